@@ -0,0 +1,310 @@
+/**
+ * @file
+ * @brief Benchmarks of the field lookup in the sensor for all field mappings, precisions, interpolations and layouts
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <array>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "benchmark_utils.h"
+#include "core/geometry/DetectorField.hpp"
+
+using namespace allpix;
+
+namespace {
+    constexpr size_t positions_per_iteration = 4096;
+
+    /**
+     * @brief Draw random positions within the pixel matrix of the sensor
+     * @param detector Detector to draw the positions for
+     * @return Local positions, identical for every call
+     */
+    std::vector<ROOT::Math::XYZPoint> random_positions(const Detector& detector) {
+        auto model = detector.getModel();
+        auto pitch = model->getPixelSize();
+        auto matrix = model->getMatrixSize();
+        auto center = model->getSensorCenter();
+        auto thickness = model->getSensorSize().z();
+
+        std::mt19937_64 generator(0);
+        std::uniform_real_distribution<double> x(-pitch.x() / 2, matrix.x() - pitch.x() / 2);
+        std::uniform_real_distribution<double> y(-pitch.y() / 2, matrix.y() - pitch.y() / 2);
+        std::uniform_real_distribution<double> z(center.z() - thickness / 2, center.z() + thickness / 2);
+
+        std::vector<ROOT::Math::XYZPoint> positions;
+        positions.reserve(positions_per_iteration);
+        for(size_t i = 0; i < positions_per_iteration; ++i) {
+            positions.emplace_back(x(generator), y(generator), z(generator));
+        }
+        return positions;
+    }
+
+    /**
+     * @brief Sample positions along drift trajectories through the full sensor thickness
+     * @param detector Detector to draw the trajectories for
+     * @return Local positions ordered along the trajectories, identical for every call
+     *
+     * The trajectories start at random positions on the top surface of the sensor and advance along z in steps of one
+     * hundredth of the thickness, with a lateral random walk of a few micrometers per step as caused by diffusion.
+     */
+    std::vector<ROOT::Math::XYZPoint> drift_trajectories(const Detector& detector) {
+        constexpr size_t steps = 100;
+        auto model = detector.getModel();
+        auto pitch = model->getPixelSize();
+        auto matrix = model->getMatrixSize();
+        auto center = model->getSensorCenter();
+        auto thickness = model->getSensorSize().z();
+
+        std::mt19937_64 generator(0);
+        std::uniform_real_distribution<double> x(-pitch.x() / 2, matrix.x() - pitch.x() / 2);
+        std::uniform_real_distribution<double> y(-pitch.y() / 2, matrix.y() - pitch.y() / 2);
+        std::normal_distribution<double> diffusion(0., 2. * Units::get(1., "um"));
+
+        auto step_z = thickness / static_cast<double>(steps);
+
+        std::vector<ROOT::Math::XYZPoint> positions;
+        positions.reserve(positions_per_iteration);
+        while(positions.size() + steps <= positions_per_iteration) {
+            ROOT::Math::XYZPoint position(x(generator), y(generator), center.z() + thickness / 2);
+            for(size_t step = 0; step < steps; ++step) {
+                positions.push_back(position);
+                position += ROOT::Math::XYZVector(diffusion(generator), diffusion(generator), -step_z);
+            }
+        }
+        return positions;
+    }
+
+    /**
+     * @brief Set an electric field and optionally a doping profile on a grid spanning the full sensor
+     * @param detector Detector to set the fields for
+     * @param bins Number of grid cells along the three axes
+     * @param interpolation Interpolation of the field values between the grid points
+     * @param layout Memory layout with which the values are stored
+     * @param doping Also set a doping profile on the same grid
+     */
+    void set_sensor_fields(Detector& detector,
+                           std::array<size_t, 3> bins,
+                           FieldInterpolation interpolation,
+                           FieldLayout layout,
+                           bool doping) {
+        auto model = detector.getModel();
+        auto thickness = model->getSensorSize().z();
+        auto center_z = model->getSensorCenter().z();
+        std::array<double, 3> size = {model->getMatrixSize().x(), model->getMatrixSize().y(), thickness};
+        std::pair<double, double> domain = {center_z - thickness / 2, center_z + thickness / 2};
+
+        auto field = std::make_shared<std::vector<double>>();
+        auto profile = std::make_shared<std::vector<double>>();
+        field->reserve(3 * bins[0] * bins[1] * bins[2]);
+        for(size_t x = 0; x < bins[0]; ++x) {
+            for(size_t y = 0; y < bins[1]; ++y) {
+                for(size_t z = 0; z < bins[2]; ++z) {
+                    field->push_back(static_cast<double>(x % 5) - 2.);
+                    field->push_back(static_cast<double>(y % 5) - 2.);
+                    field->push_back(1. + static_cast<double>(z));
+                    if(doping) {
+                        profile->push_back(1e12 * (1. + static_cast<double>(z)));
+                    }
+                }
+            }
+        }
+        std::shared_ptr<const double> data(field, field->data());
+        detector.setElectricFieldGrid(data,
+                                      bins,
+                                      size,
+                                      FieldMapping::SENSOR,
+                                      {1., 1.},
+                                      {0., 0.},
+                                      domain,
+                                      FieldPrecision::DOUBLE,
+                                      interpolation,
+                                      nullptr,
+                                      layout);
+        if(doping) {
+            std::shared_ptr<const double> doping_data(profile, profile->data());
+            detector.setDopingProfileGrid(doping_data,
+                                          bins,
+                                          size,
+                                          FieldMapping::SENSOR,
+                                          {1., 1.},
+                                          {0., 0.},
+                                          domain,
+                                          FieldPrecision::DOUBLE,
+                                          interpolation,
+                                          nullptr,
+                                          layout);
+        }
+    }
+
+    /**
+     * @brief Electric field lookup from a grid with the mapping, precision and interpolation given as arguments
+     */
+    void BM_ElectricFieldGrid(benchmark::State& state) {
+        auto mapping = static_cast<FieldMapping>(state.range(0));
+        auto precision = static_cast<FieldPrecision>(state.range(1));
+        auto interpolation = static_cast<FieldInterpolation>(state.range(2));
+
+        auto detector = benchmarks::make_detector("timepix");
+        auto model = detector->getModel();
+        auto thickness = model->getSensorSize().z();
+        auto center_z = model->getSensorCenter().z();
+
+        // Halves and quadrants of the pixel cell span half the pitch along the mirrored axes
+        auto quadrant = mapping == FieldMapping::PIXEL_QUADRANT_I || mapping == FieldMapping::PIXEL_QUADRANT_II ||
+                        mapping == FieldMapping::PIXEL_QUADRANT_III || mapping == FieldMapping::PIXEL_QUADRANT_IV;
+        auto half_x = quadrant || mapping == FieldMapping::PIXEL_HALF_LEFT || mapping == FieldMapping::PIXEL_HALF_RIGHT;
+        auto half_y = quadrant || mapping == FieldMapping::PIXEL_HALF_TOP || mapping == FieldMapping::PIXEL_HALF_BOTTOM;
+        std::array<double, 3> size = {
+            model->getPixelSize().x() / (half_x ? 2 : 1), model->getPixelSize().y() / (half_y ? 2 : 1), thickness};
+        if(mapping == FieldMapping::SENSOR) {
+            size = {model->getMatrixSize().x(), model->getMatrixSize().y(), thickness};
+        }
+
+        // Field pointing along z with a lateral component to exercise the mirroring of the vector components
+        std::array<size_t, 3> bins = {20, 20, 100};
+        auto field = std::make_shared<std::vector<double>>();
+        field->reserve(3 * bins[0] * bins[1] * bins[2]);
+        for(size_t x = 0; x < bins[0]; ++x) {
+            for(size_t y = 0; y < bins[1]; ++y) {
+                for(size_t z = 0; z < bins[2]; ++z) {
+                    field->push_back(static_cast<double>(x) - static_cast<double>(bins[0]) / 2);
+                    field->push_back(static_cast<double>(y) - static_cast<double>(bins[1]) / 2);
+                    field->push_back(1. + static_cast<double>(z));
+                }
+            }
+        }
+        std::shared_ptr<const double> data(field, field->data());
+        detector->setElectricFieldGrid(data,
+                                       bins,
+                                       size,
+                                       mapping,
+                                       {1., 1.},
+                                       {0., 0.},
+                                       {center_z - thickness / 2, center_z + thickness / 2},
+                                       precision,
+                                       interpolation);
+
+        auto positions = random_positions(*detector);
+        for(auto _ : state) {
+            for(const auto& position : positions) {
+                benchmark::DoNotOptimize(detector->getElectricField(position));
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(positions.size()));
+    }
+    BENCHMARK(BM_ElectricFieldGrid)
+        ->ArgsProduct({benchmark::CreateDenseRange(static_cast<int64_t>(FieldMapping::PIXEL_FULL),
+                                                     static_cast<int64_t>(FieldMapping::SENSOR),
+                                                     1),
+                       {static_cast<int64_t>(FieldPrecision::DOUBLE)},
+                       {static_cast<int64_t>(FieldInterpolation::NEAREST)}})
+        ->ArgsProduct({{static_cast<int64_t>(FieldMapping::PIXEL_FULL)},
+                       benchmark::CreateDenseRange(static_cast<int64_t>(FieldPrecision::DOUBLE),
+                                                     static_cast<int64_t>(FieldPrecision::QUANTIZED),
+                                                     1),
+                       benchmark::CreateDenseRange(static_cast<int64_t>(FieldInterpolation::NEAREST),
+                                                     static_cast<int64_t>(FieldInterpolation::TRICUBIC),
+                                                     1)})
+        ->ArgNames({"mapping", "precision", "interpolation"});
+
+    /**
+     * @brief Electric field lookup along drift trajectories from a grid spanning the full sensor, with the layout and the
+     *        interpolation given as arguments
+     *
+     * The grid is considerably larger than the caches, such that the lookups are dominated by memory accesses. The
+     * reduction of cache misses by the bricked layout can be measured with --benchmark_perf_counters=CACHE-MISSES if the
+     * benchmark library has been built with support for performance counters.
+     */
+    void BM_ElectricFieldTrajectory(benchmark::State& state) {
+        auto layout = static_cast<FieldLayout>(state.range(0));
+        auto interpolation = static_cast<FieldInterpolation>(state.range(1));
+
+        auto detector = benchmarks::make_detector("timepix");
+        set_sensor_fields(*detector, {256, 256, 50}, interpolation, layout, false);
+
+        auto positions = drift_trajectories(*detector);
+        for(auto _ : state) {
+            for(const auto& position : positions) {
+                benchmark::DoNotOptimize(detector->getElectricField(position));
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(positions.size()));
+    }
+    BENCHMARK(BM_ElectricFieldTrajectory)
+        ->ArgsProduct({benchmark::CreateDenseRange(static_cast<int64_t>(FieldLayout::ROW_MAJOR),
+                                                     static_cast<int64_t>(FieldLayout::BRICKED),
+                                                     1),
+                       benchmark::CreateDenseRange(static_cast<int64_t>(FieldInterpolation::NEAREST),
+                                                     static_cast<int64_t>(FieldInterpolation::TRICUBIC),
+                                                     1)})
+        ->ArgNames({"layout", "interpolation"});
+
+    /**
+     * @brief Electric field and doping lookup along drift trajectories from large grids spanning the full sensor, with
+     *        prefetching of the fields at the position extrapolated from the last step enabled by the first argument
+     *
+     * The lookups mimic a propagation step, which requests the fields at the next position predicted from the last step
+     * as done by the propagation modules with prefetch_fields enabled. The positions at the start of a trajectory are
+     * not predicted.
+     */
+    void BM_FieldTrajectoryPrefetch(benchmark::State& state) {
+        auto prefetch = (state.range(0) != 0);
+        auto interpolation = static_cast<FieldInterpolation>(state.range(1));
+
+        auto detector = benchmarks::make_detector("timepix");
+        set_sensor_fields(*detector, {256, 256, 100}, interpolation, FieldLayout::ROW_MAJOR, true);
+
+        auto positions = drift_trajectories(*detector);
+        for(auto _ : state) {
+            for(size_t i = 0; i < positions.size(); ++i) {
+                const auto& position = positions[i];
+                if(prefetch && i > 0) {
+                    detector->prefetchFields(position + (position - positions[i - 1]), false);
+                }
+                benchmark::DoNotOptimize(detector->getElectricField(position));
+                benchmark::DoNotOptimize(detector->getDopingConcentration(position));
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(positions.size()));
+    }
+    BENCHMARK(BM_FieldTrajectoryPrefetch)
+        ->ArgsProduct({{0, 1},
+                       benchmark::CreateDenseRange(static_cast<int64_t>(FieldInterpolation::NEAREST),
+                                                     static_cast<int64_t>(FieldInterpolation::TRICUBIC),
+                                                     1)})
+        ->ArgNames({"prefetch", "interpolation"});
+
+    /**
+     * @brief Electric field lookup from a linear field function, the reference for the grid lookups
+     */
+    void BM_ElectricFieldFunction(benchmark::State& state) {
+        auto detector = benchmarks::make_detector("timepix");
+        auto model = detector->getModel();
+        auto thickness = model->getSensorSize().z();
+        auto center_z = model->getSensorCenter().z();
+
+        auto function = [](const ROOT::Math::XYZPoint& pos) { return ROOT::Math::XYZVector(0, 0, pos.z()); };
+        detector->setElectricFieldFunction(
+            function, {center_z - thickness / 2, center_z + thickness / 2}, FieldType::LINEAR);
+
+        auto positions = random_positions(*detector);
+        for(auto _ : state) {
+            for(const auto& position : positions) {
+                benchmark::DoNotOptimize(detector->getElectricField(position));
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(positions.size()));
+    }
+    BENCHMARK(BM_ElectricFieldFunction);
+} // namespace
@@ -0,0 +1,91 @@
+/**
+ * @file
+ * @brief Benchmarks of the neighbor search of the detector models
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "benchmark_utils.h"
+#include "objects/Pixel.hpp"
+
+using namespace allpix;
+
+namespace {
+    const std::string hexagonal_model = R"(type = "monolithic"
+geometry = "hexagonal"
+pixel_type = "hexagon_pointy"
+number_of_pixels = 128 128
+pixel_size = 55um 55um
+sensor_thickness = 300um
+)";
+
+    /**
+     * @brief Neighbors of a pixel in the center of the matrix, with the search distance given as argument
+     */
+    void BM_GetNeighbors(benchmark::State& state, const std::string& model_name) {
+        auto model = benchmarks::make_detector(model_name)->getModel();
+        auto distance = static_cast<size_t>(state.range(0));
+        Pixel::Index seed(static_cast<int>(model->getNPixels().x() / 2), static_cast<int>(model->getNPixels().y() / 2));
+
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(model->getNeighbors(seed, distance));
+        }
+    }
+    BENCHMARK_CAPTURE(BM_GetNeighbors, pixel, "timepix")->DenseRange(1, 3)->ArgName("distance");
+    BENCHMARK_CAPTURE(BM_GetNeighbors, hexagonal, hexagonal_model)->DenseRange(1, 3)->ArgName("distance");
+    BENCHMARK_CAPTURE(BM_GetNeighbors, radial_strip, "atlas_itk_r0")->DenseRange(1, 3)->ArgName("distance");
+
+    /**
+     * @brief Neighbors of a pixel written into a reused vector, the variant used in the transfer modules
+     */
+    void BM_GetNeighborsVector(benchmark::State& state, const std::string& model_name) {
+        auto model = benchmarks::make_detector(model_name)->getModel();
+        auto distance = static_cast<size_t>(state.range(0));
+        Pixel::Index seed(static_cast<int>(model->getNPixels().x() / 2), static_cast<int>(model->getNPixels().y() / 2));
+
+        std::vector<Pixel::Index> neighbors;
+        for(auto _ : state) {
+            neighbors.clear();
+            model->getNeighbors(seed, distance, neighbors);
+            benchmark::DoNotOptimize(neighbors.data());
+        }
+    }
+    BENCHMARK_CAPTURE(BM_GetNeighborsVector, pixel, "timepix")->DenseRange(1, 3)->ArgName("distance");
+    BENCHMARK_CAPTURE(BM_GetNeighborsVector, hexagonal, hexagonal_model)->DenseRange(1, 3)->ArgName("distance");
+    BENCHMARK_CAPTURE(BM_GetNeighborsVector, radial_strip, "atlas_itk_r0")->DenseRange(1, 3)->ArgName("distance");
+
+    /**
+     * @brief Neighborship check of all pixels in a window around a seed pixel, the core of the clustering of hits
+     */
+    void BM_AreNeighbors(benchmark::State& state, const std::string& model_name) {
+        auto model = benchmarks::make_detector(model_name)->getModel();
+        auto seed_x = static_cast<int>(model->getNPixels().x() / 2);
+        auto seed_y = static_cast<int>(model->getNPixels().y() / 2);
+        Pixel::Index seed(seed_x, seed_y);
+
+        std::vector<Pixel::Index> entrants;
+        for(int x = seed_x - 4; x <= seed_x + 4; ++x) {
+            for(int y = seed_y - 4; y <= seed_y + 4; ++y) {
+                entrants.emplace_back(x, y);
+            }
+        }
+        for(auto _ : state) {
+            for(const auto& entrant : entrants) {
+                benchmark::DoNotOptimize(model->areNeighbors(seed, entrant, 1));
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(entrants.size()));
+    }
+    BENCHMARK_CAPTURE(BM_AreNeighbors, pixel, "timepix");
+    BENCHMARK_CAPTURE(BM_AreNeighbors, hexagonal, hexagonal_model);
+    BENCHMARK_CAPTURE(BM_AreNeighbors, radial_strip, "atlas_itk_r0");
+} // namespace
@@ -0,0 +1,139 @@
+/**
+ * @file
+ * @brief Benchmarks of the charge carrier mobility, recombination and trapping models
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "benchmark_utils.h"
+#include "core/utils/unit.h"
+#include "physics/Mobility.hpp"
+#include "physics/Recombination.hpp"
+#include "physics/Trapping.hpp"
+
+using namespace allpix;
+
+namespace {
+    constexpr size_t samples_per_iteration = 4096;
+
+    /**
+     * @brief Operating conditions of a charge carrier drawn for every model evaluation
+     */
+    struct Sample {
+        CarrierType type;
+        double efield;
+        double doping;
+        double probability;
+    };
+
+    /**
+     * @brief Draw random operating conditions covering the typical range of fields and doping concentrations
+     * @return Samples, identical for every call
+     */
+    std::vector<Sample> random_samples() {
+        std::mt19937_64 generator(0);
+        std::uniform_real_distribution<double> efield(0, Units::get(100., "kV/cm"));
+        std::uniform_real_distribution<double> exponent(10, 18);
+        std::uniform_real_distribution<double> probability(0, 1);
+
+        std::vector<Sample> samples;
+        samples.reserve(samples_per_iteration);
+        for(size_t i = 0; i < samples_per_iteration; ++i) {
+            samples.push_back({i % 2 == 0 ? CarrierType::ELECTRON : CarrierType::HOLE,
+                               efield(generator),
+                               Units::get(std::pow(10., exponent(generator)), "/cm/cm/cm"),
+                               probability(generator)});
+        }
+        return samples;
+    }
+
+    /**
+     * @brief Mobility model evaluation, with the model name and the use of the lookup table given as arguments
+     */
+    void BM_Mobility(benchmark::State& state, const std::string& model, bool tabulated) {
+        auto config = benchmarks::make_configuration("mobility_model = \"" + model + "\"\ntemperature = 293K\n" +
+                                                     "mobility_electron = 1000cm*cm/V/s\nmobility_hole = 500cm*cm/V/s\n" +
+                                                     "mobility_tabulated = " + (tabulated ? "true" : "false") + "\n");
+        Mobility mobility(config, SensorMaterial::SILICON, true);
+
+        auto samples = random_samples();
+        for(auto _ : state) {
+            for(const auto& sample : samples) {
+                benchmark::DoNotOptimize(mobility(sample.type, sample.efield, sample.doping));
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(samples.size()));
+    }
+    BENCHMARK_CAPTURE(BM_Mobility, jacoboni, "jacoboni", false);
+    BENCHMARK_CAPTURE(BM_Mobility, canali, "canali", false);
+    BENCHMARK_CAPTURE(BM_Mobility, canali_fast, "canali_fast", false);
+    BENCHMARK_CAPTURE(BM_Mobility, hamburg, "hamburg", false);
+    BENCHMARK_CAPTURE(BM_Mobility, hamburg_highfield, "hamburg_highfield", false);
+    BENCHMARK_CAPTURE(BM_Mobility, masetti, "masetti", false);
+    BENCHMARK_CAPTURE(BM_Mobility, masetti_canali, "masetti_canali", false);
+    BENCHMARK_CAPTURE(BM_Mobility, arora, "arora", false);
+    BENCHMARK_CAPTURE(BM_Mobility, ruch_kino, "ruch_kino", false);
+    BENCHMARK_CAPTURE(BM_Mobility, quay, "quay", false);
+    BENCHMARK_CAPTURE(BM_Mobility, levinshtein, "levinshtein", false);
+    BENCHMARK_CAPTURE(BM_Mobility, constant, "constant", false);
+    BENCHMARK_CAPTURE(BM_Mobility, masetti_canali_tabulated, "masetti_canali", true);
+
+    /**
+     * @brief Recombination model evaluation, with the model name given as argument
+     */
+    void BM_Recombination(benchmark::State& state, const std::string& model) {
+        auto config = benchmarks::make_configuration("recombination_model = \"" + model + "\"\ntemperature = 293K\n" +
+                                                     "lifetime_electron = 10us\nlifetime_hole = 5us\n");
+        Recombination recombination(config, true);
+        auto timestep = Units::get(0.1, "ns");
+
+        auto samples = random_samples();
+        for(auto _ : state) {
+            for(const auto& sample : samples) {
+                benchmark::DoNotOptimize(recombination(sample.type, sample.doping, sample.probability, timestep));
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(samples.size()));
+    }
+    BENCHMARK_CAPTURE(BM_Recombination, srh, "srh");
+    BENCHMARK_CAPTURE(BM_Recombination, auger, "auger");
+    BENCHMARK_CAPTURE(BM_Recombination, srh_auger, "srh_auger");
+    BENCHMARK_CAPTURE(BM_Recombination, constant, "constant");
+    BENCHMARK_CAPTURE(BM_Recombination, none, "none");
+
+    /**
+     * @brief Trapping model evaluation, with the model name given as argument
+     */
+    void BM_Trapping(benchmark::State& state, const std::string& model) {
+        auto config = benchmarks::make_configuration("trapping_model = \"" + model + "\"\ntemperature = 293K\n" +
+                                                     "fluence = 1e14neq/cm/cm\n" +
+                                                     "trapping_time_electron = 10ns\ntrapping_time_hole = 5ns\n");
+        Trapping trapping(config);
+        auto timestep = Units::get(0.1, "ns");
+
+        auto samples = random_samples();
+        for(auto _ : state) {
+            for(const auto& sample : samples) {
+                benchmark::DoNotOptimize(trapping(sample.type, sample.probability, timestep, sample.efield));
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(samples.size()));
+    }
+    BENCHMARK_CAPTURE(BM_Trapping, ljubljana, "ljubljana");
+    BENCHMARK_CAPTURE(BM_Trapping, dortmund, "dortmund");
+    BENCHMARK_CAPTURE(BM_Trapping, cmstracker, "cmstracker");
+    BENCHMARK_CAPTURE(BM_Trapping, mandic, "mandic");
+    BENCHMARK_CAPTURE(BM_Trapping, constant, "constant");
+    BENCHMARK_CAPTURE(BM_Trapping, none, "none");
+} // namespace
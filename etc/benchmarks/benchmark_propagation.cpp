@@ -0,0 +1,84 @@
+/**
+ * @file
+ * @brief Benchmarks of the integration of the equations of motion and of the accumulation of pulses
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <random>
+#include <vector>
+
+#include <Eigen/Core>
+#include <benchmark/benchmark.h>
+
+#include "core/utils/unit.h"
+#include "objects/Pulse.hpp"
+#include "tools/runge_kutta.h"
+
+#include "benchmark_utils.h"
+
+using namespace allpix;
+
+namespace {
+    /**
+     * @brief Velocity of a charge carrier in a linear field with constant mobility, cheap enough to expose the integrator
+     */
+    Eigen::Vector3d linear_velocity(double, const Eigen::Vector3d& position) {
+        return {1e-3 * position.z(), 0, 1e-2 + 1e-3 * position.z()};
+    }
+
+    /**
+     * @brief Single step of the Runge-Kutta-Fehlberg integrator with the tableau resolved at runtime
+     */
+    void BM_RungeKuttaStep(benchmark::State& state) {
+        benchmarks::setup_units();
+        auto runge_kutta = make_runge_kutta(tableau::RK5, linear_velocity, Units::get(0.1, "ns"), Eigen::Vector3d(0, 0, 0));
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(runge_kutta.step());
+        }
+    }
+    BENCHMARK(BM_RungeKuttaStep);
+
+    /**
+     * @brief Single step of the Runge-Kutta-Fehlberg integrator with the tableau and the function resolved at compile time
+     */
+    void BM_StaticRungeKuttaStep(benchmark::State& state) {
+        benchmarks::setup_units();
+        auto velocity = [](double time, const Eigen::Vector3d& position) { return linear_velocity(time, position); };
+        auto runge_kutta =
+            make_static_runge_kutta<tableau::StaticRK5>(velocity, Units::get(0.1, "ns"), Eigen::Vector3d(0, 0, 0));
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(runge_kutta.step());
+        }
+    }
+    BENCHMARK(BM_StaticRungeKuttaStep);
+
+    /**
+     * @brief Accumulation of induced charges into a pulse, with the number of charges per pulse given as argument
+     */
+    void BM_PulseAddCharge(benchmark::State& state) {
+        benchmarks::setup_units();
+        auto integration_time = Units::get(25., "ns");
+
+        std::mt19937_64 generator(0);
+        std::uniform_real_distribution<double> time(0, integration_time);
+        std::vector<double> times(static_cast<size_t>(state.range(0)));
+        for(auto& value : times) {
+            value = time(generator);
+        }
+
+        for(auto _ : state) {
+            Pulse pulse(Units::get(0.01, "ns"), integration_time);
+            for(const auto& value : times) {
+                pulse.addCharge(1., value);
+            }
+            benchmark::DoNotOptimize(pulse.data());
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_PulseAddCharge)->RangeMultiplier(10)->Range(10, 10000)->ArgName("charges");
+} // namespace
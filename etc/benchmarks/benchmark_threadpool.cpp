@@ -0,0 +1,64 @@
+/**
+ * @file
+ * @brief Benchmarks of the submission of event tasks to the thread pool
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include <benchmark/benchmark.h>
+
+#include "core/module/ThreadPool.hpp"
+
+using namespace allpix;
+
+namespace {
+    constexpr size_t tasks_per_iteration = 1024;
+
+    /**
+     * @brief Register the worker of the pools used by the benchmarks once
+     */
+    void register_worker() {
+        static const bool registered = [] {
+            ThreadPool::registerThreadCount(1);
+            return true;
+        }();
+        (void)registered;
+    }
+
+    /**
+     * @brief Submission of trivial tasks to a pool with a single worker, with or without a future as given by the argument
+     *
+     * The tasks capture as much state as the event functions of the event loop, such that the cost of the submission is
+     * dominated by the type erasure and the allocations of the tasks.
+     */
+    void BM_ThreadPoolSubmit(benchmark::State& state) {
+        register_worker();
+        auto with_future = state.range(0) != 0;
+
+        ThreadPool pool(1, tasks_per_iteration, tasks_per_iteration);
+        std::atomic<uint64_t> executed{0};
+        std::array<uint64_t, 16> captured{};
+        for(auto _ : state) {
+            for(size_t i = 0; i < tasks_per_iteration; ++i) {
+                auto task = [&executed, captured]() { executed += captured[0] + 1; };
+                if(with_future) {
+                    benchmark::DoNotOptimize(pool.submit(task));
+                } else {
+                    benchmark::DoNotOptimize(pool.submitDetached(task));
+                }
+            }
+            pool.wait();
+        }
+        pool.checkException();
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(tasks_per_iteration));
+    }
+    BENCHMARK(BM_ThreadPoolSubmit)->Arg(1)->Arg(0)->ArgNames({"future"})->UseRealTime();
+} // namespace
@@ -0,0 +1,75 @@
+/**
+ * @file
+ * @brief Common utilities for the micro-benchmarks of the framework libraries
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_BENCHMARK_UTILS_H
+#define ALLPIX_BENCHMARK_UTILS_H
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include <Math/Point3D.h>
+#include <Math/Rotation3D.h>
+
+#include "core/config/ConfigReader.hpp"
+#include "core/config/Configuration.hpp"
+#include "core/geometry/Detector.hpp"
+#include "core/geometry/DetectorModel.hpp"
+#include "tools/units.h"
+
+namespace allpix::benchmarks {
+
+    /**
+     * @brief Register the framework units once, such that configurations with units can be parsed by the benchmarks
+     */
+    inline void setup_units() {
+        static const bool registered = [] {
+            register_units();
+            return true;
+        }();
+        (void)registered;
+    }
+
+    /**
+     * @brief Create a configuration with the given content
+     * @param content Key-value pairs in the syntax of the configuration files
+     * @return Configuration holding the parsed values
+     */
+    inline Configuration make_configuration(const std::string& content) {
+        setup_units();
+        std::istringstream stream(content);
+        return ConfigReader(stream).getHeaderConfiguration();
+    }
+
+    /**
+     * @brief Create a detector from a model file of the source tree or from an inline model description
+     * @param model Name of the model file without suffix, or the content of a model file if containing a newline
+     * @return Detector placed at the origin of the global coordinate system
+     */
+    inline std::shared_ptr<Detector> make_detector(const std::string& model) {
+        setup_units();
+        ConfigReader reader;
+        if(model.find('\n') == std::string::npos) {
+            auto path = std::filesystem::path(ALLPIX_BENCHMARK_MODEL_DIRECTORY) / (model + ".conf");
+            std::ifstream file(path);
+            reader = ConfigReader(file, path);
+        } else {
+            std::istringstream stream(model);
+            reader = ConfigReader(stream);
+        }
+        return std::make_shared<Detector>(
+            "dut", DetectorModel::factory("dut", reader), ROOT::Math::XYZPoint(), ROOT::Math::Rotation3D());
+    }
+} // namespace allpix::benchmarks
+
+#endif /* ALLPIX_BENCHMARK_UTILS_H */
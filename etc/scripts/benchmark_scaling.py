@@ -0,0 +1,98 @@
+#!/usr/bin/python3
+
+# SPDX-FileCopyrightText: 2024 CERN and the Allpix Squared authors
+# SPDX-License-Identifier: MIT
+
+"""
+Run a simulation with an increasing number of worker threads and report the event rate and the peak memory usage.
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def number_of_events(config_file):
+    """
+    Read the number of events from the global section of a configuration file.
+    """
+    in_global = True
+    with open(config_file) as config:
+        for line in config:
+            line = line.split('#')[0].strip()
+            section = re.match(r'^\[(.*)\]$', line)
+            if section:
+                in_global = section.group(1).lower() == 'allpix'
+            elif in_global and line.startswith('number_of_events'):
+                return int(line.split('=')[1])
+    return 1
+
+
+def run(executable, config_file, workers, events, options):
+    """
+    Run the simulation once and return the wall time of the event loop, the total wall time and the peak RSS in bytes.
+    """
+    with tempfile.TemporaryDirectory() as output_directory:
+        command = [executable, '-c', config_file, '-o', f'output_directory={output_directory}',
+                   '-o', 'performance_report=true', '-o', 'log_level=WARNING', '-o', f'number_of_events={events}']
+        if workers > 0:
+            command += ['-j', str(workers)]
+        else:
+            command += ['-o', 'multithreading=false']
+        for option in options:
+            command += ['-o', option]
+
+        start = time.monotonic()
+        process = subprocess.Popen(command, stdout=subprocess.DEVNULL)
+        _, status, usage = os.wait4(process.pid, 0)
+        wall_time = time.monotonic() - start
+        if os.waitstatus_to_exitcode(status) != 0:
+            sys.exit(f'Simulation with {workers} workers failed, command: {" ".join(command)}')
+
+        with open(os.path.join(output_directory, 'performance.json')) as report:
+            run_time = json.load(report)['run_time_ns'] * 1e-9
+
+    # Linux reports the maximum resident set size in kilobytes, macOS in bytes
+    peak_rss = usage.ru_maxrss * (1 if sys.platform == 'darwin' else 1024)
+    return run_time, wall_time, peak_rss
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('config', help='main configuration file of the simulation')
+    parser.add_argument('-x', '--executable', default='allpix', help='path to the allpix executable')
+    parser.add_argument('-j', '--workers', type=int, default=os.cpu_count(), help='maximum number of worker threads')
+    parser.add_argument('-n', '--events', type=int, help='number of events, defaults to the value of the configuration')
+    parser.add_argument('-r', '--repetitions', type=int, default=1, help='runs per thread count, the fastest is kept')
+    parser.add_argument('-o', '--option', action='append', default=[], help='additional option passed to allpix')
+    parser.add_argument('--json', help='write the results to this file')
+    args = parser.parse_args()
+
+    events = args.events if args.events is not None else number_of_events(args.config)
+    thread_counts = [0] + [workers for workers in range(1, args.workers + 1) if workers & (workers - 1) == 0]
+    if args.workers not in thread_counts:
+        thread_counts.append(args.workers)
+
+    results = []
+    print(f'{"workers":>8} {"events/s":>12} {"speedup":>8} {"wall time [s]":>14} {"peak RSS [MB]":>14}')
+    for workers in thread_counts:
+        runs = [run(args.executable, args.config, workers, events, args.option) for _ in range(args.repetitions)]
+        run_time, wall_time, peak_rss = min(runs)
+        rate = events / run_time
+        speedup = rate / results[0]['events_per_second'] if results else 1.
+        print(f'{workers:>8} {rate:>12.1f} {speedup:>8.2f} {wall_time:>14.2f} {peak_rss / 1e6:>14.1f}')
+        results.append({'workers': workers, 'events': events, 'events_per_second': rate, 'run_time_s': run_time,
+                        'wall_time_s': wall_time, 'peak_rss_bytes': peak_rss})
+
+    if args.json:
+        with open(args.json, 'w') as output:
+            json.dump({'config': os.path.abspath(args.config), 'results': results}, output, indent=2)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,136 @@
+#!/usr/bin/python3
+
+# SPDX-FileCopyrightText: 2024 CERN and the Allpix Squared authors
+# SPDX-License-Identifier: MIT
+
+"""
+Compare two digest files written by the DigestWriter module. The first event and the earliest stage of the simulation chain
+at which the files differ are reported, together with a statistical comparison of the number of objects and their summed
+charge per event for every detector and object type.
+"""
+
+import argparse
+import math
+import sys
+
+# Object types in the order in which they are created in the simulation chain
+STAGES = ['MCTrack', 'MCParticle', 'DepositedCharge', 'PropagatedCharge', 'PixelCharge', 'PixelHit']
+
+
+def stage_order(key):
+    """
+    Sort key of a detector and object type by the position of the object type in the simulation chain.
+    """
+    detector, name = key
+    return (STAGES.index(name) if name in STAGES else len(STAGES), name, detector)
+
+
+def read_digests(path):
+    """
+    Read a digest file into a dictionary of events, each mapping detector and object type to count, sum and hash.
+    """
+    events = {}
+    with open(path) as digest_file:
+        for line_number, line in enumerate(digest_file, 1):
+            line = line.strip()
+            if not line or line.startswith('#'):
+                continue
+            fields = line.split()
+            if len(fields) != 6:
+                sys.exit(f'Malformed line {line_number} in {path}: {line}')
+            event, detector, name, count, total, digest = fields
+            events.setdefault(int(event), {})[(detector, name)] = (int(count), float(total), digest)
+    return events
+
+
+def first_divergence(reference, candidate):
+    """
+    Find the first event with differing digests and the earliest differing detector and object type in it.
+    Returns the event number, the differing key and the number of differing events.
+    """
+    first = None
+    differing = 0
+    for event in sorted(set(reference) | set(candidate)):
+        digests_ref = reference.get(event, {})
+        digests_cand = candidate.get(event, {})
+        keys = [key for key in set(digests_ref) | set(digests_cand) if digests_ref.get(key) != digests_cand.get(key)]
+        if not keys:
+            continue
+        differing += 1
+        if first is None:
+            first = (event, min(keys, key=stage_order))
+    return first, differing
+
+
+def moments(events, key, observable):
+    """
+    Compute mean and standard error of the mean of the count (observable 0) or sum (observable 1) per event.
+    Events without objects of the given type contribute zero.
+    """
+    values = [digests[key][observable] if key in digests else 0 for digests in events.values()]
+    n = len(values)
+    mean = sum(values) / n
+    variance = sum((value - mean) ** 2 for value in values) / (n - 1) if n > 1 else 0.
+    return mean, math.sqrt(variance / n)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('reference', help='digest file of the reference run')
+    parser.add_argument('candidate', help='digest file of the run to compare')
+    parser.add_argument('-s', '--significance', type=float, default=3.,
+                        help='number of standard errors above which the means are considered incompatible')
+    args = parser.parse_args()
+
+    reference = read_digests(args.reference)
+    candidate = read_digests(args.candidate)
+    if not reference or not candidate:
+        sys.exit('Digest files do not contain any events')
+
+    exact = True
+    if set(reference) != set(candidate):
+        exact = False
+        print(f'Event numbers differ: {len(reference)} events in reference, {len(candidate)} events in candidate')
+
+    first, differing = first_divergence(reference, candidate)
+    if first is None:
+        print(f'Digests of all {len(reference)} events are identical')
+    else:
+        exact = False
+        event, (detector, name) = first
+        where = f'detector {detector}' if detector != '-' else 'objects without detector'
+        print(f'Digests differ in {differing} events, first in event {event} at stage {name} of {where}')
+
+    print()
+    print(f'{"detector":<16} {"object":<18} {"mean count":>24} {"mean sum":>30} {"pull":>8}')
+    compatible = True
+    keys = set()
+    for digests in list(reference.values()) + list(candidate.values()):
+        keys.update(digests)
+    for key in sorted(keys, key=stage_order):
+        pulls = []
+        columns = []
+        for observable in (0, 1):
+            mean_ref, error_ref = moments(reference, key, observable)
+            mean_cand, error_cand = moments(candidate, key, observable)
+            error = math.hypot(error_ref, error_cand)
+            difference = mean_cand - mean_ref
+            pulls.append(abs(difference) / error if error > 0 else (0. if difference == 0 else math.inf))
+            columns.append(f'{mean_ref:.4g} / {mean_cand:.4g}')
+        pull = max(pulls)
+        flag = ' !' if pull > args.significance else ''
+        compatible = compatible and not flag
+        print(f'{key[0]:<16} {key[1]:<18} {columns[0]:>24} {columns[1]:>30} {pull:>8.2f}{flag}')
+
+    print()
+    if exact:
+        print('Runs are identical')
+    elif compatible:
+        print(f'Runs differ but are statistically compatible within {args.significance} standard errors')
+    else:
+        print(f'Runs are statistically incompatible at {args.significance} standard errors')
+    return 0 if compatible else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -8,6 +8,9 @@ import os
 import random
 import numpy as np
 import argparse
+import socket
+import struct
+import time
 
 from array import array
 
@@ -90,6 +93,14 @@ class depositedCharge:
         return text
 
 
+    # Required for the stream model, see DepositionStream.hpp of the DepositionReader module
+    def getDepositionRecord(self, omit_time, omit_mcparticle):
+
+        return struct.pack("=5d3i44s", self.energy, 0. if omit_time else self.time, self.positionx, self.positiony,
+                           self.positionz, self.pdg_code, 0 if omit_mcparticle else self.track_id,
+                           0 if omit_mcparticle else self.parent_id, self.detector.encode()[:44])
+
+
 # Calculation of straight particle trajectories in the sensor
 def createParticle(particle, nparticles, nsteps, mix):
 
@@ -151,6 +162,21 @@ def createParticle(particle, nparticles, nsteps, mix):
 
     return deposits
 
+# Connect to the socket of the DepositionReader module once it is listening
+def connectStream(path, timeout=60.):
+
+    start = time.time()
+    while time.time() - start < timeout:
+        try:
+            stream = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            stream.connect(path)
+            return stream
+        except (FileNotFoundError, ConnectionRefusedError):
+            stream.close()
+            time.sleep(0.1)
+    print("DepositionReader did not start listening on socket " + path)
+    exit(1)
+
 def user_input(question):
     if sys.version_info.major == 3:
         return input(question)
@@ -177,6 +203,7 @@ if __name__ == '__main__':
     parser.add_argument("--scantree", help="Scan generated ROOT tree and print sections", action="store_true")
     parser.add_argument("--omit-time", help="Omit generation of timestamps", action="store_true")
     parser.add_argument("--omit-mcparticle", help="Omit generation of Monte Carlo particles", action="store_true")
+    parser.add_argument("--stream", help="Socket of a DepositionReader to send the deposits to in the background instead of writing files")
     args = parser.parse_args()
 
     # Seed PRNG with provided seed
@@ -193,7 +220,10 @@ if __name__ == '__main__':
 
 
     # Ask whether to use TTrees or CSV files
-    if rootAvailable:
+    if args.stream is not None:
+        writeCSV = False
+        writeROOT = False
+    elif rootAvailable:
         if args.type is None:
             writeOption = user_input("Generate TTrees (a), a CSV file (b) or both (c)? ")
         else:
@@ -269,6 +299,12 @@ if __name__ == '__main__':
     if writeCSV:
         fout = open(csvFilename,'w')
 
+    if args.stream is not None:
+        # Return to the caller immediately, such that the simulation can be started after this script
+        if os.fork() != 0:
+            exit(0)
+        stream = connectStream(args.stream)
+
 
     for eventNr in range(0,events):
         print("Processing event " + str(eventNr))
@@ -285,6 +321,10 @@ if __name__ == '__main__':
             text = "\nEvent: " + str(eventNr) + "\n"
             fout.write(text)
 
+        if args.stream is not None:
+            # The header with magic number, number of deposits and event id precedes the deposits of every event
+            stream.sendall(struct.pack("=IIQ", 0x44585041, len(deposits), eventNr))
+
         for deposit in deposits:
             # Add information to the depositions
             deposit.setEventNr(eventNr)
@@ -300,6 +340,9 @@ if __name__ == '__main__':
                 text = deposit.getDepositionText(args.omit_time, args.omit_mcparticle)
                 fout.write(text)
 
+            if args.stream is not None:
+                stream.sendall(deposit.getDepositionRecord(args.omit_time, args.omit_mcparticle))
+
 
     if writeROOT:
         # Inspect tree and write ROOT file
@@ -312,3 +355,7 @@ if __name__ == '__main__':
         # End the file with a line break to prevent from the last line being ignored due to the EOF
         fout.write("\n")
         fout.close()
+
+    if args.stream is not None:
+        # Closing the connection ends the run of the simulation
+        stream.close()
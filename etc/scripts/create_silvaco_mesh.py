@@ -0,0 +1,37 @@
+#!/usr/bin/python3
+
+# SPDX-FileCopyrightText: 2024 CERN and the Allpix Squared authors
+# SPDX-License-Identifier: MIT
+
+import argparse
+
+
+# Write a regular point grid and an electric field with a step along z in the Silvaco text format read by mesh_converter
+def createMesh(prefix, size, points, field_low, field_high):
+
+    steps = [size[axis] / (points[axis] - 1) for axis in range(3)]
+
+    with open(prefix + ".grd", "w") as grid_file, open(prefix + ".dat", "w") as data_file:
+        for i in range(points[0]):
+            for j in range(points[1]):
+                for k in range(points[2]):
+                    z = k * steps[2]
+                    grid_file.write("{} {} {}\n".format(i * steps[0], j * steps[1], z))
+
+                    # The field strength changes in the center of the sensor along its thickness
+                    field = field_low if z < size[2] / 2 else field_high
+                    data_file.write("0 0 {}\n".format(field))
+
+
+if __name__ == '__main__':
+
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--prefix", help="Common prefix of the grid (.grd) and data (.dat) files", default="mesh")
+    parser.add_argument("--size", help="Size of the mesh in um", nargs=3, type=float, default=[220., 440., 400.])
+    parser.add_argument("--points", help="Number of grid points along each axis", nargs=3, type=int, default=[5, 5, 11])
+    parser.add_argument("--field-low", help="Field strength in the lower half of the sensor", type=float, default=1000.)
+    parser.add_argument("--field-high", help="Field strength in the upper half of the sensor", type=float, default=5000.)
+    args = parser.parse_args()
+
+    createMesh(args.prefix, args.size, args.points, args.field_low, args.field_high)
+    print("Mesh written to \"" + args.prefix + ".grd\" and \"" + args.prefix + ".dat\"")
@@ -0,0 +1,68 @@
+#!/usr/bin/python3
+
+# SPDX-FileCopyrightText: 2024 CERN and the Allpix Squared authors
+# SPDX-License-Identifier: MIT
+
+"""
+Merge the ROOT output files of a run distributed over several shards, or of the checkpoint segments of a run, into the
+output directory of the run.
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+
+def shard_directories(output_directory, prefix):
+    """
+    Find the output directories of all shards or segments, ordered by their index.
+    """
+    shards = []
+    for entry in os.listdir(output_directory):
+        match = re.fullmatch(re.escape(prefix) + r'_([0-9]+)', entry)
+        if match and os.path.isdir(os.path.join(output_directory, entry)):
+            shards.append((int(match.group(1)), os.path.join(output_directory, entry)))
+    shards.sort()
+
+    indices = [index for index, _ in shards]
+    if indices != list(range(len(indices))):
+        sys.exit(f'Incomplete set of {prefix} directories in {output_directory}, found indices {indices}')
+    return [directory for _, directory in shards]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('output_directory', help='output directory of the run containing the shard_<N> directories')
+    parser.add_argument('-p', '--prefix', default='shard', help='prefix of the directories to merge, e.g. checkpoint')
+    parser.add_argument('-t', '--target', help='directory to write the merged files to, defaults to the output directory')
+    parser.add_argument('-x', '--hadd', default='hadd', help='path to the ROOT hadd executable')
+    parser.add_argument('-f', '--force', action='store_true', help='overwrite existing merged files')
+    args = parser.parse_args()
+
+    shards = shard_directories(args.output_directory, args.prefix)
+    if not shards:
+        sys.exit(f'No {args.prefix} directories found in {args.output_directory}')
+    target_directory = args.target if args.target else args.output_directory
+    os.makedirs(target_directory, exist_ok=True)
+
+    # Every shard writes the same set of files, take the names from the first one
+    for file_name in sorted(os.listdir(shards[0])):
+        if not file_name.endswith('.root'):
+            continue
+        sources = [os.path.join(shard, file_name) for shard in shards]
+        missing = [source for source in sources if not os.path.isfile(source)]
+        if missing:
+            sys.exit(f'File {file_name} is missing in {", ".join(missing)}')
+
+        # Histograms are added and trees are concatenated in the order of the shards, i.e. in the order of the events
+        target = os.path.join(target_directory, file_name)
+        command = [args.hadd] + (['-f'] if args.force else []) + [target] + sources
+        print(f'Merging {len(sources)} {args.prefix} directories into {target}')
+        if subprocess.run(command, stdout=subprocess.DEVNULL).returncode != 0:
+            sys.exit(f'Merging failed, command: {" ".join(command)}')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,80 @@
+#!/usr/bin/python3
+
+# SPDX-FileCopyrightText: 2024 CERN and the Allpix Squared authors
+# SPDX-License-Identifier: MIT
+
+import argparse
+import os
+import socket
+import sys
+import time
+
+
+# Send a single request line to the simulation service and return its reply
+def sendRequest(path, request):
+
+    with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as client:
+        client.connect(path)
+        client.sendall((request + "\n").encode())
+
+        reply = b""
+        while not reply.endswith(b"\n"):
+            data = client.recv(4096)
+            if not data:
+                break
+            reply += data
+        return reply.decode().strip()
+
+
+# Wait for the service to listen on its socket
+def waitForService(path, timeout):
+
+    start = time.time()
+    while not os.path.exists(path):
+        if time.time() - start > timeout:
+            return False
+        time.sleep(0.1)
+    return True
+
+
+if __name__ == '__main__':
+
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--socket", help="Socket the simulation service is listening on", required=True)
+    parser.add_argument("--events", help="Number of events to simulate", type=int)
+    parser.add_argument("--seed", help="Random seed of the simulation", type=int)
+    parser.add_argument("--output", help="Output directory of the request")
+    parser.add_argument("--shutdown", help="Stop the service after the request has been processed", action="store_true")
+    parser.add_argument("--background", help="Detach from the caller and wait for the service to start", action="store_true")
+    parser.add_argument("--timeout", help="Time in seconds to wait for the service to start", default=60., type=float)
+    args = parser.parse_args()
+
+    # Return to the caller immediately, e.g. to start the service after this script
+    if args.background and os.fork() != 0:
+        sys.exit(0)
+
+    if not waitForService(args.socket, args.timeout):
+        print("Simulation service did not start listening on socket " + args.socket)
+        sys.exit(1)
+
+    parameters = []
+    if args.events is not None:
+        parameters.append("number_of_events=" + str(args.events))
+    if args.seed is not None:
+        parameters.append("random_seed=" + str(args.seed))
+    if args.output is not None:
+        parameters.append("output_directory=" + args.output)
+
+    # The socket file is created shortly before the service accepts connections
+    while True:
+        try:
+            reply = sendRequest(args.socket, " ".join(parameters))
+            break
+        except ConnectionRefusedError:
+            time.sleep(0.1)
+    print("Reply of simulation service: " + reply)
+
+    if args.shutdown:
+        sendRequest(args.socket, "shutdown")
+
+    sys.exit(0 if reply.startswith("OK") else 1)
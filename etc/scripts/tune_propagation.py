@@ -0,0 +1,218 @@
+#!/usr/bin/python3
+
+# SPDX-FileCopyrightText: 2024 CERN and the Allpix Squared authors
+# SPDX-License-Identifier: MIT
+
+"""
+Tune the precision parameters of the charge carrier propagation to the cheapest settings which reproduce the collected
+charge, the cluster size and the hit timing of a high-precision reference within the given tolerances.
+"""
+
+import argparse
+import json
+import math
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+# Candidate values of the tuned parameters per propagation module, ordered from the most precise to the cheapest setting
+CANDIDATES = {
+    'GenericPropagation': [
+        ('charge_per_step', ['1', '2', '5', '10', '20', '50', '100']),
+        ('max_charge_groups', ['10000', '5000', '2000', '1000', '500', '200', '100']),
+        ('spatial_precision', ['0.1nm', '0.25nm', '0.5nm', '1nm', '2nm', '5nm', '10nm']),
+        ('timestep_min', ['0.0005ns', '0.001ns', '0.002ns', '0.005ns']),
+        ('timestep_max', ['0.1ns', '0.2ns', '0.5ns', '1ns', '2ns']),
+    ],
+    'TransientPropagation': [
+        ('charge_per_step', ['1', '2', '5', '10', '20', '50', '100']),
+        ('max_charge_groups', ['10000', '5000', '2000', '1000', '500', '200', '100']),
+        ('timestep', ['0.002ns', '0.005ns', '0.01ns', '0.02ns', '0.05ns', '0.1ns']),
+    ],
+}
+
+OBSERVABLES = ['charge', 'cluster_size', 'time']
+
+
+def propagation_module(config_file):
+    """
+    Find the first propagation module of the configuration which can be tuned.
+    """
+    with open(config_file) as config:
+        for line in config:
+            section = re.match(r'^\s*\[(.*)\]\s*$', line.split('#')[0])
+            if section and section.group(1) in CANDIDATES:
+                return section.group(1)
+    sys.exit(f'No section of the modules {", ".join(CANDIDATES)} found in {config_file}')
+
+
+def read_observables(text_file):
+    """
+    Read the collected charge, the cluster size and the mean hit time of every event from the output of the TextWriter.
+    """
+    events = []
+    with open(text_file) as output:
+        for line in output:
+            if line.startswith('=== '):
+                events.append({'charge': 0., 'pixels': 0, 'hits': 0, 'time': 0.})
+            elif line.startswith('Charge: '):
+                events[-1]['charge'] += float(line.split()[1])
+                events[-1]['pixels'] += 1
+            elif line.startswith('PixelHit '):
+                events[-1]['hits'] += 1
+                events[-1]['time'] += float(line[len('PixelHit '):].split(',')[3])
+
+    observables = {name: [] for name in OBSERVABLES}
+    for event in events:
+        observables['charge'].append(event['charge'])
+        # Without a digitizer the cluster size is given by the pixels receiving charge
+        observables['cluster_size'].append(event['hits'] if event['hits'] > 0 else event['pixels'])
+        if event['hits'] > 0:
+            observables['time'].append(event['time'] / event['hits'])
+    return observables
+
+
+def summarize(values):
+    """
+    Return the mean and the standard error of the mean of a list of values.
+    """
+    if not values:
+        return None
+    mean = sum(values) / len(values)
+    variance = sum((value - mean) ** 2 for value in values) / max(len(values) - 1, 1)
+    return mean, math.sqrt(variance / len(values))
+
+
+def run(args, config_file, settings):
+    """
+    Run the pilot events with the given settings and return the summarized observables and the event rate.
+    """
+    with tempfile.TemporaryDirectory() as output_directory:
+        command = [args.executable, '-c', config_file, '-o', f'output_directory={output_directory}',
+                   '-o', 'performance_report=true', '-o', 'log_level=WARNING', '-o', f'number_of_events={args.events}',
+                   '-o', f'random_seed={args.seed}']
+        for key, value in settings.items():
+            command += ['-o', f'{args.module}.{key}={value}']
+        for option in args.option:
+            command += ['-o', option]
+
+        if subprocess.run(command, stdout=subprocess.DEVNULL).returncode != 0:
+            sys.exit(f'Simulation failed, command: {" ".join(command)}')
+
+        with open(os.path.join(output_directory, 'performance.json')) as report:
+            run_time = json.load(report)['run_time_ns'] * 1e-9
+        observables = read_observables(os.path.join(output_directory, 'tuning.txt'))
+
+    return {name: summarize(values) for name, values in observables.items()}, args.events / run_time
+
+
+def compatible(reference, result, tolerances):
+    """
+    Check if all observables agree with the reference within the relative tolerance and two standard errors.
+    """
+    for name in OBSERVABLES:
+        if reference[name] is None or result[name] is None:
+            continue
+        (ref_mean, ref_error), (mean, error) = reference[name], result[name]
+        if abs(mean - ref_mean) > tolerances[name] * abs(ref_mean) + 2 * math.hypot(ref_error, error):
+            return False
+    return True
+
+
+def report(label, observables, rate):
+    """
+    Print a single line of the result table.
+    """
+    columns = []
+    for name in OBSERVABLES:
+        columns.append(f'{observables[name][0]:>14.4g}' if observables[name] is not None else f'{"-":>14}')
+    print(f'{label:<36} {" ".join(columns)} {rate:>12.1f}')
+
+
+def write_config(config_file, output_file, module, settings):
+    """
+    Copy the configuration file, replacing or adding the tuned parameters in the section of the propagation module.
+    """
+    with open(config_file) as config:
+        lines = config.read().splitlines()
+
+    def append_remaining(output, remaining):
+        # Add the parameters not yet present before the blank lines closing the section
+        end = len(output)
+        while end > 0 and not output[end - 1].strip():
+            end -= 1
+        output[end:end] = [f'{key} = {value}' for key, value in remaining.items()]
+
+    output = []
+    remaining = {}
+    for line in lines:
+        section = re.match(r'^\s*\[(.*)\]\s*$', line.split('#')[0])
+        if section:
+            append_remaining(output, remaining)
+            remaining = dict(settings) if section.group(1) == module else {}
+        else:
+            key = line.split('=')[0].strip()
+            if '=' in line and key in remaining:
+                line = f'{key} = {remaining.pop(key)}'
+        output.append(line)
+    append_remaining(output, remaining)
+
+    with open(output_file, 'w') as config:
+        config.write('\n'.join(output) + '\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('config', help='main configuration file of the simulation')
+    parser.add_argument('-x', '--executable', default='allpix', help='path to the allpix executable')
+    parser.add_argument('-n', '--events', type=int, default=200, help='number of pilot events per setting')
+    parser.add_argument('-s', '--seed', type=int, default=1, help='random seed used for all pilot runs')
+    parser.add_argument('-m', '--module', help='propagation module to tune, defaults to the first of the configuration')
+    parser.add_argument('--charge-tolerance', type=float, default=0.01, help='relative tolerance of the collected charge')
+    parser.add_argument('--cluster-tolerance', type=float, default=0.02, help='relative tolerance of the cluster size')
+    parser.add_argument('--time-tolerance', type=float, default=0.02, help='relative tolerance of the hit time')
+    parser.add_argument('-o', '--option', action='append', default=[], help='additional option passed to allpix')
+    parser.add_argument('--output', help='write the configuration with the tuned parameters to this file')
+    args = parser.parse_args()
+
+    args.module = args.module or propagation_module(args.config)
+    if args.module not in CANDIDATES:
+        sys.exit(f'Module {args.module} cannot be tuned, supported are {", ".join(CANDIDATES)}')
+    tolerances = {'charge': args.charge_tolerance, 'cluster_size': args.cluster_tolerance, 'time': args.time_tolerance}
+
+    # Write the hits and charges of every pilot event with the TextWriter, next to the original to resolve relative paths
+    with open(args.config) as config:
+        content = config.read()
+    with tempfile.NamedTemporaryFile('w', suffix='.conf', dir=os.path.dirname(os.path.abspath(args.config))) as pilot:
+        pilot.write(content + '\n[TextWriter]\nfile_name = "tuning"\ninclude = "PixelCharge" "PixelHit"\n')
+        pilot.flush()
+
+        print(f'{"settings":<36} {" ".join(f"{name:>14}" for name in OBSERVABLES)} {"events/s":>12}')
+        settings = {key: values[0] for key, values in CANDIDATES[args.module]}
+        reference, rate = run(args, pilot.name, settings)
+        report('reference', reference, rate)
+
+        # Relax one parameter at a time as long as all observables stay compatible with the reference
+        for key, values in CANDIDATES[args.module]:
+            for value in values[1:]:
+                trial = dict(settings, **{key: value})
+                observables, trial_rate = run(args, pilot.name, trial)
+                report(f'{key} = {value}', observables, trial_rate)
+                if not compatible(reference, observables, tolerances):
+                    break
+                settings, rate = trial, trial_rate
+
+    print(f'\nTuned parameters of {args.module}:')
+    for key, value in settings.items():
+        print(f'  {key} = {value}')
+    print(f'Predicted event rate: {rate:.1f} events/s')
+
+    if args.output:
+        write_config(args.config, args.output, args.module, settings)
+        print(f'Configuration written to {args.output}')
+
+
+if __name__ == '__main__':
+    main()
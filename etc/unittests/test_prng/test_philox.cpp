@@ -0,0 +1,131 @@
+/**
+ * @file
+ * @brief Unit test of the counter-based Philox4x64-10 pseudo-random number engine
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ *
+ * The blocks generated from a counter and a key are compared to the known-answer vectors published with the Random123
+ * library. The engine has to reproduce the same sequence when seeded again, after restoring a stored state and when
+ * skipping values, and different streams of the same seed have to differ.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "core/utils/prng.h"
+
+using namespace allpix;
+
+namespace {
+    bool failed = false;
+
+    void check(bool condition, const std::string& message) {
+        if(!condition) {
+            std::cerr << "FAILED: " << message << std::endl;
+            failed = true;
+        }
+    }
+
+    std::vector<Philox4x64::result_type> draw(Philox4x64& engine, size_t count) {
+        std::vector<Philox4x64::result_type> values(count);
+        for(auto& value : values) {
+            value = engine();
+        }
+        return values;
+    }
+
+    /**
+     * @brief Compare to the known-answer vectors of philox4x64_10 from the file kat_vectors of Random123
+     */
+    void test_known_answers() {
+        struct KnownAnswer {
+            std::array<std::uint64_t, 4> counter;
+            std::array<std::uint64_t, 2> key;
+            std::array<std::uint64_t, 4> result;
+        };
+        const std::array<KnownAnswer, 3> known_answers{{
+            {{0, 0, 0, 0}, {0, 0}, {0x16554d9eca36314c, 0xdb20fe9d672d0fdc, 0xd7e772cee186176b, 0x7e68b68aec7ba23b}},
+            {{UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX},
+             {UINT64_MAX, UINT64_MAX},
+             {0x87b092c3013fe90b, 0x438c3c67be8d0224, 0x9cc7d7c69cd777b6, 0xa09caebf594f0ba0}},
+            {{0x243f6a8885a308d3, 0x13198a2e03707344, 0xa4093822299f31d0, 0x082efa98ec4e6c89},
+             {0x452821e638d01377, 0xbe5466cf34e90c6c},
+             {0xa528f45403e61d95, 0x38c72dbd566e9788, 0xa5a1610e72fd18b5, 0x57bd43b5e52b7fe6}},
+        }};
+        for(size_t i = 0; i < known_answers.size(); ++i) {
+            const auto& answer = known_answers[i];
+            check(Philox4x64::generate(answer.counter, answer.key) == answer.result,
+                  "block differs from known-answer vector " + std::to_string(i));
+        }
+
+        // The engine encrypts the counters 0, 1, 2, ... with the seed and stream as key
+        Philox4x64 engine(0x452821e638d01377, 0xbe5466cf34e90c6c);
+        for(std::uint64_t counter = 0; counter < 3; ++counter) {
+            auto block = Philox4x64::generate({counter, 0, 0, 0}, {0x452821e638d01377, 0xbe5466cf34e90c6c});
+            for(auto expected : block) {
+                check(engine() == expected, "engine differs from block of counter " + std::to_string(counter));
+            }
+        }
+    }
+
+    /**
+     * @brief Check that the sequence of a seed is reproduced, also from a stored state and when skipping values
+     */
+    void test_reproducibility() {
+        constexpr std::uint64_t seed = 123456;
+        Philox4x64 engine(seed);
+        auto reference = draw(engine, 100);
+
+        // Seeding again reproduces the sequence
+        engine.seed(seed);
+        check(draw(engine, 100) == reference, "sequence not reproduced after seeding again");
+
+        // Restoring a state stored within a block reproduces the remaining sequence
+        for(size_t position : {0u, 3u, 4u, 41u}) {
+            Philox4x64 stored(seed);
+            draw(stored, position);
+            std::stringstream state;
+            state << stored;
+
+            Philox4x64 restored;
+            state >> restored;
+            check(restored == stored, "restored state differs after " + std::to_string(position) + " values");
+            auto remaining = draw(restored, reference.size() - position);
+            check(std::equal(remaining.begin(), remaining.end(), reference.begin() + static_cast<long>(position)),
+                  "sequence not reproduced from state stored after " + std::to_string(position) + " values");
+        }
+
+        // Skipping values continues at the same position as drawing them
+        for(size_t skip : {1u, 4u, 7u, 50u}) {
+            Philox4x64 skipped(seed);
+            draw(skipped, 2);
+            skipped.discard(skip);
+            check(skipped() == reference[2 + skip], "sequence not continued after skipping " + std::to_string(skip));
+        }
+
+        // Streams of the same seed are independent
+        Philox4x64 stream(seed, 1);
+        check(draw(stream, 100) != reference, "streams of the same seed produce the same sequence");
+    }
+} // namespace
+
+int main() {
+    test_known_answers();
+    test_reproducibility();
+
+    if(failed) {
+        return EXIT_FAILURE;
+    }
+    std::cout << "Philox4x64 reproduced the known-answer vectors and its sequences" << std::endl;
+    return EXIT_SUCCESS;
+}
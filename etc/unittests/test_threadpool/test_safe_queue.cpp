@@ -0,0 +1,192 @@
+/**
+ * @file
+ * @brief Unit test of the job queue of the thread pool under concurrent access
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ *
+ * Several producers push to a queue with a small maximum size while workers pop from their own queues and steal from the
+ * others. The size of the queue is sampled concurrently and has to stay within its maximum, a size decremented below zero
+ * wraps around and is detected as well. The queue is invalidated while producers wait for a free place. Finally,
+ * identifiers are completed concurrently and out of order, the current identifier has to advance over all of them.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/module/ThreadPool.hpp"
+
+using namespace allpix;
+
+namespace {
+    constexpr unsigned int max_size = 2;
+    constexpr unsigned int num_workers = 4;
+    constexpr unsigned int num_producers = 4;
+    constexpr size_t values_per_producer = 100000;
+
+    bool failed = false;
+
+    void check(bool condition, const std::string& message) {
+        if(!condition) {
+            std::cerr << "FAILED: " << message << std::endl;
+            failed = true;
+        }
+    }
+
+    /**
+     * @brief Push and pop concurrently, producers alternate between waiting and non-waiting pushes
+     * @param max_priority_size Maximum size of the priority queue
+     * @param buffer_left Places left in the priority queue by the workers, the oldest job is popped if there is no room for
+     *                    the events started by all workers
+     */
+    void test_concurrent_push_pop(unsigned int max_priority_size, size_t buffer_left) {
+        ThreadPool::SafeQueue<size_t> queue(max_size, max_priority_size, num_workers);
+
+        // Sample the size of the queue after every operation
+        std::atomic_size_t max_observed{0};
+        auto sample_size = [&]() {
+            auto size = queue.size();
+            auto observed = max_observed.load();
+            while(size > observed && !max_observed.compare_exchange_weak(observed, size)) {
+            }
+        };
+
+        std::atomic_size_t popped{0};
+        std::atomic_size_t sum{0};
+        std::vector<std::thread> workers;
+        for(unsigned int i = 0; i < num_workers; ++i) {
+            workers.emplace_back([&, i]() {
+                size_t value = 0;
+                while(queue.pop(value, buffer_left, i)) {
+                    sum += value;
+                    ++popped;
+                    sample_size();
+                }
+            });
+        }
+
+        std::vector<std::thread> producers;
+        for(unsigned int i = 0; i < num_producers; ++i) {
+            producers.emplace_back([&]() {
+                for(size_t value = 1; value <= values_per_producer; ++value) {
+                    if(value % 2 == 0) {
+                        while(!queue.push(value, false)) {
+                            std::this_thread::yield();
+                        }
+                    } else {
+                        queue.push(value);
+                    }
+                    sample_size();
+                }
+            });
+        }
+        for(auto& producer : producers) {
+            producer.join();
+        }
+
+        // Wait for the workers to drain the queue before releasing them
+        constexpr size_t total = num_producers * values_per_producer;
+        while(popped < total) {
+            std::this_thread::yield();
+        }
+
+        check(queue.size() == 0, "queue not empty after popping all values, size " + std::to_string(queue.size()));
+        queue.invalidate();
+        for(auto& worker : workers) {
+            worker.join();
+        }
+
+        check(max_observed <= max_size, "queue size exceeded the maximum, observed " + std::to_string(max_observed.load()));
+        check(sum == num_producers * values_per_producer * (values_per_producer + 1) / 2, "values lost or duplicated");
+    }
+
+    /**
+     * @brief Invalidate a full queue while producers are waiting for a free place
+     */
+    void test_invalidate_waiting() {
+        ThreadPool::SafeQueue<size_t> queue(max_size, 0, num_workers);
+        for(size_t value = 0; value < max_size; ++value) {
+            queue.push(value);
+        }
+
+        std::atomic_size_t rejected{0};
+        std::vector<std::thread> producers;
+        for(unsigned int i = 0; i < num_producers; ++i) {
+            producers.emplace_back([&]() {
+                if(!queue.push(0)) {
+                    ++rejected;
+                }
+            });
+        }
+
+        queue.invalidate();
+        for(auto& producer : producers) {
+            producer.join();
+        }
+
+        check(rejected == num_producers, "push succeeded on an invalidated queue");
+        check(queue.size() == 0, "queue size wrapped after invalidation, size " + std::to_string(queue.size()));
+    }
+
+    /**
+     * @brief Complete identifiers concurrently and out of order, also far ahead of the current identifier
+     */
+    void test_concurrent_complete() {
+        ThreadPool::SafeQueue<size_t> queue(max_size, 1, num_workers);
+        constexpr uint64_t count = 20000;
+
+        // Hold back the first identifier, such that most identifiers are far ahead of the current one
+        auto complete_range = [&](uint64_t first, uint64_t last) {
+            std::vector<std::thread> threads;
+            for(unsigned int i = 0; i < num_workers; ++i) {
+                threads.emplace_back([&, i]() {
+                    for(auto n = first + i; n < last; n += num_workers) {
+                        queue.complete(n);
+                    }
+                });
+            }
+            for(auto& thread : threads) {
+                thread.join();
+            }
+        };
+        complete_range(1, count);
+        check(queue.currentId() == 0, "current identifier advanced over an uncompleted one");
+        queue.complete(0);
+        check(queue.currentId() == count, "completed identifiers missed, current " + std::to_string(queue.currentId()));
+
+        // Complete the following identifiers interleaved by all threads
+        complete_range(count, 2 * count);
+        check(queue.currentId() == 2 * count,
+              "completed identifiers missed, current " + std::to_string(queue.currentId()));
+
+        // A priority job becomes ready once all identifiers before it are completed
+        size_t job = 1;
+        queue.push(2 * count + 1, job);
+        std::thread completer([&]() { queue.complete(2 * count); });
+        size_t value = 0;
+        check(queue.pop(value) && value == job, "priority job not popped after completing the identifiers before it");
+        completer.join();
+    }
+} // namespace
+
+int main() {
+    test_concurrent_push_pop(0, 0);
+    test_concurrent_push_pop(num_workers + num_workers / 2, num_workers);
+    test_invalidate_waiting();
+    test_concurrent_complete();
+
+    if(failed) {
+        return EXIT_FAILURE;
+    }
+    std::cout << "SafeQueue stayed within its maximum size and completed all identifiers under concurrent access"
+              << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -11,11 +11,20 @@
 
 #include "Allpix.hpp"
 
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
 #include <chrono>
+#include <cerrno>
 #include <climits>
+#include <cstdlib>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <memory>
+#include <sstream>
 #include <stdexcept>
 #include <thread>
 #include <utility>
@@ -25,6 +34,7 @@
 #include <TStyle.h>
 #include <TSystem.h>
 
+#include "core/config/ConfigReader.hpp"
 #include "core/config/exceptions.h"
 #include "core/utils/log.h"
 #include "core/utils/unit.h"
@@ -33,6 +43,14 @@
 
 using namespace allpix;
 
+namespace {
+    // Duration in nanoseconds since the given point in time
+    uint64_t elapsed_since(std::chrono::steady_clock::time_point start) {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    }
+} // namespace
+
 /**
  * This class will own the managers for the lifetime of the simulation. Will do early initialization:
  * - Configure the special header sections.
@@ -44,6 +62,8 @@ Allpix::Allpix(std::string config_file_name,
                const std::vector<std::string>& detector_options)
     : terminate_(false), has_run_(false), msg_(std::make_unique<Messenger>()), mod_mgr_(std::make_unique<ModuleManager>()),
       geo_mgr_(std::make_unique<GeometryManager>()) {
+    auto start_time = std::chrono::steady_clock::now();
+
     // Load the global configuration
     conf_mgr_ = std::make_unique<ConfigManager>(std::move(config_file_name),
                                                 std::initializer_list<std::string>({"Allpix", ""}),
@@ -95,9 +115,17 @@ Allpix::Allpix(std::string config_file_name,
         Log::addStream(log_file_);
     }
 
+    // Write the log messages from a dedicated thread to not block the threads processing the events
+    if(global_config.get<bool>("log_asynchronous", false)) {
+        Log::setAsynchronous(true);
+        LOG(TRACE) << "Writing log messages asynchronously";
+    }
+
     // Wait for the first detailed messages until level and format are properly set
     LOG(TRACE) << "Global log level is set to " << log_level_string;
     LOG(TRACE) << "Global log format is set to " << log_format_string;
+
+    mod_mgr_->recordStartupPhase("configuration", elapsed_since(start_time));
 }
 
 /**
@@ -109,6 +137,7 @@ Allpix::Allpix(std::string config_file_name,
  */
 void Allpix::load() {
     LOG(TRACE) << "Loading Allpix";
+    auto start_time = std::chrono::steady_clock::now();
 
     // Fetch the global configuration
     Configuration& global_config = conf_mgr_->getGlobalConfiguration();
@@ -157,10 +186,25 @@ void Allpix::load() {
         directory = global_config.getPath("output_directory");
     }
 
+    // Restrict the run to the events of this shard if the events are distributed over several processes
+    global_config.setDefault<unsigned int>("number_of_shards", 1u);
+    auto number_of_shards = global_config.get<unsigned int>("number_of_shards");
+    if(number_of_shards < 1) {
+        throw InvalidValueError(global_config, "number_of_shards", "number of shards should be larger than zero");
+    }
+    if(number_of_shards > 1) {
+        directory = (std::filesystem::path(directory) / ("shard_" + std::to_string(select_shard(global_config)))).string();
+    }
+
     // Use existing output directory if it exists
     bool create_output_dir = true;
     if(std::filesystem::is_directory(directory)) {
         if(global_config.get<bool>("purge_output_directory", false)) {
+            if(global_config.get<bool>("resume", false)) {
+                throw InvalidCombinationError(global_config,
+                                              {"purge_output_directory", "resume"},
+                                              "cannot resume a run from a purged output directory");
+            }
             LOG(DEBUG) << "Deleting previous output directory " << directory;
             std::filesystem::remove_all(directory);
         } else {
@@ -191,17 +235,57 @@ void Allpix::load() {
     // Set the ROOT style
     set_style();
 
+    mod_mgr_->recordStartupPhase("framework setup", elapsed_since(start_time));
+
     // Load the geometry
+    start_time = std::chrono::steady_clock::now();
     geo_mgr_->load(conf_mgr_.get(), seeder_core_);
+    mod_mgr_->recordStartupPhase("geometry", elapsed_since(start_time));
 
     // Load the modules from the configuration
     if(!terminate_) {
-        mod_mgr_->load(msg_.get(), conf_mgr_.get(), geo_mgr_.get());
+        mod_mgr_->load(msg_.get(), conf_mgr_.get(), geo_mgr_.get(), service_);
     } else {
         LOG(INFO) << "Skip loading modules because termination is requested";
     }
 }
 
+/**
+ * The events of the run are split into contiguous blocks of (almost) equal size, one for every shard. The block of this
+ * shard is selected by adjusting the number of events and the number of events to skip, such that all events keep the seeds
+ * they would have in a single run. If the shard index is not configured, it is taken from the rank provided by MPI and
+ * Slurm launchers.
+ */
+unsigned int Allpix::select_shard(Configuration& global_config) {
+    if(!global_config.has("shard_index")) {
+        for(const auto* variable : {"OMPI_COMM_WORLD_RANK", "PMI_RANK", "PMIX_RANK", "SLURM_PROCID"}) {
+            const char* rank = std::getenv(variable);
+            if(rank != nullptr) {
+                LOG(DEBUG) << "Using shard index " << rank << " from environment variable " << variable;
+                global_config.set<unsigned int>("shard_index", allpix::from_string<unsigned int>(rank));
+                break;
+            }
+        }
+    }
+
+    auto number_of_shards = global_config.get<unsigned int>("number_of_shards");
+    auto shard_index = global_config.get<unsigned int>("shard_index");
+    if(shard_index >= number_of_shards) {
+        throw InvalidValueError(global_config, "shard_index", "shard index should be smaller than the number of shards");
+    }
+
+    auto number_of_events = global_config.get<uint64_t>("number_of_events", 1u);
+    auto skip_events = global_config.get<uint64_t>("skip_events", 0u);
+    auto first_event = number_of_events * shard_index / number_of_shards;
+    auto end_event = number_of_events * (shard_index + 1) / number_of_shards;
+    global_config.set<uint64_t>("skip_events", skip_events + first_event);
+    global_config.set<uint64_t>("number_of_events", end_event - first_event);
+
+    LOG(STATUS) << "Processing events " << skip_events + first_event + 1 << " to " << skip_events + end_event
+                << " as shard " << shard_index << " of " << number_of_shards;
+    return shard_index;
+}
+
 /**
  * Runs the Module::initialize() method linearly for every module
  */
@@ -217,9 +301,22 @@ void Allpix::initialize() {
  * Runs every modules Module::run() method linearly for the number of events
  */
 void Allpix::run() {
-    if(!terminate_) {
+    if(!terminate_ && conf_mgr_->getGlobalConfiguration().get<uint64_t>("checkpoint_interval", 0u) > 0) {
+        LOG(TRACE) << "Running Allpix with checkpoints";
+        run_checkpointed();
+    } else if(!terminate_) {
         LOG(TRACE) << "Running Allpix";
-        mod_mgr_->run(seeder_modules_);
+        if(conf_mgr_->getGlobalConfiguration().get<bool>("resume", false)) {
+            LOG(WARNING) << "No checkpoint interval configured, running all events instead of resuming";
+        }
+        for(size_t point = 0; point < mod_mgr_->getSweepPoints() && !terminate_; ++point) {
+            if(point > 0) {
+                // Seed again such that every point of a parameter sweep simulates the same events
+                seeder_modules_.seed(conf_mgr_->getGlobalConfiguration().get<uint64_t>("random_seed"));
+                mod_mgr_->nextSweepPoint();
+            }
+            mod_mgr_->run(seeder_modules_);
+        }
 
         // Set that we have run and want to finalize as well
         has_run_ = true;
@@ -227,6 +324,211 @@ void Allpix::run() {
         LOG(INFO) << "Skip running modules because termination is requested";
     }
 }
+/**
+ * The events are processed in segments of the checkpoint interval. The modules starting from the checkpoint module are
+ * created for every segment and write to the subdirectory checkpoint_<N> of the output directory. Once a segment has been
+ * finalized, its output is complete and the number of completed events is stored in the checkpoint file. A resumed run
+ * continues after the last completed segment, discarding the output of an interrupted segment. Since every segment skips
+ * the events of all preceding segments, all events keep their seeds and the segments are identical to an uninterrupted
+ * run.
+ */
+void Allpix::run_checkpointed() {
+    Configuration& global_config = conf_mgr_->getGlobalConfiguration();
+    auto interval = global_config.get<uint64_t>("checkpoint_interval");
+    auto number_of_events = global_config.get<uint64_t>("number_of_events", 1u);
+    auto skip_events = global_config.get<uint64_t>("skip_events", 0u);
+    auto random_seed = global_config.get<uint64_t>("random_seed");
+    auto checkpoint_file = std::filesystem::path(gSystem->pwd()) / "checkpoint.conf";
+
+    // Continue after the last segment completed by the interrupted run
+    uint64_t completed_events = 0;
+    if(global_config.get<bool>("resume", false)) {
+        std::ifstream file(checkpoint_file);
+        if(!file.good()) {
+            throw InvalidValueError(global_config, "resume", "no checkpoint found in the output directory");
+        }
+        auto checkpoint = ConfigReader(file, checkpoint_file).getHeaderConfiguration();
+        for(const auto& key : {"random_seed", "number_of_events", "skip_events", "checkpoint_interval"}) {
+            if(checkpoint.get<uint64_t>(key) != global_config.get<uint64_t>(key, 0u)) {
+                throw InvalidValueError(global_config,
+                                        key,
+                                        "value differs from the interrupted run, which used " + checkpoint.getText(key));
+            }
+        }
+        completed_events = checkpoint.get<uint64_t>("completed_events");
+        LOG(STATUS) << "Resuming run after " << completed_events << " completed events";
+    } else {
+        std::filesystem::remove(checkpoint_file);
+    }
+
+    for(auto first = completed_events; first < number_of_events && !terminate_; first += interval) {
+        auto name = "checkpoint_" + std::to_string(first / interval);
+        auto directory = std::filesystem::path(gSystem->pwd()) / name;
+        auto events = std::min(interval, number_of_events - first);
+
+        // Discard the output of the segment if it has been interrupted before
+        std::filesystem::remove_all(directory);
+        LOG(STATUS) << "Processing events " << skip_events + first + 1 << " to " << skip_events + first + events << " into "
+                    << directory;
+        global_config.set<uint64_t>("number_of_events", events);
+        global_config.set<uint64_t>("skip_events", skip_events + first);
+        seeder_modules_.seed(random_seed);
+
+        mod_mgr_->startRequest(name, directory);
+        mod_mgr_->run(seeder_modules_);
+        mod_mgr_->finishRequest();
+        if(terminate_ || mod_mgr_->isTerminated()) {
+            LOG(WARNING) << "Segment " << name << " has been interrupted and is repeated when resuming the run";
+            break;
+        }
+
+        // Replace the checkpoint only once it has been written completely
+        auto partial_file = checkpoint_file;
+        partial_file.replace_extension("partial");
+        {
+            std::ofstream file(partial_file, std::ios_base::out | std::ios_base::trunc);
+            file << "# Checkpoint of the run, completed events are not simulated again with --resume" << std::endl
+                 << "random_seed = " << random_seed << std::endl
+                 << "number_of_events = " << number_of_events << std::endl
+                 << "skip_events = " << skip_events << std::endl
+                 << "checkpoint_interval = " << interval << std::endl
+                 << "completed_events = " << first + events << std::endl;
+            if(!file.good()) {
+                throw RuntimeError("Cannot write checkpoint file " + partial_file.string());
+            }
+        }
+        std::filesystem::rename(partial_file, checkpoint_file);
+        LOG(STATUS) << "Stored checkpoint after " << first + events << " of " << number_of_events << " events";
+    }
+
+    // Restore the configuration of the full run
+    global_config.set<uint64_t>("number_of_events", number_of_events);
+    global_config.set<uint64_t>("skip_events", skip_events);
+    has_run_ = true;
+}
+
+/**
+ * The framework is loaded and initialized once, such that libraries, geometry, fields and all modules preceding the server
+ * module stay warm. The socket is polled with a short timeout to react to termination requests while idle. Connections are
+ * handled one at a time, a failed request is reported to its client and does not stop the service.
+ */
+void Allpix::serve(const std::string& socket_path) {
+    service_ = true;
+    load();
+    initialize();
+
+    sockaddr_un address{};
+    if(socket_path.size() >= sizeof(address.sun_path)) {
+        throw RuntimeError("Socket path " + socket_path + " is too long");
+    }
+    address.sun_family = AF_UNIX;
+    socket_path.copy(address.sun_path, socket_path.size());
+
+    int server = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if(server < 0) {
+        throw RuntimeError("Cannot create socket: " + std::string(std::strerror(errno)));
+    }
+    std::filesystem::remove(socket_path);
+    if(::bind(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(server, 16) != 0) { // NOLINT
+        auto error = std::string(std::strerror(errno));
+        ::close(server);
+        throw RuntimeError("Cannot listen on socket " + socket_path + ": " + error);
+    }
+    LOG(STATUS) << "Serving simulation requests on socket " << socket_path;
+
+    size_t index = 0;
+    while(!terminate_) {
+        pollfd poll_fd{server, POLLIN, 0};
+        if(::poll(&poll_fd, 1, 200) <= 0) {
+            continue;
+        }
+        int client = ::accept(server, nullptr, nullptr);
+        if(client < 0) {
+            continue;
+        }
+
+        // Read a single request line
+        std::string request;
+        char character = 0;
+        while(request.size() < 4096 && ::read(client, &character, 1) == 1 && character != '\n') {
+            request += character;
+        }
+
+        std::string reply;
+        if(request == "shutdown") {
+            LOG(STATUS) << "Shutdown of the simulation service requested";
+            terminate_ = true;
+            reply = "OK shutdown";
+        } else {
+            try {
+                reply = "OK " + process_request(request, index++);
+            } catch(const std::exception& e) {
+                LOG(ERROR) << "Request " << request << " failed: " << e.what();
+                reply = "ERROR " + std::string(e.what());
+            }
+        }
+        reply += '\n';
+        if(::write(client, reply.data(), reply.size()) < 0) {
+            LOG(WARNING) << "Cannot send reply to request " << request;
+        }
+        ::close(client);
+    }
+
+    ::close(server);
+    std::filesystem::remove(socket_path);
+}
+
+std::string Allpix::process_request(const std::string& request, size_t index) {
+    Configuration& global_config = conf_mgr_->getGlobalConfiguration();
+    auto name = "request_" + std::to_string(index);
+
+    // Parse the request, parameters not given are taken from the configuration
+    auto number_of_events = global_config.get<uint64_t>("number_of_events", 1u);
+    auto seed = global_config.get<uint64_t>("random_seed");
+    std::filesystem::path directory = std::filesystem::path(gSystem->pwd()) / name;
+    std::istringstream stream(request);
+    std::string token;
+    while(stream >> token) {
+        auto separator = token.find('=');
+        if(separator == std::string::npos) {
+            throw RuntimeError("Invalid request parameter " + token + ", expected key=value");
+        }
+        auto key = token.substr(0, separator);
+        auto value = token.substr(separator + 1);
+        if(key == "number_of_events") {
+            number_of_events = allpix::from_string<uint64_t>(value);
+        } else if(key == "random_seed") {
+            seed = allpix::from_string<uint64_t>(value);
+        } else if(key == "output_directory") {
+            // Relative paths are resolved against the output directory of the service
+            directory = std::filesystem::path(gSystem->pwd()) / value;
+        } else {
+            throw RuntimeError("Unknown request parameter " + key);
+        }
+    }
+
+    LOG(STATUS) << "Processing " << name << " with " << number_of_events << " events and seed " << seed << " into "
+                << directory;
+    global_config.set<uint64_t>("number_of_events", number_of_events);
+    seeder_modules_.seed(seed);
+
+    try {
+        mod_mgr_->startRequest(name, directory);
+        mod_mgr_->run(seeder_modules_);
+        has_run_ = true;
+    } catch(...) {
+        // Complete the output of the failed request to keep the service usable
+        try {
+            mod_mgr_->finishRequest();
+        } catch(const std::exception& e) {
+            LOG(ERROR) << "Cannot finalize " << name << ": " << e.what();
+        }
+        throw;
+    }
+    mod_mgr_->finishRequest();
+    return directory.string();
+}
+
 /**
  * Runs all modules Module::finalize() method linearly for every module
  */
@@ -65,6 +65,19 @@ namespace allpix {
          */
         void run();
 
+        /**
+         * @brief Serve run requests on a local socket until termination is requested (service mode)
+         * @param socket_path Path of the Unix domain socket to listen on
+         * @warning Replaces the \ref Allpix::load "load", \ref Allpix::initialize "init" and \ref Allpix::run "run"
+         *          functions and should be followed by the \ref Allpix::finalize "finalize function"
+         *
+         * The modules preceding the configured server module are loaded and initialized only once, while the server
+         * module and all following modules are created for every request. Every connection submits a single request line
+         * with the optional parameters number_of_events, random_seed and output_directory, or the line shutdown to stop
+         * the service. Requests are processed one after the other and answered with a line starting with OK or ERROR.
+         */
+        void serve(const std::string& socket_path);
+
         /**
          * @brief Finalize all modules (post-run)
          * @warning Should be called after the \ref Allpix::run "run function"
@@ -82,9 +95,31 @@ namespace allpix {
          */
         void set_style();
 
+        /**
+         * @brief Select the range of events processed by this shard of a run distributed over several processes
+         * @param global_config Global configuration, the number of events and events to skip are updated for the shard
+         * @return Index of this shard
+         */
+        unsigned int select_shard(Configuration& global_config);
+
+        /**
+         * @brief Run all events in segments of the checkpoint interval, storing a checkpoint after every segment
+         */
+        void run_checkpointed();
+
+        /**
+         * @brief Process a single request to the simulation service
+         * @param request Request line with space separated key=value pairs
+         * @param index Index of the request, used to name its output
+         * @return Output directory of the request
+         */
+        std::string process_request(const std::string& request, size_t index);
+
         // Indicate the framework should terminate
         std::atomic<bool> terminate_;
         std::atomic<bool> has_run_;
+        // Indicate the framework runs as a simulation service
+        bool service_{false};
 
         // Log file if specified
         std::ofstream log_file_;
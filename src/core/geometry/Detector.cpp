@@ -9,6 +9,8 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <algorithm>
+#include <iterator>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -32,14 +34,13 @@ Detector::Detector(std::string name,
                    ROOT::Math::XYZPoint position,
                    const ROOT::Math::Rotation3D& orientation)
     : Detector(std::move(name), std::move(position), orientation) {
-    model_ = std::move(model); // NOLINT
     // Check if valid model is supplied
-    if(model_ == nullptr) {
+    if(model == nullptr) {
         throw InvalidModuleActionException("Detector model cannot be a null pointer");
     }
 
-    // Build the transformation matrix
-    build_transform();
+    // Initialize the fields with the model and build the transformation matrix
+    set_model(std::move(model));
 }
 
 /**
@@ -74,6 +75,9 @@ void Detector::build_transform() {
     ROOT::Math::Transform3D transform_local(translation_local);
     // Compute total transform local to global by first transforming local to locally centered and then to global coordinates
     transform_ = transform_center * transform_local.Inverse();
+
+    // Cache the inverse transformation from global to local coordinates
+    inverse_transform_ = transform_.Inverse();
 }
 
 /**
@@ -82,12 +86,25 @@ void Detector::build_transform() {
  * The origin of the local frame is at the center of the first pixel in the middle of the sensor.
  */
 ROOT::Math::XYZPoint Detector::getLocalPosition(const ROOT::Math::XYZPoint& global_pos) const {
-    return transform_.Inverse()(global_pos);
+    return inverse_transform_(global_pos);
 }
 ROOT::Math::XYZPoint Detector::getGlobalPosition(const ROOT::Math::XYZPoint& local_pos) const {
     return transform_(local_pos);
 }
 
+std::vector<ROOT::Math::XYZPoint> Detector::getLocalPositions(const std::vector<ROOT::Math::XYZPoint>& global_pos) const {
+    std::vector<ROOT::Math::XYZPoint> local_pos;
+    local_pos.reserve(global_pos.size());
+    std::transform(global_pos.begin(), global_pos.end(), std::back_inserter(local_pos), inverse_transform_);
+    return local_pos;
+}
+std::vector<ROOT::Math::XYZPoint> Detector::getGlobalPositions(const std::vector<ROOT::Math::XYZPoint>& local_pos) const {
+    std::vector<ROOT::Math::XYZPoint> global_pos;
+    global_pos.reserve(local_pos.size());
+    std::transform(local_pos.begin(), local_pos.end(), std::back_inserter(global_pos), transform_);
+    return global_pos;
+}
+
 /**
  * The pixel has internal information about the size and location specific for this detector
  */
@@ -97,16 +114,19 @@ Pixel Detector::getPixel(int x, int y) const {
 }
 
 /**
- * The pixel has internal information about the size and location specific for this detector
+ * The pixel has internal information about the size and location specific for this detector. Its location is only computed
+ * from the index when accessed, such that creating pixels for every hit does not require any geometry computations.
  */
 Pixel Detector::getPixel(const Pixel::Index& index) const {
-    auto size = model_->getPixelSize();
-    auto type = model_->getPixelType();
+    return {index, model_->getPixelType(), model_->getPixelSize(), this};
+}
 
-    auto local_center = model_->getPixelCenter(index.x(), index.y());
-    auto global_center = getGlobalPosition(local_center);
+ROOT::Math::XYZPoint Detector::getLocalPixelCenter(const Pixel::Index& index) const {
+    return model_->getPixelCenter(index.x(), index.y());
+}
 
-    return {index, type, std::move(local_center), std::move(global_center), std::move(size)};
+ROOT::Math::XYZPoint Detector::getGlobalPixelCenter(const Pixel::Index& index) const {
+    return getGlobalPosition(getLocalPixelCenter(index));
 }
 
 /**
@@ -120,15 +140,29 @@ ROOT::Math::XYZVector Detector::getElectricField(const ROOT::Math::XYZPoint& loc
 /**
  * @throws std::invalid_argument If the electric field dimensions are incorrect or the thickness domain is outside the sensor
  */
-void Detector::setElectricFieldGrid(const std::shared_ptr<std::vector<double>>& field,
-                                    std::array<size_t, 3> bins,
-                                    std::array<double, 3> size,
-                                    FieldMapping mapping,
-                                    std::array<double, 2> scales,
-                                    std::array<double, 2> offset,
-                                    std::pair<double, double> thickness_domain) {
+FieldStorageSummary Detector::setElectricFieldGrid(std::shared_ptr<const double> field,
+                                                   std::array<size_t, 3> bins,
+                                                   std::array<double, 3> size,
+                                                   FieldMapping mapping,
+                                                   std::array<double, 2> scales,
+                                                   std::array<double, 2> offset,
+                                                   std::pair<double, double> thickness_domain,
+                                                   FieldPrecision precision,
+                                                   FieldInterpolation interpolation,
+                                                   std::shared_ptr<const FieldRefinement> refinement,
+                                                   FieldLayout layout) {
     check_field_match(size, mapping, scales, thickness_domain);
-    electric_field_.setGrid(field, bins, size, mapping, scales, offset, thickness_domain);
+    return electric_field_.setGrid(std::move(field),
+                                   bins,
+                                   size,
+                                   mapping,
+                                   scales,
+                                   offset,
+                                   thickness_domain,
+                                   precision,
+                                   interpolation,
+                                   std::move(refinement),
+                                   layout);
 }
 
 void Detector::setElectricFieldFunction(FieldFunction<ROOT::Math::XYZVector> function,
@@ -149,19 +183,59 @@ double Detector::getWeightingPotential(const ROOT::Math::XYZPoint& local_pos, co
     return weighting_potential_.getRelativeTo(local_pos, ref, true);
 }
 
+/**
+ * The pixel centers of the references and the mapping of the field are resolved once for both positions. Thread-local
+ * buffers are used to avoid allocations for every step of the charge carriers.
+ */
+void Detector::getWeightingPotentials(const ROOT::Math::XYZPoint& local_pos,
+                                      const ROOT::Math::XYZPoint& last_local_pos,
+                                      const std::vector<Pixel::Index>& references,
+                                      std::vector<std::pair<double, double>>& potentials) const {
+    thread_local std::vector<ROOT::Math::XYPoint> centers;
+    thread_local std::vector<double> values, last_values;
+
+    centers.clear();
+    for(const auto& reference : references) {
+        centers.emplace_back(model_->getPixelCenter(reference.x(), reference.y()));
+    }
+
+    // Extrapolating along z as for the weighting potential of a single pixel
+    weighting_potential_.getRelativeTo(local_pos, centers, values, true);
+    weighting_potential_.getRelativeTo(last_local_pos, centers, last_values, true);
+
+    potentials.resize(references.size());
+    for(size_t i = 0; i < references.size(); ++i) {
+        potentials[i] = {values[i], last_values[i]};
+    }
+}
+
 /**
  * @throws std::invalid_argument If the weighting potential dimensions are incorrect or the thickness domain is outside the
  * sensor
  */
-void Detector::setWeightingPotentialGrid(const std::shared_ptr<std::vector<double>>& potential,
-                                         std::array<size_t, 3> bins,
-                                         std::array<double, 3> size,
-                                         FieldMapping mapping,
-                                         std::array<double, 2> scales,
-                                         std::array<double, 2> offset,
-                                         std::pair<double, double> thickness_domain) {
+FieldStorageSummary Detector::setWeightingPotentialGrid(std::shared_ptr<const double> potential,
+                                                        std::array<size_t, 3> bins,
+                                                        std::array<double, 3> size,
+                                                        FieldMapping mapping,
+                                                        std::array<double, 2> scales,
+                                                        std::array<double, 2> offset,
+                                                        std::pair<double, double> thickness_domain,
+                                                        FieldPrecision precision,
+                                                        FieldInterpolation interpolation,
+                                                        std::shared_ptr<const FieldRefinement> refinement,
+                                                        FieldLayout layout) {
     check_field_match(size, mapping, scales, thickness_domain);
-    weighting_potential_.setGrid(potential, bins, size, mapping, scales, offset, thickness_domain);
+    return weighting_potential_.setGrid(std::move(potential),
+                                        bins,
+                                        size,
+                                        mapping,
+                                        scales,
+                                        offset,
+                                        thickness_domain,
+                                        precision,
+                                        interpolation,
+                                        std::move(refinement),
+                                        layout);
 }
 
 void Detector::setWeightingPotentialFunction(FieldFunction<double> function,
@@ -191,21 +265,43 @@ double Detector::getDopingConcentration(const ROOT::Math::XYZPoint& pos) const {
     return doping_profile_.get(pos, true);
 }
 
+void Detector::prefetchFields(const ROOT::Math::XYZPoint& local_pos, bool weighting_potential) const {
+    electric_field_.prefetch(local_pos);
+    doping_profile_.prefetch(local_pos);
+    if(weighting_potential) {
+        weighting_potential_.prefetch(local_pos);
+    }
+}
+
 /**
  * @throws std::invalid_argument If the doping profile dimensions are incorrect
  *
  * The doping profile is stored as a large flat array. If the sizes are denoted as respectively X_SIZE, Y_ SIZE and Z_SIZE,
  * each position (x, y, z) has one index, calculated as x*Y_SIZE*Z_SIZE+y*Z_SIZE+z
  */
-void Detector::setDopingProfileGrid(std::shared_ptr<std::vector<double>> field,
-                                    std::array<size_t, 3> bins,
-                                    std::array<double, 3> size,
-                                    FieldMapping mapping,
-                                    std::array<double, 2> scales,
-                                    std::array<double, 2> offset,
-                                    std::pair<double, double> thickness_domain) {
+FieldStorageSummary Detector::setDopingProfileGrid(std::shared_ptr<const double> field,
+                                                   std::array<size_t, 3> bins,
+                                                   std::array<double, 3> size,
+                                                   FieldMapping mapping,
+                                                   std::array<double, 2> scales,
+                                                   std::array<double, 2> offset,
+                                                   std::pair<double, double> thickness_domain,
+                                                   FieldPrecision precision,
+                                                   FieldInterpolation interpolation,
+                                                   std::shared_ptr<const FieldRefinement> refinement,
+                                                   FieldLayout layout) {
     check_field_match(size, mapping, scales, thickness_domain);
-    doping_profile_.setGrid(std::move(field), bins, size, mapping, scales, offset, thickness_domain);
+    return doping_profile_.setGrid(std::move(field),
+                                   bins,
+                                   size,
+                                   mapping,
+                                   scales,
+                                   offset,
+                                   thickness_domain,
+                                   precision,
+                                   interpolation,
+                                   std::move(refinement),
+                                   layout);
 }
 
 void Detector::setDopingProfileFunction(FieldFunction<double> function, FieldType type) {
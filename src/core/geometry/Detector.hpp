@@ -19,6 +19,7 @@
 #include <string>
 #include <tuple>
 #include <typeindex>
+#include <utility>
 #include <vector>
 
 #include <Math/Point3D.h>
@@ -38,7 +39,7 @@ namespace allpix {
      * Contains the detector in the world with several unique properties (like the electric field). All model specific
      * properties are stored in its DetectorModel instead.
      */
-    class Detector {
+    class Detector : public Pixel::Geometry {
         friend class GeometryManager;
 
     public:
@@ -89,6 +90,18 @@ namespace allpix {
          * @return Position in the global frame
          */
         ROOT::Math::XYZPoint getGlobalPosition(const ROOT::Math::XYZPoint& local_pos) const;
+        /**
+         * @brief Convert a set of global positions to positions in the detector frame
+         * @param global_pos Positions in the global frame
+         * @return Positions in the local frame, in the same order as the input
+         */
+        std::vector<ROOT::Math::XYZPoint> getLocalPositions(const std::vector<ROOT::Math::XYZPoint>& global_pos) const;
+        /**
+         * @brief Convert a set of positions in the detector frame to global positions
+         * @param local_pos Positions in the local frame
+         * @return Positions in the global frame, in the same order as the input
+         */
+        std::vector<ROOT::Math::XYZPoint> getGlobalPositions(const std::vector<ROOT::Math::XYZPoint>& local_pos) const;
 
         /**
          * @brief Return a pixel object from the x- and y-index values
@@ -102,6 +115,20 @@ namespace allpix {
          */
         Pixel getPixel(const Pixel::Index& index) const;
 
+        /**
+         * @brief Get the center of a pixel in local coordinates
+         * @param index Index of the pixel
+         * @return Local center position
+         */
+        ROOT::Math::XYZPoint getLocalPixelCenter(const Pixel::Index& index) const override;
+
+        /**
+         * @brief Get the center of a pixel in global coordinates
+         * @param index Index of the pixel
+         * @return Global center position
+         */
+        ROOT::Math::XYZPoint getGlobalPixelCenter(const Pixel::Index& index) const override;
+
         /**
          * @brief Returns if the detector has an electric field in the sensor
          * @return True if the detector has an electric field, false otherwise
@@ -113,30 +140,64 @@ namespace allpix {
          * @return The type of the electric field
          */
         FieldType getElectricFieldType() const { return electric_field_.getType(); }
+        /**
+         * @brief Return the mapping of the electric field onto the sensor
+         * @return Mapping of the electric field, only meaningful for fields defined on a grid
+         */
+        FieldMapping getElectricFieldMapping() const { return electric_field_.getMapping(); }
         /**
          * @brief Get the electric field in the sensor at a local position
          * @param local_pos Position in the local frame
          * @return Vector of the field at the queried point
          */
         ROOT::Math::XYZVector getElectricField(const ROOT::Math::XYZPoint& local_pos) const;
+        /**
+         * @brief Call a function with an accessor to the electric field, specialized for the type of the field
+         * @param function Function called with the \ref FieldAccessor as argument
+         * @return Return value of the called function
+         * @note The accessor returns the same values as \ref getElectricField but resolves the type of the field only once
+         */
+        template <typename F> decltype(auto) visitElectricField(F&& function) const {
+            return electric_field_.visit(std::forward<F>(function));
+        }
+        /**
+         * @brief Derive a field on the grid of the electric field map from the electric field at the grid points
+         * @param function Function returning the derived value from the electric field and the position of a grid point
+         * @param reference Center of the pixel the grid points are placed at for fields mapped onto pixels
+         * @return Derived field, see \ref DetectorField::derive
+         * @throws std::logic_error If the electric field is not defined on a grid
+         */
+        template <typename T, size_t N, typename F>
+        DetectorField<T, N> deriveFromElectricField(F&& function, const ROOT::Math::XYPoint& reference) const {
+            return electric_field_.template derive<T, N>(std::forward<F>(function), reference);
+        }
 
         /**
          * @brief Set the electric field in a single pixel in the detector using a grid
-         * @param field Flat array of the field vectors (see detailed description)
+         * @param field Pointer to the flat array of the field vectors (see detailed description), keeping its storage alive
          * @param bins The dimensions of the flat electric field array
          * @param size Size of the electric field along the three dimensions of the field map
          * @param mapping Specification of the mapping of the field onto the pixel plane
          * @param scales Scaling factors for the field size, given in fractions of the field size in x and y
          * @param offset Offset of the field, given in fractions of the field size in x and y
          * @param thickness_domain Domain in local coordinates in the thickness direction where the field holds
-         */
-        void setElectricFieldGrid(const std::shared_ptr<std::vector<double>>& field,
-                                  std::array<size_t, 3> bins,
-                                  std::array<double, 3> size,
-                                  FieldMapping mapping,
-                                  std::array<double, 2> scales,
-                                  std::array<double, 2> offset,
-                                  std::pair<double, double> thickness_domain);
+         * @param precision Precision with which the values are stored
+         * @param interpolation Interpolation of the values between the grid points
+         * @param refinement Optional refined cells of the grid
+         * @param layout Memory layout with which the values are stored
+         * @return Summary of the memory saved and the deviation introduced by the storage precision
+         */
+        FieldStorageSummary setElectricFieldGrid(std::shared_ptr<const double> field,
+                                                 std::array<size_t, 3> bins,
+                                                 std::array<double, 3> size,
+                                                 FieldMapping mapping,
+                                                 std::array<double, 2> scales,
+                                                 std::array<double, 2> offset,
+                                                 std::pair<double, double> thickness_domain,
+                                                 FieldPrecision precision = FieldPrecision::DOUBLE,
+                                                 FieldInterpolation interpolation = FieldInterpolation::NEAREST,
+                                                 std::shared_ptr<const FieldRefinement> refinement = nullptr,
+                                                 FieldLayout layout = FieldLayout::ROW_MAJOR);
         /**
          * @brief Set the electric field in a single pixel using a function
          * @param function Function used to retrieve the electric field
@@ -158,6 +219,11 @@ namespace allpix {
          * @return The type of the doping profile
          */
         FieldType getDopingProfileType() const { return doping_profile_.getType(); }
+        /**
+         * @brief Return the mapping of the doping profile onto the sensor
+         * @return Mapping of the doping profile, only meaningful for profiles defined on a grid
+         */
+        FieldMapping getDopingProfileMapping() const { return doping_profile_.getMapping(); }
         /**
          * @brief Get the doping profile in the sensor at a local position
          * @param pos Position in the local frame
@@ -167,21 +233,30 @@ namespace allpix {
 
         /**
          * @brief Set the doping profile in a single pixel in the detector using a grid
-         * @param field Flat array of the field (see detailed description)
+         * @param field Pointer to the flat array of the field (see detailed description), keeping its storage alive
          * @param bins The dimensions of the flat doping profile array
          * @param size Size of the doping profile along the three dimensions of the field map
          * @param mapping Specification of the mapping of the field onto the pixel plane
          * @param scales Scaling factors for the field size, given in fractions of a pixel unit cell in x and y
          * @param offset Offset of the field, given in fractions of the field size in x and y
          * @param thickness_domain Domain in local coordinates in the thickness direction where the profile holds
-         */
-        void setDopingProfileGrid(std::shared_ptr<std::vector<double>> field,
-                                  std::array<size_t, 3> bins,
-                                  std::array<double, 3> size,
-                                  FieldMapping mapping,
-                                  std::array<double, 2> scales,
-                                  std::array<double, 2> offset,
-                                  std::pair<double, double> thickness_domain);
+         * @param precision Precision with which the values are stored
+         * @param interpolation Interpolation of the values between the grid points
+         * @param refinement Optional refined cells of the grid
+         * @param layout Memory layout with which the values are stored
+         * @return Summary of the memory saved and the deviation introduced by the storage precision
+         */
+        FieldStorageSummary setDopingProfileGrid(std::shared_ptr<const double> field,
+                                                 std::array<size_t, 3> bins,
+                                                 std::array<double, 3> size,
+                                                 FieldMapping mapping,
+                                                 std::array<double, 2> scales,
+                                                 std::array<double, 2> offset,
+                                                 std::pair<double, double> thickness_domain,
+                                                 FieldPrecision precision = FieldPrecision::DOUBLE,
+                                                 FieldInterpolation interpolation = FieldInterpolation::NEAREST,
+                                                 std::shared_ptr<const FieldRefinement> refinement = nullptr,
+                                                 FieldLayout layout = FieldLayout::ROW_MAJOR);
         /**
          * @brief Set the doping profile in a single pixel using a function
          * @param function Function used to retrieve the doping profile
@@ -209,23 +284,52 @@ namespace allpix {
          */
         double getWeightingPotential(const ROOT::Math::XYZPoint& local_pos, const Pixel::Index& reference) const;
 
+        /**
+         * @brief Get the weighting potentials of several pixels at the start and end point of a step
+         * @param local_pos Position in the local frame at the end of the step
+         * @param last_local_pos Position in the local frame at the start of the step
+         * @param references Indices of the pixels for which we want the weighting potential
+         * @param potentials Values of the potential at the end and start of the step for each of the pixels
+         */
+        void getWeightingPotentials(const ROOT::Math::XYZPoint& local_pos,
+                                    const ROOT::Math::XYZPoint& last_local_pos,
+                                    const std::vector<Pixel::Index>& references,
+                                    std::vector<std::pair<double, double>>& potentials) const;
+
+        /**
+         * @brief Prefetch the electric field and doping profile at a local position into the cache
+         * @param local_pos Position in the local frame, typically the predicted position of a future lookup
+         * @param weighting_potential Also prefetch the weighting potential of the pixel containing the position
+         * @note Only fields defined on a grid are prefetched, see \ref DetectorField::prefetch
+         */
+        void prefetchFields(const ROOT::Math::XYZPoint& local_pos, bool weighting_potential) const;
+
         /**
          * @brief Set the weighting potential in a single pixel in the detector using a grid
-         * @param potential Flat array of the potential vectors (see detailed description)
+         * @param potential Pointer to the flat array of the potential (see detailed description), keeping its storage alive
          * @param bins The dimensions of the flat weighting potential array
          * @param size Size of the weighting potential along the three dimensions of the field map
          * @param mapping Specification of the mapping of the field onto the pixel plane
          * @param scales Scaling factors for the field size, given in fractions of a pixel unit cell in x and y
          * @param offset Offset of the field, given in fractions of the field size in x and y
          * @param thickness_domain Domain in local coordinates in the thickness direction where the potential holds
-         */
-        void setWeightingPotentialGrid(const std::shared_ptr<std::vector<double>>& potential,
-                                       std::array<size_t, 3> bins,
-                                       std::array<double, 3> size,
-                                       FieldMapping mapping,
-                                       std::array<double, 2> scales,
-                                       std::array<double, 2> offset,
-                                       std::pair<double, double> thickness_domain);
+         * @param precision Precision with which the values are stored
+         * @param interpolation Interpolation of the values between the grid points
+         * @param refinement Optional refined cells of the grid
+         * @param layout Memory layout with which the values are stored
+         * @return Summary of the memory saved and the deviation introduced by the storage precision
+         */
+        FieldStorageSummary setWeightingPotentialGrid(std::shared_ptr<const double> potential,
+                                                      std::array<size_t, 3> bins,
+                                                      std::array<double, 3> size,
+                                                      FieldMapping mapping,
+                                                      std::array<double, 2> scales,
+                                                      std::array<double, 2> offset,
+                                                      std::pair<double, double> thickness_domain,
+                                                      FieldPrecision precision = FieldPrecision::DOUBLE,
+                                                      FieldInterpolation interpolation = FieldInterpolation::NEAREST,
+                                                      std::shared_ptr<const FieldRefinement> refinement = nullptr,
+                                                      FieldLayout layout = FieldLayout::ROW_MAJOR);
         /**
          * @brief Set the weighting potential in a single pixel using a function
          * @param function Function used to retrieve the weighting potential
@@ -298,8 +402,9 @@ namespace allpix {
         ROOT::Math::XYZPoint position_;
         ROOT::Math::Rotation3D orientation_;
 
-        // Transform matrix from global to local coordinates
+        // Transform matrix from local to global coordinates and its precomputed inverse
         ROOT::Math::Transform3D transform_;
+        ROOT::Math::Transform3D inverse_transform_;
 
         // Electric field
         DetectorField<ROOT::Math::XYZVector, 3> electric_field_;
@@ -12,8 +12,17 @@
 #ifndef ALLPIX_DETECTOR_FIELD_H
 #define ALLPIX_DETECTOR_FIELD_H
 
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstdint>
 #include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
 #include <Math/Point2D.h>
@@ -22,8 +31,10 @@
 #include <Math/Vector3D.h>
 
 #include "DetectorModel.hpp"
+#include "core/utils/numa.h"
 #include "objects/Pixel.hpp"
 #include "tools/ROOT.h"
+#include "tools/field_refinement.h"
 
 namespace allpix {
 
@@ -61,6 +72,40 @@ namespace allpix {
                 ///< mirrored at its edges.
     };
 
+    /**
+     * @brief Precision with which field grids are stored
+     */
+    enum class FieldPrecision {
+        DOUBLE = 0, ///< Field values are stored as double-precision floating point numbers
+        FLOAT,      ///< Field values are stored as single-precision floating point numbers
+        QUANTIZED,  ///< Field values are stored as 16-bit integers with a linear scale per field component
+    };
+
+    /**
+     * @brief Interpolation of field grids between the grid points
+     */
+    enum class FieldInterpolation {
+        NEAREST = 0, ///< The value of the grid cell containing the position is used
+        TRILINEAR,   ///< Linear interpolation between the centers of the neighboring grid cells along each axis
+        TRICUBIC,    ///< Cubic Catmull-Rom interpolation using the four nearest grid cells along each axis
+    };
+
+    /**
+     * @brief Memory layout of field grids
+     */
+    enum class FieldLayout {
+        ROW_MAJOR = 0, ///< Cells are stored with the z index running fastest, followed by the y and the x index
+        BRICKED,       ///< Cells are stored in bricks of 4x4x4 cells, keeping neighboring cells of all axes close in memory
+    };
+
+    /**
+     * @brief Summary of the storage of a field grid with reduced precision
+     */
+    struct FieldStorageSummary {
+        std::size_t memory_saved{}; ///< Memory saved with respect to double-precision storage, in bytes
+        double max_deviation{};     ///< Maximum absolute deviation of any stored field value from its original value
+    };
+
     /**
      * @brief Functor returning the field at a given position
      * @param pos Position in local coordinates at which the field should be evaluated
@@ -88,6 +133,27 @@ namespace allpix {
      */
     template <> inline void flip_vector_components<double>(double&, bool, bool) {}
 
+    /**
+     * @brief Helper function to obtain the magnitude of a field value
+     * @param field Field value, templated to support vector fields and scalar fields
+     * @return Magnitude of the field value
+     */
+    template <typename T> double field_magnitude(const T& field);
+
+    /*
+     * Vector field template specialization of helper function for the field magnitude
+     */
+    template <> inline double field_magnitude<ROOT::Math::XYZVector>(const ROOT::Math::XYZVector& vec) {
+        return std::sqrt(vec.Mag2());
+    }
+
+    /*
+     * Scalar field template specialization of helper function for the field magnitude
+     */
+    template <> inline double field_magnitude<double>(const double& value) { return std::fabs(value); }
+
+    template <typename T, size_t N, FieldType Type> class FieldAccessor;
+
     /**
      * @brief Field instance of a detector
      *
@@ -96,6 +162,8 @@ namespace allpix {
      */
     template <typename T, size_t N = 3> class DetectorField {
         friend class Detector;
+        template <typename, size_t> friend class DetectorField;
+        template <typename, size_t, FieldType> friend class FieldAccessor;
 
     public:
         /**
@@ -116,6 +184,12 @@ namespace allpix {
          */
         FieldType getType() const { return type_; }
 
+        /**
+         * @brief Return the mapping of the field onto the sensor
+         * @return Mapping of the field, only meaningful for fields defined on a grid
+         */
+        FieldMapping getMapping() const { return mapping_; }
+
         /**
          * @brief Get the field value in the sensor at a position provided in local coordinates
          * @param local_pos Position in the local frame
@@ -124,6 +198,42 @@ namespace allpix {
          */
         T get(const ROOT::Math::XYZPoint& local_pos, const bool extrapolate_z = false) const;
 
+        /**
+         * @brief Prefetch the field values stored for a position provided in local coordinates into the cache
+         * @param local_pos Position in the local frame, typically the predicted position of a future lookup
+         *
+         * Only fields defined on a grid are prefetched, the call has no effect for all other fields. The position is
+         * extrapolated along z and the cell containing it is requested from memory without waiting for the values, such
+         * that a later lookup close to this position does not stall on the memory access.
+         */
+        void prefetch(const ROOT::Math::XYZPoint& local_pos) const;
+
+        /**
+         * @brief Call a function with an accessor to this field, specialized for the type of the field
+         * @param function Function called with the \ref FieldAccessor as argument
+         * @return Return value of the called function
+         *
+         * The type of the field is resolved once for the call, such that the function can query the field in a hot loop
+         * without checking the field type for every lookup. Constant and linear fields are evaluated without calling the
+         * field function, fields of all other types are looked up via \ref get.
+         */
+        template <typename F> decltype(auto) visit(F&& function) const;
+
+        /**
+         * @brief Derive a field on the grid of this field from its values at the grid points
+         * @param function Function returning the value of the derived field from the value of this field and the position of
+         * a grid point in local coordinates
+         * @param reference Center of the pixel the grid points are placed at for fields mapped onto pixels
+         * @return Field on the same grid with identical mapping, interpolation and thickness domain
+         * @throws std::logic_error If this field is not defined on a grid
+         *
+         * The grid points are placed at the centers of the grid cells. For fields mapped onto a fraction of the pixel, they
+         * are placed on the side of the reference which is covered without flipping the field. Refined cells of this field
+         * are not taken into account, and the derived values are stored in double precision.
+         */
+        template <typename U, size_t M, typename F>
+        DetectorField<U, M> derive(F&& function, const ROOT::Math::XYPoint& reference) const;
+
         /**
          * @brief Get the value of the field at a position provided in local coordinates with respect to the reference
          * @param local_pos Position in the local frame
@@ -135,6 +245,18 @@ namespace allpix {
                         const ROOT::Math::XYPoint& reference,
                         const bool extrapolate_z = false) const;
 
+        /**
+         * @brief Get the value of the field at a position provided in local coordinates with respect to several references
+         * @param local_pos Position in the local frame
+         * @param references Reference positions to calculate the field for, x and y coordinate only
+         * @param values Value(s) of the field assigned to the respective reference pixel at the queried point
+         * @param extrapolate_z Extrapolate the field along z when outside the defined region
+         */
+        void getRelativeTo(const ROOT::Math::XYZPoint& local_pos,
+                           const std::vector<ROOT::Math::XYPoint>& references,
+                           std::vector<T>& values,
+                           const bool extrapolate_z = false) const;
+
         /**
          * @brief Set the field in the detector using a grid
          * @param field Flat array of the field
@@ -144,14 +266,53 @@ namespace allpix {
          * @param scales Scaling factors for the field size, given in fractions of the field size in x and y
          * @param offset Offset of the field from the pixel center, given in fractions of the field size in x and y
          * @param thickness_domain Domain in local coordinates in the thickness direction where the field holds
+         * @param precision Precision with which the field values are stored
+         * @param interpolation Interpolation of the field values between the grid points
+         * @param refinement Optional refined cells of the grid, stored in double precision independent of the precision
+         * @param layout Memory layout with which the field values are stored
+         * @return Summary of the memory saved and the deviation introduced by the storage precision
          */
-        void setGrid(std::shared_ptr<std::vector<double>> field,
-                     std::array<size_t, 3> bins,
-                     std::array<double, 3> size,
-                     FieldMapping mapping,
-                     std::array<double, 2> scales,
-                     std::array<double, 2> offset,
-                     std::pair<double, double> thickness_domain);
+        FieldStorageSummary setGrid(std::shared_ptr<std::vector<double>> field,
+                                    std::array<size_t, 3> bins,
+                                    std::array<double, 3> size,
+                                    FieldMapping mapping,
+                                    std::array<double, 2> scales,
+                                    std::array<double, 2> offset,
+                                    std::pair<double, double> thickness_domain,
+                                    FieldPrecision precision = FieldPrecision::DOUBLE,
+                                    FieldInterpolation interpolation = FieldInterpolation::NEAREST,
+                                    std::shared_ptr<const FieldRefinement> refinement = nullptr,
+                                    FieldLayout layout = FieldLayout::ROW_MAJOR);
+        /**
+         * @brief Set the field in the detector using a grid which is not owned by a vector, e.g. memory-mapped from a file
+         * @param field Pointer to the first value of the flat array of the field, keeping its storage alive
+         * @param bins The bins of the flat field array
+         * @param size Physical extent of the field
+         * @param mapping Specification of the mapping of the field onto the pixel plane
+         * @param scales Scaling factors for the field size, given in fractions of the field size in x and y
+         * @param offset Offset of the field from the pixel center, given in fractions of the field size in x and y
+         * @param thickness_domain Domain in local coordinates in the thickness direction where the field holds
+         * @param precision Precision with which the field values are stored
+         * @param interpolation Interpolation of the field values between the grid points
+         * @param refinement Optional refined cells of the grid, stored in double precision independent of the precision
+         * @param layout Memory layout with which the field values are stored
+         * @return Summary of the memory saved and the deviation introduced by the storage precision
+         * @warning The flat array needs to hold the number of values given by the bins for all N components
+         *
+         * For reduced precision or the bricked layout, the field values are converted into a separate array owned by this
+         * field and the original array is released.
+         */
+        FieldStorageSummary setGrid(std::shared_ptr<const double> field,
+                                    std::array<size_t, 3> bins,
+                                    std::array<double, 3> size,
+                                    FieldMapping mapping,
+                                    std::array<double, 2> scales,
+                                    std::array<double, 2> offset,
+                                    std::pair<double, double> thickness_domain,
+                                    FieldPrecision precision = FieldPrecision::DOUBLE,
+                                    FieldInterpolation interpolation = FieldInterpolation::NEAREST,
+                                    std::shared_ptr<const FieldRefinement> refinement = nullptr,
+                                    FieldLayout layout = FieldLayout::ROW_MAJOR);
         /**
          * @brief Set the field in the detector using a function
          * @param function Function used to calculate the field
@@ -167,7 +328,94 @@ namespace allpix {
          * @brief Set the detector model this field is used for
          * @param model The detector model
          */
-        void set_model(const std::shared_ptr<DetectorModel>& model) { model_ = model; }
+        void set_model(const std::shared_ptr<DetectorModel>& model) {
+            model_ = model;
+            geometry_ = (model_ != nullptr ? model_->getGeometry() : DetectorModel::Geometry());
+        }
+
+        /**
+         * @brief Check if a position is within the pixel matrix, resolved inline for rectangular pixel models
+         * @param pos Position in local coordinates
+         * @return True if the position is within the matrix, false otherwise
+         */
+        bool is_within_matrix(const ROOT::Math::XYZPoint& pos) const {
+            return (geometry_.kind == DetectorModel::Geometry::Kind::RECTANGULAR ? geometry_.isWithinMatrix(pos)
+                                                                                 : model_->isWithinMatrix(pos));
+        }
+
+        /**
+         * @brief Field values converted to a reduced storage precision, shared by all fields using the same original values
+         */
+        struct ConvertedGrid {
+            std::weak_ptr<const double> source; ///< Original field values the conversion was created from
+            size_t size{};                      ///< Number of converted values
+            std::vector<float> values_float;
+            std::vector<std::uint16_t> values_quantized;
+            std::array<double, N> quantization_offset{};
+            std::array<double, N> quantization_scale{};
+            FieldStorageSummary summary;
+        };
+
+        /**
+         * @brief Convert field values to a reduced storage precision, reusing a previous conversion of the same values
+         * @param field Original field values
+         * @param number_of_values Number of values in the field
+         * @param precision Storage precision to convert to, either FLOAT or QUANTIZED
+         * @return Converted field values
+         */
+        static std::shared_ptr<const ConvertedGrid>
+        convert_grid(const std::shared_ptr<const double>& field, size_t number_of_values, FieldPrecision precision);
+
+        /**
+         * @brief Field values reordered into bricks, shared by all fields using the same original values
+         */
+        struct BrickedGrid {
+            std::weak_ptr<const double> source; ///< Original field values the bricks were created from
+            std::array<size_t, 3> bins{};       ///< Number of cells of the original grid
+            std::vector<double> values;
+        };
+
+        /**
+         * @brief Reorder the field values into bricks of the layout configured for this field, reusing a previous
+         * reordering of the same values
+         * @param field Original field values in row-major layout
+         * @return Field values in bricked layout
+         *
+         * Cells of bricks extending beyond the grid are filled with the values of the closest cell of the grid, such that
+         * they do not change the range of the values.
+         */
+        std::shared_ptr<const double> brick_grid(const std::shared_ptr<const double>& field) const;
+
+        /**
+         * @brief Get the index of a grid cell in the flat field array
+         * @param x Index of the cell in x
+         * @param y Index of the cell in y
+         * @param z Index of the cell in z
+         * @return Index of the first value of the cell in units of the number of field components
+         */
+        inline size_t storage_cell(size_t x, size_t y, size_t z) const noexcept {
+            if(layout_ == FieldLayout::ROW_MAJOR) {
+                return (x * bins_[1] + y) * bins_[2] + z;
+            }
+            const auto& shifts = brick_shifts_;
+            const auto brick =
+                ((x >> shifts[0]) * brick_counts_[1] + (y >> shifts[1])) * brick_counts_[2] + (z >> shifts[2]);
+            const auto within = ((((x & brick_masks_[0]) << shifts[1]) | (y & brick_masks_[1])) << shifts[2]) |
+                                (z & brick_masks_[2]);
+            return (brick << (shifts[0] + shifts[1] + shifts[2])) | within;
+        }
+
+        /**
+         * @brief Get the number of cells stored in the flat field array, including the padding of the bricks
+         * @return Number of stored cells
+         */
+        size_t storage_cells() const noexcept {
+            if(layout_ == FieldLayout::ROW_MAJOR) {
+                return bins_[0] * bins_[1] * bins_[2];
+            }
+            const auto& shifts = brick_shifts_;
+            return (brick_counts_[0] * brick_counts_[1] * brick_counts_[2]) << (shifts[0] + shifts[1] + shifts[2]);
+        }
 
         /**
          * @brief Helper function to retrieve the return type from a calculated index of the field data vector
@@ -176,6 +424,77 @@ namespace allpix {
          */
         template <std::size_t... I> inline auto get_impl(size_t offset, std::index_sequence<I...>) const noexcept;
 
+        /**
+         * @brief Helper function to retrieve a single value of the flat field array in the configured storage precision
+         * @param index Global index of the value
+         * @return Field value converted to double precision
+         */
+        inline double get_value(size_t index) const noexcept;
+
+        /**
+         * @brief Helper function to retrieve a single value on the grid of refined cells
+         * @param x Index of the sub-cell in x on the grid of refined cells
+         * @param y Index of the sub-cell in y on the grid of refined cells
+         * @param z Index of the sub-cell in z on the grid of refined cells
+         * @param component Field component to retrieve
+         * @return Value of the refined cell, or of the coarse cell containing it if this cell is not refined
+         */
+        inline double get_refined_value(size_t x, size_t y, size_t z, size_t component) const noexcept;
+
+        /**
+         * @brief Helper function to construct the return type from the interpolated field components
+         * @param values Field components
+         */
+        template <std::size_t... I>
+        static inline T make_field(const std::array<double, N>& values, std::index_sequence<I...>) noexcept {
+            return T{values[I]...};
+        }
+
+        /**
+         * @brief Folding of coordinates relative to a reference along one axis, as defined by the field mapping
+         */
+        struct AxisFolding {
+            double sign_positive{1.}; ///< Sign applied to coordinates above the reference, negative to flip them
+            double sign_negative{1.}; ///< Sign applied to coordinates below the reference, negative to flip them
+            double shift{};           ///< Shift of the folded coordinate in units of the field size
+            double shift_negative{};  ///< Additional shift of coordinates below the reference
+        };
+
+        /**
+         * @brief Resolve the folding of coordinates relative to a reference from the field mapping
+         * @return Folding along the x and y axis
+         */
+        std::array<AxisFolding, 2> compute_folding() const noexcept;
+
+        /**
+         * @brief Fold a coordinate relative to the reference onto the field, using the folding resolved with the grid
+         * @param coordinate Coordinate relative to the reference
+         * @param axis Axis of the coordinate, 0 for x and 1 for y
+         * @param flip Set to true if the coordinate has been flipped and the field component along this axis needs to be
+         * inverted
+         * @return Folded coordinate in units of the field size
+         */
+        inline double fold_coordinate(double coordinate, size_t axis, bool& flip) const noexcept {
+            const auto& folding = folding_[axis];
+            const auto sign = (coordinate > 0 ? folding.sign_positive : (coordinate < 0 ? folding.sign_negative : 1.));
+            flip = (sign < 0);
+            return sign * coordinate * normalization_[axis] + folding.shift +
+                   (coordinate < 0 ? folding.shift_negative : 0.);
+        }
+
+        /**
+         * @brief Calculate the interpolation stencil along one axis of the field grid
+         * @param position Position along the axis in units of grid cells
+         * @param bins Number of grid cells along the axis
+         * @param indices Indices of the grid cells contributing to the interpolation, clamped to the grid
+         * @param weights Interpolation weights of the respective grid cells
+         * @return Number of grid cells in the stencil
+         */
+        unsigned int get_stencil(double position,
+                                 size_t bins,
+                                 std::array<size_t, 4>& indices,
+                                 std::array<double, 4>& weights) const noexcept;
+
         /**
          * @brief Helper function to calculate the field index based on the distance from its center and to return the values
          * @param x Distance in local-coordinate x from the center of the field to obtain the values for
@@ -186,6 +505,26 @@ namespace allpix {
          */
         T get_field_from_grid(const double x, const double y, const double z, const bool extrapolate_z) const noexcept;
 
+        /**
+         * @brief Helper function to prefetch the grid cell containing a position into the cache
+         * @param x Position along x in units of the field size
+         * @param y Position along y in units of the field size
+         * @param z Position in local-coordinate z, within the thickness domain
+         */
+        void prefetch_from_grid(const double x, const double y, const double z) const noexcept;
+
+        /**
+         * @brief Get the grid values local to the NUMA node of the calling thread
+         * @param values Grid values in the storage precision
+         * @return Replica of the values on the node of the thread if the grid is replicated, the given values otherwise
+         */
+        template <typename V> const V* grid_values(const std::shared_ptr<const V>& values) const noexcept {
+            if(node_replicas_.empty()) {
+                return values.get();
+            }
+            return static_cast<const V*>(node_replicas_[NUMA::getThreadSlot()].get());
+        }
+
         /**
          * @brief Fast floor-to-int implementation without overflow protection as std::floor
          * @param x Double-precision floating point value
@@ -200,16 +539,22 @@ namespace allpix {
          * Field properties
          * * bins of the field map (bins in x, y, z)
          * * Mapping of the field onto the pixel cell
+         * * Interpolation between the grid points
          * * Scale of the field in x and y direction, defaults to one full pixel cell
+         * * Folding of coordinates relative to a reference pixel, resolved from the mapping when setting the grid
          */
         std::array<size_t, 3> bins_{};
         FieldMapping mapping_{FieldMapping::PIXEL_FULL};
+        FieldInterpolation interpolation_{FieldInterpolation::NEAREST};
         std::array<double, 2> normalization_{{1., 1.}};
         std::array<double, 2> offset_{{0., 0.}};
+        std::array<AxisFolding, 2> folding_{};
+        // Factor applied to the cell position in x and y before flooring it to the index, zero for axes with a single bin
+        std::array<double, 2> index_scales_{{1., 1.}};
 
         /**
          * Field definition
-         * The field is either specified through a field grid, which is stored in a flat vector, or as field function
+         * The field is either specified through a field grid, which is stored in a flat array, or as field function
          * returning the value at each position given in local coordinates. The field is valid within the thickness domain
          * specified, the configured type is stored to allow additional checks in the modules requesting the field.
          *
@@ -218,16 +563,80 @@ namespace allpix {
          * component in the flat field vector can be calculated as:
          *
          *   field_i(x, y, z) =  x * Y_SIZE* Z_SIZE * N + y * Z_SIZE * + z * N + i
+         *
+         * Depending on the storage precision, only one of the flat arrays is set. Quantized values of the i-th component are
+         * converted back via quantization_offset_[i] + quantization_scale_[i] * value.
+         *
+         * In the bricked layout, the grid is divided into bricks of up to 4x4x4 cells, which are stored consecutively in the
+         * row-major order of the bricks, with the cells within a brick in row-major order. Axes with a single bin are not
+         * divided. The position of a cell in the flat array is resolved via storage_cell(), while the refinement is always
+         * indexed in row-major order of the cells.
+         *
+         * Cells of the grid can optionally be refined into bricks of sub-cells, which are used instead of the value of the
+         * coarse cell. Interpolation within a refined cell is performed on the grid of sub-cells, where unrefined neighbors
+         * contribute with the value of their coarse cell.
          */
-        std::shared_ptr<std::vector<double>> field_;
+        FieldPrecision precision_{FieldPrecision::DOUBLE};
+        std::shared_ptr<const double> field_;
+        std::shared_ptr<const float> field_float_;
+        std::shared_ptr<const std::uint16_t> field_quantized_;
+        // Copies of the grid values in storage precision per NUMA node slot, only set if the workers are pinned to more than
+        // one node and the grid is larger than the threshold
+        std::vector<std::shared_ptr<const void>> node_replicas_;
+        static constexpr size_t replication_threshold_{size_t(1) << 20};
+        std::array<double, N> quantization_offset_{};
+        std::array<double, N> quantization_scale_{};
+        std::shared_ptr<const FieldRefinement> refinement_;
+        std::array<size_t, 3> refinement_factors_{{1, 1, 1}};
+        size_t refinement_brick_size_{};
+        FieldLayout layout_{FieldLayout::ROW_MAJOR};
+        std::array<size_t, 3> brick_shifts_{};
+        std::array<size_t, 3> brick_masks_{};
+        std::array<size_t, 3> brick_counts_{};
         std::pair<double, double> thickness_domain_{};
         FieldType type_{FieldType::NONE};
         FieldFunction<T> function_;
 
+        /*
+         * Values cached from the field function: the value of constant fields, and the closed form offset + slope * z of
+         * linear fields if the function has been verified to be linear across the thickness domain
+         */
+        T constant_value_{};
+        T linear_offset_{};
+        T linear_slope_{};
+        bool linear_closed_form_{};
+
         /*
          * Relevant parameters from the detector model for this field
          */
         std::shared_ptr<DetectorModel> model_;
+        DetectorModel::Geometry geometry_;
+    };
+
+    /**
+     * @brief Accessor to a detector field with the type of the field resolved at compile time
+     *
+     * Accessors are obtained via \ref DetectorField::visit and return the same values as \ref DetectorField::get. The
+     * accessor only holds a reference to the field and must not outlive it.
+     */
+    template <typename T, size_t N, FieldType Type> class FieldAccessor {
+    public:
+        /**
+         * @brief Construct the accessor
+         * @param field Field to access, needs to be of the given type unless the generic lookup is used
+         */
+        explicit FieldAccessor(const DetectorField<T, N>& field) : field_(field) {}
+
+        /**
+         * @brief Get the field value in the sensor at a position provided in local coordinates
+         * @param local_pos Position in the local frame
+         * @param extrapolate_z Extrapolate the field along z when outside the defined region
+         * @return Value(s) of the field at the queried point
+         */
+        T operator()(const ROOT::Math::XYZPoint& local_pos, const bool extrapolate_z = false) const;
+
+    private:
+        const DetectorField<T, N>& field_;
     };
 } // namespace allpix
 
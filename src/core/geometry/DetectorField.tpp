@@ -24,7 +24,7 @@ namespace allpix {
         }
 
         // Return empty field if outside the matrix
-        if(!model_->isWithinMatrix(pos)) {
+        if(!is_within_matrix(pos)) {
             return {};
         }
 
@@ -35,8 +35,11 @@ namespace allpix {
         }
 
         if(type_ == FieldType::CONSTANT) {
-            // Constant field - return value:
-            return function_({});
+            // Constant field - return cached value:
+            return constant_value_;
+        } else if(type_ == FieldType::LINEAR && linear_closed_form_) {
+            // Linear field - calculate value from cached coefficients:
+            return linear_offset_ + linear_slope_ * z;
         } else if(type_ == FieldType::LINEAR || type_ == FieldType::CUSTOM1D) {
             // Linear field or custom field function with z dependency only - calculate value from configured function:
             return function_(ROOT::Math::XYZPoint(0, 0, z));
@@ -45,8 +48,13 @@ namespace allpix {
             // For per-pixel fields, resort to getRelativeTo with current pixel as reference:
             if(mapping_ != FieldMapping::SENSOR) {
                 // Calculate center of current pixel from index as reference point:
-                auto [px, py] = model_->getPixelIndex(pos);
-                auto ref = static_cast<ROOT::Math::XYPoint>(model_->getPixelCenter(px, py));
+                ROOT::Math::XYPoint ref;
+                if(geometry_.kind == DetectorModel::Geometry::Kind::RECTANGULAR) {
+                    ref = geometry_.getPixelCenter(pos);
+                } else {
+                    auto [px, py] = model_->getPixelIndex(pos);
+                    ref = static_cast<ROOT::Math::XYPoint>(model_->getPixelCenter(px, py));
+                }
 
                 // Get field relative to pixel center:
                 return getRelativeTo(pos, ref, extrapolate_z);
@@ -56,7 +64,7 @@ namespace allpix {
             auto x = pos.x() + offset_[0];
             auto y = pos.y() + offset_[1];
 
-            auto pitch = model_->getPixelSize();
+            const auto& pitch = model_->getPixelSize();
 
             // Compute corresponding field replica coordinates:
             // WARNING This relies on the origin of the local coordinate system
@@ -86,6 +94,44 @@ namespace allpix {
         }
     }
 
+    /**
+     * The grid coordinates are resolved as in DetectorField::get, using the replica of the field for sensor-wide mappings
+     * and the folding relative to the pixel center for all other mappings.
+     */
+    template <typename T, size_t N> void DetectorField<T, N>::prefetch(const ROOT::Math::XYZPoint& pos) const {
+        if(type_ != FieldType::GRID || !is_within_matrix(pos)) {
+            return;
+        }
+        auto z = std::clamp(pos.z(), thickness_domain_.first, thickness_domain_.second);
+
+        if(mapping_ != FieldMapping::SENSOR) {
+            ROOT::Math::XYPoint ref;
+            if(geometry_.kind == DetectorModel::Geometry::Kind::RECTANGULAR) {
+                ref = geometry_.getPixelCenter(pos);
+            } else {
+                auto [px, py] = model_->getPixelIndex(pos);
+                ref = static_cast<ROOT::Math::XYPoint>(model_->getPixelCenter(px, py));
+            }
+
+            bool flip_x = false, flip_y = false;
+            auto px = fold_coordinate(pos.x() - ref.x() + offset_[0], 0, flip_x);
+            auto py = fold_coordinate(pos.y() - ref.y() + offset_[1], 1, flip_y);
+            prefetch_from_grid(px, py, z);
+            return;
+        }
+
+        auto x = pos.x() + offset_[0];
+        auto y = pos.y() + offset_[1];
+        const auto& pitch = model_->getPixelSize();
+        auto replica_x = int_floor((x + 0.5 * pitch.x()) * normalization_[0]);
+        auto replica_y = int_floor((y + 0.5 * pitch.y()) * normalization_[1]);
+        x -= (replica_x + 0.5) / normalization_[0] - 0.5 * pitch.x();
+        y -= (replica_y + 0.5) / normalization_[1] - 0.5 * pitch.y();
+        x *= ((replica_x % 2) == 1 ? -1 : 1);
+        y *= ((replica_y % 2) == 1 ? -1 : 1);
+        prefetch_from_grid(x * normalization_[0] + 0.5, y * normalization_[1] + 0.5, z);
+    }
+
     /**
      * Get a value from the field assigned to a specific pixel. This means, we cannot wrap around at the pixel edges and
      * start using the field of the adjacent pixel, but need to calculate the total distance from the lookup point in local
@@ -111,44 +157,10 @@ namespace allpix {
 
         T ret_val;
         if(type_ == FieldType::GRID) {
-
-            // Do we need to flip the position vector components?
-            auto flip_x =
-                (x > 0 && (mapping_ == FieldMapping::PIXEL_QUADRANT_II || mapping_ == FieldMapping::PIXEL_QUADRANT_III ||
-                           mapping_ == FieldMapping::PIXEL_HALF_LEFT)) ||
-                (x < 0 && (mapping_ == FieldMapping::PIXEL_QUADRANT_I || mapping_ == FieldMapping::PIXEL_QUADRANT_IV ||
-                           mapping_ == FieldMapping::PIXEL_HALF_RIGHT));
-            auto flip_y =
-                (y > 0 && (mapping_ == FieldMapping::PIXEL_QUADRANT_III || mapping_ == FieldMapping::PIXEL_QUADRANT_IV ||
-                           mapping_ == FieldMapping::PIXEL_HALF_BOTTOM)) ||
-                (y < 0 && (mapping_ == FieldMapping::PIXEL_QUADRANT_I || mapping_ == FieldMapping::PIXEL_QUADRANT_II ||
-                           mapping_ == FieldMapping::PIXEL_HALF_TOP));
-
             // Fold onto available field scale in the range [0 , 1] - flip coordinates if necessary
-            auto px = (flip_x ? -1.0 : 1.0) * x * normalization_[0];
-            auto py = (flip_y ? -1.0 : 1.0) * y * normalization_[1];
-
-            if(mapping_ == FieldMapping::PIXEL_QUADRANT_II || mapping_ == FieldMapping::PIXEL_QUADRANT_III ||
-               mapping_ == FieldMapping::PIXEL_HALF_LEFT) {
-                px += 1.0;
-            } else if(mapping_ == FieldMapping::PIXEL_FULL || mapping_ == FieldMapping::PIXEL_HALF_TOP ||
-                      mapping_ == FieldMapping::PIXEL_HALF_BOTTOM) {
-                px += 0.5;
-            }
-
-            if(mapping_ == FieldMapping::PIXEL_QUADRANT_III || mapping_ == FieldMapping::PIXEL_QUADRANT_IV ||
-               mapping_ == FieldMapping::PIXEL_HALF_BOTTOM) {
-                py += 1.0;
-            } else if(mapping_ == FieldMapping::PIXEL_FULL || mapping_ == FieldMapping::PIXEL_HALF_LEFT ||
-                      mapping_ == FieldMapping::PIXEL_HALF_RIGHT) {
-                py += 0.5;
-            }
-
-            // Shuffle quadrants for inverted maps
-            if(mapping_ == FieldMapping::PIXEL_FULL_INVERSE) {
-                px += (x >= 0 ? 0. : 1.0);
-                py += (y >= 0 ? 0. : 1.0);
-            }
+            bool flip_x = false, flip_y = false;
+            auto px = fold_coordinate(x, 0, flip_x);
+            auto py = fold_coordinate(y, 1, flip_y);
 
             ret_val = get_field_from_grid(px, py, z, extrapolate_z);
 
@@ -162,6 +174,88 @@ namespace allpix {
         return ret_val;
     }
 
+    /**
+     * The thickness domain is checked once for all reference positions. The values are identical to calling getRelativeTo
+     * for each reference individually.
+     */
+    template <typename T, size_t N>
+    void DetectorField<T, N>::getRelativeTo(const ROOT::Math::XYZPoint& pos,
+                                            const std::vector<ROOT::Math::XYPoint>& references,
+                                            std::vector<T>& values,
+                                            const bool extrapolate_z) const {
+        values.assign(references.size(), T());
+        if(type_ == FieldType::NONE) {
+            return;
+        }
+
+        // Check if we need to extrapolate along the z axis or if is inside thickness domain:
+        auto z = (extrapolate_z ? std::clamp(pos.z(), thickness_domain_.first, thickness_domain_.second) : pos.z());
+        if(z < thickness_domain_.first || thickness_domain_.second < z) {
+            return;
+        }
+
+        for(size_t i = 0; i < references.size(); ++i) {
+            // Calculate the coordinates relative to the reference point:
+            auto x = pos.x() - references[i].x() + offset_[0];
+            auto y = pos.y() - references[i].y() + offset_[1];
+
+            if(type_ == FieldType::GRID) {
+                bool flip_x = false, flip_y = false;
+                auto px = fold_coordinate(x, 0, flip_x);
+                auto py = fold_coordinate(y, 1, flip_y);
+
+                values[i] = get_field_from_grid(px, py, z, extrapolate_z);
+                flip_vector_components(values[i], flip_x, flip_y);
+            } else {
+                values[i] = function_(ROOT::Math::XYZPoint(x, y, z));
+            }
+        }
+    }
+
+    template <typename T, size_t N>
+    std::array<typename DetectorField<T, N>::AxisFolding, 2> DetectorField<T, N>::compute_folding() const noexcept {
+        std::array<AxisFolding, 2> folding{};
+
+        // Flip the coordinates on the side of the reference not covered by the field
+        auto sign = [](bool flip) { return flip ? -1. : 1.; };
+        folding[0].sign_positive = sign(mapping_ == FieldMapping::PIXEL_QUADRANT_II ||
+                                        mapping_ == FieldMapping::PIXEL_QUADRANT_III ||
+                                        mapping_ == FieldMapping::PIXEL_HALF_LEFT);
+        folding[0].sign_negative = sign(mapping_ == FieldMapping::PIXEL_QUADRANT_I ||
+                                        mapping_ == FieldMapping::PIXEL_QUADRANT_IV ||
+                                        mapping_ == FieldMapping::PIXEL_HALF_RIGHT);
+        folding[1].sign_positive = sign(mapping_ == FieldMapping::PIXEL_QUADRANT_III ||
+                                        mapping_ == FieldMapping::PIXEL_QUADRANT_IV ||
+                                        mapping_ == FieldMapping::PIXEL_HALF_BOTTOM);
+        folding[1].sign_negative = sign(mapping_ == FieldMapping::PIXEL_QUADRANT_I ||
+                                        mapping_ == FieldMapping::PIXEL_QUADRANT_II ||
+                                        mapping_ == FieldMapping::PIXEL_HALF_TOP);
+
+        // Shift the origin of the field to the reference
+        if(mapping_ == FieldMapping::PIXEL_QUADRANT_II || mapping_ == FieldMapping::PIXEL_QUADRANT_III ||
+           mapping_ == FieldMapping::PIXEL_HALF_LEFT) {
+            folding[0].shift = 1.0;
+        } else if(mapping_ == FieldMapping::PIXEL_FULL || mapping_ == FieldMapping::PIXEL_HALF_TOP ||
+                  mapping_ == FieldMapping::PIXEL_HALF_BOTTOM) {
+            folding[0].shift = 0.5;
+        }
+
+        if(mapping_ == FieldMapping::PIXEL_QUADRANT_III || mapping_ == FieldMapping::PIXEL_QUADRANT_IV ||
+           mapping_ == FieldMapping::PIXEL_HALF_BOTTOM) {
+            folding[1].shift = 1.0;
+        } else if(mapping_ == FieldMapping::PIXEL_FULL || mapping_ == FieldMapping::PIXEL_HALF_LEFT ||
+                  mapping_ == FieldMapping::PIXEL_HALF_RIGHT) {
+            folding[1].shift = 0.5;
+        }
+
+        // Shuffle quadrants for inverted maps
+        if(mapping_ == FieldMapping::PIXEL_FULL_INVERSE) {
+            folding[0].shift_negative = 1.0;
+            folding[1].shift_negative = 1.0;
+        }
+        return folding;
+    }
+
     // Maps the field indices onto the range of -d/2 < x < d/2, where d is the scale of the field in coordinate x.
     // This means, {x,y,z} = (0,0,0) is in the center of the field.
     template <typename T, size_t N>
@@ -171,32 +265,181 @@ namespace allpix {
                                                const bool extrapolate_z) const noexcept {
 
         // Compute indices
-        // If the number of bins in x or y is 1, the field is assumed to be 2-dimensional and the respective index
-        // is forced to zero. This circumvents that the field size in the respective dimension would otherwise be zero
-        auto x_ind = (bins_[0] == 1 ? 0 : int_floor(x * static_cast<double>(bins_[0])));
-        if(x_ind < 0 || x_ind >= static_cast<int>(bins_[0])) {
+        // If the number of bins in x or y is 1, the field is assumed to be 2-dimensional and the respective index is forced
+        // to zero by a vanishing index scale. This circumvents that the field size in the respective dimension would
+        // otherwise be zero
+        const auto x_position = x * static_cast<double>(bins_[0]);
+        const auto y_position = y * static_cast<double>(bins_[1]);
+        const auto z_position = static_cast<double>(bins_[2]) * (z - thickness_domain_.first) /
+                                (thickness_domain_.second - thickness_domain_.first);
+        const auto x_ind = int_floor(x_position * index_scales_[0]);
+        const auto y_ind = int_floor(y_position * index_scales_[1]);
+        auto z_ind = int_floor(z_position);
+        // Clamp to field indices if required - we do this here (again) to not be affected by floating-point rounding:
+        z_ind = (extrapolate_z ? std::clamp(z_ind, 0, static_cast<int>(bins_[2]) - 1) : z_ind);
+
+        // Positions outside the grid return an empty field. Negative indices wrap around to large unsigned values, such
+        // that all bounds are checked at once without branching on the individual axes
+        const bool inside = (static_cast<size_t>(x_ind) < bins_[0]) & (static_cast<size_t>(y_ind) < bins_[1]) &
+                            (static_cast<size_t>(z_ind) < bins_[2]);
+        if(!inside) {
             return {};
         }
 
-        auto y_ind = (bins_[1] == 1 ? 0 : int_floor(y * static_cast<double>(bins_[1])));
-        if(y_ind < 0 || y_ind >= static_cast<int>(bins_[1])) {
-            return {};
+        // Check whether the cell is refined, positions are then resolved on the grid of sub-cells
+        const auto cell = (static_cast<size_t>(x_ind) * bins_[1] + static_cast<size_t>(y_ind)) * bins_[2] +
+                          static_cast<size_t>(z_ind);
+        const auto refined = (refinement_ != nullptr && refinement_->bricks[cell] != FieldRefinement::unrefined);
+
+        if(interpolation_ == FieldInterpolation::NEAREST) {
+            if(refined) {
+                // Index of the sub-cell, kept within the coarse cell against floating-point rounding
+                auto sub_index = [](double position, int index, size_t factor) {
+                    const auto first = static_cast<int>(factor) * index;
+                    const auto last = first + static_cast<int>(factor) - 1;
+                    return static_cast<size_t>(std::clamp(int_floor(position * static_cast<double>(factor)), first, last));
+                };
+                const auto x_sub = sub_index(x_position, x_ind, refinement_factors_[0]);
+                const auto y_sub = sub_index(y_position, y_ind, refinement_factors_[1]);
+                const auto z_sub = sub_index(z_position, z_ind, refinement_factors_[2]);
+
+                std::array<double, N> values{};
+                for(size_t c = 0; c < N; ++c) {
+                    values[c] = get_refined_value(x_sub, y_sub, z_sub, c);
+                }
+                return make_field(values, std::make_index_sequence<N>{});
+            }
+
+            // Compute total index
+            const auto tot_ind =
+                storage_cell(static_cast<size_t>(x_ind), static_cast<size_t>(y_ind), static_cast<size_t>(z_ind)) * N;
+
+            // Retrieve field
+            return get_impl(tot_ind, std::make_index_sequence<N>{});
         }
 
-        auto z_ind = int_floor(static_cast<double>(bins_[2]) * (z - thickness_domain_.first) /
-                               (thickness_domain_.second - thickness_domain_.first));
-        // Clamp to field indices if required - we do this here (again) to not be affected by floating-point rounding:
-        z_ind = (extrapolate_z ? std::clamp(z_ind, 0, static_cast<int>(bins_[2]) - 1) : z_ind);
-        if(z_ind < 0 || z_ind >= static_cast<int>(bins_[2])) {
-            return {};
+        // Calculate the interpolation stencils once per axis, the weights of each grid cell are their products
+        std::array<size_t, 4> x_indices{}, y_indices{}, z_indices{};
+        std::array<double, 4> x_weights{}, y_weights{}, z_weights{};
+        std::array<double, N> values{};
+        if(refined) {
+            const auto& factors = refinement_factors_;
+            auto x_size =
+                get_stencil(x_position * static_cast<double>(factors[0]), bins_[0] * factors[0], x_indices, x_weights);
+            auto y_size =
+                get_stencil(y_position * static_cast<double>(factors[1]), bins_[1] * factors[1], y_indices, y_weights);
+            auto z_size =
+                get_stencil(z_position * static_cast<double>(factors[2]), bins_[2] * factors[2], z_indices, z_weights);
+
+            // Accumulate all field components of the stencil sub-cells
+            for(unsigned int i = 0; i < x_size; ++i) {
+                for(unsigned int j = 0; j < y_size; ++j) {
+                    const auto xy_weight = x_weights[i] * y_weights[j];
+                    for(unsigned int k = 0; k < z_size; ++k) {
+                        const auto weight = xy_weight * z_weights[k];
+                        for(size_t c = 0; c < N; ++c) {
+                            values[c] += weight * get_refined_value(x_indices[i], y_indices[j], z_indices[k], c);
+                        }
+                    }
+                }
+            }
+            return make_field(values, std::make_index_sequence<N>{});
+        }
+
+        auto x_size = get_stencil(x_position, bins_[0], x_indices, x_weights);
+        auto y_size = get_stencil(y_position, bins_[1], y_indices, y_weights);
+        auto z_size = get_stencil(z_position, bins_[2], z_indices, z_weights);
+
+        // Accumulate all field components of the stencil cells
+        for(unsigned int i = 0; i < x_size; ++i) {
+            for(unsigned int j = 0; j < y_size; ++j) {
+                const auto xy_weight = x_weights[i] * y_weights[j];
+                for(unsigned int k = 0; k < z_size; ++k) {
+                    const auto weight = xy_weight * z_weights[k];
+                    const auto tot_ind = storage_cell(x_indices[i], y_indices[j], z_indices[k]) * N;
+                    for(size_t c = 0; c < N; ++c) {
+                        values[c] += weight * get_value(tot_ind + c);
+                    }
+                }
+            }
+        }
+        return make_field(values, std::make_index_sequence<N>{});
+    }
+
+    /**
+     * Only the cell containing the position is requested, which also covers its neighbours along z for the row-major layout
+     * and most of the interpolation stencil for the bricked layout. Refined cells are not prefetched. Without compiler
+     * support for prefetch hints, this function has no effect.
+     */
+    template <typename T, size_t N>
+    void DetectorField<T, N>::prefetch_from_grid(const double x, const double y, const double z) const noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+        const auto z_position = static_cast<double>(bins_[2]) * (z - thickness_domain_.first) /
+                                (thickness_domain_.second - thickness_domain_.first);
+        const auto x_ind = int_floor(x * static_cast<double>(bins_[0]) * index_scales_[0]);
+        const auto y_ind = int_floor(y * static_cast<double>(bins_[1]) * index_scales_[1]);
+        const auto z_ind = std::clamp(int_floor(z_position), 0, static_cast<int>(bins_[2]) - 1);
+        if(static_cast<size_t>(x_ind) >= bins_[0] || static_cast<size_t>(y_ind) >= bins_[1]) {
+            return;
         }
 
-        // Compute total index
-        size_t tot_ind = static_cast<size_t>(x_ind) * bins_[1] * bins_[2] * N + static_cast<size_t>(y_ind) * bins_[2] * N +
-                         static_cast<size_t>(z_ind) * N;
+        const auto offset =
+            storage_cell(static_cast<size_t>(x_ind), static_cast<size_t>(y_ind), static_cast<size_t>(z_ind)) * N;
+        if(precision_ == FieldPrecision::FLOAT) {
+            __builtin_prefetch(grid_values(field_float_) + offset);
+        } else if(precision_ == FieldPrecision::QUANTIZED) {
+            __builtin_prefetch(grid_values(field_quantized_) + offset);
+        } else {
+            __builtin_prefetch(grid_values(field_) + offset);
+        }
+#else
+        (void)x;
+        (void)y;
+        (void)z;
+#endif
+    }
+
+    /**
+     * The field values are located at the centers of the grid cells, the position is therefore shifted by half a cell. Cells
+     * outside the grid are replaced by the closest cell at the border. Axes with a single bin are not interpolated.
+     */
+    template <typename T, size_t N>
+    unsigned int DetectorField<T, N>::get_stencil(double position,
+                                                  size_t bins,
+                                                  std::array<size_t, 4>& indices,
+                                                  std::array<double, 4>& weights) const noexcept {
+        if(bins == 1) {
+            indices[0] = 0;
+            weights[0] = 1.;
+            return 1;
+        }
+
+        auto cell = position - 0.5;
+        auto first = int_floor(cell);
+        auto t = cell - first;
+        auto clamp_index = [bins](int index) {
+            return static_cast<size_t>(std::clamp(index, 0, static_cast<int>(bins) - 1));
+        };
+
+        if(interpolation_ == FieldInterpolation::TRICUBIC) {
+            // Catmull-Rom spline weights of the four cells around the position
+            auto t2 = t * t;
+            auto t3 = t2 * t;
+            weights = {{0.5 * (-t3 + 2. * t2 - t),
+                        0.5 * (3. * t3 - 5. * t2 + 2.),
+                        0.5 * (-3. * t3 + 4. * t2 + t),
+                        0.5 * (t3 - t2)}};
+            for(int i = 0; i < 4; ++i) {
+                indices[static_cast<size_t>(i)] = clamp_index(first - 1 + i);
+            }
+            return 4;
+        }
 
-        // Retrieve field
-        return get_impl(tot_ind, std::make_index_sequence<N>{});
+        weights[0] = 1. - t;
+        weights[1] = t;
+        indices[0] = clamp_index(first);
+        indices[1] = clamp_index(first + 1);
+        return 2;
     }
 
     /**
@@ -207,25 +450,95 @@ namespace allpix {
     template <typename T, size_t N>
     template <std::size_t... I>
     auto DetectorField<T, N>::get_impl(size_t offset, std::index_sequence<I...>) const noexcept {
-        return T{(*field_)[offset + I]...};
+        if(precision_ == FieldPrecision::FLOAT) {
+            const auto* values = grid_values(field_float_);
+            return T{static_cast<double>(values[offset + I])...};
+        }
+        if(precision_ == FieldPrecision::QUANTIZED) {
+            const auto* values = grid_values(field_quantized_);
+            return T{(quantization_offset_[I] + quantization_scale_[I] * values[offset + I])...};
+        }
+        const auto* values = grid_values(field_);
+        return T{values[offset + I]...};
+    }
+
+    template <typename T, size_t N> double DetectorField<T, N>::get_value(size_t index) const noexcept {
+        if(precision_ == FieldPrecision::FLOAT) {
+            return static_cast<double>(grid_values(field_float_)[index]);
+        }
+        if(precision_ == FieldPrecision::QUANTIZED) {
+            return quantization_offset_[index % N] + quantization_scale_[index % N] * grid_values(field_quantized_)[index];
+        }
+        return grid_values(field_)[index];
+    }
+
+    template <typename T, size_t N>
+    double DetectorField<T, N>::get_refined_value(size_t x, size_t y, size_t z, size_t component) const noexcept {
+        const auto& factors = refinement_factors_;
+        const auto cell = ((x / factors[0]) * bins_[1] + (y / factors[1])) * bins_[2] + (z / factors[2]);
+        const auto brick = refinement_->bricks[cell];
+        if(brick == FieldRefinement::unrefined) {
+            return get_value(storage_cell(x / factors[0], y / factors[1], z / factors[2]) * N + component);
+        }
+        const auto sub_cell = ((x % factors[0]) * factors[1] + (y % factors[1])) * factors[2] + (z % factors[2]);
+        return refinement_->values[brick * refinement_brick_size_ + sub_cell * N + component];
     }
 
     /**
      * @throws std::invalid_argument If the field bins are incorrect or the thickness domain is outside the sensor
      */
     template <typename T, size_t N>
-    void DetectorField<T, N>::setGrid(std::shared_ptr<std::vector<double>> field, // NOLINT
-                                      std::array<size_t, 3> bins,
-                                      std::array<double, 3> size,
-                                      FieldMapping mapping,
-                                      std::array<double, 2> scales,
-                                      std::array<double, 2> offset,
-                                      std::pair<double, double> thickness_domain) {
+    FieldStorageSummary DetectorField<T, N>::setGrid(std::shared_ptr<std::vector<double>> field, // NOLINT
+                                                     std::array<size_t, 3> bins,
+                                                     std::array<double, 3> size,
+                                                     FieldMapping mapping,
+                                                     std::array<double, 2> scales,
+                                                     std::array<double, 2> offset,
+                                                     std::pair<double, double> thickness_domain,
+                                                     FieldPrecision precision,
+                                                     FieldInterpolation interpolation,
+                                                     std::shared_ptr<const FieldRefinement> refinement,
+                                                     FieldLayout layout) {
+        if(bins[0] * bins[1] * bins[2] * N != field->size()) {
+            throw std::invalid_argument("field does not match the given dimensions");
+        }
+
+        // Share ownership of the vector while pointing to its data
+        auto* values = field->data();
+        return setGrid(std::shared_ptr<const double>(std::move(field), values),
+                       bins,
+                       size,
+                       mapping,
+                       scales,
+                       offset,
+                       std::move(thickness_domain),
+                       precision,
+                       interpolation,
+                       std::move(refinement),
+                       layout);
+    }
+
+    /**
+     * @throws std::invalid_argument If the field is empty, the refinement does not match the field bins or the thickness
+     * domain is outside the sensor
+     */
+    template <typename T, size_t N>
+    FieldStorageSummary DetectorField<T, N>::setGrid(std::shared_ptr<const double> field, // NOLINT
+                                                     std::array<size_t, 3> bins,
+                                                     std::array<double, 3> size,
+                                                     FieldMapping mapping,
+                                                     std::array<double, 2> scales,
+                                                     std::array<double, 2> offset,
+                                                     std::pair<double, double> thickness_domain,
+                                                     FieldPrecision precision,
+                                                     FieldInterpolation interpolation,
+                                                     std::shared_ptr<const FieldRefinement> refinement,
+                                                     FieldLayout layout) {
         if(model_ == nullptr) {
             throw std::invalid_argument("field not initialized with detector model parameters");
         }
-        if(bins[0] * bins[1] * bins[2] * N != field->size()) {
-            throw std::invalid_argument("field does not match the given dimensions");
+        if(field == nullptr) {
+            throw std::invalid_argument("field does not contain any values");
         }
         if(thickness_domain.first + 1e-9 < model_->getSensorCenter().z() - model_->getSensorSize().z() / 2.0 ||
            model_->getSensorCenter().z() + model_->getSensorSize().z() / 2.0 < thickness_domain.second - 1e-9) {
@@ -234,10 +547,51 @@ namespace allpix {
         if(thickness_domain.first >= thickness_domain.second) {
             throw std::invalid_argument("end of thickness domain is before begin");
         }
+        if(refinement != nullptr && !refinement->isConsistent(bins, N)) {
+            throw std::invalid_argument("field refinement does not match the given dimensions");
+        }
 
-        field_ = std::move(field);
+        // Divide all axes with more than one bin into bricks of up to four cells
         bins_ = bins;
+        layout_ = layout;
+        index_scales_ = {{(bins[0] == 1 ? 0. : 1.), (bins[1] == 1 ? 0. : 1.)}};
+        for(size_t axis = 0; axis < 3; ++axis) {
+            brick_shifts_[axis] = (bins[axis] > 2 ? 2 : (bins[axis] > 1 ? 1 : 0));
+            brick_masks_[axis] = (size_t(1) << brick_shifts_[axis]) - 1;
+            brick_counts_[axis] = ((bins[axis] - 1) >> brick_shifts_[axis]) + 1;
+        }
+        if(layout_ == FieldLayout::BRICKED) {
+            field = brick_grid(field);
+        }
+
+        // Convert the field values to the requested storage precision
+        FieldStorageSummary summary;
+        const auto number_of_values = storage_cells() * N;
+        field_float_.reset();
+        field_quantized_.reset();
+        if(precision != FieldPrecision::DOUBLE) {
+            auto grid = convert_grid(field, number_of_values, precision);
+            summary = grid->summary;
+            quantization_offset_ = grid->quantization_offset;
+            quantization_scale_ = grid->quantization_scale;
+            if(precision == FieldPrecision::FLOAT) {
+                field_float_ = std::shared_ptr<const float>(grid, grid->values_float.data());
+            } else {
+                field_quantized_ = std::shared_ptr<const std::uint16_t>(grid, grid->values_quantized.data());
+            }
+            field.reset();
+        }
+
+        precision_ = precision;
+        field_ = std::move(field);
         mapping_ = mapping;
+        folding_ = compute_folding();
+        interpolation_ = interpolation;
+
+        // Sub-cells of refined cells, stored in double precision
+        refinement_ = std::move(refinement);
+        refinement_factors_ = (refinement_ != nullptr ? refinement_->getFactors(bins) : std::array<size_t, 3>{{1, 1, 1}});
+        refinement_brick_size_ = refinement_factors_[0] * refinement_factors_[1] * refinement_factors_[2] * N;
 
         // Calculate normalization of field from field size and scale factors:
         normalization_[0] = 1.0 / scales[0] / size[0];
@@ -247,6 +601,148 @@ namespace allpix {
 
         thickness_domain_ = std::move(thickness_domain);
         type_ = FieldType::GRID;
+
+        // Replicate large grids to the NUMA nodes of the pinned workers to avoid remote memory accesses
+        node_replicas_.clear();
+        const void* grid = field_.get();
+        auto grid_bytes = number_of_values * sizeof(double);
+        if(precision_ == FieldPrecision::FLOAT) {
+            grid = field_float_.get();
+            grid_bytes = number_of_values * sizeof(float);
+        } else if(precision_ == FieldPrecision::QUANTIZED) {
+            grid = field_quantized_.get();
+            grid_bytes = number_of_values * sizeof(std::uint16_t);
+        }
+        if(NUMA::getNodeCount() > 1 && grid_bytes >= replication_threshold_) {
+            for(size_t slot = 0; slot < NUMA::getNodeCount(); ++slot) {
+                node_replicas_.push_back(NUMA::replicate(grid, grid_bytes, slot));
+            }
+        }
+        return summary;
+    }
+
+    /**
+     * Identical grids, e.g. the same field map read for several detectors, are reordered only once. Reorderings are looked
+     * up by the owner of the original values and kept as long as any field refers to them. Entries of reorderings no longer
+     * referred to are dropped on every lookup, such that the registry does not grow with fields set repeatedly.
+     */
+    template <typename T, size_t N>
+    std::shared_ptr<const double> DetectorField<T, N>::brick_grid(const std::shared_ptr<const double>& field) const {
+        static std::mutex mutex;
+        static std::map<const double*, std::weak_ptr<const BrickedGrid>> registry;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for(auto it = registry.begin(); it != registry.end();) {
+            if(it->second.expired()) {
+                it = registry.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        auto& entry = registry[field.get()];
+        auto cached = entry.lock();
+        if(cached != nullptr && cached->bins == bins_ && !cached->source.owner_before(field) &&
+           !field.owner_before(cached->source)) {
+            return std::shared_ptr<const double>(cached, cached->values.data());
+        }
+
+        auto grid = std::make_shared<BrickedGrid>();
+        grid->source = field;
+        grid->bins = bins_;
+        grid->values.resize(storage_cells() * N);
+        const auto* values = field.get();
+        for(size_t x = 0; x < brick_counts_[0] << brick_shifts_[0]; ++x) {
+            for(size_t y = 0; y < brick_counts_[1] << brick_shifts_[1]; ++y) {
+                for(size_t z = 0; z < brick_counts_[2] << brick_shifts_[2]; ++z) {
+                    // Cells beyond the grid are padded with the closest cell of the grid
+                    const auto source = ((std::min(x, bins_[0] - 1) * bins_[1] + std::min(y, bins_[1] - 1)) * bins_[2] +
+                                         std::min(z, bins_[2] - 1)) *
+                                        N;
+                    const auto target = storage_cell(x, y, z) * N;
+                    for(size_t c = 0; c < N; ++c) {
+                        grid->values[target + c] = values[source + c];
+                    }
+                }
+            }
+        }
+
+        entry = grid;
+        return std::shared_ptr<const double>(grid, grid->values.data());
+    }
+
+    /**
+     * Identical grids, e.g. the same field map read for several detectors, are converted only once. Conversions are looked
+     * up by the owner of the original values and kept as long as any field refers to them.
+     * Entries of conversions no longer referred to are dropped on every lookup.
+     */
+    template <typename T, size_t N>
+    std::shared_ptr<const typename DetectorField<T, N>::ConvertedGrid> DetectorField<T, N>::convert_grid(
+        const std::shared_ptr<const double>& field, size_t number_of_values, FieldPrecision precision) {
+        static std::mutex mutex;
+        static std::map<std::pair<const double*, FieldPrecision>, std::weak_ptr<const ConvertedGrid>> registry;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for(auto it = registry.begin(); it != registry.end();) {
+            if(it->second.expired()) {
+                it = registry.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        auto& entry = registry[{field.get(), precision}];
+        auto cached = entry.lock();
+        if(cached != nullptr && cached->size == number_of_values && !cached->source.owner_before(field) &&
+           !field.owner_before(cached->source)) {
+            return cached;
+        }
+
+        auto grid = std::make_shared<ConvertedGrid>();
+        grid->source = field;
+        grid->size = number_of_values;
+        const auto* values = field.get();
+        auto& summary = grid->summary;
+        if(precision == FieldPrecision::FLOAT) {
+            auto& data = grid->values_float;
+            data.resize(number_of_values);
+            for(size_t i = 0; i < number_of_values; ++i) {
+                data[i] = static_cast<float>(values[i]);
+                summary.max_deviation = std::max(summary.max_deviation, std::fabs(values[i] - static_cast<double>(data[i])));
+            }
+            summary.memory_saved = number_of_values * (sizeof(double) - sizeof(float));
+        } else {
+            // Determine the range of each field component to map it linearly onto the available integer range
+            auto& quantization_offset = grid->quantization_offset;
+            auto& quantization_scale = grid->quantization_scale;
+            std::array<double, N> minimum{}, maximum{};
+            minimum.fill(std::numeric_limits<double>::max());
+            maximum.fill(std::numeric_limits<double>::lowest());
+            for(size_t i = 0; i < number_of_values; ++i) {
+                minimum[i % N] = std::min(minimum[i % N], values[i]);
+                maximum[i % N] = std::max(maximum[i % N], values[i]);
+            }
+            for(size_t c = 0; c < N; ++c) {
+                quantization_offset[c] = minimum[c];
+                quantization_scale[c] = (maximum[c] - minimum[c]) / std::numeric_limits<std::uint16_t>::max();
+            }
+
+            auto& data = grid->values_quantized;
+            data.resize(number_of_values);
+            for(size_t i = 0; i < number_of_values; ++i) {
+                const auto c = i % N;
+                auto quantized =
+                    (quantization_scale[c] > 0 ? std::lround((values[i] - quantization_offset[c]) / quantization_scale[c])
+                                               : 0L);
+                data[i] = static_cast<std::uint16_t>(
+                    std::clamp(quantized, 0L, static_cast<long>(std::numeric_limits<std::uint16_t>::max())));
+                summary.max_deviation =
+                    std::max(summary.max_deviation,
+                             std::fabs(values[i] - (quantization_offset[c] + quantization_scale[c] * data[i])));
+            }
+            summary.memory_saved = number_of_values * (sizeof(double) - sizeof(std::uint16_t));
+        }
+
+        entry = grid;
+        return grid;
     }
 
     template <typename T, size_t N>
@@ -255,5 +751,146 @@ namespace allpix {
         thickness_domain_ = std::move(thickness_domain);
         function_ = std::move(function);
         type_ = type;
+
+        // Cache the value of constant fields
+        constant_value_ = (type_ == FieldType::CONSTANT ? function_({}) : T{});
+
+        // Use a closed form for linear fields if the function is linear within the thickness domain, i.e. it is not clamped
+        linear_closed_form_ = false;
+        if(type_ == FieldType::LINEAR && thickness_domain_.second > thickness_domain_.first) {
+            const auto [z_min, z_max] = thickness_domain_;
+            const auto value_min = function_(ROOT::Math::XYZPoint(0, 0, z_min));
+            const auto value_max = function_(ROOT::Math::XYZPoint(0, 0, z_max));
+            linear_slope_ = (value_max - value_min) / (z_max - z_min);
+            linear_offset_ = value_min - linear_slope_ * z_min;
+
+            const auto tolerance = 1e-9 * std::max(field_magnitude(value_min), field_magnitude(value_max));
+            const int samples = 16;
+            linear_closed_form_ = true;
+            for(int i = 1; i < samples && linear_closed_form_; ++i) {
+                const auto z = z_min + (z_max - z_min) * i / samples;
+                const T deviation = function_(ROOT::Math::XYZPoint(0, 0, z)) - (linear_offset_ + linear_slope_ * z);
+                linear_closed_form_ = (field_magnitude(deviation) <= tolerance);
+            }
+        }
+    }
+
+    template <typename T, size_t N> template <typename F> decltype(auto) DetectorField<T, N>::visit(F&& function) const {
+        switch(type_) {
+        case FieldType::CONSTANT:
+            return function(FieldAccessor<T, N, FieldType::CONSTANT>(*this));
+        case FieldType::LINEAR:
+            return function(FieldAccessor<T, N, FieldType::LINEAR>(*this));
+        case FieldType::CUSTOM1D:
+            return function(FieldAccessor<T, N, FieldType::CUSTOM1D>(*this));
+        default:
+            return function(FieldAccessor<T, N, FieldType::CUSTOM>(*this));
+        }
+    }
+
+    /**
+     * Positions along x and y are recovered by inverting the folding of coordinates onto the field. Where both sides of the
+     * reference are covered without flipping, the position closest to the reference is used.
+     */
+    template <typename T, size_t N>
+    template <typename U, size_t M, typename F>
+    DetectorField<U, M> DetectorField<T, N>::derive(F&& function, const ROOT::Math::XYPoint& reference) const {
+        if(type_ != FieldType::GRID) {
+            throw std::logic_error("field is not defined on a grid");
+        }
+
+        // Local coordinate of the center of a grid cell along the x or y axis
+        auto pitch = model_->getPixelSize();
+        auto position = [&](size_t bin, size_t axis) {
+            auto folded = (static_cast<double>(bin) + 0.5) / static_cast<double>(bins_[axis]);
+            auto pixel_pitch = (axis == 0 ? pitch.x() : pitch.y());
+            if(mapping_ == FieldMapping::SENSOR) {
+                return folded / normalization_[axis] - 0.5 * pixel_pitch - offset_[axis];
+            }
+
+            const auto& folding = folding_[axis];
+            auto coordinate = std::numeric_limits<double>::infinity();
+            auto positive = (folded - folding.shift) / normalization_[axis];
+            if(folding.sign_positive > 0 && positive >= 0) {
+                coordinate = positive;
+            }
+            auto negative = (folded - folding.shift - folding.shift_negative) / normalization_[axis];
+            if(folding.sign_negative > 0 && negative <= 0 && -negative < std::fabs(coordinate)) {
+                coordinate = negative;
+            }
+            return (axis == 0 ? reference.x() : reference.y()) + coordinate - offset_[axis];
+        };
+
+        auto values = std::make_shared<std::vector<double>>();
+        values->reserve(bins_[0] * bins_[1] * bins_[2] * M);
+        for(size_t x = 0; x < bins_[0]; ++x) {
+            for(size_t y = 0; y < bins_[1]; ++y) {
+                for(size_t z = 0; z < bins_[2]; ++z) {
+                    auto depth = thickness_domain_.first + (static_cast<double>(z) + 0.5) /
+                                                               static_cast<double>(bins_[2]) *
+                                                               (thickness_domain_.second - thickness_domain_.first);
+                    auto value = get_impl(storage_cell(x, y, z) * N, std::make_index_sequence<N>{});
+                    U derived = function(value, ROOT::Math::XYZPoint(position(x, 0), position(y, 1), depth));
+                    if constexpr(M == 1) {
+                        values->push_back(derived);
+                    } else {
+                        values->push_back(derived.x());
+                        values->push_back(derived.y());
+                        if constexpr(M == 3) {
+                            values->push_back(derived.z());
+                        }
+                    }
+                }
+            }
+        }
+
+        // Reproduce normalization and offset of this field with unit scales
+        DetectorField<U, M> field;
+        field.set_model(model_);
+        field.setGrid(std::move(values),
+                      bins_,
+                      {1. / normalization_[0], 1. / normalization_[1], thickness_domain_.second - thickness_domain_.first},
+                      mapping_,
+                      {1., 1.},
+                      {offset_[0] * normalization_[0], offset_[1] * normalization_[1]},
+                      thickness_domain_,
+                      FieldPrecision::DOUBLE,
+                      interpolation_,
+                      nullptr,
+                      layout_);
+        return field;
+    }
+
+    /**
+     * Fields depending on z only are evaluated directly, all other fields are looked up via DetectorField::get.
+     */
+    template <typename T, size_t N, FieldType Type>
+    T FieldAccessor<T, N, Type>::operator()(const ROOT::Math::XYZPoint& pos, const bool extrapolate_z) const {
+        if constexpr(Type == FieldType::CONSTANT || Type == FieldType::LINEAR || Type == FieldType::CUSTOM1D) {
+            // Return empty field if outside the matrix
+            if(!field_.is_within_matrix(pos)) {
+                return {};
+            }
+
+            // Check if we need to extrapolate along the z axis or if is inside thickness domain:
+            const auto& domain = field_.thickness_domain_;
+            auto z = (extrapolate_z ? std::clamp(pos.z(), domain.first, domain.second) : pos.z());
+            if(z < domain.first || domain.second < z) {
+                return {};
+            }
+
+            if constexpr(Type == FieldType::CONSTANT) {
+                return field_.constant_value_;
+            } else {
+                if constexpr(Type == FieldType::LINEAR) {
+                    if(field_.linear_closed_form_) {
+                        return field_.linear_offset_ + field_.linear_slope_ * z;
+                    }
+                }
+                return field_.function_(ROOT::Math::XYZPoint(0, 0, z));
+            }
+        } else {
+            return field_.get(pos, extrapolate_z);
+        }
     }
 } // namespace allpix
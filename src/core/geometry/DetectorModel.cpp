@@ -17,6 +17,11 @@
 #include "core/geometry/RadialStripDetectorModel.hpp"
 #include "tools/liang_barsky.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <typeinfo>
+
 #include <Math/Translation3D.h>
 
 using namespace allpix;
@@ -63,6 +68,7 @@ std::shared_ptr<DetectorModel> DetectorModel::factory(const std::string& name, c
 
     // Validate the detector model - we call this here because validation might depend on derived class properties:
     model->validate();
+    model->build_geometry();
 
     auto unused_keys = config.getUnusedKeys();
     if(!unused_keys.empty()) {
@@ -176,6 +182,100 @@ void DetectorModel::addImplant(const Implant::Type& type,
     ROOT::Math::XYZVector full_offset(offset.x(), offset.y(), offset_z);
     implants_.push_back(
         Implant(type, shape, std::move(size), std::move(full_offset), ROOT::Math::RotationZ(orientation), config));
+    build_implant_lookup();
+}
+
+void DetectorModel::build_implant_lookup() {
+    // Bounding boxes of the implants relative to the pixel center, covering any orientation and shape
+    std::vector<std::array<double, 4>> boxes;
+    implant_range_z_ = {std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest()};
+    implant_grid_min_ = {std::numeric_limits<double>::max(), std::numeric_limits<double>::max()};
+    implant_grid_max_ = {std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest()};
+    for(const auto& implant : implants_) {
+        auto angle = implant.orientation_.Angle();
+        auto size = implant.size_;
+        auto half_x = (std::fabs(std::cos(angle)) * size.x() + std::fabs(std::sin(angle)) * size.y()) / 2;
+        auto half_y = (std::fabs(std::sin(angle)) * size.x() + std::fabs(std::cos(angle)) * size.y()) / 2;
+        // Widen slightly to be robust against rounding in the rotation of positions
+        auto margin = 1e-9 * (half_x + half_y);
+        std::array<double, 4> box{{implant.offset_.x() - half_x - margin,
+                                   implant.offset_.x() + half_x + margin,
+                                   implant.offset_.y() - half_y - margin,
+                                   implant.offset_.y() + half_y + margin}};
+        boxes.push_back(box);
+
+        implant_range_z_.first = std::min(implant_range_z_.first, implant.offset_.z() - size.z() / 2);
+        implant_range_z_.second = std::max(implant_range_z_.second, implant.offset_.z() + size.z() / 2);
+        implant_grid_min_ = {std::min(implant_grid_min_[0], box[0]), std::min(implant_grid_min_[1], box[2])};
+        implant_grid_max_ = {std::max(implant_grid_max_[0], box[1]), std::max(implant_grid_max_[1], box[3])};
+    }
+
+    // Aim at a few bins per implant and axis
+    auto bins = static_cast<size_t>(std::ceil(2 * std::sqrt(static_cast<double>(implants_.size()))));
+    implant_bins_ = {std::max<size_t>(bins, 1), std::max<size_t>(bins, 1)};
+    for(size_t axis = 0; axis < 2; ++axis) {
+        implant_bin_size_[axis] =
+            (implant_grid_max_[axis] - implant_grid_min_[axis]) / static_cast<double>(implant_bins_[axis]);
+    }
+    auto get_bin = [&](size_t axis, double value) {
+        if(implant_bin_size_[axis] <= 0) {
+            return size_t(0);
+        }
+        auto bin = std::floor((value - implant_grid_min_[axis]) / implant_bin_size_[axis]);
+        return static_cast<size_t>(std::clamp(bin, 0., static_cast<double>(implant_bins_[axis] - 1)));
+    };
+
+    // Count the implants per bin, then fill them in order starting at the offset of every bin
+    implant_bin_offsets_.assign(implant_bins_[0] * implant_bins_[1] + 1, 0);
+    implant_bin_entries_.clear();
+    for(size_t pass = 0; pass < 2; ++pass) {
+        auto fill = implant_bin_offsets_;
+        for(size_t index = 0; index < boxes.size(); ++index) {
+            for(auto i = get_bin(0, boxes[index][0]); i <= get_bin(0, boxes[index][1]); ++i) {
+                for(auto j = get_bin(1, boxes[index][2]); j <= get_bin(1, boxes[index][3]); ++j) {
+                    auto bin = i * implant_bins_[1] + j;
+                    if(pass == 0) {
+                        implant_bin_offsets_[bin + 1]++;
+                    } else {
+                        implant_bin_entries_[fill[bin]++] = index;
+                    }
+                }
+            }
+        }
+        if(pass == 0) {
+            for(size_t bin = 1; bin < implant_bin_offsets_.size(); ++bin) {
+                implant_bin_offsets_[bin] += implant_bin_offsets_[bin - 1];
+            }
+            implant_bin_entries_.resize(implant_bin_offsets_.back());
+        }
+    }
+}
+
+/**
+ * The pixel grid and implants are only resolved for plain pixel detector models, since derived models may override the
+ * corresponding methods.
+ */
+void DetectorModel::build_geometry() {
+    auto sensor_center = getSensorCenter();
+    auto sensor_size = getSensorSize();
+    geometry_.sensor_center = {sensor_center.x(), sensor_center.y(), sensor_center.z()};
+    geometry_.sensor_size = {sensor_size.x(), sensor_size.y(), sensor_size.z()};
+
+    if(typeid(*this) != typeid(PixelDetectorModel)) {
+        geometry_.kind = Geometry::Kind::OTHER;
+        return;
+    }
+
+    // Same bounds as in PixelDetectorModel::isWithinMatrix
+    geometry_.kind = Geometry::Kind::RECTANGULAR;
+    geometry_.pitch = {pixel_size_.x(), pixel_size_.y()};
+    geometry_.matrix_min = {-0.5 * pixel_size_.x(), -0.5 * pixel_size_.y()};
+    geometry_.matrix_max = {(number_of_pixels_.x() - 0.5) * pixel_size_.x(),
+                            (number_of_pixels_.y() - 0.5) * pixel_size_.y()};
+    geometry_.implants = !implants_.empty();
+    geometry_.implant_range_z = implant_range_z_;
+    geometry_.implant_min = implant_grid_min_;
+    geometry_.implant_max = implant_grid_max_;
 }
 
 void DetectorModel::validate() {
@@ -320,7 +420,7 @@ std::vector<SupportLayer> DetectorModel::getSupportLayers() const {
     return ret_layers;
 }
 
-std::optional<DetectorModel::Implant> DetectorModel::isWithinImplant(const ROOT::Math::XYZPoint& local_pos) const {
+std::optional<size_t> DetectorModel::findImplant(const ROOT::Math::XYZPoint& local_pos) const {
 
     // Bail out if we have no implants - no need to transform coordinates:
     if(implants_.empty()) {
@@ -330,9 +430,26 @@ std::optional<DetectorModel::Implant> DetectorModel::isWithinImplant(const ROOT:
     auto [xpixel, ypixel] = getPixelIndex(local_pos);
     auto inPixelPos = local_pos - getPixelCenter(xpixel, ypixel);
 
-    for(const auto& implant : implants_) {
-        if(implant.contains(inPixelPos)) {
-            return implant;
+    // Reject positions outside the depth range or the lateral bounding box of all implants
+    if(inPixelPos.z() <= implant_range_z_.first || inPixelPos.z() >= implant_range_z_.second ||
+       inPixelPos.x() < implant_grid_min_[0] || inPixelPos.x() > implant_grid_max_[0] ||
+       inPixelPos.y() < implant_grid_min_[1] || inPixelPos.y() > implant_grid_max_[1]) {
+        return std::nullopt;
+    }
+
+    // Test the implants overlapping with the bin of the position, in the order of their definition
+    auto get_bin = [&](size_t axis, double value) {
+        if(implant_bin_size_[axis] <= 0) {
+            return size_t(0);
+        }
+        auto bin = static_cast<size_t>((value - implant_grid_min_[axis]) / implant_bin_size_[axis]);
+        return std::min(bin, implant_bins_[axis] - 1);
+    };
+    auto bin = get_bin(0, inPixelPos.x()) * implant_bins_[1] + get_bin(1, inPixelPos.y());
+    for(auto entry = implant_bin_offsets_[bin]; entry < implant_bin_offsets_[bin + 1]; ++entry) {
+        auto index = implant_bin_entries_[entry];
+        if(implants_[index].contains(inPixelPos)) {
+            return index;
         }
     }
     return std::nullopt;
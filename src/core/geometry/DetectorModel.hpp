@@ -18,8 +18,11 @@
 #define ALLPIX_DETECTOR_MODEL_H
 
 #include <array>
+#include <cmath>
+#include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <Math/Point2D.h>
 #include <Math/Point3D.h>
@@ -175,6 +178,82 @@ namespace allpix {
             Configuration config_;
         };
 
+        /**
+         * @brief Flat view of the geometry of a model for the use in performance critical loops
+         *
+         * The view is computed once the model has been constructed and validated, and allows for inline arithmetic instead
+         * of repeated virtual calls returning new points and vectors. The sensor members hold for all models, while the
+         * pixel grid and implant members are only filled for models of the kind RECTANGULAR, i.e. plain pixel detector
+         * models with a regular grid of rectangular pixels. For all other models the methods of the model have to be used.
+         */
+        struct Geometry {
+            /**
+             * @brief Kind of the model, indicating which members of the view are valid
+             */
+            enum class Kind {
+                RECTANGULAR, ///< Regular grid of rectangular pixels with the first pixel centered at the origin
+                OTHER,       ///< Any other model, only the sensor members are valid
+            };
+            Kind kind{Kind::OTHER};
+
+            std::array<double, 3> sensor_center{}; ///< Center of the sensor in local coordinates
+            std::array<double, 3> sensor_size{};   ///< Size of the sensor
+
+            std::array<double, 2> pitch{};               ///< Size of a pixel
+            std::array<double, 2> matrix_min{};          ///< Lower edge of the pixel matrix
+            std::array<double, 2> matrix_max{};          ///< Upper edge of the pixel matrix
+            bool implants{};                             ///< If the model defines any implants
+            std::pair<double, double> implant_range_z{}; ///< Depth range of all implants
+            std::array<double, 2> implant_min{};         ///< Lower corner of the implant bounding box
+            std::array<double, 2> implant_max{};         ///< Upper corner of the implant bounding box
+
+            /**
+             * @brief Check if a position is within the sensor, equivalent to \ref DetectorModel::isWithinSensor
+             * @param pos Position in local coordinates
+             * @return True if the position is within the sensor, false otherwise
+             */
+            bool isWithinSensor(const ROOT::Math::XYZPoint& pos) const {
+                return (2 * std::fabs(pos.z() - sensor_center[2]) <= sensor_size[2]) &&
+                       (2 * std::fabs(pos.y() - sensor_center[1]) <= sensor_size[1]) &&
+                       (2 * std::fabs(pos.x() - sensor_center[0]) <= sensor_size[0]);
+            }
+
+            /**
+             * @brief Check if a position is within the pixel matrix, only valid for RECTANGULAR models
+             * @param pos Position in local coordinates
+             * @return True if the position is within the matrix, false otherwise
+             */
+            bool isWithinMatrix(const ROOT::Math::XYZPoint& pos) const {
+                return !(pos.x() < matrix_min[0] || pos.x() > matrix_max[0] || pos.y() < matrix_min[1] ||
+                         pos.y() > matrix_max[1]);
+            }
+
+            /**
+             * @brief Get the center of the pixel a position is contained in, only valid for RECTANGULAR models
+             * @param pos Position in local coordinates
+             * @return Center of the pixel in local coordinates
+             */
+            ROOT::Math::XYPoint getPixelCenter(const ROOT::Math::XYZPoint& pos) const {
+                return {pitch[0] * static_cast<int>(std::lround(pos.x() / pitch[0])),
+                        pitch[1] * static_cast<int>(std::lround(pos.y() / pitch[1]))};
+            }
+
+            /**
+             * @brief Check if a position might be located in an implant, only valid for RECTANGULAR models
+             * @param pos Position in local coordinates
+             * @return False if the position is outside the bounding box of all implants, true otherwise
+             */
+            bool mayContainImplant(const ROOT::Math::XYZPoint& pos) const {
+                if(!implants || pos.z() <= implant_range_z.first || pos.z() >= implant_range_z.second) {
+                    return false;
+                }
+                auto center = getPixelCenter(pos);
+                auto x = pos.x() - center.x();
+                auto y = pos.y() - center.y();
+                return !(x < implant_min[0] || x > implant_max[0] || y < implant_min[1] || y > implant_max[1]);
+            }
+        };
+
         /**
          * @brief Constructs the base detector model
          * @param type Name of the model type
@@ -206,6 +285,12 @@ namespace allpix {
 
         const std::shared_ptr<DetectorAssembly> getAssembly() const { return assembly_; }
 
+        /**
+         * @brief Get the flat view of the geometry of this model
+         * @return Geometry view computed after the construction of the model
+         */
+        const Geometry& getGeometry() const { return geometry_; }
+
         /**
          * @brief Get local coordinate of the position and rotation center in global frame
          * @note It can be a bit counter intuitive that this is not usually the origin, neither the geometric center of the
@@ -381,8 +466,24 @@ namespace allpix {
          *
          * @param local_pos Position in local coordinates of the detector model
          * @return Either the implant in which the position is located, or false
+         *
+         * @note This returns a copy of the implant, use \ref findImplant in performance-critical code
+         */
+        std::optional<Implant> isWithinImplant(const ROOT::Math::XYZPoint& local_pos) const {
+            auto index = findImplant(local_pos);
+            return (index.has_value() ? std::optional<Implant>(implants_[index.value()]) : std::nullopt);
+        }
+
+        /**
+         * @brief Find the implant a local position is located in, see \ref isWithinImplant
+         *
+         * Positions outside the depth range of all implants are rejected immediately, otherwise only the implants
+         * overlapping with the position in a precomputed grid of the pixel unit cell are tested.
+         *
+         * @param local_pos Position in local coordinates of the detector model
+         * @return Index of the implant in \ref getImplants, or std::nullopt if the position is not within any implant
          */
-        virtual std::optional<Implant> isWithinImplant(const ROOT::Math::XYZPoint& local_pos) const;
+        virtual std::optional<size_t> findImplant(const ROOT::Math::XYZPoint& local_pos) const;
 
         /**
          * @brief Calculate entry point of step into impant volume from one point outside the implant (before step) and one
@@ -448,6 +549,24 @@ namespace allpix {
          */
         virtual std::pair<int, int> getPixelIndex(const ROOT::Math::XYZPoint& local_pos) const = 0;
 
+        /**
+         * @brief Return X,Y indices of the pixels corresponding to a set of local positions in a sensor
+         * @param positions Positions in local coordinates of the detector model
+         * @param indices Pixel indices of the positions, resized to the number of positions
+         *
+         * @note No checks are performed on whether these indices represent an existing pixel or are within the pixel matrix.
+         *
+         * @note This method is virtual and can be implemented by detector models for faster calculations
+         */
+        virtual void getPixelIndices(const std::vector<ROOT::Math::XYZPoint>& positions,
+                                     std::vector<Pixel::Index>& indices) const {
+            indices.resize(positions.size());
+            for(size_t i = 0; i < positions.size(); ++i) {
+                auto [index_x, index_y] = getPixelIndex(positions[i]);
+                indices[i] = {index_x, index_y};
+            }
+        }
+
         /**
          * @brief Return a set containing all pixels neighboring the given one with a configurable maximum distance
          * @param idx       Index of the pixel in question
@@ -460,6 +579,21 @@ namespace allpix {
          */
         virtual std::set<Pixel::Index> getNeighbors(const Pixel::Index& idx, const size_t distance) const = 0;
 
+        /**
+         * @brief Append all pixels neighboring the given one with a configurable maximum distance to a buffer
+         * @param idx       Index of the pixel in question
+         * @param distance  Distance for pixels to be considered neighbors
+         * @param neighbors Buffer the neighboring pixel indices are appended to, including the initial pixel
+         *
+         * @note The appended indices do not contain duplicates, but may repeat indices already present in the buffer. This
+         * allows to reuse the buffer without allocating a new set for every call.
+         */
+        virtual void
+        getNeighbors(const Pixel::Index& idx, const size_t distance, std::vector<Pixel::Index>& neighbors) const {
+            auto set = getNeighbors(idx, distance);
+            neighbors.insert(neighbors.end(), set.begin(), set.end());
+        }
+
         /**
          * @brief Check if two pixel indices are neighbors to each other
          * @param  seed    Initial pixel index
@@ -525,6 +659,7 @@ namespace allpix {
         std::shared_ptr<DetectorAssembly> assembly_;
         std::vector<Implant> implants_;
         std::vector<SupportLayer> support_layers_;
+        Geometry geometry_;
 
     private:
         ///@{
@@ -554,6 +689,26 @@ namespace allpix {
                         double orientation,
                         const Configuration& config);
 
+        /**
+         * @brief Sort the implants into the lookup grid of the pixel unit cell
+         */
+        void build_implant_lookup();
+
+        /**
+         * @brief Compute the flat view of the geometry from the final model
+         */
+        void build_geometry();
+
+        // Lookup of the implants: depth range and grid of the x-y bounding box of all implants relative to the pixel center,
+        // with the implant indices of the bin i found between implant_bin_offsets_[i] and implant_bin_offsets_[i + 1]
+        std::pair<double, double> implant_range_z_{};
+        std::array<double, 2> implant_grid_min_{};
+        std::array<double, 2> implant_grid_max_{};
+        std::array<double, 2> implant_bin_size_{};
+        std::array<size_t, 2> implant_bins_{};
+        std::vector<size_t> implant_bin_offsets_;
+        std::vector<size_t> implant_bin_entries_;
+
         /**
          * @brief Add a new layer of support
          * @param size Size of the support in the x,y-plane
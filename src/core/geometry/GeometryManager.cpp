@@ -349,8 +349,18 @@ void GeometryManager::load_models() {
     std::vector<std::string> paths = getModelsPath();
 
     LOG(TRACE) << "Reading model files";
-    // Add all the paths to the reader
+    // Add all the paths to the reader, stopping as soon as all required models are known
+    auto all_models_known = [this]() {
+        return std::all_of(nonresolved_models_.begin(), nonresolved_models_.end(), [this](const auto& model) {
+            return hasModel(model.first);
+        });
+    };
     for(auto& path : paths) {
+        if(all_models_known()) {
+            LOG(TRACE) << "All required models found, skipping remaining model paths";
+            break;
+        }
+
         // Check if file or directory
         if(std::filesystem::is_directory(path)) {
             for(const auto& entry : std::filesystem::directory_iterator(path)) {
@@ -358,8 +368,8 @@ void GeometryManager::load_models() {
                     continue;
                 }
 
-                // Accept only with correct model suffix
-                auto sub_path = std::filesystem::canonical(entry);
+                // Accept only with correct model suffix, only links need to be resolved to obtain the model name
+                auto sub_path = entry.is_symlink() ? std::filesystem::canonical(entry) : entry.path();
                 std::string suffix(ALLPIX_MODEL_SUFFIX);
                 if(sub_path.extension() != suffix) {
                     continue;
@@ -35,6 +35,7 @@ namespace allpix {
     enum class MagneticFieldType {
         NONE = 0, ///< No magnetic field is simulated
         CONSTANT, ///< Constant magnetic field (mostly for testing)
+        GRID,     ///< Magnetic field map supplied through a regularized grid
         CUSTOM,   ///< Custom magnetic field function
     };
 
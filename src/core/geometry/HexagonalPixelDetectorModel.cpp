@@ -68,6 +68,19 @@ std::pair<int, int> HexagonalPixelDetectorModel::getPixelIndex(const ROOT::Math:
     return round_to_nearest_hex(q, r);
 }
 
+void HexagonalPixelDetectorModel::getPixelIndices(const std::vector<ROOT::Math::XYZPoint>& positions,
+                                                  std::vector<Pixel::Index>& indices) const {
+    // Same calculation as getPixelIndex, with the transformation selected once
+    const auto& transform = (pixel_type_ == Pixel::Type::HEXAGON_POINTY ? inv_transform_pointy_ : inv_transform_flat_);
+    indices.resize(positions.size());
+    for(size_t i = 0; i < positions.size(); ++i) {
+        auto x = positions[i].x() / pixel_size_.x() * 2;
+        auto y = positions[i].y() / pixel_size_.y() * 2;
+        auto [q, r] = round_to_nearest_hex(transform[0] * x + transform[1] * y, transform[2] * x + transform[3] * y);
+        indices[i] = {q, r};
+    }
+}
+
 /*
  * In an axial-coordinates hexagon grid, simply checking for x and y to be between 0 and number_of_pixels will create
  * a rhombus which does lack the upper-left pixels and which has surplus pixels at the upper-right corner. We
@@ -106,16 +119,21 @@ ROOT::Math::XYZVector HexagonalPixelDetectorModel::getMatrixSize() const {
 }
 
 std::set<Pixel::Index> HexagonalPixelDetectorModel::getNeighbors(const Pixel::Index& idx, const size_t distance) const {
-    std::set<Pixel::Index> neighbors;
+    std::vector<Pixel::Index> neighbors;
+    getNeighbors(idx, distance, neighbors);
+    return {neighbors.begin(), neighbors.end()};
+}
 
+void HexagonalPixelDetectorModel::getNeighbors(const Pixel::Index& idx,
+                                               const size_t distance,
+                                               std::vector<Pixel::Index>& neighbors) const {
     for(int x = idx.x() - static_cast<int>(distance); x <= idx.x() + static_cast<int>(distance); x++) {
         for(int y = idx.y() - static_cast<int>(distance); y <= idx.y() + static_cast<int>(distance); y++) {
             if(hex_distance(idx.x(), idx.y(), x, y) <= distance && isWithinMatrix(x, y)) {
-                neighbors.insert({x, y});
+                neighbors.emplace_back(x, y);
             }
         }
     }
-    return neighbors;
 }
 
 bool HexagonalPixelDetectorModel::areNeighbors(const Pixel::Index& seed,
@@ -69,6 +69,14 @@ namespace allpix {
          */
         std::pair<int, int> getPixelIndex(const ROOT::Math::XYZPoint& position) const override;
 
+        /**
+         * @brief Return X,Y indices of the pixels corresponding to a set of local positions in a sensor
+         * @param positions Positions in local coordinates of the detector model
+         * @param indices Pixel indices of the positions, resized to the number of positions
+         */
+        void getPixelIndices(const std::vector<ROOT::Math::XYZPoint>& positions,
+                             std::vector<Pixel::Index>& indices) const override;
+
         /**
          * @brief Returns if a set of pixel coordinates is within the grid of pixels defined for the device
          * @param x X- (or column-) coordinate to be checked
@@ -100,6 +108,16 @@ namespace allpix {
          */
         std::set<Pixel::Index> getNeighbors(const Pixel::Index& idx, const size_t distance) const override;
 
+        /**
+         * @brief Append all pixels neighboring the given one with a configurable maximum distance to a buffer
+         * @param idx       Index of the pixel in question
+         * @param distance  Distance for pixels to be considered neighbors
+         * @param neighbors Buffer the neighboring pixel indices are appended to, including the initial pixel
+         */
+        void getNeighbors(const Pixel::Index& idx,
+                          const size_t distance,
+                          std::vector<Pixel::Index>& neighbors) const override;
+
         /**
          * @brief Check if two pixel indices are neighbors to each other
          * @param  seed    Initial pixel index
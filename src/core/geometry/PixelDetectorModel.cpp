@@ -114,19 +114,35 @@ std::pair<int, int> PixelDetectorModel::getPixelIndex(const ROOT::Math::XYZPoint
     return {pixel_x, pixel_y};
 }
 
+void PixelDetectorModel::getPixelIndices(const std::vector<ROOT::Math::XYZPoint>& positions,
+                                         std::vector<Pixel::Index>& indices) const {
+    // Same calculation as getPixelIndex, without a virtual call per position
+    const auto pitch_x = pixel_size_.x();
+    const auto pitch_y = pixel_size_.y();
+    indices.resize(positions.size());
+    for(size_t i = 0; i < positions.size(); ++i) {
+        indices[i] = {static_cast<int>(std::lround(positions[i].x() / pitch_x)),
+                      static_cast<int>(std::lround(positions[i].y() / pitch_y))};
+    }
+}
+
 std::set<Pixel::Index> PixelDetectorModel::getNeighbors(const Pixel::Index& idx, const size_t distance) const {
-    std::set<Pixel::Index> neighbors;
+    std::vector<Pixel::Index> neighbors;
+    getNeighbors(idx, distance, neighbors);
+    return {neighbors.begin(), neighbors.end()};
+}
 
+void PixelDetectorModel::getNeighbors(const Pixel::Index& idx,
+                                      const size_t distance,
+                                      std::vector<Pixel::Index>& neighbors) const {
     for(int x = idx.x() - static_cast<int>(distance); x <= idx.x() + static_cast<int>(distance); x++) {
         for(int y = idx.y() - static_cast<int>(distance); y <= idx.y() + static_cast<int>(distance); y++) {
             if(!isWithinMatrix(x, y)) {
                 continue;
             }
-            neighbors.insert({x, y});
+            neighbors.emplace_back(x, y);
         }
     }
-
-    return neighbors;
 }
 
 bool PixelDetectorModel::areNeighbors(const Pixel::Index& seed, const Pixel::Index& entrant, const size_t distance) const {
@@ -11,16 +11,24 @@
 
 #include "RadialStripDetectorModel.hpp"
 
+#include <algorithm>
+#include <atomic>
+
 #include <Math/RotationZ.h>
 #include <Math/Transform3D.h>
 
 using namespace allpix;
 
+namespace {
+    // Identifiers of the models for the cache of the last polar conversion, addresses of models can be reused
+    std::atomic<uint64_t> next_polar_cache_id{1};
+} // namespace
+
 RadialStripDetectorModel::RadialStripDetectorModel(std::string type,
                                                    const std::shared_ptr<DetectorAssembly>& assembly,
                                                    const ConfigReader& reader,
                                                    const Configuration& config)
-    : DetectorModel(std::move(type), assembly, reader, config) {
+    : DetectorModel(std::move(type), assembly, reader, config), polar_cache_id_(next_polar_cache_id++) {
 
     if(std::dynamic_pointer_cast<MonolithicAssembly>(assembly) == nullptr) {
         throw InvalidCombinationError(config, {"type", "geometry"}, "this geometry only supports assembly type monolithic");
@@ -95,39 +103,37 @@ RadialStripDetectorModel::RadialStripDetectorModel(std::string type,
 }
 
 bool RadialStripDetectorModel::isWithinSensor(const ROOT::Math::XYZPoint& local_pos) const {
-    // Convert local position to polar coordinates
-    auto polar_pos = getPositionPolar(local_pos);
-    // Check if radial coordinate is outside the sensor
-    if(2 * std::fabs(local_pos.z() - getSensorCenter().z()) > getSensorSize().z() ||
-       (polar_pos.r() > row_radius_.back() || polar_pos.r() < row_radius_.front())) {
+    // Check if the position is outside the sensor thickness before converting it
+    if(2 * std::fabs(local_pos.z() - getSensorCenter().z()) > getSensorSize().z()) {
         return false;
     }
-    // Find which strip row the position belongs to
-    for(unsigned int row = 0; row < getNPixels().y(); row++) {
-        if(polar_pos.r() > row_radius_.at(row) && polar_pos.r() <= row_radius_.at(row + 1)) {
-            // Check if the angular coordinate is within that strip row
-            return (std::fabs(polar_pos.phi() + stereo_angle_) <= angular_pitch_.at(row) * number_of_strips_.at(row) / 2);
-        }
+    // Find which strip row the position belongs to, if radial coordinate is inside the sensor
+    auto polar_pos = getPositionPolar(local_pos);
+    auto row = find_row(polar_pos.r());
+    if(row < 0) {
+        return false;
     }
-    return false;
+    // Check if the angular coordinate is within that strip row
+    return (std::fabs(polar_pos.phi() + stereo_angle_) <= row_angle_[static_cast<size_t>(row)] / 2);
 }
 
 bool RadialStripDetectorModel::isOnSensorBoundary(const ROOT::Math::XYZPoint& local_pos) const {
-    // Convert local position to polar coordinates
-    auto polar_pos = getPositionPolar(local_pos);
+    // Check if the position is on the sensor surface
+    if(2 * std::fabs(local_pos.z()) == getSensorSize().z()) {
+        return true;
+    }
     // Check if radial coordinate is on the sensor edge
-    if(2 * std::fabs(local_pos.z()) == getSensorSize().z() ||
-       (polar_pos.r() == row_radius_.back() || polar_pos.r() == row_radius_.front())) {
+    auto polar_pos = getPositionPolar(local_pos);
+    if(polar_pos.r() == row_radius_.back() || polar_pos.r() == row_radius_.front()) {
         return true;
     }
     // Find which strip row the position belongs to
-    for(unsigned int row = 0; row < getNPixels().y(); row++) {
-        if(polar_pos.r() > row_radius_.at(row) && polar_pos.r() <= row_radius_.at(row + 1)) {
-            // Check if the angular coordinate is on the edge of strip row
-            return (std::fabs(polar_pos.phi() + stereo_angle_) == angular_pitch_.at(row) * number_of_strips_.at(row) / 2);
-        }
+    auto row = find_row(polar_pos.r());
+    if(row < 0) {
+        return false;
     }
-    return false;
+    // Check if the angular coordinate is on the edge of strip row
+    return (std::fabs(polar_pos.phi() + stereo_angle_) == row_angle_[static_cast<size_t>(row)] / 2);
 }
 
 bool RadialStripDetectorModel::isWithinMatrix(const Pixel::Index& strip_index) const {
@@ -136,6 +142,16 @@ bool RadialStripDetectorModel::isWithinMatrix(const Pixel::Index& strip_index) c
 }
 
 ROOT::Math::Polar2DPoint RadialStripDetectorModel::getPositionPolar(const ROOT::Math::XYZPoint& local_pos) const {
+    // The checks of a single propagation step convert the same position several times, the last conversion of every
+    // thread is kept. The polar coordinates do not depend on the z coordinate.
+    thread_local uint64_t last_id = 0;
+    thread_local double last_x = 0;
+    thread_local double last_y = 0;
+    thread_local ROOT::Math::Polar2DPoint last_polar;
+    if(last_id == polar_cache_id_ && last_x == local_pos.x() && last_y == local_pos.y()) {
+        return last_polar;
+    }
+
     // Calculate the radial component
     auto r = sqrt(local_pos.x() * local_pos.x() + local_pos.y() * local_pos.y());
     // Shift the coordinate origin to the strip focal point
@@ -143,7 +159,11 @@ ROOT::Math::Polar2DPoint RadialStripDetectorModel::getPositionPolar(const ROOT::
     // Calculate the angular component obtained from the corrected position
     auto phi = atan2(focus_pos.x(), focus_pos.y());
 
-    return {r, phi};
+    last_id = polar_cache_id_;
+    last_x = local_pos.x();
+    last_y = local_pos.y();
+    last_polar = {r, phi};
+    return last_polar;
 }
 
 ROOT::Math::XYPoint RadialStripDetectorModel::getPositionCartesian(const ROOT::Math::Polar2DPoint& polar_pos) const {
@@ -178,22 +198,35 @@ ROOT::Math::XYZPoint RadialStripDetectorModel::getPixelCenter(int x, int y) cons
 
 std::pair<int, int> RadialStripDetectorModel::getPixelIndex(const ROOT::Math::XYZPoint& position) const {
     // Convert local position to polar coordinates
-    auto polar_pos = getPositionPolar(position);
-
-    // Get row index
-    int strip_y{};
-    for(unsigned int row = 0; row < getNPixels().y(); row++) {
-        // Find the correct strip row by comparing to inner and outer row radii
-        if(polar_pos.r() > row_radius_.at(row) && polar_pos.r() <= row_radius_.at(row + 1)) {
-            strip_y = static_cast<int>(row);
-            break;
-        }
+    return get_strip_index(getPositionPolar(position));
+}
+
+void RadialStripDetectorModel::getPixelIndices(const std::vector<ROOT::Math::XYZPoint>& positions,
+                                               std::vector<Pixel::Index>& indices) const {
+    indices.resize(positions.size());
+    for(size_t i = 0; i < positions.size(); ++i) {
+        auto [strip_x, strip_y] = get_strip_index(getPositionPolar(positions[i]));
+        indices[i] = {strip_x, strip_y};
+    }
+}
+
+int RadialStripDetectorModel::find_row(double r) const {
+    // The row radii are sorted, the row of a radius is the first row with an outer radius not smaller than the radius
+    auto outer_radius = std::lower_bound(row_radius_.begin() + 1, row_radius_.end(), r);
+    if(outer_radius == row_radius_.end() || r <= *(outer_radius - 1)) {
+        return -1;
     }
+    return static_cast<int>(outer_radius - row_radius_.begin() - 1);
+}
+
+std::pair<int, int> RadialStripDetectorModel::get_strip_index(const ROOT::Math::Polar2DPoint& polar_pos) const {
+    // Get row index, positions outside of all rows are assigned to the first row
+    auto strip_y = std::max(find_row(polar_pos.r()), 0);
     // Get the strip pitch in the correct strip row
-    auto pitch = angular_pitch_.at(static_cast<unsigned int>(strip_y));
+    auto row = static_cast<size_t>(strip_y);
+    auto pitch = angular_pitch_[row];
     // Calculate the strip x-index
-    auto strip_x = static_cast<int>(std::floor(
-        (polar_pos.phi() + stereo_angle_ + pitch * number_of_strips_.at(static_cast<unsigned int>(strip_y)) / 2) / pitch));
+    auto strip_x = static_cast<int>(std::floor((polar_pos.phi() + stereo_angle_ + row_angle_[row] / 2) / pitch));
 
     return {strip_x, strip_y};
 }
@@ -201,6 +234,15 @@ std::pair<int, int> RadialStripDetectorModel::getPixelIndex(const ROOT::Math::XY
 std::set<Pixel::Index> RadialStripDetectorModel::getNeighbors(const Pixel::Index& idx, const size_t distance) const {
     // Vector to hold the neighbor indices
     std::vector<Pixel::Index> neighbors;
+    getNeighbors(idx, distance, neighbors);
+    return {neighbors.begin(), neighbors.end()};
+}
+
+void RadialStripDetectorModel::getNeighbors(const Pixel::Index& idx,
+                                            const size_t distance,
+                                            std::vector<Pixel::Index>& neighbors) const {
+    // Remember the start of the appended indices to remove duplicates among them
+    auto first = static_cast<std::ptrdiff_t>(neighbors.size());
 
     // Position of the global seed in polar coordinates
     auto seed_pol = getPositionPolar(getPixelCenter(idx.x(), idx.y()));
@@ -237,7 +279,8 @@ std::set<Pixel::Index> RadialStripDetectorModel::getNeighbors(const Pixel::Index
         }
     }
 
-    return {neighbors.begin(), neighbors.end()};
+    std::sort(neighbors.begin() + first, neighbors.end());
+    neighbors.erase(std::unique(neighbors.begin() + first, neighbors.end()), neighbors.end());
 }
 
 bool RadialStripDetectorModel::areNeighbors(const Pixel::Index& seed,
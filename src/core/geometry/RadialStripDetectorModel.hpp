@@ -12,6 +12,7 @@
 #ifndef ALLPIX_RADIAL_STRIP_DETECTOR_MODEL_H
 #define ALLPIX_RADIAL_STRIP_DETECTOR_MODEL_H
 
+#include <cstdint>
 #include <numeric>
 #include <string>
 #include <utility>
@@ -246,6 +247,14 @@ namespace allpix {
          */
         std::pair<int, int> getPixelIndex(const ROOT::Math::XYZPoint& position) const override;
 
+        /**
+         * @brief Return X,Y indices of the strips corresponding to a set of local positions in a sensor
+         * @param positions Positions in local coordinates of the detector model
+         * @param indices Strip indices of the positions, resized to the number of positions
+         */
+        void getPixelIndices(const std::vector<ROOT::Math::XYZPoint>& positions,
+                             std::vector<Pixel::Index>& indices) const override;
+
         /**
          * @brief Return a set containing all pixels neighboring the given one with a configurable maximum distance
          * @param idx       Index of the pixel in question
@@ -256,6 +265,16 @@ namespace allpix {
          */
         std::set<Pixel::Index> getNeighbors(const Pixel::Index& idx, const size_t distance) const override;
 
+        /**
+         * @brief Append all pixels neighboring the given one with a configurable maximum distance to a buffer
+         * @param idx       Index of the pixel in question
+         * @param distance  Distance for pixels to be considered neighbors
+         * @param neighbors Buffer the neighboring pixel indices are appended to, including the initial pixel
+         */
+        void getNeighbors(const Pixel::Index& idx,
+                          const size_t distance,
+                          std::vector<Pixel::Index>& neighbors) const override;
+
         /**
          * @brief Check if two pixel indices are neighbors to each other
          * @param seed     Initial pixel index
@@ -326,6 +345,20 @@ namespace allpix {
          */
         void setStereoAngle(double val) { stereo_angle_ = val; }
 
+        /**
+         * @brief Find the strip row of a radial coordinate by a binary search of the sorted row radii
+         * @param r Radial coordinate
+         * @return Index of the strip row or -1 if the radius is outside of all rows
+         */
+        int find_row(double r) const;
+
+        /**
+         * @brief Get the strip indices of a position in polar coordinates
+         * @param polar_pos Position in local polar coordinates
+         * @return X,Y strip indices
+         */
+        std::pair<int, int> get_strip_index(const ROOT::Math::Polar2DPoint& polar_pos) const;
+
         std::vector<unsigned int> number_of_strips_{};
         std::vector<double> strip_length_{};
         std::vector<double> angular_pitch_{};
@@ -338,6 +371,9 @@ namespace allpix {
         std::vector<double> row_angle_{};
 
         ROOT::Math::XYZVector focus_translation_;
+
+        // Identifier of the model in the cache of the last polar conversion
+        uint64_t polar_cache_id_{};
     };
 } // namespace allpix
 
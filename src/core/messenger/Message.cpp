@@ -31,3 +31,7 @@ BaseMessage::~BaseMessage() = default;
 std::vector<std::reference_wrapper<Object>> BaseMessage::getObjectArray() {
     throw MessageWithoutObjectException(typeid(*this));
 }
+
+size_t BaseMessage::getObjectCount() const { return 0; }
+
+size_t BaseMessage::getMemoryUsage() const { return sizeof(*this); }
@@ -12,6 +12,8 @@
 #ifndef ALLPIX_MESSAGE_H
 #define ALLPIX_MESSAGE_H
 
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "core/geometry/Detector.hpp"
@@ -54,6 +56,30 @@ namespace allpix {
          */
         virtual std::vector<std::reference_wrapper<Object>> getObjectArray();
 
+        /**
+         * @brief Get the number of objects stored in this message without creating the list of objects
+         * @return Number of objects, zero if the message does not contain objects
+         */
+        virtual size_t getObjectCount() const;
+
+        /**
+         * @brief Estimate the memory held by this message
+         * @return Estimated memory in bytes
+         */
+        virtual size_t getMemoryUsage() const;
+
+        /**
+         * @brief Compress the bulk payload of the objects, e.g. their pulses, while the event waits in a buffer
+         * @return Number of bytes saved, zero if the message has no compressible payload
+         * @warning The payload is not accessible until it has been restored with \ref expandPayload
+         */
+        virtual size_t compressPayload() { return 0; }
+
+        /**
+         * @brief Restore the payload compressed with \ref compressPayload
+         */
+        virtual void expandPayload() {}
+
     protected:
         /**
          * @brief Construct a general message not linked to a detector
@@ -104,6 +130,29 @@ namespace allpix {
          */
         std::vector<std::reference_wrapper<Object>> getObjectArray() override;
 
+        /**
+         * @brief Get the number of objects stored in this message
+         * @return Number of data objects if the contents can be converted to objects, zero otherwise
+         */
+        size_t getObjectCount() const override;
+
+        /**
+         * @brief Estimate the memory held by this message from the storage of its data, including attached pulses
+         * @return Estimated memory in bytes
+         */
+        size_t getMemoryUsage() const override;
+
+        /**
+         * @brief Compress the pulses of the objects if they carry any
+         * @return Number of bytes saved
+         */
+        size_t compressPayload() override;
+
+        /**
+         * @brief Restore the pulses of the objects compressed with \ref compressPayload
+         */
+        void expandPayload() override;
+
     private:
         /**
          * @brief Returns object array for messages containing objects
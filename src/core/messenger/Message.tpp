@@ -12,6 +12,20 @@
 #include "core/messenger/exceptions.h"
 
 namespace allpix {
+    /**
+     * @brief Trait to detect objects carrying a pulse, whose samples are stored outside of the object itself
+     */
+    template <typename U, typename = void> struct has_pulse : std::false_type {};
+    template <typename U>
+    struct has_pulse<U, std::void_t<decltype(std::declval<const U&>().getPulse().capacity())>> : std::true_type {};
+
+    /**
+     * @brief Trait to detect objects whose pulses can be compressed
+     */
+    template <typename U, typename = void> struct has_compressible_pulses : std::false_type {};
+    template <typename U>
+    struct has_compressible_pulses<U, std::void_t<decltype(std::declval<U&>().compressPulses())>> : std::true_type {};
+
     template <typename T> Message<T>::Message(std::vector<T> data) : BaseMessage(), data_(std::move(data)) {}
     template <typename T>
     Message<T>::Message(std::vector<T> data, const std::shared_ptr<const Detector>& detector)
@@ -21,6 +35,42 @@ namespace allpix {
 
     template <typename T> const std::vector<T>& Message<T>::getData() const { return data_; }
 
+    template <typename T> size_t Message<T>::getObjectCount() const {
+        if constexpr(std::is_base_of_v<Object, T>) {
+            return data_.size();
+        } else {
+            return 0;
+        }
+    }
+
+    template <typename T> size_t Message<T>::getMemoryUsage() const {
+        auto memory = sizeof(*this) + data_.capacity() * sizeof(T);
+        if constexpr(has_pulse<T>::value) {
+            for(const auto& object : data_) {
+                memory += object.getPulse().capacity() * sizeof(double);
+            }
+        }
+        return memory;
+    }
+
+    template <typename T> size_t Message<T>::compressPayload() {
+        size_t saved = 0;
+        if constexpr(has_compressible_pulses<T>::value) {
+            for(auto& object : data_) {
+                saved += object.compressPulses();
+            }
+        }
+        return saved;
+    }
+
+    template <typename T> void Message<T>::expandPayload() {
+        if constexpr(has_compressible_pulses<T>::value) {
+            for(auto& object : data_) {
+                object.expandPulses();
+            }
+        }
+    }
+
     /**
      * Chooses between internal \ref get_object_array implementations dependent on the type of the object (if it drives from
      * \ref allpix::Object).
@@ -11,6 +11,7 @@
 
 #include "Messenger.hpp"
 
+#include <algorithm>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -33,8 +34,13 @@ Messenger::~Messenger() { assert(delegate_to_iterator_.empty()); }
 
 // Check if the detectors match for the message and the delegate and that we don't have self-dispatch
 static bool check_send(Module* source, BaseMessage* message, BaseDelegate* delegate) {
-    if(delegate->getDetector() != nullptr &&
-       (message->getDetector() == nullptr || delegate->getDetector()->getName() != message->getDetector()->getName())) {
+    // Detector modules, including those bound to multiple detectors, only receive messages of their own detectors
+    const auto& detectors = delegate->getDetectors();
+    if(!detectors.empty() &&
+       (message->getDetector() == nullptr ||
+        std::none_of(detectors.begin(), detectors.end(), [&message](const auto& detector) {
+            return detector->getName() == message->getDetector()->getName();
+        }))) {
         return false;
     }
     if(delegate->getUniqueName() == source->getUniqueName()) {
@@ -103,6 +109,10 @@ void Messenger::add_delegate(const std::type_info& message_type,
         message_name = module->get_configuration().get<std::string>("input");
     }
 
+    // Assign the per-event storage slot of this module and message type
+    auto slot = slots_.emplace(std::make_pair(module, std::type_index(message_type)), slots_.size()).first->second;
+    delegate->slot_ = slot;
+
     // Register delegate internally
     delegates_[std::type_index(message_type)][message_name].push_back(delegate);
     auto delegate_iter = --delegates_[std::type_index(message_type)][message_name].end();
@@ -138,7 +148,21 @@ std::vector<std::pair<std::shared_ptr<BaseMessage>, std::string>> Messenger::fet
     }
 }
 
-LocalMessenger::LocalMessenger(Messenger& global_messenger) : global_messenger_(global_messenger) {}
+LocalMessenger::LocalMessenger(Messenger& global_messenger)
+    : global_messenger_(global_messenger), messages_(global_messenger.slots_.size()),
+      received_(global_messenger.slots_.size(), false) {}
+
+void LocalMessenger::reset() {
+    for(auto& message : messages_) {
+        message.single.reset();
+        message.multi.clear();
+        message.filter_multi.clear();
+    }
+    std::fill(received_.begin(), received_.end(), false);
+    sent_messages_.clear();
+    dataflow_.clear();
+    compressed_ = false;
+}
 
 void LocalMessenger::dispatchMessage(Module* source, std::shared_ptr<BaseMessage> message, std::string name) { // NOLINT
     // Get the name of the output message
@@ -146,6 +170,8 @@ void LocalMessenger::dispatchMessage(Module* source, std::shared_ptr<BaseMessage
         name = source->get_configuration().get<std::string>("output");
     }
 
+    std::lock_guard<std::mutex> lock{dispatch_mutex_};
+
     bool send = false;
 
     // Send messages to specific listeners
@@ -190,10 +216,12 @@ bool LocalMessenger::dispatchMessage(Module* source,
                 if(check_send(source, message.get(), delegate.get())) {
                     LOG(TRACE) << "Sending message " << allpix::demangle(type_idx.name()) << " from "
                                << source->getUniqueName() << " to " << delegate->getUniqueName();
-                    // Construct BaseMessage where message should be stored
-                    auto& dest = messages_[delegate->getUniqueName()][type_idx];
-
-                    delegate->process(message, name, dest);
+                    // Store the message in the slot of the receiver
+                    received_[delegate->getSlot()] = true;
+                    delegate->process(message, name, messages_[delegate->getSlot()]);
+                    if(global_messenger_.record_dataflow_) {
+                        dataflow_.push_back({source, delegate->getSlot(), type_idx});
+                    }
                     send = true;
                 }
             }
@@ -210,8 +238,11 @@ bool LocalMessenger::dispatchMessage(Module* source,
                 if(check_send(source, message.get(), delegate.get())) {
                     LOG(TRACE) << "Sending message " << allpix::demangle(type_idx.name()) << " from "
                                << source->getUniqueName() << " to generic listener " << delegate->getUniqueName();
-                    auto& dest = messages_[delegate->getUniqueName()][typeid(BaseMessage)];
-                    delegate->process(message, name, dest);
+                    received_[delegate->getSlot()] = true;
+                    delegate->process(message, name, messages_[delegate->getSlot()]);
+                    if(global_messenger_.record_dataflow_) {
+                        dataflow_.push_back({source, delegate->getSlot(), type_idx});
+                    }
                     send = true;
                 }
             }
@@ -222,29 +253,49 @@ bool LocalMessenger::dispatchMessage(Module* source,
 }
 
 std::vector<std::pair<std::shared_ptr<BaseMessage>, std::string>> LocalMessenger::fetchFilteredMessages(Module* module) {
-    const std::type_index type_idx = typeid(BaseMessage);
-    return messages_.at(module->getUniqueName()).at(type_idx).filter_multi;
+    auto slot = global_messenger_.get_slot(module, typeid(BaseMessage));
+    if(!received_[slot]) {
+        throw std::out_of_range("message not received");
+    }
+    return messages_[slot].filter_multi;
 }
 
-bool LocalMessenger::isSatisfied(BaseDelegate* delegate) const {
-    // check our records for messages for this module
-    const std::string name = delegate->getUniqueName();
-    auto messages_iter = messages_.find(name);
-    if(messages_iter == messages_.end()) {
-        return false;
+size_t LocalMessenger::getMemoryUsage() const {
+    size_t memory = 0;
+    for(const auto& message : sent_messages_) {
+        memory += message->getMemoryUsage();
+    }
+    return memory;
+}
+
+std::map<std::type_index, size_t> LocalMessenger::getMemoryUsagePerType() const {
+    std::map<std::type_index, size_t> memory;
+    for(const auto& message : sent_messages_) {
+        memory[typeid(*message)] += message->getMemoryUsage();
     }
+    return memory;
+}
 
-    // check if this delegate is in our records
-    auto delegate_iter = global_messenger_.delegate_to_iterator_.find(delegate);
-    if(delegate_iter == global_messenger_.delegate_to_iterator_.end()) {
-        throw std::out_of_range("delegate not found in listeners");
+size_t LocalMessenger::compressPayloads() {
+    size_t saved = 0;
+    for(const auto& message : sent_messages_) {
+        saved += message->compressPayload();
     }
+    compressed_ = true;
+    return saved;
+}
 
-    // check our records for messages for this delegate
-    auto iter = messages_iter->second.find(std::get<0>(delegate_iter->second));
-    if(iter == messages_iter->second.end()) {
-        return false;
+void LocalMessenger::expandPayloads() {
+    if(!compressed_) {
+        return;
+    }
+    for(const auto& message : sent_messages_) {
+        message->expandPayload();
     }
+    compressed_ = false;
+}
 
-    return true;
+bool LocalMessenger::isSatisfied(BaseDelegate* delegate) const {
+    // check our records for messages for the slot of this delegate
+    return delegate->getSlot() < received_.size() && received_[delegate->getSlot()];
 }
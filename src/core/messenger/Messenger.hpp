@@ -13,10 +13,12 @@
 #define ALLPIX_MESSENGER_H
 
 #include <list>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <typeindex>
-#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "Message.hpp"
 #include "core/module/Event.hpp"
@@ -68,6 +70,13 @@ namespace allpix {
         Messenger& operator=(Messenger&&) = delete;
         /// @}
 
+        /**
+         * @brief Enable recording which modules sent and received the messages of every event
+         * @param record True if the deliveries should be recorded, see \ref LocalMessenger::getDataflow
+         * @warning Should be set before the first event is processed
+         */
+        void setRecordDataflow(bool record) { record_dataflow_ = record; }
+
         /**
          * @brief Register a function filtering all dispatched messages
          * @param receiver Receiving module
@@ -178,9 +187,25 @@ namespace allpix {
             std::map<BaseDelegate*,
                      std::tuple<std::type_index, std::string, std::list<std::shared_ptr<BaseDelegate>>::iterator>>;
 
+        /**
+         * @brief Get the storage slot for messages of a given type received by a module
+         * @param module Module receiving the messages
+         * @param message_type Type of the message
+         * @return Index of the per-event message storage
+         * @throws std::out_of_range If the module is not bound to this type of message
+         */
+        size_t get_slot(const Module* module, const std::type_index& message_type) const {
+            return slots_.at(std::make_pair(module, message_type));
+        }
+
         DelegateMap delegates_;
         DelegateIteratorMap delegate_to_iterator_;
 
+        // Dense index of the per-event message storage for every receiving module and message type
+        std::map<std::pair<const Module*, std::type_index>, size_t> slots_;
+
+        bool record_dataflow_{false};
+
         mutable std::mutex mutex_;
     };
 
@@ -188,12 +213,27 @@ namespace allpix {
      * @brief Responsible for the actual handling of messages between Modules.
      *
      * The local messenger is an internal object that is allocated for each thread separately. It handles dispatching
-     * and fetching messages between Modules.
+     * and fetching messages between Modules. Messages are stored in a flat array, indexed by the storage slots assigned by
+     * the global messenger when the delegates are registered.
      */
     class LocalMessenger {
     public:
+        /**
+         * @brief Delivery of a message from the sending module to the storage slot of a receiving module
+         */
+        struct Transfer {
+            Module* source;
+            size_t slot;
+            std::type_index type;
+        };
+
         explicit LocalMessenger(Messenger& global_messenger);
 
+        /**
+         * @brief Release all messages of the event while keeping the storage of the slots allocated for reuse
+         */
+        void reset();
+
         void dispatchMessage(Module* source, std::shared_ptr<BaseMessage> message, std::string name);
         bool dispatchMessage(Module* source,
                              const std::shared_ptr<BaseMessage>& message,
@@ -206,6 +246,35 @@ namespace allpix {
          */
         bool isSatisfied(BaseDelegate* delegate) const;
 
+        /**
+         * @brief Estimate the memory held by all messages dispatched in this event
+         * @return Estimated memory in bytes
+         */
+        size_t getMemoryUsage() const;
+
+        /**
+         * @brief Estimate the memory held by the messages dispatched in this event for every message type
+         * @return Estimated memory in bytes per type of the messages
+         */
+        std::map<std::type_index, size_t> getMemoryUsagePerType() const;
+
+        /**
+         * @brief Compress the payload of all messages dispatched in this event while the event waits in a buffer
+         * @return Number of bytes saved
+         */
+        size_t compressPayloads();
+
+        /**
+         * @brief Restore the payload of all messages compressed with \ref compressPayloads, does nothing otherwise
+         */
+        void expandPayloads();
+
+        /**
+         * @brief Get all deliveries of messages in this event
+         * @return Deliveries in the order of dispatching, empty unless recording is enabled in the global messenger
+         */
+        const std::vector<Transfer>& getDataflow() const { return dataflow_; }
+
         /**
          * @brief Fetches a single message of specified type meant for the calling module
          * @return Shared pointer to message
@@ -228,8 +297,17 @@ namespace allpix {
         // The global messenger which contains the shared delegate information
         const Messenger& global_messenger_;
 
-        std::unordered_map<std::string, std::unordered_map<std::type_index, DelegateTypes>> messages_;
+        // Received messages and flag if a message has been received, indexed by the slots of the global messenger. The
+        // flags are stored as separate bytes such that modules can check their own flag while messages are dispatched.
+        std::vector<DelegateTypes> messages_;
+        std::vector<char> received_;
         std::vector<std::shared_ptr<BaseMessage>> sent_messages_;
+        std::vector<Transfer> dataflow_;
+        // Flag if the payload of the messages is currently compressed
+        bool compressed_{};
+
+        // Serializes the dispatching of messages from modules running concurrently for the same event
+        std::mutex dispatch_mutex_;
     };
 } // namespace allpix
 
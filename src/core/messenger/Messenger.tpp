@@ -72,18 +72,22 @@ namespace allpix {
 
     template <typename T> std::shared_ptr<T> LocalMessenger::fetchMessage(Module* module) {
         static_assert(std::is_base_of<BaseMessage, T>::value, "Fetched message should inherit from Message class");
-        std::type_index type_idx = typeid(T);
-        return std::static_pointer_cast<T>(messages_.at(module->getUniqueName()).at(type_idx).single);
+        auto slot = global_messenger_.get_slot(module, typeid(T));
+        if(!received_[slot]) {
+            throw std::out_of_range("message not received");
+        }
+        return std::static_pointer_cast<T>(messages_[slot].single);
     }
 
     template <typename T> std::vector<std::shared_ptr<T>> LocalMessenger::fetchMultiMessage(Module* module) {
         static_assert(std::is_base_of<BaseMessage, T>::value, "Fetched message should inherit from Message class");
 
         // TODO: do nothing if T == BaseMessage; there is no need to cast (optimized out)?
-        std::type_index type_idx = typeid(T);
-
-        // Construct an empty vector in case no previous modules created one during dispatch
-        auto base_messages = messages_.at(module->getUniqueName()).at(type_idx).multi;
+        auto slot = global_messenger_.get_slot(module, typeid(T));
+        if(!received_[slot]) {
+            throw std::out_of_range("message not received");
+        }
+        const auto& base_messages = messages_[slot].multi;
 
         std::vector<std::shared_ptr<T>> derived_messages;
         derived_messages.reserve(base_messages.size());
@@ -18,9 +18,11 @@
 #define ALLPIX_DELEGATE_H
 
 #include <cassert>
+#include <cstddef>
 #include <memory>
 #include <typeinfo>
 #include <utility>
+#include <vector>
 
 #include "Message.hpp"
 #include "core/geometry/Detector.hpp"
@@ -130,6 +132,12 @@ namespace allpix {
          */
         virtual std::shared_ptr<Detector> getDetector() const = 0;
 
+        /**
+         * @brief Get all detectors bound to a delegate
+         * @return Linked detectors, empty if the delegate accepts messages of all detectors
+         */
+        virtual const std::vector<std::shared_ptr<Detector>>& getDetectors() const = 0;
+
         /**
          * @brief Get the unique identifier for the bound object
          * @return Unique identifier
@@ -144,8 +152,18 @@ namespace allpix {
          */
         virtual void process(std::shared_ptr<BaseMessage> msg, std::string name, DelegateTypes& dest) = 0;
 
+        /**
+         * @brief Get the index of the per-event message storage of this delegate
+         * @return Storage slot assigned by the messenger
+         */
+        size_t getSlot() const { return slot_; }
+
     protected:
         MsgFlags flags_;
+
+    private:
+        friend class Messenger;
+        size_t slot_{};
     };
 
     /**
@@ -177,6 +195,13 @@ namespace allpix {
          */
         std::shared_ptr<Detector> getDetector() const override { return obj_->getDetector(); }
 
+        /**
+         * @brief Get all detectors bound to this module
+         *
+         * Returns the bound detectors for detector modules and an empty list for unique modules
+         */
+        const std::vector<std::shared_ptr<Detector>>& getDetectors() const override { return obj_->getDetectors(); }
+
     protected:
         T* const obj_;
     };
@@ -15,7 +15,9 @@
 #include <chrono>
 #include <list>
 #include <memory>
+#include <sstream>
 #include <string>
+#include <utility>
 
 #include "Module.hpp"
 #include "ModuleManager.hpp"
@@ -25,9 +27,13 @@
 using namespace allpix;
 
 std::mutex Event::stats_mutex_;
+thread_local RandomNumberGenerator* Event::chain_random_engine_{nullptr};
 
-Event::Event(Messenger& messenger, uint64_t event_num, uint64_t seed) : number(event_num), seed_(seed) {
-    local_messenger_ = std::make_unique<LocalMessenger>(messenger);
+Event::Event(Messenger& messenger, uint64_t event_num, uint64_t seed, std::unique_ptr<LocalMessenger> local_messenger)
+    : number(event_num), seed_(seed), local_messenger_(std::move(local_messenger)) {
+    if(local_messenger_ == nullptr) {
+        local_messenger_ = std::make_unique<LocalMessenger>(messenger);
+    }
 }
 
 void Event::set_and_seed_random_engine(RandomNumberGenerator* random_engine) {
@@ -36,6 +42,9 @@ void Event::set_and_seed_random_engine(RandomNumberGenerator* random_engine) {
 }
 
 RandomNumberGenerator& Event::getRandomEngine() {
+    if(chain_random_engine_ != nullptr) {
+        return *chain_random_engine_;
+    }
     if(random_engine_ == nullptr) {
         throw InvalidEventStateException("No PRNG available");
     }
@@ -43,18 +52,45 @@ RandomNumberGenerator& Event::getRandomEngine() {
 }
 
 void Event::store_random_engine_state() {
-    if(random_engine_ != nullptr && state_.rdbuf()->in_avail() == 0) {
+    if(random_engine_ != nullptr && state_.empty()) {
         LOG(PRNG) << "Storing PRNG state in event";
-        state_ << *random_engine_;
+        std::ostringstream state;
+        state << *random_engine_;
+        state_ = state.str();
     }
 }
 
 void Event::restore_random_engine_state() {
-    if(random_engine_ != nullptr && state_.rdbuf()->in_avail() != 0) {
+    if(random_engine_ != nullptr && !state_.empty()) {
         LOG(PRNG) << "Restoring PRNG state from event";
-        state_ >> *random_engine_;
+        std::istringstream state(state_);
+        state >> *random_engine_;
         state_.clear();
     }
 }
 
 LocalMessenger* Event::get_local_messenger() const { return local_messenger_.get(); }
+
+void Event::abort(std::string reason) { request_interrupt(Interrupt::ABORT, std::move(reason)); }
+
+void Event::requestEndOfRun(std::string reason) { request_interrupt(Interrupt::END_OF_RUN, std::move(reason)); }
+
+void Event::requestRescheduling() { request_interrupt(Interrupt::RESCHEDULE, std::string()); }
+
+void Event::request_interrupt(Interrupt interrupt, std::string reason) {
+    std::lock_guard<std::mutex> lock{interrupt_mutex_};
+    if(interrupt_ == Interrupt::NONE) {
+        interrupt_reason_ = std::move(reason);
+        interrupt_ = interrupt;
+    }
+}
+
+std::pair<Event::Interrupt, std::string> Event::take_interrupt() {
+    // Only lock if an interruption has been requested, which is the rare case
+    if(interrupt_ == Interrupt::NONE) {
+        return {Interrupt::NONE, std::string()};
+    }
+    std::lock_guard<std::mutex> lock{interrupt_mutex_};
+    auto interrupt = interrupt_.exchange(Interrupt::NONE);
+    return {interrupt, std::move(interrupt_reason_)};
+}
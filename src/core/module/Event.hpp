@@ -18,6 +18,8 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "core/utils/prng.h"
@@ -42,8 +44,12 @@ namespace allpix {
          * @param messenger Messenger responsible for handling message transmission for this event
          * @param event_num The unique event identifier
          * @param seed Random generator seed for this event
+         * @param local_messenger Local messenger of a finished event to reuse, a new one is created if not provided
          */
-        explicit Event(Messenger& messenger, uint64_t event_num, uint64_t seed);
+        explicit Event(Messenger& messenger,
+                       uint64_t event_num,
+                       uint64_t seed,
+                       std::unique_ptr<LocalMessenger> local_messenger = nullptr);
         /**
          * @brief Use default destructor
          */
@@ -80,7 +86,86 @@ namespace allpix {
          */
         uint64_t getSeed() const { return seed_; }
 
+        /**
+         * @brief Reject the event as uninteresting, e.g. because it does not fulfill a trigger condition
+         *
+         * All following modules are skipped for this event, except those processing rejected events such as writers. In
+         * contrast to aborting the event, the messages dispatched so far are kept and the event counts as finished.
+         */
+        void reject() { rejected_ = true; }
+
+        /**
+         * @brief Returns if the event has been rejected by one of the modules
+         * @return True if the event has been rejected, false otherwise
+         */
+        bool isRejected() const { return rejected_; }
+
+        /**
+         * @brief Abort the processing of this event once the calling module returns from its run method
+         * @param reason Text explaining the reason of the abortion
+         *
+         * This has the same effect as throwing an \ref AbortEventException, but avoids the cost of unwinding the stack for
+         * modules aborting many events. The module should return from its run method right after calling this method.
+         */
+        void abort(std::string reason);
+
+        /**
+         * @brief Request the end of the run once the calling module returns from its run method
+         * @param reason Text explaining the reason of the requested end of event processing
+         *
+         * This has the same effect as throwing an \ref EndOfRunException, the module should return from its run method right
+         * after calling this method.
+         */
+        void requestEndOfRun(std::string reason);
+
+        /**
+         * @brief Request to continue this event later, once the calling module returns from its run method
+         *
+         * This has the same effect as throwing a \ref MissingDependenciesException, the module should return from its run
+         * method right after calling this method and is called again for this event later.
+         */
+        void requestRescheduling();
+
+        /**
+         * @brief Set the statistical weight of the event
+         * @param weight Weight of the event
+         *
+         * Modules sampling from a biased distribution, e.g. to enhance rare configurations, set the ratio of the true to the
+         * sampled probability density of their outcome as weight. If several modules bias the event, their weights should be
+         * multiplied. Modules filling histograms or writing data should take the weight into account.
+         */
+        void setWeight(double weight) { weight_ = weight; }
+
+        /**
+         * @brief Returns the statistical weight of the event
+         * @return Weight of the event, one for unbiased events
+         */
+        double getWeight() const { return weight_; }
+
     private:
+        /**
+         * @brief Interruption of the processing of the event requested by a module
+         */
+        enum class Interrupt {
+            NONE,
+            RESCHEDULE,
+            ABORT,
+            END_OF_RUN,
+        };
+
+        /**
+         * @brief Request an interruption of the event, only the first request is kept
+         * @param interrupt Type of the interruption
+         * @param reason    Text explaining the reason of the interruption
+         */
+        void request_interrupt(Interrupt interrupt, std::string reason);
+
+        /**
+         * @brief Take the interruption requested by the last module and reset it
+         * @return Type and reason of the interruption, type NONE if no interruption was requested
+         */
+        std::pair<Interrupt, std::string> take_interrupt();
+
         /**
          * @brief Sets the random engine and seed it to be used by this event
          * @param random_engine Pointer to RNG for this event
@@ -100,11 +185,26 @@ namespace allpix {
         // The random number engine associated with this event
         RandomNumberGenerator* random_engine_{nullptr};
 
+        // Random number engine replacing the one of the event on the calling thread while it processes a chain of detector
+        // modules concurrently with other chains of the same event
+        static thread_local RandomNumberGenerator* chain_random_engine_;
+
         // Seed for random number generator
         uint64_t seed_;
 
-        // State of the random number generator
-        std::stringstream state_;
+        // State of the random number generator, only stored when the event is interrupted
+        std::string state_;
+
+        // Flag if the event has been rejected by one of the modules, which might run concurrently
+        std::atomic_bool rejected_{false};
+
+        // Interruption requested by a module, checked after every module without locking, and its reason
+        std::atomic<Interrupt> interrupt_{Interrupt::NONE};
+        std::string interrupt_reason_;
+        std::mutex interrupt_mutex_;
+
+        // Statistical weight of the event
+        double weight_{1.};
 
         /**
          * @brief Returns a pointer to the event local messenger
@@ -116,6 +216,13 @@ namespace allpix {
 
         // Mutex for execution time
         static std::mutex stats_mutex_;
+
+        // Memory retained by the modules so far and its maximum during the event in bytes, protected by the stats mutex
+        int64_t memory_footprint_{};
+        int64_t memory_peak_{};
+
+        // Time spent in every stage of the pipeline in ns if the dataflow is recorded, protected by the stats mutex
+        std::vector<int64_t> stage_time_;
     };
 
 } // namespace allpix
@@ -0,0 +1,156 @@
+/**
+ * @file
+ * @brief Implementation of the accounting of memory allocations in the event loop
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "MemoryAccounting.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#if defined(__linux__) || defined(__APPLE__)
+#define ALLPIX_MEMORY_ACCOUNTING
+#include <sys/resource.h>
+#endif
+
+#if defined(__linux__)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#endif
+
+using namespace allpix;
+
+bool MemoryAccounting::enabled_{false};
+thread_local MemoryAccounting::Counters* MemoryAccounting::counters_{nullptr};
+
+MemoryAccounting::Scope::Scope(Counters& counters) : previous_(counters_) { counters_ = &counters; }
+
+MemoryAccounting::Scope::~Scope() { counters_ = previous_; }
+
+bool MemoryAccounting::enable() {
+#ifdef ALLPIX_MEMORY_ACCOUNTING
+    enabled_ = true;
+#endif
+    return enabled_;
+}
+
+uint64_t MemoryAccounting::getPeakResidentMemory() {
+#ifdef ALLPIX_MEMORY_ACCOUNTING
+    struct rusage usage {};
+    if(getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    // Reported in bytes on macOS
+    return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+    // Reported in kilobytes on Linux
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#else
+    return 0;
+#endif
+}
+
+#ifdef ALLPIX_MEMORY_ACCOUNTING
+namespace {
+    /**
+     * @brief Get the usable size of a block allocated by the C allocator
+     */
+    size_t usable_size(void* ptr) {
+#ifdef __APPLE__
+        return malloc_size(ptr);
+#else
+        return malloc_usable_size(ptr);
+#endif
+    }
+
+    /**
+     * @brief Allocate memory like the default global operator new and count the allocation
+     * @param size Requested size in bytes
+     * @param alignment Requested alignment, only honored explicitly if stricter than the default of the C allocator
+     */
+    void* allocate(size_t size, size_t alignment) {
+        size = std::max<size_t>(size, 1);
+        while(true) {
+            void* ptr = nullptr;
+            if(alignment > alignof(std::max_align_t)) {
+                if(posix_memalign(&ptr, alignment, size) != 0) {
+                    ptr = nullptr;
+                }
+            } else {
+                ptr = std::malloc(size);
+            }
+            if(ptr != nullptr) {
+                if(MemoryAccounting::enabled()) {
+                    MemoryAccounting::countAllocation(usable_size(ptr));
+                }
+                return ptr;
+            }
+
+            // Give the installed handler the chance to free memory as required for the default operator new
+            auto* handler = std::get_new_handler();
+            if(handler == nullptr) {
+                throw std::bad_alloc();
+            }
+            handler();
+        }
+    }
+
+    void* allocate_nothrow(size_t size, size_t alignment) noexcept {
+        try {
+            return allocate(size, alignment);
+        } catch(const std::bad_alloc&) {
+            return nullptr;
+        }
+    }
+
+    void release(void* ptr) noexcept {
+        if(ptr == nullptr) {
+            return;
+        }
+        if(MemoryAccounting::enabled()) {
+            MemoryAccounting::countRelease(usable_size(ptr));
+        }
+        std::free(ptr);
+    }
+} // namespace
+
+/*
+ * Replacements of all global allocation and deallocation functions, such that allocations and deallocations always go
+ * through the same functions regardless of the form of new and delete used
+ */
+void* operator new(size_t size) { return allocate(size, 0); }
+void* operator new[](size_t size) { return allocate(size, 0); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return allocate_nothrow(size, 0); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return allocate_nothrow(size, 0); }
+void* operator new(size_t size, std::align_val_t alignment) { return allocate(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment) { return allocate(size, static_cast<size_t>(alignment)); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate_nothrow(size, static_cast<size_t>(alignment));
+}
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate_nothrow(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept { release(ptr); }
+void operator delete[](void* ptr) noexcept { release(ptr); }
+void operator delete(void* ptr, size_t) noexcept { release(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { release(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { release(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { release(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { release(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { release(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { release(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { release(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { release(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { release(ptr); }
+#endif
@@ -0,0 +1,131 @@
+/**
+ * @file
+ * @brief Definition of the accounting of memory allocations in the event loop
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_MODULE_MEMORY_ACCOUNTING_H
+#define ALLPIX_MODULE_MEMORY_ACCOUNTING_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace allpix {
+    /**
+     * @brief Static class attributing the memory allocated with the global operator new to the code currently running
+     *
+     * The global allocation functions are replaced by the framework and forward to the C allocator. Once enabled, every
+     * allocation and deallocation on a thread with an active \ref MemoryAccounting::Scope is added to the counters of that
+     * scope, using the usable size of the allocated block as reported by the C allocator. Memory released in a scope is
+     * counted there regardless of where it has been allocated, so the difference of allocated and released bytes is the
+     * memory a scope has retained, e.g. in dispatched messages or caches of the module. Allocations with the C functions
+     * themselves, as done by some external libraries, are not seen. On platforms without a way to query the size of an
+     * allocated block, the allocation functions are not replaced and nothing is counted.
+     */
+    class MemoryAccounting {
+    public:
+        /**
+         * @brief Counters of one scope, only ever modified by the thread owning the scope
+         */
+        struct Counters {
+            uint64_t allocated{};   ///< Number of bytes allocated
+            uint64_t released{};    ///< Number of bytes released
+            uint64_t allocations{}; ///< Number of allocations
+            int64_t peak{};         ///< Maximum of the allocated minus the released bytes during the scope
+        };
+
+        /**
+         * @brief Guard attributing the allocations of the calling thread to a set of counters during its lifetime
+         *
+         * Scopes can be nested, the previous counters are restored when the inner scope ends. The scope has no effect if
+         * the accounting is not enabled.
+         */
+        class Scope {
+        public:
+            /**
+             * @brief Start counting the allocations of the calling thread
+             * @param counters Counters to add the allocations to, need to outlive the scope
+             */
+            explicit Scope(Counters& counters);
+
+            /**
+             * @brief Restore the counters active before the scope
+             */
+            ~Scope();
+
+            /// @{
+            /**
+             * @brief Scopes are bound to the calling thread and cannot be copied or moved
+             */
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+            Scope(Scope&&) = delete;
+            Scope& operator=(Scope&&) = delete;
+            /// @}
+
+        private:
+            Counters* previous_;
+        };
+
+        /**
+         * @brief Delete default constructor (only static access)
+         */
+        MemoryAccounting() = delete;
+
+        /**
+         * @brief Enable the accounting
+         * @return True if the accounting is supported on this platform, false otherwise
+         * @warning Should be called before the threads counting allocations are started
+         */
+        static bool enable();
+
+        /**
+         * @brief Check if the accounting is enabled
+         * @return True if allocations are counted
+         */
+        static bool enabled() { return enabled_; }
+
+        /**
+         * @brief Get the maximum resident memory of the process so far
+         * @return Peak resident memory in bytes, zero if it cannot be determined
+         */
+        static uint64_t getPeakResidentMemory();
+
+        /**
+         * @brief Count an allocation for the active scope of the calling thread
+         * @param size Usable size of the allocated block
+         * @note Only to be called by the replaced allocation functions
+         */
+        static void countAllocation(size_t size) {
+            if(enabled_ && counters_ != nullptr) {
+                counters_->allocated += size;
+                counters_->allocations++;
+                counters_->peak =
+                    std::max(counters_->peak, static_cast<int64_t>(counters_->allocated - counters_->released));
+            }
+        }
+
+        /**
+         * @brief Count a deallocation for the active scope of the calling thread
+         * @param size Usable size of the released block
+         * @note Only to be called by the replaced deallocation functions
+         */
+        static void countRelease(size_t size) {
+            if(enabled_ && counters_ != nullptr) {
+                counters_->released += size;
+            }
+        }
+
+    private:
+        static bool enabled_;
+        static thread_local Counters* counters_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_MODULE_MEMORY_ACCOUNTING_H */
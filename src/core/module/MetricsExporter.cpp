@@ -0,0 +1,161 @@
+/**
+ * @file
+ * @brief Implementation of the exporter of live metrics of the event loop
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "MetricsExporter.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#include "core/utils/log.h"
+
+using namespace allpix;
+
+MetricsExporter::MetricsExporter(std::filesystem::path path,
+                                 Format format,
+                                 std::chrono::nanoseconds interval,
+                                 std::function<Metrics()> sample)
+    : path_(std::move(path)), format_(format), interval_(interval), sample_(std::move(sample)),
+      start_time_(std::chrono::steady_clock::now()), last_time_(start_time_) {
+    thread_ = std::thread([this]() {
+        std::unique_lock<std::mutex> lock{mutex_};
+        while(!condition_.wait_for(lock, interval_, [this]() { return done_; })) {
+            export_metrics();
+        }
+    });
+}
+
+MetricsExporter::~MetricsExporter() { stop(); }
+
+void MetricsExporter::stop() {
+    if(!thread_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        done_ = true;
+    }
+    condition_.notify_all();
+    thread_.join();
+
+    // Export the final state of the run
+    export_metrics();
+}
+
+void MetricsExporter::export_metrics() {
+    auto metrics = sample_();
+    auto now = std::chrono::steady_clock::now();
+    auto run_time = std::chrono::duration<double>(now - start_time_).count();
+    auto interval = std::chrono::duration<double>(now - last_time_).count();
+
+    auto event_rate = 0.;
+    if(interval > 0) {
+        event_rate = static_cast<double>(metrics.finished_events - last_finished_events_) / interval;
+    }
+    std::vector<double> utilization(metrics.worker_busy_time.size());
+    last_busy_time_.resize(metrics.worker_busy_time.size());
+    for(size_t i = 0; i < utilization.size() && interval > 0; ++i) {
+        utilization[i] = static_cast<double>(metrics.worker_busy_time[i] - last_busy_time_[i]) * 1e-9 / interval;
+    }
+    last_time_ = now;
+    last_finished_events_ = metrics.finished_events;
+    last_busy_time_ = metrics.worker_busy_time;
+
+    auto content = (format_ == Format::JSON ? format_json(metrics, run_time, event_rate, utilization)
+                                            : format_prometheus(metrics, run_time, event_rate, utilization));
+
+    // Write to a temporary file next to the metrics file and replace it, failures do not interrupt the run
+    try {
+        auto temporary_path = path_;
+        temporary_path += "." + std::to_string(::getpid());
+        {
+            std::ofstream file(temporary_path);
+            file << content;
+            if(!file) {
+                throw std::runtime_error("cannot write " + temporary_path.string());
+            }
+        }
+        std::filesystem::rename(temporary_path, path_);
+        write_failed_ = false;
+    } catch(std::exception& e) {
+        if(!write_failed_) {
+            LOG(WARNING) << "Cannot export metrics to " << path_ << ": " << e.what();
+        }
+        write_failed_ = true;
+    }
+}
+
+std::string MetricsExporter::format_prometheus(const Metrics& metrics,
+                                               double run_time,
+                                               double event_rate,
+                                               const std::vector<double>& utilization) {
+    std::ostringstream out;
+    auto metric = [&out](const std::string& name, const std::string& type, const std::string& help) {
+        out << "# HELP allpix_" << name << " " << help << "\n# TYPE allpix_" << name << " " << type << "\n";
+    };
+
+    metric("events_finished_total", "counter", "Number of events finished in this run");
+    out << "allpix_events_finished_total " << metrics.finished_events << "\n";
+    metric("events_aborted_total", "counter", "Number of events aborted by a module");
+    out << "allpix_events_aborted_total " << metrics.aborted_events << "\n";
+    metric("events_rejected_total", "counter", "Number of events rejected by a module");
+    out << "allpix_events_rejected_total " << metrics.rejected_events << "\n";
+    metric("events_requested", "gauge", "Number of events requested for this run");
+    out << "allpix_events_requested " << metrics.total_events << "\n";
+    metric("event_rate", "gauge", "Events finished per second since the previous export");
+    out << "allpix_event_rate " << event_rate << "\n";
+    metric("run_time_seconds", "gauge", "Time since the start of the event loop");
+    out << "allpix_run_time_seconds " << run_time << "\n";
+    metric("queued_events", "gauge", "Number of events waiting in the queue of the workers");
+    out << "allpix_queued_events " << metrics.queued_events << "\n";
+    metric("buffered_events", "gauge", "Number of events buffered for modules requiring the events in sequence");
+    out << "allpix_buffered_events " << metrics.buffered_events << "\n";
+
+    metric("module_time_seconds_total", "counter", "Cumulative execution time of every module");
+    for(const auto& [name, time] : metrics.module_time) {
+        out << "allpix_module_time_seconds_total{module=\"" << name << "\"} " << static_cast<double>(time) * 1e-9 << "\n";
+    }
+    metric("worker_busy_seconds_total", "counter", "Cumulative time every worker spent processing events");
+    for(size_t i = 0; i < metrics.worker_busy_time.size(); ++i) {
+        out << "allpix_worker_busy_seconds_total{worker=\"" << i << "\"} "
+            << static_cast<double>(metrics.worker_busy_time[i]) * 1e-9 << "\n";
+    }
+    metric("worker_utilization", "gauge", "Fraction of the time since the previous export every worker was busy");
+    for(size_t i = 0; i < utilization.size(); ++i) {
+        out << "allpix_worker_utilization{worker=\"" << i << "\"} " << utilization[i] << "\n";
+    }
+    return out.str();
+}
+
+std::string MetricsExporter::format_json(const Metrics& metrics,
+                                         double run_time,
+                                         double event_rate,
+                                         const std::vector<double>& utilization) {
+    std::ostringstream out;
+    out << "{\n  \"finished_events\": " << metrics.finished_events << ",\n  \"aborted_events\": " << metrics.aborted_events
+        << ",\n  \"rejected_events\": " << metrics.rejected_events << ",\n  \"requested_events\": " << metrics.total_events
+        << ",\n  \"event_rate\": " << event_rate << ",\n  \"run_time_s\": " << run_time
+        << ",\n  \"queued_events\": " << metrics.queued_events << ",\n  \"buffered_events\": " << metrics.buffered_events
+        << ",\n  \"modules\": {";
+    for(size_t i = 0; i < metrics.module_time.size(); ++i) {
+        out << (i == 0 ? "" : ", ") << "\"" << metrics.module_time[i].first
+            << "\": " << static_cast<double>(metrics.module_time[i].second) * 1e-9;
+    }
+    out << "},\n  \"workers\": [";
+    for(size_t i = 0; i < utilization.size(); ++i) {
+        out << (i == 0 ? "" : ", ") << "{\"busy_s\": " << static_cast<double>(metrics.worker_busy_time[i]) * 1e-9
+            << ", \"utilization\": " << utilization[i] << "}";
+    }
+    out << "]\n}\n";
+    return out.str();
+}
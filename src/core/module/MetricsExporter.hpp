@@ -0,0 +1,143 @@
+/**
+ * @file
+ * @brief Definition of the exporter of live metrics of the event loop
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_MODULE_METRICS_EXPORTER_H
+#define ALLPIX_MODULE_METRICS_EXPORTER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace allpix {
+    /**
+     * @brief Exporter writing metrics of the running event loop periodically to a file
+     *
+     * The metrics are sampled from the event loop in a dedicated thread and written either in the Prometheus text format,
+     * which can be collected by the textfile collector of the Prometheus node exporter, or as JSON. Every export replaces
+     * the file atomically, such that readers never see a partially written file.
+     */
+    class MetricsExporter {
+    public:
+        /**
+         * @brief Format of the metrics file
+         */
+        enum class Format {
+            PROMETHEUS, ///< Prometheus text exposition format
+            JSON,       ///< Single JSON object
+        };
+
+        /**
+         * @brief Metrics of the event loop at the time of sampling
+         */
+        struct Metrics {
+            uint64_t finished_events{};
+            uint64_t aborted_events{};
+            uint64_t rejected_events{};
+            uint64_t total_events{};
+            size_t queued_events{};
+            size_t buffered_events{};
+            // Cumulative execution time of every module in ns
+            std::vector<std::pair<std::string, int64_t>> module_time;
+            // Cumulative time every worker spent executing tasks in ns
+            std::vector<int64_t> worker_busy_time;
+        };
+
+        /**
+         * @brief Start the exporter thread
+         * @param path     Path of the metrics file
+         * @param format   Format of the metrics file
+         * @param interval Time between two exports
+         * @param sample   Function sampling the metrics of the event loop, called from the exporter thread
+         */
+        MetricsExporter(std::filesystem::path path,
+                        Format format,
+                        std::chrono::nanoseconds interval,
+                        std::function<Metrics()> sample);
+
+        /**
+         * @brief Stop the exporter thread after a last export
+         */
+        ~MetricsExporter();
+
+        /// @{
+        /**
+         * @brief Copying and moving the exporter is not allowed
+         */
+        MetricsExporter(const MetricsExporter&) = delete;
+        MetricsExporter& operator=(const MetricsExporter&) = delete;
+        MetricsExporter(MetricsExporter&&) = delete;
+        MetricsExporter& operator=(MetricsExporter&&) = delete;
+        /// @}
+
+        /**
+         * @brief Stop the exporter thread after a last export, such that the file holds the final metrics of the run
+         */
+        void stop();
+
+    private:
+        /**
+         * @brief Sample the metrics and write them to the metrics file
+         */
+        void export_metrics();
+
+        /**
+         * @brief Format the metrics in the Prometheus text format
+         * @param metrics     Sampled metrics
+         * @param run_time    Time since the start of the exporter in s
+         * @param event_rate  Event rate since the previous export in events/s
+         * @param utilization Fraction of the time since the previous export every worker spent executing tasks
+         * @return Content of the metrics file
+         */
+        static std::string format_prometheus(const Metrics& metrics,
+                                             double run_time,
+                                             double event_rate,
+                                             const std::vector<double>& utilization);
+
+        /**
+         * @brief Format the metrics as JSON object
+         * @param metrics     Sampled metrics
+         * @param run_time    Time since the start of the exporter in s
+         * @param event_rate  Event rate since the previous export in events/s
+         * @param utilization Fraction of the time since the previous export every worker spent executing tasks
+         * @return Content of the metrics file
+         */
+        static std::string format_json(const Metrics& metrics,
+                                       double run_time,
+                                       double event_rate,
+                                       const std::vector<double>& utilization);
+
+        std::filesystem::path path_;
+        Format format_;
+        std::chrono::nanoseconds interval_;
+        std::function<Metrics()> sample_;
+
+        // State of the previous export to derive the rates
+        std::chrono::steady_clock::time_point start_time_;
+        std::chrono::steady_clock::time_point last_time_;
+        uint64_t last_finished_events_{};
+        std::vector<int64_t> last_busy_time_;
+        bool write_failed_{};
+
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        bool done_{};
+        std::thread thread_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_MODULE_METRICS_EXPORTER_H */
@@ -25,7 +25,13 @@ using namespace allpix;
 
 Module::Module(Configuration& config) : Module(config, nullptr) {}
 Module::Module(Configuration& config, std::shared_ptr<Detector> detector)
-    : config_(config), detector_(std::move(detector)) {}
+    : config_(config), detector_(std::move(detector)) {
+    if(detector_ != nullptr) {
+        detectors_.push_back(detector_);
+    }
+}
+Module::Module(Configuration& config, std::vector<std::shared_ptr<Detector>> detectors)
+    : config_(config), detectors_(std::move(detectors)) {}
 /**
  * @note The remove_delegate can throw in theory, but this should never happen in practice
  */
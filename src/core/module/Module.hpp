@@ -14,6 +14,7 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <list>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -23,6 +24,8 @@
 #include <TDirectory.h>
 
 #include "ModuleIdentifier.hpp"
+#include "Observable.hpp"
+#include "Profiler.hpp"
 #include "core/config/ConfigManager.hpp"
 #include "core/config/Configuration.hpp"
 #include "core/geometry/Detector.hpp"
@@ -69,6 +72,15 @@ namespace allpix {
          *          \ref InvalidModuleStateException will be raised if the module failed to so.
          */
         explicit Module(Configuration& config, std::shared_ptr<Detector> detector);
+        /**
+         * @brief Base constructor for detector modules running in multi-detector mode
+         * @param config Configuration for this module
+         * @param detectors All detectors bound to this single module instance
+         *
+         * A single instance of such modules receives the messages of all its detectors in every event, see
+         * \ref getDetectors().
+         */
+        explicit Module(Configuration& config, std::vector<std::shared_ptr<Detector>> detectors);
         /**
          * @brief Essential virtual destructor.
          *
@@ -100,6 +112,15 @@ namespace allpix {
          */
         std::shared_ptr<Detector> getDetector() const { return detector_; }
 
+        /**
+         * @brief Get all detectors linked to this module
+         * @return List of linked detectors, empty for unique modules
+         *
+         * Detector modules are linked to their single detector, while detector modules in multi-detector mode are linked to
+         * all detectors they have been instantiated for and return a null pointer from \ref getDetector().
+         */
+        const std::vector<std::shared_ptr<Detector>>& getDetectors() const { return detectors_; }
+
         /**
          * @brief Get the unique name of this module
          * @return Unique name
@@ -132,12 +153,36 @@ namespace allpix {
          */
         ConfigManager* getConfigManager() const;
 
+        /**
+         * @brief Get the profiler to register and fill counters and timers included in the performance report
+         * @return Reference to the profiler of this instantiation
+         */
+        Profiler& getProfiler() { return profiler_; }
+
+        /**
+         * @brief Get the observables of this instantiation monitored for the convergence of the run
+         * @return List of the registered observables
+         */
+        const std::list<Observable>& getObservables() const { return observables_; }
+
         /**
          * @brief Returns if multithreading of this module is enabled
          * @return True if multithreading is enabled, false otherwise (the default)
          */
         bool multithreadingEnabled() const { return multithreading_; }
 
+        /**
+         * @brief Returns if the module can be initialized concurrently with the modules of other detectors
+         * @return True if parallel initialization is allowed, false otherwise (the default)
+         */
+        bool parallelInitializationAllowed() const { return parallel_initialization_; }
+
+        /**
+         * @brief Returns if the module runs for events rejected by an earlier module
+         * @return True if rejected events are processed, false otherwise (the default)
+         */
+        bool rejectedEventsProcessed() const { return process_rejected_events_; }
+
         /**
          * @brief Initialize the module for each thread after the global initialization
          * @note Useful to prepare thread local objects
@@ -183,6 +228,30 @@ namespace allpix {
          */
         void allow_multithreading() { set_multithreading(true); }
 
+        /**
+         * @brief Allow the initialization of this module concurrently with the initialization of modules of other detectors
+         * @note Only to be used if the initialization exclusively changes the state of this module and its detector, and
+         * does not create any ROOT objects
+         */
+        void allow_parallel_initialization() { parallel_initialization_ = true; }
+
+        /**
+         * @brief Continue running this module for events rejected by an earlier module, see \ref Event::reject
+         * @note Intended for output modules which should store the data produced until the rejection
+         */
+        void process_rejected_events() { process_rejected_events_ = true; }
+
+        /**
+         * @brief Register an observable which is monitored for the convergence of the run, see \ref Observable
+         * @param name Name of the observable
+         * @param type Property of the samples estimated by the observable
+         * @return Reference to the observable to add the samples to, valid for the lifetime of the module
+         * @note Should be called in the constructor or the initialization of the module
+         */
+        Observable& register_observable(std::string name, Observable::Type type = Observable::Type::MEAN) {
+            return observables_.emplace_back(std::move(name), type);
+        }
+
         /**
          * @brief Get the module configuration for internal use
          * @return Configuration of the module
@@ -239,12 +308,18 @@ namespace allpix {
         std::vector<std::pair<Messenger*, BaseDelegate*>> delegates_;
 
         std::shared_ptr<Detector> detector_;
+        std::vector<std::shared_ptr<Detector>> detectors_;
+
+        Profiler profiler_;
+        std::list<Observable> observables_;
 
         /**
          * @brief Sets the multithreading flag
          */
         void set_multithreading(bool multithreading) { multithreading_ = multithreading; }
         bool multithreading_{false};
+        bool parallel_initialization_{false};
+        bool process_rejected_events_{false};
 
         /**
          * @brief Checks if object is instance of SequentialModule class
@@ -265,6 +340,8 @@ namespace allpix {
         explicit SequentialModule(Configuration& config) : Module(config) {}
         explicit SequentialModule(Configuration& config, std::shared_ptr<Detector> detector)
             : Module(config, std::move(detector)) {}
+        explicit SequentialModule(Configuration& config, std::vector<std::shared_ptr<Detector>> detectors)
+            : Module(config, std::move(detectors)) {}
 
     protected:
         /**
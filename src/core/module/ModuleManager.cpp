@@ -11,19 +11,32 @@
 
 #include "ModuleManager.hpp"
 #include "Event.hpp"
+#include "MemoryAccounting.hpp"
+#include "MetricsExporter.hpp"
+#include "PerformanceCounters.hpp"
+#include "Tracer.hpp"
 
 #include <dlfcn.h>
 #include <unistd.h>
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <exception>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <limits>
+#include <numeric>
 #include <set>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <tuple>
 
 #include <TROOT.h>
 #include <TSystem.h>
@@ -34,6 +47,9 @@
 #include "core/geometry/GeometryManager.hpp"
 #include "core/messenger/Messenger.hpp"
 #include "core/utils/log.h"
+#include "core/utils/numa.h"
+#include "core/utils/type.h"
+#include "objects/Object.hpp"
 
 // Common prefix for all modules
 // TODO [doc] Should be provided by the build system
@@ -42,16 +58,143 @@
 // These should point to the function defined in dynamic_module_impl.cpp
 #define ALLPIX_GENERATOR_FUNCTION "allpix_module_generator"
 #define ALLPIX_UNIQUE_FUNCTION "allpix_module_is_unique"
+#define ALLPIX_MULTI_GENERATOR_FUNCTION "allpix_module_multi_generator"
 
 using namespace allpix;
 
 ModuleManager::ModuleManager() : terminate_(false) {}
 
+/**
+ * The key hashes everything the messages of the cached modules depend on: the framework version, the random number
+ * generation, the range of events, the detector setup and the configurations of all sections preceding the cache module.
+ * Log settings and internal parameters are left out. Files referenced by the configurations are only included by name.
+ */
+static std::string stage_cache_key(const Configuration& global_config,
+                                   const std::list<Configuration>& detector_configs,
+                                   const std::list<Configuration>& module_configs,
+                                   size_t sections) {
+    // 64-bit FNV-1a hash, every string is terminated to keep the boundaries between keys and values
+    uint64_t hash = 0xcbf29ce484222325;
+    auto add = [&hash](const std::string& text) {
+        for(auto character : text) {
+            hash ^= static_cast<unsigned char>(character);
+            hash *= 0x100000001b3;
+        }
+        hash ^= 0xff;
+        hash *= 0x100000001b3;
+    };
+    auto add_config = [&add](const Configuration& config) {
+        add(config.getName());
+        for(const auto& [key, value] : config.getAll()) {
+            if(key.front() == '_' || key == "log_level" || key == "log_format") {
+                continue;
+            }
+            add(key);
+            add(value);
+        }
+    };
+
+    for(const auto* key :
+        {"version", "random_engine", "random_seed", "random_seed_core", "number_of_events", "skip_events"}) {
+        add(key);
+        add(global_config.getText(key, ""));
+    }
+    for(const auto& config : detector_configs) {
+        add_config(config);
+    }
+    auto end = std::next(module_configs.begin(), static_cast<std::ptrdiff_t>(sections));
+    for(auto config = module_configs.begin(); config != end; ++config) {
+        add_config(*config);
+    }
+
+    std::stringstream key;
+    key << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return key.str();
+}
+
+/**
+ * Every section with branch values is replaced by one section per branch, each setting the branch parameters to the values
+ * of its branch and writing to its own output. All branches receive the same messages of the preceding modules.
+ */
+static void expand_branches(std::list<Configuration>& configs) {
+    for(auto config = configs.begin(); config != configs.end();) {
+        if(!config->has("branch_values") || config->has("_branch")) {
+            ++config;
+            continue;
+        }
+
+        auto parameters = config->getArray<std::string>("branch_parameter");
+        if(parameters.empty()) {
+            throw InvalidValueError(*config, "branch_parameter", "list of parameters should not be empty");
+        }
+        Matrix<std::string> values;
+        if(parameters.size() == 1) {
+            for(auto& value : config->getArray<std::string>("branch_values")) {
+                values.push_back({std::move(value)});
+            }
+        } else {
+            values = config->getMatrix<std::string>("branch_values");
+        }
+        if(values.empty()) {
+            throw InvalidValueError(*config, "branch_values", "list of values should not be empty");
+        }
+        auto output = config->get<std::string>("output", "");
+        if(output.empty()) {
+            output = "branch";
+        }
+
+        for(size_t branch = 0; branch < values.size(); ++branch) {
+            if(values[branch].size() != parameters.size()) {
+                throw InvalidValueError(*config,
+                                        "branch_values",
+                                        "branch " + std::to_string(branch) + " should provide " +
+                                            std::to_string(parameters.size()) + " values");
+            }
+            auto& copy = *configs.insert(config, *config);
+            for(size_t parameter = 0; parameter < parameters.size(); ++parameter) {
+                copy.setText(parameters[parameter], values[branch][parameter]);
+            }
+            copy.set<std::string>("output", output + std::to_string(branch));
+            copy.set<size_t>("_branch", branch);
+        }
+        std::string names;
+        for(const auto& parameter : parameters) {
+            names += (names.empty() ? "" : ", ") + parameter;
+        }
+        LOG(STATUS) << "Creating " << values.size() << " branches of " << config->getName() << " with different values of "
+                    << names;
+        config = configs.erase(config);
+    }
+}
+
+/**
+ * The random number stream of a branch is derived from the unique name of its module instance, which contains the name of
+ * the branch output, with a 64-bit FNV-1a hash. This keeps the streams independent between the branches and detectors.
+ */
+static uint64_t hash_branch_stream(const std::string& name) {
+    uint64_t hash = 0xcbf29ce484222325;
+    for(auto character : name) {
+        hash ^= static_cast<unsigned char>(character);
+        hash *= 0x100000001b3;
+    }
+    // Stream one is used by the stage cache
+    return std::max<uint64_t>(hash, 2);
+}
+
+/**
+ * Phases recorded before the modules are loaded are reported together with the phases of the module manager.
+ */
+void ModuleManager::recordStartupPhase(std::string name, uint64_t duration) {
+    startup_phases_.emplace_back(std::move(name), duration);
+}
+
 /**
  * Loads the modules specified in the configuration file. Each module is contained within its own library which is loaded
  * automatically. After that the required modules are created from the configuration.
  */
-void ModuleManager::load(Messenger* messenger, ConfigManager* conf_manager, GeometryManager* geo_manager) {
+void ModuleManager::load(Messenger* messenger, ConfigManager* conf_manager, GeometryManager* geo_manager, bool service) {
+    auto start_time = std::chrono::steady_clock::now();
+
     // Store config manager and get configurations
     conf_manager_ = conf_manager;
     auto& configs = conf_manager_->getModuleConfigurations();
@@ -61,11 +204,138 @@ void ModuleManager::load(Messenger* messenger, ConfigManager* conf_manager, Geom
     global_config.setDefault("multithreading", true);
     multithreading_flag_ = global_config.get<bool>("multithreading");
 
+    // Initialize the modules of different detectors concurrently where the modules allow it
+    global_config.setDefault("parallel_initialization", multithreading_flag_);
+    parallel_initialization_ = global_config.get<bool>("parallel_initialization");
+
+    // Process the modules of different detectors concurrently within each event
+    global_config.setDefault("parallel_detectors", false);
+    parallel_detectors_ = global_config.get<bool>("parallel_detectors");
+
     // Set default for performance plot creation:
     global_config.setDefault("performance_plots", false);
+    global_config.setDefault("performance_report", false);
+    global_config.setDefault("performance_trace", false);
+    global_config.setDefault("performance_memory", false);
+    global_config.setDefault("performance_counters", false);
+    global_config.setDefault("performance_dataflow", false);
+
+    // Set the pseudo-random number engine used for the events
+    global_config.setDefault("random_engine", RandomNumberGenerator::Engine::MT19937_64);
+    random_engine_ = global_config.get<RandomNumberGenerator::Engine>("random_engine");
+    LOG(DEBUG) << "Using pseudo-random number engine " << global_config.get<std::string>("random_engine") << " for events";
+
+    // Set the depth of the history recorded in the objects created by the modules
+    global_config.setDefault("object_history", Object::HistoryDepth::FULL);
+    Object::setHistoryDepth(global_config.get<Object::HistoryDepth>("object_history"));
+    LOG(DEBUG) << "Recording " << global_config.get<std::string>("object_history") << " object history";
+
+    // Limit the number of copies held by the histograms of the modules to bound their memory for many threads
+    global_config.setDefault("histogram_copies", 0u);
+    histogram_copies() = global_config.get<unsigned int>("histogram_copies");
+    if(histogram_copies() > 0) {
+        LOG(DEBUG) << "Limiting histograms to " << histogram_copies() << " copies shared between the threads";
+    }
 
-    // Store the messenger
+    // Store the messenger and the geometry manager to create the modules
     messenger_ = messenger;
+    geo_manager_ = geo_manager;
+
+    // Replace the sections with branch values by one section per branch before the sections are counted
+    expand_branches(configs);
+
+    // Repeat the run for every value of a module parameter. The sections starting from the first section of the swept
+    // module are created again for every sweep point, while all preceding modules keep their state.
+    if(global_config.has("sweep_values")) {
+        sweep_module_ = global_config.get<std::string>("sweep_module");
+        sweep_parameter_ = global_config.get<std::string>("sweep_parameter");
+        sweep_values_ = global_config.getArray<std::string>("sweep_values");
+        if(sweep_values_.empty()) {
+            throw InvalidValueError(global_config, "sweep_values", "list of values should not be empty");
+        }
+        auto swept_config = std::find_if(configs.begin(), configs.end(), [this](const Configuration& config) {
+            return config.getName() == sweep_module_;
+        });
+        if(swept_config == configs.end()) {
+            throw InvalidValueError(global_config, "sweep_module", "module is not part of the configuration");
+        }
+        sweep_section_ = static_cast<size_t>(std::distance(configs.begin(), swept_config));
+        LOG(STATUS) << "Sweeping parameter " << sweep_parameter_ << " of " << sweep_module_ << " over "
+                    << sweep_values_.size() << " values";
+        point_name_ = "sweep_0";
+        point_directory_ = std::filesystem::path(gSystem->pwd()) / point_name_;
+        apply_sweep_value();
+    }
+
+    // A simulation service creates the sections starting from the first section of the server module for every request,
+    // while all preceding modules are kept initialized across the requests. Runs with checkpoints do the same for every
+    // segment of events starting from the checkpoint module.
+    global_config.setDefault<uint64_t>("checkpoint_interval", 0);
+    checkpoints_ = !service && global_config.get<uint64_t>("checkpoint_interval") > 0;
+    if(service || checkpoints_) {
+        const std::string key = (service ? "server_module" : "checkpoint_module");
+        if(!sweep_values_.empty()) {
+            throw InvalidCombinationError(
+                global_config, {"sweep_values", key}, "a parameter sweep cannot be combined with recreated modules");
+        }
+        auto server_module = global_config.get<std::string>(key);
+        auto server_config = std::find_if(configs.begin(), configs.end(), [&server_module](const Configuration& config) {
+            return config.getName() == server_module;
+        });
+        if(server_config == configs.end()) {
+            throw InvalidValueError(global_config, key, "module is not part of the configuration");
+        }
+        sweep_section_ = static_cast<size_t>(std::distance(configs.begin(), server_config));
+        LOG(STATUS) << "Creating the modules starting from " << server_module << " for every "
+                    << (service ? "request" : "checkpoint");
+    }
+    if(checkpoints_ && global_config.get<double>("convergence_precision", 0) > 0) {
+        throw InvalidCombinationError(global_config,
+                                      {"checkpoint_interval", "convergence_precision"},
+                                      "the convergence of the observables cannot be checked across checkpoints");
+    }
+
+    // Memoize the modules preceding the cache module: their messages are either stored in the stage cache by an additional
+    // ROOTObjectWriter or, if the cache already holds them, replayed by a ROOTObjectReader instead of running these modules
+    if(global_config.has("cache_module")) {
+        if(!sweep_values_.empty() || service || checkpoints_) {
+            throw InvalidCombinationError(
+                global_config,
+                {"cache_module", service ? "server_module" : (checkpoints_ ? "checkpoint_module" : "sweep_values")},
+                "the stage cache cannot be combined with recreated modules");
+        }
+        auto cache_module = global_config.get<std::string>("cache_module");
+        auto cache_config = std::find_if(configs.begin(), configs.end(), [&cache_module](const Configuration& config) {
+            return config.getName() == cache_module;
+        });
+        if(cache_config == configs.end()) {
+            throw InvalidValueError(global_config, "cache_module", "module is not part of the configuration");
+        }
+        if(cache_config == configs.begin()) {
+            throw InvalidValueError(global_config, "cache_module", "no module precedes the first module to run");
+        }
+        cache_section_ = static_cast<size_t>(std::distance(configs.begin(), cache_config));
+
+        auto cache_directory = std::filesystem::path(gSystem->pwd()) / "stage_cache";
+        if(global_config.has("cache_directory")) {
+            cache_directory = global_config.getPath("cache_directory");
+        }
+        auto key = stage_cache_key(global_config, conf_manager_->getDetectorConfigurations(), configs, cache_section_);
+        cache_file_ = cache_directory / (key + ".root");
+        cache_hit_ = std::filesystem::is_regular_file(cache_file_);
+
+        // The cache instantiation is named separately, such that it does not collide with configured instantiations
+        cache_config_ = Configuration(cache_hit_ ? "ROOTObjectReader" : "ROOTObjectWriter", global_config.getFilePath());
+        cache_config_->set<std::string>("output", "stage_cache");
+        if(cache_hit_) {
+            cache_config_->set<std::string>("file_name", cache_file_.string());
+            LOG(STATUS) << "Replaying the modules preceding " << cache_module << " from stage cache " << cache_file_;
+        } else {
+            cache_config_->set<std::string>("file_name", "partial_" + key);
+            LOG(STATUS) << "Storing the output of the modules preceding " << cache_module << " in stage cache "
+                        << cache_file_;
+        }
+    }
 
     // (Re)create the main ROOT file
     auto path = std::filesystem::path(gSystem->pwd()) / global_config.get<std::string>("root_file", "modules");
@@ -84,193 +354,240 @@ void ModuleManager::load(Messenger* messenger, ConfigManager* conf_manager, Geom
     }
     modules_file_->cd();
 
-    // Loop through all non-global configurations
+    // Loop through all non-global configurations, the sections of a simulation service are created with every request
+    size_t section = 0;
     for(auto& config : configs) {
-        // Load library for each module. Libraries are named (by convention + CMAKE) libAllpixModule Name.suffix
-        std::string lib_name = std::string(ALLPIX_MODULE_PREFIX).append(config.getName()).append(SHARED_LIBRARY_SUFFIX);
-        LOG_PROGRESS(STATUS, "LOAD_LOOP") << "Loading module " << config.getName();
-
-        void* lib = nullptr;
-        bool load_error = false;
-        dlerror();
-        if(loaded_libraries_.count(lib_name) == 0) {
-            // If library is not loaded then try to load it first from the config directories
-            if(global_config.has("library_directories")) {
-                LOG(TRACE) << "Attempting to load library from configured paths";
-                auto lib_paths = global_config.getPathArray("library_directories", true);
-                for(const auto& lib_path : lib_paths) {
-                    auto full_lib_path = lib_path;
-                    full_lib_path /= lib_name;
-                    LOG(TRACE) << "Searching in path " << full_lib_path;
-
-                    // Check if the absolute file exists and try to load if it exists
-                    std::ifstream check_file(full_lib_path);
-                    if(check_file.good()) {
-                        lib = dlopen(full_lib_path.c_str(), RTLD_NOW);
-                        if(lib != nullptr) {
-                            LOG(DEBUG) << "Found library in configuration specified directory at " << full_lib_path;
-                        } else {
-                            load_error = true;
-                        }
-                        break;
-                    }
-                }
-            }
+        if((service || checkpoints_) && section >= sweep_section_) {
+            break;
+        }
+        if(section == cache_section_) {
+            auto kept_modules = modules_.size();
+            load_section(cache_config_.value(), section);
+            cache_stage_ = std::next(modules_.begin(), static_cast<std::ptrdiff_t>(kept_modules))->get();
+        }
+        load_section(config, section++);
+    }
 
-            // Otherwise try to load from the standard paths if not found already
-            if(!load_error && lib == nullptr) {
-                lib = dlopen(lib_name.c_str(), RTLD_NOW);
+    // Force MT off for all modules in case MT was not requested or some modules didn't enable multithreading
+    if(!(multithreading_flag_ && can_parallelize_)) {
+        for(auto& module : modules_) {
+            module->set_multithreading(false);
+        }
+    }
+    LOG_PROGRESS(STATUS, "LOAD_LOOP") << "Loaded " << section << " modules";
+
+    // Split the loading time into the time spent in the dynamic loader and the construction of the modules
+    auto end_time = std::chrono::steady_clock::now();
+    auto load_time =
+        static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count());
+    auto library_time = std::accumulate(library_load_time_.begin(),
+                                        library_load_time_.end(),
+                                        uint64_t(0),
+                                        [](uint64_t sum, const auto& library) { return sum + library.second; });
+    startup_phases_.emplace_back("module libraries", library_time);
+    startup_phases_.emplace_back("module construction", load_time - std::min(library_time, load_time));
+}
 
-                if(lib != nullptr) {
-                    Dl_info dl_info;
-                    dl_info.dli_fname = "";
+/**
+ * Loads the library of the module if not loaded yet and creates the instantiations of the section. Instantiations replacing
+ * existing instantiations of lower priority remove these from the run list.
+ */
+void ModuleManager::load_section(Configuration& config, size_t section) {
+    Configuration& global_config = conf_manager_->getGlobalConfiguration();
 
-                    // workaround to get the location of the library
-                    int ret = dladdr(dlsym(lib, ALLPIX_UNIQUE_FUNCTION), &dl_info);
-                    if(ret != 0) {
-                        LOG(DEBUG) << "Found library during global search in runtime paths at " << dl_info.dli_fname;
+    // Load library for each module. Libraries are named (by convention + CMAKE) libAllpixModule Name.suffix
+    std::string lib_name = std::string(ALLPIX_MODULE_PREFIX).append(config.getName()).append(SHARED_LIBRARY_SUFFIX);
+    LOG_PROGRESS(STATUS, "LOAD_LOOP") << "Loading module " << config.getName();
+
+    void* lib = nullptr;
+    bool load_error = false;
+    dlerror();
+    auto library_start = std::chrono::steady_clock::now();
+    if(loaded_libraries_.count(lib_name) == 0) {
+        // If library is not loaded then try to load it first from the config directories
+        if(global_config.has("library_directories")) {
+            LOG(TRACE) << "Attempting to load library from configured paths";
+            auto lib_paths = global_config.getPathArray("library_directories", true);
+            for(const auto& lib_path : lib_paths) {
+                auto full_lib_path = lib_path;
+                full_lib_path /= lib_name;
+                LOG(TRACE) << "Searching in path " << full_lib_path;
+
+                // Check if the absolute file exists and try to load if it exists
+                std::ifstream check_file(full_lib_path);
+                if(check_file.good()) {
+                    lib = dlopen(full_lib_path.c_str(), RTLD_NOW);
+                    if(lib != nullptr) {
+                        LOG(DEBUG) << "Found library in configuration specified directory at " << full_lib_path;
                     } else {
-                        LOG(WARNING)
-                            << "Found library during global search but could not deduce location, likely broken library";
+                        load_error = true;
                     }
-                } else {
-                    load_error = true;
+                    break;
                 }
             }
-        } else {
-            // Otherwise just fetch it from the cache
-            lib = loaded_libraries_[lib_name];
         }
 
-        // If library did not load then throw exception
-        if(load_error) {
-            const char* lib_error = dlerror();
+        // Otherwise try to load from the standard paths if not found already
+        if(!load_error && lib == nullptr) {
+            lib = dlopen(lib_name.c_str(), RTLD_NOW);
 
-            // Find the name of the loaded library if it exists
-            std::string lib_error_str = lib_error;
-            size_t end_pos = lib_error_str.find(':');
-            std::string problem_lib;
-            if(end_pos != std::string::npos) {
-                problem_lib = lib_error_str.substr(0, end_pos);
-            }
+            if(lib != nullptr) {
+                Dl_info dl_info;
+                dl_info.dli_fname = "";
 
-            // FIXME is checking the error in this way portable?
-            if(lib_error != nullptr && std::strstr(lib_error, "cannot allocate memory in static TLS block") != nullptr) {
-                LOG(ERROR) << "Library could not be loaded: not enough thread local storage available" << std::endl
-                           << "Try one of below workarounds:" << std::endl
-                           << "- Rerun library with the environmental variable LD_PRELOAD='" << problem_lib << "'"
-                           << std::endl
-                           << "- Recompile the library " << problem_lib << " with tls-model=global-dynamic";
-            } else if(lib_error != nullptr && std::strstr(lib_error, "cannot open shared object file") != nullptr &&
-                      problem_lib.find(ALLPIX_MODULE_PREFIX) == std::string::npos) {
-                LOG(ERROR) << "Library could not be loaded: one of its dependencies is missing" << std::endl
-                           << "The name of the missing library is " << problem_lib << std::endl
-                           << "Please make sure the library is properly initialized and try again";
-            } else if(lib_error != nullptr && std::strstr(lib_error, "undefined symbol") != nullptr) {
-                LOG(ERROR) << "Library could not be loaded: library version does not match framework (undefined symbols)"
-                           << std::endl
-                           << "The name of the problematic library is " << problem_lib << std::endl
-                           << "Please make sure the library is compiled against the correct framework version";
-            } else {
-                LOG(ERROR) << "Library could not be loaded: it is not available" << std::endl
-                           << " - Did you enable the library during building? " << std::endl
-                           << " - Did you spell the library name correctly (case-sensitive)? ";
-                if(lib_error != nullptr) {
-                    LOG(DEBUG) << "Detailed error: " << lib_error;
+                // workaround to get the location of the library
+                int ret = dladdr(dlsym(lib, ALLPIX_UNIQUE_FUNCTION), &dl_info);
+                if(ret != 0) {
+                    LOG(DEBUG) << "Found library during global search in runtime paths at " << dl_info.dli_fname;
+                } else {
+                    LOG(WARNING)
+                        << "Found library during global search but could not deduce location, likely broken library";
                 }
+            } else {
+                load_error = true;
             }
-
-            throw allpix::DynamicLibraryError(config.getName());
         }
-        // Remember that this library was loaded
-        loaded_libraries_[lib_name] = lib;
+    } else {
+        // Otherwise just fetch it from the cache
+        lib = loaded_libraries_[lib_name];
+    }
+
+    // If library did not load then throw exception
+    if(load_error) {
+        const char* lib_error = dlerror();
 
-        // Check if this module is produced once, or once per detector
-        bool unique = true;
-        void* uniqueFunction = dlsym(loaded_libraries_[lib_name], ALLPIX_UNIQUE_FUNCTION);
+        // Find the name of the loaded library if it exists
+        std::string lib_error_str = lib_error;
+        size_t end_pos = lib_error_str.find(':');
+        std::string problem_lib;
+        if(end_pos != std::string::npos) {
+            problem_lib = lib_error_str.substr(0, end_pos);
+        }
 
-        // If the unique function was not found, throw an error
-        if(uniqueFunction == nullptr) {
-            LOG(ERROR) << "Module library is invalid or outdated: required interface function not found!";
-            throw allpix::DynamicLibraryError(config.getName());
+        // FIXME is checking the error in this way portable?
+        if(lib_error != nullptr && std::strstr(lib_error, "cannot allocate memory in static TLS block") != nullptr) {
+            LOG(ERROR) << "Library could not be loaded: not enough thread local storage available" << std::endl
+                       << "Try one of below workarounds:" << std::endl
+                       << "- Rerun library with the environmental variable LD_PRELOAD='" << problem_lib << "'"
+                       << std::endl
+                       << "- Recompile the library " << problem_lib << " with tls-model=global-dynamic";
+        } else if(lib_error != nullptr && std::strstr(lib_error, "cannot open shared object file") != nullptr &&
+                  problem_lib.find(ALLPIX_MODULE_PREFIX) == std::string::npos) {
+            LOG(ERROR) << "Library could not be loaded: one of its dependencies is missing" << std::endl
+                       << "The name of the missing library is " << problem_lib << std::endl
+                       << "Please make sure the library is properly initialized and try again";
+        } else if(lib_error != nullptr && std::strstr(lib_error, "undefined symbol") != nullptr) {
+            LOG(ERROR) << "Library could not be loaded: library version does not match framework (undefined symbols)"
+                       << std::endl
+                       << "The name of the problematic library is " << problem_lib << std::endl
+                       << "Please make sure the library is compiled against the correct framework version";
         } else {
-            unique = reinterpret_cast<bool (*)()>(uniqueFunction)(); // NOLINT
+            LOG(ERROR) << "Library could not be loaded: it is not available" << std::endl
+                       << " - Did you enable the library during building? " << std::endl
+                       << " - Did you spell the library name correctly (case-sensitive)? ";
+            if(lib_error != nullptr) {
+                LOG(DEBUG) << "Detailed error: " << lib_error;
+            }
         }
 
-        // Add the global internal parameters to the configuration
-        std::string global_dir = gSystem->pwd();
-        config.set<std::string>("_global_dir", global_dir);
+        throw allpix::DynamicLibraryError(config.getName());
+    }
+    // Remember that this library was loaded and how long it took to load it
+    if(loaded_libraries_.count(lib_name) == 0) {
+        auto library_end = std::chrono::steady_clock::now();
+        library_load_time_[config.getName()] = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(library_end - library_start).count());
+    }
+    loaded_libraries_[lib_name] = lib;
 
-        // Set default input and output name
-        config.setDefault<std::string>("input", "");
-        config.setDefault<std::string>("output", "");
+    // Check if this module is produced once, or once per detector
+    bool unique = true;
+    void* uniqueFunction = dlsym(loaded_libraries_[lib_name], ALLPIX_UNIQUE_FUNCTION);
 
-        // Create the modules from the library depending on the module type
-        std::vector<std::pair<ModuleIdentifier, Module*>> mod_list;
-        if(unique) {
-            mod_list.emplace_back(create_unique_modules(loaded_libraries_[lib_name], config, messenger, geo_manager));
-        } else {
-            mod_list = create_detector_modules(loaded_libraries_[lib_name], config, messenger, geo_manager);
-        }
+    // If the unique function was not found, throw an error
+    if(uniqueFunction == nullptr) {
+        LOG(ERROR) << "Module library is invalid or outdated: required interface function not found!";
+        throw allpix::DynamicLibraryError(config.getName());
+    } else {
+        unique = reinterpret_cast<bool (*)()>(uniqueFunction)(); // NOLINT
+    }
 
-        // Loop through all created instantiations
-        for(auto& id_mod : mod_list) {
-            // FIXME: This convert the module to an unique pointer. Check that this always works and we can do this earlier
-            std::unique_ptr<Module> mod(id_mod.second);
-            ModuleIdentifier identifier = id_mod.first;
+    // Add the global internal parameters to the configuration, the sections of a parameter sweep write to the point
+    std::filesystem::path global_dir = gSystem->pwd();
+    if(section >= sweep_section_) {
+        global_dir = point_directory_;
+        std::filesystem::create_directories(global_dir);
+    }
+    if(cache_config_.has_value() && &config == &cache_config_.value()) {
+        global_dir = cache_file_.parent_path();
+        std::filesystem::create_directories(global_dir);
+    }
+    config.set<std::string>("_global_dir", global_dir.string());
 
-            // Check if the unique instantiation already exists
-            auto iter = std::find_if(id_to_module_.begin(), id_to_module_.end(), [&identifier](const auto& mapv) {
-                return identifier.getUniqueName() == mapv.first.getUniqueName();
-            });
-            if(iter != id_to_module_.end()) {
-                // Unique name exists, check if its needs to be replaced
-                if(identifier.getPriority() < iter->first.getPriority()) {
-                    // Priority of new instance is higher, replace the instance
-                    LOG(TRACE) << "Replacing model instance " << iter->first.getUniqueName()
-                               << " with instance with higher priority.";
-
-                    // Drop configuration from replaced module
-                    conf_manager_->dropInstanceConfiguration(iter->first);
-
-                    module_execution_time_.erase(iter->second->get());
-                    iter->second = modules_.erase(iter->second);
-                    iter = id_to_module_.erase(iter);
-                } else {
-                    // Priority is equal, raise an error
-                    if(identifier.getPriority() == iter->first.getPriority()) {
-                        throw AmbiguousInstantiationError(config.getName());
-                    }
-                    // Priority is lower, do not add this module to the run list, drop config
-                    conf_manager_->dropInstanceConfiguration(identifier);
-                    module_execution_time_.erase(id_mod.second);
-                    continue;
-                }
-            }
+    // Set default input and output name
+    config.setDefault<std::string>("input", "");
+    config.setDefault<std::string>("output", "");
 
-            // Save the identifier in the module
-            mod->set_identifier(identifier);
+    // Create the modules from the library depending on the module type
+    std::vector<std::pair<ModuleIdentifier, Module*>> mod_list;
+    if(unique) {
+        mod_list.emplace_back(create_unique_modules(loaded_libraries_[lib_name], config, messenger_, geo_manager_));
+    } else {
+        mod_list = create_detector_modules(loaded_libraries_[lib_name], config, messenger_, geo_manager_);
+    }
 
-            // Check if module can't run in parallel
-            auto module_can_parallelize = mod->multithreadingEnabled();
-            if(multithreading_flag_ && !module_can_parallelize) {
-                LOG(WARNING) << "Module instance " << mod->getUniqueName() << " prevents multithreading";
+    // Loop through all created instantiations
+    for(auto& id_mod : mod_list) {
+        // FIXME: This convert the module to an unique pointer. Check that this always works and we can do this earlier
+        std::unique_ptr<Module> mod(id_mod.second);
+        ModuleIdentifier identifier = id_mod.first;
+
+        // Check if the unique instantiation already exists
+        auto iter = std::find_if(id_to_module_.begin(), id_to_module_.end(), [&identifier](const auto& mapv) {
+            return identifier.getUniqueName() == mapv.first.getUniqueName();
+        });
+        if(iter != id_to_module_.end()) {
+            // Unique name exists, check if its needs to be replaced
+            if(identifier.getPriority() < iter->first.getPriority()) {
+                // Priority of new instance is higher, replace the instance
+                LOG(TRACE) << "Replacing model instance " << iter->first.getUniqueName()
+                           << " with instance with higher priority.";
+
+                // Drop configuration from replaced module
+                conf_manager_->dropInstanceConfiguration(iter->first);
+
+                module_execution_time_.erase(iter->second->get());
+                module_section_.erase(iter->second->get());
+                iter->second = modules_.erase(iter->second);
+                iter = id_to_module_.erase(iter);
+            } else {
+                // Priority is equal, raise an error
+                if(identifier.getPriority() == iter->first.getPriority()) {
+                    throw AmbiguousInstantiationError(config.getName());
+                }
+                // Priority is lower, do not add this module to the run list, drop config
+                conf_manager_->dropInstanceConfiguration(identifier);
+                module_execution_time_.erase(id_mod.second);
+                continue;
             }
-            can_parallelize_ = module_can_parallelize && can_parallelize_;
-
-            // Add the new module to the run list
-            modules_.emplace_back(std::move(mod));
-            id_to_module_[identifier] = --modules_.end();
         }
-    }
 
-    // Force MT off for all modules in case MT was not requested or some modules didn't enable multithreading
-    if(!(multithreading_flag_ && can_parallelize_)) {
-        for(auto& module : modules_) {
-            module->set_multithreading(false);
+        // Save the identifier in the module
+        mod->set_identifier(identifier);
+
+        // Check if module can't run in parallel
+        auto module_can_parallelize = mod->multithreadingEnabled();
+        if(multithreading_flag_ && !module_can_parallelize) {
+            LOG(WARNING) << "Module instance " << mod->getUniqueName() << " prevents multithreading";
         }
+        can_parallelize_ = module_can_parallelize && can_parallelize_;
+
+        // Add the new module to the run list
+        module_section_[mod.get()] = section;
+        modules_.emplace_back(std::move(mod));
+        id_to_module_[identifier] = --modules_.end();
     }
-    LOG_PROGRESS(STATUS, "LOAD_LOOP") << "Loaded " << configs.size() << " modules";
+
 }
 
 /**
@@ -285,6 +602,21 @@ add_instance_configuration(ConfigManager* config_manager, const ModuleIdentifier
     }
 }
 
+/**
+ * Returns the priority with which a section of a detector module selects the given detector, or -1 if it does not select it
+ */
+static int selection_priority(const Configuration& config, const Detector& detector) {
+    auto names = config.getArray<std::string>("name", {});
+    auto types = config.getArray<std::string>("type", {});
+    if(std::find(names.begin(), names.end(), detector.getName()) != names.end()) {
+        return 0;
+    }
+    if(std::find(types.begin(), types.end(), detector.getType()) != types.end()) {
+        return 1;
+    }
+    return (names.empty() && types.empty()) ? 2 : -1;
+}
+
 /**
  * For unique modules a single instance is created per section
  */
@@ -437,6 +769,37 @@ std::vector<std::pair<ModuleIdentifier, Module*>> ModuleManager::create_detector
         }
     }
 
+    // Instances in multi-detector mode do not share the unique name of the per-detector instances, the detectors selected
+    // with higher priority by other sections of this module are therefore removed explicitly
+    config.setDefault<bool>("multi_detector", false);
+    auto multi_detector = config.get<bool>("multi_detector");
+    for(auto& other : conf_manager_->getModuleConfigurations()) {
+        if(&other == &config || other.getName() != module_name ||
+           other.get<std::string>("input", "") != config.get<std::string>("input") ||
+           other.get<std::string>("output", "") != config.get<std::string>("output") ||
+           (!multi_detector && !other.get<bool>("multi_detector", false))) {
+            continue;
+        }
+
+        instantiations.erase(std::remove_if(instantiations.begin(),
+                                            instantiations.end(),
+                                            [&](const auto& instance) {
+                                                auto priority = selection_priority(other, *instance.first);
+                                                if(priority == instance.second.getPriority()) {
+                                                    throw AmbiguousInstantiationError(module_name);
+                                                }
+                                                return priority >= 0 && priority < instance.second.getPriority();
+                                            }),
+                             instantiations.end());
+    }
+
+    if(multi_detector) {
+        if(instantiations.empty()) {
+            return {};
+        }
+        return {create_multi_detector_module(library, config, messenger, instantiations, identifier)};
+    }
+
     // Construct instantiations from the list of requests
     std::vector<std::pair<ModuleIdentifier, Module*>> module_list;
     for(auto& instance : instantiations) {
@@ -480,6 +843,80 @@ std::vector<std::pair<ModuleIdentifier, Module*>> ModuleManager::create_detector
     return module_list;
 }
 
+/**
+ * @throws InvalidValueError If the module does not provide a constructor for multiple detectors
+ * @throws InvalidModuleStateException If the module fails to forward the detectors to the base class
+ *
+ * A single instance is created for all detectors selected by the section. Its identifier is built from the selection of the
+ * section instead of the name of a detector.
+ */
+std::pair<ModuleIdentifier, Module*> ModuleManager::create_multi_detector_module(
+    void* library,
+    Configuration& config,
+    Messenger* messenger,
+    const std::vector<std::pair<std::shared_ptr<Detector>, ModuleIdentifier>>& instantiations,
+    const std::string& identifier) {
+    const std::string& module_name = config.getName();
+
+    // Get the generator function for multiple detectors
+    void* generator = dlsym(library, ALLPIX_MULTI_GENERATOR_FUNCTION);
+    if(generator == nullptr) {
+        LOG(ERROR) << "Module library is invalid or outdated: required interface function not found!";
+        throw allpix::DynamicLibraryError(module_name);
+    }
+    auto module_generator =
+        reinterpret_cast<Module* (*)(Configuration&, Messenger*, std::vector<std::shared_ptr<Detector>>)>( // NOLINT
+            generator);
+
+    // Collect the detectors and name the instance after the selection of the section
+    std::vector<std::shared_ptr<Detector>> detectors;
+    int priority = 2;
+    for(const auto& instance : instantiations) {
+        detectors.push_back(instance.first);
+        priority = std::min(priority, instance.second.getPriority());
+    }
+    std::string selection;
+    for(const auto& key : {"name", "type"}) {
+        for(const auto& value : config.getArray<std::string>(key, {})) {
+            selection += (selection.empty() ? "" : "_") + value;
+        }
+    }
+    ModuleIdentifier multi_identifier(module_name, (selection.empty() ? "all" : selection) + identifier, priority);
+    LOG(DEBUG) << "Creating multi-detector instantiation " << multi_identifier.getUniqueName() << " for "
+               << detectors.size() << " detectors";
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Create and add module instance config
+    Configuration& instance_config = add_instance_configuration(conf_manager_, multi_identifier, config);
+    std::filesystem::path output_dir = instance_config.get<std::string>("_global_dir");
+    auto path_mod_name = multi_identifier.getUniqueName();
+    std::replace(path_mod_name.begin(), path_mod_name.end(), ':', '/');
+    output_dir /= path_mod_name;
+
+    // Build module
+    auto old_settings = set_module_before(multi_identifier.getUniqueName(), instance_config, "C:");
+    Module* module = module_generator(instance_config, messenger, detectors);
+    set_module_after(std::move(old_settings));
+    if(module == nullptr) {
+        throw InvalidValueError(
+            config, "multi_detector", "module does not support a single instance for multiple detectors");
+    }
+    auto end = std::chrono::steady_clock::now();
+    module_execution_time_[module] += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+    module->get_configuration().set<std::string>("_output_dir", output_dir);
+
+    // Check if the module called the correct base class constructor
+    if(module->getDetector() != nullptr || module->getDetectors() != detectors) {
+        throw InvalidModuleStateException(
+            "Module " + module_name +
+            " does not call the correct base Module constructor: the provided detectors should be forwarded");
+    }
+
+    return std::make_pair(multi_identifier, module);
+}
+
 // Helper functions to set the module specific log settings if necessary
 std::tuple<LogLevel, LogFormat, std::string, uint64_t> ModuleManager::set_module_before(const std::string& name,
                                                                                         const Configuration& config,
@@ -552,6 +989,28 @@ void ModuleManager::set_module_after(std::tuple<LogLevel, LogFormat, std::string
     Log::setEventNum(std::get<3>(prev));
 }
 
+std::shared_ptr<Event> ModuleManager::create_event(uint64_t event_num, uint64_t seed) {
+    std::unique_ptr<LocalMessenger> local_messenger;
+    {
+        std::lock_guard<std::mutex> lock(local_messenger_pool_mutex_);
+        if(!local_messenger_pool_.empty()) {
+            local_messenger = std::move(local_messenger_pool_.back());
+            local_messenger_pool_.pop_back();
+        }
+    }
+
+    auto* event = new Event(*messenger_, event_num, seed, std::move(local_messenger));
+    return std::shared_ptr<Event>(event, [this](Event* finished_event) {
+        // Release all messages of the event at once and return its local messenger to the pool
+        auto finished_messenger = std::move(finished_event->local_messenger_);
+        delete finished_event;
+        finished_messenger->reset();
+
+        std::lock_guard<std::mutex> lock(local_messenger_pool_mutex_);
+        local_messenger_pool_.push_back(std::move(finished_messenger));
+    });
+}
+
 /**
  * Sets the section header and logging settings before executing the  \ref Module::initialize() function.
  */
@@ -588,6 +1047,25 @@ void ModuleManager::initialize() {
             throw InvalidValueError(global_config, "buffer_per_worker", "buffer per worker should be larger than one");
         }
         LOG(STATUS) << "Allocating a total of " << max_buffer_size_ << " event slots for buffered modules";
+        compress_buffered_events_ = global_config.get<bool>("compress_buffered_events", false);
+        if(compress_buffered_events_) {
+            LOG(STATUS) << "Compressing the payload of events waiting in the buffers of modules";
+        }
+
+        // Select the layout of the event queue, the single shared queue is kept for comparison
+        global_config.setDefault("thread_pool", ThreadPool::QueueLayout::SHARDED);
+        queue_layout_ = global_config.get<ThreadPool::QueueLayout>("thread_pool");
+        LOG(DEBUG) << "Using " << global_config.get<std::string>("thread_pool") << " event queue layout";
+
+        // Pin the workers to the given CPUs, large field grids are then replicated to the NUMA nodes of these CPUs
+        if(global_config.has("worker_cpus")) {
+            auto cpus = global_config.getArray<unsigned int>("worker_cpus");
+            if(cpus.empty()) {
+                throw InvalidValueError(global_config, "worker_cpus", "list of CPUs should not be empty");
+            }
+            NUMA::setWorkerCPUs(cpus);
+            LOG(STATUS) << "Pinning workers to " << cpus.size() << " CPUs on " << NUMA::getNodeCount() << " NUMA nodes";
+        }
     } else {
         // Issue a warning in case MT was requested but we can't actually run in MT
         if(multithreading_flag_ && !can_parallelize_) {
@@ -606,6 +1084,30 @@ void ModuleManager::initialize() {
         ThreadPool::registerThreadCount(number_of_threads_);
     }
 
+    // Record the timeline of the event loop, keeping the given number of records per thread
+    if(global_config.get<bool>("performance_trace")) {
+        Tracer::enable(global_config.get<size_t>("performance_trace_size", 65536));
+        trace_buffered_ = Tracer::registerName("event buffered for sequence");
+        trace_rescheduled_ = Tracer::registerName("event rescheduled");
+        trace_queued_events_ = Tracer::registerName("queued events");
+        trace_buffered_events_ = Tracer::registerName("buffered events");
+    }
+
+    // Count the memory allocated by the modules in the event loop
+    if(global_config.get<bool>("performance_memory") && !MemoryAccounting::enable()) {
+        LOG(WARNING) << "Accounting of memory allocations is not supported on this platform";
+    }
+
+    // Read the hardware performance counters around the modules in the event loop
+    if(global_config.get<bool>("performance_counters") && !PerformanceCounters::enable()) {
+        LOG(WARNING) << "Hardware performance counters are not available on this system or access is not permitted,"
+                     << " check /proc/sys/kernel/perf_event_paranoid";
+    }
+
+    // Record the modules sending and receiving the messages of every event
+    record_dataflow_ = global_config.get<bool>("performance_dataflow");
+    messenger_->setRecordDataflow(record_dataflow_);
+
     // Book global performance histograms
     if(global_config.get<bool>("performance_plots")) {
         buffer_fill_level_ = CreateHistogram<TH1D>("buffer_fill_level",
@@ -614,88 +1116,896 @@ void ModuleManager::initialize() {
                                                    0,
                                                    static_cast<double>(max_buffer_size_));
         event_time_ = CreateHistogram<TH1D>("event_time", "processing time per event;time [s];# events", 1000, 0, 10);
+        if(MemoryAccounting::enabled()) {
+            event_memory_ = CreateHistogram<TH1D>(
+                "event_memory", "peak memory footprint per event;memory [MB];# events", 1000, 0, 100);
+        }
     }
 
     auto start_time = std::chrono::steady_clock::now();
     LOG_PROGRESS(STATUS, "INIT_LOOP") << "Initializing " << modules_.size() << " module instantiations";
+    initialize_modules(modules_.begin(), modules_.end());
+    compile_pipeline();
+    LOG_PROGRESS(STATUS, "INIT_LOOP") << "Initialized " << modules_.size() << " module instantiations";
+    auto end_time = std::chrono::steady_clock::now();
+    initialize_time_ =
+        static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count());
+
+    // Report the time from the start of the framework to the first event, the modules only spent time in their constructor
+    // and initialization so far
+    startup_phases_.emplace_back("module initialization", initialize_time_);
+    for(auto& module : modules_) {
+        module_startup_time_[module.get()] = module_execution_time_[module.get()].load();
+    }
+    auto startup_time = std::accumulate(startup_phases_.begin(),
+                                        startup_phases_.end(),
+                                        uint64_t(0),
+                                        [](uint64_t sum, const auto& phase) { return sum + phase.second; });
+    LOG(STATUS) << "Startup took " << Units::display(startup_time, {"s", "ms"}) << " until the first event";
+    for(const auto& [phase, duration] : startup_phases_) {
+        LOG(INFO) << " Startup phase " << phase << " took " << Units::display(duration, {"s", "ms"});
+    }
+    for(const auto& [library, duration] : library_load_time_) {
+        LOG(DEBUG) << " Loading library of module " << library << " took " << Units::display(duration, {"s", "ms"});
+    }
     for(auto& module : modules_) {
-        LOG_PROGRESS(TRACE, "INIT_LOOP") << "Initializing " << module->get_identifier().getUniqueName();
+        LOG(DEBUG) << " Module " << module->getUniqueName() << " took "
+                   << Units::display(module_startup_time_[module.get()], {"s", "ms"}) << " to construct and initialize";
+    }
+}
 
-        // Pass the config manager to this instance
-        module->set_config_manager(conf_manager_);
+/**
+ * The log settings of every module are parsed from its configuration and the required delegates are collected once, such
+ * that the event loop only needs to apply them to run a module. If requested, consecutive detector modules not requiring
+ * the events in sequence are grouped into batches which are processed concurrently for the different detectors.
+ */
+void ModuleManager::compile_pipeline() {
+    pipeline_.clear();
+    pipeline_.reserve(modules_.size());
+    module_stages_.clear();
+    slot_stages_.clear();
+    for(auto& module : modules_) {
+        // The messages of the modules preceding the stage cache are replayed from the cache
+        if(cache_hit_ && module_section_.at(module.get()) < cache_section_) {
+            continue;
+        }
+        const auto& config = module->get_configuration();
+
+        PipelineStage stage;
+        stage.module = module.get();
+        stage.index = pipeline_.size();
+        stage.reseed_event = (module.get() == cache_stage_);
+        if(config.has("_branch")) {
+            stage.branch_stream = hash_branch_stream(module->get_identifier().getUniqueName());
+        }
 
-        // Create main ROOT directory for this module class if it does not exists yet
-        LOG(TRACE) << "Creating and accessing ROOT directory";
-        std::string module_name = module->get_configuration().getName();
-        auto* directory = modules_file_->GetDirectory(module_name.c_str());
-        if(directory == nullptr) {
-            directory = modules_file_->mkdir(module_name.c_str());
-            if(directory == nullptr) {
-                throw RuntimeError("Cannot create or access overall ROOT directory for module " + module_name);
+        if(config.has("log_level")) {
+            auto log_level_string = config.get<std::string>("log_level");
+            std::transform(log_level_string.begin(), log_level_string.end(), log_level_string.begin(), ::toupper);
+            try {
+                stage.log_level = Log::getLevelFromString(log_level_string);
+            } catch(std::invalid_argument& e) {
+                throw InvalidValueError(config, "log_level", e.what());
             }
         }
-        directory->cd();
+        if(config.has("log_format")) {
+            auto log_format_string = config.get<std::string>("log_format");
+            std::transform(log_format_string.begin(), log_format_string.end(), log_format_string.begin(), ::toupper);
+            try {
+                stage.log_format = Log::getFormatFromString(log_format_string);
+            } catch(std::invalid_argument& e) {
+                throw InvalidValueError(config, "log_format", e.what());
+            }
+        }
+        stage.section = "R:" + module->get_identifier().getUniqueName();
+        if(Tracer::enabled()) {
+            stage.trace_name = Tracer::registerName(module->get_identifier().getUniqueName());
+        }
 
-        // Create local directory for this instance
-        TDirectory* local_directory = nullptr;
-        if(module->get_identifier().getIdentifier().empty()) {
-            local_directory = directory;
-        } else {
-            local_directory = directory->mkdir(module->get_identifier().getIdentifier().c_str());
-            if(local_directory == nullptr) {
-                throw RuntimeError("Cannot create or access local ROOT directory for module " + module->getUniqueName());
+        for(const auto& delegate : module->delegates_) {
+            if(delegate.second->isRequired()) {
+                stage.required_delegates.push_back(delegate.second);
             }
+            if(record_dataflow_) {
+                auto slot = delegate.second->getSlot();
+                slot_stages_.resize(std::max(slot_stages_.size(), slot + 1), std::numeric_limits<size_t>::max());
+                slot_stages_[slot] = stage.index;
+            }
+        }
+        module_stages_[module.get()] = stage.index;
+        if(module->require_sequence()) {
+            stage.sequence = std::make_unique<SequenceBuffer>();
         }
 
-        // Change to the directory and save it in the module
-        local_directory->cd();
-        module->set_ROOT_directory(local_directory);
+        stage.execution_time = &module_execution_time_.at(module.get());
+        if(MemoryAccounting::enabled()) {
+            stage.memory = &module_memory_[module.get()];
+        }
+        if(PerformanceCounters::enabled()) {
+            // Every thread of the pool adds to its own slot, the main thread has number zero
+            auto& counters = module_counters_[module.get()];
+            counters.per_thread = decltype(counters.per_thread)(ThreadPool::threadCount());
+            stage.counters = &counters;
+        }
+        auto event_time = module_event_time_.find(module.get());
+        if(event_time != module_event_time_.end()) {
+            stage.event_time = event_time->second.get();
+        }
 
-        // Get current time
-        auto start = std::chrono::steady_clock::now();
-        // Set module specific settings
-        auto old_settings = set_module_before(module->get_identifier().getUniqueName(), module->get_configuration(), "I:");
-        // Change to our ROOT directory
-        module->getROOTDirectory()->cd();
-        // Init module
-        module->initialize();
-        // Reset logging
-        set_module_after(std::move(old_settings));
-        // Update execution time
-        auto end = std::chrono::steady_clock::now();
-        module_execution_time_[module.get()] += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        pipeline_.push_back(std::move(stage));
+    }
 
-        // Book per-module performance plots
-        if(global_config.get<bool>("performance_plots")) {
-            const auto& module_identifier = module->get_identifier();
-            const auto& identifier = module_identifier.getIdentifier();
-            const auto& name = (identifier.empty() ? module->get_configuration().getName() : identifier);
-            auto title = module->get_configuration().getName() + " event processing time " +
-                         (!identifier.empty() ? "for " + identifier : "") + ";time [s];# events";
-            module_event_time_.emplace(module.get(), CreateHistogram<TH1D>(name.c_str(), title.c_str(), 1000, 0, 1));
+    // The dataflow refers to the stages, restart its accounting for the new pipeline
+    dataflow_edges_.clear();
+    stage_dataflow_time_.assign(pipeline_.size(), 0);
+    critical_time_.assign(pipeline_.size(), 0);
+    critical_events_.assign(pipeline_.size(), 0);
+    dataflow_critical_time_ = 0;
+    dataflow_events_ = 0;
+
+    if(!parallel_detectors_) {
+        return;
+    }
+    for(size_t begin = 0; begin < pipeline_.size();) {
+        auto end = begin;
+        while(end < pipeline_.size() && pipeline_[end].module->getDetector() != nullptr &&
+              pipeline_[end].sequence == nullptr) {
+            ++end;
+        }
+
+        auto batch = std::make_unique<ParallelBatch>();
+        batch->end = end;
+        std::map<const Detector*, size_t> chain_of_detector;
+        for(auto index = begin; index < end; ++index) {
+            auto chain = chain_of_detector.emplace(pipeline_[index].module->getDetector().get(), batch->chains.size());
+            if(chain.second) {
+                batch->chains.emplace_back();
+            }
+            batch->chains[chain.first->second].push_back(index);
         }
+
+        if(batch->chains.size() > 1) {
+            LOG(DEBUG) << "Processing " << (end - begin) << " module instantiations of " << batch->chains.size()
+                       << " detectors concurrently within each event";
+            pipeline_[begin].batch = std::move(batch);
+        }
+        begin = std::max(end, begin + 1);
     }
-    LOG_PROGRESS(STATUS, "INIT_LOOP") << "Initialized " << modules_.size() << " module instantiations";
-    auto end_time = std::chrono::steady_clock::now();
-    initialize_time_ =
-        static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count());
 }
 
-/**
- * Initializes the thread pool and executes each event in parallel.
- */
-void ModuleManager::run(RandomNumberGenerator& seeder) {
-    using namespace std::chrono_literals;
+bool ModuleManager::skip_stage(const PipelineStage& stage, Event* event) const {
+    auto* module = stage.module;
 
-    Configuration& global_config = conf_manager_->getGlobalConfiguration();
-    auto plot = global_config.get<bool>("performance_plots");
+    // Skip the module if the event has been rejected, unless it processes rejected events
+    if(event->isRejected() && !module->rejectedEventsProcessed()) {
+        return true;
+    }
 
-    // Creates the thread pool
-    LOG(TRACE) << "Initializing thread pool with " << number_of_threads_ << " threads";
-    auto initialize_function =
-        [log_level = Log::getReportingLevel(), log_format = Log::getFormat(), modules_list = modules_]() {
-            // Initialize the threads to the same log level and format as the master setting
-            Log::setReportingLevel(log_level);
+    // Check if the module is satisfied to run
+    if(!std::all_of(stage.required_delegates.cbegin(), stage.required_delegates.cend(), [&](auto* delegate) {
+           return messenger_->isSatisfied(delegate, event);
+       })) {
+        LOG(TRACE) << "Not all required messages are received for " << module->get_identifier().getUniqueName()
+                   << ", skipping module!";
+        return true;
+    }
+    return false;
+}
+
+ModuleManager::StageResult ModuleManager::run_stage(const PipelineStage& stage,
+                                                    Event* event,
+                                                    const std::tuple<LogLevel, LogFormat, std::string, uint64_t>& thread_log,
+                                                    bool plot,
+                                                    int64_t& event_time) {
+    // Get current time
+    auto start = std::chrono::steady_clock::now();
+
+    // Set module specific logging settings
+    if(stage.log_level.has_value()) {
+        Log::setReportingLevel(stage.log_level.value());
+    }
+    if(stage.log_format.has_value()) {
+        Log::setFormat(stage.log_format.value());
+    }
+    Log::setSection(stage.section);
+    Log::setEventNum(event->number);
+
+    // Run module, attributing its allocations and hardware events to it
+    auto result = StageResult::FINISHED;
+    MemoryAccounting::Counters memory;
+    PerformanceCounters::Values counters_start{};
+    if(stage.counters != nullptr) {
+        counters_start = PerformanceCounters::read();
+    }
+    try {
+        MemoryAccounting::Scope memory_scope(memory);
+        stage.module->run(event);
+    } catch(const MissingDependenciesException& e) {
+        result = StageResult::STOPPED;
+    } catch(const AbortEventException& e) {
+        LOG(WARNING) << "Event aborted:" << std::endl << e.what();
+        result = StageResult::ABORTED;
+    } catch(const EndOfRunException& e) {
+        // Terminate if the module threw the EndOfRun request exception:
+        LOG(WARNING) << "Request to terminate:" << std::endl << e.what();
+        terminate_ = true;
+    }
+
+    if(stage.counters != nullptr) {
+        auto counters_end = PerformanceCounters::read();
+        auto thread = std::min<size_t>(ThreadPool::threadNum(), stage.counters->per_thread.size() - 1);
+        for(size_t event_type = 0; event_type < counters_end.size(); ++event_type) {
+            stage.counters->per_thread[thread][event_type] += counters_end[event_type] - counters_start[event_type];
+        }
+    }
+
+    // Interruptions requested through the event are handled like the corresponding exceptions without unwinding the stack
+    auto [interrupt, reason] = event->take_interrupt();
+    if(result == StageResult::FINISHED) {
+        if(interrupt == Event::Interrupt::RESCHEDULE) {
+            result = StageResult::STOPPED;
+        } else if(interrupt == Event::Interrupt::ABORT) {
+            LOG(WARNING) << "Event aborted:" << std::endl << reason;
+            result = StageResult::ABORTED;
+        } else if(interrupt == Event::Interrupt::END_OF_RUN) {
+            LOG(WARNING) << "Request to terminate:" << std::endl << reason;
+            terminate_ = true;
+        }
+    }
+
+    // Reset logging
+    Log::setReportingLevel(std::get<0>(thread_log));
+    Log::setFormat(std::get<1>(thread_log));
+    Log::setSection(std::get<2>(thread_log));
+    Log::setEventNum(std::get<3>(thread_log));
+
+    // Update execution time
+    auto end = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    // Note: we do not need to lock a mutex because the counters are atomic.
+    *stage.execution_time += duration;
+    if(Tracer::enabled()) {
+        Tracer::complete(stage.trace_name, start, end, event->number);
+    }
+
+    if(stage.memory != nullptr) {
+        stage.memory->allocated += memory.allocated;
+        stage.memory->released += memory.released;
+        stage.memory->allocations += memory.allocations;
+
+        // The peak of the event is approximate if detector modules run concurrently
+        std::lock_guard<std::mutex> stat_lock{event->stats_mutex_};
+        event->memory_peak_ = std::max(event->memory_peak_, event->memory_footprint_ + memory.peak);
+        event->memory_footprint_ += static_cast<int64_t>(memory.allocated - memory.released);
+    }
+
+    if(record_dataflow_) {
+        std::lock_guard<std::mutex> stat_lock{event->stats_mutex_};
+        event->stage_time_.resize(pipeline_.size());
+        event->stage_time_[stage.index] += duration;
+    }
+
+    if(plot) {
+        std::lock_guard<std::mutex> stat_lock{event->stats_mutex_};
+        event_time += duration;
+        stage.event_time->Fill(std::chrono::duration<double>(std::chrono::nanoseconds(duration)).count());
+    }
+
+    return result;
+}
+
+/**
+ * The memory of the messages still held by the event is attributed to their types. The memory retained by the modules
+ * includes these messages as well as anything else allocated for the event and not yet released, e.g. in caches.
+ */
+void ModuleManager::account_event_memory(Event* event, bool plot) {
+    auto messages = event->get_local_messenger()->getMemoryUsagePerType();
+    {
+        std::lock_guard<std::mutex> lock{message_memory_mutex_};
+        for(const auto& [type, memory] : messages) {
+            message_memory_[type] += memory;
+        }
+    }
+
+    int64_t footprint = 0, peak = 0;
+    {
+        std::lock_guard<std::mutex> stat_lock{event->stats_mutex_};
+        footprint = event->memory_footprint_;
+        peak = event->memory_peak_;
+    }
+    memory_events_++;
+    event_memory_retained_ += footprint;
+    auto max_peak = event_memory_peak_.load();
+    while(peak > max_peak && !event_memory_peak_.compare_exchange_weak(max_peak, peak)) {
+    }
+
+    if(plot) {
+        event_memory_->Fill(static_cast<double>(peak) / 1024 / 1024);
+    }
+}
+
+/**
+ * Messages are only taken into account if they are sent to a later module in the pipeline, as only these can have been
+ * received before the receiving module ran. The time of the critical path is the time the event would take if all modules
+ * not depending on each other ran concurrently, the time of all modules on the path is attributed to the critical path.
+ */
+void ModuleManager::account_event_dataflow(Event* event) {
+    std::vector<int64_t> stage_time;
+    {
+        std::lock_guard<std::mutex> stat_lock{event->stats_mutex_};
+        stage_time = event->stage_time_;
+    }
+    stage_time.resize(pipeline_.size());
+
+    // Collect the dependencies between the stages in this event
+    std::map<std::pair<size_t, size_t>, std::set<std::type_index>> edges;
+    for(const auto& transfer : event->get_local_messenger()->getDataflow()) {
+        auto source = module_stages_.find(transfer.source);
+        if(source == module_stages_.end() || transfer.slot >= slot_stages_.size()) {
+            continue;
+        }
+        auto target = slot_stages_[transfer.slot];
+        if(target > source->second && target < pipeline_.size()) {
+            edges[{source->second, target}].insert(transfer.type);
+        }
+    }
+
+    // Find the longest path through the stages, which are ordered topologically by construction
+    std::vector<int64_t> finish(stage_time);
+    std::vector<size_t> previous(pipeline_.size(), std::numeric_limits<size_t>::max());
+    for(const auto& [edge, types] : edges) {
+        // Edges are sorted by their source, so all edges into a stage are processed after the finish of the source is final
+        if(finish[edge.first] + stage_time[edge.second] > finish[edge.second]) {
+            finish[edge.second] = finish[edge.first] + stage_time[edge.second];
+            previous[edge.second] = edge.first;
+        }
+    }
+    auto last = static_cast<size_t>(std::distance(finish.begin(), std::max_element(finish.begin(), finish.end())));
+
+    std::lock_guard<std::mutex> lock{dataflow_mutex_};
+    for(const auto& [edge, types] : edges) {
+        auto& dataflow_edge = dataflow_edges_[edge];
+        dataflow_edge.events++;
+        dataflow_edge.types.insert(types.begin(), types.end());
+    }
+    for(size_t index = 0; index < stage_time.size(); ++index) {
+        stage_dataflow_time_[index] += stage_time[index];
+    }
+    if(!finish.empty()) {
+        dataflow_critical_time_ += finish[last];
+        for(auto index = last; index < pipeline_.size(); index = previous[index]) {
+            critical_time_[index] += stage_time[index];
+            critical_events_[index]++;
+        }
+    }
+    dataflow_events_++;
+}
+
+/**
+ * The summary gives the time of the critical path compared to the time of all modules, which bounds the speedup possible
+ * by processing independent modules of an event concurrently, e.g. with parallel_detectors. The time spent in modules
+ * requiring the events in sequence cannot overlap between events and bounds the speedup from processing events in
+ * parallel. The graph is written in the DOT format, with the modules on the critical path of most events highlighted and
+ * the modules requiring the events in sequence drawn with a double border.
+ */
+void ModuleManager::write_dataflow() {
+    auto events = static_cast<double>(std::max<uint64_t>(dataflow_events_, 1));
+    auto total_time = std::accumulate(stage_dataflow_time_.begin(), stage_dataflow_time_.end(), int64_t(0));
+    int64_t sequential_time = 0;
+    for(const auto& stage : pipeline_) {
+        if(stage.sequence != nullptr) {
+            sequential_time += stage_dataflow_time_[stage.index];
+        }
+    }
+
+    auto fraction = [total_time](int64_t time) {
+        return std::round(100. * static_cast<double>(time) / static_cast<double>(std::max<int64_t>(total_time, 1)));
+    };
+    auto speedup = [](int64_t total, int64_t part) {
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(2)
+           << static_cast<double>(total) / static_cast<double>(std::max<int64_t>(part, 1));
+        return ss.str();
+    };
+    LOG(STATUS) << "Critical path of the events takes " << fraction(dataflow_critical_time_)
+                << "% of the module time, processing independent modules concurrently could speed up events by up to "
+                << speedup(total_time, dataflow_critical_time_);
+    if(sequential_time > 0) {
+        LOG(STATUS) << "Modules requiring the events in sequence take " << fraction(sequential_time)
+                    << "% of the module time, limiting the speedup from parallel events to "
+                    << speedup(total_time, sequential_time);
+    }
+    for(const auto& stage : pipeline_) {
+        LOG(INFO) << " Module " << stage.module->getUniqueName() << " is on the critical path of "
+                  << std::round(100. * static_cast<double>(critical_events_[stage.index]) / events) << "% of events with "
+                  << fraction(critical_time_[stage.index]) << "% of the module time";
+    }
+
+    auto path = std::filesystem::path(gSystem->pwd()) / "dataflow.dot";
+    std::ofstream graph(path);
+    if(!graph) {
+        throw RuntimeError("Cannot create dataflow graph " + path.string());
+    }
+    graph << "digraph dataflow {\n  node [shape=box];\n";
+    for(const auto& stage : pipeline_) {
+        auto critical = (2 * critical_events_[stage.index] > dataflow_events_);
+        graph << "  m" << stage.index << " [label=\"" << stage.module->getUniqueName() << "\\n"
+              << Units::display(static_cast<double>(stage_dataflow_time_[stage.index]) / events, {"ms", "us"})
+              << "/event\\ncritical in " << std::round(100. * static_cast<double>(critical_events_[stage.index]) / events)
+              << "% of events\"" << (critical ? ", color=red, penwidth=2" : "")
+              << (stage.sequence != nullptr ? ", peripheries=2" : "") << "];\n";
+    }
+    for(const auto& [edge, dataflow_edge] : dataflow_edges_) {
+        graph << "  m" << edge.first << " -> m" << edge.second << " [label=\"";
+        for(const auto& type : dataflow_edge.types) {
+            graph << allpix::demangle(type.name()) << "\\n";
+        }
+        graph << std::round(100. * static_cast<double>(dataflow_edge.events) / events) << "% of events\"];\n";
+    }
+    graph << "}\n";
+    LOG(STATUS) << "Wrote dataflow graph of the modules to " << path;
+}
+
+/**
+ * The random engine of every chain is seeded with a number drawn from the engine of the event in the order of the chains,
+ * such that the event is reproducible independently of the number of workers and of the order in which the chains run.
+ * Chains stop after the current module if any module aborted the event or threw an exception, the first exception is
+ * rethrown once all started chains have finished.
+ */
+ModuleManager::StageResult
+ModuleManager::run_parallel_batch(const ParallelBatch& batch, Event* event, bool plot, int64_t& event_time) {
+    // Shared with the jobs offered to the thread pool, which might only start after the batch has finished
+    struct BatchState {
+        std::vector<uint64_t> seeds;
+        std::atomic<size_t> next_chain{0};
+        std::atomic_bool stop{false};
+        bool aborted{false};
+        size_t pending{};
+        std::exception_ptr exception;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    auto state = std::make_shared<BatchState>();
+    state->seeds.resize(batch.chains.size());
+    for(auto& seed : state->seeds) {
+        seed = event->getRandomNumber();
+    }
+    state->pending = batch.chains.size();
+
+    auto process_chains = [this, state, &batch, event, plot, &event_time]() {
+        static thread_local RandomNumberGenerator random_engine;
+        const auto thread_log =
+            std::make_tuple(Log::getReportingLevel(), Log::getFormat(), Log::getSection(), Log::getEventNum());
+
+        for(auto chain = state->next_chain++; chain < batch.chains.size(); chain = state->next_chain++) {
+            random_engine.setEngine(random_engine_);
+            random_engine.seed(state->seeds[chain]);
+            Event::chain_random_engine_ = &random_engine;
+
+            auto aborted = false;
+            std::exception_ptr exception;
+            try {
+                for(auto index : batch.chains[chain]) {
+                    if(state->stop) {
+                        break;
+                    }
+
+                    const auto& stage = pipeline_[index];
+                    if(stage.branch_stream != 0) {
+                        random_engine.seed(Philox4x64(event->getSeed(), stage.branch_stream)());
+                    }
+                    LOG_PROGRESS(TRACE, "EVENT_LOOP") << "Running event " << event->number << " ["
+                                                      << stage.module->get_identifier().getUniqueName() << "]";
+                    if(skip_stage(stage, event)) {
+                        continue;
+                    }
+
+                    auto result = run_stage(stage, event, thread_log, plot, event_time);
+                    if(result == StageResult::STOPPED) {
+                        throw RuntimeError("Module " + stage.module->get_identifier().getUniqueName() +
+                                           " cannot request rescheduling while processing detectors in parallel");
+                    }
+                    if(result == StageResult::ABORTED) {
+                        aborted = true;
+                        break;
+                    }
+                }
+            } catch(...) {
+                exception = std::current_exception();
+            }
+            Event::chain_random_engine_ = nullptr;
+
+            {
+                std::lock_guard<std::mutex> lock{state->mutex};
+                if(aborted || exception) {
+                    state->stop = true;
+                    state->aborted = state->aborted || aborted;
+                }
+                if(exception && !state->exception) {
+                    state->exception = exception;
+                }
+                --state->pending;
+            }
+            state->finished.notify_all();
+        }
+    };
+
+    // Offer the chains to idle workers and process all chains not picked up on this thread
+    for(size_t i = 1; i < batch.chains.size(); ++i) {
+        if(!thread_pool_->trySubmit(process_chains)) {
+            break;
+        }
+    }
+    process_chains();
+
+    std::unique_lock<std::mutex> lock{state->mutex};
+    state->finished.wait(lock, [&]() { return state->pending == 0; });
+    if(state->exception) {
+        std::rethrow_exception(state->exception);
+    }
+    return state->aborted ? StageResult::ABORTED : StageResult::FINISHED;
+}
+
+/**
+ * Events passing the module in order only advance the counter, while events passing out of order are remembered until the
+ * counter reaches them. The release of a waiting event also frees its slot in the buffer of the thread pool.
+ */
+void ModuleManager::advance_sequence(SequenceBuffer& sequence, uint64_t event_num) {
+    ThreadPool::Task released;
+    {
+        std::lock_guard<std::mutex> lock{sequence.mutex};
+        if(event_num == sequence.next_event) {
+            ++sequence.next_event;
+        } else {
+            sequence.passed_events.insert(event_num);
+        }
+        while(!sequence.passed_events.empty() && *sequence.passed_events.begin() == sequence.next_event) {
+            sequence.passed_events.erase(sequence.passed_events.begin());
+            ++sequence.next_event;
+        }
+
+        auto waiting = sequence.waiting_events.begin();
+        if(waiting != sequence.waiting_events.end() && waiting->first == sequence.next_event) {
+            released = std::move(waiting->second);
+            sequence.waiting_events.erase(waiting);
+        }
+    }
+
+    if(released) {
+        thread_pool_->releaseBuffered();
+        released_events().push_back(std::move(released));
+    }
+}
+
+std::deque<ThreadPool::Task>& ModuleManager::released_events() {
+    thread_local std::deque<ThreadPool::Task> released;
+    return released;
+}
+
+/**
+ * Released events are continued one after another instead of recursively from within the event releasing them, such that
+ * the stack depth does not grow with the length of a chain of waiting events.
+ */
+void ModuleManager::run_released_events() {
+    thread_local bool running = false;
+    if(running) {
+        return;
+    }
+
+    running = true;
+    auto& released = released_events();
+    try {
+        while(!released.empty()) {
+            auto event_function = std::move(released.front());
+            released.pop_front();
+            event_function();
+        }
+    } catch(...) {
+        running = false;
+        throw;
+    }
+    running = false;
+}
+
+void ModuleManager::prepare_module(Module* module) {
+    // Pass the config manager to this instance
+    module->set_config_manager(conf_manager_);
+
+    // Create main ROOT directory for this module class if it does not exists yet
+    LOG(TRACE) << "Creating and accessing ROOT directory";
+    std::string module_name = module->get_configuration().getName();
+    TDirectory* base_directory = modules_file_.get();
+    if(point_file_ != nullptr && module_section_.at(module) >= sweep_section_) {
+        // Modules created for a checkpoint segment store their objects in the main ROOT file of the segment
+        base_directory = point_file_.get();
+    } else if(module_section_.at(module) >= sweep_section_) {
+        // Modules created for every point of a parameter sweep or request store their objects separately for each point
+        base_directory = modules_file_->GetDirectory(point_name_.c_str());
+        if(base_directory == nullptr) {
+            base_directory = modules_file_->mkdir(point_name_.c_str());
+            if(base_directory == nullptr) {
+                throw RuntimeError("Cannot create or access ROOT directory for " + point_name_);
+            }
+        }
+    }
+    auto* directory = base_directory->GetDirectory(module_name.c_str());
+    if(directory == nullptr) {
+        directory = base_directory->mkdir(module_name.c_str());
+        if(directory == nullptr) {
+            throw RuntimeError("Cannot create or access overall ROOT directory for module " + module_name);
+        }
+    }
+    directory->cd();
+
+    // Create local directory for this instance
+    TDirectory* local_directory = nullptr;
+    if(module->get_identifier().getIdentifier().empty()) {
+        local_directory = directory;
+    } else {
+        local_directory = directory->mkdir(module->get_identifier().getIdentifier().c_str());
+        if(local_directory == nullptr) {
+            throw RuntimeError("Cannot create or access local ROOT directory for module " + module->getUniqueName());
+        }
+    }
+
+    // Change to the directory and save it in the module
+    local_directory->cd();
+    module->set_ROOT_directory(local_directory);
+}
+
+void ModuleManager::initialize_module(Module* module) {
+    // Get current time
+    auto start = std::chrono::steady_clock::now();
+    // Set module specific settings
+    auto old_settings = set_module_before(module->get_identifier().getUniqueName(), module->get_configuration(), "I:");
+    // Change to our ROOT directory
+    module->getROOTDirectory()->cd();
+    // Init module
+    module->initialize();
+    // Reset logging
+    set_module_after(std::move(old_settings));
+    // Update execution time, the entry of the module already exists and can be accessed concurrently
+    auto end = std::chrono::steady_clock::now();
+    module_execution_time_.at(module) += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+/**
+ * Consecutive detector modules which allow it are initialized concurrently, all other modules are initialized in the order
+ * of the configuration. The performance histograms of the modules are booked afterwards if requested.
+ */
+void ModuleManager::initialize_modules(ModuleList::iterator begin, ModuleList::iterator end) {
+    for(auto iter = begin; iter != end;) {
+        // Collect the consecutive detector modules which allow to be initialized in parallel
+        auto batch_end = iter;
+        while(parallel_initialization_ && batch_end != end && (*batch_end)->parallelInitializationAllowed() &&
+              (*batch_end)->getDetector() != nullptr) {
+            ++batch_end;
+        }
+
+        if(std::distance(iter, batch_end) > 1) {
+            initialize_parallel(iter, batch_end);
+            iter = batch_end;
+        } else {
+            LOG_PROGRESS(TRACE, "INIT_LOOP") << "Initializing " << (*iter)->get_identifier().getUniqueName();
+            prepare_module(iter->get());
+            initialize_module(iter->get());
+            ++iter;
+        }
+    }
+
+    // Book per-module performance plots
+    if(conf_manager_->getGlobalConfiguration().get<bool>("performance_plots")) {
+        for(auto iter = begin; iter != end; ++iter) {
+            auto& module = *iter;
+            module->getROOTDirectory()->cd();
+            const auto& module_identifier = module->get_identifier();
+            const auto& identifier = module_identifier.getIdentifier();
+            const auto& name = (identifier.empty() ? module->get_configuration().getName() : identifier);
+            auto title = module->get_configuration().getName() + " event processing time " +
+                         (!identifier.empty() ? "for " + identifier : "") + ";time [s];# events";
+            module_event_time_.emplace(module.get(), CreateHistogram<TH1D>(name.c_str(), title.c_str(), 1000, 0, 1));
+        }
+    }
+}
+
+/**
+ * The ROOT directories of all modules are created beforehand in the calling thread. The modules are then grouped by their
+ * detector, and the groups are initialized on separate threads while the modules within a group are initialized in the
+ * order of the configuration. The first exception thrown by any module is rethrown after all threads have finished.
+ */
+void ModuleManager::initialize_parallel(ModuleList::iterator begin, ModuleList::iterator end) {
+    std::vector<std::vector<Module*>> chains;
+    std::map<const Detector*, size_t> chain_of_detector;
+    for(auto iter = begin; iter != end; ++iter) {
+        prepare_module(iter->get());
+        auto chain = chain_of_detector.emplace((*iter)->getDetector().get(), chains.size());
+        if(chain.second) {
+            chains.emplace_back();
+        }
+        chains[chain.first->second].push_back(iter->get());
+    }
+
+    auto workers = std::min<size_t>(chains.size(), std::max(std::thread::hardware_concurrency(), 1u));
+    LOG(DEBUG) << "Initializing " << std::distance(begin, end) << " module instantiations of " << chains.size()
+               << " detectors in parallel on " << workers << " threads";
+
+    std::atomic<size_t> next_chain{0};
+    std::exception_ptr exception;
+    std::mutex exception_mutex;
+    auto initialize_chains = [&, log_level = Log::getReportingLevel(), log_format = Log::getFormat()]() {
+        // Initialize the thread to the same log level and format as the calling thread
+        Log::setReportingLevel(log_level);
+        Log::setFormat(log_format);
+
+        for(auto chain = next_chain++; chain < chains.size(); chain = next_chain++) {
+            try {
+                for(auto* module : chains[chain]) {
+                    LOG(TRACE) << "Initializing " << module->get_identifier().getUniqueName();
+                    initialize_module(module);
+                }
+            } catch(...) {
+                // Store the first exception and stop picking up new detectors
+                std::lock_guard<std::mutex> lock(exception_mutex);
+                if(!exception) {
+                    exception = std::current_exception();
+                }
+                next_chain = chains.size();
+                return;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers);
+    for(size_t i = 0; i < workers; ++i) {
+        threads.emplace_back(initialize_chains);
+    }
+    for(auto& thread : threads) {
+        thread.join();
+    }
+
+    if(exception) {
+        std::rethrow_exception(exception);
+    }
+}
+
+void ModuleManager::apply_sweep_value() {
+    const auto& value = sweep_values_.at(sweep_point_);
+    for(auto& config : conf_manager_->getModuleConfigurations()) {
+        if(config.getName() == sweep_module_) {
+            config.setText(sweep_parameter_, value);
+        }
+    }
+    LOG(STATUS) << "Sweep point " << sweep_point_ << ": setting parameter " << sweep_parameter_ << " of " << sweep_module_
+                << " to " << value;
+}
+
+/**
+ * The modules created from the sections of the swept module and all following sections are finalized, such that their
+ * output of the previous point is complete, and are destroyed together with their instance configurations. The sections
+ * are then loaded again with the next value of the swept parameter and the new modules are initialized. Libraries,
+ * geometry and all modules preceding the swept module are kept.
+ */
+void ModuleManager::nextSweepPoint() {
+    LOG_PROGRESS(STATUS, "SWEEP_LOOP") << "Finalizing modules of sweep point " << sweep_point_;
+    drop_recreated_modules();
+
+    sweep_point_++;
+    point_name_ = "sweep_" + std::to_string(sweep_point_);
+    point_directory_ = point_directory_.parent_path() / point_name_;
+    apply_sweep_value();
+
+    auto created = create_recreated_modules();
+    LOG_PROGRESS(STATUS, "SWEEP_LOOP") << "Initialized " << created << " module instantiations of sweep point "
+                                       << sweep_point_;
+}
+
+void ModuleManager::startRequest(const std::string& name, const std::filesystem::path& output_directory) {
+    point_name_ = name;
+    point_directory_ = output_directory;
+
+    if(checkpoints_) {
+        auto path = output_directory / conf_manager_->getGlobalConfiguration().get<std::string>("root_file", "modules");
+        path.replace_extension("root");
+        std::filesystem::create_directories(output_directory);
+        point_file_ = std::make_unique<TFile>(path.c_str(), "RECREATE");
+        if(point_file_->IsZombie()) {
+            throw RuntimeError("Cannot create main ROOT file " + path.string());
+        }
+    }
+
+    auto created = create_recreated_modules();
+    LOG(STATUS) << "Initialized " << created << " module instantiations of " << name;
+}
+
+void ModuleManager::finishRequest() {
+    LOG(STATUS) << "Finalizing modules of " << point_name_;
+    drop_recreated_modules();
+
+    if(point_file_ != nullptr) {
+        point_file_->Close();
+        point_file_.reset();
+        modules_file_->cd();
+    }
+}
+
+void ModuleManager::drop_recreated_modules() {
+    auto is_recreated = [this](const std::shared_ptr<Module>& module) {
+        return module_section_.at(module.get()) >= sweep_section_;
+    };
+
+    finalize_modules(std::find_if(modules_.begin(), modules_.end(), is_recreated), modules_.end());
+    for(auto iter = std::find_if(modules_.begin(), modules_.end(), is_recreated); iter != modules_.end();) {
+        conf_manager_->dropInstanceConfiguration((*iter)->get_identifier());
+        id_to_module_.erase((*iter)->get_identifier());
+        module_execution_time_.erase(iter->get());
+        module_startup_time_.erase(iter->get());
+        module_event_time_.erase(iter->get());
+        module_memory_.erase(iter->get());
+        module_counters_.erase(iter->get());
+        module_section_.erase(iter->get());
+        iter = modules_.erase(iter);
+    }
+
+    // The message slots of the removed modules are replaced, local messengers need to be created again
+    local_messenger_pool_.clear();
+}
+
+size_t ModuleManager::create_recreated_modules() {
+    // Create the modules of the recreated sections and initialize them
+    auto kept_modules = modules_.size();
+    size_t section = 0;
+    for(auto& config : conf_manager_->getModuleConfigurations()) {
+        if(section >= sweep_section_) {
+            load_section(config, section);
+        }
+        section++;
+    }
+    auto first_created = std::next(modules_.begin(), static_cast<std::ptrdiff_t>(kept_modules));
+    if(!(multithreading_flag_ && can_parallelize_)) {
+        for(auto iter = first_created; iter != modules_.end(); ++iter) {
+            (*iter)->set_multithreading(false);
+        }
+    }
+
+    initialize_modules(first_created, modules_.end());
+    compile_pipeline();
+    return modules_.size() - kept_modules;
+}
+
+/**
+ * An observable has converged if it has at least two samples and its uncertainty is within the precision relative to its
+ * value. Observables with a value of zero therefore only converge if their uncertainty vanishes as well.
+ */
+bool ModuleManager::observables_converged(double precision) const {
+    bool found = false;
+    for(const auto& module : modules_) {
+        for(const auto& observable : module->getObservables()) {
+            if(observable.getEntries() < 2 ||
+               observable.getUncertainty() > precision * std::fabs(observable.getValue())) {
+                return false;
+            }
+            found = true;
+        }
+    }
+    return found;
+}
+
+/**
+ * Initializes the thread pool and executes each event in parallel.
+ */
+void ModuleManager::run(RandomNumberGenerator& seeder) {
+    using namespace std::chrono_literals;
+
+    Configuration& global_config = conf_manager_->getGlobalConfiguration();
+    auto plot = global_config.get<bool>("performance_plots");
+
+    // Creates the thread pool
+    LOG(TRACE) << "Initializing thread pool with " << number_of_threads_ << " threads";
+    auto initialize_function =
+        [log_level = Log::getReportingLevel(), log_format = Log::getFormat(), modules_list = modules_]() {
+            // Initialize the threads to the same log level and format as the master setting
+            Log::setReportingLevel(log_level);
             Log::setFormat(log_format);
 
             // Call per-thread initialization of each module
@@ -730,7 +2040,7 @@ void ModuleManager::run(RandomNumberGenerator& seeder) {
     // Push 128 events for each worker to maintain enough work
     auto max_queue_size = number_of_threads_ * 128;
     thread_pool_ = std::make_unique<ThreadPool>(
-        number_of_threads_, max_queue_size, max_buffer_size_, initialize_function, finalize_function);
+        number_of_threads_, max_queue_size, max_buffer_size_, initialize_function, finalize_function, queue_layout_);
 
     // Record the run stage total time
     auto start_time = std::chrono::steady_clock::now();
@@ -738,19 +2048,127 @@ void ModuleManager::run(RandomNumberGenerator& seeder) {
     // Push all events to the thread pool
     std::atomic<uint64_t> finished_events{0};
     std::atomic<uint64_t> aborted_events{0};
+    std::atomic<uint64_t> rejected_events{0};
     global_config.setDefault<uint64_t>("number_of_events", 1u);
     auto number_of_events = global_config.get<uint64_t>("number_of_events");
 
+    // Export the metrics of the event loop periodically to monitor the throughput of running simulations
+    std::unique_ptr<MetricsExporter> metrics_exporter;
+    if(global_config.has("metrics_file")) {
+        auto metrics_interval = global_config.get<double>("metrics_interval", Units::get(10.0, "s"));
+        if(metrics_interval <= 0) {
+            throw InvalidValueError(global_config, "metrics_interval", "interval should be larger than zero");
+        }
+        auto metrics_file = global_config.getPath("metrics_file");
+        metrics_exporter = std::make_unique<MetricsExporter>(
+            metrics_file,
+            global_config.get<MetricsExporter::Format>("metrics_format", MetricsExporter::Format::PROMETHEUS),
+            std::chrono::nanoseconds(static_cast<int64_t>(metrics_interval)),
+            [&, number_of_events]() {
+                MetricsExporter::Metrics metrics;
+                metrics.finished_events = finished_events;
+                metrics.aborted_events = aborted_events;
+                metrics.rejected_events = rejected_events;
+                metrics.total_events = number_of_events;
+                metrics.queued_events = thread_pool_->queueSize();
+                metrics.buffered_events = thread_pool_->bufferedQueueSize();
+                for(const auto& module : modules_) {
+                    auto execution_time = module_execution_time_.find(module.get());
+                    if(execution_time != module_execution_time_.end()) {
+                        metrics.module_time.emplace_back(module->getUniqueName(), execution_time->second.load());
+                    }
+                }
+                metrics.worker_busy_time = thread_pool_->busyTime();
+                return metrics;
+            });
+        LOG(STATUS) << "Exporting metrics of the event loop every " << Units::display(metrics_interval, {"s", "ms"})
+                    << " to " << metrics_file;
+    }
+
     // Skip first N events and discard their event seed from the seeder engine:
     auto skip_events = global_config.get<uint64_t>("skip_events", 0);
     seeder.discard(skip_events);
 
+    // Run consecutive events in a single task of the thread pool to reduce the scheduling overhead of light events
+    global_config.setDefault<uint64_t>("events_per_task", 1u);
+    auto events_per_task = global_config.get<uint64_t>("events_per_task");
+    if(events_per_task < 1) {
+        throw InvalidValueError(global_config, "events_per_task", "number of events per task should be larger than zero");
+    }
+    std::vector<ThreadPool::Task> task_events;
+    task_events.reserve(events_per_task);
+    auto submit_task_events = [&]() {
+        auto submitted = thread_pool_->submitDetached([events = std::move(task_events)]() mutable {
+            for(auto& event_function : events) {
+                event_function();
+            }
+        });
+        assert(submitted || !thread_pool_->valid());
+        static_cast<void>(submitted);
+        thread_pool_->checkException();
+        task_events.clear();
+        task_events.reserve(events_per_task);
+    };
+
+    // Limit the number of events in flight such that their messages stay within the configured memory budget (in MB)
+    auto memory_budget = global_config.get<double>("event_memory_budget", 0) * 1024 * 1024;
+    if(memory_budget < 0) {
+        throw InvalidValueError(global_config, "event_memory_budget", "memory budget should not be negative");
+    }
+    std::atomic<uint64_t> measured_events{0};
+    std::atomic<uint64_t> measured_memory{0};
+    std::mutex memory_mutex;
+    std::condition_variable memory_condition;
+    uint64_t max_events_in_flight = 0;
+
+    // Bytes saved by compressing the payload of events parked in reorder buffers
+    std::atomic<uint64_t> compressed_events{0};
+    std::atomic<uint64_t> compressed_bytes{0};
+    auto events_in_flight_limit = [&]() -> uint64_t {
+        // Start with one event per worker until the memory of a finished event has been measured
+        if(measured_events == 0 || measured_memory == 0) {
+            return std::max<uint64_t>(number_of_threads_, 1);
+        }
+        auto memory_per_event = static_cast<double>(measured_memory) / static_cast<double>(measured_events);
+        return std::max<uint64_t>(static_cast<uint64_t>(memory_budget / memory_per_event), 1);
+    };
+
+    // Stop starting new events once all observables of the modules reached the requested relative precision
+    auto convergence_precision = global_config.get<double>("convergence_precision", 0);
+    if(convergence_precision < 0) {
+        throw InvalidValueError(global_config, "convergence_precision", "precision should not be negative");
+    }
+    auto convergence_interval = global_config.get<uint64_t>("convergence_interval", 100u);
+    if(convergence_interval < 1) {
+        throw InvalidValueError(global_config, "convergence_interval", "interval should be larger than zero");
+    }
+    uint64_t next_convergence_check = convergence_interval;
+    uint64_t converged_events = 0;
+    if(convergence_precision > 0) {
+        auto observables = std::accumulate(modules_.begin(), modules_.end(), size_t(0), [](size_t sum, const auto& module) {
+            return sum + module->getObservables().size();
+        });
+        if(observables == 0) {
+            LOG(WARNING) << "No module provides observables, the run will not stop before the requested number of events";
+        } else {
+            LOG(STATUS) << "Monitoring " << observables << " observables for a relative precision of "
+                        << convergence_precision;
+        }
+    }
+
     // Mark the first N events as completed for the thread pool. Since events start at one, always mark zero identifier as
     // completed
     for(size_t n = 0; n <= skip_events; n++) {
         thread_pool_->markComplete(n);
     }
 
+    // Let the first event pass the modules requiring the events in sequence
+    for(auto& stage : pipeline_) {
+        if(stage.sequence != nullptr) {
+            stage.sequence->next_event = skip_events + 1;
+        }
+    }
+
     LOG(STATUS) << "Starting event loop";
     for(uint64_t i = 1 + skip_events; i <= number_of_events + skip_events; i++) {
         // Check if run was aborted and stop pushing extra events to the threadpool
@@ -760,23 +2178,63 @@ void ModuleManager::run(RandomNumberGenerator& seeder) {
             break;
         }
 
+        // Check the precision of the observables after every interval of finished events
+        if(convergence_precision > 0 && finished_events >= next_convergence_check) {
+            next_convergence_check = finished_events + convergence_interval;
+            if(observables_converged(convergence_precision)) {
+                converged_events = finished_events;
+                LOG(STATUS) << "Observables converged after " << converged_events << " events, finishing the started events";
+                break;
+            }
+        }
+
+        // Wait for events to finish while the events in flight would exceed the memory budget
+        if(memory_budget > 0) {
+            auto events_in_flight = [&]() { return (i - 1 - skip_events) - finished_events; };
+            if(events_in_flight() >= events_in_flight_limit() && !task_events.empty()) {
+                // Submit the events collected for the next task first, they would never finish otherwise
+                submit_task_events();
+            }
+            std::unique_lock<std::mutex> memory_lock{memory_mutex};
+            while(!terminate_ && events_in_flight() >= events_in_flight_limit()) {
+                memory_condition.wait_for(memory_lock, 10ms);
+                thread_pool_->checkException();
+            }
+            max_events_in_flight = std::max<uint64_t>(max_events_in_flight, events_in_flight() + 1);
+        }
+
         // Get a new seed for the new event
         uint64_t seed = seeder();
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wstrict-overflow"
         auto event_function_with_module =
-            [this, plot, number_of_events, event_num = i, event_seed = seed, &finished_events, &aborted_events](
+            [this,
+             plot,
+             number_of_events,
+             event_num = i,
+             event_seed = seed,
+             &finished_events,
+             &aborted_events,
+             &rejected_events,
+             &measured_events,
+             &measured_memory,
+             &memory_mutex,
+             &memory_condition,
+             memory_budget,
+             &compressed_events,
+             &compressed_bytes](
                 std::shared_ptr<Event> event,
-                ModuleList::iterator module_iter,
+                size_t stage_index,
                 int64_t event_time,
                 auto&& self_func) mutable -> void {
             // The RNG to be used by all events running on this thread
             static thread_local RandomNumberGenerator random_engine;
 
             // Create the event data
+            random_engine.setEngine(this->random_engine_);
             if(event == nullptr) {
-                event = std::make_shared<Event>(*this->messenger_, event_num, event_seed);
+                event = this->create_event(event_num, event_seed);
                 event->set_and_seed_random_engine(&random_engine);
                 LOG(INFO) << "Starting event " << event_num << " with seed " << event_seed;
             } else {
@@ -785,109 +2243,180 @@ void ModuleManager::run(RandomNumberGenerator& seeder) {
                 event->restore_random_engine_state();
             }
 
-            while(module_iter != modules_.end()) {
-                auto module = *module_iter;
+            // Keep the log settings of the thread to restore them after running each module
+            const auto thread_log =
+                std::make_tuple(Log::getReportingLevel(), Log::getFormat(), Log::getSection(), Log::getEventNum());
 
-                LOG_PROGRESS(TRACE, "EVENT_LOOP")
-                    << "Running event " << event->number << " [" << module->get_identifier().getUniqueName() << "]";
+            for(; stage_index < this->pipeline_.size(); ++stage_index) {
+                const auto& stage = this->pipeline_[stage_index];
+                auto* module = stage.module;
 
-                // Check if the module is satisfied to run
-                if(!module->check_delegates(this->messenger_, event.get())) {
-                    LOG(TRACE) << "Not all required messages are received for " << module->get_identifier().getUniqueName()
-                               << ", skipping module!";
-                    ++module_iter;
-                    continue;
+                // Modules following the stage cache use the same random numbers whether the cache is written or replayed
+                if(stage.reseed_event) {
+                    event->getRandomEngine().seed(Philox4x64(event->getSeed(), 1)());
+                }
+                // Every branch of a section draws from its own random number stream of the event
+                if(stage.branch_stream != 0) {
+                    event->getRandomEngine().seed(Philox4x64(event->getSeed(), stage.branch_stream)());
                 }
 
-                // Get current time
-                auto start = std::chrono::steady_clock::now();
+                auto result = StageResult::FINISHED;
+                if(stage.batch != nullptr) {
+                    // Process the detector modules of the batch concurrently for the different detectors
+                    result = this->run_parallel_batch(*stage.batch, event.get(), plot, event_time);
+                    stage_index = stage.batch->end - 1;
+                } else {
+                    LOG_PROGRESS(TRACE, "EVENT_LOOP")
+                        << "Running event " << event->number << " [" << module->get_identifier().getUniqueName() << "]";
 
-                // Set module specific logging settings
-                auto old_settings = ModuleManager::set_module_before(
-                    module->get_identifier().getUniqueName(), module->get_configuration(), "R:", event->number);
-
-                // Run module
-                bool stop = false;
-                bool abort = false;
-                try {
-                    if(module->require_sequence() && event_num != thread_pool_->minimumUncompleted()) {
-                        stop = true;
-                    } else {
-                        module->run(event.get());
+                    // Skip the module if the event has been rejected or the module is not satisfied to run
+                    if(this->skip_stage(stage, event.get())) {
+                        if(stage.sequence != nullptr) {
+                            this->advance_sequence(*stage.sequence, event_num);
+                        }
+                        continue;
                     }
-                } catch(const MissingDependenciesException& e) {
-                    stop = true;
-                } catch(const AbortEventException& e) {
-                    LOG(WARNING) << "Event aborted:" << std::endl << e.what();
-                    abort = true;
-                } catch(const EndOfRunException& e) {
-                    // Terminate if the module threw the EndOfRun request exception:
-                    LOG(WARNING) << "Request to terminate:" << std::endl << e.what();
-                    this->terminate_ = true;
-                }
 
-                // Reset logging
-                ModuleManager::set_module_after(std::move(old_settings));
+                    // Park the event in the reorder buffer of the module if earlier events still need to pass it
+                    if(stage.sequence != nullptr) {
+                        std::unique_lock<std::mutex> sequence_lock{stage.sequence->mutex};
+                        if(this->compress_buffered_events_ && event_num != stage.sequence->next_event) {
+                            // Compress without holding the lock, the turn of the event might come in the meantime
+                            sequence_lock.unlock();
+                            compressed_bytes += event->get_local_messenger()->compressPayloads();
+                            compressed_events++;
+                            sequence_lock.lock();
+                        }
+                        if(event_num != stage.sequence->next_event) {
+                            LOG(DEBUG) << "Event " << event->number << " arrived early at "
+                                       << module->get_identifier().getUniqueName() << ", buffering...";
+                            event->store_random_engine_state();
+                            if(Tracer::enabled()) {
+                                Tracer::instant(this->trace_buffered_, event->number);
+                            }
+                            stage.sequence->waiting_events.emplace(
+                                event_num, [self_func, event, stage_index, event_time]() mutable {
+                                    event->get_local_messenger()->expandPayloads();
+                                    self_func(std::move(event), stage_index, event_time, self_func);
+                                });
+                            thread_pool_->holdBuffered();
+                            sequence_lock.unlock();
+
+                            this->run_released_events();
+                            return;
+                        }
+                        sequence_lock.unlock();
+                        event->get_local_messenger()->expandPayloads();
+                    }
 
-                // Update execution time
-                auto end = std::chrono::steady_clock::now();
-                auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
-                // Note: we do not need to lock a mutex because the std::map is not altered and its values are atomic.
-                this->module_execution_time_[module.get()] += duration;
-
-                if(plot) {
-                    std::lock_guard<std::mutex> stat_lock{event->stats_mutex_};
-                    event_time += duration;
-                    this->module_event_time_[module.get()]->Fill(
-                        std::chrono::duration<double>(std::chrono::nanoseconds(duration)).count());
+                    // Run module
+                    result = this->run_stage(stage, event.get(), thread_log, plot, event_time);
                 }
 
-                if(abort) {
+                if(result == StageResult::ABORTED) {
+                    // Let the event pass all remaining modules requiring the events in sequence
+                    for(auto index = stage_index; index < this->pipeline_.size(); ++index) {
+                        if(this->pipeline_[index].sequence != nullptr) {
+                            this->advance_sequence(*this->pipeline_[index].sequence, event_num);
+                        }
+                    }
+
                     // Break module execution loop:
                     aborted_events++;
                     break;
                 }
 
-                if(stop) {
+                if(result == StageResult::STOPPED) {
                     LOG(DEBUG) << "Event " << event->number
                                << " was interrupted because of missing dependencies, rescheduling...";
                     // Store state of PRNG engine:
                     event->store_random_engine_state();
+                    if(Tracer::enabled()) {
+                        Tracer::instant(this->trace_rescheduled_, event->number);
+                    }
                     // Reschedule the event:
-                    auto event_function = std::bind(self_func, event, module_iter, event_time, self_func);
-                    auto future = thread_pool_->submit(event->number, event_function, false);
-                    assert(future.valid() || !thread_pool_->valid());
+                    auto event_number = event->number;
+                    auto submitted = thread_pool_->submitDetached(
+                        event_number, [self_func, event = std::move(event), stage_index, event_time]() mutable {
+                            self_func(std::move(event), stage_index, event_time, self_func);
+                        });
+                    assert(submitted || !thread_pool_->valid());
+                    static_cast<void>(submitted);
                     auto buffered_events = thread_pool_->bufferedQueueSize();
                     LOG_PROGRESS(STATUS, "EVENT_LOOP") << "Buffered " << buffered_events << ", finished " << finished_events
                                                        << " of " << number_of_events << " events";
+                    this->run_released_events();
                     return;
                 }
 
-                ++module_iter;
+                if(stage.sequence != nullptr) {
+                    this->advance_sequence(*stage.sequence, event_num);
+                }
             }
 #pragma GCC diagnostic pop
 
             // All modules finished, mark as complete
             thread_pool_->markComplete(event->number);
-            LOG(INFO) << "Finished event " << event_num << " with seed " << event_seed;
+            if(event->isRejected()) {
+                rejected_events++;
+                LOG(INFO) << "Finished rejected event " << event_num << " with seed " << event_seed;
+            } else {
+                LOG(INFO) << "Finished event " << event_num << " with seed " << event_seed;
+            }
 
             auto buffered_events = thread_pool_->bufferedQueueSize();
+            if(Tracer::enabled()) {
+                Tracer::counter(this->trace_queued_events_, thread_pool_->queueSize());
+                Tracer::counter(this->trace_buffered_events_, buffered_events);
+            }
             if(plot) {
                 this->buffer_fill_level_->Fill(static_cast<double>(buffered_events));
                 event_time_->Fill(static_cast<double>(event_time) * 1e-9);
             }
+            if(MemoryAccounting::enabled()) {
+                this->account_event_memory(event.get(), plot);
+            }
+            if(this->record_dataflow_) {
+                this->account_event_dataflow(event.get());
+            }
 
-            finished_events++;
+            if(memory_budget > 0) {
+                // Measure the memory held by the messages of the event before releasing the next event
+                measured_memory += event->get_local_messenger()->getMemoryUsage();
+                measured_events++;
+                std::lock_guard<std::mutex> memory_lock{memory_mutex};
+                finished_events++;
+                memory_condition.notify_one();
+            } else {
+                finished_events++;
+            }
             LOG_PROGRESS(STATUS, "EVENT_LOOP") << "Buffered " << buffered_events << ", finished " << finished_events
                                                << " of " << number_of_events << " events";
+
+            // Continue the events released from the reorder buffers by this event
+            this->run_released_events();
+        };
+
+        auto event_function = [event_function_with_module]() mutable {
+            event_function_with_module(nullptr, size_t(0), 0, event_function_with_module);
         };
 
-        auto event_function =
-            std::bind(event_function_with_module, nullptr, modules_.begin(), 0, event_function_with_module);
+        if(events_per_task == 1) {
+            auto submitted = thread_pool_->submitDetached(std::move(event_function));
+            assert(submitted || !thread_pool_->valid());
+            static_cast<void>(submitted);
+            thread_pool_->checkException();
+        } else {
+            task_events.emplace_back(std::move(event_function));
+            if(task_events.size() == events_per_task || i == number_of_events + skip_events) {
+                submit_task_events();
+            }
+        }
+    }
 
-        auto future = thread_pool_->submit(event_function);
-        assert(future.valid() || !thread_pool_->valid());
-        thread_pool_->checkException();
+    // Submit the events collected for an incomplete task if the loop stopped early
+    if(!task_events.empty() && thread_pool_->valid()) {
+        submit_task_events();
     }
 
     LOG(TRACE) << "All events have been initialized. Waiting for thread pool to finish...";
@@ -898,16 +2427,57 @@ void ModuleManager::run(RandomNumberGenerator& seeder) {
     // Check exception for last events
     thread_pool_->checkException();
 
+    // Export the final metrics of the run
+    if(metrics_exporter != nullptr) {
+        metrics_exporter->stop();
+    }
+
     LOG_PROGRESS(STATUS, "EVENT_LOOP") << "Finished run of " << finished_events << " events";
+    cache_complete_ = !terminate_ && finished_events == number_of_events;
     global_config.set<uint64_t>("number_of_events", finished_events);
 
+    if(rejected_events > 0) {
+        LOG(STATUS) << "Rejected " << rejected_events << " events in this run";
+    }
     if(aborted_events > 0) {
         LOG(WARNING) << "Aborted " << aborted_events << " events in this run";
     }
 
+    // Report the number of events needed to converge and the precision achieved with all finished events
+    if(convergence_precision > 0) {
+        if(converged_events > 0) {
+            LOG(STATUS) << "Reached the relative precision of " << convergence_precision << " after " << converged_events
+                        << " events";
+        } else {
+            LOG(WARNING) << "Observables did not reach the relative precision of " << convergence_precision << " within "
+                         << finished_events << " events";
+        }
+        for(const auto& module : modules_) {
+            for(const auto& observable : module->getObservables()) {
+                auto value = observable.getValue();
+                LOG(STATUS) << " " << module->getUniqueName() << " " << observable.getName() << ": " << value << " +/- "
+                            << observable.getUncertainty() << " (relative "
+                            << (value != 0 ? observable.getUncertainty() / std::fabs(value) : 0.) << ")";
+            }
+        }
+    }
+
     auto end_time = std::chrono::steady_clock::now();
     run_time_ = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count());
 
+    if(memory_budget > 0 && measured_events > 0) {
+        auto memory_per_event = static_cast<double>(measured_memory) / static_cast<double>(measured_events);
+        auto events_per_second = static_cast<double>(finished_events) * 1e9 / static_cast<double>(run_time_);
+        LOG(STATUS) << "Kept at most " << max_events_in_flight << " events in flight with " << std::fixed
+                    << std::setprecision(3) << memory_per_event / 1024 / 1024 << "MB of messages per event on average"
+                    << " (memory budget " << memory_budget / 1024 / 1024 << "MB, " << events_per_second << " events/s)";
+    }
+
+    if(compressed_events > 0) {
+        LOG(STATUS) << "Compressed the payload of " << compressed_events << " buffered events, saving " << std::fixed
+                    << std::setprecision(3) << static_cast<double>(compressed_bytes) / 1024 / 1024 << "MB in total";
+    }
+
     LOG(TRACE) << "Destroying thread pool";
     thread_pool_.reset();
 }
@@ -935,13 +2505,25 @@ static std::string nanoseconds_to_time(uint64_t nanoseconds) {
 }
 
 /**
- * Sets the section header and logging settings before executing the  \ref Module::finalize() function. Reset the logging
- * after finalization. No method will be called after finalizing the module (except the destructor).
+ * The directories of the module instances are removed first, the common directory of a module is removed with its last
+ * instance. The ROOT files themselves are never removed.
  */
-void ModuleManager::finalize() {
-    auto start_time = std::chrono::steady_clock::now();
-    LOG_PROGRESS(TRACE, "FINALIZE_LOOP") << "Finalizing module instantiations";
-    for(auto& module : modules_) {
+void ModuleManager::remove_empty_directory(TDirectory* directory) {
+    while(directory != nullptr && directory->GetFile() != directory && directory->GetNkeys() == 0 &&
+          directory->GetList()->GetSize() == 0) {
+        auto* mother = directory->GetMotherDir();
+        if(mother == nullptr) {
+            return;
+        }
+        mother->cd();
+        mother->rmdir(directory->GetName());
+        directory = mother;
+    }
+}
+
+void ModuleManager::finalize_modules(ModuleList::iterator begin, ModuleList::iterator end) {
+    for(auto iter = begin; iter != end; ++iter) {
+        auto& module = *iter;
         LOG_PROGRESS(TRACE, "FINALIZE_LOOP") << "Finalizing " << module->get_identifier().getUniqueName();
 
         // Get current time
@@ -950,19 +2532,65 @@ void ModuleManager::finalize() {
         // Set module specific log settings
         auto old_settings = set_module_before(module->get_identifier().getUniqueName(), module->get_configuration(), "F:");
         // Change to our ROOT directory
-        module->getROOTDirectory()->cd();
+        auto* directory = module->getROOTDirectory();
+        directory->cd();
         // Finalize module
         module->finalize();
+        // Remove the ROOT directory if the module did not store anything, e.g. for a detector without any data
+        remove_empty_directory(directory);
         // Remove the pointer to the ROOT directory after finalizing
         module->set_ROOT_directory(nullptr);
         // Remove the config manager
         module->set_config_manager(nullptr);
         set_module_after(std::move(old_settings));
         // Update execution time
-        auto end = std::chrono::steady_clock::now();
-        module_execution_time_[module.get()] += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        auto stop = std::chrono::steady_clock::now();
+        module_execution_time_[module.get()] += std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+    }
+}
+
+/**
+ * Sets the section header and logging settings before executing the  \ref Module::finalize() function. Reset the logging
+ * after finalization. No method will be called after finalizing the module (except the destructor).
+ */
+void ModuleManager::finalize() {
+    auto start_time = std::chrono::steady_clock::now();
+    // Merge the per-thread copies of the histograms of all modules concurrently. The modules write to the common output
+    // file and are therefore finalized one after another, writing their histograms then only stores the merged copies
+    if(multithreading_flag_ && number_of_threads_ > 1) {
+        auto merge_start = std::chrono::steady_clock::now();
+        auto merged_histograms = ThreadedHistogramBase::mergeAll(number_of_threads_);
+        auto merge_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - merge_start).count();
+        LOG(DEBUG) << "Merged thread copies of " << merged_histograms << " histograms with " << number_of_threads_
+                   << " threads in " << merge_time << "s";
+    }
+
+    LOG_PROGRESS(TRACE, "FINALIZE_LOOP") << "Finalizing module instantiations";
+    finalize_modules(modules_.begin(), modules_.end());
+
+    // Publish the stage cache written by this run, the output of incomplete runs is discarded
+    if(cache_stage_ != nullptr && !cache_hit_) {
+        auto partial_file = cache_file_.parent_path() / ("partial_" + cache_file_.filename().string());
+        if(cache_complete_) {
+            std::filesystem::rename(partial_file, cache_file_);
+            LOG(STATUS) << "Stored stage cache " << cache_file_;
+        } else {
+            std::filesystem::remove(partial_file);
+            LOG(WARNING) << "Discarding stage cache of incomplete run";
+        }
     }
 
+    // Sum the hardware events counted for a module over all threads
+    auto counter_totals = [this](Module* module) {
+        PerformanceCounters::Values totals{};
+        for(const auto& values : module_counters_[module].per_thread) {
+            for(size_t event_type = 0; event_type < totals.size(); ++event_type) {
+                totals[event_type] += values[event_type];
+            }
+        }
+        return totals;
+    };
+
     // Store performance plots
     Configuration& global_config = conf_manager_->getGlobalConfiguration();
     if(global_config.get<bool>("performance_plots")) {
@@ -976,6 +2604,46 @@ void ModuleManager::finalize() {
         event_time_->Write();
         buffer_fill_level_->Write();
 
+        if(MemoryAccounting::enabled()) {
+            event_memory_->Write();
+
+            // Write the memory allocated and retained by every module per event with one labeled bin per module
+            auto nbins = static_cast<int>(modules_.size());
+            auto events = static_cast<double>(std::max<uint64_t>(memory_events_, 1));
+            TH1D allocated("module_memory_allocated", "memory allocated per event;;memory [MB]", nbins, 0, nbins);
+            TH1D retained("module_memory_retained", "memory retained per event;;memory [MB]", nbins, 0, nbins);
+            int bin = 1;
+            for(auto& module : modules_) {
+                const auto& memory = module_memory_[module.get()];
+                allocated.GetXaxis()->SetBinLabel(bin, module->getUniqueName().c_str());
+                allocated.SetBinContent(bin, static_cast<double>(memory.allocated) / events / 1024 / 1024);
+                retained.GetXaxis()->SetBinLabel(bin, module->getUniqueName().c_str());
+                retained.SetBinContent(
+                    bin,
+                    static_cast<double>(static_cast<int64_t>(memory.allocated - memory.released)) / events / 1024 / 1024);
+                bin++;
+            }
+            allocated.Write();
+            retained.Write();
+        }
+
+        if(PerformanceCounters::enabled()) {
+            // Write every hardware event counted per event with one labeled bin per module
+            auto nbins = static_cast<int>(modules_.size());
+            auto events = static_cast<double>(std::max<uint64_t>(global_config.get<uint64_t>("number_of_events"), 1));
+            for(size_t event_type = 0; event_type < PerformanceCounters::NUM_EVENTS; ++event_type) {
+                auto name = std::string(PerformanceCounters::getName(event_type));
+                TH1D histogram(("module_" + name).c_str(), (name + " per event;;# " + name).c_str(), nbins, 0, nbins);
+                int bin = 1;
+                for(auto& module : modules_) {
+                    histogram.GetXaxis()->SetBinLabel(bin, module->getUniqueName().c_str());
+                    histogram.SetBinContent(bin, static_cast<double>(counter_totals(module.get())[event_type]) / events);
+                    bin++;
+                }
+                histogram.Write();
+            }
+        }
+
         for(auto& module : modules_) {
             const auto& module_name = module->get_configuration().getName();
             auto* mod_dir = perf_dir->GetDirectory(module_name.c_str());
@@ -990,7 +2658,140 @@ void ModuleManager::finalize() {
 
             // Write the histogram
             module_event_time_[module.get()]->Write();
+
+            // Write the counters and timers of the module profiler with one labeled bin per entry
+            std::vector<Profiler::Entry> counters, timers;
+            for(auto& entry : module->getProfiler().summarize()) {
+                (entry.timer ? timers : counters).push_back(std::move(entry));
+            }
+            const auto& identifier = module->get_identifier().getIdentifier();
+            const auto& name = (identifier.empty() ? module->get_configuration().getName() : identifier);
+            auto write_entries = [&](const std::vector<Profiler::Entry>& entries, const std::string& type) {
+                if(entries.empty()) {
+                    return;
+                }
+                auto nbins = static_cast<int>(entries.size());
+                auto title = module_name + " profiler " + type + ";;" + (type == "timers" ? "time [s]" : "count");
+                TH1D histogram((name + "_" + type).c_str(), title.c_str(), nbins, 0, nbins);
+                for(int bin = 1; bin <= nbins; ++bin) {
+                    const auto& entry = entries[static_cast<size_t>(bin - 1)];
+                    histogram.GetXaxis()->SetBinLabel(bin, entry.name.c_str());
+                    histogram.SetBinContent(bin,
+                                            entry.timer ? static_cast<double>(Units::convert(entry.total, "s"))
+                                                        : static_cast<double>(entry.total));
+                }
+                histogram.Write();
+            };
+            write_entries(counters, "counters");
+            write_entries(timers, "timers");
+        }
+    }
+
+    // Write the timeline of the event loop
+    if(Tracer::enabled()) {
+        auto path = std::filesystem::path(gSystem->pwd()) / "trace.json";
+        try {
+            auto records = Tracer::write(path);
+            LOG(STATUS) << "Wrote timeline of the event loop with " << records << " records to " << path;
+        } catch(const std::runtime_error& e) {
+            throw RuntimeError("Cannot write timeline of the event loop: " + std::string(e.what()));
+        }
+    }
+
+    // Summarize the dataflow between the modules
+    if(record_dataflow_) {
+        write_dataflow();
+    }
+
+    // Write the machine-readable performance report
+    if(global_config.get<bool>("performance_report")) {
+        auto path = std::filesystem::path(gSystem->pwd()) / "performance.json";
+        std::ofstream report(path);
+        if(!report) {
+            throw RuntimeError("Cannot create performance report " + path.string());
+        }
+
+        auto write_values = [&report](const std::vector<uint64_t>& values) {
+            report << "[";
+            for(size_t i = 0; i < values.size(); ++i) {
+                report << (i == 0 ? "" : ", ") << values[i];
+            }
+            report << "]";
+        };
+
+        report << "{\n  \"run_time_ns\": " << run_time_ << ",\n  \"startup\": {\"phases\": {";
+        for(size_t i = 0; i < startup_phases_.size(); ++i) {
+            report << (i == 0 ? "" : ", ") << "\"" << startup_phases_[i].first << "\": " << startup_phases_[i].second;
+        }
+        report << "}, \"libraries\": {";
+        for(auto iter = library_load_time_.begin(); iter != library_load_time_.end(); ++iter) {
+            report << (iter == library_load_time_.begin() ? "" : ", ") << "\"" << iter->first << "\": " << iter->second;
+        }
+        report << "}},\n  \"modules\": [";
+        for(auto module_it = modules_.begin(); module_it != modules_.end(); ++module_it) {
+            const auto& module = *module_it;
+            auto startup_time = module_startup_time_.find(module.get());
+            report << (module_it == modules_.begin() ? "" : ",") << "\n    {\"name\": \"" << module->getUniqueName()
+                   << "\", \"execution_time_ns\": " << module_execution_time_[module.get()].load()
+                   << ", \"startup_time_ns\": " << (startup_time != module_startup_time_.end() ? startup_time->second : 0);
+
+            std::vector<Profiler::Entry> counters, timers;
+            for(auto& entry : module->getProfiler().summarize()) {
+                (entry.timer ? timers : counters).push_back(std::move(entry));
+            }
+            report << ", \"counters\": {";
+            for(size_t i = 0; i < counters.size(); ++i) {
+                report << (i == 0 ? "" : ", ") << "\"" << counters[i].name << "\": {\"total\": " << counters[i].total
+                       << ", \"per_thread\": ";
+                write_values(counters[i].per_thread);
+                report << "}";
+            }
+            report << "}, \"timers\": {";
+            for(size_t i = 0; i < timers.size(); ++i) {
+                report << (i == 0 ? "" : ", ") << "\"" << timers[i].name << "\": {\"total_ns\": " << timers[i].total
+                       << ", \"calls\": " << timers[i].calls << ", \"per_thread_ns\": ";
+                write_values(timers[i].per_thread);
+                report << "}";
+            }
+            report << "}";
+            if(MemoryAccounting::enabled()) {
+                const auto& memory = module_memory_[module.get()];
+                report << ", \"memory\": {\"allocated_bytes\": " << memory.allocated.load()
+                       << ", \"released_bytes\": " << memory.released.load()
+                       << ", \"allocations\": " << memory.allocations.load() << "}";
+            }
+            if(PerformanceCounters::enabled()) {
+                const auto& counters = module_counters_[module.get()];
+                auto totals = counter_totals(module.get());
+                report << ", \"hardware_counters\": {";
+                for(size_t event_type = 0; event_type < totals.size(); ++event_type) {
+                    std::vector<uint64_t> per_thread;
+                    for(const auto& values : counters.per_thread) {
+                        per_thread.push_back(values[event_type]);
+                    }
+                    report << (event_type == 0 ? "" : ", ") << "\"" << PerformanceCounters::getName(event_type)
+                           << "\": {\"total\": " << totals[event_type] << ", \"per_thread\": ";
+                    write_values(per_thread);
+                    report << "}";
+                }
+                report << "}";
+            }
+            report << "}";
         }
+        report << "\n  ]";
+        if(MemoryAccounting::enabled()) {
+            report << ",\n  \"memory\": {\"events\": " << memory_events_.load()
+                   << ", \"retained_bytes\": " << event_memory_retained_.load()
+                   << ", \"peak_event_bytes\": " << event_memory_peak_.load()
+                   << ", \"peak_resident_bytes\": " << MemoryAccounting::getPeakResidentMemory() << ", \"messages\": {";
+            for(auto iter = message_memory_.begin(); iter != message_memory_.end(); ++iter) {
+                report << (iter == message_memory_.begin() ? "" : ", ") << "\"" << allpix::demangle(iter->first.name())
+                       << "\": " << iter->second;
+            }
+            report << "}}";
+        }
+        report << "\n}\n";
+        LOG(STATUS) << "Wrote performance report to " << path;
     }
 
     // Close module ROOT file
@@ -1047,6 +2848,50 @@ void ModuleManager::finalize() {
                   << Units::display(module_execution_time_[module.get()].load(), {"s", "ms"});
     }
 
+    if(MemoryAccounting::enabled()) {
+        auto events = static_cast<double>(std::max<uint64_t>(memory_events_, 1));
+        auto megabytes = [](double bytes) {
+            std::stringstream mb;
+            mb << std::fixed << std::setprecision(3) << bytes / 1024 / 1024 << "MB";
+            return mb.str();
+        };
+        LOG(STATUS) << "Events retained " << megabytes(static_cast<double>(event_memory_retained_) / events)
+                    << " on average with a peak footprint of " << megabytes(static_cast<double>(event_memory_peak_))
+                    << ", peak resident memory of the process was "
+                    << megabytes(static_cast<double>(MemoryAccounting::getPeakResidentMemory()));
+        for(auto& module : modules_) {
+            const auto& memory = module_memory_[module.get()];
+            LOG(INFO) << " Module " << module->getUniqueName() << " allocated "
+                      << megabytes(static_cast<double>(memory.allocated) / events) << " in "
+                      << std::round(static_cast<double>(memory.allocations) / events) << " allocations and retained "
+                      << megabytes(static_cast<double>(static_cast<int64_t>(memory.allocated - memory.released)) / events)
+                      << " per event";
+        }
+        for(const auto& [type, memory] : message_memory_) {
+            LOG(INFO) << " Messages of type " << allpix::demangle(type.name()) << " held "
+                      << megabytes(static_cast<double>(memory) / events) << " per event";
+        }
+    }
+
+    if(PerformanceCounters::enabled()) {
+        LOG(STATUS) << "Hardware performance counters of the modules in the event loop:";
+        for(auto& module : modules_) {
+            auto totals = counter_totals(module.get());
+            auto instructions = static_cast<double>(totals[PerformanceCounters::INSTRUCTIONS]);
+            auto kilo_instructions = std::max(instructions, 1.) / 1000;
+            std::stringstream line;
+            line << " Module " << module->getUniqueName() << " ran " << instructions << " instructions in "
+                 << static_cast<double>(totals[PerformanceCounters::CYCLES]) << " cycles (" << std::fixed
+                 << std::setprecision(2)
+                 << instructions / std::max(static_cast<double>(totals[PerformanceCounters::CYCLES]), 1.) << " IPC), "
+                 << static_cast<double>(totals[PerformanceCounters::CACHE_MISSES]) / kilo_instructions
+                 << " cache misses and "
+                 << static_cast<double>(totals[PerformanceCounters::BRANCH_MISSES]) / kilo_instructions
+                 << " branch misses per 1000 instructions";
+            LOG(INFO) << line.str();
+        }
+    }
+
     auto processing_time = std::round(run_time_ / std::max(uint64_t(1), global_config.get<uint64_t>("number_of_events")));
     LOG(STATUS) << "Average processing time is \x1B[1m" << Units::display(processing_time, {"ms", "us"})
                 << "/event\x1B[0m, event generation at \x1B[1m"
@@ -12,20 +12,35 @@
 #ifndef ALLPIX_MODULE_MANAGER_H
 #define ALLPIX_MODULE_MANAGER_H
 
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <limits>
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <queue>
+#include <set>
+#include <string>
+#include <typeindex>
+#include <vector>
 
 #include <TDirectory.h>
 #include <TFile.h>
 #include <TH1D.h>
 
 #include "Module.hpp"
+#include "PerformanceCounters.hpp"
 #include "ThreadPool.hpp"
 #include "core/config/Configuration.hpp"
+#include "core/messenger/Messenger.hpp"
 #include "core/utils/log.h"
+#include "core/utils/prng.h"
 #include "tools/ROOT.h"
 
 namespace allpix {
@@ -81,8 +96,20 @@ namespace allpix {
          * @param messenger Pointer to the messenger
          * @param conf_manager Pointer to the configuration manager
          * @param geo_manager Pointer to the manager holding the geometry
+         * @param service True to defer the creation of the modules starting from the section of the server module to the
+         *                requests of a simulation service, see \ref startRequest
          */
-        void load(Messenger* messenger, ConfigManager* conf_manager, GeometryManager* geo_manager);
+        void load(Messenger* messenger, ConfigManager* conf_manager, GeometryManager* geo_manager, bool service = false);
+
+        /**
+         * @brief Record the duration of a startup phase of the framework preceding the loading of the modules
+         * @param name Name of the startup phase
+         * @param duration Duration of the phase in nanoseconds
+         *
+         * The phases are reported in the startup breakdown after the initialization of the modules, together with the
+         * phases of loading and initializing the modules recorded by the module manager itself.
+         */
+        void recordStartupPhase(std::string name, uint64_t duration);
 
         /**
          * @brief Initialize all modules before the event sequence
@@ -97,6 +124,36 @@ namespace allpix {
          */
         void run(RandomNumberGenerator& seeder);
 
+        /**
+         * @brief Get the number of points of the configured parameter sweep
+         * @return Number of values of the swept parameter, one if no parameter sweep is configured
+         */
+        size_t getSweepPoints() const { return std::max<size_t>(sweep_values_.size(), 1); }
+
+        /**
+         * @brief Prepare the next point of the parameter sweep by creating the swept modules again with the next value
+         * @warning Should be called after the \ref ModuleManager::run "run function" of the previous point
+         */
+        void nextSweepPoint();
+
+        /**
+         * @brief Create and initialize the modules of a request to the simulation service
+         * @param name Name of the request, used for the ROOT directories of the created modules
+         * @param output_directory Directory the created modules write their output files to
+         *
+         * The modules of the section of the server module and of all following sections are created from their
+         * configurations, all preceding modules are kept from the previous requests. For runs with checkpoints, the
+         * section of the checkpoint module takes the role of the server module and the created modules write their
+         * histograms to a separate main ROOT file in the output directory of the segment.
+         */
+        void startRequest(const std::string& name, const std::filesystem::path& output_directory);
+
+        /**
+         * @brief Finalize and destroy the modules created for the current request, completing their output
+         * @warning Should be called after the \ref ModuleManager::run "run function" of the request
+         */
+        void finishRequest();
+
         /**
          * @brief Finalize all modules after the event sequence
          * @warning Should be called after the \ref ModuleManager::initialize "run function"
@@ -109,7 +166,36 @@ namespace allpix {
          */
         void terminate();
 
+        /**
+         * @brief Check if the termination of the run has been requested, by the user or by a module ending the run
+         * @return True if the run has been terminated
+         */
+        bool isTerminated() const { return terminate_; }
+
     private:
+        /**
+         * @brief Load the library of a module section and create its module instantiations
+         * @param config Configuration of the section
+         * @param section Index of the section in the list of module configurations
+         */
+        void load_section(Configuration& config, size_t section);
+
+        /**
+         * @brief Set the value of the current sweep point in the configurations of the swept module
+         */
+        void apply_sweep_value();
+
+        /**
+         * @brief Finalize and destroy the modules of all sections starting from the first recreated section
+         */
+        void drop_recreated_modules();
+
+        /**
+         * @brief Create and initialize the modules of all sections starting from the first recreated section
+         * @return Number of created module instantiations
+         */
+        size_t create_recreated_modules();
+
         /**
          * @brief Create unique modules
          * @param library Void pointer to the loaded library
@@ -131,6 +217,22 @@ namespace allpix {
         std::vector<std::pair<ModuleIdentifier, Module*>>
         create_detector_modules(void*, Configuration&, Messenger*, GeometryManager*);
 
+        /**
+         * @brief Create a single detector module instance for multiple detectors
+         * @param library Void pointer to the loaded library
+         * @param config Configuration of the module
+         * @param messenger Pointer to the messenger
+         * @param instantiations Detectors selected by the section with their per-detector identifiers
+         * @param identifier Identifier suffix built from the input and output of the section
+         * @return The module instance together with its identifier
+         */
+        std::pair<ModuleIdentifier, Module*>
+        create_multi_detector_module(void*,
+                                     Configuration&,
+                                     Messenger*,
+                                     const std::vector<std::pair<std::shared_ptr<Detector>, ModuleIdentifier>>&,
+                                     const std::string&);
+
         /**
          * @brief Set module specific log setting before running init/run/finalize
          * @param mod_name Unique identifier of the module
@@ -149,8 +251,238 @@ namespace allpix {
          */
         static void set_module_after(std::tuple<LogLevel, LogFormat, std::string, uint64_t> prev);
 
+        /**
+         * @brief Set the config manager and create the ROOT directory of a module before its initialization
+         * @param module Module to prepare
+         * @warning Creates ROOT objects and should therefore only be called from the main thread
+         */
+        void prepare_module(Module* module);
+
+        /**
+         * @brief Initialize a single module with its module specific log settings and record the time spent
+         * @param module Module to initialize, needs to be prepared by \ref ModuleManager::prepare_module
+         */
+        void initialize_module(Module* module);
+
+        /**
+         * @brief Initialize a range of modules concurrently, running the modules of different detectors on separate threads
+         * @param begin Iterator to the first module of the range
+         * @param end Iterator past the last module of the range
+         */
+        void initialize_parallel(ModuleList::iterator begin, ModuleList::iterator end);
+
+        /**
+         * @brief Initialize a range of modules and book their performance histograms if requested
+         * @param begin Iterator to the first module of the range
+         * @param end Iterator past the last module of the range
+         */
+        void initialize_modules(ModuleList::iterator begin, ModuleList::iterator end);
+
+        /**
+         * @brief Finalize a range of modules with their module specific log settings and record the time spent
+         * @param begin Iterator to the first module of the range
+         * @param end Iterator past the last module of the range
+         */
+        void finalize_modules(ModuleList::iterator begin, ModuleList::iterator end);
+
+        /**
+         * @brief Remove a ROOT directory of a module and its parent directories as long as they hold no objects
+         * @param directory Directory to remove if empty
+         */
+        static void remove_empty_directory(TDirectory* directory);
+
+        struct SequenceBuffer;
+        struct ParallelBatch;
+        struct PipelineStage;
+
+        /**
+         * @brief Resolve the settings of all modules needed in the event loop into the \ref ModuleManager::pipeline_
+         * @warning Should be called after all modules are initialized and their performance histograms are booked
+         */
+        void compile_pipeline();
+
+        /**
+         * @brief Mark an event as having passed a module requiring the events in sequence and release the next event
+         * @param sequence Reorder buffer of the module
+         * @param event_num Number of the event which either ran or skipped the module
+         *
+         * A waiting event which is now allowed to run the module is queued to be continued by the calling thread via
+         * \ref ModuleManager::run_released_events.
+         */
+        void advance_sequence(SequenceBuffer& sequence, uint64_t event_num);
+
+        /**
+         * @brief Continue all events released by the calling thread from the reorder buffers
+         * @note Does nothing if called while already continuing released events on this thread
+         */
+        void run_released_events();
+
+        /**
+         * @brief Get the events released from the reorder buffers by the calling thread
+         * @return Queue of functions continuing the released events
+         */
+        static std::deque<ThreadPool::Task>& released_events();
+
+        /**
+         * @brief Outcome of running a module for an event
+         */
+        enum class StageResult {
+            FINISHED, ///< The module finished, the event continues with the next module
+            STOPPED,  ///< The module requested the event to be rescheduled because of missing dependencies
+            ABORTED,  ///< The module aborted the event
+        };
+
+        /**
+         * @brief Check if a module should be skipped for an event because it has been rejected or messages are missing
+         * @param stage Stage of the module
+         * @param event Event to process
+         * @return True if the module should not run for this event
+         */
+        bool skip_stage(const PipelineStage& stage, Event* event) const;
+
+        /**
+         * @brief Run a module for an event with its log settings and record the time spent
+         * @param stage Stage of the module to run
+         * @param event Event to process
+         * @param thread_log Log settings of the calling thread to restore after running the module
+         * @param plot If the processing time of the module should be histogrammed
+         * @param event_time Processing time of the event, incremented by the time spent in the module if plotting
+         * @return Outcome of running the module
+         */
+        StageResult run_stage(const PipelineStage& stage,
+                              Event* event,
+                              const std::tuple<LogLevel, LogFormat, std::string, uint64_t>& thread_log,
+                              bool plot,
+                              int64_t& event_time);
+
+        /**
+         * @brief Run a batch of detector modules for an event, processing the chains of different detectors concurrently
+         * @param batch Batch of stages to run
+         * @param event Event to process
+         * @param plot If the processing time of the modules should be histogrammed
+         * @param event_time Processing time of the event, incremented by the time spent in the modules if plotting
+         * @return Aborted if any module aborted the event, finished otherwise
+         *
+         * The calling thread offers the chains to idle workers of the thread pool and processes the chains not picked up
+         * itself, such that it never waits for a chain which has not been started yet.
+         */
+        StageResult run_parallel_batch(const ParallelBatch& batch, Event* event, bool plot, int64_t& event_time);
+
+        /**
+         * @brief Add the memory held by a finished event to the accounting of the run
+         * @param event Event which finished all modules
+         * @param plot If the peak memory footprint of the event should be histogrammed
+         */
+        void account_event_memory(Event* event, bool plot);
+
+        /**
+         * @brief Add the dependencies between the modules in a finished event to the dataflow of the run
+         * @param event Event which finished all modules
+         *
+         * The critical path of the event is the longest chain of modules connected by messages, weighted with the time
+         * spent in the modules for this event.
+         */
+        void account_event_dataflow(Event* event);
+
+        /**
+         * @brief Summarize the dataflow between the modules and write it as graph to the output directory
+         */
+        void write_dataflow();
+
+        /**
+         * @brief Check if all observables of the modules reached a relative statistical precision
+         * @param precision Required uncertainty of every observable relative to its value
+         * @return True if at least one observable is registered and all observables reached the precision
+         */
+        bool observables_converged(double precision) const;
+
+        /**
+         * @brief Create a new event, reusing the local messenger of a finished event if available
+         * @param event_num Number of the event
+         * @param seed Seed of the event
+         * @return Event which returns its local messenger to the pool when released
+         */
+        std::shared_ptr<Event> create_event(uint64_t event_num, uint64_t seed);
+
         using IdentifierToModuleMap = std::map<ModuleIdentifier, ModuleList::iterator>;
 
+        /**
+         * @brief Reorder buffer of a module which requires the events in sequence
+         *
+         * Events arriving before their turn are parked with the state needed to continue them, and are released by the
+         * event preceding them once it has passed the module.
+         */
+        struct SequenceBuffer {
+            std::mutex mutex;
+            // Event which is allowed to run the module next
+            uint64_t next_event{};
+            // Events which skip the module, e.g. because they were aborted, but have not reached their turn yet
+            std::set<uint64_t> passed_events;
+            // Events waiting for their turn, together with the function continuing them
+            std::map<uint64_t, ThreadPool::Task> waiting_events;
+        };
+
+        /**
+         * @brief Consecutive detector modules of the event loop which are processed concurrently for different detectors
+         *
+         * Messages to detector modules are only delivered if they belong to the detector of the receiving module, so the
+         * modules of one detector only depend on each other. The batch is split into one chain per detector holding its
+         * modules in the order of the configuration, and the chains of an event are processed concurrently.
+         */
+        struct ParallelBatch {
+            // Index of the first stage following the batch
+            size_t end{};
+            // Indices of the stages of each chain
+            std::vector<std::vector<size_t>> chains;
+        };
+
+        /**
+         * @brief Memory allocated and released by a module in the event loop, summed over all events and threads
+         */
+        struct ModuleMemory {
+            std::atomic<uint64_t> allocated{};
+            std::atomic<uint64_t> released{};
+            std::atomic<uint64_t> allocations{};
+        };
+
+        /**
+         * @brief Hardware events counted while a module runs in the event loop, summed over all events per thread
+         */
+        struct ModuleCounters {
+            std::vector<std::array<std::atomic<uint64_t>, PerformanceCounters::NUM_EVENTS>> per_thread;
+        };
+
+        /**
+         * @brief Module of the event loop with all settings resolved before the first event
+         */
+        struct PipelineStage {
+            Module* module{};
+            // Position of the stage in the pipeline
+            size_t index{};
+            // Module specific log settings, only set if different from the global settings
+            std::optional<LogLevel> log_level;
+            std::optional<LogFormat> log_format;
+            std::string section;
+            // Delegates which need to be satisfied for the module to run
+            std::vector<BaseDelegate*> required_delegates;
+            // Reorder buffer if the module requires the events in sequence
+            std::unique_ptr<SequenceBuffer> sequence;
+            std::atomic_int64_t* execution_time{};
+            ThreadedHistogram<TH1D>* event_time{};
+            // Batch of detector modules starting with this module if they are processed concurrently
+            std::unique_ptr<ParallelBatch> batch;
+            // Name of the module in the timeline of the event loop
+            size_t trace_name{};
+            // Memory allocated by the module in the event loop if the allocations are counted
+            ModuleMemory* memory{};
+            // Hardware events counted for the module if the performance counters are read
+            ModuleCounters* counters{};
+            // Reseed the random number generator of the event before this stage, set for the stage cache
+            bool reseed_event{};
+            // Random number stream of the event used by the stage if its section is one of several branches
+            uint64_t branch_stream{};
+        };
+
         ModuleList modules_;
         IdentifierToModuleMap id_to_module_;
 
@@ -161,28 +493,108 @@ namespace allpix {
         // Duration in ns
         std::map<Module*, std::atomic_int64_t> module_execution_time_;
         std::map<Module*, Histogram<TH1D>> module_event_time_;
+        std::vector<PipelineStage> pipeline_;
         Histogram<TH1D> event_time_;
         Histogram<TH1D> buffer_fill_level_;
 
+        // Accounting of the memory of the events if the allocations are counted, sizes in bytes
+        std::map<Module*, ModuleMemory> module_memory_;
+        std::map<std::type_index, uint64_t> message_memory_;
+        std::mutex message_memory_mutex_;
+        std::atomic<uint64_t> memory_events_{};
+        std::atomic<int64_t> event_memory_retained_{};
+        std::atomic<int64_t> event_memory_peak_{};
+        Histogram<TH1D> event_memory_;
+
+        // Hardware events counted in the modules if the performance counters are read
+        std::map<Module*, ModuleCounters> module_counters_;
+
+        /**
+         * @brief Messages sent from one module of the pipeline to a later one, summed over all events
+         */
+        struct DataflowEdge {
+            uint64_t events{};
+            std::set<std::type_index> types;
+        };
+
+        // Dataflow between the modules if recorded, all times in ns and indexed by the stages of the pipeline
+        bool record_dataflow_{false};
+        std::map<const Module*, size_t> module_stages_;
+        std::vector<size_t> slot_stages_;
+        std::map<std::pair<size_t, size_t>, DataflowEdge> dataflow_edges_;
+        std::vector<int64_t> stage_dataflow_time_;
+        std::vector<int64_t> critical_time_;
+        std::vector<uint64_t> critical_events_;
+        int64_t dataflow_critical_time_{};
+        uint64_t dataflow_events_{};
+        std::mutex dataflow_mutex_;
+
+        // Names of the records of the event loop in the timeline
+        size_t trace_buffered_{}, trace_rescheduled_{}, trace_queued_events_{}, trace_buffered_events_{};
+
         // Durations in ns
         uint64_t initialize_time_{}, run_time_{}, finalize_time_{};
 
+        // Durations of the startup phases until the first event, of loading every module library and of constructing and
+        // initializing every module in ns
+        std::vector<std::pair<std::string, uint64_t>> startup_phases_;
+        std::map<std::string, uint64_t> library_load_time_;
+        std::map<const Module*, int64_t> module_startup_time_;
+
         std::map<std::string, void*> loaded_libraries_;
 
         std::atomic<bool> terminate_;
 
         Messenger* messenger_{};
+        GeometryManager* geo_manager_{};
+
+        // Parameter sweep, the modules of all sections starting from the first swept section are created for every point.
+        // The requests of a simulation service create the sections starting from the section of the server module in the
+        // same way.
+        std::string sweep_module_;
+        std::string sweep_parameter_;
+        std::vector<std::string> sweep_values_;
+        size_t sweep_point_{};
+        size_t sweep_section_{std::numeric_limits<size_t>::max()};
+        // Name and output directory of the current sweep point or request
+        std::string point_name_;
+        std::filesystem::path point_directory_;
+        // Runs with checkpoints create the sections starting from the checkpoint module for every segment of events, which
+        // stores the histograms in its own main ROOT file such that completed segments are self-contained
+        bool checkpoints_{};
+        std::unique_ptr<TFile> point_file_;
+        std::map<const Module*, size_t> module_section_;
+
+        // Stage cache storing or replaying the messages of all sections preceding the cache module
+        size_t cache_section_{std::numeric_limits<size_t>::max()};
+        std::optional<Configuration> cache_config_;
+        std::filesystem::path cache_file_;
+        Module* cache_stage_{};
+        bool cache_hit_{};
+        bool cache_complete_{};
+
+        // Local messengers of finished events, reused to keep the storage of their message slots allocated. Needs to be
+        // declared before the thread pool such that it outlives the events still held by the pool.
+        std::vector<std::unique_ptr<LocalMessenger>> local_messenger_pool_;
+        std::mutex local_messenger_pool_mutex_;
 
         // The thread pool used in the run method
         std::unique_ptr<ThreadPool> thread_pool_{nullptr};
 
         // User defined multithreading flags and parameters from configuration
         bool multithreading_flag_{false};
+        bool parallel_initialization_{false};
+        bool parallel_detectors_{false};
         unsigned int number_of_threads_{0};
         size_t max_buffer_size_{1};
+        bool compress_buffered_events_{false};
+        ThreadPool::QueueLayout queue_layout_{ThreadPool::QueueLayout::SHARDED};
 
         // Possibility of running loaded modules in parallel
         bool can_parallelize_{true};
+
+        // Pseudo-random number engine used for the events
+        RandomNumberGenerator::Engine random_engine_{RandomNumberGenerator::Engine::MT19937_64};
     };
 } // namespace allpix
 
@@ -0,0 +1,61 @@
+/**
+ * @file
+ * @brief Implementation of observables monitored for the convergence of a run
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "Observable.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace allpix;
+
+void Observable::add(double value, double weight) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_++;
+    sum_weights_ += weight;
+    sum_weights2_ += weight * weight;
+    sum_values_ += weight * value;
+    sum_values2_ += weight * value * value;
+}
+
+uint64_t Observable::getEntries() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_;
+}
+
+double Observable::getValue() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(sum_weights_ <= 0) {
+        return 0;
+    }
+    auto mean = sum_values_ / sum_weights_;
+    if(type_ == Type::MEAN) {
+        return mean;
+    }
+    return std::sqrt(std::max(sum_values2_ / sum_weights_ - mean * mean, 0.));
+}
+
+/**
+ * The uncertainty of the mean is the standard deviation divided by the square root of the effective number of entries
+ * given by the weights. For the width, the uncertainty of the standard deviation of a normal distribution is used.
+ */
+double Observable::getUncertainty() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(entries_ < 2 || sum_weights_ <= 0 || sum_weights2_ <= 0) {
+        return 0;
+    }
+    auto mean = sum_values_ / sum_weights_;
+    auto width = std::sqrt(std::max(sum_values2_ / sum_weights_ - mean * mean, 0.));
+    auto effective_entries = sum_weights_ * sum_weights_ / sum_weights2_;
+    if(type_ == Type::MEAN) {
+        return width / std::sqrt(effective_entries);
+    }
+    return width / std::sqrt(2 * effective_entries);
+}
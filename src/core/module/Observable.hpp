@@ -0,0 +1,89 @@
+/**
+ * @file
+ * @brief Definition of observables monitored for the convergence of a run
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_MODULE_OBSERVABLE_H
+#define ALLPIX_MODULE_OBSERVABLE_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace allpix {
+    /**
+     * @brief Observable of a module estimated from weighted samples, with the statistical uncertainty of the estimate
+     *
+     * The observable is either the mean or the width (standard deviation) of the samples added during the event loop, e.g.
+     * an efficiency as the mean of samples which are zero or one. The uncertainty is derived from the width of the samples
+     * and the effective number of entries. Samples can be added concurrently from all threads.
+     */
+    class Observable {
+    public:
+        /**
+         * @brief Property of the sample distribution estimated by the observable
+         */
+        enum class Type {
+            MEAN,  ///< Mean of the samples
+            WIDTH, ///< Standard deviation of the samples
+        };
+
+        /**
+         * @brief Construct an observable without samples
+         * @param name Name of the observable
+         * @param type Property of the samples which is estimated
+         */
+        Observable(std::string name, Type type) : name_(std::move(name)), type_(type) {}
+
+        /**
+         * @brief Add a sample
+         * @param value Value of the sample
+         * @param weight Weight of the sample
+         */
+        void add(double value, double weight = 1);
+
+        /**
+         * @brief Get the name of the observable
+         * @return Name of the observable
+         */
+        const std::string& getName() const { return name_; }
+
+        /**
+         * @brief Get the number of samples added so far
+         * @return Number of samples
+         */
+        uint64_t getEntries() const;
+
+        /**
+         * @brief Get the current estimate of the observable
+         * @return Mean or standard deviation of the samples, zero without samples
+         */
+        double getValue() const;
+
+        /**
+         * @brief Get the statistical uncertainty of the current estimate
+         * @return Uncertainty of the estimate, zero with less than two samples
+         */
+        double getUncertainty() const;
+
+    private:
+        std::string name_;
+        Type type_;
+
+        mutable std::mutex mutex_;
+        uint64_t entries_{};
+        double sum_weights_{};
+        double sum_weights2_{};
+        double sum_values_{};
+        double sum_values2_{};
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_MODULE_OBSERVABLE_H */
@@ -0,0 +1,144 @@
+/**
+ * @file
+ * @brief Implementation of the reading of hardware performance counters for the modules of the event loop
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "PerformanceCounters.hpp"
+
+#include <array>
+#include <vector>
+
+#if defined(__linux__)
+#define ALLPIX_PERFORMANCE_COUNTERS
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace allpix;
+
+bool PerformanceCounters::enabled_{false};
+
+#ifdef ALLPIX_PERFORMANCE_COUNTERS
+namespace {
+    /**
+     * @brief Group of counters of a single thread, opened on construction and closed on destruction
+     */
+    class ThreadCounters {
+    public:
+        ThreadCounters() {
+            constexpr std::array<uint64_t, PerformanceCounters::NUM_EVENTS> configs{PERF_COUNT_HW_CPU_CYCLES,
+                                                                                  PERF_COUNT_HW_INSTRUCTIONS,
+                                                                                  PERF_COUNT_HW_CACHE_MISSES,
+                                                                                  PERF_COUNT_HW_BRANCH_MISSES};
+            positions_.fill(PerformanceCounters::NUM_EVENTS);
+            for(size_t event = 0; event < configs.size(); ++event) {
+                struct perf_event_attr attr {};
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.size = sizeof(attr);
+                attr.config = configs[event];
+                attr.read_format = PERF_FORMAT_GROUP;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                if(leader_ < 0) {
+                    // The group is started once all counters are opened
+                    attr.disabled = 1;
+                }
+
+                // Count the calling thread on any CPU, all counters of the group are read at once through the first one
+                auto fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader_, 0));
+                if(fd < 0) {
+                    if(leader_ < 0) {
+                        // Without the processor cycles the group cannot be formed
+                        return;
+                    }
+                    continue;
+                }
+                if(leader_ < 0) {
+                    leader_ = fd;
+                } else {
+                    members_.push_back(fd);
+                }
+                positions_[event] = opened_++;
+            }
+            ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+
+        ~ThreadCounters() {
+            for(auto fd : members_) {
+                close(fd);
+            }
+            if(leader_ >= 0) {
+                close(leader_);
+            }
+        }
+
+        ThreadCounters(const ThreadCounters&) = delete;
+        ThreadCounters& operator=(const ThreadCounters&) = delete;
+        ThreadCounters(ThreadCounters&&) = delete;
+        ThreadCounters& operator=(ThreadCounters&&) = delete;
+
+        bool valid() const { return leader_ >= 0; }
+
+        PerformanceCounters::Values read() const {
+            PerformanceCounters::Values values{};
+            if(leader_ < 0) {
+                return values;
+            }
+
+            // The group is read as the number of counters followed by their values in the order of opening
+            std::array<uint64_t, PerformanceCounters::NUM_EVENTS + 1> buffer{};
+            if(::read(leader_, buffer.data(), sizeof(buffer)) < static_cast<ssize_t>(sizeof(uint64_t))) {
+                return values;
+            }
+            for(size_t event = 0; event < values.size(); ++event) {
+                if(positions_[event] < buffer[0]) {
+                    values[event] = buffer[positions_[event] + 1];
+                }
+            }
+            return values;
+        }
+
+    private:
+        int leader_{-1};
+        std::vector<int> members_;
+        // Position of every event in the values read from the group, past the opened counters if not available
+        std::array<size_t, PerformanceCounters::NUM_EVENTS> positions_{};
+        size_t opened_{};
+    };
+
+    const ThreadCounters& thread_counters() {
+        thread_local ThreadCounters counters;
+        return counters;
+    }
+} // namespace
+#endif
+
+bool PerformanceCounters::enable() {
+#ifdef ALLPIX_PERFORMANCE_COUNTERS
+    enabled_ = thread_counters().valid();
+#endif
+    return enabled_;
+}
+
+const char* PerformanceCounters::getName(size_t event) {
+    static constexpr std::array<const char*, NUM_EVENTS> names{"cycles", "instructions", "cache_misses", "branch_misses"};
+    return names.at(event);
+}
+
+PerformanceCounters::Values PerformanceCounters::read() {
+#ifdef ALLPIX_PERFORMANCE_COUNTERS
+    if(enabled_) {
+        return thread_counters().read();
+    }
+#endif
+    return {};
+}
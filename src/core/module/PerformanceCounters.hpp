@@ -0,0 +1,83 @@
+/**
+ * @file
+ * @brief Definition of the reading of hardware performance counters for the modules of the event loop
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_MODULE_PERFORMANCE_COUNTERS_H
+#define ALLPIX_MODULE_PERFORMANCE_COUNTERS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace allpix {
+    /**
+     * @brief Static class reading the hardware performance counters of the calling thread
+     *
+     * The counters are read through the performance events of the Linux kernel, such that no additional library is
+     * required. Every thread opens its own group of counters on its first read, which count the events of this thread in
+     * user space only. The difference of two reads on the same thread thus attributes the events to the code executed in
+     * between. Counters not provided by the processor, e.g. in virtual machines, stay at zero. On other platforms, or if
+     * the kernel does not permit access to the counters, nothing is counted.
+     */
+    class PerformanceCounters {
+    public:
+        /**
+         * @brief Hardware events counted for every thread
+         */
+        enum Event : size_t {
+            CYCLES = 0,    ///< Processor cycles
+            INSTRUCTIONS,  ///< Retired instructions
+            CACHE_MISSES,  ///< Misses of the last level cache
+            BRANCH_MISSES, ///< Mispredicted branches
+            NUM_EVENTS,
+        };
+
+        /**
+         * @brief Values of all counted events, indexed by \ref Event
+         */
+        using Values = std::array<uint64_t, NUM_EVENTS>;
+
+        /**
+         * @brief Delete default constructor (only static access)
+         */
+        PerformanceCounters() = delete;
+
+        /**
+         * @brief Enable the counters after checking that they can be opened on the calling thread
+         * @return True if at least the processor cycles can be counted, false otherwise
+         * @warning Should be called before the threads reading the counters are started
+         */
+        static bool enable();
+
+        /**
+         * @brief Check if the counters are enabled
+         * @return True if the counters are read
+         */
+        static bool enabled() { return enabled_; }
+
+        /**
+         * @brief Get the name of a counted event as used in the reports
+         * @param event Counted event
+         * @return Name of the event
+         */
+        static const char* getName(size_t event);
+
+        /**
+         * @brief Read the current values of the counters of the calling thread
+         * @return Counted events since the counters of the thread were opened, zero if the counters are not enabled
+         */
+        static Values read();
+
+    private:
+        static bool enabled_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_MODULE_PERFORMANCE_COUNTERS_H */
@@ -0,0 +1,72 @@
+/**
+ * @file
+ * @brief Implementation of lightweight counters and timers for the instrumentation of modules
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "Profiler.hpp"
+
+#include <atomic>
+
+using namespace allpix;
+
+Profiler::Profiler() {
+    static std::atomic<uint64_t> next_id{0};
+    id_ = next_id++;
+}
+
+size_t Profiler::registerCounter(std::string name) {
+    counter_names_.push_back(std::move(name));
+    return counter_names_.size() - 1;
+}
+
+size_t Profiler::registerTimer(std::string name) {
+    timer_names_.push_back(std::move(name));
+    return timer_names_.size() - 1;
+}
+
+Profiler::ThreadValues& Profiler::local() {
+    // Values of all profilers used by this thread, identified by the profiler id since addresses may be reused
+    thread_local std::vector<std::pair<uint64_t, ThreadValues*>> thread_cache;
+    for(const auto& [id, values] : thread_cache) {
+        if(id == id_) {
+            return *values;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& values = thread_values_.emplace_back();
+    values.counters.resize(counter_names_.size());
+    values.timers.resize(timer_names_.size());
+    thread_cache.emplace_back(id_, &values);
+    return values;
+}
+
+std::vector<Profiler::Entry> Profiler::summarize() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<Entry> entries;
+    for(size_t i = 0; i < counter_names_.size(); ++i) {
+        Entry entry{counter_names_[i], false, 0, 0, {}};
+        for(const auto& values : thread_values_) {
+            entry.total += values.counters[i];
+            entry.per_thread.push_back(values.counters[i]);
+        }
+        entries.push_back(std::move(entry));
+    }
+    for(size_t i = 0; i < timer_names_.size(); ++i) {
+        Entry entry{timer_names_[i], true, 0, 0, {}};
+        for(const auto& values : thread_values_) {
+            entry.total += values.timers[i].first;
+            entry.calls += values.timers[i].second;
+            entry.per_thread.push_back(values.timers[i].first);
+        }
+        entries.push_back(std::move(entry));
+    }
+    return entries;
+}
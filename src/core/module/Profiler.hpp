@@ -0,0 +1,154 @@
+/**
+ * @file
+ * @brief Definition of lightweight counters and timers for the instrumentation of modules
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_MODULE_PROFILER_H
+#define ALLPIX_MODULE_PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace allpix {
+    /**
+     * @brief Counters and timers of a module, aggregated per thread without locking
+     *
+     * Counters and timers are registered by name before the event loop, i.e. in the constructor or the initialization of a
+     * module, and are referred to by the returned index. Every thread accumulates into its own set of values, which is only
+     * allocated on the first use by this thread. The values of all threads are combined after the event loop, when the
+     * framework writes the performance report. Adding to a counter requires a short lookup of the values of the calling
+     * thread, counts of tight loops should therefore be accumulated locally and added once per call of the loop.
+     */
+    class Profiler {
+        /**
+         * @brief Values accumulated by a single thread
+         */
+        struct ThreadValues {
+            std::vector<uint64_t> counters;
+            // Total time in nanoseconds and number of calls of every timer
+            std::vector<std::pair<uint64_t, uint64_t>> timers;
+        };
+
+    public:
+        /**
+         * @brief Summary of a counter or timer over all threads
+         */
+        struct Entry {
+            std::string name;
+            bool timer{};
+            // Sum of all counts, or total time in nanoseconds for timers
+            uint64_t total{};
+            // Number of timed scopes, zero for counters
+            uint64_t calls{};
+            // Contribution of every thread to the total
+            std::vector<uint64_t> per_thread;
+        };
+
+        /**
+         * @brief Timer adding the time spent in its scope to a timer of the profiler
+         */
+        class ScopedTimer {
+        public:
+            /**
+             * @brief Start timing the current scope
+             * @param profiler Profiler holding the timer
+             * @param timer Index of the timer returned by \ref Profiler::registerTimer
+             */
+            ScopedTimer(Profiler& profiler, size_t timer)
+                : values_(profiler.local()), timer_(timer), start_(std::chrono::steady_clock::now()) {}
+
+            /**
+             * @brief Add the elapsed time to the timer
+             */
+            ~ScopedTimer() {
+                auto elapsed = std::chrono::steady_clock::now() - start_;
+                auto& timer = values_.timers[timer_];
+                timer.first += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+                ++timer.second;
+            }
+
+            /// @{
+            /**
+             * @brief Disallow copying and moving the timer
+             */
+            ScopedTimer(const ScopedTimer&) = delete;
+            ScopedTimer& operator=(const ScopedTimer&) = delete;
+            ScopedTimer(ScopedTimer&&) = delete;
+            ScopedTimer& operator=(ScopedTimer&&) = delete;
+            /// @}
+
+        private:
+            ThreadValues& values_;
+            size_t timer_;
+            std::chrono::steady_clock::time_point start_;
+        };
+
+        /**
+         * @brief Construct an empty profiler
+         */
+        Profiler();
+
+        /**
+         * @brief Register a counter, needs to be called before the event loop
+         * @param name Name of the counter in the report
+         * @return Index of the counter
+         */
+        size_t registerCounter(std::string name);
+
+        /**
+         * @brief Register a timer, needs to be called before the event loop
+         * @param name Name of the timer in the report
+         * @return Index of the timer
+         */
+        size_t registerTimer(std::string name);
+
+        /**
+         * @brief Add to a counter of the calling thread
+         * @param counter Index of the counter returned by \ref Profiler::registerCounter
+         * @param value Value to add
+         */
+        void count(size_t counter, uint64_t value = 1) { local().counters[counter] += value; }
+
+        /**
+         * @brief Check if any counter or timer is registered
+         * @return True if the profiler holds no counters or timers
+         */
+        bool empty() const { return counter_names_.empty() && timer_names_.empty(); }
+
+        /**
+         * @brief Combine the values of all threads, should only be called after the event loop
+         * @return Summary of all counters followed by all timers
+         */
+        std::vector<Entry> summarize() const;
+
+    private:
+        /**
+         * @brief Get the values of the calling thread, allocating them on first use
+         * @return Values of the calling thread
+         */
+        ThreadValues& local();
+
+        // Unique identifier of this profiler, used to find the values of the calling thread
+        uint64_t id_;
+
+        std::vector<std::string> counter_names_;
+        std::vector<std::string> timer_names_;
+
+        // Values of all threads, a list keeps the addresses stable when further threads are added
+        mutable std::mutex mutex_;
+        std::list<ThreadValues> thread_values_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_MODULE_PROFILER_H */
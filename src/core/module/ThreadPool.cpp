@@ -10,16 +10,84 @@
  */
 
 #include "ThreadPool.hpp"
+#include "Tracer.hpp"
 
 #include <cassert>
+#include <chrono>
 
 #include "Module.hpp"
+#include "core/utils/numa.h"
 
 using namespace allpix;
 
 std::map<std::thread::id, unsigned int> ThreadPool::thread_nums_;
 std::atomic_uint ThreadPool::thread_cnt_{1u};
 std::atomic_uint ThreadPool::thread_total_{1u};
+std::atomic_uint ThreadPool::thread_idle_{0u};
+thread_local ThreadPool* ThreadPool::current_pool_{nullptr};
+
+/**
+ * Tasks are created on the thread submitting them and destroyed on the worker executing them, a single list of unused nodes
+ * shared by all threads is therefore used instead of lists per thread.
+ */
+struct ThreadPool::Task::NodePool {
+    std::mutex mutex;
+    Node* free{nullptr};
+};
+
+ThreadPool::Task::NodePool& ThreadPool::Task::node_pool() {
+    static NodePool pool;
+    return pool;
+}
+
+ThreadPool::Task::Node* ThreadPool::Task::acquire_node() {
+    auto& pool = node_pool();
+    {
+        std::lock_guard<std::mutex> lock{pool.mutex};
+        if(pool.free != nullptr) {
+            auto* node = pool.free;
+            pool.free = node->next;
+            node->next = nullptr;
+            return node;
+        }
+    }
+    return new Node();
+}
+
+void ThreadPool::Task::release_node(Node* node) {
+    auto& pool = node_pool();
+    std::lock_guard<std::mutex> lock{pool.mutex};
+    node->invoke = nullptr;
+    node->destroy = nullptr;
+    node->next = pool.free;
+    pool.free = node;
+}
+
+ThreadPool::Task::~Task() { reset(); }
+
+ThreadPool::Task::Task(Task&& other) noexcept : node_(other.node_) { other.node_ = nullptr; }
+
+ThreadPool::Task& ThreadPool::Task::operator=(Task&& other) noexcept {
+    if(this != &other) {
+        reset();
+        node_ = other.node_;
+        other.node_ = nullptr;
+    }
+    return *this;
+}
+
+void ThreadPool::Task::operator()() {
+    assert(node_ != nullptr);
+    node_->invoke(node_->storage);
+}
+
+void ThreadPool::Task::reset() {
+    if(node_ != nullptr) {
+        node_->destroy(node_->storage);
+        release_node(node_);
+        node_ = nullptr;
+    }
+}
 
 /**
  * The threads are created in an exception-safe way and all of them will be destroyed when creation of one fails
@@ -36,8 +104,10 @@ ThreadPool::ThreadPool(unsigned int num_threads,
                        unsigned int max_queue_size,
                        unsigned int max_buffered_size,
                        const std::function<void()>& worker_init_function,
-                       const std::function<void()>& worker_finalize_function)
-    : queue_(max_queue_size, max_buffered_size) {
+                       const std::function<void()>& worker_finalize_function,
+                       QueueLayout queue_layout)
+    : queue_(max_queue_size, max_buffered_size, (queue_layout == QueueLayout::SHARDED ? num_threads : 1u)),
+      busy_time_(num_threads) {
     assert(max_buffered_size == 0 || max_buffered_size >= num_threads);
     // Create threads
     try {
@@ -78,6 +148,24 @@ void ThreadPool::checkException() {
     }
 }
 
+/**
+ * The task is counted before pushing it, such that a worker finishing it right away cannot decrement the count first
+ */
+bool ThreadPool::push_task(uint64_t n, Task task, bool wait) {
+    {
+        std::unique_lock<std::mutex> lock{run_mutex_};
+        ++run_cnt_;
+    }
+    auto success = (n == UINT64_MAX ? queue_.push(std::move(task), wait) : queue_.push(n, std::move(task), wait));
+    if(!success) {
+        std::unique_lock<std::mutex> lock{run_mutex_};
+        if(--run_cnt_ == 0) {
+            run_condition_.notify_all();
+        }
+    }
+    return success;
+}
+
 void ThreadPool::wait() {
     std::unique_lock<std::mutex> lock{run_mutex_};
     run_condition_.wait(lock, [this]() { return exception_ptr_ != nullptr || (run_cnt_ == 0 || done_ == true); });
@@ -94,20 +182,38 @@ void ThreadPool::worker(size_t min_thread_buffer,
         unsigned int thread_num = thread_cnt_++;
         assert(thread_num < thread_total_);
         thread_nums_[std::this_thread::get_id()] = thread_num;
+        current_pool_ = this;
+
+        // Pin the worker to its CPU if requested, the main thread holds the first thread number
+        NUMA::pinWorker(thread_num - 1);
 
         // Initialize the worker
         if(initialize_function) {
             initialize_function();
         }
 
+        // Record the time spent waiting for tasks in the timeline if requested
+        auto wait_name = Tracer::registerName("wait for task");
+
         while(!done_) {
-            Task task{nullptr};
+            Task task;
 
-            if(queue_.pop(task, min_thread_buffer)) {
-                // Execute task
-                (*task)();
-                // Fetch the future to propagate exceptions
-                task->get_future().get();
+            auto wait_start = std::chrono::steady_clock::now();
+            ++thread_idle_;
+            auto popped = queue_.pop(task, min_thread_buffer, thread_num);
+            --thread_idle_;
+            if(popped) {
+                if(Tracer::enabled()) {
+                    Tracer::complete(wait_name, wait_start, std::chrono::steady_clock::now());
+                }
+                // Execute task, exceptions are propagated to the pool
+                auto task_start = std::chrono::steady_clock::now();
+                task();
+                if(thread_num - 1 < busy_time_.size()) {
+                    busy_time_[thread_num - 1] +=
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - task_start)
+                            .count();
+                }
                 // Update the run count and propagate update
                 std::unique_lock<std::mutex> lock{run_mutex_};
                 if(--run_cnt_ == 0) {
@@ -117,6 +223,7 @@ void ThreadPool::worker(size_t min_thread_buffer,
         }
 
         // Execute the cleanup function at the end of run
+        current_pool_ = nullptr;
         if(finalize_function) {
             finalize_function();
         }
@@ -145,6 +252,8 @@ void ThreadPool::destroy() {
     for(auto& thread : threads_) {
         if(thread.joinable()) {
             thread.join();
+            // Release the number of the thread such that the workers of a later pool are numbered the same way
+            thread_cnt_--;
         }
     }
 
@@ -156,6 +265,15 @@ void ThreadPool::destroy() {
 
 bool ThreadPool::valid() { return queue_.valid() && !done_; }
 
+std::vector<int64_t> ThreadPool::busyTime() const {
+    std::vector<int64_t> busy_time;
+    busy_time.reserve(busy_time_.size());
+    for(const auto& time : busy_time_) {
+        busy_time.push_back(time.load());
+    }
+    return busy_time;
+}
+
 unsigned int ThreadPool::threadNum() {
     auto iter = thread_nums_.find(std::this_thread::get_id());
     if(iter != thread_nums_.end()) {
@@ -167,3 +285,7 @@ unsigned int ThreadPool::threadNum() {
 unsigned int ThreadPool::threadCount() { return thread_total_; }
 
 void ThreadPool::registerThreadCount(unsigned int cnt) { thread_total_ += cnt; }
+
+unsigned int ThreadPool::idleThreadCount() { return thread_idle_; }
+
+ThreadPool* ThreadPool::current() { return current_pool_; }
@@ -14,15 +14,22 @@
 
 #include <algorithm>
 #include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <exception>
 #include <functional>
 #include <future>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <set>
 #include <thread>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace allpix {
     /**
@@ -30,15 +37,117 @@ namespace allpix {
      */
     class ThreadPool {
     public:
+        /**
+         * @brief Layout of the queue holding the standard jobs
+         */
+        enum class QueueLayout {
+            LEGACY,  ///< Single queue shared by all workers
+            SHARDED, ///< One queue per worker, stealing from the queues of other workers if the own queue is empty
+        };
+
+        /**
+         * @brief Move-only function executed once by the workers of the pool
+         *
+         * The function is stored in a node taken from a pool of nodes shared by all tasks. Nodes are recycled instead of
+         * freed once a task is destroyed, such that creating a task does not allocate memory after the pool has grown to
+         * the number of tasks in flight. Functions exceeding the inline storage of a node are allocated separately.
+         */
+        class Task {
+        public:
+            /**
+             * @brief Size of the inline storage of a node, large enough for the functions of the event loop
+             */
+            static constexpr size_t inline_size = 256;
+
+            /**
+             * @brief Construct an empty task
+             */
+            Task() = default;
+
+            /**
+             * @brief Construct a task holding a function
+             * @param func Function to store in the task, invoked without arguments
+             */
+            template <typename Func, typename = std::enable_if_t<!std::is_same_v<std::decay_t<Func>, Task>>>
+            explicit Task(Func&& func);
+
+            /**
+             * @brief Destroy the stored function and return the node to the pool
+             */
+            ~Task();
+
+            /// @{
+            /**
+             * @brief Tasks can only be moved, transferring the ownership of their node
+             */
+            Task(const Task&) = delete;
+            Task& operator=(const Task&) = delete;
+            Task(Task&& other) noexcept;
+            Task& operator=(Task&& other) noexcept;
+            /// @}
+
+            /**
+             * @brief Invoke the stored function
+             * @warning The task must not be empty
+             */
+            void operator()();
+
+            /**
+             * @brief Check if the task holds a function
+             * @return True if a function is stored, false for an empty task
+             */
+            explicit operator bool() const { return node_ != nullptr; }
+
+        private:
+            /**
+             * @brief Storage of a function together with the operations to invoke and destroy it
+             */
+            struct Node {
+                alignas(std::max_align_t) unsigned char storage[inline_size];
+                void (*invoke)(void*){};
+                void (*destroy)(void*){};
+                Node* next{};
+            };
+
+            /**
+             * @brief Unused nodes of all tasks
+             */
+            struct NodePool;
+            static NodePool& node_pool();
+
+            /**
+             * @brief Take a node from the pool, allocating a new one if the pool is empty
+             * @return Node without a stored function
+             */
+            static Node* acquire_node();
+
+            /**
+             * @brief Return a node to the pool
+             * @param node Node whose function has been destroyed
+             */
+            static void release_node(Node* node);
+
+            /**
+             * @brief Destroy the stored function and return the node to the pool
+             */
+            void reset();
+
+            Node* node_{nullptr};
+        };
+
         /**
          * @brief Internal thread-safe queuing system
          *
-         * It internally consists of two separate queues
-         * - A standard queue pushed in order of jobs to process
+         * It internally consists of two separate queue systems
+         * - A set of standard double-ended queues, one per worker, filled in round-robin order with jobs to process
          * - An ordered priority queue for work that need linear processing
          *
          * The priority queue is popped if the top of the queue can be directly processed. Otherwise work is popped from the
-         * default queue unless the priority queue size is too large.
+         * standard queues unless the priority queue size is too large. Workers take the first job of their own queue and
+         * only steal the oldest job of all queues if their own queue is empty. Once the priority queue has no room left for
+         * the events all workers might start, the oldest job of all queues is taken, such that the events start in order.
+         * The standard queues are protected by individual locks, the central lock is only acquired for the priority queue
+         * and when workers wait. Completed identifiers are marked without locking.
          */
         template <typename T> class SafeQueue {
         public:
@@ -46,8 +155,9 @@ namespace allpix {
              * @brief Default constructor, initializes empty queue
              * @param max_standard_size Max size of the default queue
              * @param max_priority_size Max size of the priority queue
+             * @param num_shards Number of standard queues to distribute jobs across, usually the number of workers
              */
-            SafeQueue(unsigned int max_standard_size, unsigned int max_priority_size);
+            SafeQueue(unsigned int max_standard_size, unsigned int max_priority_size, unsigned int num_shards = 1);
 
             /**
              * @brief Erases the queue and release waiting threads on destruction
@@ -58,9 +168,10 @@ namespace allpix {
              * @brief Get the top value from the appropriate queue
              * @param out Reference where the value at the top of the queue will be written to
              * @param buffer_left Optional number of jobs that should be left in priority buffer without stall on push
+             * @param shard Index of the standard queue owned by the calling worker
              * @return True if a task was acquired or false if pop was exited for another reason
              */
-            bool pop(T& out, size_t buffer_left = 0);
+            bool pop(T& out, size_t buffer_left = 0, size_t shard = 0);
 
             /**
              * @brief Push a new value onto the standard queue, will block if queue is full
@@ -114,20 +225,75 @@ namespace allpix {
              */
             size_t prioritySize() const;
 
+            /**
+             * @brief Count a value held outside of the queue towards the size of the priority queue
+             */
+            void hold();
+
+            /**
+             * @brief Release a value previously counted by \ref hold
+             */
+            void release();
+
             /**
              * @brief Invalidate the queue
              */
             void invalidate();
 
         private:
+            /**
+             * @brief Standard queue of a single worker with its own lock
+             */
+            struct Shard {
+                std::mutex mutex;
+                std::deque<std::pair<uint64_t, T>> queue;
+                // Push sequence of the first job, readable without the lock to find the oldest job
+                std::atomic<uint64_t> front{UINT64_MAX};
+            };
+
+            /**
+             * @brief Reserve a place in the standard queues
+             * @return True if the place was reserved, false if the standard queues are full
+             */
+            bool reserve_standard();
+
+            /**
+             * @brief Pop a job from the own standard queue or steal it from another standard queue
+             * @param out Reference where the value will be written to
+             * @param shard Index of the own standard queue
+             * @param ordered If the oldest job over all standard queues has to be taken
+             * @return True if a value was acquired
+             */
+            bool pop_standard(T& out, size_t shard, bool ordered);
+
+            /**
+             * @brief Update the flag signalling that the top of the priority queue can be processed
+             * @warning Requires the central mutex to be locked
+             */
+            void update_priority_ready();
+
             std::atomic_bool valid_{true};
             mutable std::mutex mutex_{};
-            std::queue<T> queue_;
-            std::set<uint64_t> completed_ids_;
-            uint64_t current_id_{0};
+            std::vector<std::unique_ptr<Shard>> shards_;
+            std::atomic<uint64_t> push_sequence_{0};
+            std::atomic_size_t standard_size_{0};
+            std::atomic_size_t waiting_{0};
+            std::atomic_size_t waiting_pushers_{0};
+            // Completed identifiers ahead of the current one, marked without locking in a ring of slots holding the
+            // identifier plus one. Identifiers too far ahead of the current one are kept in a locked overflow set.
+            std::vector<std::atomic<uint64_t>> completed_ring_;
+            std::mutex overflow_mutex_;
+            std::set<uint64_t> completed_overflow_;
+            std::atomic_size_t overflow_size_{0};
+            std::atomic<uint64_t> current_id_{0};
             using PQValue = std::pair<uint64_t, T>;
-            std::priority_queue<PQValue, std::vector<PQValue>, std::greater<>> priority_queue_;
+            struct PQCompare {
+                bool operator()(const PQValue& lhs, const PQValue& rhs) const { return lhs.first > rhs.first; }
+            };
+            std::priority_queue<PQValue, std::vector<PQValue>, PQCompare> priority_queue_;
             std::atomic_size_t priority_queue_size_{0};
+            std::atomic_size_t held_size_{0};
+            std::atomic_bool priority_ready_{false};
             std::condition_variable push_condition_;
             std::condition_variable pop_condition_;
             const size_t max_standard_size_;
@@ -154,13 +320,15 @@ namespace allpix {
          * @param max_buffered_size Maximum size of the buffered job queue (should be at least number of threads)
          * @param worker_init_function Function run by all the workers to initialize
          * @param worker_finalize_function Function run by all the workers to cleanup
+         * @param queue_layout Layout of the queue holding the standard jobs
          * @warning Total count of threads need to be preregistered via \ref ThreadPool::registerThreadCount
          */
         ThreadPool(unsigned int num_threads,
                    unsigned int max_queue_size,
                    unsigned int max_buffered_size,
                    const std::function<void()>& worker_init_function = nullptr,
-                   const std::function<void()>& worker_finalize_function = nullptr);
+                   const std::function<void()>& worker_finalize_function = nullptr,
+                   QueueLayout queue_layout = QueueLayout::SHARDED);
 
         /// @{
         /**
@@ -188,6 +356,36 @@ namespace allpix {
          */
         template <typename Func, typename... Args> auto submit(uint64_t n, Func&& func, Args&&... args);
 
+        /**
+         * @brief Submit a standard job without a future to be run by the thread pool. In case no workers are registered, the
+         * function will be executed immediately.
+         * @param func Function to execute by the pool
+         * @return True if the job was queued or executed, false if the pool has been invalidated
+         *
+         * Exceptions thrown by the job are propagated through \ref checkException. Without the shared state of a future, no
+         * memory is allocated for the submission of functions fitting into the inline storage of a \ref Task.
+         */
+        template <typename Func> bool submitDetached(Func&& func);
+        /**
+         * @brief Submit a priority job without a future to be run by the thread pool. In case no workers are registered, the
+         * function will be executed immediately.
+         * @param n Priority identifier or UINT64_MAX for non-prioritized submission
+         * @param func Function to execute by the pool
+         * @return True if the job was queued or executed, false if the pool has been invalidated
+         *
+         * @warning This function can only be called if thread pool was initialized with buffered jobs
+         */
+        template <typename Func> bool submitDetached(uint64_t n, Func&& func);
+
+        /**
+         * @brief Try to submit a standard job without waiting for capacity in the queue
+         * @param func Function to execute by the pool
+         * @return True if the job was queued, false if the queue is full or no workers are registered
+         *
+         * Meant for jobs offering optional help to the calling worker, which does the work itself if it is not picked up.
+         */
+        template <typename Func> bool trySubmit(Func&& func);
+
         /**
          * @brief Mark identifier as completed
          * @param n Identifier that is complete
@@ -212,6 +410,23 @@ namespace allpix {
          */
         size_t bufferedQueueSize() const { return queue_.prioritySize(); }
 
+        /**
+         * @brief Count a job buffered outside of the pool towards the buffered jobs, limiting the number of new jobs started
+         * @note Every call needs to be matched by a call to \ref releaseBuffered
+         */
+        void holdBuffered() { queue_.hold(); }
+
+        /**
+         * @brief Release a job counted by \ref holdBuffered
+         */
+        void releaseBuffered() { queue_.release(); }
+
+        /**
+         * @brief Return the time every worker spent executing tasks since the pool was created
+         * @return Cumulative execution time in nanoseconds for every worker
+         */
+        std::vector<int64_t> busyTime() const;
+
         /**
          * @brief Check if any worker thread has thrown an exception
          * @throw Exception thrown by worker thread, if any
@@ -256,7 +471,32 @@ namespace allpix {
          */
         static void registerThreadCount(unsigned int cnt);
 
+        /**
+         * @brief Get the number of workers currently waiting for a task
+         * @return Count of idle worker threads
+         *
+         * Allows modules to spread the work of expensive events to the cores left idle, e.g. at the end of the run
+         */
+        static unsigned int idleThreadCount();
+
+        /**
+         * @brief Get the pool the calling thread is a worker of
+         * @return Pointer to the pool of the calling worker, or a null pointer if not called from a worker thread
+         *
+         * Allows modules to offer parts of the work of an event to the other workers via \ref trySubmit
+         */
+        static ThreadPool* current();
+
     private:
+        /**
+         * @brief Push a task to the queues, counting it as running
+         * @param n Priority identifier or UINT64_MAX for non-prioritized submission
+         * @param task Task to push
+         * @param wait If the push is allowed to stall if there is no capacity
+         * @return If the push was successful
+         */
+        bool push_task(uint64_t n, Task task, bool wait);
+
         /**
          * @brief Constantly running internal function each thread uses to acquire work items from the queue.
          * @param min_thread_buffer   Minimum buffer size to keep available without stall on push
@@ -268,7 +508,6 @@ namespace allpix {
                     const std::function<void()>& finalize_function);
 
         // The queue holds the task functions to be executed by the workers
-        using Task = std::unique_ptr<std::packaged_task<void()>>;
         SafeQueue<Task> queue_;
         bool with_buffered_{true};
         std::function<void()> finalize_function_{};
@@ -279,6 +518,7 @@ namespace allpix {
         mutable std::mutex run_mutex_{};
         std::condition_variable run_condition_;
         std::vector<std::thread> threads_;
+        std::vector<std::atomic_int64_t> busy_time_;
 
         std::atomic_flag has_exception_{false};
         std::exception_ptr exception_ptr_{nullptr};
@@ -286,6 +526,8 @@ namespace allpix {
         static std::map<std::thread::id, unsigned int> thread_nums_;
         static std::atomic_uint thread_cnt_;
         static std::atomic_uint thread_total_;
+        static std::atomic_uint thread_idle_;
+        static thread_local ThreadPool* current_pool_;
     };
 } // namespace allpix
 
@@ -11,81 +11,186 @@
 
 #include <cassert>
 #include <climits>
+#include <new>
 
 namespace allpix {
     template <typename T>
-    ThreadPool::SafeQueue<T>::SafeQueue(unsigned int max_standard_size, unsigned max_priority_size)
-        : max_standard_size_(max_standard_size), max_priority_size_(max_priority_size) {}
+    ThreadPool::SafeQueue<T>::SafeQueue(unsigned int max_standard_size,
+                                        unsigned max_priority_size,
+                                        unsigned int num_shards)
+        : completed_ring_(4096), max_standard_size_(max_standard_size), max_priority_size_(max_priority_size) {
+        for(unsigned int i = 0; i < std::max(num_shards, 1u); ++i) {
+            shards_.push_back(std::make_unique<Shard>());
+        }
+    }
 
     /*
      * Block until a value is available if the wait parameter is set to true. The wait exits when the queue is invalidated.
+     * Standard jobs are acquired without taking the central lock, which is only required for priority jobs and for waiting.
      */
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wstrict-overflow"
-    template <typename T> bool ThreadPool::SafeQueue<T>::pop(T& out, size_t buffer_left) {
+    template <typename T> bool ThreadPool::SafeQueue<T>::pop(T& out, size_t buffer_left, size_t shard) {
         assert(buffer_left <= max_priority_size_);
-        // Lock the mutex
-        std::unique_lock<std::mutex> lock{mutex_};
-        if(!valid_) {
-            return false;
+        while(valid_) {
+            // Pop the priority queue if its top can be processed
+            if(priority_ready_) {
+                std::unique_lock<std::mutex> lock{mutex_};
+                if(!valid_) {
+                    return false;
+                }
+                if(!priority_queue_.empty() && priority_queue_.top().first == current_id_) {
+                    // Priority queue is missing a pop returning a non-const reference, so need to apply a const_cast
+                    out = std::move(const_cast<PQValue&>(priority_queue_.top())).second; // NOLINT
+                    priority_queue_.pop();
+                    priority_queue_size_--;
+                    update_priority_ready();
+
+                    // Notify possible pusher waiting to fill the queue
+                    lock.unlock();
+                    pop_condition_.notify_one();
+                    push_condition_.notify_all();
+                    return true;
+                }
+            }
+
+            // Pop or steal from the standard queues. Jobs are only taken out of order while the priority queue has room
+            // for the events all workers might start meanwhile, such that it cannot fill up with events waiting for one
+            // which has not been started yet
+            auto buffered = priority_queue_size_ + held_size_ + buffer_left;
+            if(buffered <= max_priority_size_ && pop_standard(out, shard, buffered + buffer_left > max_priority_size_)) {
+                // Release the place reserved by the pusher and notify pushers waiting for the queue to drop below its
+                // maximum size. The counter is only read after the release, such that a pusher starting to wait
+                // meanwhile sees the free place and none is missed. All are notified as priority pushers share the
+                // condition.
+                standard_size_--;
+                if(waiting_pushers_ > 0) {
+                    { std::lock_guard<std::mutex> lock{mutex_}; }
+                    push_condition_.notify_all();
+                }
+                return true;
+            }
+
+            // Wait for new item in one of the queues (unlocks the mutex while waiting)
+            std::unique_lock<std::mutex> lock{mutex_};
+            ++waiting_;
+            pop_condition_.wait(lock, [&]() {
+                return !valid_ || (!priority_queue_.empty() && priority_queue_.top().first == current_id_) ||
+                       (standard_size_ > 0 && priority_queue_.size() + held_size_ + buffer_left <= max_priority_size_);
+            });
+            --waiting_;
         }
+        return false;
+    }
+#pragma GCC diagnostic pop
 
-        // Wait for one of the queues to be available
-        bool pop_priority = !priority_queue_.empty() && priority_queue_.top().first == current_id_;
-        bool pop_standard = !queue_.empty() && priority_queue_.size() + buffer_left <= max_priority_size_;
-        while(!pop_priority && !pop_standard) {
-            // Wait for new item in the queue (unlocks the mutex while waiting)
-            pop_condition_.wait(lock);
-            if(!valid_) {
+    /*
+     * Workers take the first job of their own queue and only lock the queue of another worker to steal its oldest job if
+     * their own queue is empty. If the order is required, the oldest job over all queues is taken, found from the sequence
+     * numbers of the first jobs without locking the queues.
+     */
+    template <typename T> bool ThreadPool::SafeQueue<T>::pop_standard(T& out, size_t shard, bool ordered) {
+        // Take the first job of a queue, requires the lock of the queue
+        auto take_front = [&out](Shard& queue_shard) {
+            out = std::move(queue_shard.queue.front().second);
+            queue_shard.queue.pop_front();
+            queue_shard.front = (queue_shard.queue.empty() ? UINT64_MAX : queue_shard.queue.front().first);
+        };
+
+        auto num_shards = shards_.size();
+        while(standard_size_ > 0) {
+            if(!ordered) {
+                auto& own = *shards_[shard % num_shards];
+                std::lock_guard<std::mutex> lock{own.mutex};
+                if(!own.queue.empty()) {
+                    take_front(own);
+                    return true;
+                }
+            }
+
+            // Find the queue holding the oldest job
+            size_t oldest_shard = num_shards;
+            uint64_t oldest_sequence = UINT64_MAX;
+            for(size_t i = 0; i < num_shards; ++i) {
+                auto sequence = shards_[i]->front.load();
+                if(sequence < oldest_sequence) {
+                    oldest_sequence = sequence;
+                    oldest_shard = i;
+                }
+            }
+            if(oldest_shard == num_shards) {
                 return false;
             }
-            pop_priority = !priority_queue_.empty() && priority_queue_.top().first == current_id_;
-            pop_standard = !queue_.empty() && priority_queue_.size() + buffer_left <= max_priority_size_;
-        }
 
-        // Pop the appropriate queue
-        if(pop_priority) {
-            // Priority queue is missing a pop returning a non-const reference, so need to apply a const_cast
-            out = std::move(const_cast<PQValue&>(priority_queue_.top())).second; // NOLINT
-            priority_queue_.pop();
-            priority_queue_size_--;
-        } else { // pop_standard
-            out = std::move(queue_.front());
-            queue_.pop();
+            // Steal the job unless another worker was faster, retry otherwise
+            auto& victim = *shards_[oldest_shard];
+            std::lock_guard<std::mutex> lock{victim.mutex};
+            if(!victim.queue.empty() && victim.queue.front().first == oldest_sequence) {
+                take_front(victim);
+                return true;
+            }
         }
+        return false;
+    }
 
-        // Notify possible pusher waiting to fill the queue
-        lock.unlock();
-        if(pop_priority) {
-            pop_condition_.notify_one();
-        }
-        push_condition_.notify_one();
+    template <typename T> bool ThreadPool::SafeQueue<T>::reserve_standard() {
+        auto size = standard_size_.load();
+        do {
+            if(size >= max_standard_size_) {
+                return false;
+            }
+        } while(!standard_size_.compare_exchange_weak(size, size + 1));
         return true;
     }
-#pragma GCC diagnostic pop
 
-    template <typename T> bool ThreadPool::SafeQueue<T>::push(T value, bool wait) {
-        // Lock the mutex
-        std::unique_lock<std::mutex> lock{mutex_};
+    template <typename T> void ThreadPool::SafeQueue<T>::update_priority_ready() {
+        priority_ready_ = !priority_queue_.empty() && priority_queue_.top().first == current_id_;
+    }
 
-        // Check if the queue reached its full size
-        if(queue_.size() >= max_standard_size_) {
-            // Wait until the queue is below the max size or it was invalidated(shutdown)
+    /*
+     * The place in the queue is reserved before inserting the value, such that the size never exceeds the maximum and is
+     * never decremented by a consumer before the value has been counted.
+     */
+    template <typename T> bool ThreadPool::SafeQueue<T>::push(T value, bool wait) {
+        if(!reserve_standard()) {
             if(!wait) {
                 return false;
             }
-            push_condition_.wait(lock, [this]() { return queue_.size() < max_standard_size_ || !valid_; });
+
+            // Wait until a place is reserved or the queue was invalidated (shutdown)
+            std::unique_lock<std::mutex> lock{mutex_};
+            bool reserved = false;
+            ++waiting_pushers_;
+            push_condition_.wait(lock, [&]() {
+                reserved = valid_ && reserve_standard();
+                return reserved || !valid_;
+            });
+            --waiting_pushers_;
+            if(!reserved) {
+                return false;
+            }
         }
 
-        // Abort the push operation if conditions not met
-        if(queue_.size() >= max_standard_size_ || !valid_) {
-            return false;
+        // Push a new element to the next queue in round-robin order, unless the queue was invalidated meanwhile
+        auto sequence = push_sequence_++;
+        auto& shard = *shards_[sequence % shards_.size()];
+        {
+            std::lock_guard<std::mutex> lock{shard.mutex};
+            if(!valid_) {
+                standard_size_--;
+                return false;
+            }
+            if(shard.queue.empty()) {
+                shard.front = sequence;
+            }
+            shard.queue.emplace_back(sequence, std::move(value));
         }
 
-        // Push a new element to the queue and notify possible consumer
-        queue_.push(std::move(value));
-        lock.unlock();
-        pop_condition_.notify_one();
+        // Notify possible consumer, synchronizing with the central lock only if a consumer might be waiting
+        if(waiting_ > 0) {
+            { std::lock_guard<std::mutex> lock{mutex_}; }
+            pop_condition_.notify_one();
+        }
         return true;
     }
 
@@ -113,49 +218,85 @@ namespace allpix {
         // Push a new element to the queue and notify possible consumer
         priority_queue_.emplace(n, std::move(value));
         priority_queue_size_++;
+        update_priority_ready();
         lock.unlock();
         pop_condition_.notify_one();
         return true;
     }
 #pragma GCC diagnostic pop
 
+    /*
+     * The slot of an identifier within the ring size ahead of the current one cannot hold an identifier which is still
+     * marked, since that would be behind the current identifier. The current identifier is only advanced by the thread
+     * consuming its mark, and every thread checks the current identifier after marking, such that no mark is missed.
+     */
     template <typename T> void ThreadPool::SafeQueue<T>::complete(uint64_t n) {
-        std::unique_lock<std::mutex> lock{mutex_};
-        completed_ids_.insert(n);
-        auto iter = completed_ids_.begin();
-        while(iter != completed_ids_.end()) {
-            if(*iter != current_id_) {
-                return;
+        auto ring_size = completed_ring_.size();
+        if(n - current_id_ < ring_size) {
+            completed_ring_[n % ring_size] = n + 1;
+        } else {
+            std::lock_guard<std::mutex> lock{overflow_mutex_};
+            completed_overflow_.insert(n);
+            ++overflow_size_;
+        }
+
+        // Advance the current identifier over all completed identifiers
+        bool advanced = false;
+        while(true) {
+            auto current = current_id_.load();
+            auto marked = current + 1;
+            if(!completed_ring_[current % ring_size].compare_exchange_strong(marked, 0)) {
+                if(overflow_size_ == 0) {
+                    break;
+                }
+                std::lock_guard<std::mutex> lock{overflow_mutex_};
+                if(completed_overflow_.erase(current) == 0) {
+                    break;
+                }
+                --overflow_size_;
+            }
+            current_id_ = current + 1;
+            advanced = true;
+        }
+
+        // Only synchronize with the consumers if the top of the priority queue might have become ready
+        if(advanced && priority_queue_size_ > 0) {
+            {
+                std::lock_guard<std::mutex> lock{mutex_};
+                update_priority_ready();
             }
-            iter = completed_ids_.erase(iter);
-            ++current_id_;
-            lock.unlock();
             pop_condition_.notify_one();
-            lock.lock();
         }
     }
 
-    template <typename T> uint64_t ThreadPool::SafeQueue<T>::currentId() const {
-        std::lock_guard<std::mutex> lock{mutex_};
-        return current_id_;
-    }
+    template <typename T> uint64_t ThreadPool::SafeQueue<T>::currentId() const { return current_id_; }
 
-    template <typename T> bool ThreadPool::SafeQueue<T>::valid() const {
-        std::lock_guard<std::mutex> lock{mutex_};
-        return valid_;
-    }
+    template <typename T> bool ThreadPool::SafeQueue<T>::valid() const { return valid_; }
 
     template <typename T> bool ThreadPool::SafeQueue<T>::empty() const {
         std::lock_guard<std::mutex> lock{mutex_};
-        return !valid_ || (queue_.empty() && priority_queue_.empty());
+        return !valid_ || (standard_size_ == 0 && priority_queue_.empty());
     }
 
     template <typename T> size_t ThreadPool::SafeQueue<T>::size() const {
         std::lock_guard<std::mutex> lock{mutex_};
-        return queue_.size() + priority_queue_.size();
+        return standard_size_ + priority_queue_.size();
+    }
+
+    template <typename T> size_t ThreadPool::SafeQueue<T>::prioritySize() const {
+        return priority_queue_size_ + held_size_;
     }
 
-    template <typename T> size_t ThreadPool::SafeQueue<T>::prioritySize() const { return priority_queue_size_; }
+    template <typename T> void ThreadPool::SafeQueue<T>::hold() { ++held_size_; }
+
+    template <typename T> void ThreadPool::SafeQueue<T>::release() {
+        // Synchronize with consumers waiting for the buffer to drop below its maximum size
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            --held_size_;
+        }
+        pop_condition_.notify_one();
+    }
 
     /*
      * Used to ensure no conditions are being waited for in pop when a thread or the application is trying to exit. The queue
@@ -163,15 +304,42 @@ namespace allpix {
      */
     template <typename T> void ThreadPool::SafeQueue<T>::invalidate() {
         std::unique_lock<std::mutex> lock{mutex_};
-        std::priority_queue<PQValue, std::vector<PQValue>, std::greater<>>().swap(priority_queue_);
-        priority_queue_size_ = 0;
-        std::queue<T>().swap(queue_);
         valid_ = false;
+        std::priority_queue<PQValue, std::vector<PQValue>, PQCompare>().swap(priority_queue_);
+        priority_queue_size_ = 0;
+        priority_ready_ = false;
+
+        // Only the removed values are subtracted from the size, places reserved by pushers are released by themselves
+        for(auto& shard : shards_) {
+            std::lock_guard<std::mutex> shard_lock{shard->mutex};
+            standard_size_ -= shard->queue.size();
+            std::deque<std::pair<uint64_t, T>>().swap(shard->queue);
+            shard->front = UINT64_MAX;
+        }
         lock.unlock();
         push_condition_.notify_all();
         pop_condition_.notify_all();
     }
 
+    template <typename Func, typename> ThreadPool::Task::Task(Func&& func) : node_(acquire_node()) {
+        using Function = std::decay_t<Func>;
+        try {
+            if constexpr(sizeof(Function) <= inline_size && alignof(Function) <= alignof(std::max_align_t)) {
+                new(node_->storage) Function(std::forward<Func>(func));
+                node_->invoke = [](void* storage) { (*static_cast<Function*>(storage))(); };
+                node_->destroy = [](void* storage) { static_cast<Function*>(storage)->~Function(); };
+            } else {
+                // Store a pointer to a separate allocation for functions exceeding the inline storage
+                new(node_->storage) Function*(new Function(std::forward<Func>(func)));
+                node_->invoke = [](void* storage) { (**static_cast<Function**>(storage))(); };
+                node_->destroy = [](void* storage) { delete *static_cast<Function**>(storage); };
+            }
+        } catch(...) {
+            release_node(node_);
+            throw;
+        }
+    }
+
     template <typename Func, typename... Args> auto ThreadPool::submit(Func&& func, Args&&... args) {
         return submit(UINT64_MAX, std::forward<Func>(func), std::forward<Args>(args)...);
     }
@@ -185,24 +353,17 @@ namespace allpix {
         using PackagedTask = std::packaged_task<decltype(bound_task())()>;
         PackagedTask task(bound_task);
 
-        // Get future and wrapper to add to vector
+        // Get future and wrapper to add to the queue, rethrowing exceptions of the task in the worker
         auto future = task.get_future().share();
-        auto task_function = [task = std::move(task), future = future]() mutable {
+        Task task_function([task = std::move(task), future = future]() mutable {
             task();
             future.get();
-        };
+        });
         bool success = true;
         if(threads_.empty()) {
             task_function();
         } else {
-            if(n == UINT64_MAX) {
-                success = queue_.push(std::make_unique<std::packaged_task<void()>>(std::move(task_function)), true);
-            } else {
-                success = queue_.push(n, std::make_unique<std::packaged_task<void()>>(std::move(task_function)), false);
-            }
-            // Increment run count:
-            std::unique_lock<std::mutex> lock{run_mutex_};
-            ++run_cnt_;
+            success = push_task(n, std::move(task_function), n == UINT64_MAX);
         }
         if(success) {
             return future;
@@ -211,4 +372,24 @@ namespace allpix {
         }
     }
 
+    template <typename Func> bool ThreadPool::submitDetached(Func&& func) {
+        return submitDetached(UINT64_MAX, std::forward<Func>(func));
+    }
+
+    template <typename Func> bool ThreadPool::submitDetached(uint64_t n, Func&& func) {
+        assert(n == UINT64_MAX || with_buffered_);
+        if(threads_.empty()) {
+            std::forward<Func>(func)();
+            return true;
+        }
+        return push_task(n, Task(std::forward<Func>(func)), n == UINT64_MAX);
+    }
+
+    template <typename Func> bool ThreadPool::trySubmit(Func&& func) {
+        if(threads_.empty()) {
+            return false;
+        }
+        return push_task(UINT64_MAX, Task(std::forward<Func>(func)), false);
+    }
+
 } // namespace allpix
@@ -0,0 +1,118 @@
+/**
+ * @file
+ * @brief Implementation of the timeline tracer of the event loop
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "Tracer.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+
+#include "ThreadPool.hpp"
+
+using namespace allpix;
+
+bool Tracer::enabled_{false};
+size_t Tracer::capacity_{0};
+std::chrono::steady_clock::time_point Tracer::start_;
+std::mutex Tracer::mutex_;
+std::vector<std::string> Tracer::names_;
+std::list<Tracer::ThreadBuffer> Tracer::buffers_;
+
+void Tracer::enable(size_t capacity) {
+    capacity_ = std::max<size_t>(capacity, 1);
+    start_ = std::chrono::steady_clock::now();
+    enabled_ = true;
+}
+
+size_t Tracer::registerName(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = std::find(names_.begin(), names_.end(), name);
+    if(iter != names_.end()) {
+        return static_cast<size_t>(std::distance(names_.begin(), iter));
+    }
+    names_.push_back(name);
+    return names_.size() - 1;
+}
+
+Tracer::ThreadBuffer& Tracer::local() {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if(buffer == nullptr) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffer = &buffers_.emplace_back();
+        buffer->thread = ThreadPool::threadNum();
+        buffer->records.resize(capacity_);
+    }
+    return *buffer;
+}
+
+/**
+ * Names are escaped for the JSON output. Timestamps and durations are given in microseconds relative to enabling the
+ * tracer, counters are attributed to the process and all other records to the thread which recorded them.
+ */
+size_t Tracer::write(const std::filesystem::path& path) {
+    std::ofstream file(path);
+    if(!file) {
+        throw std::runtime_error("cannot create file " + path.string());
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> names;
+    names.reserve(names_.size());
+    for(const auto& name : names_) {
+        std::string escaped;
+        for(auto character : name) {
+            if(character == '"' || character == '\\') {
+                escaped += '\\';
+            }
+            escaped += character;
+        }
+        names.push_back(std::move(escaped));
+    }
+    auto microseconds = [](std::chrono::steady_clock::duration duration) {
+        return std::chrono::duration<double, std::micro>(duration).count();
+    };
+
+    size_t count = 0;
+    std::set<unsigned int> threads;
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    for(const auto& buffer : buffers_) {
+        threads.insert(buffer.thread);
+
+        // Start with the oldest record if the ring buffer has been overwritten
+        auto size = std::min<uint64_t>(buffer.written, buffer.records.size());
+        for(uint64_t index = buffer.written - size; index < buffer.written; ++index) {
+            const auto& entry = buffer.records[index % buffer.records.size()];
+            file << (count++ == 0 ? "\n" : ",\n") << "{\"name\": \"" << names[entry.name] << "\", \"ph\": \""
+                 << entry.phase << "\", \"ts\": " << microseconds(entry.time - start_) << ", \"pid\": 0";
+            if(entry.phase == 'C') {
+                file << ", \"args\": {\"value\": " << entry.value << "}}";
+                continue;
+            }
+            file << ", \"tid\": " << buffer.thread;
+            if(entry.phase == 'X') {
+                file << ", \"dur\": " << microseconds(entry.duration);
+            } else {
+                file << ", \"s\": \"t\"";
+            }
+            file << ", \"args\": {\"event\": " << entry.value << "}}";
+        }
+    }
+
+    // Name the threads, the main thread holds the first thread number
+    for(auto thread : threads) {
+        file << (count == 0 && thread == *threads.begin() ? "\n" : ",\n")
+             << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": " << thread
+             << ", \"args\": {\"name\": \"" << (thread == 0 ? "main" : "worker " + std::to_string(thread)) << "\"}}";
+    }
+    file << "\n]}\n";
+    return count;
+}
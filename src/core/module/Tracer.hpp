@@ -0,0 +1,155 @@
+/**
+ * @file
+ * @brief Definition of the timeline tracer of the event loop
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_MODULE_TRACER_H
+#define ALLPIX_MODULE_TRACER_H
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace allpix {
+    /**
+     * @brief Static class recording a timeline of the work done by every thread during the event loop
+     *
+     * Every thread records into its own ring buffer of fixed size, which is allocated on the first record of the thread.
+     * Once the buffer is full, the oldest records are overwritten, such that the timeline always covers the end of the run.
+     * Names of the records are registered beforehand and referred to by their index. The timeline is written in the Chrome
+     * trace event format, which can be displayed by Perfetto or the trace viewer of Chromium based browsers. Recording
+     * does nothing unless the tracer has been enabled.
+     */
+    class Tracer {
+    public:
+        /**
+         * @brief Delete default constructor (only static access)
+         */
+        Tracer() = delete;
+
+        /**
+         * @brief Enable recording
+         * @param capacity Number of records kept per thread
+         * @warning Should be called before the threads recording the timeline are started
+         */
+        static void enable(size_t capacity);
+
+        /**
+         * @brief Check if recording is enabled
+         * @return True if the tracer records the timeline
+         */
+        static bool enabled() { return enabled_; }
+
+        /**
+         * @brief Register the name of records
+         * @param name Name displayed in the timeline
+         * @return Index of the name, the same index is returned for names registered before
+         */
+        static size_t registerName(const std::string& name);
+
+        /**
+         * @brief Record a task of the calling thread with its start and end time
+         * @param name Index of the name of the task
+         * @param start Start time of the task
+         * @param end End time of the task
+         * @param event Number of the event the task belongs to, zero if not related to an event
+         */
+        static void complete(size_t name,
+                             std::chrono::steady_clock::time_point start,
+                             std::chrono::steady_clock::time_point end,
+                             uint64_t event = 0) {
+            record({name, 'X', start, end - start, event});
+        }
+
+        /**
+         * @brief Record an instant of the calling thread, e.g. an event being rescheduled
+         * @param name Index of the name of the instant
+         * @param event Number of the event the instant belongs to
+         */
+        static void instant(size_t name, uint64_t event) {
+            auto now = std::chrono::steady_clock::now();
+            record({name, 'i', now, {}, event});
+        }
+
+        /**
+         * @brief Record the current value of a counter, e.g. a queue size
+         * @param name Index of the name of the counter
+         * @param value Value of the counter
+         */
+        static void counter(size_t name, uint64_t value) {
+            auto now = std::chrono::steady_clock::now();
+            record({name, 'C', now, {}, value});
+        }
+
+        /**
+         * @brief Write the records of all threads as Chrome trace event file
+         * @param path Path of the file
+         * @return Number of written records
+         * @warning Should only be called after the event loop
+         */
+        static size_t write(const std::filesystem::path& path);
+
+    private:
+        /**
+         * @brief Entry of the timeline
+         */
+        struct Record {
+            size_t name;
+            // Type of the record in the Chrome trace event format
+            char phase;
+            std::chrono::steady_clock::time_point time;
+            std::chrono::steady_clock::duration duration;
+            // Event number or counter value
+            uint64_t value;
+        };
+
+        /**
+         * @brief Ring buffer of the records of a single thread
+         */
+        struct ThreadBuffer {
+            unsigned int thread{};
+            std::vector<Record> records;
+            // Total number of records written, including the overwritten ones
+            uint64_t written{};
+        };
+
+        /**
+         * @brief Add a record to the buffer of the calling thread if enabled
+         * @param entry Record to add
+         */
+        static void record(const Record& entry) {
+            if(!enabled_) {
+                return;
+            }
+            auto& buffer = local();
+            buffer.records[buffer.written++ % buffer.records.size()] = entry;
+        }
+
+        /**
+         * @brief Get the buffer of the calling thread, allocating it on first use
+         * @return Buffer of the calling thread
+         */
+        static ThreadBuffer& local();
+
+        static bool enabled_;
+        static size_t capacity_;
+        static std::chrono::steady_clock::time_point start_;
+
+        static std::mutex mutex_;
+        static std::vector<std::string> names_;
+        // Buffers of all threads, a list keeps the addresses stable when further threads are added
+        static std::list<ThreadBuffer> buffers_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_MODULE_TRACER_H */
@@ -19,7 +19,9 @@
 #endif
 
 #include <memory>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "core/config/Configuration.hpp"
 #include "core/geometry/Detector.hpp"
@@ -31,6 +33,22 @@ namespace allpix {
     class Messenger;
     class GeometryManager;
 
+#if !ALLPIX_MODULE_UNIQUE || defined(DOXYGEN)
+    /**
+     * @brief Instantiates a detector module for multiple detectors if it provides the corresponding constructor
+     */
+    template <typename T>
+    Module* create_multi_detector_module([[maybe_unused]] Configuration& config,
+                                         [[maybe_unused]] Messenger* messenger,
+                                         [[maybe_unused]] std::vector<std::shared_ptr<Detector>> detectors) {
+        if constexpr(std::is_constructible_v<T, Configuration&, Messenger*, std::vector<std::shared_ptr<Detector>>>) {
+            return static_cast<Module*>(new T(config, messenger, std::move(detectors))); // NOLINT
+        } else {
+            return nullptr;
+        }
+    }
+#endif
+
     extern "C" {
     /**
      * @brief Returns the type of the Module it is linked to
@@ -78,6 +96,25 @@ namespace allpix {
         return static_cast<Module*>(module);
     }
 
+    /**
+     * @brief Instantiates a detector module in multi-detector mode
+     * @param config Configuration for this module
+     * @param messenger Pointer to the Messenger (guaranteed to be valid until the module is destructed)
+     * @param detectors List of all Detector objects this single module instance is bound to
+     * @return Instantiation of the module or a null pointer if the module does not support the multi-detector mode
+     *
+     * Internal method for the dynamic loading in the ModuleManager. Forwards the supplied arguments to the constructor if
+     * the module provides a constructor accepting a list of detectors.
+     */
+    Module* allpix_module_multi_generator(Configuration& config,
+                                          Messenger* messenger,
+                                          std::vector<std::shared_ptr<Detector>> detectors);
+    Module* allpix_module_multi_generator(Configuration& config,
+                                          Messenger* messenger,
+                                          std::vector<std::shared_ptr<Detector>> detectors) { // NOLINT
+        return create_multi_detector_module<ALLPIX_MODULE_NAME>(config, messenger, std::move(detectors));
+    }
+
     // Returns that is a detector module
     bool allpix_module_is_unique() { return false; }
 #endif
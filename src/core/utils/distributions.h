@@ -12,7 +12,16 @@
 #ifndef ALLPIX_RANDOM_DISTRIBUTIONS_H
 #define ALLPIX_RANDOM_DISTRIBUTIONS_H
 
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <boost/random/binomial_distribution.hpp>
 #include <boost/random/exponential_distribution.hpp>
+#include <boost/random/negative_binomial_distribution.hpp>
 #include <boost/random/normal_distribution.hpp>
 #include <boost/random/piecewise_linear_distribution.hpp>
 #include <boost/random/poisson_distribution.hpp>
@@ -24,6 +33,155 @@ namespace allpix {
     template <typename T> using poisson_distribution = boost::random::poisson_distribution<T>;
     template <typename T> using uniform_real_distribution = boost::random::uniform_real_distribution<T>;
     template <typename T> using exponential_distribution = boost::random::exponential_distribution<T>;
+    template <typename I, typename T> using binomial_distribution = boost::random::binomial_distribution<I, T>;
+    template <typename I, typename T>
+    using negative_binomial_distribution = boost::random::negative_binomial_distribution<I, T>;
+
+    /**
+     * @brief Check if a random number engine can generate a block of numbers in one call
+     */
+    template <typename RandomEngine, typename = void> struct has_block_generation : std::false_type {};
+    template <typename RandomEngine>
+    struct has_block_generation<
+        RandomEngine,
+        std::void_t<decltype(std::declval<RandomEngine&>().fill(std::declval<std::vector<std::uint64_t>&>()))>>
+        : std::true_type {};
+
+    /**
+     * @brief Fill a buffer with 64-bit random numbers, using the block generation of the engine if available
+     * @param engine Random number engine providing uniformly distributed 64-bit random numbers
+     * @param values Buffer to fill, all elements are replaced
+     */
+    template <typename RandomEngine> void fill_random(RandomEngine& engine, std::vector<std::uint64_t>& values) {
+        if constexpr(has_block_generation<RandomEngine>::value) {
+            engine.fill(values);
+        } else {
+            for(auto& value : values) {
+                value = engine();
+            }
+        }
+    }
+
+    /**
+     * @brief Fill a buffer with uniform random numbers in [0, 1)
+     * @param engine Random number engine providing uniformly distributed 64-bit random numbers
+     * @param values Buffer to fill, all elements are replaced
+     */
+    template <typename RandomEngine> void fill_standard_uniform(RandomEngine& engine, std::vector<double>& values) {
+        static_assert(RandomEngine::min() == 0 && RandomEngine::max() == std::numeric_limits<std::uint64_t>::max(),
+                      "random number engine needs to provide 64-bit random numbers");
+
+        thread_local std::vector<std::uint64_t> bits;
+        bits.resize(values.size());
+        fill_random(engine, bits);
+        for(size_t i = 0; i < values.size(); ++i) {
+            // Uniform number from the upper 53 bits
+            values[i] = static_cast<double>(bits[i] >> 11) * 0x1.0p-53;
+        }
+    }
+
+    /**
+     * @brief Fill a buffer with standard normal random numbers using the Box-Muller transform
+     * @param engine Random number engine providing uniformly distributed 64-bit random numbers
+     * @param values Buffer to fill, all elements are replaced
+     *
+     * All uniform random numbers are drawn from the engine first and are then transformed pairwise in a loop without
+     * dependencies between its iterations, which allows the compiler to vectorize the transform. The generated numbers only
+     * depend on the state of the engine and the size of the buffer, and are therefore reproducible for a given seed.
+     */
+    template <typename RandomEngine> void fill_standard_normal(RandomEngine& engine, std::vector<double>& values) {
+        static_assert(RandomEngine::min() == 0 && RandomEngine::max() == std::numeric_limits<std::uint64_t>::max(),
+                      "random number engine needs to provide 64-bit random numbers");
+
+        const auto size = values.size();
+        const auto pairs = (size + 1) / 2;
+        thread_local std::vector<std::uint64_t> bits;
+        thread_local std::vector<double> uniform;
+        bits.resize(2 * pairs);
+        uniform.resize(2 * pairs);
+        fill_random(engine, bits);
+        for(size_t i = 0; i < bits.size(); ++i) {
+            // Uniform number in (0, 1] from the upper 53 bits, excluding zero for the logarithm
+            uniform[i] = (static_cast<double>(bits[i] >> 11) + 1.0) * 0x1.0p-53;
+        }
+
+        values.resize(2 * pairs);
+        for(size_t i = 0; i < pairs; ++i) {
+            const auto radius = std::sqrt(-2.0 * std::log(uniform[i]));
+            const auto angle = 2.0 * M_PI * uniform[pairs + i];
+            values[i] = radius * std::cos(angle);
+            values[pairs + i] = radius * std::sin(angle);
+        }
+        values.resize(size);
+    }
+
+    /**
+     * @brief Sampler of standard normal and uniform random numbers generated in blocks
+     *
+     * The random numbers are generated in blocks with \ref fill_standard_normal and \ref fill_standard_uniform whenever the
+     * previous block is used up, and are scaled to the requested distribution at use. This avoids constructing distributions
+     * and checking the logging level for every single number in the innermost loops. The sampler draws ahead from the engine
+     * and should therefore be constructed per event or task, the generated numbers then only depend on the state of the
+     * engine at construction and are reproducible for a given seed. They differ from the ones of the Boost distributions.
+     */
+    template <typename RandomEngine> class BlockSampler {
+    public:
+        /**
+         * @brief Construct a sampler drawing from the given engine
+         * @param engine Random number engine providing uniformly distributed 64-bit random numbers
+         * @param block_size Number of random numbers generated at once
+         */
+        explicit BlockSampler(RandomEngine& engine, size_t block_size = 128) : engine_(engine), block_size_(block_size) {}
+
+        /**
+         * @brief Get the next standard normal random number
+         * @return Normal random number with zero mean and unit standard deviation
+         */
+        double normal() {
+            if(normal_index_ == normals_.size()) {
+                normals_.resize(block_size_);
+                fill_standard_normal(engine_, normals_);
+                normal_index_ = 0;
+            }
+            return normals_[normal_index_++];
+        }
+
+        /**
+         * @brief Get the next normal random number
+         * @param mean Mean of the distribution
+         * @param stddev Standard deviation of the distribution
+         * @return Normal random number
+         */
+        double normal(double mean, double stddev) { return mean + stddev * normal(); }
+
+        /**
+         * @brief Get the next uniform random number in [0, 1)
+         * @return Uniform random number
+         */
+        double uniform() {
+            if(uniform_index_ == uniforms_.size()) {
+                uniforms_.resize(block_size_);
+                fill_standard_uniform(engine_, uniforms_);
+                uniform_index_ = 0;
+            }
+            return uniforms_[uniform_index_++];
+        }
+
+        /**
+         * @brief Get the next uniform random number in [min, max)
+         * @param min Lower bound of the distribution
+         * @param max Upper bound of the distribution
+         * @return Uniform random number
+         */
+        double uniform(double min, double max) { return min + (max - min) * uniform(); }
+
+    private:
+        RandomEngine& engine_;
+        size_t block_size_;
+
+        std::vector<double> normals_, uniforms_;
+        size_t normal_index_{}, uniform_index_{};
+    };
 } // namespace allpix
 
 #endif // ALLPIX_RANDOM_DISTRIBUTIONS_H
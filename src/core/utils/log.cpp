@@ -13,7 +13,10 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <exception>
 #include <iomanip>
 #include <iostream>
@@ -32,6 +35,36 @@ std::string DefaultLogger::last_message_;
 // Mutex to guard output writing
 std::mutex DefaultLogger::write_mutex_;
 
+namespace {
+    // Bounded queue of finished messages and their identifiers, written by a dedicated thread for asynchronous logging
+    struct AsynchronousSink {
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::deque<std::pair<std::string, std::string>> queue;
+        std::thread writer;
+        std::atomic<bool> enabled{};
+        bool running{};
+        bool writing{};
+
+        // Stop the writer thread if the logging has not been finished explicitly
+        ~AsynchronousSink() {
+            if(writer.joinable()) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    running = false;
+                }
+                condition.notify_all();
+                writer.join();
+            }
+        }
+    };
+    AsynchronousSink& asynchronous_sink() {
+        static AsynchronousSink sink;
+        return sink;
+    }
+    constexpr size_t asynchronous_queue_size = 16384;
+} // namespace
+
 /**
  * The logger will save the number of uncaught exceptions during construction to compare that with the number of exceptions
  * during destruction later.
@@ -65,12 +98,38 @@ DefaultLogger::~DefaultLogger() {
         } while((start_pos = out.find('\n', start_pos)) != std::string::npos);
     }
 
+    // Hand the message to the writer thread if asynchronous logging is enabled
+    auto& sink = asynchronous_sink();
+    if(sink.enabled.load(std::memory_order_relaxed)) {
+        std::unique_lock<std::mutex> sink_lock(sink.mutex);
+        sink.condition.wait(sink_lock, [&sink]() { return sink.queue.size() < asynchronous_queue_size || !sink.running; });
+        if(sink.running) {
+            sink.queue.emplace_back(std::move(out), identifier_);
+            sink_lock.unlock();
+            sink.condition.notify_all();
+
+            // Make sure fatal messages are written before the framework terminates
+            if(level_ == LogLevel::FATAL) {
+                sink_lock.lock();
+                sink.condition.wait(sink_lock,
+                                    [&sink]() { return (sink.queue.empty() && !sink.writing) || !sink.running; });
+            }
+            return;
+        }
+    }
+
     // Lock the mutex to guard last identifier usage
-    std::unique_lock<std::mutex> lock(write_mutex_);
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    write_message(std::move(out), identifier_);
+}
 
+/**
+ * The identifier of the previous message is used to overwrite process logs with the same identifier.
+ */
+void DefaultLogger::write_message(std::string out, const std::string& identifier) {
     // Add extra spaces if necessary
     size_t extra_spaces = 0;
-    if(!identifier_.empty() && last_identifier_ == identifier_) {
+    if(!identifier.empty() && last_identifier_ == identifier) {
         // Put carriage return for process logs
         out = '\r' + out;
 
@@ -82,7 +141,7 @@ DefaultLogger::~DefaultLogger() {
         // End process log and continue normal logging
         out = '\n' + out;
     }
-    last_identifier_ = identifier_;
+    last_identifier_ = identifier;
 
     // Save last message
     last_message_ = out;
@@ -94,7 +153,7 @@ DefaultLogger::~DefaultLogger() {
     }
 
     // Add final newline if not a progress log
-    if(identifier_.empty()) {
+    if(identifier.empty()) {
         out += '\n';
     }
 
@@ -125,14 +184,80 @@ DefaultLogger::~DefaultLogger() {
         }
         (*stream).flush();
     }
-    lock.unlock();
 }
 
+/**
+ * The writer thread takes all queued messages at once and writes them while the queue is filled further. Consecutive
+ * process logs with the same identifier overwrite each other, such that only the last one of them is written.
+ */
+void DefaultLogger::write_queued() {
+    auto& sink = asynchronous_sink();
+    std::deque<std::pair<std::string, std::string>> messages;
+    std::unique_lock<std::mutex> sink_lock(sink.mutex);
+    while(true) {
+        sink.condition.wait(sink_lock, [&sink]() { return !sink.queue.empty() || !sink.running; });
+        if(sink.queue.empty()) {
+            break;
+        }
+        messages.swap(sink.queue);
+        sink.writing = true;
+        sink_lock.unlock();
+        sink.condition.notify_all();
+
+        {
+            std::lock_guard<std::mutex> lock(write_mutex_);
+            for(auto iter = messages.begin(); iter != messages.end(); ++iter) {
+                auto next = std::next(iter);
+                if(!iter->second.empty() && next != messages.end() && next->second == iter->second) {
+                    continue;
+                }
+                write_message(std::move(iter->first), iter->second);
+            }
+        }
+        messages.clear();
+
+        sink_lock.lock();
+        sink.writing = false;
+        sink.condition.notify_all();
+    }
+}
+
+/**
+ * Enabling starts the writer thread, disabling waits for the writer thread to finish all queued messages.
+ */
+void DefaultLogger::setAsynchronous(bool asynchronous) {
+    auto& sink = asynchronous_sink();
+    std::unique_lock<std::mutex> sink_lock(sink.mutex);
+    if(asynchronous == sink.running) {
+        return;
+    }
+
+    if(asynchronous) {
+        sink.running = true;
+        sink.enabled = true;
+        sink.writer = std::thread(&DefaultLogger::write_queued);
+        return;
+    }
+
+    sink.running = false;
+    sink.enabled = false;
+    sink_lock.unlock();
+    sink.condition.notify_all();
+    if(sink.writer.joinable()) {
+        sink.writer.join();
+    }
+}
+
+
+
 /**
  * @warning No other log message should be send after this method
  * @note Does not close the streams
  */
 void DefaultLogger::finish() {
+    // Write all messages still queued for the writer thread
+    setAsynchronous(false);
+
     // Lock the mutex to guard output writing
     std::lock_guard<std::mutex> lock(write_mutex_);
 
@@ -164,6 +289,8 @@ void DefaultLogger::finish() {
  */
 std::ostringstream&
 DefaultLogger::getStream(LogLevel level, const std::string& file, const std::string& function, uint32_t line) {
+    level_ = level;
+
     // Add date in all except short format
     if(get_format() != LogFormat::SHORT) {
         os << "\x1B[1m"; // BOLD
@@ -363,7 +490,7 @@ std::string& DefaultLogger::get_section() {
     thread_local std::string section;
     return section;
 }
-void DefaultLogger::setSection(std::string section) { get_section() = std::move(section); }
+void DefaultLogger::setSection(const std::string& section) { get_section() = section; }
 std::string DefaultLogger::getSection() { return get_section(); }
 
 // Getters and setters for the event number
@@ -114,6 +114,14 @@ namespace allpix {
          */
         static void finish();
 
+        /**
+         * @brief Enable or disable writing the log messages from a dedicated thread
+         * @param asynchronous True to hand the messages to the writer thread, false to write them from the logging thread
+         *
+         * When disabling, all messages handed to the writer thread are written before the thread is stopped.
+         */
+        static void setAsynchronous(bool asynchronous);
+
         /**
          * @brief Get the reporting level for logging
          * @return The current log level
@@ -179,9 +187,9 @@ namespace allpix {
 
         /**
          * @brief Set the section header to use from now on
-         * @param header Header to use
+         * @param header Header to use, copied into the storage of the current header to avoid reallocations
          */
-        static void setSection(std::string header);
+        static void setSection(const std::string& header);
         /**
          * @brief Get the current section header
          * @return Header used
@@ -212,11 +220,26 @@ namespace allpix {
          */
         static bool is_terminal(std::ostream& stream);
 
+        /**
+         * @brief Write a finished message to all streams
+         * @param out Formatted message
+         * @param identifier Identifier of a process log or empty for a normal log message
+         * @warning The write mutex needs to be locked by the caller
+         */
+        static void write_message(std::string out, const std::string& identifier);
+
+        /**
+         * @brief Write the messages handed to the writer thread until asynchronous logging is disabled
+         */
+        static void write_queued();
+
         // Output stream
         std::ostringstream os;
 
         // Number of exceptions to prevent abort
         int exception_count_{};
+        // Level of the message
+        LogLevel level_{LogLevel::INFO};
         // Saved value of the length of the header indent
         unsigned int indent_count_{};
 
@@ -244,18 +267,33 @@ namespace allpix {
 #define __FILE_NAME__ (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 : __FILE__)
 #endif
 
+#ifndef ALLPIX_LOG_LEVEL_MAX
+/**
+ * @brief Highest log level compiled into the framework, messages of higher levels are removed at compile time
+ */
+#define ALLPIX_LOG_LEVEL_MAX PRNG
+#endif
+
+/**
+ * @brief Check if a log level is compiled into the framework and high enough to be reported
+ * @param level The log level to check
+ */
+#define LOG_LEVEL_ENABLED(level)                                                                                            \
+    (allpix::LogLevel::level <= allpix::LogLevel::ALLPIX_LOG_LEVEL_MAX &&                                                   \
+     allpix::LogLevel::level <= allpix::Log::getReportingLevel() && !allpix::Log::getStreams().empty())
+
 /**
  * @brief Execute a block only if the reporting level is high enough
  * @param level The minimum log level
  */
-#define IFLOG(level) if(allpix::LogLevel::level <= allpix::Log::getReportingLevel() && !allpix::Log::getStreams().empty())
+#define IFLOG(level) if(LOG_LEVEL_ENABLED(level))
 
 /**
  * @brief Create a logging stream if the reporting level is high enough
  * @param level The log level of the stream
  */
 #define LOG(level)                                                                                                          \
-    if(allpix::LogLevel::level <= allpix::Log::getReportingLevel() && !allpix::Log::getStreams().empty())                   \
+    if(LOG_LEVEL_ENABLED(level))                                                                                            \
     allpix::Log().getStream(                                                                                                \
         allpix::LogLevel::level, __FILE_NAME__, std::string(static_cast<const char*>(__func__)), __LINE__)
 
@@ -265,7 +303,7 @@ namespace allpix {
  * @param identifier Identifier for this stream to determine overwrites
  */
 #define LOG_PROGRESS(level, identifier)                                                                                     \
-    if(allpix::LogLevel::level <= allpix::Log::getReportingLevel() && !allpix::Log::getStreams().empty())                   \
+    if(LOG_LEVEL_ENABLED(level))                                                                                            \
     allpix::Log().getProcessStream(                                                                                         \
         identifier, allpix::LogLevel::level, __FILE_NAME__, std::string(static_cast<const char*>(__func__)), __LINE__)
 
@@ -297,7 +335,7 @@ namespace allpix {
 #define LOG_N(level, max_log_count)                                                                                         \
     GENERATE_LOG_VAR(max_log_count);                                                                                        \
     if(GET_LOG_VARIABLE() > 0)                                                                                              \
-        if(allpix::LogLevel::level <= allpix::Log::getReportingLevel() && !allpix::Log::getStreams().empty())               \
+        if(LOG_LEVEL_ENABLED(level))                                                                                        \
     allpix::Log().getStream(                                                                                                \
         allpix::LogLevel::level, __FILE_NAME__, std::string(static_cast<const char*>(__func__)), __LINE__)                  \
         << ((--GET_LOG_VARIABLE() == 0) ? "[further messages suppressed] " : "")
@@ -0,0 +1,108 @@
+/**
+ * @file
+ * @brief Implementation of the placement of worker threads and data on the NUMA nodes
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "numa.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace allpix;
+
+std::vector<unsigned int> NUMA::worker_cpus_;
+std::vector<size_t> NUMA::worker_slots_;
+std::vector<unsigned int> NUMA::node_cpus_;
+thread_local size_t NUMA::thread_slot_{0};
+
+void NUMA::setWorkerCPUs(std::vector<unsigned int> cpus) {
+    worker_cpus_ = std::move(cpus);
+    worker_slots_.clear();
+    node_cpus_.clear();
+
+    std::vector<unsigned int> nodes;
+    for(auto cpu : worker_cpus_) {
+        auto node = node_of_cpu(cpu);
+        auto slot = static_cast<size_t>(std::distance(nodes.begin(), std::find(nodes.begin(), nodes.end(), node)));
+        if(slot == nodes.size()) {
+            nodes.push_back(node);
+            node_cpus_.push_back(cpu);
+        }
+        worker_slots_.push_back(slot);
+    }
+}
+
+bool NUMA::pinWorker(unsigned int worker) {
+    if(worker_cpus_.empty()) {
+        return false;
+    }
+
+    auto index = worker % worker_cpus_.size();
+    if(!pin_thread(worker_cpus_[index])) {
+        return false;
+    }
+    thread_slot_ = worker_slots_[index];
+    return true;
+}
+
+/**
+ * The memory is allocated and written by a temporary thread pinned to a CPU of the node. Since pages are only assigned to a
+ * node when they are first written, the copy ends up local to the node under the default first-touch policy.
+ */
+std::shared_ptr<const void> NUMA::replicate(const void* data, size_t bytes, size_t slot) {
+    std::shared_ptr<char[]> copy;
+    std::thread thread([&]() {
+        if(slot < node_cpus_.size()) {
+            pin_thread(node_cpus_[slot]);
+        }
+        copy = std::shared_ptr<char[]>(new char[bytes]);
+        std::memcpy(copy.get(), data, bytes);
+    });
+    thread.join();
+    return copy;
+}
+
+bool NUMA::pin_thread(unsigned int cpu) {
+#ifdef __linux__
+    if(cpu >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu, &cpu_set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+unsigned int NUMA::node_of_cpu(unsigned int cpu) {
+    // The system exposes the node of a CPU as a link named after the node in the directory of the CPU
+    std::error_code error;
+    auto path = std::filesystem::path("/sys/devices/system/cpu") / ("cpu" + std::to_string(cpu));
+    for(const auto& entry : std::filesystem::directory_iterator(path, error)) {
+        auto name = entry.path().filename().string();
+        if(name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+           std::all_of(name.begin() + 4, name.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            return static_cast<unsigned int>(std::stoul(name.substr(4)));
+        }
+    }
+    return 0;
+}
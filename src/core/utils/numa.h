@@ -0,0 +1,95 @@
+/**
+ * @file
+ * @brief Placement of worker threads and data on the NUMA nodes of the system
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_NUMA_H
+#define ALLPIX_NUMA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace allpix {
+
+    /**
+     * @brief Static class to pin the worker threads to CPUs and to keep copies of large data local to their NUMA nodes
+     *
+     * The workers are pinned to the registered CPUs in round-robin order. The distinct NUMA nodes of these CPUs are
+     * numbered by slots in the order of their first appearance in the CPU list, and every pinned thread knows the slot of
+     * its node. Data replicated with \ref NUMA::replicate is copied by a thread running on the respective node, such that
+     * the memory pages of the copy are allocated on that node. Threads which are not pinned use the first slot. Without
+     * registered CPUs, no thread is pinned and no data is replicated.
+     */
+    class NUMA {
+    public:
+        /**
+         * @brief Delete default constructor (only static access)
+         */
+        NUMA() = delete;
+
+        /**
+         * @brief Register the CPUs the worker threads should be pinned to
+         * @param cpus Indices of the CPUs as used by the operating system
+         * @warning Should be called before any worker is started or any data is replicated
+         */
+        static void setWorkerCPUs(std::vector<unsigned int> cpus);
+
+        /**
+         * @brief Pin the calling thread to the CPU assigned to a worker
+         * @param worker Index of the worker, starting at zero
+         * @return True if the thread has been pinned, false if no CPUs are registered or pinning failed
+         */
+        static bool pinWorker(unsigned int worker);
+
+        /**
+         * @brief Get the number of distinct NUMA nodes of the registered CPUs
+         * @return Number of nodes, zero if no CPUs are registered
+         */
+        static size_t getNodeCount() { return node_cpus_.size(); }
+
+        /**
+         * @brief Get the slot of the NUMA node the calling thread is pinned to
+         * @return Slot of the node, zero for threads which are not pinned
+         */
+        static size_t getThreadSlot() { return thread_slot_; }
+
+        /**
+         * @brief Copy data to memory local to the NUMA node of a slot
+         * @param data Data to copy
+         * @param bytes Size of the data in bytes
+         * @param slot Slot of the node to allocate the copy on
+         * @return Copy of the data
+         */
+        static std::shared_ptr<const void> replicate(const void* data, size_t bytes, size_t slot);
+
+    private:
+        /**
+         * @brief Pin the calling thread to a single CPU
+         * @param cpu Index of the CPU
+         * @return True if successful, false otherwise
+         */
+        static bool pin_thread(unsigned int cpu);
+
+        /**
+         * @brief Find the NUMA node of a CPU from the system information
+         * @param cpu Index of the CPU
+         * @return Index of the node, zero if it cannot be determined
+         */
+        static unsigned int node_of_cpu(unsigned int cpu);
+
+        static std::vector<unsigned int> worker_cpus_;
+        static std::vector<size_t> worker_slots_;
+        // First registered CPU of every node slot
+        static std::vector<unsigned int> node_cpus_;
+        static thread_local size_t thread_slot_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_NUMA_H */
@@ -1,6 +1,6 @@
 /**
  * @file
- * @brief Provides a wrapper around the STL pseudo-random number generator Mersenne Twister
+ * @brief Provides a wrapper around the STL pseudo-random number generator Mersenne Twister and a counter-based generator
  *
  * @copyright Copyright (c) 2020-2024 CERN and the Allpix Squared authors.
  * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
@@ -14,15 +14,162 @@
 
 #include "core/utils/log.h"
 
+#include <array>
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <ostream>
 #include <random>
+#include <utility>
+#include <vector>
 
 namespace allpix {
 
     /**
-     * @brief Wrapper around the STL's Mersenne Twister
+     * @brief Counter-based Philox4x64-10 pseudo-random number engine
+     *
+     * Implementation of the Philox generator with four 64-bit words and ten rounds as described in J. K. Salmon et al.,
+     * "Parallel random numbers: as easy as 1, 2, 3", SC '11. The random numbers are obtained by encrypting a counter with a
+     * key, the full state therefore only consists of the key, the counter and the position within the current block. The key
+     * is set from the seed and an optional stream identifier, different streams of the same seed are independent.
      */
-    class RandomNumberGenerator : public std::mt19937_64 {
+    class Philox4x64 {
     public:
+        using result_type = std::uint64_t;
+
+        /**
+         * @brief Construct the engine for a given seed and stream
+         * @param seed Seed of the engine
+         * @param stream Identifier of the independent stream
+         */
+        explicit Philox4x64(result_type seed = 0, result_type stream = 0) { this->seed(seed, stream); }
+
+        /**
+         * @brief Reset the engine to the beginning of a given stream
+         * @param seed Seed of the engine
+         * @param stream Identifier of the independent stream
+         */
+        void seed(result_type seed, result_type stream = 0) {
+            key_ = {seed, stream};
+            counter_ = 0;
+            index_ = block_.size();
+        }
+
+        static constexpr result_type min() { return std::numeric_limits<result_type>::min(); }
+        static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+        /**
+         * @brief Retrieve the next pseudo-random number, generating a new block every four calls
+         * @return 64-bit pseudo-random number
+         */
+        result_type operator()() {
+            if(index_ == block_.size()) {
+                block_ = generate({counter_++, 0, 0, 0}, key_);
+                index_ = 0;
+            }
+            return block_[index_++];
+        }
+
+        /**
+         * @brief Advance the engine by a number of steps without generating the skipped blocks
+         * @param z Number of values to skip
+         */
+        void discard(unsigned long long z) {
+            // Position of the next value within the stream
+            auto position = (index_ < block_.size() ? (counter_ - 1) * block_.size() + index_ : counter_ * block_.size());
+            position += z;
+            counter_ = position / block_.size();
+            index_ = block_.size();
+            if(position % block_.size() != 0) {
+                block_ = generate({counter_++, 0, 0, 0}, key_);
+                index_ = position % block_.size();
+            }
+        }
+
+        /**
+         * @brief Encrypt a counter with a key, the stateless core of the generator
+         * @param counter Counter to encrypt
+         * @param key Key to encrypt the counter with
+         * @return Block of four pseudo-random numbers
+         */
+        static std::array<result_type, 4> generate(std::array<result_type, 4> counter, std::array<result_type, 2> key) {
+            for(unsigned int round = 0; round < 10; ++round) {
+                if(round > 0) {
+                    key[0] += 0x9E3779B97F4A7C15;
+                    key[1] += 0xBB67AE8584CAA73B;
+                }
+                auto [hi0, lo0] = multiply(0xD2E7470EE14C6C93, counter[0]);
+                auto [hi1, lo1] = multiply(0xCA5A826395121157, counter[2]);
+                counter = {hi1 ^ counter[1] ^ key[0], lo1, hi0 ^ counter[3] ^ key[1], lo0};
+            }
+            return counter;
+        }
+
+        friend bool operator==(const Philox4x64& lhs, const Philox4x64& rhs) {
+            return lhs.key_ == rhs.key_ && lhs.counter_ == rhs.counter_ && lhs.index_ == rhs.index_;
+        }
+
+        /**
+         * @brief Write the state of the engine, consisting of only four numbers
+         */
+        friend std::ostream& operator<<(std::ostream& os, const Philox4x64& engine) {
+            return os << engine.key_[0] << ' ' << engine.key_[1] << ' ' << engine.counter_ << ' ' << engine.index_;
+        }
+
+        /**
+         * @brief Read the state of the engine and regenerate the current block
+         */
+        friend std::istream& operator>>(std::istream& is, Philox4x64& engine) {
+            is >> engine.key_[0] >> engine.key_[1] >> engine.counter_ >> engine.index_;
+            if(engine.index_ < engine.block_.size()) {
+                engine.block_ = generate({engine.counter_ - 1, 0, 0, 0}, engine.key_);
+            }
+            return is;
+        }
+
+    private:
+        /**
+         * @brief Full 128-bit product of two 64-bit numbers
+         * @return High and low word of the product
+         */
+        static std::pair<result_type, result_type> multiply(result_type a, result_type b) {
+            const result_type mask = 0xFFFFFFFF;
+            const result_type a_lo = a & mask, a_hi = a >> 32, b_lo = b & mask, b_hi = b >> 32;
+            const result_type lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo, lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+            const result_type cross = (lo_lo >> 32) + (hi_lo & mask) + lo_hi;
+            return {(hi_lo >> 32) + (cross >> 32) + hi_hi, (cross << 32) | (lo_lo & mask)};
+        }
+
+        std::array<result_type, 2> key_{};
+        result_type counter_{};
+        std::array<result_type, 4> block_{};
+        std::size_t index_{};
+    };
+
+    /**
+     * @brief Pseudo-random number generator of the framework, using either the STL's Mersenne Twister or Philox4x64
+     *
+     * The Mersenne Twister is used by default. The counter-based engine can be selected for a cheap storage and restoration
+     * of the generator state and for independent streams of the same seed.
+     */
+    class RandomNumberGenerator {
+    public:
+        /**
+         * @brief Available pseudo-random number engines
+         */
+        enum class Engine {
+            MT19937_64, ///< 64-bit Mersenne Twister from the C++ Standard Library
+            PHILOX4X64, ///< Counter-based Philox engine with four 64-bit words and ten rounds
+        };
+
+        using result_type = std::uint_fast64_t;
+
+        /**
+         * @brief Construct a generator using the given engine
+         * @param engine Engine to use for the generation of random numbers
+         */
+        explicit RandomNumberGenerator(Engine engine = Engine::MT19937_64) : engine_(engine) {}
+
         /// @{
         /**
          * @brief Disallow copy-assignment
@@ -36,22 +183,109 @@ namespace allpix {
         RandomNumberGenerator& operator=(RandomNumberGenerator&&) = delete;
 
         /**
-         * Redefine function operator to retrieve pseudo-random numbers. This allows us to log the number at retrieval.
-         * Technically we are shadowing the base class operator since it is non-virtual and explicitly call it from within.
+         * @brief Select the engine used by this generator, needs to be followed by seeding
+         * @param engine Engine to use for the generation of random numbers
+         */
+        void setEngine(Engine engine) { engine_ = engine; }
+
+        /**
+         * @brief Get the engine used by this generator
+         * @return Engine used for the generation of random numbers
+         */
+        Engine getEngine() const { return engine_; }
+
+        /**
+         * @brief Seed the generator
+         * @param seed Seed of the generator
+         * @param stream Identifier of an independent stream, only used for counter-based engines
+         */
+        void seed(result_type seed = std::mt19937_64::default_seed, result_type stream = 0) {
+            if(engine_ == Engine::PHILOX4X64) {
+                philox_.seed(seed, stream);
+            } else {
+                mersenne_twister_.seed(seed);
+            }
+        }
+
+        static constexpr result_type min() { return std::numeric_limits<std::uint64_t>::min(); }
+        static constexpr result_type max() { return std::numeric_limits<std::uint64_t>::max(); }
+
+        /**
+         * Function operator to retrieve pseudo-random numbers. This allows us to log the number at retrieval.
          *
          * @return 64-bit pseudo-random number
          */
-        std::uint_fast64_t operator()() {
+        result_type operator()() {
             // Only copy if we want to log it
             IFLOG(PRNG) {
-                auto prn = std::mt19937_64::operator()();
+                auto prn = generate();
                 LOG(PRNG) << "Using random number " << prn;
                 return prn;
             }
             else {
-                return std::mt19937_64::operator()();
+                return generate();
+            }
+        }
+
+        /**
+         * @brief Retrieve a block of pseudo-random numbers, checking the logging level only once for the full block
+         * @param values Buffer to fill, all elements are replaced
+         */
+        void fill(std::vector<std::uint64_t>& values) {
+            if(engine_ == Engine::PHILOX4X64) {
+                for(auto& value : values) {
+                    value = philox_();
+                }
+            } else {
+                for(auto& value : values) {
+                    value = mersenne_twister_();
+                }
+            }
+            IFLOG(PRNG) {
+                for(auto value : values) {
+                    LOG(PRNG) << "Using random number " << value;
+                }
+            }
+        }
+
+        /**
+         * @brief Advance the generator by a number of steps
+         * @param z Number of values to skip
+         */
+        void discard(unsigned long long z) {
+            if(engine_ == Engine::PHILOX4X64) {
+                philox_.discard(z);
+            } else {
+                mersenne_twister_.discard(z);
+            }
+        }
+
+        /**
+         * @brief Write the state of the active engine
+         */
+        friend std::ostream& operator<<(std::ostream& os, const RandomNumberGenerator& generator) {
+            if(generator.engine_ == Engine::PHILOX4X64) {
+                return os << generator.philox_;
             }
+            return os << generator.mersenne_twister_;
         }
+
+        /**
+         * @brief Read the state of the active engine
+         */
+        friend std::istream& operator>>(std::istream& is, RandomNumberGenerator& generator) {
+            if(generator.engine_ == Engine::PHILOX4X64) {
+                return is >> generator.philox_;
+            }
+            return is >> generator.mersenne_twister_;
+        }
+
+    private:
+        result_type generate() { return engine_ == Engine::PHILOX4X64 ? philox_() : mersenne_twister_(); }
+
+        Engine engine_;
+        std::mt19937_64 mersenne_twister_;
+        Philox4x64 philox_;
     };
 } // namespace allpix
 
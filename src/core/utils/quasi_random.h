@@ -0,0 +1,124 @@
+/**
+ * @file
+ * @brief Low-discrepancy sequences for quasi-random sampling
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_QUASI_RANDOM_H
+#define ALLPIX_QUASI_RANDOM_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace allpix {
+    /**
+     * @brief Sobol sequence with the direction numbers of Joe and Kuo
+     *
+     * The points are computed directly from their index, such that the point for a given index does not depend on the
+     * points generated before. This allows to index the sequence by the event number, making the sampling independent of
+     * the order in which events are processed by the worker threads. The first 2^m points of every dimension cover the
+     * unit interval evenly in strata of width 2^-m, which improves the convergence of averages over the sampled points
+     * compared to pseudo-random sampling.
+     */
+    class SobolSequence {
+    public:
+        /**
+         * @brief Maximum number of dimensions supported
+         */
+        static constexpr size_t max_dimensions = 8;
+
+        /**
+         * @brief Number of bits of the points, the sequence repeats after 2^bits points
+         */
+        static constexpr size_t bits = 32;
+
+        /**
+         * @brief Construct the sequence for a number of dimensions
+         * @param dimensions Number of dimensions of the points
+         */
+        explicit SobolSequence(size_t dimensions) : dimensions_(dimensions) {
+            if(dimensions_ == 0 || dimensions_ > max_dimensions) {
+                throw std::invalid_argument("Sobol sequence supports between 1 and " + std::to_string(max_dimensions) +
+                                            " dimensions");
+            }
+
+            // Degree, coefficients and initial direction numbers of the primitive polynomials of the dimensions after the
+            // first, see S. Joe and F. Y. Kuo, SIAM J. Sci. Comput. 30, 2635 (2008)
+            struct Polynomial {
+                unsigned int degree;
+                unsigned int coefficients;
+                std::array<uint32_t, 5> initial;
+            };
+            static constexpr std::array<Polynomial, max_dimensions - 1> polynomials{{{1, 0, {1}},
+                                                                                     {2, 1, {1, 3}},
+                                                                                     {3, 1, {1, 3, 1}},
+                                                                                     {3, 2, {1, 1, 1}},
+                                                                                     {4, 1, {1, 1, 3, 3}},
+                                                                                     {4, 4, {1, 3, 5, 13}},
+                                                                                     {5, 2, {1, 1, 5, 5, 17}}}};
+
+            // The first dimension is the van der Corput sequence in base 2
+            for(size_t k = 0; k < bits; ++k) {
+                directions_[0][k] = uint32_t(1) << (bits - 1 - k);
+            }
+            for(size_t dim = 1; dim < dimensions_; ++dim) {
+                const auto& polynomial = polynomials[dim - 1];
+                const auto degree = polynomial.degree;
+                auto& direction = directions_[dim];
+                for(size_t k = 0; k < bits; ++k) {
+                    if(k < degree) {
+                        direction[k] = polynomial.initial[k] << (bits - 1 - k);
+                        continue;
+                    }
+                    direction[k] = direction[k - degree] ^ (direction[k - degree] >> degree);
+                    for(unsigned int l = 1; l < degree; ++l) {
+                        if(((polynomial.coefficients >> (degree - 1 - l)) & 1U) != 0) {
+                            direction[k] ^= direction[k - l];
+                        }
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief Get the number of dimensions of the points
+         */
+        size_t dimensions() const { return dimensions_; }
+
+        /**
+         * @brief Compute a point of the sequence
+         * @param index Index of the point, only the lowest 32 bits are used
+         * @return Coordinates of the point in the open unit interval, unused dimensions are zero
+         *
+         * The coordinates are placed in the center of their stratum of width 2^-32, such that they never reach zero or one
+         * and can be passed to inverse cumulative distribution functions.
+         */
+        std::array<double, max_dimensions> point(uint64_t index) const {
+            std::array<double, max_dimensions> coordinates{};
+            for(size_t dim = 0; dim < dimensions_; ++dim) {
+                uint32_t value = 0;
+                for(size_t k = 0; k < bits; ++k) {
+                    if(((index >> k) & 1U) != 0) {
+                        value ^= directions_[dim][k];
+                    }
+                }
+                coordinates[dim] = (static_cast<double>(value) + 0.5) / 4294967296.;
+            }
+            return coordinates;
+        }
+
+    private:
+        size_t dimensions_;
+        std::array<std::array<uint32_t, bits>, max_dimensions> directions_{};
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_QUASI_RANDOM_H */
@@ -135,6 +135,65 @@ namespace allpix {
     private:
         static std::map<std::string, UnitType> unit_map_;
     };
+
+    /**
+     * @brief Compile-time values of the framework units in the base units
+     * @see The registration of these units in \ref allpix::register_units
+     *
+     * The string-based lookup of \ref Units is meant for the configuration. Code executed for every step or event can use
+     * these constants instead, e.g. `time / units::ns` to obtain a time in nanoseconds, which yields the same result as
+     * converting with the unit name.
+     */
+    namespace units {
+        // Length
+        constexpr Units::UnitType nm = 1e-6;
+        constexpr Units::UnitType um = 1e-3;
+        constexpr Units::UnitType mm = 1;
+        constexpr Units::UnitType cm = 1e1;
+        constexpr Units::UnitType dm = 1e2;
+        constexpr Units::UnitType m = 1e3;
+        constexpr Units::UnitType km = 1e6;
+
+        // Time
+        constexpr Units::UnitType ps = 1e-3;
+        constexpr Units::UnitType ns = 1;
+        constexpr Units::UnitType us = 1e3;
+        constexpr Units::UnitType ms = 1e6;
+        constexpr Units::UnitType s = 1e9;
+
+        // Temperature
+        constexpr Units::UnitType K = 1;
+
+        // Energy
+        constexpr Units::UnitType eV = 1e-6;
+        constexpr Units::UnitType keV = 1e-3;
+        constexpr Units::UnitType MeV = 1;
+        constexpr Units::UnitType GeV = 1e3;
+
+        // Charge
+        constexpr Units::UnitType e = 1;
+        constexpr Units::UnitType ke = 1e3;
+        constexpr Units::UnitType fC = 1 / 1.602176634e-4;
+        constexpr Units::UnitType C = 1 / 1.602176634e-19;
+
+        // Voltage, fixed by the units above
+        constexpr Units::UnitType mV = 1e-9;
+        constexpr Units::UnitType V = 1e-6;
+        constexpr Units::UnitType kV = 1e-3;
+
+        // Magnetic field
+        constexpr Units::UnitType kT = 1;
+        constexpr Units::UnitType T = 1e-3;
+        constexpr Units::UnitType mT = 1e-6;
+
+        // Angles, these are fake units
+        constexpr Units::UnitType deg = 3.14159265358979323846 / 180.0;
+        constexpr Units::UnitType rad = 1;
+        constexpr Units::UnitType mrad = 1e-3;
+
+        // Fluence, pseudo unit "1-MeV neutron equivalent"
+        constexpr Units::UnitType neq = 1;
+    } // namespace units
 } // namespace allpix
 
 // Include template definitions
@@ -105,6 +105,7 @@ int main(int argc, const char* argv[]) {
     // Parse arguments
     std::string config_file_name;
     std::string log_file_name;
+    std::string socket_path;
     std::vector<std::string> module_options;
     std::vector<std::string> detector_options;
 
@@ -182,6 +183,10 @@ int main(int argc, const char* argv[]) {
             }
         } else if(arg == "-g" && (i + 1 < argc)) {
             detector_options.emplace_back(argv[++i]);
+        } else if(arg == "--resume") {
+            module_options.emplace_back("resume=true");
+        } else if(arg == "--server" && (i + 1 < argc)) {
+            socket_path = std::string(argv[++i]);
         } else {
             LOG(ERROR) << "Unrecognized command line argument \"" << argv[i] << "\"";
             print_help = true;
@@ -204,6 +209,10 @@ int main(int argc, const char* argv[]) {
         std::cout << "  -v <level>   verbosity level, overwriting the global level" << std::endl;
         std::cout << "  -j <workers> number of worker threads, equivalent to" << std::endl;
         std::cout << "               -o multithreading=true -o workers=<workers>" << std::endl;
+        std::cout << "  --server <socket>" << std::endl;
+        std::cout << "               keep the simulation loaded and serve run requests" << std::endl;
+        std::cout << "               on the given local socket" << std::endl;
+        std::cout << "  --resume     continue an interrupted run after its last checkpoint" << std::endl;
         std::cout << "  --version    print version information and quit" << std::endl;
         std::cout << std::endl;
         std::cout << "For more help, please see <https://cern.ch/allpix-squared>" << std::endl;
@@ -237,14 +246,19 @@ int main(int argc, const char* argv[]) {
         apx = std::make_unique<Allpix>(config_file_name, module_options, detector_options);
         apx_ready = true;
 
-        // Load modules
-        apx->load();
+        if(socket_path.empty()) {
+            // Load modules
+            apx->load();
 
-        // Initialize modules (pre-run)
-        apx->initialize();
+            // Initialize modules (pre-run)
+            apx->initialize();
 
-        // Run modules and event-loop
-        apx->run();
+            // Run modules and event-loop
+            apx->run();
+        } else {
+            // Load and initialize modules once and run the requests received on the socket
+            apx->serve(socket_path);
+        }
 
         // Finalize modules (post-run)
         apx->finalize();
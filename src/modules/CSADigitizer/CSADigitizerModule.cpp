@@ -11,9 +11,13 @@
 
 #include "CSADigitizerModule.hpp"
 
+#include <algorithm>
+#include <limits>
+
 #include "core/utils/distributions.h"
 #include "core/utils/unit.h"
 #include "tools/ROOT.h"
+#include "tools/fft.h"
 
 #include <TFile.h>
 #include <TGraph.h>
@@ -26,6 +30,11 @@
 
 using namespace allpix;
 
+namespace {
+    // Number of bins compared at once when scanning pulses for threshold crossings
+    constexpr size_t scan_block_size = 16;
+} // namespace
+
 CSADigitizerModule::CSADigitizerModule(Configuration& config, Messenger* messenger, std::shared_ptr<Detector> detector)
     : Module(config, std::move(detector)), messenger_(messenger) {
 
@@ -84,6 +93,15 @@ CSADigitizerModule::CSADigitizerModule(Configuration& config, Messenger* messeng
     threshold_ = config_.get<double>("threshold");
     ignore_polarity_ = config.get<bool>("ignore_polarity");
 
+    // Pixels which cannot cross the threshold
+    if(config_.has("noise_margin")) {
+        skip_pixels_ = true;
+        noise_margin_ = config_.get<double>("noise_margin");
+        if(noise_margin_ < 0) {
+            throw InvalidValueError(config_, "noise_margin", "noise margin has to be positive");
+        }
+    }
+
     if(model_ == DigitizerType::SIMPLE) {
         auto tauF = config_.get<double>("feedback_time_constant");
         auto tauR = config_.get<double>("rise_time_constant");
@@ -93,6 +111,9 @@ CSADigitizerModule::CSADigitizerModule(Configuration& config, Messenger* messeng
         calculate_impulse_response_ =
             std::make_unique<TFormula>("response_function", "[0]*(TMath::Exp(-x/[1])-TMath::Exp(-x/[2]))/([1]-[2])");
         calculate_impulse_response_->SetParameters(resistance_feedback, tauF, tauR);
+        response_amplitude_ = resistance_feedback;
+        tau_feedback_ = tauF;
+        tau_rise_ = tauR;
 
         LOG(DEBUG) << "Parameters: cf = " << Units::display(capacitance_feedback, {"C/V", "fC/mV"})
                    << ", rf = " << Units::display(resistance_feedback, "V*s/C")
@@ -126,6 +147,9 @@ CSADigitizerModule::CSADigitizerModule(Configuration& config, Messenger* messeng
         calculate_impulse_response_ =
             std::make_unique<TFormula>("response_function", "[0]*(TMath::Exp(-x/[1])-TMath::Exp(-x/[2]))/([1]-[2])");
         calculate_impulse_response_->SetParameters(resistance_feedback, tauF, tauR);
+        response_amplitude_ = resistance_feedback;
+        tau_feedback_ = tauF;
+        tau_rise_ = tauR;
 
         LOG(DEBUG) << "Parameters: rf = " << Units::display(resistance_feedback, "V*s/C")
                    << ", capacitance_feedback = " << Units::display(capacitance_feedback, {"C/V", "fC/mV"})
@@ -233,17 +257,32 @@ void CSADigitizerModule::run(Event* event) {
 
         LOG(DEBUG) << "Received pixel " << pixel_index << ", charge " << Units::display(inputcharge, "e");
 
-        const auto& pulse = pixel_charge.getPulse(); // the pulse containing charges and times
+        const auto& input_pulse = pixel_charge.getPulse(); // the pulse containing charges and times
 
-        if(!pulse.isInitialized()) {
+        if(!input_pulse.isInitialized()) {
             throw ModuleError("No pulse information available.");
         }
 
+        // Resample pulses with piecewise binning onto uniform bins of the length of their fine bins, as the response is
+        // applied to equidistant samples
+        Pulse resampled_pulse;
+        if(!input_pulse.isUniform()) {
+            resampled_pulse = input_pulse.getUniform();
+            LOG(TRACE) << "Resampled pulse with " << input_pulse.size() << " bins of piecewise binning onto "
+                       << resampled_pulse.size() << " uniform bins";
+        }
+        const auto& pulse = (input_pulse.isUniform() ? input_pulse : resampled_pulse);
+
         auto timestep = pulse.getBinning();
         LOG(DEBUG) << "Timestep: " << timestep << " integration_time: " << integration_time_;
         auto ntimepoints = static_cast<size_t>(std::lround(integration_time_ / timestep));
 
         std::call_once(first_event_flag_, [&]() {
+            // The built-in models are applied as recursive filter and only require the sampled response for plotting
+            if(model_ != DigitizerType::CUSTOM && !output_plots_) {
+                return;
+            }
+
             // initialize impulse response function - assume all time bins are equal
             impulse_response_function_.reserve(ntimepoints);
             for(size_t itimepoint = 0; itimepoint < ntimepoints; ++itimepoint) {
@@ -276,16 +315,9 @@ void CSADigitizerModule::run(Event* event) {
                    << Units::display(timestep, {"ps", "ns"}) << ", total charge: " << Units::display(pulse.getCharge(), "e");
 
         // Convolution of the input pulse with the impulse response (size ntimepoints)
-        for(size_t k = 0; k < ntimepoints; ++k) {
-            double outsum{};
-            // Convolution: multiply pulse.at(k - i) * impulse_response_function_.at(i), when (k - i) < input length
-            // -> no point to start i at 0, start from jmin:
-            size_t jmin = (k >= pulse.size() - 1) ? k - (pulse.size() - 1) : 0;
-            for(size_t i = jmin; i <= k; ++i) {
-                outsum += pulse.at(k - i) * impulse_response_function_.at(i);
-            }
-            amplified_pulse.addCharge(outsum, timestep * static_cast<double>(k));
-        }
+        auto amplified = (model_ == DigitizerType::CUSTOM ? convolve(pulse, timestep, ntimepoints)
+                                                          : filter(pulse, timestep, ntimepoints));
+        amplified_pulse.addCharges(0, amplified.data(), ntimepoints);
 
         if(output_pulsegraphs_) {
             // Fill a graph with the pulse:
@@ -297,13 +329,30 @@ void CSADigitizerModule::run(Event* event) {
                                       amplified_pulse);
         }
 
-        // Apply noise to the amplified pulse
+        // Skip pixels whose amplified signal cannot reach the threshold within the noise margin
+        if(skip_pixels_) {
+            auto polarity = (threshold_ > 0 ? 1. : -1.);
+            auto peak = -std::numeric_limits<double>::max();
+            for(auto bin : amplified_pulse) {
+                peak = std::max(peak, std::max(polarity * bin, (ignore_polarity_ ? -polarity : polarity) * bin));
+            }
+            if(peak + noise_margin_ * sigmaNoise_ <= (ignore_polarity_ ? std::fabs(threshold_) : polarity * threshold_)) {
+                LOG(DEBUG) << "Amplified signal peaks at " << Units::display(peak, {"mV", "V"})
+                           << " and cannot cross threshold, skipping noise";
+                pulses.emplace_back(pixel, amplified_pulse, &pixel_charge);
+                continue;
+            }
+        }
+
+        // Apply noise to the amplified pulse, drawn for all bins at once and added in a separate pass
         allpix::normal_distribution<double> pulse_smearing(0, sigmaNoise_);
         LOG(TRACE) << "Adding electronics noise with sigma = " << Units::display(sigmaNoise_, {"mV", "V"});
-        std::transform(amplified_pulse.begin(),
-                       amplified_pulse.end(),
-                       amplified_pulse.begin(),
-                       [&pulse_smearing, &event](auto& c) { return c + (pulse_smearing(event->getRandomEngine())); });
+        thread_local std::vector<double> noise;
+        noise.resize(amplified_pulse.size());
+        std::generate(noise.begin(), noise.end(), [&]() { return pulse_smearing(event->getRandomEngine()); });
+        for(size_t k = 0; k < amplified_pulse.size(); ++k) {
+            amplified_pulse[k] += noise[k];
+        }
 
         // Fill a graphs with the individual pixel pulses:
         if(output_pulsegraphs_) {
@@ -367,60 +416,180 @@ void CSADigitizerModule::run(Event* event) {
     }
 }
 
-std::tuple<bool, unsigned int, double> CSADigitizerModule::get_toa(double timestep, const std::vector<double>& pulse) const {
+std::vector<double> CSADigitizerModule::convolve(const Pulse& pulse, double timestep, size_t ntimepoints) const {
+    std::vector<double> output(ntimepoints);
 
-    LOG(TRACE) << "Calculating time-of-arrival";
-    bool threshold_crossed = false;
-    unsigned int comparator_cycles = 0;
-    double arrival_time = 0;
-
-    // Lambda for threshold calculation:
-    auto is_above_threshold = [this](double bin) {
-        if(ignore_polarity_) {
-            return (std::fabs(bin) > std::fabs(threshold_));
-        } else {
-            return (threshold_ > 0 ? bin > threshold_ : bin < threshold_);
+    // Only the input bins within the integration time contribute, starting from the first stored bin of the pulse
+    const auto offset = pulse.getOffset();
+    const auto length = (offset < ntimepoints ? std::min(pulse.size(), ntimepoints - offset) : 0);
+    if(length == 0) {
+        return output;
+    }
+
+    // Estimate the cost of the direct convolution against two transforms of the padded input, as the transform of the
+    // impulse response is cached. The linear convolution fits into a transform of the input and response length combined.
+    const auto outputs = static_cast<double>(ntimepoints - offset);
+    const auto direct_cost = static_cast<double>(length) * (outputs - 0.5 * static_cast<double>(length));
+    const auto size = fft_size(length + ntimepoints - 1);
+    const auto fft_cost = 8.0 * static_cast<double>(size) * std::log2(static_cast<double>(size));
+
+    if(direct_cost <= fft_cost) {
+        for(size_t k = offset; k < ntimepoints; ++k) {
+            double outsum{};
+            // Convolution: multiply pulse.at(k - i) * impulse_response_function_.at(i), when (k - i) < input length
+            // -> no point to start i at 0, start from jmin:
+            size_t jmin = (k - offset >= length - 1) ? k - offset - (length - 1) : 0;
+            for(size_t i = jmin; i <= k - offset; ++i) {
+                outsum += pulse[k - offset - i] * impulse_response_function_.at(i);
+            }
+            output[k] = outsum;
         }
+        return output;
+    }
+
+    // Transformed impulse responses of the module instance, cached per thread for each timestep and transform size
+    thread_local std::map<std::tuple<const CSADigitizerModule*, double, size_t>, std::vector<std::complex<double>>>
+        response_transforms;
+    auto& response = response_transforms[{this, timestep, size}];
+    if(response.empty()) {
+        LOG(DEBUG) << "Caching transformed impulse response with " << size << " samples";
+        response.assign(size, 0.0);
+        std::copy(impulse_response_function_.begin(),
+                  impulse_response_function_.begin() +
+                      static_cast<std::ptrdiff_t>(std::min(impulse_response_function_.size(), ntimepoints)),
+                  response.begin());
+        fft(response);
+    }
+
+    // Thread-local buffer to avoid reallocation for every pixel
+    thread_local std::vector<std::complex<double>> buffer;
+    buffer.assign(size, 0.0);
+    std::copy(pulse.begin(), pulse.begin() + static_cast<std::ptrdiff_t>(length), buffer.begin());
+    fft(buffer);
+    for(size_t i = 0; i < size; ++i) {
+        buffer[i] *= response[i];
+    }
+    fft(buffer, true);
+
+    for(size_t k = offset; k < ntimepoints; ++k) {
+        output[k] = buffer[k - offset].real();
+    }
+    return output;
+}
+
+std::vector<double> CSADigitizerModule::filter(const Pulse& pulse, double timestep, size_t ntimepoints) const {
+    std::vector<double> output(ntimepoints);
+
+    const auto offset = pulse.getOffset();
+    const auto length = (offset < ntimepoints ? std::min(pulse.size(), ntimepoints - offset) : 0);
+    if(length == 0) {
+        return output;
+    }
+
+    // Each exponential of the response accumulates the input with its decay over one time step. The response vanishes at
+    // zero time, the input of the current bin therefore cancels in the difference as in the sampled convolution.
+    const auto decay_feedback = std::exp(-timestep / tau_feedback_);
+    const auto decay_rise = std::exp(-timestep / tau_rise_);
+    const auto scale = response_amplitude_ / (tau_feedback_ - tau_rise_);
+    double state_feedback{}, state_rise{};
+    for(size_t k = offset; k < ntimepoints; ++k) {
+        const auto input = (k - offset < length ? pulse[k - offset] : 0.);
+        state_feedback = decay_feedback * state_feedback + input;
+        state_rise = decay_rise * state_rise + input;
+        output[k] = scale * (state_feedback - state_rise);
+    }
+    return output;
+}
+
+size_t CSADigitizerModule::find_bin(const std::vector<double>& pulse, size_t begin, size_t end, bool above) const {
+    // Compare the signal against the threshold in the direction of its polarity, or its absolute value if the polarity is
+    // ignored. Searching below threshold flips the sign of the difference.
+    const auto polarity = (threshold_ > 0 ? 1. : -1.);
+    const auto other_polarity = (ignore_polarity_ ? -polarity : polarity);
+    const auto level = (ignore_polarity_ ? std::fabs(threshold_) : polarity * threshold_);
+    const auto direction = (above ? 1. : -1.);
+    auto matches = [&](double bin) {
+        return direction * (std::max(polarity * bin, other_polarity * bin) - level) > 0;
     };
 
-    // Find the point where the signal crosses the threshold, latch ToA
-    while(arrival_time < integration_time_) {
-        auto bin = pulse.at(static_cast<size_t>(std::floor(arrival_time / timestep)));
-        if(is_above_threshold(bin)) {
-            threshold_crossed = true;
+    auto bin = begin;
+    for(; bin + scan_block_size <= end; bin += scan_block_size) {
+        bool any = false;
+        for(size_t i = bin; i < bin + scan_block_size; ++i) {
+            any |= matches(pulse[i]);
+        }
+        if(any) {
             break;
-        };
-        comparator_cycles++;
-        arrival_time += (store_toa_ ? clockToA_ : timestep);
+        }
     }
-    return {threshold_crossed, comparator_cycles, arrival_time};
+    for(; bin < end; ++bin) {
+        if(matches(pulse[bin])) {
+            return bin;
+        }
+    }
+    return end;
 }
 
-unsigned int CSADigitizerModule::get_tot(double timestep, double arrival_time, const std::vector<double>& pulse) const {
+std::pair<size_t, bool> CSADigitizerModule::find_cycle(
+    const std::vector<double>& pulse, double timestep, double clock, size_t cycle, bool above) const {
+    // Bin sampled by a clock cycle, which is the cycle itself when sampling every bin
+    auto sample_bin = [&](size_t c) {
+        return (clock == timestep ? c : static_cast<size_t>(std::floor(static_cast<double>(c) * clock / timestep)));
+    };
 
-    LOG(TRACE) << "Calculating time-over-threshold, starting at " << Units::display(arrival_time, {"ps", "ns", "us"});
-    unsigned int tot_clock_cycles = 0;
-
-    // Lambda for threshold calculation:
-    auto is_below_threshold = [this](double bin) {
-        if(ignore_polarity_) {
-            return (std::fabs(bin) < std::fabs(threshold_));
-        } else {
-            return (threshold_ > 0 ? bin < threshold_ : bin > threshold_);
+    // Clock cycles starting within the integration time and sampling a bin of the pulse
+    auto end = static_cast<size_t>(std::ceil(integration_time_ / clock));
+    while(end > 0 && static_cast<double>(end - 1) * clock >= integration_time_) {
+        end--;
+    }
+    while(end > 0 && sample_bin(end - 1) >= pulse.size()) {
+        end--;
+    }
+    end = std::max(end, cycle);
+
+    // Scan the consecutive bins for the next match and check the first cycle sampling it or a later bin
+    while(cycle < end) {
+        auto last_bin = sample_bin(end - 1);
+        auto bin = find_bin(pulse, sample_bin(cycle), last_bin + 1, above);
+        if(bin > last_bin) {
+            break;
         }
-    };
 
-    // Start calculation from the next ToT clock cycle following the threshold crossing
-    auto tot_time = clockToT_ * std::ceil(arrival_time / clockToT_);
-    while(tot_time < integration_time_) {
-        auto bin = pulse.at(static_cast<size_t>(std::floor(tot_time / timestep)));
-        if(is_below_threshold(bin)) {
+        auto estimate = static_cast<size_t>(std::floor(static_cast<double>(bin) * timestep / clock));
+        cycle = std::max(cycle, (estimate > 0 ? estimate - 1 : 0));
+        while(sample_bin(cycle) < bin) {
+            cycle++;
+        }
+        if(cycle >= end) {
             break;
         }
-        tot_clock_cycles++;
-        tot_time += clockToT_;
+        auto sampled = sample_bin(cycle);
+        if(find_bin(pulse, sampled, sampled + 1, above) == sampled) {
+            return {cycle, true};
+        }
+        cycle++;
     }
-    return tot_clock_cycles;
+    return {end, false};
+}
+
+std::tuple<bool, unsigned int, double> CSADigitizerModule::get_toa(double timestep, const std::vector<double>& pulse) const {
+
+    LOG(TRACE) << "Calculating time-of-arrival";
+
+    // Find the point where the signal crosses the threshold, latch ToA
+    auto clock = (store_toa_ ? clockToA_ : timestep);
+    auto [comparator_cycles, threshold_crossed] = find_cycle(pulse, timestep, clock, 0, true);
+    return {threshold_crossed, static_cast<unsigned int>(comparator_cycles), static_cast<double>(comparator_cycles) * clock};
+}
+
+unsigned int CSADigitizerModule::get_tot(double timestep, double arrival_time, const std::vector<double>& pulse) const {
+
+    LOG(TRACE) << "Calculating time-over-threshold, starting at " << Units::display(arrival_time, {"ps", "ns", "us"});
+
+    // Start calculation from the next ToT clock cycle following the threshold crossing
+    auto first_cycle = static_cast<size_t>(std::ceil(arrival_time / clockToT_));
+    auto last_cycle = find_cycle(pulse, timestep, clockToT_, first_cycle, false).first;
+    return static_cast<unsigned int>(last_cycle - first_cycle);
 }
 
 void CSADigitizerModule::create_output_pulsegraphs(const std::string& s_event_num,
@@ -14,6 +14,7 @@
 
 #include <memory>
 #include <string>
+#include <utility>
 
 #include "core/config/Configuration.hpp"
 #include "core/messenger/Messenger.hpp"
@@ -80,9 +81,16 @@ namespace allpix {
         // Function to calculate impulse response
         std::unique_ptr<TFormula> calculate_impulse_response_;
 
+        // Parameters of the two-pole impulse response of the built-in models, applied as recursive filter
+        double response_amplitude_{}, tau_feedback_{}, tau_rise_{};
+
         // Parameters of the electronics: Noise, time-over-threshold logic
         double sigmaNoise_{}, clockToT_{}, clockToA_{}, threshold_{};
 
+        // Skip pixels which cannot cross the threshold with noise below the given number of standard deviations
+        bool skip_pixels_{false};
+        double noise_margin_{};
+
         // Helper variables for transfer function
         double integration_time_{};
         std::vector<double> impulse_response_function_;
@@ -92,6 +100,53 @@ namespace allpix {
         Histogram<TH1D> h_tot{}, h_toa{};
         Histogram<TH2D> h_pxq_vs_tot{};
 
+        /**
+         * @brief Convolve the input pulse with the impulse response
+         * @param pulse      Input pulse
+         * @param timestep   Step size of the input pulse
+         * @param ntimepoints Number of bins within the integration time
+         * @return Amplified pulse without noise for each bin within the integration time
+         *
+         * The direct convolution is used for short pulses, longer ones are convolved via fast Fourier transforms.
+         */
+        std::vector<double> convolve(const Pulse& pulse, double timestep, size_t ntimepoints) const;
+
+        /**
+         * @brief Apply the impulse response of the built-in models as recursive filter
+         * @param pulse      Input pulse
+         * @param timestep   Step size of the input pulse
+         * @param ntimepoints Number of bins within the integration time
+         * @return Amplified pulse without noise for each bin within the integration time
+         *
+         * The impulse response is a difference of two exponentials, its convolution with the sampled pulse is therefore
+         * obtained exactly from two first-order recursions with the decay factors of the exponentials over one time step.
+         */
+        std::vector<double> filter(const Pulse& pulse, double timestep, size_t ntimepoints) const;
+
+        /**
+         * @brief Find the first bin of a range which is above or below threshold
+         * @param pulse Pulse after amplification and electronics noise
+         * @param begin First bin of the range
+         * @param end   Bin past the end of the range
+         * @param above Search for a bin above threshold if true, below threshold otherwise
+         * @return Index of the first matching bin, or end if no bin matches
+         *
+         * The bins are compared in blocks without branches, such that the comparisons can be vectorized.
+         */
+        size_t find_bin(const std::vector<double>& pulse, size_t begin, size_t end, bool above) const;
+
+        /**
+         * @brief Find the first clock cycle within the integration time sampling a bin above or below threshold
+         * @param pulse    Pulse after amplification and electronics noise
+         * @param timestep Step size of the input pulse
+         * @param clock    Duration of a clock cycle
+         * @param cycle    First clock cycle to consider
+         * @param above    Search for a cycle above threshold if true, below threshold otherwise
+         * @return Pair of the matching cycle and true, or the number of cycles within the integration time and false
+         */
+        std::pair<size_t, bool>
+        find_cycle(const std::vector<double>& pulse, double timestep, double clock, size_t cycle, bool above) const;
+
         /**
          * @brief Calculate time of first threshold crossing
          * @param timestep Step size of the input pulse
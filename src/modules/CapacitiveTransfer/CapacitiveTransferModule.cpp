@@ -22,6 +22,7 @@
 #include "core/utils/log.h"
 #include "core/utils/unit.h"
 #include "tools/ROOT.h"
+#include "tools/pixel_map.h"
 
 #include <Eigen/Core>
 
@@ -258,6 +259,68 @@ void CapacitiveTransferModule::initialize() {
             "Capacitive coupling was not defined. Please, check the README file for configuration options or use "
             "the SimpleTransfer module.");
     }
+
+    // Precompute the coupling stencil around the pixel the charge is collected at
+    for(unsigned int row = 0; row < max_row_; row++) {
+        for(unsigned int col = 0; col < max_col_; col++) {
+            // Without cross-coupling, only the central element of the matrix is used
+            auto coupling_col = (cross_coupling_ ? col : matrix_cols_ / 2);
+            auto coupling_row = (cross_coupling_ ? row : matrix_rows_ / 2);
+
+            Coupling coupling{coupling_col,
+                              coupling_row,
+                              static_cast<int>(coupling_col) - static_cast<int>(matrix_cols_ / 2),
+                              static_cast<int>(coupling_row) - static_cast<int>(matrix_rows_ / 2),
+                              0.};
+            if(config_.has("coupling_file")) {
+                coupling.factor = relative_coupling_[coupling_col][coupling_row];
+            } else if(config_.has("coupling_matrix")) {
+                coupling.factor = relative_coupling_[max_row_ - coupling_row - 1][coupling_col];
+            }
+
+            // If there is no cross-coupling (factor is zero) no pixel hit needs to be created:
+            if(!config_.has("coupling_scan_file") && std::fabs(coupling.factor) < std::numeric_limits<double>::epsilon()) {
+                LOG(TRACE) << "Detected zero coupling to neighbour " << coupling_col << "," << coupling_row;
+                continue;
+            }
+            coupling_stencil_.push_back(coupling);
+
+            if(!cross_coupling_) {
+                break;
+            }
+        }
+        if(!cross_coupling_) {
+            break;
+        }
+    }
+
+    // Tabulate the coupling factors of the capacitance scan, which depend on the gap at the coupled pixel
+    if(config_.has("coupling_scan_file")) {
+        auto xpixels = model_->getNPixels().x();
+        auto ypixels = model_->getNPixels().y();
+        scan_coupling_.resize(static_cast<size_t>(xpixels) * ypixels * coupling_stencil_.size());
+        for(unsigned int x = 0; x < xpixels; x++) {
+            for(unsigned int y = 0; y < ypixels; y++) {
+                for(size_t i = 0; i < coupling_stencil_.size(); i++) {
+                    scan_coupling_[(static_cast<size_t>(x) * ypixels + y) * coupling_stencil_.size() + i] =
+                        get_scan_coupling(static_cast<int>(x), static_cast<int>(y), coupling_stencil_[i]);
+                }
+            }
+        }
+        LOG(DEBUG) << "Tabulated coupling factors for " << xpixels * ypixels << " pixels";
+    }
+}
+
+double CapacitiveTransferModule::get_scan_coupling(int x, int y, const Coupling& coupling) const {
+    double local_x = x * model_->getPixelSize().x();
+    double local_y = y * model_->getPixelSize().y();
+    auto pixel_point = Eigen::Vector3d(local_x, local_y, 0);
+    auto pixel_projection = plane_.projection(pixel_point);
+    auto pixel_gap = pixel_projection[2];
+
+    return capacitances_[coupling.row * 3 + coupling.col]->Eval(
+               static_cast<double>(Units::convert(pixel_gap, "um")), nullptr, "S") *
+           normalization_;
 }
 
 void CapacitiveTransferModule::run(Event* event) {
@@ -266,7 +329,9 @@ void CapacitiveTransferModule::run(Event* event) {
     // Find corresponding pixels for all propagated charges
     LOG(TRACE) << "Transferring charges to pixels";
     unsigned int transferred_charges_count = 0;
-    std::map<Pixel::Index, std::pair<double, std::vector<const PropagatedCharge*>>> pixel_map;
+    // Reuse the pixel map of this thread across events to avoid allocations
+    thread_local PixelMap<std::pair<double, std::vector<const PropagatedCharge*>>> pixel_map;
+    pixel_map.clear();
     for(const auto& propagated_charge : propagated_message->getData()) {
         auto position = propagated_charge.getLocalPosition();
         // Ignore if outside depth range of implant
@@ -281,44 +346,32 @@ void CapacitiveTransferModule::run(Event* event) {
         auto [xpixel, ypixel] = model_->getPixelIndex(position);
         LOG(DEBUG) << "Hit at pixel " << xpixel << ", " << ypixel;
 
-        for(size_t row = 0; row < max_row_; row++) {
-            for(size_t col = 0; col < max_col_; col++) {
-                if(!cross_coupling_) {
-                    col = static_cast<size_t>(std::floor(matrix_cols_ / 2));
-                    row = static_cast<size_t>(std::floor(matrix_rows_ / 2));
-                }
-
-                auto xcoord = xpixel + static_cast<int>(col - static_cast<size_t>(std::floor(matrix_cols_ / 2)));
-                auto ycoord = ypixel + static_cast<int>(row - static_cast<size_t>(std::floor(matrix_rows_ / 2)));
-
-                // Ignore if out of pixel grid
-                if(!detector_->getModel()->isWithinMatrix(xcoord, ycoord)) {
-                    LOG(DEBUG) << "Skipping set of propagated charges at " << propagated_charge.getLocalPosition()
-                               << " because their nearest pixel (" << xpixel << "," << ypixel
-                               << ") is outside the pixel matrix";
-                    continue;
-                }
-
-                auto pixel_index = Pixel::Index(xcoord, ycoord);
-
-                double ccpd_factor = 0;
-                if(config_.has("coupling_scan_file")) {
-                    double local_x = pixel_index.x() * model_->getPixelSize().x();
-                    double local_y = pixel_index.y() * model_->getPixelSize().y();
-                    auto pixel_point = Eigen::Vector3d(local_x, local_y, 0);
-                    auto pixel_projection = plane_.projection(pixel_point);
-                    auto pixel_gap = pixel_projection[2];
+        for(size_t i = 0; i < coupling_stencil_.size(); i++) {
+            const auto& coupling = coupling_stencil_[i];
+            auto xcoord = xpixel + coupling.dx;
+            auto ycoord = ypixel + coupling.dy;
+
+            // Ignore if out of pixel grid
+            if(!model_->isWithinMatrix(xcoord, ycoord)) {
+                LOG(DEBUG) << "Skipping set of propagated charges at " << propagated_charge.getLocalPosition()
+                           << " because their nearest pixel (" << xpixel << "," << ypixel
+                           << ") is outside the pixel matrix";
+                continue;
+            }
 
-                    ccpd_factor = capacitances_[row * 3 + col]->Eval(
-                                      static_cast<double>(Units::convert(pixel_gap, "um")), nullptr, "S") *
-                                  normalization_;
-                } else if(config_.has("coupling_file")) {
-                    ccpd_factor = relative_coupling_[col][row];
-                } else if(config_.has("coupling_matrix")) {
-                    ccpd_factor = relative_coupling_[max_row_ - row - 1][col];
+            auto pixel_index = Pixel::Index(xcoord, ycoord);
+
+            auto ccpd_factor = coupling.factor;
+            if(!scan_coupling_.empty()) {
+                auto xpixels = model_->getNPixels().x();
+                auto ypixels = model_->getNPixels().y();
+                if(xcoord >= 0 && ycoord >= 0 && static_cast<unsigned int>(xcoord) < xpixels &&
+                   static_cast<unsigned int>(ycoord) < ypixels) {
+                    ccpd_factor = scan_coupling_[(static_cast<size_t>(xcoord) * ypixels + static_cast<size_t>(ycoord)) *
+                                                     coupling_stencil_.size() +
+                                                 i];
                 } else {
-                    ccpd_factor = 1;
-                    LOG(ERROR) << "This shouldn't happen. Transferring 100% of detected charge";
+                    ccpd_factor = get_scan_coupling(xcoord, ycoord, coupling);
                 }
 
                 // If there is no cross-coupling (factor is zero) don't create a pixel hit:
@@ -326,26 +379,29 @@ void CapacitiveTransferModule::run(Event* event) {
                     LOG(TRACE) << "Detected zero coupling, skipping pixel hit creation";
                     continue;
                 }
+            }
 
-                // Update statistics
-                transferred_charges_count += static_cast<unsigned int>(propagated_charge.getCharge() * ccpd_factor);
-                auto neighbour_charge =
-                    static_cast<double>(propagated_charge.getSign() * propagated_charge.getCharge()) * ccpd_factor;
+            // Update statistics
+            transferred_charges_count += static_cast<unsigned int>(propagated_charge.getCharge() * ccpd_factor);
+            auto neighbour_charge =
+                static_cast<double>(propagated_charge.getSign() * propagated_charge.getCharge()) * ccpd_factor;
 
-                LOG(DEBUG) << "Set of " << propagated_charge.getCharge() * ccpd_factor << " charges brought to neighbour "
-                           << col << "," << row << " pixel " << pixel_index << "with cross-coupling of " << ccpd_factor * 100
-                           << "%";
+            LOG(DEBUG) << "Set of " << propagated_charge.getCharge() * ccpd_factor << " charges brought to neighbour "
+                       << coupling.col << "," << coupling.row << " pixel " << pixel_index << "with cross-coupling of "
+                       << ccpd_factor * 100 << "%";
 
-                // Add the pixel the list of hit pixels
-                pixel_map[pixel_index].first += neighbour_charge;
-                pixel_map[pixel_index].second.emplace_back(&propagated_charge);
-            }
+            // Add the pixel the list of hit pixels
+            auto& pixel_charge = pixel_map[pixel_index];
+            pixel_charge.first += neighbour_charge;
+            pixel_charge.second.emplace_back(&propagated_charge);
         }
     }
 
     // Create pixel charges
     LOG(TRACE) << "Combining charges at same pixel";
+    pixel_map.sort();
     std::vector<PixelCharge> pixel_charges;
+    pixel_charges.reserve(pixel_map.size());
     for(auto& pixel_index_charge : pixel_map) {
         double charge = pixel_index_charge.second.first;
 
@@ -91,6 +91,30 @@ namespace allpix {
         void getCapacitanceScan(TFile* root_file);
         std::array<TGraph*, 9> capacitances_{};
 
+        /**
+         * @brief Element of the coupling matrix applied to the pixel the charge is collected at
+         */
+        struct Coupling {
+            unsigned int col;
+            unsigned int row;
+            int dx;
+            int dy;
+            double factor;
+        };
+        // Non-zero elements of the coupling matrix, precomputed to avoid looking up the configuration for every charge
+        std::vector<Coupling> coupling_stencil_;
+
+        /**
+         * @brief Calculate the coupling factor to a pixel from the capacitance scan, taking into account its gap
+         * @param x Column of the coupled pixel
+         * @param y Row of the coupled pixel
+         * @param coupling Element of the coupling matrix
+         * @return Relative coupling factor
+         */
+        double get_scan_coupling(int x, int y, const Coupling& coupling) const;
+        // Coupling factors from the capacitance scan tabulated for every pixel, indexed by the pixel and matrix element
+        std::vector<double> scan_coupling_;
+
         Eigen::Hyperplane<double, 3> plane_;
 
         Histogram<TH2D> coupling_map;
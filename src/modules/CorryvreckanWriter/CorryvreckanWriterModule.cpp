@@ -14,6 +14,7 @@
 #include <Math/RotationZYX.h>
 #include <TProcessID.h>
 
+#include <deque>
 #include <fstream>
 #include <string>
 #include <utility>
@@ -34,6 +35,14 @@ CorryvreckanWriterModule::CorryvreckanWriterModule(Configuration& config, Messen
     config_.setDefault("geometry_file", "corryvreckanGeometry.conf");
     config_.setDefault("global_timing", false);
     config_.setDefault("output_mctruth", true);
+    config_.setDefault<bool>("write_asynchronously", false);
+    config_.setDefault<unsigned int>("write_queue_size", 16);
+
+    write_asynchronously_ = config_.get<bool>("write_asynchronously");
+    write_queue_size_ = config_.get<unsigned int>("write_queue_size");
+    if(write_queue_size_ == 0) {
+        throw InvalidValueError(config_, "write_queue_size", "queue needs to hold at least one event");
+    }
 }
 
 // Set up the output trees
@@ -60,6 +69,9 @@ void CorryvreckanWriterModule::initialize() {
     fileName_ = createOutputFile(config_.get<std::string>("file_name"), "root");
     LOG(TRACE) << "Creating output file \"" << fileName_ << "\"";
     output_file_ = std::make_unique<TFile>(fileName_.c_str(), "RECREATE");
+    if(config_.has("compression_settings")) {
+        output_file_->SetCompressionSettings(config_.get<int>("compression_settings"));
+    }
     output_file_->cd();
 
     // Create geometry file:
@@ -78,8 +90,26 @@ void CorryvreckanWriterModule::initialize() {
         mcparticle_tree_ = std::make_unique<TTree>("MCParticle", (std::string("Tree of MCParticles").c_str()));
     }
 
+    if(config_.has("auto_flush")) {
+        auto auto_flush = config_.get<Long64_t>("auto_flush");
+        event_tree_->SetAutoFlush(auto_flush);
+        pixel_tree_->SetAutoFlush(auto_flush);
+        if(output_mc_truth_) {
+            mcparticle_tree_->SetAutoFlush(auto_flush);
+        }
+    }
+
     // Initialise the time
     time_ = 0;
+
+    if(write_asynchronously_) {
+        LOG(INFO) << "Writing objects asynchronously, buffering up to " << write_queue_size_ << " events";
+        writer_.start(write_queue_size_, [this](std::deque<PendingEvent>& batch) {
+            for(auto& pending : batch) {
+                write_event(pending);
+            }
+        });
+    }
 }
 
 // Make instantiations of Corryvreckan pixels, and store these in the trees during run time
@@ -93,14 +123,12 @@ void CorryvreckanWriterModule::run(Event* event) {
 
     LOG(TRACE) << "Processing event " << event->number;
 
-    // Create and store a new Event:
-    event_ = new corryvreckan::Event(time_, time_ + 5);
-    LOG(DEBUG) << "Defining event for Corryvreckan: [" << Units::display(event_->start(), {"ns", "um"}) << ","
-               << Units::display(event_->end(), {"ns", "um"}) << "]";
-    event_tree_->Fill();
-
-    // Events start with 1, pre-filling only with empty events before:
-    auto event_id = event->number - 1;
+    // Create a new Event:
+    PendingEvent pending;
+    pending.number = event->number;
+    pending.event = std::make_unique<corryvreckan::Event>(time_, time_ + 5);
+    LOG(DEBUG) << "Defining event for Corryvreckan: [" << Units::display(pending.event->start(), {"ns", "um"}) << ","
+               << Units::display(pending.event->end(), {"ns", "um"}) << "]";
 
     // Loop through all received messages
     for(auto& message : pixel_messages) {
@@ -116,6 +144,65 @@ void CorryvreckanWriterModule::run(Event* event) {
 
         LOG(DEBUG) << "Received " << message->getData().size() << " pixel hits from detector " << detector_name;
 
+        // Every detector with a message receives a branch, even without any hits
+        auto& pixels = pending.pixels[detector_name];
+        pixels.reserve(message->getData().size());
+        auto* mcparticles = (output_mc_truth_ ? &pending.mcparticles[detector_name] : nullptr);
+
+        // Fill the branch vector
+        for(const auto& apx_pixel : message->getData()) {
+            auto* corry_pixel = new corryvreckan::Pixel(
+                detector_name,
+                apx_pixel.getPixel().getIndex().X(),
+                apx_pixel.getPixel().getIndex().Y(),
+                static_cast<int>(apx_pixel.getSignal()),
+                apx_pixel.getSignal(),
+                (timing_global_ ? pending.event->start() + apx_pixel.getGlobalTime() : apx_pixel.getLocalTime()));
+            pixels.push_back(corry_pixel);
+
+            // If writing MC truth then also write out associated particle info
+            if(mcparticles == nullptr) {
+                continue;
+            }
+
+            // Get all associated particles
+            auto mcp = apx_pixel.getMCParticles();
+            LOG(DEBUG) << "Received " << mcp.size() << " Monte Carlo particles from pixel hit";
+            for(auto& particle : mcp) {
+                auto* mcParticle = new corryvreckan::MCParticle(
+                    detector_name,
+                    particle->getParticleID(),
+                    particle->getLocalStartPoint() + offset,
+                    particle->getLocalEndPoint() + offset,
+                    (timing_global_ ? pending.event->start() + particle->getGlobalTime() : particle->getLocalTime()));
+                mcparticles->push_back(mcParticle);
+            }
+        }
+    }
+
+    // Increment the time till the next event
+    time_ += 10;
+
+    if(write_asynchronously_) {
+        // Reset object count:
+        TProcessID::SetObjectCount(object_count);
+        root_lock.unlock();
+
+        writer_.push(std::move(pending));
+    } else {
+        write_event(pending);
+
+        // Reset object count:
+        TProcessID::SetObjectCount(object_count);
+    }
+}
+
+void CorryvreckanWriterModule::write_event(PendingEvent& pending) {
+    // Events start with 1, pre-filling only with empty events before:
+    auto event_id = pending.number - 1;
+
+    // Create the branches of detectors seen for the first time, pre-filling them with empty events
+    for(auto& [detector_name, pixels] : pending.pixels) {
         if(write_list_px_.find(detector_name) == write_list_px_.end()) {
             write_list_px_[detector_name] = new std::vector<corryvreckan::Pixel*>();
             pixel_tree_->Bronch(detector_name.c_str(),
@@ -132,7 +219,12 @@ void CorryvreckanWriterModule::run(Event* event) {
             }
         }
 
-        if(output_mc_truth_ && write_list_mcp_.find(detector_name) == write_list_mcp_.end()) {
+        // Swap the objects into the branch vector, leaving its previous, empty buffer with the pending event
+        write_list_px_[detector_name]->swap(pixels);
+    }
+
+    for(auto& [detector_name, mcparticles] : pending.mcparticles) {
+        if(write_list_mcp_.find(detector_name) == write_list_mcp_.end()) {
             write_list_mcp_[detector_name] = new std::vector<corryvreckan::MCParticle*>();
             mcparticle_tree_->Bronch(detector_name.c_str(),
                                      std::string("std::vector<corryvreckan::MCParticle*>").c_str(),
@@ -149,40 +241,14 @@ void CorryvreckanWriterModule::run(Event* event) {
             }
         }
 
-        // Fill the branch vector
-        for(const auto& apx_pixel : message->getData()) {
-            auto* corry_pixel = new corryvreckan::Pixel(
-                detector_name,
-                apx_pixel.getPixel().getIndex().X(),
-                apx_pixel.getPixel().getIndex().Y(),
-                static_cast<int>(apx_pixel.getSignal()),
-                apx_pixel.getSignal(),
-                (timing_global_ ? event_->start() + apx_pixel.getGlobalTime() : apx_pixel.getLocalTime()));
-            write_list_px_[detector_name]->push_back(corry_pixel);
-
-            // If writing MC truth then also write out associated particle info
-            if(!output_mc_truth_) {
-                continue;
-            }
-
-            // Get all associated particles
-            auto mcp = apx_pixel.getMCParticles();
-            LOG(DEBUG) << "Received " << mcp.size() << " Monte Carlo particles from pixel hit";
-            for(auto& particle : mcp) {
-                auto* mcParticle = new corryvreckan::MCParticle(
-                    detector_name,
-                    particle->getParticleID(),
-                    particle->getLocalStartPoint() + offset,
-                    particle->getLocalEndPoint() + offset,
-                    (timing_global_ ? event_->start() + particle->getGlobalTime() : particle->getLocalTime()));
-                write_list_mcp_[detector_name]->push_back(mcParticle);
-            }
-        }
+        write_list_mcp_[detector_name]->swap(mcparticles);
     }
 
     LOG(TRACE) << "Writing new objects to tree";
     output_file_->cd();
 
+    event_ = pending.event.get();
+    event_tree_->Fill();
     pixel_tree_->Fill();
     if(output_mc_truth_) {
         mcparticle_tree_->Fill();
@@ -204,18 +270,14 @@ void CorryvreckanWriterModule::run(Event* event) {
         index_data.second->clear();
     }
 
-    // Increment the time till the next event
-    time_ += 10;
-
     // Delete the currently stored event object
-    delete event_;
-
-    // Reset object count:
-    TProcessID::SetObjectCount(object_count);
+    event_ = nullptr;
+    pending.event.reset();
 }
 
 // Save the output trees to file
 void CorryvreckanWriterModule::finalize() {
+    writer_.finish();
 
     // Finish writing to output file
     output_file_->Write();
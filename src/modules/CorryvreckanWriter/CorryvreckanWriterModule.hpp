@@ -9,7 +9,11 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <cstdint>
+#include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "core/config/Configuration.hpp"
 #include "core/geometry/GeometryManager.hpp"
@@ -24,6 +28,8 @@
 #include "corryvreckan/Pixel.hpp"
 #include "objects/PixelHit.hpp"
 
+#include "tools/async_writer.h"
+
 // ROOT includes
 #include "TFile.h"
 #include "TTree.h"
@@ -62,6 +68,20 @@ namespace allpix {
         void finalize() override;
 
     private:
+        // Converted event waiting to be written, owning the Corryvreckan objects until they have been written
+        struct PendingEvent {
+            uint64_t number{};
+            std::unique_ptr<corryvreckan::Event> event;
+            std::map<std::string, std::vector<corryvreckan::Pixel*>> pixels;
+            std::map<std::string, std::vector<corryvreckan::MCParticle*>> mcparticles;
+        };
+
+        /**
+         * @brief Create missing branches, fill all trees with an event and delete its objects
+         * @param pending Event to write
+         */
+        void write_event(PendingEvent& pending);
+
         // General module members
         Messenger* messenger_;
         GeometryManager* geometryManager_;
@@ -84,5 +104,9 @@ namespace allpix {
         std::unique_ptr<TTree> mcparticle_tree_;
         std::map<std::string, std::vector<corryvreckan::Pixel*>*> write_list_px_;
         std::map<std::string, std::vector<corryvreckan::MCParticle*>*> write_list_mcp_;
+
+        bool write_asynchronously_{};
+        size_t write_queue_size_{};
+        AsyncWriter<PendingEvent> writer_;
     };
 } // namespace allpix
@@ -11,7 +11,10 @@
 
 #include "DatabaseWriterModule.hpp"
 
+#include <deque>
 #include <fstream>
+#include <iterator>
+#include <memory>
 #include <optional>
 #include <string>
 #include <utility>
@@ -28,6 +31,13 @@
 
 using namespace allpix;
 
+namespace {
+    // Deposits of electron-hole pairs are stored without a carrier type, the type column is zero for them
+    int carrier_type(const DepositedCharge& deposit) {
+        return (deposit.isPaired() ? 0 : static_cast<int>(deposit.getType()));
+    }
+} // namespace
+
 thread_local std::shared_ptr<pqxx::connection> DatabaseWriterModule::conn_ = nullptr;
 
 DatabaseWriterModule::DatabaseWriterModule(Configuration& config, Messenger* messenger, GeometryManager*)
@@ -42,6 +52,11 @@ DatabaseWriterModule::DatabaseWriterModule(Configuration& config, Messenger* mes
 
     config_.setDefault("run_id", "none");
 
+    // Bulk insertion via COPY, buffering the rows of several events
+    config_.setDefault("bulk_insert", false);
+    config_.setDefault("bulk_events", 100);
+    config_.setDefault("bulk_id_block", 10000);
+
     // retrieving configuration parameters
     host_ = config_.get<std::string>("host");
     port_ = config_.get<std::string>("port");
@@ -53,6 +68,15 @@ DatabaseWriterModule::DatabaseWriterModule(Configuration& config, Messenger* mes
     // Select pixel hit timing information to be saved:
     timing_global_ = config_.get<bool>("global_timing");
 
+    bulk_insert_ = config_.get<bool>("bulk_insert");
+    bulk_events_ = config_.get<unsigned int>("bulk_events");
+    bulk_id_block_ = config_.get<unsigned int>("bulk_id_block");
+    if(bulk_insert_ && (bulk_events_ == 0 || bulk_id_block_ == 0)) {
+        throw InvalidValueError(config_,
+                                (bulk_events_ == 0 ? "bulk_events" : "bulk_id_block"),
+                                "value needs to be larger than zero for bulk insertion");
+    }
+
     // Waive sequence requirement if requested by user
     if(!config_.get<bool>("require_sequence")) {
         waive_sequence_requirement();
@@ -100,6 +124,37 @@ void DatabaseWriterModule::prepare_statements(const std::shared_ptr<pqxx::connec
                         "hittime) VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9) RETURNING pixelHit_nr;");
 }
 
+void DatabaseWriterModule::initialize() {
+    if(!bulk_insert_) {
+        return;
+    }
+
+    // Insert the run entry once, all threads and the background writer share it
+    try {
+        bulk_connection_ = std::make_unique<pqxx::connection>("host=" + host_ + " port=" + port_ + " dbname=" +
+                                                              database_name_ + " user=" + user_ + " password=" + password_);
+        pqxx::work transaction(*bulk_connection_);
+        auto runR = transaction.exec1("INSERT INTO Run (run_id) VALUES (" + transaction.quote(run_id_) +
+                                      ") RETURNING run_nr;");
+        run_nr_ = runR.front().as<int>();
+        transaction.commit();
+    } catch(const std::exception& e) {
+        throw ModuleError("SQL error: " + std::string(e.what()));
+    }
+
+    LOG(INFO) << "Bulk insertion enabled, writing every " << bulk_events_ << " events via COPY";
+    // Buffers are written one transaction each, the workers wait if two further buffers are pending
+    bulk_writer_.start(2, [this](std::deque<BulkRows>& batch) {
+        try {
+            for(const auto& rows : batch) {
+                write_bulk(rows);
+            }
+        } catch(const std::exception& e) {
+            throw ModuleError("SQL error: " + std::string(e.what()));
+        }
+    });
+}
+
 void DatabaseWriterModule::initializeThread() {
     // Establishing connection to the database
     conn_ = std::make_shared<pqxx::connection>("host=" + host_ + " port=" + port_ + " dbname=" + database_name_ +
@@ -110,17 +165,19 @@ void DatabaseWriterModule::initializeThread() {
 
     prepare_statements(conn_);
 
-    // Inserting run entry in the database
-    try {
-        // Open new transaction
-        pqxx::work transaction(*conn_);
-        auto runR = transaction.exec_prepared1("add_run", run_id_);
-        run_nr_ = runR.front().as<int>();
-        // Commit transaction to database:
-        transaction.commit();
-
-    } catch(const std::exception& e) {
-        throw ModuleError("SQL error: " + std::string(e.what()));
+    // Inserting run entry in the database, in bulk insertion mode this has already happened
+    if(!bulk_insert_) {
+        try {
+            // Open new transaction
+            pqxx::work transaction(*conn_);
+            auto runR = transaction.exec_prepared1("add_run", run_id_);
+            run_nr_ = runR.front().as<int>();
+            // Commit transaction to database:
+            transaction.commit();
+
+        } catch(const std::exception& e) {
+            throw ModuleError("SQL error: " + std::string(e.what()));
+        }
     }
 
     // Read include and exclude list
@@ -173,6 +230,12 @@ bool DatabaseWriterModule::filter(const std::shared_ptr<BaseMessage>& message,
 void DatabaseWriterModule::run(Event* event) {
     auto messages = messenger_->fetchFilteredMessages(this, event);
 
+    // Buffer the rows for the background writer in bulk insertion mode
+    if(bulk_insert_) {
+        buffer_event(event, messages);
+        return;
+    }
+
     // TO BE NOTED
     // the correct relations of objects in the database are guaranteed by the fact that sequence of dispatched messages
     // within one event always follows this order: MCTrack -> MCParticle -> DepositedCharge -> PropagatedCharge ->
@@ -281,7 +344,7 @@ void DatabaseWriterModule::run(Event* event) {
                                                                 event_nr,
                                                                 mcparticle_nr,
                                                                 detectorName,
-                                                                static_cast<int>(charge.getType()),
+                                                                carrier_type(charge),
                                                                 charge.getCharge(),
                                                                 charge.getLocalPosition().X(),
                                                                 charge.getLocalPosition().Y(),
@@ -332,6 +395,315 @@ void DatabaseWriterModule::run(Event* event) {
     }
 }
 
+int DatabaseWriterModule::next_id(const std::string& table) {
+    std::lock_guard<std::mutex> lock(ids_mutex_);
+    auto& ids = reserved_ids_[table];
+    if(ids.empty()) {
+        // Reserve a new block of identifiers from the sequence of the table, in reverse order to pop them from the back
+        LOG(DEBUG) << "Reserving " << bulk_id_block_ << " identifiers for table " << table;
+        pqxx::nontransaction transaction(*conn_);
+        auto result = transaction.exec("SELECT nextval('" + table + "_" + table + "_nr_seq') FROM generate_series(1, " +
+                                       std::to_string(bulk_id_block_) + ");");
+        for(auto row = result.rbegin(); row != result.rend(); ++row) {
+            ids.push_back(row->front().as<int>());
+        }
+    }
+    auto id = ids.back();
+    ids.pop_back();
+    return id;
+}
+
+void DatabaseWriterModule::buffer_event(Event* event,
+                                        const std::vector<std::pair<std::shared_ptr<BaseMessage>, std::string>>& messages) {
+    // References to the last object of the previous type in the chain, see the regular insertion in run()
+    std::optional<int> mctrack_nr;
+    std::optional<int> mcparticle_nr;
+    std::optional<int> depositedcharge_nr;
+    std::optional<int> propagatedcharge_nr;
+    std::optional<int> pixelcharge_nr;
+
+    BulkRows rows;
+    try {
+        auto event_nr = next_id("event");
+        rows.events.emplace_back(event_nr, run_nr_, event->number);
+
+        for(const auto& pair : messages) {
+            const auto& message = pair.first;
+            auto detectorName = (message->getDetector() != nullptr ? message->getDetector()->getName() : "global");
+
+            for(const auto& object : message->getObjectArray()) {
+                auto& o = object.get();
+                std::string class_name = allpix::demangle(typeid(o).name());
+
+                if(class_name == "PixelHit") {
+                    const auto& hit = static_cast<const PixelHit&>(o);
+                    rows.pixelhits.emplace_back(next_id("pixelhit"),
+                                                run_nr_,
+                                                event_nr,
+                                                mcparticle_nr,
+                                                pixelcharge_nr,
+                                                detectorName,
+                                                hit.getIndex().X(),
+                                                hit.getIndex().Y(),
+                                                hit.getSignal(),
+                                                (timing_global_ ? hit.getGlobalTime() : hit.getLocalTime()));
+                } else if(class_name == "PixelCharge") {
+                    const auto& charge = static_cast<const PixelCharge&>(o);
+                    pixelcharge_nr = next_id("pixelcharge");
+                    rows.pixelcharges.emplace_back(pixelcharge_nr.value(),
+                                                   run_nr_,
+                                                   event_nr,
+                                                   propagatedcharge_nr,
+                                                   detectorName,
+                                                   charge.getCharge(),
+                                                   charge.getIndex().X(),
+                                                   charge.getIndex().Y(),
+                                                   charge.getPixel().getLocalCenter().X(),
+                                                   charge.getPixel().getLocalCenter().Y(),
+                                                   charge.getPixel().getGlobalCenter().X(),
+                                                   charge.getPixel().getGlobalCenter().Y());
+                } else if(class_name == "PropagatedCharge") {
+                    const auto& charge = static_cast<const PropagatedCharge&>(o);
+                    propagatedcharge_nr = next_id("propagatedcharge");
+                    rows.propagatedcharges.emplace_back(propagatedcharge_nr.value(),
+                                                        run_nr_,
+                                                        event_nr,
+                                                        depositedcharge_nr,
+                                                        detectorName,
+                                                        static_cast<int>(charge.getType()),
+                                                        charge.getCharge(),
+                                                        charge.getLocalPosition().X(),
+                                                        charge.getLocalPosition().Y(),
+                                                        charge.getLocalPosition().Z(),
+                                                        charge.getGlobalPosition().X(),
+                                                        charge.getGlobalPosition().Y(),
+                                                        charge.getGlobalPosition().Z());
+                } else if(class_name == "MCTrack") {
+                    const auto& track = static_cast<const MCTrack&>(o);
+                    mctrack_nr = next_id("mctrack");
+                    rows.mctracks.emplace_back(mctrack_nr.value(),
+                                               run_nr_,
+                                               event_nr,
+                                               detectorName,
+                                               reinterpret_cast<uintptr_t>(&object),           // NOLINT
+                                               reinterpret_cast<uintptr_t>(track.getParent()), // NOLINT
+                                               track.getParticleID(),
+                                               track.getCreationProcessName(),
+                                               track.getOriginatingVolumeName(),
+                                               track.getStartPoint().X(),
+                                               track.getStartPoint().Y(),
+                                               track.getStartPoint().Z(),
+                                               track.getEndPoint().X(),
+                                               track.getEndPoint().Y(),
+                                               track.getEndPoint().Z(),
+                                               track.getGlobalStartTime(),
+                                               track.getGlobalEndTime(),
+                                               track.getKineticEnergyInitial(),
+                                               track.getKineticEnergyFinal());
+                } else if(class_name == "DepositedCharge") {
+                    const auto& charge = static_cast<const DepositedCharge&>(o);
+                    depositedcharge_nr = next_id("depositedcharge");
+                    rows.depositedcharges.emplace_back(depositedcharge_nr.value(),
+                                                       run_nr_,
+                                                       event_nr,
+                                                       mcparticle_nr,
+                                                       detectorName,
+                                                       carrier_type(charge),
+                                                       charge.getCharge(),
+                                                       charge.getLocalPosition().X(),
+                                                       charge.getLocalPosition().Y(),
+                                                       charge.getLocalPosition().Z(),
+                                                       charge.getGlobalPosition().X(),
+                                                       charge.getGlobalPosition().Y(),
+                                                       charge.getGlobalPosition().Z());
+                } else if(class_name == "MCParticle") {
+                    const auto& particle = static_cast<const MCParticle&>(o);
+                    mcparticle_nr = next_id("mcparticle");
+                    rows.mcparticles.emplace_back(mcparticle_nr.value(),
+                                                  run_nr_,
+                                                  event_nr,
+                                                  mctrack_nr,
+                                                  detectorName,
+                                                  reinterpret_cast<uintptr_t>(&object),              // NOLINT
+                                                  reinterpret_cast<uintptr_t>(particle.getParent()), // NOLINT
+                                                  reinterpret_cast<uintptr_t>(particle.getTrack()),  // NOLINT
+                                                  particle.getParticleID(),
+                                                  particle.getLocalStartPoint().X(),
+                                                  particle.getLocalStartPoint().Y(),
+                                                  particle.getLocalStartPoint().Z(),
+                                                  particle.getLocalEndPoint().X(),
+                                                  particle.getLocalEndPoint().Y(),
+                                                  particle.getLocalEndPoint().Z(),
+                                                  particle.getGlobalStartPoint().X(),
+                                                  particle.getGlobalStartPoint().Y(),
+                                                  particle.getGlobalStartPoint().Z(),
+                                                  particle.getGlobalEndPoint().X(),
+                                                  particle.getGlobalEndPoint().Y(),
+                                                  particle.getGlobalEndPoint().Z());
+                } else {
+                    LOG(WARNING) << "Following object type is not yet accounted for in database output: " << class_name;
+                }
+                write_cnt_++;
+            }
+            msg_cnt_++;
+        }
+    } catch(const std::exception& e) {
+        throw ModuleError("SQL error: " + std::string(e.what()));
+    }
+
+    // Append the rows to the buffer and hand it to the background writer once enough events are collected
+    auto append = [](auto& to, auto& from) {
+        to.insert(to.end(), std::make_move_iterator(from.begin()), std::make_move_iterator(from.end()));
+    };
+    BulkRows full_rows;
+    {
+        std::lock_guard<std::mutex> lock(bulk_mutex_);
+        append(bulk_rows_.events, rows.events);
+        append(bulk_rows_.mctracks, rows.mctracks);
+        append(bulk_rows_.mcparticles, rows.mcparticles);
+        append(bulk_rows_.depositedcharges, rows.depositedcharges);
+        append(bulk_rows_.propagatedcharges, rows.propagatedcharges);
+        append(bulk_rows_.pixelcharges, rows.pixelcharges);
+        append(bulk_rows_.pixelhits, rows.pixelhits);
+        if(++bulk_buffered_events_ < bulk_events_) {
+            return;
+        }
+        full_rows = std::move(bulk_rows_);
+        bulk_rows_ = BulkRows();
+        bulk_buffered_events_ = 0;
+    }
+    bulk_writer_.push(std::move(full_rows));
+}
+
+void DatabaseWriterModule::write_bulk(const BulkRows& rows) {
+    // Stream all rows of a table with a single COPY command
+    auto copy = [](pqxx::work& transaction,
+                   const std::string& table,
+                   const std::vector<std::string>& columns,
+                   const auto& table_rows) {
+        if(table_rows.empty()) {
+            return;
+        }
+        pqxx::stream_to stream(transaction, table, columns);
+        for(const auto& row : table_rows) {
+            stream << row;
+        }
+        stream.complete();
+    };
+
+    // Tables are written in the order of their references
+    pqxx::work transaction(*bulk_connection_);
+    copy(transaction, "event", {"event_nr", "run_nr", "eventid"}, rows.events);
+    copy(transaction,
+         "mctrack",
+         {"mctrack_nr",
+          "run_nr",
+          "event_nr",
+          "detector",
+          "address",
+          "parentaddress",
+          "particleid",
+          "productionprocess",
+          "productionvolume",
+          "initialpositionx",
+          "initialpositiony",
+          "initialpositionz",
+          "finalpositionx",
+          "finalpositiony",
+          "finalpositionz",
+          "initialtime",
+          "finaltime",
+          "initialkineticenergy",
+          "finalkineticenergy"},
+         rows.mctracks);
+    copy(transaction,
+         "mcparticle",
+         {"mcparticle_nr",
+          "run_nr",
+          "event_nr",
+          "mctrack_nr",
+          "detector",
+          "address",
+          "parentaddress",
+          "trackaddress",
+          "particleid",
+          "localstartpointx",
+          "localstartpointy",
+          "localstartpointz",
+          "localendpointx",
+          "localendpointy",
+          "localendpointz",
+          "globalstartpointx",
+          "globalstartpointy",
+          "globalstartpointz",
+          "globalendpointx",
+          "globalendpointy",
+          "globalendpointz"},
+         rows.mcparticles);
+    copy(transaction,
+         "depositedcharge",
+         {"depositedcharge_nr",
+          "run_nr",
+          "event_nr",
+          "mcparticle_nr",
+          "detector",
+          "carriertype",
+          "charge",
+          "localx",
+          "localy",
+          "localz",
+          "globalx",
+          "globaly",
+          "globalz"},
+         rows.depositedcharges);
+    copy(transaction,
+         "propagatedcharge",
+         {"propagatedcharge_nr",
+          "run_nr",
+          "event_nr",
+          "depositedcharge_nr",
+          "detector",
+          "carriertype",
+          "charge",
+          "localx",
+          "localy",
+          "localz",
+          "globalx",
+          "globaly",
+          "globalz"},
+         rows.propagatedcharges);
+    copy(transaction,
+         "pixelcharge",
+         {"pixelcharge_nr",
+          "run_nr",
+          "event_nr",
+          "propagatedcharge_nr",
+          "detector",
+          "charge",
+          "x",
+          "y",
+          "localx",
+          "localy",
+          "globalx",
+          "globaly"},
+         rows.pixelcharges);
+    copy(transaction,
+         "pixelhit",
+         {"pixelhit_nr",
+          "run_nr",
+          "event_nr",
+          "mcparticle_nr",
+          "pixelcharge_nr",
+          "detector",
+          "x",
+          "y",
+          "signal",
+          "hittime"},
+         rows.pixelhits);
+    transaction.commit();
+    LOG(DEBUG) << "Wrote " << rows.events.size() << " events to database";
+}
+
 void DatabaseWriterModule::finalizeThread() {
 // Disconnecting from database
 #if PQXX_VERSION_MAJOR > 6
@@ -342,5 +714,20 @@ void DatabaseWriterModule::finalizeThread() {
 }
 
 void DatabaseWriterModule::finalize() {
+    if(bulk_writer_.running()) {
+        // Hand the remaining rows to the background writer and wait for it to complete
+        if(bulk_buffered_events_ > 0) {
+            bulk_writer_.push(std::move(bulk_rows_));
+            bulk_buffered_events_ = 0;
+        }
+        bulk_writer_.finish();
+
+#if PQXX_VERSION_MAJOR > 6
+        bulk_connection_->close();
+#else
+        bulk_connection_->disconnect();
+#endif
+    }
+
     LOG(STATUS) << "Wrote " << write_cnt_ << " objects from " << msg_cnt_ << " messages to database" << std::endl;
 }
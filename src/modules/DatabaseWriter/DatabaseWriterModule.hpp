@@ -10,15 +10,23 @@
  */
 
 #include <atomic>
+#include <cstdint>
 #include <fstream>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <tuple>
+#include <vector>
 
 #include "core/config/Configuration.hpp"
 #include "core/geometry/GeometryManager.hpp"
 #include "core/messenger/Messenger.hpp"
 #include "core/module/Module.hpp"
 
+#include "tools/async_writer.h"
+
 #include <pqxx/pqxx>
 
 namespace allpix {
@@ -46,6 +54,11 @@ namespace allpix {
          */
         bool filter(const std::shared_ptr<BaseMessage>& message, const std::string& name) const;
 
+        /**
+         * @brief Start the background writer if the bulk insertion mode is enabled
+         */
+        void initialize() override;
+
         /**
          * @brief Initialize per-thread database connections
          */
@@ -70,6 +83,101 @@ namespace allpix {
     private:
         Messenger* messenger_;
 
+        /**
+         * @brief Rows of all tables buffered for the bulk insertion, with all identifiers already assigned
+         */
+        struct BulkRows {
+            using EventRow = std::tuple<int, int, uint64_t>;
+            using MCTrackRow = std::tuple<int,
+                                          int,
+                                          int,
+                                          std::string,
+                                          uintptr_t,
+                                          uintptr_t,
+                                          int,
+                                          std::string,
+                                          std::string,
+                                          double,
+                                          double,
+                                          double,
+                                          double,
+                                          double,
+                                          double,
+                                          double,
+                                          double,
+                                          double,
+                                          double>;
+            using MCParticleRow = std::tuple<int,
+                                             int,
+                                             int,
+                                             std::optional<int>,
+                                             std::string,
+                                             uintptr_t,
+                                             uintptr_t,
+                                             uintptr_t,
+                                             int,
+                                             double,
+                                             double,
+                                             double,
+                                             double,
+                                             double,
+                                             double,
+                                             double,
+                                             double,
+                                             double,
+                                             double,
+                                             double,
+                                             double>;
+            using SensorChargeRow = std::tuple<int,
+                                               int,
+                                               int,
+                                               std::optional<int>,
+                                               std::string,
+                                               int,
+                                               unsigned int,
+                                               double,
+                                               double,
+                                               double,
+                                               double,
+                                               double,
+                                               double>;
+            using PixelChargeRow =
+                std::tuple<int, int, int, std::optional<int>, std::string, long, int, int, double, double, double, double>;
+            using PixelHitRow =
+                std::tuple<int, int, int, std::optional<int>, std::optional<int>, std::string, int, int, double, double>;
+
+            std::vector<EventRow> events;
+            std::vector<MCTrackRow> mctracks;
+            std::vector<MCParticleRow> mcparticles;
+            std::vector<SensorChargeRow> depositedcharges;
+            std::vector<SensorChargeRow> propagatedcharges;
+            std::vector<PixelChargeRow> pixelcharges;
+            std::vector<PixelHitRow> pixelhits;
+        };
+
+        /**
+         * @brief Convert the objects of an event to rows and add them to the bulk buffer, handing full buffers to the writer
+         * @param event Event to buffer
+         * @param messages Messages of the event to store
+         */
+        void buffer_event(Event* event, const std::vector<std::pair<std::shared_ptr<BaseMessage>, std::string>>& messages);
+
+        /**
+         * @brief Take the next identifier of a table from the identifiers reserved by this client
+         * @param table Name of the table
+         * @return Identifier of the new row
+         *
+         * Identifiers are reserved from the sequence of the table in blocks, such that rows can be linked before they are
+         * written to the database.
+         */
+        int next_id(const std::string& table);
+
+        /**
+         * @brief Stream buffered rows to the database via COPY, one transaction per buffer
+         * @param rows Rows of several events to write
+         */
+        void write_bulk(const BulkRows& rows);
+
         /**
          * @brief Submit "prepared statements" to the database connection(s)
          * @param connection  Database connection to be used
@@ -91,6 +199,19 @@ namespace allpix {
         int run_nr_{0};
         bool timing_global_{};
 
+        // Bulk insertion mode
+        bool bulk_insert_{};
+        unsigned int bulk_events_{};
+        unsigned int bulk_id_block_{};
+        std::mutex ids_mutex_;
+        std::map<std::string, std::vector<int>> reserved_ids_;
+        std::mutex bulk_mutex_;
+        BulkRows bulk_rows_;
+        unsigned int bulk_buffered_events_{};
+        // Connection of the background writer, only used from its thread
+        std::unique_ptr<pqxx::connection> bulk_connection_;
+        AsyncWriter<BulkRows> bulk_writer_;
+
         // Statistical information about number of objects
         std::atomic<unsigned long> write_cnt_{};
         std::atomic<unsigned long> msg_cnt_{};
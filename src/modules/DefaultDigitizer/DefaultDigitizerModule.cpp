@@ -11,6 +11,10 @@
 
 #include "DefaultDigitizerModule.hpp"
 
+#include <algorithm>
+#include <cmath>
+
+#include "core/messenger/exceptions.h"
 #include "core/utils/distributions.h"
 #include "core/utils/unit.h"
 #include "objects/PixelHit.hpp"
@@ -18,6 +22,7 @@
 
 #include <TFile.h>
 #include <TH1D.h>
+#include <TMath.h>
 #include <TProfile.h>
 
 using namespace allpix;
@@ -29,8 +34,12 @@ DefaultDigitizerModule::DefaultDigitizerModule(Configuration& config,
     // Enable multithreading of this module if multithreading is enabled
     allow_multithreading();
 
+    // Pixels without charge can only see noise hits if the module runs also for events without pixel charges
+    config_.setDefault<bool>("noise_hits", false);
+    noise_hits_ = config_.get<bool>("noise_hits");
+
     // Require PixelCharge message for single detector
-    messenger_->bindSingle<PixelChargeMessage>(this, MsgFlags::REQUIRED);
+    messenger_->bindSingle<PixelChargeMessage>(this, noise_hits_ ? MsgFlags::NONE : MsgFlags::REQUIRED);
 
     if(config_.has("gain") && config_.has("gain_function")) {
         throw InvalidCombinationError(
@@ -65,6 +74,9 @@ DefaultDigitizerModule::DefaultDigitizerModule(Configuration& config,
     config_.setDefault<int>("saturation_mean", Units::get(190, "ke"));
     config_.setDefault<int>("saturation_width", Units::get(20, "ke"));
 
+    // Sampling of all random numbers of an event at once
+    config_.setDefault<bool>("batch_sampling", false);
+
     // Plotting
     config_.setDefault<bool>("output_plots", false);
     config_.setDefault<int>("output_plots_scale", Units::get(30, "ke"));
@@ -73,6 +85,7 @@ DefaultDigitizerModule::DefaultDigitizerModule(Configuration& config,
 
     // Cache config parameters
     output_plots_ = config_.get<bool>("output_plots");
+    batch_sampling_ = config_.get<bool>("batch_sampling");
 
     electronics_noise_ = config_.get<unsigned int>("electronics_noise");
 
@@ -141,6 +154,10 @@ void DefaultDigitizerModule::initialize() {
                   << ((1 << tdc_resolution_) - 1);
     }
 
+    if(noise_hits_) {
+        prepare_noise_hits();
+    }
+
     if(output_plots_) {
         LOG(TRACE) << "Creating output plots";
 
@@ -214,12 +231,138 @@ void DefaultDigitizerModule::initialize() {
     }
 }
 
+void DefaultDigitizerModule::prepare_noise_hits() {
+    if(electronics_noise_ == 0) {
+        throw InvalidCombinationError(
+            config_, {"noise_hits", "electronics_noise"}, "noise hits cannot be generated without electronics noise");
+    }
+
+    // Weight every noise value with the probability of the amplified value to pass the smeared threshold
+    constexpr size_t points = 4801;
+    const auto noise = static_cast<double>(electronics_noise_);
+    std::vector<double> noise_values(points);
+    std::vector<double> weights(points);
+    for(size_t i = 0; i < points; ++i) {
+        noise_values[i] = noise * (-12. + 24. * static_cast<double>(i) / (points - 1));
+        auto charge = gain_function_->Eval(noise_values[i]);
+        auto pass = (threshold_smearing_ > 0
+                         ? 0.5 * std::erfc((threshold_ - charge) / (std::sqrt(2.) * threshold_smearing_))
+                         : (charge >= threshold_ ? 1. : 0.));
+        weights[i] = pass * std::exp(-0.5 * noise_values[i] * noise_values[i] / (noise * noise)) /
+                     (std::sqrt(2. * TMath::Pi()) * noise);
+        if(i > 0) {
+            noise_probability_ += 0.5 * (weights[i - 1] + weights[i]) * (noise_values[i] - noise_values[i - 1]);
+        }
+    }
+    noise_probability_ = std::min(noise_probability_, 1.);
+
+    auto n_pixels = getDetector()->getModel()->getNPixels();
+    LOG(INFO) << "Generating noise hits with a probability of " << noise_probability_ << " per pixel, "
+              << noise_probability_ * n_pixels.x() * n_pixels.y() << " noise hits expected per event";
+    if(noise_probability_ > 0) {
+        noise_distribution_ =
+            allpix::piecewise_linear_distribution<double>(noise_values.begin(), noise_values.end(), weights.begin());
+    }
+}
+
+void DefaultDigitizerModule::add_noise_hits(Event* event,
+                                            const std::vector<PixelCharge>& pixel_charges,
+                                            std::vector<PixelHit>& hits) {
+    if(noise_probability_ <= 0) {
+        return;
+    }
+
+    auto model = getDetector()->getModel();
+    auto n_pixels = model->getNPixels();
+    auto total_pixels = static_cast<double>(n_pixels.x()) * n_pixels.y();
+
+    // The noise of pixels with charge has already been simulated
+    std::vector<uint64_t> charged_pixels;
+    charged_pixels.reserve(pixel_charges.size());
+    for(const auto& pixel_charge : pixel_charges) {
+        auto index = pixel_charge.getIndex();
+        charged_pixels.push_back(static_cast<uint64_t>(index.y()) * n_pixels.x() + static_cast<uint64_t>(index.x()));
+    }
+    std::sort(charged_pixels.begin(), charged_pixels.end());
+
+    allpix::uniform_real_distribution<double> uniform_distribution(0, 1);
+    const auto log_complement = std::log1p(-noise_probability_);
+    size_t noise_hits = 0;
+    double position = -1;
+    while(true) {
+        // The number of pixels without noise hit up to the next one follows a geometric distribution
+        position += 1 + std::floor(std::log1p(-uniform_distribution(event->getRandomEngine())) / log_complement);
+        if(position >= total_pixels) {
+            break;
+        }
+        auto linear_index = static_cast<uint64_t>(position);
+        Pixel::Index index(static_cast<int>(linear_index % n_pixels.x()), static_cast<int>(linear_index / n_pixels.x()));
+        if(!model->isWithinMatrix(index) || std::binary_search(charged_pixels.begin(), charged_pixels.end(), linear_index)) {
+            continue;
+        }
+
+        // Draw the noise passing the threshold and process it like the charge of all other pixels
+        auto charge = gain_function_->Eval(noise_distribution_(event->getRandomEngine()));
+        if(saturation_) {
+            allpix::normal_distribution<double> saturation_distribution(saturation_mean_, saturation_width_);
+            charge = std::min(charge, saturation_distribution(event->getRandomEngine()));
+        }
+        if(qdc_resolution_ > 0) {
+            allpix::normal_distribution<double> qdc_distribution(0, qdc_smearing_);
+            charge += qdc_distribution(event->getRandomEngine());
+            charge = static_cast<double>(std::clamp(static_cast<int>((qdc_offset_ + charge) / qdc_slope_),
+                                                    (allow_zero_qdc_ ? 0 : 1),
+                                                    (1 << qdc_resolution_) - 1));
+        }
+
+        // Noise hits carry no time information
+        double time = 0;
+        if(tdc_resolution_ > 0) {
+            allpix::normal_distribution<double> tdc_distribution(0, tdc_smearing_);
+            time += tdc_distribution(event->getRandomEngine());
+            time = static_cast<double>(std::clamp(
+                static_cast<int>((tdc_offset_ + time) / tdc_slope_), (allow_zero_tdc_ ? 0 : 1), (1 << tdc_resolution_) - 1));
+        }
+
+        LOG(DEBUG) << "Noise hit in pixel " << index << " with charge " << charge;
+        hits.emplace_back(getDetector()->getPixel(index), time, 0., charge, nullptr);
+        ++noise_hits;
+    }
+    LOG(DEBUG) << "Generated " << noise_hits << " noise hits in pixels without charge";
+}
+
 void DefaultDigitizerModule::run(Event* event) {
-    auto pixel_message = messenger_->fetchMessage<PixelChargeMessage>(this, event);
+    // Without pixel charges, only noise hits can be generated
+    static const std::vector<PixelCharge> no_pixel_charges;
+    std::shared_ptr<PixelChargeMessage> pixel_message;
+    try {
+        pixel_message = messenger_->fetchMessage<PixelChargeMessage>(this, event);
+    } catch(const MessageNotFoundException&) {
+        LOG(DEBUG) << "No pixel charges received, only generating noise hits";
+    }
+
+    const auto& pixel_charges = (pixel_message != nullptr ? pixel_message->getData() : no_pixel_charges);
+
+    // Draw the Gaussian random numbers for noise, saturation, threshold, QDC and TDC smearing of all pixels at once if
+    // requested, stored as one block per quantity
+    enum Quantity : size_t { NOISE = 0, SATURATION, THRESHOLD, QDC, TDC, QUANTITIES };
+    thread_local std::vector<double> normals;
+    if(batch_sampling_) {
+        normals.resize(QUANTITIES * pixel_charges.size());
+        fill_standard_normal(event->getRandomEngine(), normals);
+    }
+    auto sample = [&](Quantity quantity, size_t pixel, double mean, double stddev) {
+        if(batch_sampling_) {
+            return mean + stddev * normals[quantity * pixel_charges.size() + pixel];
+        }
+        allpix::normal_distribution<double> distribution(mean, stddev);
+        return distribution(event->getRandomEngine());
+    };
 
     // Loop through all pixels with charges
     std::vector<PixelHit> hits;
-    for(const auto& pixel_charge : pixel_message->getData()) {
+    for(size_t i = 0; i < pixel_charges.size(); ++i) {
+        const auto& pixel_charge = pixel_charges[i];
         auto pixel = pixel_charge.getPixel();
         auto pixel_index = pixel.getIndex();
         auto charge = static_cast<double>(pixel_charge.getAbsoluteCharge());
@@ -230,8 +373,7 @@ void DefaultDigitizerModule::run(Event* event) {
         }
 
         // Add electronics noise from Gaussian:
-        allpix::normal_distribution<double> el_noise(0, electronics_noise_);
-        charge += el_noise(event->getRandomEngine());
+        charge += sample(NOISE, i, 0, electronics_noise_);
 
         LOG(DEBUG) << "Charge with noise: " << Units::display(charge, "e");
         if(output_plots_) {
@@ -250,8 +392,7 @@ void DefaultDigitizerModule::run(Event* event) {
 
         // Simulate simple front-end saturation if enabled:
         if(saturation_) {
-            allpix::normal_distribution<double> saturation_smearing(saturation_mean_, saturation_width_);
-            auto saturation = saturation_smearing(event->getRandomEngine());
+            auto saturation = sample(SATURATION, i, saturation_mean_, saturation_width_);
             if(charge > saturation) {
                 LOG(DEBUG) << "Above front-end saturation, " << Units::display(charge, {"e", "ke"}) << " > "
                            << Units::display(saturation, {"e", "ke"}) << ", setting to saturation value";
@@ -264,8 +405,7 @@ void DefaultDigitizerModule::run(Event* event) {
         }
 
         // Smear the threshold, Gaussian distribution around "threshold" with width "threshold_smearing"
-        allpix::normal_distribution<double> thr_smearing(threshold_, threshold_smearing_);
-        double threshold = thr_smearing(event->getRandomEngine());
+        double threshold = sample(THRESHOLD, i, threshold_, threshold_smearing_);
         if(output_plots_) {
             h_thr->Fill(threshold / 1e3);
         }
@@ -288,8 +428,7 @@ void DefaultDigitizerModule::run(Event* event) {
             auto original_charge = charge;
 
             // Add ADC smearing:
-            allpix::normal_distribution<double> adc_smearing(0, qdc_smearing_);
-            charge += adc_smearing(event->getRandomEngine());
+            charge += sample(QDC, i, 0, qdc_smearing_);
             if(output_plots_) {
                 h_pxq_adc_smear->Fill(charge / 1e3);
             }
@@ -322,8 +461,7 @@ void DefaultDigitizerModule::run(Event* event) {
         // Simulate TDC if resolution set to more than 0bit
         if(tdc_resolution_ > 0) {
             // Add TDC smearing:
-            allpix::normal_distribution<double> tdc_smearing(0, tdc_smearing_);
-            time += tdc_smearing(event->getRandomEngine());
+            time += sample(TDC, i, 0, tdc_smearing_);
             if(output_plots_) {
                 h_px_tdc_smear->Fill(time);
             }
@@ -346,6 +484,11 @@ void DefaultDigitizerModule::run(Event* event) {
         hits.emplace_back(pixel, time, pixel_charge.getGlobalTime() + original_time, charge, &pixel_charge);
     }
 
+    // Add the hits of pixels without charge
+    if(noise_hits_) {
+        add_noise_hits(event, pixel_charges, hits);
+    }
+
     // Output summary and update statistics
     LOG(INFO) << "Digitized " << hits.size() << " pixel hits";
     total_hits_ += hits.size();
@@ -370,7 +513,7 @@ double DefaultDigitizerModule::time_of_arrival(const PixelCharge& pixel_charge,
                 break;
             }
         }
-        return pulse.getBinning() * static_cast<double>(std::distance(pulse.begin(), bin));
+        return pulse.getBinTime(pulse.getOffset() + static_cast<size_t>(std::distance(pulse.begin(), bin)));
     } else {
         LOG_ONCE(INFO) << "Simulation chain does not allow for time-of-arrival calculation";
         return 0;
@@ -14,13 +14,16 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "core/config/Configuration.hpp"
 #include "core/messenger/Messenger.hpp"
 #include "core/module/Event.hpp"
 #include "core/module/Module.hpp"
 
+#include "core/utils/distributions.h"
 #include "objects/PixelCharge.hpp"
+#include "objects/PixelHit.hpp"
 
 #include "tools/ROOT.h"
 
@@ -74,10 +77,32 @@ namespace allpix {
          */
         double time_of_arrival(const PixelCharge& pixel_charge, double threshold) const;
 
+        /**
+         * @brief Tabulate the distribution of the noise of pixels without charge which passes the threshold
+         */
+        void prepare_noise_hits();
+
+        /**
+         * @brief Generate the hits of pixels without charge which pass the threshold from electronics noise alone
+         * @param event Event to draw the random numbers from
+         * @param pixel_charges Pixels with charge, whose noise has already been simulated
+         * @param hits Hits of the event the noise hits are added to
+         *
+         * The pixels with noise hits are found by skipping the pixels in between, the number of which follows a geometric
+         * distribution. The cost therefore scales with the number of noise hits instead of the size of the matrix.
+         */
+        void add_noise_hits(Event* event, const std::vector<PixelCharge>& pixel_charges, std::vector<PixelHit>& hits);
+
         // Configuration
         bool output_plots_{};
+        bool batch_sampling_{};
 
         unsigned int electronics_noise_{};
+
+        // Noise hits in pixels without charge
+        bool noise_hits_{};
+        double noise_probability_{};
+        allpix::piecewise_linear_distribution<double> noise_distribution_;
         std::unique_ptr<TFormula> gain_function_{};
 
         bool saturation_{};
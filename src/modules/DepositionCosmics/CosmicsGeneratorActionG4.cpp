@@ -13,6 +13,7 @@
 #include "DepositionCosmicsModule.hpp"
 #include "RNGWrapper.hpp"
 
+#include <algorithm>
 #include <limits>
 #include <memory>
 #include <regex>
@@ -27,7 +28,17 @@
 using namespace allpix;
 
 CosmicsGeneratorActionG4::CosmicsGeneratorActionG4(const Configuration& config)
-    : particle_gun_(std::make_unique<G4ParticleGun>()), config_(config) {
+    : particle_gun_(std::make_unique<G4ParticleGun>()), shower_library_(DepositionCosmicsModule::shower_library_),
+      primary_culling_(DepositionCosmicsModule::primary_culling_), config_(config) {
+
+    // Parse other configuration parameters:
+    reset_particle_time_ = config_.get<bool>("reset_particle_time");
+
+    // Showers are sampled from the library if available, CRY is not needed in this case
+    if(shower_library_ != nullptr) {
+        LOG(DEBUG) << "Sampling showers from library with " << shower_library_->size() << " showers";
+        return;
+    }
 
     LOG(DEBUG) << "Setting up CRY generator";
     LOG(DEBUG) << "CRY configuration: " << config_.get<std::string>("_cry_config");
@@ -39,9 +50,6 @@ CosmicsGeneratorActionG4::CosmicsGeneratorActionG4(const Configuration& config)
     LOG(DEBUG) << "Configuring CRY random engine to use Geant4's event-seeded engine";
     RNGWrapper<CLHEP::HepRandomEngine>::set(CLHEP::HepRandom::getTheEngine(), &CLHEP::HepRandomEngine::flat);
     setup->setRandomFunction(RNGWrapper<CLHEP::HepRandomEngine>::rng);
-
-    // Parse other configuration parameters:
-    reset_particle_time_ = config_.get<bool>("reset_particle_time");
 }
 
 /**
@@ -49,6 +57,11 @@ CosmicsGeneratorActionG4::CosmicsGeneratorActionG4(const Configuration& config)
  */
 void CosmicsGeneratorActionG4::GeneratePrimaries(G4Event* event) {
 
+    if(shower_library_ != nullptr) {
+        generate_from_library(event);
+        return;
+    }
+
     // Let CRY generate the particles
     std::vector<CRYParticle*> vect;
     LOG(DEBUG) << "Absolute time simulated before shower: "
@@ -70,12 +83,21 @@ void CosmicsGeneratorActionG4::GeneratePrimaries(G4Event* event) {
     }
 
     for(const auto& particle : vect) {
+        // Skip particles which cannot reach any sensor, the live time of the shower has been accounted for already
+        auto position = G4ThreeVector(particle->x() * CLHEP::m, particle->y() * CLHEP::m, particle->z() * CLHEP::m);
+        auto direction = G4ThreeVector(particle->u(), particle->v(), particle->w());
+        if(primary_culling_ != nullptr &&
+           !primary_culling_->reachesSensor(ROOT::Math::XYZPoint(position.x(), position.y(), position.z()),
+                                            ROOT::Math::XYZVector(direction.x(), direction.y(), direction.z()))) {
+            LOG(DEBUG) << "  " << CRYUtils::partName(particle->id()) << ": culled, cannot reach any sensor";
+            continue;
+        }
+
         auto* pdg_table = G4ParticleTable::GetParticleTable();
         particle_gun_->SetParticleDefinition(pdg_table->FindParticle(particle->PDGid()));
         particle_gun_->SetParticleEnergy(particle->ke() * CLHEP::MeV);
-        particle_gun_->SetParticlePosition(
-            G4ThreeVector(particle->x() * CLHEP::m, particle->y() * CLHEP::m, particle->z() * CLHEP::m));
-        particle_gun_->SetParticleMomentumDirection(G4ThreeVector(particle->u(), particle->v(), particle->w()));
+        particle_gun_->SetParticlePosition(position);
+        particle_gun_->SetParticleMomentumDirection(direction);
 
         double time = (reset_particle_time_ ? 0. : particle->t() - event_starting_time);
         particle_gun_->SetParticleTime(time);
@@ -88,3 +110,44 @@ void CosmicsGeneratorActionG4::GeneratePrimaries(G4Event* event) {
                    << " t=" << Units::display(Units::get(time, "s"), {"ns", "us", "ms"});
     }
 }
+
+void CosmicsGeneratorActionG4::generate_from_library(G4Event* event) {
+
+    // Sample a shower using Geant4's event-seeded engine, making the selection reproducible for every event
+    auto size = shower_library_->size();
+    auto random = CLHEP::HepRandom::getTheEngine()->flat();
+    auto index = std::min(static_cast<size_t>(random * static_cast<double>(size)), size - 1);
+    const auto& shower = shower_library_->getShower(index);
+    LOG(DEBUG) << "Sampled shower " << index << " from library with " << shower.particles.size() << " particles";
+
+    // Update simulation time in the framework base units with the live time represented by this shower
+    DepositionCosmicsModule::cry_instance_time_simulated_ += shower.livetime;
+
+    for(const auto& particle : shower.particles) {
+        auto position = G4ThreeVector(particle.position[0], particle.position[1], particle.position[2]);
+        auto direction = G4ThreeVector(particle.direction[0], particle.direction[1], particle.direction[2]);
+
+        // Skip particles which cannot reach any sensor, the live time of the shower has been accounted for already
+        if(primary_culling_ != nullptr &&
+           !primary_culling_->reachesSensor(ROOT::Math::XYZPoint(position.x(), position.y(), position.z()),
+                                            ROOT::Math::XYZVector(direction.x(), direction.y(), direction.z()))) {
+            LOG(DEBUG) << "  " << particle.pdg << ": culled, cannot reach any sensor";
+            continue;
+        }
+
+        auto* pdg_table = G4ParticleTable::GetParticleTable();
+        particle_gun_->SetParticleDefinition(pdg_table->FindParticle(particle.pdg));
+        particle_gun_->SetParticleEnergy(particle.energy);
+        particle_gun_->SetParticlePosition(position);
+        particle_gun_->SetParticleMomentumDirection(direction);
+
+        double time = (reset_particle_time_ ? 0. : particle.time);
+        particle_gun_->SetParticleTime(time);
+        particle_gun_->GeneratePrimaryVertex(event);
+
+        LOG(DEBUG) << "  " << particle.pdg << ":" << std::setprecision(4)
+                   << " energy=" << Units::display(particle.energy, {"MeV", "GeV"})
+                   << " pos=" << Units::display(position, {"m"}) << " dir. cos=" << direction
+                   << " t=" << Units::display(time, {"ns", "us", "ms"});
+    }
+}
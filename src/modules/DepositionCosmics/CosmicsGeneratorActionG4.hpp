@@ -24,6 +24,8 @@
 #include <CRYSetup.h>
 #include <CRYUtils.h>
 
+#include "../DepositionGeant4/PrimaryCulling.hpp"
+#include "ShowerLibrary.hpp"
 #include "core/config/Configuration.hpp"
 
 namespace allpix {
@@ -44,8 +46,16 @@ namespace allpix {
         void GeneratePrimaries(G4Event*) override;
 
     private:
+        /**
+         * @brief Dispatch the particles of a shower from the library
+         * @param event Geant4 event to add the primary vertices to
+         */
+        void generate_from_library(G4Event* event);
+
         std::unique_ptr<G4ParticleGun> particle_gun_;
         std::unique_ptr<CRYGenerator> cry_generator_;
+        std::shared_ptr<const ShowerLibrary> shower_library_;
+        std::shared_ptr<const PrimaryCulling> primary_culling_;
 
         bool reset_particle_time_{};
         const Configuration& config_;
@@ -28,6 +28,7 @@
 using namespace allpix;
 
 thread_local double DepositionCosmicsModule::cry_instance_time_simulated_ = 0;
+std::shared_ptr<const ShowerLibrary> DepositionCosmicsModule::shower_library_;
 
 DepositionCosmicsModule::DepositionCosmicsModule(Configuration& config, Messenger* messenger, GeometryManager* geo_manager)
     : DepositionGeant4Module(config, messenger, geo_manager) {
@@ -49,6 +50,7 @@ DepositionCosmicsModule::DepositionCosmicsModule(Configuration& config, Messenge
     config_.setDefault("latitude", 53.0);
     config_.setDefault("date", "12-31-2020");
     config_.setDefault("reset_particle_time", false);
+    config_.setDefault<size_t>("shower_library_size", 0);
 
     // Force source type and position:
     config_.set("source_type", "cosmics");
@@ -143,6 +145,60 @@ DepositionCosmicsModule::DepositionCosmicsModule(Configuration& config, Messenge
     config_.set<std::string>("_cry_config", cry_config.str());
 }
 
+void DepositionCosmicsModule::initialize() {
+    if(config_.has("shower_library")) {
+        auto path = config_.getPath("shower_library");
+        auto cry_config = config_.get<std::string>("_cry_config");
+
+        std::unique_ptr<ShowerLibrary> library;
+        if(std::filesystem::exists(path)) {
+            try {
+                library = std::make_unique<ShowerLibrary>(ShowerLibrary::read(path));
+            } catch(std::runtime_error& e) {
+                throw InvalidValueError(
+                    config_, "shower_library", "could not read shower library: " + std::string(e.what()));
+            }
+            LOG(INFO) << "Read library of " << library->size() << " showers from " << path;
+            if(library->getConfiguration() != cry_config) {
+                LOG(WARNING) << "Shower library has been generated with a different CRY configuration:" << std::endl
+                             << "library: " << library->getConfiguration() << std::endl
+                             << "current: " << cry_config;
+            }
+        } else {
+            // Generate the library once and store it for further simulations
+            auto number_of_showers = config_.get<size_t>("shower_library_size");
+            if(number_of_showers == 0) {
+                throw InvalidValueError(config_,
+                                        "shower_library",
+                                        "library file does not exist, the number of showers to generate has to be "
+                                        "provided via the shower_library_size parameter");
+            }
+            LOG(STATUS) << "Generating library of " << number_of_showers << " showers with CRY";
+            auto seed = getConfigManager()->getGlobalConfiguration().get<uint64_t>("random_seed");
+            library = std::make_unique<ShowerLibrary>(
+                ShowerLibrary::generate(cry_config, config_.get<std::string>("data_path"), number_of_showers, seed));
+            try {
+                library->write(path);
+            } catch(std::runtime_error& e) {
+                throw InvalidValueError(
+                    config_, "shower_library", "could not write shower library: " + std::string(e.what()));
+            }
+            LOG(STATUS) << "Stored shower library in " << path;
+        }
+
+        LOG(INFO) << "Sampling showers from library representing a live time of "
+                  << Units::display(library->getLivetime(), {"us", "ms", "s"});
+        auto events = getConfigManager()->getGlobalConfiguration().get<uint64_t>("number_of_events");
+        if(events > library->size()) {
+            LOG(WARNING) << "Shower library contains fewer showers than events to be simulated, showers will be reused";
+        }
+        shower_library_ = std::move(library);
+    }
+
+    // Call base class initialization:
+    DepositionGeant4Module::initialize();
+}
+
 void DepositionCosmicsModule::initialize_g4_action() {
     auto* action_initialization =
         new ActionInitializationG4<CosmicsGeneratorActionG4, GeneratorActionInitializationMaster>(config_);
@@ -162,6 +218,7 @@ void DepositionCosmicsModule::finalizeThread() {
 void DepositionCosmicsModule::finalize() {
     LOG(STATUS) << "Total simulated time in CRY: " << Units::display(total_time_simulated_, {"us", "ms", "s"});
     config_.set("total_time_simulated", total_time_simulated_);
+    shower_library_.reset();
 
     // Call base class finalization:
     DepositionGeant4Module::finalize();
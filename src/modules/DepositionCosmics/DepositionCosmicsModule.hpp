@@ -13,7 +13,9 @@
 #define ALLPIX_COSMICS_DEPOSITION_MODULE_H
 
 #include "../DepositionGeant4/DepositionGeant4Module.hpp"
+#include "ShowerLibrary.hpp"
 
+#include <memory>
 #include <mutex>
 
 namespace allpix {
@@ -38,6 +40,11 @@ namespace allpix {
          */
         DepositionCosmicsModule(Configuration& config, Messenger* messenger, GeometryManager* geo_manager);
 
+        /**
+         * @brief Prepare the optional shower library and call \ref DepositionGeant4Module::initialize()
+         */
+        void initialize() override;
+
         /**
          * @brief Cleanup \ref RunManager for each thread
          */
@@ -52,6 +59,8 @@ namespace allpix {
         void initialize_g4_action() override;
 
         static thread_local double cry_instance_time_simulated_;
+        // Library of pre-generated showers shared by the generator actions of all threads, if configured
+        static std::shared_ptr<const ShowerLibrary> shower_library_;
         std::mutex stats_mutex_;
         double total_time_simulated_{};
     };
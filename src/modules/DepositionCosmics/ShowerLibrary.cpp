@@ -0,0 +1,131 @@
+/**
+ * @file
+ * @brief Implements the library of pre-generated cosmic showers
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "ShowerLibrary.hpp"
+#include "RNGWrapper.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+#include <cereal/archives/portable_binary.hpp>
+#include <cereal/types/array.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+
+#include <CLHEP/Random/MixMaxRng.h>
+#include <CLHEP/Units/SystemOfUnits.h>
+#include <CRYGenerator.h>
+#include <CRYParticle.h>
+#include <CRYSetup.h>
+
+using namespace allpix;
+
+namespace {
+    // Identifier and version of the file format
+    constexpr const char* library_identifier = "APSHOWERS";
+    constexpr std::uint32_t library_version = 1;
+} // namespace
+
+ShowerLibrary::ShowerLibrary(std::string configuration, std::vector<Shower> showers)
+    : configuration_(std::move(configuration)), showers_(std::move(showers)) {}
+
+ShowerLibrary ShowerLibrary::generate(const std::string& configuration,
+                                      const std::string& data_path,
+                                      size_t number_of_showers,
+                                      uint64_t seed) {
+    // CRY draws its random numbers from a dedicated engine seeded once for the full library
+    CLHEP::MixMaxRng random_engine(static_cast<long>(seed % LONG_MAX));
+    auto* setup = new CRYSetup(configuration, data_path);
+    CRYGenerator generator(setup);
+    RNGWrapper<CLHEP::HepRandomEngine>::set(&random_engine, &CLHEP::HepRandomEngine::flat);
+    setup->setRandomFunction(RNGWrapper<CLHEP::HepRandomEngine>::rng);
+
+    std::vector<Shower> showers(number_of_showers);
+    std::vector<CRYParticle*> particles;
+    for(auto& shower : showers) {
+        auto time_simulated = generator.timeSimulated();
+        particles.clear();
+        generator.genEvent(&particles);
+        shower.livetime = (generator.timeSimulated() - time_simulated) * CLHEP::s;
+
+        // Shower time frame starts with first particle arriving
+        double starting_time = std::numeric_limits<double>::max();
+        for(auto* particle : particles) {
+            starting_time = std::min(starting_time, particle->t());
+        }
+
+        shower.particles.reserve(particles.size());
+        for(auto* particle : particles) {
+            shower.particles.push_back({particle->PDGid(),
+                                        particle->ke() * CLHEP::MeV,
+                                        {particle->x() * CLHEP::m, particle->y() * CLHEP::m, particle->z() * CLHEP::m},
+                                        {particle->u(), particle->v(), particle->w()},
+                                        (particle->t() - starting_time) * CLHEP::s});
+            delete particle;
+        }
+    }
+
+    return {configuration, std::move(showers)};
+}
+
+ShowerLibrary ShowerLibrary::read(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if(!file) {
+        throw std::runtime_error("could not open file");
+    }
+
+    std::string identifier;
+    std::uint32_t version = 0;
+    std::string configuration;
+    std::vector<Shower> showers;
+    try {
+        cereal::PortableBinaryInputArchive archive(file);
+        archive(identifier);
+        if(identifier != library_identifier) {
+            throw std::runtime_error("invalid file type");
+        }
+        archive(version);
+        if(version != library_version) {
+            throw std::runtime_error("unknown format version " + std::to_string(version));
+        }
+        archive(configuration, showers);
+    } catch(cereal::Exception& e) {
+        throw std::runtime_error(e.what());
+    }
+
+    if(showers.empty()) {
+        throw std::runtime_error("library does not contain any showers");
+    }
+    return {std::move(configuration), std::move(showers)};
+}
+
+void ShowerLibrary::write(const std::filesystem::path& path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if(!file) {
+        throw std::runtime_error("could not open file for writing");
+    }
+
+    cereal::PortableBinaryOutputArchive archive(file);
+    archive(std::string(library_identifier), library_version, configuration_, showers_);
+    if(!file.good()) {
+        throw std::runtime_error("could not write file");
+    }
+}
+
+double ShowerLibrary::getLivetime() const {
+    return std::accumulate(
+        showers_.begin(), showers_.end(), 0., [](double sum, const Shower& shower) { return sum + shower.livetime; });
+}
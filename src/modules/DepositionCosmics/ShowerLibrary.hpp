@@ -0,0 +1,128 @@
+/**
+ * @file
+ * @brief Defines a library of pre-generated cosmic showers
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_COSMICS_DEPOSITION_MODULE_SHOWER_LIBRARY_H
+#define ALLPIX_COSMICS_DEPOSITION_MODULE_SHOWER_LIBRARY_H
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace allpix {
+    /**
+     * @brief Library of cosmic showers generated by CRY, stored in a binary file
+     *
+     * Every shower holds the primary particles at the boundary of the CRY subbox together with the live time it represents,
+     * i.e. the time CRY simulated to obtain this shower. All quantities are stored in the internal units of Geant4 with the
+     * particle times relative to the first particle of the shower, such that showers can be dispatched without CRY. The
+     * primaries do not depend on the setup apart from the subbox size, a library can therefore be reused for different
+     * geometries as long as the CRY configuration is identical.
+     */
+    class ShowerLibrary {
+    public:
+        /**
+         * @brief Primary particle of a shower
+         */
+        struct Particle {
+            int pdg{};                         ///< PDG code of the particle
+            double energy{};                   ///< Kinetic energy
+            std::array<double, 3> position{};  ///< Position at the boundary of the subbox
+            std::array<double, 3> direction{}; ///< Direction cosines of the momentum
+            double time{};                     ///< Time relative to the first particle of the shower
+
+            /**
+             * @brief Serialization of the particle
+             * @param archive Archive to (de-)serialize from or to
+             */
+            template <class Archive> void serialize(Archive& archive) { archive(pdg, energy, position, direction, time); }
+        };
+
+        /**
+         * @brief Shower with its primary particles
+         */
+        struct Shower {
+            std::vector<Particle> particles; ///< Primary particles of the shower
+            double livetime{};               ///< Live time simulated by CRY for this shower
+
+            /**
+             * @brief Serialization of the shower
+             * @param archive Archive to (de-)serialize from or to
+             */
+            template <class Archive> void serialize(Archive& archive) { archive(particles, livetime); }
+        };
+
+        /**
+         * @brief Construct a library from generated showers
+         * @param configuration Configuration string CRY has been set up with
+         * @param showers Generated showers
+         */
+        ShowerLibrary(std::string configuration, std::vector<Shower> showers);
+
+        /**
+         * @brief Generate a library of showers with CRY
+         * @param configuration Configuration string to set up CRY with
+         * @param data_path Path to the CRY data files
+         * @param number_of_showers Number of showers to generate
+         * @param seed Seed for the random number engine used by CRY
+         * @return Library of generated showers
+         */
+        static ShowerLibrary
+        generate(const std::string& configuration, const std::string& data_path, size_t number_of_showers, uint64_t seed);
+
+        /**
+         * @brief Read a library from file
+         * @param path Path of the library file
+         * @return Library stored in the file
+         * @throws std::runtime_error if the file cannot be read or is no valid shower library
+         */
+        static ShowerLibrary read(const std::filesystem::path& path);
+
+        /**
+         * @brief Write the library to file
+         * @param path Path of the library file
+         * @throws std::runtime_error if the file cannot be written
+         */
+        void write(const std::filesystem::path& path) const;
+
+        /**
+         * @brief Get the configuration string CRY has been set up with to generate the showers
+         * @return CRY configuration string
+         */
+        const std::string& getConfiguration() const { return configuration_; }
+
+        /**
+         * @brief Get the number of showers in the library
+         * @return Number of showers
+         */
+        size_t size() const { return showers_.size(); }
+
+        /**
+         * @brief Get a shower of the library
+         * @param index Index of the shower
+         * @return Shower with the given index
+         */
+        const Shower& getShower(size_t index) const { return showers_[index]; }
+
+        /**
+         * @brief Get the total live time represented by all showers of the library
+         * @return Live time
+         */
+        double getLivetime() const;
+
+    private:
+        std::string configuration_;
+        std::vector<Shower> showers_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_COSMICS_DEPOSITION_MODULE_SHOWER_LIBRARY_H */
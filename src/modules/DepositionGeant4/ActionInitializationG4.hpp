@@ -18,6 +18,7 @@
 
 #include "SetTrackInfoUserHookG4.hpp"
 #include "StepInfoUserHookG4.hpp"
+#include "SubEventStackingActionG4.hpp"
 
 namespace allpix {
     /**
@@ -40,6 +41,11 @@ namespace allpix {
 
             // step hook
             SetUserAction(new StepInfoUserHookG4());
+
+            // optional removal of secondaries not reaching any sensor and of energetic secondaries to simulate in sub-events
+            if(config_.get<unsigned int>("sub_event_threads") > 0 || config_.get<bool>("cull_secondaries")) {
+                SetUserAction(new SubEventStackingActionG4(config_.get<double>("sub_event_min_energy")));
+            }
         };
 
         /**
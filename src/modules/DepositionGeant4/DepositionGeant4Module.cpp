@@ -12,23 +12,42 @@
 
 #include "DepositionGeant4Module.hpp"
 
+#include <fstream>
+#include <algorithm>
+#include <iomanip>
 #include <limits>
+#include <optional>
+#include <set>
+#include <sstream>
 #include <string>
+#include <system_error>
 #include <utility>
 
+#include <unistd.h>
+
+#include <CLHEP/Units/SystemOfUnits.h>
 #include <G4Box.hh>
 #include <G4EmParameters.hh>
+#include <G4FastSimulationPhysics.hh>
 #include <G4HadronicParameters.hh>
 #include <G4HadronicProcessStore.hh>
 #include <G4LogicalVolume.hh>
+#include <G4Material.hh>
 #include <G4NuclearLevelData.hh>
+#include <G4PVPlacement.hh>
 #include <G4PhysListFactory.hh>
+#include <G4PrimaryParticle.hh>
+#include <G4PrimaryVertex.hh>
 #include <G4ProcessTable.hh>
+#include <G4ProductionCuts.hh>
 #include <G4RadioactiveDecayPhysics.hh>
+#include <G4Region.hh>
 #include <G4StepLimiterPhysics.hh>
 #include <G4UImanager.hh>
 #include <G4UserLimits.hh>
+#include <G4Version.hh>
 
+#include "G4CachedMagneticField.hh"
 #include "G4FieldManager.hh"
 #include "G4TransportationManager.hh"
 #include "G4UniformMagField.hh"
@@ -38,6 +57,7 @@
 #include "core/geometry/RadialStripDetectorModel.hpp"
 #include "core/module/exceptions.h"
 #include "core/utils/log.h"
+#include "core/utils/prng.h"
 #include "objects/DepositedCharge.hpp"
 #include "physics/MaterialProperties.hpp"
 #include "tools/ROOT.h"
@@ -48,17 +68,61 @@
 #include "AdditionalPhysicsLists.hpp"
 
 #include "ActionInitializationG4.hpp"
+#include "FastSimulationModelG4.hpp"
 #include "GeneratorActionG4.hpp"
+#include "MagneticFieldG4.hpp"
 #include "SDAndFieldConstruction.hpp"
 #include "SensitiveDetectorActionG4.hpp"
 #include "SetTrackInfoUserHookG4.hpp"
+#include "SharedSensitiveDetectorG4.hpp"
 
 #define G4_NUM_SEEDS 10
 
 using namespace allpix;
 
+/**
+ * @brief Describe everything the physics tables depend on, i.e. the Geant4 version, the physics configuration, the range
+ * cut and the materials of the geometry
+ */
+static std::string physics_table_description(const Configuration& config, const std::string& physics_list, double cut) {
+    std::stringstream description;
+    description << std::setprecision(17) << G4Version << "\n"
+                << physics_list << "\n"
+                << "cut " << cut << "\n"
+                << "detector_cuts " << config.getText("detector_range_cut", "") << "\n"
+                << "pai " << config.get<bool>("enable_pai", false) << " " << config.get<std::string>("pai_model") << "\n"
+                << "fast_simulation " << config.get<bool>("fast_simulation") << "\n";
+    for(const auto* material : *G4Material::GetMaterialTable()) {
+        description << "material " << material->GetName() << " " << material->GetDensity() << " "
+                    << material->GetNumberOfElements() << "\n";
+    }
+    return description.str();
+}
+
+/**
+ * @brief Stable 64-bit FNV-1a hash of a string, used to name the directories of cached physics tables
+ */
+static std::string physics_table_hash(const std::string& description) {
+    uint64_t hash = 14695981039346656037ULL;
+    for(auto character : description) {
+        hash ^= static_cast<unsigned char>(character);
+        hash *= 1099511628211ULL;
+    }
+    std::stringstream hex;
+    hex << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return hex.str();
+}
+
+// Approximate mass stopping power of a minimum ionizing particle, used to estimate the charge deposited along a step
+static const double mip_mass_stopping_power = 1.66 * CLHEP::MeV * CLHEP::cm2 / CLHEP::g;
+
+// Name of the file marking a complete set of cached physics tables
+static const std::string physics_table_marker = "allpix_physics_tables.txt";
+
 thread_local std::unique_ptr<TrackInfoManager> DepositionGeant4Module::track_info_manager_ = nullptr;
 thread_local std::vector<SensitiveDetectorActionG4*> DepositionGeant4Module::sensors_;
+std::shared_ptr<const PrimaryCulling> DepositionGeant4Module::primary_culling_ = nullptr;
+std::shared_ptr<const SecondaryCulling> DepositionGeant4Module::secondary_culling_ = nullptr;
 
 /**
  * Includes the particle source point to the geometry using \ref GeometryManager::addPoint.
@@ -78,19 +142,44 @@ DepositionGeant4Module::DepositionGeant4Module(Configuration& config, Messenger*
     config_.setDefault<bool>("output_plots", false);
     config_.setDefault<int>("output_plots_scale", Units::get(100, "ke"));
     config_.setDefault<double>("max_step_length", Units::get(1.0, "um"));
+    // Charge per step of the propagation, used to derive the step length in the automatic mode
+    config_.setDefault<unsigned int>("charge_per_step", 10);
     // Default value chosen to ensure proper gamma generation for Cs137 decay
     config_.setDefault<double>("cutoff_time", 2.21e+11);
     // By default, only record MCTracks connected to MCParticles in the sensitive volume
     config_.setDefault<bool>("record_all_tracks", false);
+    config_.setDefault<bool>("record_only_tracks_with_deposits", false);
+    // By default, all events are passed on
+    config_.setDefault<bool>("reject_events_without_deposits", false);
+    // By default, a new Geant4 run is started for every event
+    config_.setDefault<bool>("persistent_run", false);
+    // By default, all secondaries are tracked within their event
+    config_.setDefault<unsigned int>("sub_event_threads", 0);
+    config_.setDefault<size_t>("sub_event_size", 100);
+    config_.setDefault<double>("sub_event_min_energy", Units::get(1.0, "MeV"));
+    // By default, all primary particles are tracked
+    config_.setDefault<bool>("cull_primaries", false);
+    config_.setDefault<double>("cull_primaries_margin", Units::get(1.0, "mm"));
+    config_.setDefault<bool>("cull_secondaries", false);
+    config_.setDefault<double>("cull_secondaries_range_factor", 2.0);
+    // By default, deposits are not merged
+    config_.setDefault<double>("deposit_merge_distance", 0.);
+    config_.setDefault<double>("deposit_merge_time", Units::get(10.0, "ps"));
+    // By default, separate deposits are created for electrons and holes
+    config_.setDefault<bool>("paired_deposits", false);
+    // By default, non-uniform magnetic fields are evaluated at every point
+    config_.setDefault<double>("magnetic_field_cache_distance", 0.);
 
     // Defaults for energy deposition in implants
+    config_.setDefault<bool>("fast_simulation", false);
+    config_.setDefault<std::vector<std::string>>("fast_simulation_particles",
+                                                 {"mu-", "mu+", "pi-", "pi+", "proton", "anti_proton"});
+    config_.setDefault<double>("fast_simulation_delta_threshold", Units::get(10.0, "keV"));
+    config_.setDefault<double>("fast_simulation_max_energy_loss", 0.05);
+
     config_.setDefault<bool>("deposit_in_frontside_implants", true);
     config_.setDefault<bool>("deposit_in_backside_implants", false);
 
-    // Create user limits for maximum step length and maximum event time in the sensor
-    user_limits_ =
-        std::make_unique<G4UserLimits>(config_.get<double>("max_step_length"), DBL_MAX, config_.get<double>("cutoff_time"));
-
     // Create user limits for maximum event time in the world volume:
     user_limits_world_ = std::make_unique<G4UserLimits>(DBL_MAX, DBL_MAX, config_.get<double>("cutoff_time"));
 
@@ -125,6 +214,21 @@ void DepositionGeant4Module::initialize() {
 
     number_of_particles_ = config_.get<unsigned int>("number_of_particles", 1);
     output_plots_ = config_.get<bool>("output_plots");
+    reject_events_without_deposits_ = config_.get<bool>("reject_events_without_deposits");
+
+    if(config_.get<bool>("record_all_tracks") && config_.get<bool>("record_only_tracks_with_deposits")) {
+        throw InvalidCombinationError(config_,
+                                      {"record_all_tracks", "record_only_tracks_with_deposits"},
+                                      "cannot record all tracks and only tracks with deposits at the same time");
+    }
+
+    auto sub_event_threads = config_.get<unsigned int>("sub_event_threads");
+    if(sub_event_threads > 0 && !multithreadingEnabled()) {
+        throw InvalidValueError(config_, "sub_event_threads", "sub-events can only be simulated with multithreading");
+    }
+    if(config_.get<size_t>("sub_event_size") == 0) {
+        throw InvalidValueError(config_, "sub_event_size", "sub-events have to contain at least one track");
+    }
 
     // Load the G4 run manager (which is owned by the geometry builder)
     if(multithreadingEnabled()) {
@@ -154,17 +258,36 @@ void DepositionGeant4Module::initialize() {
             throw InvalidValueError(config_, "pai_model", "model has to be either 'pai' or 'paiphoton'");
         }
 
+        // Detectors sharing their sensor volume share the region, the model is only added once per region
+        std::set<const G4Region*> pai_regions;
         for(auto& detector : geo_manager_->getDetectors()) {
-            // Get logical volume
-            auto logical_volume = geo_manager_->getExternalObject<G4LogicalVolume>(detector->getName(), "sensor_log");
-            if(logical_volume == nullptr) {
-                throw ModuleError("Detector " + detector->getName() + " has no sensitive device (broken Geant4 geometry)");
+            auto* region = sensor_region(detector);
+            if(pai_regions.insert(region).second) {
+                G4EmParameters::Instance()->AddPAIModel("all", region->GetName(), pai_model);
             }
-            // Create region
-            auto* region = new G4Region(detector->getName() + "_sensor_region");
-            region->AddRootLogicalVolume(logical_volume.get());
+        }
+    }
 
-            G4EmParameters::Instance()->AddPAIModel("all", region->GetName(), pai_model);
+    // Prepare the sensor regions for the optional fast simulation, the models are attached per thread
+    if(config_.get<bool>("fast_simulation")) {
+        if(geo_manager_->hasMagneticField()) {
+            throw InvalidCombinationError(config_,
+                                          {"fast_simulation"},
+                                          "fast simulation propagates particles along straight lines and cannot be used "
+                                          "with a magnetic field");
+        }
+        if(config_.get<double>("fast_simulation_delta_threshold") <= 0) {
+            throw InvalidValueError(config_, "fast_simulation_delta_threshold", "threshold has to be positive");
+        }
+
+        LOG(TRACE) << "Enabling fast simulation on all detectors";
+        std::set<const G4Region*> fast_simulation_regions;
+        for(auto& detector : geo_manager_->getDetectors()) {
+            // The model of a region deposits in a single sensitive detector action, sensors cannot be shared
+            if(!fast_simulation_regions.insert(sensor_region(detector)).second) {
+                throw ModuleError("Fast simulation cannot be used with detector " + detector->getName() +
+                                  " sharing its sensor volume with other detectors");
+            }
         }
     }
 
@@ -214,6 +337,16 @@ void DepositionGeant4Module::initialize() {
     LOG(DEBUG) << "Registering Geant4 step limiter physics list";
     physicsList->RegisterPhysics(new G4StepLimiterPhysics());
 
+    // Register the fast simulation process for the selected particles
+    if(config_.get<bool>("fast_simulation")) {
+        LOG(DEBUG) << "Registering Geant4 fast simulation physics list";
+        auto* fast_simulation_physics = new G4FastSimulationPhysics();
+        for(const auto& particle : config_.getArray<std::string>("fast_simulation_particles")) {
+            fast_simulation_physics->ActivateFastSimulation(particle);
+        }
+        physicsList->RegisterPhysics(fast_simulation_physics);
+    }
+
     // Register radioactive decay physics lists unless we are using a _HP list which include this already:
     if(physics_list.find("_HP") == std::string::npos) {
         LOG(DEBUG) << "Registering Geant4 radioactive decay physics list";
@@ -268,6 +401,42 @@ void DepositionGeant4Module::initialize() {
     }
     physicsList->SetDefaultCutValue(production_cut);
 
+    // Apply the production cuts configured for individual detectors or models to the regions of their sensors
+    for(const auto& [name, value] : read_detector_settings("detector_range_cut")) {
+        double cut = NAN;
+        try {
+            cut = allpix::from_string<double>(value);
+        } catch(std::invalid_argument& e) {
+            throw InvalidValueError(config_, "detector_range_cut", e.what());
+        }
+        if(!(cut > 0)) {
+            throw InvalidValueError(config_, "detector_range_cut", "range cut of detector " + name + " has to be positive");
+        }
+
+        auto* region = sensor_region(geo_manager_->getDetector(name));
+        auto* production_cuts = new G4ProductionCuts();
+        production_cuts->SetProductionCut(cut);
+        region->SetProductionCuts(production_cuts);
+        LOG(INFO) << "Setting G4 production cut of detector \"" << name << "\" to " << Units::display(cut, {"mm", "um"});
+    }
+
+    // Retrieve the physics tables from the cache if they have been stored by a previous run with identical physics and
+    // materials, otherwise they are stored at the end of this run
+    physics_list_ = physicsList;
+    if(config_.has("physics_table_cache")) {
+        physics_table_description_ = physics_table_description(config_, physics_list, production_cut);
+        physics_table_directory_ =
+            config_.getPath("physics_table_cache") / physics_table_hash(physics_table_description_);
+        if(std::filesystem::exists(physics_table_directory_ / physics_table_marker)) {
+            LOG(INFO) << "Retrieving G4 physics tables from " << physics_table_directory_;
+            physicsList->SetPhysicsTableRetrieved(physics_table_directory_.string());
+            physics_tables_retrieved_ = true;
+        } else {
+            LOG(INFO) << "No cached G4 physics tables found, storing tables to " << physics_table_directory_
+                      << " at the end of the run";
+        }
+    }
+
     // Set minimum remaining kinetic energy for a track
     double min_charge_creation_energy{};
     if(config_.has("charge_creation_energy")) {
@@ -304,6 +473,35 @@ void DepositionGeant4Module::initialize() {
         world_log_volume->GetRegion()->SetUserLimits(user_limits_world_.get());
     }
 
+    // Create user limits for the maximum step length and maximum event time in the sensor of every detector
+    auto step_lengths = read_detector_settings("detector_max_step_length");
+    for(auto& detector : geo_manager_->getDetectors()) {
+        auto configured = step_lengths.find(detector->getName());
+        auto step_length_key = (configured != step_lengths.end() ? "detector_max_step_length" : "max_step_length");
+        auto value =
+            (configured != step_lengths.end() ? configured->second : config_.get<std::string>("max_step_length"));
+        double max_step_length = NAN;
+        if(allpix::transform(value, ::tolower) == "auto") {
+            max_step_length = auto_max_step_length(detector);
+            LOG(INFO) << "Setting maximum step length of detector \"" << detector->getName() << "\" to "
+                      << Units::display(max_step_length, {"nm", "um"}) << ", derived from pitch and charge per step";
+        } else {
+            try {
+                max_step_length = allpix::from_string<double>(value);
+            } catch(std::invalid_argument& e) {
+                throw InvalidValueError(config_, step_length_key, e.what());
+            }
+            LOG(DEBUG) << "Setting maximum step length of detector \"" << detector->getName() << "\" to "
+                       << Units::display(max_step_length, {"nm", "um"});
+        }
+        if(!(max_step_length > 0)) {
+            throw InvalidValueError(config_, step_length_key, "maximum step length has to be positive");
+        }
+        max_step_lengths_[detector->getName()] = max_step_length;
+        user_limits_[detector->getName()] =
+            std::make_unique<G4UserLimits>(max_step_length, DBL_MAX, config_.get<double>("cutoff_time"));
+    }
+
     // Initialize the physics list
     LOG(TRACE) << "Initializing physics processes";
     run_manager_g4_->SetUserInitialization(physicsList);
@@ -320,6 +518,34 @@ void DepositionGeant4Module::initialize() {
     // Initialize the full run manager to ensure correct state flags
     run_manager_g4_->Initialize();
 
+    // Prepare the optional culling of primaries which cannot reach any sensor before the generator actions are built
+    if(config_.get<bool>("cull_primaries")) {
+        if(geo_manager_->hasMagneticField()) {
+            throw InvalidCombinationError(config_,
+                                          {"cull_primaries"},
+                                          "primaries are extrapolated along straight lines and cannot be culled with a "
+                                          "magnetic field");
+        }
+        auto margin = config_.get<double>("cull_primaries_margin");
+        if(margin < 0) {
+            throw InvalidValueError(config_, "cull_primaries_margin", "margin cannot be negative");
+        }
+        LOG(DEBUG) << "Culling primaries missing all sensors by more than " << Units::display(margin, {"um", "mm"});
+        primary_culling_ = std::make_shared<PrimaryCulling>(geo_manager_->getDetectors(), margin);
+    }
+
+    // Prepare the optional culling of secondaries which cannot reach any sensor before the stacking actions are built
+    if(config_.get<bool>("cull_secondaries")) {
+        auto range_factor = config_.get<double>("cull_secondaries_range_factor");
+        if(range_factor < 0) {
+            throw InvalidValueError(config_, "cull_secondaries_range_factor", "range factor cannot be negative");
+        }
+        LOG(DEBUG) << "Culling charged secondaries whose range times " << range_factor
+                   << " is shorter than the distance to the closest sensor";
+        secondary_culling_ = std::make_shared<SecondaryCulling>(
+            geo_manager_->getDetectors(), range_factor, read_volume_range_factors("cull_secondaries_volumes"));
+    }
+
     // Build particle generator
     // User hook to store additional information at track initialization and termination as well as custom track ids
     LOG(TRACE) << "Constructing particle source";
@@ -328,12 +554,23 @@ void DepositionGeant4Module::initialize() {
     // Construct the sensitive detectors and fields.
     if(run_manager_mt == nullptr) {
         // Create the info track manager for the main thread before creating the Sensitive detectors.
-        track_info_manager_ = std::make_unique<TrackInfoManager>(config_.get<bool>("record_all_tracks"));
+        track_info_manager_ = std::make_unique<TrackInfoManager>(
+            config_.get<bool>("record_all_tracks"), config_.get<bool>("record_only_tracks_with_deposits"));
         construct_sensitive_detectors_and_fields();
     } else {
         // In MT-mode we register a builder that will be called for each thread to construct the SD when needed.
         auto detector_construction = std::make_unique<SDAndFieldConstruction>(this);
         run_manager_mt->SetSDAndFieldConstruction(std::move(detector_construction));
+
+        // Optionally keep one Geant4 run open per worker to avoid the run initialization and termination for every event
+        run_manager_mt->SetPersistentRun(config_.get<bool>("persistent_run"));
+
+        if(sub_event_threads > 0) {
+            LOG(INFO) << "Simulating secondaries above "
+                      << Units::display(config_.get<double>("sub_event_min_energy"), {"keV", "MeV", "GeV"})
+                      << " in sub-events of " << config_.get<size_t>("sub_event_size") << " tracks on "
+                      << sub_event_threads << " helper threads";
+        }
     }
 
     // Flush the Geant4 stream buffer because some elements in the initialization never do:
@@ -357,10 +594,33 @@ void DepositionGeant4Module::initializeThread() {
         // In MT-mode the sensitive detectors will be created with the calls to BeamOn. So we construct the
         // track manager for each calling thread here.
         if(track_info_manager_ == nullptr) {
-            track_info_manager_ = std::make_unique<TrackInfoManager>(config_.get<bool>("record_all_tracks"));
+            track_info_manager_ = std::make_unique<TrackInfoManager>(
+                config_.get<bool>("record_all_tracks"), config_.get<bool>("record_only_tracks_with_deposits"));
         }
 
         run_manager_mt->InitializeForThread();
+
+        // Start the helper threads simulating energetic secondaries of heavy events in parallel, only once the
+        // initialization of all modules has finished
+        auto sub_event_threads = config_.get<unsigned int>("sub_event_threads");
+        if(sub_event_threads > 0) {
+            std::call_once(sub_event_pool_flag_, [this, sub_event_threads]() {
+                sub_event_pool_ = std::make_unique<SubEventPool>(
+                    sub_event_threads,
+                    config_.get<size_t>("sub_event_size"),
+                    [this,
+                     log_level = Log::getReportingLevel(),
+                     log_format = Log::getFormat(),
+                     log_section = Log::getSection()]() {
+                        Log::setReportingLevel(log_level);
+                        Log::setFormat(log_format);
+                        Log::setSection(log_section);
+                        initialize_sub_event_thread();
+                    },
+                    [this](SubEventPool::SubEvent& sub_event) { run_sub_event(sub_event); },
+                    [this]() { static_cast<MTRunManager*>(run_manager_g4_)->TerminateForThread(); });
+            });
+        }
     }
 
     // Set selected tracking verbosity, defaulting to zero. Higher levels can be useful for tracing individual Geant4 events
@@ -381,6 +641,12 @@ void DepositionGeant4Module::run(Event* event) {
     auto seed2 = event->getRandomNumber();
     LOG(DEBUG) << "Seeding Geant4 event with seeds " << seed1 << " " << seed2;
 
+    // Collect energetic secondaries into sub-events for the helper threads, waiting for them also if the event is aborted
+    std::optional<SubEventPool::Collector> sub_event_collector;
+    if(sub_event_pool_ != nullptr) {
+        sub_event_collector.emplace(*sub_event_pool_, event->number, event->getRandomNumber());
+    }
+
     try {
         if(multithreadingEnabled()) {
             auto* run_manager_mt = static_cast<MTRunManager*>(run_manager_g4_);
@@ -390,6 +656,10 @@ void DepositionGeant4Module::run(Event* event) {
             run_manager->Run(static_cast<int>(number_of_particles_), seed1, seed2);
         }
 
+        if(sub_event_collector.has_value()) {
+            merge_sub_events(sub_event_collector->finish());
+        }
+
         uint64_t last_event_num = last_event_num_.load();
         last_event_num_.compare_exchange_strong(last_event_num, event->number);
 
@@ -397,8 +667,10 @@ void DepositionGeant4Module::run(Event* event) {
         track_info_manager_->dispatchMessage(this, messenger_, event);
 
         // Dispatch the necessary messages
+        bool has_deposits = false;
         for(auto& sensor : sensors_) {
             sensor->dispatchMessages(this, messenger_, event);
+            has_deposits |= (sensor->getDepositedCharge() > 0);
 
             // Fill output plots if requested:
             if(output_plots_) {
@@ -409,6 +681,12 @@ void DepositionGeant4Module::run(Event* event) {
                 energy_per_event_[sensor->getName()]->Fill(deposited_energy);
             }
         }
+
+        // Skip the further simulation of events without any charge deposited in the sensors
+        if(reject_events_without_deposits_ && !has_deposits) {
+            LOG(DEBUG) << "No charge deposited in any sensor, rejecting event";
+            event->reject();
+        }
     } catch(AbortEventException& e) {
         // Clear charge deposits of all sensors
         for(auto& sensor : sensors_) {
@@ -422,6 +700,82 @@ void DepositionGeant4Module::run(Event* event) {
     track_info_manager_->resetTrackInfoManager();
 }
 
+void DepositionGeant4Module::initialize_sub_event_thread() {
+    // Helper threads only ever simulate sub-events, whose primaries refer to parents in the event they are split from
+    track_info_manager_ = std::make_unique<TrackInfoManager>(
+        config_.get<bool>("record_all_tracks"), config_.get<bool>("record_only_tracks_with_deposits"), true);
+    static_cast<MTRunManager*>(run_manager_g4_)->InitializeForThread();
+
+    G4RunManagerKernel::GetRunManagerKernel()->GetTrackingManager()->SetVerboseLevel(
+        config_.get<int>("geant4_tracking_verbosity", 0));
+}
+
+void DepositionGeant4Module::run_sub_event(SubEventPool::SubEvent& sub_event) {
+    Log::setEventNum(sub_event.event_number);
+
+    // Every sub-event draws its seeds from its own stream, independent of the helper thread simulating it
+    Philox4x64 random_generator(sub_event.seed, sub_event.index);
+    for(auto& sensor : sensors_) {
+        sensor->seed(random_generator());
+    }
+    auto seed1 = random_generator();
+    auto seed2 = random_generator();
+
+    // Start every track from its own vertex, such that its Geant4 track id follows from its index in the sub-event
+    auto generator = [&sub_event](G4Event* g4_event) {
+        for(const auto& track : sub_event.tracks) {
+            auto* particle = new G4PrimaryParticle(track.definition);
+            particle->SetKineticEnergy(track.kinetic_energy);
+            particle->SetMomentumDirection(track.direction);
+            particle->SetPolarization(track.polarization);
+            particle->SetCharge(track.charge);
+            particle->SetWeight(track.weight);
+
+            auto* vertex = new G4PrimaryVertex(track.position, track.time);
+            vertex->SetPrimary(particle);
+            g4_event->AddPrimaryVertex(vertex);
+        }
+    };
+
+    LOG(DEBUG) << "Simulating sub-event " << sub_event.index << " with " << sub_event.tracks.size() << " tracks";
+    try {
+        static_cast<MTRunManager*>(run_manager_g4_)->RunSubEvent(generator, seed1, seed2);
+
+        for(auto& sensor : sensors_) {
+            sub_event.sensors.push_back(sensor->releaseEventInfo());
+        }
+        sub_event.track_ids = track_info_manager_->getNumberOfTrackIDs();
+        sub_event.track_infos = track_info_manager_->releaseTrackInfos();
+    } catch(AbortEventException& e) {
+        for(auto& sensor : sensors_) {
+            sensor->clearEventInfo();
+        }
+        run_manager_g4_->AbortRun();
+        track_info_manager_->resetTrackInfoManager();
+        throw;
+    }
+
+    track_info_manager_->resetTrackInfoManager();
+}
+
+void DepositionGeant4Module::merge_sub_events(const std::vector<std::unique_ptr<SubEventPool::SubEvent>>& sub_events) {
+    size_t tracks = 0;
+    for(const auto& sub_event : sub_events) {
+        if(sub_event->sensors.size() != sensors_.size()) {
+            throw ModuleError("Sub-event recorded deposits in " + std::to_string(sub_event->sensors.size()) +
+                              " sensors instead of " + std::to_string(sensors_.size()));
+        }
+
+        auto offset =
+            track_info_manager_->mergeSubEvent(std::move(sub_event->track_infos), sub_event->track_ids, sub_event->tracks);
+        for(size_t i = 0; i < sensors_.size(); ++i) {
+            sensors_[i]->mergeEventInfo(std::move(sub_event->sensors[i]), offset, sub_event->tracks);
+        }
+        tracks += sub_event->tracks.size();
+    }
+    LOG(DEBUG) << "Merged " << sub_events.size() << " sub-events started from " << tracks << " secondaries";
+}
+
 void DepositionGeant4Module::finalize() {
     if(output_plots_) {
         // Write histograms
@@ -442,6 +796,166 @@ void DepositionGeant4Module::finalize() {
     } else {
         LOG(WARNING) << "No charges deposited";
     }
+
+    if(!physics_table_directory_.empty() && !physics_tables_retrieved_) {
+        store_physics_tables();
+    }
+
+    // Terminate the Geant4 workers of the helper threads
+    sub_event_pool_.reset();
+
+    if(primary_culling_ != nullptr) {
+        LOG(INFO) << "Culled " << primary_culling_->getCulledPrimaries() << " of "
+                  << primary_culling_->getCheckedPrimaries() << " primaries not reaching any sensor";
+        primary_culling_.reset();
+    }
+    if(secondary_culling_ != nullptr) {
+        LOG(INFO) << "Culled " << secondary_culling_->getCulledSecondaries() << " of "
+                  << secondary_culling_->getCheckedSecondaries() << " charged secondaries not reaching any sensor";
+        secondary_culling_.reset();
+    }
+}
+
+/**
+ * The tables are first written to a temporary directory which is then renamed, such that concurrent jobs never retrieve an
+ * incomplete set of tables. If another job stored the same tables in the meantime, the temporary copy is discarded.
+ */
+std::map<std::string, std::string> DepositionGeant4Module::read_detector_settings(const std::string& key) const {
+    std::map<std::string, std::string> by_detector;
+    if(!config_.has(key)) {
+        return by_detector;
+    }
+
+    // Collect the settings per detector name and per model type
+    std::map<std::string, std::string> by_name;
+    for(const auto& row : config_.getMatrix<std::string>(key)) {
+        if(row.size() != 2) {
+            throw InvalidValueError(config_, key, "expecting pairs of a detector name or model type and a value");
+        }
+        if(!by_name.emplace(row.front(), row.back()).second) {
+            throw InvalidValueError(config_, key, "duplicate entry for " + row.front());
+        }
+    }
+
+    // Settings of individual detectors take precedence over the ones of their model
+    std::set<std::string> used;
+    for(const auto& detector : geo_manager_->getDetectors()) {
+        for(const auto& name : {detector->getName(), detector->getType()}) {
+            auto setting = by_name.find(name);
+            if(setting != by_name.end()) {
+                by_detector.emplace(detector->getName(), setting->second);
+                used.insert(name);
+                break;
+            }
+        }
+    }
+    for(const auto& [name, value] : by_name) {
+        if(used.count(name) == 0) {
+            throw InvalidValueError(config_, key, "no detector or model with name " + name + " in the geometry");
+        }
+    }
+    return by_detector;
+}
+
+std::map<const G4LogicalVolume*, double> DepositionGeant4Module::read_volume_range_factors(const std::string& key) const {
+    std::map<const G4LogicalVolume*, double> by_volume;
+    if(!config_.has(key)) {
+        return by_volume;
+    }
+
+    for(const auto& row : config_.getMatrix<std::string>(key)) {
+        if(row.size() != 2) {
+            throw InvalidValueError(config_, key, "expecting pairs of a passive material name and a range factor");
+        }
+
+        auto volume = (row.front() == "world"
+                           ? geo_manager_->getExternalObject<G4LogicalVolume>("", "world_log")
+                           : geo_manager_->getExternalObject<G4LogicalVolume>(row.front(), "passive_material_log"));
+        if(volume == nullptr) {
+            throw InvalidValueError(config_, key, "no passive material with name " + row.front() + " in the geometry");
+        }
+
+        double factor = NAN;
+        try {
+            factor = allpix::from_string<double>(row.back());
+        } catch(std::invalid_argument& e) {
+            throw InvalidValueError(config_, key, e.what());
+        }
+        if(!(factor >= 0)) {
+            throw InvalidValueError(config_, key, "range factor cannot be negative");
+        }
+        if(!by_volume.emplace(volume.get(), factor).second) {
+            throw InvalidValueError(config_, key, "duplicate entry for " + row.front());
+        }
+        LOG(DEBUG) << "Culling secondaries in volume " << row.front() << " with range factor " << factor;
+    }
+    return by_volume;
+}
+
+double DepositionGeant4Module::auto_max_step_length(const std::shared_ptr<Detector>& detector) const {
+    auto model = detector->getModel();
+    auto logical_volume = geo_manager_->getExternalObject<G4LogicalVolume>(detector->getName(), "sensor_log");
+    if(logical_volume == nullptr) {
+        throw ModuleError("Detector " + detector->getName() + " has no sensitive device (broken Geant4 geometry)");
+    }
+
+    // Resolve a tenth of the smallest pixel feature, i.e. either pitch or thickness
+    auto spatial_step = std::min({model->getPixelSize().x(), model->getPixelSize().y(), model->getSensorSize().z()}) / 10;
+
+    // Do not split the deposits of a minimum ionizing particle below the charge per step of the propagation
+    auto charge_creation_energy =
+        (config_.has("charge_creation_energy") ? config_.get<double>("charge_creation_energy")
+                                               : allpix::ionization_energies[model->getSensorMaterial()]);
+    auto stopping_power = mip_mass_stopping_power * logical_volume->GetMaterial()->GetDensity();
+    auto charge_step = config_.get<unsigned int>("charge_per_step") * charge_creation_energy / stopping_power;
+
+    LOG(DEBUG) << "Detector " << detector->getName() << " resolves pixel features with steps of "
+               << Units::display(spatial_step, {"nm", "um"}) << " and charge per step with steps of "
+               << Units::display(charge_step, {"nm", "um"});
+    return std::max(spatial_step, charge_step);
+}
+
+G4Region* DepositionGeant4Module::sensor_region(const std::shared_ptr<Detector>& detector) const {
+    auto logical_volume = geo_manager_->getExternalObject<G4LogicalVolume>(detector->getName(), "sensor_log");
+    if(logical_volume == nullptr) {
+        throw ModuleError("Detector " + detector->getName() + " has no sensitive device (broken Geant4 geometry)");
+    }
+
+    // Reuse the region created for another feature or for another detector sharing the sensor volume
+    if(logical_volume->IsRootRegion() && logical_volume->GetRegion() != nullptr) {
+        return logical_volume->GetRegion();
+    }
+    auto* region = new G4Region(detector->getName() + "_sensor_region");
+    region->AddRootLogicalVolume(logical_volume.get());
+    return region;
+}
+
+void DepositionGeant4Module::store_physics_tables() {
+    auto temporary_directory = physics_table_directory_;
+    temporary_directory += ".tmp" + std::to_string(::getpid());
+
+    std::error_code error;
+    std::filesystem::create_directories(temporary_directory, error);
+    if(error) {
+        LOG(WARNING) << "Cannot create directory " << temporary_directory << " to store G4 physics tables: "
+                     << error.message();
+        return;
+    }
+
+    if(!physics_list_->StorePhysicsTable(temporary_directory.string())) {
+        LOG(WARNING) << "Failed to store G4 physics tables to " << temporary_directory;
+        std::filesystem::remove_all(temporary_directory, error);
+        return;
+    }
+    std::ofstream(temporary_directory / physics_table_marker) << physics_table_description_;
+
+    std::filesystem::rename(temporary_directory, physics_table_directory_, error);
+    if(error) {
+        LOG(DEBUG) << "G4 physics tables already stored to " << physics_table_directory_ << ", discarding copy";
+        std::filesystem::remove_all(temporary_directory, error);
+        return;
+    }
+    LOG(INFO) << "Stored G4 physics tables to " << physics_table_directory_;
 }
 
 void DepositionGeant4Module::finalizeThread() {
@@ -457,17 +971,36 @@ void DepositionGeant4Module::finalizeThread() {
 void DepositionGeant4Module::construct_sensitive_detectors_and_fields() {
     if(geo_manager_->hasMagneticField()) {
         MagneticFieldType magnetic_field_type_ = geo_manager_->getMagneticFieldType();
-
+        G4MagneticField* magField = nullptr;
         if(magnetic_field_type_ == MagneticFieldType::CONSTANT) {
             ROOT::Math::XYZVector b_field = geo_manager_->getMagneticField(ROOT::Math::XYZPoint(0., 0., 0.));
-            G4MagneticField* magField = new G4UniformMagField(G4ThreeVector(b_field.x(), b_field.y(), b_field.z()));
-            G4FieldManager* globalFieldMgr = G4TransportationManager::GetTransportationManager()->GetFieldManager();
-            globalFieldMgr->SetDetectorField(magField);
-            globalFieldMgr->CreateChordFinder(magField);
+            magField = new G4UniformMagField(G4ThreeVector(b_field.x(), b_field.y(), b_field.z()));
         } else {
-            throw ModuleError("Magnetic field enabled, but not constant. This can't be handled by this module yet.");
+            // Field maps and custom fields are evaluated at every point requested by the stepper, optionally reusing the
+            // last value within the configured distance
+            magField = new MagneticFieldG4(geo_manager_);
+            auto cache_distance = config_.get<double>("magnetic_field_cache_distance");
+            if(cache_distance > 0) {
+                magField = new G4CachedMagneticField(magField, cache_distance);
+            }
+        }
+        G4FieldManager* globalFieldMgr = G4TransportationManager::GetTransportationManager()->GetFieldManager();
+        globalFieldMgr->SetDetectorField(magField);
+        globalFieldMgr->CreateChordFinder(magField);
+    }
+
+    // Find the sensor volumes shared by several detectors of the same model, these obtain the user limits of the detector
+    // with the smallest maximum step length and a sensitive detector forwarding the steps to the action of each detector
+    std::map<const G4LogicalVolume*, std::vector<std::string>> sensor_volume_detectors;
+    for(auto& detector : geo_manager_->getDetectors()) {
+        auto logical_volume = geo_manager_->getExternalObject<G4LogicalVolume>(detector->getName(), "sensor_log");
+        auto& sharing_detectors = sensor_volume_detectors[logical_volume.get()];
+        sharing_detectors.push_back(detector->getName());
+        if(max_step_lengths_.at(detector->getName()) < max_step_lengths_.at(sharing_detectors.front())) {
+            std::swap(sharing_detectors.front(), sharing_detectors.back());
         }
     }
+    std::map<const G4LogicalVolume*, SharedSensitiveDetectorG4*> shared_sensitive_detectors;
 
     // Loop through all detectors and set the sensitive detector action that handles the particle passage
     bool useful_deposition = false;
@@ -496,19 +1029,45 @@ void DepositionGeant4Module::construct_sensitive_detectors_and_fields() {
         // Cut-off time for particle generation:
         auto cutoff_time = config_.get<double>("cutoff_time");
 
+        // Tolerances for merging consecutive deposits of the same track
+        auto merge_distance = config_.get<double>("deposit_merge_distance");
+        auto merge_time = config_.get<double>("deposit_merge_time");
+        if(merge_distance < 0) {
+            throw InvalidValueError(config_, "deposit_merge_distance", "merging distance cannot be negative");
+        }
+
         // Get model of the sensitive device
-        auto* sensitive_detector_action = new SensitiveDetectorActionG4(
-            detector, track_info_manager_.get(), charge_creation_energy, fano_factor, cutoff_time);
+        auto* sensitive_detector_action = new SensitiveDetectorActionG4(detector,
+                                                                        track_info_manager_.get(),
+                                                                        charge_creation_energy,
+                                                                        fano_factor,
+                                                                        cutoff_time,
+                                                                        merge_distance,
+                                                                        merge_time);
+        sensitive_detector_action->setPairedDeposits(config_.get<bool>("paired_deposits"));
         auto logical_volume = geo_manager_->getExternalObject<G4LogicalVolume>(detector->getName(), "sensor_log");
         if(logical_volume == nullptr) {
             throw ModuleError("Detector " + detector->getName() + " has no sensitive device (broken Geant4 geometry)");
         }
 
-        // Apply the user limits to this element
-        logical_volume->SetUserLimits(user_limits_.get());
-
-        // Add the sensitive detector action
-        logical_volume->SetSensitiveDetector(sensitive_detector_action);
+        // Apply the user limits of this detector, or of the sharing detector with the smallest step, to this element
+        const auto& sharing_detectors = sensor_volume_detectors.at(logical_volume.get());
+        auto* user_limits = user_limits_.at(sharing_detectors.front()).get();
+        logical_volume->SetUserLimits(user_limits);
+
+        // Add the sensitive detector action, identifying the detector by the copy number of its wrapper if shared
+        G4VSensitiveDetector* sensitive_detector = sensitive_detector_action;
+        if(sharing_detectors.size() > 1) {
+            auto& shared_sensitive_detector = shared_sensitive_detectors[logical_volume.get()];
+            if(shared_sensitive_detector == nullptr) {
+                shared_sensitive_detector = new SharedSensitiveDetectorG4(logical_volume->GetName());
+            }
+            auto wrapper = geo_manager_->getExternalObject<G4PVPlacement>(detector->getName(), "wrapper_phys");
+            shared_sensitive_detector->addDetector(wrapper->GetCopyNo(), sensitive_detector_action);
+            sensitive_detector_action->setSharedVolume(true);
+            sensitive_detector = shared_sensitive_detector;
+        }
+        logical_volume->SetSensitiveDetector(sensitive_detector);
 
         // Add the sensitive detector action to fronmtside implant volumes
         std::regex regex;
@@ -520,8 +1079,19 @@ void DepositionGeant4Module::construct_sensitive_detectors_and_fields() {
             regex = "implant_log_backside_.*";
         }
         for(const auto& implant : geo_manager_->getExternalObjects<G4LogicalVolume>(detector->getName(), regex)) {
-            implant->SetUserLimits(user_limits_.get());
-            implant->SetSensitiveDetector(sensitive_detector_action);
+            implant->SetUserLimits(user_limits);
+            implant->SetSensitiveDetector(sensitive_detector);
+        }
+
+        // Attach the fast simulation model to the region of the sensor
+        if(config_.get<bool>("fast_simulation")) {
+            new FastSimulationModelG4(detector->getName() + "_fast_simulation",
+                                      logical_volume->GetRegion(),
+                                      sensitive_detector_action,
+                                      config_.getArray<std::string>("fast_simulation_particles"),
+                                      max_step_lengths_.at(detector->getName()),
+                                      config_.get<double>("fast_simulation_delta_threshold"),
+                                      config_.get<double>("fast_simulation_max_energy_loss"));
         }
 
         sensors_.push_back(sensitive_detector_action);
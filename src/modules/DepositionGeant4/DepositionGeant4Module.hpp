@@ -13,7 +13,10 @@
 #define ALLPIX_SIMPLE_DEPOSITION_MODULE_H
 
 #include <atomic>
+#include <filesystem>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 
 #include <G4UserLimits.hh>
@@ -24,15 +27,20 @@
 #include "core/module/Event.hpp"
 #include "core/module/Module.hpp"
 
+#include "PrimaryCulling.hpp"
+#include "SecondaryCulling.hpp"
 #include "SensitiveDetectorActionG4.hpp"
+#include "SubEventPool.hpp"
 #include "TrackInfoManager.hpp"
 
 #include "tools/ROOT.h"
 
 #include <TH1D.h>
 
+class G4Region;
 class G4UserLimits;
 class G4RunManager;
+class G4VModularPhysicsList;
 
 namespace allpix {
     /**
@@ -47,6 +55,9 @@ namespace allpix {
     class DepositionGeant4Module : public SequentialModule {
         friend class SDAndFieldConstruction;
         friend class SetTrackInfoUserHookG4;
+        friend class SubEventStackingActionG4;
+        friend class GeneratorActionG4;
+        friend class CosmicsGeneratorActionG4;
 
     public:
         /**
@@ -91,6 +102,12 @@ namespace allpix {
 
         virtual void initialize_g4_action();
 
+        // Optional pre-selection of primary particles reaching any sensor, shared by the generator actions of all threads
+        static std::shared_ptr<const PrimaryCulling> primary_culling_;
+
+        // Optional removal of secondary particles not reaching any sensor, shared by the stacking actions of all threads
+        static std::shared_ptr<const SecondaryCulling> secondary_culling_;
+
     private:
         /**
          * @brief Construct the sensitive detectors and magnetic fields.
@@ -102,8 +119,59 @@ namespace allpix {
          */
         void record_module_statistics();
 
+        /**
+         * @brief Store the physics tables built in this run to the cache directory
+         */
+        void store_physics_tables();
+
+        /**
+         * @brief Prepare a helper thread of the sub-event pool as Geant4 worker
+         */
+        void initialize_sub_event_thread();
+
+        /**
+         * @brief Simulate a sub-event on a helper thread of the sub-event pool
+         * @param sub_event Sub-event to simulate, receives the recorded tracks and deposits
+         */
+        void run_sub_event(SubEventPool::SubEvent& sub_event);
+
+        /**
+         * @brief Merge the simulated sub-events of an event into the tracks and deposits of the calling thread
+         * @param sub_events Simulated sub-events in the order of their creation
+         */
+        void merge_sub_events(const std::vector<std::unique_ptr<SubEventPool::SubEvent>>& sub_events);
+
+        /**
+         * @brief Read a per-detector setting given as pairs of detector name or model type and value
+         * @param key Key of the setting in the configuration
+         * @return Values of the setting for all detectors it applies to, indexed by detector name
+         */
+        std::map<std::string, std::string> read_detector_settings(const std::string& key) const;
+
+        /**
+         * @brief Read the range factors for the culling of secondaries given as pairs of passive material name and factor
+         * @param key Key of the setting in the configuration
+         * @return Range factors indexed by logical volume, the name "world" refers to the world volume
+         */
+        std::map<const G4LogicalVolume*, double> read_volume_range_factors(const std::string& key) const;
+
+        /**
+         * @brief Derive the maximum step length in the sensor of a detector from its pitch and the charge per step
+         * @param detector Detector to derive the step length for
+         * @return Maximum step length
+         */
+        double auto_max_step_length(const std::shared_ptr<Detector>& detector) const;
+
+        /**
+         * @brief Get the region of the sensor of a detector, creating it if the sensor is not yet the root of a region
+         * @param detector Detector to get the sensor region for
+         * @return Region of the sensor, shared by all detectors sharing the sensor volume
+         */
+        G4Region* sensor_region(const std::shared_ptr<Detector>& detector) const;
+
         // Configuration parameters:
         bool output_plots_{};
+        bool reject_events_without_deposits_{};
         unsigned int number_of_particles_{};
 
         // The track manager which this module uses to assign custom track IDs and manage & create MCTracks
@@ -112,11 +180,16 @@ namespace allpix {
         // Handling of the charge deposition in all the sensitive devices
         static thread_local std::vector<SensitiveDetectorActionG4*> sensors_;
 
+        // Helper threads simulating energetic secondaries of the events in sub-events
+        std::unique_ptr<SubEventPool> sub_event_pool_;
+        std::once_flag sub_event_pool_flag_;
+
         // Number of the last event
         std::atomic_uint64_t last_event_num_{0};
 
-        // Class holding the limits for the step size
-        std::unique_ptr<G4UserLimits> user_limits_;
+        // Classes holding the limits for the step size per detector
+        std::map<std::string, double> max_step_lengths_;
+        std::map<std::string, std::unique_ptr<G4UserLimits>> user_limits_;
         std::unique_ptr<G4UserLimits> user_limits_world_;
 
         // Vector of histogram pointers for debugging plots
@@ -128,6 +201,12 @@ namespace allpix {
 
         std::atomic_size_t number_of_sensors_{0};
 
+        // Physics list (owned by the Geant4 run manager) and directory of its cached tables
+        G4VModularPhysicsList* physics_list_{nullptr};
+        std::filesystem::path physics_table_directory_;
+        std::string physics_table_description_;
+        bool physics_tables_retrieved_{false};
+
         // Mutex used for the construction of histograms
         std::mutex histogram_mutex_;
     };
@@ -0,0 +1,159 @@
+/**
+ * @file
+ * @brief Implements a Geant4 fast simulation model for the energy loss of charged particles in the sensors
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "FastSimulationModelG4.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <G4DynamicParticle.hh>
+#include <G4Electron.hh>
+#include <G4FastStep.hh>
+#include <G4FastTrack.hh>
+#include <G4Poisson.hh>
+#include <Randomize.hh>
+
+#include "core/utils/log.h"
+#include "tools/landau_table.h"
+
+using namespace allpix;
+
+FastSimulationModelG4::FastSimulationModelG4(const std::string& name,
+                                             G4Region* region,
+                                             SensitiveDetectorActionG4* sensor,
+                                             const std::vector<std::string>& particles,
+                                             double segment_length,
+                                             double delta_threshold,
+                                             double max_energy_loss)
+    : G4VFastSimulationModel(name, region), sensor_(sensor), particles_(particles.begin(), particles.end()),
+      segment_length_(segment_length), delta_threshold_(delta_threshold), max_energy_loss_(max_energy_loss) {}
+
+G4bool FastSimulationModelG4::IsApplicable(const G4ParticleDefinition& particle) {
+    return particle.GetPDGCharge() != 0. && particles_.count(particle.GetParticleName()) > 0;
+}
+
+G4bool FastSimulationModelG4::ModelTrigger(const G4FastTrack& fast_track) {
+    if(fast_track.OnTheBoundaryButExiting()) {
+        return false;
+    }
+
+    // Only parameterise particles losing a small fraction of their energy, for which the straight path is a good
+    // approximation. Other particles are handled by the full Geant4 stepping.
+    const auto* track = fast_track.GetPrimaryTrack();
+    auto length = fast_track.GetEnvelopeSolid()->DistanceToOut(fast_track.GetPrimaryTrackLocalPosition(),
+                                                               fast_track.GetPrimaryTrackLocalDirection());
+    auto kinetic_energy = track->GetKineticEnergy();
+    auto dedx = em_calculator_.ComputeElectronicDEDX(
+        kinetic_energy, track->GetParticleDefinition(), track->GetMaterial(), delta_threshold_);
+    return dedx * length < max_energy_loss_ * kinetic_energy;
+}
+
+void FastSimulationModelG4::DoIt(const G4FastTrack& fast_track, G4FastStep& fast_step) {
+    const auto* track = fast_track.GetPrimaryTrack();
+    const auto* particle = track->GetParticleDefinition();
+    const auto* material = track->GetMaterial();
+    const auto& landau = LandauTable::get();
+
+    // Straight path to the surface of the sensor, divided into segments
+    auto length = fast_track.GetEnvelopeSolid()->DistanceToOut(fast_track.GetPrimaryTrackLocalPosition(),
+                                                               fast_track.GetPrimaryTrackLocalDirection());
+    auto segments = std::max(1., std::ceil(length / segment_length_));
+    auto segment_length = length / segments;
+
+    auto direction = track->GetMomentumDirection();
+    auto position = track->GetPosition();
+    auto time = track->GetGlobalTime();
+    auto kinetic_energy = track->GetKineticEnergy();
+    auto mass = particle->GetPDGMass();
+    auto charge = particle->GetPDGCharge() / CLHEP::eplus;
+    auto electron_mass = CLHEP::electron_mass_c2;
+
+    struct Secondary {
+        G4DynamicParticle particle;
+        G4ThreeVector position;
+        double time;
+    };
+    std::vector<Secondary> secondaries;
+
+    double path_length = 0;
+    for(int segment = 0; segment < static_cast<int>(segments) && kinetic_energy > 0; ++segment) {
+        auto gamma = 1. + kinetic_energy / mass;
+        auto beta2 = 1. - 1. / (gamma * gamma);
+        auto velocity = std::sqrt(beta2) * CLHEP::c_light;
+
+        auto begin = position;
+        auto end = position + segment_length * direction;
+        auto center = (begin + end) / 2;
+        auto center_time = time + segment_length / 2 / velocity;
+
+        // Restricted energy loss of the segment, fluctuating around its mean with a Landau distribution of width xi. The
+        // distribution is truncated where a single collision would exceed the threshold for the production of delta rays.
+        auto mean_loss =
+            em_calculator_.ComputeElectronicDEDX(kinetic_energy, particle, material, delta_threshold_) * segment_length;
+        auto xi = CLHEP::twopi_mc2_rcl2 * material->GetElectronDensity() * charge * charge * segment_length / beta2;
+        auto lambda_max = delta_threshold_ / xi;
+        auto energy_loss = mean_loss + xi * (landau.sample(lambda_max, G4UniformRand()) - landau.mean(lambda_max));
+        energy_loss = std::clamp(energy_loss, 0., kinetic_energy);
+        kinetic_energy -= energy_loss;
+        sensor_->processDeposit(track, begin, end, center, center_time, energy_loss);
+
+        // Delta electrons above the threshold, sampled from the Rutherford cross section with a factor for the spin
+        auto mass_ratio = electron_mass / mass;
+        auto max_energy =
+            2. * electron_mass * (gamma * gamma - 1.) / (1. + 2. * gamma * mass_ratio + mass_ratio * mass_ratio);
+        if(max_energy > delta_threshold_) {
+            auto number = G4Poisson(xi * (1. / delta_threshold_ - 1. / max_energy));
+            for(G4long n = 0; n < number; ++n) {
+                auto delta_energy =
+                    delta_threshold_ * max_energy / (max_energy - G4UniformRand() * (max_energy - delta_threshold_));
+                if(G4UniformRand() > 1. - beta2 * delta_energy / max_energy || delta_energy >= kinetic_energy) {
+                    continue;
+                }
+
+                // Emission angle from the two-body kinematics of the collision
+                auto momentum = std::sqrt(kinetic_energy * (kinetic_energy + 2. * mass));
+                auto delta_momentum = std::sqrt(delta_energy * (delta_energy + 2. * electron_mass));
+                auto cos_theta =
+                    std::min(1., delta_energy * (kinetic_energy + mass + electron_mass) / (delta_momentum * momentum));
+                auto sin_theta = std::sqrt((1. - cos_theta) * (1. + cos_theta));
+                auto phi = CLHEP::twopi * G4UniformRand();
+                G4ThreeVector delta_direction(sin_theta * std::cos(phi), sin_theta * std::sin(phi), cos_theta);
+                delta_direction.rotateUz(direction);
+
+                secondaries.push_back(
+                    {G4DynamicParticle(G4Electron::Definition(), delta_direction, delta_energy), center, center_time});
+                kinetic_energy -= delta_energy;
+            }
+        }
+
+        position = end;
+        time += segment_length / velocity;
+        path_length += segment_length;
+    }
+
+    // Hand the delta electrons back to Geant4
+    fast_step.SetNumberOfSecondaryTracks(static_cast<G4int>(secondaries.size()));
+    for(const auto& secondary : secondaries) {
+        fast_step.CreateSecondaryTrack(secondary.particle, secondary.position, secondary.time, false);
+    }
+    LOG(TRACE) << "Moved " << particle->GetParticleName() << " through the sensor in " << static_cast<int>(segments)
+               << " segments, creating " << secondaries.size() << " delta electrons";
+
+    // The energy loss is not assigned to the step since it has already been deposited via the sensitive detector
+    fast_step.ProposePrimaryTrackFinalPosition(position, false);
+    fast_step.ProposePrimaryTrackFinalTime(time);
+    fast_step.ProposePrimaryTrackPathLength(path_length);
+    if(kinetic_energy > 0) {
+        fast_step.ProposePrimaryTrackFinalKineticEnergy(kinetic_energy);
+    } else {
+        fast_step.KillPrimaryTrack();
+    }
+}
@@ -0,0 +1,87 @@
+/**
+ * @file
+ * @brief Defines a Geant4 fast simulation model for the energy loss of charged particles in the sensors
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef FastSimulationModelG4_H
+#define FastSimulationModelG4_H 1
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include <G4EmCalculator.hh>
+#include <G4Region.hh>
+#include <G4VFastSimulationModel.hh>
+
+#include "SensitiveDetectorActionG4.hpp"
+
+namespace allpix {
+    /**
+     * @brief Fast simulation model replacing the stepping of charged particles through a sensor by a parameterisation
+     *
+     * Particles are moved along a straight line through the sensor in segments of fixed length. The restricted energy loss
+     * of every segment is sampled from a Landau distribution around the mean restricted energy loss obtained from Geant4,
+     * and deposited in the sensor via its \ref SensitiveDetectorActionG4. Delta electrons with a kinetic energy above the
+     * threshold of the restricted energy loss are sampled from the Rutherford cross section and handed back to Geant4 as
+     * secondary tracks.
+     */
+    class FastSimulationModelG4 : public G4VFastSimulationModel {
+    public:
+        /**
+         * @brief Construct the model and attach it to the region of a sensor
+         * @param name Name of the model
+         * @param region Region of the sensor
+         * @param sensor Sensitive detector action of the sensor
+         * @param particles Names of the particles to which the model is applied
+         * @param segment_length Length of the segments of the path through the sensor
+         * @param delta_threshold Kinetic energy threshold above which delta electrons are produced as secondary tracks
+         * @param max_energy_loss Maximum fraction of its kinetic energy a particle is expected to lose in the sensor
+         */
+        FastSimulationModelG4(const std::string& name,
+                              G4Region* region,
+                              SensitiveDetectorActionG4* sensor,
+                              const std::vector<std::string>& particles,
+                              double segment_length,
+                              double delta_threshold,
+                              double max_energy_loss);
+
+        /**
+         * @brief Check if the model applies to a type of particle
+         * @param particle Definition of the particle
+         * @return True if the particle is in the list of configured particles
+         */
+        G4bool IsApplicable(const G4ParticleDefinition& particle) override;
+
+        /**
+         * @brief Check if the model should take over a track
+         * @param fast_track Track in the sensor
+         * @return True unless the track is leaving the sensor or expected to lose a large fraction of its energy
+         */
+        G4bool ModelTrigger(const G4FastTrack& fast_track) override;
+
+        /**
+         * @brief Move a track through the sensor, depositing its energy loss and creating delta electrons
+         * @param fast_track Track in the sensor
+         * @param fast_step Final state of the track and its secondaries
+         */
+        void DoIt(const G4FastTrack& fast_track, G4FastStep& fast_step) override;
+
+    private:
+        SensitiveDetectorActionG4* sensor_;
+        std::set<std::string> particles_;
+        double segment_length_;
+        double delta_threshold_;
+        double max_energy_loss_;
+
+        G4EmCalculator em_calculator_;
+    };
+} // namespace allpix
+
+#endif /* FastSimulationModelG4_H */
@@ -11,6 +11,7 @@
  */
 
 #include "GeneratorActionG4.hpp"
+#include "DepositionGeant4Module.hpp"
 
 #include <limits>
 #include <memory>
@@ -20,6 +21,8 @@
 #include <G4IonTable.hh>
 #include <G4ParticleDefinition.hh>
 #include <G4ParticleTable.hh>
+#include <G4PrimaryParticle.hh>
+#include <G4PrimaryVertex.hh>
 #include <G4RunManager.hh>
 #include <G4UImanager.hh>
 #include <core/module/exceptions.h>
@@ -85,7 +88,8 @@ std::map<std::string, std::tuple<int, int, int, double>> GeneratorActionG4::isot
 };
 
 GeneratorActionG4::GeneratorActionG4(const Configuration& config)
-    : particle_source_(std::make_unique<G4GeneralParticleSource>()), config_(config) {
+    : particle_source_(std::make_unique<G4GeneralParticleSource>()),
+      primary_culling_(DepositionGeant4Module::primary_culling_), config_(config) {
 
     // Set verbosity of source to off
     particle_source_->SetVerbosity(0);
@@ -303,9 +307,44 @@ void GeneratorActionG4::GeneratePrimaries(G4Event* event) {
         }
     }
 
+    if(primary_culling_ != nullptr) {
+        generate_culled(event);
+        return;
+    }
+
     particle_source_->GeneratePrimaryVertex(event);
 }
 
+void GeneratorActionG4::generate_culled(G4Event* event) {
+    // The particle source samples the primaries while generating the vertices, generate them into a scratch event first
+    G4Event candidates;
+    particle_source_->GeneratePrimaryVertex(&candidates);
+
+    for(G4int i = 0; i < candidates.GetNumberOfPrimaryVertex(); ++i) {
+        auto* vertex = candidates.GetPrimaryVertex(i);
+        auto position = ROOT::Math::XYZPoint(vertex->GetX0(), vertex->GetY0(), vertex->GetZ0());
+
+        // Keep the full vertex if any of its particles can reach a sensor
+        bool reaches_sensor = false;
+        for(auto* particle = vertex->GetPrimary(); particle != nullptr; particle = particle->GetNext()) {
+            auto momentum = particle->GetMomentumDirection();
+            auto direction = ROOT::Math::XYZVector(momentum.x(), momentum.y(), momentum.z());
+            reaches_sensor |= primary_culling_->reachesSensor(position, direction);
+        }
+        if(!reaches_sensor) {
+            LOG(DEBUG) << "Culling primary vertex at " << Units::display(position, {"mm", "cm"})
+                       << ", no particle can reach any sensor";
+            continue;
+        }
+
+        // Copy the vertex, the copy of the first particle includes all following particles of the vertex
+        auto* accepted = new G4PrimaryVertex(vertex->GetPosition(), vertex->GetT0());
+        accepted->SetWeight(vertex->GetWeight());
+        accepted->SetPrimary(new G4PrimaryParticle(*vertex->GetPrimary()));
+        event->AddPrimaryVertex(accepted);
+    }
+}
+
 GeneratorActionInitializationMaster::GeneratorActionInitializationMaster(const Configuration& config)
     : particle_source_(std::make_unique<G4GeneralParticleSource>()) {
 
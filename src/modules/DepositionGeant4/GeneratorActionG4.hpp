@@ -21,6 +21,7 @@
 #include <G4TwoVector.hh>
 #include <G4VUserPrimaryGeneratorAction.hh>
 
+#include "PrimaryCulling.hpp"
 #include "core/config/Configuration.hpp"
 
 namespace allpix {
@@ -52,7 +53,14 @@ namespace allpix {
         void GeneratePrimaries(G4Event*) override;
 
     private:
+        /**
+         * @brief Generate the primary vertices and only pass on those with particles reaching any sensor
+         * @param event Geant4 event to add the primary vertices to
+         */
+        void generate_culled(G4Event* event);
+
         std::unique_ptr<G4GeneralParticleSource> particle_source_;
+        std::shared_ptr<const PrimaryCulling> primary_culling_;
 
         static std::map<std::string, std::tuple<int, int, int, double>> isotopes_;
 
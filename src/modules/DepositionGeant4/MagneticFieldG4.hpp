@@ -0,0 +1,51 @@
+/**
+ * @file
+ * @brief Defines the Geant4 magnetic field following the field of the geometry manager
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_SIMPLE_DEPOSITION_MODULE_MAGNETIC_FIELD_H
+#define ALLPIX_SIMPLE_DEPOSITION_MODULE_MAGNETIC_FIELD_H
+
+#include <G4MagneticField.hh>
+
+#include "core/geometry/GeometryManager.hpp"
+
+namespace allpix {
+    /**
+     * @brief Magnetic field for the Geant4 tracking, evaluating the magnetic field function of the geometry manager
+     *
+     * Used for all non-uniform magnetic fields such as field maps. The field is evaluated directly in global coordinates,
+     * which coincide with the Geant4 world coordinates, and in the internal units shared by the framework and Geant4.
+     */
+    class MagneticFieldG4 : public G4MagneticField {
+    public:
+        /**
+         * @brief Construct the field
+         * @param geo_manager Geometry manager providing the magnetic field
+         */
+        explicit MagneticFieldG4(const GeometryManager* geo_manager) : geo_manager_(geo_manager) {}
+
+        /**
+         * @brief Get the magnetic field at a position
+         * @param point Position and time of the point to evaluate the field at
+         * @param field Output array for the three components of the magnetic field
+         */
+        void GetFieldValue(const G4double point[4], G4double* field) const override {
+            auto b_field = geo_manager_->getMagneticField(ROOT::Math::XYZPoint(point[0], point[1], point[2]));
+            field[0] = b_field.x();
+            field[1] = b_field.y();
+            field[2] = b_field.z();
+        }
+
+    private:
+        const GeometryManager* geo_manager_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_SIMPLE_DEPOSITION_MODULE_MAGNETIC_FIELD_H */
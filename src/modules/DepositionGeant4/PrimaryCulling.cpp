@@ -0,0 +1,48 @@
+/**
+ * @file
+ * @brief Implements the geometric pre-selection of primary particles
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "PrimaryCulling.hpp"
+
+#include <Math/Translation3D.h>
+
+#include "tools/liang_barsky.h"
+
+using namespace allpix;
+
+PrimaryCulling::PrimaryCulling(const std::vector<std::shared_ptr<Detector>>& detectors, double margin) {
+    for(const auto& detector : detectors) {
+        auto model = detector->getModel();
+
+        // Place the origin of the box frame at the sensor center, with the axes along the local detector axes
+        auto sensor_center = detector->getGlobalPosition(model->getSensorCenter());
+        ROOT::Math::Transform3D box_to_global(ROOT::Math::Rotation3D(detector->getOrientation()),
+                                              ROOT::Math::Translation3D(static_cast<ROOT::Math::XYZVector>(sensor_center)));
+
+        auto size = model->getSensorSize() + 2 * margin * ROOT::Math::XYZVector(1, 1, 1);
+        sensor_boxes_.push_back({box_to_global.Inverse(), size});
+    }
+}
+
+bool PrimaryCulling::reachesSensor(const ROOT::Math::XYZPoint& position, const ROOT::Math::XYZVector& direction) const {
+    checked_primaries_++;
+
+    for(const auto& box : sensor_boxes_) {
+        // The box is reached if the far intersection lies ahead of the starting position
+        auto intersection =
+            LiangBarsky::intersectionDistances(box.global_to_box(direction), box.global_to_box(position), box.size);
+        if(intersection.has_value() && intersection->second >= 0) {
+            return true;
+        }
+    }
+
+    culled_primaries_++;
+    return false;
+}
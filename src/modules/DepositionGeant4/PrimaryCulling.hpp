@@ -0,0 +1,80 @@
+/**
+ * @file
+ * @brief Defines the geometric pre-selection of primary particles
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_SIMPLE_DEPOSITION_MODULE_PRIMARY_CULLING_H
+#define ALLPIX_SIMPLE_DEPOSITION_MODULE_PRIMARY_CULLING_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <Math/Point3D.h>
+#include <Math/Transform3D.h>
+#include <Math/Vector3D.h>
+
+#include "core/geometry/Detector.hpp"
+
+namespace allpix {
+    /**
+     * @brief Geometric pre-selection of primary particles which can reach any sensor
+     *
+     * The primary particles are extrapolated along straight lines from their starting position and checked for an
+     * intersection with the sensor boxes of all detectors. The boxes are enlarged by a safety margin on all sides to account
+     * for multiple scattering along the way. Primaries missing all enlarged sensors are not passed on to Geant4 and are not
+     * tracked through the setup.
+     */
+    class PrimaryCulling {
+    public:
+        /**
+         * @brief Construct the pre-selection from the sensors of the given detectors
+         * @param detectors Detectors of the setup
+         * @param margin Safety margin added to all sides of the sensor boxes
+         */
+        PrimaryCulling(const std::vector<std::shared_ptr<Detector>>& detectors, double margin);
+
+        /**
+         * @brief Check if a primary particle can reach any sensor on a straight line
+         * @param position Starting position of the particle in global coordinates
+         * @param direction Direction of the momentum of the particle in global coordinates
+         * @return True if the extrapolated track intersects any of the enlarged sensor boxes
+         */
+        bool reachesSensor(const ROOT::Math::XYZPoint& position, const ROOT::Math::XYZVector& direction) const;
+
+        /**
+         * @brief Get the number of primary particles checked so far
+         * @return Number of checked primaries
+         */
+        uint64_t getCheckedPrimaries() const { return checked_primaries_; }
+
+        /**
+         * @brief Get the number of primary particles culled so far
+         * @return Number of primaries not reaching any sensor
+         */
+        uint64_t getCulledPrimaries() const { return culled_primaries_; }
+
+    private:
+        /**
+         * @brief Enlarged sensor box of a detector
+         */
+        struct SensorBox {
+            ROOT::Math::Transform3D global_to_box; ///< Transformation from global coordinates to the center of the box
+            ROOT::Math::XYZVector size;            ///< Size of the box including the margin
+        };
+        std::vector<SensorBox> sensor_boxes_;
+
+        // Statistics shared between all threads
+        mutable std::atomic<uint64_t> checked_primaries_{0};
+        mutable std::atomic<uint64_t> culled_primaries_{0};
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_SIMPLE_DEPOSITION_MODULE_PRIMARY_CULLING_H */
@@ -0,0 +1,83 @@
+/**
+ * @file
+ * @brief Implements the range-based removal of secondary particles which cannot reach any sensor
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "SecondaryCulling.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include <G4LossTableManager.hh>
+#include <G4VPhysicalVolume.hh>
+
+#include <Math/Translation3D.h>
+
+using namespace allpix;
+
+SecondaryCulling::SecondaryCulling(const std::vector<std::shared_ptr<Detector>>& detectors,
+                                   double range_factor,
+                                   std::map<const G4LogicalVolume*, double> volume_range_factors)
+    : range_factor_(range_factor), volume_range_factors_(std::move(volume_range_factors)) {
+    for(const auto& detector : detectors) {
+        auto model = detector->getModel();
+
+        // Place the origin of the box frame at the sensor center, with the axes along the local detector axes
+        auto sensor_center = detector->getGlobalPosition(model->getSensorCenter());
+        ROOT::Math::Transform3D box_to_global(ROOT::Math::Rotation3D(detector->getOrientation()),
+                                              ROOT::Math::Translation3D(static_cast<ROOT::Math::XYZVector>(sensor_center)));
+        sensor_boxes_.push_back({box_to_global.Inverse(), model->getSensorSize() / 2.});
+    }
+}
+
+bool SecondaryCulling::reachesSensor(const G4Track* track) const {
+    // Neutral particles are not described by a range and are always kept
+    const auto* volume = track->GetVolume();
+    if(track->GetDefinition()->GetPDGCharge() == 0 || volume == nullptr) {
+        return true;
+    }
+
+    auto range_factor = range_factor_;
+    const auto* logical_volume = volume->GetLogicalVolume();
+    auto volume_factor = volume_range_factors_.find(logical_volume);
+    if(volume_factor != volume_range_factors_.end()) {
+        range_factor = volume_factor->second;
+    }
+    if(range_factor == 0) {
+        return true;
+    }
+
+    checked_secondaries_++;
+
+    // The restricted range from the tables overestimates the continuous slowing down range and is thus conservative
+    const auto& start = track->GetPosition();
+    auto distance = distance_to_sensor(ROOT::Math::XYZPoint(start.x(), start.y(), start.z()));
+    auto range = G4LossTableManager::Instance()->GetRange(
+        track->GetDefinition(), track->GetKineticEnergy(), logical_volume->GetMaterialCutsCouple());
+    if(range_factor * range >= distance) {
+        return true;
+    }
+
+    culled_secondaries_++;
+    return false;
+}
+
+double SecondaryCulling::distance_to_sensor(const ROOT::Math::XYZPoint& position) const {
+    auto min_distance = std::numeric_limits<double>::max();
+    for(const auto& box : sensor_boxes_) {
+        auto local = box.global_to_box(position);
+        auto dx = std::max(std::fabs(local.x()) - box.half_size.x(), 0.);
+        auto dy = std::max(std::fabs(local.y()) - box.half_size.y(), 0.);
+        auto dz = std::max(std::fabs(local.z()) - box.half_size.z(), 0.);
+        min_distance = std::min(min_distance, std::sqrt(dx * dx + dy * dy + dz * dz));
+    }
+    return min_distance;
+}
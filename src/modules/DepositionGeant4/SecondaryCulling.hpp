@@ -0,0 +1,96 @@
+/**
+ * @file
+ * @brief Defines the range-based removal of secondary particles which cannot reach any sensor
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_SIMPLE_DEPOSITION_MODULE_SECONDARY_CULLING_H
+#define ALLPIX_SIMPLE_DEPOSITION_MODULE_SECONDARY_CULLING_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <G4LogicalVolume.hh>
+#include <G4Track.hh>
+
+#include <Math/Point3D.h>
+#include <Math/Transform3D.h>
+#include <Math/Vector3D.h>
+
+#include "core/geometry/Detector.hpp"
+
+namespace allpix {
+    /**
+     * @brief Removal of charged secondary particles whose range is too short to reach any sensor
+     *
+     * The range of a new charged secondary is taken from the energy loss tables of the material it has been created in and
+     * compared to the straight distance from its starting point to the closest sensor box. The range is multiplied by a
+     * safety factor, configurable per volume, to account for less dense material along the way. Secondaries created inside
+     * a sensor are always kept.
+     */
+    class SecondaryCulling {
+    public:
+        /**
+         * @brief Construct the removal of secondaries from the sensors of the given detectors
+         * @param detectors Detectors of the setup
+         * @param range_factor Safety factor applied to the range of secondaries in all volumes without a dedicated setting
+         * @param volume_range_factors Safety factors for individual logical volumes, a factor of zero keeps all secondaries
+         */
+        SecondaryCulling(const std::vector<std::shared_ptr<Detector>>& detectors,
+                         double range_factor,
+                         std::map<const G4LogicalVolume*, double> volume_range_factors);
+
+        /**
+         * @brief Check if a new secondary particle can reach any sensor
+         * @param track The new track of the secondary particle
+         * @return True if the particle is neutral or if its scaled range exceeds the distance to the closest sensor
+         */
+        bool reachesSensor(const G4Track* track) const;
+
+        /**
+         * @brief Get the number of secondary particles checked so far
+         * @return Number of checked secondaries
+         */
+        uint64_t getCheckedSecondaries() const { return checked_secondaries_; }
+
+        /**
+         * @brief Get the number of secondary particles culled so far
+         * @return Number of secondaries not reaching any sensor
+         */
+        uint64_t getCulledSecondaries() const { return culled_secondaries_; }
+
+    private:
+        /**
+         * @brief Calculate the distance from a point to the closest sensor box
+         * @param position Point in global coordinates
+         * @return Distance to the surface of the closest sensor, zero for points inside a sensor
+         */
+        double distance_to_sensor(const ROOT::Math::XYZPoint& position) const;
+
+        /**
+         * @brief Sensor box of a detector
+         */
+        struct SensorBox {
+            ROOT::Math::Transform3D global_to_box; ///< Transformation from global coordinates to the center of the box
+            ROOT::Math::XYZVector half_size;       ///< Half of the size of the box
+        };
+        std::vector<SensorBox> sensor_boxes_;
+
+        double range_factor_;
+        std::map<const G4LogicalVolume*, double> volume_range_factors_;
+
+        // Statistics shared between all threads
+        mutable std::atomic<uint64_t> checked_secondaries_{0};
+        mutable std::atomic<uint64_t> culled_secondaries_{0};
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_SIMPLE_DEPOSITION_MODULE_SECONDARY_CULLING_H */
@@ -13,7 +13,10 @@
 #include "SensitiveDetectorActionG4.hpp"
 #include "TrackInfoG4.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <memory>
+#include <utility>
 
 #include "G4DecayTable.hh"
 #include "G4HCofThisEvent.hh"
@@ -40,10 +43,12 @@ SensitiveDetectorActionG4::SensitiveDetectorActionG4(const std::shared_ptr<Detec
                                                      TrackInfoManager* track_info_manager,
                                                      double charge_creation_energy,
                                                      double fano_factor,
-                                                     double cutoff_time)
+                                                     double cutoff_time,
+                                                     double merge_distance,
+                                                     double merge_time)
     : G4VSensitiveDetector("SensitiveDetector_" + detector->getName()), detector_(detector),
       track_info_manager_(track_info_manager), charge_creation_energy_(charge_creation_energy), fano_factor_(fano_factor),
-      cutoff_time_(cutoff_time) {
+      cutoff_time_(cutoff_time), merge_distance_(merge_distance), merge_time_(merge_time) {
 
     // Add the sensor to the internal sensitive detector manager
     G4SDManager* sd_man_g4 = G4SDManager::GetSDMpointer();
@@ -57,8 +62,6 @@ G4bool SensitiveDetectorActionG4::ProcessHits(G4Step* step, G4TouchableHistory*)
     G4StepPoint* postStep = step->GetPostStepPoint();
     LOG(TRACE) << "Distance of this step: " << (postStep->GetPosition() - preStep->GetPosition()).mag();
 
-    // Get Transportaion Matrix
-    G4TouchableHandle theTouchable = step->GetPreStepPoint()->GetTouchableHandle();
     auto* track = step->GetTrack();
 
     // Put the charge deposit in the middle of the step unless it is a photon:
@@ -68,6 +71,15 @@ G4bool SensitiveDetectorActionG4::ProcessHits(G4Step* step, G4TouchableHistory*)
     G4ThreeVector step_pos = is_photon ? postStep->GetPosition() : (preStep->GetPosition() + postStep->GetPosition()) / 2;
     double step_time = is_photon ? postStep->GetGlobalTime() : (preStep->GetGlobalTime() + postStep->GetGlobalTime()) / 2;
 
+    return processDeposit(track, preStep->GetPosition(), postStep->GetPosition(), step_pos, step_time, edep);
+}
+
+bool SensitiveDetectorActionG4::processDeposit(const G4Track* track,
+                                               const G4ThreeVector& begin,
+                                               const G4ThreeVector& end,
+                                               const G4ThreeVector& step_pos,
+                                               double step_time,
+                                               double edep) {
     // If this arrives very late, skip MCParticle and DepositedCharge creation:
     if(step_time > cutoff_time_) {
         return false;
@@ -91,31 +103,60 @@ G4bool SensitiveDetectorActionG4::ProcessHits(G4Step* step, G4TouchableHistory*)
     // If this track originates in the sensor add parent ID. Otherwise set the ID to zero (primary particle) since it might
     // have a parent connected from a previous crossing of the sensor, i.e. backscattering from an interaction in non-sensor
     // material. While these particles are connected via MCTracks, we treat them as primaries to the sensor since they
-    // entered from the outside and were not created in the sensor volume.
-    auto parentTrackID =
-        (track->GetVolume()->GetLogicalVolume() == track->GetLogicalVolumeAtVertex() ? userTrackInfo->getParentID() : 0);
+    // entered from the outside and were not created in the sensor volume. If the volume is shared with other detectors, the
+    // vertex has to be within the sensor of this detector.
+    auto created_in_sensor = (track->GetVolume()->GetLogicalVolume() == track->GetLogicalVolumeAtVertex());
+    if(created_in_sensor && shared_volume_) {
+        auto vertex = detector_->getLocalPosition(static_cast<ROOT::Math::XYZPoint>(track->GetVertexPosition()));
+        created_in_sensor = detector_->getModel()->isWithinSensor(vertex);
+    }
+    auto parentTrackID = (created_in_sensor ? userTrackInfo->getParentID() : 0);
 
     // Save begin point when track is seen for the first time
-    if(track_begin_.find(trackID) == track_begin_.end()) {
-        track_info_manager_->setTrackInfoToBeStored(trackID);
-        auto start_position = detector_->getLocalPosition(static_cast<ROOT::Math::XYZPoint>(preStep->GetPosition()));
-        track_begin_.emplace(trackID, start_position);
-        track_parents_.emplace(trackID, parentTrackID);
-        track_time_.emplace(trackID, step_time);
-        track_pdg_.emplace(trackID, track->GetDynamicParticle()->GetPDGcode());
-        track_total_energy_start_.emplace(trackID, track->GetTotalEnergy());
-        track_kinetic_energy_start_.emplace(trackID, track->GetKineticEnergy());
+    auto track_index = static_cast<size_t>(trackID);
+    if(track_index >= track_index_.size()) {
+        track_index_.resize(track_index + 1, no_track);
     }
+    if(track_index_[track_index] == no_track) {
+        track_index_[track_index] = tracks_.size();
+        auto& record = tracks_.emplace_back();
+        record.id = trackID;
+        record.parent_id = parentTrackID;
+        record.begin = detector_->getLocalPosition(static_cast<ROOT::Math::XYZPoint>(begin));
+        record.pdg_code = track->GetDynamicParticle()->GetPDGcode();
+        record.time = step_time;
+        record.total_energy_start = track->GetTotalEnergy();
+        record.kinetic_energy_start = track->GetKineticEnergy();
+    }
+    track_info_manager_->setTrackInfoToBeStored(trackID, charge > 0);
 
     // Update current end point with the current last step
-    track_end_[trackID] = detector_->getLocalPosition(static_cast<ROOT::Math::XYZPoint>(postStep->GetPosition()));
-    track_charge_[trackID] += charge;
+    auto& record = tracks_[track_index_[track_index]];
+    record.end = detector_->getLocalPosition(static_cast<ROOT::Math::XYZPoint>(end));
+    record.charge += charge;
 
     // Add new deposit if the charge is more than zero
     if(charge == 0) {
         return false;
     }
 
+    // Merge the deposit into the previous deposit of the same track if all merged steps are within the tolerances. The
+    // position and time of the merged deposit are weighted by the charge of the steps.
+    if(merge_distance_ > 0 && !deposit_to_id_.empty() && deposit_to_id_.back() == trackID &&
+       (deposit_position - merge_start_position_).Mag2() <= merge_distance_ * merge_distance_ &&
+       std::fabs(step_time - merge_start_time_) <= merge_time_) {
+        auto total_charge = deposit_charge_.back() + charge;
+        auto weight = static_cast<double>(charge) / static_cast<double>(total_charge);
+        deposit_position_.back() += (deposit_position - deposit_position_.back()) * weight;
+        deposit_time_.back() += (step_time - deposit_time_.back()) * weight;
+        deposit_charge_.back() = total_charge;
+        deposit_energy_.back() += edep;
+        merged_steps_++;
+        return true;
+    }
+    merge_start_position_ = deposit_position;
+    merge_start_time_ = step_time;
+
     // Store relevant quantities to create charge deposits:
     deposit_position_.push_back(deposit_position);
     deposit_charge_.push_back(charge);
@@ -139,14 +180,8 @@ double SensitiveDetectorActionG4::getDepositedEnergy() const { return deposited_
 void SensitiveDetectorActionG4::clearEventInfo() {
     LOG(DEBUG) << "Clearing track and deposit vectors";
 
-    track_parents_.clear();
-    track_begin_.clear();
-    track_end_.clear();
-    track_pdg_.clear();
-    track_time_.clear();
-    track_charge_.clear();
-    track_total_energy_start_.clear();
-    track_kinetic_energy_start_.clear();
+    tracks_.clear();
+    track_index_.clear();
 
     deposit_position_.clear();
     deposit_charge_.clear();
@@ -154,57 +189,90 @@ void SensitiveDetectorActionG4::clearEventInfo() {
     deposit_time_.clear();
 
     deposit_to_id_.clear();
-    id_to_particle_.clear();
+    merged_steps_ = 0;
+}
+
+SensitiveDetectorActionG4::EventInfo SensitiveDetectorActionG4::releaseEventInfo() {
+    EventInfo info;
+    info.tracks = std::move(tracks_);
+    info.deposit_position = std::move(deposit_position_);
+    info.deposit_charge = std::move(deposit_charge_);
+    info.deposit_energy = std::move(deposit_energy_);
+    info.deposit_time = std::move(deposit_time_);
+    info.deposit_to_id = std::move(deposit_to_id_);
+    info.merged_steps = merged_steps_;
+
+    clearEventInfo();
+    return info;
+}
+
+void SensitiveDetectorActionG4::mergeEventInfo(EventInfo info, int offset, const std::vector<SubEventTrack>& primaries) {
+    for(auto& record : info.tracks) {
+        record.id = sub_event_track_id(record.id, offset, primaries);
+        record.parent_id = sub_event_track_id(record.parent_id, offset, primaries);
+
+        auto track_index = static_cast<size_t>(record.id);
+        if(track_index >= track_index_.size()) {
+            track_index_.resize(track_index + 1, no_track);
+        }
+        track_index_[track_index] = tracks_.size();
+        tracks_.push_back(record);
+    }
+
+    for(auto& track_id : info.deposit_to_id) {
+        track_id = sub_event_track_id(track_id, offset, primaries);
+    }
+    deposit_position_.insert(deposit_position_.end(), info.deposit_position.begin(), info.deposit_position.end());
+    deposit_charge_.insert(deposit_charge_.end(), info.deposit_charge.begin(), info.deposit_charge.end());
+    deposit_energy_.insert(deposit_energy_.end(), info.deposit_energy.begin(), info.deposit_energy.end());
+    deposit_time_.insert(deposit_time_.end(), info.deposit_time.begin(), info.deposit_time.end());
+    deposit_to_id_.insert(deposit_to_id_.end(), info.deposit_to_id.begin(), info.deposit_to_id.end());
+    merged_steps_ += info.merged_steps;
 }
 
 void SensitiveDetectorActionG4::dispatchMessages(Module* module, Messenger* messenger, Event* event) {
 
-    auto time_reference = std::min_element(track_time_.begin(), track_time_.end(), [](const auto& l, const auto& r) {
-                              return l.second < r.second;
-                          })->second;
+    auto time_reference = std::min_element(tracks_.begin(), tracks_.end(), [](const auto& l, const auto& r) {
+                              return l.time < r.time;
+                          })->time;
     LOG(TRACE) << "Earliest MCParticle arrived at " << Units::display(time_reference, {"ns", "ps"}) << " global";
 
+    // Order the tracks by their id and point the track ids to the index of their mc particle
+    std::sort(tracks_.begin(), tracks_.end(), [](const auto& l, const auto& r) { return l.id < r.id; });
+    for(size_t i = 0; i < tracks_.size(); ++i) {
+        track_index_[static_cast<size_t>(tracks_[i].id)] = i;
+    }
+
     // Create the mc particles
     std::vector<MCParticle> mc_particles;
-    for(auto& track_id_point : track_begin_) {
-        auto track_id = track_id_point.first;
-        auto local_begin = track_id_point.second;
-
-        ROOT::Math::XYZPoint end_point;
-        auto local_end = track_end_.at(track_id);
-        auto pdg_code = track_pdg_.at(track_id);
-        auto charge = track_charge_.at(track_id);
-        auto track_time_global = track_time_.at(track_id);
-        auto track_time_local = track_time_global - time_reference;
-
-        auto global_begin = detector_->getGlobalPosition(local_begin);
-        auto global_end = detector_->getGlobalPosition(local_end);
+    mc_particles.reserve(tracks_.size());
+    for(const auto& record : tracks_) {
+        auto track_time_local = record.time - time_reference;
+
+        auto global_begin = detector_->getGlobalPosition(record.begin);
+        auto global_end = detector_->getGlobalPosition(record.end);
         mc_particles.emplace_back(
-            local_begin, global_begin, local_end, global_end, pdg_code, track_time_local, track_time_global);
+            record.begin, global_begin, record.end, global_end, record.pdg_code, track_time_local, record.time);
         // Count electrons and holes:
-        mc_particles.back().setTotalDepositedCharge(2 * charge);
-        mc_particles.back().setTrack(track_info_manager_->findMCTrack(track_id));
-        mc_particles.back().setTotalEnergyStart(track_total_energy_start_.at(track_id));
-        mc_particles.back().setKineticEnergyStart(track_kinetic_energy_start_.at(track_id));
-        id_to_particle_[track_id] = mc_particles.size() - 1;
-
-        LOG(DEBUG) << "Found MC particle " << pdg_code << " crossing detector " << detector_->getName() << " from "
-                   << Units::display(local_begin, {"mm", "um"}) << " to " << Units::display(local_end, {"mm", "um"})
-                   << " local after " << Units::display(track_time_global, {"ns", "ps"}) << " global / "
+        mc_particles.back().setTotalDepositedCharge(2 * record.charge);
+        mc_particles.back().setTrack(track_info_manager_->findMCTrack(record.id));
+        mc_particles.back().setTotalEnergyStart(record.total_energy_start);
+        mc_particles.back().setKineticEnergyStart(record.kinetic_energy_start);
+
+        LOG(DEBUG) << "Found MC particle " << record.pdg_code << " crossing detector " << detector_->getName() << " from "
+                   << Units::display(record.begin, {"mm", "um"}) << " to " << Units::display(record.end, {"mm", "um"})
+                   << " local after " << Units::display(record.time, {"ns", "ps"}) << " global / "
                    << Units::display(track_time_local, {"ns", "ps"}) << " local";
     }
 
-    for(auto& track_parent : track_parents_) {
-        auto track_id = track_parent.first;
-        auto parent_id = track_parent.second;
-        if(id_to_particle_.find(parent_id) == id_to_particle_.end()) {
+    for(size_t i = 0; i < tracks_.size(); ++i) {
+        auto parent_id = static_cast<size_t>(tracks_[i].parent_id);
+        if(parent_id >= track_index_.size() || track_index_[parent_id] == no_track) {
             // Skip tracks without direct parents with deposits
             // FIXME: Geant4 does not allow for an easy way retrieve the whole hierarchy
             continue;
         }
-        auto track_idx = id_to_particle_.at(track_id);
-        auto parent_idx = id_to_particle_.at(parent_id);
-        mc_particles.at(track_idx).setParent(&mc_particles.at(parent_idx));
+        mc_particles[i].setParent(&mc_particles[track_index_[parent_id]]);
     }
 
     // Send the mc particle information
@@ -217,9 +285,10 @@ void SensitiveDetectorActionG4::dispatchMessages(Module* module, Messenger* mess
     if(!deposit_position_.empty()) {
         // Prepare charge deposits for this event
         std::vector<DepositedCharge> deposits;
+        auto global_positions = detector_->getGlobalPositions(deposit_position_);
         for(size_t i = 0; i < deposit_position_.size(); i++) {
-            auto local_position = deposit_position_.at(i);
-            auto global_position = detector_->getGlobalPosition(local_position);
+            const auto& local_position = deposit_position_.at(i);
+            const auto& global_position = global_positions.at(i);
 
             auto global_time = deposit_time_.at(i);
             auto local_time = global_time - time_reference;
@@ -233,15 +302,29 @@ void SensitiveDetectorActionG4::dispatchMessages(Module* module, Messenger* mess
             energies += edep;
 
             // Match deposit with mc particle if possible
-            auto track_id = deposit_to_id_.at(i);
-
-            // Deposit electron
-            deposits.emplace_back(local_position, global_position, CarrierType::ELECTRON, charge, local_time, global_time);
-            deposits.back().setMCParticle(&mc_particle_message->getData().at(id_to_particle_.at(track_id)));
-
-            // Deposit hole
-            deposits.emplace_back(local_position, global_position, CarrierType::HOLE, charge, local_time, global_time);
-            deposits.back().setMCParticle(&mc_particle_message->getData().at(id_to_particle_.at(track_id)));
+            const auto* mc_particle =
+                &mc_particle_message->getData().at(track_index_[static_cast<size_t>(deposit_to_id_.at(i))]);
+
+            if(paired_deposits_) {
+                // Deposit electron-hole pairs
+                deposits.emplace_back(local_position,
+                                      global_position,
+                                      CarrierType::ELECTRON,
+                                      charge,
+                                      local_time,
+                                      global_time,
+                                      mc_particle,
+                                      true);
+            } else {
+                // Deposit electron
+                deposits.emplace_back(
+                    local_position, global_position, CarrierType::ELECTRON, charge, local_time, global_time);
+                deposits.back().setMCParticle(mc_particle);
+
+                // Deposit hole
+                deposits.emplace_back(local_position, global_position, CarrierType::HOLE, charge, local_time, global_time);
+                deposits.back().setMCParticle(mc_particle);
+            }
 
             LOG(DEBUG) << "Created deposit of " << charge << " charges at " << Units::display(global_position, {"mm", "um"})
                        << " global / " << Units::display(local_position, {"mm", "um"}) << " local in "
@@ -250,6 +333,9 @@ void SensitiveDetectorActionG4::dispatchMessages(Module* module, Messenger* mess
         }
 
         LOG(INFO) << "Deposited " << charges << " charges in sensor of detector " << detector_->getName();
+        if(merged_steps_ > 0) {
+            LOG(DEBUG) << "Merged " << merged_steps_ << " steps into " << deposit_position_.size() << " deposits";
+        }
 
         // Create a new charge deposit message
         auto deposit_message = std::make_shared<DepositedChargeMessage>(std::move(deposits), detector_);
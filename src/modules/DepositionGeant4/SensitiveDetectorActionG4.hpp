@@ -12,8 +12,12 @@
 #ifndef ALLPIX_SIMPLE_DEPOSITION_MODULE_SENSITIVE_DETECTOR_ACTION_H
 #define ALLPIX_SIMPLE_DEPOSITION_MODULE_SENSITIVE_DETECTOR_ACTION_H
 
+#include <limits>
 #include <memory>
+#include <vector>
 
+#include <G4ThreeVector.hh>
+#include <G4Track.hh>
 #include <G4VSensitiveDetector.hh>
 #include <G4WrapperProcess.hh>
 
@@ -41,12 +45,16 @@ namespace allpix {
          * @param charge_creation_energy Energy needed per deposited charge
          * @param fano_factor Fano factor for fluctuations in the energy fraction going into e/h pair creation
          * @param cutoff_time Cut-off time for the creation of secondary particles
+         * @param merge_distance Maximum distance of consecutive deposits of the same track to be merged, zero to disable
+         * @param merge_time Maximum time difference of consecutive deposits of the same track to be merged
          */
         SensitiveDetectorActionG4(const std::shared_ptr<Detector>& detector,
                                   TrackInfoManager* track_info_manager,
                                   double charge_creation_energy,
                                   double fano_factor,
-                                  double cutoff_time);
+                                  double cutoff_time,
+                                  double merge_distance = 0,
+                                  double merge_time = 0);
 
         /**
          * @brief Get total number of charges deposited in the sensitive device bound to this action
@@ -77,6 +85,25 @@ namespace allpix {
          */
         void clearEventInfo();
 
+        /**
+         * @brief Tracks and deposits recorded in a sub-event, to be merged into the event it has been split from
+         */
+        struct EventInfo;
+
+        /**
+         * @brief Hand over the tracks and deposits recorded in this event and clear them
+         * @return Recorded tracks and deposits
+         */
+        EventInfo releaseEventInfo();
+
+        /**
+         * @brief Merge the tracks and deposits of a sub-event recorded by another instance bound to the same detector
+         * @param info Recorded tracks and deposits of the sub-event
+         * @param offset Offset of the range of track ids reserved for the sub-event by the track information manager
+         * @param primaries Tracks the sub-event has been started from
+         */
+        void mergeEventInfo(EventInfo info, int offset, const std::vector<SubEventTrack>& primaries);
+
         /**
          * @brief Get the name of the sensitive device bound to this action
          */
@@ -87,6 +114,18 @@ namespace allpix {
          */
         void seed(uint64_t random_seed) { random_generator_.seed(random_seed); }
 
+        /**
+         * @brief Set if the sensor volume is shared with other detectors of the same model
+         * @param shared True if the logical volume of the sensor is placed for several detectors
+         */
+        void setSharedVolume(bool shared) { shared_volume_ = shared; }
+
+        /**
+         * @brief Set if a single deposit should be created for the electrons and holes of every step
+         * @param paired True to create deposits of electron-hole pairs, false for separate deposits per carrier type
+         */
+        void setPairedDeposits(bool paired) { paired_deposits_ = paired; }
+
         /**
          * @brief Process a single step of a particle passage through this sensor
          * @param step Information about the step
@@ -94,6 +133,23 @@ namespace allpix {
          */
         G4bool ProcessHits(G4Step* step, G4TouchableHistory* history) override;
 
+        /**
+         * @brief Process an energy deposit of a particle in this sensor, e.g. from a step or from a fast simulation model
+         * @param track Track of the particle creating the deposit
+         * @param begin Global position at which the particle entered the section of its path with the deposit
+         * @param end Global position at which the particle left the section of its path with the deposit
+         * @param step_pos Global position of the deposit
+         * @param step_time Global time of the deposit
+         * @param edep Deposited energy
+         * @return True if a deposit of charge carriers was created
+         */
+        bool processDeposit(const G4Track* track,
+                            const G4ThreeVector& begin,
+                            const G4ThreeVector& end,
+                            const G4ThreeVector& step_pos,
+                            double step_time,
+                            double edep);
+
         /**
          * @brief Send the MCParticle and DepositedCharge messages
          * @param module The module which is responsible for dispatching the message
@@ -110,6 +166,10 @@ namespace allpix {
         double charge_creation_energy_;
         double fano_factor_;
         double cutoff_time_;
+        double merge_distance_;
+        double merge_time_;
+        bool shared_volume_{};
+        bool paired_deposits_{};
 
         /**
          * Random number generator for e/h pair creation fluctuation
@@ -124,33 +184,53 @@ namespace allpix {
         double total_deposited_energy_{};
         double deposited_energy_{};
 
-        // List of positions for deposits
+        // List of positions for deposits, the capacity is kept when clearing them for the next event
         std::vector<ROOT::Math::XYZPoint> deposit_position_;
         std::vector<unsigned int> deposit_charge_;
         std::vector<double> deposit_energy_;
         std::vector<double> deposit_time_;
 
-        // List of begin points for tracks
-        std::map<int, ROOT::Math::XYZPoint> track_begin_;
-        // List of end points for tracks
-        std::map<int, ROOT::Math::XYZPoint> track_end_;
-        // Parent of all mc tracks
-        std::map<int, int> track_parents_;
-        // PDG code of the tracks
-        std::map<int, int> track_pdg_;
-        // Arrival timestamp of the tracks
-        std::map<int, double> track_time_;
-        // Total charge by track
-        std::map<int, unsigned int> track_charge_;
-        // Total energy by track at start point
-        std::map<int, double> track_total_energy_start_;
-        // Kinetic energy by track at start point
-        std::map<int, double> track_kinetic_energy_start_;
+        // Position and time of the first step merged into the last deposit
+        ROOT::Math::XYZPoint merge_start_position_;
+        double merge_start_time_{};
+        unsigned int merged_steps_{};
+
+        /**
+         * @brief Information about a track passing the sensor
+         */
+        struct TrackRecord {
+            int id{};
+            int parent_id{};
+            ROOT::Math::XYZPoint begin;
+            ROOT::Math::XYZPoint end;
+            int pdg_code{};
+            // Arrival timestamp of the track
+            double time{};
+            // Total charge deposited by the track
+            unsigned int charge{};
+            double total_energy_start{};
+            double kinetic_energy_start{};
+        };
+
+        // Records of all tracks passing the sensor in this event, sorted by track id before dispatching
+        std::vector<TrackRecord> tracks_;
+        // Index of the record for every track id, and of the mc particle after sorting
+        std::vector<size_t> track_index_;
+        static constexpr auto no_track = std::numeric_limits<size_t>::max();
 
         // Map from deposit index to track id
         std::vector<int> deposit_to_id_;
-        // Map from track id to mc particle index
-        std::map<int, size_t> id_to_particle_;
+
+    public:
+        struct EventInfo {
+            std::vector<TrackRecord> tracks;
+            std::vector<ROOT::Math::XYZPoint> deposit_position;
+            std::vector<unsigned int> deposit_charge;
+            std::vector<double> deposit_energy;
+            std::vector<double> deposit_time;
+            std::vector<int> deposit_to_id;
+            unsigned int merged_steps{};
+        };
     };
 } // namespace allpix
 
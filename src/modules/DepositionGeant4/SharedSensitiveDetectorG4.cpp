@@ -0,0 +1,39 @@
+/**
+ * @file
+ * @brief Implements the sensitive detector of sensor volumes shared by several detectors
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "SharedSensitiveDetectorG4.hpp"
+
+#include <G4SDManager.hh>
+#include <G4Step.hh>
+#include <G4VTouchable.hh>
+
+using namespace allpix;
+
+SharedSensitiveDetectorG4::SharedSensitiveDetectorG4(const std::string& name)
+    : G4VSensitiveDetector("SharedSensitiveDetector_" + name) {
+    G4SDManager::GetSDMpointer()->AddNewDetector(this);
+}
+
+void SharedSensitiveDetectorG4::addDetector(G4int copy_number, SensitiveDetectorActionG4* action) {
+    actions_[copy_number] = action;
+}
+
+G4bool SharedSensitiveDetectorG4::ProcessHits(G4Step* step, G4TouchableHistory* history) {
+    // The wrapper volumes of the detectors are placed directly in the world volume, i.e. one level below the top
+    const auto* touchable = step->GetPreStepPoint()->GetTouchable();
+    auto action = actions_.find(touchable->GetCopyNumber(touchable->GetHistoryDepth() - 1));
+
+    // Detectors without listeners for their deposits have no action
+    if(action == actions_.end()) {
+        return false;
+    }
+    return action->second->ProcessHits(step, history);
+}
@@ -0,0 +1,57 @@
+/**
+ * @file
+ * @brief Defines the sensitive detector of sensor volumes shared by several detectors
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_SIMPLE_DEPOSITION_MODULE_SHARED_SENSITIVE_DETECTOR_H
+#define ALLPIX_SIMPLE_DEPOSITION_MODULE_SHARED_SENSITIVE_DETECTOR_H
+
+#include <map>
+#include <string>
+
+#include <G4VSensitiveDetector.hh>
+
+#include "SensitiveDetectorActionG4.hpp"
+
+namespace allpix {
+    /**
+     * @brief Forwards the steps in a sensor volume shared by several detectors to the action of the detector passed
+     *
+     * Detectors of the same model can share their logical volumes, in which case Geant4 only allows a single sensitive
+     * detector for all of them. The detector a step belongs to is identified by the copy number of the placement of its
+     * wrapper volume in the world volume.
+     */
+    class SharedSensitiveDetectorG4 : public G4VSensitiveDetector {
+    public:
+        /**
+         * @brief Constructs the sensitive detector of a shared sensor volume
+         * @param name Name of the shared sensor volume
+         */
+        explicit SharedSensitiveDetectorG4(const std::string& name);
+
+        /**
+         * @brief Add the action of a detector sharing the sensor volume
+         * @param copy_number Copy number of the placement of the wrapper volume of the detector
+         * @param action Sensitive detector action of the detector
+         */
+        void addDetector(G4int copy_number, SensitiveDetectorActionG4* action);
+
+        /**
+         * @brief Forward a single step of a particle passage to the action of the detector it belongs to
+         * @param step Information about the step
+         * @param history Parameter passed on to the action
+         */
+        G4bool ProcessHits(G4Step* step, G4TouchableHistory* history) override;
+
+    private:
+        std::map<G4int, SensitiveDetectorActionG4*> actions_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_SIMPLE_DEPOSITION_MODULE_SHARED_SENSITIVE_DETECTOR_H */
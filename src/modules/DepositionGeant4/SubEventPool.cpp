@@ -0,0 +1,145 @@
+/**
+ * @file
+ * @brief Implements the pool of helper threads simulating sub-events of heavy events
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "SubEventPool.hpp"
+
+#include <utility>
+
+using namespace allpix;
+
+thread_local SubEventPool::Collector* SubEventPool::Collector::current_ = nullptr;
+
+SubEventPool::Collector::Collector(SubEventPool& pool, uint64_t event_number, uint64_t seed)
+    : pool_(pool), event_number_(event_number), seed_(seed) {
+    current_ = this;
+}
+
+SubEventPool::Collector::~Collector() {
+    if(current_ == this) {
+        current_ = nullptr;
+    }
+    wait();
+}
+
+void SubEventPool::Collector::add(SubEventTrack track) {
+    if(open_sub_event_ == nullptr) {
+        auto sub_event = std::make_unique<SubEvent>();
+        sub_event->event_number = event_number_;
+        sub_event->seed = seed_;
+        sub_event->index = sub_events_.size();
+        open_sub_event_ = sub_events_.emplace_back(std::move(sub_event)).get();
+    }
+
+    open_sub_event_->tracks.push_back(std::move(track));
+    if(open_sub_event_->tracks.size() >= pool_.sub_event_size_) {
+        submit();
+    }
+}
+
+std::vector<std::unique_ptr<SubEventPool::SubEvent>> SubEventPool::Collector::finish() {
+    current_ = nullptr;
+    if(open_sub_event_ != nullptr) {
+        submit();
+    }
+    wait();
+
+    for(const auto& sub_event : sub_events_) {
+        if(sub_event->exception) {
+            std::rethrow_exception(sub_event->exception);
+        }
+    }
+    return std::move(sub_events_);
+}
+
+void SubEventPool::Collector::submit() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++pending_;
+    }
+    {
+        std::lock_guard<std::mutex> lock(pool_.mutex_);
+        pool_.queue_.emplace(open_sub_event_, this);
+    }
+    pool_.condition_.notify_one();
+    open_sub_event_ = nullptr;
+}
+
+void SubEventPool::Collector::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]() { return pending_ == 0; });
+}
+
+SubEventPool::SubEventPool(unsigned int threads,
+                           size_t sub_event_size,
+                           std::function<void()> initialize,
+                           std::function<void(SubEvent&)> process,
+                           std::function<void()> terminate)
+    : sub_event_size_(sub_event_size), initialize_(std::move(initialize)), process_(std::move(process)),
+      terminate_(std::move(terminate)) {
+    threads_.reserve(threads);
+    for(unsigned int i = 0; i < threads; ++i) {
+        threads_.emplace_back(&SubEventPool::worker, this);
+    }
+}
+
+SubEventPool::~SubEventPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    condition_.notify_all();
+    for(auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void SubEventPool::worker() {
+    // A failed initialization is reported for every sub-event this thread receives
+    std::exception_ptr initialize_exception;
+    try {
+        initialize_();
+    } catch(...) {
+        initialize_exception = std::current_exception();
+    }
+
+    while(true) {
+        std::pair<SubEvent*, Collector*> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+            if(queue_.empty()) {
+                break;
+            }
+            task = queue_.front();
+            queue_.pop();
+        }
+
+        auto& [sub_event, collector] = task;
+        if(initialize_exception) {
+            sub_event->exception = initialize_exception;
+        } else {
+            try {
+                process_(*sub_event);
+            } catch(...) {
+                sub_event->exception = std::current_exception();
+            }
+        }
+
+        // The collector may be destroyed as soon as the last pending sub-event is reported
+        std::lock_guard<std::mutex> lock(collector->mutex_);
+        --collector->pending_;
+        collector->done_.notify_all();
+    }
+
+    if(!initialize_exception) {
+        terminate_();
+    }
+}
@@ -0,0 +1,176 @@
+/**
+ * @file
+ * @brief Defines the pool of helper threads simulating sub-events of heavy events
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_SIMPLE_DEPOSITION_MODULE_SUB_EVENT_POOL_H
+#define ALLPIX_SIMPLE_DEPOSITION_MODULE_SUB_EVENT_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "SensitiveDetectorActionG4.hpp"
+#include "SubEventStackingActionG4.hpp"
+#include "TrackInfoG4.hpp"
+
+namespace allpix {
+    /**
+     * @brief Pool of helper threads simulating sub-events split off from the events of the module workers
+     *
+     * Every helper thread acts as an independent Geant4 worker. Secondaries removed from an event by the
+     * \ref SubEventStackingActionG4 are grouped into sub-events by the \ref Collector of the event, which are simulated by
+     * the helpers while the worker continues with its event. The results of the sub-events are handed back to the worker in
+     * the order the sub-events have been created, such that they can be merged deterministically.
+     */
+    class SubEventPool {
+    public:
+        /**
+         * @brief Sub-event with its primaries and, once simulated, its results
+         */
+        struct SubEvent {
+            uint64_t event_number{};
+            uint64_t seed{};
+            // Index of the sub-event within its event, identifying its random number stream
+            uint64_t index{};
+            std::vector<SubEventTrack> tracks;
+
+            // Tracks and deposits recorded by every sensor of the helper thread
+            std::vector<SensitiveDetectorActionG4::EventInfo> sensors;
+            // Stored tracks and number of track ids assigned by the helper thread
+            std::vector<std::unique_ptr<TrackInfoG4>> track_infos;
+            int track_ids{};
+            // Exception thrown while simulating the sub-event
+            std::exception_ptr exception;
+        };
+
+        /**
+         * @brief Collects the secondaries removed from a single event into sub-events and waits for their results
+         *
+         * The collector is registered for the calling thread for its lifetime or until \ref finish is called. Its
+         * destructor waits for all sub-events submitted so far, such that it can safely go out of scope while unwinding.
+         */
+        class Collector {
+        public:
+            /**
+             * @brief Construct a collector and register it for the calling thread
+             * @param pool Pool to submit the sub-events to
+             * @param event_number Number of the event
+             * @param seed Seed from which the random number streams of all sub-events of the event are derived
+             */
+            Collector(SubEventPool& pool, uint64_t event_number, uint64_t seed);
+
+            /**
+             * @brief Unregister the collector and wait for all submitted sub-events
+             */
+            ~Collector();
+
+            /// @{
+            /**
+             * @brief The collector is referenced by the pending sub-events and cannot be copied or moved
+             */
+            Collector(const Collector&) = delete;
+            Collector& operator=(const Collector&) = delete;
+            Collector(Collector&&) = delete;
+            Collector& operator=(Collector&&) = delete;
+            /// @}
+
+            /**
+             * @brief Get the collector registered for the calling thread
+             * @return Pointer to the collector or a nullptr if none is registered
+             */
+            static Collector* current() { return current_; }
+
+            /**
+             * @brief Add a track to the current sub-event, submitting the sub-event once it is full
+             * @param track Track to add
+             */
+            void add(SubEventTrack track);
+
+            /**
+             * @brief Stop collecting, submit the last sub-event and wait for all sub-events of the event
+             * @return Simulated sub-events in the order of their creation
+             * @throws Exception thrown while simulating the first failed sub-event
+             */
+            std::vector<std::unique_ptr<SubEvent>> finish();
+
+        private:
+            friend class SubEventPool;
+
+            void submit();
+            void wait();
+
+            SubEventPool& pool_;
+            uint64_t event_number_;
+            uint64_t seed_;
+
+            std::vector<std::unique_ptr<SubEvent>> sub_events_;
+            SubEvent* open_sub_event_{nullptr};
+
+            std::mutex mutex_;
+            std::condition_variable done_;
+            size_t pending_{};
+
+            static thread_local Collector* current_;
+        };
+
+        /**
+         * @brief Start the helper threads
+         * @param threads Number of helper threads
+         * @param sub_event_size Number of tracks per sub-event
+         * @param initialize Function called by every helper thread before simulating sub-events
+         * @param process Function simulating a single sub-event on a helper thread
+         * @param terminate Function called by every helper thread before it exits
+         */
+        SubEventPool(unsigned int threads,
+                     size_t sub_event_size,
+                     std::function<void()> initialize,
+                     std::function<void(SubEvent&)> process,
+                     std::function<void()> terminate);
+
+        /**
+         * @brief Stop and join the helper threads
+         */
+        ~SubEventPool();
+
+        /// @{
+        /**
+         * @brief The pool owns its threads and cannot be copied or moved
+         */
+        SubEventPool(const SubEventPool&) = delete;
+        SubEventPool& operator=(const SubEventPool&) = delete;
+        SubEventPool(SubEventPool&&) = delete;
+        SubEventPool& operator=(SubEventPool&&) = delete;
+        /// @}
+
+    private:
+        void worker();
+
+        size_t sub_event_size_;
+        std::function<void()> initialize_;
+        std::function<void(SubEvent&)> process_;
+        std::function<void()> terminate_;
+
+        std::queue<std::pair<SubEvent*, Collector*>> queue_;
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        bool stop_{false};
+
+        std::vector<std::thread> threads_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_SIMPLE_DEPOSITION_MODULE_SUB_EVENT_POOL_H */
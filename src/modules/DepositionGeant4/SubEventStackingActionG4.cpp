@@ -0,0 +1,55 @@
+/**
+ * @file
+ * @brief Implements the stacking action splitting secondaries of heavy events into sub-events
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "SubEventStackingActionG4.hpp"
+
+#include <utility>
+
+#include <G4VProcess.hh>
+
+#include "DepositionGeant4Module.hpp"
+#include "SubEventPool.hpp"
+
+using namespace allpix;
+
+SubEventStackingActionG4::SubEventStackingActionG4(double min_energy)
+    : min_energy_(min_energy), secondary_culling_(DepositionGeant4Module::secondary_culling_) {}
+
+G4ClassificationOfNewTrack SubEventStackingActionG4::ClassifyNewTrack(const G4Track* track) {
+    if(secondary_culling_ != nullptr && track->GetParentID() != 0 && !secondary_culling_->reachesSensor(track)) {
+        return fKill;
+    }
+
+    auto* collector = SubEventPool::Collector::current();
+    if(collector == nullptr || track->GetParentID() == 0 || track->GetKineticEnergy() < min_energy_) {
+        return fUrgent;
+    }
+
+    SubEventTrack sub_event_track;
+    sub_event_track.definition = track->GetDefinition();
+    sub_event_track.position = track->GetPosition();
+    sub_event_track.direction = track->GetMomentumDirection();
+    sub_event_track.polarization = track->GetPolarization();
+    sub_event_track.kinetic_energy = track->GetKineticEnergy();
+    sub_event_track.time = track->GetGlobalTime();
+    sub_event_track.charge = track->GetDynamicParticle()->GetCharge();
+    sub_event_track.weight = track->GetWeight();
+
+    // The parent has already been tracked and holds a custom id
+    sub_event_track.parent_id = DepositionGeant4Module::track_info_manager_->getCustomID(track->GetParentID());
+    const auto* process = track->GetCreatorProcess();
+    sub_event_track.creator_process_name =
+        (process != nullptr) ? static_cast<std::string>(process->GetProcessName()) : "none";
+    sub_event_track.creator_process_type = (process != nullptr) ? process->GetProcessType() : -1;
+
+    collector->add(std::move(sub_event_track));
+    return fKill;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file
+ * @brief Defines the stacking action splitting secondaries of heavy events into sub-events
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_SIMPLE_DEPOSITION_MODULE_SUB_EVENT_STACKING_ACTION_H
+#define ALLPIX_SIMPLE_DEPOSITION_MODULE_SUB_EVENT_STACKING_ACTION_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <G4ParticleDefinition.hh>
+#include <G4ThreeVector.hh>
+#include <G4Track.hh>
+#include <G4UserStackingAction.hh>
+
+#include "SecondaryCulling.hpp"
+
+namespace allpix {
+    /**
+     * @brief Secondary particle removed from an event to be simulated as primary of a sub-event
+     */
+    struct SubEventTrack {
+        const G4ParticleDefinition* definition{};
+        G4ThreeVector position;
+        G4ThreeVector direction;
+        G4ThreeVector polarization;
+        double kinetic_energy{};
+        double time{};
+        double charge{};
+        double weight{};
+        // Custom track id of the parent in the event the track has been removed from
+        int parent_id{};
+        // Process which created the particle
+        std::string creator_process_name;
+        int creator_process_type{};
+    };
+
+    /**
+     * @brief Translate a track id of a sub-event into the id range reserved for the sub-event in its event
+     * @param id Custom track id assigned while simulating the sub-event
+     * @param offset Offset of the id range reserved for the sub-event
+     * @param primaries Tracks the sub-event has been started from
+     * @return Custom track id in the event
+     *
+     * Positive ids are shifted by the offset. Negative ids are assigned as parent ids to the primaries of a sub-event and
+     * refer to the Geant4 track id of the primary, they are replaced by the parent of the secondary the primary has been
+     * started from. Zero denotes the absence of a parent and is kept.
+     */
+    inline int sub_event_track_id(int id, int offset, const std::vector<SubEventTrack>& primaries) {
+        if(id > 0) {
+            return id + offset;
+        }
+        if(id < 0) {
+            return primaries.at(static_cast<size_t>(-id - 1)).parent_id;
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Removes energetic secondaries from the event of the calling thread and hands them to a sub-event
+     *
+     * Secondaries are only removed while a \ref SubEventPool::Collector is active on the calling thread, i.e. in the main
+     * event of a worker. All tracks of the sub-events themselves are simulated in full. If the culling of secondaries is
+     * enabled, secondaries which cannot reach any sensor are killed first, both in events and in sub-events.
+     */
+    class SubEventStackingActionG4 : public G4UserStackingAction {
+    public:
+        /**
+         * @brief Construct the stacking action
+         * @param min_energy Minimum kinetic energy of secondaries to be moved to a sub-event
+         */
+        explicit SubEventStackingActionG4(double min_energy);
+
+        /**
+         * @brief Classify a new track, killing secondaries which are culled or moved to a sub-event
+         * @param track The new track
+         * @return Classification of the track
+         */
+        G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track* track) override;
+
+    private:
+        double min_energy_;
+        std::shared_ptr<const SecondaryCulling> secondary_culling_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_SIMPLE_DEPOSITION_MODULE_SUB_EVENT_STACKING_ACTION_H */
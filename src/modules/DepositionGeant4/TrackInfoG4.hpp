@@ -14,6 +14,8 @@
 #define TrackInfoG4_H 1
 
 #include <map>
+#include <string>
+#include <utility>
 
 #include "G4Track.hh"
 #include "G4VUserTrackInformation.hh"
@@ -47,6 +49,26 @@ namespace allpix {
          */
         int getParentID() const { return parent_track_id_; }
 
+        /**
+         * @brief Move the track into the id range of the event a sub-event has been split from
+         * @param custom_track_id The custom id of this track in the event
+         * @param parent_track_id The custom id of the parent track in the event
+         */
+        void setIDs(int custom_track_id, int parent_track_id) {
+            custom_track_id_ = custom_track_id;
+            parent_track_id_ = parent_track_id;
+        }
+
+        /**
+         * @brief Set the process which created the particle, for tracks started from a secondary of another event
+         * @param name Name of the process
+         * @param type Geant4 type of the process
+         */
+        void setCreationProcess(std::string name, int type) {
+            origin_g4_process_name_ = std::move(name);
+            origin_g4_process_type_ = type;
+        }
+
         /**
          * @brief Update track info from the G4Track
          * @param aTrack A pointer to a G4Track instance which represents this track's final state
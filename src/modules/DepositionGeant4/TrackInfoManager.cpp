@@ -11,41 +11,85 @@
 
 #include "TrackInfoManager.hpp"
 
+#include <utility>
+
 using namespace allpix;
 
-TrackInfoManager::TrackInfoManager(bool record_all) : counter_(1), record_all_(record_all) {}
+TrackInfoManager::TrackInfoManager(bool record_all, bool record_deposits_only, bool sub_events)
+    : counter_(1), record_all_(record_all), record_deposits_only_(record_deposits_only), sub_events_(sub_events) {}
 
 std::unique_ptr<TrackInfoG4> TrackInfoManager::makeTrackInfo(const G4Track* const track) {
     auto custom_id = counter_++;
     auto G4ParentID = track->GetParentID();
-    auto parent_track_id = G4ParentID == 0 ? G4ParentID : g4_to_custom_id_.at(G4ParentID);
-    g4_to_custom_id_[track->GetTrackID()] = custom_id;
-    track_id_to_parent_id_[custom_id] = parent_track_id;
+    auto parent_track_id = G4ParentID == 0 ? G4ParentID : g4_to_custom_id_.at(static_cast<size_t>(G4ParentID));
+    // Primaries of a sub-event refer to their parent in the event they have been split from, see #mergeSubEvent
+    if(G4ParentID == 0 && sub_events_) {
+        parent_track_id = -track->GetTrackID();
+    }
+
+    auto g4_id = static_cast<size_t>(track->GetTrackID());
+    if(g4_id >= g4_to_custom_id_.size()) {
+        g4_to_custom_id_.resize(g4_id + 1);
+    }
+    g4_to_custom_id_[g4_id] = custom_id;
+
+    // Custom ids are assigned consecutively, such that the tables indexed by them only grow by one entry
+    track_id_to_parent_id_.resize(static_cast<size_t>(custom_id) + 1);
+    track_id_to_parent_id_[static_cast<size_t>(custom_id)] = parent_track_id;
+    to_store_track_ids_.resize(static_cast<size_t>(custom_id) + 1, false);
     return std::make_unique<TrackInfoG4>(custom_id, parent_track_id, track);
 }
 
-void TrackInfoManager::setTrackInfoToBeStored(int track_id) {
-    auto element = std::find(to_store_track_ids_.begin(), to_store_track_ids_.end(), track_id);
-    // If track id is not present we add it, otherwise skip as we only need each track once
-    if(element == to_store_track_ids_.end()) {
-        to_store_track_ids_.emplace_back(track_id);
+void TrackInfoManager::setTrackInfoToBeStored(int track_id, bool has_deposit) {
+    if(record_deposits_only_ && !has_deposit) {
+        return;
+    }
+    auto index = static_cast<size_t>(track_id);
+    if(index >= to_store_track_ids_.size()) {
+        to_store_track_ids_.resize(index + 1, false);
     }
+    to_store_track_ids_[index] = true;
 }
 
 void TrackInfoManager::storeTrackInfo(std::unique_ptr<TrackInfoG4> the_track_info) {
-    auto track_id = the_track_info->getID();
-    auto element = std::find(to_store_track_ids_.begin(), to_store_track_ids_.end(), track_id);
+    auto track_id = static_cast<size_t>(the_track_info->getID());
+    auto to_store = (track_id < to_store_track_ids_.size() && to_store_track_ids_[track_id]);
 
-    if(record_all_ || element != to_store_track_ids_.end()) {
+    if(record_all_ || to_store) {
         LOG(DEBUG) << "Storing MCTrack with ID " << track_id;
         stored_track_infos_.push_back(std::move(the_track_info));
     } else {
         LOG(DEBUG) << "Not storing MCTrack with ID " << track_id;
     }
+}
+
+std::vector<std::unique_ptr<TrackInfoG4>> TrackInfoManager::releaseTrackInfos() {
+    auto track_infos = std::move(stored_track_infos_);
+    stored_track_infos_.clear();
+    return track_infos;
+}
+
+int TrackInfoManager::mergeSubEvent(std::vector<std::unique_ptr<TrackInfoG4>> track_infos,
+                                    int track_ids,
+                                    const std::vector<SubEventTrack>& primaries) {
+    // Reserve the range of ids following the ones assigned so far
+    auto offset = counter_ - 1;
+    counter_ += track_ids;
+    track_id_to_parent_id_.resize(static_cast<size_t>(counter_), 0);
+    to_store_track_ids_.resize(static_cast<size_t>(counter_), false);
 
-    if(element != to_store_track_ids_.end()) {
-        to_store_track_ids_.erase(element);
+    for(auto& track_info : track_infos) {
+        auto parent_id = track_info->getParentID();
+        if(parent_id < 0) {
+            const auto& primary = primaries.at(static_cast<size_t>(-parent_id - 1));
+            track_info->setCreationProcess(primary.creator_process_name, primary.creator_process_type);
+        }
+        track_info->setIDs(sub_event_track_id(track_info->getID(), offset, primaries),
+                           sub_event_track_id(parent_id, offset, primaries));
+        track_id_to_parent_id_[static_cast<size_t>(track_info->getID())] = track_info->getParentID();
+        stored_track_infos_.push_back(std::move(track_info));
     }
+    return offset;
 }
 
 void TrackInfoManager::resetTrackInfoManager() {
@@ -73,13 +117,14 @@ void TrackInfoManager::dispatchMessage(Module* module, Messenger* messenger, Eve
 }
 
 MCTrack const* TrackInfoManager::findMCTrack(int track_id) const {
-    auto it = id_to_track_.find(track_id);
-    return (it == id_to_track_.end()) ? nullptr : it->second;
+    auto index = static_cast<size_t>(track_id);
+    return (track_id < 0 || index >= id_to_track_.size()) ? nullptr : id_to_track_[index];
 }
 
 void TrackInfoManager::createMCTracks() {
     // Reserve size so we don't move the vector around and change addresses:
     stored_tracks_.reserve(stored_track_infos_.size());
+    id_to_track_.assign(static_cast<size_t>(counter_), nullptr);
 
     for(auto& track_info : stored_track_infos_) {
         stored_tracks_.emplace_back(track_info->getStartPoint(),
@@ -96,7 +141,7 @@ void TrackInfoManager::createMCTracks() {
                                     track_info->getTotalEnergyInitial(),
                                     track_info->getTotalEnergyFinal());
 
-        id_to_track_[track_info->getID()] = &stored_tracks_.back();
+        id_to_track_[static_cast<size_t>(track_info->getID())] = &stored_tracks_.back();
         stored_track_ids_.emplace_back(track_info->getID());
     }
 }
@@ -104,7 +149,7 @@ void TrackInfoManager::createMCTracks() {
 void TrackInfoManager::set_all_track_parents() {
     for(size_t ix = 0; ix < stored_track_ids_.size(); ++ix) {
         auto track_id = stored_track_ids_[ix];
-        auto parent_id = track_id_to_parent_id_[track_id];
+        auto parent_id = track_id_to_parent_id_[static_cast<size_t>(track_id)];
         stored_tracks_[ix].setParent(findMCTrack(parent_id));
     }
 }
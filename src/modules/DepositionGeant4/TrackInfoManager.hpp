@@ -13,9 +13,11 @@
 #ifndef TrackInfoManager_H
 #define TrackInfoManager_H 1
 
-#include <map>
+#include <memory>
+#include <vector>
 
 #include "G4Track.hh"
+#include "SubEventStackingActionG4.hpp"
 #include "TrackInfoG4.hpp"
 
 #include "core/module/Event.hpp"
@@ -30,8 +32,12 @@ namespace allpix {
     public:
         /**
          * @brief Default constructor
+         * @param record_all Store all tracks, regardless of whether they passed any sensor
+         * @param record_deposits_only Only store tracks which created charge deposits in a sensor
+         * @param sub_events Assign the negative Geant4 track id as parent id to primaries, used for the simulation of
+         * sub-events whose primaries have a parent in another event
          */
-        explicit TrackInfoManager(bool record_all);
+        explicit TrackInfoManager(bool record_all, bool record_deposits_only = false, bool sub_events = false);
 
         /**
          * @brief Factory method for TrackInfoG4 instances
@@ -54,10 +60,12 @@ namespace allpix {
         /**
          * @brief Will register a track id to be stored
          * @param track_id The id of the track to be stored
+         * @param has_deposit Whether the track created a charge deposit, tracks without are ignored if only tracks with
+         * deposits are recorded
          *
          * The track itself will have to be provided via @see storeTrackInfo once finished
          */
-        void setTrackInfoToBeStored(int track_id);
+        void setTrackInfoToBeStored(int track_id, bool has_deposit = true);
 
         /**
          * @brief Reset of the TrackInfoManager instance
@@ -91,6 +99,40 @@ namespace allpix {
          */
         MCTrack const* findMCTrack(int track_id) const;
 
+        /**
+         * @brief Get the custom id assigned to a Geant4 track in this event
+         * @param g4_track_id Geant4 id of a track which has already been started
+         * @return Custom track id
+         */
+        int getCustomID(int g4_track_id) const { return g4_to_custom_id_.at(static_cast<size_t>(g4_track_id)); }
+
+        /**
+         * @brief Get the number of custom track ids assigned in this event
+         * @return Number of assigned ids
+         */
+        int getNumberOfTrackIDs() const { return counter_ - 1; }
+
+        /**
+         * @brief Hand over the stored TrackInfoG4 instances, e.g. to merge them into another event
+         * @return Stored TrackInfoG4 instances
+         */
+        std::vector<std::unique_ptr<TrackInfoG4>> releaseTrackInfos();
+
+        /**
+         * @brief Merge the stored tracks of a sub-event simulated by another manager into this event
+         * @param track_infos Stored TrackInfoG4 instances of the sub-event
+         * @param track_ids Number of custom track ids assigned in the sub-event
+         * @param primaries Tracks the sub-event has been started from
+         * @return Offset of the range of track ids reserved for the sub-event
+         *
+         * The tracks of the sub-event are moved into a newly reserved range of track ids following the ones already
+         * assigned, and the primaries of the sub-event are attached to the parents of the secondaries they have been started
+         * from. Must be called before \ref createMCTracks.
+         */
+        int mergeSubEvent(std::vector<std::unique_ptr<TrackInfoG4>> track_infos,
+                          int track_ids,
+                          const std::vector<SubEventTrack>& primaries);
+
     private:
         /**
          * @brief Will internally set all the parent-child relations between stored tracks
@@ -104,21 +146,24 @@ namespace allpix {
 
         // Store configuration whether all tracks or only those connected to sensor should be stored
         bool record_all_{};
+        bool record_deposits_only_{};
+        bool sub_events_{};
 
+        // The following tables are indexed by track id and reset for every event while keeping their allocated memory
         // Geant4 id to custom id translation
-        std::map<int, int> g4_to_custom_id_{};
+        std::vector<int> g4_to_custom_id_;
         // Custom id to custom parent id tracking
-        std::map<int, int> track_id_to_parent_id_{};
-        // List of track ids to be stored if they are provided via #storeTrackInfo
-        std::vector<int> to_store_track_ids_;
+        std::vector<int> track_id_to_parent_id_;
+        // Flags of the custom track ids to be stored if they are provided via #storeTrackInfo
+        std::vector<bool> to_store_track_ids_;
         // The TrackInfoG4 instances which are handed over to this track manager
         std::vector<std::unique_ptr<TrackInfoG4>> stored_track_infos_;
         // The MCTrack vector which is dispatched via #dispatchMessage
         std::vector<MCTrack> stored_tracks_;
         // Ids ins same order as tracks stored in #stored_tracks_
         std::vector<int> stored_track_ids_;
-        // Id to index in #stored_tracks_ for easier handling
-        std::map<int, MCTrack const*> id_to_track_;
+        // Custom id to track in #stored_tracks_ for easier handling
+        std::vector<MCTrack const*> id_to_track_;
     };
 } // namespace allpix
 #endif /* TrackInfoManager_H */
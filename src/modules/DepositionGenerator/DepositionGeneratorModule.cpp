@@ -36,10 +36,10 @@ DepositionGeneratorModule::DepositionGeneratorModule(Configuration& config,
     // Enable multithreading of this module if multithreading is enabled
     allow_multithreading();
 
-    // Do *not* waive sequence requirement - we're reading from file and this should happen sequentially
-    waive_sequence_requirement(false);
+    // Events are read ahead by a separate thread and assigned by event number, so no sequence requirement is needed
 
     file_model_ = config_.get<PrimariesReader::FileModel>("model");
+    config_.setDefault<uint64_t>("prefetch_events", 128);
 
     // Force source type and position:
     config_.set("source_type", "generator");
@@ -67,13 +67,21 @@ void DepositionGeneratorModule::initialize() {
         throw InvalidValueError(config_, "model", "Unsupported data file model");
     }
 
+    // Start reading events ahead, skipping the events the framework fast-forwards over
+    auto prefetch_events = config_.get<uint64_t>("prefetch_events");
+    if(prefetch_events == 0) {
+        throw InvalidValueError(config_, "prefetch_events", "number of events to read ahead has to be positive");
+    }
+    auto skip_events = getConfigManager()->getGlobalConfiguration().get<uint64_t>("skip_events", 0);
+    reader_->start_prefetching(skip_events, prefetch_events);
+
     // Call upstream initialization method
     DepositionGeant4Module::initialize();
 }
 
 void DepositionGeneratorModule::run(Event* event) {
-    // Pass current event number to the reader instance
-    reader_->set_event_num(event->number);
+    // Pass current event number to the reader instance for the calling thread
+    PrimariesReader::set_event_num(event->number);
 
     // Call upstream run method
     DepositionGeant4Module::run(event);
@@ -0,0 +1,112 @@
+/**
+ * @file
+ * @brief Implements the prefetching of primary particles common to all file readers
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "PrimariesReader.hpp"
+
+#include <utility>
+
+#include "core/module/exceptions.h"
+#include "core/utils/log.h"
+
+using namespace allpix;
+
+std::vector<PrimariesReader::Particle> PrimariesReader::getParticles() {
+    const auto event_num = eventNum();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // Allow the prefetching thread to read ahead of the latest requested event
+    if(event_num > requested_) {
+        requested_ = event_num;
+        cv_.notify_all();
+    }
+    cv_.wait(lock, [&]() { return read_done_ || read_until_ >= event_num; });
+
+    auto event = events_.find(event_num);
+    if(event != events_.end()) {
+        auto particles = std::move(event->second);
+        events_.erase(event);
+        return particles;
+    }
+
+    // If we have no more events, end this run
+    if(read_until_ < event_num) {
+        if(read_error_) {
+            std::rethrow_exception(read_error_);
+        }
+        throw EndOfRunException("Requesting end of run: end of file reached");
+    }
+
+    LOG(INFO) << "Expecting event " << (event_num - 1) << ", not found in input data, returning empty event";
+    return {};
+}
+
+void PrimariesReader::start_prefetching(uint64_t skip_events, uint64_t prefetch_events) {
+    // Generator events are assigned to the event with the following number, skipped events are never read
+    requested_ = skip_events;
+    read_until_ = skip_events;
+    prefetch_events_ = prefetch_events;
+    seek(skip_events);
+
+    prefetch_thread_ = std::thread(&PrimariesReader::prefetch, this);
+}
+
+void PrimariesReader::stop_prefetching() {
+    if(prefetch_thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        prefetch_thread_.join();
+    }
+}
+
+void PrimariesReader::prefetch() {
+    try {
+        while(true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this]() { return stop_ || read_until_ < requested_ + prefetch_events_; });
+                if(stop_) {
+                    return;
+                }
+            }
+
+            // Read the next event without holding the lock
+            std::vector<Particle> particles;
+            uint64_t event_number = 0;
+            auto found = read_event(particles, event_number);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if(!found) {
+                read_done_ = true;
+                cv_.notify_all();
+                return;
+            }
+
+            // Event numbers are expected in ascending order, drop skipped or repeated events
+            if(event_number + 1 <= read_until_) {
+                LOG(DEBUG) << "Generator event " << event_number << " too early, dropping.";
+                continue;
+            }
+            read_until_ = event_number + 1;
+            events_.emplace(read_until_, std::move(particles));
+            cv_.notify_all();
+        }
+    } catch(...) {
+        // Pass any error on to the threads requesting events
+        std::lock_guard<std::mutex> lock(mutex_);
+        read_error_ = std::current_exception();
+        read_done_ = true;
+        cv_.notify_all();
+    }
+}
@@ -12,7 +12,13 @@
 #ifndef ALLPIX_GENERATOR_DEPOSITION_MODULE_READER_H
 #define ALLPIX_GENERATOR_DEPOSITION_MODULE_READER_H
 
+#include <condition_variable>
+#include <exception>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include <G4ThreeVector.hh>
 
@@ -92,34 +98,94 @@ namespace allpix {
         };
 
         /**
-         * Default constructor and destructor
+         * Default constructor and destructor. The destructor stops the prefetching thread, derived classes have to stop it
+         * in their own destructor before releasing the input file.
          */
         PrimariesReader() = default;
-        virtual ~PrimariesReader() = default;
+        virtual ~PrimariesReader() { stop_prefetching(); }
 
+        /// @{
         /**
-         * Purely virtual method to obtain a vector of primary particles for the current event. This methods needs to be
-         * implemented by derived classes which implement a specific file format. This method normally needs to be called
-         * sequentially and is not thread-safe.
+         * @brief Copying or moving the reader is not allowed
+         */
+        PrimariesReader(const PrimariesReader&) = delete;
+        PrimariesReader& operator=(const PrimariesReader&) = delete;
+        PrimariesReader(PrimariesReader&&) = delete;
+        PrimariesReader& operator=(PrimariesReader&&) = delete;
+        /// @}
+
+        /**
+         * Method to obtain a vector of primary particles for the event currently processed by the calling thread. The
+         * particles are taken from the events read ahead by the prefetching thread and matched by event number, such that
+         * events can be requested in any order. This method is thread-safe.
          * @return Vector of primary particles
+         * @throws EndOfRunException if the end of the input data has been reached
          */
-        virtual std::vector<Particle> getParticles() = 0;
+        std::vector<Particle> getParticles();
 
         /**
-         * Get the event number of the currently processed event. This allows to cross-check with potentially available event
-         * ID information from the input data file.
+         * Get the event number of the event currently processed by the calling thread. This allows to cross-check with
+         * potentially available event ID information from the input data file.
          * @return Event number
          */
-        uint64_t eventNum() const { return event_num_; }
+        static uint64_t eventNum() { return event_num_; }
+
+    protected:
+        /**
+         * Purely virtual method to read the primary particles of the next event from the input data file. This method needs
+         * to be implemented by derived classes which implement a specific file format, it is only called from the
+         * prefetching thread.
+         * @param particles Vector to store the primary particles of the event in
+         * @param event_number Event number of the generator event read
+         * @return False if the end of the input data has been reached
+         */
+        virtual bool read_event(std::vector<Particle>& particles, uint64_t& event_number) = 0;
+
+        /**
+         * Move the reader to the first generator event with an event number not smaller than the given one. The default
+         * implementation does not move the reader, earlier events are then read and dropped by the prefetching thread.
+         */
+        virtual void seek(uint64_t) {}
+
+        /**
+         * Stop the prefetching thread if it has been started
+         */
+        void stop_prefetching();
 
     private:
         /**
-         * Helper method to set the currently processed event number from the \ref DepositionGeneratorModule::run() function.
-         * This is not thread-safe and should only be called in sequential processing mode.
+         * Helper method to set the event number processed by the calling thread from the \ref
+         * DepositionGeneratorModule::run() function.
          * @param event_num  Event number
          */
-        void set_event_num(uint64_t event_num) { event_num_ = event_num; }
-        uint64_t event_num_;
+        static void set_event_num(uint64_t event_num) { event_num_ = event_num; }
+        inline static thread_local uint64_t event_num_{};
+
+        /**
+         * Start the thread reading events ahead of their processing
+         * @param skip_events Number of events skipped at the beginning of the run
+         * @param prefetch_events Maximum number of events read ahead of the latest requested event
+         */
+        void start_prefetching(uint64_t skip_events, uint64_t prefetch_events);
+
+        /**
+         * Loop of the prefetching thread, reading events until the end of the input data or until stopped
+         */
+        void prefetch();
+
+        std::thread prefetch_thread_;
+        std::mutex mutex_;
+        std::condition_variable cv_;
+
+        // Primary particles of the events read ahead, indexed by the event number they are assigned to
+        std::map<uint64_t, std::vector<Particle>> events_;
+        // Highest event number requested so far and highest event number covered by the events read
+        uint64_t requested_{};
+        uint64_t read_until_{};
+        uint64_t prefetch_events_{};
+        bool read_done_{};
+        bool stop_{};
+        std::exception_ptr read_error_;
     };
 } // namespace allpix
 
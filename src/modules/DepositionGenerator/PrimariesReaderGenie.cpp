@@ -63,35 +63,48 @@ void PrimariesReaderGenie::check_tree_reader(const Configuration& config, std::s
     }
 }
 
-std::vector<PrimariesReader::Particle> PrimariesReaderGenie::getParticles() {
+PrimariesReaderGenie::~PrimariesReaderGenie() { stop_prefetching(); }
+
+void PrimariesReaderGenie::seek(uint64_t event_number) {
+    // Find the first entry with an event id not smaller than the requested one, only the event id branch is read
+    Long64_t first = 0;
+    auto count = tree_reader_->GetEntries(false);
+    while(count > 0) {
+        auto step = count / 2;
+        tree_reader_->SetEntry(first + step);
+        if(static_cast<uint64_t>(*event_->Get()) < event_number) {
+            first += step + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+    LOG(DEBUG) << "Moved to tree entry " << first << " for event " << event_number;
+    tree_reader_->SetEntry(first);
+}
+
+bool PrimariesReaderGenie::read_event(std::vector<Particle>& particles, uint64_t& event_number) {
 
     // Read tree status:
     auto status = tree_reader_->GetEntryStatus();
     if(status == TTreeReader::kEntryNotFound || status == TTreeReader::kEntryBeyondEnd) {
-        throw EndOfRunException("Requesting end of run: end of tree reached");
+        return false;
     } else if(status != TTreeReader::kEntryValid) {
         throw EndOfRunException("Problem reading from tree, error: " + std::to_string(static_cast<int>(status)));
     }
 
-    // Check if this is the requested event, otherwise return an empty vector
-    if(static_cast<uint64_t>(*event_->Get()) > eventNum() - 1) {
-        LOG(INFO) << "Expecting event " << (eventNum() - 1) << ", found " << static_cast<uint64_t>(*event_->Get())
-                  << ", returning empty event";
-        tree_reader_->Next();
-        return {};
-    }
-    LOG(INFO) << "Found " << px_->GetSize() << " primary particles";
+    event_number = static_cast<uint64_t>(*event_->Get());
+    LOG(DEBUG) << "Found " << px_->GetSize() << " primary particles in event " << event_number;
 
     // Ensure all arrays have the same size:
     if(pdg_code_->GetSize() != energy_->GetSize() || pdg_code_->GetSize() != px_->GetSize() ||
        pdg_code_->GetSize() != py_->GetSize() || pdg_code_->GetSize() != pz_->GetSize()) {
         LOG(WARNING) << "Found broken event in input data, array sizes do not match, skipping";
         tree_reader_->Next();
-        return {};
+        return true;
     }
 
     // Generate particles:
-    std::vector<Particle> particles;
     for(size_t i = 0; i < px_->GetSize(); i++) {
         // Filter out illegal PDG codes - they should be maximally 7-digit numbers:
         if(std::abs(pdg_code_->At(i)) > 9999999) {
@@ -103,7 +116,7 @@ std::vector<PrimariesReader::Particle> PrimariesReaderGenie::getParticles() {
         LOG(DEBUG) << "Adding particle with ID " << particles.back().pdg() << " energy " << particles.back().energy();
     }
 
-    // Return and advance to next tree entry:
+    // Advance to next tree entry:
     tree_reader_->Next();
-    return particles;
+    return true;
 }
@@ -22,7 +22,7 @@ namespace allpix {
     /**
      * @brief Reads particles from an input data file
      */
-    class PrimariesReaderGenie : public PrimariesReader {
+    class PrimariesReaderGenie final : public PrimariesReader {
     public:
         /**
          * Default constructor which opens the file and checks that all expected trees and branches are available
@@ -31,11 +31,24 @@ namespace allpix {
         explicit PrimariesReaderGenie(const Configuration& config);
 
         /**
-         * Overwritten method to obtain the primary particles for the current event. This method needs to be called
-         * sequentially and is not thread-safe.
-         * @return Vector of primary particles
+         * Destructor stopping the prefetching thread before closing the input file
          */
-        std::vector<Particle> getParticles() override;
+        ~PrimariesReaderGenie() override;
+
+    protected:
+        /**
+         * Overwritten method to read the primary particles of the next tree entry
+         * @param particles Vector to store the primary particles of the event in
+         * @param event_number Event number of the generator event read
+         * @return False if the end of the tree has been reached
+         */
+        bool read_event(std::vector<Particle>& particles, uint64_t& event_number) override;
+
+        /**
+         * Overwritten method to move to the first tree entry of the given event by bisection of the sorted event ids
+         * @param event_number Generator event number to seek to
+         */
+        void seek(uint64_t event_number) override;
 
     private:
         // Helper to create and check tree branches
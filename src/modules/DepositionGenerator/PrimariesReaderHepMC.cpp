@@ -48,29 +48,20 @@ PrimariesReaderHepMC::PrimariesReaderHepMC(const Configuration& config) {
     LOG(INFO) << "Successfully opened data file " << file_path;
 }
 
-std::vector<PrimariesReader::Particle> PrimariesReaderHepMC::getParticles() {
+PrimariesReaderHepMC::~PrimariesReaderHepMC() { stop_prefetching(); }
+
+bool PrimariesReaderHepMC::read_event(std::vector<Particle>& particles, uint64_t& event_number) {
 
     // Read event from input file
     HepMC3::GenEvent evt(HepMC3::Units::MEV, HepMC3::Units::MM);
-    LOG(DEBUG) << "Reading event " << eventNum() << " from HepMC3 file";
     reader_->read_event(evt);
 
     // If we have no more events, end this run
     if(reader_->failed()) {
-        throw EndOfRunException("Requesting end of run: end of file reached");
-    }
-
-    // Check if this is the requested event, otherwise act!
-    while(static_cast<uint64_t>(evt.event_number()) < eventNum() - 1) {
-        LOG(INFO) << "HepMC3 event " << evt.event_number() << " too early, dropping.";
-        reader_->read_event(evt);
-    }
-
-    if(static_cast<uint64_t>(evt.event_number()) > eventNum() - 1) {
-        LOG(INFO) << "Expecting event " << (eventNum() - 1) << ", found " << static_cast<uint64_t>(evt.event_number())
-                  << ", returning empty event";
-        return {};
+        return false;
     }
+    event_number = static_cast<uint64_t>(evt.event_number());
+    LOG(DEBUG) << "Read event " << event_number << " from HepMC3 file";
 
     // FIXME This prints to std::cout. We would need to pass a std::ostream as first parameter
     IFLOG(DEBUG) {
@@ -79,7 +70,6 @@ std::vector<PrimariesReader::Particle> PrimariesReaderHepMC::getParticles() {
     }
 
     // Generate particles:
-    std::vector<Particle> particles;
     for(const auto& v : evt.vertices()) {
 
         auto pos = v->position();
@@ -102,6 +92,5 @@ std::vector<PrimariesReader::Particle> PrimariesReaderHepMC::getParticles() {
         }
     }
 
-    // Return and advance to next tree entry:
-    return particles;
+    return true;
 }
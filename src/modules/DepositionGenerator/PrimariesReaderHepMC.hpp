@@ -21,7 +21,7 @@ namespace allpix {
     /**
      * @brief Reads particles from an input data file
      */
-    class PrimariesReaderHepMC : public PrimariesReader {
+    class PrimariesReaderHepMC final : public PrimariesReader {
     public:
         /**
          * Default constructor which opens the file and checks that all expected trees and branches are available
@@ -30,11 +30,18 @@ namespace allpix {
         explicit PrimariesReaderHepMC(const Configuration& config);
 
         /**
-         * Overwritten method to obtain the primary particles for the current event. This method needs to be called
-         * sequentially and is not thread-safe.
-         * @return Vector of primary particles
+         * Destructor stopping the prefetching thread before closing the input file
          */
-        std::vector<Particle> getParticles() override;
+        ~PrimariesReaderHepMC() override;
+
+    protected:
+        /**
+         * Overwritten method to read the primary particles of the next event from the input file
+         * @param particles Vector to store the primary particles of the event in
+         * @param event_number Event number of the generator event read
+         * @return False if the end of the file has been reached
+         */
+        bool read_event(std::vector<Particle>& particles, uint64_t& event_number) override;
 
     private:
         std::shared_ptr<HepMC3::Reader> reader_;
@@ -18,16 +18,28 @@
 #include <tools/liang_barsky.h>
 
 #include <Math/AxisAngle.h>
+#include <Math/QuantFuncMathCore.h>
 #include <TMath.h>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cmath>
+#include <exception>
 #include <filesystem>
 #include <fstream>
 #include <iterator>
+#include <limits>
+#include <map>
+#include <thread>
 
 using namespace allpix;
 
+namespace {
+    // Number of photons per task for intra-event parallel tracking
+    constexpr size_t photon_task_size = 4096;
+} // namespace
+
 DepositionLaserModule::DepositionLaserModule(Configuration& config, Messenger* messenger, GeometryManager* geo_manager)
     : Module(config), geo_manager_(geo_manager), messenger_(messenger) {
 
@@ -87,6 +99,10 @@ DepositionLaserModule::DepositionLaserModule(Configuration& config, Messenger* m
         LOG(DEBUG) << "Photons will be generated as " << number_of_photons_ << " groups of " << group_photons_;
     }
 
+    // Number of threads to distribute the photons of a single pulse to, disabled by default
+    config_.setDefault<unsigned int>("photon_threads", 0);
+    photon_threads_ = config_.get<unsigned int>("photon_threads");
+
     config_.setDefault<double>("pulse_duration", 0.5);
     pulse_duration_ = config_.get<double>("pulse_duration");
     LOG(DEBUG) << "Pulse duration: " << Units::display(pulse_duration_, "ns");
@@ -94,6 +110,14 @@ DepositionLaserModule::DepositionLaserModule(Configuration& config, Messenger* m
         throw InvalidValueError(config_, "pulse_duration_", "Pulse should be a positive value");
     }
 
+    // Sample the geometry and penetration depth of the photons from a Sobol sequence, indexed by event and photon number
+    config_.setDefault("sampling", SamplingMethod::PSEUDO_RANDOM);
+    sampling_ = config_.get<SamplingMethod>("sampling");
+    if(sampling_ == SamplingMethod::SOBOL) {
+        sobol_.emplace(5);
+        LOG(DEBUG) << "Sampling photons from a Sobol sequence";
+    }
+
     // Select user optics or silicon absorption lookup:
     is_user_optics_ = (config_.count({"absorption_length", "refractive_index"}) == 2);
 
@@ -149,6 +173,16 @@ DepositionLaserModule::DepositionLaserModule(Configuration& config, Messenger* m
 
     config_.setDefault<bool>("output_plots", false);
     output_plots_ = config.get<bool>("output_plots");
+
+    // Histograms are only filled per registered worker thread
+    if(photon_threads_ > 0 && output_plots_) {
+        throw InvalidCombinationError(config_,
+                                      {"photon_threads", "output_plots"},
+                                      "Intra-event parallel photon tracking cannot be used together with output plots");
+    }
+    if(photon_threads_ > 0) {
+        LOG(INFO) << "Distributing photons of each pulse to " << photon_threads_ << " threads";
+    }
 }
 
 void DepositionLaserModule::initialize() {
@@ -192,13 +226,17 @@ void DepositionLaserModule::initialize() {
                << ", refractive index: " << refractive_index_;
 
     // Check for unsupported detector materials, warn user if present
-
-    std::vector<std::shared_ptr<Detector>> detectors = geo_manager_->getDetectors();
-    for(auto& detector : detectors) {
+    // The geometry of all sensors is cached to avoid recomputing the transformations for every photon
+    detectors_ = geo_manager_->getDetectors();
+    for(auto& detector : detectors_) {
         auto material = detector->getModel()->getSensorMaterial();
-        if(material != SensorMaterial::SILICON && !is_user_optics_) {
+        bool tracked = (material == SensorMaterial::SILICON || is_user_optics_);
+        if(!tracked) {
             LOG(WARNING) << "Detector " << detector->getName() << " has unsupported material and will be ignored";
         }
+        sensor_boxes_.push_back(
+            make_tracking_box(detector->getPosition(), detector->getOrientation(), detector->getModel()->getSensorSize()));
+        sensor_tracked_.push_back(tracked);
     }
     // Check for incompatible passive objects, warn user if there are any
     auto passive_configs = geo_manager_->getPassiveElements();
@@ -206,7 +244,12 @@ void DepositionLaserModule::initialize() {
         auto shape = item.get<std::string>("type");
         if(shape != "box") {
             LOG(WARNING) << item.getName() << " passive object has unsupported type (" << shape << ") and will be ignored";
+            continue;
         }
+        auto [passive_position, passive_orientation] = geo_manager_->getPassiveElementOrientation(item.getName());
+        passive_boxes_.push_back(
+            make_tracking_box(passive_position, passive_orientation, item.get<ROOT::Math::XYZVector>("size")));
+        passive_names_.push_back(item.getName());
     }
 
     // Create Histograms
@@ -246,32 +289,31 @@ void DepositionLaserModule::initialize() {
         h_pulse_shape_ =
             CreateHistogram<TH1D>("pulse_shape", "Pulse shape;t [ns];Intensity [a.u.]", nbins, 0, 8 * pulse_duration_);
 
-        for(const auto& detector : detectors) {
+        for(const auto& detector : detectors_) {
             std::string name = "dep_charge_" + detector->getName();
             std::string title = name + ";x [mm];y [mm];z [mm]";
             auto sensor = detector->getModel()->getSensorSize();
 
-            h_deposited_charge_shapes_[detector] = CreateHistogram<TH3D>(name.c_str(),
-                                                                         title.c_str(),
-                                                                         100,
-                                                                         -sensor.X() / 2,
-                                                                         sensor.X() / 2,
-                                                                         100,
-                                                                         -sensor.Y() / 2,
-                                                                         sensor.Y() / 2,
-                                                                         100,
-                                                                         -sensor.Z() / 2,
-                                                                         sensor.Z() / 2);
+            h_deposited_charge_shapes_.push_back(CreateHistogram<TH3D>(name.c_str(),
+                                                                       title.c_str(),
+                                                                       100,
+                                                                       -sensor.X() / 2,
+                                                                       sensor.X() / 2,
+                                                                       100,
+                                                                       -sensor.Y() / 2,
+                                                                       sensor.Y() / 2,
+                                                                       100,
+                                                                       -sensor.Z() / 2,
+                                                                       sensor.Z() / 2));
         }
     }
 }
 
 void DepositionLaserModule::run(Event* event) {
 
-    // Containers for output messages
-
-    std::map<std::shared_ptr<Detector>, std::vector<MCParticle>> mc_particles;
-    std::map<std::shared_ptr<Detector>, std::vector<DepositedCharge>> deposited_charges;
+    // Containers for output messages, indexed like the detectors
+    std::vector<std::vector<MCParticle>> mc_particles(detectors_.size());
+    std::vector<std::vector<DepositedCharge>> deposited_charges(detectors_.size());
 
     // Lambda generator to yield pulse shape
     auto yield_starting_time = [&]() {
@@ -295,55 +337,91 @@ void DepositionLaserModule::run(Event* event) {
 
     std::sort(begin(starting_times), end(starting_times));
 
-    // To correctly offset local time for each detector
-    std::map<std::shared_ptr<Detector>, double> local_time_offsets;
-
-    // Loop over photons in a single laser pulse
-    // In time order
-    for(size_t i_photon = 0; i_photon < number_of_photons_; ++i_photon) {
-
-        LOG_PROGRESS(INFO, "photon_counter")
-            << "Event " << event->number << ": photon " << i_photon + 1 << " of " << number_of_photons_;
-
-        // Starting point and direction for this exact photon
-        auto [starting_point, photon_direction] = generate_photon_geometry(event);
+    // Generate and track all photons. For intra-event parallel tracking the photons are distributed to tasks of fixed size,
+    // independent of the number of threads, each with a separate random number stream
+    std::vector<std::pair<PhotonHit, double>> hits;
+    if(photon_threads_ == 0) {
+        hits = trace_photons(event->getRandomEngine(), event->number, starting_times, 0, number_of_photons_);
+    } else {
+        auto task_count = (number_of_photons_ + photon_task_size - 1) / photon_task_size;
 
-        // Get starting time in the pulse
-        double starting_time = starting_times[i_photon];
-        LOG(DEBUG) << "    Starting timestamp: " << Units::display(starting_time, "ns");
+        // Seed the random number streams of all tasks from the event, in order
+        std::vector<uint64_t> task_seeds(task_count);
+        for(auto& seed : task_seeds) {
+            seed = event->getRandomNumber();
+        }
 
-        // Generate penetration depth
-        double penetration_depth =
-            allpix::exponential_distribution<double>(1 / absorption_length_)(event->getRandomEngine());
-        LOG(DEBUG) << "    Penetration depth: " << Units::display(penetration_depth, "um");
+        std::vector<std::vector<std::pair<PhotonHit, double>>> task_hits(task_count);
+        std::vector<std::exception_ptr> task_exceptions(task_count);
+        std::atomic_size_t next_task{0};
+        auto worker = [&,
+                       log_level = Log::getReportingLevel(),
+                       log_format = Log::getFormat(),
+                       log_section = Log::getSection()]() {
+            Log::setReportingLevel(log_level);
+            Log::setFormat(log_format);
+            Log::setSection(log_section);
+            Log::setEventNum(event->number);
+
+            for(auto idx = next_task++; idx < task_count; idx = next_task++) {
+                try {
+                    RandomNumberGenerator random_generator;
+                    random_generator.seed(task_seeds[idx]);
+                    task_hits[idx] = trace_photons(random_generator,
+                                                   event->number,
+                                                   starting_times,
+                                                   idx * photon_task_size,
+                                                   std::min(number_of_photons_, (idx + 1) * photon_task_size));
+                } catch(...) {
+                    task_exceptions[idx] = std::current_exception();
+                }
+            }
+        };
 
-        // Perform tracking
-        std::optional<PhotonHit> hit_opt = track(starting_point, photon_direction, penetration_depth);
+        // The calling thread participates in the tracking
+        std::vector<std::thread> threads;
+        for(size_t i = 1; i < std::min<size_t>(photon_threads_, task_count); ++i) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for(auto& thread : threads) {
+            thread.join();
+        }
 
-        // If this photon did not hit any of the detectors, skip this iteration
-        if(!hit_opt) {
-            continue;
+        // Merge the hits in task order to be independent of the thread scheduling
+        for(size_t idx = 0; idx < task_count; ++idx) {
+            if(task_exceptions[idx]) {
+                std::rethrow_exception(task_exceptions[idx]);
+            }
+            std::move(task_hits[idx].begin(), task_hits[idx].end(), std::back_inserter(hits));
         }
+    }
 
-        PhotonHit hit = hit_opt.value();
+    // To correctly offset local time for each detector, NaN until the first hit in the detector
+    std::vector<double> local_time_offsets(detectors_.size(), std::numeric_limits<double>::quiet_NaN());
+
+    // Loop over the hits of all photons, in time order
+    for(const auto& [hit, starting_time] : hits) {
+        const auto& detector = detectors_[hit.detector];
 
         // If this was the first hit in this detector in this event,
         // remember entry timestamp as local t=0 for this detector.
         // It is assumed that photon that is created earlier also hits earlier
-        if(local_time_offsets.count(hit.detector) == 0) {
-            local_time_offsets[hit.detector] = starting_time + hit.time_to_entry;
+        auto& local_time_offset = local_time_offsets[hit.detector];
+        if(std::isnan(local_time_offset)) {
+            local_time_offset = starting_time + hit.time_to_entry;
         }
 
         // Create and store corresponding MCParticle and DepositedCharge
-        auto entry_local = hit.detector->getLocalPosition(hit.entry_global);
-        auto hit_local = hit.detector->getLocalPosition(hit.hit_global);
+        auto entry_local = detector->getLocalPosition(hit.entry_global);
+        auto hit_local = detector->getLocalPosition(hit.hit_global);
 
         double time_entry_global = starting_time + hit.time_to_entry;
         double time_hit_global = starting_time + hit.time_to_hit;
-        double time_entry_local = time_entry_global - local_time_offsets[hit.detector];
-        double time_hit_local = time_hit_global - local_time_offsets[hit.detector];
+        double time_entry_local = time_entry_global - local_time_offset;
+        double time_hit_local = time_hit_global - local_time_offset;
 
-        LOG(DEBUG) << "    Hit in " << hit.detector->getName();
+        LOG(DEBUG) << "    Hit in " << detector->getName();
         LOG(DEBUG) << "        global: " << Units::display(hit.hit_global, {"mm"}) << Units::display(time_hit_global, "ns");
         LOG(DEBUG) << "        local: " << Units::display(hit_local, {"mm"}) << Units::display(time_hit_local, "ns");
 
@@ -351,64 +429,61 @@ void DepositionLaserModule::run(Event* event) {
             h_deposited_charge_shapes_[hit.detector]->Fill(hit_local.X(), hit_local.Y(), hit_local.Z());
         }
 
-        // If that is a first hit in this detector, create map entries
-        if(mc_particles.count(hit.detector) == 0) {
-            mc_particles[hit.detector] = std::vector<MCParticle>();
-        }
-        if(deposited_charges.count(hit.detector) == 0) {
-            deposited_charges[hit.detector] = std::vector<DepositedCharge>();
-        }
-
         // Construct all necessary objects in-place
         // allpix::MCParticle
-        mc_particles[hit.detector].emplace_back(entry_local,
-                                                hit.entry_global,
-                                                hit_local,
-                                                hit.hit_global,
-                                                22, // gamma
-                                                time_entry_local,
-                                                time_entry_global);
+        auto& detector_particles = mc_particles[hit.detector];
+        detector_particles.emplace_back(entry_local,
+                                        hit.entry_global,
+                                        hit_local,
+                                        hit.hit_global,
+                                        22, // gamma
+                                        time_entry_local,
+                                        time_entry_global);
         // Count electrons and holes:
-        mc_particles[hit.detector].back().setTotalDepositedCharge(2);
+        detector_particles.back().setTotalDepositedCharge(2);
 
         // allpix::DepositedCharge for electron
-        deposited_charges[hit.detector].emplace_back(hit_local,
-                                                     hit.hit_global,
-                                                     CarrierType::ELECTRON,
-                                                     group_photons_, // value
-                                                     time_hit_local,
-                                                     time_hit_global);
+        auto& detector_charges = deposited_charges[hit.detector];
+        detector_charges.emplace_back(hit_local,
+                                      hit.hit_global,
+                                      CarrierType::ELECTRON,
+                                      group_photons_, // value
+                                      time_hit_local,
+                                      time_hit_global);
 
         // allpix::DepositedCharge for hole
-        deposited_charges[hit.detector].emplace_back(hit_local,
-                                                     hit.hit_global,
-                                                     CarrierType::HOLE,
-                                                     group_photons_, // value
-                                                     time_hit_local,
-                                                     time_hit_global);
+        detector_charges.emplace_back(hit_local,
+                                      hit.hit_global,
+                                      CarrierType::HOLE,
+                                      group_photons_, // value
+                                      time_hit_local,
+                                      time_hit_global);
 
-    } // loop over photons
+    } // loop over hits
 
-    LOG(INFO) << "Registered hits in " << mc_particles.size() << " detectors";
+    auto hit_detectors = std::count_if(
+        mc_particles.begin(), mc_particles.end(), [](const auto& particles) { return !particles.empty(); });
+    LOG(INFO) << "Registered hits in " << hit_detectors << " detectors";
 
     // After all the containers are filled, assign MCParticle links in DepositedCharges
-
-    for(const auto& [detector, data] : mc_particles) {
-        for(size_t i = 0; i < size(mc_particles[detector]); ++i) {
-            deposited_charges[detector][2 * i].setMCParticle(&(data[i]));
-            deposited_charges[detector][2 * i + 1].setMCParticle(&(data[i]));
+    for(size_t index = 0; index < detectors_.size(); ++index) {
+        const auto& data = mc_particles[index];
+        for(size_t i = 0; i < data.size(); ++i) {
+            deposited_charges[index][2 * i].setMCParticle(&(data[i]));
+            deposited_charges[index][2 * i + 1].setMCParticle(&(data[i]));
         }
     }
 
-    // Dispatch messages
-    for(auto& [detector, data] : mc_particles) {
-        LOG(INFO) << "    " << detector->getName() << ": " << data.size() << " hits";
-        auto mcparticle_message = std::make_shared<MCParticleMessage>(std::move(data), detector);
+    // Dispatch messages for the detectors with hits
+    for(size_t index = 0; index < detectors_.size(); ++index) {
+        if(mc_particles[index].empty()) {
+            continue;
+        }
+        const auto& detector = detectors_[index];
+        LOG(INFO) << "    " << detector->getName() << ": " << mc_particles[index].size() << " hits";
+        auto mcparticle_message = std::make_shared<MCParticleMessage>(std::move(mc_particles[index]), detector);
         messenger_->dispatchMessage(this, std::move(mcparticle_message), event);
-    }
-
-    for(auto& [detector, data] : deposited_charges) {
-        auto charge_message = std::make_shared<DepositedChargeMessage>(std::move(data), detector);
+        auto charge_message = std::make_shared<DepositedChargeMessage>(std::move(deposited_charges[index]), detector);
         messenger_->dispatchMessage(this, std::move(charge_message), event);
     }
 }
@@ -420,13 +495,57 @@ void DepositionLaserModule::finalize() {
         h_angular_phi_->Write();
         h_angular_theta_->Write();
         h_pulse_shape_->Write();
-        for(auto& [detector, histo] : h_deposited_charge_shapes_) {
+        for(auto& histo : h_deposited_charge_shapes_) {
             histo->Write();
         }
     }
 }
 
-std::pair<ROOT::Math::XYZPoint, ROOT::Math::XYZVector> DepositionLaserModule::generate_photon_geometry(Event* event) {
+std::vector<std::pair<DepositionLaserModule::PhotonHit, double>>
+DepositionLaserModule::trace_photons(RandomNumberGenerator& random_generator,
+                                     uint64_t event_number,
+                                     const std::vector<double>& starting_times,
+                                     size_t first,
+                                     size_t last) {
+    std::vector<std::pair<PhotonHit, double>> hits;
+    for(size_t i_photon = first; i_photon < last; ++i_photon) {
+
+        LOG_PROGRESS(INFO, "photon_counter")
+            << "Event " << event_number << ": photon " << i_photon + 1 << " of " << number_of_photons_;
+
+        // Quasi-random point of this photon, skipping the first point of the sequence at the origin
+        std::optional<std::array<double, SobolSequence::max_dimensions>> point;
+        if(sobol_.has_value()) {
+            point = sobol_->point((event_number - 1) * number_of_photons_ + i_photon + 1);
+        }
+
+        // Starting point and direction for this exact photon
+        auto [starting_point, photon_direction] = generate_photon_geometry(random_generator, point);
+
+        // Get starting time in the pulse
+        double starting_time = starting_times[i_photon];
+        LOG(DEBUG) << "    Starting timestamp: " << Units::display(starting_time, "ns");
+
+        // Generate penetration depth
+        double penetration_depth =
+            (point.has_value() ? -absorption_length_ * std::log((*point)[4])
+                               : allpix::exponential_distribution<double>(1 / absorption_length_)(random_generator));
+        LOG(DEBUG) << "    Penetration depth: " << Units::display(penetration_depth, "um");
+
+        // Perform tracking
+        std::optional<PhotonHit> hit_opt = track(starting_point, photon_direction, penetration_depth);
+
+        // If this photon did not hit any of the detectors, skip it
+        if(hit_opt) {
+            hits.emplace_back(hit_opt.value(), starting_time);
+        }
+    }
+    return hits;
+}
+
+std::pair<ROOT::Math::XYZPoint, ROOT::Math::XYZVector>
+DepositionLaserModule::generate_photon_geometry(
+    RandomNumberGenerator& random_generator, const std::optional<std::array<double, SobolSequence::max_dimensions>>& point) {
     // Lambda to generate two unit vectors, orthogonal to beam direction
     // Adapted from TVector3::Orthogonal()
     auto orthogonal_pair = [](const ROOT::Math::XYZVector& v) {
@@ -452,8 +571,12 @@ std::pair<ROOT::Math::XYZPoint, ROOT::Math::XYZVector> DepositionLaserModule::ge
         auto [v1, v2] = orthogonal_pair(beam_direction_);
 
         // Beam waist is equal to 2*sigma
-        double dx = allpix::normal_distribution<double>(0, size / 2.)(event->getRandomEngine());
-        double dy = allpix::normal_distribution<double>(0, size / 2.)(event->getRandomEngine());
+        if(point.has_value()) {
+            return v1 * ROOT::Math::normal_quantile((*point)[0], size / 2.) +
+                   v2 * ROOT::Math::normal_quantile((*point)[1], size / 2.);
+        }
+        double dx = allpix::normal_distribution<double>(0, size / 2.)(random_generator);
+        double dy = allpix::normal_distribution<double>(0, size / 2.)(random_generator);
         return v1 * dx + v2 * dy;
     };
 
@@ -474,9 +597,14 @@ std::pair<ROOT::Math::XYZPoint, ROOT::Math::XYZVector> DepositionLaserModule::ge
         auto focal_position = source_position_ + beam_direction_ * focal_distance_ + beam_pos_smearing(beam_waist_);
 
         // Generate angles
-        double phi = allpix::uniform_real_distribution<double>(0, 2 * TMath::Pi())(event->getRandomEngine());
-        double cos_theta =
-            allpix::uniform_real_distribution<double>(cos(beam_convergence_angle_), 1)(event->getRandomEngine());
+        double phi = 0, cos_theta = 0;
+        if(point.has_value()) {
+            phi = 2 * TMath::Pi() * (*point)[2];
+            cos_theta = cos(beam_convergence_angle_) + (1 - cos(beam_convergence_angle_)) * (*point)[3];
+        } else {
+            phi = allpix::uniform_real_distribution<double>(0, 2 * TMath::Pi())(random_generator);
+            cos_theta = allpix::uniform_real_distribution<double>(cos(beam_convergence_angle_), 1)(random_generator);
+        }
 
         // Rotate direction by given angles
         // First, define and apply theta rotation
@@ -540,30 +668,26 @@ std::optional<DepositionLaserModule::PhotonHit> DepositionLaserModule::track(con
 
     double c = TMath::C() * 100; // speed of light in mm/ns
 
-    std::vector<std::shared_ptr<Detector>> detectors = geo_manager_->getDetectors();
-    std::vector<std::pair<std::shared_ptr<Detector>, std::pair<double, double>>> intersection_segments;
-
-    for(auto& detector : detectors) {
-        if(detector->getModel()->getSensorMaterial() != SensorMaterial::SILICON && !is_user_optics_) {
+    // Find the first sensor along the track
+    std::optional<std::pair<size_t, std::pair<double, double>>> first_intersection;
+    for(size_t index = 0; index < sensor_boxes_.size(); ++index) {
+        if(!sensor_tracked_[index]) {
             continue;
         }
-        auto intersection = intersect_with_sensor(detector, position, direction);
-        if(intersection) {
-            intersection_segments.emplace_back(detector, intersection.value());
+        auto intersection = intersect_with_box(sensor_boxes_[index], position, direction);
+        if(intersection && (!first_intersection || intersection.value() < first_intersection->second)) {
+            first_intersection = std::make_pair(index, intersection.value());
         }
     }
 
-    if(intersection_segments.empty()) {
+    if(!first_intersection) {
         LOG(DEBUG) << "No intersections with sensitive detectors";
         return std::nullopt;
     }
 
-    auto it_first_detector = std::min_element(begin(intersection_segments),
-                                              end(intersection_segments),
-                                              [](const auto& p1, const auto& p2) { return p1.second < p2.second; });
-
-    auto detector = it_first_detector->first;
-    double t0 = it_first_detector->second.first;
+    auto detector_index = first_intersection->first;
+    const auto& sensor_box = sensor_boxes_[detector_index];
+    double t0 = first_intersection->second.first;
 
     auto intersect_passive = intersect_with_passives(position, direction);
     if(intersect_passive) {
@@ -573,7 +697,7 @@ std::optional<DepositionLaserModule::PhotonHit> DepositionLaserModule::track(con
         }
     }
 
-    auto normal_vector = -1 * intersection_normal_vector(detector, position + direction * t0);
+    auto normal_vector = -1 * intersection_normal_vector(sensor_box, position + direction * t0);
 
     double incidence_angle = angle(direction, normal_vector);
     double refraction_angle = asin(sin(incidence_angle) / refractive_index_);
@@ -583,7 +707,7 @@ std::optional<DepositionLaserModule::PhotonHit> DepositionLaserModule::track(con
     ROOT::Math::AxisAngle refraction_rotation(binormal, incidence_angle - refraction_angle);
     ROOT::Math::XYZVector new_direction = refraction_rotation(direction);
 
-    LOG(DEBUG) << "    Intersection with " << detector->getName();
+    LOG(DEBUG) << "    Intersection with " << detectors_[detector_index]->getName();
     LOG(DEBUG) << "        entry at " << Units::display(position + direction * t0, {"mm"});
     LOG(DEBUG) << "        normal at entry: " << normal_vector << ", binormal: " << binormal.Unit();
     LOG(DEBUG) << "        incidence angle: " << Units::display(incidence_angle, "deg")
@@ -591,7 +715,7 @@ std::optional<DepositionLaserModule::PhotonHit> DepositionLaserModule::track(con
     LOG(DEBUG) << "        direction after refraction: " << new_direction;
 
     // Intersect the refracted ray with the detector
-    auto intersection = intersect_with_sensor(detector, position + direction * t0, new_direction);
+    auto intersection = intersect_with_box(sensor_box, position + direction * t0, new_direction);
     auto [t0_refract, t1_refract] = intersection.value();
     double crossing_distance = t1_refract - t0_refract;
 
@@ -604,61 +728,45 @@ std::optional<DepositionLaserModule::PhotonHit> DepositionLaserModule::track(con
 
     // Construct a hit
 
-    return PhotonHit{detector,
+    return PhotonHit{detector_index,
                      position + direction * t0,
                      position + direction * t0 + new_direction * penetration_depth,
                      t0 / c,
                      t0 / c + penetration_depth / c * refractive_index_};
 }
 
-std::optional<std::pair<double, double>>
-DepositionLaserModule::intersect_with_sensor(const std::shared_ptr<const Detector>& detector,
-                                             const ROOT::Math::XYZPoint& position_global,
-                                             const ROOT::Math::XYZVector& direction_global) const {
-    // Obtain total sensor size
-    auto sensor = detector->getModel()->getSensorSize();
-
-    // Transform original position and direction to a sensor-related coordinate system,
-
-    // Construct transformation from the sensor system to the global one
+DepositionLaserModule::TrackingBox DepositionLaserModule::make_tracking_box(const ROOT::Math::XYZPoint& position,
+                                                                        const ROOT::Math::Rotation3D& orientation,
+                                                                        const ROOT::Math::XYZVector& size) {
+    // Construct transformation from the box system to the global one
     // * The rotation into the global coordinate system
-    // * The shift from the origin to the detector position
-    ROOT::Math::Rotation3D rotation_center(detector->getOrientation());
-    ROOT::Math::Translation3D translation_center(static_cast<ROOT::Math::XYZVector>(detector->getPosition()));
+    // * The shift from the origin to the box position
+    ROOT::Math::Rotation3D rotation_center(orientation);
+    ROOT::Math::Translation3D translation_center(static_cast<ROOT::Math::XYZVector>(position));
     ROOT::Math::Transform3D transform_center(rotation_center, translation_center);
 
-    // Apply inverse of that transformation
-    auto position_local = transform_center.Inverse()(position_global);
-
-    // Direction vector can directly be rotated
-    auto direction_local = detector->getOrientation().Inverse()(direction_global);
+    // Store the inverse of that transformation, direction vectors can directly be rotated
+    return TrackingBox{transform_center.Inverse(), rotation_center, rotation_center.Inverse(), size};
+}
 
-    return LiangBarsky::intersectionDistances(direction_local, position_local, sensor);
+std::optional<std::pair<double, double>>
+DepositionLaserModule::intersect_with_box(const TrackingBox& box,
+                                          const ROOT::Math::XYZPoint& position_global,
+                                          const ROOT::Math::XYZVector& direction_global) {
+    // Transform original position and direction to the coordinate system of the box
+    auto position_local = box.to_local(position_global);
+    auto direction_local = box.rotation_to_local(direction_global);
+
+    return LiangBarsky::intersectionDistances(direction_local, position_local, box.size);
 }
 
 std::optional<std::pair<double, std::string>>
 DepositionLaserModule::intersect_with_passives(const ROOT::Math::XYZPoint& position_global,
                                                const ROOT::Math::XYZVector& direction_global) const {
 
-    std::optional<std::pair<double, std::string>> result{};
-    auto passive_configs = geo_manager_->getPassiveElements();
-
-    for(const auto& item : passive_configs) {
-        auto shape = item.get<std::string>("type");
-        if(shape != "box") {
-            continue;
-        }
-
-        auto [passive_position, passive_orientation] = geo_manager_->getPassiveElementOrientation(item.getName());
-        auto passive_size = item.get<ROOT::Math::XYZVector>("size");
-
-        ROOT::Math::Rotation3D rotation_center(passive_orientation);
-        ROOT::Math::Translation3D translation_center(static_cast<ROOT::Math::XYZVector>(passive_position));
-        ROOT::Math::Transform3D transform_center(rotation_center, translation_center);
-        auto position_local = transform_center.Inverse()(position_global);
-        auto direction_local = rotation_center.Inverse()(direction_global);
-
-        auto intersect = LiangBarsky::intersectionDistances(direction_local, position_local, passive_size);
+    std::optional<std::pair<double, size_t>> result{};
+    for(size_t index = 0; index < passive_boxes_.size(); ++index) {
+        auto intersect = intersect_with_box(passive_boxes_[index], position_global, direction_global);
 
         if(!intersect) {
             continue;
@@ -666,53 +774,41 @@ DepositionLaserModule::intersect_with_passives(const ROOT::Math::XYZPoint& posit
 
         double distance = intersect.value().first;
 
-        if(!result) {
-            result = {distance, item.getName()};
-        }
-
-        if(distance < result.value().first) {
-            result = {distance, item.getName()};
+        if(!result || distance < result.value().first) {
+            result = {distance, index};
         }
     }
 
-    return result;
+    if(!result) {
+        return std::nullopt;
+    }
+    return std::make_pair(result.value().first, passive_names_[result.value().second]);
 }
 
-ROOT::Math::XYZVector DepositionLaserModule::intersection_normal_vector(const std::shared_ptr<const Detector>& detector,
-                                                                        const ROOT::Math::XYZPoint& position_global) const {
-    // Obtain total sensor size
-    auto sensor = detector->getModel()->getSensorSize();
+ROOT::Math::XYZVector DepositionLaserModule::intersection_normal_vector(const TrackingBox& box,
+                                                                        const ROOT::Math::XYZPoint& position_global) {
+    // Transform original position to the coordinate system of the box
+    auto position_local = box.to_local(position_global);
+    const auto& size = box.size;
 
-    // Transform original position and direction to a sensor-related coordinate system,
+    std::array<double, 6> distances_to_faces = {abs(position_local.X() - size.X() / 2),
+                                                abs(position_local.X() + size.X() / 2),
+                                                abs(position_local.Y() - size.Y() / 2),
+                                                abs(position_local.Y() + size.Y() / 2),
+                                                abs(position_local.Z() - size.Z() / 2),
+                                                abs(position_local.Z() + size.Z() / 2)};
 
-    // Construct transformation from the sensor system to the global one
-    // * The rotation into the global coordinate system
-    // * The shift from the origin to the detector position
-    ROOT::Math::Rotation3D rotation_center(detector->getOrientation());
-    ROOT::Math::Translation3D translation_center(static_cast<ROOT::Math::XYZVector>(detector->getPosition()));
-    ROOT::Math::Transform3D transform_center(rotation_center, translation_center);
-
-    // Apply inverse of that transformation
-    auto position_local = transform_center.Inverse()(position_global);
-
-    std::vector<double> distances_to_faces = {abs(position_local.X() - sensor.X() / 2),
-                                              abs(position_local.X() + sensor.X() / 2),
-                                              abs(position_local.Y() - sensor.Y() / 2),
-                                              abs(position_local.Y() + sensor.Y() / 2),
-                                              abs(position_local.Z() - sensor.Z() / 2),
-                                              abs(position_local.Z() + sensor.Z() / 2)};
-
-    std::vector<ROOT::Math::XYZVector> normals_to_faces = {
+    static const std::array<ROOT::Math::XYZVector, 6> normals_to_faces = {{
         {1, 0, 0},
         {-1, 0, 0},
         {0, 1, 0},
         {0, -1, 0},
         {0, 0, 1},
         {0, 0, -1},
-    };
+    }};
 
     auto iter_min = std::min_element(begin(distances_to_faces), end(distances_to_faces));
     size_t index_min = static_cast<size_t>(abs(iter_min - begin(distances_to_faces))); // avoid implicit conversion
 
-    return rotation_center(normals_to_faces[index_min]);
+    return box.rotation(normals_to_faces[index_min]);
 }
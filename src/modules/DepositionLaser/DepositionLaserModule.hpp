@@ -13,16 +13,20 @@
  * Refer to the User's Manual for more details.
  */
 
-#include <map>
+#include <array>
 #include <optional>
 #include <string>
 #include <utility>
+#include <vector>
+
+#include <Math/Transform3D.h>
 
 #include "core/config/Configuration.hpp"
 #include "core/geometry/GeometryManager.hpp"
 #include "core/messenger/Messenger.hpp"
 #include "core/module/Event.hpp"
 #include "core/module/Module.hpp"
+#include "core/utils/quasi_random.h"
 
 #include "TH1D.h"
 #include "TH2D.h"
@@ -43,9 +47,22 @@ namespace allpix {
             CONVERGING,
         };
 
+        enum class SamplingMethod {
+            PSEUDO_RANDOM, ///< Pseudo-random numbers from the random number generator of the event
+            SOBOL,         ///< Sobol sequence indexed by the event number and the photon
+        };
+
+        // Box volume of a sensor or a passive object, with the transformations precomputed for the photon tracking
+        struct TrackingBox {
+            ROOT::Math::Transform3D to_local;
+            ROOT::Math::Rotation3D rotation;
+            ROOT::Math::Rotation3D rotation_to_local;
+            ROOT::Math::XYZVector size;
+        };
+
         // Data to return from tracking algorithms
         struct PhotonHit { // NOLINT
-            std::shared_ptr<Detector> detector;
+            size_t detector;
             ROOT::Math::XYZPoint entry_global;
             ROOT::Math::XYZPoint hit_global;
             double time_to_entry;
@@ -78,13 +95,23 @@ namespace allpix {
 
     private:
         /**
-         * @brief Check intersection of the given track with the given detector
+         * @brief Precompute the transformations of a box volume from the global coordinate system to its local one
+         * @param position Position of the box center in global coordinates
+         * @param orientation Orientation of the box in the global coordinate system
+         * @param size Size of the box
+         */
+        static TrackingBox make_tracking_box(const ROOT::Math::XYZPoint& position,
+                                             const ROOT::Math::Rotation3D& orientation,
+                                             const ROOT::Math::XYZVector& size);
+
+        /**
+         * @brief Check intersection of the given track with the given box
          * This is a wrapper around LiangBarsky::intersectionDistances,
          * which properly transforms coordinates to make it work
          */
-        std::optional<std::pair<double, double>> intersect_with_sensor(const std::shared_ptr<const Detector>& detector,
-                                                                       const ROOT::Math::XYZPoint& position_global,
-                                                                       const ROOT::Math::XYZVector& direction_global) const;
+        static std::optional<std::pair<double, double>> intersect_with_box(const TrackingBox& box,
+                                                                           const ROOT::Math::XYZPoint& position_global,
+                                                                           const ROOT::Math::XYZVector& direction_global);
 
         /**
          * @brief Check intersection with passive objects if there is any
@@ -95,18 +122,36 @@ namespace allpix {
                                 const ROOT::Math::XYZVector& direction_global) const;
 
         /**
-         * @brief Get a normal vector for a point where the given track enters the given detector
-         * Returns a normal vector to sensor face, closest to the hit_point
+         * @brief Get a normal vector for a point where the given track enters the given box
+         * Returns a normal vector to box face, closest to the hit_point
          */
-        ROOT::Math::XYZVector intersection_normal_vector(const std::shared_ptr<const Detector>& detector,
-                                                         const ROOT::Math::XYZPoint& position_global) const;
+        static ROOT::Math::XYZVector intersection_normal_vector(const TrackingBox& box,
+                                                                const ROOT::Math::XYZPoint& position_global);
 
         /**
          * @brief Generate starting position and direction for a single photon, obeying the set beam geometry
-         * @param event is passed to get proper RNGs
+         * @param random_generator Random number generator to use
+         * @param point Quasi-random point to use instead of the random number generator, if sampling from a sequence
          * Also fills histograms
          */
-        std::pair<ROOT::Math::XYZPoint, ROOT::Math::XYZVector> generate_photon_geometry(Event* event);
+        std::pair<ROOT::Math::XYZPoint, ROOT::Math::XYZVector>
+        generate_photon_geometry(RandomNumberGenerator& random_generator,
+                                 const std::optional<std::array<double, SobolSequence::max_dimensions>>& point);
+
+        /**
+         * @brief Generate and track a range of photons of a pulse
+         * @param random_generator Random number generator to use
+         * @param event_number Number of the event, for the progress output
+         * @param starting_times Time-ordered starting times of all photons in the pulse
+         * @param first Index of the first photon of the range
+         * @param last Index past the last photon of the range
+         * @return Hits of the photons absorbed in a sensor and their starting times, in photon order
+         */
+        std::vector<std::pair<PhotonHit, double>> trace_photons(RandomNumberGenerator& random_generator,
+                                                                uint64_t event_number,
+                                                                const std::vector<double>& starting_times,
+                                                                size_t first,
+                                                                size_t last);
 
         /**
          * @brief Track a photon, starting at the given point
@@ -136,6 +181,18 @@ namespace allpix {
         bool is_user_optics_{false};
 
         size_t group_photons_;
+        unsigned int photon_threads_;
+
+        // Optional quasi-random sampling of the photon geometry and penetration depth
+        SamplingMethod sampling_{};
+        std::optional<SobolSequence> sobol_;
+
+        // Geometry for the photon tracking, the sensor boxes are indexed like the detectors
+        std::vector<std::shared_ptr<Detector>> detectors_;
+        std::vector<TrackingBox> sensor_boxes_;
+        std::vector<bool> sensor_tracked_;
+        std::vector<TrackingBox> passive_boxes_;
+        std::vector<std::string> passive_names_;
 
         // Histograms
         bool output_plots_;
@@ -144,6 +201,6 @@ namespace allpix {
         Histogram<TH1D> h_angular_phi_{};
         Histogram<TH1D> h_angular_theta_{};
         Histogram<TH1D> h_pulse_shape_{};
-        std::map<const std::shared_ptr<Detector>, Histogram<TH3D>> h_deposited_charge_shapes_;
+        std::vector<Histogram<TH3D>> h_deposited_charge_shapes_;
     };
 } // namespace allpix
@@ -11,10 +11,13 @@
 
 #include "DepositionPointChargeModule.hpp"
 
+#include <array>
 #include <cmath>
 #include <string>
 #include <utility>
 
+#include <Math/QuantFuncMathCore.h>
+
 #include "core/messenger/Messenger.hpp"
 #include "core/module/Event.hpp"
 #include "core/utils/distributions.h"
@@ -38,6 +41,7 @@ DepositionPointChargeModule::DepositionPointChargeModule(Configuration& config,
     // Set default value for the number of charges deposited
     config_.setDefault("position", ROOT::Math::XYZPoint(0., 0., 0.));
     config_.setDefault("source_type", SourceType::POINT);
+    config_.setDefault("sampling", SamplingMethod::PSEUDO_RANDOM);
 
     // Plotting parameters
     config_.setDefault<bool>("output_plots", false);
@@ -46,6 +50,7 @@ DepositionPointChargeModule::DepositionPointChargeModule(Configuration& config,
     // Read type and model:
     type_ = config_.get<SourceType>("source_type");
     model_ = config_.get<DepositionModel>("model");
+    sampling_ = config_.get<SamplingMethod>("sampling");
 
     // Read spot size
     if(model_ == DepositionModel::SPOT) {
@@ -107,6 +112,35 @@ void DepositionPointChargeModule::initialize() {
         // Get the config manager and retrieve total number of events:
         ConfigManager* conf_manager = getConfigManager();
         auto events = conf_manager->getGlobalConfiguration().get<unsigned int>("number_of_events");
+
+        // Optionally deposit several voxels per event, placed in different pixel cells to not overlap in their response
+        config_.setDefault<unsigned int>("scan_voxels_per_event", 1);
+        config_.setDefault<unsigned int>("scan_pixel_spacing", 5);
+        voxels_per_event_ = config_.get<unsigned int>("scan_voxels_per_event");
+        pixel_spacing_ = config_.get<unsigned int>("scan_pixel_spacing");
+        if(voxels_per_event_ == 0) {
+            throw InvalidValueError(config_, "scan_voxels_per_event", "number of voxels per event has to be positive");
+        }
+        if(voxels_per_event_ > 1) {
+            if(pixel_spacing_ == 0) {
+                throw InvalidValueError(
+                    config_, "scan_pixel_spacing", "spacing of the scanned pixel cells has to be positive");
+            }
+            auto npixels = detector_model_->getNPixels();
+            cells_per_row_ = std::min((npixels.x() - 1) / pixel_spacing_ + 1, voxels_per_event_);
+            auto rows = (voxels_per_event_ + cells_per_row_ - 1) / cells_per_row_;
+            if((rows - 1) * pixel_spacing_ >= npixels.y()) {
+                throw InvalidValueError(config_,
+                                        "scan_voxels_per_event",
+                                        "pixel cells for " + std::to_string(voxels_per_event_) +
+                                            " voxels with a spacing of " + std::to_string(pixel_spacing_) +
+                                            " pixels do not fit into the pixel matrix");
+            }
+            events *= voxels_per_event_;
+            LOG(INFO) << "Depositing " << voxels_per_event_ << " voxels per event in pixel cells " << pixel_spacing_
+                      << " pixels apart";
+        }
+
         scan_coordinates_ = config_.getArray<std::string>("scan_coordinates", {"x", "y", "z"});
 
         scan_x_ = std::find(scan_coordinates_.begin(), scan_coordinates_.end(), "x") != scan_coordinates_.end();
@@ -145,11 +179,11 @@ void DepositionPointChargeModule::initialize() {
                 "The scan coordinates must be a combination of x, y, and z, and the number of coordinates cannot exceed 3.");
         }
 
-        // Check that the scan setup is correct
-        root_ = events;
+        // Check that the scan setup is correct, quasi-random scans sample the full pixel cell in every event
+        root_ = (sampling_ == SamplingMethod::SOBOL ? 1 : events);
         if(no_of_coordinates_ == 2) {
-            root_ = static_cast<unsigned int>(std::lround(std::sqrt(events)));
-            if(events != root_ * root_) {
+            root_ = (sampling_ == SamplingMethod::SOBOL ? 1 : static_cast<unsigned int>(std::lround(std::sqrt(events))));
+            if(sampling_ != SamplingMethod::SOBOL && events != root_ * root_) {
                 LOG(WARNING) << "Number of events is not a square, pixel cell volume cannot fully be covered in scan. "
                              << "Closest square is " << root_ * root_;
             }
@@ -160,8 +194,8 @@ void DepositionPointChargeModule::initialize() {
                                         "The coordinates must be x, y, or z, and a coordinate must not be repeated");
             }
         } else if(no_of_coordinates_ == 3) {
-            root_ = static_cast<unsigned int>(std::lround(std::cbrt(events)));
-            if(events != root_ * root_ * root_) {
+            root_ = (sampling_ == SamplingMethod::SOBOL ? 1 : static_cast<unsigned int>(std::lround(std::cbrt(events))));
+            if(sampling_ != SamplingMethod::SOBOL && events != root_ * root_ * root_) {
                 LOG(WARNING) << "Number of events is not a cube, pixel cell volume cannot fully be covered in scan. "
                              << "Closest cube is " << root_ * root_ * root_;
             }
@@ -170,7 +204,77 @@ void DepositionPointChargeModule::initialize() {
         voxel_ = ROOT::Math::XYZVector(detector_model_->getPixelSize().x() / (scan_x_ ? root_ : 1.0),
                                        detector_model_->getPixelSize().y() / (scan_y_ ? root_ : 1.0),
                                        detector_model_->getSensorSize().z() / (scan_z_ ? root_ : 1.0));
-        LOG(INFO) << "Voxel size for scan of pixel volume: " << Units::display(voxel_, {"um", "mm"});
+        if(sampling_ == SamplingMethod::SOBOL) {
+            sobol_.emplace(no_of_coordinates_);
+        } else {
+            LOG(INFO) << "Voxel size for scan of pixel volume: " << Units::display(voxel_, {"um", "mm"});
+        }
+    }
+
+    // Set up the pixel cell for random depositions and the optional biasing towards a sub-volume of it
+    if(model_ == DepositionModel::RANDOM) {
+        // The pixel cell is placed at the center of the active sensor area, shifted by the configured position
+        auto [xpixel, ypixel] = detector_model_->getPixelIndex(detector_model_->getMatrixCenter());
+        auto pixel_center = detector_model_->getPixelCenter(xpixel, ypixel);
+        cell_center_ = ROOT::Math::XYZPoint(pixel_center.x(), pixel_center.y(), 0) + position_;
+        cell_size_ = ROOT::Math::XYZVector(detector_model_->getPixelSize().x(),
+                                           detector_model_->getPixelSize().y(),
+                                           detector_model_->getSensorSize().z());
+
+        config_.setDefault<double>("bias_fraction", 0.);
+        bias_fraction_ = config_.get<double>("bias_fraction");
+        if(bias_fraction_ < 0. || bias_fraction_ >= 1.) {
+            throw InvalidValueError(config_, "bias_fraction", "fraction of biased depositions has to be in the range [0,1)");
+        }
+
+        if(bias_fraction_ > 0.) {
+            // Only the x and y coordinates of the region are used for the mip source type
+            auto read_vector = [&](const std::string& key) {
+                if(config_.getArray<double>(key).size() == 2) {
+                    auto tmp = config_.get<ROOT::Math::XYVector>(key);
+                    return ROOT::Math::XYZVector(tmp.x(), tmp.y(), 0);
+                }
+                return config_.get<ROOT::Math::XYZVector>(key);
+            };
+            config_.setDefault("bias_region_position", ROOT::Math::XYZVector(0., 0., 0.));
+            bias_region_size_ = read_vector("bias_region_size");
+            bias_region_position_ = read_vector("bias_region_position");
+
+            const auto sample_z = (type_ == SourceType::POINT);
+            const std::array<double, 3> region_size{bias_region_size_.x(), bias_region_size_.y(), bias_region_size_.z()};
+            const std::array<double, 3> region_position{
+                bias_region_position_.x(), bias_region_position_.y(), bias_region_position_.z()};
+            const std::array<double, 3> cell_size{cell_size_.x(), cell_size_.y(), cell_size_.z()};
+            bias_volume_ratio_ = 1.;
+            for(size_t i = 0; i < (sample_z ? 3 : 2); ++i) {
+                if(region_size[i] <= 0.) {
+                    throw InvalidValueError(config_, "bias_region_size", "size of the biased region has to be positive");
+                }
+                if(std::fabs(region_position[i]) + region_size[i] / 2 > cell_size[i] / 2) {
+                    throw InvalidValueError(
+                        config_, "bias_region_position", "biased region has to be fully contained in the pixel cell");
+                }
+                bias_volume_ratio_ *= cell_size[i] / region_size[i];
+            }
+            LOG(INFO) << "Biasing " << 100. * bias_fraction_ << "% of the depositions towards a region of size "
+                      << Units::display(bias_region_size_, {"um", "mm"}) << " at "
+                      << Units::display(bias_region_position_, {"um", "mm"}) << " relative to the pixel center";
+        }
+
+        // The biased sampling chooses between the region and the full cell with an additional dimension
+        if(sampling_ == SamplingMethod::SOBOL) {
+            sobol_.emplace(bias_fraction_ > 0. ? 4 : 3);
+        }
+    }
+
+    if(model_ == DepositionModel::SPOT && sampling_ == SamplingMethod::SOBOL) {
+        sobol_.emplace(3);
+    }
+    if(sobol_.has_value()) {
+        LOG(INFO) << "Sampling positions from a " << sobol_->dimensions() << "-dimensional Sobol sequence indexed by the "
+                  << "event number";
+    } else if(sampling_ == SamplingMethod::SOBOL) {
+        LOG(WARNING) << "Deposition model " << allpix::to_string(model_) << " does not sample positions, ignoring sampling";
     }
 
     if(output_plots_) {
@@ -212,73 +316,179 @@ void DepositionPointChargeModule::initialize() {
 
 void DepositionPointChargeModule::run(Event* event) {
 
-    ROOT::Math::XYZPoint position;
+    // Vector of deposited charges and their "MCParticle"
+    // The deposited charges point to their MCParticle, the particles must therefore not be reallocated
+    std::vector<DepositedCharge> charges;
+    std::vector<MCParticle> mcparticles;
+    mcparticles.reserve(voxels_per_event_);
+
+    // Create charge carriers at requested position
+    auto deposit = [&](const ROOT::Math::XYZPoint& position) {
+        if(type_ == SourceType::MIP) {
+            DepositLine(position, charges, mcparticles);
+        } else {
+            DepositPoint(position, charges, mcparticles);
+            if(output_plots_) {
+                auto [xpixel, ypixel] = detector_model_->getPixelIndex(position);
+                auto inPixelPos = position - detector_model_->getPixelCenter(xpixel, ypixel);
+                auto in_pixel_um_x = static_cast<double>(Units::convert(inPixelPos.x(), "um"));
+                auto in_pixel_um_y = static_cast<double>(Units::convert(inPixelPos.y(), "um"));
+                auto in_pixel_um_z = static_cast<double>(Units::convert(position.z(), "um"));
+                deposition_position_xy->Fill(in_pixel_um_x, in_pixel_um_y);
+                deposition_position_xz->Fill(in_pixel_um_x, in_pixel_um_z);
+                deposition_position_yz->Fill(in_pixel_um_y, in_pixel_um_z);
+            }
+        }
+    };
 
     if(model_ == DepositionModel::FIXED) {
         // Fixed position as read from the configuration:
-        position = position_;
+        deposit(position_);
     } else if(model_ == DepositionModel::SCAN) {
-        // Center the volume to be scanned in the center of the sensor,
-        // reference point is lower left corner of one pixel volume
-        auto ref = position_ + detector_model_->getMatrixSize() / 2.0 + voxel_ / 2.0 -
-                   ROOT::Math::XYZVector(detector_model_->getPixelSize().x() / 2.0,
-                                         detector_model_->getPixelSize().y() / 2.0,
-                                         detector_model_->getSensorSize().z() / 2.0);
-        LOG(DEBUG) << "Reference: " << Units::display(ref, {"um", "mm"});
-        if(no_of_coordinates_ == 3) {
-            position =
-                ROOT::Math::XYZPoint(voxel_.x() * static_cast<double>((event->number - 1) % root_),
-                                     voxel_.y() * static_cast<double>(((event->number - 1) / root_) % root_),
-                                     voxel_.z() * static_cast<double>(((event->number - 1) / root_ / root_) % root_)) +
-                ref;
-        } else {
-            position = ref;
-            if(scan_x_) {
-                position.SetX(voxel_.x() * static_cast<double>((event->number - 1) % root_) + ref.x());
-                if(scan_y_) {
-                    position.SetY(voxel_.y() * static_cast<double>(((event->number - 1) / root_) % root_) + ref.y());
-                } else if(scan_z_) {
-                    position.SetZ(voxel_.z() * static_cast<double>(((event->number - 1) / root_) % root_) + ref.z());
-                }
-            } else if(scan_y_) {
-                position.SetY(voxel_.y() * static_cast<double>((event->number - 1) % root_) + ref.y());
-                if(scan_z_) {
-                    position.SetZ(voxel_.z() * static_cast<double>(((event->number - 1) / root_) % root_) + ref.z());
-                }
-            } else {
-                position.SetZ(voxel_.z() * static_cast<double>((event->number - 1) % root_) + ref.z());
+        // Consecutive voxels of the scan, each in its own pixel cell. The cells form a grid centered on the scanned cell.
+        const auto cols = static_cast<int>(cells_per_row_);
+        const auto rows = (static_cast<int>(voxels_per_event_) + cols - 1) / cols;
+        const auto spacing = static_cast<int>(pixel_spacing_);
+        for(unsigned int i = 0; i < voxels_per_event_; ++i) {
+            auto position = ScanPosition((event->number - 1) * voxels_per_event_ + i);
+            if(voxels_per_event_ > 1) {
+                auto cell_x = static_cast<int>(i) % cols * spacing - (cols - 1) * spacing / 2;
+                auto cell_y = static_cast<int>(i) / cols * spacing - (rows - 1) * spacing / 2;
+                position += ROOT::Math::XYZVector(
+                    cell_x * detector_model_->getPixelSize().x(), cell_y * detector_model_->getPixelSize().y(), 0);
             }
+            LOG(DEBUG) << "Deposition position in local coordinates: " << Units::display(position, {"um", "mm"});
+            deposit(position);
         }
-        LOG(DEBUG) << "Deposition position in local coordinates: " << Units::display(position, {"um", "mm"});
+    } else if(model_ == DepositionModel::RANDOM) {
+        // Random position within the pixel cell, the event is weighted if the sampling is biased
+        deposit(RandomPosition(event));
     } else {
-        // Calculate random offset from configured position
-        auto shift = [&](auto size) {
-            double dx = allpix::normal_distribution<double>(0, size)(event->getRandomEngine());
-            double dy = allpix::normal_distribution<double>(0, size)(event->getRandomEngine());
-            double dz = allpix::normal_distribution<double>(0, size)(event->getRandomEngine());
-            return ROOT::Math::XYZVector(dx, dy, dz);
-        };
-
         // Spot around the configured position
-        position = position_ + shift(spot_size_);
+        deposit(position_ + SpotOffset(event));
     }
 
-    // Create charge carriers at requested position
-    if(type_ == SourceType::MIP) {
-        DepositLine(event, position);
+    // Only dispatch if charges have been deposited within the sensor
+    if(mcparticles.empty()) {
+        return;
+    }
+
+    // Dispatch the messages to the framework
+    auto mcparticle_message = std::make_shared<MCParticleMessage>(std::move(mcparticles), detector_);
+    messenger_->dispatchMessage(this, std::move(mcparticle_message), event);
+
+    auto deposit_message = std::make_shared<DepositedChargeMessage>(std::move(charges), detector_);
+    messenger_->dispatchMessage(this, std::move(deposit_message), event);
+}
+
+ROOT::Math::XYZPoint DepositionPointChargeModule::ScanPosition(uint64_t voxel) const {
+    // Center the volume to be scanned in the center of the sensor,
+    // reference point is lower left corner of one pixel volume
+    auto ref = position_ + detector_model_->getMatrixSize() / 2.0 + voxel_ / 2.0 -
+               ROOT::Math::XYZVector(detector_model_->getPixelSize().x() / 2.0,
+                                     detector_model_->getPixelSize().y() / 2.0,
+                                     detector_model_->getSensorSize().z() / 2.0);
+    LOG(DEBUG) << "Reference: " << Units::display(ref, {"um", "mm"});
+
+    // Quasi-random scans sample the scanned coordinates within the full pixel cell, skipping the first point at the corner
+    ROOT::Math::XYZPoint position;
+    if(sobol_.has_value()) {
+        auto point = sobol_->point(voxel + 1);
+        size_t dim = 0;
+        position = ref;
+        if(scan_x_) {
+            position.SetX(ref.x() + (point[dim++] - 0.5) * voxel_.x());
+        }
+        if(scan_y_) {
+            position.SetY(ref.y() + (point[dim++] - 0.5) * voxel_.y());
+        }
+        if(scan_z_) {
+            position.SetZ(ref.z() + (point[dim++] - 0.5) * voxel_.z());
+        }
+    } else if(no_of_coordinates_ == 3) {
+        position = ROOT::Math::XYZPoint(voxel_.x() * static_cast<double>(voxel % root_),
+                                        voxel_.y() * static_cast<double>((voxel / root_) % root_),
+                                        voxel_.z() * static_cast<double>((voxel / root_ / root_) % root_)) +
+                   ref;
     } else {
-        DepositPoint(event, position);
-        if(output_plots_) {
-            auto [xpixel, ypixel] = detector_model_->getPixelIndex(position);
-            auto inPixelPos = position - detector_model_->getPixelCenter(xpixel, ypixel);
-            auto in_pixel_um_x = static_cast<double>(Units::convert(inPixelPos.x(), "um"));
-            auto in_pixel_um_y = static_cast<double>(Units::convert(inPixelPos.y(), "um"));
-            auto in_pixel_um_z = static_cast<double>(Units::convert(position.z(), "um"));
-            deposition_position_xy->Fill(in_pixel_um_x, in_pixel_um_y);
-            deposition_position_xz->Fill(in_pixel_um_x, in_pixel_um_z);
-            deposition_position_yz->Fill(in_pixel_um_y, in_pixel_um_z);
+        position = ref;
+        if(scan_x_) {
+            position.SetX(voxel_.x() * static_cast<double>(voxel % root_) + ref.x());
+            if(scan_y_) {
+                position.SetY(voxel_.y() * static_cast<double>((voxel / root_) % root_) + ref.y());
+            } else if(scan_z_) {
+                position.SetZ(voxel_.z() * static_cast<double>((voxel / root_) % root_) + ref.z());
+            }
+        } else if(scan_y_) {
+            position.SetY(voxel_.y() * static_cast<double>(voxel % root_) + ref.y());
+            if(scan_z_) {
+                position.SetZ(voxel_.z() * static_cast<double>((voxel / root_) % root_) + ref.z());
+            }
+        } else {
+            position.SetZ(voxel_.z() * static_cast<double>(voxel % root_) + ref.z());
         }
     }
+    return position;
+}
+
+ROOT::Math::XYZVector DepositionPointChargeModule::SpotOffset(Event* event) const {
+    if(sobol_.has_value()) {
+        auto point = sobol_->point(event->number);
+        return ROOT::Math::XYZVector(ROOT::Math::normal_quantile(point[0], spot_size_),
+                                     ROOT::Math::normal_quantile(point[1], spot_size_),
+                                     ROOT::Math::normal_quantile(point[2], spot_size_));
+    }
+
+    // Calculate random offset from configured position
+    double dx = allpix::normal_distribution<double>(0, spot_size_)(event->getRandomEngine());
+    double dy = allpix::normal_distribution<double>(0, spot_size_)(event->getRandomEngine());
+    double dz = allpix::normal_distribution<double>(0, spot_size_)(event->getRandomEngine());
+    return {dx, dy, dz};
+}
+
+ROOT::Math::XYZPoint DepositionPointChargeModule::RandomPosition(Event* event) const {
+    auto& random_engine = event->getRandomEngine();
+    const auto sample_z = (type_ == SourceType::POINT);
+
+    // Quasi-random points are indexed by the event number, the last dimension selects the biased region
+    std::array<double, SobolSequence::max_dimensions> point{};
+    if(sobol_.has_value()) {
+        point = sobol_->point(event->number);
+    }
+    auto uniform = [&](double size, size_t dim) {
+        if(sobol_.has_value()) {
+            return (point[dim] - 0.5) * size;
+        }
+        return allpix::uniform_real_distribution<double>(-size / 2, size / 2)(random_engine);
+    };
+    auto sample = [&](const ROOT::Math::XYZVector& size) {
+        return ROOT::Math::XYZVector(uniform(size.x(), 0), uniform(size.y(), 1), sample_z ? uniform(size.z(), 2) : 0.);
+    };
+
+    // Without biasing, sample uniformly within the pixel cell
+    if(bias_fraction_ <= 0.) {
+        return cell_center_ + sample(cell_size_);
+    }
+
+    // Sample from the mixture of a uniform distribution in the biased region and one in the full pixel cell
+    ROOT::Math::XYZVector offset;
+    auto choice = (sobol_.has_value() ? point[3] : allpix::uniform_real_distribution<double>(0., 1.)(random_engine));
+    if(choice < bias_fraction_) {
+        offset = bias_region_position_ + sample(bias_region_size_);
+    } else {
+        offset = sample(cell_size_);
+    }
+
+    // Weight the event with the ratio of the uniform to the sampled probability density at this position
+    auto distance = offset - bias_region_position_;
+    auto in_region = std::fabs(distance.x()) <= bias_region_size_.x() / 2 &&
+                     std::fabs(distance.y()) <= bias_region_size_.y() / 2 &&
+                     (!sample_z || std::fabs(distance.z()) <= bias_region_size_.z() / 2);
+    auto weight = 1. / (1. - bias_fraction_ + (in_region ? bias_fraction_ * bias_volume_ratio_ : 0.));
+    LOG(DEBUG) << "Biased deposition " << (in_region ? "inside" : "outside") << " of the region, weight " << weight;
+    event->setWeight(event->getWeight() * weight);
+
+    return cell_center_ + offset;
 }
 
 void DepositionPointChargeModule::finalize() {
@@ -293,11 +503,9 @@ void DepositionPointChargeModule::finalize() {
     }
 }
 
-void DepositionPointChargeModule::DepositPoint(Event* event, const ROOT::Math::XYZPoint& position) {
-    // Vector of deposited charges and their "MCParticle"
-    std::vector<DepositedCharge> charges;
-    std::vector<MCParticle> mcparticles;
-
+void DepositionPointChargeModule::DepositPoint(const ROOT::Math::XYZPoint& position,
+                                               std::vector<DepositedCharge>& charges,
+                                               std::vector<MCParticle>& mcparticles) {
     LOG(DEBUG) << "Position (local coordinates): " << Units::display(position, {"um", "mm"});
     // Cross-check calculated position to be within sensor:
     if(!detector_model_->isWithinSensor(position)) {
@@ -318,20 +526,11 @@ void DepositionPointChargeModule::DepositPoint(Event* event, const ROOT::Math::X
     charges.emplace_back(position, position_global, CarrierType::HOLE, carriers_, 0., 0., &(mcparticles.back()));
     LOG(DEBUG) << "Deposited " << carriers_ << " charge carriers of both types at global position "
                << Units::display(position_global, {"um", "mm"}) << " in detector " << detector_->getName();
-
-    // Dispatch the messages to the framework
-    auto mcparticle_message = std::make_shared<MCParticleMessage>(std::move(mcparticles), detector_);
-    messenger_->dispatchMessage(this, std::move(mcparticle_message), event);
-
-    auto deposit_message = std::make_shared<DepositedChargeMessage>(std::move(charges), detector_);
-    messenger_->dispatchMessage(this, std::move(deposit_message), event);
 }
 
-void DepositionPointChargeModule::DepositLine(Event* event, const ROOT::Math::XYZPoint& position) {
-    // Vector of deposited charges and their "MCParticle"
-    std::vector<DepositedCharge> charges;
-    std::vector<MCParticle> mcparticles;
-
+void DepositionPointChargeModule::DepositLine(const ROOT::Math::XYZPoint& position,
+                                              std::vector<DepositedCharge>& charges,
+                                              std::vector<MCParticle>& mcparticles) {
     // Cross-check calculated position to be within sensor:
     if(!detector_model_->isWithinSensor(position)) {
         LOG(DEBUG) << "Requested position is outside active sensor volume.";
@@ -381,13 +580,6 @@ void DepositionPointChargeModule::DepositLine(Event* event, const ROOT::Math::XY
 
         position_local += step_size_ * mip_direction_;
     }
-
-    // Dispatch the messages to the framework
-    auto mcparticle_message = std::make_shared<MCParticleMessage>(std::move(mcparticles), detector_);
-    messenger_->dispatchMessage(this, std::move(mcparticle_message), event);
-
-    auto deposit_message = std::make_shared<DepositedChargeMessage>(std::move(charges), detector_);
-    messenger_->dispatchMessage(this, std::move(deposit_message), event);
 }
 
 std::tuple<ROOT::Math::XYZPoint, ROOT::Math::XYZPoint>
@@ -9,11 +9,16 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <optional>
 #include <string>
+#include <vector>
 
 #include <TH2D.h>
 
 #include "core/module/Module.hpp"
+#include "core/utils/quasi_random.h"
+#include "objects/DepositedCharge.hpp"
+#include "objects/MCParticle.hpp"
 
 namespace allpix {
     /**
@@ -27,9 +32,10 @@ namespace allpix {
          * @brief Types of deposition
          */
         enum class DepositionModel {
-            FIXED, ///< Deposition at a specific point
-            SCAN,  ///< Scan through the volume of a pixel
-            SPOT,  ///< Deposition around fixed position with Gaussian profile
+            FIXED,  ///< Deposition at a specific point
+            SCAN,   ///< Scan through the volume of a pixel
+            SPOT,   ///< Deposition around fixed position with Gaussian profile
+            RANDOM, ///< Random deposition within the volume of a pixel, optionally biased towards a sub-volume
         };
 
         /**
@@ -40,6 +46,14 @@ namespace allpix {
             MIP,   ///< MIP-like linear deposition of charge carrier
         };
 
+        /**
+         * @brief Methods to sample the positions of the spot, random and scan models
+         */
+        enum class SamplingMethod {
+            PSEUDO_RANDOM, ///< Pseudo-random numbers from the event random number generator
+            SOBOL,         ///< Sobol sequence indexed by the event number
+        };
+
     public:
         /**
          * @brief Constructor for a module to deposit charges at a specific point in the detector's active sensor volume
@@ -65,19 +79,32 @@ namespace allpix {
         void finalize() override;
 
     private:
+        /**
+         * @brief Helper function to calculate the position of a voxel of the scan
+         * @param voxel Index of the voxel
+         * @return Position of the voxel in local coordinates, within the scanned pixel cell
+         */
+        ROOT::Math::XYZPoint ScanPosition(uint64_t voxel) const;
+
         /**
          * @brief Helper function to deposit charges at a single point
-         * @param event Pointer to current event
          * @param position
+         * @param charges Deposited charges of the event to append to
+         * @param mcparticles Monte Carlo particles of the event to append to, with capacity for the new particle
          */
-        void DepositPoint(Event*, const ROOT::Math::XYZPoint& position);
+        void DepositPoint(const ROOT::Math::XYZPoint& position,
+                          std::vector<DepositedCharge>& charges,
+                          std::vector<MCParticle>& mcparticles);
 
         /**
          * @brief Helper function to deposit charges along a line
-         * @param event Pointer to current event
          * @param position
+         * @param charges Deposited charges of the event to append to
+         * @param mcparticles Monte Carlo particles of the event to append to, with capacity for the new particle
          */
-        void DepositLine(Event*, const ROOT::Math::XYZPoint& position);
+        void DepositLine(const ROOT::Math::XYZPoint& position,
+                         std::vector<DepositedCharge>& charges,
+                         std::vector<MCParticle>& mcparticles);
 
         /**
          * @brief Finds and returns the points where a line with mip_direction through a given point intersects the sensor
@@ -89,6 +116,20 @@ namespace allpix {
         std::tuple<ROOT::Math::XYZPoint, ROOT::Math::XYZPoint>
         SensorIntersection(const ROOT::Math::XYZPoint& line_origin) const;
 
+        /**
+         * @brief Helper function to sample a random position within the pixel cell
+         * @param event Event to take the random engine from and to apply the weight of a biased sample to
+         * @return Position in local coordinates
+         */
+        ROOT::Math::XYZPoint RandomPosition(Event* event) const;
+
+        /**
+         * @brief Helper function to sample the offset of the spot model from the configured position
+         * @param event Event to take the random engine or the index of the quasi-random point from
+         * @return Offset from the configured position
+         */
+        ROOT::Math::XYZVector SpotOffset(Event* event) const;
+
         Messenger* messenger_;
 
         std::shared_ptr<Detector> detector_;
@@ -96,6 +137,8 @@ namespace allpix {
 
         DepositionModel model_;
         SourceType type_;
+        SamplingMethod sampling_;
+        std::optional<SobolSequence> sobol_;
         double spot_size_{};
         ROOT::Math::XYZVector voxel_;
         double step_size_{};
@@ -104,6 +147,17 @@ namespace allpix {
         ROOT::Math::XYZVector mip_direction_{};
         std::vector<std::string> scan_coordinates_{};
         size_t no_of_coordinates_;
+        unsigned int voxels_per_event_{1};
+        unsigned int pixel_spacing_{};
+        unsigned int cells_per_row_{1};
+
+        // Pixel cell of the random deposition and sub-volume it is biased towards
+        ROOT::Math::XYZPoint cell_center_{};
+        ROOT::Math::XYZVector cell_size_{};
+        double bias_fraction_{};
+        ROOT::Math::XYZVector bias_region_size_{};
+        ROOT::Math::XYZVector bias_region_position_{};
+        double bias_volume_ratio_{1.};
 
         bool scan_x_;
         bool scan_y_;
@@ -11,15 +11,66 @@
 
 #include "DepositionReaderModule.hpp"
 
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
 #include <string>
+#include <type_traits>
 #include <utility>
 
 #include "core/utils/distributions.h"
 #include "core/utils/log.h"
 #include "physics/MaterialProperties.hpp"
+#include "tools/ROOT.h"
 
 using namespace allpix;
 
+namespace {
+    // Remove leading and trailing whitespace without copying
+    std::string_view trim_view(std::string_view str) {
+        const auto* whitespace = " \t\n\r\v";
+        auto begin = str.find_first_not_of(whitespace);
+        if(begin == std::string_view::npos) {
+            return {};
+        }
+        return str.substr(begin, str.find_last_not_of(whitespace) - begin + 1);
+    }
+
+    // Convert a trimmed field to a number, leaving the value unchanged if the field cannot be parsed
+    template <typename T> void parse_field(std::string_view field, T& value) {
+        field = trim_view(field);
+        if constexpr(std::is_floating_point_v<T>) {
+#if defined(__cpp_lib_to_chars)
+            std::from_chars(field.data(), field.data() + field.size(), value);
+#else
+            // Floating point conversion of std::from_chars is not available in all supported standard libraries
+            std::string copy(field);
+            char* end = nullptr;
+            auto result = std::strtod(copy.c_str(), &end);
+            if(end != copy.c_str()) {
+                value = result;
+            }
+#endif
+        } else {
+            std::from_chars(field.data(), field.data() + field.size(), value);
+        }
+    }
+
+    // Split off the next comma-separated field from the line
+    std::string_view next_field(std::string_view& line) {
+        auto end = line.find(',');
+        auto field = line.substr(0, end);
+        line = (end == std::string_view::npos ? std::string_view() : line.substr(end + 1));
+        return field;
+    }
+} // namespace
+
 DepositionReaderModule::DepositionReaderModule(Configuration& config, Messenger* messenger, GeometryManager* geo_manager)
     : SequentialModule(config), geo_manager_(geo_manager), messenger_(messenger) {
     // Enable multithreading of this module if multithreading is enabled
@@ -75,24 +126,16 @@ void DepositionReaderModule::initialize() {
     if(file_model_ == FileModel::CSV) {
         // Open the file with the objects
         auto file_path = config_.getPathWithExtension("file_name", "csv", true);
-        input_file_ = std::make_unique<std::ifstream>(file_path);
+        input_file_ = std::make_unique<std::ifstream>(file_path, std::ios::binary);
         if(!input_file_->is_open()) {
             throw InvalidValueError(config_, "file_name", "could not open input file");
         }
+
+        // Read the file in large blocks ahead of parsing
+        csv_prefetch_thread_ = std::thread(&DepositionReaderModule::prefetch_csv_blocks, this);
     } else if(file_model_ == FileModel::ROOT) {
-        auto file_path = config_.getPathWithExtension("file_name", "root", true);
-        input_file_root_ = std::make_unique<TFile>(file_path.c_str(), "READ");
-        if(!input_file_root_->IsOpen()) {
-            throw InvalidValueError(config_, "file_name", "could not open input file");
-        }
-        input_file_root_->cd();
-        auto tree = config_.get<std::string>("tree_name");
-        tree_reader_ = std::make_shared<TTreeReader>(tree.c_str(), input_file_root_.get());
-        if(tree_reader_->GetEntryStatus() == TTreeReader::kEntryNoTree) {
-            throw InvalidValueError(config_, "tree_name", "could not open tree");
-        }
-        LOG(INFO) << "Initialized tree reader for tree " << tree << ", found " << tree_reader_->GetEntries(false)
-                  << " entries";
+        root_file_path_ = config_.getPathWithExtension("file_name", "root", true);
+        tree_name_ = config_.get<std::string>("tree_name");
 
         // Check if we have branch names configured and use the default values otherwise:
         auto branch_list = config_.getArray<std::string>("branch_names");
@@ -109,60 +152,36 @@ void DepositionReaderModule::initialize() {
 
         // Convert list to map for easier lookup:
         size_t it = (time_available_ ? 3 : 2);
-        std::map<std::string, std::string> branches = {{"event", branch_list.at(0)},
-                                                       {"energy", branch_list.at(1)},
-                                                       {"px", branch_list.at(it++)},
-                                                       {"py", branch_list.at(it++)},
-                                                       {"pz", branch_list.at(it++)},
-                                                       {"volume", branch_list.at(it++)},
-                                                       {"pdg", branch_list.at(it++)}};
+        branches_ = {{"event", branch_list.at(0)},
+                     {"energy", branch_list.at(1)},
+                     {"px", branch_list.at(it++)},
+                     {"py", branch_list.at(it++)},
+                     {"pz", branch_list.at(it++)},
+                     {"volume", branch_list.at(it++)},
+                     {"pdg", branch_list.at(it++)}};
         if(time_available_) {
-            branches["time"] = branch_list.at(2);
+            branches_["time"] = branch_list.at(2);
         }
         if(create_mcparticles_) {
-            branches["track_id"] = branch_list.at(it++);
-            branches["parent_id"] = branch_list.at(it++);
+            branches_["track_id"] = branch_list.at(it++);
+            branches_["parent_id"] = branch_list.at(it++);
         }
 
         LOG(DEBUG) << "List of configured branches and their names:";
-        for(const auto& branch : branches) {
+        for(const auto& branch : branches_) {
             LOG(DEBUG) << branch.first << ": \"" << branch.second << "\"";
         }
 
-        // Set up branch pointers
-        create_tree_reader(event_, branches.at("event"));
-        create_tree_reader(edep_, branches.at("energy"));
-        if(time_available_) {
-            create_tree_reader(time_, branches.at("time"));
-        }
-        create_tree_reader(px_, branches.at("px"));
-        create_tree_reader(py_, branches.at("py"));
-        create_tree_reader(pz_, branches.at("pz"));
-        create_tree_reader(volume_, branches.at("volume"));
-        create_tree_reader(pdg_code_, branches.at("pdg"));
-        if(create_mcparticles_) {
-            create_tree_reader(track_id_, branches.at("track_id"));
-            create_tree_reader(parent_id_, branches.at("parent_id"));
-        }
-
-        // Advance to first entry of the tree:
-        tree_reader_->Next();
+        // Open the input for the first thread and check all branches
+        tree_input_ = open_tree_input();
+        tree_entries_ = tree_input_->tree_reader->GetEntries(false);
+        LOG(INFO) << "Initialized tree reader for tree " << tree_name_ << ", found " << tree_entries_ << " entries";
 
-        // Only after loading the first entry we can actually check the branch status:
-        check_tree_reader(event_);
-        check_tree_reader(edep_);
-        if(time_available_) {
-            check_tree_reader(time_);
-        }
-        check_tree_reader(px_);
-        check_tree_reader(py_);
-        check_tree_reader(pz_);
-        check_tree_reader(volume_);
-        check_tree_reader(pdg_code_);
-        if(create_mcparticles_) {
-            check_tree_reader(track_id_);
-            check_tree_reader(parent_id_);
-        }
+        // With the entries of all events known, the events can be read in any order
+        build_event_index();
+        waive_sequence_requirement();
+    } else if(file_model_ == FileModel::STREAM) {
+        open_stream();
     }
 
     // If requested, prepare output plots
@@ -196,8 +215,8 @@ void DepositionReaderModule::initialize() {
 }
 
 template <typename T>
-void DepositionReaderModule::create_tree_reader(std::shared_ptr<T>& branch_ptr, const std::string& name) {
-    branch_ptr = std::make_shared<T>(*tree_reader_, name.c_str());
+void DepositionReaderModule::create_tree_reader(TreeInput& input, std::shared_ptr<T>& branch_ptr, const std::string& name) {
+    branch_ptr = std::make_shared<T>(*input.tree_reader, name.c_str());
 }
 
 template <typename T> void DepositionReaderModule::check_tree_reader(std::shared_ptr<T> branch_ptr) {
@@ -207,6 +226,114 @@ template <typename T> void DepositionReaderModule::check_tree_reader(std::shared
     }
 }
 
+std::unique_ptr<DepositionReaderModule::TreeInput> DepositionReaderModule::open_tree_input() {
+    auto input = std::make_unique<TreeInput>();
+    input->file = std::make_unique<TFile>(root_file_path_.c_str(), "READ");
+    if(!input->file->IsOpen()) {
+        throw InvalidValueError(config_, "file_name", "could not open input file");
+    }
+    input->file->cd();
+    input->tree_reader = std::make_shared<TTreeReader>(tree_name_.c_str(), input->file.get());
+    if(input->tree_reader->GetEntryStatus() == TTreeReader::kEntryNoTree) {
+        throw InvalidValueError(config_, "tree_name", "could not open tree");
+    }
+
+    // Set up branch pointers
+    create_tree_reader(*input, input->event, branches_.at("event"));
+    create_tree_reader(*input, input->edep, branches_.at("energy"));
+    if(time_available_) {
+        create_tree_reader(*input, input->time, branches_.at("time"));
+    }
+    create_tree_reader(*input, input->px, branches_.at("px"));
+    create_tree_reader(*input, input->py, branches_.at("py"));
+    create_tree_reader(*input, input->pz, branches_.at("pz"));
+    create_tree_reader(*input, input->volume, branches_.at("volume"));
+    create_tree_reader(*input, input->pdg_code, branches_.at("pdg"));
+    if(create_mcparticles_) {
+        create_tree_reader(*input, input->track_id, branches_.at("track_id"));
+        create_tree_reader(*input, input->parent_id, branches_.at("parent_id"));
+    }
+
+    // Advance to first entry of the tree:
+    input->tree_reader->Next();
+
+    // Only after loading the first entry we can actually check the branch status:
+    check_tree_reader(input->event);
+    check_tree_reader(input->edep);
+    if(time_available_) {
+        check_tree_reader(input->time);
+    }
+    check_tree_reader(input->px);
+    check_tree_reader(input->py);
+    check_tree_reader(input->pz);
+    check_tree_reader(input->volume);
+    check_tree_reader(input->pdg_code);
+    if(create_mcparticles_) {
+        check_tree_reader(input->track_id);
+        check_tree_reader(input->parent_id);
+    }
+    return input;
+}
+
+DepositionReaderModule::TreeInput& DepositionReaderModule::tree_input() {
+    std::lock_guard<std::mutex> lock(inputs_mutex_);
+    auto& input = thread_inputs_[std::this_thread::get_id()];
+    if(input == nullptr) {
+        // The first thread takes over the input opened during initialization
+        if(tree_input_ != nullptr) {
+            input = std::move(tree_input_);
+        } else {
+            auto root_lock = root_process_lock();
+            input = open_tree_input();
+        }
+    }
+    return *input;
+}
+
+void DepositionReaderModule::build_event_index() {
+    // Only read the branch with the event id, using a separate file to leave the branches of the input untouched
+    TFile file(root_file_path_.c_str(), "READ");
+    TTreeReader reader(tree_name_.c_str(), &file);
+    TTreeReaderValue<int> event_id(reader, branches_.at("event").c_str());
+
+    Long64_t block_start = 0;
+    int64_t block_id = -1;
+    auto close_block = [&](Long64_t block_end) {
+        if(block_end == block_start) {
+            return;
+        }
+        // Sequential events are indexed by their id, otherwise by the position of the block
+        auto key = (require_sequential_events_ ? static_cast<uint64_t>(block_id) : event_index_.size());
+        if(require_sequential_events_ && !event_index_.empty() && key <= event_index_.rbegin()->first) {
+            throw InvalidValueError(config_,
+                                    "require_sequential_events",
+                                    "event " + std::to_string(block_id) + " is not stored in ascending order");
+        }
+        event_index_[key] = {block_start, block_end};
+    };
+    while(reader.Next()) {
+        auto entry = reader.GetCurrentEntry();
+        if(static_cast<int64_t>(*event_id) != block_id) {
+            close_block(entry);
+            block_start = entry;
+            block_id = *event_id;
+        }
+    }
+    close_block(tree_entries_);
+    LOG(DEBUG) << "Indexed " << event_index_.size() << " events in " << tree_entries_ << " tree entries";
+}
+
+std::pair<Long64_t, Long64_t> DepositionReaderModule::event_entries(uint64_t event_num) const {
+    auto key = event_num - 1;
+    if(event_index_.empty() || key > event_index_.rbegin()->first) {
+        throw EndOfRunException("Requesting end of run: end of tree reached");
+    }
+
+    // Events without entries are empty
+    auto it = event_index_.find(key);
+    return (it == event_index_.end() ? std::pair<Long64_t, Long64_t>(0, 0) : it->second);
+}
+
 void DepositionReaderModule::run(Event* event) {
     auto event_num = event->number;
 
@@ -226,11 +353,34 @@ void DepositionReaderModule::run(Event* event) {
     std::map<std::shared_ptr<Detector>, std::map<int, size_t>> track_id_to_mcparticle;
 
     LOG(DEBUG) << "Start reading event " << event_num;
-    int64_t curr_event_id = -1;
     bool end_of_run = false;
     std::string eof_message;
 
-    while(true) {
+    // Look up the range of tree entries of this event
+    TreeInput* input = nullptr;
+    std::pair<Long64_t, Long64_t> entries{};
+    if(file_model_ == FileModel::ROOT) {
+        input = &tree_input();
+        try {
+            entries = event_entries(event_num);
+        } catch(EndOfRunException& e) {
+            end_of_run = true;
+            eof_message = e.what();
+        }
+    }
+    auto entry = entries.first;
+
+    // Receive all deposits of this event from the stream
+    if(file_model_ == FileModel::STREAM) {
+        try {
+            receive_stream_event(event_num);
+        } catch(EndOfRunException& e) {
+            end_of_run = true;
+            eof_message = e.what();
+        }
+    }
+
+    while(!end_of_run) {
         bool read_status = false;
         ROOT::Math::XYZPoint global_position;
         std::string volume;
@@ -242,7 +392,9 @@ void DepositionReaderModule::run(Event* event) {
                 read_status = read_csv(event_num, volume, global_position, time, energy, pdg_code, track_id, parent_id);
             } else if(file_model_ == FileModel::ROOT) {
                 read_status = read_root(
-                    event_num, curr_event_id, volume, global_position, time, energy, pdg_code, track_id, parent_id);
+                    *input, entry, entries.second, volume, global_position, time, energy, pdg_code, track_id, parent_id);
+            } else if(file_model_ == FileModel::STREAM) {
+                read_status = read_stream(volume, global_position, time, energy, pdg_code, track_id, parent_id);
             }
         } catch(EndOfRunException& e) {
             end_of_run = true;
@@ -322,6 +474,12 @@ void DepositionReaderModule::run(Event* event) {
 
     LOG(INFO) << "Finished reading event " << event;
 
+    // Request end of run after the last event of the tree
+    if(file_model_ == FileModel::ROOT && !end_of_run && entries.second == tree_entries_) {
+        end_of_run = true;
+        eof_message = "Requesting end of run: end of tree reached";
+    }
+
     double time_reference = 0;
 
     // Loop over all known detectors and dispatch messages for them
@@ -432,8 +590,9 @@ void DepositionReaderModule::finalize() {
         }
     }
 }
-bool DepositionReaderModule::read_root(uint64_t event_num,
-                                       int64_t& curr_event_id,
+bool DepositionReaderModule::read_root(TreeInput& input,
+                                       Long64_t& entry,
+                                       Long64_t end_entry,
                                        std::string& volume,
                                        ROOT::Math::XYZPoint& position,
                                        double& time,
@@ -442,56 +601,230 @@ bool DepositionReaderModule::read_root(uint64_t event_num,
                                        int& track_id,
                                        int& parent_id) {
 
-    auto status = tree_reader_->GetEntryStatus();
-    if(status == TTreeReader::kEntryNotFound || status == TTreeReader::kEntryBeyondEnd) {
-        throw EndOfRunException("Requesting end of run: end of tree reached");
-    } else if(status != TTreeReader::kEntryValid) {
+    // Return at the end of the entries of this event
+    if(entry >= end_entry) {
+        return false;
+    }
+    auto status = input.tree_reader->SetEntry(entry++);
+    if(status != TTreeReader::kEntryValid) {
         throw EndOfRunException("Problem reading from tree, error: " + std::to_string(static_cast<int>(status)));
     }
 
-    if(require_sequential_events_) {
-        // sequential read, return if eventID is larger than allpix-squared event number
-        if(static_cast<uint64_t>(*event_->Get()) > event_num - 1) {
-            return false;
+    // Read detector name
+    volume = std::string(static_cast<char*>(input.volume->GetAddress()));
+
+    // Read other information, interpret in framework units:
+    position = ROOT::Math::XYZPoint(Units::get(*input.px->Get(), unit_length_),
+                                    Units::get(*input.py->Get(), unit_length_),
+                                    Units::get(*input.pz->Get(), unit_length_));
+
+    // Attempt to read time only if available:
+    time = (time_available_ ? Units::get(*input.time->Get(), unit_time_) : 0);
+    energy = Units::get(*input.edep->Get(), unit_energy_);
+
+    // Read PDG code and track ids
+    pdg_code = (*input.pdg_code->Get());
+    if(create_mcparticles_) {
+        track_id = (*input.track_id->Get());
+        parent_id = (*input.parent_id->Get());
+    }
+    return true;
+}
+
+DepositionReaderModule::~DepositionReaderModule() {
+    if(csv_prefetch_thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(csv_mutex_);
+            csv_stop_ = true;
         }
-    } else {
-        // non-sequential read, return if eventID changes (requires events to be in blocks)
-        if(curr_event_id == -1) {
-            // first entry in event, save eventID for later
-            curr_event_id = *event_->Get();
-            LOG(TRACE) << "Read eventID " << curr_event_id;
-        } else {
-            // check if eventID changed compared to last entry, if yes reset curr_event_id
-            if(*event_->Get() != curr_event_id) {
-                curr_event_id = -1;
+        csv_cv_.notify_all();
+        csv_prefetch_thread_.join();
+    }
+    if(stream_socket_ >= 0) {
+        ::close(stream_socket_);
+    }
+}
+
+/**
+ * The module listens on the socket and waits for a single producer to connect. The socket file is removed once the
+ * producer is connected. Flow control is provided by the socket itself: the producer blocks while the receive buffer is
+ * full and the module blocks while it waits for the deposits of the next event.
+ */
+void DepositionReaderModule::open_stream() {
+    auto socket_path = config_.getPath("file_name").string();
+    sockaddr_un address{};
+    if(socket_path.size() >= sizeof(address.sun_path)) {
+        throw InvalidValueError(config_, "file_name", "socket path is too long");
+    }
+    address.sun_family = AF_UNIX;
+    socket_path.copy(address.sun_path, socket_path.size());
+
+    int server = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if(server < 0) {
+        throw ModuleError("Cannot create socket: " + std::string(std::strerror(errno)));
+    }
+    std::filesystem::remove(socket_path);
+    if(::bind(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(server, 1) != 0) { // NOLINT
+        auto error = std::string(std::strerror(errno));
+        ::close(server);
+        throw InvalidValueError(config_, "file_name", "cannot listen on socket: " + error);
+    }
+
+    LOG(STATUS) << "Waiting for the producer of the deposits to connect to socket " << socket_path;
+    stream_socket_ = ::accept(server, nullptr, nullptr);
+    auto error = std::string(std::strerror(errno));
+    ::close(server);
+    std::filesystem::remove(socket_path);
+    if(stream_socket_ < 0) {
+        throw ModuleError("Cannot accept connection of the producer: " + error);
+    }
+
+    // A larger receive buffer lets the producer run further ahead of the simulation
+    if(config_.has("stream_buffer_size")) {
+        auto buffer_size = config_.get<int>("stream_buffer_size");
+        ::setsockopt(stream_socket_, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+    }
+    LOG(INFO) << "Producer of the deposits connected";
+}
+
+bool DepositionReaderModule::receive_stream(void* data, size_t size) {
+    auto* bytes = static_cast<char*>(data);
+    size_t received = 0;
+    while(received < size) {
+        auto count = ::recv(stream_socket_, bytes + received, size - received, MSG_WAITALL);
+        if(count < 0 && errno == EINTR) {
+            continue;
+        }
+        if(count < 0) {
+            throw ModuleError("Cannot receive deposits from the stream: " + std::string(std::strerror(errno)));
+        }
+        if(count == 0) {
+            // The producer may only close the stream between two events
+            if(received == 0) {
                 return false;
             }
+            throw ModuleError("Stream of deposits ended within a record");
         }
+        received += static_cast<size_t>(count);
     }
+    return true;
+}
 
-    // Read detector name
-    volume = std::string(static_cast<char*>(volume_->GetAddress()));
+void DepositionReaderModule::receive_stream_event(uint64_t event_num) {
+    stream_records_.clear();
+    stream_position_ = 0;
+    while(true) {
+        if(!stream_header_pending_) {
+            if(!receive_stream(&stream_header_, sizeof(stream_header_))) {
+                throw EndOfRunException("Requesting end of run, producer closed the stream before event " +
+                                        std::to_string(event_num));
+            }
+            if(stream_header_.magic != DepositionStreamHeader::magic_number) {
+                throw ModuleError("Invalid event header in the stream of deposits");
+            }
+            stream_header_pending_ = true;
+        }
 
-    // Read other information, interpret in framework units:
-    position = ROOT::Math::XYZPoint(
-        Units::get(*px_->Get(), unit_length_), Units::get(*py_->Get(), unit_length_), Units::get(*pz_->Get(), unit_length_));
+        // Events without deposits may be left out by the producer, the header then belongs to a later event
+        if(stream_header_.event + 1 > event_num) {
+            return;
+        }
 
-    // Attempt to read time only if available:
-    time = (time_available_ ? Units::get(*time_->Get(), unit_time_) : 0);
-    energy = Units::get(*edep_->Get(), unit_energy_);
+        // Receive the deposits directly into the records, deposits of skipped events are discarded
+        stream_records_.resize(stream_header_.deposits);
+        receive_stream(stream_records_.data(), stream_records_.size() * sizeof(DepositionStreamRecord));
+        stream_header_pending_ = false;
+        if(stream_header_.event + 1 == event_num) {
+            LOG(DEBUG) << "Received " << stream_records_.size() << " deposits of event " << stream_header_.event;
+            return;
+        }
+        stream_records_.clear();
+    }
+}
 
-    // Read PDG code and track ids
-    pdg_code = (*pdg_code_->Get());
+bool DepositionReaderModule::read_stream(std::string& volume,
+                                         ROOT::Math::XYZPoint& position,
+                                         double& time,
+                                         double& energy,
+                                         int& pdg_code,
+                                         int& track_id,
+                                         int& parent_id) {
+    if(stream_position_ >= stream_records_.size()) {
+        return false;
+    }
+    const auto& record = stream_records_[stream_position_++];
+
+    volume = std::string(record.detector, strnlen(record.detector, sizeof(record.detector)));
+    position = ROOT::Math::XYZPoint(Units::get(record.position[0], unit_length_),
+                                    Units::get(record.position[1], unit_length_),
+                                    Units::get(record.position[2], unit_length_));
+    time = (time_available_ ? Units::get(record.time, unit_time_) : 0);
+    energy = Units::get(record.energy, unit_energy_);
+    pdg_code = record.pdg_code;
     if(create_mcparticles_) {
-        track_id = (*track_id_->Get());
-        parent_id = (*parent_id_->Get());
+        track_id = record.track_id;
+        parent_id = record.parent_id;
     }
-
-    // Return and advance to next tree entry:
-    tree_reader_->Next();
     return true;
 }
 
+void DepositionReaderModule::prefetch_csv_blocks() {
+    while(true) {
+        std::string block(csv_block_size_, '\0');
+        input_file_->read(block.data(), static_cast<std::streamsize>(block.size()));
+        block.resize(static_cast<size_t>(input_file_->gcount()));
+
+        std::unique_lock<std::mutex> lock(csv_mutex_);
+        csv_cv_.wait(lock, [this]() { return csv_stop_ || csv_blocks_.size() < csv_prefetch_blocks_; });
+        if(csv_stop_) {
+            return;
+        }
+        if(!block.empty()) {
+            csv_blocks_.push_back(std::move(block));
+        }
+        csv_read_done_ = !(*input_file_);
+        lock.unlock();
+        csv_cv_.notify_all();
+
+        if(csv_read_done_) {
+            return;
+        }
+    }
+}
+
+bool DepositionReaderModule::next_csv_line(std::string_view& line) {
+    while(true) {
+        auto end = csv_buffer_.find('\n', csv_position_);
+        if(end != std::string::npos) {
+            line = std::string_view(csv_buffer_).substr(csv_position_, end - csv_position_);
+            csv_position_ = end + 1;
+            return true;
+        }
+
+        // Take the next block from the prefetching thread
+        std::unique_lock<std::mutex> lock(csv_mutex_);
+        csv_cv_.wait(lock, [this]() { return csv_read_done_ || !csv_blocks_.empty(); });
+        if(csv_blocks_.empty()) {
+            // Last line of the file without line break
+            if(csv_position_ < csv_buffer_.size()) {
+                line = std::string_view(csv_buffer_).substr(csv_position_);
+                csv_position_ = csv_buffer_.size();
+                return true;
+            }
+            return false;
+        }
+        auto block = std::move(csv_blocks_.front());
+        csv_blocks_.pop_front();
+        lock.unlock();
+        csv_cv_.notify_all();
+
+        // Keep the incomplete line in front of the new block
+        csv_buffer_.erase(0, csv_position_);
+        csv_buffer_ += block;
+        csv_position_ = 0;
+    }
+}
+
 bool DepositionReaderModule::read_csv(uint64_t event_num,
                                       std::string& volume,
                                       ROOT::Math::XYZPoint& position,
@@ -501,24 +834,24 @@ bool DepositionReaderModule::read_csv(uint64_t event_num,
                                       int& track_id,
                                       int& parent_id) {
 
-    std::string line, tmp;
+    std::string_view line;
     do { // NOLINT
         // Read input file line-by-line and trim whitespaces at beginning and end:
-        std::getline(*input_file_, line);
-        line = allpix::trim(line);
-        LOG(TRACE) << "Line read: " << line;
-
-        // Request end of run if we reached end of file:
-        if(input_file_->eof()) {
+        if(!next_csv_line(line)) {
+            // Request end of run if we reached end of file:
             throw EndOfRunException("Requesting end of run, CSV file only contains data for " + std::to_string(event_num) +
                                     " events");
         }
+        line = trim_view(line);
+        LOG(TRACE) << "Line read: " << line;
 
         // Check for event header:
-        if(line.front() == 'E') {
-            std::stringstream lse(line);
+        if(!line.empty() && line.front() == 'E') {
             uint64_t event_read = 0;
-            lse >> tmp >> event_read;
+            auto number = line.find_first_of(" \t");
+            if(number != std::string_view::npos) {
+                parse_field(line.substr(number), event_read);
+            }
             if(event_read + 1 > event_num) {
                 return false;
             }
@@ -527,35 +860,20 @@ bool DepositionReaderModule::read_csv(uint64_t event_num,
         }
     } while(line.empty() || line.front() == '#' || line.front() == 'E');
 
-    std::istringstream ls(line);
     double px = NAN, py = NAN, pz = NAN;
 
-    std::getline(ls, tmp, ',');
-    std::istringstream(tmp) >> pdg_code;
-
+    parse_field(next_field(line), pdg_code);
     if(time_available_) {
-        std::getline(ls, tmp, ',');
-        std::istringstream(tmp) >> time;
+        parse_field(next_field(line), time);
     }
-
-    std::getline(ls, tmp, ',');
-    std::istringstream(tmp) >> energy;
-
-    std::getline(ls, tmp, ',');
-    std::istringstream(tmp) >> px;
-    std::getline(ls, tmp, ',');
-    std::istringstream(tmp) >> py;
-    std::getline(ls, tmp, ',');
-    std::istringstream(tmp) >> pz;
-
-    std::getline(ls, volume, ',');
-    volume = allpix::trim(volume);
-
+    parse_field(next_field(line), energy);
+    parse_field(next_field(line), px);
+    parse_field(next_field(line), py);
+    parse_field(next_field(line), pz);
+    volume = std::string(trim_view(next_field(line)));
     if(create_mcparticles_) {
-        std::getline(ls, tmp, ',');
-        std::istringstream(tmp) >> track_id;
-        std::getline(ls, tmp, ',');
-        std::istringstream(tmp) >> parent_id;
+        parse_field(next_field(line), track_id);
+        parse_field(next_field(line), parent_id);
     }
 
     // Calculate the charge deposit at a global position and convert the proper units
@@ -14,9 +14,15 @@
  * Refer to the User's Manual for more details.
  */
 
+#include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <functional>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 #include <TFile.h>
 #include <TH1D.h>
@@ -29,6 +35,8 @@
 #include "core/module/Module.hpp"
 #include "objects/DepositedCharge.hpp"
 
+#include "DepositionStream.hpp"
+
 namespace allpix {
     /**
      * @ingroup Modules
@@ -44,8 +52,9 @@ namespace allpix {
          * @brief Different implemented file models
          */
         enum class FileModel {
-            ROOT, ///< ROOT Trees
-            CSV,  ///< Comma-separated value files
+            ROOT,   ///< ROOT Trees
+            CSV,    ///< Comma-separated value files
+            STREAM, ///< Binary records received from an external producer on a Unix domain socket
         };
 
     public:
@@ -57,6 +66,11 @@ namespace allpix {
          */
         DepositionReaderModule(Configuration& config, Messenger* messenger, GeometryManager* geo_manager);
 
+        /**
+         * @brief Stop the thread prefetching blocks of the CSV file and close the stream
+         */
+        ~DepositionReaderModule() override;
+
         /**
          * @brief Initialize the input file stream
          */
@@ -79,24 +93,70 @@ namespace allpix {
 
         // File containing the input data
         std::unique_ptr<std::ifstream> input_file_;
-        std::unique_ptr<TFile> input_file_root_;
+
+        // Deposits of the current event received from the stream, read directly into the records
+        void open_stream();
+        void receive_stream_event(uint64_t event_num);
+        bool receive_stream(void* data, size_t size);
+        int stream_socket_{-1};
+        DepositionStreamHeader stream_header_;
+        bool stream_header_pending_{};
+        std::vector<DepositionStreamRecord> stream_records_;
+        size_t stream_position_{};
+
+        // Blocks of the CSV file read ahead by the prefetching thread
+        static constexpr size_t csv_block_size_ = 4 * 1024 * 1024;
+        static constexpr size_t csv_prefetch_blocks_ = 4;
+        void prefetch_csv_blocks();
+        bool next_csv_line(std::string_view& line);
+        std::thread csv_prefetch_thread_;
+        std::mutex csv_mutex_;
+        std::condition_variable csv_cv_;
+        std::deque<std::string> csv_blocks_;
+        bool csv_read_done_{};
+        bool csv_stop_{};
+        // Block currently parsed, starting with the incomplete last line of the previous block
+        std::string csv_buffer_;
+        size_t csv_position_{};
+
+        /**
+         * @brief Input file with a reader for all branches of the tree, opened once per thread reading events
+         */
+        struct TreeInput {
+            std::unique_ptr<TFile> file;
+            std::shared_ptr<TTreeReader> tree_reader;
+            std::shared_ptr<TTreeReaderValue<int>> event;
+            std::shared_ptr<TTreeReaderValue<double>> edep;
+            std::shared_ptr<TTreeReaderValue<double>> time;
+            std::shared_ptr<TTreeReaderValue<double>> px;
+            std::shared_ptr<TTreeReaderValue<double>> py;
+            std::shared_ptr<TTreeReaderValue<double>> pz;
+            std::shared_ptr<TTreeReaderArray<char>> volume;
+            std::shared_ptr<TTreeReaderValue<int>> pdg_code;
+            std::shared_ptr<TTreeReaderValue<int>> track_id;
+            std::shared_ptr<TTreeReaderValue<int>> parent_id;
+        };
 
         // Helper to create and check tree branches
-        template <typename T> void create_tree_reader(std::shared_ptr<T>& branch_ptr, const std::string& name);
+        template <typename T>
+        void create_tree_reader(TreeInput& input, std::shared_ptr<T>& branch_ptr, const std::string& name);
         template <typename T> void check_tree_reader(std::shared_ptr<T> branch_ptr);
 
-        // Set up branches:
-        std::shared_ptr<TTreeReader> tree_reader_;
-        std::shared_ptr<TTreeReaderValue<int>> event_;
-        std::shared_ptr<TTreeReaderValue<double>> edep_;
-        std::shared_ptr<TTreeReaderValue<double>> time_;
-        std::shared_ptr<TTreeReaderValue<double>> px_;
-        std::shared_ptr<TTreeReaderValue<double>> py_;
-        std::shared_ptr<TTreeReaderValue<double>> pz_;
-        std::shared_ptr<TTreeReaderArray<char>> volume_;
-        std::shared_ptr<TTreeReaderValue<int>> pdg_code_;
-        std::shared_ptr<TTreeReaderValue<int>> track_id_;
-        std::shared_ptr<TTreeReaderValue<int>> parent_id_;
+        // Open the input file and set up the branches
+        std::unique_ptr<TreeInput> open_tree_input();
+        TreeInput& tree_input();
+        std::string root_file_path_;
+        std::string tree_name_;
+        std::map<std::string, std::string> branches_;
+        std::unique_ptr<TreeInput> tree_input_;
+        std::map<std::thread::id, std::unique_ptr<TreeInput>> thread_inputs_;
+        std::mutex inputs_mutex_;
+
+        // Range of tree entries of every event, indexed by event id or by the position of the block of entries
+        void build_event_index();
+        std::pair<Long64_t, Long64_t> event_entries(uint64_t event_num) const;
+        std::map<uint64_t, std::pair<Long64_t, Long64_t>> event_index_;
+        Long64_t tree_entries_{};
         std::map<std::shared_ptr<Detector>, double> charge_creation_energy_;
         std::map<std::shared_ptr<Detector>, double> fano_factor_;
 
@@ -115,8 +175,16 @@ namespace allpix {
                       int& pdg_code,
                       int& track_id,
                       int& parent_id);
-        bool read_root(uint64_t event_num,
-                       int64_t& curr_event_id,
+        bool read_stream(std::string& volume,
+                         ROOT::Math::XYZPoint& position,
+                         double& time,
+                         double& energy,
+                         int& pdg_code,
+                         int& track_id,
+                         int& parent_id);
+        bool read_root(TreeInput& input,
+                       Long64_t& entry,
+                       Long64_t end_entry,
                        std::string& volume,
                        ROOT::Math::XYZPoint& position,
                        double& time,
@@ -0,0 +1,53 @@
+/**
+ * @file
+ * @brief Binary record layout of energy deposits streamed to the DepositionReader module
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ *
+ * This header only depends on the C++ standard library, such that external producers can include it to fill the stream.
+ */
+
+#ifndef ALLPIX_DEPOSITION_READER_STREAM_H
+#define ALLPIX_DEPOSITION_READER_STREAM_H
+
+#include <cstdint>
+
+namespace allpix {
+    /**
+     * @brief Header preceding the deposits of every event in the stream
+     */
+    struct DepositionStreamHeader {
+        // Magic number identifying the header, "APXD" in ASCII
+        static constexpr uint32_t magic_number = 0x44585041;
+
+        uint32_t magic{magic_number};
+        // Number of deposit records following the header
+        uint32_t deposits{};
+        // Event id, starting from zero
+        uint64_t event{};
+    };
+
+    /**
+     * @brief Single energy deposit, interpreted in the units configured for the module
+     */
+    struct DepositionStreamRecord {
+        double energy{};
+        double time{};
+        // Position in global coordinates of the setup
+        double position[3]{}; // NOLINT
+        int32_t pdg_code{};
+        int32_t track_id{};
+        int32_t parent_id{};
+        // Name of the detector or volume, zero-terminated unless all characters are used
+        char detector[44]{}; // NOLINT
+    };
+
+    static_assert(sizeof(DepositionStreamHeader) == 16, "unexpected padding of the stream header");
+    static_assert(sizeof(DepositionStreamRecord) == 96, "unexpected padding of the stream record");
+} // namespace allpix
+
+#endif /* ALLPIX_DEPOSITION_READER_STREAM_H */
@@ -0,0 +1,374 @@
+/**
+ * @file
+ * @brief Implementation of a fast deposition module transporting charged particles along straight tracks without Geant4
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "DepositionTelescopeModule.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <utility>
+
+#include "core/utils/distributions.h"
+#include "core/utils/log.h"
+#include "objects/DepositedCharge.hpp"
+#include "objects/MCParticle.hpp"
+#include "objects/MCTrack.hpp"
+#include "tools/landau_table.h"
+#include "tools/liang_barsky.h"
+
+using namespace allpix;
+
+namespace {
+    // Physical constants in framework-internal units
+    constexpr double electron_mass = 0.51099895;  // MeV
+    constexpr double speed_of_light = 299.792458; // mm/ns
+    constexpr double bethe_constant = 0.307075;   // MeV cm^2 / mol
+
+    /**
+     * @brief PDG code and mass of the supported charged particles, named as in Geant4
+     */
+    const std::map<std::string, std::pair<int, double>> particles = {
+        {"e-", {11, electron_mass}},
+        {"e+", {-11, electron_mass}},
+        {"mu-", {13, 105.6583755}},
+        {"mu+", {-13, 105.6583755}},
+        {"pi+", {211, 139.57039}},
+        {"pi-", {-211, 139.57039}},
+        {"kaon+", {321, 493.677}},
+        {"kaon-", {-321, 493.677}},
+        {"proton", {2212, 938.27208816}},
+        {"anti_proton", {-2212, 938.27208816}},
+    };
+
+    /**
+     * @brief Construct two unit vectors perpendicular to a direction and to each other
+     * @param direction Unit vector
+     * @return Pair of perpendicular unit vectors
+     */
+    std::pair<ROOT::Math::XYZVector, ROOT::Math::XYZVector> perpendicular_axes(const ROOT::Math::XYZVector& direction) {
+        auto reference = (std::fabs(direction.x()) < 0.9 ? ROOT::Math::XYZVector(1, 0, 0) : ROOT::Math::XYZVector(0, 1, 0));
+        auto first = direction.Cross(reference).Unit();
+        return {first, direction.Cross(first)};
+    }
+} // namespace
+
+DepositionTelescopeModule::DepositionTelescopeModule(Configuration& config,
+                                                     Messenger* messenger,
+                                                     GeometryManager* geo_manager)
+    : Module(config), messenger_(messenger), geo_manager_(geo_manager) {
+    // Enable multithreading of this module if multithreading is enabled
+    allow_multithreading();
+
+    config_.setDefault("source_energy_spread", 0.);
+    config_.setDefault("number_of_particles", 1);
+    config_.setDefault("beam_size", 0.);
+    config_.setDefault("beam_divergence", ROOT::Math::XYVector(0., 0.));
+    config_.setDefault("max_step_length", Units::get(1.0, "um"));
+    config_.setDefault("material_budget", 0.);
+
+    auto particle_type = config_.get<std::string>("particle_type");
+    std::transform(particle_type.begin(), particle_type.end(), particle_type.begin(), ::tolower);
+    auto particle = particles.find(particle_type);
+    if(particle == particles.end()) {
+        throw InvalidValueError(config_, "particle_type", "only singly charged leptons and hadrons are supported");
+    }
+    particle_code_ = particle->second.first;
+    mass_ = particle->second.second;
+    electron_ = (particle_code_ == 11);
+    positron_ = (particle_code_ == -11);
+
+    kinetic_energy_ = config_.get<double>("source_energy");
+    energy_spread_ = config_.get<double>("source_energy_spread");
+    if(kinetic_energy_ <= 0 || energy_spread_ < 0) {
+        throw InvalidValueError(config_, "source_energy", "energy has to be positive and its spread must not be negative");
+    }
+    number_of_particles_ = config_.get<unsigned int>("number_of_particles");
+
+    source_position_ = config_.get<ROOT::Math::XYZPoint>("source_position");
+    beam_direction_ = config_.get<ROOT::Math::XYZVector>("beam_direction");
+    if(beam_direction_.Mag2() == 0) {
+        throw InvalidValueError(config_, "beam_direction", "direction must not be a null vector");
+    }
+    beam_direction_ = beam_direction_.Unit();
+    beam_size_ = config_.get<double>("beam_size");
+    beam_divergence_ = config_.get<ROOT::Math::XYVector>("beam_divergence");
+
+    max_step_length_ = config_.get<double>("max_step_length");
+    if(max_step_length_ <= 0) {
+        throw InvalidValueError(config_, "max_step_length", "step length has to be positive");
+    }
+    material_budget_ = config_.get<double>("material_budget");
+    if(material_budget_ < 0) {
+        throw InvalidValueError(config_, "material_budget", "material budget must not be negative");
+    }
+}
+
+void DepositionTelescopeModule::initialize() {
+    for(auto& detector : geo_manager_->getDetectors()) {
+        auto material = detector->getModel()->getSensorMaterial();
+        auto properties = stopping_properties.find(material);
+        if(properties == stopping_properties.end()) {
+            throw ModuleError("No stopping properties available for the sensor material of detector " +
+                              detector->getName());
+        }
+
+        auto charge_creation_energy = (config_.has("charge_creation_energy")
+                                           ? config_.get<double>("charge_creation_energy")
+                                           : allpix::ionization_energies[material]);
+        auto fano_factor =
+            (config_.has("fano_factor") ? config_.get<double>("fano_factor") : allpix::fano_factors[material]);
+        LOG(DEBUG) << "Detector " << detector->getName() << " uses charge creation energy "
+                   << Units::display(charge_creation_energy, "eV") << " and Fano factor " << fano_factor;
+
+        sensors_.push_back({detector, properties->second, charge_creation_energy, fano_factor});
+    }
+
+    LOG(INFO) << "Transporting " << number_of_particles_ << " " << config_.get<std::string>("particle_type")
+              << " per event through " << sensors_.size() << " sensors";
+}
+
+std::tuple<size_t, double, double> DepositionTelescopeModule::next_sensor(const ROOT::Math::XYZPoint& position,
+                                                                          const ROOT::Math::XYZVector& direction,
+                                                                          const std::vector<bool>& crossed) const {
+    auto next = std::make_tuple(sensors_.size(), std::numeric_limits<double>::max(), 0.);
+    for(size_t i = 0; i < sensors_.size(); ++i) {
+        if(crossed[i]) {
+            continue;
+        }
+
+        // Intersect the track with the sensor box, centered at the origin
+        const auto& detector = sensors_[i].detector;
+        const auto& model = detector->getModel();
+        auto local_position = detector->getLocalPosition(position);
+        auto local_direction = detector->getLocalPosition(position + direction) - local_position;
+        auto distances = LiangBarsky::intersectionDistances(
+            local_direction, local_position - (model->getSensorCenter() - ROOT::Math::XYZPoint()), model->getSensorSize());
+        if(!distances || distances->second <= 0) {
+            continue;
+        }
+
+        auto entry = std::max(distances->first, 0.);
+        auto length = distances->second - entry;
+        if(length > 0 && entry < std::get<1>(next)) {
+            next = std::make_tuple(i, entry, length);
+        }
+    }
+    return next;
+}
+
+void DepositionTelescopeModule::run(Event* event) {
+    auto& random_engine = event->getRandomEngine();
+    allpix::normal_distribution<double> gauss(0., 1.);
+    allpix::uniform_real_distribution<double> uniform(0., 1.);
+    const auto& landau = LandauTable::get();
+
+    // The particles and charges point to the tracks, which must therefore not be reallocated
+    std::vector<MCTrack> tracks;
+    tracks.reserve(number_of_particles_);
+    std::vector<std::vector<Crossing>> crossings(sensors_.size());
+
+    auto [beam_u, beam_v] = perpendicular_axes(beam_direction_);
+    for(unsigned int n = 0; n < number_of_particles_; ++n) {
+        // Sample the start of the particle from the beam profile
+        auto position = source_position_ + beam_size_ * (gauss(random_engine) * beam_u + gauss(random_engine) * beam_v);
+        auto direction = (beam_direction_ + std::tan(beam_divergence_.x() * gauss(random_engine)) * beam_u +
+                          std::tan(beam_divergence_.y() * gauss(random_engine)) * beam_v)
+                             .Unit();
+        auto kinetic_energy = std::max(kinetic_energy_ + energy_spread_ * gauss(random_engine), 0.);
+        const auto start_position = position;
+        const auto start_energy = kinetic_energy;
+        double time = 0;
+
+        std::vector<bool> crossed(sensors_.size(), false);
+        while(kinetic_energy > 0) {
+            auto [index, entry, length] = next_sensor(position, direction, crossed);
+            if(index == sensors_.size()) {
+                break;
+            }
+            crossed[index] = true;
+
+            const auto& sensor = sensors_[index];
+            const auto& detector = sensor.detector;
+            const auto& material = sensor.material;
+
+            auto gamma = 1. + kinetic_energy / mass_;
+            auto beta = std::sqrt(1. - 1. / (gamma * gamma));
+            position += entry * direction;
+            time += entry / (beta * speed_of_light);
+
+            auto local_start = detector->getLocalPosition(position);
+            auto local_direction = detector->getLocalPosition(position + direction) - local_start;
+            Crossing crossing{local_start, local_start + length * local_direction, time, kinetic_energy, 0, n, {}};
+
+            // Sample the energy loss along the path through the sensor in steps
+            auto steps = std::max(1., std::ceil(length / max_step_length_));
+            auto step_length = length / steps;
+            for(int step = 0; step < static_cast<int>(steps) && kinetic_energy > 0; ++step) {
+                gamma = 1. + kinetic_energy / mass_;
+                auto beta2 = 1. - 1. / (gamma * gamma);
+                auto velocity = std::sqrt(beta2) * speed_of_light;
+
+                // Maximum energy transfer to an electron in a single collision
+                auto mass_ratio = electron_mass / mass_;
+                auto max_energy = (electron_ || positron_) ? (electron_ ? kinetic_energy / 2 : kinetic_energy)
+                                                           : 2. * electron_mass * (gamma * gamma - 1.) /
+                                                                 (1. + 2. * gamma * mass_ratio + mass_ratio * mass_ratio);
+
+                // Mean energy loss from the Bethe formula with the high-energy limit of the density effect, and width of
+                // the Landau distribution of the step
+                auto electron_density = bethe_constant * material.z_over_a * material.density / 10.; // MeV / mm
+                auto plasma_energy = 28.816e-6 * std::sqrt(material.density * material.z_over_a);
+                auto beta_gamma = std::sqrt(gamma * gamma - 1.);
+                auto density_effect = std::max(
+                    0., std::log(plasma_energy / material.mean_excitation_energy) + std::log(beta_gamma) - 0.5);
+                auto mean_loss = electron_density / beta2 *
+                                 (0.5 * std::log(2. * electron_mass * beta_gamma * beta_gamma * max_energy /
+                                                 (material.mean_excitation_energy * material.mean_excitation_energy)) -
+                                  beta2 - density_effect) *
+                                 step_length;
+                auto xi = electron_density / 2. / beta2 * step_length;
+
+                // Fluctuation of the energy loss around its mean, truncated at the maximum energy transfer
+                auto lambda_max = max_energy / xi;
+                auto energy_loss =
+                    mean_loss + xi * (landau.sample(lambda_max, uniform(random_engine)) - landau.mean(lambda_max));
+                energy_loss = std::clamp(energy_loss, 0., kinetic_energy);
+                kinetic_energy -= energy_loss;
+
+                // Number of electron-hole pairs, fluctuating according to the Fano factor
+                auto mean_charge = energy_loss / sensor.charge_creation_energy;
+                allpix::normal_distribution<double> charge_fluctuation(mean_charge,
+                                                                       std::sqrt(mean_charge * sensor.fano_factor));
+                auto charge = static_cast<unsigned int>(std::max(charge_fluctuation(random_engine), 0.) + 0.5);
+
+                auto local_position = local_start + (step + 0.5) * step_length * local_direction;
+                if(charge > 0 && detector->getModel()->isWithinSensor(local_position)) {
+                    crossing.deposits.push_back({local_position, charge, time + step_length / 2 / velocity});
+                    crossing.charge += charge;
+                }
+                time += step_length / velocity;
+            }
+            position += length * direction;
+
+            // Multiple scattering in the sensor and the additional material of the detector, applied at the exit of the
+            // sensor as deflection and displacement in two perpendicular planes
+            auto radiation_lengths = length / material.radiation_length + material_budget_;
+            if(kinetic_energy > 0 && radiation_lengths > 0) {
+                gamma = 1. + kinetic_energy / mass_;
+                auto beta2 = 1. - 1. / (gamma * gamma);
+                auto momentum = std::sqrt(kinetic_energy * (kinetic_energy + 2. * mass_));
+                auto theta0 = 13.6 / (std::sqrt(beta2) * momentum) * std::sqrt(radiation_lengths) *
+                              (1. + 0.038 * std::log(radiation_lengths / beta2));
+
+                auto [axis_u, axis_v] = perpendicular_axes(direction);
+                std::array<double, 2> angles{};
+                std::array<double, 2> offsets{};
+                for(size_t plane = 0; plane < 2; ++plane) {
+                    auto z1 = gauss(random_engine);
+                    auto z2 = gauss(random_engine);
+                    offsets[plane] = length * theta0 * (z1 / std::sqrt(12.) + z2 / 2.);
+                    angles[plane] = z2 * theta0;
+                }
+                position += offsets[0] * axis_u + offsets[1] * axis_v;
+                direction = (direction + std::tan(angles[0]) * axis_u + std::tan(angles[1]) * axis_v).Unit();
+            }
+
+            LOG(DEBUG) << "Particle " << n << " crossed detector " << detector->getName() << " from "
+                       << Units::display(crossing.local_start, {"um", "mm"}) << " to "
+                       << Units::display(crossing.local_end, {"um", "mm"}) << " depositing " << 2 * crossing.charge
+                       << " charges";
+            crossings[index].push_back(std::move(crossing));
+        }
+
+        tracks.emplace_back(start_position,
+                            position,
+                            "World",
+                            "World",
+                            "none",
+                            -1,
+                            particle_code_,
+                            0.,
+                            time,
+                            start_energy,
+                            kinetic_energy,
+                            start_energy + mass_,
+                            kinetic_energy + mass_);
+    }
+
+    // Dispatch the particles and charges of every crossed sensor
+    for(size_t i = 0; i < sensors_.size(); ++i) {
+        if(crossings[i].empty()) {
+            continue;
+        }
+        const auto& detector = sensors_[i].detector;
+
+        // Times in the local reference frame of the detector start with the arrival of the earliest particle
+        auto time_reference =
+            std::min_element(crossings[i].begin(), crossings[i].end(), [](const auto& l, const auto& r) {
+                return l.global_time < r.global_time;
+            })->global_time;
+
+        std::vector<MCParticle> mc_particles;
+        mc_particles.reserve(crossings[i].size());
+        std::vector<DepositedCharge> deposits;
+        for(const auto& crossing : crossings[i]) {
+            mc_particles.emplace_back(crossing.local_start,
+                                      detector->getGlobalPosition(crossing.local_start),
+                                      crossing.local_end,
+                                      detector->getGlobalPosition(crossing.local_end),
+                                      particle_code_,
+                                      crossing.global_time - time_reference,
+                                      crossing.global_time);
+            auto& mc_particle = mc_particles.back();
+            mc_particle.setTotalDepositedCharge(2 * crossing.charge);
+            mc_particle.setTrack(&tracks[crossing.track]);
+            mc_particle.setKineticEnergyStart(crossing.kinetic_energy);
+            mc_particle.setTotalEnergyStart(crossing.kinetic_energy + mass_);
+
+            for(const auto& deposit : crossing.deposits) {
+                auto global_position = detector->getGlobalPosition(deposit.local_position);
+                auto local_time = deposit.global_time - time_reference;
+                deposits.emplace_back(deposit.local_position,
+                                      global_position,
+                                      CarrierType::ELECTRON,
+                                      deposit.charge,
+                                      local_time,
+                                      deposit.global_time,
+                                      &mc_particle);
+                deposits.emplace_back(deposit.local_position,
+                                      global_position,
+                                      CarrierType::HOLE,
+                                      deposit.charge,
+                                      local_time,
+                                      deposit.global_time,
+                                      &mc_particle);
+            }
+            total_charge_ += 2 * crossing.charge;
+            total_crossings_++;
+        }
+
+        messenger_->dispatchMessage(this, std::make_shared<MCParticleMessage>(std::move(mc_particles), detector), event);
+        messenger_->dispatchMessage(this, std::make_shared<DepositedChargeMessage>(std::move(deposits), detector), event);
+    }
+
+    messenger_->dispatchMessage(this, std::make_shared<MCTrackMessage>(std::move(tracks)), event);
+}
+
+void DepositionTelescopeModule::finalize() {
+    if(total_crossings_ > 0) {
+        LOG(STATUS) << "Deposited total of " << total_charge_ << " charges in " << total_crossings_
+                    << " sensor crossings (average of " << total_charge_ / total_crossings_ << " per crossing)";
+    } else {
+        LOG(WARNING) << "No sensors crossed by the particles";
+    }
+}
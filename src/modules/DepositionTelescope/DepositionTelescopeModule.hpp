@@ -0,0 +1,136 @@
+/**
+ * @file
+ * @brief Definition of a fast deposition module transporting charged particles along straight tracks without Geant4
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <Math/Point3D.h>
+#include <Math/Vector2D.h>
+#include <Math/Vector3D.h>
+
+#include "core/config/Configuration.hpp"
+#include "core/geometry/GeometryManager.hpp"
+#include "core/messenger/Messenger.hpp"
+#include "core/module/Event.hpp"
+#include "core/module/Module.hpp"
+
+#include "physics/MaterialProperties.hpp"
+
+namespace allpix {
+    /**
+     * @ingroup Modules
+     * @brief Module to deposit the charge of charged particles crossing a stack of detectors along straight tracks
+     *
+     * Primary particles are transported from the source through the sensors of all detectors in the order in which they
+     * are crossed. The path through every sensor is divided into steps, and the energy lost in every step is sampled from
+     * a truncated Landau distribution around the mean energy loss given by the Bethe formula. After leaving a sensor, the
+     * direction and position of the particle are changed by multiple scattering following the Highland formula. Secondary
+     * particles are not produced, which makes the module suitable for beam telescope studies with minimum ionizing particles
+     * at a fraction of the cost of a full Geant4 simulation.
+     */
+    class DepositionTelescopeModule : public Module {
+    public:
+        /**
+         * @brief Constructor for this unique module
+         * @param config Configuration object for this module as retrieved from the steering file
+         * @param messenger Pointer to the messenger object to allow binding to messages on the bus
+         * @param geo_manager Pointer to the geometry manager, containing the detectors
+         */
+        DepositionTelescopeModule(Configuration& config, Messenger* messenger, GeometryManager* geo_manager);
+
+        /**
+         * @brief Read the properties of the sensors of all detectors
+         */
+        void initialize() override;
+
+        /**
+         * @brief Transport the primary particles of the event and dispatch the deposited charges
+         */
+        void run(Event* event) override;
+
+        /**
+         * @brief Report the total deposited charge
+         */
+        void finalize() override;
+
+    private:
+        /**
+         * @brief Properties of the sensor of a detector entering the transport of the particles
+         */
+        struct Sensor {
+            std::shared_ptr<Detector> detector;
+            MaterialStoppingProperties material;
+            double charge_creation_energy{};
+            double fano_factor{};
+        };
+
+        /**
+         * @brief Charge deposited along a step of a particle through a sensor
+         */
+        struct Deposit {
+            ROOT::Math::XYZPoint local_position;
+            unsigned int charge{};
+            double global_time{};
+        };
+
+        /**
+         * @brief Crossing of a sensor by a primary particle
+         */
+        struct Crossing {
+            ROOT::Math::XYZPoint local_start;
+            ROOT::Math::XYZPoint local_end;
+            double global_time{};
+            double kinetic_energy{};
+            unsigned int charge{};
+            size_t track{};
+            std::vector<Deposit> deposits;
+        };
+
+        /**
+         * @brief Find the sensor the particle enters next
+         * @param position Current position of the particle in global coordinates
+         * @param direction Current direction of the particle in global coordinates
+         * @param crossed Flags of the sensors already crossed by the particle
+         * @return Index of the sensor, the distance to its entry and the length of the path through it, or the number of
+         *         sensors if none is crossed anymore
+         */
+        std::tuple<size_t, double, double> next_sensor(const ROOT::Math::XYZPoint& position,
+                                                       const ROOT::Math::XYZVector& direction,
+                                                       const std::vector<bool>& crossed) const;
+
+        Messenger* messenger_;
+        GeometryManager* geo_manager_;
+
+        std::vector<Sensor> sensors_;
+
+        // Properties of the primary particles and the beam
+        int particle_code_{};
+        double mass_{};
+        bool electron_{};
+        bool positron_{};
+        double kinetic_energy_{};
+        double energy_spread_{};
+        unsigned int number_of_particles_{};
+        ROOT::Math::XYZPoint source_position_;
+        ROOT::Math::XYZVector beam_direction_;
+        double beam_size_{};
+        ROOT::Math::XYVector beam_divergence_;
+
+        double max_step_length_{};
+        double material_budget_{};
+
+        std::atomic<uint64_t> total_charge_{};
+        std::atomic<uint64_t> total_crossings_{};
+    };
+} // namespace allpix
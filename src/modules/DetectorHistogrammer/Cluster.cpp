@@ -13,6 +13,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <functional>
 #include <set>
 
 #include "core/utils/log.h"
@@ -20,8 +21,8 @@
 
 using namespace allpix;
 
-Cluster::Cluster(const PixelHit* seed_pixel_hit)
-    : seed_pixel_hit_(seed_pixel_hit), cluster_charge_(seed_pixel_hit->getSignal()) {
+Cluster::Cluster(const PixelHit* seed_pixel_hit, const std::vector<MCParticle>& mc_particles)
+    : seed_pixel_hit_(seed_pixel_hit), mc_particles_(&mc_particles), cluster_charge_(seed_pixel_hit->getSignal()) {
     pixel_hits_.insert(seed_pixel_hit);
 
     minX_ = seed_pixel_hit->getPixel().getIndex().x();
@@ -29,9 +30,7 @@ Cluster::Cluster(const PixelHit* seed_pixel_hit)
     minY_ = seed_pixel_hit->getPixel().getIndex().y();
     maxY_ = minY_; // NOLINT
 
-    for(const auto* mc_particle : seed_pixel_hit->getMCParticles()) {
-        mc_particles_.insert(mc_particle);
-    }
+    add_mc_particles(seed_pixel_hit);
 }
 
 bool Cluster::addPixelHit(const PixelHit* pixel_hit) {
@@ -51,15 +50,34 @@ bool Cluster::addPixelHit(const PixelHit* pixel_hit) {
             seed_pixel_hit_ = pixel_hit;
         }
 
-        for(const auto* mc_particle : pixel_hit->getMCParticles()) {
-            mc_particles_.insert(mc_particle);
-        }
+        add_mc_particles(pixel_hit);
 
         return true;
     }
     return false;
 }
 
+/**
+ * The MCParticles referenced by the hit are stored in the message of the detector, so their index follows from their
+ * address. Clusters are only related to a handful of particles, such that insertion into a sorted vector is cheaper than
+ * maintaining a tree of pointers.
+ */
+void Cluster::add_mc_particles(const PixelHit* pixel_hit) {
+    for(const auto* mc_particle : pixel_hit->getMCParticles()) {
+        // Skip particles from other detectors, which cannot be related to the primaries of this detector
+        const auto* first = mc_particles_->data();
+        const auto* last = first + mc_particles_->size();
+        if(std::less<const MCParticle*>()(mc_particle, first) || !std::less<const MCParticle*>()(mc_particle, last)) {
+            continue;
+        }
+        auto index = static_cast<size_t>(mc_particle - first);
+        auto position = std::lower_bound(mc_particle_indices_.begin(), mc_particle_indices_.end(), index);
+        if(position == mc_particle_indices_.end() || *position != index) {
+            mc_particle_indices_.insert(position, index);
+        }
+    }
+}
+
 ROOT::Math::XYZPoint Cluster::getPosition() const {
     ROOT::Math::XYZVector meanPos;
     for(const auto& pixel : this->getPixelHits()) {
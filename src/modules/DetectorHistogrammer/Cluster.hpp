@@ -15,6 +15,7 @@
 #include <Math/Vector3D.h>
 
 #include <set>
+#include <vector>
 
 #include "objects/Pixel.hpp"
 #include "objects/PixelHit.hpp"
@@ -26,8 +27,9 @@ namespace allpix {
         /**
          * @brief Construct a cluster
          * @param seed_pixel_hit PixelHit to start the cluster with
+         * @param mc_particles MCParticles of the detector in this event, used to identify related MCParticles by index
          */
-        explicit Cluster(const PixelHit* seed_pixel_hit);
+        Cluster(const PixelHit* seed_pixel_hit, const std::vector<MCParticle>& mc_particles);
 
         /**
          * @brief Get the total accumulated signal of the cluster
@@ -80,17 +82,24 @@ namespace allpix {
         const std::set<const PixelHit*>& getPixelHits() const { return pixel_hits_; }
 
         /**
-         * @brief Get all MCParticles related to the cluster
+         * @brief Get the indices of all MCParticles related to the cluster
          * @note MCParticles can only be fetched if the full history of objects are in scope and stored
-         * @return Vector of all related MCParticles
+         * @return Sorted vector of the unique indices of the related MCParticles in the MCParticles of the detector
          */
-        const std::set<const MCParticle*>& getMCParticles() const { return mc_particles_; }
+        const std::vector<size_t>& getMCParticleIndices() const { return mc_particle_indices_; }
 
     private:
+        /**
+         * @brief Add the MCParticles of a PixelHit to the sorted indices of the related MCParticles
+         * @param pixel_hit PixelHit to add the MCParticles of
+         */
+        void add_mc_particles(const PixelHit* pixel_hit);
+
         const PixelHit* seed_pixel_hit_;
+        const std::vector<MCParticle>* mc_particles_;
 
         std::set<const PixelHit*> pixel_hits_;
-        std::set<const MCParticle*> mc_particles_;
+        std::vector<size_t> mc_particle_indices_;
 
         double cluster_charge_{};
 
@@ -12,6 +12,7 @@
 #include "DetectorHistogrammerModule.hpp"
 
 #include <algorithm>
+#include <iterator>
 #include <memory>
 #include <string>
 #include <utility>
@@ -23,6 +24,7 @@
 #include "core/utils/log.h"
 
 #include "tools/ROOT.h"
+#include "tools/clustering.h"
 
 using namespace allpix;
 
@@ -49,9 +51,18 @@ DetectorHistogrammerModule::DetectorHistogrammerModule(Configuration& config,
                                                static_cast<int>(Units::convert(model->getPixelSize().y(), "um"))));
     config_.setDefault<DisplacementVector2D<Cartesian2D<int>>>("granularity_local", {1, 1});
     config_.setDefault<double>("max_cluster_charge", Units::get(50., "ke"));
+    config_.setDefault<bool>("tiled_maps",
+                             static_cast<uint64_t>(model->getNPixels().x()) * model->getNPixels().y() > 1000000);
+    config_.setDefault<DisplacementVector2D<Cartesian2D<int>>>("tiled_maps_reduction", {1, 1});
 
     matching_cut_ = config_.get<XYVector>("matching_cut");
     track_resolution_ = config_.get<XYVector>("track_resolution");
+
+    // Register the observables which can be monitored for the convergence of the run
+    efficiency_observable_ = &register_observable("efficiency");
+    cluster_size_observable_ = &register_observable("cluster_size");
+    residual_x_observable_ = &register_observable("residual_x_width_um", Observable::Type::WIDTH);
+    residual_y_observable_ = &register_observable("residual_y_width_um", Observable::Type::WIDTH);
 }
 
 void DetectorHistogrammerModule::initialize() {
@@ -75,11 +86,23 @@ void DetectorHistogrammerModule::initialize() {
         LOG(DEBUG) << "In-pixel plot granularity: " << inpixel_bins;
     }
 
+    // Set up the storage of the maps over the pixel matrix
+    matrix_storage_.tiled = config_.get<bool>("tiled_maps");
+    auto reduction = config_.get<DisplacementVector2D<Cartesian2D<int>>>("tiled_maps_reduction");
+    if(reduction.x() < 1 || reduction.y() < 1) {
+        throw InvalidValueError(config_, "tiled_maps_reduction", "number of merged bins needs to be positive");
+    }
+    matrix_storage_.reduce_x = reduction.x();
+    matrix_storage_.reduce_y = reduction.y();
+    if(matrix_storage_.tiled) {
+        LOG(DEBUG) << "Storing maps over the pixel matrix in tiles, merging " << reduction << " bins for writing";
+    }
+
     // Create histogram of hitmap
     LOG(TRACE) << "Creating histograms";
     std::string hit_map_title = "Hitmap (" + detector_->getName() + ");x (pixels);y (pixels);hits";
-    hit_map =
-        CreateHistogram<TH2D>("hit_map", hit_map_title.c_str(), xpixels, -0.5, xpixels - 0.5, ypixels, -0.5, ypixels - 0.5);
+    hit_map = std::make_unique<MatrixHistogram<TH2D>>(
+        matrix_storage_, "hit_map", hit_map_title, xpixels, -0.5, xpixels - 0.5, ypixels, -0.5, ypixels - 0.5);
 
     std::string hit_map_global_title = "Hitmap (" + detector_->getName() + ")  in global coord.;x [mm];y [mm];hits";
     auto global_ll = detector_->getGlobalPosition(model->getSensorCenter() - model->getSensorSize() / 2);
@@ -98,21 +121,24 @@ void DetectorHistogrammerModule::initialize() {
                                            std::max({global_ll.y(), global_ur.y(), global_lr.y(), global_ul.y()}));
 
     std::string hit_map_local_title = "Hitmap (" + detector_->getName() + ") in local coord.;x (mm);y (mm);hits";
-    hit_map_local = CreateHistogram<TH2D>("hit_map_local",
-                                          hit_map_local_title.c_str(),
-                                          static_cast<int>(model->getMatrixSize().x() / model->getPixelSize().x()),
-                                          -model->getPixelSize().x() / 2,
-                                          model->getMatrixSize().x() - model->getPixelSize().x() / 2,
-                                          static_cast<int>(model->getMatrixSize().y() / model->getPixelSize().y()),
-                                          -model->getPixelSize().y() / 2,
-                                          model->getMatrixSize().y() - model->getPixelSize().y() / 2);
+    hit_map_local = std::make_unique<MatrixHistogram<TH2D>>(
+        matrix_storage_,
+        "hit_map_local",
+        hit_map_local_title,
+        static_cast<int>(model->getMatrixSize().x() / model->getPixelSize().x()),
+        -model->getPixelSize().x() / 2,
+        model->getMatrixSize().x() - model->getPixelSize().x() / 2,
+        static_cast<int>(model->getMatrixSize().y() / model->getPixelSize().y()),
+        -model->getPixelSize().y() / 2,
+        model->getMatrixSize().y() - model->getPixelSize().y() / 2);
 
     auto local_inpixel_bins = config_.get<DisplacementVector2D<Cartesian2D<int>>>("granularity_local");
     std::string hit_map_local_mc_title =
         "MCParticle position hitmap (" + detector_->getName() + ") in local coord.;x (mm);y (mm);hits";
-    hit_map_local_mc = CreateHistogram<TH2D>(
+    hit_map_local_mc = std::make_unique<MatrixHistogram<TH2D>>(
+        matrix_storage_,
         "hit_map_local_mc",
-        hit_map_local_mc_title.c_str(),
+        hit_map_local_mc_title,
         static_cast<int>(model->getMatrixSize().x() / model->getPixelSize().x()) * local_inpixel_bins.x(),
         -model->getPixelSize().x() / 2,
         model->getMatrixSize().x() - model->getPixelSize().x() / 2,
@@ -121,20 +147,21 @@ void DetectorHistogrammerModule::initialize() {
         model->getMatrixSize().y() - model->getPixelSize().y() / 2);
 
     std::string charge_map_title = "Pixel charge map (" + detector_->getName() + ");x (pixels);y (pixels); charge [ke]";
-    charge_map = CreateHistogram<TH2D>(
-        "charge_map", charge_map_title.c_str(), xpixels, -0.5, xpixels - 0.5, ypixels, -0.5, ypixels - 0.5);
+    charge_map = std::make_unique<MatrixHistogram<TH2D>>(
+        matrix_storage_, "charge_map", charge_map_title, xpixels, -0.5, xpixels - 0.5, ypixels, -0.5, ypixels - 0.5);
 
     // Create histogram of cluster map
     std::string cluster_map_title = "Cluster map (" + detector_->getName() + ");x (pixels);y (pixels); clusters";
-    cluster_map = CreateHistogram<TH2D>(
-        "cluster_map", cluster_map_title.c_str(), xpixels, -0.5, xpixels - 0.5, ypixels, -0.5, ypixels - 0.5);
+    cluster_map = std::make_unique<MatrixHistogram<TH2D>>(
+        matrix_storage_, "cluster_map", cluster_map_title, xpixels, -0.5, xpixels - 0.5, ypixels, -0.5, ypixels - 0.5);
 
     // Create histogram of cluster map
     std::string cluster_size_map_local_title =
         "Cluster size as function of MCParticle impact position (" + detector_->getName() + ");x [mm];y [mm]";
-    cluster_size_map_local = CreateHistogram<TProfile2D>(
+    cluster_size_map_local = std::make_unique<MatrixHistogram<TProfile2D>>(
+        matrix_storage_,
         "cluster_size_map_local",
-        cluster_size_map_local_title.c_str(),
+        cluster_size_map_local_title,
         static_cast<int>(model->getMatrixSize().x() / model->getPixelSize().x()) * local_inpixel_bins.x(),
         -model->getPixelSize().x() / 2,
         model->getMatrixSize().x() - model->getPixelSize().x() / 2,
@@ -254,8 +281,15 @@ void DetectorHistogrammerModule::initialize() {
                                                pitch_y / 2);
     std::string residual_detector_title = "Mean absolute deviation of residual (" + detector_->getName() +
                                           ");x (pixels);y (pixels);MAD(#sqrt{#Deltax^{2}+#Deltay^{2}}) [#mum]";
-    residual_detector = CreateHistogram<TProfile2D>(
-        "residual_detector", residual_detector_title.c_str(), xpixels, -0.5, xpixels - 0.5, ypixels, -0.5, ypixels - 0.5);
+    residual_detector = std::make_unique<MatrixHistogram<TProfile2D>>(matrix_storage_,
+                                                                      "residual_detector",
+                                                                      residual_detector_title,
+                                                                      xpixels,
+                                                                      -0.5,
+                                                                      xpixels - 0.5,
+                                                                      ypixels,
+                                                                      -0.5,
+                                                                      ypixels - 0.5);
 
     std::string residual_x_map_title = "Mean absolute deviation of residual in X as function of in-pixel impact position (" +
                                        detector_->getName() + ");x%pitch [#mum];y%pitch [#mum];MAD(#Deltax) [#mum]";
@@ -269,14 +303,15 @@ void DetectorHistogrammerModule::initialize() {
                                                  pitch_y / 2);
     std::string residual_x_detector_title =
         "Mean absolute deviation of residual in X (" + detector_->getName() + ");x (pixels);y (pixels);MAD(#Deltax) [#mum]";
-    residual_x_detector = CreateHistogram<TProfile2D>("residual_x_detector",
-                                                      residual_x_detector_title.c_str(),
-                                                      xpixels,
-                                                      -0.5,
-                                                      xpixels - 0.5,
-                                                      ypixels,
-                                                      -0.5,
-                                                      ypixels - 0.5);
+    residual_x_detector = std::make_unique<MatrixHistogram<TProfile2D>>(matrix_storage_,
+                                                                        "residual_x_detector",
+                                                                        residual_x_detector_title,
+                                                                        xpixels,
+                                                                        -0.5,
+                                                                        xpixels - 0.5,
+                                                                        ypixels,
+                                                                        -0.5,
+                                                                        ypixels - 0.5);
 
     std::string residual_y_map_title = "Mean absolute deviation of residual in Y as function of in-pixel impact position (" +
                                        detector_->getName() + ");x%pitch [#mum];y%pitch [#mum];MAD(#Deltay) [#mum]";
@@ -290,14 +325,15 @@ void DetectorHistogrammerModule::initialize() {
                                                  pitch_y / 2);
     std::string residual_y_detector_title =
         "Mean absolute deviation of residual in Y (" + detector_->getName() + ");x (pixels);y (pixels);MAD(#Deltay) [#mum]";
-    residual_y_detector = CreateHistogram<TProfile2D>("residual_y_detector",
-                                                      residual_y_detector_title.c_str(),
-                                                      xpixels,
-                                                      -0.5,
-                                                      xpixels - 0.5,
-                                                      ypixels,
-                                                      -0.5,
-                                                      ypixels - 0.5);
+    residual_y_detector = std::make_unique<MatrixHistogram<TProfile2D>>(matrix_storage_,
+                                                                        "residual_y_detector",
+                                                                        residual_y_detector_title,
+                                                                        xpixels,
+                                                                        -0.5,
+                                                                        xpixels - 0.5,
+                                                                        ypixels,
+                                                                        -0.5,
+                                                                        ypixels - 0.5);
 
     // Efficiency maps:
     std::string efficiency_map_title = "Efficiency as function of in-pixel impact position (" + detector_->getName() +
@@ -314,9 +350,10 @@ void DetectorHistogrammerModule::initialize() {
                                                  1);
     std::string efficiency_local_title =
         "Efficiency (" + detector_->getName() + ") MCParticle positions, local coord.;x (mm);y (mm);efficiency";
-    efficiency_local = CreateHistogram<TProfile2D>(
+    efficiency_local = std::make_unique<MatrixHistogram<TProfile2D>>(
+        matrix_storage_,
         "efficiency_local",
-        efficiency_local_title.c_str(),
+        efficiency_local_title,
         static_cast<int>(model->getMatrixSize().x() / model->getPixelSize().x()) * local_inpixel_bins.x(),
         -model->getPixelSize().x() / 2,
         model->getMatrixSize().x() - model->getPixelSize().x() / 2,
@@ -327,16 +364,17 @@ void DetectorHistogrammerModule::initialize() {
         1);
 
     std::string efficiency_detector_title = "Efficiency of " + detector_->getName() + ";x (pixels);y (pixels);efficiency";
-    efficiency_detector = CreateHistogram<TProfile2D>("efficiency_detector",
-                                                      efficiency_detector_title.c_str(),
-                                                      xpixels,
-                                                      -0.5,
-                                                      xpixels - 0.5,
-                                                      ypixels,
-                                                      -0.5,
-                                                      ypixels - 0.5,
-                                                      0,
-                                                      1);
+    efficiency_detector = std::make_unique<MatrixHistogram<TProfile2D>>(matrix_storage_,
+                                                                        "efficiency_detector",
+                                                                        efficiency_detector_title,
+                                                                        xpixels,
+                                                                        -0.5,
+                                                                        xpixels - 0.5,
+                                                                        ypixels,
+                                                                        -0.5,
+                                                                        ypixels - 0.5,
+                                                                        0,
+                                                                        1);
     // Efficiency projections
     std::string efficiency_vs_x_title =
         "Efficiency as function of in-pixel X position (" + detector_->getName() + ");x%pitch [#mum];efficiency";
@@ -411,6 +449,9 @@ void DetectorHistogrammerModule::initialize() {
 void DetectorHistogrammerModule::run(Event* event) {
     using namespace ROOT::Math;
 
+    // Weight of the event, e.g. from biased sampling of the deposition positions
+    const auto weight = event->getWeight();
+
     std::shared_ptr<PixelHitMessage> pixels_message{nullptr};
     auto mcparticle_message = messenger_->fetchMessage<MCParticleMessage>(this, event);
 
@@ -431,15 +472,16 @@ void DetectorHistogrammerModule::run(Event* event) {
             auto local_pos = pixel_hit.getPixel().getLocalCenter();
 
             // Add pixel
-            hit_map->Fill(pixel_idx.x(), pixel_idx.y());
-            hit_map_global->Fill(global_pos.x(), global_pos.y());
-            hit_map_local->Fill(local_pos.x(), local_pos.y());
-            charge_map->Fill(pixel_idx.x(), pixel_idx.y(), static_cast<double>(Units::convert(pixel_hit.getSignal(), "ke")));
-            pixel_charge->Fill(static_cast<double>(Units::convert(pixel_hit.getSignal(), "ke")));
+            hit_map->Fill(pixel_idx.x(), pixel_idx.y(), weight);
+            hit_map_global->Fill(global_pos.x(), global_pos.y(), weight);
+            hit_map_local->Fill(local_pos.x(), local_pos.y(), weight);
+            charge_map->Fill(
+                pixel_idx.x(), pixel_idx.y(), static_cast<double>(Units::convert(pixel_hit.getSignal(), "ke")) * weight);
+            pixel_charge->Fill(static_cast<double>(Units::convert(pixel_hit.getSignal(), "ke")), weight);
             // For radial_strip models also fill the polar hit map
             if(radial_model != nullptr) {
                 auto hit_pos = radial_model->getPositionPolar(pixel_hit.getPixel().getLocalCenter());
-                polar_hit_map->Fill(hit_pos.phi(), hit_pos.r());
+                polar_hit_map->Fill(hit_pos.phi(), hit_pos.r(), weight);
             }
 
             // Update statistics
@@ -449,7 +491,9 @@ void DetectorHistogrammerModule::run(Event* event) {
     }
 
     // Perform a clustering
-    std::vector<Cluster> clusters = (pixels_message != nullptr ? doClustering(pixels_message) : std::vector<Cluster>());
+    const auto& mc_particles = mcparticle_message->getData();
+    std::vector<Cluster> clusters =
+        (pixels_message != nullptr ? doClustering(pixels_message, mc_particles) : std::vector<Cluster>());
 
     // Lambda for smearing the Monte Carlo truth position with the track resolution
     auto track_smearing = [&](auto residuals) {
@@ -464,26 +508,28 @@ void DetectorHistogrammerModule::run(Event* event) {
 
     // Evaluate the clusters
     double charge_sum = 0;
+    std::vector<size_t> intersection;
     for(const auto& clus : clusters) {
         // Fill cluster histograms
-        cluster_size->Fill(static_cast<double>(clus.getSize()));
+        cluster_size->Fill(static_cast<double>(clus.getSize()), weight);
+        cluster_size_observable_->add(static_cast<double>(clus.getSize()), weight);
         auto clusSizesXY = clus.getSizeXY();
-        cluster_size_x->Fill(clusSizesXY.first);
-        cluster_size_y->Fill(clusSizesXY.second);
+        cluster_size_x->Fill(clusSizesXY.first, weight);
+        cluster_size_y->Fill(clusSizesXY.second, weight);
 
         auto clusterPos = clus.getPosition();
         auto [cluster_x, cluster_y] = model->getPixelIndex(clusterPos);
         LOG(DEBUG) << "Cluster at indices " << cluster_x << ", " << cluster_y << "(" << clusterPos
                    << " local coordinates) with charge " << Units::display(clus.getCharge(), "ke");
-        cluster_map->Fill(cluster_x, cluster_y);
-        cluster_charge->Fill(static_cast<double>(Units::convert(clus.getCharge(), "ke")));
+        cluster_map->Fill(cluster_x, cluster_y, weight);
+        cluster_charge->Fill(static_cast<double>(Units::convert(clus.getCharge(), "ke")), weight);
         charge_sum += clus.getCharge();
 
-        auto cluster_particles = clus.getMCParticles();
+        const auto& cluster_particles = clus.getMCParticleIndices();
         LOG(DEBUG) << "This cluster is connected to " << cluster_particles.size() << " MC particles";
 
-        // Find all particles connected to this cluster which are also primaries:
-        std::vector<const MCParticle*> intersection;
+        // Find all particles connected to this cluster which are also primaries, both indices are sorted:
+        intersection.clear();
         std::set_intersection(primary_particles.begin(),
                               primary_particles.end(),
                               cluster_particles.begin(),
@@ -491,10 +537,10 @@ void DetectorHistogrammerModule::run(Event* event) {
                               std::back_inserter(intersection));
 
         LOG(TRACE) << "Matching primaries: " << intersection.size();
-        for(const auto& particle : intersection) {
-            auto particlePos = particle->getLocalReferencePoint();
+        for(auto index : intersection) {
+            auto particlePos = mc_particles[index].getLocalReferencePoint();
             // Plot hist in global coordinates of the associated MCParticles:
-            hit_map_local_mc->Fill(particlePos.x(), particlePos.y());
+            hit_map_local_mc->Fill(particlePos.x(), particlePos.y(), weight);
             // Add track smearing to the particle position:
             particlePos += track_smearing(track_resolution_);
             LOG(DEBUG) << "MCParticle at " << Units::display(particlePos, {"mm", "um"});
@@ -522,7 +568,7 @@ void DetectorHistogrammerModule::run(Event* event) {
 
                 auto residual_mrad_phi =
                     static_cast<double>(Units::convert(particle_polar.phi() - cluster_polar.phi(), "mrad"));
-                residual_phi->Fill(residual_mrad_phi);
+                residual_phi->Fill(residual_mrad_phi, weight);
 
                 // Recalculate in-pixel positions
                 auto delta_phi = particle_polar.phi() - strip_polar.phi();
@@ -532,45 +578,47 @@ void DetectorHistogrammerModule::run(Event* event) {
             auto inPixel_um_x = static_cast<double>(Units::convert(inPixelPos.x(), "um"));
             auto inPixel_um_y = static_cast<double>(Units::convert(inPixelPos.y(), "um"));
 
-            cluster_size_map->Fill(inPixel_um_x, inPixel_um_y, static_cast<double>(clus.getSize()));
-            cluster_size_map_local->Fill(particlePos.x(), particlePos.y(), static_cast<double>(clus.getSize()));
-            cluster_size_x_map->Fill(inPixel_um_x, inPixel_um_y, clusSizesXY.first);
-            cluster_size_y_map->Fill(inPixel_um_x, inPixel_um_y, clusSizesXY.second);
+            cluster_size_map->Fill(inPixel_um_x, inPixel_um_y, static_cast<double>(clus.getSize()), weight);
+            cluster_size_map_local->Fill(particlePos.x(), particlePos.y(), static_cast<double>(clus.getSize()), weight);
+            cluster_size_x_map->Fill(inPixel_um_x, inPixel_um_y, clusSizesXY.first, weight);
+            cluster_size_y_map->Fill(inPixel_um_x, inPixel_um_y, clusSizesXY.second, weight);
 
             // Charge maps:
             cluster_charge_map->Fill(
-                inPixel_um_x, inPixel_um_y, static_cast<double>(Units::convert(clus.getCharge(), "ke")));
+                inPixel_um_x, inPixel_um_y, static_cast<double>(Units::convert(clus.getCharge(), "ke")), weight);
 
             // Retrieve the seed pixel:
             const auto* seed_pixel = clus.getSeedPixelHit();
             seed_charge_map->Fill(
-                inPixel_um_x, inPixel_um_y, static_cast<double>(Units::convert(seed_pixel->getSignal(), "ke")));
-            cluster_seed_charge->Fill(static_cast<double>(Units::convert(seed_pixel->getSignal(), "ke")));
-
-            residual_x->Fill(residual_um_x);
-            residual_y->Fill(residual_um_y);
-            residual_r->Fill(residual_um_r);
-            residual_x_vs_x->Fill(inPixel_um_x, std::fabs(residual_um_x));
-            residual_y_vs_y->Fill(inPixel_um_y, std::fabs(residual_um_y));
-            residual_x_vs_y->Fill(inPixel_um_y, std::fabs(residual_um_x));
-            residual_y_vs_x->Fill(inPixel_um_x, std::fabs(residual_um_y));
-            residual_map->Fill(inPixel_um_x, inPixel_um_y, residual_um_r);
-            residual_x_map->Fill(inPixel_um_x, inPixel_um_y, std::fabs(residual_um_x));
-            residual_y_map->Fill(inPixel_um_x, inPixel_um_y, std::fabs(residual_um_y));
+                inPixel_um_x, inPixel_um_y, static_cast<double>(Units::convert(seed_pixel->getSignal(), "ke")), weight);
+            cluster_seed_charge->Fill(static_cast<double>(Units::convert(seed_pixel->getSignal(), "ke")), weight);
+
+            residual_x->Fill(residual_um_x, weight);
+            residual_y->Fill(residual_um_y, weight);
+            residual_x_observable_->add(residual_um_x, weight);
+            residual_y_observable_->add(residual_um_y, weight);
+            residual_r->Fill(residual_um_r, weight);
+            residual_x_vs_x->Fill(inPixel_um_x, std::fabs(residual_um_x), weight);
+            residual_y_vs_y->Fill(inPixel_um_y, std::fabs(residual_um_y), weight);
+            residual_x_vs_y->Fill(inPixel_um_y, std::fabs(residual_um_x), weight);
+            residual_y_vs_x->Fill(inPixel_um_x, std::fabs(residual_um_y), weight);
+            residual_map->Fill(inPixel_um_x, inPixel_um_y, residual_um_r, weight);
+            residual_x_map->Fill(inPixel_um_x, inPixel_um_y, std::fabs(residual_um_x), weight);
+            residual_y_map->Fill(inPixel_um_x, inPixel_um_y, std::fabs(residual_um_y), weight);
             residual_detector->Fill(
-                xpixel, ypixel, std::sqrt(residual_um_x * residual_um_x + residual_um_y * residual_um_y));
-            residual_x_detector->Fill(xpixel, ypixel, std::fabs(residual_um_x));
-            residual_y_detector->Fill(xpixel, ypixel, std::fabs(residual_um_y));
+                xpixel, ypixel, std::sqrt(residual_um_x * residual_um_x + residual_um_y * residual_um_y), weight);
+            residual_x_detector->Fill(xpixel, ypixel, std::fabs(residual_um_x), weight);
+            residual_y_detector->Fill(xpixel, ypixel, std::fabs(residual_um_y), weight);
         }
     }
 
     // Store total charge in event:
-    total_charge->Fill(static_cast<double>(Units::convert(charge_sum, "ke")));
+    total_charge->Fill(static_cast<double>(Units::convert(charge_sum, "ke")), weight);
 
     // Calculate efficiency: search for matching clusters for all primary MCParticles
-    for(auto& particle : primary_particles) {
+    for(auto index : primary_particles) {
         // Calculate 2D local position of particle:
-        auto particlePos = particle->getLocalReferencePoint() + track_smearing(track_resolution_);
+        auto particlePos = mc_particles[index].getLocalReferencePoint() + track_smearing(track_resolution_);
 
         // Check whether the particle position is in the sensor excess, and exclude it from the efficiency calculation if so
         if(!model->isWithinMatrix(particlePos)) {
@@ -609,16 +657,17 @@ void DetectorHistogrammerModule::run(Event* event) {
         LOG(DEBUG) << "Particle at " << Units::display(particlePos, {"mm", "um"})
                    << (matched ? " has a matching cluster" : " has no matching cluster");
 
-        efficiency_vs_x->Fill(inPixel_um_x, static_cast<double>(matched));
-        efficiency_vs_y->Fill(inPixel_um_y, static_cast<double>(matched));
-        efficiency_map->Fill(inPixel_um_x, inPixel_um_y, static_cast<double>(matched));
-        efficiency_detector->Fill(xpixel, ypixel, static_cast<double>(matched));
-        efficiency_local->Fill(particlePos.x(), particlePos.y(), static_cast<double>(matched));
+        efficiency_observable_->add(static_cast<double>(matched), weight);
+        efficiency_vs_x->Fill(inPixel_um_x, static_cast<double>(matched), weight);
+        efficiency_vs_y->Fill(inPixel_um_y, static_cast<double>(matched), weight);
+        efficiency_map->Fill(inPixel_um_x, inPixel_um_y, static_cast<double>(matched), weight);
+        efficiency_detector->Fill(xpixel, ypixel, static_cast<double>(matched), weight);
+        efficiency_local->Fill(particlePos.x(), particlePos.y(), static_cast<double>(matched), weight);
     }
 
     // Fill further histograms
-    event_size->Fill(pixels_message != nullptr ? static_cast<double>(pixels_message->getData().size()) : 0.);
-    n_cluster->Fill(static_cast<double>(clusters.size()));
+    event_size->Fill(pixels_message != nullptr ? static_cast<double>(pixels_message->getData().size()) : 0., weight);
+    n_cluster->Fill(static_cast<double>(clusters.size()), weight);
 }
 
 void DetectorHistogrammerModule::finalize() {
@@ -820,58 +869,30 @@ void DetectorHistogrammerModule::finalize() {
 /**
  * @brief Perform a sparse clustering on the PixelHits
  */
-std::vector<Cluster> DetectorHistogrammerModule::doClustering(std::shared_ptr<PixelHitMessage>& pixels_message) const {
+std::vector<Cluster> DetectorHistogrammerModule::doClustering(std::shared_ptr<PixelHitMessage>& pixels_message,
+                                                              const std::vector<MCParticle>& mc_particles) const {
     std::vector<Cluster> clusters;
-    std::map<const PixelHit*, bool> usedPixel;
-
-    auto pixel_it = pixels_message->getData().begin();
-    for(; pixel_it != pixels_message->getData().end(); pixel_it++) {
-        const PixelHit* pixel_hit = &(*pixel_it);
-
-        // Check if the pixel has been used:
-        if(usedPixel[pixel_hit]) {
-            continue;
-        }
-
-        // Create new cluster
-        Cluster cluster(pixel_hit);
-        usedPixel[pixel_hit] = true;
-        LOG(TRACE) << "Creating new cluster with seed: " << pixel_hit->getPixel().getIndex();
-
-        auto touching = [&](const PixelHit* pixel) {
-            for(const auto& cluster_pixel : cluster.getPixelHits()) {
-                if(detector_->getModel()->areNeighbors(cluster_pixel->getIndex(), pixel->getIndex(), 1)) {
-                    return true;
-                }
-            }
-            return false;
-        };
-
-        // Keep adding pixels to the cluster:
-        for(auto other_pixel = pixel_it + 1; other_pixel != pixels_message->getData().end(); other_pixel++) {
-            const PixelHit* neighbor = &(*other_pixel);
-
-            // Check if neighbor has been used or if it touches the current cluster:
-            if(usedPixel[neighbor] || !touching(neighbor)) {
-                continue;
-            }
 
-            cluster.addPixelHit(neighbor);
-            LOG(TRACE) << "Adding pixel: " << neighbor->getPixel().getIndex();
-            usedPixel[neighbor] = true;
-            other_pixel = pixel_it;
+    // Group the hits into connected components of neighboring pixels
+    for(const auto& pixel_hits : find_clusters(*detector_->getModel(), pixels_message->getData())) {
+        Cluster cluster(pixel_hits.front(), mc_particles);
+        LOG(TRACE) << "Creating new cluster with seed: " << pixel_hits.front()->getPixel().getIndex();
+        for(auto pixel_hit = std::next(pixel_hits.begin()); pixel_hit != pixel_hits.end(); ++pixel_hit) {
+            cluster.addPixelHit(*pixel_hit);
+            LOG(TRACE) << "Adding pixel: " << (*pixel_hit)->getPixel().getIndex();
         }
-        clusters.push_back(cluster);
+        clusters.push_back(std::move(cluster));
     }
     return clusters;
 }
 
-std::vector<const MCParticle*>
-DetectorHistogrammerModule::getPrimaryParticles(std::shared_ptr<MCParticleMessage>& mcparticle_message) {
-    std::vector<const MCParticle*> primaries;
+std::vector<size_t> DetectorHistogrammerModule::getPrimaryParticles(std::shared_ptr<MCParticleMessage>& mcparticle_message) {
+    std::vector<size_t> primaries;
 
     // Loop over all MCParticles available
-    for(const auto& mc_particle : mcparticle_message->getData()) {
+    const auto& mc_particles = mcparticle_message->getData();
+    for(size_t index = 0; index < mc_particles.size(); ++index) {
+        const auto& mc_particle = mc_particles[index];
         // Check for possible parents:
         const auto* parent = mc_particle.getParent();
         if(parent != nullptr) {
@@ -881,7 +902,7 @@ DetectorHistogrammerModule::getPrimaryParticles(std::shared_ptr<MCParticleMessag
 
         // This particle has no parent particles in the regarded sensor, return it.
         LOG(TRACE) << "MCParticle " << mc_particle.getParticleID() << " (primary)";
-        primaries.push_back(&mc_particle);
+        primaries.push_back(index);
     }
 
     return primaries;
@@ -29,6 +29,7 @@
 #include "core/module/Module.hpp"
 
 #include "Cluster.hpp"
+#include "MatrixHistogram.hpp"
 #include "objects/PixelHit.hpp"
 #include "tools/ROOT.h"
 
@@ -68,13 +69,15 @@ namespace allpix {
         /**
          * @brief Perform a sparse clustering on the PixelHits
          */
-        std::vector<Cluster> doClustering(std::shared_ptr<PixelHitMessage>& pixels_message) const;
+        std::vector<Cluster> doClustering(std::shared_ptr<PixelHitMessage>& pixels_message,
+                                          const std::vector<MCParticle>& mc_particles) const;
 
         /**
          * @brief analyze the available MCParticles and return the all particles identified as primary (i.e. that do not have
          * a parent). This might be several particles.
+         * @return Indices of the primary particles in the message in ascending order
          */
-        static std::vector<const MCParticle*> getPrimaryParticles(std::shared_ptr<MCParticleMessage>& mcparticle_message);
+        static std::vector<size_t> getPrimaryParticles(std::shared_ptr<MCParticleMessage>& mcparticle_message);
 
         Messenger* messenger_;
 
@@ -89,15 +92,26 @@ namespace allpix {
         // Reference track resolution
         ROOT::Math::XYVector track_resolution_{};
 
+        // Observables monitored for the convergence of the run
+        Observable* efficiency_observable_{};
+        Observable* cluster_size_observable_{};
+        Observable* residual_x_observable_{};
+        Observable* residual_y_observable_{};
+
         // Histograms to output
-        Histogram<TH2D> hit_map, hit_map_global, hit_map_local, hit_map_local_mc, charge_map, cluster_map, polar_hit_map;
-        Histogram<TProfile2D> cluster_size_map_local, cluster_size_map, cluster_size_x_map, cluster_size_y_map;
+        Histogram<TH2D> hit_map_global, polar_hit_map;
+        Histogram<TProfile2D> cluster_size_map, cluster_size_x_map, cluster_size_y_map;
         Histogram<TProfile2D> cluster_charge_map, seed_charge_map;
-        Histogram<TProfile2D> residual_map, residual_x_map, residual_y_map, residual_detector, residual_x_detector,
-            residual_y_detector;
+        Histogram<TProfile2D> residual_map, residual_x_map, residual_y_map;
         Histogram<TH1D> residual_x, residual_y, residual_r, residual_phi;
         Histogram<TProfile> residual_x_vs_x, residual_y_vs_y, residual_x_vs_y, residual_y_vs_x;
-        Histogram<TProfile2D> efficiency_map, efficiency_local, efficiency_detector;
+        Histogram<TProfile2D> efficiency_map;
+
+        // Histograms binned over the pixel matrix
+        MatrixStorage matrix_storage_;
+        std::unique_ptr<MatrixHistogram<TH2D>> hit_map, hit_map_local, hit_map_local_mc, charge_map, cluster_map;
+        std::unique_ptr<MatrixHistogram<TProfile2D>> cluster_size_map_local, residual_detector, residual_x_detector,
+            residual_y_detector, efficiency_local, efficiency_detector;
         Histogram<TProfile> efficiency_vs_x, efficiency_vs_y;
         Histogram<TH1D> event_size;
         Histogram<TH1D> cluster_size, cluster_size_x, cluster_size_y;
@@ -0,0 +1,330 @@
+/**
+ * @file
+ * @brief Definition of two-dimensional histograms over the pixel matrix with optional tiled storage
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_DETECTOR_HISTOGRAMMER_MATRIX_HISTOGRAM_H
+#define ALLPIX_DETECTOR_HISTOGRAMMER_MATRIX_HISTOGRAM_H
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <TH2D.h>
+#include <TProfile2D.h>
+
+#include "core/module/ThreadPool.hpp"
+#include "tools/ROOT.h"
+
+namespace allpix {
+    /**
+     * @brief Storage settings of the histograms over the pixel matrix
+     */
+    struct MatrixStorage {
+        bool tiled{false}; ///< If the bins are stored in tiles allocated on first use instead of dense histograms
+        int reduce_x{1};   ///< Number of bins in x merged into one bin of the written histogram, only used if tiled
+        int reduce_y{1};   ///< Number of bins in y merged into one bin of the written histogram, only used if tiled
+    };
+
+    /**
+     * @brief Histogram or profile binned over the pixel matrix, filled concurrently by all threads
+     *
+     * Without tiled storage, this is a thin wrapper around a \ref ThreadedHistogram. With tiled storage, every copy of the
+     * histogram only allocates square tiles of bins once a bin of the tile is filled, such that the memory scales with the
+     * area of the matrix actually hit instead of the size of the matrix times the number of copies. The sums of every bin
+     * and the statistics of the histogram are accumulated exactly as ROOT does when filling, and the dense histogram is
+     * only created when merging at the end of the run, optionally merging neighboring bins.
+     */
+    template <typename T> class MatrixHistogram {
+        static_assert(std::is_same_v<T, TH2D> || std::is_same_v<T, TProfile2D>, "only TH2D and TProfile2D are supported");
+        static constexpr bool is_profile = std::is_same_v<T, TProfile2D>;
+
+    public:
+        /**
+         * @brief Construct the histogram with fixed bins
+         * @param storage Storage settings
+         * @param name Name of the histogram
+         * @param title Title of the histogram
+         * @param nx Number of bins in x
+         * @param xlow Lower edge of the x axis
+         * @param xup Upper edge of the x axis
+         * @param ny Number of bins in y
+         * @param ylow Lower edge of the y axis
+         * @param yup Upper edge of the y axis
+         * @param zlow Lower limit of the values of a profile, values outside the limits are ignored unless both are equal
+         * @param zup Upper limit of the values of a profile
+         */
+        MatrixHistogram(const MatrixStorage& storage,
+                        std::string name,
+                        std::string title,
+                        int nx,
+                        double xlow,
+                        double xup,
+                        int ny,
+                        double ylow,
+                        double yup,
+                        double zlow = 0,
+                        double zup = 0)
+            : storage_(storage), name_(std::move(name)), title_(std::move(title)), nx_(nx), xlow_(xlow), xup_(xup),
+              ny_(ny), ylow_(ylow), yup_(yup), zlow_(zlow), zup_(zup) {
+            if(!storage_.tiled) {
+                if constexpr(is_profile) {
+                    dense_ = CreateHistogram<T>(name_.c_str(), title_.c_str(), nx, xlow, xup, ny, ylow, yup, zlow, zup);
+                } else {
+                    dense_ = CreateHistogram<T>(name_.c_str(), title_.c_str(), nx, xlow, xup, ny, ylow, yup);
+                }
+                return;
+            }
+
+            // Set up the copies in the same way as the threaded histograms
+            const auto num_threads = std::max(ThreadPool::threadCount(), 1u);
+            const auto max_copies = histogram_copies().load();
+            const auto num_slots = (max_copies == 0 ? num_threads : std::min(num_threads, max_copies));
+            copies_.resize(num_slots);
+            shared_ = (num_slots < num_threads);
+            if(shared_) {
+                mutexes_ = std::make_unique<std::mutex[]>(num_slots);
+            }
+            tiles_x_ = (nx_ + 2 + tile_size - 1) / tile_size;
+            tiles_y_ = (ny_ + 2 + tile_size - 1) / tile_size;
+            for(auto& copy : copies_) {
+                copy.tiles.resize(static_cast<size_t>(tiles_x_) * static_cast<size_t>(tiles_y_));
+            }
+        }
+
+        /**
+         * @brief Fill a histogram
+         * @param x Position in x
+         * @param y Position in y
+         * @param w Weight of the entry
+         */
+        void Fill(double x, double y, double w) { // NOLINT
+            static_assert(!is_profile, "profiles need to be filled with a value");
+            if(dense_ != nullptr) {
+                dense_->Fill(x, y, w);
+                return;
+            }
+            fill(x, y, 0, w);
+        }
+
+        /**
+         * @brief Fill a profile
+         * @param x Position in x
+         * @param y Position in y
+         * @param z Value to average
+         * @param w Weight of the entry
+         */
+        void Fill(double x, double y, double z, double w) { // NOLINT
+            static_assert(is_profile, "histograms cannot be filled with a value");
+            if(dense_ != nullptr) {
+                dense_->Fill(x, y, z, w);
+                return;
+            }
+            fill(x, y, z, w);
+        }
+
+        /**
+         * @brief Merge the copies into the final histogram
+         * @return Final histogram, with merged bins if requested
+         * @warning The tiles are released after merging, the histogram cannot be filled anymore
+         */
+        std::shared_ptr<T> Merge() { // NOLINT
+            if(dense_ != nullptr) {
+                return dense_->Merge();
+            }
+            if(merged_ == nullptr) {
+                merged_ = materialize();
+            }
+            return merged_;
+        }
+
+    private:
+        static constexpr int tile_size = 32;
+
+        /**
+         * @brief Sums of a single bin, the value sums are only used for profiles
+         */
+        struct Bin {
+            double sumw{};   ///< Sum of weights
+            double sumw2{};  ///< Sum of squared weights
+            double sumwz{};  ///< Sum of weighted values
+            double sumwz2{}; ///< Sum of weighted squared values
+        };
+
+        /**
+         * @brief Copy of the histogram filled by one or several threads
+         */
+        struct Copy {
+            std::vector<std::unique_ptr<Bin[]>> tiles;
+            // Statistics in the order expected by ROOT: sumw, sumw2, sumwx, sumwx2, sumwy, sumwy2, sumwxy, sumwz, sumwz2
+            std::array<double, 9> stats{};
+            double entries{};
+            bool weighted{};
+        };
+
+        /**
+         * @brief Find the bin of a value on a fixed axis like ROOT, with underflow and overflow bins
+         */
+        static int find_bin(double value, int bins, double low, double up) {
+            if(value < low) {
+                return 0;
+            }
+            if(!(value < up)) {
+                return bins + 1;
+            }
+            return 1 + static_cast<int>(bins * (value - low) / (up - low));
+        }
+
+        void fill(double x, double y, double z, double w) {
+            // Values outside the limits of a profile are not counted at all
+            if(is_profile && zlow_ != zup_ && (z < zlow_ || z > zup_ || z != z)) {
+                return;
+            }
+
+            auto idx = ThreadPool::threadNum() % copies_.size();
+            std::unique_lock<std::mutex> lock;
+            if(shared_) {
+                lock = std::unique_lock<std::mutex>(mutexes_[idx]);
+            }
+            auto& copy = copies_[idx];
+
+            auto binx = find_bin(x, nx_, xlow_, xup_);
+            auto biny = find_bin(y, ny_, ylow_, yup_);
+            auto& tile = copy.tiles[static_cast<size_t>(binx / tile_size + tiles_x_ * (biny / tile_size))];
+            if(tile == nullptr) {
+                tile = std::make_unique<Bin[]>(tile_size * tile_size);
+            }
+            auto& bin = tile[static_cast<size_t>(binx % tile_size + tile_size * (biny % tile_size))];
+            bin.sumw += w;
+            bin.sumw2 += w * w;
+            bin.sumwz += w * z;
+            bin.sumwz2 += w * z * z;
+            copy.entries++;
+            copy.weighted = copy.weighted || (w != 1.);
+
+            // Entries in the underflow and overflow bins are not included in the statistics
+            if(binx == 0 || binx > nx_ || biny == 0 || biny > ny_) {
+                return;
+            }
+            copy.stats[0] += w;
+            copy.stats[1] += w * w;
+            copy.stats[2] += w * x;
+            copy.stats[3] += w * x * x;
+            copy.stats[4] += w * y;
+            copy.stats[5] += w * y * y;
+            copy.stats[6] += w * x * y;
+            copy.stats[7] += w * z;
+            copy.stats[8] += w * z * z;
+        }
+
+        /**
+         * @brief Create the dense histogram from the tiles of all copies
+         */
+        std::shared_ptr<T> materialize() {
+            auto reduce_x = std::max(storage_.reduce_x, 1);
+            auto reduce_y = std::max(storage_.reduce_y, 1);
+            auto nx = (nx_ + reduce_x - 1) / reduce_x;
+            auto ny = (ny_ + reduce_y - 1) / reduce_y;
+            auto xup = xlow_ + (xup_ - xlow_) / nx_ * nx * reduce_x;
+            auto yup = ylow_ + (yup_ - ylow_) / ny_ * ny * reduce_y;
+
+            std::shared_ptr<T> histogram;
+            if constexpr(is_profile) {
+                histogram = std::make_shared<T>(name_.c_str(), title_.c_str(), nx, xlow_, xup, ny, ylow_, yup, zlow_, zup_);
+            } else {
+                histogram = std::make_shared<T>(name_.c_str(), title_.c_str(), nx, xlow_, xup, ny, ylow_, yup);
+            }
+            histogram->SetDirectory(nullptr);
+
+            // Weighted entries require the sums of squared weights like when filling the histogram directly
+            auto weighted = std::any_of(copies_.begin(), copies_.end(), [](const auto& copy) { return copy.weighted; });
+            if constexpr(is_profile) {
+                if(weighted && histogram->GetBinSumw2()->fN == 0) {
+                    histogram->Sumw2();
+                }
+            } else {
+                if(weighted && histogram->GetSumw2N() == 0) {
+                    histogram->Sumw2();
+                }
+            }
+
+            auto reduce = [](int bin, int bins, int factor, int reduced_bins) {
+                return (bin == 0 ? 0 : (bin > bins ? reduced_bins + 1 : (bin - 1) / factor + 1));
+            };
+            std::array<double, 9> stats{};
+            double entries = 0;
+            for(auto& copy : copies_) {
+                for(int tile_y = 0; tile_y < tiles_y_; ++tile_y) {
+                    for(int tile_x = 0; tile_x < tiles_x_; ++tile_x) {
+                        const auto& tile = copy.tiles[static_cast<size_t>(tile_x + tiles_x_ * tile_y)];
+                        if(tile == nullptr) {
+                            continue;
+                        }
+                        for(int i = 0; i < tile_size * tile_size; ++i) {
+                            const auto& bin = tile[static_cast<size_t>(i)];
+                            auto binx = tile_x * tile_size + i % tile_size;
+                            auto biny = tile_y * tile_size + i / tile_size;
+                            if(bin.sumw == 0 && bin.sumw2 == 0) {
+                                continue;
+                            }
+                            auto target =
+                                histogram->GetBin(reduce(binx, nx_, reduce_x, nx), reduce(biny, ny_, reduce_y, ny));
+                            if constexpr(is_profile) {
+                                // Profiles store the weighted sums of the values as content and their squares as errors
+                                histogram->fArray[target] += bin.sumwz;
+                                histogram->GetSumw2()->fArray[target] += bin.sumwz2;
+                                histogram->SetBinEntries(target, histogram->GetBinEntries(target) + bin.sumw);
+                                if(histogram->GetBinSumw2()->fN > 0) {
+                                    histogram->GetBinSumw2()->fArray[target] += bin.sumw2;
+                                }
+                            } else {
+                                histogram->fArray[target] += bin.sumw;
+                                if(histogram->GetSumw2N() > 0) {
+                                    histogram->GetSumw2()->fArray[target] += bin.sumw2;
+                                }
+                            }
+                        }
+                    }
+                }
+                for(size_t i = 0; i < stats.size(); ++i) {
+                    stats[i] += copy.stats[i];
+                }
+                entries += copy.entries;
+                copy.tiles.clear();
+            }
+            histogram->PutStats(stats.data());
+            histogram->SetEntries(entries);
+            return histogram;
+        }
+
+        MatrixStorage storage_;
+        std::string name_, title_;
+        int nx_;
+        double xlow_, xup_;
+        int ny_;
+        double ylow_, yup_;
+        double zlow_, zup_;
+
+        Histogram<T> dense_;
+        std::shared_ptr<T> merged_;
+
+        int tiles_x_{}, tiles_y_{};
+        std::vector<Copy> copies_;
+
+        // Mutexes guarding the copies if they are shared between threads
+        bool shared_{false};
+        std::unique_ptr<std::mutex[]> mutexes_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_DETECTOR_HISTOGRAMMER_MATRIX_HISTOGRAM_H */
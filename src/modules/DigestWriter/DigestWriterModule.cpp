@@ -0,0 +1,158 @@
+/**
+ * @file
+ * @brief Implementation of the writer of per-event digests of the simulation objects
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "DigestWriterModule.hpp"
+
+#include <array>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <utility>
+
+#include "core/utils/log.h"
+
+#include "objects/objects.h"
+
+using namespace allpix;
+
+namespace {
+    /**
+     * @brief Incremental FNV-1a hash of the bit patterns of a sequence of values
+     */
+    class Hasher {
+    public:
+        template <typename T> Hasher& operator<<(T value) {
+            std::array<unsigned char, sizeof(T)> bytes{};
+            std::memcpy(bytes.data(), &value, sizeof(T));
+            for(auto byte : bytes) {
+                hash_ = (hash_ ^ byte) * 0x100000001b3;
+            }
+            return *this;
+        }
+        Hasher& operator<<(const ROOT::Math::XYZPoint& point) { return *this << point.x() << point.y() << point.z(); }
+
+        uint64_t hash() const { return hash_; }
+
+    private:
+        uint64_t hash_{0xcbf29ce484222325};
+    };
+} // namespace
+
+DigestWriterModule::DigestWriterModule(Configuration& config, Messenger* messenger, GeometryManager*)
+    : SequentialModule(config), messenger_(messenger) {
+    // Enable multithreading of this module if multithreading is enabled
+    allow_multithreading();
+
+    // Bind to all messages with filter
+    messenger_->registerFilter(this, &DigestWriterModule::filter);
+}
+
+void DigestWriterModule::initialize() {
+    output_file_name_ = createOutputFile(config_.get<std::string>("file_name", "digest"), "txt", true);
+    output_file_.open(output_file_name_);
+    output_file_ << "# Allpix Squared event digest\n# event detector object count sum hash\n";
+
+    // Read include and exclude list
+    if(config_.has("include") && config_.has("exclude")) {
+        throw InvalidValueError(config_, "exclude", "include and exclude parameter are mutually exclusive");
+    } else if(config_.has("include")) {
+        auto inc_arr = config_.getArray<std::string>("include");
+        include_.insert(inc_arr.begin(), inc_arr.end());
+    } else if(config_.has("exclude")) {
+        auto exc_arr = config_.getArray<std::string>("exclude");
+        exclude_.insert(exc_arr.begin(), exc_arr.end());
+    }
+}
+
+bool DigestWriterModule::filter(const std::shared_ptr<BaseMessage>& message, const std::string&) const { // NOLINT
+    const auto* entry = filter_cache_.get(*message, [this](const std::string& class_name) {
+        return (include_.empty() || include_.find(class_name) != include_.end()) &&
+               (exclude_.empty() || exclude_.find(class_name) == exclude_.end());
+    });
+    return entry != nullptr && entry->objects && entry->keep && message->getObjectCount() != 0;
+}
+
+void DigestWriterModule::add_object(Digest& digest, const Object& object) {
+    Hasher hasher;
+    double amount = 0;
+    if(const auto* charge = dynamic_cast<const SensorCharge*>(&object)) {
+        auto hash_charge = [charge](Hasher& charge_hasher, CarrierType type) {
+            charge_hasher << charge->getLocalPosition() << charge->getCharge() << static_cast<int>(type)
+                          << charge->getLocalTime();
+        };
+        hash_charge(hasher, charge->getType());
+        amount = charge->getCharge();
+
+        // Deposits of electron-hole pairs contribute their holes like a separate deposit, such that the digest does not
+        // depend on whether the deposits are paired
+        const auto* deposit = dynamic_cast<const DepositedCharge*>(charge);
+        if(deposit != nullptr && deposit->isPaired()) {
+            Hasher hole_hasher;
+            hash_charge(hole_hasher, CarrierType::HOLE);
+            digest.count++;
+            digest.sum += amount;
+            digest.hash += hole_hasher.hash();
+        }
+    } else if(const auto* pixel_charge = dynamic_cast<const PixelCharge*>(&object)) {
+        hasher << pixel_charge->getIndex().x() << pixel_charge->getIndex().y() << pixel_charge->getCharge()
+               << pixel_charge->getLocalTime();
+        amount = static_cast<double>(pixel_charge->getCharge());
+    } else if(const auto* hit = dynamic_cast<const PixelHit*>(&object)) {
+        hasher << hit->getIndex().x() << hit->getIndex().y() << hit->getSignal() << hit->getLocalTime();
+        amount = hit->getSignal();
+    } else if(const auto* particle = dynamic_cast<const MCParticle*>(&object)) {
+        hasher << particle->getParticleID() << particle->getLocalStartPoint() << particle->getLocalEndPoint()
+               << particle->getTotalDepositedCharge();
+        amount = particle->getTotalDepositedCharge();
+    } else if(const auto* track = dynamic_cast<const MCTrack*>(&object)) {
+        hasher << track->getParticleID() << track->getStartPoint() << track->getEndPoint()
+               << track->getKineticEnergyInitial();
+        amount = track->getKineticEnergyInitial();
+    }
+
+    // Objects without known quantities only contribute to the count
+    digest.count++;
+    digest.sum += amount;
+    digest.hash += hasher.hash();
+}
+
+void DigestWriterModule::run(Event* event) {
+    auto messages = messenger_->fetchFilteredMessages(this, event);
+
+    // Digests ordered by detector and object type, such that the lines do not depend on the order of the messages
+    std::map<std::pair<std::string, std::string>, Digest> digests;
+    for(auto& [message, name] : messages) {
+        // The class name of the objects has been stored when filtering the message
+        const auto* entry = filter_cache_.get(*message, [](const std::string&) { return true; });
+        auto detector = (message->getDetector() != nullptr ? message->getDetector()->getName() : "-");
+        auto& digest = digests[{detector, entry->class_name}];
+        for(const Object& object : message->getObjectArray()) {
+            add_object(digest, object);
+        }
+    }
+
+    std::ostringstream lines;
+    lines << std::setprecision(17);
+    for(const auto& [key, digest] : digests) {
+        lines << event->number << ' ' << key.first << ' ' << key.second << ' ' << digest.count << ' ' << digest.sum << ' '
+              << std::hex << std::setw(16) << std::setfill('0') << digest.hash << std::dec << '\n';
+    }
+    output_file_ << lines.str();
+    event_cnt_++;
+}
+
+void DigestWriterModule::finalize() {
+    output_file_ << "# " << event_cnt_ << " events\n";
+    output_file_.flush();
+
+    LOG(STATUS) << "Wrote digests of " << event_cnt_ << " events to file:" << std::endl << output_file_name_;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file
+ * @brief Definition of the writer of per-event digests of the simulation objects
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <string>
+
+#include "core/config/Configuration.hpp"
+#include "core/geometry/GeometryManager.hpp"
+#include "core/messenger/Messenger.hpp"
+#include "core/module/Event.hpp"
+#include "core/module/Module.hpp"
+
+#include "objects/Object.hpp"
+#include "tools/message_filter.h"
+
+namespace allpix {
+    /**
+     * @ingroup Modules
+     * @brief Module to write a compact digest of the objects of every event to a text file
+     *
+     * Listens to all objects dispatched in the framework and writes one line per event, detector and object type with the
+     * number of objects, their total charge or signal and a hash of their key quantities. Digest files of two runs can be
+     * compared to verify that a change of the execution mode does not alter the results.
+     */
+    class DigestWriterModule : public SequentialModule {
+    public:
+        /**
+         * @brief Constructor for this unique module
+         * @param config Configuration object for this module as retrieved from the steering file
+         * @param messenger Pointer to the messenger object to allow binding to messages on the bus
+         * @param geo_mgr Pointer to the geometry manager, containing the detectors
+         */
+        DigestWriterModule(Configuration& config, Messenger* messenger, GeometryManager* geo_mgr);
+
+        /**
+         * @brief Receive a single message containing objects of arbitrary type
+         * @param message Message dispatched in the framework
+         * @param name Name of the message
+         */
+        bool filter(const std::shared_ptr<BaseMessage>& message, const std::string& name) const;
+
+        /**
+         * @brief Open the file to write the digests to
+         */
+        void initialize() override;
+
+        /**
+         * @brief Write the digests of the objects of the event
+         */
+        void run(Event* event) override;
+
+        /**
+         * @brief Close the digest file
+         */
+        void finalize() override;
+
+    private:
+        /**
+         * @brief Digest of the objects of one type in one detector
+         */
+        struct Digest {
+            uint64_t count{};
+            double sum{};
+            uint64_t hash{};
+        };
+
+        /**
+         * @brief Add an object to a digest
+         * @param digest Digest to add the object to
+         * @param object Object to add
+         *
+         * The hash of the object is computed from the bit patterns of its key quantities and added to the hash of the
+         * digest, such that the digest does not depend on the order of the objects.
+         */
+        static void add_object(Digest& digest, const Object& object);
+
+        Messenger* messenger_;
+
+        // Object names to include or exclude from the digests
+        std::set<std::string> include_;
+        std::set<std::string> exclude_;
+        // Decisions of the filter per message type
+        mutable MessageFilterCache filter_cache_;
+
+        std::string output_file_name_{};
+        std::ofstream output_file_;
+
+        std::atomic<uint64_t> event_cnt_{};
+    };
+} // namespace allpix
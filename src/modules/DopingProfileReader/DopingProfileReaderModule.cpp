@@ -11,19 +11,103 @@
 
 #include "DopingProfileReaderModule.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
 #include <string>
 #include <utility>
+#include <vector>
 
+#include <Math/Point3D.h>
 #include <TH2F.h>
 
 #include "core/utils/log.h"
 
 using namespace allpix;
 
+namespace {
+    /**
+     * @brief Doping regions along the sensor depth, indexed by a uniform table of depth bins
+     *
+     * Every bin stores the first region whose lower boundary is not above the beginning of the bin. As long as the bins are
+     * not wider than the thinnest region, at most one boundary falls into a bin and the region is found with a single
+     * comparison instead of a search through all boundaries.
+     */
+    class DepthRegions {
+    public:
+        /**
+         * @brief Build the table from the regions
+         * @param regions Concentration of all regions, keyed by the depth of their lower boundary
+         */
+        explicit DepthRegions(const std::map<double, double>& regions) {
+            for(const auto& [depth, concentration] : regions) {
+                boundaries_.push_back(depth);
+                concentrations_.push_back(concentration);
+            }
+
+            // Bins as wide as the thinnest region, limited to a maximum number of bins
+            auto range = boundaries_.back() - boundaries_.front();
+            auto width = std::numeric_limits<double>::max();
+            for(size_t i = 1; i < boundaries_.size(); ++i) {
+                width = std::min(width, boundaries_[i] - boundaries_[i - 1]);
+            }
+            width_ = (range > 0 ? std::max(width, range / max_bins) : 1.);
+
+            // Boundaries are assigned to bins with the same arithmetic as the lookup to be robust against rounding
+            first_region_.resize(static_cast<size_t>(std::ceil(range / width_)) + 1);
+            size_t index = 0;
+            for(size_t bin = 0; bin < first_region_.size(); ++bin) {
+                while(index + 1 < boundaries_.size() && get_bin(boundaries_[index]) < bin) {
+                    ++index;
+                }
+                first_region_[bin] = index;
+            }
+        }
+
+        /**
+         * @brief Get the concentration at a given depth
+         * @param depth Depth below the sensor surface
+         * @return Concentration of the first region with its lower boundary not above the depth, or of the deepest region
+         */
+        double operator()(double depth) const {
+            auto index = first_region_[get_bin(depth)];
+            while(index + 1 < boundaries_.size() && boundaries_[index] < depth) {
+                ++index;
+            }
+            return concentrations_[index];
+        }
+
+        /**
+         * @brief Get the number of depth bins of the table
+         * @return Number of bins
+         */
+        size_t bins() const { return first_region_.size(); }
+
+    private:
+        size_t get_bin(double depth) const {
+            auto bin = std::clamp((depth - boundaries_.front()) / width_, 0., static_cast<double>(first_region_.size() - 1));
+            return static_cast<size_t>(bin);
+        }
+
+        static constexpr double max_bins = 65536;
+
+        std::vector<double> boundaries_;
+        std::vector<double> concentrations_;
+        std::vector<size_t> first_region_;
+        double width_{};
+    };
+} // namespace
+
 DopingProfileReaderModule::DopingProfileReaderModule(Configuration& config, Messenger*, std::shared_ptr<Detector> detector)
     : Module(config, detector), detector_(std::move(detector)) {
     // Enable multithreading of this module if multithreading is enabled
     allow_multithreading();
+
+    // Initialization only modifies this detector and can run in parallel to other detectors unless plots are booked
+    if(!config_.get<bool>("output_plots", false)) {
+        allow_parallel_initialization();
+    }
 }
 
 void DopingProfileReaderModule::initialize() {
@@ -69,13 +153,31 @@ void DopingProfileReaderModule::initialize() {
         }
         LOG(DEBUG) << "Doping profile has offset of " << offset << " fractions of the field size";
 
-        detector_->setDopingProfileGrid(field_data.getData(),
-                                        field_data.getDimensions(),
-                                        field_data.getSize(),
-                                        field_mapping,
-                                        field_scale,
-                                        {{offset.x(), offset.y()}},
-                                        thickness_domain);
+        // Storage precision of the field grid, reduced precision lowers the memory footprint of the field lookup
+        auto precision = config_.get<FieldPrecision>("field_precision", FieldPrecision::DOUBLE);
+        // Interpolation between the grid points, allows using coarser field grids
+        auto interpolation = config_.get<FieldInterpolation>("interpolation", FieldInterpolation::NEAREST);
+        LOG(DEBUG) << "Field values are interpolated with " << magic_enum::enum_name(interpolation) << " interpolation";
+        // Memory layout of the field grid, bricks keep cells neighboring along all axes close in memory
+        auto layout = config_.get<FieldLayout>("field_layout", FieldLayout::ROW_MAJOR);
+        LOG(DEBUG) << "Field values are stored in " << magic_enum::enum_name(layout) << " layout";
+
+        auto summary = detector_->setDopingProfileGrid(field_data.getValues(),
+                                                       field_data.getDimensions(),
+                                                       field_data.getSize(),
+                                                       field_mapping,
+                                                       field_scale,
+                                                       {{offset.x(), offset.y()}},
+                                                       thickness_domain,
+                                                       precision,
+                                                       interpolation,
+                                                       field_data.getRefinement(),
+                                                       layout);
+        if(precision != FieldPrecision::DOUBLE) {
+            LOG(INFO) << "Doping profile stored with " << magic_enum::enum_name(precision) << " precision, saving "
+                      << static_cast<double>(summary.memory_saved) / (1024. * 1024.) << " MiB with a maximum deviation of "
+                      << Units::display(summary.max_deviation, {"/cm/cm/cm"});
+        }
 
     } else if(field_model == DopingProfile::CONSTANT) {
         LOG(TRACE) << "Adding constant doping concentration";
@@ -100,16 +202,16 @@ void DopingProfileReaderModule::initialize() {
             LOG(INFO) << "Set constant doping concentration of " << Units::display(region.back(), {"/cm/cm/cm"})
                       << " at sensor depth " << Units::display(region.front(), {"um", "mm"});
         }
-        FieldFunction<double> function = [concentration_map, thickness = detector_->getModel()->getSensorSize().z()](
-                                             const ROOT::Math::XYZPoint& position) {
-            // Lower bound returns the first element that is *not less* than the given key - in this case, the z position
-            // should always be *before* the region boundary set in the vector
-            auto item = concentration_map.lower_bound(thickness / 2 - position.z());
-            if(item != concentration_map.end()) {
-                return item->second;
-            } else {
-                return concentration_map.rbegin()->second;
-            }
+        if(concentration_map.empty()) {
+            throw InvalidValueError(config_, "doping_concentration", "expecting at least one region");
+        }
+
+        // The z position should always be *before* the region boundary, i.e. the first boundary not less than the depth
+        DepthRegions regions(concentration_map);
+        LOG(DEBUG) << "Indexed " << concentration_map.size() << " doping regions with " << regions.bins() << " depth bins";
+        FieldFunction<double> function = [regions = std::move(regions),
+                                          thickness = model->getSensorSize().z()](const ROOT::Math::XYZPoint& position) {
+            return regions(thickness / 2 - position.z());
         };
 
         detector_->setDopingProfileFunction(std::move(function), FieldType::CUSTOM1D);
@@ -130,8 +232,28 @@ FieldData<double> DopingProfileReaderModule::read_field() {
     try {
         LOG(TRACE) << "Fetching doping concentration map from mesh file";
 
+        // Sub-volume of the field file to read, in the coordinates of the file, and averaging of blocks of cells
+        FieldSubset subset;
+        auto crop_min = config_.get<ROOT::Math::XYZPoint>("field_crop_min", ROOT::Math::XYZPoint());
+        subset.region_min = {{crop_min.x(), crop_min.y(), crop_min.z()}};
+        if(config_.has("field_crop_max")) {
+            auto crop_max = config_.get<ROOT::Math::XYZPoint>("field_crop_max");
+            subset.region_max = {{crop_max.x(), crop_max.y(), crop_max.z()}};
+        }
+        for(size_t i = 0; i < 3; ++i) {
+            if(subset.region_min.at(i) < 0 || subset.region_min.at(i) >= subset.region_max.at(i)) {
+                throw InvalidValueError(config_, "field_crop_max", "field region has to be positive and non-empty");
+            }
+        }
+        auto downsampling = config_.getArray<size_t>("field_downsampling", {1, 1, 1});
+        if(downsampling.size() != 3 || std::find(downsampling.begin(), downsampling.end(), 0) != downsampling.end()) {
+            throw InvalidValueError(config_, "field_downsampling", "expecting three positive downsampling factors");
+        }
+        std::copy(downsampling.begin(), downsampling.end(), subset.downsampling.begin());
+
         // Get field from file
-        auto field_data = field_parser_.getByFileName(config_.getPath("file_name", true), "/cm/cm/cm");
+        auto field_data = field_parser_.getByFileName(
+            config_.getPath("file_name", true), "/cm/cm/cm", config_.get<bool>("cache_init_file", false), subset);
 
         LOG(INFO) << "Set doping concentration map with " << field_data.getDimensions().at(0) << "x"
                   << field_data.getDimensions().at(1) << "x" << field_data.getDimensions().at(2) << " cells";
@@ -11,6 +11,9 @@
 
 #include "ElectricFieldReaderModule.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <fstream>
 #include <limits>
 #include <memory>
@@ -19,6 +22,7 @@
 #include <string>
 #include <utility>
 
+#include <Math/Point3D.h>
 #include <Math/Vector3D.h>
 #include <TFormula.h>
 #include <TH2F.h>
@@ -35,6 +39,13 @@ ElectricFieldReaderModule::ElectricFieldReaderModule(Configuration& config, Mess
     // Enable multithreading of this module if multithreading is enabled
     allow_multithreading();
 
+    // Mesh and analytic fields only modify this detector and can be initialized in parallel to other detectors, while
+    // custom fields are compiled by ROOT and plots are booked in the ROOT file
+    if(!config_.get<bool>("output_plots", false) &&
+       !(config_.has("model") && config_.get<ElectricField>("model") == ElectricField::CUSTOM)) {
+        allow_parallel_initialization();
+    }
+
     // NOTE use voltage as a synonym for bias voltage
     config_.setAlias("bias_voltage", "voltage");
     // NOTE use field_depth as a synonym for depletion_depth
@@ -96,13 +107,40 @@ void ElectricFieldReaderModule::initialize() {
         }
         LOG(DEBUG) << "Electric field has offset of " << offset << " fractions of the field size";
 
-        detector_->setElectricFieldGrid(field_data.getData(),
-                                        field_data.getDimensions(),
-                                        field_data.getSize(),
-                                        field_mapping,
-                                        field_scale,
-                                        {{offset.x(), offset.y()}},
-                                        thickness_domain);
+        // Storage precision of the field grid, reduced precision lowers the memory footprint of the field lookup
+        auto precision = config_.get<FieldPrecision>("field_precision", FieldPrecision::DOUBLE);
+        // Interpolation between the grid points, allows using coarser field grids
+        auto interpolation = config_.get<FieldInterpolation>("interpolation", FieldInterpolation::NEAREST);
+        LOG(DEBUG) << "Field values are interpolated with " << magic_enum::enum_name(interpolation) << " interpolation";
+        // Memory layout of the field grid, bricks keep cells neighboring along all axes close in memory
+        auto layout = config_.get<FieldLayout>("field_layout", FieldLayout::ROW_MAJOR);
+        LOG(DEBUG) << "Field values are stored in " << magic_enum::enum_name(layout) << " layout";
+
+        auto summary = detector_->setElectricFieldGrid(field_data.getValues(),
+                                                       field_data.getDimensions(),
+                                                       field_data.getSize(),
+                                                       field_mapping,
+                                                       field_scale,
+                                                       {{offset.x(), offset.y()}},
+                                                       thickness_domain,
+                                                       precision,
+                                                       interpolation,
+                                                       field_data.getRefinement(),
+                                                       layout);
+        if(precision != FieldPrecision::DOUBLE) {
+            LOG(INFO) << "Electric field stored with " << magic_enum::enum_name(precision) << " precision, saving "
+                      << static_cast<double>(summary.memory_saved) / (1024. * 1024.) << " MiB with a maximum deviation of "
+                      << Units::display(summary.max_deviation, {"V/cm", "kV/cm"});
+        }
+
+        // Look up the field half-way through the thickness domain, which is interpolated between grid points if requested
+        auto center = model->getPixelCenter(0, 0);
+        auto field = detector_->getElectricField(
+            ROOT::Math::XYZPoint(center.x(), center.y(), (thickness_domain.first + thickness_domain.second) / 2.0));
+        LOG(DEBUG) << "Value of electric field at pixel center: " << Units::display(field, {"V/cm"});
+    } else if(field_model == ElectricField::TETRAHEDRAL) {
+        LOG(TRACE) << "Adding electric field from tetrahedral mesh";
+        detector_->setElectricFieldFunction(get_mesh_field_function(thickness_domain), thickness_domain, FieldType::CUSTOM);
     } else if(field_model == ElectricField::CONSTANT) {
         LOG(TRACE) << "Adding constant electric field";
         auto field_z = config_.get<double>("bias_voltage") / getDetector()->getModel()->getSensorSize().z();
@@ -276,11 +314,32 @@ FieldData<double> ElectricFieldReaderModule::read_field() {
     try {
         LOG(TRACE) << "Fetching electric field from mesh file";
 
+        // Sub-volume of the field file to read, in the coordinates of the file, and averaging of blocks of cells
+        FieldSubset subset;
+        auto crop_min = config_.get<ROOT::Math::XYZPoint>("field_crop_min", ROOT::Math::XYZPoint());
+        subset.region_min = {{crop_min.x(), crop_min.y(), crop_min.z()}};
+        if(config_.has("field_crop_max")) {
+            auto crop_max = config_.get<ROOT::Math::XYZPoint>("field_crop_max");
+            subset.region_max = {{crop_max.x(), crop_max.y(), crop_max.z()}};
+        }
+        for(size_t i = 0; i < 3; ++i) {
+            if(subset.region_min.at(i) < 0 || subset.region_min.at(i) >= subset.region_max.at(i)) {
+                throw InvalidValueError(config_, "field_crop_max", "field region has to be positive and non-empty");
+            }
+        }
+        auto downsampling = config_.getArray<size_t>("field_downsampling", {1, 1, 1});
+        if(downsampling.size() != 3 || std::find(downsampling.begin(), downsampling.end(), 0) != downsampling.end()) {
+            throw InvalidValueError(config_, "field_downsampling", "expecting three positive downsampling factors");
+        }
+        std::copy(downsampling.begin(), downsampling.end(), subset.downsampling.begin());
+
         // Get field from file
-        auto field_data = field_parser_.getByFileName(config_.getPath("file_name", true), "V/cm");
+        auto field_data = field_parser_.getByFileName(
+            config_.getPath("file_name", true), "V/cm", config_.get<bool>("cache_init_file", false), subset);
 
         // Warn at field values larger than 1MV/cm / 10 MV/mm. Simple lookup per vector component, not total field magnitude
-        auto max_field = *std::max_element(std::begin(*field_data.getData()), std::end(*field_data.getData()));
+        const auto* values = field_data.getValues().get();
+        auto max_field = *std::max_element(values, values + field_data.getNumberOfValues());
         if(max_field > 10) {
             LOG(WARNING) << "Very high electric field of " << Units::display(max_field, "kV/cm")
                          << ", this is most likely not desired.";
@@ -300,6 +359,62 @@ FieldData<double> ElectricFieldReaderModule::read_field() {
     }
 }
 
+std::mutex ElectricFieldReaderModule::mesh_mutex_;
+std::map<std::filesystem::path, std::shared_ptr<const FieldMesh>> ElectricFieldReaderModule::meshes_;
+
+/**
+ * Meshes are shared between all detectors using the same file. The walk-based point location of the mesh starts from the
+ * tetrahedron of the previous lookup on the same thread, which usually belongs to the previous step of the same carrier.
+ */
+FieldFunction<ROOT::Math::XYZVector>
+ElectricFieldReaderModule::get_mesh_field_function(std::pair<double, double> thickness_domain) {
+    std::shared_ptr<const FieldMesh> mesh;
+    try {
+        auto file_name = config_.getPath("file_name", true);
+        std::lock_guard<std::mutex> lock(mesh_mutex_);
+        auto& cached = meshes_[file_name];
+        if(cached == nullptr) {
+            LOG(TRACE) << "Reading tetrahedral mesh from file " << file_name;
+            cached = FieldMesh::read(file_name);
+        }
+        mesh = cached;
+    } catch(std::invalid_argument& e) {
+        throw InvalidValueError(config_, "file_name", e.what());
+    } catch(std::runtime_error& e) {
+        throw InvalidValueError(config_, "file_name", e.what());
+    } catch(std::bad_alloc& e) {
+        throw InvalidValueError(config_, "file_name", "file too large");
+    }
+    if(mesh->getComponents() != 3) {
+        throw InvalidValueError(config_, "file_name", "mesh does not contain a vector field");
+    }
+
+    LOG(INFO) << "Set electric field on tetrahedral mesh with " << mesh->getElementCount() << " tetrahedra and "
+              << mesh->getVertexCount() << " vertices, using "
+              << static_cast<double>(mesh->getMemory()) / (1024. * 1024.) << " MiB";
+
+    // Center the mesh on the pixel in x and y and map its extent along z onto the thickness domain
+    const auto& mesh_min = mesh->getMin();
+    const auto& mesh_max = mesh->getMax();
+    auto pitch = detector_->getModel()->getPixelSize();
+    if(std::fabs(mesh_max[0] - mesh_min[0] - pitch.x()) > 1e-6 || std::fabs(mesh_max[1] - mesh_min[1] - pitch.y()) > 1e-6) {
+        LOG(WARNING) << "Tetrahedral mesh size of " << Units::display(mesh_max[0] - mesh_min[0], {"um", "mm"}) << " x "
+                     << Units::display(mesh_max[1] - mesh_min[1], {"um", "mm"}) << " does not match the pixel pitch";
+    }
+    auto center_x = (mesh_min[0] + mesh_max[0]) / 2;
+    auto center_y = (mesh_min[1] + mesh_max[1]) / 2;
+    auto scale_z = (mesh_max[2] - mesh_min[2]) / (thickness_domain.second - thickness_domain.first);
+
+    return [mesh, center_x, center_y, scale_z, mesh_z = mesh_min[2], domain_z = thickness_domain.first](
+               const ROOT::Math::XYZPoint& pos) {
+        // Positions outside of the mesh have no field
+        std::array<double, 3> field{};
+        mesh->interpolate({{pos.x() + center_x, pos.y() + center_y, mesh_z + (pos.z() - domain_z) * scale_z}},
+                          field.data());
+        return ROOT::Math::XYZVector(field[0], field[1], field[2]);
+    };
+}
+
 void ElectricFieldReaderModule::create_output_plots() {
     LOG(TRACE) << "Creating output plots";
 
@@ -9,14 +9,17 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <filesystem>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include "core/config/Configuration.hpp"
 #include "core/geometry/GeometryManager.hpp"
 #include "core/messenger/Messenger.hpp"
+#include "tools/field_mesh.h"
 #include "tools/field_parser.h"
 
 #include "core/module/Module.hpp"
@@ -35,11 +38,12 @@ namespace allpix {
          * @brief Different electric field types
          */
         enum class ElectricField {
-            CONSTANT,  ///< Constant electric field
-            LINEAR,    ///< Linear electric field
-            MESH,      ///< Electric field defined by a mesh
-            PARABOLIC, ///< Parabolic electric field
-            CUSTOM,    ///< Custom electric field, defined as 3-dimensional function
+            CONSTANT,    ///< Constant electric field
+            LINEAR,      ///< Linear electric field
+            MESH,        ///< Electric field defined by a mesh
+            TETRAHEDRAL, ///< Electric field defined on the unstructured tetrahedral mesh of a TCAD simulation
+            PARABOLIC,   ///< Parabolic electric field
+            CUSTOM,      ///< Custom electric field, defined as 3-dimensional function
         };
 
     public:
@@ -87,6 +91,15 @@ namespace allpix {
         FieldData<double> read_field();
         static FieldParser<double> field_parser_;
 
+        /**
+         * @brief Create a field function interpolating the field on a tetrahedral mesh read from file
+         * @param thickness_domain Domain of the thickness where the field is defined
+         * @return Field function with the mesh centered on the pixel and spanning the thickness domain
+         */
+        FieldFunction<ROOT::Math::XYZVector> get_mesh_field_function(std::pair<double, double> thickness_domain);
+        static std::mutex mesh_mutex_;
+        static std::map<std::filesystem::path, std::shared_ptr<const FieldMesh>> meshes_;
+
         /**
          * @brief Create output plots of the electric field profile
          */
@@ -0,0 +1,220 @@
+/**
+ * @file
+ * @brief Implementation of the propagation of charge carrier groups on an offload device
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "DevicePropagation.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "tools/device_tables.h"
+#include "tools/runge_kutta.h"
+
+using namespace allpix;
+
+namespace {
+    using Tableau = tableau::StaticRK5;
+    constexpr size_t stages = Tableau::stages;
+    constexpr size_t tableau_size = (stages + 2) * stages;
+
+#ifdef _OPENMP
+#pragma omp declare target
+#endif
+    /**
+     * @brief Look up the drift velocity and the diffusion constant of a carrier type at a position
+     *
+     * The position is folded into the unit cell of the pixel the tables have been computed for, the values of the bin
+     * containing it are returned.
+     */
+    inline double lookup(const DevicePropagation::Parameters& parameters,
+                         const float* tables,
+                         unsigned int carrier,
+                         const double* position,
+                         double* velocity) {
+        std::array<size_t, 3> bin{};
+        for(size_t axis = 0; axis < 2; ++axis) {
+            bin[axis] = device::to_cell_bin(
+                position[axis], parameters.pixel_center[axis], parameters.pixel_pitch[axis], parameters.bins[axis]);
+        }
+        auto bottom = parameters.sensor_center[2] - parameters.sensor_size[2] / 2;
+        bin[2] = device::to_bin((position[2] - bottom) / parameters.sensor_size[2], parameters.bins[2]);
+
+        auto index = ((carrier * parameters.bins[0] + bin[0]) * parameters.bins[1] + bin[1]) * parameters.bins[2] + bin[2];
+        const float* values = tables + index * DevicePropagation::values_per_bin;
+        velocity[0] = values[0];
+        velocity[1] = values[1];
+        velocity[2] = values[2];
+        return values[3];
+    }
+
+    /**
+     * @brief Propagate a single group until it leaves the sensor or reaches the integration time
+     * @param parameters Parameters of the propagation
+     * @param tables Tables of drift velocities and diffusion constants
+     * @param tableau Coefficients of the Runge-Kutta tableau
+     * @param group Group to propagate
+     * @param seed Seed of the random number streams
+     * @param stream Random number stream of this group
+     */
+    void propagate_group(const DevicePropagation::Parameters& parameters,
+                         const float* tables,
+                         const double* tableau,
+                         DevicePropagation::Group& group,
+                         uint64_t seed,
+                         uint64_t stream) {
+        auto coefficient = [tableau](size_t row, size_t column) { return tableau[row * stages + column]; };
+
+        double position[3] = {group.position[0], group.position[1], group.position[2]};
+        double last_position[3] = {position[0], position[1], position[2]};
+        double k[stages][3];
+        double timestep = parameters.timestep_start;
+        double time = 0;
+        unsigned int steps = 0;
+        bool halted = false;
+
+        while(group.start_time + time < parameters.integration_time) {
+            for(int axis = 0; axis < 3; ++axis) {
+                last_position[axis] = position[axis];
+            }
+
+            // Runge-Kutta stages, the first stage provides the diffusion constant at the pre-step position
+            double diffusion_constant = 0;
+            for(size_t i = 0; i < stages; ++i) {
+                double stage_position[3] = {position[0], position[1], position[2]};
+                for(size_t j = 0; j < i; ++j) {
+                    for(int axis = 0; axis < 3; ++axis) {
+                        stage_position[axis] += timestep * coefficient(i, j) * k[j][axis];
+                    }
+                }
+                auto diffusion = lookup(parameters, tables, group.carrier, stage_position, k[i]);
+                if(i == 0) {
+                    diffusion_constant = diffusion;
+                }
+            }
+
+            // Combine stages to step value and error estimate
+            double step[3] = {0, 0, 0};
+            double error[3] = {0, 0, 0};
+            for(size_t i = 0; i < stages; ++i) {
+                for(int axis = 0; axis < 3; ++axis) {
+                    step[axis] += timestep * coefficient(stages, i) * k[i][axis];
+                    error[axis] += timestep * coefficient(stages + 1, i) * k[i][axis];
+                }
+            }
+            for(int axis = 0; axis < 3; ++axis) {
+                error[axis] = step[axis] - error[axis];
+                position[axis] += step[axis];
+            }
+            time += timestep;
+            ++steps;
+
+            // Apply diffusion with normal random numbers drawn from the stream of this group
+            auto diffusion_std_dev = std::sqrt(2. * diffusion_constant * timestep);
+            auto normal = device::normal_numbers(seed, stream, steps);
+            for(size_t axis = 0; axis < 3; ++axis) {
+                position[axis] += diffusion_std_dev * normal[axis];
+            }
+
+            // Stop the group when it leaves the sensor
+            bool within_sensor = true;
+            for(size_t axis = 0; axis < 3; ++axis) {
+                within_sensor &= (2 * std::fabs(position[axis] - parameters.sensor_center[axis]) <=
+                                  parameters.sensor_size[axis]);
+            }
+            if(!within_sensor) {
+                halted = true;
+                break;
+            }
+
+            // Adapt step size to match target precision, lowering the timestep when reaching the sensor edge
+            auto uncertainty = std::sqrt(error[0] * error[0] + error[1] * error[1] + error[2] * error[2]);
+            if(std::fabs(parameters.sensor_size[2] / 2.0 - position[2]) < 2 * step[2]) {
+                timestep *= 0.75;
+            } else if(uncertainty > parameters.spatial_precision) {
+                timestep *= 0.75;
+            } else if(2 * uncertainty < parameters.spatial_precision) {
+                timestep *= 1.5;
+            }
+            timestep = std::max(std::min(timestep, parameters.timestep_max), parameters.timestep_min);
+        }
+
+        for(size_t axis = 0; axis < 3; ++axis) {
+            group.position[axis] = position[axis];
+            group.last_position[axis] = last_position[axis];
+        }
+        group.time = time;
+        group.steps = steps;
+        group.halted = halted;
+    }
+#ifdef _OPENMP
+#pragma omp end declare target
+#endif
+} // namespace
+
+DevicePropagation::DevicePropagation(const Parameters& parameters, std::vector<float> tables)
+    : parameters_(parameters), tables_(std::move(tables)) {
+    const float* data = tables_.data();
+    const size_t size = tables_.size();
+    const double* tableau = &Tableau::values[0][0];
+#ifdef _OPENMP
+#pragma omp target enter data map(to : data[0 : size], tableau[0 : tableau_size])
+#endif
+    static_cast<void>(data);
+    static_cast<void>(size);
+    static_cast<void>(tableau);
+}
+
+DevicePropagation::~DevicePropagation() {
+    const float* data = tables_.data();
+    const size_t size = tables_.size();
+    const double* tableau = &Tableau::values[0][0];
+#ifdef _OPENMP
+#pragma omp target exit data map(delete : data[0 : size], tableau[0 : tableau_size])
+#endif
+    static_cast<void>(data);
+    static_cast<void>(size);
+    static_cast<void>(tableau);
+}
+
+void DevicePropagation::propagate(std::vector<Group>& groups, uint64_t seed) const {
+    const Parameters parameters = parameters_;
+    const float* tables = tables_.data();
+    const size_t tables_size = tables_.size();
+    const double* tableau = &Tableau::values[0][0];
+    Group* data = groups.data();
+    const size_t size = groups.size();
+
+    // The tables are already present on the device, only the groups are transferred
+#ifdef _OPENMP
+#pragma omp target teams distribute parallel for map(to : tables[0 : tables_size], tableau[0 : tableau_size])    \
+    map(tofrom : data[0 : size]) firstprivate(parameters, seed)
+#endif
+    for(size_t idx = 0; idx < size; ++idx) {
+        propagate_group(parameters, tables, tableau, data[idx], seed, idx);
+    }
+    static_cast<void>(tables_size);
+}
+
+std::string DevicePropagation::getDeviceDescription() {
+#ifdef _OPENMP
+    auto devices = omp_get_num_devices();
+    if(devices > 0) {
+        return "offload device " + std::to_string(omp_get_default_device()) + " of " + std::to_string(devices);
+    }
+    return "host, no offload device available";
+#else
+    return "host, module built without offloading support";
+#endif
+}
@@ -0,0 +1,112 @@
+/**
+ * @file
+ * @brief Definition of the propagation of charge carrier groups on an offload device
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_GENERIC_PROPAGATION_DEVICE_PROPAGATION_H
+#define ALLPIX_GENERIC_PROPAGATION_DEVICE_PROPAGATION_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace allpix {
+    /**
+     * @brief Propagation of independent charge carrier groups on an offload device
+     *
+     * The drift velocity and the diffusion constant of both carrier types are tabulated on a regular grid spanning the unit
+     * cell of one pixel over the full sensor thickness. The tables are transferred to the device once and kept there for
+     * the lifetime of the object. All groups of a call are then propagated in parallel with an adaptive fifth-order
+     * Runge-Kutta integration and Gaussian diffusion, each group drawing its random numbers from its own stream of a
+     * counter-based generator. The result therefore does not depend on the number of groups propagated concurrently.
+     *
+     * The device code is written as OpenMP target regions. If the module is not built with offloading support, or no
+     * device is available at run time, the same code is executed on the host.
+     */
+    class DevicePropagation {
+    public:
+        /**
+         * @brief Parameters of the propagation, all lengths given in local coordinates
+         */
+        struct Parameters {
+            double timestep_start{};    ///< Initial time step of every group
+            double timestep_min{};      ///< Minimum time step
+            double timestep_max{};      ///< Maximum time step
+            double spatial_precision{}; ///< Target spatial precision of a step
+            double integration_time{};  ///< Time after which the propagation of a group is stopped
+            std::array<double, 3> sensor_center{}; ///< Center of the sensor
+            std::array<double, 3> sensor_size{};   ///< Size of the sensor
+            std::array<double, 2> pixel_center{};  ///< Center of the pixel the tables are computed for
+            std::array<double, 2> pixel_pitch{};   ///< Pitch of the pixels, i.e. the size of the tabulated unit cell
+            std::array<size_t, 3> bins{};          ///< Number of bins of the tables along the three axes
+        };
+
+        /**
+         * @brief Charge carrier group propagated on the device
+         */
+        struct Group {
+            std::array<double, 3> position{};      ///< Start position, replaced by the final position
+            std::array<double, 3> last_position{}; ///< Position before the last step
+            double start_time{};                   ///< Local time of the deposit the group starts from
+            double time{};                         ///< Time the group has been propagated
+            unsigned int steps{};                  ///< Number of steps performed
+            unsigned int carrier{};                ///< Index of the table of the carrier type, 0 for electrons, 1 for holes
+            bool halted{};                         ///< True if the group has left the sensor
+        };
+
+        /**
+         * @brief Transfer the tables of drift velocities and diffusion constants to the device
+         * @param parameters Parameters of the propagation
+         * @param tables Drift velocity and diffusion constant at the center of every bin for electrons followed by holes,
+         *               stored with the z index running fastest
+         */
+        DevicePropagation(const Parameters& parameters, std::vector<float> tables);
+
+        /**
+         * @brief Release the tables on the device
+         */
+        ~DevicePropagation();
+
+        /// @{
+        /**
+         * @brief The tables are bound to the device storage and cannot be copied or moved
+         */
+        DevicePropagation(const DevicePropagation&) = delete;
+        DevicePropagation& operator=(const DevicePropagation&) = delete;
+        DevicePropagation(DevicePropagation&&) = delete;
+        DevicePropagation& operator=(DevicePropagation&&) = delete;
+        /// @}
+
+        /**
+         * @brief Propagate charge carrier groups until they leave the sensor or reach the integration time
+         * @param groups Groups to propagate, updated in place
+         * @param seed Seed of the random number streams of the groups
+         */
+        void propagate(std::vector<Group>& groups, uint64_t seed) const;
+
+        /**
+         * @brief Describe the device the propagation is executed on
+         * @return Human-readable description
+         */
+        static std::string getDeviceDescription();
+
+        /**
+         * @brief Number of values stored per bin of the tables
+         */
+        static constexpr size_t values_per_bin = 4;
+
+    private:
+        Parameters parameters_;
+        std::vector<float> tables_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_GENERIC_PROPAGATION_DEVICE_PROPAGATION_H */
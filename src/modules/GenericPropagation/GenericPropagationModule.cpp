@@ -12,12 +12,22 @@
 
 #include "GenericPropagationModule.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iterator>
 #include <limits>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <utility>
 
 #include <Eigen/Core>
@@ -26,7 +36,10 @@
 #include <Math/Vector3D.h>
 
 #include "core/config/Configuration.hpp"
+#include "core/geometry/HexagonalPixelDetectorModel.hpp"
+#include "core/geometry/PixelDetectorModel.hpp"
 #include "core/messenger/Messenger.hpp"
+#include "core/module/ThreadPool.hpp"
 #include "core/utils/distributions.h"
 #include "core/utils/log.h"
 #include "core/utils/unit.h"
@@ -38,6 +51,122 @@
 
 using namespace allpix;
 
+namespace {
+    // Number of charge carrier groups per task for intra-event parallel propagation
+    constexpr unsigned int propagation_task_size = 64;
+
+    // Call a function with a flag known at runtime only, passed on as compile-time constant
+    template <typename F> void with_flag(bool flag, F&& function) {
+        if(flag) {
+            function(std::true_type{});
+        } else {
+            function(std::false_type{});
+        }
+    }
+
+    // Number of cells along each axis of the sensor used to order the deposits by their Morton code
+    constexpr double morton_cells = 1024;
+
+    // Spread the lowest 21 bits of a value to every third bit
+    uint64_t spread_bits(uint64_t value) {
+        value &= 0x1fffff;
+        value = (value | value << 32) & 0x1f00000000ffff;
+        value = (value | value << 16) & 0x1f0000ff0000ff;
+        value = (value | value << 8) & 0x100f00f00f00f00f;
+        value = (value | value << 4) & 0x10c30c30c30c30c3;
+        value = (value | value << 2) & 0x1249249249249249;
+        return value;
+    }
+
+    // Morton code of the cell of the sensor a position is located in, interleaving the cell indices along the three axes
+    uint64_t morton_code(const ROOT::Math::XYZPoint& position,
+                         const ROOT::Math::XYZPoint& origin,
+                         const ROOT::Math::XYZVector& size) {
+        auto cell = [](double offset, double length) {
+            return static_cast<uint64_t>(std::clamp(offset / length * morton_cells, 0., morton_cells - 1));
+        };
+        return spread_bits(cell(position.x() - origin.x(), size.x())) |
+               spread_bits(cell(position.y() - origin.y(), size.y())) << 1 |
+               spread_bits(cell(position.z() - origin.z(), size.z())) << 2;
+    }
+
+    // Check if a field repeats with the pixel pitch
+    bool repeats_with_pitch(FieldType type, FieldMapping mapping) {
+        return type == FieldType::NONE || type == FieldType::CONSTANT || type == FieldType::LINEAR ||
+               type == FieldType::CUSTOM1D || (type == FieldType::GRID && mapping != FieldMapping::SENSOR);
+    }
+
+    // Squared Euclidean distance transform of a line of samples with the given spacing, following the lower envelope of
+    // parabolas described by P. Felzenszwalb and D. Huttenlocher, Theory of Computing 8 (2012) 415
+    void distance_transform(std::vector<double>& values, double spacing) {
+        auto n = values.size();
+        std::vector<size_t> vertices(n);
+        std::vector<double> boundaries(n + 1);
+        auto intersection = [&](size_t q, size_t p) {
+            auto xq = static_cast<double>(q) * spacing;
+            auto xp = static_cast<double>(p) * spacing;
+            return ((values[q] + xq * xq) - (values[p] + xp * xp)) / (2. * (xq - xp));
+        };
+
+        size_t k = 0;
+        boundaries[0] = -std::numeric_limits<double>::infinity();
+        boundaries[1] = std::numeric_limits<double>::infinity();
+        for(size_t q = 1; q < n; ++q) {
+            auto boundary = intersection(q, vertices[k]);
+            while(boundary <= boundaries[k]) {
+                --k;
+                boundary = intersection(q, vertices[k]);
+            }
+            ++k;
+            vertices[k] = q;
+            boundaries[k] = boundary;
+            boundaries[k + 1] = std::numeric_limits<double>::infinity();
+        }
+
+        std::vector<double> result(n);
+        k = 0;
+        for(size_t q = 0; q < n; ++q) {
+            auto x = static_cast<double>(q) * spacing;
+            while(boundaries[k + 1] < x) {
+                ++k;
+            }
+            auto offset = x - static_cast<double>(vertices[k]) * spacing;
+            result[q] = offset * offset + values[vertices[k]];
+        }
+        values = std::move(result);
+    }
+
+    // Time D t / R^2 for a Brownian motion in three dimensions with diffusion constant D to leave a sphere of radius R
+    // around its starting point, sampled by inversion of the distribution function with survival probability
+    // S(tau) = 2 sum_n (-1)^(n+1) exp(-n^2 pi^2 tau), tabulated up to tau = 0.4 and given by the leading term beyond
+    double first_passage_time(double probability) {
+        constexpr size_t bins = 4096;
+        constexpr double tau_max = 0.4;
+        static const auto distribution = []() {
+            std::vector<double> values(bins + 1, 0.);
+            for(size_t i = 1; i <= bins; ++i) {
+                auto tau = tau_max * static_cast<double>(i) / static_cast<double>(bins);
+                double survival = 0;
+                for(int n = 1; n <= 200; ++n) {
+                    survival += (n % 2 == 1 ? 2. : -2.) * std::exp(-n * n * M_PI * M_PI * tau);
+                }
+                values[i] = std::clamp(1. - survival, values[i - 1], 1.);
+            }
+            return values;
+        }();
+
+        if(probability >= distribution.back()) {
+            return std::log(2. / (1. - probability)) / (M_PI * M_PI);
+        }
+        auto index = static_cast<size_t>(
+            std::distance(distribution.begin(), std::upper_bound(distribution.begin(), distribution.end(), probability)));
+        auto lower = distribution[index - 1];
+        auto upper = distribution[index];
+        auto fraction = (upper > lower ? (probability - lower) / (upper - lower) : 0.);
+        return tau_max * (static_cast<double>(index - 1) + fraction) / static_cast<double>(bins);
+    }
+} // namespace
+
 /**
  * Besides binding the message and setting defaults for the configuration, the module copies some configuration variables to
  * local copies to speed up computation.
@@ -57,6 +186,9 @@ GenericPropagationModule::GenericPropagationModule(Configuration& config,
     config_.setDefault<double>("timestep_start", Units::get(0.01, "ns"));
     config_.setDefault<double>("timestep_min", Units::get(0.001, "ns"));
     config_.setDefault<double>("timestep_max", Units::get(0.5, "ns"));
+    config_.setDefault<TimestepController>("timestep_controller", TimestepController::FIXED_FACTOR);
+    config_.setDefault<PropagationPrecision>("propagation_precision", PropagationPrecision::DOUBLE);
+    config_.setDefault<bool>("validate_precision", false);
     config_.setDefault<double>("integration_time", Units::get(25, "ns"));
     config_.setDefault<unsigned int>("charge_per_step", 10);
     config_.setDefault<unsigned int>("max_charge_groups", 1000);
@@ -67,12 +199,17 @@ GenericPropagationModule::GenericPropagationModule(Configuration& config,
     config_.setDefault<std::string>("recombination_model", "none");
     config_.setDefault<std::string>("trapping_model", "none");
     config_.setDefault<std::string>("detrapping_model", "none");
+    config_.setDefault<bool>("sample_carrier_lifetimes", false);
+    config_.setDefault<bool>("precompute_velocity", false);
+    config_.setDefault<bool>("batch_sampling", false);
+    config_.setDefault<bool>("prefetch_fields", false);
 
     config_.setDefault<bool>("output_linegraphs", false);
     config_.setDefault<bool>("output_linegraphs_collected", false);
     config_.setDefault<bool>("output_linegraphs_recombined", false);
     config_.setDefault<bool>("output_linegraphs_trapped", false);
     config_.setDefault<bool>("output_animations", false);
+    config_.setDefault<bool>("output_trajectories", false);
     config_.setDefault<bool>("output_plots",
                              config_.get<bool>("output_linegraphs") || config_.get<bool>("output_animations"));
     config_.setDefault<bool>("output_animations_color_markers", false);
@@ -99,6 +236,35 @@ GenericPropagationModule::GenericPropagationModule(Configuration& config,
     config_.setDefault<double>("multiplication_threshold", 1e-2);
     config_.setDefault<unsigned int>("max_multiplication_level", 5);
 
+    // Precomputed map of the impact ionization region and table of the gain factors, disabled by default
+    config_.setDefault<bool>("precompute_multiplication", false);
+    config_.setDefaultArray<unsigned int>("multiplication_map_bins", {100, 100, 100});
+    config_.setDefault<unsigned int>("multiplication_table_bins", 1000);
+
+    // Number of charge groups to propagate in lock-step, disabled by default
+    config_.setDefault<unsigned int>("propagation_batch_size", 0);
+
+    // Number of threads to distribute the charge carrier groups of a single event to, disabled by default
+    config_.setDefault<unsigned int>("propagation_threads", 0);
+    config_.setDefault<unsigned int>("propagation_charge_per_thread", 0);
+
+    // Merging of converged charge groups within a batch, disabled by default
+    config_.setDefault<unsigned int>("merge_interval", 0);
+    config_.setDefault<double>("merge_distance", Units::get(1, "um"));
+    config_.setDefault<double>("merge_time", Units::get(0.1, "ns"));
+
+    // Propagation on an offload device using tabulated carrier velocities, disabled by default
+    config_.setDefault<bool>("offload_propagation", false);
+    config_.setDefaultArray<unsigned int>("offload_table_bins", {100, 100, 100});
+
+    // Ordering of the deposits by their position, disabled by default
+    config_.setDefault<bool>("sort_deposits", false);
+
+    // First-passage sampling of the diffusion in field-free regions, disabled by default
+    config_.setDefault<bool>("field_free_sampling", false);
+    config_.setDefault<double>("field_free_threshold", Units::get(10, "V/cm"));
+    config_.setDefaultArray<unsigned int>("field_free_map_bins", {100, 100, 100});
+
     // Copy some variables from configuration to avoid lookups:
     temperature_ = config_.get<double>("temperature");
     timestep_min_ = config_.get<double>("timestep_min");
@@ -106,18 +272,39 @@ GenericPropagationModule::GenericPropagationModule(Configuration& config,
     timestep_start_ = config_.get<double>("timestep_start");
     integration_time_ = config_.get<double>("integration_time");
     target_spatial_precision_ = config_.get<double>("spatial_precision");
+    timestep_controller_ = config_.get<TimestepController>("timestep_controller");
+    propagation_precision_ = config_.get<PropagationPrecision>("propagation_precision");
+    validate_precision_ = config_.get<bool>("validate_precision");
     output_plots_ = config_.get<bool>("output_plots");
     output_linegraphs_ = config_.get<bool>("output_linegraphs");
     output_linegraphs_collected_ = config_.get<bool>("output_linegraphs_collected");
     output_linegraphs_recombined_ = config_.get<bool>("output_linegraphs_recombined");
     output_linegraphs_trapped_ = config_.get<bool>("output_linegraphs_trapped");
     output_animations_ = config_.get<bool>("output_animations");
+    output_trajectories_ = config_.get<bool>("output_trajectories");
+    record_trajectories_ = output_linegraphs_ || output_trajectories_;
     output_plots_step_ = config_.get<double>("output_plots_step");
+    plot_settings_ = LineGraph::PlotSettings(config_);
     propagate_electrons_ = config_.get<bool>("propagate_electrons");
     propagate_holes_ = config_.get<bool>("propagate_holes");
+    sample_carrier_lifetimes_ = config_.get<bool>("sample_carrier_lifetimes");
+    precompute_velocity_ = config_.get<bool>("precompute_velocity");
+    precompute_multiplication_ = config_.get<bool>("precompute_multiplication");
+    batch_sampling_ = config_.get<bool>("batch_sampling");
+    prefetch_fields_ = config_.get<bool>("prefetch_fields");
     charge_per_step_ = config_.get<unsigned int>("charge_per_step");
     max_charge_groups_ = config_.get<unsigned int>("max_charge_groups");
     max_multiplication_level_ = config.get<unsigned int>("max_multiplication_level");
+    batch_size_ = config_.get<unsigned int>("propagation_batch_size");
+    propagation_threads_ = config_.get<unsigned int>("propagation_threads");
+    propagation_charge_per_thread_ = config_.get<unsigned int>("propagation_charge_per_thread");
+    merge_interval_ = config_.get<unsigned int>("merge_interval");
+    merge_distance_ = config_.get<double>("merge_distance");
+    merge_time_ = config_.get<double>("merge_time");
+    offload_propagation_ = config_.get<bool>("offload_propagation");
+    sort_deposits_ = config_.get<bool>("sort_deposits");
+    field_free_sampling_ = config_.get<bool>("field_free_sampling");
+    field_free_threshold_ = config_.get<double>("field_free_threshold");
 
     // Enable multithreading of this module if multithreading is enabled and no per-event output plots are requested:
     // FIXME: Review if this is really the case or we can still use multithreading
@@ -137,6 +324,17 @@ GenericPropagationModule::GenericPropagationModule(Configuration& config,
 
 void GenericPropagationModule::initialize() {
 
+    // Register the counters and timers of the performance report
+    groups_counter_ = getProfiler().registerCounter("charge_groups");
+    steps_counter_ = getProfiler().registerCounter("steps");
+    recombined_counter_ = getProfiler().registerCounter("recombined_charges");
+    trapped_counter_ = getProfiler().registerCounter("trapped_charges");
+    propagation_timer_ = getProfiler().registerTimer("propagation");
+
+    if(output_trajectories_) {
+        trajectory_writer_ = std::make_unique<LineGraph::TrajectoryWriter>(this);
+    }
+
     // Check for electric field and output warning for slow propagation if not defined
     if(!detector_->hasElectricField()) {
         LOG(WARNING) << "This detector does not have an electric field.";
@@ -328,6 +526,567 @@ void GenericPropagationModule::initialize() {
 
     // Prepare trapping model
     detrapping_ = Detrapping(config_);
+
+    // Precompute drift velocity and diffusion constant of both carrier types on the grid of the electric field if requested
+    if(precompute_velocity_) {
+        if(detector_->getElectricFieldType() != FieldType::GRID) {
+            LOG(WARNING) << "Carrier velocities can only be precomputed for electric field maps, disabling precomputation";
+            precompute_velocity_ = false;
+        } else if(has_magnetic_field_) {
+            LOG(WARNING) << "Carrier velocities cannot be precomputed in a magnetic field, disabling precomputation";
+            precompute_velocity_ = false;
+        } else {
+            // Field map cells are evaluated at the position they represent in the pixel at the matrix center
+            auto [reference_x, reference_y] = model_->getPixelIndex(model_->getMatrixCenter());
+            auto reference = static_cast<ROOT::Math::XYPoint>(model_->getPixelCenter(reference_x, reference_y));
+
+            for(auto type : {CarrierType::ELECTRON, CarrierType::HOLE}) {
+                auto& grids = (type == CarrierType::ELECTRON ? electron_grids_ : hole_grids_);
+                grids.velocity = detector_->deriveFromElectricField<ROOT::Math::XYZVector, 3>(
+                    [&](const ROOT::Math::XYZVector& efield, const ROOT::Math::XYZPoint& position) {
+                        auto doping = detector_->getDopingConcentration(position);
+                        return static_cast<int>(type) * mobility_(type, std::sqrt(efield.Mag2()), doping) * efield;
+                    },
+                    reference);
+                grids.diffusion = detector_->deriveFromElectricField<double, 1>(
+                    [&](const ROOT::Math::XYZVector& efield, const ROOT::Math::XYZPoint& position) {
+                        return boltzmann_kT_ *
+                               mobility_(type, std::sqrt(efield.Mag2()), detector_->getDopingConcentration(position));
+                    },
+                    reference);
+            }
+            LOG(INFO) << "Precomputed carrier velocities and diffusion constants on the grid of the electric field";
+        }
+    }
+
+    if(timestep_controller_ == TimestepController::PI) {
+        LOG(INFO) << "Adapting the integration time step with a proportional-integral controller";
+    }
+
+    if(sample_carrier_lifetimes_) {
+        LOG(INFO) << "Sampling the lifetimes of charge carriers once per set of charge carriers";
+    }
+
+    if(sort_deposits_) {
+        LOG(INFO) << "Propagating deposits in the order of the Morton code of their position";
+    }
+
+    // Single precision is only implemented for the propagation of individual groups, which the validation runs alongside
+    if(propagation_precision_ == PropagationPrecision::SINGLE) {
+        if(batch_size_ > 1) {
+            throw InvalidCombinationError(config_,
+                                          {"propagation_precision", "propagation_batch_size"},
+                                          "Batched propagation cannot be used together with single precision");
+        }
+        LOG(INFO) << "Propagating charge carrier groups in single precision";
+    }
+    if(validate_precision_) {
+        if(propagation_precision_ != PropagationPrecision::SINGLE) {
+            throw InvalidCombinationError(config_,
+                                          {"validate_precision", "propagation_precision"},
+                                          "Validation of the precision requires the propagation in single precision");
+        }
+        if(propagation_threads_ > 0) {
+            throw InvalidCombinationError(config_,
+                                          {"validate_precision", "propagation_threads"},
+                                          "Intra-event parallel propagation cannot be used together with validation");
+        }
+
+        precision_deviation_histo_ =
+            CreateHistogram<TH1D>("precision_deviation_histo",
+                                  "Deviation of the final position from double precision;deviation [nm];charge carriers",
+                                  200,
+                                  0,
+                                  1000);
+        collection_time_double_histo_ =
+            CreateHistogram<TH1D>("collection_time_double_histo",
+                                  "Arrival time of collected charge carriers, double precision;time [ns];charge carriers",
+                                  static_cast<int>(Units::convert(integration_time_, "ns") * 5),
+                                  0,
+                                  static_cast<double>(Units::convert(integration_time_, "ns")));
+        collection_time_single_histo_ =
+            CreateHistogram<TH1D>("collection_time_single_histo",
+                                  "Arrival time of collected charge carriers, single precision;time [ns];charge carriers",
+                                  static_cast<int>(Units::convert(integration_time_, "ns") * 5),
+                                  0,
+                                  static_cast<double>(Units::convert(integration_time_, "ns")));
+        LOG(INFO) << "Validating the propagation in single precision against double precision";
+    }
+
+    // Batched propagation does not support features which require per-group bookkeeping along the path
+    if(batch_size_ > 1) {
+        if(!multiplication_.is<NoImpactIonization>()) {
+            throw InvalidCombinationError(config_,
+                                          {"propagation_batch_size", "multiplication_model"},
+                                          "Batched propagation cannot be used together with impact ionization");
+        }
+        if(output_linegraphs_) {
+            throw InvalidCombinationError(config_,
+                                          {"propagation_batch_size", "output_linegraphs"},
+                                          "Batched propagation cannot be used together with line graph output");
+        }
+        if(output_trajectories_) {
+            throw InvalidCombinationError(config_,
+                                          {"propagation_batch_size", "output_trajectories"},
+                                          "Batched propagation cannot be used together with trajectory output");
+        }
+        LOG(INFO) << "Propagating charge carrier groups in batches of " << batch_size_;
+    }
+
+    // Groups can only be merged while they are propagated in lock-step
+    if(merge_interval_ > 0) {
+        if(batch_size_ <= 1) {
+            throw InvalidCombinationError(config_,
+                                          {"merge_interval", "propagation_batch_size"},
+                                          "Merging of charge carrier groups requires batched propagation");
+        }
+        LOG(INFO) << "Merging charge carrier groups closer than " << Units::display(merge_distance_, {"nm", "um"})
+                  << " and " << Units::display(merge_time_, {"ps", "ns"}) << " every " << merge_interval_ << " steps";
+    }
+
+    // Histograms are only filled per registered worker thread and line graphs per event, both can't be intra-event parallel
+    if(propagation_threads_ > 0) {
+        if(output_plots_) {
+            throw InvalidCombinationError(config_,
+                                          {"propagation_threads", "output_plots"},
+                                          "Intra-event parallel propagation cannot be used together with output plots");
+        }
+        if(output_linegraphs_) {
+            throw InvalidCombinationError(config_,
+                                          {"propagation_threads", "output_linegraphs"},
+                                          "Intra-event parallel propagation cannot be used together with line graph output");
+        }
+        if(output_trajectories_) {
+            throw InvalidCombinationError(config_,
+                                          {"propagation_threads", "output_trajectories"},
+                                          "Intra-event parallel propagation cannot be used together with trajectory output");
+        }
+        if(propagation_charge_per_thread_ > 0) {
+            LOG(INFO) << "Distributing charge carrier groups of each event to up to " << propagation_threads_
+                      << " threads, one per " << propagation_charge_per_thread_
+                      << " charge carriers as long as workers are idle";
+        } else {
+            LOG(INFO) << "Distributing charge carrier groups of each event to " << propagation_threads_ << " threads";
+        }
+    } else if(propagation_charge_per_thread_ > 0) {
+        throw InvalidCombinationError(config_,
+                                      {"propagation_charge_per_thread", "propagation_threads"},
+                                      "Distributing charge carrier groups by cost requires intra-event parallelism");
+    }
+
+    if(field_free_sampling_) {
+        if(batch_size_ > 1) {
+            throw InvalidCombinationError(config_,
+                                          {"field_free_sampling", "propagation_batch_size"},
+                                          "Batched propagation cannot be used together with first-passage sampling");
+        }
+        initialize_field_free_map();
+    }
+
+    if(precompute_multiplication_) {
+        if(multiplication_.is<NoImpactIonization>()) {
+            LOG(WARNING) << "No impact ionization model selected, not precomputing the impact ionization region";
+            precompute_multiplication_ = false;
+        } else {
+            initialize_multiplication_map();
+        }
+    }
+
+    if(offload_propagation_) {
+        initialize_offload();
+    }
+}
+
+void GenericPropagationModule::setup_sensor_map(SensorMap& map, const std::string& key) const {
+    auto map_bins = config_.getArray<unsigned int>(key);
+    if(map_bins.size() != 3 || std::find(map_bins.begin(), map_bins.end(), 0) != map_bins.end()) {
+        throw InvalidValueError(config_, key, "three non-zero numbers of bins along x, y and z are required");
+    }
+
+    std::copy(map_bins.begin(), map_bins.end(), map.bins.begin());
+    auto sensor_center = model_->getSensorCenter();
+    auto sensor_size = model_->getSensorSize();
+    map.periodic = repeats_with_pitch(detector_->getElectricFieldType(), detector_->getElectricFieldMapping()) &&
+                   std::dynamic_pointer_cast<PixelDetectorModel>(model_) != nullptr &&
+                   std::dynamic_pointer_cast<HexagonalPixelDetectorModel>(model_) == nullptr;
+    if(map.periodic) {
+        auto [reference_x, reference_y] = model_->getPixelIndex(model_->getMatrixCenter());
+        auto reference = model_->getPixelCenter(reference_x, reference_y);
+        auto pitch = model_->getPixelSize();
+        map.origin = ROOT::Math::XYZPoint(
+            reference.x() - pitch.x() / 2, reference.y() - pitch.y() / 2, sensor_center.z() - sensor_size.z() / 2);
+        map.size = ROOT::Math::XYZVector(pitch.x(), pitch.y(), sensor_size.z());
+    } else {
+        map.origin = sensor_center - sensor_size / 2;
+        map.size = sensor_size;
+    }
+}
+
+size_t GenericPropagationModule::SensorMap::index(const ROOT::Math::XYZPoint& position) const {
+    auto cell_index = [](double offset, double length, size_t bins, bool wrap) {
+        if(wrap) {
+            offset -= length * std::floor(offset / length);
+        }
+        return std::min(static_cast<size_t>(std::max(offset / length, 0.) * static_cast<double>(bins)), bins - 1);
+    };
+    auto x = cell_index(position.x() - origin.x(), size.x(), bins[0], periodic);
+    auto y = cell_index(position.y() - origin.y(), size.y(), bins[1], periodic);
+    auto z = cell_index(position.z() - origin.z(), size.z(), bins[2], false);
+    return (x * bins[1] + y) * bins[2] + z;
+}
+
+/**
+ * Cells of the map with an electric field above the threshold or located within an implant are occupied. The distance from
+ * every cell center to the closest occupied cell center is obtained from a separable Euclidean distance transform. If the
+ * electric field repeats with the pixel pitch, only the unit cell of the pixel at the matrix center is tabulated and the
+ * distances are computed with periodic boundaries along x and y.
+ */
+void GenericPropagationModule::initialize_field_free_map() {
+    auto& map = field_free_map_;
+    setup_sensor_map(map, "field_free_map_bins");
+    std::array<double, 3> spacing = {map.size.x() / static_cast<double>(map.bins[0]),
+                                     map.size.y() / static_cast<double>(map.bins[1]),
+                                     map.size.z() / static_cast<double>(map.bins[2])};
+
+    // Squared distance to the closest occupied cell, far away from all cells if none is occupied
+    auto far = 1e6 * map.size.Mag2();
+    std::vector<double> squared_distance;
+    squared_distance.reserve(map.bins[0] * map.bins[1] * map.bins[2]);
+    size_t occupied = 0;
+    for(size_t x = 0; x < map.bins[0]; ++x) {
+        for(size_t y = 0; y < map.bins[1]; ++y) {
+            for(size_t z = 0; z < map.bins[2]; ++z) {
+                ROOT::Math::XYZPoint position(map.origin.x() + (static_cast<double>(x) + 0.5) * spacing[0],
+                                              map.origin.y() + (static_cast<double>(y) + 0.5) * spacing[1],
+                                              map.origin.z() + (static_cast<double>(z) + 0.5) * spacing[2]);
+                auto efield = detector_->getElectricField(position);
+                auto blocked = efield.Mag2() > field_free_threshold_ * field_free_threshold_ ||
+                               model_->findImplant(position).has_value();
+                squared_distance.push_back(blocked ? 0. : far);
+                occupied += (blocked ? 1 : 0);
+            }
+        }
+    }
+
+    // Transform along every axis in turn, lines along x and y of periodic maps are repeated on both sides
+    std::array<size_t, 3> strides = {map.bins[1] * map.bins[2], map.bins[2], 1};
+    for(size_t axis = 0; axis < 3; ++axis) {
+        auto periodic = map.periodic && axis < 2;
+        auto length = map.bins[axis];
+        std::vector<double> line;
+        for(size_t start = 0; start < squared_distance.size(); ++start) {
+            if((start / strides[axis]) % length != 0) {
+                continue;
+            }
+            line.clear();
+            for(size_t copy = 0; copy < (periodic ? 3 : 1); ++copy) {
+                for(size_t i = 0; i < length; ++i) {
+                    line.push_back(squared_distance[start + i * strides[axis]]);
+                }
+            }
+            distance_transform(line, spacing[axis]);
+            for(size_t i = 0; i < length; ++i) {
+                squared_distance[start + i * strides[axis]] = line[(periodic ? length : 0) + i];
+            }
+        }
+    }
+
+    map.distance.clear();
+    map.distance.reserve(squared_distance.size());
+    for(auto value : squared_distance) {
+        map.distance.push_back(static_cast<float>(std::sqrt(value)));
+    }
+
+    LOG(INFO) << "Sampling the diffusion in field-free regions by first passage, " << occupied << " of "
+              << squared_distance.size() << " cells of the " << (map.periodic ? "pixel" : "sensor")
+              << " with electric field above " << Units::display(field_free_threshold_, {"V/cm", "kV/cm"});
+}
+
+/**
+ * The electric field is sampled at the center and the corners of every cell of the map, and cells with a field magnitude
+ * above the threshold of the impact ionization model at any of these points are marked. Since the field in between is not
+ * known, the marked region is extended by one cell in every direction. The gain factors of both carrier types are tabulated
+ * from the threshold to the largest sampled field magnitude, stronger fields are evaluated by the model directly.
+ */
+void GenericPropagationModule::initialize_multiplication_map() {
+    auto& map = multiplication_map_;
+    setup_sensor_map(map, "multiplication_map_bins");
+    std::array<double, 3> spacing = {map.size.x() / static_cast<double>(map.bins[0]),
+                                     map.size.y() / static_cast<double>(map.bins[1]),
+                                     map.size.z() / static_cast<double>(map.bins[2])};
+
+    // Offsets of the eight corners of a cell in units of the cell size, followed by the cell center
+    auto corner_offset = [](size_t corner, size_t axis) {
+        return (corner == 8 ? 0.5 : static_cast<double>((corner >> axis) & 1U));
+    };
+
+    auto threshold = multiplication_.getThreshold();
+    auto field_max = 0.;
+    std::vector<uint8_t> above;
+    above.reserve(map.bins[0] * map.bins[1] * map.bins[2]);
+    for(size_t x = 0; x < map.bins[0]; ++x) {
+        for(size_t y = 0; y < map.bins[1]; ++y) {
+            for(size_t z = 0; z < map.bins[2]; ++z) {
+                auto cell_field = 0.;
+                for(size_t corner = 0; corner < 9; ++corner) {
+                    ROOT::Math::XYZPoint position(
+                        map.origin.x() + (static_cast<double>(x) + corner_offset(corner, 0)) * spacing[0],
+                        map.origin.y() + (static_cast<double>(y) + corner_offset(corner, 1)) * spacing[1],
+                        map.origin.z() + (static_cast<double>(z) + corner_offset(corner, 2)) * spacing[2]);
+                    cell_field = std::max(cell_field, std::sqrt(detector_->getElectricField(position).Mag2()));
+                }
+                field_max = std::max(field_max, cell_field);
+                above.push_back(cell_field >= threshold ? 1 : 0);
+            }
+        }
+    }
+
+    // Extend the marked region by one cell, wrapping around along x and y for periodic maps
+    map.active.assign(above.size(), 0);
+    size_t active = 0;
+    auto neighbour = [&](size_t index, int shift, size_t axis) -> std::optional<size_t> {
+        auto shifted = static_cast<long>(index) + shift;
+        if(shifted < 0 || shifted >= static_cast<long>(map.bins[axis])) {
+            if(!map.periodic || axis == 2) {
+                return std::nullopt;
+            }
+            shifted = (shifted + static_cast<long>(map.bins[axis])) % static_cast<long>(map.bins[axis]);
+        }
+        return static_cast<size_t>(shifted);
+    };
+    for(size_t x = 0; x < map.bins[0]; ++x) {
+        for(size_t y = 0; y < map.bins[1]; ++y) {
+            for(size_t z = 0; z < map.bins[2]; ++z) {
+                uint8_t marked = 0;
+                for(int dx = -1; dx <= 1 && marked == 0; ++dx) {
+                    for(int dy = -1; dy <= 1 && marked == 0; ++dy) {
+                        for(int dz = -1; dz <= 1 && marked == 0; ++dz) {
+                            auto nx = neighbour(x, dx, 0);
+                            auto ny = neighbour(y, dy, 1);
+                            auto nz = neighbour(z, dz, 2);
+                            if(nx.has_value() && ny.has_value() && nz.has_value()) {
+                                marked = above[(nx.value() * map.bins[1] + ny.value()) * map.bins[2] + nz.value()];
+                            }
+                        }
+                    }
+                }
+                map.active[(x * map.bins[1] + y) * map.bins[2] + z] = marked;
+                active += marked;
+            }
+        }
+    }
+
+    // Tabulate the gain factors over the field magnitudes found in the marked region
+    auto table_bins = config_.get<unsigned int>("multiplication_table_bins");
+    if(table_bins < 2) {
+        throw InvalidValueError(config_, "multiplication_table_bins", "at least two bins are required");
+    }
+    map.field_min = threshold;
+    map.field_max = std::max(field_max, threshold);
+    map.field_step = (map.field_max - map.field_min) / static_cast<double>(table_bins - 1);
+    for(auto type : {CarrierType::ELECTRON, CarrierType::HOLE}) {
+        auto& table = map.gain_factor[type == CarrierType::ELECTRON ? 0 : 1];
+        table.clear();
+        for(unsigned int bin = 0; bin < table_bins; ++bin) {
+            table.push_back(multiplication_.getGainFactor(type, map.field_min + static_cast<double>(bin) * map.field_step));
+        }
+    }
+
+    LOG(INFO) << "Impact ionization possible in " << active << " of " << map.active.size() << " cells of the "
+              << (map.periodic ? "pixel" : "sensor") << ", tabulated gain factors up to "
+              << Units::display(map.field_max, {"V/cm", "kV/cm"});
+}
+
+double GenericPropagationModule::precomputed_gain(CarrierType type,
+                                                  double efield_mag,
+                                                  double step,
+                                                  const ROOT::Math::XYZPoint& start,
+                                                  const ROOT::Math::XYZPoint& end) const {
+    const auto& map = multiplication_map_;
+
+    // Outside of the marked region the field stays below the threshold of the model
+    if(map.active[map.index(start)] == 0 && map.active[map.index(end)] == 0) {
+        return 1.;
+    }
+    if(efield_mag < map.field_min) {
+        return 1.;
+    }
+    if(efield_mag >= map.field_max || map.field_step <= 0) {
+        return multiplication_(type, efield_mag, step);
+    }
+
+    // Interpolate the gain factor linearly between the tabulated field magnitudes
+    const auto& table = map.gain_factor[type == CarrierType::ELECTRON ? 0 : 1];
+    auto bin_position = (efield_mag - map.field_min) / map.field_step;
+    auto bin = std::min(static_cast<size_t>(bin_position), table.size() - 2);
+    auto fraction = bin_position - static_cast<double>(bin);
+    return std::exp(step * (table[bin] + fraction * (table[bin + 1] - table[bin])));
+}
+
+/**
+ * The exit point of a Brownian motion from a sphere around its starting point is distributed uniformly on the surface of the
+ * sphere, and the exit time follows a distribution which only depends on the radius and the diffusion constant. The radius
+ * of the sphere is given by the distance to the closest region with electric field, reduced by the diagonal of a cell of
+ * the map, and by the distance to the sensor surfaces. The diffusion constant is taken at the center of the sphere.
+ */
+std::optional<std::pair<ROOT::Math::XYZVector, double>>
+GenericPropagationModule::field_free_jump(RandomNumberGenerator& random_generator,
+                                          CarrierType type,
+                                          const ROOT::Math::XYZPoint& position,
+                                          double doping,
+                                          double timestep,
+                                          double remaining_time) const {
+    const auto& map = field_free_map_;
+
+    // Find the cell of the map, positions are wrapped into the unit cell of periodic maps
+    ROOT::Math::XYZVector cell(map.size.x() / static_cast<double>(map.bins[0]),
+                               map.size.y() / static_cast<double>(map.bins[1]),
+                               map.size.z() / static_cast<double>(map.bins[2]));
+    auto radius = static_cast<double>(map.distance[map.index(position)]) - std::sqrt(cell.Mag2());
+
+    auto sensor_center = model_->getSensorCenter();
+    auto sensor_size = model_->getSensorSize();
+    radius = std::min({radius,
+                       sensor_size.x() / 2 - std::fabs(position.x() - sensor_center.x()),
+                       sensor_size.y() / 2 - std::fabs(position.y() - sensor_center.y()),
+                       sensor_size.z() / 2 - std::fabs(position.z() - sensor_center.z())});
+
+    // Limit the radius such that the set leaves the sphere within the integration time with a probability of 99.9%, and
+    // only jump if the mean time to leave the sphere exceeds the next regular step
+    auto diffusion_constant = boltzmann_kT_ * mobility_(type, 0., doping);
+    radius = std::min(radius, std::sqrt(diffusion_constant * remaining_time / first_passage_time(0.999)));
+    if(radius <= 0 || radius * radius / (6. * diffusion_constant) < timestep) {
+        return std::nullopt;
+    }
+
+    allpix::uniform_real_distribution<double> uniform_distribution(0, 1);
+    auto duration = first_passage_time(uniform_distribution(random_generator)) * radius * radius / diffusion_constant;
+    if(duration >= remaining_time) {
+        return std::nullopt;
+    }
+
+    auto cos_theta = 2. * uniform_distribution(random_generator) - 1.;
+    auto sin_theta = std::sqrt(1. - cos_theta * cos_theta);
+    auto phi = 2. * M_PI * uniform_distribution(random_generator);
+    return std::make_pair(
+        ROOT::Math::XYZVector(radius * sin_theta * std::cos(phi), radius * sin_theta * std::sin(phi), radius * cos_theta),
+        duration);
+}
+
+/**
+ * The drift velocity and diffusion constant are tabulated over the unit cell of the pixel at the matrix center, which
+ * requires all fields to repeat with the pixel pitch. Configurations with features not implemented on the device fall
+ * back to the propagation on the host.
+ */
+void GenericPropagationModule::initialize_offload() {
+    // Collect all reasons preventing the propagation on the device
+    std::vector<std::string> reasons;
+    if(!repeats_with_pitch(detector_->getElectricFieldType(), detector_->getElectricFieldMapping())) {
+        reasons.emplace_back("electric field does not repeat with the pixel pitch");
+    }
+    if(!repeats_with_pitch(detector_->getDopingProfileType(), detector_->getDopingProfileMapping())) {
+        reasons.emplace_back("doping profile does not repeat with the pixel pitch");
+    }
+    if(std::dynamic_pointer_cast<PixelDetectorModel>(model_) == nullptr ||
+       std::dynamic_pointer_cast<HexagonalPixelDetectorModel>(model_) != nullptr) {
+        reasons.emplace_back("detector model has no rectangular pixel grid");
+    }
+    if(!model_->getImplants().empty()) {
+        reasons.emplace_back("detector model has implants");
+    }
+    if(has_magnetic_field_) {
+        reasons.emplace_back("magnetic field is present");
+    }
+    if(!multiplication_.is<NoImpactIonization>()) {
+        reasons.emplace_back("impact ionization is enabled");
+    }
+    if(config_.get<std::string>("recombination_model") != "none" || config_.get<std::string>("trapping_model") != "none") {
+        reasons.emplace_back("recombination or trapping is enabled");
+    }
+    if(timestep_controller_ != TimestepController::FIXED_FACTOR) {
+        reasons.emplace_back("time step controller is not supported");
+    }
+    if(output_plots_ || output_linegraphs_ || output_trajectories_) {
+        reasons.emplace_back("output plots, line graphs or trajectories are requested");
+    }
+    if(merge_interval_ > 0) {
+        reasons.emplace_back("merging of charge carrier groups is requested");
+    }
+    if(validate_precision_) {
+        reasons.emplace_back("validation of the single precision propagation is requested");
+    }
+    if(field_free_sampling_) {
+        reasons.emplace_back("first-passage sampling in field-free regions is requested");
+    }
+    if(!reasons.empty()) {
+        std::stringstream reason_list;
+        for(const auto& reason : reasons) {
+            reason_list << std::endl << "  " << reason;
+        }
+        LOG(WARNING) << "Propagation cannot be offloaded, propagating on the host:" << reason_list.str();
+        offload_propagation_ = false;
+        return;
+    }
+
+    auto table_bins = config_.getArray<unsigned int>("offload_table_bins");
+    if(table_bins.size() != 3 || std::find(table_bins.begin(), table_bins.end(), 0) != table_bins.end()) {
+        throw InvalidValueError(
+            config_, "offload_table_bins", "three non-zero numbers of bins along x, y and z are required");
+    }
+    std::array<size_t, 3> bins{};
+    std::copy(table_bins.begin(), table_bins.end(), bins.begin());
+
+    // Tabulate drift velocity and diffusion constant over the unit cell of the pixel at the matrix center
+    auto [reference_x, reference_y] = model_->getPixelIndex(model_->getMatrixCenter());
+    auto reference = model_->getPixelCenter(reference_x, reference_y);
+    auto sensor_center = model_->getSensorCenter();
+    auto sensor_size = model_->getSensorSize();
+    auto pitch = model_->getPixelSize();
+
+    DevicePropagation::Parameters parameters;
+    parameters.timestep_start = timestep_start_;
+    parameters.timestep_min = timestep_min_;
+    parameters.timestep_max = timestep_max_;
+    parameters.spatial_precision = target_spatial_precision_;
+    parameters.integration_time = integration_time_;
+    parameters.sensor_center = {sensor_center.x(), sensor_center.y(), sensor_center.z()};
+    parameters.sensor_size = {sensor_size.x(), sensor_size.y(), sensor_size.z()};
+    parameters.pixel_center = {reference.x(), reference.y()};
+    parameters.pixel_pitch = {pitch.x(), pitch.y()};
+    parameters.bins = bins;
+
+    std::vector<float> tables;
+    tables.reserve(2 * bins[0] * bins[1] * bins[2] * DevicePropagation::values_per_bin);
+    for(auto type : {CarrierType::ELECTRON, CarrierType::HOLE}) {
+        for(size_t x = 0; x < bins[0]; ++x) {
+            for(size_t y = 0; y < bins[1]; ++y) {
+                for(size_t z = 0; z < bins[2]; ++z) {
+                    ROOT::Math::XYZPoint position(
+                        reference.x() + pitch.x() * ((static_cast<double>(x) + 0.5) / static_cast<double>(bins[0]) - 0.5),
+                        reference.y() + pitch.y() * ((static_cast<double>(y) + 0.5) / static_cast<double>(bins[1]) - 0.5),
+                        sensor_center.z() +
+                            sensor_size.z() * ((static_cast<double>(z) + 0.5) / static_cast<double>(bins[2]) - 0.5));
+                    auto efield = detector_->getElectricField(position);
+                    auto mobility = mobility_(type, std::sqrt(efield.Mag2()), detector_->getDopingConcentration(position));
+                    auto velocity = static_cast<int>(type) * mobility * efield;
+                    tables.push_back(static_cast<float>(velocity.x()));
+                    tables.push_back(static_cast<float>(velocity.y()));
+                    tables.push_back(static_cast<float>(velocity.z()));
+                    tables.push_back(static_cast<float>(boltzmann_kT_ * mobility));
+                }
+            }
+        }
+    }
+
+    device_propagation_ = std::make_unique<DevicePropagation>(parameters, std::move(tables));
+    LOG(INFO) << "Propagating charge carrier groups on " << DevicePropagation::getDeviceDescription() << " with "
+              << bins[0] << "x" << bins[1] << "x" << bins[2] << " tabulated carrier velocities";
+
+    // All groups of an event are propagated in a single call on the device
+    if(batch_size_ > 1 || propagation_threads_ > 0) {
+        LOG(WARNING) << "Batched and intra-event parallel propagation are not used when offloading the propagation";
+        propagation_threads_ = 0;
+    }
 }
 
 void GenericPropagationModule::run(Event* event) {
@@ -336,21 +1095,44 @@ void GenericPropagationModule::run(Event* event) {
     // Create vector of propagated charges to output
     std::vector<PropagatedCharge> propagated_charges;
 
-    // List of points to plot to plot for output plots
-    LineGraph::OutputPlotPoints output_plot_points;
+    // Trajectories recorded for the output plots, the buffer is reused for all events of this thread
+    thread_local LineGraph::OutputPlotPoints output_plot_points;
+    output_plot_points.clear();
+
+    // Split all deposits into charge carrier groups. For intra-event parallel propagation the groups are distributed to
+    // tasks of fixed size, independent of the number of threads, each with a separate random number stream
+    std::vector<std::vector<std::tuple<const DepositedCharge*, CarrierType, unsigned int>>> tasks(1);
+    const auto task_size = std::max(batch_size_, propagation_task_size);
+    uint64_t event_charge = 0;
+
+    // Visit the deposits in the order of the Morton code of their position if requested, such that consecutive charge
+    // carrier groups start in neighboring cells of the sensor and access nearby regions of the field maps. Deposits of
+    // electron-hole pairs are expanded into their electrons followed by their holes
+    const auto carriers = expandCarriers(deposits_message->getData());
+    std::vector<std::pair<uint64_t, const std::pair<const DepositedCharge*, CarrierType>*>> ordered_deposits;
+    ordered_deposits.reserve(carriers.size());
+    if(sort_deposits_) {
+        auto sensor_size = model_->getSensorSize();
+        auto sensor_origin = model_->getSensorCenter() - sensor_size / 2;
+        for(const auto& carrier : carriers) {
+            ordered_deposits.emplace_back(morton_code(carrier.first->getLocalPosition(), sensor_origin, sensor_size),
+                                          &carrier);
+        }
+        std::stable_sort(ordered_deposits.begin(), ordered_deposits.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.first < rhs.first;
+        });
+    } else {
+        for(const auto& carrier : carriers) {
+            ordered_deposits.emplace_back(0, &carrier);
+        }
+    }
 
-    // Loop over all deposits for propagation
-    LOG(TRACE) << "Propagating charges in sensor";
-    unsigned int propagated_charges_count = 0;
-    unsigned int recombined_charges_count = 0;
-    unsigned int trapped_charges_count = 0;
-    unsigned int step_count = 0;
-    long double total_time = 0;
-    for(const auto& deposit : deposits_message->getData()) {
+    for(const auto& ordered_deposit : ordered_deposits) {
+        const auto& deposit = *ordered_deposit.second->first;
+        const auto type = ordered_deposit.second->second;
 
-        if((deposit.getType() == CarrierType::ELECTRON && !propagate_electrons_) ||
-           (deposit.getType() == CarrierType::HOLE && !propagate_holes_)) {
-            LOG(DEBUG) << "Skipping charge carriers (" << deposit.getType() << ") on "
+        if((type == CarrierType::ELECTRON && !propagate_electrons_) || (type == CarrierType::HOLE && !propagate_holes_)) {
+            LOG(DEBUG) << "Skipping charge carriers (" << type << ") on "
                        << Units::display(deposit.getLocalPosition(), {"mm", "um"});
             continue;
         }
@@ -364,11 +1146,12 @@ void GenericPropagationModule::run(Event* event) {
         }
 
         total_deposits_++;
+        event_charge += deposit.getCharge();
 
         // Loop over all charges in the deposit
         unsigned int charges_remaining = deposit.getCharge();
 
-        LOG(DEBUG) << "Set of charge carriers (" << deposit.getType() << ") on "
+        LOG(DEBUG) << "Set of charge carriers (" << type << ") on "
                    << Units::display(deposit.getLocalPosition(), {"mm", "um"});
 
         auto charge_per_step = charge_per_step_;
@@ -379,6 +1162,7 @@ void GenericPropagationModule::run(Event* event) {
                       << ", which exceeds the maximum number of charge groups allowed. Increasing charge_per_step to "
                       << charge_per_step << " for this deposit.";
         }
+
         while(charges_remaining > 0) {
             // Define number of charges to be propagated and remove charges of this step from the total
             if(charge_per_step > charges_remaining) {
@@ -386,43 +1170,156 @@ void GenericPropagationModule::run(Event* event) {
             }
             charges_remaining -= charge_per_step;
 
-            // Propagate a single charge deposit
-            auto [recombined, trapped, propagated, steps, time] = propagate(event,
-                                                                            deposit,
-                                                                            deposit.getLocalPosition(),
-                                                                            deposit.getType(),
-                                                                            charge_per_step,
-                                                                            deposit.getLocalTime(),
-                                                                            deposit.getGlobalTime(),
-                                                                            0,
-                                                                            propagated_charges,
-                                                                            output_plot_points);
-
-            // Update statistical information
-            recombined_charges_count += recombined;
-            trapped_charges_count += trapped;
-            propagated_charges_count += propagated;
-            step_count += steps;
-            total_time += time;
+            if(propagation_threads_ > 0 && tasks.back().size() == task_size) {
+                tasks.emplace_back();
+            }
+            tasks.back().emplace_back(&deposit, type, charge_per_step);
         }
     }
 
+    // Propagate all charge carrier groups
+    LOG(TRACE) << "Propagating charges in sensor";
+    std::vector<std::tuple<unsigned int, unsigned int, unsigned int, unsigned int, long double>> task_stats(tasks.size());
+    std::optional<Profiler::ScopedTimer> propagation_timer(std::in_place, getProfiler(), propagation_timer_);
+    if(device_propagation_ != nullptr) {
+        task_stats.front() = propagate_offload(event->getRandomNumber(), tasks.front(), propagated_charges);
+    } else if(propagation_threads_ == 0) {
+        task_stats.front() =
+            propagate_groups(event->getRandomEngine(), tasks.front(), propagated_charges, output_plot_points);
+    } else {
+        // Seed the random number streams of all tasks from the event, in order
+        std::vector<uint64_t> task_seeds(tasks.size());
+        for(auto& seed : task_seeds) {
+            seed = event->getRandomNumber();
+        }
+
+        std::vector<std::vector<PropagatedCharge>> task_charges(tasks.size());
+        std::vector<std::exception_ptr> task_exceptions(tasks.size());
+
+        // Shared with the jobs offered to the thread pool, which might only start after all tasks have been propagated
+        struct TaskState {
+            size_t count{};
+            std::atomic_size_t next_task{0};
+            size_t pending{};
+            std::mutex mutex;
+            std::condition_variable finished;
+        };
+        auto state = std::make_shared<TaskState>();
+        state->count = tasks.size();
+        state->pending = tasks.size();
+
+        auto process_tasks = [&,
+                              state,
+                              log_level = Log::getReportingLevel(),
+                              log_format = Log::getFormat(),
+                              log_section = Log::getSection(),
+                              event_num = event->number,
+                              random_engine = event->getRandomEngine().getEngine()]() {
+            // Log in the context of the event, restoring the settings of the executing thread afterwards
+            const auto thread_log =
+                std::make_tuple(Log::getReportingLevel(), Log::getFormat(), Log::getSection(), Log::getEventNum());
+            Log::setReportingLevel(log_level);
+            Log::setFormat(log_format);
+            Log::setSection(log_section);
+            Log::setEventNum(event_num);
+
+            // The references to the event data are only accessed while tasks are left
+            LineGraph::OutputPlotPoints task_plot_points;
+            for(auto idx = state->next_task++; idx < state->count; idx = state->next_task++) {
+                try {
+                    RandomNumberGenerator random_generator(random_engine);
+                    random_generator.seed(task_seeds[idx]);
+                    task_stats[idx] = propagate_groups(random_generator, tasks[idx], task_charges[idx], task_plot_points);
+                } catch(...) {
+                    task_exceptions[idx] = std::current_exception();
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock{state->mutex};
+                    --state->pending;
+                }
+                state->finished.notify_all();
+            }
+
+            Log::setReportingLevel(std::get<0>(thread_log));
+            Log::setFormat(std::get<1>(thread_log));
+            Log::setSection(std::get<2>(thread_log));
+            Log::setEventNum(std::get<3>(thread_log));
+        };
+
+        // Only expensive events are spread to further workers if requested, limited to the workers currently idle
+        size_t thread_count = propagation_threads_;
+        if(propagation_charge_per_thread_ > 0) {
+            thread_count = std::min<size_t>({thread_count,
+                                             1 + event_charge / propagation_charge_per_thread_,
+                                             1 + ThreadPool::idleThreadCount()});
+            LOG(INFO) << "Propagating " << event_charge << " charge carriers with " << thread_count << " threads";
+        }
+
+        // Offer the tasks to the workers of the framework, all tasks not picked up are propagated on the calling thread
+        auto* thread_pool = ThreadPool::current();
+        for(size_t i = 1; thread_pool != nullptr && i < std::min<size_t>(thread_count, tasks.size()); ++i) {
+            if(!thread_pool->trySubmit(process_tasks)) {
+                break;
+            }
+        }
+        process_tasks();
+
+        std::unique_lock<std::mutex> lock{state->mutex};
+        state->finished.wait(lock, [&]() { return state->pending == 0; });
+        lock.unlock();
+
+        // Merge propagated charges in task order to be independent of the thread scheduling
+        for(size_t idx = 0; idx < tasks.size(); ++idx) {
+            if(task_exceptions[idx]) {
+                std::rethrow_exception(task_exceptions[idx]);
+            }
+            std::move(task_charges[idx].begin(), task_charges[idx].end(), std::back_inserter(propagated_charges));
+        }
+    }
+
+    propagation_timer.reset();
+
+    // Restore the order of the deposits in the output, the charges propagated from the same deposit keep their order
+    if(sort_deposits_) {
+        std::stable_sort(propagated_charges.begin(), propagated_charges.end(), [](const auto& lhs, const auto& rhs) {
+            return std::less<const DepositedCharge*>()(lhs.getDepositedCharge(), rhs.getDepositedCharge());
+        });
+    }
+
+    // Update statistical information
+    unsigned int propagated_charges_count = 0;
+    unsigned int recombined_charges_count = 0;
+    unsigned int trapped_charges_count = 0;
+    unsigned int step_count = 0;
+    long double total_time = 0;
+    for(const auto& [recombined, trapped, propagated, steps, time] : task_stats) {
+        recombined_charges_count += recombined;
+        trapped_charges_count += trapped;
+        propagated_charges_count += propagated;
+        step_count += steps;
+        total_time += time;
+    }
+
     // Output plots if required
     if(output_linegraphs_) {
-        LineGraph::Create(event->number, this, config_, output_plot_points, CarrierState::UNKNOWN);
+        LineGraph::Create(event->number, this, plot_settings_, output_plot_points, CarrierState::UNKNOWN);
         if(output_linegraphs_collected_) {
-            LineGraph::Create(event->number, this, config_, output_plot_points, CarrierState::HALTED);
+            LineGraph::Create(event->number, this, plot_settings_, output_plot_points, CarrierState::HALTED);
         }
         if(output_linegraphs_recombined_) {
-            LineGraph::Create(event->number, this, config_, output_plot_points, CarrierState::RECOMBINED);
+            LineGraph::Create(event->number, this, plot_settings_, output_plot_points, CarrierState::RECOMBINED);
         }
         if(output_linegraphs_trapped_) {
-            LineGraph::Create(event->number, this, config_, output_plot_points, CarrierState::TRAPPED);
+            LineGraph::Create(event->number, this, plot_settings_, output_plot_points, CarrierState::TRAPPED);
         }
         if(output_animations_) {
-            LineGraph::Animate(event->number, this, config_, output_plot_points);
+            LineGraph::Animate(event->number, this, plot_settings_, output_plot_points);
         }
     }
+    if(output_trajectories_) {
+        trajectory_writer_->fill(event->number, output_plot_points);
+    }
 
     // Write summary and update statistics
     long double average_time = total_time / std::max(1u, propagated_charges_count);
@@ -434,6 +1331,15 @@ void GenericPropagationModule::run(Event* event) {
     total_steps_ += step_count;
     total_time_picoseconds_ += static_cast<long unsigned int>(total_time * 1e3);
 
+    size_t group_count = 0;
+    for(const auto& task : tasks) {
+        group_count += task.size();
+    }
+    getProfiler().count(groups_counter_, group_count);
+    getProfiler().count(steps_counter_, step_count);
+    getProfiler().count(recombined_counter_, recombined_charges_count);
+    getProfiler().count(trapped_counter_, trapped_charges_count);
+
     if(output_plots_) {
         auto total = (propagated_charges_count + recombined_charges_count + trapped_charges_count);
         recombine_histo_->Fill(static_cast<double>(recombined_charges_count) / (total == 0 ? 1 : total));
@@ -447,13 +1353,73 @@ void GenericPropagationModule::run(Event* event) {
     messenger_->dispatchMessage(this, std::move(propagated_charge_message), event);
 }
 
+/**
+ * Consecutive groups from the same deposit are combined into batches of up to the configured batch size if batched
+ * propagation is enabled, all other groups are propagated individually in the given order.
+ */
+std::tuple<unsigned int, unsigned int, unsigned int, unsigned int, long double>
+GenericPropagationModule::propagate_groups(
+    RandomNumberGenerator& random_generator,
+    const std::vector<std::tuple<const DepositedCharge*, CarrierType, unsigned int>>& groups,
+    std::vector<PropagatedCharge>& propagated_charges,
+    LineGraph::OutputPlotPoints& output_plot_points) const {
+    unsigned int propagated_charges_count = 0;
+    unsigned int recombined_charges_count = 0;
+    unsigned int trapped_charges_count = 0;
+    unsigned int step_count = 0;
+    long double total_time = 0;
+
+    std::vector<unsigned int> group_charges;
+    for(size_t idx = 0; idx < groups.size(); ++idx) {
+        const auto& deposit = *std::get<0>(groups[idx]);
+        const auto type = std::get<1>(groups[idx]);
+
+        std::tuple<unsigned int, unsigned int, unsigned int, unsigned int, long double> stats;
+        if(batch_size_ > 1) {
+            // Collect consecutive groups of the same carriers of the same deposit and advance them in lock-step
+            group_charges.clear();
+            group_charges.push_back(std::get<2>(groups[idx]));
+            while(group_charges.size() < batch_size_ && idx + 1 < groups.size() &&
+                  std::get<0>(groups[idx + 1]) == &deposit && std::get<1>(groups[idx + 1]) == type) {
+                group_charges.push_back(std::get<2>(groups[++idx]));
+            }
+            stats = detector_->visitElectricField([&](const auto& electric_field) {
+                return propagate_batch(random_generator, deposit, type, group_charges, propagated_charges, electric_field);
+            });
+        } else {
+            // Propagate a single charge deposit
+            stats = propagate(random_generator,
+                              deposit,
+                              deposit.getLocalPosition(),
+                              type,
+                              std::get<2>(groups[idx]),
+                              deposit.getLocalTime(),
+                              deposit.getGlobalTime(),
+                              0,
+                              propagated_charges,
+                              output_plot_points);
+        }
+
+        // Update statistical information
+        auto [recombined, trapped, propagated, steps, time] = stats;
+        recombined_charges_count += recombined;
+        trapped_charges_count += trapped;
+        propagated_charges_count += propagated;
+        step_count += steps;
+        total_time += time;
+    }
+
+    return std::make_tuple(
+        recombined_charges_count, trapped_charges_count, propagated_charges_count, step_count, total_time);
+}
+
 /**
  * Propagation is simulated using a parameterization for the electron mobility. This is used to calculate the electron
  * velocity at every point with help of the electric field map of the detector. An Runge-Kutta integration is applied in
  * multiple steps, adding a random diffusion to the propagating charge every step.
  */
 std::tuple<unsigned int, unsigned int, unsigned int, unsigned int, long double>
-GenericPropagationModule::propagate(Event* event,
+GenericPropagationModule::propagate(RandomNumberGenerator& random_generator,
                                     const DepositedCharge& deposit,
                                     const ROOT::Math::XYZPoint& pos,
                                     const CarrierType& type,
@@ -463,15 +1429,115 @@ GenericPropagationModule::propagate(Event* event,
                                     const unsigned int level,
                                     std::vector<PropagatedCharge>& propagated_charges,
                                     LineGraph::OutputPlotPoints& output_plot_points) const {
+    unsigned int propagated_charges_count = 0;
+    unsigned int recombined_charges_count = 0;
+    unsigned int trapped_charges_count = 0;
+    unsigned int steps = 0;
+    long double total_time = 0;
 
-    if(level > max_multiplication_level_) {
-        LOG(WARNING) << "Found impact ionization shower with level larger than " << max_multiplication_level_
-                     << ", interrupting";
-        return {};
-    }
+    // Work queue of charge carrier sets, starting with the primary set and extended by the secondaries of every set
+    thread_local std::vector<CarrierGroup> pending;
+    pending.clear();
+    pending.push_back({pos, type, charge, initial_time_local, initial_time_global, level});
+
+    // Resolve the type of the electric field, the precision and the enabled features once for all sets
+    auto propagate_pending = [&](const auto& electric_field,
+                                 auto single_precision,
+                                 auto magnetic_field,
+                                 auto multiplication,
+                                 auto recording) {
+        using ElectricField = std::decay_t<decltype(electric_field)>;
+        using Scalar = std::conditional_t<decltype(single_precision)::value, float, double>;
+        while(!pending.empty()) {
+            auto group = pending.back();
+            pending.pop_back();
+
+            if(group.level > max_multiplication_level_) {
+                LOG(WARNING) << "Found impact ionization shower with level larger than " << max_multiplication_level_
+                             << ", interrupting";
+                continue;
+            }
+
+            // Propagate the set in double precision from a copy of the random number state first if validating
+            std::vector<PropagatedCharge> reference_charges;
+            if(decltype(single_precision)::value && validate_precision_) {
+                std::stringstream state;
+                state << random_generator;
+                RandomNumberGenerator reference_generator(random_generator.getEngine());
+                state >> reference_generator;
+
+                std::vector<CarrierGroup> reference_secondaries;
+                LineGraph::OutputPlotPoints reference_points;
+                propagate_group<double,
+                                ElectricField,
+                                decltype(magnetic_field)::value,
+                                decltype(multiplication)::value,
+                                false>(reference_generator,
+                                       deposit,
+                                       type,
+                                       group,
+                                       reference_secondaries,
+                                       reference_charges,
+                                       reference_points,
+                                       electric_field);
+            }
+
+            auto [recombined, trapped, propagated, psteps, ptime] =
+                propagate_group<Scalar,
+                                ElectricField,
+                                decltype(magnetic_field)::value,
+                                decltype(multiplication)::value,
+                                decltype(recording)::value>(
+                    random_generator, deposit, type, group, pending, propagated_charges, output_plot_points, electric_field);
+            if(!reference_charges.empty()) {
+                compare_precision(reference_charges.back(), propagated_charges.back());
+            }
+            recombined_charges_count += recombined;
+            trapped_charges_count += trapped;
+            propagated_charges_count += propagated;
+            steps += psteps;
+            total_time += ptime;
+        }
+    };
+    detector_->visitElectricField([&](const auto& electric_field) {
+        with_flag(propagation_precision_ == PropagationPrecision::SINGLE, [&](auto single_precision) {
+            with_flag(has_magnetic_field_, [&](auto magnetic_field) {
+                with_flag(!multiplication_.is<NoImpactIonization>(), [&](auto multiplication) {
+                    with_flag(output_plots_ || record_trajectories_, [&](auto recording) {
+                        propagate_pending(electric_field, single_precision, magnetic_field, multiplication, recording);
+                    });
+                });
+            });
+        });
+    });
+
+    return std::make_tuple(recombined_charges_count, trapped_charges_count, propagated_charges_count, steps, total_time);
+}
+
+/**
+ * The position is integrated in the given floating-point type, while the fields, the physics models and the diffusion are
+ * evaluated in double precision and the time is always accumulated in double precision.
+ */
+template <typename Scalar, typename ElectricField, bool MagneticField, bool Multiplication, bool Recording>
+std::tuple<unsigned int, unsigned int, unsigned int, unsigned int, long double>
+GenericPropagationModule::propagate_group(RandomNumberGenerator& random_generator,
+                                          const DepositedCharge& deposit,
+                                          CarrierType deposit_type,
+                                          const CarrierGroup& group,
+                                          std::vector<CarrierGroup>& secondaries,
+                                          std::vector<PropagatedCharge>& propagated_charges,
+                                          LineGraph::OutputPlotPoints& output_plot_points,
+                                          const ElectricField& electric_field) const {
+    const auto& pos = group.position;
+    const auto type = group.type;
+    const auto initial_time_local = group.initial_time_local;
+    const auto initial_time_global = group.initial_time_global;
+    const auto level = group.level;
+    auto charge = group.charge;
 
     // Create a runge kutta solver using the electric field as step function
-    Eigen::Vector3d position(pos.x(), pos.y(), pos.z());
+    using Vector = Eigen::Matrix<Scalar, 3, 1>;
+    Vector position = Eigen::Vector3d(pos.x(), pos.y(), pos.z()).template cast<Scalar>();
 
     unsigned int propagated_charges_count = 0;
     unsigned int recombined_charges_count = 0;
@@ -480,54 +1546,79 @@ GenericPropagationModule::propagate(Event* event,
     long double total_time = 0;
 
     // Add point of deposition to the output plots if requested
-    if(output_linegraphs_) {
-        output_plot_points.emplace_back(
-            std::make_tuple(deposit.getGlobalTime(), charge, deposit.getType(), CarrierState::MOTION),
-            std::vector<ROOT::Math::XYZPoint>());
+    size_t output_plot_index = 0;
+    if(Recording && record_trajectories_) {
+        output_plot_index =
+            output_plot_points.addTrajectory(deposit.getGlobalTime(), charge, deposit_type, CarrierState::MOTION);
     }
-    auto output_plot_index = output_plot_points.size() - 1;
 
     // Store initial charge
     const unsigned int initial_charge = charge;
 
+    // Precomputed velocity and diffusion grids of this carrier type, only used if requested
+    const auto& grids = (type == CarrierType::ELECTRON ? electron_grids_ : hole_grids_);
+
+    // Normal random numbers for the diffusion generated in blocks, only used if requested
+    BlockSampler<RandomNumberGenerator> sampler(random_generator);
+
     // Define a function to compute the diffusion
-    auto carrier_diffusion = [&](double efield_mag, double doping_concentration, double timestep) -> Eigen::Vector3d {
-        double diffusion_constant = boltzmann_kT_ * mobility_(type, efield_mag, doping_concentration);
+    auto carrier_diffusion = [&](const Vector& cur_pos,
+                                 double efield_mag,
+                                 double doping_concentration,
+                                 double timestep) -> Vector {
+        // Precomputed diffusion constants are only available within the field map, use the mobility model elsewhere
+        double diffusion_constant =
+            (precompute_velocity_ ? grids.diffusion.get(static_cast<ROOT::Math::XYZPoint>(cur_pos), true) : 0.);
+        if(diffusion_constant <= 0) {
+            diffusion_constant = boltzmann_kT_ * mobility_(type, efield_mag, doping_concentration);
+        }
         double diffusion_std_dev = std::sqrt(2. * diffusion_constant * timestep);
 
-        // Compute the independent diffusion in three
+        // Compute the independent diffusion in three dimensions, from the pre-generated block if requested
+        if(batch_sampling_) {
+            auto x = sampler.normal(0, diffusion_std_dev);
+            auto y = sampler.normal(0, diffusion_std_dev);
+            auto z = sampler.normal(0, diffusion_std_dev);
+            return Eigen::Vector3d(x, y, z).template cast<Scalar>();
+        }
         allpix::normal_distribution<double> gauss_distribution(0, diffusion_std_dev);
-        auto x = gauss_distribution(event->getRandomEngine());
-        auto y = gauss_distribution(event->getRandomEngine());
-        auto z = gauss_distribution(event->getRandomEngine());
-        return {x, y, z};
+        auto x = gauss_distribution(random_generator);
+        auto y = gauss_distribution(random_generator);
+        auto z = gauss_distribution(random_generator);
+        return Eigen::Vector3d(x, y, z).template cast<Scalar>();
     };
 
     // Survival or detrap probability of this charge carrier package, evaluated at every step
     allpix::uniform_real_distribution<double> uniform_distribution(0, 1);
 
-    // Define lambda functions to compute the charge carrier velocity with or without magnetic field
-    std::function<Eigen::Vector3d(double, const Eigen::Vector3d&)> carrier_velocity_noB =
-        [&](double, const Eigen::Vector3d& cur_pos) -> Eigen::Vector3d {
-        auto raw_field = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(cur_pos));
-        Eigen::Vector3d efield(raw_field.x(), raw_field.y(), raw_field.z());
-        auto doping = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+    // Remaining time to recombination and trapping in units of the respective lifetime, drawn once if requested
+    allpix::exponential_distribution<double> lifetime_distribution(1);
+    double recombination_budget = 0, trapping_budget = 0;
+    if(sample_carrier_lifetimes_) {
+        recombination_budget = lifetime_distribution(random_generator);
+        trapping_budget = lifetime_distribution(random_generator);
+    }
 
-        return static_cast<int>(type) * mobility_(type, efield.norm(), doping) * efield;
-    };
+    // Define a lambda function to compute the charge carrier velocity with or without magnetic field
+    auto carrier_velocity = [&](double, const Vector& cur_pos) -> Vector {
+        if(precompute_velocity_) {
+            auto velocity = grids.velocity.get(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+            return Eigen::Vector3d(velocity.x(), velocity.y(), velocity.z()).template cast<Scalar>();
+        }
 
-    std::function<Eigen::Vector3d(double, const Eigen::Vector3d&)> carrier_velocity_withB =
-        [&](double, const Eigen::Vector3d& cur_pos) -> Eigen::Vector3d {
-        auto raw_field = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+        auto raw_field = electric_field(static_cast<ROOT::Math::XYZPoint>(cur_pos));
         Eigen::Vector3d efield(raw_field.x(), raw_field.y(), raw_field.z());
 
-        Eigen::Vector3d velocity;
+        auto doping = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+        auto mob = mobility_(type, efield.norm(), doping);
+
+        if constexpr(!MagneticField) {
+            return (static_cast<int>(type) * mob * efield).template cast<Scalar>();
+        }
+
         auto magnetic_field = detector_->getMagneticField(static_cast<ROOT::Math::XYZPoint>(cur_pos));
         Eigen::Vector3d bfield(magnetic_field.x(), magnetic_field.y(), magnetic_field.z());
 
-        auto doping = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(cur_pos));
-
-        auto mob = mobility_(type, efield.norm(), doping);
         auto exb = efield.cross(bfield);
 
         Eigen::Vector3d term1;
@@ -537,85 +1628,117 @@ GenericPropagationModule::propagate(Event* event,
         Eigen::Vector3d term2 = mob * mob * hallFactor * hallFactor * efield.dot(bfield) * bfield;
 
         auto rnorm = 1 + mob * mob * hallFactor * hallFactor * bfield.dot(bfield);
-        return static_cast<int>(type) * mob * (efield + term1 + term2) / rnorm;
+        return (static_cast<int>(type) * mob * (efield + term1 + term2) / rnorm).template cast<Scalar>();
     };
 
-    // Create the runge kutta solver with an RKF5 tableau, using different velocity calculators depending on the magnetic
-    // field
-    auto runge_kutta = make_runge_kutta(
-        tableau::RK5, (has_magnetic_field_ ? carrier_velocity_withB : carrier_velocity_noB), timestep_start_, position);
+    // Create the runge kutta solver with an RKF5 tableau, resolving both the tableau and the velocity function at compile
+    // time
+    auto runge_kutta =
+        make_static_runge_kutta<tableau::StaticRK5>(carrier_velocity, static_cast<Scalar>(timestep_start_), position);
 
     // Continue propagation until the deposit is outside the sensor
-    Eigen::Vector3d last_position = position;
-    ROOT::Math::XYZVector efield{}, last_efield{};
+    Vector last_position = position;
+    // Only the field magnitude enters the physics models, the doping at the end of a step is reused for the next step
+    double efield_mag = 0, last_efield_mag = 0;
+    auto doping = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(position));
     double last_time = 0;
+    double last_error = 1.;
     size_t next_idx = 0;
     auto state = CarrierState::MOTION;
     while(state == CarrierState::MOTION && (initial_time_local + runge_kutta.getTime()) < integration_time_) {
         // Update output plots if necessary (depending on the plot step)
-        if(output_linegraphs_) {
+        if(Recording && record_trajectories_) {
             auto time_idx = static_cast<size_t>(runge_kutta.getTime() / output_plots_step_);
             while(next_idx <= time_idx) {
-                output_plot_points.at(output_plot_index).second.push_back(static_cast<ROOT::Math::XYZPoint>(position));
-                next_idx = output_plot_points.at(output_plot_index).second.size();
+                output_plot_points.addPoint(output_plot_index, static_cast<ROOT::Math::XYZPoint>(position));
+                next_idx = output_plot_points.getNumberOfPoints(output_plot_index);
             }
         }
 
         // Save previous position and time
         last_position = position;
         last_time = runge_kutta.getTime();
-        last_efield = efield;
+        last_efield_mag = efield_mag;
 
         // Get electric field at current (pre-step) position
-        efield = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(position));
-        auto doping = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(position));
+        efield_mag = std::sqrt(electric_field(static_cast<ROOT::Math::XYZPoint>(position)).Mag2());
+
+        // Jump to the surface of the largest field-free sphere around the set in a single move if possible
+        std::optional<std::pair<ROOT::Math::XYZVector, double>> jump;
+        if(field_free_sampling_) {
+            jump = field_free_jump(random_generator,
+                                   type,
+                                   static_cast<ROOT::Math::XYZPoint>(position),
+                                   doping,
+                                   runge_kutta.getTimeStep(),
+                                   integration_time_ - initial_time_local - runge_kutta.getTime());
+        }
 
-        // Execute a Runge Kutta step
-        auto step = runge_kutta.step();
+        double timestep = 0;
+        typename decltype(runge_kutta)::Step step;
+        if(jump.has_value()) {
+            step.value = Eigen::Vector3d(jump->first.x(), jump->first.y(), jump->first.z()).template cast<Scalar>();
+            step.error.setZero();
+            timestep = jump->second;
+            position += step.value;
+            runge_kutta.setValue(position);
+            runge_kutta.advanceTime(timestep);
+            LOG(TRACE) << "Jump from " << Units::display(static_cast<ROOT::Math::XYZPoint>(last_position), {"um"})
+                       << " to " << Units::display(static_cast<ROOT::Math::XYZPoint>(position), {"um"}) << " in "
+                       << Units::display(timestep, {"ps", "ns"});
+        } else {
+            // Execute a Runge Kutta step
+            step = runge_kutta.step();
 
-        // Get the current result and timestep
-        auto timestep = runge_kutta.getTimeStep();
-        position = runge_kutta.getValue();
-        LOG(TRACE) << "Step from " << Units::display(static_cast<ROOT::Math::XYZPoint>(last_position), {"um"}) << " to "
-                   << Units::display(static_cast<ROOT::Math::XYZPoint>(position), {"um"});
+            // Get the current result and timestep
+            timestep = runge_kutta.getTimeStep();
+            position = runge_kutta.getValue();
 
-        // Apply diffusion step
-        auto diffusion = carrier_diffusion(std::sqrt(efield.Mag2()), doping, timestep);
-        position += diffusion;
-        runge_kutta.setValue(position);
+            // Request the fields at the position predicted for the end of the next step while processing this one
+            if(prefetch_fields_) {
+                detector_->prefetchFields(static_cast<ROOT::Math::XYZPoint>(Vector(position + step.value)), false);
+            }
+            LOG(TRACE) << "Step from " << Units::display(static_cast<ROOT::Math::XYZPoint>(last_position), {"um"})
+                       << " to " << Units::display(static_cast<ROOT::Math::XYZPoint>(position), {"um"});
+
+            // Apply diffusion step
+            auto diffusion = carrier_diffusion(last_position, efield_mag, doping, timestep);
+            position += diffusion;
+            runge_kutta.setValue(position);
+        }
 
         // Check if we are still in the sensor and not in an implant:
-        if(!model_->isWithinSensor(static_cast<ROOT::Math::XYZPoint>(position)) ||
-           model_->isWithinImplant(static_cast<ROOT::Math::XYZPoint>(position))) {
+        if(halted(static_cast<ROOT::Math::XYZPoint>(position))) {
             state = CarrierState::HALTED;
         }
 
         // Physics effects:
 
         // Check if charge carrier is still alive:
-        if(state == CarrierState::MOTION &&
-           recombination_(type,
-                          detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(position)),
-                          uniform_distribution(event->getRandomEngine()),
-                          timestep)) {
-            state = CarrierState::RECOMBINED;
+        if(state == CarrierState::MOTION) {
+            doping = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(position));
+            if(recombined(random_generator, type, doping, timestep, recombination_budget)) {
+                state = CarrierState::RECOMBINED;
+            }
         }
 
         // Check if the charge carrier has been trapped:
-        if(state == CarrierState::MOTION &&
-           trapping_(type, uniform_distribution(event->getRandomEngine()), timestep, std::sqrt(efield.Mag2()))) {
-            if(output_plots_) {
-                trapping_time_histo_->Fill(static_cast<double>(Units::convert(runge_kutta.getTime(), "ns")), charge);
+        if(state == CarrierState::MOTION && trapped(random_generator, type, efield_mag, timestep, trapping_budget)) {
+            if(Recording && output_plots_) {
+                trapping_time_histo_->Fill(static_cast<double>(runge_kutta.getTime() / units::ns), charge);
             }
 
-            auto detrap_time = detrapping_(type, uniform_distribution(event->getRandomEngine()), std::sqrt(efield.Mag2()));
+            auto detrap_time = detrapping_(type, uniform_distribution(random_generator), efield_mag);
             if((initial_time_local + runge_kutta.getTime() + detrap_time) < integration_time_) {
                 LOG(DEBUG) << "De-trapping charge carrier after " << Units::display(detrap_time, {"ns", "us"});
                 // De-trap and advance in time if still below integration time
                 runge_kutta.advanceTime(detrap_time);
+                if(sample_carrier_lifetimes_) {
+                    trapping_budget = lifetime_distribution(random_generator);
+                }
 
-                if(output_plots_) {
-                    detrapping_time_histo_->Fill(static_cast<double>(Units::convert(detrap_time, "ns")), charge);
+                if(Recording && output_plots_) {
+                    detrapping_time_histo_->Fill(static_cast<double>(detrap_time / units::ns), charge);
                 }
             } else {
                 // Mark as trapped otherwise
@@ -631,23 +1754,35 @@ GenericPropagationModule::propagate(Event* event,
         // Apply multiplication step: calculate gain factor from local efield and step length; Interpolate efield values
         // The multiplication factor is not scaled by the velocity fraction parallel to the electric field, as the
         // correction is negligible for semiconductors
-        auto local_gain =
-            multiplication_(type, (std::sqrt(efield.Mag2()) + std::sqrt(last_efield.Mag2())) / 2., step.value.norm());
+        auto local_gain = 1.;
+        if(Multiplication && !jump.has_value()) {
+            if(precompute_multiplication_) {
+                local_gain = precomputed_gain(type,
+                                              (efield_mag + last_efield_mag) / 2.,
+                                              step.value.norm(),
+                                              static_cast<ROOT::Math::XYZPoint>(last_position),
+                                              static_cast<ROOT::Math::XYZPoint>(position));
+            } else {
+                local_gain = multiplication_(type, (efield_mag + last_efield_mag) / 2., step.value.norm());
+            }
+        }
 
         unsigned int n_secondaries = 0;
 
         if(local_gain > 1.0) {
             LOG(DEBUG) << "Calculated local gain of " << local_gain << " for step of "
                        << Units::display(step.value.norm(), {"um", "nm"}) << " from field of "
-                       << Units::display(std::sqrt(last_efield.Mag2()), "kV/cm") << " to "
-                       << Units::display(std::sqrt(efield.Mag2()), "kV/cm");
+                       << Units::display(last_efield_mag, "kV/cm") << " to " << Units::display(efield_mag, "kV/cm");
 
-            // For each charge carrier draw a number to determine the number of
-            // secondaries generated in this step
-            double log_prob = 1. / std::log1p(-1. / local_gain);
-            for(unsigned int i_carrier = 0; i_carrier < charge; ++i_carrier) {
-                n_secondaries +=
-                    static_cast<unsigned int>(std::log(uniform_distribution(event->getRandomEngine())) * log_prob);
+            // The number of secondaries generated by each charge carrier in this step follows a geometric distribution with
+            // success probability 1/gain, the sum over all carriers of the set a negative binomial distribution
+            if(charge == 1) {
+                n_secondaries = static_cast<unsigned int>(std::log(uniform_distribution(random_generator)) /
+                                                          std::log1p(-1. / local_gain));
+            } else {
+                allpix::negative_binomial_distribution<unsigned int, double> secondaries_distribution(charge,
+                                                                                                      1. / local_gain);
+                n_secondaries = secondaries_distribution(random_generator);
             }
 
             auto inverted_type = invertCarrierType(type);
@@ -663,66 +1798,37 @@ GenericPropagationModule::propagate(Event* event,
                 auto carrier_pos = static_cast<ROOT::Math::XYZPoint>(position);
                 LOG(DEBUG) << "Set of charge carriers (" << inverted_type << ") generated from impact ionization on "
                            << Units::display(carrier_pos, {"mm", "um"});
-                if(output_plots_) {
+                if(Recording && output_plots_) {
                     multiplication_depth_histo_->Fill(carrier_pos.z(), n_secondaries);
                 }
 
-                auto [recombined, trapped, propagated, psteps, ptime] =
-                    propagate(event,
-                              deposit,
-                              carrier_pos,
-                              inverted_type,
-                              n_secondaries,
-                              initial_time_local + runge_kutta.getTime(),
-                              initial_time_global + runge_kutta.getTime(),
-                              level + 1,
-                              propagated_charges,
-                              output_plot_points);
-
-                // Update statistics:
-                recombined_charges_count += recombined;
-                trapped_charges_count += trapped;
-                propagated_charges_count += propagated;
-                steps += psteps;
-                total_time += ptime * charge;
-
-                LOG(DEBUG) << "Continuing propagation of charge carrier set (" << type << ") at "
-                           << Units::display(carrier_pos, {"mm", "um"});
+                // Queue the new set for propagation after the current one
+                secondaries.push_back({carrier_pos,
+                                       inverted_type,
+                                       n_secondaries,
+                                       initial_time_local + runge_kutta.getTime(),
+                                       initial_time_global + runge_kutta.getTime(),
+                                       level + 1});
             }
 
             auto gain = static_cast<double>(charge + n_secondaries) / initial_charge;
             if(gain > 50.) {
                 LOG(WARNING) << "Detected gain of " << gain << ", local electric field of "
-                             << Units::display(std::sqrt(efield.Mag2()), "kV/cm") << ", diode seems to be in breakdown";
+                             << Units::display(efield_mag, "kV/cm") << ", diode seems to be in breakdown";
             }
         }
 
         // Update step length histogram
-        if(output_plots_) {
-            step_length_histo_->Fill(static_cast<double>(Units::convert(step.value.norm(), "um")));
-            uncertainty_histo_->Fill(static_cast<double>(Units::convert(step.error.norm(), "nm")));
+        if(Recording && output_plots_) {
+            step_length_histo_->Fill(static_cast<double>(step.value.norm() / units::um));
+            uncertainty_histo_->Fill(static_cast<double>(step.error.norm() / units::nm));
         }
 
-        // Adapt step size to match target precision
-        double uncertainty = step.error.norm();
-
-        // Lower timestep when reaching the sensor edge
-        if(std::fabs(model_->getSensorSize().z() / 2.0 - position.z()) < 2 * step.value.z()) {
-            timestep *= 0.75;
-        } else {
-            if(uncertainty > target_spatial_precision_) {
-                timestep *= 0.75;
-            } else if(2 * uncertainty < target_spatial_precision_) {
-                timestep *= 1.5;
-            }
-        }
-        // Limit the timestep to certain minimum and maximum step sizes
-        if(timestep > timestep_max_) {
-            timestep = timestep_max_;
-        } else if(timestep < timestep_min_) {
-            timestep = timestep_min_;
+        // Adapt step size to match target precision, jumps leave the time step of the integration untouched
+        if(!jump.has_value()) {
+            timestep = next_timestep(timestep, step.error.norm(), last_error, position.z(), step.value.z());
+            runge_kutta.setTimeStep(static_cast<Scalar>(timestep));
         }
-        runge_kutta.setTimeStep(timestep);
 
         charge += n_secondaries;
     }
@@ -732,22 +1838,22 @@ GenericPropagationModule::propagate(Event* event,
     if(state == CarrierState::HALTED && !model_->isWithinSensor(static_cast<ROOT::Math::XYZPoint>(position))) {
         auto intercept = model_->getSensorIntercept(static_cast<ROOT::Math::XYZPoint>(last_position),
                                                     static_cast<ROOT::Math::XYZPoint>(position));
-        position = Eigen::Vector3d(intercept.x(), intercept.y(), intercept.z());
+        position = Eigen::Vector3d(intercept.x(), intercept.y(), intercept.z()).template cast<Scalar>();
     }
 
     // Set final state of charge carrier for plotting:
-    if(output_linegraphs_) {
+    if(Recording && record_trajectories_) {
         // If drift time is larger than integration time or the charge carriers have been collected at the backside, reset:
-        if(!model_->isWithinImplant(static_cast<ROOT::Math::XYZPoint>(position)) &&
-           (time >= integration_time_ || last_position.z() < -model_->getSensorSize().z() * 0.45)) {
-            std::get<3>(output_plot_points.at(output_plot_index).first) = CarrierState::UNKNOWN;
+        if(!model_->findImplant(static_cast<ROOT::Math::XYZPoint>(position)) &&
+           (time >= integration_time_ || last_position.z() < -model_->getGeometry().sensor_size[2] * 0.45)) {
+            output_plot_points.setState(output_plot_index, CarrierState::UNKNOWN);
         } else {
-            std::get<3>(output_plot_points.at(output_plot_index).first) = state;
+            output_plot_points.setState(output_plot_index, state);
         }
     }
 
     auto gain = charge / initial_charge;
-    if(output_plots_ && !multiplication_.is<NoImpactIonization>()) {
+    if(Recording && Multiplication && output_plots_) {
         if(level == 0) {
             gain_primary_histo_->Fill(gain, initial_charge);
             if(type == CarrierType::ELECTRON) {
@@ -783,8 +1889,8 @@ GenericPropagationModule::propagate(Event* event,
         LOG(DEBUG) << " Recombined " << charge << " at " << Units::display(local_position, {"mm", "um"}) << " in "
                    << Units::display(time, "ns") << " time, removing";
         recombined_charges_count += charge;
-        if(output_plots_) {
-            recombination_time_histo_->Fill(static_cast<double>(Units::convert(time, "ns")), charge);
+        if(Recording && output_plots_) {
+            recombination_time_histo_->Fill(static_cast<double>(time / units::ns), charge);
         }
     } else if(state == CarrierState::TRAPPED) {
         LOG(DEBUG) << " Trapped " << charge << " at " << Units::display(local_position, {"mm", "um"}) << " in "
@@ -802,7 +1908,7 @@ GenericPropagationModule::propagate(Event* event,
     auto global_position = detector_->getGlobalPosition(local_position);
     PropagatedCharge propagated_charge(local_position,
                                        global_position,
-                                       deposit.getType(),
+                                       deposit_type,
                                        charge,
                                        deposit.getLocalTime() + time,
                                        deposit.getGlobalTime() + time,
@@ -811,15 +1917,438 @@ GenericPropagationModule::propagate(Event* event,
 
     propagated_charges.push_back(std::move(propagated_charge));
 
-    if(output_plots_) {
-        drift_time_histo_->Fill(static_cast<double>(Units::convert(time, "ns")), charge);
+    if(Recording && output_plots_) {
+        drift_time_histo_->Fill(static_cast<double>(time / units::ns), charge);
         group_size_histo_->Fill(charge);
     }
 
-    // Return statistics counters about this and all daughter propagated charge carrier groups and their final states
+    // Return statistics counters about this propagated charge carrier group and its final state
     return std::make_tuple(recombined_charges_count, trapped_charges_count, propagated_charges_count, steps, total_time);
 }
 
+/**
+ * Both propagations draw from the same random number state, such that they follow the same path as long as they perform the
+ * same number of steps. Only charge carriers which reached the sensor surface or an implant enter the distributions of the
+ * collected charge.
+ */
+void GenericPropagationModule::compare_precision(const PropagatedCharge& reference, const PropagatedCharge& single) const {
+    validated_groups_++;
+    if(reference.getState() != single.getState()) {
+        validated_state_mismatches_++;
+    }
+
+    auto deviation = std::sqrt((single.getLocalPosition() - reference.getLocalPosition()).Mag2());
+    precision_deviation_histo_->Fill(static_cast<double>(Units::convert(deviation, "nm")));
+    if(reference.getState() == CarrierState::HALTED) {
+        collection_time_double_histo_->Fill(static_cast<double>(Units::convert(reference.getLocalTime(), "ns")),
+                                            reference.getCharge());
+    }
+    if(single.getState() == CarrierState::HALTED) {
+        collection_time_single_histo_->Fill(static_cast<double>(Units::convert(single.getLocalTime(), "ns")),
+                                            single.getCharge());
+    }
+}
+
+/**
+ * All charge carrier groups of the batch start from the same deposit and are advanced in lock-step. The state of the groups
+ * is kept in a structure-of-arrays layout, such that the Runge-Kutta stage combinations, the final step update and the
+ * step size adaption are evaluated for all groups at once. Only the field lookups and the random number draws are performed
+ * per group. Groups which are halted, recombined, trapped or have exceeded the integration time are retired from the batch
+ * by swapping them with the last active group.
+ */
+template <typename ElectricField>
+std::tuple<unsigned int, unsigned int, unsigned int, unsigned int, long double>
+GenericPropagationModule::propagate_batch(RandomNumberGenerator& random_generator,
+                                          const DepositedCharge& deposit,
+                                          CarrierType type,
+                                          const std::vector<unsigned int>& charges,
+                                          std::vector<PropagatedCharge>& propagated_charges,
+                                          const ElectricField& electric_field) const {
+    using Lanes = Eigen::Array<double, 1, Eigen::Dynamic>;
+    using Lanes3 = Eigen::Array<double, 3, Eigen::Dynamic>;
+
+    const auto initial_time_local = deposit.getLocalTime();
+    const auto& pos = deposit.getLocalPosition();
+    using Tableau = tableau::StaticRK5;
+    constexpr size_t stages = Tableau::stages;
+
+    unsigned int propagated_charges_count = 0;
+    unsigned int recombined_charges_count = 0;
+    unsigned int trapped_charges_count = 0;
+    unsigned int steps = 0;
+    long double total_time = 0;
+
+    // Structure-of-arrays state of all charge carrier groups in this batch
+    auto size = static_cast<Eigen::Index>(charges.size());
+    Lanes3 position(3, size);
+    position.colwise() = Eigen::Array3d(pos.x(), pos.y(), pos.z());
+    Lanes3 last_position = position;
+    Lanes timestep = Lanes::Constant(size, timestep_start_);
+    Lanes last_error = Lanes::Ones(size);
+    Lanes time = Lanes::Zero(size);
+    Lanes efield_mag(size);
+    Lanes diffusion_constant(size);
+    std::vector<unsigned int> charge(charges);
+    std::vector<CarrierState> state(charges.size(), CarrierState::MOTION);
+
+    // Remaining time to recombination and trapping in units of the respective lifetime, drawn once per group if requested
+    allpix::exponential_distribution<double> lifetime_distribution(1);
+    Lanes recombination_budget = Lanes::Zero(size);
+    Lanes trapping_budget = Lanes::Zero(size);
+    if(sample_carrier_lifetimes_) {
+        for(Eigen::Index l = 0; l < size; ++l) {
+            recombination_budget(l) = lifetime_distribution(random_generator);
+            trapping_budget(l) = lifetime_distribution(random_generator);
+        }
+    }
+
+    // Stage derivatives and step results
+    std::array<Lanes3, stages> k;
+    k.fill(Lanes3(3, size));
+    Lanes3 stage_position(3, size);
+    Lanes3 step_value(3, size);
+    Lanes3 step_error(3, size);
+
+    allpix::uniform_real_distribution<double> uniform_distribution(0, 1);
+
+    // Normal random numbers for the diffusion generated in blocks, only used if requested
+    BlockSampler<RandomNumberGenerator> sampler(random_generator);
+
+    // Steps since the start of the batch and merged groups with the number and charge-weighted displacement of their charges
+    unsigned int merge_steps = 0;
+    unsigned int merged_groups = 0, merged_charges = 0;
+    double merge_shift = 0, merge_delay = 0;
+
+    // Precomputed velocity and diffusion grids of this carrier type, only used if requested
+    const auto& grids = (type == CarrierType::ELECTRON ? electron_grids_ : hole_grids_);
+
+    // Diffusion constant at a given position, precomputed values are only available within the field map
+    auto carrier_diffusion_constant = [&](const Eigen::Vector3d& cur_pos, double field_mag, double dop) {
+        if(precompute_velocity_) {
+            auto diffusion = grids.diffusion.get(static_cast<ROOT::Math::XYZPoint>(cur_pos), true);
+            if(diffusion > 0) {
+                return diffusion;
+            }
+            dop = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+        }
+        return boltzmann_kT_ * mobility_(type, field_mag, dop);
+    };
+
+    // Carrier velocity at a given position, also returning the magnitude of the electric field and the doping concentration
+    // unless the velocity is taken from the precomputed grid
+    auto carrier_velocity = [&](const Eigen::Vector3d& cur_pos, double& field_mag, double& dop) -> Eigen::Vector3d {
+        if(precompute_velocity_) {
+            auto velocity = grids.velocity.get(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+            return {velocity.x(), velocity.y(), velocity.z()};
+        }
+
+        auto raw_field = electric_field(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+        Eigen::Vector3d efield(raw_field.x(), raw_field.y(), raw_field.z());
+        dop = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+        field_mag = efield.norm();
+
+        auto mob = mobility_(type, field_mag, dop);
+        if(!has_magnetic_field_) {
+            return static_cast<int>(type) * mob * efield;
+        }
+
+        auto magnetic_field = detector_->getMagneticField(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+        Eigen::Vector3d bfield(magnetic_field.x(), magnetic_field.y(), magnetic_field.z());
+        double hallFactor = (type == CarrierType::ELECTRON ? electron_Hall_ : hole_Hall_);
+        Eigen::Vector3d term1 = static_cast<int>(type) * mob * hallFactor * efield.cross(bfield);
+        Eigen::Vector3d term2 = mob * mob * hallFactor * hallFactor * efield.dot(bfield) * bfield;
+        auto rnorm = 1 + mob * mob * hallFactor * hallFactor * bfield.dot(bfield);
+        return static_cast<int>(type) * mob * (efield + term1 + term2) / rnorm;
+    };
+
+    auto active = size;
+
+    // Remove a group from the batch by moving the last active group into its slot
+    auto remove_group = [&](Eigen::Index l) {
+        --active;
+        auto lane = static_cast<size_t>(l);
+        auto last = static_cast<size_t>(active);
+        position.col(l) = position.col(active);
+        last_position.col(l) = last_position.col(active);
+        timestep(l) = timestep(active);
+        last_error(l) = last_error(active);
+        time(l) = time(active);
+        recombination_budget(l) = recombination_budget(active);
+        trapping_budget(l) = trapping_budget(active);
+        charge[lane] = charge[last];
+        state[lane] = state[last];
+    };
+
+    while(active > 0) {
+        auto n = active;
+        last_position.leftCols(n) = position.leftCols(n);
+
+        // Runge-Kutta stages, the first stage provides the pre-step field and diffusion constant for diffusion and trapping
+        for(size_t i = 0; i < stages; ++i) {
+            stage_position.leftCols(n) = position.leftCols(n);
+            for(size_t j = 0; j < i; ++j) {
+                stage_position.leftCols(n) +=
+                    (timestep.leftCols(n) * Tableau::values[i][j]).replicate<3, 1>() * k[j].leftCols(n);
+            }
+            double field_mag = 0, dop = 0;
+            for(Eigen::Index l = 0; l < n; ++l) {
+                Eigen::Vector3d cur_pos = stage_position.col(l).matrix();
+                k[i].col(l) = carrier_velocity(cur_pos, field_mag, dop).array();
+                if(i == 0) {
+                    if(precompute_velocity_) {
+                        field_mag = std::sqrt(electric_field(static_cast<ROOT::Math::XYZPoint>(cur_pos)).Mag2());
+                    }
+                    efield_mag(l) = field_mag;
+                    diffusion_constant(l) = carrier_diffusion_constant(cur_pos, field_mag, dop);
+                }
+            }
+        }
+
+        // Combine stages to step value and error estimate
+        step_value.leftCols(n).setZero();
+        step_error.leftCols(n).setZero();
+        for(size_t i = 0; i < stages; ++i) {
+            const auto& ki = k[i].leftCols(n);
+            step_value.leftCols(n) += (timestep.leftCols(n) * Tableau::values[stages][i]).replicate<3, 1>() * ki;
+            step_error.leftCols(n) += (timestep.leftCols(n) * Tableau::values[stages + 1][i]).replicate<3, 1>() * ki;
+        }
+        step_error.leftCols(n) = step_value.leftCols(n) - step_error.leftCols(n);
+        position.leftCols(n) += step_value.leftCols(n);
+        time.leftCols(n) += timestep.leftCols(n);
+
+        // Request the fields at the positions predicted for the end of the next step while processing this one
+        if(prefetch_fields_) {
+            for(Eigen::Index l = 0; l < n; ++l) {
+                detector_->prefetchFields(ROOT::Math::XYZPoint(position(0, l) + step_value(0, l),
+                                                               position(1, l) + step_value(1, l),
+                                                               position(2, l) + step_value(2, l)),
+                                          false);
+            }
+        }
+
+        // Per-group diffusion and physics processes
+        for(Eigen::Index l = 0; l < n; ++l) {
+            auto lane = static_cast<size_t>(l);
+            auto diffusion_std_dev = std::sqrt(2. * diffusion_constant(l) * timestep(l));
+            if(batch_sampling_) {
+                position(0, l) += sampler.normal(0, diffusion_std_dev);
+                position(1, l) += sampler.normal(0, diffusion_std_dev);
+                position(2, l) += sampler.normal(0, diffusion_std_dev);
+            } else {
+                allpix::normal_distribution<double> gauss_distribution(0, diffusion_std_dev);
+                position(0, l) += gauss_distribution(random_generator);
+                position(1, l) += gauss_distribution(random_generator);
+                position(2, l) += gauss_distribution(random_generator);
+            }
+
+            auto cur_pos = ROOT::Math::XYZPoint(position(0, l), position(1, l), position(2, l));
+            if(halted(cur_pos)) {
+                state[lane] = CarrierState::HALTED;
+            }
+
+            if(state[lane] == CarrierState::MOTION &&
+               recombined(random_generator,
+                          type,
+                          detector_->getDopingConcentration(cur_pos),
+                          timestep(l),
+                          recombination_budget(l))) {
+                state[lane] = CarrierState::RECOMBINED;
+            }
+
+            if(state[lane] == CarrierState::MOTION &&
+               trapped(random_generator, type, efield_mag(l), timestep(l), trapping_budget(l))) {
+                if(output_plots_) {
+                    trapping_time_histo_->Fill(static_cast<double>(time(l) / units::ns), charge[lane]);
+                }
+
+                auto detrap_time = detrapping_(type, uniform_distribution(random_generator), efield_mag(l));
+                if((initial_time_local + time(l) + detrap_time) < integration_time_) {
+                    time(l) += detrap_time;
+                    if(sample_carrier_lifetimes_) {
+                        trapping_budget(l) = lifetime_distribution(random_generator);
+                    }
+                    if(output_plots_) {
+                        detrapping_time_histo_->Fill(static_cast<double>(detrap_time / units::ns), charge[lane]);
+                    }
+                } else {
+                    state[lane] = CarrierState::TRAPPED;
+                }
+            }
+
+            if(output_plots_) {
+                step_length_histo_->Fill(
+                    static_cast<double>(step_value.col(l).matrix().norm() / units::um));
+                uncertainty_histo_->Fill(
+                    static_cast<double>(step_error.col(l).matrix().norm() / units::nm));
+            }
+        }
+
+        // Adapt step sizes of all groups to match target precision, lowering the timestep when reaching the sensor edge
+        Lanes uncertainty = step_error.leftCols(n).matrix().colwise().norm().array();
+        if(timestep_controller_ == TimestepController::PI) {
+            for(Eigen::Index l = 0; l < n; ++l) {
+                timestep(l) = next_timestep(timestep(l), uncertainty(l), last_error(l), position(2, l), step_value(2, l));
+            }
+        } else {
+            auto near_edge = ((model_->getGeometry().sensor_size[2] / 2.0 - position.row(2).leftCols(n)).abs() <
+                              2 * step_value.row(2).leftCols(n));
+            Lanes scale = (uncertainty > target_spatial_precision_)
+                              .select(0.75, (2 * uncertainty < target_spatial_precision_).select(1.5, Lanes::Ones(n)));
+            timestep.leftCols(n) =
+                (timestep.leftCols(n) * near_edge.select(0.75, scale)).min(timestep_max_).max(timestep_min_);
+        }
+
+        // Retire finished groups by swapping them with the last active group
+        for(Eigen::Index l = 0; l < active;) {
+            auto lane = static_cast<size_t>(l);
+            if(state[lane] == CarrierState::MOTION && (initial_time_local + time(l)) < integration_time_) {
+                ++l;
+                continue;
+            }
+
+            // Find proper final position in the sensor
+            auto local_position = ROOT::Math::XYZPoint(position(0, l), position(1, l), position(2, l));
+            if(state[lane] == CarrierState::HALTED && !model_->isWithinSensor(local_position)) {
+                local_position = model_->getSensorIntercept(
+                    ROOT::Math::XYZPoint(last_position(0, l), last_position(1, l), last_position(2, l)), local_position);
+            }
+
+            if(state[lane] == CarrierState::RECOMBINED) {
+                LOG(DEBUG) << " Recombined " << charge[lane] << " at " << Units::display(local_position, {"mm", "um"})
+                           << " in " << Units::display(time(l), "ns") << " time, removing";
+                recombined_charges_count += charge[lane];
+                if(output_plots_) {
+                    recombination_time_histo_->Fill(static_cast<double>(time(l) / units::ns), charge[lane]);
+                }
+            } else if(state[lane] == CarrierState::TRAPPED) {
+                LOG(DEBUG) << " Trapped " << charge[lane] << " at " << Units::display(local_position, {"mm", "um"})
+                           << " in " << Units::display(time(l), "ns") << " time, removing";
+                trapped_charges_count += charge[lane];
+            }
+            propagated_charges_count += charge[lane];
+            ++steps;
+            total_time += time(l) * charge[lane];
+
+            LOG(DEBUG) << " Propagated " << charge[lane] << " to " << Units::display(local_position, {"mm", "um"})
+                       << " in " << Units::display(time(l), "ns")
+                       << " time, final state: " << allpix::to_string(state[lane]);
+
+            propagated_charges.emplace_back(local_position,
+                                            detector_->getGlobalPosition(local_position),
+                                            type,
+                                            charge[lane],
+                                            deposit.getLocalTime() + time(l),
+                                            deposit.getGlobalTime() + time(l),
+                                            state[lane],
+                                            &deposit);
+
+            if(output_plots_) {
+                drift_time_histo_->Fill(static_cast<double>(time(l) / units::ns), charge[lane]);
+                group_size_histo_->Fill(charge[lane]);
+            }
+
+            remove_group(l);
+        }
+
+        // Merge groups which have converged in position and time into the heavier group at their charge-weighted mean
+        if(merge_interval_ > 0 && ++merge_steps % merge_interval_ == 0) {
+            for(Eigen::Index a = 0; a < active; ++a) {
+                for(Eigen::Index b = a + 1; b < active;) {
+                    if((position.col(a) - position.col(b)).matrix().norm() > merge_distance_ ||
+                       std::fabs(time(a) - time(b)) > merge_time_) {
+                        ++b;
+                        continue;
+                    }
+
+                    auto charge_a = static_cast<double>(charge[static_cast<size_t>(a)]);
+                    auto charge_b = static_cast<double>(charge[static_cast<size_t>(b)]);
+                    auto weight_b = charge_b / (charge_a + charge_b);
+                    Eigen::Array3d merged_position = position.col(a) + weight_b * (position.col(b) - position.col(a));
+                    auto merged_time = time(a) + weight_b * (time(b) - time(a));
+
+                    // Charge-weighted displacement introduced by the merging
+                    merge_shift += charge_a * (position.col(a) - merged_position).matrix().norm() +
+                                   charge_b * (position.col(b) - merged_position).matrix().norm();
+                    merge_delay += charge_a * std::fabs(time(a) - merged_time) + charge_b * std::fabs(time(b) - merged_time);
+                    merged_charges += charge[static_cast<size_t>(a)] + charge[static_cast<size_t>(b)];
+                    ++merged_groups;
+
+                    last_position.col(a) += weight_b * (last_position.col(b) - last_position.col(a));
+                    position.col(a) = merged_position;
+                    time(a) = merged_time;
+                    timestep(a) = std::min(timestep(a), timestep(b));
+                    charge[static_cast<size_t>(a)] += charge[static_cast<size_t>(b)];
+                    remove_group(b);
+                }
+            }
+        }
+    }
+
+    if(merged_groups > 0) {
+        LOG(DEBUG) << "Merged " << merged_groups << " charge carrier groups during drift";
+        total_merged_groups_ += merged_groups;
+        total_merged_charges_ += merged_charges;
+        merge_shift_nanometers_ += static_cast<long unsigned int>(merge_shift / units::nm);
+        merge_delay_picoseconds_ += static_cast<long unsigned int>(merge_delay / units::ps);
+    }
+
+    return std::make_tuple(recombined_charges_count, trapped_charges_count, propagated_charges_count, steps, total_time);
+}
+
+std::tuple<unsigned int, unsigned int, unsigned int, unsigned int, long double>
+GenericPropagationModule::propagate_offload(
+    uint64_t seed,
+    const std::vector<std::tuple<const DepositedCharge*, CarrierType, unsigned int>>& groups,
+    std::vector<PropagatedCharge>& propagated_charges) const {
+    std::vector<DevicePropagation::Group> device_groups;
+    device_groups.reserve(groups.size());
+    for(const auto& [deposit, type, charge] : groups) {
+        const auto& position = deposit->getLocalPosition();
+        DevicePropagation::Group group;
+        group.position = {position.x(), position.y(), position.z()};
+        group.start_time = deposit->getLocalTime();
+        group.carrier = (type == CarrierType::ELECTRON ? 0 : 1);
+        device_groups.push_back(group);
+    }
+
+    device_propagation_->propagate(device_groups, seed);
+
+    unsigned int propagated_charges_count = 0;
+    unsigned int step_count = 0;
+    long double total_time = 0;
+    for(size_t idx = 0; idx < groups.size(); ++idx) {
+        const auto& [deposit, type, charge] = groups[idx];
+        const auto& group = device_groups[idx];
+
+        // Find proper final position in the sensor
+        auto local_position = ROOT::Math::XYZPoint(group.position[0], group.position[1], group.position[2]);
+        auto state = (group.halted ? CarrierState::HALTED : CarrierState::MOTION);
+        if(group.halted && !model_->isWithinSensor(local_position)) {
+            local_position = model_->getSensorIntercept(
+                ROOT::Math::XYZPoint(group.last_position[0], group.last_position[1], group.last_position[2]),
+                local_position);
+        }
+
+        propagated_charges_count += charge;
+        step_count += group.steps;
+        total_time += group.time * charge;
+
+        LOG(DEBUG) << " Propagated " << charge << " to " << Units::display(local_position, {"mm", "um"}) << " in "
+                   << Units::display(group.time, "ns") << " time, final state: " << allpix::to_string(state);
+
+        propagated_charges.emplace_back(local_position,
+                                        detector_->getGlobalPosition(local_position),
+                                        type,
+                                        charge,
+                                        deposit->getLocalTime() + group.time,
+                                        deposit->getGlobalTime() + group.time,
+                                        state,
+                                        deposit);
+    }
+
+    return std::make_tuple(0u, 0u, propagated_charges_count, step_count, total_time);
+}
+
 void GenericPropagationModule::finalize() {
     if(output_plots_) {
         group_size_histo_->Get()->GetXaxis()->SetRange(1, group_size_histo_->Get()->GetNbinsX() + 1);
@@ -849,10 +2378,115 @@ void GenericPropagationModule::finalize() {
         }
     }
 
+    if(output_trajectories_) {
+        auto events = trajectory_writer_->write();
+        LOG(INFO) << "Wrote charge carrier trajectories of " << events << " events";
+    }
+
     long double average_time = static_cast<long double>(total_time_picoseconds_) / 1e3 /
                                std::max(1u, static_cast<unsigned int>(total_propagated_charges_));
     LOG(INFO) << "Propagated total of " << total_propagated_charges_ << " charges in " << total_steps_
               << " steps in average time of " << Units::display(average_time, "ns");
     LOG(INFO) << deposits_exceeding_max_groups_ * 100.0 / total_deposits_ << "% of deposits have charge exceeding the "
               << max_charge_groups_ << " charge groups allowed, with a charge_per_step value of " << charge_per_step_ << ".";
+    if(merge_interval_ > 0) {
+        // Average displacement of the charge carriers involved in a merge towards their common position and time
+        auto merged_charges = std::max(1.0, static_cast<double>(total_merged_charges_));
+        auto shift = Units::get(static_cast<double>(merge_shift_nanometers_), "nm") / merged_charges;
+        auto delay = Units::get(static_cast<double>(merge_delay_picoseconds_), "ps") / merged_charges;
+        LOG(INFO) << "Merged " << total_merged_groups_ << " charge carrier groups during drift, displacing the "
+                  << total_merged_charges_ << " charges involved by " << Units::display(shift, {"nm", "um"}) << " and "
+                  << Units::display(delay, {"ps", "ns"}) << " on average";
+    }
+    if(validate_precision_) {
+        // Compare the distributions of the collected charge of both precisions
+        auto reference = collection_time_double_histo_->Merge();
+        auto single = collection_time_single_histo_->Merge();
+        auto reference_charge = reference->Integral(0, reference->GetNbinsX() + 1);
+        auto single_charge = single->Integral(0, single->GetNbinsX() + 1);
+        auto probability = (reference_charge > 0 && single_charge > 0 ? reference->KolmogorovTest(single.get()) : 1.);
+        LOG(INFO) << "Validated propagation of " << validated_groups_ << " charge carrier groups in single precision, "
+                  << validated_state_mismatches_ << " with different final state" << std::endl
+                  << "Collected charge of " << single_charge << " in single and " << reference_charge
+                  << " in double precision, Kolmogorov-Smirnov probability of the arrival times " << probability;
+
+        precision_deviation_histo_->Write();
+        reference->Write();
+        single->Write();
+    }
+}
+
+/**
+ * For plain pixel detector models, the sensor bounds and the bounding box of the implants are checked inline via the
+ * geometry view of the model, such that the implants only need to be searched close to them.
+ */
+bool GenericPropagationModule::halted(const ROOT::Math::XYZPoint& position) const {
+    const auto& geometry = model_->getGeometry();
+    if(geometry.kind == DetectorModel::Geometry::Kind::RECTANGULAR) {
+        return !geometry.isWithinSensor(position) ||
+               (geometry.mayContainImplant(position) && model_->findImplant(position).has_value());
+    }
+    return !model_->isWithinSensor(position) || model_->findImplant(position).has_value();
+}
+
+double GenericPropagationModule::next_timestep(
+    double timestep, double uncertainty, double& last_error, double position_z, double drift_z) const {
+    auto surface_distance = model_->getGeometry().sensor_size[2] / 2.0;
+    if(timestep_controller_ == TimestepController::FIXED_FACTOR) {
+        // Lower timestep when reaching the sensor edge
+        if(std::fabs(surface_distance - position_z) < 2 * drift_z) {
+            timestep *= 0.75;
+        } else {
+            if(uncertainty > target_spatial_precision_) {
+                timestep *= 0.75;
+            } else if(2 * uncertainty < target_spatial_precision_) {
+                timestep *= 1.5;
+            }
+        }
+    } else {
+        // Proportional-integral controller for the fifth-order method with embedded fourth-order error estimate, the
+        // change of the time step per step is limited to avoid oscillations
+        auto error = std::max(uncertainty / target_spatial_precision_, 1e-6);
+        auto factor = 0.9 * std::pow(error, -0.7 / 5) * std::pow(last_error, 0.4 / 5);
+        last_error = error;
+        auto next = timestep * std::clamp(factor, 0.2, 5.);
+
+        // Limit the drift of the next step to the distance to the sensor surface the set is moving towards, slightly
+        // overshooting such that the set leaves the sensor in this step instead of approaching the surface asymptotically
+        if(drift_z != 0) {
+            auto distance = std::copysign(surface_distance, drift_z) - position_z;
+            auto surface_time = 1.01 * timestep * distance / drift_z;
+            if(surface_time > 0 && surface_time < next) {
+                next = surface_time;
+            }
+        }
+        timestep = next;
+    }
+
+    // Limit the timestep to certain minimum and maximum step sizes
+    return std::clamp(timestep, timestep_min_, timestep_max_);
+}
+
+bool GenericPropagationModule::recombined(
+    RandomNumberGenerator& random_generator, CarrierType type, double doping, double timestep, double& budget) const {
+    if(!sample_carrier_lifetimes_) {
+        allpix::uniform_real_distribution<double> uniform_distribution(0, 1);
+        return recombination_(type, doping, uniform_distribution(random_generator), timestep);
+    }
+
+    // Integrate the recombination rate along the path until the sampled time to recombination is used up
+    budget -= recombination_.rate(type, doping) * timestep;
+    return budget < 0;
+}
+
+bool GenericPropagationModule::trapped(
+    RandomNumberGenerator& random_generator, CarrierType type, double efield_mag, double timestep, double& budget) const {
+    if(!sample_carrier_lifetimes_) {
+        allpix::uniform_real_distribution<double> uniform_distribution(0, 1);
+        return trapping_(type, uniform_distribution(random_generator), timestep, efield_mag);
+    }
+
+    // Integrate the trapping rate along the path until the sampled time to trapping is used up
+    budget -= trapping_.rate(type, efield_mag) * timestep;
+    return budget < 0;
 }
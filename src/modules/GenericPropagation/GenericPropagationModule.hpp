@@ -9,9 +9,13 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <array>
 #include <atomic>
 #include <memory>
+#include <optional>
 #include <string>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 #include <Math/Point3D.h>
@@ -20,10 +24,12 @@
 #include <TProfile.h>
 
 #include "core/config/Configuration.hpp"
+#include "core/geometry/DetectorField.hpp"
 #include "core/geometry/DetectorModel.hpp"
 #include "core/messenger/Messenger.hpp"
 #include "core/module/Event.hpp"
 #include "core/module/Module.hpp"
+#include "core/utils/prng.h"
 
 #include "objects/DepositedCharge.hpp"
 #include "objects/PropagatedCharge.hpp"
@@ -37,6 +43,8 @@
 #include "tools/ROOT.h"
 #include "tools/line_graphs.h"
 
+#include "DevicePropagation.hpp"
+
 namespace allpix {
 
     /**
@@ -75,13 +83,41 @@ namespace allpix {
         void finalize() override;
 
     private:
+        /**
+         * @brief Different implemented controllers to adapt the time step of the integration
+         */
+        enum class TimestepController {
+            FIXED_FACTOR, ///< Scale the time step by fixed factors depending on the uncertainty of the last step
+            PI,           ///< Predict the time step from the last two uncertainties and stop at the sensor surface
+        };
+
+        /**
+         * @brief Floating-point precision of the position and the Runge-Kutta integration of a set of charge carriers
+         */
+        enum class PropagationPrecision {
+            DOUBLE, ///< Integrate the position in double precision
+            SINGLE, ///< Integrate the position in single precision, accumulating the time in double precision
+        };
+
         Messenger* messenger_;
         std::shared_ptr<const Detector> detector_;
         std::shared_ptr<DetectorModel> model_;
 
         /**
-         * @brief Propagate a single set of charges through the sensor
-         * @param event               Pointer to current event
+         * @brief Set of charge carriers waiting to be propagated, either from a deposit or from impact ionization
+         */
+        struct CarrierGroup {
+            ROOT::Math::XYZPoint position;
+            CarrierType type;
+            unsigned int charge;
+            double initial_time_local;
+            double initial_time_global;
+            unsigned int level;
+        };
+
+        /**
+         * @brief Propagate a single set of charges and all secondary charge carriers generated by it through the sensor
+         * @param random_generator    Reference to the random number generator to draw from
          * @param deposit             Reference to the original deposited charge object
          * @param pos                 Position of the deposit in the sensor
          * @param type                Type of the carrier to propagate
@@ -93,9 +129,12 @@ namespace allpix {
          * @param output_plot_points Reference to vector to hold points for line graph output plots
          *
          * @return Total recombined, trapped and propagated charge for statistics purposes
+         *
+         * Secondary charge carriers from impact ionization are collected in a work queue and propagated after the set which
+         * generated them, instead of recursing into the propagation of every secondary set.
          */
         std::tuple<unsigned int, unsigned int, unsigned int, unsigned int, long double>
-        propagate(Event* event,
+        propagate(RandomNumberGenerator& random_generator,
                   const DepositedCharge& deposit,
                   const ROOT::Math::XYZPoint& pos,
                   const CarrierType& type,
@@ -106,15 +145,217 @@ namespace allpix {
                   std::vector<PropagatedCharge>& propagated_charges,
                   LineGraph::OutputPlotPoints& output_plot_points) const;
 
+        /**
+         * @brief Propagate a single set of charges through the sensor
+         * @param random_generator    Reference to the random number generator to draw from
+         * @param deposit             Reference to the original deposited charge object
+         * @param deposit_type        Type of the carriers propagated from the deposit, assigned to the propagated charges
+         * @param group               Set of charge carriers to propagate
+         * @param secondaries         Work queue to append the sets of secondary charge carriers to
+         * @param propagated_charges  Reference to vector with all produced final PropagatedCharge objects
+         * @param output_plot_points  Reference to vector to hold points for line graph output plots
+         * @param electric_field      Accessor to the electric field of the detector
+         *
+         * @tparam Scalar         Floating-point type of the position and the Runge-Kutta integration
+         * @tparam MagneticField  Whether the drift is deflected by the magnetic field
+         * @tparam Multiplication Whether impact ionization is simulated
+         * @tparam Recording      Whether output plots or trajectories are recorded
+         *
+         * @return Recombined, trapped and propagated charge of this set for statistics purposes
+         */
+        template <typename Scalar, typename ElectricField, bool MagneticField, bool Multiplication, bool Recording>
+        std::tuple<unsigned int, unsigned int, unsigned int, unsigned int, long double>
+        propagate_group(RandomNumberGenerator& random_generator,
+                        const DepositedCharge& deposit,
+                        CarrierType deposit_type,
+                        const CarrierGroup& group,
+                        std::vector<CarrierGroup>& secondaries,
+                        std::vector<PropagatedCharge>& propagated_charges,
+                        LineGraph::OutputPlotPoints& output_plot_points,
+                        const ElectricField& electric_field) const;
+
+        /**
+         * @brief Compare the final state of a set of charge carriers propagated in single and in double precision
+         * @param reference Propagated charge of the set from the propagation in double precision
+         * @param single    Propagated charge of the set from the propagation in single precision
+         */
+        void compare_precision(const PropagatedCharge& reference, const PropagatedCharge& single) const;
+
+        /**
+         * @brief Propagate a batch of charge carrier groups from the same deposit in lock-step through the sensor
+         * @param random_generator    Reference to the random number generator to draw from
+         * @param deposit             Reference to the original deposited charge object
+         * @param type                Type of the charge carriers
+         * @param charges             Charge of each of the carrier groups in the batch
+         * @param propagated_charges  Reference to vector with all produced final PropagatedCharge objects
+         * @param electric_field      Accessor to the electric field of the detector
+         *
+         * @return Total recombined, trapped and propagated charge for statistics purposes
+         */
+        template <typename ElectricField>
+        std::tuple<unsigned int, unsigned int, unsigned int, unsigned int, long double>
+        propagate_batch(RandomNumberGenerator& random_generator,
+                        const DepositedCharge& deposit,
+                        CarrierType type,
+                        const std::vector<unsigned int>& charges,
+                        std::vector<PropagatedCharge>& propagated_charges,
+                        const ElectricField& electric_field) const;
+
+        /**
+         * @brief Propagate a consecutive range of charge carrier groups, in batches if requested
+         * @param random_generator    Reference to the random number generator to draw from
+         * @param groups              Deposit, carrier type and charge of each of the carrier groups
+         * @param propagated_charges  Reference to vector with all produced final PropagatedCharge objects
+         * @param output_plot_points  Reference to vector to hold points for line graph output plots
+         *
+         * @return Total recombined, trapped and propagated charge for statistics purposes
+         */
+        std::tuple<unsigned int, unsigned int, unsigned int, unsigned int, long double>
+        propagate_groups(RandomNumberGenerator& random_generator,
+                         const std::vector<std::tuple<const DepositedCharge*, CarrierType, unsigned int>>& groups,
+                         std::vector<PropagatedCharge>& propagated_charges,
+                         LineGraph::OutputPlotPoints& output_plot_points) const;
+
+        /**
+         * @brief Check if the propagation can be offloaded and transfer the tabulated carrier velocities to the device
+         */
+        void initialize_offload();
+
+        /**
+         * @brief Propagate all charge carrier groups of an event on the offload device
+         * @param seed                Seed of the random number streams of the groups
+         * @param groups              Deposit, carrier type and charge of each of the carrier groups
+         * @param propagated_charges  Reference to vector with all produced final PropagatedCharge objects
+         *
+         * @return Total recombined, trapped and propagated charge for statistics purposes
+         */
+        std::tuple<unsigned int, unsigned int, unsigned int, unsigned int, long double>
+        propagate_offload(uint64_t seed,
+                          const std::vector<std::tuple<const DepositedCharge*, CarrierType, unsigned int>>& groups,
+                          std::vector<PropagatedCharge>& propagated_charges) const;
+
+        /**
+         * @brief Set up the grid of a map over the sensor or over the unit cell of the pixel at the matrix center
+         * @param map Map to set up
+         * @param key Configuration key holding the number of bins along x, y and z
+         */
+        void setup_sensor_map(SensorMap& map, const std::string& key) const;
+
+        /**
+         * @brief Tabulate the distance to the closest region with electric field for the first-passage sampling
+         */
+        void initialize_field_free_map();
+
+        /**
+         * @brief Mark the cells in which impact ionization can occur and tabulate the gain factors of the model
+         */
+        void initialize_multiplication_map();
+
+        /**
+         * @brief Calculate the gain of a step from the precomputed impact ionization map
+         * @param type       Type of the charge carriers
+         * @param efield_mag Electric field magnitude averaged over the step
+         * @param step       Length of the step
+         * @param start      Local position at the start of the step
+         * @param end        Local position at the end of the step
+         * @return Gain factor for the step
+         */
+        double precomputed_gain(CarrierType type,
+                                double efield_mag,
+                                double step,
+                                const ROOT::Math::XYZPoint& start,
+                                const ROOT::Math::XYZPoint& end) const;
+
+        /**
+         * @brief Sample the jump of a set of charge carriers to the surface of the largest field-free sphere around it
+         * @param random_generator Reference to the random number generator to draw from
+         * @param type             Type of the charge carriers
+         * @param position         Local position of the set
+         * @param doping           Doping concentration at the position of the set
+         * @param timestep         Time step of the next regular step, shorter jumps are not taken
+         * @param remaining_time   Time until the end of the integration time
+         * @return Displacement and duration of the jump, or nothing if no jump is possible
+         */
+        std::optional<std::pair<ROOT::Math::XYZVector, double>> field_free_jump(RandomNumberGenerator& random_generator,
+                                                                                CarrierType type,
+                                                                                const ROOT::Math::XYZPoint& position,
+                                                                                double doping,
+                                                                                double timestep,
+                                                                                double remaining_time) const;
+
+        /**
+         * @brief Calculate the time step for the next step of a charge carrier set
+         * @param timestep    Time step of the last step
+         * @param uncertainty Spatial uncertainty of the last step from the embedded error estimate
+         * @param last_error  Relative error of the previous step, updated with the error of the last step
+         * @param position_z  Local z coordinate of the set after the last step
+         * @param drift_z     Drift of the set along the z axis in the last step
+         * @return Time step limited to the configured minimum and maximum
+         */
+        double
+        next_timestep(double timestep, double uncertainty, double& last_error, double position_z, double drift_z) const;
+
+        /**
+         * @brief Check if a charge carrier has left the sensor or reached an implant
+         * @param position Local position of the charge carrier
+         * @return True if the charge carrier is halted at this position, false otherwise
+         */
+        bool halted(const ROOT::Math::XYZPoint& position) const;
+
+        /**
+         * @brief Check if a set of charge carriers recombines during the last step
+         * @param random_generator Reference to the random number generator to draw from
+         * @param type             Type of the charge carriers
+         * @param doping           Doping concentration at the position of the set
+         * @param timestep         Time step of the last step
+         * @param budget           Remaining time to recombination in units of the lifetime if sampled once per set
+         * @return True if the set has recombined
+         */
+        bool recombined(
+            RandomNumberGenerator& random_generator, CarrierType type, double doping, double timestep, double& budget) const;
+
+        /**
+         * @brief Check if a set of charge carriers is trapped during the last step
+         * @param random_generator Reference to the random number generator to draw from
+         * @param type             Type of the charge carriers
+         * @param efield_mag       Magnitude of the electric field at the position of the set
+         * @param timestep         Time step of the last step
+         * @param budget           Remaining time to trapping in units of the trapping time if sampled once per set
+         * @return True if the set has been trapped
+         */
+        bool trapped(RandomNumberGenerator& random_generator,
+                     CarrierType type,
+                     double efield_mag,
+                     double timestep,
+                     double& budget) const;
+
         // Local copies of configuration parameters to avoid costly lookup:
         double temperature_{}, timestep_min_{}, timestep_max_{}, timestep_start_{}, integration_time_{},
             target_spatial_precision_{}, output_plots_step_{};
         bool output_plots_{}, output_linegraphs_{}, output_linegraphs_collected_{}, output_linegraphs_recombined_{},
-            output_linegraphs_trapped_{}, output_animations_{};
+            output_linegraphs_trapped_{}, output_animations_{}, output_trajectories_{}, record_trajectories_{};
+        LineGraph::PlotSettings plot_settings_;
         bool propagate_electrons_{}, propagate_holes_{};
+        bool sample_carrier_lifetimes_{};
+        bool precompute_velocity_{};
+        bool precompute_multiplication_{};
+        bool batch_sampling_{};
+        bool prefetch_fields_{};
         unsigned int charge_per_step_{};
         unsigned int max_charge_groups_{};
         unsigned int max_multiplication_level_{};
+        unsigned int batch_size_{};
+        unsigned int propagation_threads_{};
+        unsigned int propagation_charge_per_thread_{};
+        unsigned int merge_interval_{};
+        double merge_distance_{}, merge_time_{};
+        bool offload_propagation_{};
+        bool sort_deposits_{};
+        bool field_free_sampling_{};
+        double field_free_threshold_{};
+        TimestepController timestep_controller_{};
+        PropagationPrecision propagation_precision_{};
+        bool validate_precision_{};
 
         // Models for electron and hole mobility and lifetime
         Mobility mobility_;
@@ -123,6 +364,53 @@ namespace allpix {
         Trapping trapping_;
         Detrapping detrapping_;
 
+        /**
+         * @brief Drift velocity and diffusion constant of one carrier type, precomputed on the grid of the electric field
+         */
+        struct CarrierGrids {
+            DetectorField<ROOT::Math::XYZVector, 3> velocity;
+            DetectorField<double, 1> diffusion;
+        };
+        CarrierGrids electron_grids_;
+        CarrierGrids hole_grids_;
+
+        /**
+         * @brief Regular grid of cells over the sensor or over the unit cell of the pixel at the matrix center if all fields
+         * repeat with the pixel pitch
+         */
+        struct SensorMap {
+            std::array<size_t, 3> bins{};
+            ROOT::Math::XYZPoint origin;
+            ROOT::Math::XYZVector size;
+            bool periodic{};
+
+            /**
+             * @brief Find the cell of a position, positions are wrapped into the unit cell of periodic maps
+             * @param position Local position in the sensor
+             * @return Index of the cell
+             */
+            size_t index(const ROOT::Math::XYZPoint& position) const;
+        };
+
+        /**
+         * @brief Distance to the closest region with electric field above the threshold or an implant
+         */
+        struct FieldFreeMap : SensorMap {
+            std::vector<float> distance;
+        };
+        FieldFreeMap field_free_map_;
+
+        /**
+         * @brief Cells in which the electric field can exceed the impact ionization threshold, and the gain factor of both
+         * carrier types tabulated over the electric field magnitude from the threshold to the maximum field in the cells
+         */
+        struct MultiplicationMap : SensorMap {
+            std::vector<uint8_t> active;
+            double field_min{}, field_max{}, field_step{};
+            std::array<std::vector<double>, 2> gain_factor;
+        };
+        MultiplicationMap multiplication_map_;
+
         // Precalculated value for Boltzmann constant:
         double boltzmann_kT_;
 
@@ -133,11 +421,24 @@ namespace allpix {
         // Magnetic field
         bool has_magnetic_field_;
 
+        // Propagation on the offload device if requested and supported
+        std::unique_ptr<DevicePropagation> device_propagation_;
+
+        // Writer of the recorded trajectories if requested
+        std::unique_ptr<LineGraph::TrajectoryWriter> trajectory_writer_;
+
         // Statistical information
         std::atomic<unsigned int> total_propagated_charges_{};
         std::atomic<unsigned int> total_steps_{};
         std::atomic<long unsigned int> total_time_picoseconds_{};
         std::atomic<unsigned int> total_deposits_{}, deposits_exceeding_max_groups_{};
+        mutable std::atomic<long unsigned int> total_merged_groups_{}, total_merged_charges_{};
+        mutable std::atomic<long unsigned int> merge_shift_nanometers_{}, merge_delay_picoseconds_{};
+        mutable std::atomic<unsigned int> validated_groups_{}, validated_state_mismatches_{};
+
+        // Indices of the profiler counters and timers
+        size_t groups_counter_{}, steps_counter_{}, recombined_counter_{}, trapped_counter_{}, propagation_timer_{};
+
         Histogram<TH1D> step_length_histo_;
         Histogram<TH1D> drift_time_histo_;
         Histogram<TH1D> uncertainty_histo_;
@@ -155,6 +456,9 @@ namespace allpix {
         Histogram<TH1D> multiplication_depth_histo_;
         Histogram<TProfile> gain_e_vs_x_, gain_e_vs_y_, gain_e_vs_z_;
         Histogram<TProfile> gain_h_vs_x_, gain_h_vs_y_, gain_h_vs_z_;
+        Histogram<TH1D> precision_deviation_histo_;
+        Histogram<TH1D> collection_time_double_histo_;
+        Histogram<TH1D> collection_time_single_histo_;
     };
 
 } // namespace allpix
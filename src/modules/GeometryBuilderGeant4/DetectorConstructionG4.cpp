@@ -12,6 +12,9 @@
 
 #include "DetectorConstructionG4.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -49,7 +52,55 @@
 
 using namespace allpix;
 
-DetectorConstructionG4::DetectorConstructionG4(GeometryManager* geo_manager) : geo_manager_(geo_manager) {}
+namespace {
+    /**
+     * @brief Volume of a single bump within the bump layer
+     * @param sphere_radius Radius of the sphere of the bump
+     * @param cylinder_radius Radius of the cylinder of the bump
+     * @param height Height of the cylinder and of the bump layer, both centered on the sphere
+     *
+     * The bump is the union of the sphere and the cylinder. Parts of the sphere outside of the layer are not counted, as no
+     * particle is tracked through them.
+     */
+    double bump_volume(double sphere_radius, double cylinder_radius, double height) {
+        // Volume of the sphere between the heights a and b above its center
+        auto slice = [sphere_radius](double a, double b) {
+            return M_PI * (sphere_radius * sphere_radius * (b - a) - (b * b * b - a * a * a) / 3.);
+        };
+        auto cylinder_area = M_PI * cylinder_radius * cylinder_radius;
+
+        // The cross section of the intersection is the cylinder up to z_cut and the sphere above
+        auto z_max = std::min(sphere_radius, height / 2.);
+        auto z_cut = std::min(
+            std::sqrt(std::max(sphere_radius * sphere_radius - cylinder_radius * cylinder_radius, 0.)), z_max);
+        auto intersection = 2. * (cylinder_area * z_cut + slice(z_cut, z_max));
+
+        return 2. * slice(0., z_max) + cylinder_area * height - intersection;
+    }
+
+    /**
+     * @brief Register an external object of one detector also for another detector
+     * @param geo_manager Geometry manager holding the external objects
+     * @param source Name of the detector the object has been built for
+     * @param target Name of the detector sharing the object
+     * @param id Identifier of the external object
+     */
+    template <typename T>
+    void share_external_object(GeometryManager* geo_manager,
+                               const std::string& source,
+                               const std::string& target,
+                               const std::string& id) {
+        auto object = geo_manager->getExternalObject<T>(source, id);
+        if(object != nullptr) {
+            geo_manager->setExternalObject(target, id, object);
+        }
+    }
+} // namespace
+
+DetectorConstructionG4::DetectorConstructionG4(GeometryManager* geo_manager,
+                                               bool homogenize_bumps,
+                                               bool share_model_volumes)
+    : geo_manager_(geo_manager), homogenize_bumps_(homogenize_bumps), share_model_volumes_(share_model_volumes) {}
 
 void DetectorConstructionG4::build(const std::shared_ptr<G4LogicalVolume>& world_log) {
 
@@ -62,7 +113,12 @@ void DetectorConstructionG4::build(const std::shared_ptr<G4LogicalVolume>& world
     std::vector<std::shared_ptr<Detector>> detectors = geo_manager_->getDetectors();
     LOG(TRACE) << "Building " << detectors.size() << " device(s)";
 
-    for(auto& detector : detectors) {
+    // Name of the first detector built for every model, whose volumes are reused when sharing the model volumes
+    std::map<const DetectorModel*, std::string> built_models;
+
+    for(size_t detector_index = 0; detector_index < detectors.size(); ++detector_index) {
+        auto& detector = detectors[detector_index];
+
         // Material budget:
         double total_material_budget = 0;
 
@@ -76,51 +132,62 @@ void DetectorConstructionG4::build(const std::shared_ptr<G4LogicalVolume>& world
         LOG(TRACE) << " Chip dimensions: " << Units::display(model->getChipSize(), {"mm", "um"});
         LOG(DEBUG) << " Global position and orientation of the detector:";
 
-        // Build a radial wrapper if radial_strip model is used, otherwise build a box wrapper
+        // Reuse the volumes of the first detector of the same model if requested
         auto radial_model = std::dynamic_pointer_cast<RadialStripDetectorModel>(model);
-        if(radial_model != nullptr) {
-            // Create the base cylindrical section; wider than the requested dimensions to account for the stereo angle
-            auto* wrapper_base_tub = new G4Tubs("wrapper_base" + name,
-                                                radial_model->getRowRadius(0),
-                                                radial_model->getRowRadius(radial_model->getNPixels().y()),
-                                                radial_model->getSize().z() / 2,
-                                                90 * CLHEP::deg - radial_model->getRowAngleMax() / 2 * 1.5,
-                                                radial_model->getRowAngleMax() * 1.5);
-
-            // Create the angled cylindrical section coming from the focal point; longer than the requested dimensions to
-            // account for the stereo angle
-            auto* wrapper_angled_tub = new G4Tubs("wrapper_angled" + name,
-                                                  radial_model->getRowRadius(0) * 0.95,
-                                                  radial_model->getRowRadius(radial_model->getNPixels().y()) * 1.05,
-                                                  radial_model->getSize().z() / 2,
-                                                  90.0 * CLHEP::deg - radial_model->getRowAngleMax() / 2,
-                                                  radial_model->getRowAngleMax());
-
-            // Get the requested stereo angle
-            auto stereo_angle = radial_model->getStereoAngle();
-            LOG(TRACE) << "Applying stereo angle of " << Units::display(stereo_angle, "mrad");
-
-            // Transformation for the angled cylindrical section
-            auto angled_tub_rot = G4RotationMatrix();
-            angled_tub_rot.rotateZ(stereo_angle);
-            auto center_radius = radial_model->getCenterRadius();
-            auto angled_tub_pos =
-                G4ThreeVector(center_radius * sin(stereo_angle), -center_radius * (1 - cos(stereo_angle)), 0);
-            auto angled_tub_trf = G4Transform3D(angled_tub_rot, angled_tub_pos);
-            auto wrapper_final_tub = make_shared_no_delete<G4IntersectionSolid>(
-                "wrapper_" + name, wrapper_base_tub, wrapper_angled_tub, angled_tub_trf);
-            solids_.push_back(wrapper_final_tub);
+        auto built_model = built_models.find(model.get());
+        auto shared = share_model_volumes_ && built_model != built_models.end();
+
+        std::shared_ptr<G4LogicalVolume> wrapper_log;
+        if(shared) {
+            LOG(DEBUG) << " Sharing the volumes of detector " << built_model->second;
+            wrapper_log = geo_manager_->getExternalObject<G4LogicalVolume>(built_model->second, "wrapper_log");
+            geo_manager_->setExternalObject(name, "wrapper_log", wrapper_log);
         } else {
-            // Create the wrapper box
-            auto wrapper_box = make_shared_no_delete<G4Box>(
-                "wrapper_" + name, model->getSize().x() / 2.0, model->getSize().y() / 2.0, model->getSize().z() / 2.0);
-            solids_.push_back(wrapper_box);
-        }
+            // Build a radial wrapper if radial_strip model is used, otherwise build a box wrapper
+            if(radial_model != nullptr) {
+                // Create the base cylindrical section; wider than the requested dimensions to account for the stereo angle
+                auto* wrapper_base_tub = new G4Tubs("wrapper_base" + name,
+                                                    radial_model->getRowRadius(0),
+                                                    radial_model->getRowRadius(radial_model->getNPixels().y()),
+                                                    radial_model->getSize().z() / 2,
+                                                    90 * CLHEP::deg - radial_model->getRowAngleMax() / 2 * 1.5,
+                                                    radial_model->getRowAngleMax() * 1.5);
+
+                // Create the angled cylindrical section coming from the focal point; longer than the requested dimensions to
+                // account for the stereo angle
+                auto* wrapper_angled_tub = new G4Tubs("wrapper_angled" + name,
+                                                      radial_model->getRowRadius(0) * 0.95,
+                                                      radial_model->getRowRadius(radial_model->getNPixels().y()) * 1.05,
+                                                      radial_model->getSize().z() / 2,
+                                                      90.0 * CLHEP::deg - radial_model->getRowAngleMax() / 2,
+                                                      radial_model->getRowAngleMax());
+
+                // Get the requested stereo angle
+                auto stereo_angle = radial_model->getStereoAngle();
+                LOG(TRACE) << "Applying stereo angle of " << Units::display(stereo_angle, "mrad");
+
+                // Transformation for the angled cylindrical section
+                auto angled_tub_rot = G4RotationMatrix();
+                angled_tub_rot.rotateZ(stereo_angle);
+                auto center_radius = radial_model->getCenterRadius();
+                auto angled_tub_pos =
+                    G4ThreeVector(center_radius * sin(stereo_angle), -center_radius * (1 - cos(stereo_angle)), 0);
+                auto angled_tub_trf = G4Transform3D(angled_tub_rot, angled_tub_pos);
+                auto wrapper_final_tub = make_shared_no_delete<G4IntersectionSolid>(
+                    "wrapper_" + name, wrapper_base_tub, wrapper_angled_tub, angled_tub_trf);
+                solids_.push_back(wrapper_final_tub);
+            } else {
+                // Create the wrapper box
+                auto wrapper_box = make_shared_no_delete<G4Box>(
+                    "wrapper_" + name, model->getSize().x() / 2.0, model->getSize().y() / 2.0, model->getSize().z() / 2.0);
+                solids_.push_back(wrapper_box);
+            }
 
-        // Create the wrapper logical volume
-        auto wrapper_log = make_shared_no_delete<G4LogicalVolume>(
-            solids_.back().get(), materials.get("world_material"), "wrapper_" + name + "_log");
-        geo_manager_->setExternalObject(name, "wrapper_log", wrapper_log);
+            // Create the wrapper logical volume
+            wrapper_log = make_shared_no_delete<G4LogicalVolume>(
+                solids_.back().get(), materials.get("world_material"), "wrapper_" + name + "_log");
+            geo_manager_->setExternalObject(name, "wrapper_log", wrapper_log);
+        }
 
         // Get position and orientation
         auto position = detector->getPosition();
@@ -154,11 +221,38 @@ void DetectorConstructionG4::build(const std::shared_ptr<G4LogicalVolume>& world
             throw ModuleError("Cannot find world volume");
         }
 
-        // Place the wrapper
-        auto wrapper_phys = make_shared_no_delete<G4PVPlacement>(
-            transform_phys, wrapper_log.get(), "wrapper_" + name + "_phys", world_log.get(), false, 0, true);
+        // Place the wrapper, the copy number identifies the detector if the wrapper is shared with other detectors
+        auto wrapper_phys = make_shared_no_delete<G4PVPlacement>(transform_phys,
+                                                                 wrapper_log.get(),
+                                                                 "wrapper_" + name + "_phys",
+                                                                 world_log.get(),
+                                                                 false,
+                                                                 static_cast<G4int>(detector_index),
+                                                                 true);
         geo_manager_->setExternalObject(name, "wrapper_phys", wrapper_phys);
 
+        // Register the volumes placed in the shared wrapper also for this detector
+        if(shared) {
+            const auto& source = built_model->second;
+            for(const auto& id : {"sensor_log", "pixel_log", "chip_log", "bumps_wrapper_log", "bumps_cell_log"}) {
+                share_external_object<G4LogicalVolume>(geo_manager_, source, name, id);
+            }
+            for(const auto& id : {"sensor_phys", "chip_phys", "bumps_wrapper_phys"}) {
+                share_external_object<G4PVPlacement>(geo_manager_, source, name, id);
+            }
+            for(const auto& id : {"pixel_param", "bumps_param"}) {
+                share_external_object<G4VPVParameterisation>(geo_manager_, source, name, id);
+            }
+            share_external_object<G4PVParameterised>(geo_manager_, source, name, "bumps_param_phys");
+            share_external_object<std::vector<std::shared_ptr<G4LogicalVolume>>>(geo_manager_, source, name, "supports_log");
+            share_external_object<std::vector<std::shared_ptr<G4PVPlacement>>>(geo_manager_, source, name, "supports_phys");
+            share_external_object<double>(geo_manager_, source, name, "material_budget");
+
+            LOG(TRACE) << " Placed shared volumes for detector " << detector->getName() << " successfully";
+            continue;
+        }
+        built_models.emplace(model.get(), name);
+
         LOG(DEBUG) << " Center of the geometry parts relative to the detector wrapper geometric center:";
 
         /**
@@ -376,9 +470,34 @@ void DetectorConstructionG4::build(const std::shared_ptr<G4LogicalVolume>& world
                 "bump_box_" + name, model->getSensorSize().x() / 2.0, model->getSensorSize().y() / 2.0, bump_height / 2.);
             solids_.push_back(bump_box);
 
+            // Add bump material equivalent to uniform solder layer to total material budget:
+            auto radius = std::max(bump_sphere_radius, bump_cylinder_radius);
+            auto relativeArea = M_PI * radius * radius / model->getPixelSize().x() / model->getPixelSize().y();
+            total_material_budget += (relativeArea * bump_height / materials.get("solder")->GetRadlen());
+
+            // Replace the individual bumps by a mixture of solder and world material with the same total mass if requested
+            auto* bumps_material = materials.get("world_material");
+            if(homogenize_bumps_) {
+                auto solder_fraction = static_cast<double>(model->getNPixels().x() * model->getNPixels().y()) *
+                                       bump_volume(bump_sphere_radius, bump_cylinder_radius, bump_height) /
+                                       (model->getSensorSize().x() * model->getSensorSize().y() * bump_height);
+                if(solder_fraction > 1.) {
+                    throw ModuleError("Bump bonds of detector '" + name + "' do not fit into the sensor area");
+                }
+
+                auto* solder = materials.get("solder");
+                auto solder_density = solder_fraction * solder->GetDensity();
+                auto world_density = (1. - solder_fraction) * bumps_material->GetDensity();
+                auto* mixture = new G4Material("bumps_homogenized_" + name, solder_density + world_density, 2);
+                mixture->AddMaterial(solder, solder_density / (solder_density + world_density));
+                mixture->AddMaterial(bumps_material, world_density / (solder_density + world_density));
+                bumps_material = mixture;
+                LOG(DEBUG) << "  - Bumps homogenized with a solder volume fraction of " << solder_fraction;
+            }
+
             // Create the logical wrapper volume
             auto bumps_wrapper_log = make_shared_no_delete<G4LogicalVolume>(
-                bump_box.get(), materials.get("world_material"), "bumps_wrapper_" + name + "_log");
+                bump_box.get(), bumps_material, "bumps_wrapper_" + name + "_log");
             geo_manager_->setExternalObject(name, "bumps_wrapper_log", bumps_wrapper_log);
 
             // Place the general bumps volume
@@ -396,46 +515,43 @@ void DetectorConstructionG4::build(const std::shared_ptr<G4LogicalVolume>& world
                                                                            true);
             geo_manager_->setExternalObject(name, "bumps_wrapper_phys", bumps_wrapper_phys);
 
-            // Create the individual bump solid
-            auto bump_sphere = make_shared_no_delete<G4Sphere>(
-                "bumps_" + name + "_sphere", 0, bump_sphere_radius, 0, 360 * CLHEP::deg, 0, 360 * CLHEP::deg);
-            solids_.push_back(bump_sphere);
-            auto bump_tube = make_shared_no_delete<G4Tubs>(
-                "bumps_" + name + "_tube", 0., bump_cylinder_radius, bump_height / 2., 0., 360 * CLHEP::deg);
-            solids_.push_back(bump_tube);
-            auto bump = make_shared_no_delete<G4UnionSolid>("bumps_" + name, bump_sphere.get(), bump_tube.get());
-            solids_.push_back(bump);
-
-            // Create the logical volume for the individual bumps
-            auto bumps_cell_log =
-                make_shared_no_delete<G4LogicalVolume>(bump.get(), materials.get("solder"), "bumps_" + name + "_log");
-            geo_manager_->setExternalObject(name, "bumps_cell_log", bumps_cell_log);
-
-            // Add bump material equivalent to uniform solder layer to total material budget:
-            auto radius = std::max(hybrid_chip->getBumpSphereRadius(), hybrid_chip->getBumpCylinderRadius());
-            auto relativeArea = M_PI * radius * radius / model->getPixelSize().x() / model->getPixelSize().y();
-            total_material_budget +=
-                (relativeArea * hybrid_chip->getBumpHeight() / bumps_cell_log->GetMaterial()->GetRadlen());
-
-            // Place the bump bonds grid
-            std::shared_ptr<G4VPVParameterisation> bumps_param = std::make_shared<Parameterization2DG4>(
-                model->getNPixels().x(),
-                model->getPixelSize().x(),
-                model->getPixelSize().y(),
-                -(model->getNPixels().x() * model->getPixelSize().x()) / 2.0 + (hybrid_chip->getBumpsOffset().x()),
-                -(model->getNPixels().y() * model->getPixelSize().y()) / 2.0 + (hybrid_chip->getBumpsOffset().y()),
-                0);
-            geo_manager_->setExternalObject(name, "bumps_param", bumps_param);
-
-            std::shared_ptr<G4PVParameterised> bumps_param_phys =
-                std::make_shared<ParameterisedG4>("bumps_" + name + "_phys",
-                                                  bumps_cell_log.get(),
-                                                  bumps_wrapper_log.get(),
-                                                  kUndefined,
-                                                  model->getNPixels().x() * model->getNPixels().y(),
-                                                  bumps_param.get(),
-                                                  false);
-            geo_manager_->setExternalObject(name, "bumps_param_phys", std::move(bumps_param_phys));
+            // Place the individual bumps unless the layer is homogenized
+            if(!homogenize_bumps_) {
+                // Create the individual bump solid
+                auto bump_sphere = make_shared_no_delete<G4Sphere>(
+                    "bumps_" + name + "_sphere", 0, bump_sphere_radius, 0, 360 * CLHEP::deg, 0, 360 * CLHEP::deg);
+                solids_.push_back(bump_sphere);
+                auto bump_tube = make_shared_no_delete<G4Tubs>(
+                    "bumps_" + name + "_tube", 0., bump_cylinder_radius, bump_height / 2., 0., 360 * CLHEP::deg);
+                solids_.push_back(bump_tube);
+                auto bump = make_shared_no_delete<G4UnionSolid>("bumps_" + name, bump_sphere.get(), bump_tube.get());
+                solids_.push_back(bump);
+
+                // Create the logical volume for the individual bumps
+                auto bumps_cell_log =
+                    make_shared_no_delete<G4LogicalVolume>(bump.get(), materials.get("solder"), "bumps_" + name + "_log");
+                geo_manager_->setExternalObject(name, "bumps_cell_log", bumps_cell_log);
+
+                // Place the bump bonds grid
+                std::shared_ptr<G4VPVParameterisation> bumps_param = std::make_shared<Parameterization2DG4>(
+                    model->getNPixels().x(),
+                    model->getPixelSize().x(),
+                    model->getPixelSize().y(),
+                    -(model->getNPixels().x() * model->getPixelSize().x()) / 2.0 + (hybrid_chip->getBumpsOffset().x()),
+                    -(model->getNPixels().y() * model->getPixelSize().y()) / 2.0 + (hybrid_chip->getBumpsOffset().y()),
+                    0);
+                geo_manager_->setExternalObject(name, "bumps_param", bumps_param);
+
+                std::shared_ptr<G4PVParameterised> bumps_param_phys =
+                    std::make_shared<ParameterisedG4>("bumps_" + name + "_phys",
+                                                      bumps_cell_log.get(),
+                                                      bumps_wrapper_log.get(),
+                                                      kUndefined,
+                                                      model->getNPixels().x() * model->getNPixels().y(),
+                                                      bumps_param.get(),
+                                                      false);
+                geo_manager_->setExternalObject(name, "bumps_param_phys", std::move(bumps_param_phys));
+            }
         }
 
         // Store the total material budget:
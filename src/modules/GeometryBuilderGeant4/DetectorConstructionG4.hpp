@@ -30,8 +30,12 @@ namespace allpix {
         /**
          * @brief Constructs geometry construction module
          * @param geo_manager Pointer to the geometry manager, containing the detectors
+         * @param homogenize_bumps Build the bump bonds as a single layer of averaged material instead of individual bumps
+         * @param share_model_volumes Build the logical volumes once per detector model and only place them per detector
          */
-        explicit DetectorConstructionG4(GeometryManager* geo_manager);
+        explicit DetectorConstructionG4(GeometryManager* geo_manager,
+                                        bool homogenize_bumps = false,
+                                        bool share_model_volumes = false);
 
         /**
          * @brief Constructs the world geometry with all detectors
@@ -41,6 +45,8 @@ namespace allpix {
 
     private:
         GeometryManager* geo_manager_;
+        bool homogenize_bumps_;
+        bool share_model_volumes_;
 
         // Storage of internal objects
         std::vector<std::shared_ptr<G4VSolid>> solids_;
@@ -13,9 +13,17 @@
 #include "GeometryConstructionG4.hpp"
 #include "MaterialManager.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <functional>
+#include <iomanip>
 #include <memory>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include <G4Box.hh>
 #include <G4LogicalVolume.hh>
@@ -46,7 +54,8 @@ using namespace allpix;
 
 GeometryConstructionG4::GeometryConstructionG4(GeometryManager* geo_manager, Configuration& config)
     : geo_manager_(geo_manager), config_(config) {
-    detector_builder_ = std::make_unique<DetectorConstructionG4>(geo_manager_);
+    detector_builder_ = std::make_unique<DetectorConstructionG4>(
+        geo_manager_, config_.get<bool>("homogenize_bumps", false), config_.get<bool>("share_model_volumes", false));
     passive_builder_ = std::make_unique<PassiveMaterialConstructionG4>(geo_manager_);
     passive_builder_->registerVolumes();
 }
@@ -128,15 +137,127 @@ G4VPhysicalVolume* GeometryConstructionG4::Construct() {
     return world_phys_.get();
 }
 
+/**
+ * @brief Calculate a hash of the constructed geometry and of the settings of the overlap check
+ * @param resolution Number of points sampled on the surface of every volume
+ * @param tolerance Tolerance of the overlap check
+ * @param check_bumps Whether the copies of the bump bond grids are checked
+ * @return Hexadecimal representation of the hash
+ *
+ * The hash covers the name, placement, material and full solid description of every physical volume, such that any change
+ * of the geometry results in a different hash.
+ */
+static std::string geometry_hash(int resolution, double tolerance, bool check_bumps) {
+    std::ostringstream description;
+    description << resolution << " " << tolerance << " " << check_bumps << std::endl;
+    for(auto* volume : *G4PhysicalVolumeStore::GetInstance()) {
+        auto* logical = volume->GetLogicalVolume();
+        description << volume->GetName() << " " << logical->GetName() << " " << logical->GetMaterial()->GetName() << " "
+                    << (volume->GetMotherLogical() != nullptr ? volume->GetMotherLogical()->GetName() : "") << " "
+                    << volume->GetTranslation() << " " << volume->GetMultiplicity() << std::endl;
+        if(volume->GetRotation() != nullptr) {
+            description << *volume->GetRotation() << std::endl;
+        }
+        const auto* param = dynamic_cast<const Parameterization2DG4*>(volume->GetParameterisation());
+        if(param != nullptr) {
+            description << param->getTranslation(0) << " " << param->getTranslation(volume->GetMultiplicity() - 1) << " "
+                        << param->getDivisionsX() << std::endl;
+        }
+        logical->GetSolid()->StreamInfo(description);
+    }
+
+    std::ostringstream hash;
+    hash << std::hex << std::setw(16) << std::setfill('0') << std::hash<std::string>()(description.str());
+    return hash.str();
+}
+
+/**
+ * The placed volumes are checked individually, the copies of the bump bond grids are split into ranges checked against
+ * their neighbours only. All checks are distributed to the configured number of threads.
+ */
 void GeometryConstructionG4::check_overlaps() const {
+    if(!config_.get<bool>("check_overlaps", true)) {
+        LOG(INFO) << "Not checking for overlapping volumes";
+        return;
+    }
+
+    auto resolution = config_.get<int>("overlap_check_resolution", 1000);
+    if(resolution <= 0) {
+        throw InvalidValueError(config_, "overlap_check_resolution", "number of sampled points needs to be positive");
+    }
+    auto tolerance = config_.get<double>("overlap_check_tolerance", 0.);
+    auto check_bumps = config_.get<bool>("overlap_check_bumps", false);
+    auto threads = config_.get<unsigned int>("overlap_check_threads", std::max(std::thread::hardware_concurrency(), 1u));
+    if(threads == 0) {
+        throw InvalidValueError(config_, "overlap_check_threads", "at least one thread is required");
+    }
+
+    // Skip the check if this geometry has been found free of overlaps before
+    std::string hash;
+    if(config_.has("overlap_check_cache")) {
+        hash = geometry_hash(resolution, tolerance, check_bumps);
+        std::ifstream cache(config_.getPath("overlap_check_cache"));
+        std::string line;
+        while(std::getline(cache, line)) {
+            if(line == hash) {
+                LOG(INFO) << "Geometry " << hash << " has been validated before, not checking for overlapping volumes";
+                return;
+            }
+        }
+    }
+
+    // Split the check into tasks for every placed volume and for ranges of copies of the bump bond grids
     G4PhysicalVolumeStore* phys_volume_store = G4PhysicalVolumeStore::GetInstance();
-    LOG(TRACE) << "Checking overlaps";
-    bool overlapFlag = false;
+    std::vector<std::function<bool()>> tasks;
+    for(auto* volume : (*phys_volume_store)) {
+        auto* solid = volume->GetLogicalVolume()->GetSolid();
+
+        auto* parameterised = dynamic_cast<ParameterisedG4*>(volume);
+        if(parameterised == nullptr) {
+            // Sample the surface once before checking in parallel, some solids only prepare the sampling on first use
+            solid->GetPointOnSurface();
+            tasks.emplace_back(
+                [volume, resolution, tolerance]() { return volume->CheckOverlaps(resolution, tolerance, false); });
+            continue;
+        }
+        if(!check_bumps) {
+            continue;
+        }
+
+        // All copies share the same solid, such that its surface is sampled only once
+        auto points = std::make_shared<std::vector<G4ThreeVector>>();
+        for(int point = 0; point < resolution; ++point) {
+            points->push_back(solid->GetPointOnSurface());
+        }
+        auto copies = parameterised->GetMultiplicity();
+        auto range = std::max(copies / static_cast<int>(4 * threads), 1);
+        for(int first = 0; first < copies; first += range) {
+            auto last = std::min(first + range, copies);
+            tasks.emplace_back([parameterised, points, first, last, tolerance]() {
+                return parameterised->checkOverlaps(*points, first, last, tolerance) != 0;
+            });
+        }
+    }
+
+    auto workers = std::min<size_t>(threads, tasks.size());
+    LOG(TRACE) << "Checking overlaps in " << tasks.size() << " volumes and ranges of copies with " << workers << " threads";
 
     auto current_level = G4LoggingDestination::getG4coutReportingLevel();
     G4LoggingDestination::setG4coutReportingLevel(LogLevel::ERROR);
-    for(auto* volume : (*phys_volume_store)) {
-        overlapFlag = volume->CheckOverlaps(1000, 0., false) || overlapFlag;
+    std::atomic<size_t> next_task{0};
+    std::atomic<bool> overlapFlag{false};
+    std::vector<std::thread> worker_threads;
+    for(size_t worker = 0; worker < workers; ++worker) {
+        worker_threads.emplace_back([&]() {
+            for(auto task = next_task++; task < tasks.size(); task = next_task++) {
+                if(tasks[task]()) {
+                    overlapFlag = true;
+                }
+            }
+        });
+    }
+    for(auto& thread : worker_threads) {
+        thread.join();
     }
     G4LoggingDestination::setG4coutReportingLevel(current_level);
 
@@ -144,6 +265,12 @@ void GeometryConstructionG4::check_overlaps() const {
         LOG(ERROR) << "Overlapping volumes detected.";
     } else {
         LOG(INFO) << "No overlapping volumes detected.";
+
+        // Remember the validated geometry
+        if(!hash.empty()) {
+            std::ofstream cache(config_.getPath("overlap_check_cache"), std::ios_base::app);
+            cache << hash << std::endl;
+        }
     }
 }
 
@@ -183,9 +310,11 @@ void GeometryConstructionG4::verify_transforms() const {
     for(auto& detector : geo_manager_->getDetectors()) {
         auto local = detector->getLocalPosition(static_cast<ROOT::Math::XYZPoint>(global));
 
-        // Obtain physical sensor volume, its transformation to the world volume and apply to global test vector:
+        // Obtain the physical wrapper volume, its transformation to the world volume and apply to global test vector. The
+        // sensor is placed without rotation in the wrapper, which might be shared with other detectors of the same model:
+        auto wrapper = geo_manager_->getExternalObject<G4PVPlacement>(detector->getName(), "wrapper_phys");
         auto sensor = geo_manager_->getExternalObject<G4PVPlacement>(detector->getName(), "sensor_phys");
-        auto coord_g4 = get_world_transform(sensor.get()).TransformPoint(global);
+        auto coord_g4 = get_world_transform(wrapper.get()).TransformPoint(global) - sensor->GetTranslation();
 
         // Apply translation to correct for volume origin not corresponding to volume center
         coord_g4 -= *geo_manager_->getExternalObject<G4ThreeVector>(detector->getName(), "model_translation");
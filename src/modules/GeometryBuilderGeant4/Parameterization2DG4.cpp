@@ -11,8 +11,16 @@
 
 #include "Parameterization2DG4.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <memory>
 
+#include <G4LogicalVolume.hh>
+#include <G4VSolid.hh>
+
+#include "core/utils/log.h"
+#include "tools/geant4/geant4.h"
+
 using namespace allpix;
 
 Parameterization2DG4::Parameterization2DG4(
@@ -20,14 +28,18 @@ Parameterization2DG4::Parameterization2DG4(
     : div_x_(div_x), size_x_(size_x), size_y_(size_y), offset_x_(offset_x), offset_y_(offset_y), pos_z_(pos_z) {}
 
 void Parameterization2DG4::ComputeTransformation(const G4int copy_id, G4VPhysicalVolume* phys_volume) const {
+    phys_volume->SetTranslation(getTranslation(copy_id));
+    phys_volume->SetRotation(nullptr);
+}
+
+G4ThreeVector Parameterization2DG4::getTranslation(int copy_id) const {
     auto idx_x = copy_id % div_x_;
     auto idx_y = copy_id / div_x_;
 
     auto pos_x = (idx_x + 0.5) * size_x_ + offset_x_;
     auto pos_y = (idx_y + 0.5) * size_y_ + offset_y_;
 
-    phys_volume->SetTranslation(G4ThreeVector(pos_x, pos_y, pos_z_));
-    phys_volume->SetRotation(nullptr);
+    return {pos_x, pos_y, pos_z_};
 }
 
 ParameterisedG4::ParameterisedG4(const G4String& name,
@@ -48,3 +60,69 @@ bool ParameterisedG4::CheckOverlaps(int res, double tol, bool verbose, int max_e
     }
     return false;
 }
+
+unsigned int ParameterisedG4::checkOverlaps(const std::vector<G4ThreeVector>& points,
+                                            int first,
+                                            int last,
+                                            double tolerance) const {
+    const auto* param = dynamic_cast<const Parameterization2DG4*>(GetParameterisation());
+    if(param == nullptr) {
+        return 0;
+    }
+    auto* solid = GetLogicalVolume()->GetSolid();
+    auto* mother_solid = GetMotherLogical()->GetSolid();
+
+    // Copies further apart on the grid than the extent of their solid cannot overlap
+    G4ThreeVector min;
+    G4ThreeVector max;
+    solid->BoundingLimits(min, max);
+    auto size = param->getElementSize();
+    auto reach_x = static_cast<int>(std::ceil((max.x() - min.x()) / size.x()));
+    auto reach_y = static_cast<int>(std::ceil((max.y() - min.y()) / size.y()));
+    auto copies = GetMultiplicity();
+    auto div_x = param->getDivisionsX();
+    auto div_y = (copies + div_x - 1) / div_x;
+
+    unsigned int overlaps = 0;
+    for(int copy = first; copy < last; ++copy) {
+        auto translation = param->getTranslation(copy);
+
+        // Check if the surface of this copy is contained in the mother volume
+        bool overlap = false;
+        for(const auto& point : points) {
+            auto mother_point = point + translation;
+            if(mother_solid->Inside(mother_point) == kOutside && mother_solid->DistanceToIn(mother_point) > tolerance) {
+                LOG(DEBUG) << "Copy " << copy << " of " << GetName() << " protrudes from its mother volume at "
+                           << Units::display(mother_point, {"mm", "um"});
+                overlap = true;
+                break;
+            }
+        }
+
+        // Check if the surface of this copy is inside any of the neighbouring copies
+        auto idx_x = copy % div_x;
+        auto idx_y = copy / div_x;
+        for(int y = std::max(idx_y - reach_y, 0); !overlap && y <= std::min(idx_y + reach_y, div_y - 1); ++y) {
+            for(int x = std::max(idx_x - reach_x, 0); !overlap && x <= std::min(idx_x + reach_x, div_x - 1); ++x) {
+                auto neighbour = y * div_x + x;
+                if(neighbour == copy || neighbour >= copies) {
+                    continue;
+                }
+                auto offset = translation - param->getTranslation(neighbour);
+                for(const auto& point : points) {
+                    auto neighbour_point = point + offset;
+                    if(solid->Inside(neighbour_point) == kInside && solid->DistanceToOut(neighbour_point) > tolerance) {
+                        LOG(DEBUG) << "Copy " << copy << " of " << GetName() << " overlaps with copy " << neighbour;
+                        overlap = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        if(overlap) {
+            ++overlaps;
+        }
+    }
+    return overlaps;
+}
@@ -13,6 +13,7 @@
 #define ALLPIX_MODULE_GEOMETRY_CONSTRUCTION_PARAMETERIZATION_2D_HH_
 
 #include <memory>
+#include <vector>
 
 #include <G4PVParameterised.hh>
 #include <G4ThreeVector.hh>
@@ -45,6 +46,25 @@ namespace allpix {
          */
         void ComputeTransformation(const G4int, G4VPhysicalVolume*) const override;
 
+        /**
+         * @brief Get the translation of an element on the grid
+         * @param copy_id Id of the volume on the grid
+         * @return Position of the element center in the mother volume
+         */
+        G4ThreeVector getTranslation(int copy_id) const;
+
+        /**
+         * @brief Get the number of divisions of the grid in the x-direction
+         * @return Number of divisions
+         */
+        int getDivisionsX() const { return div_x_; }
+
+        /**
+         * @brief Get the size of a single element
+         * @return Size in the x- and y-direction, the z-component is zero
+         */
+        G4ThreeVector getElementSize() const { return {size_x_, size_y_, 0}; }
+
     private:
         int div_x_;
         double size_x_;
@@ -73,6 +93,20 @@ namespace allpix {
          */
         bool CheckOverlaps(int res, double tol, bool verbose, int max_err) override;
 
+        /**
+         * @brief Check a range of copies for protrusions from the mother volume and overlaps with neighbouring copies
+         * @param points Points on the surface of the solid placed by the parameterization, in its local coordinates
+         * @param first First copy to check
+         * @param last Copy following the last one to check
+         * @param tolerance Tolerance of the overlap check
+         * @return Number of overlapping copies in the range
+         *
+         * Unlike \ref CheckOverlaps, this check does not alter the placement of the volume and can therefore run for
+         * separate ranges of copies in parallel. It requires a \ref Parameterization2DG4, copies are only compared to the
+         * copies close enough on the grid to possibly overlap.
+         */
+        unsigned int checkOverlaps(const std::vector<G4ThreeVector>& points, int first, int last, double tolerance) const;
+
     private:
         bool check_overlaps_;
     };
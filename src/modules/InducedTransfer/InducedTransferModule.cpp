@@ -13,10 +13,12 @@
 
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "core/module/Event.hpp"
 #include "core/utils/log.h"
 #include "objects/PixelCharge.hpp"
+#include "tools/pixel_map.h"
 
 using namespace allpix;
 using namespace ROOT::Math;
@@ -52,7 +54,12 @@ void InducedTransferModule::run(Event* event) {
     LOG(TRACE) << "Calculating induced charge on pixels";
     bool found_electrons = false, found_holes = false;
 
-    std::map<Pixel::Index, std::vector<std::pair<double, const PropagatedCharge*>>> pixel_map;
+    // Reuse the pixel map of this thread across events to avoid allocations
+    thread_local PixelMap<std::vector<std::pair<double, const PropagatedCharge*>>> pixel_map;
+    pixel_map.clear();
+    // Buffers for the induction matrix and its weighting potentials
+    thread_local std::vector<Pixel::Index> neighbors;
+    thread_local std::vector<std::pair<double, double>> potentials;
     for(const auto& propagated_charge : propagated_message->getData()) {
 
         // Make sure we're not double-counting by adding induced current information to an existing pulse:
@@ -84,9 +91,12 @@ void InducedTransferModule::run(Event* event) {
 
         // Loop over NxN pixels:
         auto idx = Pixel::Index(xpixel, ypixel);
-        for(const auto& pixel_index : model_->getNeighbors(idx, distance_)) {
-            auto ramo_end = detector_->getWeightingPotential(position_end, pixel_index);
-            auto ramo_start = detector_->getWeightingPotential(position_start, pixel_index);
+        neighbors.clear();
+        model_->getNeighbors(idx, distance_, neighbors);
+        detector_->getWeightingPotentials(position_end, position_start, neighbors, potentials);
+        for(size_t n = 0; n < neighbors.size(); ++n) {
+            const auto& pixel_index = neighbors[n];
+            auto [ramo_end, ramo_start] = potentials[n];
 
             // Induced charge on electrode is q_int = q * (phi(x1) - phi(x0))
             auto induced =
@@ -108,7 +118,9 @@ void InducedTransferModule::run(Event* event) {
 
     // Create pixel charges
     LOG(TRACE) << "Combining charges at same pixel";
+    pixel_map.sort();
     std::vector<PixelCharge> pixel_charges;
+    pixel_charges.reserve(pixel_map.size());
     for(auto& pixel_index_charge : pixel_map) {
         double charge = 0;
         std::vector<const PropagatedCharge*> prop_charges;
@@ -11,7 +11,9 @@
 
 #include "LCIOWriterModule.hpp"
 
+#include <deque>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -102,10 +104,23 @@ LCIOWriterModule::LCIOWriterModule(Configuration& config, Messenger* messenger,
     config_.setDefault("pixel_type", 2);
     config_.setDefault("detector_name", "EUTelescope");
     config_.setDefault("dump_mc_truth", false);
+    config_.setDefault<int>("compression_level", -1);
+    config_.setDefault<bool>("write_asynchronously", false);
+    config_.setDefault<unsigned int>("write_queue_size", 16);
 
     pixel_type_ = config_.get<int>("pixel_type");
     detector_name_ = config_.get<std::string>("detector_name");
     dump_mc_truth_ = config_.get<bool>("dump_mc_truth");
+
+    auto compression_level = config_.get<int>("compression_level");
+    if(compression_level < -1 || compression_level > 9) {
+        throw InvalidValueError(config_, "compression_level", "compression level needs to be between -1 and 9");
+    }
+    write_asynchronously_ = config_.get<bool>("write_asynchronously");
+    write_queue_size_ = config_.get<unsigned int>("write_queue_size");
+    if(write_queue_size_ == 0) {
+        throw InvalidValueError(config_, "write_queue_size", "queue needs to hold at least one event");
+    }
     // There are two ways to configure this module - either by providing a "output_collection_name" or a
     // "detector_assignment". Throws an error if both are provided and defaults back to "output_collection_name" if none are
     // provided
@@ -244,11 +259,22 @@ void LCIOWriterModule::initialize() {
     // Open LCIO file and write run header
     lcio_file_name_ = createOutputFile(config_.get<std::string>("file_name"), "slcio");
     lcWriter_ = std::shared_ptr<IO::LCWriter>(LCFactory::getInstance()->createLCWriter());
+    lcWriter_->setCompressionLevel(config_.get<int>("compression_level"));
     lcWriter_->open(lcio_file_name_, LCIO::WRITE_NEW);
     auto run = std::make_unique<LCRunHeaderImpl>();
     run->setRunNumber(1);
     run->setDetectorName(detector_name_);
     lcWriter_->writeRunHeader(run.get());
+
+    if(write_asynchronously_) {
+        LOG(INFO) << "Writing events asynchronously, buffering up to " << write_queue_size_ << " events";
+        writer_.start(write_queue_size_, [this](std::deque<std::unique_ptr<LCEventImpl>>& batch) {
+            for(auto& evt : batch) {
+                lcWriter_->writeEvent(evt.get());
+                write_cnt_++;
+            }
+        });
+    }
 }
 
 void LCIOWriterModule::run(Event* event) {
@@ -450,11 +476,18 @@ void LCIOWriterModule::run(Event* event) {
         evt->addCollection(output_col_vec[i], collection_names_vector_[i]);
     }
 
+    if(write_asynchronously_) {
+        writer_.push(std::move(evt));
+        return;
+    }
+
     lcWriter_->writeEvent(evt.get()); // write the event to the file
     write_cnt_++;
 }
 
 void LCIOWriterModule::finalize() {
+    writer_.finish();
+
     lcWriter_->close();
     // Print statistics
     LOG(STATUS) << "Wrote " << write_cnt_ << " events to file:" << std::endl << lcio_file_name_;
@@ -9,6 +9,7 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -20,6 +21,9 @@
 
 #include "objects/PixelHit.hpp"
 
+#include "tools/async_writer.h"
+
+#include <IMPL/LCEventImpl.h>
 #include <IO/LCWriter.h>
 
 namespace allpix {
@@ -72,5 +76,9 @@ namespace allpix {
         std::string lcio_file_name_;
         std::string geometry_file_name_;
         std::atomic<int> write_cnt_{0};
+
+        bool write_asynchronously_{};
+        size_t write_queue_size_{};
+        AsyncWriter<std::unique_ptr<IMPL::LCEventImpl>> writer_;
     };
 } // namespace allpix
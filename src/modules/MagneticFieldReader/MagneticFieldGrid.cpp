@@ -0,0 +1,67 @@
+/**
+ * @file
+ * @brief Implementation of a magnetic field map on a regular grid in global coordinates
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "MagneticFieldGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace allpix;
+
+MagneticFieldGrid::MagneticFieldGrid(const FieldData<double>& field_data, const ROOT::Math::XYZPoint& center)
+    : values_(field_data.getValues()), bins_(field_data.getDimensions()) {
+    const auto size = field_data.getSize();
+    const std::array<double, 3> center_coordinates{{center.x(), center.y(), center.z()}};
+    for(size_t axis = 0; axis < 3; ++axis) {
+        cell_size_[axis] = size[axis] / static_cast<double>(bins_[axis]);
+        corner_[axis] = center_coordinates[axis] - size[axis] / 2;
+    }
+}
+
+ROOT::Math::XYZVector MagneticFieldGrid::get(const ROOT::Math::XYZPoint& position) const {
+    const std::array<double, 3> coordinates{{position.x(), position.y(), position.z()}};
+
+    // Find the lower of the two neighboring cell centers along each axis and the fraction towards the upper one
+    std::array<size_t, 3> lower{};
+    std::array<size_t, 3> upper{};
+    std::array<double, 3> fraction{};
+    for(size_t axis = 0; axis < 3; ++axis) {
+        auto cell = (coordinates[axis] - corner_[axis]) / cell_size_[axis];
+        if(!(cell >= 0) || cell > static_cast<double>(bins_[axis])) {
+            return {};
+        }
+        auto last = static_cast<double>(bins_[axis] - 1);
+        auto offset = std::clamp(cell - 0.5, 0., last);
+        lower[axis] = static_cast<size_t>(std::floor(offset));
+        upper[axis] = std::min(lower[axis] + 1, bins_[axis] - 1);
+        fraction[axis] = offset - static_cast<double>(lower[axis]);
+    }
+
+    // Interpolate trilinearly between the eight surrounding cell centers
+    const auto* values = values_.get();
+    std::array<double, 3> field{};
+    for(size_t corner = 0; corner < 8; ++corner) {
+        double weight = 1;
+        size_t index = 0;
+        for(size_t axis = 0; axis < 3; ++axis) {
+            const bool is_upper = ((corner >> axis) & 1U) != 0;
+            weight *= (is_upper ? fraction[axis] : 1 - fraction[axis]);
+            index = index * bins_[axis] + (is_upper ? upper[axis] : lower[axis]);
+        }
+        if(weight == 0) {
+            continue;
+        }
+        for(size_t component = 0; component < 3; ++component) {
+            field[component] += weight * values[index * 3 + component];
+        }
+    }
+    return {field[0], field[1], field[2]};
+}
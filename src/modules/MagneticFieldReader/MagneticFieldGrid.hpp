@@ -0,0 +1,56 @@
+/**
+ * @file
+ * @brief Definition of a magnetic field map on a regular grid in global coordinates
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_MAGNETIC_FIELD_GRID_H
+#define ALLPIX_MAGNETIC_FIELD_GRID_H
+
+#include <array>
+#include <cstddef>
+#include <memory>
+
+#include <Math/Point3D.h>
+#include <Math/Vector3D.h>
+
+#include "tools/field_parser.h"
+
+namespace allpix {
+    /**
+     * @brief Magnetic field map on a regular grid in global coordinates
+     *
+     * The field values are shared with the \ref FieldParser the map has been read with and are interpreted as the field at
+     * the centers of the grid cells. Between the cell centers, the field is interpolated trilinearly, while the field of the
+     * outermost cells is continued up to the boundary of the map. Outside the map the field vanishes.
+     */
+    class MagneticFieldGrid {
+    public:
+        /**
+         * @brief Construct the field map from parsed field data
+         * @param field_data Field data with three components per grid cell
+         * @param center Position of the center of the map in global coordinates
+         */
+        MagneticFieldGrid(const FieldData<double>& field_data, const ROOT::Math::XYZPoint& center);
+
+        /**
+         * @brief Get the magnetic field at a position
+         * @param position Position in global coordinates
+         * @return Magnetic field at the given position, zero outside the map
+         */
+        ROOT::Math::XYZVector get(const ROOT::Math::XYZPoint& position) const;
+
+    private:
+        std::shared_ptr<const double> values_;
+        std::array<size_t, 3> bins_{};
+        std::array<double, 3> cell_size_{};
+        std::array<double, 3> corner_{};
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_MAGNETIC_FIELD_GRID_H */
@@ -11,6 +11,8 @@
 
 #include "MagneticFieldReaderModule.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <limits>
 #include <memory>
@@ -28,8 +30,12 @@
 #include "core/utils/log.h"
 #include "core/utils/unit.h"
 
+#include "MagneticFieldGrid.hpp"
+
 using namespace allpix;
 
+FieldParser<double> MagneticFieldReaderModule::field_parser_(FieldQuantity::VECTOR);
+
 MagneticFieldReaderModule::MagneticFieldReaderModule(Configuration& config, Messenger*, GeometryManager* geoManager)
     : Module(config), geometryManager_(geoManager) {
     // Enable multithreading of this module if multithreading is enabled
@@ -52,15 +58,61 @@ void MagneticFieldReaderModule::initialize() {
         MagneticFieldFunction function = [b_field](const ROOT::Math::XYZPoint&) { return b_field; };
 
         geometryManager_->setMagneticFieldFunction(function, type);
-        auto detectors = geometryManager_->getDetectors();
-        for(auto& detector : detectors) {
-            // TODO the magnetic field is calculated once for the center position of the detector. This could be extended to
-            // a function enabling a gradient in the magnetic field inside the sensor
-            auto position = detector->getPosition();
-            detector->setMagneticField(detector->getOrientation().Inverse() * geometryManager_->getMagneticField(position));
-            LOG(DEBUG) << "Magnetic field in detector " << detector->getName() << ": "
-                       << Units::display(detector->getMagneticField(detector->getLocalPosition(position)), {"T", "mT"});
-        }
+        set_detector_fields();
         LOG(INFO) << "Set constant magnetic field: " << Units::display(b_field, {"T", "mT"});
+    } else if(field_model == MagneticField::MESH) {
+        LOG(TRACE) << "Adding magnetic field map";
+        type = MagneticFieldType::GRID;
+
+        std::shared_ptr<const MagneticFieldGrid> grid;
+        try {
+            auto field_data = field_parser_.getByFileName(
+                config_.getPath("file_name", true), "T", config_.get<bool>("cache_init_file", false));
+            grid = std::make_shared<MagneticFieldGrid>(
+                field_data, config_.get<ROOT::Math::XYZPoint>("field_position", ROOT::Math::XYZPoint()));
+            LOG(INFO) << "Set magnetic field map with " << field_data.getDimensions().at(0) << "x"
+                      << field_data.getDimensions().at(1) << "x" << field_data.getDimensions().at(2) << " cells";
+        } catch(std::invalid_argument& e) {
+            throw InvalidValueError(config_, "file_name", e.what());
+        } catch(std::runtime_error& e) {
+            throw InvalidValueError(config_, "file_name", e.what());
+        } catch(std::bad_alloc& e) {
+            throw InvalidValueError(config_, "file_name", "file too large");
+        }
+
+        MagneticFieldFunction function = [grid](const ROOT::Math::XYZPoint& position) { return grid->get(position); };
+
+        geometryManager_->setMagneticFieldFunction(function, type);
+        set_detector_fields();
+    }
+}
+
+/**
+ * The field is cached for every detector since it is usually quasi-constant across a sensor. The largest deviation from the
+ * cached value at the corners of the sensor is reported to judge the validity of this approximation.
+ */
+void MagneticFieldReaderModule::set_detector_fields() {
+    for(auto& detector : geometryManager_->getDetectors()) {
+        auto model = detector->getModel();
+        auto center = model->getSensorCenter();
+        auto b_field = geometryManager_->getMagneticField(detector->getGlobalPosition(center));
+        detector->setMagneticField(detector->getOrientation().Inverse() * b_field);
+        LOG(DEBUG) << "Magnetic field in detector " << detector->getName() << ": "
+                   << Units::display(detector->getMagneticField(center), {"T", "mT"});
+
+        double max_deviation = 0;
+        for(int corner = 0; corner < 8; ++corner) {
+            auto offset = model->getSensorSize() / 2;
+            offset.SetXYZ((corner & 1) != 0 ? offset.x() : -offset.x(),
+                          (corner & 2) != 0 ? offset.y() : -offset.y(),
+                          (corner & 4) != 0 ? offset.z() : -offset.z());
+            auto deviation = geometryManager_->getMagneticField(detector->getGlobalPosition(center + offset)) - b_field;
+            max_deviation = std::max(max_deviation, std::sqrt(deviation.Mag2()));
+        }
+        if(max_deviation > 0.01 * std::sqrt(b_field.Mag2())) {
+            LOG(WARNING) << "Magnetic field varies by up to " << Units::display(max_deviation, {"T", "mT"})
+                         << " across the sensor of detector " << detector->getName()
+                         << ", using the field at the sensor center";
+        }
     }
 }
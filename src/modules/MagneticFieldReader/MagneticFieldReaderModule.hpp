@@ -19,14 +19,15 @@
 #include "core/messenger/Messenger.hpp"
 
 #include "core/module/Module.hpp"
+#include "tools/field_parser.h"
 
 namespace allpix {
     /**
      * @ingroup Modules
      * @brief Module to define magnetic fields
      *
-     * Read the model of the magnetic field from the config during initialization and apply a constant field throughout the
-     * whole volume
+     * Read the model of the magnetic field from the config during initialization and apply either a constant field or a
+     * field map throughout the whole volume. The field in every detector is evaluated once at the center of its sensor.
      */
     class MagneticFieldReaderModule : public Module {
         /**
@@ -34,6 +35,7 @@ namespace allpix {
          */
         enum class MagneticField {
             CONSTANT, ///< Constant magnetic field
+            MESH,     ///< Magnetic field map read from a file
         };
 
     public:
@@ -51,6 +53,14 @@ namespace allpix {
         void initialize() override;
 
     private:
+        /**
+         * @brief Set the field of all detectors to the field at the center of their sensor
+         */
+        void set_detector_fields();
+
         GeometryManager* geometryManager_;
+
+        // Field parser shared between runs
+        static FieldParser<double> field_parser_;
     };
 } // namespace allpix
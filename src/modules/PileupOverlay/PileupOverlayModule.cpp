@@ -0,0 +1,231 @@
+/**
+ * @file
+ * @brief Implementation of module overlaying pile-up from a library of pre-simulated pixel charges
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "PileupOverlayModule.hpp"
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <TBranch.h>
+#include <TFile.h>
+#include <TTree.h>
+
+#include "core/config/exceptions.h"
+#include "core/messenger/exceptions.h"
+#include "core/utils/distributions.h"
+#include "core/utils/log.h"
+#include "core/utils/unit.h"
+#include "objects/exceptions.h"
+#include "tools/ROOT.h"
+#include "tools/pixel_map.h"
+
+using namespace allpix;
+
+PileupOverlayModule::PileupOverlayModule(Configuration& config, Messenger* messenger, std::shared_ptr<Detector> detector)
+    : Module(config, detector), messenger_(messenger), detector_(std::move(detector)) {
+    // Enable multithreading of this module if multithreading is enabled
+    allow_multithreading();
+
+    config_.setDefault<std::string>("library_detector", detector_->getName());
+    config_.setDefault<PileupDistribution>("pileup_distribution", PileupDistribution::POISSON);
+    config_.setDefault<double>("time_window", 0.);
+    config_.setDefault<bool>("randomize_position", true);
+
+    pileup_ = config_.get<double>("pileup");
+    if(pileup_ < 0) {
+        throw InvalidValueError(config_, "pileup", "pile-up cannot be negative");
+    }
+    pileup_distribution_ = config_.get<PileupDistribution>("pileup_distribution");
+    if(pileup_distribution_ == PileupDistribution::FIXED && std::floor(pileup_) != pileup_) {
+        throw InvalidValueError(config_, "pileup", "a fixed pile-up requires an integer number of library entries");
+    }
+    time_window_ = config_.get<double>("time_window");
+    if(time_window_ < 0) {
+        throw InvalidValueError(config_, "time_window", "time window cannot be negative");
+    }
+    randomize_position_ = config_.get<bool>("randomize_position");
+
+    model_ = detector_->getModel();
+
+    // Pixel charges of the simulated signal are optional, the pile-up is also overlaid onto empty events
+    messenger_->bindSingle<PixelChargeMessage>(this);
+}
+
+/**
+ * The library is read completely into memory, such that the entries can be sampled from all threads without accessing the
+ * file during the event loop.
+ */
+void PileupOverlayModule::initialize() {
+    auto file_name = config_.getPathWithExtension("file_name", "root", true);
+    auto library_detector = config_.get<std::string>("library_detector");
+
+    auto root_lock = root_process_lock();
+    auto library_file = std::make_unique<TFile>(file_name.c_str());
+    if(library_file->IsZombie()) {
+        throw InvalidValueError(config_, "file_name", "cannot open library file");
+    }
+
+    TTree* tree = nullptr;
+    library_file->GetObject("PixelCharge", tree);
+    if(tree == nullptr) {
+        throw InvalidValueError(config_, "file_name", "library file does not contain any pixel charges");
+    }
+    auto* branch = tree->GetBranch(library_detector.c_str());
+    if(branch == nullptr) {
+        throw InvalidValueError(config_, "library_detector", "library file does not contain pixel charges of this detector");
+    }
+
+    std::vector<PixelCharge*>* objects = nullptr;
+    branch->SetAddress(&objects);
+
+    size_t library_charges = 0;
+    library_.reserve(static_cast<size_t>(tree->GetEntries()));
+    for(Long64_t entry = 0; entry < tree->GetEntries(); ++entry) {
+        branch->GetEntry(entry);
+
+        LibraryEntry library_entry;
+        double total_charge = 0;
+        double center_x = 0;
+        double center_y = 0;
+        for(const auto* pixel_charge : *objects) {
+            auto weight = static_cast<double>(pixel_charge->getAbsoluteCharge());
+            total_charge += weight;
+            center_x += weight * pixel_charge->getIndex().x();
+            center_y += weight * pixel_charge->getIndex().y();
+            library_entry.pixels.emplace_back(pixel_charge->getIndex(), pixel_charge->getPulse());
+        }
+        if(total_charge > 0) {
+            library_entry.anchor = {static_cast<int>(std::lround(center_x / total_charge)),
+                                    static_cast<int>(std::lround(center_y / total_charge))};
+        }
+
+        // Entries without charges are kept, they represent particles missing the sensor
+        library_charges += library_entry.pixels.size();
+        library_.push_back(std::move(library_entry));
+    }
+
+    branch->ResetAddress();
+    delete objects;
+    library_file->Close();
+
+    if(library_.empty()) {
+        throw InvalidValueError(config_, "file_name", "library file does not contain any events");
+    }
+    LOG(INFO) << "Read " << library_.size() << " library entries with " << library_charges << " pixel charges from "
+              << file_name;
+}
+
+void PileupOverlayModule::run(Event* event) {
+    // Sample the number of library entries to overlay
+    auto entries = static_cast<unsigned long>(pileup_);
+    if(pileup_distribution_ == PileupDistribution::POISSON && pileup_ > 0) {
+        allpix::poisson_distribution<unsigned long> pileup_distribution(pileup_);
+        entries = pileup_distribution(event->getRandomEngine());
+    }
+
+    // Combine the time-shifted pulses of all sampled entries per pixel
+    auto n_pixels = model_->getNPixels();
+    allpix::uniform_real_distribution<double> uniform_distribution(0, 1);
+    PixelMap<OverlayPixel> overlay;
+    for(unsigned long i = 0; i < entries; ++i) {
+        auto entry_index = static_cast<size_t>(uniform_distribution(event->getRandomEngine()) *
+                                               static_cast<double>(library_.size()));
+        const auto& library_entry = library_[std::min(entry_index, library_.size() - 1)];
+
+        // Move the entry point of the entry to a random pixel of the matrix
+        Pixel::Index shift{0, 0};
+        if(randomize_position_) {
+            auto column = static_cast<int>(uniform_distribution(event->getRandomEngine()) * n_pixels.x());
+            auto row = static_cast<int>(uniform_distribution(event->getRandomEngine()) * n_pixels.y());
+            shift = Pixel::Index(column, row) - library_entry.anchor;
+        }
+        auto time_shift = time_window_ * uniform_distribution(event->getRandomEngine());
+
+        LOG(TRACE) << "Overlaying library entry with " << library_entry.pixels.size() << " pixel charges, shifted by "
+                   << shift << " pixels and " << Units::display(time_shift, {"ns", "ps"});
+        for(const auto& [index, pulse] : library_entry.pixels) {
+            auto pixel_index = index + shift;
+            if(!model_->isWithinMatrix(pixel_index)) {
+                continue;
+            }
+
+            // Pulses without time information only hold the total charge
+            auto& overlay_pulse = overlay[pixel_index].pulse;
+            if(!pulse.isInitialized() || time_shift == 0.) {
+                overlay_pulse += pulse;
+            } else {
+                Pulse shifted_pulse(pulse.getBinning(), pulse.getFineBins(), pulse.getGrowth());
+                for(size_t bin = 0; bin < pulse.size(); ++bin) {
+                    shifted_pulse.addCharge(pulse[bin], pulse.getBinTime(pulse.getOffset() + bin) + time_shift);
+                }
+                overlay_pulse += shifted_pulse;
+            }
+        }
+    }
+    overlaid_entries_ += entries;
+    overlaid_events_++;
+
+    // Fetch the pixel charges of the simulated signal if available
+    std::shared_ptr<PixelChargeMessage> signal_message;
+    try {
+        signal_message = messenger_->fetchMessage<PixelChargeMessage>(this, event);
+    } catch(const MessageNotFoundException&) {
+        LOG(DEBUG) << "No pixel charges of the simulated signal, only overlaying pile-up";
+    }
+
+    // Add the pile-up to the pixels of the signal, keeping their history
+    std::vector<PixelCharge> pixel_charges;
+    if(signal_message != nullptr) {
+        pixel_charges.reserve(signal_message->getData().size() + overlay.size());
+        for(const auto& pixel_charge : signal_message->getData()) {
+            if(overlay.find(pixel_charge.getIndex()) == nullptr) {
+                pixel_charges.push_back(pixel_charge);
+                continue;
+            }
+
+            auto& overlay_pixel = overlay[pixel_charge.getIndex()];
+            auto pulse = pixel_charge.getPulse();
+            try {
+                pulse += overlay_pixel.pulse;
+            } catch(const IncompatibleDatatypesException&) {
+                throw ModuleError("Pulses of the library have a different time binning than the simulated signal");
+            }
+            std::vector<const PropagatedCharge*> propagated_charges;
+            try {
+                propagated_charges = pixel_charge.getPropagatedCharges();
+            } catch(const MissingReferenceException&) {
+                LOG(TRACE) << "Propagated charges of pixel " << pixel_charge.getIndex() << " not in scope, not linking them";
+            }
+            pixel_charges.emplace_back(pixel_charge.getPixel(), std::move(pulse), propagated_charges);
+            overlay_pixel.merged = true;
+        }
+    }
+
+    // Create the pixel charges only seeing pile-up
+    overlay.sort();
+    for(auto& [index, overlay_pixel] : overlay) {
+        if(!overlay_pixel.merged) {
+            pixel_charges.emplace_back(detector_->getPixel(index), std::move(overlay_pixel.pulse));
+        }
+    }
+
+    LOG(DEBUG) << "Overlaid " << entries << " library entries, " << pixel_charges.size() << " pixels with charge";
+
+    // Dispatch the combined pixel charges
+    auto pixel_message = std::make_shared<PixelChargeMessage>(std::move(pixel_charges), detector_);
+    messenger_->dispatchMessage(this, pixel_message, event);
+}
+
+void PileupOverlayModule::finalize() {
+    LOG(INFO) << "Overlaid " << overlaid_entries_ << " library entries in " << overlaid_events_ << " events";
+}
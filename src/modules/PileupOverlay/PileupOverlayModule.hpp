@@ -0,0 +1,105 @@
+/**
+ * @file
+ * @brief Definition of module overlaying pile-up from a library of pre-simulated pixel charges
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/config/Configuration.hpp"
+#include "core/geometry/DetectorModel.hpp"
+#include "core/messenger/Messenger.hpp"
+#include "core/module/Event.hpp"
+#include "core/module/Module.hpp"
+
+#include "objects/Pixel.hpp"
+#include "objects/PixelCharge.hpp"
+#include "objects/Pulse.hpp"
+
+namespace allpix {
+    /**
+     * @ingroup Modules
+     * @brief Module overlaying randomly sampled entries of a pixel charge library onto the pixel charges of every event
+     * @note This module supports multithreading
+     *
+     * The library is read from a file written by the ROOTObjectWriter module, every event of this file containing the pixel
+     * charges of a single particle. A number of library entries is sampled for every event, shifted randomly in time and
+     * position on the pixel matrix, and combined with the pixel charges of the event before digitization.
+     */
+    class PileupOverlayModule : public Module {
+    public:
+        /**
+         * @brief Distribution of the number of library entries overlaid in every event
+         */
+        enum class PileupDistribution {
+            FIXED,   ///< Fixed number of entries, given by the pile-up parameter
+            POISSON, ///< Poisson-distributed number of entries with the pile-up parameter as mean
+        };
+
+        /**
+         * @brief Constructor for this detector-specific module
+         * @param config Configuration object for this module as retrieved from the steering file
+         * @param messenger Pointer to the messenger object to allow binding to messages on the bus
+         * @param detector Pointer to the detector for this module instance
+         */
+        PileupOverlayModule(Configuration& config, Messenger* messenger, std::shared_ptr<Detector> detector);
+
+        /**
+         * @brief Read the pixel charges of the detector from the library file
+         */
+        void initialize() override;
+
+        /**
+         * @brief Overlay the sampled library entries onto the pixel charges of the event
+         */
+        void run(Event*) override;
+
+        /**
+         * @brief Display statistical summary
+         */
+        void finalize() override;
+
+    private:
+        /**
+         * @brief Pixel charges of a single particle stored in the library
+         */
+        struct LibraryEntry {
+            std::vector<std::pair<Pixel::Index, Pulse>> pixels;
+            // Pixel closest to the charge-weighted center of the entry, used as its entry point on the matrix
+            Pixel::Index anchor;
+        };
+
+        /**
+         * @brief Helper to combine the pile-up pulses of a single pixel
+         */
+        struct OverlayPixel {
+            Pulse pulse;
+            bool merged{};
+        };
+
+        Messenger* messenger_;
+        std::shared_ptr<Detector> detector_;
+        std::shared_ptr<DetectorModel> model_;
+
+        std::vector<LibraryEntry> library_;
+
+        // Configuration parameters
+        double pileup_{};
+        PileupDistribution pileup_distribution_{};
+        double time_window_{};
+        bool randomize_position_{};
+
+        // Statistical information
+        std::atomic<unsigned long> overlaid_entries_{};
+        std::atomic<unsigned long> overlaid_events_{};
+    };
+} // namespace allpix
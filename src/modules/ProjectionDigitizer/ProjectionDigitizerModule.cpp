@@ -0,0 +1,293 @@
+/**
+ * @file
+ * @brief Implementation of ProjectionDigitizer module
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "ProjectionDigitizerModule.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <utility>
+
+#include "core/messenger/Messenger.hpp"
+#include "core/utils/distributions.h"
+#include "core/utils/log.h"
+#include "objects/PixelHit.hpp"
+#include "tools/pixel_map.h"
+
+using namespace allpix;
+
+ProjectionDigitizerModule::ProjectionDigitizerModule(Configuration& config,
+                                                     Messenger* messenger,
+                                                     std::shared_ptr<Detector> detector)
+    : Module(config, detector), messenger_(messenger), detector_(std::move(detector)),
+      top_z_(detector_->getModel()->getSensorSize().z() / 2) {
+    // Enable multithreading of this module if multithreading is enabled
+    allow_multithreading();
+
+    // Save detector model
+    model_ = detector_->getModel();
+
+    // Require deposits message for single detector
+    messenger_->bindSingle<DepositedChargeMessage>(this, MsgFlags::REQUIRED);
+
+    // Set default value for config variables
+    config_.setDefault<int>("charge_per_step", 10);
+    config_.setDefault<unsigned int>("max_charge_groups", 1000);
+    config_.setDefault<double>("integration_time", Units::get(25, "ns"));
+    config_.setDefault<std::string>("recombination_model", "none");
+    config_.setDefault<bool>("propagate_holes", false);
+    config_.setDefault<bool>("ignore_magnetic_field", false);
+
+    config_.setDefault<int>("electronics_noise", Units::get(110, "e"));
+    config_.setDefault<double>("gain", 1.0);
+    config_.setDefault<int>("threshold_smearing", Units::get(30, "e"));
+    config_.setDefault<int>("qdc_resolution", 0);
+    config_.setDefault<int>("qdc_smearing", Units::get(300, "e"));
+    config_.setDefault<double>("qdc_offset", Units::get(0, "e"));
+    config_.setDefault<double>("qdc_slope", Units::get(10, "e"));
+    config_.setDefault<bool>("allow_zero_qdc", false);
+
+    config_.setDefault<bool>("output_plots", false);
+
+    integration_time_ = config_.get<double>("integration_time");
+    charge_per_step_ = config_.get<unsigned int>("charge_per_step");
+    max_charge_groups_ = config_.get<unsigned int>("max_charge_groups");
+    output_plots_ = config_.get<bool>("output_plots");
+
+    electronics_noise_ = config_.get<unsigned int>("electronics_noise");
+    gain_ = config_.get<double>("gain");
+    threshold_ = config_.get<unsigned int>("threshold");
+    threshold_smearing_ = config_.get<unsigned int>("threshold_smearing");
+
+    qdc_resolution_ = config_.get<int>("qdc_resolution");
+    qdc_smearing_ = config_.get<unsigned int>("qdc_smearing");
+    qdc_offset_ = config_.get<double>("qdc_offset");
+    qdc_slope_ = config_.get<double>("qdc_slope");
+    allow_zero_qdc_ = config_.get<bool>("allow_zero_qdc");
+
+    if(qdc_resolution_ > 31) {
+        throw InvalidValueError(config_, "qdc_resolution", "precision higher than 31bit is not possible");
+    }
+
+    if(config_.get<bool>("propagate_holes")) {
+        propagate_type_ = CarrierType::HOLE;
+        LOG(INFO) << "Holes are chosen for propagation. Electrons are therefore not propagated.";
+    } else {
+        propagate_type_ = CarrierType::ELECTRON;
+    }
+
+    auto temperature = config_.get<double>("temperature");
+    boltzmann_kT_ = Units::get(8.6173333e-5, "eV/K") * temperature;
+
+    // Mobility fixed to Jacoboni, using the critical fields for the discrete integration of the drift time as done by the
+    // ProjectionPropagation module
+    mobility_ = std::make_unique<JacoboniCanali>(model_->getSensorMaterial(), temperature);
+    electron_Ec_ = Units::get(1.01 * std::pow(temperature, 1.55), "V/cm");
+    hole_Ec_ = Units::get(1.24 * std::pow(temperature, 1.68), "V/cm");
+}
+
+void ProjectionDigitizerModule::initialize() {
+    if(detector_->getElectricFieldType() != FieldType::LINEAR) {
+        throw ModuleError("This module should only be used with linear electric fields.");
+    }
+
+    if(detector_->hasDopingProfile() && detector_->getDopingProfileType() != FieldType::CONSTANT) {
+        throw ModuleError("This module should only be used with constant doping concentration.");
+    }
+
+    // Prepare recombination model
+    recombination_ = Recombination(config_, detector_->hasDopingProfile());
+
+    if(detector_->hasMagneticField() && !config_.get<bool>("ignore_magnetic_field")) {
+        throw ModuleError("This module should not be used with magnetic fields. Add the option 'ignore_magnetic_field' to "
+                          "the configuration if you would like to continue.");
+    }
+
+    // Find correct top side
+    if(detector_->getElectricField({0, 0, top_z_}).z() > detector_->getElectricField({0, 0, -top_z_}).z()) {
+        top_z_ *= -1;
+    }
+    if(propagate_type_ == CarrierType::HOLE) {
+        top_z_ *= -1;
+    }
+
+    if(top_z_ < 0) {
+        LOG(WARNING)
+            << "Selected carriers are not propagated to the implant side, combination of propagated carrier and electric "
+               "field is wrong!";
+    }
+
+    if(output_plots_) {
+        h_drift_time_ = CreateHistogram<TH1D>("drift_time_histo",
+                                              "Drift time;Drift time [ns];charge carriers",
+                                              static_cast<int>(Units::convert(integration_time_, "ns") * 5),
+                                              0,
+                                              static_cast<double>(Units::convert(integration_time_, "ns")) * 2);
+        h_pxq_ = CreateHistogram<TH1D>("pixelcharge", "raw pixel charge;pixel charge [ke];pixels", 100, 0, 30);
+        h_pxq_thr_ = CreateHistogram<TH1D>(
+            "pixelcharge_threshold", "pixel charge above threshold;pixel charge [ke];pixels", 100, 0, 30);
+    }
+}
+
+void ProjectionDigitizerModule::run(Event* event) {
+    auto deposits_message = messenger_->fetchMessage<DepositedChargeMessage>(this, event);
+
+    // The field at the top of the sensor is the same for all charge carriers
+    const auto efield_mag_top = std::sqrt(detector_->getElectricField(ROOT::Math::XYZPoint(0., 0., top_z_)).Mag2());
+
+    // Charge and earliest arrival time per pixel, reused by this thread across events
+    struct PixelSignal {
+        double charge{};
+        double local_time{std::numeric_limits<double>::max()};
+        double global_time{std::numeric_limits<double>::max()};
+    };
+    thread_local PixelMap<PixelSignal> pixel_map;
+    pixel_map.clear();
+
+    // Project all deposits onto the sensor surface and accumulate their charge per pixel
+    for(const auto& deposit : deposits_message->getData()) {
+        auto type = propagate_type_;
+        if(!deposit.hasCarrier(type)) {
+            continue;
+        }
+
+        const auto& position = deposit.getLocalPosition();
+        auto efield_mag = std::sqrt(detector_->getElectricField(position).Mag2());
+
+        // Only project if within the depleted region (i.e. efield not zero)
+        if(efield_mag < std::numeric_limits<double>::epsilon()) {
+            continue;
+        }
+
+        // Drift time and diffusion width of the linear field approximation, see the ProjectionPropagation module
+        auto doping = detector_->getDopingConcentration(position);
+        double drift_time = 0;
+        if(position.z() != top_z_) {
+            auto slope_efield = (efield_mag_top - efield_mag) / (std::abs(top_z_ - position.z()));
+            double Ec = (type == CarrierType::ELECTRON ? electron_Ec_ : hole_Ec_);
+            drift_time = ((log(efield_mag_top) - log(efield_mag)) / slope_efield + std::abs(top_z_ - position.z()) / Ec) /
+                         (*mobility_)(type, 0, doping);
+        }
+        double diffusion_constant =
+            boltzmann_kT_ * ((*mobility_)(type, efield_mag, doping) + (*mobility_)(type, efield_mag_top, doping)) / 2.;
+        double diffusion_std_dev = std::sqrt(2. * diffusion_constant * drift_time);
+
+        auto local_time = deposit.getLocalTime() + drift_time;
+        auto global_time = deposit.getGlobalTime() + drift_time;
+
+        // Only add if within requested integration time:
+        if(local_time > integration_time_) {
+            continue;
+        }
+
+        if(output_plots_) {
+            h_drift_time_->Fill(drift_time, deposit.getCharge());
+        }
+
+        unsigned int charges_remaining = deposit.getCharge();
+        auto charge_per_step = charge_per_step_;
+        if(max_charge_groups_ > 0 && deposit.getCharge() / charge_per_step > max_charge_groups_) {
+            charge_per_step = static_cast<unsigned int>(ceil(static_cast<double>(deposit.getCharge()) / max_charge_groups_));
+        }
+
+        allpix::uniform_real_distribution<double> survival(0, 1);
+        allpix::normal_distribution<double> gauss_distribution(0, diffusion_std_dev);
+        while(charges_remaining > 0) {
+            charge_per_step = std::min(charge_per_step, charges_remaining);
+            charges_remaining -= charge_per_step;
+
+            // Check if charge carrier is still alive via its survival probability, evaluated once
+            if(recombination_(type, doping, survival(event->getRandomEngine()), drift_time)) {
+                continue;
+            }
+
+            // Find projected position and the pixel it is collected by
+            double diffusion_x = gauss_distribution(event->getRandomEngine());
+            double diffusion_y = gauss_distribution(event->getRandomEngine());
+            auto local_position = ROOT::Math::XYZPoint(position.x() + diffusion_x, position.y() + diffusion_y, top_z_);
+            if(!model_->isWithinSensor(local_position)) {
+                continue;
+            }
+
+            auto [xpixel, ypixel] = model_->getPixelIndex(local_position);
+            if(!model_->isWithinMatrix(xpixel, ypixel)) {
+                continue;
+            }
+
+            auto& signal = pixel_map[Pixel::Index(xpixel, ypixel)];
+            signal.charge += charge_per_step;
+            signal.local_time = std::min(signal.local_time, local_time);
+            signal.global_time = std::min(signal.global_time, global_time);
+        }
+    }
+
+    // Digitize the accumulated pixel charges in the order of their pixel indices
+    pixel_map.sort();
+    std::vector<PixelHit> hits;
+    for(const auto& [index, signal] : pixel_map) {
+        auto charge = signal.charge;
+        if(output_plots_) {
+            h_pxq_->Fill(charge / 1e3);
+        }
+
+        // Add electronics noise from Gaussian and apply the gain:
+        allpix::normal_distribution<double> charge_smearing(0, electronics_noise_);
+        charge = gain_ * (charge + charge_smearing(event->getRandomEngine()));
+
+        // Smear the threshold, Gaussian distribution around "threshold" with width "threshold_smearing"
+        allpix::normal_distribution<double> thr_smearing(threshold_, threshold_smearing_);
+        double threshold = thr_smearing(event->getRandomEngine());
+
+        // Discard charges below threshold:
+        if(charge < threshold) {
+            LOG(DEBUG) << "Below smeared threshold: " << Units::display(charge, "e") << " < "
+                       << Units::display(threshold, "e");
+            continue;
+        }
+
+        LOG(DEBUG) << "Passed threshold: " << Units::display(charge, "e") << " > " << Units::display(threshold, "e");
+        if(output_plots_) {
+            h_pxq_thr_->Fill(charge / 1e3);
+        }
+
+        // Simulate QDC if resolution set to more than 0bit
+        if(qdc_resolution_ > 0) {
+            allpix::normal_distribution<double> qdc_smearing(0, qdc_smearing_);
+            charge += qdc_smearing(event->getRandomEngine());
+            charge = static_cast<double>(std::clamp(static_cast<int>((qdc_offset_ + charge) / qdc_slope_),
+                                                    (allow_zero_qdc_ ? 0 : 1),
+                                                    (1 << qdc_resolution_) - 1));
+        }
+
+        // Hits are created without history since no intermediate objects exist
+        hits.emplace_back(detector_->getPixel(index), signal.local_time, signal.global_time, charge);
+    }
+
+    // Output summary and update statistics
+    LOG(INFO) << "Digitized " << hits.size() << " pixel hits";
+    total_hits_ += hits.size();
+
+    if(!hits.empty()) {
+        auto hits_message = std::make_shared<PixelHitMessage>(std::move(hits), detector_);
+        messenger_->dispatchMessage(this, std::move(hits_message), event);
+    }
+}
+
+void ProjectionDigitizerModule::finalize() {
+    if(output_plots_) {
+        h_drift_time_->Write();
+        h_pxq_->Write();
+        h_pxq_thr_->Write();
+    }
+
+    LOG(INFO) << "Digitized " << total_hits_ << " pixel hits in total";
+}
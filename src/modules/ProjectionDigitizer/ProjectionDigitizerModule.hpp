@@ -0,0 +1,111 @@
+/**
+ * @file
+ * @brief Definition of ProjectionDigitizer module
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_PROJECTION_DIGITIZER_MODULE_H
+#define ALLPIX_PROJECTION_DIGITIZER_MODULE_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include <TH1D.h>
+
+#include "core/config/Configuration.hpp"
+#include "core/geometry/DetectorModel.hpp"
+#include "core/messenger/Messenger.hpp"
+#include "core/module/Event.hpp"
+#include "core/module/Module.hpp"
+
+#include "objects/DepositedCharge.hpp"
+
+#include "physics/Mobility.hpp"
+#include "physics/Recombination.hpp"
+
+#include "tools/ROOT.h"
+
+namespace allpix {
+    /**
+     * @ingroup Modules
+     * @brief Module to digitize deposited charges in a single pass via projection onto the sensor surface
+     * @note This module supports multithreading
+     *
+     * The deposited charge carriers are projected onto the sensor surface as done by the ProjectionPropagation module, and
+     * the projected charge is accumulated directly per pixel instead of creating propagated charge objects. The summed
+     * charge of each pixel is then digitized with electronics noise, gain, a smeared threshold and an optional QDC as done
+     * by the DefaultDigitizer module. No intermediate PropagatedCharge or PixelCharge objects are created, the resulting
+     * pixel hits therefore carry no Monte Carlo history.
+     */
+    class ProjectionDigitizerModule : public Module {
+    public:
+        /**
+         * @brief Constructor for this detector-specific module
+         * @param config Configuration object for this module as retrieved from the steering file
+         * @param messenger Pointer to the messenger object to allow binding to messages on the bus
+         * @param detector Pointer to the detector for this module instance
+         */
+        ProjectionDigitizerModule(Configuration& config, Messenger* messenger, std::shared_ptr<Detector> detector);
+
+        /**
+         * @brief Initialize - check the fields and create plots if needed
+         */
+        void initialize() override;
+
+        /**
+         * @brief Projection of the charge carriers to the surface and digitization of the pixel charges
+         */
+        void run(Event*) override;
+
+        /**
+         * @brief Write plots if needed
+         */
+        void finalize() override;
+
+    private:
+        Messenger* messenger_;
+        std::shared_ptr<const Detector> detector_;
+        std::shared_ptr<DetectorModel> model_;
+
+        // Config parameters
+        bool output_plots_{};
+        double integration_time_{};
+        unsigned int charge_per_step_{};
+        unsigned int max_charge_groups_{};
+        double electronics_noise_{}, gain_{};
+        double threshold_{}, threshold_smearing_{};
+        int qdc_resolution_{};
+        double qdc_smearing_{}, qdc_offset_{}, qdc_slope_{};
+        bool allow_zero_qdc_{};
+
+        // Carrier type to be propagated
+        CarrierType propagate_type_;
+        // Side to propagate too
+        double top_z_;
+
+        // Precalculated values for electron and hole critical fields
+        double hole_Ec_;
+        double electron_Ec_;
+
+        // Models for electron and hole mobility and lifetime
+        std::unique_ptr<JacoboniCanali> mobility_;
+        Recombination recombination_;
+
+        // Precalculated value for Boltzmann constant:
+        double boltzmann_kT_;
+
+        // Statistical information
+        std::atomic<unsigned long> total_hits_{};
+        Histogram<TH1D> h_drift_time_;
+        Histogram<TH1D> h_pxq_;
+        Histogram<TH1D> h_pxq_thr_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_PROJECTION_DIGITIZER_MODULE_H */
@@ -11,20 +11,29 @@
 
 #include "ProjectionPropagationModule.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <functional>
 #include <limits>
 #include <string>
 #include <utility>
 
+#include "core/geometry/HexagonalPixelDetectorModel.hpp"
+#include "core/geometry/PixelDetectorModel.hpp"
 #include "core/messenger/Messenger.hpp"
 #include "core/utils/distributions.h"
 #include "core/utils/log.h"
 #include "objects/DepositedCharge.hpp"
+#include "objects/PixelCharge.hpp"
 #include "objects/PropagatedCharge.hpp"
 
 using namespace allpix;
 
+namespace {
+    // Range of the analytic charge sharing around the projected position, in units of the diffusion width
+    constexpr double charge_sharing_range = 5.;
+} // namespace
+
 ProjectionPropagationModule::ProjectionPropagationModule(Configuration& config,
                                                          Messenger* messenger,
                                                          std::shared_ptr<Detector> detector)
@@ -43,6 +52,9 @@ ProjectionPropagationModule::ProjectionPropagationModule(Configuration& config,
     config_.setDefault<double>("integration_time", Units::get(25, "ns"));
     config_.setDefault<bool>("diffuse_deposit", false);
     config_.setDefault<std::string>("recombination_model", "none");
+    config_.setDefaultArray<unsigned int>("field_cache_bins", {20, 20, 100});
+    config_.setDefault<ChargeSharing>("charge_sharing", ChargeSharing::SAMPLED);
+    config_.setDefault<ChargeSharingFluctuations>("charge_sharing_fluctuations", ChargeSharingFluctuations::NONE);
 
     config_.setDefault<bool>("output_linegraphs", false);
     config_.setDefault<bool>("output_animations", false);
@@ -58,9 +70,34 @@ ProjectionPropagationModule::ProjectionPropagationModule(Configuration& config,
     diffuse_deposit_ = config_.get<bool>("diffuse_deposit");
     charge_per_step_ = config_.get<unsigned int>("charge_per_step");
     max_charge_groups_ = config_.get<unsigned int>("max_charge_groups");
+    charge_sharing_ = config_.get<ChargeSharing>("charge_sharing");
+    charge_sharing_fluctuations_ = config_.get<ChargeSharingFluctuations>("charge_sharing_fluctuations");
+
+    if(charge_sharing_ == ChargeSharing::ANALYTIC) {
+        // The pixel edges are only aligned with the axes for rectangular pixel matrices
+        if(std::dynamic_pointer_cast<PixelDetectorModel>(model_) == nullptr ||
+           std::dynamic_pointer_cast<HexagonalPixelDetectorModel>(model_) != nullptr) {
+            throw InvalidValueError(
+                config_, "charge_sharing", "analytic charge sharing is only supported for rectangular pixel matrices");
+        }
+
+        // Groups of charge carriers are only sampled if the diffusion prior to the drift or recombination are simulated
+        sample_groups_ = diffuse_deposit_ || config_.get<std::string>("recombination_model") != "none";
+        LOG(INFO) << "Sharing the charge of each " << (sample_groups_ ? "group of charge carriers" : "deposit")
+                  << " analytically among the pixels";
+    }
 
     output_plots_ = config_.get<bool>("output_plots");
     output_linegraphs_ = config_.get<bool>("output_linegraphs");
+    plot_settings_ = LineGraph::PlotSettings(config_);
+
+    auto field_cache_bins = config_.getArray<unsigned int>("field_cache_bins");
+    if(field_cache_bins.size() != 3 ||
+       std::find(field_cache_bins.begin(), field_cache_bins.end(), 0) != field_cache_bins.end()) {
+        throw InvalidValueError(
+            config_, "field_cache_bins", "three non-zero numbers of bins along x, y and z are required");
+    }
+    std::copy(field_cache_bins.begin(), field_cache_bins.end(), field_cache_bins_.begin());
 
     // Enable multithreading of this module if multithreading is enabled and no per-event output plots are requested:
     // FIXME: Review if this is really the case or we can still use multithreading
@@ -79,6 +116,24 @@ ProjectionPropagationModule::ProjectionPropagationModule(Configuration& config,
         propagate_type_ = CarrierType::ELECTRON;
     }
 
+    // Hall factors of the Lorentz drift, approximated from http://www.ioffe.ru/SVA/NSM/Semicond/Si/electric.html as in the
+    // GenericPropagation module unless given explicitly, optionally tabulated versus the electric field
+    config_.setDefaultArray<double>("hall_factor", {propagate_type_ == CarrierType::ELECTRON ? 1.15 : 0.9});
+    hall_factors_ = config_.getArray<double>("hall_factor");
+    if(hall_factors_.empty()) {
+        throw InvalidValueError(config_, "hall_factor", "at least one Hall factor is required");
+    }
+    if(hall_factors_.size() > 1) {
+        hall_factor_fields_ = config_.getArray<double>("hall_factor_fields");
+        if(hall_factor_fields_.size() != hall_factors_.size() ||
+           std::adjacent_find(hall_factor_fields_.begin(), hall_factor_fields_.end(), std::greater_equal<>()) !=
+               hall_factor_fields_.end()) {
+            throw InvalidValueError(config_,
+                                    "hall_factor_fields",
+                                    "one strictly increasing electric field per tabulated Hall factor is required");
+        }
+    }
+
     auto temperature = config_.get<double>("temperature");
     boltzmann_kT_ = Units::get(8.6173333e-5, "eV/K") * temperature;
 
@@ -94,8 +149,14 @@ ProjectionPropagationModule::ProjectionPropagationModule(Configuration& config,
 }
 
 void ProjectionPropagationModule::initialize() {
-    if(detector_->getElectricFieldType() != FieldType::LINEAR) {
-        throw ModuleError("This module should only be used with linear electric fields.");
+    // The drift time is calculated analytically for linear fields and integrated along the sensor thickness otherwise
+    linear_field_ = (detector_->getElectricFieldType() == FieldType::LINEAR);
+    if(!linear_field_) {
+        LOG(INFO) << "Electric field is not linear, integrating the drift per cell of the pixel plane on first use";
+        auto [reference_x, reference_y] = model_->getPixelIndex(model_->getMatrixCenter());
+        reference_pixel_center_ = model_->getPixelCenter(reference_x, reference_y);
+        field_lines_.resize(field_cache_bins_[0] * field_cache_bins_[1]);
+        field_lines_built_ = std::make_unique<std::once_flag[]>(field_lines_.size());
     }
 
     if(detector_->hasDopingProfile() && detector_->getDopingProfileType() != FieldType::CONSTANT) {
@@ -105,11 +166,16 @@ void ProjectionPropagationModule::initialize() {
     // Prepare recombination model
     recombination_ = Recombination(config_, detector_->hasDopingProfile());
 
-    if(detector_->hasMagneticField() && !config_.get<bool>("ignore_magnetic_field")) {
-        throw ModuleError("This module should not be used with magnetic fields. Add the option 'ignore_magnetic_field' to "
-                          "the configuration if you would like to continue.");
-    } else if(detector_->hasMagneticField() && config_.get<bool>("ignore_magnetic_field")) {
-        LOG(WARNING) << "A magnetic field is switched on, but is set to be ignored for this module.";
+    // The magnetic field is constant across the sensor, the Lorentz drift is applied along the projected path
+    has_magnetic_field_ = detector_->hasMagneticField();
+    if(has_magnetic_field_) {
+        if(config_.get<bool>("ignore_magnetic_field")) {
+            has_magnetic_field_ = false;
+            LOG(WARNING) << "A magnetic field is switched on, but is set to be ignored for this module.";
+        } else {
+            magnetic_field_ = detector_->getMagneticField(model_->getSensorCenter());
+            LOG(INFO) << "Applying Lorentz drift in magnetic field of " << Units::display(magnetic_field_, {"T", "mT"});
+        }
     }
 
     // Find correct top side
@@ -170,12 +236,163 @@ void ProjectionPropagationModule::initialize() {
     }
 }
 
+const ProjectionPropagationModule::FieldLine&
+ProjectionPropagationModule::get_field_line(const ROOT::Math::XYZPoint& position) const {
+    auto cell = [this](double offset, double size, size_t axis) {
+        auto index = static_cast<long>(std::floor((offset / size + 0.5) * static_cast<double>(field_cache_bins_[axis])));
+        return static_cast<size_t>(std::clamp<long>(index, 0, static_cast<long>(field_cache_bins_[axis]) - 1));
+    };
+
+    // The cells span one pixel, positions are looked up relative to the center of their pixel
+    auto [pixel_x, pixel_y] = model_->getPixelIndex(position);
+    auto pixel_center = model_->getPixelCenter(pixel_x, pixel_y);
+    auto x = cell(position.x() - pixel_center.x(), model_->getPixelSize().x(), 0);
+    auto y = cell(position.y() - pixel_center.y(), model_->getPixelSize().y(), 1);
+    auto index = x * field_cache_bins_[1] + y;
+
+    std::call_once(field_lines_built_[index], [&]() {
+        auto& line = field_lines_[index];
+        const auto nodes = field_cache_bins_[2];
+        line.time.assign(nodes + 1, 0.);
+        line.offset.assign(nodes + 1, ROOT::Math::XYVector());
+        line.variance.assign(nodes + 1, 0.);
+
+        // Integrate along the center of the cell in the central pixel of the matrix, from the collecting side downwards
+        auto cell_center = [this](size_t bin, size_t axis) {
+            return (static_cast<double>(bin) + 0.5) / static_cast<double>(field_cache_bins_[axis]) - 0.5;
+        };
+        auto column_x = reference_pixel_center_.x() + cell_center(x, 0) * model_->getPixelSize().x();
+        auto column_y = reference_pixel_center_.y() + cell_center(y, 1) * model_->getPixelSize().y();
+        auto step = 2 * top_z_ / static_cast<double>(nodes);
+        for(size_t node = nodes; node > 0; --node) {
+            auto point = ROOT::Math::XYZPoint(column_x, column_y, -top_z_ + (static_cast<double>(node) - 0.5) * step);
+            auto efield = detector_->getElectricField(point);
+            auto doping = detector_->getDopingConcentration(point);
+            auto mobility = (*mobility_)(propagate_type_, std::sqrt(efield.Mag2()), doping);
+            auto velocity = drift_velocity(efield, mobility);
+
+            // Charge carriers not drifting towards the collecting side never arrive
+            auto velocity_z = (top_z_ > 0 ? velocity.z() : -velocity.z());
+            if(velocity_z <= 0 || !std::isfinite(line.time[node])) {
+                line.time[node - 1] = std::numeric_limits<double>::infinity();
+                continue;
+            }
+            auto time = std::fabs(step) / velocity_z;
+            line.time[node - 1] = line.time[node] + time;
+            line.offset[node - 1] = line.offset[node] + ROOT::Math::XYVector(velocity.x(), velocity.y()) * time;
+            line.variance[node - 1] = line.variance[node] + 2. * boltzmann_kT_ * mobility * time;
+        }
+    });
+    return field_lines_[index];
+}
+
+double ProjectionPropagationModule::hall_factor(double efield) const {
+    if(hall_factors_.size() == 1) {
+        return hall_factors_.front();
+    }
+
+    // Interpolate linearly between the tabulated fields, the factors at the ends of the table are kept beyond them
+    auto upper = std::upper_bound(hall_factor_fields_.begin(), hall_factor_fields_.end(), efield);
+    if(upper == hall_factor_fields_.begin()) {
+        return hall_factors_.front();
+    }
+    if(upper == hall_factor_fields_.end()) {
+        return hall_factors_.back();
+    }
+    auto index = static_cast<size_t>(upper - hall_factor_fields_.begin());
+    auto weight = (efield - hall_factor_fields_[index - 1]) / (hall_factor_fields_[index] - hall_factor_fields_[index - 1]);
+    return (1 - weight) * hall_factors_[index - 1] + weight * hall_factors_[index];
+}
+
+ROOT::Math::XYZVector ProjectionPropagationModule::drift_velocity(const ROOT::Math::XYZVector& efield,
+                                                                  double mobility) const {
+    auto sign = static_cast<int>(propagate_type_);
+    if(!has_magnetic_field_) {
+        return sign * mobility * efield;
+    }
+
+    // Drift velocity in electric and magnetic field with the Hall mobility, as in the GenericPropagation module
+    const auto& bfield = magnetic_field_;
+    auto hall_mobility = hall_factor(std::sqrt(efield.Mag2())) * mobility;
+    auto hall_mobility2 = hall_mobility * hall_mobility;
+    return sign * mobility *
+           (efield + sign * hall_mobility * efield.Cross(bfield) + hall_mobility2 * efield.Dot(bfield) * bfield) /
+           (1 + hall_mobility2 * bfield.Mag2());
+}
+
+void ProjectionPropagationModule::share_charge(const ROOT::Math::XYZPoint& center,
+                                               double sigma,
+                                               unsigned int charge,
+                                               PixelMap<double>& pixel_charges,
+                                               RandomNumberGenerator& random_engine) const {
+    // Fractions of the charge cloud per pixel column or row within the range of the cloud, pixel i spans (i -/+ 0.5) * pitch
+    auto axis_fractions = [sigma](double position, double pitch, unsigned int pixels, std::vector<double>& fractions) {
+        fractions.clear();
+        auto range = charge_sharing_range * sigma;
+        auto first = std::max(0, static_cast<int>(std::lround((position - range) / pitch)));
+        auto last = std::min(static_cast<int>(pixels) - 1, static_cast<int>(std::lround((position + range) / pitch)));
+
+        // Probability of the charge carriers to end up below the lower edge of pixel i
+        auto below_edge = [&](int i) {
+            auto edge = (i - 0.5) * pitch;
+            if(sigma > 0) {
+                return 0.5 * std::erfc((position - edge) / (std::sqrt(2.) * sigma));
+            }
+            return edge > position ? 1. : 0.;
+        };
+        auto lower = below_edge(first);
+        for(int i = first; i <= last; ++i) {
+            auto upper = below_edge(i + 1);
+            fractions.push_back(upper - lower);
+            lower = upper;
+        }
+        return first;
+    };
+
+    thread_local std::vector<double> fractions_x, fractions_y;
+    auto first_x = axis_fractions(center.x(), model_->getPixelSize().x(), model_->getNPixels().x(), fractions_x);
+    auto first_y = axis_fractions(center.y(), model_->getPixelSize().y(), model_->getNPixels().y(), fractions_y);
+
+    // Binomial fluctuations distribute the carriers multinomially via successive draws, the remainder is lost outside
+    auto remaining_charge = charge;
+    auto remaining_probability = 1.;
+    for(size_t x = 0; x < fractions_x.size(); ++x) {
+        for(size_t y = 0; y < fractions_y.size(); ++y) {
+            auto probability = fractions_x[x] * fractions_y[y];
+            if(probability <= 0) {
+                continue;
+            }
+
+            auto shared_charge = charge * probability;
+            if(charge_sharing_fluctuations_ == ChargeSharingFluctuations::BINOMIAL) {
+                if(remaining_charge == 0 || remaining_probability <= 0) {
+                    return;
+                }
+                allpix::binomial_distribution<unsigned int, double> binomial(
+                    remaining_charge, std::min(1., probability / remaining_probability));
+                auto drawn_charge = binomial(random_engine);
+                remaining_charge -= drawn_charge;
+                remaining_probability -= probability;
+                shared_charge = drawn_charge;
+            }
+
+            if(shared_charge > 0) {
+                pixel_charges[{first_x + static_cast<int>(x), first_y + static_cast<int>(y)}] += shared_charge;
+            }
+        }
+    }
+}
+
 void ProjectionPropagationModule::run(Event* event) {
     auto deposits_message = messenger_->fetchMessage<DepositedChargeMessage>(this, event);
 
     // Create vector of propagated charges to output
     std::vector<PropagatedCharge> propagated_charges;
 
+    // Charge per pixel shared analytically among the pixels
+    thread_local PixelMap<double> pixel_map;
+    pixel_map.clear();
+
     unsigned int charge_lost = 0;
     unsigned int total_charge = 0;
     unsigned int total_projected_charge = 0;
@@ -187,11 +404,11 @@ void ProjectionPropagationModule::run(Event* event) {
     // Loop over all deposits for propagation
     for(const auto& deposit : deposits_message->getData()) {
 
-        auto type = deposit.getType();
+        auto type = propagate_type_;
         auto initial_position = deposit.getLocalPosition();
 
-        // Selection of charge carrier:
-        if(type != propagate_type_) {
+        // Selection of charge carrier, deposits of electron-hole pairs hold both types:
+        if(!deposit.hasCarrier(type)) {
             continue;
         }
 
@@ -206,7 +423,9 @@ void ProjectionPropagationModule::run(Event* event) {
         total_charge += charges_remaining;
 
         auto charge_per_step = charge_per_step_;
-        if(max_charge_groups_ > 0 && deposit.getCharge() / charge_per_step > max_charge_groups_) {
+        if(charge_sharing_ == ChargeSharing::ANALYTIC && !sample_groups_) {
+            charge_per_step = deposit.getCharge();
+        } else if(max_charge_groups_ > 0 && deposit.getCharge() / charge_per_step > max_charge_groups_) {
             charge_per_step = static_cast<unsigned int>(ceil(static_cast<double>(deposit.getCharge()) / max_charge_groups_));
             deposits_exceeding_max_groups_++;
             LOG(INFO) << "Deposited charge: " << deposit.getCharge()
@@ -222,12 +441,11 @@ void ProjectionPropagationModule::run(Event* event) {
             auto position = initial_position;
 
             // Add point of deposition to the output plots if requested
+            size_t output_plot_index = 0;
             if(output_linegraphs_) {
-                output_plot_points.emplace_back(
-                    std::make_tuple(deposit.getGlobalTime(), charge_per_step, deposit.getType(), CarrierState::HALTED),
-                    std::vector<ROOT::Math::XYZPoint>());
-
-                output_plot_points.back().second.push_back(initial_position);
+                output_plot_index = output_plot_points.addTrajectory(
+                    deposit.getGlobalTime(), charge_per_step, type, CarrierState::HALTED);
+                output_plot_points.addPoint(output_plot_index, initial_position);
             }
 
             // Get the electric field at the position of the deposited charge and the top of the sensor:
@@ -265,7 +483,7 @@ void ProjectionPropagationModule::run(Event* event) {
 
                     // Add position after diffusion to line graphs:
                     if(output_linegraphs_) {
-                        output_plot_points.back().second.push_back(local_position_diffusion);
+                        output_plot_points.addPoint(output_plot_index, local_position_diffusion);
                     }
 
                     continue;
@@ -299,7 +517,7 @@ void ProjectionPropagationModule::run(Event* event) {
                     // Add position at sensor intercept:
                     if(output_linegraphs_) {
                         auto intercept = detector_->getModel()->getSensorIntercept(initial_position, position);
-                        output_plot_points.back().second.push_back(intercept);
+                        output_plot_points.addPoint(output_plot_index, intercept);
                     }
 
                     continue;
@@ -307,7 +525,7 @@ void ProjectionPropagationModule::run(Event* event) {
 
                 // Add potential position after diffusion to line graphs:
                 if(output_linegraphs_) {
-                    output_plot_points.back().second.push_back(position);
+                    output_plot_points.addPoint(output_plot_index, position);
                 }
 
                 LOG(TRACE) << "Charge diffused to position: " << Units::display(position, {"mm", "um"});
@@ -318,26 +536,71 @@ void ProjectionPropagationModule::run(Event* event) {
             LOG(TRACE) << "Electric field at carrier position / top of the sensor: "
                        << Units::display(efield_mag_top, "V/cm") << " , " << Units::display(efield_mag, "V/cm");
 
-            auto slope_efield = (efield_mag_top - efield_mag) / (std::abs(top_z_ - position.z()));
-
-            // Calculate the drift time
-            auto calc_drift_time = [&]() {
-                if(position.z() == top_z_) {
-                    return 0.;
-                }
-
-                double Ec = (type == CarrierType::ELECTRON ? electron_Ec_ : hole_Ec_);
+            double drift_time = 0;
+            double diffusion_std_dev = 0;
+            ROOT::Math::XYVector drift_offset;
+            if(linear_field_) {
+                auto slope_efield = (efield_mag_top - efield_mag) / (std::abs(top_z_ - position.z()));
 
-                return ((log(efield_mag_top) - log(efield_mag)) / slope_efield + std::abs(top_z_ - position.z()) / Ec) /
-                       (*mobility_)(type, 0, doping);
-            };
-            LOG(TRACE) << "Electric field is " << Units::display(efield_mag, "V/cm");
+                // Calculate the drift time
+                auto calc_drift_time = [&]() {
+                    if(position.z() == top_z_) {
+                        return 0.;
+                    }
 
-            // Assume linear electric field over the depleted part of the sensor
-            double diffusion_constant =
-                boltzmann_kT_ * ((*mobility_)(type, efield_mag, doping) + (*mobility_)(type, efield_mag_top, doping)) / 2.;
+                    double Ec = (type == CarrierType::ELECTRON ? electron_Ec_ : hole_Ec_);
 
-            double drift_time = calc_drift_time();
+                    return ((log(efield_mag_top) - log(efield_mag)) / slope_efield +
+                            std::abs(top_z_ - position.z()) / Ec) /
+                           (*mobility_)(type, 0, doping);
+                };
+                LOG(TRACE) << "Electric field is " << Units::display(efield_mag, "V/cm");
+
+                // Assume linear electric field over the depleted part of the sensor
+                double diffusion_constant =
+                    boltzmann_kT_ * ((*mobility_)(type, efield_mag, doping) + (*mobility_)(type, efield_mag_top, doping)) /
+                    2.;
+
+                drift_time = calc_drift_time();
+                diffusion_std_dev = std::sqrt(2. * diffusion_constant * drift_time);
+
+                if(has_magnetic_field_) {
+                    // Lorentz angle of the drift along the field in z, with the Hall mobility averaged over the path. The
+                    // magnetic field component along the drift slows down the deflection, perpendicular components slow
+                    // down the drift itself
+                    auto hall_mobility =
+                        (hall_factor(efield_mag) * (*mobility_)(type, efield_mag, doping) +
+                         hall_factor(efield_mag_top) * (*mobility_)(type, efield_mag_top, doping)) /
+                        2.;
+                    auto hall_mobility2 = hall_mobility * hall_mobility;
+                    const auto& bfield = magnetic_field_;
+                    auto sign = static_cast<int>(type);
+                    auto longitudinal = 1 + hall_mobility2 * bfield.z() * bfield.z();
+                    auto tan_lorentz = ROOT::Math::XYVector(-sign * hall_mobility * bfield.y() +
+                                                                hall_mobility2 * bfield.z() * bfield.x(),
+                                                            sign * hall_mobility * bfield.x() +
+                                                                hall_mobility2 * bfield.z() * bfield.y()) /
+                                       longitudinal;
+                    drift_offset = tan_lorentz * (top_z_ - position.z());
+                    drift_time *= (1 + hall_mobility2 * bfield.Mag2()) / longitudinal;
+                    LOG(TRACE) << "Lorentz drift offset is " << Units::display(drift_offset, {"um", "nm"});
+                }
+            } else {
+                // Interpolate the drift integrated along the sensor thickness between the neighboring nodes
+                const auto& line = get_field_line(position);
+                const auto nodes = static_cast<double>(field_cache_bins_[2]);
+                auto depth = std::clamp((position.z() + top_z_) / (2 * top_z_) * nodes, 0., nodes);
+                auto node = std::min(static_cast<size_t>(depth), field_cache_bins_[2] - 1);
+                auto weight = depth - static_cast<double>(node);
+                if(!std::isfinite(line.time[node])) {
+                    LOG(DEBUG) << "Charge carriers at " << Units::display(position, {"mm", "um"})
+                               << " do not drift to the collecting side";
+                    continue;
+                }
+                drift_time = (1 - weight) * line.time[node] + weight * line.time[node + 1];
+                drift_offset = (1 - weight) * line.offset[node] + weight * line.offset[node + 1];
+                diffusion_std_dev = std::sqrt((1 - weight) * line.variance[node] + weight * line.variance[node + 1]);
+            }
             double propagation_time = drift_time + diffusion_time;
             LOG(TRACE) << "Drift time is " << Units::display(drift_time, "ns");
 
@@ -349,7 +612,6 @@ void ProjectionPropagationModule::run(Event* event) {
                 }
             }
 
-            double diffusion_std_dev = std::sqrt(2. * diffusion_constant * drift_time);
             LOG(TRACE) << "Diffusion width is " << Units::display(diffusion_std_dev, "um");
 
             // Check if charge carrier is still alive via its survival probability, evaluated once
@@ -362,12 +624,41 @@ void ProjectionPropagationModule::run(Event* event) {
                 continue;
             }
 
+            if(charge_sharing_ == ChargeSharing::ANALYTIC) {
+                auto local_time = deposit.getLocalTime() + propagation_time;
+                if(local_time > integration_time_) {
+                    LOG(DEBUG) << "Charge carriers propagation time not within integration time: "
+                               << Units::display(local_time, {"ns", "ps"}) << " local";
+                    continue;
+                }
+
+                // Share the group among the pixels around its projected position instead of sampling its diffusion
+                auto center = ROOT::Math::XYZPoint(position.x() + drift_offset.x(), position.y() + drift_offset.y(), top_z_);
+                if(output_linegraphs_) {
+                    output_plot_points.addPoint(output_plot_index, center);
+                }
+                if(output_plots_) {
+                    initial_position_histo_->Fill(static_cast<double>(Units::convert(initial_position.z(), "um")),
+                                                  charge_per_step);
+                    group_size_histo_->Fill(charge_per_step);
+                }
+
+                share_charge(center, diffusion_std_dev, charge_per_step, pixel_map, event->getRandomEngine());
+                LOG(DEBUG) << "Shared " << charge_per_step << " " << type << " around "
+                           << Units::display(center, {"mm", "um"}) << " with a diffusion width of "
+                           << Units::display(diffusion_std_dev, "um");
+
+                projected_charge += charge_per_step;
+                continue;
+            }
+
             allpix::normal_distribution<double> gauss_distribution(0, diffusion_std_dev);
             double diffusion_x = gauss_distribution(event->getRandomEngine());
             double diffusion_y = gauss_distribution(event->getRandomEngine());
 
             // Find projected position
-            auto local_position = ROOT::Math::XYZPoint(position.x() + diffusion_x, position.y() + diffusion_y, top_z_);
+            auto local_position = ROOT::Math::XYZPoint(
+                position.x() + drift_offset.x() + diffusion_x, position.y() + drift_offset.y() + diffusion_y, top_z_);
 
             auto global_time = deposit.getGlobalTime() + propagation_time;
             auto local_time = deposit.getLocalTime() + propagation_time;
@@ -389,7 +680,7 @@ void ProjectionPropagationModule::run(Event* event) {
 
             // Finalize line graph by adding final position
             if(output_linegraphs_) {
-                output_plot_points.back().second.push_back(local_position);
+                output_plot_points.addPoint(output_plot_index, local_position);
             }
 
             if(output_plots_) {
@@ -403,7 +694,7 @@ void ProjectionPropagationModule::run(Event* event) {
             // Produce charge carrier at this position
             propagated_charges.emplace_back(local_position,
                                             global_position,
-                                            deposit.getType(),
+                                            type,
                                             charge_per_step,
                                             local_time,
                                             global_time,
@@ -423,17 +714,48 @@ void ProjectionPropagationModule::run(Event* event) {
     LOG(INFO) << "Total charge: " << total_charge << " (lost: " << charge_lost << ", "
               << (total_charge > 0 ? (charge_lost / total_charge * 100.) : 0) << "%)";
 
-    LOG(DEBUG) << "Total count of propagated charge carriers: " << propagated_charges.size();
-
     // Output plots if required
     if(output_linegraphs_) {
-        LineGraph::Create(event->number, this, config_, output_plot_points, CarrierState::UNKNOWN);
+        LineGraph::Create(event->number, this, plot_settings_, output_plot_points, CarrierState::UNKNOWN);
     }
 
     if(output_plots_) {
         recombine_histo_->Fill(total_charge > 0 ? (static_cast<double>(recombined_charges_count) / total_charge) : 0.);
     }
 
+    if(charge_sharing_ == ChargeSharing::ANALYTIC) {
+        // Create pixel charges from the shared charge, applying the requested fluctuations
+        pixel_map.sort();
+        std::vector<PixelCharge> pixel_charges;
+        pixel_charges.reserve(pixel_map.size());
+        for(const auto& [index, expected_charge] : pixel_map) {
+            long charge = 0;
+            if(charge_sharing_fluctuations_ == ChargeSharingFluctuations::POISSON) {
+                allpix::poisson_distribution<long> poisson(expected_charge);
+                charge = poisson(event->getRandomEngine());
+            } else {
+                charge = std::lround(expected_charge);
+            }
+            if(charge == 0) {
+                continue;
+            }
+
+            auto pixel = detector_->getPixel(index.x(), index.y());
+            pixel_charges.emplace_back(pixel, static_cast<int>(propagate_type_) * charge);
+            LOG(DEBUG) << "Set of " << charge << " charges shared to pixel " << index;
+        }
+
+        LOG(INFO) << "Distributed " << total_projected_charge << " charge carriers analytically among "
+                  << pixel_charges.size() << " pixels";
+
+        // Dispatch the message with pixel charges
+        auto pixel_charge_message = std::make_shared<PixelChargeMessage>(std::move(pixel_charges), detector_);
+        messenger_->dispatchMessage(this, std::move(pixel_charge_message), event);
+        return;
+    }
+
+    LOG(DEBUG) << "Total count of propagated charge carriers: " << propagated_charges.size();
+
     // Create a new message with propagated charges
     auto propagated_charge_message = std::make_shared<PropagatedChargeMessage>(std::move(propagated_charges), detector_);
 
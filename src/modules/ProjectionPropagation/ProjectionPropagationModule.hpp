@@ -13,8 +13,14 @@
  * Refer to the User's Manual for more details.
  */
 
+#include <array>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
+#include <Math/Vector2D.h>
+#include <Math/Vector3D.h>
 #include <TH1D.h>
 
 #include "core/config/Configuration.hpp"
@@ -24,6 +30,7 @@
 #include "core/module/Module.hpp"
 
 #include "objects/DepositedCharge.hpp"
+#include "objects/PixelCharge.hpp"
 #include "objects/PropagatedCharge.hpp"
 
 #include "physics/Mobility.hpp"
@@ -31,6 +38,7 @@
 
 #include "tools/ROOT.h"
 #include "tools/line_graphs.h"
+#include "tools/pixel_map.h"
 
 namespace allpix {
     /**
@@ -67,26 +75,111 @@ namespace allpix {
         void finalize() override;
 
     private:
+        /**
+         * @brief Methods to distribute the projected charge carriers among the pixels
+         */
+        enum class ChargeSharing {
+            SAMPLED,  ///< Sample the diffusion per group of charge carriers and output the propagated charges
+            ANALYTIC, ///< Integrate the diffusion over the pixels around each group and output the pixel charges
+        };
+
+        /**
+         * @brief Fluctuations applied to the charge shared analytically among the pixels
+         */
+        enum class ChargeSharingFluctuations {
+            NONE,     ///< Expected charge per pixel, rounded to full charge carriers
+            BINOMIAL, ///< Multinomial distribution of the charge carriers of each group among the pixels
+            POISSON,  ///< Poisson distribution of the expected charge per pixel
+        };
+
+        /**
+         * @brief Drift integrated along the sensor thickness for one cell of the pixel plane
+         *
+         * All quantities are integrated from the opposite side of the sensor up to each of the equidistant nodes along the
+         * thickness, such that the drift from any depth to the collecting side follows from the difference to the last node.
+         */
+        struct FieldLine {
+            std::vector<double> time;                 ///< Integrated drift time
+            std::vector<ROOT::Math::XYVector> offset; ///< Integrated lateral displacement
+            std::vector<double> variance;             ///< Integrated variance of the lateral diffusion
+        };
+
+        /**
+         * @brief Get the integrated drift for the cell of the pixel plane containing a position, integrating it on first use
+         * @param position Position in local coordinates
+         * @return Integrated drift for the cell of the position relative to the center of its pixel
+         */
+        const FieldLine& get_field_line(const ROOT::Math::XYZPoint& position) const;
+
+        /**
+         * @brief Share a group of charge carriers among the pixels around its projected position
+         * @param center Projected position of the group on the collecting side of the sensor
+         * @param sigma Width of the lateral diffusion of the group
+         * @param charge Number of charge carriers in the group
+         * @param pixel_charges Map of the charge per pixel to add the shares of the group to
+         * @param random_engine Random engine used for binomial fluctuations
+         *
+         * The Gaussian charge cloud factorizes into x and y, the fraction collected by each pixel is therefore given by the
+         * product of the differences of the error function over its edges along both axes.
+         */
+        void share_charge(const ROOT::Math::XYZPoint& center,
+                          double sigma,
+                          unsigned int charge,
+                          PixelMap<double>& pixel_charges,
+                          RandomNumberGenerator& random_engine) const;
+
+        /**
+         * @brief Get the Hall scattering factor of the propagated carriers, interpolated in the table if configured
+         * @param efield Magnitude of the electric field
+         * @return Ratio of the Hall mobility to the drift mobility
+         */
+        double hall_factor(double efield) const;
+
+        /**
+         * @brief Calculate the drift velocity of the propagated carriers, including the Lorentz drift in the magnetic field
+         * @param efield Electric field at the position of the carriers
+         * @param mobility Mobility of the carriers at the position
+         * @return Drift velocity
+         */
+        ROOT::Math::XYZVector drift_velocity(const ROOT::Math::XYZVector& efield, double mobility) const;
+
         Messenger* messenger_;
         std::shared_ptr<const Detector> detector_;
         std::shared_ptr<DetectorModel> model_;
 
         // Config parameters
         bool output_plots_{}, output_linegraphs_{};
+        LineGraph::PlotSettings plot_settings_;
         double integration_time_{};
         bool diffuse_deposit_;
         unsigned int charge_per_step_{};
         unsigned int max_charge_groups_{};
+        ChargeSharing charge_sharing_{};
+        ChargeSharingFluctuations charge_sharing_fluctuations_{};
+        bool sample_groups_{};
 
         // Carrier type to be propagated
         CarrierType propagate_type_;
         // Side to propagate too
         double top_z_;
 
+        // Constant magnetic field of the detector and Hall factors, optionally tabulated versus the electric field
+        bool has_magnetic_field_{};
+        ROOT::Math::XYZVector magnetic_field_;
+        std::vector<double> hall_factors_;
+        std::vector<double> hall_factor_fields_;
+
         // Precalculated values for electron and hole critical fields
         double hole_Ec_;
         double electron_Ec_;
 
+        // Cache of the drift along the thickness per cell of the pixel plane for non-linear electric fields
+        bool linear_field_{};
+        std::array<size_t, 3> field_cache_bins_{};
+        ROOT::Math::XYZPoint reference_pixel_center_;
+        mutable std::vector<FieldLine> field_lines_;
+        std::unique_ptr<std::once_flag[]> field_lines_built_;
+
         // Models for electron and hole mobility and lifetime
         std::unique_ptr<JacoboniCanali> mobility_;
         Recombination recombination_;
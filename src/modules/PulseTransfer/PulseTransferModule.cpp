@@ -14,8 +14,8 @@
 #include "core/utils/log.h"
 #include "objects/PixelCharge.hpp"
 #include "objects/exceptions.h"
+#include "tools/pixel_map.h"
 
-#include <set>
 #include <string>
 #include <utility>
 
@@ -94,13 +94,13 @@ void PulseTransferModule::initialize() {
 void PulseTransferModule::run(Event* event) {
     auto propagated_message = messenger_->fetchMessage<PropagatedChargeMessage>(this, event);
 
-    // Create map for all pixels: pulse and propagated charges
-    std::map<Pixel::Index, Pulse> pixel_pulse_map;
-    std::map<Pixel::Index, std::set<const PropagatedCharge*>> pixel_charge_map;
+    // Create map for all pixels: pulse and propagated charges, reusing the map of this thread across events
+    thread_local PixelMap<std::pair<Pulse, std::vector<const PropagatedCharge*>>> pixel_map;
+    pixel_map.clear();
 
     LOG(DEBUG) << "Received " << propagated_message->getData().size() << " propagated charge objects.";
     for(const auto& propagated_charge : propagated_message->getData()) {
-        auto pulses = propagated_charge.getPulses();
+        const auto& pulses = propagated_charge.getPulses();
 
         if(pulses.empty()) {
             LOG_ONCE(INFO) << "No pulse information available - producing pseudo-pulse from arrival time of charge carriers";
@@ -123,7 +123,7 @@ void PulseTransferModule::run(Event* event) {
                 });
 
                 // Ignore if outside the implant region:
-                if(!model->isWithinImplant(position)) {
+                if(!model->findImplant(position)) {
                     LOG(TRACE) << "Skipping set of " << propagated_charge.getCharge() << " propagated charges at "
                                << Units::display(propagated_charge.getLocalPosition(), {"mm", "um"})
                                << " because their local position is outside the pixel implant";
@@ -151,40 +151,49 @@ void PulseTransferModule::run(Event* event) {
 
             Pixel::Index pixel_index(xpixel, ypixel);
 
-            // Generate pseudo-pulse:
-            Pulse pulse(timestep_);
+            // Add the charge as pseudo-pulse directly to the pulse of the pixel, which like accumulated pulses keeps all
+            // bins from the start of the time axis:
+            auto& [pixel_pulse, pixel_propagated_charges] = pixel_map[pixel_index];
+            if(!pixel_pulse.isInitialized()) {
+                pixel_pulse = Pulse(timestep_);
+            }
             try {
-                pulse.addCharge(static_cast<double>(propagated_charge.getSign() * propagated_charge.getCharge()),
-                                propagated_charge.getLocalTime());
+                auto bin = pixel_pulse.getBin(propagated_charge.getLocalTime());
+                pixel_pulse.extend(0, bin + 1);
+                pixel_pulse.addChargeToBin(
+                    static_cast<double>(propagated_charge.getSign() * propagated_charge.getCharge()), bin);
             } catch(const PulseBadAllocException& e) {
                 LOG(ERROR) << e.what() << std::endl
                            << "Ignoring pulse contribution at time "
                            << Units::display(propagated_charge.getLocalTime(), {"ms", "us", "ns"});
             }
-            pixel_pulse_map[pixel_index] += pulse;
 
             // For each pulse, store the corresponding propagated charges to preserve history:
-            pixel_charge_map[pixel_index].emplace(&propagated_charge);
+            pixel_propagated_charges.emplace_back(&propagated_charge);
         } else {
             LOG(TRACE) << "Found pulse information";
             LOG_ONCE(INFO) << "Pulses available - settings \"timestep\", \"max_depth_distance\" and "
                               "\"collect_from_implant\" have no effect";
 
-            for(auto& [pixel_index, pulse] : pulses) {
+            for(const auto& [pixel_index, pulse] : pulses) {
                 // Accumulate all pulses from input message data:
-                pixel_pulse_map[pixel_index] += pulse;
+                auto& [pixel_pulse, pixel_propagated_charges] = pixel_map[pixel_index];
+                pixel_pulse += pulse;
 
-                // For each pulse, store the corresponding propagated charges to preserve history:
-                pixel_charge_map[pixel_index].emplace(&propagated_charge);
+                // For each pulse, store the corresponding propagated charges to preserve history, each propagated charge
+                // only holds a single pulse per pixel:
+                pixel_propagated_charges.emplace_back(&propagated_charge);
             }
         }
     }
 
     // Create vector of pixel pulses to return for this detector
+    pixel_map.sort();
     std::vector<PixelCharge> pixel_charges;
-    pixel_charges.reserve(pixel_pulse_map.size());
+    pixel_charges.reserve(pixel_map.size());
     Pulse total_pulse;
-    for(auto& [index, pulse] : pixel_pulse_map) {
+    for(auto& [index, pixel_entry] : pixel_map) {
+        auto& [pulse, pixel_charge_vec] = pixel_entry;
         // Sum all pulses for informational output:
         total_pulse += pulse;
 
@@ -192,11 +201,10 @@ void PulseTransferModule::run(Event* event) {
         if(output_plots_) {
             h_induced_pixel_charge_->Fill(pulse.getCharge() / 1e3);
 
-            auto step = pulse.getBinning();
             double charge = 0;
 
             for(auto bin = pulse.begin(); bin != pulse.end(); ++bin) {
-                auto time = step * static_cast<double>(std::distance(pulse.begin(), bin));
+                auto time = pulse.getBinTime(pulse.getOffset() + static_cast<size_t>(std::distance(pulse.begin(), bin)));
                 h_induced_pulses_->Fill(time, *bin);
                 p_induced_pulses_->Fill(time, *bin);
 
@@ -212,8 +220,6 @@ void PulseTransferModule::run(Event* event) {
         }
 
         // Store the pulse:
-        std::vector<const PropagatedCharge*> pixel_charge_vec(pixel_charge_map[index].begin(),
-                                                              pixel_charge_map[index].end());
         LOG(DEBUG) << "Charge on pixel " << index << " has " << pixel_charge_vec.size() << " ancestors";
         pixel_charges.emplace_back(detector_->getPixel(index), std::move(pulse), std::move(pixel_charge_vec));
     }
@@ -232,8 +238,9 @@ void PulseTransferModule::run(Event* event) {
                                     -0.5,
                                     static_cast<int>(size.y()) - 0.5);
 
-        for(auto& [index, pulse] : pixel_pulse_map) {
-            charge_map->Fill(index.x(), index.y(), pulse.getCharge());
+        for(const auto& pixel_charge : pixel_charges) {
+            auto index = pixel_charge.getPixel().getIndex();
+            charge_map->Fill(index.x(), index.y(), pixel_charge.getPulse().getCharge());
         }
         getROOTDirectory()->WriteTObject(charge_map, name.c_str());
     }
@@ -269,11 +276,11 @@ void PulseTransferModule::create_pulsegraphs(uint64_t event_num, const Pixel::In
     LOG(TRACE) << "Preparing pulse for pixel " << index << ", " << pulse.size() << " bins of "
                << Units::display(step, {"ps", "ns"}) << ", total charge: " << Units::display(pulse.getCharge(), "e");
 
-    // Generate x-axis:
+    // Generate x-axis from the times of the bins, which are not equidistant for pulses with piecewise binning:
     std::vector<double> time(pulse.size());
-    // clang-format off
-    std::generate(time.begin(), time.end(), [n = 0.0, step]() mutable { auto now = n; n += step; return now; });
-    // clang-format on
+    for(size_t bin = 0; bin < pulse.size(); ++bin) {
+        time[bin] = pulse.getBinTime(pulse.getOffset() + bin);
+    }
 
     std::string name =
         "pulse_ev" + std::to_string(event_num) + "_px" + std::to_string(index.x()) + "-" + std::to_string(index.y());
@@ -300,10 +307,11 @@ void PulseTransferModule::create_pulsegraphs(uint64_t event_num, const Pixel::In
     getROOTDirectory()->WriteTObject(pulse_abs_graph, name.c_str());
 
     auto current_vec = pulse;
-    // Convert charge bins to current in uA
-    std::for_each(current_vec.begin(), current_vec.end(), [step](auto& bin) {
-        bin = static_cast<double>(Units::convert(bin, "fC") / Units::convert(step, "ns"));
-    });
+    // Convert charge bins to current in uA, using the length of every bin
+    for(size_t bin = 0; bin < current_vec.size(); ++bin) {
+        auto width = pulse.getBinWidth(pulse.getOffset() + bin);
+        current_vec[bin] = static_cast<double>(Units::convert(current_vec[bin], "fC") / Units::convert(width, "ns"));
+    }
 
     // Generate graphs of induced current over time:
     name = "current_ev" + std::to_string(event_num) + "_px" + std::to_string(index.x()) + "-" + std::to_string(index.y());
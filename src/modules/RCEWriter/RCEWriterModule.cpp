@@ -12,6 +12,7 @@
 #include "RCEWriterModule.hpp"
 
 #include <cassert>
+#include <deque>
 #include <filesystem>
 #include <fstream>
 #include <stdexcept>
@@ -308,6 +309,14 @@ RCEWriterModule::RCEWriterModule(Configuration& config, Messenger* messenger, Ge
     // Use default names in Proteus
     config_.setDefault("device_file", "device.toml");
     config_.setDefault("geometry_file", "geometry.toml");
+    config_.setDefault<bool>("write_asynchronously", false);
+    config_.setDefault<unsigned int>("write_queue_size", 16);
+
+    write_asynchronously_ = config_.get<bool>("write_asynchronously");
+    write_queue_size_ = config_.get<unsigned int>("write_queue_size");
+    if(write_queue_size_ == 0) {
+        throw InvalidValueError(config_, "write_queue_size", "queue needs to hold at least one event");
+    }
 }
 
 void RCEWriterModule::initialize() {
@@ -321,6 +330,9 @@ void RCEWriterModule::initialize() {
     // Open output data file
     std::string path_data = createOutputFile(config_.get<std::string>("file_name"), "root");
     output_file_ = std::make_unique<TFile>(path_data.c_str(), "RECREATE");
+    if(config_.has("compression_settings")) {
+        output_file_->SetCompressionSettings(config_.get<int>("compression_settings"));
+    }
     output_file_->cd();
 
     // Initialize the events tree
@@ -331,11 +343,15 @@ void RCEWriterModule::initialize() {
     event_tree_->Branch("TriggerOffset", &trigger_offset_);
     event_tree_->Branch("TriggerInfo", &trigger_info_);
     event_tree_->Branch("Invalid", &invalid_);
+    if(config_.has("auto_flush")) {
+        event_tree_->SetAutoFlush(config_.get<Long64_t>("auto_flush"));
+    }
 
     // For each detector name, initialize an instance of SensorData
     int det_index = 0;
     for(const auto& detector_name : detector_names) {
         auto& sensor = sensors_[detector_name];
+        sensor.index = static_cast<size_t>(det_index);
 
         LOG(TRACE) << "Sensor " << det_index << ", detector " << detector_name;
 
@@ -352,6 +368,11 @@ void RCEWriterModule::initialize() {
         sensor.tree->Branch("Value", &sensor.value_, "Value[NHits]/I");
         sensor.tree->Branch("Timing", &sensor.timing_, "Timing[NHits]/I");
         sensor.tree->Branch("HitInCluster", &sensor.hit_in_cluster_, "HitInCluster[NHits]/I");
+        if(config_.has("auto_flush")) {
+            sensor.tree->SetAutoFlush(config_.get<Long64_t>("auto_flush"));
+        }
+        // This contains no useful information but it expected to be present
+        sensor.hit_in_cluster_.fill(0);
 
         det_index += 1;
     }
@@ -360,62 +381,92 @@ void RCEWriterModule::initialize() {
     auto device_path = createOutputFile(config_.get<std::string>("device_file"), "toml");
     auto geometry_path = createOutputFile(config_.get<std::string>("geometry_file"), "toml");
     write_proteus_config(device_path, geometry_path, detector_names, *geo_mgr_, *getConfigManager());
+
+    if(write_asynchronously_) {
+        LOG(INFO) << "Writing events asynchronously, buffering up to " << write_queue_size_ << " events";
+        writer_.start(
+            write_queue_size_,
+            [this](std::deque<pending_event>& batch) {
+                for(const auto& pending : batch) {
+                    write_event(pending);
+                }
+            },
+            true);
+    }
 }
 
 void RCEWriterModule::run(Event* event) {
     auto pixel_hit_messages = messenger_->fetchMultiMessage<PixelHitMessage>(this, event);
 
-    // fill per-event data
-    timestamp_ = 0;
-    frame_number_ = event->number;
-    trigger_time_ = 0;
-    trigger_offset_ = 0;
-    trigger_info_ = 0;
-    invalid_ = false;
-    event_tree_->Fill();
-    LOG(TRACE) << "Wrote global event data";
-
-    // reset all per-sensor trees
-    for(auto& item : sensors_) {
-        item.second.nhits_ = 0;
+    // Reuse the hit vectors of an event already written if available
+    auto pending = writer_.acquire();
+    pending.frame_number = event->number;
+    pending.sensor_hits.resize(sensors_.size());
+    for(auto& hits : pending.sensor_hits) {
+        hits.clear();
     }
 
     // Loop over the pixel hit messages
     for(const auto& hit_msg : pixel_hit_messages) {
         const auto& detector_name = hit_msg->getDetector()->getName();
-        auto& sensor = sensors_[detector_name];
+        auto& hits = pending.sensor_hits[sensors_[detector_name].index];
 
         // Loop over all the hits
         for(const auto& hit : hit_msg->getData()) {
-            if(sensor_data::kMaxHits <= sensor.nhits_) {
+            if(static_cast<size_t>(sensor_data::kMaxHits) <= hits.size()) {
                 LOG(ERROR) << "More than " << sensor_data::kMaxHits << " in detector " << detector_name;
                 continue;
             }
 
-            // Fill the tree with received messages
-            auto i = static_cast<size_t>(sensor.nhits_);
-            sensor.pix_x_[i] = hit.getPixel().getIndex().x();
-            sensor.pix_y_[i] = hit.getPixel().getIndex().y();
-            sensor.value_[i] = static_cast<Int_t>(hit.getSignal());
             // Assumes that time is correctly digitized
-            sensor.timing_[i] = static_cast<Int_t>(hit.getLocalTime());
-            // This contains no useful information but it expected to be present
-            sensor.hit_in_cluster_[i] = 0;
-            sensor.nhits_ += 1;
+            hits.push_back({hit.getPixel().getIndex().x(),
+                            hit.getPixel().getIndex().y(),
+                            static_cast<Int_t>(hit.getSignal()),
+                            static_cast<Int_t>(hit.getLocalTime())});
 
             LOG(TRACE) << detector_name << " x=" << hit.getPixel().getIndex().x() << " y=" << hit.getPixel().getIndex().y()
                        << " t=" << hit.getLocalTime() << " signal=" << hit.getSignal();
         }
     }
 
-    // Loop over all the detectors to fill all corresponding sensor trees
+    if(write_asynchronously_) {
+        writer_.push(std::move(pending));
+    } else {
+        write_event(pending);
+        writer_.release(std::move(pending));
+    }
+}
+
+void RCEWriterModule::write_event(const pending_event& pending) {
+    // fill per-event data
+    timestamp_ = 0;
+    frame_number_ = pending.frame_number;
+    trigger_time_ = 0;
+    trigger_offset_ = 0;
+    trigger_info_ = 0;
+    invalid_ = false;
+    event_tree_->Fill();
+    LOG(TRACE) << "Wrote global event data";
+
+    // Copy the hits into the branch buffers and fill all corresponding sensor trees
     for(auto& item : sensors_) {
-        item.second.tree->Fill();
+        auto& sensor = item.second;
+        const auto& hits = pending.sensor_hits[sensor.index];
+        for(size_t i = 0; i < hits.size(); ++i) {
+            sensor.pix_x_[i] = hits[i].pix_x;
+            sensor.pix_y_[i] = hits[i].pix_y;
+            sensor.value_[i] = hits[i].value;
+            sensor.timing_[i] = hits[i].timing;
+        }
+        sensor.nhits_ = static_cast<Int_t>(hits.size());
+        sensor.tree->Fill();
         LOG(TRACE) << "Wrote sensor event data for " << item.first;
     }
 }
 
 void RCEWriterModule::finalize() {
+    writer_.finish();
+
     output_file_->Write();
     LOG(TRACE) << "Wrote data to file";
 }
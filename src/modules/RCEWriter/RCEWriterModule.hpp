@@ -11,6 +11,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include <TFile.h>
 #include <TTree.h>
@@ -24,6 +25,8 @@
 #include "core/module/Module.hpp"
 #include "objects/PixelHit.hpp"
 
+#include "tools/async_writer.h"
+
 namespace allpix {
     /**
      * @ingroup Modules
@@ -64,12 +67,33 @@ namespace allpix {
         void finalize() override;
 
     private:
+        // Single hit converted to the RCE format
+        struct hit_data {
+            Int_t pix_x;
+            Int_t pix_y;
+            Int_t value;
+            Int_t timing;
+        };
+        // Converted event waiting to be written, the hit vectors are reused for later events to avoid reallocations
+        struct pending_event {
+            ULong64_t frame_number{};
+            std::vector<std::vector<hit_data>> sensor_hits;
+        };
+
+        /**
+         * @brief Fill the event tree and all sensor trees with a converted event
+         * @param pending Event to write
+         */
+        void write_event(const pending_event& pending);
+
         Messenger* messenger_;
         GeometryManager* geo_mgr_;
 
         // Struct to store tree and information for each detector
         struct sensor_data {
             static constexpr int kMaxHits = (1 << 14);
+            // Position of the hits of this sensor in a pending event
+            size_t index;
             TTree* tree; // no unique_ptr, ROOT takes ownership
             Int_t nhits_;
             std::array<Int_t, kMaxHits> pix_x_;
@@ -93,5 +117,10 @@ namespace allpix {
 
         // Output data file to write
         std::unique_ptr<TFile> output_file_;
+
+        bool write_asynchronously_{};
+        size_t write_queue_size_{};
+        // Events already written are kept by the writer to reuse their hit vectors
+        AsyncWriter<pending_event> writer_;
     };
 } // namespace allpix
@@ -0,0 +1,333 @@
+/**
+ * @file
+ * @brief Implementation of ROOT columnar data file reader module
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "ROOTColumnReaderModule.hpp"
+
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "core/config/exceptions.h"
+#include "core/module/exceptions.h"
+#include "core/utils/log.h"
+#include "objects/objects.h"
+
+#include "tools/ROOT.h"
+
+using namespace allpix;
+
+namespace {
+    /**
+     * @brief Objects of one type per detector index, with the capacity reserved for all objects
+     * @param detectors Detector column of the object type
+     *
+     * The capacity is reserved upfront since the addresses of the objects need to remain valid while the history of later
+     * objects is restored.
+     */
+    template <typename T> std::map<int, std::vector<T>> reserve_objects(const std::vector<int>& detectors) {
+        std::map<int, size_t> counts;
+        for(auto detector : detectors) {
+            ++counts[detector];
+        }
+        std::map<int, std::vector<T>> objects;
+        for(const auto& [detector, count] : counts) {
+            objects[detector].reserve(count);
+        }
+        return objects;
+    }
+
+    /**
+     * @brief Resolve a stored index to the object it refers to
+     * @return Pointer to the object or a null pointer for a missing reference
+     */
+    template <typename T> const T* resolve(const std::vector<T*>& objects, int index) {
+        return (index < 0 || static_cast<size_t>(index) >= objects.size()) ? nullptr : objects[static_cast<size_t>(index)];
+    }
+
+    /**
+     * @brief Get the sensor charge members of an object from its columns
+     */
+    std::tuple<ROOT::Math::XYZPoint, ROOT::Math::XYZPoint, CarrierType, unsigned int, double, double>
+    sensor_charge(ObjectColumns& columns, size_t i) {
+        return {ROOT::Math::XYZPoint(
+                    columns.doubles("local_x")[i], columns.doubles("local_y")[i], columns.doubles("local_z")[i]),
+                ROOT::Math::XYZPoint(
+                    columns.doubles("global_x")[i], columns.doubles("global_y")[i], columns.doubles("global_z")[i]),
+                static_cast<CarrierType>(columns.integers("type")[i]),
+                static_cast<unsigned int>(columns.integers("charge")[i]),
+                columns.doubles("local_time")[i],
+                columns.doubles("global_time")[i]};
+    }
+
+    /**
+     * @brief Restore a pulse from the pulse columns
+     */
+    Pulse restore_pulse(ObjectColumns& columns, size_t i) {
+        const auto& values = columns.floats("values");
+        const auto& values_begin = columns.integers("values_begin");
+        auto begin = static_cast<size_t>(values_begin[i]);
+        auto end = (i + 1 < values_begin.size() ? static_cast<size_t>(values_begin[i + 1]) : values.size());
+
+        // Adding the charges at the start times of the stored bins restores the offset of the pulse
+        Pulse pulse(columns.doubles("bin")[i]);
+        auto offset = static_cast<size_t>(columns.integers("offset")[i]);
+        for(auto value = begin; value < end; ++value) {
+            pulse.addCharge(values[value], static_cast<double>(offset + value - begin) * pulse.getBinning());
+        }
+        return pulse;
+    }
+} // namespace
+
+ROOTColumnReaderModule::ROOTColumnReaderModule(Configuration& config, Messenger* messenger, GeometryManager* geo_mgr)
+    : Module(config), messenger_(messenger), geo_mgr_(geo_mgr), columns_(object_columns()) {
+    // Enable multithreading of this module if multithreading is enabled
+    allow_multithreading();
+}
+
+void ROOTColumnReaderModule::initialize() {
+    // Open the file with the objects
+    auto input_file_name = config_.getPathWithExtension("file_name", "root", true);
+    input_file_ = std::make_unique<TFile>(input_file_name.c_str());
+    if(input_file_->IsZombie()) {
+        throw InvalidValueError(config_, "file_name", "file cannot be opened");
+    }
+
+    // Look up the detectors referred to by the detector columns
+    std::vector<std::string>* names = nullptr;
+    input_file_->GetObject("detectors", names);
+    std::unique_ptr<std::vector<std::string>> detector_names(names);
+    input_file_->GetObject("Events", tree_);
+    if(detector_names == nullptr || tree_ == nullptr) {
+        throw InvalidValueError(config_, "file_name", "file does not contain columns written by the ROOTColumnWriter");
+    }
+    detectors_[-1] = nullptr;
+    for(size_t i = 0; i < detector_names->size(); ++i) {
+        const auto& name = (*detector_names)[i];
+        if(!geo_mgr_->hasDetector(name)) {
+            throw ModuleError("Detector " + name + " of the input file is not part of the geometry");
+        }
+        detectors_[static_cast<int>(i)] = geo_mgr_->getDetector(name);
+    }
+
+    // Pulses are only present if they have been stored by the writer
+    if(tree_->GetBranch("Pulse_owner") != nullptr) {
+        LOG(DEBUG) << "File contains pulses, restoring pulses and PixelPulse objects";
+        columns_.merge(pulse_columns());
+    }
+
+    // Attach all columns
+    for(auto& [type, columns] : columns_) {
+        if(!columns.bind(tree_, false)) {
+            throw InvalidValueError(config_, "file_name", "tree is missing columns of " + type + " objects");
+        }
+    }
+}
+
+void ROOTColumnReaderModule::run(Event* event) {
+    std::map<std::string, ObjectColumns> columns;
+    {
+        auto root_lock = root_process_lock();
+
+        // Beware: ROOT uses signed entry counters for its trees
+        auto event_num = static_cast<int64_t>(event->number) - 1;
+        if(event_num >= tree_->GetEntries()) {
+            // All events in flight beyond the end of the tree end up here, avoid the cost of throwing for each of them
+            event->requestEndOfRun("Requesting end of run because TTree only contains data for " +
+                                   std::to_string(tree_->GetEntries()) + " events");
+            return;
+        }
+        tree_->GetEntry(event_num);
+
+        // Restore the objects from a copy of the columns without holding the lock
+        columns = columns_;
+    }
+    LOG(TRACE) << "Restoring objects from columns";
+
+    // Pulses per owner object, indexed by the owner type and the index of the owner
+    std::map<std::pair<PulseOwner, int>, std::vector<size_t>> owned_pulses;
+    auto* pulse_columns = (columns.count("Pulse") != 0 ? &columns.at("Pulse") : nullptr);
+    if(pulse_columns != nullptr) {
+        for(size_t i = 0; i < pulse_columns->size(); ++i) {
+            auto owner_type = static_cast<PulseOwner>(pulse_columns->integers("owner_type")[i]);
+            owned_pulses[{owner_type, pulse_columns->integers("owner")[i]}].push_back(i);
+        }
+    }
+    auto pulses_of = [&](PulseOwner owner_type, size_t owner) {
+        auto pulses = owned_pulses.find({owner_type, static_cast<int>(owner)});
+        return (pulses == owned_pulses.end() ? nullptr : &pulses->second);
+    };
+
+    // Monte-Carlo particles, the parents are set once all particles exist
+    auto& mcparticle_columns = columns.at("MCParticle");
+    auto mcparticles = reserve_objects<MCParticle>(mcparticle_columns.integers("detector"));
+    std::vector<MCParticle*> mcparticle_pointers;
+    for(size_t i = 0; i < mcparticle_columns.size(); ++i) {
+        auto& objects = mcparticles[mcparticle_columns.integers("detector")[i]];
+        auto& particle = objects.emplace_back(ROOT::Math::XYZPoint(mcparticle_columns.doubles("local_start_x")[i],
+                                                                   mcparticle_columns.doubles("local_start_y")[i],
+                                                                   mcparticle_columns.doubles("local_start_z")[i]),
+                                              ROOT::Math::XYZPoint(mcparticle_columns.doubles("global_start_x")[i],
+                                                                   mcparticle_columns.doubles("global_start_y")[i],
+                                                                   mcparticle_columns.doubles("global_start_z")[i]),
+                                              ROOT::Math::XYZPoint(mcparticle_columns.doubles("local_end_x")[i],
+                                                                   mcparticle_columns.doubles("local_end_y")[i],
+                                                                   mcparticle_columns.doubles("local_end_z")[i]),
+                                              ROOT::Math::XYZPoint(mcparticle_columns.doubles("global_end_x")[i],
+                                                                   mcparticle_columns.doubles("global_end_y")[i],
+                                                                   mcparticle_columns.doubles("global_end_z")[i]),
+                                              mcparticle_columns.integers("particle_id")[i],
+                                              mcparticle_columns.doubles("local_time")[i],
+                                              mcparticle_columns.doubles("global_time")[i]);
+        particle.setTotalEnergyStart(mcparticle_columns.doubles("total_energy_start")[i]);
+        particle.setKineticEnergyStart(mcparticle_columns.doubles("kinetic_energy_start")[i]);
+        particle.setTotalDepositedCharge(
+            static_cast<unsigned int>(mcparticle_columns.integers("total_deposited_charge")[i]));
+        mcparticle_pointers.push_back(&particle);
+    }
+    for(size_t i = 0; i < mcparticle_pointers.size(); ++i) {
+        mcparticle_pointers[i]->setParent(resolve(mcparticle_pointers, mcparticle_columns.integers("parent")[i]));
+    }
+
+    // Deposited charges
+    auto& deposit_columns = columns.at("DepositedCharge");
+    auto deposits = reserve_objects<DepositedCharge>(deposit_columns.integers("detector"));
+    std::vector<DepositedCharge*> deposit_pointers;
+    for(size_t i = 0; i < deposit_columns.size(); ++i) {
+        auto [local, global, type, charge, local_time, global_time] = sensor_charge(deposit_columns, i);
+        const auto* mcparticle = resolve(mcparticle_pointers, deposit_columns.integers("mcparticle")[i]);
+        auto& objects = deposits[deposit_columns.integers("detector")[i]];
+        // Deposits of electron-hole pairs are stored without a carrier type
+        auto paired = (deposit_columns.integers("type")[i] == 0);
+        deposit_pointers.push_back(
+            &objects.emplace_back(local, global, type, charge, local_time, global_time, mcparticle, paired));
+    }
+
+    // Propagated charges
+    auto& propagated_columns = columns.at("PropagatedCharge");
+    auto propagated = reserve_objects<PropagatedCharge>(propagated_columns.integers("detector"));
+    std::vector<PropagatedCharge*> propagated_pointers;
+    for(size_t i = 0; i < propagated_columns.size(); ++i) {
+        auto [local, global, type, charge, local_time, global_time] = sensor_charge(propagated_columns, i);
+        auto& objects = propagated[propagated_columns.integers("detector")[i]];
+        auto state = static_cast<CarrierState>(propagated_columns.integers("state")[i]);
+        const auto* deposit = resolve(deposit_pointers, propagated_columns.integers("deposited_charge")[i]);
+
+        // Charges with pulses derive their charge from the pulses as when created in the simulation
+        const auto* pulse_indices = pulses_of(PulseOwner::PROPAGATED_CHARGE, i);
+        if(pulse_indices != nullptr) {
+            PropagatedCharge::PulseMap pulses;
+            for(auto pulse : *pulse_indices) {
+                pulses.emplace_back(
+                    Pixel::Index(pulse_columns->integers("x")[pulse], pulse_columns->integers("y")[pulse]),
+                    restore_pulse(*pulse_columns, pulse));
+            }
+            propagated_pointers.push_back(&objects.emplace_back(
+                local, global, type, std::move(pulses), local_time, global_time, state, deposit));
+        } else {
+            propagated_pointers.push_back(
+                &objects.emplace_back(local, global, type, charge, local_time, global_time, state, deposit));
+        }
+    }
+
+    // Pixel charges, referring to the range of their propagated charges in the flattened column
+    auto& pixel_charge_columns = columns.at("PixelCharge");
+    auto pixel_charges = reserve_objects<PixelCharge>(pixel_charge_columns.integers("detector"));
+    std::vector<PixelCharge*> pixel_charge_pointers;
+    const auto& references = pixel_charge_columns.integers("propagated_charges");
+    const auto& references_begin = pixel_charge_columns.integers("propagated_charges_begin");
+    for(size_t i = 0; i < pixel_charge_columns.size(); ++i) {
+        auto detector_index = pixel_charge_columns.integers("detector")[i];
+        const auto& detector = detectors_.at(detector_index);
+        if(detector == nullptr) {
+            throw ModuleError("Cannot restore pixel charge without detector");
+        }
+
+        auto end = (i + 1 < references_begin.size() ? references_begin[i + 1] : static_cast<int>(references.size()));
+        std::vector<const PropagatedCharge*> charges;
+        for(auto reference = references_begin[i]; reference < end; ++reference) {
+            const auto* charge = resolve(propagated_pointers, references[static_cast<size_t>(reference)]);
+            if(charge != nullptr) {
+                charges.push_back(charge);
+            }
+        }
+
+        auto pixel = detector->getPixel(pixel_charge_columns.integers("x")[i], pixel_charge_columns.integers("y")[i]);
+        const auto* pulse_indices = pulses_of(PulseOwner::PIXEL_CHARGE, i);
+        if(pulse_indices != nullptr) {
+            pixel_charge_pointers.push_back(&pixel_charges[detector_index].emplace_back(
+                std::move(pixel), restore_pulse(*pulse_columns, pulse_indices->front()), charges));
+        } else {
+            pixel_charge_pointers.push_back(&pixel_charges[detector_index].emplace_back(
+                std::move(pixel), static_cast<long>(pixel_charge_columns.integers("charge")[i]), charges));
+        }
+    }
+
+    // Pixel hits
+    auto& pixel_hit_columns = columns.at("PixelHit");
+    auto pixel_hits = reserve_objects<PixelHit>(pixel_hit_columns.integers("detector"));
+    for(size_t i = 0; i < pixel_hit_columns.size(); ++i) {
+        auto detector_index = pixel_hit_columns.integers("detector")[i];
+        const auto& detector = detectors_.at(detector_index);
+        if(detector == nullptr) {
+            throw ModuleError("Cannot restore pixel hit without detector");
+        }
+
+        auto pixel = detector->getPixel(pixel_hit_columns.integers("x")[i], pixel_hit_columns.integers("y")[i]);
+        const auto* pixel_charge = resolve(pixel_charge_pointers, pixel_hit_columns.integers("pixel_charge")[i]);
+        pixel_hits[detector_index].emplace_back(std::move(pixel),
+                                                pixel_hit_columns.doubles("local_time")[i],
+                                                pixel_hit_columns.doubles("global_time")[i],
+                                                pixel_hit_columns.doubles("signal")[i],
+                                                pixel_charge);
+    }
+
+    // Pixel pulses, only present if pulses have been stored
+    std::map<int, std::vector<PixelPulse>> pixel_pulses;
+    if(pulse_columns != nullptr) {
+        auto& pixel_pulse_columns = columns.at("PixelPulse");
+        pixel_pulses = reserve_objects<PixelPulse>(pixel_pulse_columns.integers("detector"));
+        for(size_t i = 0; i < pixel_pulse_columns.size(); ++i) {
+            auto detector_index = pixel_pulse_columns.integers("detector")[i];
+            const auto& detector = detectors_.at(detector_index);
+            const auto* pulse_indices = pulses_of(PulseOwner::PIXEL_PULSE, i);
+            if(detector == nullptr || pulse_indices == nullptr) {
+                throw ModuleError("Cannot restore pixel pulse without detector or pulse");
+            }
+
+            auto pixel = detector->getPixel(pixel_pulse_columns.integers("x")[i], pixel_pulse_columns.integers("y")[i]);
+            const auto* pixel_charge = resolve(pixel_charge_pointers, pixel_pulse_columns.integers("pixel_charge")[i]);
+            pixel_pulses[detector_index].emplace_back(
+                std::move(pixel), restore_pulse(*pulse_columns, pulse_indices->front()), pixel_charge);
+        }
+    }
+
+    // Dispatch one message per object type and detector, moving the objects keeps their addresses
+    auto dispatch = [&](auto& objects_per_detector) {
+        for(auto& [detector_index, objects] : objects_per_detector) {
+            using ObjectType = typename std::decay_t<decltype(objects)>::value_type;
+            read_cnt_ += objects.size();
+            auto message = std::make_shared<Message<ObjectType>>(std::move(objects), detectors_.at(detector_index));
+            messenger_->dispatchMessage(this, message, event);
+        }
+    };
+    dispatch(mcparticles);
+    dispatch(deposits);
+    dispatch(propagated);
+    dispatch(pixel_charges);
+    dispatch(pixel_hits);
+    dispatch(pixel_pulses);
+}
+
+void ROOTColumnReaderModule::finalize() {
+    LOG(INFO) << "Read " << read_cnt_ << " objects from " << tree_->GetEntries() << " events";
+}
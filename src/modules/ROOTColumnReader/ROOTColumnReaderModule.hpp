@@ -0,0 +1,84 @@
+/**
+ * @file
+ * @brief Definition of ROOT columnar data file reader module
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_ROOT_COLUMN_READER_MODULE_H
+#define ALLPIX_ROOT_COLUMN_READER_MODULE_H
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+
+#include <TFile.h>
+#include <TTree.h>
+
+#include "core/config/Configuration.hpp"
+#include "core/geometry/GeometryManager.hpp"
+#include "core/messenger/Messenger.hpp"
+#include "core/module/Event.hpp"
+#include "core/module/Module.hpp"
+
+#include "tools/object_columns.h"
+
+namespace allpix {
+    /**
+     * @ingroup Modules
+     * @brief Module to read objects from a flat ROOT tree written by the ROOTColumnWriter module
+     *
+     * Reads the columns of the tree for every event and restores the MCParticle, DepositedCharge, PropagatedCharge,
+     * PixelCharge and PixelHit objects, including the history stored as indices between them. Pulses and PixelPulse objects
+     * are restored if present in the file. One message is dispatched per object type and detector.
+     */
+    class ROOTColumnReaderModule : public Module {
+    public:
+        /**
+         * @brief Constructor for this unique module
+         * @param config Configuration object for this module as retrieved from the steering file
+         * @param messenger Pointer to the messenger object to allow binding to messages on the bus
+         * @param geo_mgr Pointer to the geometry manager, containing the detectors
+         */
+        ROOTColumnReaderModule(Configuration& config, Messenger* messenger, GeometryManager* geo_mgr);
+
+        /**
+         * @brief Open the file and attach the columns to the tree
+         */
+        void initialize() override;
+
+        /**
+         * @brief Read the columns of the event and dispatch the restored objects
+         */
+        void run(Event* event) override;
+
+        /**
+         * @brief Output summary of the objects read
+         */
+        void finalize() override;
+
+    private:
+        Messenger* messenger_;
+        GeometryManager* geo_mgr_;
+
+        // Detectors referred to by the detector columns
+        std::map<int, std::shared_ptr<const Detector>> detectors_;
+
+        // Input file and tree
+        std::unique_ptr<TFile> input_file_;
+        TTree* tree_{};
+
+        // Columns of all object types of the last entry read
+        std::map<std::string, ObjectColumns> columns_;
+
+        // Statistical information about number of objects
+        std::atomic<unsigned long> read_cnt_{};
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_ROOT_COLUMN_READER_MODULE_H */
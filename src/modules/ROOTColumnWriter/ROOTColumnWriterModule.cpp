@@ -0,0 +1,319 @@
+/**
+ * @file
+ * @brief Implementation of ROOT columnar data file writer module
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "ROOTColumnWriterModule.hpp"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/messenger/exceptions.h"
+#include "core/utils/log.h"
+#include "objects/objects.h"
+
+#include "tools/ROOT.h"
+
+using namespace allpix;
+
+namespace {
+    /**
+     * @brief Fetch the messages of an optional message type, returning an empty list if none were dispatched
+     */
+    template <typename T>
+    std::vector<std::shared_ptr<T>> fetch_optional(Messenger* messenger, Module* module, Event* event) {
+        try {
+            return messenger->fetchMultiMessage<T>(module, event);
+        } catch(const MessageNotFoundException&) {
+            return {};
+        }
+    }
+
+    /**
+     * @brief Append the members of a charge in the sensor to its columns
+     */
+    void fill_sensor_charge(ObjectColumns& columns, int detector, const SensorCharge& charge) {
+        columns.integers("detector").push_back(detector);
+        columns.integers("type").push_back(static_cast<int>(charge.getType()));
+        columns.integers("charge").push_back(static_cast<int>(charge.getCharge()));
+        auto local = charge.getLocalPosition();
+        auto global = charge.getGlobalPosition();
+        columns.doubles("local_x").push_back(local.x());
+        columns.doubles("local_y").push_back(local.y());
+        columns.doubles("local_z").push_back(local.z());
+        columns.doubles("global_x").push_back(global.x());
+        columns.doubles("global_y").push_back(global.y());
+        columns.doubles("global_z").push_back(global.z());
+        columns.doubles("local_time").push_back(charge.getLocalTime());
+        columns.doubles("global_time").push_back(charge.getGlobalTime());
+    }
+
+    /**
+     * @brief Append a pulse to the pulse columns, storing its bins in single precision
+     */
+    void fill_pulse(ObjectColumns& columns,
+                    int detector,
+                    PulseOwner owner_type,
+                    int owner,
+                    const Pixel::Index& index,
+                    const Pulse& pulse) {
+        // The columns describe uniform bins only, pulses with piecewise binning are stored resampled onto their fine bins
+        if(!pulse.isUniform()) {
+            fill_pulse(columns, detector, owner_type, owner, index, pulse.getUniform());
+            return;
+        }
+
+        columns.integers("detector").push_back(detector);
+        columns.integers("owner_type").push_back(static_cast<int>(owner_type));
+        columns.integers("owner").push_back(owner);
+        columns.integers("x").push_back(index.x());
+        columns.integers("y").push_back(index.y());
+        columns.integers("offset").push_back(static_cast<int>(pulse.getOffset()));
+        columns.doubles("bin").push_back(pulse.getBinning());
+
+        auto& values = columns.floats("values");
+        columns.integers("values_begin").push_back(static_cast<int>(values.size()));
+        for(auto value : pulse) {
+            values.push_back(static_cast<float>(value));
+        }
+    }
+} // namespace
+
+ROOTColumnWriterModule::ROOTColumnWriterModule(Configuration& config, Messenger* messenger, GeometryManager* geo_mgr)
+    : SequentialModule(config), messenger_(messenger), geo_mgr_(geo_mgr), columns_(object_columns()) {
+    // Enable multithreading of this module if multithreading is enabled
+    allow_multithreading();
+
+    // Store the data of rejected events produced before the rejection
+    process_rejected_events();
+
+    // Bind to all object types which can be stored in columns
+    messenger_->bindMulti<MCParticleMessage>(this);
+    messenger_->bindMulti<DepositedChargeMessage>(this);
+    messenger_->bindMulti<PropagatedChargeMessage>(this);
+    messenger_->bindMulti<PixelChargeMessage>(this);
+    messenger_->bindMulti<PixelHitMessage>(this);
+
+    config_.setDefault("file_name", "data");
+    config_.setDefault<bool>("store_pulses", false);
+
+    // Pulses of the charges and pixel pulses are only stored on request, they dominate the output of transient simulations
+    store_pulses_ = config_.get<bool>("store_pulses");
+    if(store_pulses_) {
+        messenger_->bindMulti<PixelPulseMessage>(this);
+        columns_.merge(pulse_columns());
+    }
+}
+
+void ROOTColumnWriterModule::initialize() {
+    // Index of the detectors in the list stored with the tree
+    for(const auto& detector : geo_mgr_->getDetectors()) {
+        detector_index_.emplace(detector->getName(), static_cast<int>(detector_index_.size()));
+    }
+
+    // Create output file
+    output_file_name_ = createOutputFile(config_.get<std::string>("file_name"), "root", true);
+    output_file_ = std::make_unique<TFile>(output_file_name_.c_str(), "RECREATE");
+    output_file_->cd();
+
+    // Create the tree with the event information and the columns of all object types
+    tree_ = new TTree("Events", "Objects of all events in columns");
+    tree_->Branch("event", &current_event_);
+    tree_->Branch("seed", &current_seed_);
+    for(auto& [type, columns] : columns_) {
+        columns.bind(tree_, true);
+    }
+}
+
+void ROOTColumnWriterModule::run(Event* event) {
+    auto mcparticle_messages = fetch_optional<MCParticleMessage>(messenger_, this, event);
+    auto deposit_messages = fetch_optional<DepositedChargeMessage>(messenger_, this, event);
+    auto propagated_messages = fetch_optional<PropagatedChargeMessage>(messenger_, this, event);
+    auto pixel_charge_messages = fetch_optional<PixelChargeMessage>(messenger_, this, event);
+    auto pixel_hit_messages = fetch_optional<PixelHitMessage>(messenger_, this, event);
+    auto pixel_pulse_messages = (store_pulses_ ? fetch_optional<PixelPulseMessage>(messenger_, this, event)
+                                               : std::vector<std::shared_ptr<PixelPulseMessage>>());
+
+    // Assign the column index of every object first, references may point to objects of any detector
+    std::map<const Object*, int> indices;
+    auto assign_indices = [&](const auto& messages) {
+        int index = 0;
+        for(const auto& message : messages) {
+            for(const auto& object : message->getData()) {
+                indices.emplace(&object, index++);
+            }
+        }
+    };
+    assign_indices(mcparticle_messages);
+    assign_indices(deposit_messages);
+    assign_indices(propagated_messages);
+    assign_indices(pixel_charge_messages);
+    assign_indices(pixel_hit_messages);
+    assign_indices(pixel_pulse_messages);
+    auto index_of = [&](const Object* object) {
+        auto it = indices.find(object);
+        return (it == indices.end() ? -1 : it->second);
+    };
+    auto detector_of = [&](const auto& message) {
+        return (message->getDetector() == nullptr ? -1 : detector_index_.at(message->getDetector()->getName()));
+    };
+
+    for(auto& column : columns_) {
+        column.second.clear();
+    }
+    current_event_ = event->number;
+    current_seed_ = event->getSeed();
+    auto* pulses = (store_pulses_ ? &columns_.at("Pulse") : nullptr);
+
+    auto& mcparticles = columns_.at("MCParticle");
+    for(const auto& message : mcparticle_messages) {
+        auto detector = detector_of(message);
+        for(const auto& particle : message->getData()) {
+            mcparticles.integers("detector").push_back(detector);
+            mcparticles.integers("particle_id").push_back(particle.getParticleID());
+            mcparticles.integers("parent").push_back(index_of(particle.getParent()));
+            mcparticles.integers("total_deposited_charge").push_back(static_cast<int>(particle.getTotalDepositedCharge()));
+            auto local_start = particle.getLocalStartPoint();
+            auto local_end = particle.getLocalEndPoint();
+            auto global_start = particle.getGlobalStartPoint();
+            auto global_end = particle.getGlobalEndPoint();
+            mcparticles.doubles("local_start_x").push_back(local_start.x());
+            mcparticles.doubles("local_start_y").push_back(local_start.y());
+            mcparticles.doubles("local_start_z").push_back(local_start.z());
+            mcparticles.doubles("local_end_x").push_back(local_end.x());
+            mcparticles.doubles("local_end_y").push_back(local_end.y());
+            mcparticles.doubles("local_end_z").push_back(local_end.z());
+            mcparticles.doubles("global_start_x").push_back(global_start.x());
+            mcparticles.doubles("global_start_y").push_back(global_start.y());
+            mcparticles.doubles("global_start_z").push_back(global_start.z());
+            mcparticles.doubles("global_end_x").push_back(global_end.x());
+            mcparticles.doubles("global_end_y").push_back(global_end.y());
+            mcparticles.doubles("global_end_z").push_back(global_end.z());
+            mcparticles.doubles("local_time").push_back(particle.getLocalTime());
+            mcparticles.doubles("global_time").push_back(particle.getGlobalTime());
+            mcparticles.doubles("total_energy_start").push_back(particle.getTotalEnergyStart());
+            mcparticles.doubles("kinetic_energy_start").push_back(particle.getKineticEnergyStart());
+        }
+    }
+
+    auto& deposits = columns_.at("DepositedCharge");
+    for(const auto& message : deposit_messages) {
+        auto detector = detector_of(message);
+        for(const auto& deposit : message->getData()) {
+            fill_sensor_charge(deposits, detector, deposit);
+            if(deposit.isPaired()) {
+                // Deposits of electron-hole pairs are stored without a carrier type
+                deposits.integers("type").back() = 0;
+            }
+            deposits.integers("mcparticle").push_back(index_of(deposit.getMCParticle()));
+        }
+    }
+
+    auto& propagated = columns_.at("PropagatedCharge");
+    for(const auto& message : propagated_messages) {
+        auto detector = detector_of(message);
+        for(const auto& charge : message->getData()) {
+            fill_sensor_charge(propagated, detector, charge);
+            propagated.integers("state").push_back(static_cast<int>(charge.getState()));
+            propagated.integers("deposited_charge").push_back(index_of(charge.getDepositedCharge()));
+            if(pulses != nullptr) {
+                for(const auto& [pixel_index, pulse] : charge.getPulses()) {
+                    fill_pulse(*pulses, detector, PulseOwner::PROPAGATED_CHARGE, index_of(&charge), pixel_index, pulse);
+                }
+            }
+        }
+    }
+
+    auto& pixel_charges = columns_.at("PixelCharge");
+    for(const auto& message : pixel_charge_messages) {
+        auto detector = detector_of(message);
+        for(const auto& pixel_charge : message->getData()) {
+            auto index = pixel_charge.getIndex();
+            pixel_charges.integers("detector").push_back(detector);
+            pixel_charges.integers("x").push_back(index.x());
+            pixel_charges.integers("y").push_back(index.y());
+            pixel_charges.integers("charge").push_back(static_cast<int>(pixel_charge.getCharge()));
+
+            // Store the references to the propagated charges as range in the flattened column
+            auto& references = pixel_charges.integers("propagated_charges");
+            pixel_charges.integers("propagated_charges_begin").push_back(static_cast<int>(references.size()));
+            for(const auto* charge : pixel_charge.getPropagatedCharges()) {
+                references.push_back(index_of(charge));
+            }
+
+            const auto& pulse = pixel_charge.getPulse();
+            if(pulses != nullptr && pulse.isInitialized()) {
+                fill_pulse(*pulses, detector, PulseOwner::PIXEL_CHARGE, index_of(&pixel_charge), index, pulse);
+            }
+        }
+    }
+
+    auto& pixel_hits = columns_.at("PixelHit");
+    for(const auto& message : pixel_hit_messages) {
+        auto detector = detector_of(message);
+        for(const auto& pixel_hit : message->getData()) {
+            auto index = pixel_hit.getIndex();
+            pixel_hits.integers("detector").push_back(detector);
+            pixel_hits.integers("x").push_back(index.x());
+            pixel_hits.integers("y").push_back(index.y());
+            pixel_hits.integers("pixel_charge").push_back(index_of(pixel_hit.getPixelCharge()));
+            pixel_hits.doubles("signal").push_back(pixel_hit.getSignal());
+            pixel_hits.doubles("local_time").push_back(pixel_hit.getLocalTime());
+            pixel_hits.doubles("global_time").push_back(pixel_hit.getGlobalTime());
+        }
+    }
+
+    if(pulses != nullptr) {
+        auto& pixel_pulses = columns_.at("PixelPulse");
+        for(const auto& message : pixel_pulse_messages) {
+            auto detector = detector_of(message);
+            for(const auto& pixel_pulse : message->getData()) {
+                auto index = pixel_pulse.getPixel().getIndex();
+                auto owner = static_cast<int>(pixel_pulses.size());
+                pixel_pulses.integers("detector").push_back(detector);
+                pixel_pulses.integers("x").push_back(index.x());
+                pixel_pulses.integers("y").push_back(index.y());
+                pixel_pulses.integers("pixel_charge").push_back(index_of(pixel_pulse.getPixelCharge()));
+                fill_pulse(*pulses, detector, PulseOwner::PIXEL_PULSE, owner, index, pixel_pulse);
+            }
+        }
+    }
+
+    // Count the objects stored in this event, pulses are part of the objects they belong to
+    unsigned long object_count = 0;
+    for(const auto& [type, column] : columns_) {
+        object_count += (type == "Pulse" ? 0 : column.size());
+    }
+    write_cnt_ += object_count;
+
+    LOG(TRACE) << "Writing " << object_count << " objects of event " << event->number;
+    auto root_lock = root_process_lock();
+    tree_->Fill();
+}
+
+void ROOTColumnWriterModule::finalize() {
+    LOG(TRACE) << "Writing objects to file";
+    output_file_->cd();
+
+    // Store the names of the detectors referred to by the detector columns
+    std::vector<std::string> detector_names(detector_index_.size());
+    for(const auto& [name, index] : detector_index_) {
+        detector_names[static_cast<size_t>(index)] = name;
+    }
+    output_file_->WriteObject(&detector_names, "detectors");
+
+    // Closing the file deletes the tree owned by it
+    auto events = tree_->GetEntries();
+    output_file_->Write();
+    output_file_->Close();
+
+    LOG(STATUS) << "Wrote " << write_cnt_ << " objects of " << events << " events to file:" << std::endl
+                << output_file_name_;
+}
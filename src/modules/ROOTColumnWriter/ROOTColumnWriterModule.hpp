@@ -0,0 +1,89 @@
+/**
+ * @file
+ * @brief Definition of ROOT columnar data file writer module
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_ROOT_COLUMN_WRITER_MODULE_H
+#define ALLPIX_ROOT_COLUMN_WRITER_MODULE_H
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+
+#include <TFile.h>
+#include <TTree.h>
+
+#include "core/config/Configuration.hpp"
+#include "core/geometry/GeometryManager.hpp"
+#include "core/messenger/Messenger.hpp"
+#include "core/module/Event.hpp"
+#include "core/module/Module.hpp"
+
+#include "tools/object_columns.h"
+
+namespace allpix {
+    /**
+     * @ingroup Modules
+     * @brief Module to write objects to a flat ROOT tree without cross-object references via TRef
+     *
+     * Receives the MCParticle, DepositedCharge, PropagatedCharge, PixelCharge and PixelHit objects of all detectors and
+     * stores them as columns of a single tree with one entry per event. References between the objects are stored as
+     * indices into the columns of the referenced type. Optionally, the pulses of the charges and PixelPulse objects are
+     * stored with their bins in single precision. The file can be read back with the ROOTColumnReader module.
+     */
+    class ROOTColumnWriterModule : public SequentialModule {
+    public:
+        /**
+         * @brief Constructor for this unique module
+         * @param config Configuration object for this module as retrieved from the steering file
+         * @param messenger Pointer to the messenger object to allow binding to messages on the bus
+         * @param geo_mgr Pointer to the geometry manager, containing the detectors
+         */
+        ROOTColumnWriterModule(Configuration& config, Messenger* messenger, GeometryManager* geo_mgr);
+
+        /**
+         * @brief Open the file and create the tree with all columns
+         */
+        void initialize() override;
+
+        /**
+         * @brief Convert the objects of the event to columns and fill the tree
+         */
+        void run(Event* event) override;
+
+        /**
+         * @brief Store the list of detector names and write the file
+         */
+        void finalize() override;
+
+    private:
+        Messenger* messenger_;
+        GeometryManager* geo_mgr_;
+
+        // Index of every detector in the detector column
+        std::map<std::string, int> detector_index_;
+
+        // Output file and tree
+        std::unique_ptr<TFile> output_file_;
+        std::string output_file_name_;
+        TTree* tree_{};
+
+        // Event information and columns of all object types
+        uint64_t current_event_{};
+        uint64_t current_seed_{};
+        std::map<std::string, ObjectColumns> columns_;
+        bool store_pulses_{};
+
+        // Statistical information about number of objects
+        std::atomic<unsigned long> write_cnt_{};
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_ROOT_COLUMN_WRITER_MODULE_H */
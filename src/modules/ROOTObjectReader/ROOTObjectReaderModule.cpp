@@ -18,8 +18,11 @@
 #include <TBranch.h>
 #include <TKey.h>
 #include <TObjArray.h>
+#include <TClass.h>
 #include <TProcessID.h>
 #include <TTree.h>
+#include <TTreeCacheUnzip.h>
+#include <TTreeFormula.h>
 
 #include "core/messenger/Messenger.hpp"
 #include "core/utils/log.h"
@@ -37,6 +40,11 @@ ROOTObjectReaderModule::ROOTObjectReaderModule(Configuration& config, Messenger*
     : Module(config), messenger_(messenger), geo_mgr_(geo_mgr) {
     // Enable multithreading of this module if multithreading is enabled
     allow_multithreading();
+
+    // Read performance tuning
+    config_.setDefault<bool>("parallel_unzip", false);
+    config_.setDefault<bool>("cluster_prefetch", false);
+    config_.setDefault<bool>("skip_unused_branches", false);
 }
 
 /**
@@ -138,6 +146,18 @@ void ROOTObjectReaderModule::initialize() {
             // Exclude the Event tree
             if(strcmp(tree->GetName(), "Event") == 0) {
                 LOG(TRACE) << "Skipping Event tree in reading";
+                if(event_tree_ == nullptr) {
+                    event_tree_ = tree;
+                }
+                continue;
+            }
+
+            // Exclude the tree indexing the event content
+            if(strcmp(tree->GetName(), "EventIndex") == 0) {
+                LOG(TRACE) << "Skipping EventIndex tree in reading";
+                if(index_tree_ == nullptr) {
+                    index_tree_ = tree;
+                }
                 continue;
             }
 
@@ -206,8 +226,68 @@ void ROOTObjectReaderModule::initialize() {
                      << " - this might lead to unexpected behavior.";
     }
 
+    // Select the entries to read by evaluating the selection on the event index, read in consecutive events
+    if(config_.has("selection")) {
+        if(index_tree_ == nullptr) {
+            throw InvalidValueError(config_,
+                                    "selection",
+                                    "input file does not contain an event index, write it with the write_index parameter of "
+                                    "the ROOTObjectWriter module");
+        }
+
+        auto selection = config_.get<std::string>("selection");
+        TTreeFormula formula("selection", selection.c_str(), index_tree_);
+        if(formula.GetNdim() == 0) {
+            throw InvalidValueError(config_, "selection", "cannot evaluate selection on the event index");
+        }
+        for(Long64_t entry = 0; entry < index_tree_->GetEntries(); ++entry) {
+            index_tree_->LoadTree(entry);
+            formula.GetNdata();
+            if(formula.EvalInstance() != 0) {
+                selected_entries_.push_back(entry);
+            }
+        }
+        select_entries_ = true;
+        LOG(INFO) << "Selected " << selected_entries_.size() << " of " << index_tree_->GetEntries()
+                  << " events with selection " << selection;
+    }
+
+    // Files merged from the outputs of several threads do not store the events in order, index them by event number
+    if(!select_entries_ && event_tree_ != nullptr && event_tree_->GetBranch("ID") != nullptr) {
+        uint64_t event_id = 0;
+        uint64_t previous_id = 0;
+        event_tree_->SetBranchAddress("ID", &event_id);
+        for(Long64_t entry = 0; entry < event_tree_->GetEntries(); ++entry) {
+            event_tree_->GetEntry(entry);
+            if(event_id != previous_id + 1) {
+                event_index_ = true;
+                break;
+            }
+            previous_id = event_id;
+        }
+        event_tree_->ResetBranchAddresses();
+
+        if(event_index_) {
+            LOG(INFO) << "Events are not stored in order, reading them via their event number";
+            event_tree_->BuildIndex("ID");
+        }
+    }
+
+    // Decompress the baskets in the read cache in parallel, must be selected before the caches are created
+    if(config_.get<bool>("parallel_unzip")) {
+        TTreeCacheUnzip::SetParallelUnzip(TTreeCacheUnzip::kEnable);
+    }
+    auto skip_unused_branches = config_.get<bool>("skip_unused_branches");
+
     // Loop over all found trees
     for(auto& tree : trees_) {
+        if(config_.has("cache_size")) {
+            tree->SetCacheSize(config_.get<Long64_t>("cache_size"));
+        }
+        if(config_.get<bool>("cluster_prefetch")) {
+            tree->SetClusterPrefetch(true);
+        }
+
         // Loop over the list of branches and create the set of receiver objects
         TObjArray* branches = tree->GetListOfBranches();
         for(int i = 0; i < branches->GetEntries(); i++) {
@@ -261,7 +341,29 @@ void ROOTObjectReaderModule::initialize() {
                     message_info_array_.back().detector = geo_mgr_->getDetector(split[det_idx]);
                 }
             }
+
+            // Do not read branches of which no module would receive the messages
+            if(skip_unused_branches) {
+                auto* object_class = TClass::GetClass((apx_namespace + class_name).c_str());
+                auto creator = (object_class != nullptr && object_class->GetTypeInfo() != nullptr
+                                    ? message_creator_map_.find(*object_class->GetTypeInfo())
+                                    : message_creator_map_.end());
+                if(creator != message_creator_map_.end() &&
+                   !messenger_->hasReceiver(this, creator->second({}, message_info_array_.back().detector))) {
+                    LOG(DEBUG) << "Skipping branch " << branch_name << " of tree " << tree->GetName()
+                               << " because no module receives its objects";
+                    tree->SetBranchStatus((branch_name + "*").c_str(), false);
+                    branch->ResetAddress();
+                    delete message_info_array_.back().objects;
+                    message_info_array_.pop_back();
+                    continue;
+                }
+            }
+
+            // Only read the branches in use into the cache
+            tree->AddBranchToCache(branch, true);
         }
+        tree->StopCacheLearningPhase();
     }
 }
 
@@ -271,10 +373,27 @@ void ROOTObjectReaderModule::run(Event* event) {
     // Beware: ROOT uses signed entry counters for its trees
     auto event_num = static_cast<int64_t>(event->number);
     --event_num;
+    if(select_entries_) {
+        if(static_cast<size_t>(event_num) >= selected_entries_.size()) {
+            event->requestEndOfRun("Requesting end of run because only " + std::to_string(selected_entries_.size()) +
+                                   " events have been selected");
+            return;
+        }
+        event_num = selected_entries_[static_cast<size_t>(event_num)];
+    } else if(event_index_) {
+        event_num = event_tree_->GetEntryNumberWithIndex(static_cast<Long64_t>(event->number));
+        if(event_num < 0) {
+            event->requestEndOfRun("Requesting end of run because TTree does not contain data for event " +
+                                   std::to_string(event->number));
+            return;
+        }
+    }
     for(auto& tree : trees_) {
         if(event_num >= tree->GetEntries()) {
-            throw EndOfRunException("Requesting end of run because TTree only contains data for " +
-                                    std::to_string(event_num) + " events");
+            // All events in flight beyond the end of the tree end up here, avoid the cost of throwing for each of them
+            event->requestEndOfRun("Requesting end of run because TTree only contains data for " +
+                                   std::to_string(event_num) + " events");
+            return;
         }
         tree->GetEntry(event_num);
     }
@@ -90,6 +90,15 @@ namespace allpix {
         // Object trees in the file
         std::vector<TTree*> trees_;
 
+        // Tree with the event information, indexed by event number if the events are not stored in order
+        TTree* event_tree_{};
+        bool event_index_{};
+
+        // Tree indexing the event content and the entries selected from it, read as consecutive events
+        TTree* index_tree_{};
+        bool select_entries_{};
+        std::vector<Long64_t> selected_entries_;
+
         // List of objects and message information converted from the trees
         std::list<message_info> message_info_array_;
 
@@ -11,12 +11,15 @@
 
 #include "ROOTObjectWriterModule.hpp"
 
+#include <cstdio>
+#include <deque>
 #include <fstream>
 #include <string>
 #include <utility>
 
 #include <TBranchElement.h>
 #include <TClass.h>
+#include <TFileMerger.h>
 #include <TProcessID.h>
 
 #include "core/config/ConfigReader.hpp"
@@ -35,29 +38,101 @@ ROOTObjectWriterModule::ROOTObjectWriterModule(Configuration& config, Messenger*
     // Enable multithreading of this module if multithreading is enabled
     allow_multithreading();
 
+    // Store the data of rejected events produced before the rejection
+    process_rejected_events();
+
     // Bind to all messages with filter
     messenger_->registerFilter(this, &ROOTObjectWriterModule::filter);
+
+    config_.setDefault<int>("basket_size", 32000);
+    config_.setDefault<bool>("write_asynchronously", false);
+    config_.setDefault<unsigned int>("write_queue_size", 16);
+    config_.setDefault<bool>("parallel_output", false);
+    config_.setDefault<bool>("write_index", false);
+
+    basket_size_ = config_.get<int>("basket_size");
+    write_index_ = config_.get<bool>("write_index");
+    write_asynchronously_ = config_.get<bool>("write_asynchronously");
+    write_queue_size_ = config_.get<unsigned int>("write_queue_size");
+    if(write_queue_size_ == 0) {
+        throw InvalidValueError(config_, "write_queue_size", "queue needs to hold at least one event");
+    }
+
+    // Writing separate files per thread does not require the events in sequence, they are ordered when reading
+    parallel_output_ = config_.get<bool>("parallel_output");
+    if(parallel_output_ && write_asynchronously_) {
+        throw InvalidCombinationError(config_,
+                                      {"parallel_output", "write_asynchronously"},
+                                      "per-thread output files are already written without a shared writer");
+    }
+    if(parallel_output_) {
+        waive_sequence_requirement();
+    }
 }
 /**
  * @note Objects cannot be stored in smart pointers due to internal ROOT logic
  */
 ROOTObjectWriterModule::~ROOTObjectWriterModule() {
+    // The writer thread fills the trees from the write lists deleted below
+    writer_.stop();
+
     // Delete all object pointers
-    for(auto& index_data : write_list_) {
-        delete index_data.second;
+    auto delete_lists = [](OutputSet* output) {
+        if(output != nullptr) {
+            for(auto& index_data : output->write_list) {
+                delete index_data.second;
+            }
+        }
+    };
+    delete_lists(output_.get());
+    for(auto& thread_output : thread_outputs_) {
+        delete_lists(thread_output.second.get());
     }
 }
 
-void ROOTObjectWriterModule::initialize() {
-    // Create output file
-    output_file_name_ = createOutputFile(config_.get<std::string>("file_name", "data"), "root", true);
-    output_file_ = std::make_unique<TFile>(output_file_name_.c_str(), "RECREATE");
-    output_file_->cd();
+std::unique_ptr<ROOTObjectWriterModule::OutputSet> ROOTObjectWriterModule::create_output(const std::string& file_name) {
+    auto output = std::make_unique<OutputSet>();
+    output->file_name = file_name;
+    output->file = std::make_unique<TFile>(file_name.c_str(), "RECREATE");
+    if(config_.has("compression_settings")) {
+        output->file->SetCompressionSettings(config_.get<int>("compression_settings"));
+    }
+    output->file->cd();
 
     // Create tree to hold Event information
-    trees_.emplace("Event", std::make_unique<TTree>("Event", "Tree of event info"));
-    trees_["Event"]->Branch("ID", &current_event_);
-    trees_["Event"]->Branch("seed", &current_seed_);
+    auto& tree = output->trees.emplace("Event", std::make_unique<TTree>("Event", "Tree of event info")).first->second;
+    tree->Branch("ID", &output->current_event, basket_size_);
+    tree->Branch("seed", &output->current_seed, basket_size_);
+    tree->Branch("weight", &output->current_weight, basket_size_);
+    if(config_.has("auto_flush")) {
+        tree->SetAutoFlush(config_.get<Long64_t>("auto_flush"));
+    }
+
+    // Create tree to hold the index of the event content, the object counts are added together with their branches
+    if(write_index_) {
+        auto& index_tree = output->trees
+                               .emplace("EventIndex", std::make_unique<TTree>("EventIndex", "Tree of event content"))
+                               .first->second;
+        index_tree->Branch("ID", &output->current_event, basket_size_);
+        for(auto& detector : geo_mgr_->getDetectors()) {
+            auto branch_name = detector->getName() + "_charge";
+            index_tree->Branch(branch_name.c_str(), &output->index_charges[detector->getName()], basket_size_);
+        }
+    }
+    return output;
+}
+
+void ROOTObjectWriterModule::initialize() {
+    // Create output file
+    auto output_file_name = createOutputFile(config_.get<std::string>("file_name", "data"), "root", true);
+    if(parallel_output_) {
+        // The merged file is only created at the end of the run from the output files of the threads
+        output_ = std::make_unique<OutputSet>();
+        output_->file_name = output_file_name;
+        LOG(INFO) << "Writing separate output files per thread, merging them at the end of the run";
+    } else {
+        output_ = create_output(output_file_name);
+    }
 
     // Check if the given type of object is contained in the inclusion or exclusion filter rules:
     auto check_object_filter = [](const std::string& object, const std::set<std::string>& arr, bool inclusive) {
@@ -92,168 +167,328 @@ void ROOTObjectWriterModule::initialize() {
                      << std::endl
                      << "It is advised to use the include and exclude parameters to select object types specifically.";
     }
+
+    if(write_asynchronously_) {
+        LOG(INFO) << "Writing objects asynchronously, buffering up to " << write_queue_size_ << " events";
+        writer_.start(write_queue_size_, [this](std::deque<PendingEvent>& batch) {
+            for(auto& pending : batch) {
+                write_event(*output_, pending);
+            }
+        });
+    }
 }
 
 bool ROOTObjectWriterModule::filter(const std::shared_ptr<BaseMessage>& message,
                                     const std::string& message_name) const { // NOLINT
-    try {
-        const BaseMessage* inst = message.get();
-        std::string name_str = " without a name";
-        if(!message_name.empty()) {
-            name_str = " named " + message_name;
-        }
-        LOG(TRACE) << "ROOT object writer received " << allpix::demangle(typeid(*inst).name()) << name_str;
+    // Look up the decision for this message type, only evaluated when the type is received for the first time
+    const auto* entry = filter_cache_.get(*message, [this](const std::string& class_name) {
+        return (include_.empty() || include_.find(class_name) != include_.cend()) &&
+               (exclude_.empty() || exclude_.find(class_name) == exclude_.cend());
+    });
+    if(entry == nullptr) {
+        return false;
+    }
 
-        // Read the object
-        auto object_array = message->getObjectArray();
-        if(object_array.empty()) {
-            return false;
-        }
-        const Object& first_object = object_array[0];
-        std::string class_name = allpix::demangle(typeid(first_object).name());
-
-        // Check if this message should be kept
-        if((!include_.empty() && include_.find(class_name) == include_.cend()) ||
-           (!exclude_.empty() && exclude_.find(class_name) != exclude_.cend())) {
-            LOG(TRACE) << "ROOT object writer ignored message with object " << allpix::demangle(typeid(*inst).name())
-                       << " because it has been excluded or not explicitly included";
-            return false;
-        }
-    } catch(MessageWithoutObjectException& e) {
-        const BaseMessage* inst = message.get();
-        LOG(WARNING) << "ROOT object writer cannot process message of type" << allpix::demangle(typeid(*inst).name())
-                     << " with name " << message_name;
+    if(!entry->objects) {
+        LOG_ONCE(WARNING) << "ROOT object writer cannot process message of type "
+                          << allpix::demangle(typeid(*message).name()) << " with name " << message_name;
+        return false;
+    }
+    if(!entry->keep) {
+        LOG(TRACE) << "ROOT object writer ignored message with object " << entry->class_name
+                   << " because it has been excluded or not explicitly included";
         return false;
     }
 
-    return true;
+    // Empty messages are not stored
+    return message->getObjectCount() != 0;
 }
 
 void ROOTObjectWriterModule::run(Event* event) {
-    auto root_lock = root_process_lock();
-
-    // Retrieve current object count:
-    auto object_count = TProcessID::GetObjectCount();
+    OutputSet* thread_output = nullptr;
+    PendingEvent pending;
+    pending.number = event->number;
+    pending.seed = event->getSeed();
+    pending.weight = event->getWeight();
 
     // Fetch filtered messages
-    auto messages = messenger_->fetchFilteredMessages(this, event);
+    pending.messages = messenger_->fetchFilteredMessages(this, event);
 
-    // Mark objects to be stored:
-    for(auto& pair : messages) {
-        auto& message = pair.first;
-        auto object_array = message->getObjectArray();
+    // Mark objects to be stored. The objects of this event are only accessed by this thread, such that this does not
+    // require the ROOT process lock.
+    for(auto& pair : pending.messages) {
+        auto object_array = pair.first->getObjectArray();
         for(Object& object : object_array) {
             object.markForStorage();
         }
     }
 
+    {
+        auto root_lock = root_process_lock();
+
+        // Retrieve current object count:
+        auto object_count = TProcessID::GetObjectCount();
+
+        // Trigger the creation of TRefs for cross-object references to be able to store them
+        for(auto& pair : pending.messages) {
+            auto object_array = pair.first->getObjectArray();
+            for(Object& object : object_array) {
+                object.petrifyHistory();
+            }
+        }
+
+        if(parallel_output_) {
+            // Fetch the output file of this thread, creating it on its first event
+            auto& output = thread_outputs_[std::this_thread::get_id()];
+            if(output == nullptr) {
+                auto file_name = output_->file_name;
+                file_name.insert(file_name.size() - 5, "_thread" + std::to_string(thread_outputs_.size() - 1));
+                output = create_output(file_name);
+            }
+            thread_output = output.get();
+        }
+
+        // We can reset the TObject count after processing this event because the TRef creation is only done here locally
+        // in one worker thread instead of framework wide.
+        TProcessID::SetObjectCount(object_count);
+    }
+
+    if(thread_output != nullptr) {
+        // The output file of this thread is not accessed by any other thread
+        write_event(*thread_output, pending);
+    } else if(write_asynchronously_) {
+        writer_.push(std::move(pending));
+    } else {
+        // The shared output file is filled outside of the ROOT process lock, the references have been created already
+        std::lock_guard<std::mutex> lock(output_mutex_);
+        write_event(*output_, pending);
+    }
+}
+
+void ROOTObjectWriterModule::create_branch(OutputSet& output,
+                                           const BranchKey& key,
+                                           const std::pair<std::string, std::string>& class_name) {
+    const auto& [name, name_with_namespace] = class_name;
+    const auto& detector_name = std::get<1>(key);
+    const auto& message_name = std::get<2>(key);
+
+    // Add vector of objects to write to the write list
+    output.write_list[key] = new std::vector<Object*>();
+    auto* addr = &output.write_list[key];
+
+    auto new_tree = (output.trees.find(name) == output.trees.end());
+    if(new_tree) {
+        // Create new tree
+        output.file->cd();
+        output.trees.emplace(name, std::make_unique<TTree>(name.c_str(), (std::string("Tree of ") + name).c_str()));
+        if(config_.has("auto_flush")) {
+            output.trees[name]->SetAutoFlush(config_.get<Long64_t>("auto_flush"));
+        }
+    }
+
+    std::string branch_name = detector_name.empty() ? "global" : detector_name;
+    if(!message_name.empty()) {
+        branch_name += "_";
+        branch_name += message_name;
+    }
+
+    output.trees[name]->Bronch(
+        branch_name.c_str(), (std::string("std::vector<") + name_with_namespace + "*>").c_str(), addr, basket_size_);
+
+    // Prefill new tree or new branch with empty records for all events that were missed since the start
+    auto last_event = output.trees["Event"]->GetEntries();
+    if(last_event > 0) {
+        if(new_tree) {
+            LOG(DEBUG) << "Pre-filling new tree of " << name << " with " << last_event << " empty events";
+            for(Long64_t i = 0; i < last_event; ++i) {
+                output.trees[name]->Fill();
+            }
+        } else {
+            LOG(DEBUG) << "Pre-filling new branch " << branch_name << " of " << name << " with " << last_event
+                       << " empty events";
+            auto* branch = output.trees[name]->GetBranch(branch_name.c_str());
+            for(Long64_t i = 0; i < last_event; ++i) {
+                branch->Fill();
+            }
+        }
+    }
+
+    // Add the object count of this detector and type to the event index, shared by all messages with different names
+    auto index_name = (detector_name.empty() ? "global" : detector_name) + "_" + name;
+    if(write_index_ && output.index_counts.find(index_name) == output.index_counts.end()) {
+        auto* branch =
+            output.trees["EventIndex"]->Branch(index_name.c_str(), &output.index_counts[index_name], basket_size_);
+        for(Long64_t i = 0; i < last_event; ++i) {
+            branch->Fill();
+        }
+    }
+}
+
+void ROOTObjectWriterModule::write_event(OutputSet& output, PendingEvent& pending) {
     // Add event data
-    current_event_ = event->number;
-    current_seed_ = event->getSeed();
+    output.current_event = pending.number;
+    output.current_seed = pending.seed;
+    output.current_weight = pending.weight;
 
     // Generate trees and index data
-    for(auto& pair : messages) {
+    for(auto& pair : pending.messages) {
         auto& message = pair.first;
         auto& message_name = pair.second;
 
-        // Get the detector name
-        std::string detector_name;
-        if(message->getDetector() != nullptr) {
-            detector_name = message->getDetector()->getName();
+        // Find the branch of this message, first in the flat list of branches already used by this output set
+        const Detector* detector = message->getDetector().get();
+        std::type_index message_type = typeid(*message);
+        std::vector<Object*>* objects = nullptr;
+        const OutputSet::CachedBranch* cached = nullptr;
+        for(const auto& branch : output.branch_cache) {
+            if(branch.message_type == message_type && branch.detector == detector && branch.message_name == message_name) {
+                objects = branch.objects;
+                cached = &branch;
+                break;
+            }
         }
 
         // Read the object
         auto object_array = message->getObjectArray();
-        // object_array emptiness is checked in the filter
-        const Object& first_object = object_array[0];
-        std::type_index type_idx = typeid(first_object);
-
-        // Create a new branch of the correct type if this message was not received before
-        auto index_tuple = std::make_tuple(type_idx, detector_name, message_name);
-        if(write_list_.find(index_tuple) == write_list_.end()) {
-
-            std::string class_name = allpix::demangle(typeid(first_object).name());
-            std::string class_name_with_namespace = allpix::demangle(typeid(first_object).name(), true);
-
-            // Add vector of objects to write to the write list
-            write_list_[index_tuple] = new std::vector<Object*>();
-            auto* addr = &write_list_[index_tuple];
-
-            auto new_tree = (trees_.find(class_name) == trees_.end());
-            if(new_tree) {
-                // Create new tree
-                output_file_->cd();
-                trees_.emplace(class_name,
-                               std::make_unique<TTree>(class_name.c_str(), (std::string("Tree of ") + class_name).c_str()));
-            }
 
-            std::string branch_name = detector_name.empty() ? "global" : detector_name;
-            if(!message_name.empty()) {
-                branch_name += "_";
-                branch_name += message_name;
+        if(objects == nullptr) {
+            // object_array emptiness is checked in the filter
+            const Object& first_object = object_array[0];
+            std::type_index type_idx = typeid(first_object);
+            std::string detector_name = (detector != nullptr ? detector->getName() : "");
+
+            // Create a new branch of the correct type if this message was not received before
+            auto index_tuple = std::make_tuple(type_idx, detector_name, message_name);
+            if(output.write_list.find(index_tuple) == output.write_list.end()) {
+                auto class_name = std::make_pair(allpix::demangle(typeid(first_object).name()),
+                                                 allpix::demangle(typeid(first_object).name(), true));
+                {
+                    std::lock_guard<std::mutex> lock(branch_mutex_);
+                    branch_classes_.emplace(index_tuple, class_name);
+                }
+                create_branch(output, index_tuple, class_name);
             }
+            objects = output.write_list[index_tuple];
+
+            // Look up the entries of the event index, the pixel charge is summed per detector
+            UInt_t* index_count = nullptr;
+            Double_t* index_charge = nullptr;
+            if(write_index_) {
+                auto index_name =
+                    (detector_name.empty() ? "global" : detector_name) + "_" + allpix::demangle(type_idx.name());
+                index_count = &output.index_counts[index_name];
+                if(detector != nullptr && message_type == typeid(PixelChargeMessage)) {
+                    index_charge = &output.index_charges[detector_name];
+                }
+            }
+            output.branch_cache.push_back({message_type, detector, message_name, objects, index_count, index_charge});
+            cached = &output.branch_cache.back();
+        }
 
-            trees_[class_name]->Bronch(
-                branch_name.c_str(), (std::string("std::vector<") + class_name_with_namespace + "*>").c_str(), addr);
-
-            // Prefill new tree or new branch with empty records for all events that were missed since the start
-            auto last_event = trees_["Event"]->GetEntries();
-            if(last_event > 0) {
-                if(new_tree) {
-                    LOG(DEBUG) << "Pre-filling new tree of " << class_name << " with " << last_event << " empty events";
-                    for(Long64_t i = 0; i < last_event; ++i) {
-                        trees_[class_name]->Fill();
-                    }
-                } else {
-                    LOG(DEBUG) << "Pre-filling new branch " << branch_name << " of " << class_name << " with " << last_event
-                               << " empty events";
-                    auto* branch = trees_[class_name]->GetBranch(branch_name.c_str());
-                    for(Long64_t i = 0; i < last_event; ++i) {
-                        branch->Fill();
-                    }
+        // Update the event index
+        if(cached->index_count != nullptr) {
+            *cached->index_count += static_cast<UInt_t>(object_array.size());
+            if(cached->message_type == typeid(DepositedChargeMessage)) {
+                // Deposits of electron-hole pairs are counted once per carrier type, independent of paired deposits
+                for(Object& object : object_array) {
+                    *cached->index_count += (static_cast<DepositedCharge&>(object).isPaired() ? 1 : 0);
+                }
+            }
+            if(cached->index_charge != nullptr) {
+                for(Object& object : object_array) {
+                    *cached->index_charge += static_cast<Double_t>(static_cast<PixelCharge&>(object).getCharge());
                 }
             }
         }
 
         // Fill the branch vector
+        write_cnt_ += object_array.size();
+        objects->reserve(objects->size() + object_array.size());
         for(Object& object : object_array) {
-            // Trigger the creation of TRefs for cross-object references to be able to store them to file.
-            object.petrifyHistory();
-            ++write_cnt_;
-            write_list_[index_tuple]->push_back(&object);
+            objects->push_back(&object);
         }
     }
 
     LOG(TRACE) << "Writing new objects to tree";
-    output_file_->cd();
+    output.file->cd();
 
     // Fill the tree with the current received messages
-    for(auto& tree : trees_) {
+    for(auto& tree : output.trees) {
         tree.second->Fill();
     }
 
     // Clear the current message list
-    for(auto& index_data : write_list_) {
+    for(auto& index_data : output.write_list) {
         index_data.second->clear();
     }
 
-    // We can reset the TObject count after processing this event because the TRef creation is only done here locally
-    // in one worker thread instead of framework wide.
-    TProcessID::SetObjectCount(object_count);
+    // Reset the event index
+    for(auto& count : output.index_counts) {
+        count.second = 0;
+    }
+    for(auto& charge : output.index_charges) {
+        charge.second = 0;
+    }
+}
+
+int ROOTObjectWriterModule::merge_outputs() {
+    TFileMerger merger(false);
+    merger.OutputFile(output_->file_name.c_str(), "RECREATE");
+
+    // All trees of the thread files have identical structure, the branches are counted in the first file
+    int branch_count = 0;
+
+    for(auto& [thread, thread_output] : thread_outputs_) {
+        // Add all branches seen by any thread, such that all trees of the thread files have identical structure
+        for(const auto& [key, class_name] : branch_classes_) {
+            if(thread_output->write_list.find(key) == thread_output->write_list.end()) {
+                create_branch(*thread_output, key, class_name);
+            }
+        }
+
+        thread_output->file->cd();
+        thread_output->file->Write();
+        if(branch_count == 0) {
+            for(auto& tree : thread_output->trees) {
+                branch_count += tree.second->GetListOfBranches()->GetEntries();
+            }
+        }
+        thread_output->trees.clear();
+        thread_output->file->Close();
+        merger.AddFile(thread_output->file_name.c_str(), false);
+    }
+
+    LOG(INFO) << "Merging output files of " << thread_outputs_.size() << " threads";
+    if(!thread_outputs_.empty() && !merger.Merge()) {
+        throw ModuleError("Could not merge the output files of the individual threads");
+    }
+    for(auto& thread_output : thread_outputs_) {
+        std::remove(thread_output.second->file_name.c_str());
+    }
+
+    // Reopen the merged file to add the configuration and detector setup
+    output_->file = std::make_unique<TFile>(output_->file_name.c_str(), (thread_outputs_.empty() ? "RECREATE" : "UPDATE"));
+    return branch_count;
 }
 
 void ROOTObjectWriterModule::finalize() {
-    LOG(TRACE) << "Writing objects to file";
-    output_file_->cd();
+    writer_.finish();
 
     int branch_count = 0;
-    for(auto& tree : trees_) {
-        // Update statistics
-        branch_count += tree.second->GetListOfBranches()->GetEntries();
+    if(parallel_output_) {
+        branch_count = merge_outputs();
+    } else {
+        for(auto& tree : output_->trees) {
+            // Update statistics
+            branch_count += tree.second->GetListOfBranches()->GetEntries();
+        }
     }
 
+    LOG(TRACE) << "Writing objects to file";
+    output_->file->cd();
+
     // Create main config directory
-    TDirectory* config_dir = output_file_->mkdir("config");
+    TDirectory* config_dir = output_->file->mkdir("config");
     config_dir->cd();
 
     // Get the config manager
@@ -291,8 +526,8 @@ void ROOTObjectWriterModule::finalize() {
     }
 
     // Save the detectors to the output file
-    auto* detectors_dir = output_file_->mkdir("detectors");
-    auto* models_dir = output_file_->mkdir("models");
+    auto* detectors_dir = output_->file->mkdir("detectors");
+    auto* models_dir = output_->file->mkdir("models");
     for(auto& detector : geo_mgr_->getDetectors()) {
         detectors_dir->cd();
         LOG(TRACE) << "Writing detector configuration for: " << detector->getName();
@@ -328,9 +563,9 @@ void ROOTObjectWriterModule::finalize() {
     }
 
     // Finish writing to output file
-    output_file_->Write();
+    output_->file->Write();
 
     // Print statistics
     LOG(STATUS) << "Wrote " << write_cnt_ << " objects to " << branch_count << " branches in file:" << std::endl
-                << output_file_name_;
+                << output_->file_name;
 }
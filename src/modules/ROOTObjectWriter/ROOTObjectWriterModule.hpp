@@ -11,7 +11,13 @@
 
 #include <atomic>
 #include <map>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <typeindex>
+#include <utility>
+#include <vector>
 
 #include <TFile.h>
 #include <TTree.h>
@@ -22,6 +28,9 @@
 #include "core/module/Event.hpp"
 #include "core/module/Module.hpp"
 
+#include "tools/async_writer.h"
+#include "tools/message_filter.h"
+
 namespace allpix {
     /**
      * @ingroup Modules
@@ -69,28 +78,115 @@ namespace allpix {
         void finalize() override;
 
     private:
+        /**
+         * @brief Messages of an event prepared for writing, keeping the objects alive until they are written
+         */
+        struct PendingEvent {
+            uint64_t number{};
+            uint64_t seed{};
+            double weight{1.};
+            std::vector<std::pair<std::shared_ptr<BaseMessage>, std::string>> messages;
+        };
+
+        // Key of a branch: type of the objects, name of the detector and name of the message
+        using BranchKey = std::tuple<std::type_index, std::string, std::string>;
+
+        /**
+         * @brief Output file with its trees and the lists of objects bound to their branches
+         */
+        struct OutputSet {
+            // Output data file to write
+            std::unique_ptr<TFile> file;
+            std::string file_name;
+
+            // Current event, random seed and weight
+            uint64_t current_event{0};
+            uint64_t current_seed{0};
+            double current_weight{1.};
+
+            // List of trees that are stored in data file
+            std::map<std::string, std::unique_ptr<TTree>> trees;
+
+            // List of objects of a particular type, bound to a specific detector and having a particular name
+            std::map<BranchKey, std::vector<Object*>*> write_list;
+
+            // Event index with the number of objects per detector and type and the pixel charge per detector
+            std::map<std::string, UInt_t> index_counts;
+            std::map<std::string, Double_t> index_charges;
+
+            // Flat list of the branches used so far, looked up by message type, detector and message name to avoid
+            // demangling the object type and comparing detector names for every message
+            struct CachedBranch {
+                std::type_index message_type;
+                const Detector* detector;
+                std::string message_name;
+                std::vector<Object*>* objects;
+                // Entries of the event index to update, null if not writing the index or not applicable
+                UInt_t* index_count;
+                Double_t* index_charge;
+            };
+            std::vector<CachedBranch> branch_cache;
+        };
+
+        /**
+         * @brief Open an output file and create its tree holding the event information
+         * @param file_name Path of the file to create
+         * @return Output set of the newly created file
+         */
+        std::unique_ptr<OutputSet> create_output(const std::string& file_name);
+
+        /**
+         * @brief Create a branch in an output set, creating its tree if necessary and prefilling it for all previous events
+         * @param output Output set to create the branch in
+         * @param key Key of the branch
+         * @param class_name Class name of the objects stored in the branch, without and with namespace
+         */
+        void create_branch(OutputSet& output, const BranchKey& key, const std::pair<std::string, std::string>& class_name);
+
+        /**
+         * @brief Create missing trees and branches and fill all trees with the objects of an event
+         * @param output Output set to write the event to
+         * @param pending Event to write
+         */
+        void write_event(OutputSet& output, PendingEvent& pending);
+
+        /**
+         * @brief Complete the per-thread output files and merge them into the final output file
+         * @return Number of branches in the merged file
+         */
+        int merge_outputs();
+
         Messenger* messenger_;
         GeometryManager* geo_mgr_;
 
+        // Output tuning parameters
+        int basket_size_{};
+
+        // Write a separate tree indexing the content of every event to select events when reading
+        bool write_index_{};
+
+        bool write_asynchronously_{};
+        size_t write_queue_size_{};
+        AsyncWriter<PendingEvent> writer_;
+
         // Object names to include or exclude from writing
         std::set<std::string> include_;
         std::set<std::string> exclude_;
+        // Decisions of the filter per message type
+        mutable MessageFilterCache filter_cache_;
 
-        // Output data file to write
-        std::unique_ptr<TFile> output_file_;
-        std::string output_file_name_{};
-
-        // Current event
-        uint64_t current_event_{0};
-
-        // Current random seed
-        uint64_t current_seed_{0};
+        // Output file to write, holding the merged output of all threads when writing in parallel
+        std::unique_ptr<OutputSet> output_;
+        // Serializes the synchronous writing of events to the shared output file
+        std::mutex output_mutex_;
 
-        // List of trees that are stored in data file
-        std::map<std::string, std::unique_ptr<TTree>> trees_;
+        // Separate output files of every worker thread, merged at the end of the run
+        bool parallel_output_{};
+        std::map<std::thread::id, std::unique_ptr<OutputSet>> thread_outputs_;
 
-        // List of objects of a particular type, bound to a specific detector and having a particular name
-        std::map<std::tuple<std::type_index, std::string, std::string>, std::vector<Object*>*> write_list_;
+        // Class names of all branches created in any output file
+        std::mutex branch_mutex_;
+        std::map<BranchKey, std::pair<std::string, std::string>> branch_classes_;
 
         // Statistical information about number of objects
         std::atomic<unsigned long> write_cnt_{};
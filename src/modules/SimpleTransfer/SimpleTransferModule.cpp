@@ -23,6 +23,7 @@
 #include "core/utils/log.h"
 #include "core/utils/unit.h"
 #include "tools/ROOT.h"
+#include "tools/pixel_map.h"
 
 #include "objects/PixelCharge.hpp"
 
@@ -30,6 +31,23 @@ using namespace allpix;
 
 SimpleTransferModule::SimpleTransferModule(Configuration& config, Messenger* messenger, std::shared_ptr<Detector> detector)
     : Module(config, detector), messenger_(messenger), detector_(std::move(detector)) {
+    configure();
+
+    // Require propagated deposits for single detector
+    messenger_->bindSingle<PropagatedChargeMessage>(this, MsgFlags::REQUIRED);
+}
+
+SimpleTransferModule::SimpleTransferModule(Configuration& config,
+                                           Messenger* messenger,
+                                           std::vector<std::shared_ptr<Detector>> detectors)
+    : Module(config, std::move(detectors)), messenger_(messenger) {
+    configure();
+
+    // Require propagated deposits for at least one of the detectors
+    messenger_->bindMulti<PropagatedChargeMessage>(this, MsgFlags::REQUIRED);
+}
+
+void SimpleTransferModule::configure() {
     // Enable multithreading of this module if multithreading is enabled
     allow_multithreading();
 
@@ -44,36 +62,35 @@ SimpleTransferModule::SimpleTransferModule(Configuration& config, Messenger* mes
     config_.setDefault<double>("output_plots_step", Units::get(0.1, "ns"));
     config_.setDefault<double>("output_plots_range", Units::get(100, "ns"));
 
-    // Save detector model
-    model_ = detector_->getModel();
-
     // Cache config parameters:
     max_depth_distance_ = config_.get<double>("max_depth_distance");
     collect_from_implant_ = config_.get<bool>("collect_from_implant");
 
     // Cache flag for output plots:
     output_plots_ = config_.get<bool>("output_plots");
-
-    // Require propagated deposits for single detector
-    messenger_->bindSingle<PropagatedChargeMessage>(this, MsgFlags::REQUIRED);
 }
 
 void SimpleTransferModule::initialize() {
 
-    auto model = detector_->getModel();
-    if(collect_from_implant_) {
-        if(model->getImplants().empty()) {
-            throw InvalidValueError(config_,
-                                    "collect_from_implant",
-                                    "Detector model does not have implants defined, but collection requested from implants");
-        }
-        if(detector_->getElectricFieldType() == FieldType::LINEAR) {
-            throw ModuleError("Charge collection from implant region should not be used with linear electric fields.");
+    for(const auto& detector : getDetectors()) {
+        auto model = detector->getModel();
+        if(collect_from_implant_) {
+            if(model->getImplants().empty()) {
+                throw InvalidValueError(
+                    config_,
+                    "collect_from_implant",
+                    "Detector model does not have implants defined, but collection requested from implants");
+            }
+            if(detector->getElectricFieldType() == FieldType::LINEAR) {
+                throw ModuleError("Charge collection from implant region should not be used with linear electric fields.");
+            }
+        } else if(!model->getImplants().empty()) {
+            LOG(WARNING) << "Detector " << detector->getName() << " of type " << model->getType()
+                         << " has implants defined but collecting charge carriers from full sensor surface";
         }
+    }
+    if(collect_from_implant_) {
         LOG(INFO) << "Collecting charges from implants";
-    } else if(!model->getImplants().empty()) {
-        LOG(WARNING) << "Detector " << detector_->getName() << " of type " << model->getType()
-                     << " has implants defined but collecting charge carriers from full sensor surface";
     }
 
     if(output_plots_) {
@@ -88,31 +105,53 @@ void SimpleTransferModule::initialize() {
 }
 
 void SimpleTransferModule::run(Event* event) {
-    auto propagated_message = messenger_->fetchMessage<PropagatedChargeMessage>(this, event);
+    if(detector_ != nullptr) {
+        auto propagated_message = messenger_->fetchMessage<PropagatedChargeMessage>(this, event);
+        messenger_->dispatchMessage(this, transfer(detector_, *propagated_message), event);
+        return;
+    }
+
+    // Transfer the charges of all detectors handled by this instance
+    for(const auto& propagated_message : messenger_->fetchMultiMessage<PropagatedChargeMessage>(this, event)) {
+        messenger_->dispatchMessage(this, transfer(propagated_message->getDetector(), *propagated_message), event);
+    }
+}
+
+std::shared_ptr<PixelChargeMessage> SimpleTransferModule::transfer(const std::shared_ptr<const Detector>& detector,
+                                                                   const PropagatedChargeMessage& propagated_message) {
+    auto model = detector->getModel();
 
     // Find corresponding pixels for all propagated charges
     LOG(TRACE) << "Transferring charges to pixels";
     unsigned int transferred_charges_count = 0;
-    std::map<Pixel::Index, std::vector<const PropagatedCharge*>> pixel_map;
-    for(const auto& propagated_charge : propagated_message->getData()) {
+    // Reuse the pixel map and buffers of this thread across events to avoid allocations
+    thread_local PixelMap<std::vector<const PropagatedCharge*>> pixel_map;
+    thread_local std::vector<const PropagatedCharge*> collected_charges;
+    thread_local std::vector<ROOT::Math::XYZPoint> collected_positions;
+    thread_local std::vector<Pixel::Index> collected_indices;
+    pixel_map.clear();
+    collected_charges.clear();
+    collected_positions.clear();
+    for(const auto& propagated_charge : propagated_message.getData()) {
         auto position = propagated_charge.getLocalPosition();
 
         if(collect_from_implant_) {
             // Ignore if outside the implant region:
-            auto implant = model_->isWithinImplant(position);
-            if(!implant.has_value()) {
+            auto implant_index = model->findImplant(position);
+            if(!implant_index.has_value()) {
                 LOG(TRACE) << "Skipping set of " << propagated_charge.getCharge() << " propagated charges at "
                            << Units::display(propagated_charge.getLocalPosition(), {"mm", "um"})
                            << " because their local position is outside the pixel implant";
                 continue;
             }
-            if(implant->getType() != DetectorModel::Implant::Type::FRONTSIDE) {
+            const auto& implant = model->getImplants()[implant_index.value()];
+            if(implant.getType() != DetectorModel::Implant::Type::FRONTSIDE) {
                 LOG(TRACE) << "Skipping set of " << propagated_charge.getCharge() << " propagated charges at "
                            << Units::display(propagated_charge.getLocalPosition(), {"mm", "um"})
-                           << " because the pixel implant is located at " << allpix::to_string(implant->getType());
+                           << " because the pixel implant is located at " << allpix::to_string(implant.getType());
                 continue;
             }
-        } else if(std::fabs(position.z() - (model_->getSensorCenter().z() + model_->getSensorSize().z() / 2.0)) >
+        } else if(std::fabs(position.z() - (model->getSensorCenter().z() + model->getSensorSize().z() / 2.0)) >
                   max_depth_distance_) {
             // Ignore if not close to the sensor surface:
             LOG(TRACE) << "Skipping set of " << propagated_charge.getCharge() << " propagated charges at "
@@ -121,19 +160,25 @@ void SimpleTransferModule::run(Event* event) {
             continue;
         }
 
-        // Find the nearest pixel
-        auto [xpixel, ypixel] = model_->getPixelIndex(position);
+        collected_charges.push_back(&propagated_charge);
+        collected_positions.push_back(position);
+    }
+
+    // Find the nearest pixels of all collected charges at once
+    model->getPixelIndices(collected_positions, collected_indices);
+    for(size_t i = 0; i < collected_charges.size(); ++i) {
+        const auto& propagated_charge = *collected_charges[i];
+        const auto& pixel_index = collected_indices[i];
 
         // Ignore if out of pixel grid
-        if(!model_->isWithinMatrix(xpixel, ypixel)) {
+        if(!model->isWithinMatrix(pixel_index)) {
             LOG(TRACE) << "Skipping set of " << propagated_charge.getCharge() << " propagated charges at "
                        << Units::display(propagated_charge.getLocalPosition(), {"mm", "um"})
-                       << " because their nearest pixel (" << xpixel << "," << ypixel << ") is outside the grid";
+                       << " because their nearest pixel (" << pixel_index.x() << "," << pixel_index.y()
+                       << ") is outside the grid";
             continue;
         }
 
-        Pixel::Index pixel_index(xpixel, ypixel);
-
         // Update statistics
         transferred_charges_count += propagated_charge.getCharge();
 
@@ -151,7 +196,9 @@ void SimpleTransferModule::run(Event* event) {
 
     // Create pixel charges
     LOG(TRACE) << "Combining charges at same pixel";
+    pixel_map.sort();
     std::vector<PixelCharge> pixel_charges;
+    pixel_charges.reserve(pixel_map.size());
     for(auto& pixel_index_charge : pixel_map) {
         long charge = 0;
         for(auto& propagated_charge : pixel_index_charge.second) {
@@ -159,7 +206,7 @@ void SimpleTransferModule::run(Event* event) {
         }
 
         // Get pixel object from detector
-        auto pixel = detector_->getPixel(pixel_index_charge.first.x(), pixel_index_charge.first.y());
+        auto pixel = detector->getPixel(pixel_index_charge.first.x(), pixel_index_charge.first.y());
 
         pixel_charges.emplace_back(pixel, charge, pixel_index_charge.second);
         LOG(DEBUG) << "Set of " << charge << " charges combined at " << pixel.getIndex();
@@ -169,9 +216,8 @@ void SimpleTransferModule::run(Event* event) {
     LOG(INFO) << "Transferred " << transferred_charges_count << " charges to " << pixel_map.size() << " pixels";
     total_transferred_charges_ += transferred_charges_count;
 
-    // Dispatch message of pixel charges
-    auto pixel_message = std::make_shared<PixelChargeMessage>(pixel_charges, detector_);
-    messenger_->dispatchMessage(this, pixel_message, event);
+    // Create message of pixel charges
+    return std::make_shared<PixelChargeMessage>(std::move(pixel_charges), detector);
 }
 
 void SimpleTransferModule::finalize() {
@@ -48,6 +48,16 @@ namespace allpix {
          */
         SimpleTransferModule(Configuration& config, Messenger* messenger, std::shared_ptr<Detector> detector);
 
+        /**
+         * @brief Constructor for a single module instance transferring the charges of multiple detectors
+         * @param config Configuration object for this module as retrieved from the steering file
+         * @param messenger Pointer to the messenger object to allow binding to messages on the bus
+         * @param detectors Pointers to all detectors handled by this module instance
+         */
+        SimpleTransferModule(Configuration& config,
+                             Messenger* messenger,
+                             std::vector<std::shared_ptr<Detector>> detectors);
+
         /**
          * @brief Initialize - check for field configuration and implants
          */
@@ -64,10 +74,24 @@ namespace allpix {
         void finalize() override;
 
     private:
+        /**
+         * @brief Set the configuration defaults and cache the configuration parameters
+         */
+        void configure();
+
+        /**
+         * @brief Transfer the propagated charges of a single detector to its pixels
+         * @param detector Detector the propagated charges belong to
+         * @param propagated_message Message with the propagated charges of the detector
+         * @return Message with the pixel charges of the detector
+         */
+        std::shared_ptr<PixelChargeMessage> transfer(const std::shared_ptr<const Detector>& detector,
+                                                     const PropagatedChargeMessage& propagated_message);
+
         Messenger* messenger_;
 
+        // Detector of this instance, null for a single instance handling multiple detectors
         std::shared_ptr<Detector> detector_;
-        std::shared_ptr<DetectorModel> model_;
 
         Histogram<TH1D> drift_time_histo;
 
@@ -0,0 +1,94 @@
+/**
+ * @file
+ * @brief Binary message layout of the pixel data published by the StreamWriter module
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ *
+ * This header only depends on the C++ standard library, such that external consumers can include it to decode the stream.
+ */
+
+#ifndef ALLPIX_STREAM_WRITER_PIXEL_STREAM_H
+#define ALLPIX_STREAM_WRITER_PIXEL_STREAM_H
+
+#include <cstdint>
+
+namespace allpix {
+    /**
+     * @brief Header of the setup message sent once to every subscriber after connecting
+     *
+     * The header is followed by one \ref PixelStreamDetector record per detector, the position of a record is the detector
+     * index used in all further messages.
+     */
+    struct PixelStreamSetup {
+        // Magic number identifying the setup message, "APXS" in ASCII
+        static constexpr uint32_t magic_number = 0x53585041;
+
+        uint32_t magic{magic_number};
+        // Number of detector records following the header
+        uint32_t detectors{};
+    };
+
+    /**
+     * @brief Name of a detector of the setup
+     */
+    struct PixelStreamDetector {
+        // Name of the detector, zero-terminated unless all characters are used
+        char name[64]{}; // NOLINT
+    };
+
+    /**
+     * @brief Header of the message holding the data of a single event
+     *
+     * The header is followed by the hit records and then by the pulse records of the event.
+     */
+    struct PixelStreamEvent {
+        // Magic number identifying the event message, "APXE" in ASCII
+        static constexpr uint32_t magic_number = 0x45585041;
+
+        uint32_t magic{magic_number};
+        // Number of hit records following the header
+        uint32_t hits{};
+        // Event number as assigned by the framework, starting from one
+        uint64_t event{};
+        // Number of pulse records following the hit records
+        uint32_t pulses{};
+        uint32_t reserved{};
+    };
+
+    /**
+     * @brief Single pixel hit, all values in the internal units of the framework
+     */
+    struct PixelStreamHit {
+        double signal{};
+        double local_time{};
+        double global_time{};
+        int32_t column{};
+        int32_t row{};
+        uint32_t detector{};
+        uint32_t reserved{};
+    };
+
+    /**
+     * @brief Header of a single pixel pulse, followed by the amplitudes of all bins as double values
+     */
+    struct PixelStreamPulse {
+        double binning{};
+        int32_t column{};
+        int32_t row{};
+        uint32_t detector{};
+        // Number of bins following the header
+        uint32_t bins{};
+    };
+
+    static_assert(sizeof(PixelStreamSetup) == 8, "unexpected padding of the setup header");
+    static_assert(sizeof(PixelStreamDetector) == 64, "unexpected padding of the detector record");
+    static_assert(sizeof(PixelStreamEvent) == 24, "unexpected padding of the event header");
+    static_assert(sizeof(PixelStreamHit) == 40, "unexpected padding of the hit record");
+    static_assert(sizeof(PixelStreamPulse) == 24, "unexpected padding of the pulse record");
+} // namespace allpix
+
+#endif /* ALLPIX_STREAM_WRITER_PIXEL_STREAM_H */
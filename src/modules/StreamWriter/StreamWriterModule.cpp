@@ -0,0 +1,260 @@
+/**
+ * @file
+ * @brief Implementation of module publishing pixel data on a socket stream
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "StreamWriterModule.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "core/utils/log.h"
+
+#include "PixelStream.hpp"
+
+using namespace allpix;
+
+namespace {
+    // Append the bytes of a record to an encoded message
+    template <typename T> void append_record(std::string& message, const T& record) {
+        message.append(reinterpret_cast<const char*>(&record), sizeof(T)); // NOLINT
+    }
+
+    // Fetch messages which are not necessarily dispatched in every event
+    template <typename T>
+    std::vector<std::shared_ptr<T>> fetch_optional(Messenger* messenger, Module* module, Event* event) {
+        try {
+            return messenger->fetchMultiMessage<T>(module, event);
+        } catch(const MessageNotFoundException&) {
+            return {};
+        }
+    }
+} // namespace
+
+StreamWriterModule::StreamWriterModule(Configuration& config, Messenger* messenger, GeometryManager* geo_manager)
+    : SequentialModule(config), messenger_(messenger), geo_mgr_(geo_manager) {
+    // Enable multithreading of this module if multithreading is enabled
+    allow_multithreading();
+
+    config_.setDefault("file_name", "pixel_stream");
+    config_.setDefault<bool>("include_pulses", false);
+    config_.setDefault<bool>("ordered", true);
+    config_.setDefault<unsigned int>("high_water_mark", 1000);
+    config_.setDefault<unsigned int>("wait_for_subscribers", 0);
+
+    include_pulses_ = config_.get<bool>("include_pulses");
+    high_water_mark_ = config_.get<unsigned int>("high_water_mark");
+    if(high_water_mark_ == 0) {
+        throw InvalidValueError(config_, "high_water_mark", "queue needs to hold at least one event");
+    }
+
+    // Subscribers not relying on the event order can receive the events as soon as they have been processed
+    if(!config_.get<bool>("ordered")) {
+        waive_sequence_requirement();
+    }
+
+    // Every event is published, also if it does not contain any hits
+    messenger_->bindMulti<PixelHitMessage>(this);
+    if(include_pulses_) {
+        messenger_->bindMulti<PixelPulseMessage>(this);
+    }
+}
+
+StreamWriterModule::~StreamWriterModule() {
+    sender_.stop();
+
+    for(auto subscriber : subscribers_) {
+        ::close(subscriber);
+    }
+    if(listen_socket_ >= 0) {
+        ::close(listen_socket_);
+        std::filesystem::remove(socket_path_);
+    }
+}
+
+void StreamWriterModule::initialize() {
+    // Encode the setup message with the index of every detector
+    PixelStreamSetup setup;
+    auto detectors = geo_mgr_->getDetectors();
+    setup.detectors = static_cast<uint32_t>(detectors.size());
+    append_record(setup_message_, setup);
+    for(const auto& detector : detectors) {
+        PixelStreamDetector record;
+        detector->getName().copy(record.name, sizeof(record.name));
+        detector_index_[detector->getName()] = static_cast<uint32_t>(detector_index_.size());
+        append_record(setup_message_, record);
+    }
+
+    // Replace the file created to check the output path by the socket
+    socket_path_ = createOutputFile(config_.get<std::string>("file_name"), "sock");
+    std::filesystem::remove(socket_path_);
+    sockaddr_un address{};
+    if(socket_path_.size() >= sizeof(address.sun_path)) {
+        throw InvalidValueError(config_, "file_name", "socket path is too long");
+    }
+    address.sun_family = AF_UNIX;
+    socket_path_.copy(address.sun_path, socket_path_.size());
+
+    listen_socket_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listen_socket_ < 0) {
+        throw ModuleError("Cannot create socket: " + std::string(std::strerror(errno)));
+    }
+    if(::bind(listen_socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || // NOLINT
+       ::listen(listen_socket_, 16) != 0) {
+        throw InvalidValueError(config_, "file_name", "cannot listen on socket: " + std::string(std::strerror(errno)));
+    }
+    // Subscribers are accepted by the sending thread without blocking
+    ::fcntl(listen_socket_, F_SETFL, ::fcntl(listen_socket_, F_GETFL) | O_NONBLOCK); // NOLINT
+    LOG(STATUS) << "Publishing pixel data on socket " << socket_path_;
+
+    // Wait for the subscribers which should receive all events
+    auto wait_for = config_.get<unsigned int>("wait_for_subscribers");
+    if(wait_for > 0) {
+        LOG(STATUS) << "Waiting for " << wait_for << " subscribers to connect";
+    }
+    while(subscribers_.size() < wait_for) {
+        pollfd listen_poll{listen_socket_, POLLIN, 0};
+        if(::poll(&listen_poll, 1, -1) < 0 && errno != EINTR) {
+            throw ModuleError("Waiting for subscribers failed: " + std::string(std::strerror(errno)));
+        }
+        accept_subscribers();
+    }
+
+    // Wake up regularly to accept new subscribers while no events are processed
+    sender_.start(
+        high_water_mark_,
+        [this](std::deque<std::string>& batch) {
+            accept_subscribers();
+            for(const auto& message : batch) {
+                publish(message);
+                published_events_++;
+            }
+        },
+        false,
+        std::chrono::milliseconds(100));
+}
+
+void StreamWriterModule::run(Event* event) {
+    auto hit_messages = fetch_optional<PixelHitMessage>(messenger_, this, event);
+    std::vector<std::shared_ptr<PixelPulseMessage>> pulse_messages;
+    if(include_pulses_) {
+        pulse_messages = fetch_optional<PixelPulseMessage>(messenger_, this, event);
+    }
+
+    // Encode the event in the worker thread
+    PixelStreamEvent header;
+    header.event = event->number;
+    for(const auto& message : hit_messages) {
+        header.hits += static_cast<uint32_t>(message->getData().size());
+    }
+    for(const auto& message : pulse_messages) {
+        header.pulses += static_cast<uint32_t>(message->getData().size());
+    }
+
+    std::string message;
+    message.reserve(sizeof(PixelStreamEvent) + header.hits * sizeof(PixelStreamHit) +
+                    header.pulses * sizeof(PixelStreamPulse));
+    append_record(message, header);
+    for(const auto& hit_message : hit_messages) {
+        auto detector = detector_index_.at(hit_message->getDetector()->getName());
+        for(const auto& hit : hit_message->getData()) {
+            PixelStreamHit record;
+            record.signal = hit.getSignal();
+            record.local_time = hit.getLocalTime();
+            record.global_time = hit.getGlobalTime();
+            record.column = hit.getIndex().x();
+            record.row = hit.getIndex().y();
+            record.detector = detector;
+            append_record(message, record);
+        }
+    }
+    for(const auto& pulse_message : pulse_messages) {
+        auto detector = detector_index_.at(pulse_message->getDetector()->getName());
+        for(const auto& pulse : pulse_message->getData()) {
+            PixelStreamPulse record;
+            record.binning = pulse.getBinning();
+            record.column = pulse.getIndex().x();
+            record.row = pulse.getIndex().y();
+            record.detector = detector;
+            record.bins = static_cast<uint32_t>(pulse.size());
+            append_record(message, record);
+            message.append(reinterpret_cast<const char*>(pulse.data()), pulse.size() * sizeof(double)); // NOLINT
+        }
+    }
+
+    // Queue the event without blocking, dropping it if the subscribers cannot keep up
+    if(!sender_.try_push(std::move(message))) {
+        dropped_events_++;
+        LOG_ONCE(WARNING) << "High-water mark of " << high_water_mark_ << " events reached, dropping events";
+    }
+}
+
+size_t StreamWriterModule::accept_subscribers() {
+    size_t accepted = 0;
+    while(true) {
+        auto subscriber = ::accept(listen_socket_, nullptr, nullptr);
+        if(subscriber < 0) {
+            break;
+        }
+
+        // The connection is blocking, slow subscribers only hold up the sending thread
+        subscribers_.push_back(subscriber);
+        ++accepted;
+        LOG(INFO) << "Subscriber connected, publishing to " << subscribers_.size() << " subscribers";
+    }
+
+    // Send the setup to the new subscribers only
+    if(accepted > 0) {
+        publish(setup_message_, subscribers_.size() - accepted);
+    }
+    return accepted;
+}
+
+void StreamWriterModule::publish(const std::string& message, size_t first) {
+    for(auto it = subscribers_.begin() + static_cast<std::ptrdiff_t>(first); it != subscribers_.end();) {
+        size_t sent = 0;
+        while(sent < message.size()) {
+            auto result = ::send(*it, message.data() + sent, message.size() - sent, MSG_NOSIGNAL);
+            if(result < 0 && errno == EINTR) {
+                continue;
+            }
+            if(result <= 0) {
+                break;
+            }
+            sent += static_cast<size_t>(result);
+        }
+
+        if(sent < message.size()) {
+            LOG(WARNING) << "Subscriber disconnected: " << std::strerror(errno);
+            ::close(*it);
+            it = subscribers_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void StreamWriterModule::finalize() {
+    // Send all queued events before closing the connections
+    sender_.finish();
+
+    LOG(STATUS) << "Published " << published_events_ << " events to " << subscribers_.size() << " subscribers, dropped "
+                << dropped_events_ << " events";
+}
@@ -0,0 +1,108 @@
+/**
+ * @file
+ * @brief Definition of module publishing pixel data on a socket stream
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_STREAM_WRITER_MODULE_H
+#define ALLPIX_STREAM_WRITER_MODULE_H
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "core/config/Configuration.hpp"
+#include "core/geometry/GeometryManager.hpp"
+#include "core/messenger/Messenger.hpp"
+#include "core/module/Event.hpp"
+#include "core/module/Module.hpp"
+
+#include "objects/PixelHit.hpp"
+#include "objects/PixelPulse.hpp"
+
+#include "tools/async_writer.h"
+
+namespace allpix {
+    /**
+     * @ingroup Modules
+     * @brief Module publishing the pixel hits and pulses of every event on a Unix domain socket
+     *
+     * The events are encoded in the binary format defined in PixelStream.hpp by the worker threads and sent to all
+     * connected subscribers by a dedicated thread. Events exceeding the high-water mark of the send queue are dropped
+     * instead of blocking the simulation.
+     */
+    class StreamWriterModule : public SequentialModule {
+    public:
+        /**
+         * @brief Constructor for this unique module
+         * @param config Configuration object for this module as retrieved from the steering file
+         * @param messenger Pointer to the messenger object to allow binding to messages on the bus
+         * @param geo_manager Pointer to the geometry manager, containing the detectors
+         */
+        StreamWriterModule(Configuration& config, Messenger* messenger, GeometryManager* geo_manager);
+
+        /**
+         * @brief Stop the sending thread and close all sockets
+         */
+        ~StreamWriterModule() override;
+
+        /**
+         * @brief Open the socket, wait for the requested subscribers and start the sending thread
+         */
+        void initialize() override;
+
+        /**
+         * @brief Encode the pixel data of the event and queue it for sending
+         */
+        void run(Event* event) override;
+
+        /**
+         * @brief Send all queued events and close the socket
+         */
+        void finalize() override;
+
+    private:
+        /**
+         * @brief Accept all subscribers waiting for a connection and send them the setup message
+         * @return Number of accepted subscribers
+         */
+        size_t accept_subscribers();
+
+        /**
+         * @brief Send a message to all subscribers, dropping subscribers whose connection failed
+         * @param message Encoded message to send
+         * @param first Index of the first subscriber to send the message to
+         */
+        void publish(const std::string& message, size_t first = 0);
+
+        Messenger* messenger_;
+        GeometryManager* geo_mgr_;
+
+        bool include_pulses_{};
+
+        // Index of every detector in the setup message
+        std::map<std::string, uint32_t> detector_index_;
+        std::string setup_message_;
+
+        // Listening socket and connected subscribers
+        std::string socket_path_;
+        int listen_socket_{-1};
+        std::vector<int> subscribers_;
+
+        // Events waiting to be sent, bounded by the high-water mark
+        size_t high_water_mark_{};
+        AsyncWriter<std::string> sender_;
+
+        // Statistics
+        std::atomic<uint64_t> published_events_{};
+        std::atomic<uint64_t> dropped_events_{};
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_STREAM_WRITER_MODULE_H */
@@ -0,0 +1,355 @@
+/**
+ * @file
+ * @brief Implementation of TabulatedPropagation module
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "TabulatedPropagationModule.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <Eigen/Core>
+
+#include "core/messenger/Messenger.hpp"
+#include "core/utils/distributions.h"
+#include "core/utils/log.h"
+#include "objects/DepositedCharge.hpp"
+#include "objects/PropagatedCharge.hpp"
+#include "tools/runge_kutta.h"
+
+using namespace allpix;
+
+TabulatedPropagationModule::TabulatedPropagationModule(Configuration& config,
+                                                       Messenger* messenger,
+                                                       std::shared_ptr<Detector> detector)
+    : Module(config, detector), messenger_(messenger), detector_(std::move(detector)) {
+
+    // Save detector model
+    model_ = detector_->getModel();
+
+    // Require deposits message for single detector
+    messenger_->bindSingle<DepositedChargeMessage>(this, MsgFlags::REQUIRED);
+
+    // Set default value for config variables
+    config_.setDefault<double>("spatial_precision", Units::get(0.25, "nm"));
+    config_.setDefault<double>("timestep_start", Units::get(0.01, "ns"));
+    config_.setDefault<double>("timestep_min", Units::get(0.001, "ns"));
+    config_.setDefault<double>("timestep_max", Units::get(0.5, "ns"));
+    config_.setDefault<double>("integration_time", Units::get(25, "ns"));
+    config_.setDefault<unsigned int>("charge_per_step", 10);
+    config_.setDefault<unsigned int>("max_charge_groups", 1000);
+    config_.setDefault<double>("temperature", 293.15);
+    config_.setDefaultArray<unsigned int>("table_bins", {10, 10, 50});
+    config_.setDefault<std::string>("mobility_model", "jacoboni");
+    config_.setDefault<std::string>("recombination_model", "none");
+    config_.setDefault<bool>("propagate_electrons", true);
+    config_.setDefault<bool>("propagate_holes", false);
+    config_.setDefault<bool>("ignore_magnetic_field", false);
+    config_.setDefault<bool>("output_plots", false);
+
+    // Copy some variables from configuration to avoid lookups:
+    target_spatial_precision_ = config_.get<double>("spatial_precision");
+    timestep_start_ = config_.get<double>("timestep_start");
+    timestep_min_ = config_.get<double>("timestep_min");
+    timestep_max_ = config_.get<double>("timestep_max");
+    integration_time_ = config_.get<double>("integration_time");
+    charge_per_step_ = config_.get<unsigned int>("charge_per_step");
+    max_charge_groups_ = config_.get<unsigned int>("max_charge_groups");
+    propagate_electrons_ = config_.get<bool>("propagate_electrons");
+    propagate_holes_ = config_.get<bool>("propagate_holes");
+    output_plots_ = config_.get<bool>("output_plots");
+
+    auto table_bins = config_.getArray<unsigned int>("table_bins");
+    if(table_bins.size() != 3 || std::find(table_bins.begin(), table_bins.end(), 0) != table_bins.end()) {
+        throw InvalidValueError(config_, "table_bins", "three non-zero numbers of bins along x, y and z are required");
+    }
+    std::copy(table_bins.begin(), table_bins.end(), bins_.begin());
+
+    // Precalculate the Boltzmann constant times the temperature
+    boltzmann_kT_ = Units::get(8.6173333e-5, "eV/K") * config_.get<double>("temperature");
+
+    // The drift table is read-only during the event loop
+    allow_multithreading();
+}
+
+void TabulatedPropagationModule::initialize() {
+    if(!detector_->hasElectricField()) {
+        LOG(WARNING) << "This detector does not have an electric field.";
+    } else if(detector_->getElectricFieldType() == FieldType::CUSTOM) {
+        LOG(WARNING) << "The drift table assumes the custom electric field to repeat with the pixel pitch";
+    }
+
+    if(detector_->hasMagneticField() && !config_.get<bool>("ignore_magnetic_field")) {
+        throw ModuleError("This module should not be used with magnetic fields. Add the option 'ignore_magnetic_field' to "
+                          "the configuration if you would like to continue.");
+    } else if(detector_->hasMagneticField() && config_.get<bool>("ignore_magnetic_field")) {
+        LOG(WARNING) << "A magnetic field is switched on, but is set to be ignored for this module.";
+    }
+
+    // Prepare mobility model
+    mobility_ = Mobility(config_, model_->getSensorMaterial(), detector_->hasDopingProfile());
+
+    // Prepare recombination model
+    recombination_ = Recombination(config_, detector_->hasDopingProfile());
+
+    // Tabulate the drift within the central pixel of the matrix, where the neighbors of the pixel are present
+    auto [reference_x, reference_y] = model_->getPixelIndex(model_->getMatrixCenter());
+    reference_pixel_center_ = model_->getPixelCenter(reference_x, reference_y);
+
+    const auto entries = bins_[0] * bins_[1] * bins_[2];
+    auto build_table = [&](CarrierType type, std::vector<DriftEntry>& table) {
+        table.resize(entries);
+
+        // The entries are independent, distribute slices along x to all available threads
+        std::vector<std::thread> threads;
+        const auto workers = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, bins_[0]);
+        for(size_t worker = 0; worker < workers; ++worker) {
+            threads.emplace_back([&, type, worker]() {
+                for(size_t x = worker; x < bins_[0]; x += workers) {
+                    for(size_t y = 0; y < bins_[1]; ++y) {
+                        for(size_t z = 0; z < bins_[2]; ++z) {
+                            table[(x * bins_[1] + y) * bins_[2] + z] = integrate_drift(type, get_start_position(x, y, z));
+                        }
+                    }
+                }
+            });
+        }
+        for(auto& thread : threads) {
+            thread.join();
+        }
+    };
+    if(propagate_electrons_) {
+        build_table(CarrierType::ELECTRON, electron_table_);
+    }
+    if(propagate_holes_) {
+        build_table(CarrierType::HOLE, hole_table_);
+    }
+    LOG(INFO) << "Tabulated the drift from " << entries << " start positions per charge carrier type";
+
+    if(output_plots_) {
+        drift_time_histo_ = CreateHistogram<TH1D>("drift_time_histo",
+                                                  "Drift time;Drift time [ns];charge carriers",
+                                                  static_cast<int>(Units::convert(integration_time_, "ns") * 5),
+                                                  0,
+                                                  static_cast<double>(Units::convert(integration_time_, "ns")));
+        auto pitch = static_cast<double>(Units::convert(model_->getPixelSize().x(), "um"));
+        diffusion_width_histo_ = CreateHistogram<TH1D>("diffusion_width_histo",
+                                                       "Lateral diffusion width;Diffusion width [um];charge carriers",
+                                                       200,
+                                                       0,
+                                                       pitch);
+        group_size_histo_ = CreateHistogram<TH1D>("group_size_histo",
+                                                  "Charge carrier group size;group size;number of groups transported",
+                                                  static_cast<int>(100 * charge_per_step_),
+                                                  0,
+                                                  static_cast<int>(100 * charge_per_step_));
+    }
+}
+
+ROOT::Math::XYZPoint TabulatedPropagationModule::get_start_position(size_t x, size_t y, size_t z) const {
+    auto cell_center = [this](size_t index, size_t axis) {
+        return (static_cast<double>(index) + 0.5) / static_cast<double>(bins_[axis]) - 0.5;
+    };
+    return {reference_pixel_center_.x() + cell_center(x, 0) * model_->getPixelSize().x(),
+            reference_pixel_center_.y() + cell_center(y, 1) * model_->getPixelSize().y(),
+            model_->getSensorCenter().z() + cell_center(z, 2) * model_->getSensorSize().z()};
+}
+
+TabulatedPropagationModule::DriftEntry TabulatedPropagationModule::integrate_drift(CarrierType type,
+                                                                                   const ROOT::Math::XYZPoint& start) const {
+    auto carrier_velocity = [&](double, const Eigen::Vector3d& cur_pos) -> Eigen::Vector3d {
+        auto raw_field = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+        Eigen::Vector3d efield(raw_field.x(), raw_field.y(), raw_field.z());
+
+        auto doping = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+        return static_cast<int>(type) * mobility_(type, efield.norm(), doping) * efield;
+    };
+
+    Eigen::Vector3d position(start.x(), start.y(), start.z());
+    auto runge_kutta = make_static_runge_kutta<tableau::StaticRK5>(carrier_velocity, timestep_start_, position);
+
+    DriftEntry entry;
+    Eigen::Vector3d last_position = position;
+    while(runge_kutta.getTime() < integration_time_) {
+        last_position = position;
+
+        // Accumulate the diffusion of the step with the mobility at the pre-step position
+        auto local_position = static_cast<ROOT::Math::XYZPoint>(position);
+        auto efield_mag = std::sqrt(detector_->getElectricField(local_position).Mag2());
+        auto doping = detector_->getDopingConcentration(local_position);
+        auto timestep = runge_kutta.getTimeStep();
+        entry.variance += 2. * boltzmann_kT_ * mobility_(type, efield_mag, doping) * timestep;
+
+        auto step = runge_kutta.step();
+        position = runge_kutta.getValue();
+
+        local_position = static_cast<ROOT::Math::XYZPoint>(position);
+        if(!model_->isWithinSensor(local_position) || model_->findImplant(local_position)) {
+            entry.halted = true;
+            break;
+        }
+
+        // Adapt step size to match target precision
+        double uncertainty = step.error.norm();
+        if(uncertainty > target_spatial_precision_) {
+            timestep *= 0.75;
+        } else if(2 * uncertainty < target_spatial_precision_) {
+            timestep *= 1.5;
+        }
+        runge_kutta.setTimeStep(std::clamp(timestep, timestep_min_, timestep_max_));
+    }
+
+    // Find proper final position in the sensor
+    auto end = static_cast<ROOT::Math::XYZPoint>(position);
+    if(entry.halted && !model_->isWithinSensor(end)) {
+        end = model_->getSensorIntercept(static_cast<ROOT::Math::XYZPoint>(last_position), end);
+    }
+    entry.displacement = ROOT::Math::XYVector(end.x() - start.x(), end.y() - start.y());
+    entry.end_z = end.z();
+    entry.time = runge_kutta.getTime();
+    return entry;
+}
+
+const TabulatedPropagationModule::DriftEntry& TabulatedPropagationModule::lookup(CarrierType type,
+                                                                               const ROOT::Math::XYZPoint& position) const {
+    auto cell = [this](double offset, double size, size_t axis) {
+        auto index = static_cast<long>(std::floor((offset / size + 0.5) * static_cast<double>(bins_[axis])));
+        return static_cast<size_t>(std::clamp<long>(index, 0, static_cast<long>(bins_[axis]) - 1));
+    };
+
+    // The table spans one pixel cell, positions are looked up relative to the center of their pixel
+    auto [pixel_x, pixel_y] = model_->getPixelIndex(position);
+    auto pixel_center = model_->getPixelCenter(pixel_x, pixel_y);
+    auto x = cell(position.x() - pixel_center.x(), model_->getPixelSize().x(), 0);
+    auto y = cell(position.y() - pixel_center.y(), model_->getPixelSize().y(), 1);
+    auto z = cell(position.z() - model_->getSensorCenter().z(), model_->getSensorSize().z(), 2);
+
+    const auto& table = (type == CarrierType::ELECTRON ? electron_table_ : hole_table_);
+    return table[(x * bins_[1] + y) * bins_[2] + z];
+}
+
+void TabulatedPropagationModule::run(Event* event) {
+    auto deposits_message = messenger_->fetchMessage<DepositedChargeMessage>(this, event);
+
+    // Create vector of propagated charges to output
+    std::vector<PropagatedCharge> propagated_charges;
+
+    unsigned int total_charge = 0;
+    unsigned int propagated_charge = 0;
+    unsigned int recombined_charge = 0;
+
+    allpix::uniform_real_distribution<double> survival(0, 1);
+    for(const auto& [deposit_ptr, type] : expandCarriers(deposits_message->getData())) {
+        const auto& deposit = *deposit_ptr;
+        if((type == CarrierType::ELECTRON && !propagate_electrons_) || (type == CarrierType::HOLE && !propagate_holes_)) {
+            continue;
+        }
+
+        total_deposits_++;
+        total_charge += deposit.getCharge();
+
+        // All charge carrier groups of a deposit share the same table entry
+        const auto& position = deposit.getLocalPosition();
+        const auto& entry = lookup(type, position);
+        auto local_time = deposit.getLocalTime() + entry.time;
+        if(!entry.halted || local_time > integration_time_) {
+            LOG(DEBUG) << "Charge carriers (" << type << ") on " << Units::display(position, {"mm", "um"})
+                       << " do not reach the end of their drift within the integration time";
+            continue;
+        }
+
+        auto charge_per_step = charge_per_step_;
+        if(max_charge_groups_ > 0 && deposit.getCharge() / charge_per_step > max_charge_groups_) {
+            charge_per_step = static_cast<unsigned int>(ceil(static_cast<double>(deposit.getCharge()) / max_charge_groups_));
+            deposits_exceeding_max_groups_++;
+            LOG(INFO) << "Deposited charge: " << deposit.getCharge()
+                      << ", which exceeds the maximum number of charge groups allowed. Increasing charge_per_step to "
+                      << charge_per_step << " for this deposit.";
+        }
+
+        auto diffusion_std_dev = std::sqrt(entry.variance);
+        allpix::normal_distribution<double> gauss_distribution(0, diffusion_std_dev);
+        auto drift_end = ROOT::Math::XYZPoint(
+            position.x() + entry.displacement.x(), position.y() + entry.displacement.y(), entry.end_z);
+        auto doping = detector_->getDopingConcentration(position);
+
+        unsigned int charges_remaining = deposit.getCharge();
+        while(charges_remaining > 0) {
+            if(charge_per_step > charges_remaining) {
+                charge_per_step = charges_remaining;
+            }
+            charges_remaining -= charge_per_step;
+
+            // Check if charge carrier is still alive via its survival probability, evaluated once
+            if(recombination_(type, doping, survival(event->getRandomEngine()), entry.time)) {
+                LOG(DEBUG) << "Recombined " << charge_per_step << " charge carriers (" << type << ") at "
+                           << Units::display(position, {"mm", "um"});
+                recombined_charge += charge_per_step;
+                continue;
+            }
+
+            double diffusion_x = gauss_distribution(event->getRandomEngine());
+            double diffusion_y = gauss_distribution(event->getRandomEngine());
+            auto local_position =
+                ROOT::Math::XYZPoint(drift_end.x() + diffusion_x, drift_end.y() + diffusion_y, drift_end.z());
+
+            // Only add if within sensor volume:
+            if(!model_->isWithinSensor(local_position)) {
+                LOG(DEBUG) << "Charge carriers outside sensor volume at " << Units::display(local_position, {"mm", "um"});
+                continue;
+            }
+
+            if(output_plots_) {
+                drift_time_histo_->Fill(static_cast<double>(Units::convert(entry.time, "ns")), charge_per_step);
+                diffusion_width_histo_->Fill(static_cast<double>(Units::convert(diffusion_std_dev, "um")), charge_per_step);
+                group_size_histo_->Fill(charge_per_step);
+            }
+
+            propagated_charges.emplace_back(local_position,
+                                            detector_->getGlobalPosition(local_position),
+                                            type,
+                                            charge_per_step,
+                                            local_time,
+                                            deposit.getGlobalTime() + entry.time,
+                                            CarrierState::HALTED,
+                                            &deposit);
+
+            LOG(DEBUG) << "Propagated " << charge_per_step << " " << type << " to "
+                       << Units::display(local_position, {"mm", "um"}) << " in " << Units::display(entry.time, "ns");
+            propagated_charge += charge_per_step;
+        }
+    }
+
+    LOG(INFO) << "Total charge: " << total_charge << " (propagated: " << propagated_charge
+              << ", recombined: " << recombined_charge << ")";
+    LOG(DEBUG) << "Total count of propagated charge carriers: " << propagated_charges.size();
+
+    // Create a new message with propagated charges
+    auto propagated_charge_message = std::make_shared<PropagatedChargeMessage>(std::move(propagated_charges), detector_);
+
+    // Dispatch the message with propagated charges
+    messenger_->dispatchMessage(this, std::move(propagated_charge_message), event);
+}
+
+void TabulatedPropagationModule::finalize() {
+    if(output_plots_) {
+        group_size_histo_->Get()->GetXaxis()->SetRange(1, group_size_histo_->Get()->GetNbinsX() + 1);
+
+        // Write output plots
+        drift_time_histo_->Write();
+        diffusion_width_histo_->Write();
+        group_size_histo_->Write();
+    }
+    LOG(INFO) << deposits_exceeding_max_groups_ * 100.0 / std::max(1u, total_deposits_.load())
+              << "% of deposits have charge exceeding the " << max_charge_groups_
+              << " charge groups allowed, with a charge_per_step value of " << charge_per_step_ << ".";
+}
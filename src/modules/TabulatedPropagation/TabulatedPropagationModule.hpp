@@ -0,0 +1,138 @@
+/**
+ * @file
+ * @brief Definition of TabulatedPropagation module
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <Math/Point3D.h>
+#include <Math/Vector2D.h>
+#include <TH1D.h>
+
+#include "core/config/Configuration.hpp"
+#include "core/geometry/DetectorModel.hpp"
+#include "core/messenger/Messenger.hpp"
+#include "core/module/Event.hpp"
+#include "core/module/Module.hpp"
+
+#include "objects/DepositedCharge.hpp"
+#include "objects/PropagatedCharge.hpp"
+
+#include "physics/Mobility.hpp"
+#include "physics/Recombination.hpp"
+
+#include "tools/ROOT.h"
+
+namespace allpix {
+    /**
+     * @ingroup Modules
+     * @brief Module to propagate charge carriers to their end point via a precomputed table of drift paths
+     *
+     * For static electric fields and doping profiles, the drift of a charge carrier only depends on its start position.
+     * The drift of charge carriers starting in a grid of positions within one pixel cell is therefore integrated once
+     * during initialization, storing the drift displacement, the drift time and the diffusion width integrated along the
+     * path for every start position. During the event loop, the sets of charge carriers are moved by the displacement of
+     * the table entry of their start position and diffusion is added by drawing from a Gaussian of the tabulated width.
+     */
+    class TabulatedPropagationModule : public Module {
+    public:
+        /**
+         * @brief Constructor for this detector-specific module
+         * @param config Configuration object for this module as retrieved from the steering file
+         * @param messenger Pointer to the messenger object to allow binding to messages on the bus
+         * @param detector Pointer to the detector for this module instance
+         */
+        TabulatedPropagationModule(Configuration& config, Messenger* messenger, std::shared_ptr<Detector> detector);
+
+        /**
+         * @brief Initialize the models and integrate the drift table
+         */
+        void initialize() override;
+
+        /**
+         * @brief Propagate all deposited charges via the drift table
+         */
+        void run(Event*) override;
+
+        /**
+         * @brief Write plots if needed
+         */
+        void finalize() override;
+
+    private:
+        /**
+         * @brief Drift of a charge carrier from one start position of the table
+         */
+        struct DriftEntry {
+            ROOT::Math::XYVector displacement; ///< Lateral displacement from the start to the end point of the drift
+            double end_z{};                    ///< Local z coordinate of the end point of the drift
+            double time{};                     ///< Drift time to the end point
+            double variance{};                 ///< Variance of the lateral diffusion integrated along the drift path
+            bool halted{};                     ///< Whether the end point was reached within the integration time
+        };
+
+        /**
+         * @brief Integrate the drift of a charge carrier without diffusion
+         * @param type Type of the charge carrier
+         * @param start Start position of the charge carrier in local coordinates
+         * @return Drift of the charge carrier
+         */
+        DriftEntry integrate_drift(CarrierType type, const ROOT::Math::XYZPoint& start) const;
+
+        /**
+         * @brief Get the start position of a table entry
+         * @param x Index of the table entry along x
+         * @param y Index of the table entry along y
+         * @param z Index of the table entry along z
+         * @return Position at the center of the grid cell in the reference pixel, in local coordinates
+         */
+        ROOT::Math::XYZPoint get_start_position(size_t x, size_t y, size_t z) const;
+
+        /**
+         * @brief Look up the table entry of a start position
+         * @param type Type of the charge carrier
+         * @param position Start position in local coordinates
+         * @return Table entry of the grid cell containing the position relative to its pixel center
+         */
+        const DriftEntry& lookup(CarrierType type, const ROOT::Math::XYZPoint& position) const;
+
+        Messenger* messenger_;
+        std::shared_ptr<const Detector> detector_;
+        std::shared_ptr<DetectorModel> model_;
+
+        // Config parameters
+        bool output_plots_{};
+        bool propagate_electrons_{}, propagate_holes_{};
+        double integration_time_{}, target_spatial_precision_{}, timestep_min_{}, timestep_max_{}, timestep_start_{};
+        unsigned int charge_per_step_{};
+        unsigned int max_charge_groups_{};
+
+        // Drift tables for electrons and holes, indexed by the start position relative to the pixel center
+        std::array<size_t, 3> bins_{};
+        ROOT::Math::XYZPoint reference_pixel_center_;
+        std::vector<DriftEntry> electron_table_;
+        std::vector<DriftEntry> hole_table_;
+
+        // Models for electron and hole mobility and lifetime
+        Mobility mobility_;
+        Recombination recombination_;
+
+        // Precalculated value for Boltzmann constant:
+        double boltzmann_kT_;
+
+        // Statistical information
+        std::atomic<unsigned int> total_deposits_{}, deposits_exceeding_max_groups_{};
+        Histogram<TH1D> drift_time_histo_;
+        Histogram<TH1D> diffusion_width_histo_;
+        Histogram<TH1D> group_size_histo_;
+    };
+} // namespace allpix
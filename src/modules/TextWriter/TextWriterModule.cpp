@@ -11,6 +11,9 @@
 
 #include "TextWriterModule.hpp"
 
+#include <array>
+#include <charconv>
+#include <deque>
 #include <fstream>
 #include <string>
 #include <utility>
@@ -32,16 +35,72 @@ TextWriterModule::TextWriterModule(Configuration& config, Messenger* messenger,
     // Enable multithreading of this module if multithreading is enabled
     allow_multithreading();
 
+    // Store the data of rejected events produced before the rejection
+    process_rejected_events();
+
     // Bind to all messages with filter
     messenger_->registerFilter(this, &TextWriterModule::filter);
+
+    config_.setDefault<Compression>("compression", Compression::NONE);
+    config_.setDefault<int>("compression_level", 6);
+    config_.setDefault<bool>("write_asynchronously", false);
+    config_.setDefault<unsigned int>("write_queue_size", 16);
+
+    compression_ = config_.get<Compression>("compression");
+    write_asynchronously_ = config_.get<bool>("write_asynchronously");
+    write_queue_size_ = config_.get<unsigned int>("write_queue_size");
+    if(write_queue_size_ == 0) {
+        throw InvalidValueError(config_, "write_queue_size", "queue needs to hold at least one event");
+    }
+}
+
+TextWriterModule::~TextWriterModule() {
+    // The writer thread writes to the file closed below
+    writer_.stop();
+
+#if ALLPIX_TEXTWRITER_ZLIB
+    if(compressed_file_ != nullptr) {
+        gzclose(compressed_file_);
+    }
+#endif
+}
+
+TextWriterModule::StringBuffer::int_type TextWriterModule::StringBuffer::overflow(int_type ch) {
+    if(!traits_type::eq_int_type(ch, traits_type::eof())) {
+        target_->push_back(traits_type::to_char_type(ch));
+    }
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize TextWriterModule::StringBuffer::xsputn(const char* s, std::streamsize count) {
+    target_->append(s, static_cast<size_t>(count));
+    return count;
 }
 
 void TextWriterModule::initialize() {
     // Create output file
-    output_file_name_ = createOutputFile(config_.get<std::string>("file_name", "data"), "txt", true);
-    output_file_ = std::make_unique<std::ofstream>(output_file_name_);
+    if(compression_ == Compression::GZIP) {
+#if ALLPIX_TEXTWRITER_ZLIB
+        auto level = config_.get<int>("compression_level");
+        if(level < 1 || level > 9) {
+            throw InvalidValueError(config_, "compression_level", "compression level needs to be between 1 and 9");
+        }
+        output_file_name_ = createOutputFile(config_.get<std::string>("file_name", "data"), "txt.gz", true);
+        compressed_file_ = gzopen(output_file_name_.c_str(), ("wb" + std::to_string(level)).c_str());
+        if(compressed_file_ == nullptr) {
+            throw ModuleError("Cannot open compressed output file " + output_file_name_);
+        }
+        // Compress the per-event buffers in large blocks
+        gzbuffer(compressed_file_, 1 << 20);
+#else
+        throw InvalidValueError(config_, "compression", "gzip compression is not available, zlib has not been found");
+#endif
+    } else {
+        output_file_name_ = createOutputFile(config_.get<std::string>("file_name", "data"), "txt", true);
+        output_file_ = std::make_unique<std::ofstream>(output_file_name_);
+    }
 
-    *output_file_ << "# Allpix Squared ASCII data - https://cern.ch/allpix-squared" << std::endl << std::endl;
+    write_buffer("# Allpix Squared ASCII data - https://cern.ch/allpix-squared\n\n");
 
     // Read include and exclude list
     if(config_.has("include") && config_.has("exclude")) {
@@ -53,77 +112,116 @@ void TextWriterModule::initialize() {
         auto exc_arr = config_.getArray<std::string>("exclude");
         exclude_.insert(exc_arr.begin(), exc_arr.end());
     }
+
+    if(write_asynchronously_) {
+        LOG(INFO) << "Writing objects asynchronously, buffering up to " << write_queue_size_ << " events";
+        writer_.start(
+            write_queue_size_,
+            [this](std::deque<std::string>& batch) {
+                for(const auto& buffer : batch) {
+                    write_buffer(buffer);
+                }
+            },
+            true);
+    }
 }
 
 bool TextWriterModule::filter(const std::shared_ptr<BaseMessage>& message, const std::string& message_name) const { // NOLINT
-    try {
-        const BaseMessage* inst = message.get();
-        std::string name_str = " without a name";
-        if(!message_name.empty()) {
-            name_str = " named " + message_name;
-        }
-        LOG(TRACE) << "Text writer received " << allpix::demangle(typeid(*inst).name()) << name_str;
-
-        // Get the detector name
-        std::string detector_name;
-        if(message->getDetector() != nullptr) {
-            detector_name = message->getDetector()->getName();
-        }
-
-        // Read the object
-        auto object_array = message->getObjectArray();
-        if(!object_array.empty()) {
-            const Object& first_object = object_array[0];
-            std::string class_name = allpix::demangle(typeid(first_object).name());
-
-            // Check if this message should be kept
-            if((!include_.empty() && include_.find(class_name) == include_.end()) ||
-               (!exclude_.empty() && exclude_.find(class_name) != exclude_.end())) {
-                LOG(TRACE) << "Text writer ignored message with object " << allpix::demangle(typeid(*inst).name())
-                           << " because it has been excluded or not explicitly included";
-                return false;
-            }
-
-            return true;
-        }
+    // Look up the decision for this message type, only evaluated when the type is received for the first time
+    const auto* entry = filter_cache_.get(*message, [this](const std::string& class_name) {
+        return (include_.empty() || include_.find(class_name) != include_.end()) &&
+               (exclude_.empty() || exclude_.find(class_name) == exclude_.end());
+    });
+    if(entry == nullptr) {
+        return false;
+    }
 
-    } catch(MessageWithoutObjectException& e) {
-        const BaseMessage* inst = message.get();
-        LOG(WARNING) << "Text writer cannot process message of type" << allpix::demangle(typeid(*inst).name())
-                     << " with name " << message_name;
+    if(!entry->objects) {
+        LOG_ONCE(WARNING) << "Text writer cannot process message of type " << allpix::demangle(typeid(*message).name())
+                          << " with name " << message_name;
+        return false;
+    }
+    if(!entry->keep) {
+        LOG(TRACE) << "Text writer ignored message with object " << entry->class_name
+                   << " because it has been excluded or not explicitly included";
+        return false;
     }
 
-    return false;
+    return message->getObjectCount() != 0;
 }
 
 void TextWriterModule::run(Event* event) {
     auto messages = messenger_->fetchFilteredMessages(this, event);
     LOG(TRACE) << "Writing new objects to text file";
 
+    // Format the event into a buffer of an event already written if available, reusing its memory
+    auto buffer = writer_.acquire();
+    buffer.clear();
+    format_buffer_.setTarget(&buffer);
+
     // Print the current event:
-    *output_file_ << "=== " << event->number << " ===" << std::endl;
+    std::array<char, 24> number{};
+    auto number_end = std::to_chars(number.data(), number.data() + number.size(), event->number).ptr;
+    buffer.append("=== ").append(number.data(), number_end).append(" ===\n");
+    if(event->getWeight() != 1.) {
+        format_stream_ << "Weight: " << event->getWeight() << '\n';
+    }
 
     for(auto& pair : messages) {
         auto& message = pair.first;
 
         // Print the current detector:
         if(message->getDetector() != nullptr) {
-            *output_file_ << "--- " << message->getDetector()->getName() << " ---" << std::endl;
+            buffer.append("--- ").append(message->getDetector()->getName()).append(" ---\n");
         } else {
-            *output_file_ << "--- <global> ---" << std::endl;
+            buffer.append("--- <global> ---\n");
         }
         for(auto& object : message->getObjectArray()) {
             // Print the object's ASCII representation:
-            *output_file_ << object << std::endl;
+            format_stream_ << object << '\n';
             write_cnt_++;
         }
         msg_cnt_++;
     }
+    format_buffer_.setTarget(nullptr);
+
+    if(write_asynchronously_) {
+        writer_.push(std::move(buffer));
+    } else {
+        write_buffer(buffer);
+        writer_.release(std::move(buffer));
+    }
+}
+
+void TextWriterModule::write_buffer(const std::string& buffer) {
+#if ALLPIX_TEXTWRITER_ZLIB
+    if(compressed_file_ != nullptr) {
+        if(!buffer.empty() && gzwrite(compressed_file_, buffer.data(), static_cast<unsigned int>(buffer.size())) == 0) {
+            throw ModuleError("Writing to compressed output file " + output_file_name_ + " failed");
+        }
+        return;
+    }
+#endif
+    output_file_->write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
 }
 
 void TextWriterModule::finalize() {
+    writer_.finish();
+
     // Finish writing to output file
-    *output_file_ << "# " << write_cnt_ << " objects from " << msg_cnt_ << " messages" << std::endl;
+    write_buffer("# " + std::to_string(write_cnt_) + " objects from " + std::to_string(msg_cnt_) + " messages\n");
+#if ALLPIX_TEXTWRITER_ZLIB
+    if(compressed_file_ != nullptr) {
+        auto result = gzclose(compressed_file_);
+        compressed_file_ = nullptr;
+        if(result != Z_OK) {
+            throw ModuleError("Closing compressed output file " + output_file_name_ + " failed");
+        }
+    }
+#endif
+    if(output_file_ != nullptr) {
+        output_file_->flush();
+    }
 
     // Print statistics
     LOG(STATUS) << "Wrote " << write_cnt_ << " objects from " << msg_cnt_ << " messages to file:" << std::endl
@@ -12,14 +12,23 @@
 #include <atomic>
 #include <fstream>
 #include <map>
+#include <ostream>
+#include <streambuf>
 #include <string>
 
+#if ALLPIX_TEXTWRITER_ZLIB
+#include <zlib.h>
+#endif
+
 #include "core/config/Configuration.hpp"
 #include "core/geometry/GeometryManager.hpp"
 #include "core/messenger/Messenger.hpp"
 #include "core/module/Event.hpp"
 #include "core/module/Module.hpp"
 
+#include "tools/async_writer.h"
+#include "tools/message_filter.h"
+
 namespace allpix {
     /**
      * @ingroup Modules
@@ -28,6 +37,14 @@ namespace allpix {
      * Listens to all objects dispatched in the framework and stores an ASCII representation of every object to file.
      */
     class TextWriterModule : public SequentialModule {
+        /**
+         * @brief Compression of the output file
+         */
+        enum class Compression {
+            NONE, ///< Plain text file
+            GZIP, ///< Text file compressed with gzip
+        };
+
     public:
         /**
          * @brief Constructor for this unique module
@@ -37,6 +54,11 @@ namespace allpix {
          */
         TextWriterModule(Configuration& config, Messenger* messenger, GeometryManager* geo_mgr);
 
+        /**
+         * @brief Close the compressed output file
+         */
+        ~TextWriterModule() override;
+
         /**
          * @brief Receive a single message containing objects of arbitrary type
          * @param message Message dispatched in the framework
@@ -61,15 +83,51 @@ namespace allpix {
         void finalize() override;
 
     private:
+        /**
+         * @brief Stream buffer appending to a string, which keeps its capacity when it is cleared for the next event
+         */
+        class StringBuffer : public std::streambuf {
+        public:
+            void setTarget(std::string* target) { target_ = target; }
+
+        protected:
+            int_type overflow(int_type ch) override;
+            std::streamsize xsputn(const char* s, std::streamsize count) override;
+
+        private:
+            std::string* target_{};
+        };
+
+        /**
+         * @brief Write a formatted buffer to the output file, compressing it if requested
+         * @param buffer Text to write
+         */
+        void write_buffer(const std::string& buffer);
+
         Messenger* messenger_;
 
         // Object names to include or exclude from writing
         std::set<std::string> include_;
         std::set<std::string> exclude_;
+        // Decisions of the filter per message type
+        mutable MessageFilterCache filter_cache_;
 
         // Output data file to write
+        Compression compression_{};
         std::string output_file_name_{};
         std::unique_ptr<std::ofstream> output_file_;
+#if ALLPIX_TEXTWRITER_ZLIB
+        gzFile compressed_file_{};
+#endif
+
+        // Stream formatting the objects of an event into the buffer of the event
+        StringBuffer format_buffer_;
+        std::ostream format_stream_{&format_buffer_};
+
+        bool write_asynchronously_{};
+        size_t write_queue_size_{};
+        // Buffers already written are kept by the writer to reuse their memory
+        AsyncWriter<std::string> writer_;
 
         // Statistical information about number of objects
         std::atomic<unsigned long> write_cnt_{};
@@ -0,0 +1,383 @@
+/**
+ * @file
+ * @brief Implementation of the transient propagation of charge carrier groups on an offload device
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "DeviceTransientPropagation.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <utility>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "tools/device_tables.h"
+#include "tools/runge_kutta.h"
+
+using namespace allpix;
+
+namespace {
+    using Tableau = tableau::StaticRK4;
+    constexpr size_t stages = Tableau::stages;
+    constexpr size_t tableau_size = (stages + 2) * stages;
+
+#ifdef _OPENMP
+#pragma omp declare target
+#endif
+    /**
+     * @brief Look up the drift velocity and the diffusion constant of a carrier type at a position
+     *
+     * The position is folded into the unit cell of the pixel the tables have been computed for, the values of the bin
+     * containing it are returned.
+     */
+    inline double lookup(const DeviceTransientPropagation::Parameters& parameters,
+                         const float* tables,
+                         unsigned int carrier,
+                         const double* position,
+                         double* velocity) {
+        const auto& bins = parameters.velocity_bins;
+        std::array<size_t, 3> bin{};
+        for(size_t axis = 0; axis < 2; ++axis) {
+            bin[axis] = device::to_cell_bin(
+                position[axis], parameters.pixel_center[axis], parameters.pixel_pitch[axis], bins[axis]);
+        }
+        auto bottom = parameters.sensor_center[2] - parameters.sensor_size[2] / 2;
+        bin[2] = device::to_bin((position[2] - bottom) / parameters.sensor_size[2], bins[2]);
+
+        auto index = ((carrier * bins[0] + bin[0]) * bins[1] + bin[1]) * bins[2] + bin[2];
+        const float* values = tables + index * DeviceTransientPropagation::values_per_bin;
+        velocity[0] = values[0];
+        velocity[1] = values[1];
+        velocity[2] = values[2];
+        return values[3];
+    }
+
+    /**
+     * @brief Interpolate the weighting potential of a pixel at a position
+     */
+    inline double weighting_potential(const DeviceTransientPropagation::Parameters& parameters,
+                                      const float* potentials,
+                                      int pixel_x,
+                                      int pixel_y,
+                                      const double* position) {
+        const auto& range = parameters.potential_range;
+        auto bottom = parameters.sensor_center[2] - parameters.sensor_size[2] / 2;
+        std::array<double, 3> fraction = {
+            (position[0] - parameters.pixel_pitch[0] * pixel_x + range[0]) / (2 * range[0]),
+            (position[1] - parameters.pixel_pitch[1] * pixel_y + range[1]) / (2 * range[1]),
+            (position[2] - bottom) / parameters.sensor_size[2]};
+        return device::interpolate(potentials, parameters.potential_nodes, fraction);
+    }
+
+    /**
+     * @brief Propagate a single group and add its induced charge to the buffer of the event
+     * @param parameters Parameters of the propagation
+     * @param tables Tables of drift velocities and diffusion constants
+     * @param potentials Table of the weighting potential
+     * @param tableau Coefficients of the Runge-Kutta tableau
+     * @param window Pixels and time bins the buffer spans
+     * @param buffer Induced charge per pixel of the window and time bin
+     * @param group Group to propagate
+     * @param seed Seed of the random number streams
+     * @param stream Random number stream of this group
+     */
+    void propagate_group(const DeviceTransientPropagation::Parameters& parameters,
+                         const float* tables,
+                         const float* potentials,
+                         const double* tableau,
+                         const DeviceTransientPropagation::Window& window,
+                         double* buffer,
+                         DeviceTransientPropagation::Group& group,
+                         uint64_t seed,
+                         uint64_t stream) {
+        auto coefficient = [tableau](size_t row, size_t column) { return tableau[row * stages + column]; };
+        auto pixel_index = [&parameters](const double* position, size_t axis) {
+            return static_cast<int>(std::lround(position[axis] / parameters.pixel_pitch[axis]));
+        };
+
+        double position[3] = {group.position[0], group.position[1], group.position[2]};
+        double last_position[3] = {position[0], position[1], position[2]};
+        double k[stages][3];
+        double timestep = parameters.timestep;
+        double time = 0;
+        uint64_t steps = 0;
+        auto last_max_potential = std::numeric_limits<double>::max();
+        int pixel[2] = {pixel_index(position, 0), pixel_index(position, 1)};
+        group.pixel_min = {pixel[0], pixel[1]};
+        group.pixel_max = {pixel[0], pixel[1]};
+
+        while(group.start_time + time < parameters.integration_time) {
+            int last_pixel[2] = {pixel[0], pixel[1]};
+            for(int axis = 0; axis < 3; ++axis) {
+                last_position[axis] = position[axis];
+            }
+
+            // Runge-Kutta stages, the first stage provides the diffusion constant at the pre-step position
+            double diffusion_constant = 0;
+            for(size_t i = 0; i < stages; ++i) {
+                double stage_position[3] = {position[0], position[1], position[2]};
+                for(size_t j = 0; j < i; ++j) {
+                    for(int axis = 0; axis < 3; ++axis) {
+                        stage_position[axis] += timestep * coefficient(i, j) * k[j][axis];
+                    }
+                }
+                auto diffusion = lookup(parameters, tables, group.carrier, stage_position, k[i]);
+                if(i == 0) {
+                    diffusion_constant = diffusion;
+                }
+            }
+            for(size_t i = 0; i < stages; ++i) {
+                for(int axis = 0; axis < 3; ++axis) {
+                    position[axis] += timestep * coefficient(stages, i) * k[i][axis];
+                }
+            }
+            time += timestep;
+            ++steps;
+
+            // Apply diffusion with normal random numbers drawn from the stream of this group
+            auto diffusion_std_dev = std::sqrt(2. * diffusion_constant * timestep);
+            auto normal = device::normal_numbers(seed, stream, steps);
+            for(size_t axis = 0; axis < 3; ++axis) {
+                position[axis] += diffusion_std_dev * normal[axis];
+            }
+
+            // Stop the group at the intercept of its last step with the sensor surface
+            double fraction = 1;
+            for(size_t axis = 0; axis < 3; ++axis) {
+                auto half_size = parameters.sensor_size[axis] / 2;
+                auto offset = position[axis] - parameters.sensor_center[axis];
+                auto last_offset = last_position[axis] - parameters.sensor_center[axis];
+                if(std::fabs(offset) > half_size) {
+                    auto boundary = (offset > 0 ? half_size : -half_size);
+                    fraction = std::min(fraction, (boundary - last_offset) / (offset - last_offset));
+                }
+            }
+            bool halted = (fraction < 1);
+            if(halted) {
+                for(size_t axis = 0; axis < 3; ++axis) {
+                    position[axis] = last_position[axis] + fraction * (position[axis] - last_position[axis]);
+                }
+            }
+
+            // Induction matrix around the pixels before and after the step
+            pixel[0] = pixel_index(position, 0);
+            pixel[1] = pixel_index(position, 1);
+            for(size_t axis = 0; axis < 2; ++axis) {
+                group.pixel_min[axis] = std::min(group.pixel_min[axis], pixel[axis]);
+                group.pixel_max[axis] = std::max(group.pixel_max[axis], pixel[axis]);
+            }
+            int matrix_min[2], matrix_max[2];
+            for(size_t axis = 0; axis < 2; ++axis) {
+                matrix_min[axis] = std::max(std::min(pixel[axis], last_pixel[axis]) - parameters.distance, 0);
+                matrix_max[axis] = std::min(std::max(pixel[axis], last_pixel[axis]) + parameters.distance,
+                                            parameters.matrix_size[axis] - 1);
+            }
+
+            // Induced charge on electrode is q_int = q * (phi(x1) - phi(x0)), added at the time after the step
+            auto time_bin = static_cast<size_t>(std::lround((group.start_time + time) / parameters.timestep));
+            double max_potential = 0, max_potential_difference = 0;
+            for(int x = matrix_min[0]; x <= matrix_max[0]; ++x) {
+                for(int y = matrix_min[1]; y <= matrix_max[1]; ++y) {
+                    auto in_matrix = [&](const int* center) {
+                        return std::abs(x - center[0]) <= parameters.distance &&
+                               std::abs(y - center[1]) <= parameters.distance;
+                    };
+                    if(!in_matrix(pixel) && !in_matrix(last_pixel)) {
+                        continue;
+                    }
+
+                    auto ramo = weighting_potential(parameters, potentials, x, y, position);
+                    auto last_ramo = weighting_potential(parameters, potentials, x, y, last_position);
+                    max_potential = std::max(max_potential, std::fabs(ramo));
+                    max_potential_difference = std::max(max_potential_difference, std::fabs(ramo - last_ramo));
+
+                    auto window_x = x - window.origin[0];
+                    auto window_y = y - window.origin[1];
+                    if(window_x < 0 || window_x >= window.size[0] || window_y < 0 || window_y >= window.size[1] ||
+                       time_bin >= window.time_bins) {
+                        group.left_window = true;
+                        continue;
+                    }
+                    auto index = (static_cast<size_t>(window_x) * static_cast<size_t>(window.size[1]) +
+                                  static_cast<size_t>(window_y)) *
+                                     window.time_bins +
+                                 time_bin;
+                    auto induced = group.charge * (ramo - last_ramo) * group.sign;
+#ifdef _OPENMP
+#pragma omp atomic update
+#endif
+                    buffer[index] += induced;
+                }
+            }
+
+            if(halted) {
+                group.halted = true;
+                break;
+            }
+
+            // Stop groups moving away from all electrodes once the charge they can still induce is negligible
+            if(parameters.termination_charge > 0 && max_potential <= last_max_potential &&
+               group.charge * max_potential < parameters.termination_charge) {
+                group.terminated = true;
+                break;
+            }
+            last_max_potential = max_potential;
+
+            // Coarsen the time step while the weighting potentials barely change
+            if(parameters.coarsening_potential > 0) {
+                timestep = (max_potential_difference < parameters.coarsening_potential
+                                ? std::min(2 * timestep, parameters.timestep_max)
+                                : parameters.timestep);
+            }
+        }
+
+        for(size_t axis = 0; axis < 3; ++axis) {
+            group.position[axis] = position[axis];
+        }
+        group.time = time;
+    }
+#ifdef _OPENMP
+#pragma omp end declare target
+#endif
+} // namespace
+
+DeviceTransientPropagation::DeviceTransientPropagation(const Parameters& parameters,
+                                                       std::vector<float> velocity_tables,
+                                                       std::vector<float> potential_table)
+    : parameters_(parameters), velocity_tables_(std::move(velocity_tables)), potential_table_(std::move(potential_table)) {
+    const float* tables = velocity_tables_.data();
+    const size_t tables_size = velocity_tables_.size();
+    const float* potentials = potential_table_.data();
+    const size_t potentials_size = potential_table_.size();
+    const double* tableau = &Tableau::values[0][0];
+#ifdef _OPENMP
+#pragma omp target enter data map(to : tables[0 : tables_size], potentials[0 : potentials_size], tableau[0 : tableau_size])
+#endif
+    static_cast<void>(tables);
+    static_cast<void>(tables_size);
+    static_cast<void>(potentials);
+    static_cast<void>(potentials_size);
+    static_cast<void>(tableau);
+}
+
+DeviceTransientPropagation::~DeviceTransientPropagation() {
+    const float* tables = velocity_tables_.data();
+    const size_t tables_size = velocity_tables_.size();
+    const float* potentials = potential_table_.data();
+    const size_t potentials_size = potential_table_.size();
+    const double* tableau = &Tableau::values[0][0];
+#ifdef _OPENMP
+#pragma omp target exit data map(delete : tables[0 : tables_size], potentials[0 : potentials_size])                         \
+    map(delete : tableau[0 : tableau_size])
+#endif
+    static_cast<void>(tables);
+    static_cast<void>(tables_size);
+    static_cast<void>(potentials);
+    static_cast<void>(potentials_size);
+    static_cast<void>(tableau);
+}
+
+/**
+ * The buffer of the induced charge only exists on the device while the groups are propagated. After the propagation, the
+ * first and last occupied time bin of every pixel are determined on the device, and only this range is transferred back.
+ */
+std::vector<DeviceTransientPropagation::PixelPulse>
+DeviceTransientPropagation::propagate(std::vector<Group>& groups, const Window& window, uint64_t seed) const {
+    const Parameters parameters = parameters_;
+    const float* tables = velocity_tables_.data();
+    const size_t tables_size = velocity_tables_.size();
+    const float* potentials = potential_table_.data();
+    const size_t potentials_size = potential_table_.size();
+    const double* tableau = &Tableau::values[0][0];
+    Group* data = groups.data();
+    const size_t size = groups.size();
+
+    const auto time_bins = window.time_bins;
+    const auto pixels = static_cast<size_t>(window.size[0]) * static_cast<size_t>(window.size[1]);
+    const size_t buffer_size = pixels * time_bins;
+    std::vector<double> buffer_storage(buffer_size);
+    std::vector<size_t> range_storage(2 * pixels);
+    double* buffer = buffer_storage.data();
+    size_t* ranges = range_storage.data();
+
+    // The tables are already present on the device, the buffer is allocated and cleared there
+#ifdef _OPENMP
+#pragma omp target enter data map(alloc : buffer[0 : buffer_size])
+#pragma omp target teams distribute parallel for
+#endif
+    for(size_t idx = 0; idx < buffer_size; ++idx) {
+        buffer[idx] = 0;
+    }
+
+#ifdef _OPENMP
+#pragma omp target teams distribute parallel for map(to : tables[0 : tables_size], potentials[0 : potentials_size])         \
+    map(to : tableau[0 : tableau_size]) map(tofrom : data[0 : size]) firstprivate(parameters, window, seed)
+#endif
+    for(size_t idx = 0; idx < size; ++idx) {
+        propagate_group(parameters, tables, potentials, tableau, window, buffer, data[idx], seed, idx);
+    }
+
+    // Find the occupied range of time bins of every pixel, an empty range is marked by a start beyond the end
+#ifdef _OPENMP
+#pragma omp target teams distribute parallel for map(from : ranges[0 : 2 * pixels])
+#endif
+    for(size_t pixel = 0; pixel < pixels; ++pixel) {
+        size_t first = time_bins, last = 0;
+        for(size_t bin = 0; bin < time_bins; ++bin) {
+            if(buffer[pixel * time_bins + bin] != 0) {
+                first = std::min(first, bin);
+                last = bin;
+            }
+        }
+        ranges[2 * pixel] = first;
+        ranges[2 * pixel + 1] = last;
+    }
+
+    std::vector<PixelPulse> pulses;
+    for(size_t pixel = 0; pixel < pixels; ++pixel) {
+        const auto first = ranges[2 * pixel];
+        if(first >= time_bins) {
+            continue;
+        }
+        const auto start = pixel * time_bins + first;
+        const auto length = ranges[2 * pixel + 1] - first + 1;
+#ifdef _OPENMP
+#pragma omp target update from(buffer[start : length])
+#endif
+        PixelPulse pulse;
+        pulse.index = {window.origin[0] + static_cast<int>(pixel / static_cast<size_t>(window.size[1])),
+                       window.origin[1] + static_cast<int>(pixel % static_cast<size_t>(window.size[1]))};
+        pulse.offset = first;
+        pulse.values.assign(buffer + start, buffer + start + length);
+        pulses.push_back(std::move(pulse));
+    }
+
+#ifdef _OPENMP
+#pragma omp target exit data map(delete : buffer[0 : buffer_size])
+#endif
+    static_cast<void>(tables_size);
+    static_cast<void>(potentials_size);
+    return pulses;
+}
+
+std::string DeviceTransientPropagation::getDeviceDescription() {
+#ifdef _OPENMP
+    auto devices = omp_get_num_devices();
+    if(devices > 0) {
+        return "offload device " + std::to_string(omp_get_default_device()) + " of " + std::to_string(devices);
+    }
+    return "host, no offload device available";
+#else
+    return "host, module built without offloading support";
+#endif
+}
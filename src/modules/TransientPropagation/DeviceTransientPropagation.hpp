@@ -0,0 +1,147 @@
+/**
+ * @file
+ * @brief Definition of the transient propagation of charge carrier groups on an offload device
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_TRANSIENT_PROPAGATION_DEVICE_TRANSIENT_PROPAGATION_H
+#define ALLPIX_TRANSIENT_PROPAGATION_DEVICE_TRANSIENT_PROPAGATION_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace allpix {
+    /**
+     * @brief Transient propagation of independent charge carrier groups on an offload device
+     *
+     * The drift velocity and the diffusion constant of both carrier types are tabulated on a regular grid spanning the unit
+     * cell of one pixel over the full sensor thickness, and the weighting potential of a pixel is tabulated on the nodes of
+     * a grid spanning its induction matrix. The tables are transferred to the device once and kept there for the lifetime
+     * of the object. All groups of an event are propagated in parallel with a fixed-step fourth-order Runge-Kutta
+     * integration and Gaussian diffusion, each group drawing its random numbers from its own stream of a counter-based
+     * generator. The charge induced in every step is added atomically to a buffer of the event spanning the pixels of a
+     * window of the matrix and the time bins of the integration time. Only the occupied time range of every pixel is
+     * transferred back from the device.
+     *
+     * The device code is written as OpenMP target regions. If the module is not built with offloading support, or no
+     * device is available at run time, the same code is executed on the host.
+     */
+    class DeviceTransientPropagation {
+    public:
+        /**
+         * @brief Parameters of the propagation, all lengths given in local coordinates
+         */
+        struct Parameters {
+            double timestep{};                       ///< Nominal time step
+            double timestep_max{};                   ///< Maximum time step when coarsening the time step
+            double coarsening_potential{};           ///< Potential difference below which the time step is coarsened
+            double termination_charge{};             ///< Charge still to be induced below which groups are stopped
+            double integration_time{};               ///< Time after which the propagation of a group is stopped
+            std::array<double, 3> sensor_center{};   ///< Center of the sensor
+            std::array<double, 3> sensor_size{};     ///< Size of the sensor
+            std::array<int, 2> matrix_size{};        ///< Number of pixels of the matrix along x and y
+            std::array<double, 2> pixel_center{};    ///< Center of the pixel the velocity tables are computed for
+            std::array<double, 2> pixel_pitch{};     ///< Pitch of the pixels, i.e. the size of the tabulated unit cell
+            std::array<size_t, 3> velocity_bins{};   ///< Number of bins of the velocity tables along the three axes
+            int distance{};                          ///< Distance of the pixels of the induction matrix from the center
+            std::array<double, 2> potential_range{}; ///< Half-width of the weighting potential table around the pixel
+            std::array<size_t, 3> potential_nodes{}; ///< Number of nodes of the weighting potential table
+        };
+
+        /**
+         * @brief Charge carrier group propagated on the device
+         */
+        struct Group {
+            std::array<double, 3> position{}; ///< Start position, replaced by the final position
+            double start_time{};              ///< Local time of the deposit the group starts from
+            double time{};                    ///< Time the group has been propagated
+            double charge{};                  ///< Number of charge carriers in the group
+            int sign{};                       ///< Sign of the charge of the carriers
+            unsigned int carrier{};           ///< Index of the table of the carrier type, 0 for electrons, 1 for holes
+            bool halted{};                    ///< True if the group has left the sensor
+            bool terminated{};                ///< True if the group has been stopped early
+            bool left_window{};               ///< True if charge has been induced in pixels outside the window
+            std::array<int, 2> pixel_min{};   ///< Lowest pixel indices the group has passed
+            std::array<int, 2> pixel_max{};   ///< Highest pixel indices the group has passed
+        };
+
+        /**
+         * @brief Pixels and time bins of the matrix the induced charge of an event is recorded for
+         */
+        struct Window {
+            std::array<int, 2> origin{}; ///< Indices of the first pixel of the window
+            std::array<int, 2> size{};   ///< Number of pixels of the window along x and y
+            size_t time_bins{};          ///< Number of time bins of the integration time
+        };
+
+        /**
+         * @brief Induced charge in one pixel of the window
+         */
+        struct PixelPulse {
+            std::array<int, 2> index{}; ///< Index of the pixel
+            size_t offset{};            ///< First occupied time bin
+            std::vector<double> values; ///< Induced charge in the occupied time bins
+        };
+
+        /**
+         * @brief Transfer the tables of drift velocities, diffusion constants and weighting potentials to the device
+         * @param parameters Parameters of the propagation
+         * @param velocity_tables Drift velocity and diffusion constant at the center of every bin for electrons followed by
+         *                        holes, stored with the z index running fastest
+         * @param potential_table Weighting potential of a pixel at every node, stored with the z index running fastest
+         */
+        DeviceTransientPropagation(const Parameters& parameters,
+                                   std::vector<float> velocity_tables,
+                                   std::vector<float> potential_table);
+
+        /**
+         * @brief Release the tables on the device
+         */
+        ~DeviceTransientPropagation();
+
+        /// @{
+        /**
+         * @brief The tables are bound to the device storage and cannot be copied or moved
+         */
+        DeviceTransientPropagation(const DeviceTransientPropagation&) = delete;
+        DeviceTransientPropagation& operator=(const DeviceTransientPropagation&) = delete;
+        DeviceTransientPropagation(DeviceTransientPropagation&&) = delete;
+        DeviceTransientPropagation& operator=(DeviceTransientPropagation&&) = delete;
+        /// @}
+
+        /**
+         * @brief Propagate the charge carrier groups of an event and collect their induced charge
+         * @param groups Groups to propagate, updated in place
+         * @param window Pixels and time bins to record the induced charge for
+         * @param seed Seed of the random number streams of the groups
+         * @return Induced charge of all pixels of the window with a non-vanishing signal
+         */
+        std::vector<PixelPulse> propagate(std::vector<Group>& groups, const Window& window, uint64_t seed) const;
+
+        /**
+         * @brief Describe the device the propagation is executed on
+         * @return Human-readable description
+         */
+        static std::string getDeviceDescription();
+
+        /**
+         * @brief Number of values stored per bin of the velocity tables
+         */
+        static constexpr size_t values_per_bin = 4;
+
+    private:
+        Parameters parameters_;
+        std::vector<float> velocity_tables_;
+        std::vector<float> potential_table_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_TRANSIENT_PROPAGATION_DEVICE_TRANSIENT_PROPAGATION_H */
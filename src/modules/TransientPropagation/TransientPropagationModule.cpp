@@ -11,16 +11,24 @@
 
 #include "TransientPropagationModule.hpp"
 
-#include <map>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <memory>
+#include <optional>
+#include <sstream>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <Eigen/Core>
 
+#include "core/geometry/HexagonalPixelDetectorModel.hpp"
+#include "core/geometry/PixelDetectorModel.hpp"
 #include "core/utils/distributions.h"
 #include "core/utils/log.h"
 #include "objects/exceptions.h"
+#include "tools/pixel_map.h"
 #include "tools/runge_kutta.h"
 
 using namespace allpix;
@@ -39,15 +47,29 @@ TransientPropagationModule::TransientPropagationModule(Configuration& config,
 
     // Set default value for config variables
     config_.setDefault<double>("timestep", Units::get(0.01, "ns"));
+    config_.setDefault<double>("timestep_max", 10 * config_.get<double>("timestep"));
+    config_.setDefault<double>("coarsening_potential", 0.);
+    config_.setDefault<double>("termination_charge", 0.);
+    config_.setDefault<bool>("pulse_library", false);
+    config_.setDefault<ROOT::Math::XYZVector>("pulse_library_bins", {5, 5, 20});
     config_.setDefault<double>("integration_time", Units::get(25, "ns"));
+    config_.setDefault<double>("pulse_fine_time", config_.get<double>("integration_time"));
+    config_.setDefault<double>("pulse_bin_growth", 1.);
     config_.setDefault<unsigned int>("charge_per_step", 10);
     config_.setDefault<unsigned int>("max_charge_groups", 1000);
 
+    // Propagation on an offload device using tabulated carrier velocities and weighting potentials, disabled by default
+    config_.setDefault<bool>("offload_propagation", false);
+    config_.setDefaultArray<unsigned int>("offload_table_bins", {100, 100, 100});
+    config_.setDefaultArray<unsigned int>("offload_potential_bins", {20, 20, 100});
+
     // Models:
     config_.setDefault<std::string>("mobility_model", "jacoboni");
     config_.setDefault<std::string>("recombination_model", "none");
     config_.setDefault<std::string>("trapping_model", "none");
     config_.setDefault<std::string>("detrapping_model", "none");
+    config_.setDefault<bool>("sample_carrier_lifetimes", false);
+    config_.setDefault<bool>("prefetch_fields", false);
 
     config_.setDefault<double>("temperature", 293.15);
     config_.setDefault<unsigned int>("distance", 1);
@@ -63,6 +85,7 @@ TransientPropagationModule::TransientPropagationModule(Configuration& config,
     config_.setDefault<bool>("output_linegraphs_recombined", false);
     config_.setDefault<bool>("output_linegraphs_trapped", false);
     config_.setDefault<bool>("output_animations", false);
+    config_.setDefault<bool>("output_trajectories", false);
     config_.setDefault<bool>("output_plots",
                              config_.get<bool>("output_linegraphs") || config_.get<bool>("output_animations"));
     config_.setDefault<bool>("output_animations_color_markers", false);
@@ -75,10 +98,29 @@ TransientPropagationModule::TransientPropagationModule(Configuration& config,
     // Copy some variables from configuration to avoid lookups:
     temperature_ = config_.get<double>("temperature");
     timestep_ = config_.get<double>("timestep");
+    timestep_max_ = config_.get<double>("timestep_max");
+    coarsening_potential_ = config_.get<double>("coarsening_potential");
+    termination_charge_ = config_.get<double>("termination_charge");
+    pulse_library_ = config_.get<bool>("pulse_library");
     integration_time_ = config_.get<double>("integration_time");
+
+    // Piecewise binning of the pulses, bins of the length of the time step up to the fine time and growing bins thereafter
+    pulse_bin_growth_ = config_.get<double>("pulse_bin_growth");
+    if(pulse_bin_growth_ < 1.) {
+        throw InvalidValueError(config_, "pulse_bin_growth", "growth of the pulse bins cannot be smaller than one");
+    }
+    auto pulse_fine_time = config_.get<double>("pulse_fine_time");
+    if(pulse_fine_time < 0.) {
+        throw InvalidValueError(config_, "pulse_fine_time", "time covered by fine pulse bins cannot be negative");
+    }
+    pulse_fine_bins_ = static_cast<size_t>(std::lround(pulse_fine_time / timestep_));
+
     distance_ = config_.get<unsigned int>("distance");
     charge_per_step_ = config_.get<unsigned int>("charge_per_step");
     max_charge_groups_ = config_.get<unsigned int>("max_charge_groups");
+    sample_carrier_lifetimes_ = config_.get<bool>("sample_carrier_lifetimes");
+    prefetch_fields_ = config_.get<bool>("prefetch_fields");
+    offload_propagation_ = config_.get<bool>("offload_propagation");
     boltzmann_kT_ = Units::get(8.6173333e-5, "eV/K") * temperature_;
 
     max_multiplication_level_ = config.get<unsigned int>("max_multiplication_level");
@@ -88,11 +130,15 @@ TransientPropagationModule::TransientPropagationModule(Configuration& config,
     output_linegraphs_collected_ = config_.get<bool>("output_linegraphs_collected");
     output_linegraphs_recombined_ = config_.get<bool>("output_linegraphs_recombined");
     output_linegraphs_trapped_ = config_.get<bool>("output_linegraphs_trapped");
+    output_animations_ = config_.get<bool>("output_animations");
+    output_trajectories_ = config_.get<bool>("output_trajectories");
+    record_trajectories_ = output_linegraphs_ || output_trajectories_;
     output_plots_step_ = config_.get<double>("output_plots_step");
+    plot_settings_ = LineGraph::PlotSettings(config_);
 
     // Enable multithreading of this module if multithreading is enabled and no per-event output plots are requested:
     // FIXME: Review if this is really the case or we can still use multithreading
-    if(!(config_.get<bool>("output_animations") || output_linegraphs_)) {
+    if(!(output_animations_ || output_linegraphs_)) {
         allow_multithreading();
     } else {
         LOG(WARNING) << "Per-event line graphs or animations requested, disabling parallel event processing";
@@ -106,6 +152,16 @@ TransientPropagationModule::TransientPropagationModule(Configuration& config,
 
 void TransientPropagationModule::initialize() {
 
+    // Register the counters and timers of the performance report
+    groups_counter_ = getProfiler().registerCounter("charge_groups");
+    recombined_counter_ = getProfiler().registerCounter("recombined_charges");
+    trapped_counter_ = getProfiler().registerCounter("trapped_charges");
+    propagation_timer_ = getProfiler().registerTimer("propagation");
+
+    if(output_trajectories_) {
+        trajectory_writer_ = std::make_unique<LineGraph::TrajectoryWriter>(this);
+    }
+
     // Check for electric field
     if(!detector_->hasElectricField()) {
         LOG(WARNING) << "This detector does not have an electric field.";
@@ -388,6 +444,213 @@ void TransientPropagationModule::initialize() {
                                                      model_->getSensorSize().z() / 2.);
         }
     }
+
+    // Precompute the induced charge of single carriers started on a grid in the pixel cell
+    if(pulse_library_) {
+        if(pulse_bin_growth_ != 1.) {
+            throw InvalidCombinationError(
+                config_, {"pulse_library", "pulse_bin_growth"}, "Pulse library requires pulses with uniform binning");
+        }
+        if(!multiplication_.is<NoImpactIonization>()) {
+            throw InvalidCombinationError(
+                config_, {"pulse_library", "multiplication_model"}, "Pulse library cannot be used with impact ionization");
+        }
+        if(config_.get<std::string>("recombination_model") != "none" ||
+           config_.get<std::string>("trapping_model") != "none") {
+            throw InvalidCombinationError(config_,
+                                          {"pulse_library", "recombination_model", "trapping_model"},
+                                          "Pulse library cannot be used with recombination or trapping");
+        }
+        if(has_magnetic_field_) {
+            throw ModuleError("Pulse library cannot be used in a magnetic field");
+        }
+
+        auto bins = config_.get<ROOT::Math::XYZVector>("pulse_library_bins");
+        if(bins.x() < 1 || bins.y() < 1 || bins.z() < 1) {
+            throw InvalidValueError(config_, "pulse_library_bins", "number of bins has to be positive along all axes");
+        }
+        library_bins_ = {static_cast<size_t>(bins.x()), static_cast<size_t>(bins.y()), static_cast<size_t>(bins.z())};
+
+        // The library is calculated for the pixel at the matrix center, such that its induction matrix is complete
+        auto [reference_x, reference_y] = model_->getPixelIndex(model_->getMatrixCenter());
+        auto reference = Pixel::Index(reference_x, reference_y);
+        auto neighbors = model_->getNeighbors(reference, distance_);
+        library_offsets_.clear();
+        for(const auto& neighbor : neighbors) {
+            library_offsets_.emplace_back(neighbor.x() - reference.x(), neighbor.y() - reference.y());
+        }
+
+        auto center = model_->getPixelCenter(reference_x, reference_y);
+        auto pitch = model_->getPixelSize();
+        auto thickness = model_->getSensorSize().z();
+        auto sensor_min_z = model_->getSensorCenter().z() - thickness / 2;
+        detector_->visitElectricField([&](const auto& electric_field) {
+            for(auto type : {CarrierType::ELECTRON, CarrierType::HOLE}) {
+                auto& library = (type == CarrierType::ELECTRON ? electron_library_ : hole_library_);
+                library.clear();
+                for(size_t x = 0; x < library_bins_[0]; ++x) {
+                    for(size_t y = 0; y < library_bins_[1]; ++y) {
+                        for(size_t z = 0; z < library_bins_[2]; ++z) {
+                            auto start = ROOT::Math::XYZPoint(
+                                center.x() + ((static_cast<double>(x) + 0.5) / library_bins_[0] - 0.5) * pitch.x(),
+                                center.y() + ((static_cast<double>(y) + 0.5) / library_bins_[1] - 0.5) * pitch.y(),
+                                sensor_min_z + (static_cast<double>(z) + 0.5) / library_bins_[2] * thickness);
+                            library.push_back(create_library_entry(electric_field, type, start, reference));
+                        }
+                    }
+                }
+            }
+        });
+        LOG(INFO) << "Calculated pulse library with " << library_bins_[0] << "x" << library_bins_[1] << "x"
+                  << library_bins_[2] << " start positions per carrier type for " << library_offsets_.size() << " pixels";
+    }
+
+    if(offload_propagation_) {
+        initialize_offload();
+    }
+}
+
+/**
+ * The drift velocity and diffusion constant are tabulated over the unit cell of the pixel at the matrix center, which
+ * requires the electric field and doping profile to repeat with the pixel pitch. The weighting potential of this pixel is
+ * tabulated on a grid of nodes covering its induction matrix extended by one pixel, such that it can be evaluated for all
+ * pixels around the positions before and after a step crossing a pixel boundary. Configurations with features not
+ * implemented on the device fall back to the propagation on the host.
+ */
+void TransientPropagationModule::initialize_offload() {
+    // Collect all reasons preventing the propagation on the device
+    std::vector<std::string> reasons;
+    auto periodic = [](FieldType type, FieldMapping mapping) {
+        return type == FieldType::NONE || type == FieldType::CONSTANT || type == FieldType::LINEAR ||
+               type == FieldType::CUSTOM1D || (type == FieldType::GRID && mapping != FieldMapping::SENSOR);
+    };
+    if(!periodic(detector_->getElectricFieldType(), detector_->getElectricFieldMapping())) {
+        reasons.emplace_back("electric field does not repeat with the pixel pitch");
+    }
+    if(!periodic(detector_->getDopingProfileType(), detector_->getDopingProfileMapping())) {
+        reasons.emplace_back("doping profile does not repeat with the pixel pitch");
+    }
+    if(std::dynamic_pointer_cast<PixelDetectorModel>(model_) == nullptr ||
+       std::dynamic_pointer_cast<HexagonalPixelDetectorModel>(model_) != nullptr) {
+        reasons.emplace_back("detector model has no rectangular pixel grid");
+    }
+    if(!model_->getImplants().empty()) {
+        reasons.emplace_back("detector model has implants");
+    }
+    if(has_magnetic_field_) {
+        reasons.emplace_back("magnetic field is present");
+    }
+    if(!multiplication_.is<NoImpactIonization>()) {
+        reasons.emplace_back("impact ionization is enabled");
+    }
+    if(config_.get<std::string>("recombination_model") != "none" || config_.get<std::string>("trapping_model") != "none") {
+        reasons.emplace_back("recombination or trapping is enabled");
+    }
+    if(pulse_library_) {
+        reasons.emplace_back("pulse library is enabled");
+    }
+    if(pulse_bin_growth_ != 1.) {
+        reasons.emplace_back("pulses have piecewise binning");
+    }
+    if(output_plots_ || output_linegraphs_ || output_trajectories_) {
+        reasons.emplace_back("output plots, line graphs or trajectories are requested");
+    }
+    if(!reasons.empty()) {
+        std::stringstream reason_list;
+        for(const auto& reason : reasons) {
+            reason_list << std::endl << "  " << reason;
+        }
+        LOG(WARNING) << "Propagation cannot be offloaded, propagating on the host:" << reason_list.str();
+        offload_propagation_ = false;
+        return;
+    }
+
+    auto get_bins = [&](const std::string& key) {
+        auto values = config_.getArray<unsigned int>(key);
+        if(values.size() != 3 || std::find(values.begin(), values.end(), 0) != values.end()) {
+            throw InvalidValueError(config_, key, "three non-zero numbers of bins along x, y and z are required");
+        }
+        std::array<size_t, 3> bins{};
+        std::copy(values.begin(), values.end(), bins.begin());
+        return bins;
+    };
+    auto table_bins = get_bins("offload_table_bins");
+    auto potential_bins = get_bins("offload_potential_bins");
+
+    // Tables are computed for the pixel at the matrix center
+    auto [reference_x, reference_y] = model_->getPixelIndex(model_->getMatrixCenter());
+    auto reference = model_->getPixelCenter(reference_x, reference_y);
+    auto sensor_center = model_->getSensorCenter();
+    auto sensor_size = model_->getSensorSize();
+    auto pitch = model_->getPixelSize();
+    auto matrix = model_->getNPixels();
+    auto cells = 2 * distance_ + 3;
+
+    DeviceTransientPropagation::Parameters parameters;
+    parameters.timestep = timestep_;
+    parameters.timestep_max = timestep_max_;
+    parameters.coarsening_potential = coarsening_potential_;
+    parameters.termination_charge = termination_charge_;
+    parameters.integration_time = integration_time_;
+    parameters.sensor_center = {sensor_center.x(), sensor_center.y(), sensor_center.z()};
+    parameters.sensor_size = {sensor_size.x(), sensor_size.y(), sensor_size.z()};
+    parameters.matrix_size = {static_cast<int>(matrix.x()), static_cast<int>(matrix.y())};
+    parameters.pixel_center = {reference.x(), reference.y()};
+    parameters.pixel_pitch = {pitch.x(), pitch.y()};
+    parameters.velocity_bins = table_bins;
+    parameters.distance = static_cast<int>(distance_);
+    parameters.potential_range = {cells * pitch.x() / 2, cells * pitch.y() / 2};
+    parameters.potential_nodes = {potential_bins[0] * cells + 1, potential_bins[1] * cells + 1, potential_bins[2] + 1};
+
+    // Relative position of bin centers and nodes within the tabulated range
+    auto bin_center = [](size_t bin, size_t bins) {
+        return (static_cast<double>(bin) + 0.5) / static_cast<double>(bins) - 0.5;
+    };
+    auto node = [](size_t index, size_t nodes) { return static_cast<double>(index) / static_cast<double>(nodes - 1) - 0.5; };
+
+    // Drift velocity and diffusion constant at the bin centers of the unit cell
+    std::vector<float> velocity_tables;
+    velocity_tables.reserve(2 * table_bins[0] * table_bins[1] * table_bins[2] * DeviceTransientPropagation::values_per_bin);
+    for(auto type : {CarrierType::ELECTRON, CarrierType::HOLE}) {
+        for(size_t x = 0; x < table_bins[0]; ++x) {
+            for(size_t y = 0; y < table_bins[1]; ++y) {
+                for(size_t z = 0; z < table_bins[2]; ++z) {
+                    ROOT::Math::XYZPoint position(reference.x() + pitch.x() * bin_center(x, table_bins[0]),
+                                                  reference.y() + pitch.y() * bin_center(y, table_bins[1]),
+                                                  sensor_center.z() + sensor_size.z() * bin_center(z, table_bins[2]));
+                    auto efield = detector_->getElectricField(position);
+                    auto mobility = mobility_(type, std::sqrt(efield.Mag2()), detector_->getDopingConcentration(position));
+                    auto velocity = static_cast<int>(type) * mobility * efield;
+                    velocity_tables.push_back(static_cast<float>(velocity.x()));
+                    velocity_tables.push_back(static_cast<float>(velocity.y()));
+                    velocity_tables.push_back(static_cast<float>(velocity.z()));
+                    velocity_tables.push_back(static_cast<float>(boltzmann_kT_ * mobility));
+                }
+            }
+        }
+    }
+
+    // Weighting potential at the nodes around the pixel
+    const auto& nodes = parameters.potential_nodes;
+    auto reference_index = Pixel::Index(reference_x, reference_y);
+    std::vector<float> potential_table;
+    potential_table.reserve(nodes[0] * nodes[1] * nodes[2]);
+    for(size_t x = 0; x < nodes[0]; ++x) {
+        for(size_t y = 0; y < nodes[1]; ++y) {
+            for(size_t z = 0; z < nodes[2]; ++z) {
+                ROOT::Math::XYZPoint position(reference.x() + cells * pitch.x() * node(x, nodes[0]),
+                                              reference.y() + cells * pitch.y() * node(y, nodes[1]),
+                                              sensor_center.z() + sensor_size.z() * node(z, nodes[2]));
+                potential_table.push_back(static_cast<float>(detector_->getWeightingPotential(position, reference_index)));
+            }
+        }
+    }
+
+    device_propagation_ = std::make_unique<DeviceTransientPropagation>(
+        parameters, std::move(velocity_tables), std::move(potential_table));
+    LOG(INFO) << "Propagating charge carrier groups on " << DeviceTransientPropagation::getDeviceDescription() << " with "
+              << table_bins[0] << "x" << table_bins[1] << "x" << table_bins[2] << " tabulated carrier velocities and "
+              << nodes[0] << "x" << nodes[1] << "x" << nodes[2] << " tabulated weighting potentials";
 }
 
 void TransientPropagationModule::run(Event* event) {
@@ -398,13 +661,21 @@ void TransientPropagationModule::run(Event* event) {
     unsigned int propagated_charges_count = 0;
     unsigned int recombined_charges_count = 0;
     unsigned int trapped_charges_count = 0;
+    uint64_t group_count = 0;
+
+    // Trajectories recorded for the output plots, the buffer is reused for all events of this thread
+    thread_local LineGraph::OutputPlotPoints output_plot_points;
+    output_plot_points.clear();
 
-    // List of points to plot to plot for output plots
-    LineGraph::OutputPlotPoints output_plot_points;
+    // Charge carrier groups collected for the propagation on the offload device
+    std::vector<std::tuple<const DepositedCharge*, CarrierType, unsigned int>> offload_groups;
 
     // Loop over all deposits for propagation
     LOG(TRACE) << "Propagating charges in sensor";
-    for(const auto& deposit : deposits_message->getData()) {
+    std::optional<Profiler::ScopedTimer> propagation_timer(std::in_place, getProfiler(), propagation_timer_);
+    for(const auto& carrier : expandCarriers(deposits_message->getData())) {
+        const auto& deposit = *carrier.first;
+        const auto type = carrier.second;
 
         // Only process if within requested integration time:
         if(deposit.getLocalTime() > integration_time_) {
@@ -419,7 +690,7 @@ void TransientPropagationModule::run(Event* event) {
         // Loop over all charges in the deposit
         unsigned int charges_remaining = deposit.getCharge();
 
-        LOG(DEBUG) << "Set of charge carriers (" << deposit.getType() << ") on "
+        LOG(DEBUG) << "Set of charge carriers (" << type << ") on "
                    << Units::display(deposit.getLocalPosition(), {"mm", "um"});
 
         auto charge_per_step = charge_per_step_;
@@ -437,41 +708,71 @@ void TransientPropagationModule::run(Event* event) {
             }
             charges_remaining -= charge_per_step;
 
-            // Get position and propagate through sensor
-            auto [recombined, trapped, propagated] = propagate(event,
-                                                               deposit,
-                                                               deposit.getLocalPosition(),
-                                                               deposit.getType(),
-                                                               charge_per_step,
-                                                               deposit.getLocalTime(),
-                                                               deposit.getGlobalTime(),
-                                                               0,
-                                                               propagated_charges,
-                                                               output_plot_points);
+            // Collect the groups for the propagation on the offload device, no charge is lost on the device
+            if(device_propagation_ != nullptr) {
+                offload_groups.emplace_back(&deposit, type, charge_per_step);
+                propagated_charges_count += charge_per_step;
+                group_count++;
+                continue;
+            }
+
+            // Synthesize the pulses from the library if requested, no charge is lost without recombination and trapping
+            if(pulse_library_) {
+                synthesize(event, deposit, type, charge_per_step, propagated_charges);
+                propagated_charges_count += charge_per_step;
+                group_count++;
+                continue;
+            }
+
+            // Get position and propagate through sensor, resolving the type of the electric field once for this set
+            auto [recombined, trapped, propagated] = detector_->visitElectricField([&](const auto& electric_field) {
+                return propagate(event,
+                                 deposit,
+                                 deposit.getLocalPosition(),
+                                 type,
+                                 charge_per_step,
+                                 deposit.getLocalTime(),
+                                 deposit.getGlobalTime(),
+                                 0,
+                                 propagated_charges,
+                                 output_plot_points,
+                                 electric_field);
+            });
 
             // Update statistics:
             recombined_charges_count += recombined;
             trapped_charges_count += trapped;
             propagated_charges_count += propagated;
+            group_count++;
         }
     }
+    if(device_propagation_ != nullptr) {
+        propagate_offload(event->getRandomNumber(), offload_groups, propagated_charges);
+    }
+    propagation_timer.reset();
+    getProfiler().count(groups_counter_, group_count);
+    getProfiler().count(recombined_counter_, recombined_charges_count);
+    getProfiler().count(trapped_counter_, trapped_charges_count);
 
     // Output plots if required
     if(output_linegraphs_) {
-        LineGraph::Create(event->number, this, config_, output_plot_points, CarrierState::UNKNOWN);
+        LineGraph::Create(event->number, this, plot_settings_, output_plot_points, CarrierState::UNKNOWN);
         if(output_linegraphs_collected_) {
-            LineGraph::Create(event->number, this, config_, output_plot_points, CarrierState::HALTED);
+            LineGraph::Create(event->number, this, plot_settings_, output_plot_points, CarrierState::HALTED);
         }
         if(output_linegraphs_recombined_) {
-            LineGraph::Create(event->number, this, config_, output_plot_points, CarrierState::RECOMBINED);
+            LineGraph::Create(event->number, this, plot_settings_, output_plot_points, CarrierState::RECOMBINED);
         }
         if(output_linegraphs_trapped_) {
-            LineGraph::Create(event->number, this, config_, output_plot_points, CarrierState::TRAPPED);
+            LineGraph::Create(event->number, this, plot_settings_, output_plot_points, CarrierState::TRAPPED);
         }
-        if(config_.get<bool>("output_animations")) {
-            LineGraph::Animate(event->number, this, config_, output_plot_points);
+        if(output_animations_) {
+            LineGraph::Animate(event->number, this, plot_settings_, output_plot_points);
         }
     }
+    if(output_trajectories_) {
+        trajectory_writer_->fill(event->number, output_plot_points);
+    }
 
     LOG(INFO) << "Propagated " << propagated_charges_count << " charges" << std::endl
               << "Recombined " << recombined_charges_count << " charges during transport" << std::endl
@@ -495,6 +796,7 @@ void TransientPropagationModule::run(Event* event) {
  * velocity at every point with help of the electric field map of the detector. A Runge-Kutta integration is applied in
  * multiple steps, adding a random diffusion to the propagating charge every step.
  */
+template <typename ElectricField>
 std::tuple<unsigned int, unsigned int, unsigned int>
 TransientPropagationModule::propagate(Event* event,
                                       const DepositedCharge& deposit,
@@ -505,7 +807,8 @@ TransientPropagationModule::propagate(Event* event,
                                       const double initial_time_global,
                                       const unsigned int level,
                                       std::vector<PropagatedCharge>& propagated_charges,
-                                      LineGraph::OutputPlotPoints& output_plot_points) const {
+                                      LineGraph::OutputPlotPoints& output_plot_points,
+                                      const ElectricField& electric_field) const {
 
     if(level > max_multiplication_level_) {
         LOG(WARNING) << "Found impact ionization shower with level larger than " << max_multiplication_level_
@@ -514,18 +817,21 @@ TransientPropagationModule::propagate(Event* event,
     }
 
     Eigen::Vector3d position(pos.x(), pos.y(), pos.z());
-    std::map<Pixel::Index, Pulse> pixel_map;
+    // Pulses are accumulated in a flat pixel map, which cannot be shared between the recursive calls for secondaries
+    PixelMap<Pulse> pixel_map;
+    // Buffers for the induction matrix and its weighting potentials, reused for every step of this charge carrier set
+    std::vector<Pixel::Index> neighbors;
+    std::vector<std::pair<double, double>> potentials;
 
     unsigned int propagated_charges_count = 0;
     unsigned int recombined_charges_count = 0;
     unsigned int trapped_charges_count = 0;
 
     // Add point of deposition to the output plots if requested
-    if(output_linegraphs_) {
-        output_plot_points.emplace_back(std::make_tuple(deposit.getGlobalTime(), charge, type, CarrierState::MOTION),
-                                        std::vector<ROOT::Math::XYZPoint>());
+    size_t output_plot_index = 0;
+    if(record_trajectories_) {
+        output_plot_index = output_plot_points.addTrajectory(deposit.getGlobalTime(), charge, type, CarrierState::MOTION);
     }
-    auto output_plot_index = output_plot_points.size() - 1;
 
     // Store initial charge
     const unsigned int initial_charge = charge;
@@ -546,29 +852,45 @@ TransientPropagationModule::propagate(Event* event,
     // Survival probability of this charge carrier package, evaluated at every step
     allpix::uniform_real_distribution<double> uniform_distribution(0, 1);
 
-    // Define lambda functions to compute the charge carrier velocity with or without magnetic field
-    std::function<Eigen::Vector3d(double, const Eigen::Vector3d&)> carrier_velocity_noB =
-        [&](double, const Eigen::Vector3d& cur_pos) -> Eigen::Vector3d {
-        auto raw_field = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(cur_pos));
-        Eigen::Vector3d efield(raw_field.x(), raw_field.y(), raw_field.z());
-
-        auto doping = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+    // Remaining time to recombination and trapping in units of the respective lifetime, drawn once if requested
+    allpix::exponential_distribution<double> lifetime_distribution(1);
+    double recombination_budget = 0, trapping_budget = 0;
+    if(sample_carrier_lifetimes_) {
+        recombination_budget = lifetime_distribution(event->getRandomEngine());
+        trapping_budget = lifetime_distribution(event->getRandomEngine());
+    }
 
-        return static_cast<int>(type) * mobility_(type, efield.norm(), doping) * efield;
+    // Check for recombination and trapping in the last step, integrating the rates along the path if sampled once
+    auto recombined = [&](double doping, double timestep) {
+        if(!sample_carrier_lifetimes_) {
+            return recombination_(type, doping, uniform_distribution(event->getRandomEngine()), timestep);
+        }
+        recombination_budget -= recombination_.rate(type, doping) * timestep;
+        return recombination_budget < 0;
+    };
+    auto trapped = [&](double efield_mag, double timestep) {
+        if(!sample_carrier_lifetimes_) {
+            return trapping_(type, uniform_distribution(event->getRandomEngine()), timestep, efield_mag);
+        }
+        trapping_budget -= trapping_.rate(type, efield_mag) * timestep;
+        return trapping_budget < 0;
     };
 
-    std::function<Eigen::Vector3d(double, const Eigen::Vector3d&)> carrier_velocity_withB =
-        [&](double, const Eigen::Vector3d& cur_pos) -> Eigen::Vector3d {
-        auto raw_field = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+    // Define a lambda function to compute the charge carrier velocity with or without magnetic field
+    auto carrier_velocity = [&](double, const Eigen::Vector3d& cur_pos) -> Eigen::Vector3d {
+        auto raw_field = electric_field(static_cast<ROOT::Math::XYZPoint>(cur_pos));
         Eigen::Vector3d efield(raw_field.x(), raw_field.y(), raw_field.z());
 
-        Eigen::Vector3d velocity;
+        auto doping = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+        auto mob = mobility_(type, efield.norm(), doping);
+
+        if(!has_magnetic_field_) {
+            return static_cast<int>(type) * mob * efield;
+        }
+
         auto magnetic_field = detector_->getMagneticField(static_cast<ROOT::Math::XYZPoint>(cur_pos));
         Eigen::Vector3d bfield(magnetic_field.x(), magnetic_field.y(), magnetic_field.z());
 
-        auto doping = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(cur_pos));
-
-        auto mob = mobility_(type, efield.norm(), doping);
         auto exb = efield.cross(bfield);
 
         Eigen::Vector3d term1;
@@ -582,21 +904,22 @@ TransientPropagationModule::propagate(Event* event,
     };
 
     // Create the runge kutta solver with an RK4 tableau, no error estimation required since we're not adapting step size
-    auto runge_kutta = make_runge_kutta(
-        tableau::RK4, (has_magnetic_field_ ? carrier_velocity_withB : carrier_velocity_noB), timestep_, position);
+    auto runge_kutta = make_static_runge_kutta<tableau::StaticRK4>(carrier_velocity, timestep_, position);
 
     // Continue propagation until the deposit is outside the sensor
     Eigen::Vector3d last_position = position;
     ROOT::Math::XYZVector efield{}, last_efield{};
+    // Largest weighting potential of the induction matrix after the previous step, for the early termination
+    auto last_max_potential = std::numeric_limits<double>::max();
     size_t next_idx = 0;
     auto state = CarrierState::MOTION;
     while(state == CarrierState::MOTION && (initial_time_local + runge_kutta.getTime()) < integration_time_) {
         // Update output plots if necessary (depending on the plot step)
-        if(output_linegraphs_) { // Set final state of charge carrier for plotting:
+        if(record_trajectories_) {
             auto time_idx = static_cast<size_t>(runge_kutta.getTime() / output_plots_step_);
             while(next_idx <= time_idx) {
-                output_plot_points.at(output_plot_index).second.push_back(static_cast<ROOT::Math::XYZPoint>(position));
-                next_idx = output_plot_points.at(output_plot_index).second.size();
+                output_plot_points.addPoint(output_plot_index, static_cast<ROOT::Math::XYZPoint>(position));
+                next_idx = output_plot_points.getNumberOfPoints(output_plot_index);
             }
         }
 
@@ -605,29 +928,35 @@ TransientPropagationModule::propagate(Event* event,
         last_efield = efield;
 
         // Get electric field at current (pre-step) position
-        efield = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(position));
+        efield = electric_field(static_cast<ROOT::Math::XYZPoint>(position));
         auto doping = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(position));
 
         // Execute a Runge Kutta step
+        auto timestep = runge_kutta.getTimeStep();
         auto step = runge_kutta.step();
 
         // Get the current result
         position = runge_kutta.getValue();
 
+        // Request the fields at the position predicted for the end of the next step while processing this one
+        if(prefetch_fields_) {
+            detector_->prefetchFields(static_cast<ROOT::Math::XYZPoint>(Eigen::Vector3d(position + step.value)), true);
+        }
+
         // Apply diffusion step
-        auto diffusion = carrier_diffusion(std::sqrt(efield.Mag2()), doping, timestep_);
+        auto diffusion = carrier_diffusion(std::sqrt(efield.Mag2()), doping, timestep);
         position += diffusion;
         runge_kutta.setValue(position);
 
         // Update step length histogram
         if(output_plots_) {
-            step_length_histo_->Fill(static_cast<double>(Units::convert(step.value.norm(), "um")));
+            step_length_histo_->Fill(static_cast<double>(step.value.norm() / units::um));
         }
 
         // If charge carrier reaches implant, interpolate surface position for higher accuracy:
-        if(auto implant = model_->isWithinImplant(static_cast<ROOT::Math::XYZPoint>(position))) {
+        if(auto implant = model_->findImplant(static_cast<ROOT::Math::XYZPoint>(position))) {
             LOG(TRACE) << "Carrier in implant: " << Units::display(static_cast<ROOT::Math::XYZPoint>(position), {"nm"});
-            auto new_position = model_->getImplantIntercept(implant.value(),
+            auto new_position = model_->getImplantIntercept(model_->getImplants()[implant.value()],
                                                             static_cast<ROOT::Math::XYZPoint>(last_position),
                                                             static_cast<ROOT::Math::XYZPoint>(position));
             position = Eigen::Vector3d(new_position.x(), new_position.y(), new_position.z());
@@ -648,14 +977,12 @@ TransientPropagationModule::propagate(Event* event,
         // Physics effects:
 
         // Check if charge carrier is still alive:
-        if(state == CarrierState::MOTION &&
-           recombination_(type, doping, uniform_distribution(event->getRandomEngine()), timestep_)) {
+        if(state == CarrierState::MOTION && recombined(doping, timestep)) {
             state = CarrierState::RECOMBINED;
         }
 
         // Check if the charge carrier has been trapped:
-        if(state == CarrierState::MOTION &&
-           trapping_(type, uniform_distribution(event->getRandomEngine()), timestep_, std::sqrt(efield.Mag2()))) {
+        if(state == CarrierState::MOTION && trapped(std::sqrt(efield.Mag2()), timestep)) {
             if(output_plots_) {
                 trapping_time_histo_->Fill(runge_kutta.getTime(), charge);
             }
@@ -665,9 +992,12 @@ TransientPropagationModule::propagate(Event* event,
                 // De-trap and advance in time if still below integration time
                 LOG(TRACE) << "De-trapping charge carrier after " << Units::display(detrap_time, {"ns", "us"});
                 runge_kutta.advanceTime(detrap_time);
+                if(sample_carrier_lifetimes_) {
+                    trapping_budget = lifetime_distribution(event->getRandomEngine());
+                }
 
                 if(output_plots_) {
-                    detrapping_time_histo_->Fill(static_cast<double>(Units::convert(detrap_time, "ns")), charge);
+                    detrapping_time_histo_->Fill(static_cast<double>(detrap_time / units::ns), charge);
                 }
             } else {
                 // Mark as trapped otherwise
@@ -717,7 +1047,8 @@ TransientPropagationModule::propagate(Event* event,
                                                                    initial_time_global + runge_kutta.getTime(),
                                                                    level + 1,
                                                                    propagated_charges,
-                                                                   output_plot_points);
+                                                                   output_plot_points,
+                                                                   electric_field);
 
                 // Update statistics:
                 recombined_charges_count += recombined;
@@ -741,14 +1072,17 @@ TransientPropagationModule::propagate(Event* event,
         auto [xpixel, ypixel] = model_->getPixelIndex(static_cast<ROOT::Math::XYZPoint>(position));
         auto [last_xpixel, last_ypixel] = model_->getPixelIndex(static_cast<ROOT::Math::XYZPoint>(last_position));
         auto idx = Pixel::Index(xpixel, ypixel);
-        auto neighbors = model_->getNeighbors(idx, distance_);
+        neighbors.clear();
+        model_->getNeighbors(idx, distance_, neighbors);
 
         // If the charge carrier crossed pixel boundaries, ensure that we always calculate the induced current for both of
         // them by extending the induction matrix temporarily. Otherwise we end up doing "double-counting" because we would
         // only jump "into" a pixel but never "out". At the border of the induction matrix, this would create an imbalance.
         if(last_xpixel != xpixel || last_ypixel != ypixel) {
             auto last_idx = Pixel::Index(last_xpixel, last_ypixel);
-            neighbors.merge(model_->getNeighbors(last_idx, distance_));
+            model_->getNeighbors(last_idx, distance_, neighbors);
+            std::sort(neighbors.begin(), neighbors.end());
+            neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
             LOG(TRACE) << "Carrier crossed boundary from pixel " << Pixel::Index(last_xpixel, last_ypixel) << " to pixel "
                        << Pixel::Index(xpixel, ypixel);
         }
@@ -757,9 +1091,19 @@ TransientPropagationModule::propagate(Event* event,
                    << Units::display(static_cast<ROOT::Math::XYZPoint>(position), {"um", "mm"}) << ", "
                    << Units::display(initial_time_local + runge_kutta.getTime(), "ns");
 
-        for(const auto& pixel_index : neighbors) {
-            auto ramo = detector_->getWeightingPotential(static_cast<ROOT::Math::XYZPoint>(position), pixel_index);
-            auto last_ramo = detector_->getWeightingPotential(static_cast<ROOT::Math::XYZPoint>(last_position), pixel_index);
+        detector_->getWeightingPotentials(static_cast<ROOT::Math::XYZPoint>(position),
+                                          static_cast<ROOT::Math::XYZPoint>(last_position),
+                                          neighbors,
+                                          potentials);
+        double max_potential = 0, max_potential_difference = 0;
+        // All pulses share the binning, the time bin of this step is the same for all pixels
+        auto time_bin =
+            Pulse(timestep_, pulse_fine_bins_, pulse_bin_growth_).getBin(initial_time_local + runge_kutta.getTime());
+        for(size_t n = 0; n < neighbors.size(); ++n) {
+            const auto& pixel_index = neighbors[n];
+            auto [ramo, last_ramo] = potentials[n];
+            max_potential = std::max(max_potential, std::fabs(ramo));
+            max_potential_difference = std::max(max_potential_difference, std::fabs(ramo - last_ramo));
 
             // Induced charge on electrode is q_int = q * (phi(x1) - phi(x0))
             auto induced = charge * (ramo - last_ramo) * static_cast<std::underlying_type<CarrierType>::type>(type);
@@ -772,10 +1116,14 @@ TransientPropagationModule::propagate(Event* event,
             LOG(TRACE) << "Pixel " << pixel_index << " dPhi = " << (ramo - last_ramo) << ", induced " << type
                        << " q = " << Units::display(induced, "e");
 
-            // Create pulse if it doesn't exist. Store induced charge in the returned pulse iterator
-            auto pixel_map_iterator = pixel_map.emplace(pixel_index, Pulse(timestep_, integration_time_));
+            // Create pulse if it doesn't exist. Store induced charge in the pulse of the pixel, the pulse only grows over
+            // the duration of the induced signal instead of pre-allocating the full integration time
+            auto& pulse = pixel_map[pixel_index];
+            if(!pulse.isInitialized()) {
+                pulse = Pulse(timestep_, pulse_fine_bins_, pulse_bin_growth_);
+            }
             try {
-                pixel_map_iterator.first->second.addCharge(induced, initial_time_local + runge_kutta.getTime());
+                pulse.addChargeToBin(induced, time_bin);
             } catch(const PulseBadAllocException& e) {
                 LOG(ERROR) << e.what() << std::endl
                            << "Ignoring pulse contribution at time "
@@ -818,6 +1166,22 @@ TransientPropagationModule::propagate(Event* event,
         }
         // Increase charge at the end of the step in case of impact ionization
         charge += n_secondaries;
+
+        // Stop sets moving away from all electrodes once the charge they can still induce is negligible, the induction
+        // until reaching a vanishing weighting potential is bounded by the charge times the current weighting potential
+        if(state == CarrierState::MOTION && termination_charge_ > 0 && max_potential <= last_max_potential &&
+           charge * max_potential < termination_charge_) {
+            LOG(DEBUG) << "Terminating propagation of charge carrier set at weighting potential " << max_potential;
+            terminated_sets_++;
+            break;
+        }
+        last_max_potential = max_potential;
+
+        // Coarsen the time step while the weighting potentials barely change, return to the nominal time step otherwise
+        if(coarsening_potential_ > 0) {
+            runge_kutta.setTimeStep(max_potential_difference < coarsening_potential_ ? std::min(2 * timestep, timestep_max_)
+                                                                                      : timestep_);
+        }
     }
 
     if(output_plots_ && !multiplication_.is<NoImpactIonization>()) {
@@ -845,22 +1209,30 @@ TransientPropagationModule::propagate(Event* event,
     }
 
     // Set final state of charge carrier for plotting:
-    if(output_linegraphs_) {
+    if(record_trajectories_) {
         // If drift time is larger than integration time or the charge carriers have been collected at the backside, reset:
         if(runge_kutta.getTime() >= integration_time_ || last_position.z() < -model_->getSensorSize().z() * 0.45) {
-            std::get<3>(output_plot_points.at(output_plot_index).first) = CarrierState::UNKNOWN;
+            output_plot_points.setState(output_plot_index, CarrierState::UNKNOWN);
         } else {
-            std::get<3>(output_plot_points.at(output_plot_index).first) = state;
+            output_plot_points.setState(output_plot_index, state);
         }
     }
 
+    // Move the pulses into a flat range ordered by pixel index
+    pixel_map.sort();
+    PropagatedCharge::PulseMap pulses;
+    pulses.reserve(pixel_map.size());
+    for(auto& [pixel_index, pulse] : pixel_map) {
+        pulses.emplace_back(pixel_index, std::move(pulse));
+    }
+
     // Create a new propagated charge and add it to the list
     auto local_position = static_cast<ROOT::Math::XYZPoint>(position);
     auto global_position = detector_->getGlobalPosition(local_position);
     PropagatedCharge propagated_charge(local_position,
                                        global_position,
                                        type,
-                                       std::move(pixel_map),
+                                       std::move(pulses),
                                        initial_time_local + runge_kutta.getTime(),
                                        initial_time_global + runge_kutta.getTime(),
                                        state,
@@ -885,7 +1257,7 @@ TransientPropagationModule::propagate(Event* event,
     }
 
     if(output_plots_) {
-        drift_time_histo_->Fill(static_cast<double>(Units::convert(runge_kutta.getTime(), "ns")), charge);
+        drift_time_histo_->Fill(static_cast<double>(runge_kutta.getTime() / units::ns), charge);
         group_size_histo_->Fill(initial_charge);
     }
 
@@ -893,9 +1265,258 @@ TransientPropagationModule::propagate(Event* event,
     return std::make_tuple(recombined_charges_count, trapped_charges_count, propagated_charges_count);
 }
 
+/**
+ * The induced charge is recorded for a window of the pixel matrix around the start pixels of all groups, extended by the
+ * induction matrix and one additional pixel for lateral motion. Pulses from the device combine the contributions of all
+ * groups to a pixel and are assigned to the first group which passed close enough to the pixel to induce charge in it. The
+ * other groups close to the pixel hold an empty pulse for it, such that the history of the pixel still lists all of them.
+ */
+void TransientPropagationModule::propagate_offload(
+    uint64_t seed,
+    const std::vector<std::tuple<const DepositedCharge*, CarrierType, unsigned int>>& groups,
+    std::vector<PropagatedCharge>& propagated_charges) const {
+    if(groups.empty()) {
+        return;
+    }
+
+    std::vector<DeviceTransientPropagation::Group> device_groups;
+    device_groups.reserve(groups.size());
+    std::array<int, 2> start_min = {std::numeric_limits<int>::max(), std::numeric_limits<int>::max()};
+    std::array<int, 2> start_max = {std::numeric_limits<int>::min(), std::numeric_limits<int>::min()};
+    for(const auto& [deposit, type, charge] : groups) {
+        const auto& position = deposit->getLocalPosition();
+        auto [xpixel, ypixel] = model_->getPixelIndex(position);
+        start_min = {std::min(start_min[0], xpixel), std::min(start_min[1], ypixel)};
+        start_max = {std::max(start_max[0], xpixel), std::max(start_max[1], ypixel)};
+
+        DeviceTransientPropagation::Group group;
+        group.position = {position.x(), position.y(), position.z()};
+        group.start_time = deposit->getLocalTime();
+        group.charge = charge;
+        group.sign = static_cast<int>(type);
+        group.carrier = (type == CarrierType::ELECTRON ? 0 : 1);
+        device_groups.push_back(group);
+    }
+
+    // Window of the matrix covering the induction matrices of all groups and the full integration time
+    auto matrix = model_->getNPixels();
+    auto margin = static_cast<int>(distance_) + 2;
+    DeviceTransientPropagation::Window window;
+    window.origin = {std::max(start_min[0] - margin, 0), std::max(start_min[1] - margin, 0)};
+    window.size = {std::min(start_max[0] + margin, static_cast<int>(matrix.x()) - 1) - window.origin[0] + 1,
+                   std::min(start_max[1] + margin, static_cast<int>(matrix.y()) - 1) - window.origin[1] + 1};
+    auto last_time = integration_time_ + std::max(timestep_, timestep_max_);
+    window.time_bins = static_cast<size_t>(std::lround(last_time / timestep_)) + 1;
+
+    auto pixel_pulses = device_propagation_->propagate(device_groups, window, seed);
+
+    // Assign the pulse of every pixel to the groups which passed close enough to induce charge in it
+    std::vector<PropagatedCharge::PulseMap> pulses(groups.size());
+    for(auto& pixel_pulse : pixel_pulses) {
+        auto pixel_index = Pixel::Index(pixel_pulse.index[0], pixel_pulse.index[1]);
+        Pulse pulse(timestep_);
+        pulse.addCharges(pixel_pulse.offset, pixel_pulse.values.data(), pixel_pulse.values.size());
+
+        bool assigned = false;
+        for(size_t idx = 0; idx < groups.size(); ++idx) {
+            const auto& group = device_groups[idx];
+            auto distance = static_cast<int>(distance_);
+            if(pixel_index.x() < group.pixel_min[0] - distance || pixel_index.x() > group.pixel_max[0] + distance ||
+               pixel_index.y() < group.pixel_min[1] - distance || pixel_index.y() > group.pixel_max[1] + distance) {
+                continue;
+            }
+            pulses[idx].emplace_back(pixel_index, assigned ? Pulse(timestep_) : std::move(pulse));
+            assigned = true;
+        }
+    }
+
+    for(size_t idx = 0; idx < groups.size(); ++idx) {
+        const auto& [deposit, type, charge] = groups[idx];
+        const auto& group = device_groups[idx];
+        if(group.left_window) {
+            LOG_ONCE(WARNING) << "Charge carrier groups induced charge outside of the recorded pixels or integration time, "
+                              << "the induced charge is not fully recorded";
+        }
+        if(group.terminated) {
+            terminated_sets_++;
+        }
+
+        std::sort(pulses[idx].begin(), pulses[idx].end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.first < rhs.first;
+        });
+
+        auto local_position = ROOT::Math::XYZPoint(group.position[0], group.position[1], group.position[2]);
+        auto state = (group.halted ? CarrierState::HALTED : CarrierState::MOTION);
+        PropagatedCharge propagated_charge(local_position,
+                                           detector_->getGlobalPosition(local_position),
+                                           type,
+                                           std::move(pulses[idx]),
+                                           deposit->getLocalTime() + group.time,
+                                           deposit->getGlobalTime() + group.time,
+                                           state,
+                                           deposit);
+        LOG(DEBUG) << " Propagated " << charge << " to " << Units::display(local_position, {"mm", "um"})
+                   << " in " << Units::display(group.time, "ns") << " time, final state: " << allpix::to_string(state);
+        propagated_charges.push_back(std::move(propagated_charge));
+    }
+}
+
+/**
+ * The carrier is propagated with the same Runge-Kutta integration as in the full simulation, but without diffusion. The
+ * induced charge of every step is stored per unit charge for all pixels of the induction matrix of the start pixel.
+ */
+template <typename ElectricField>
+TransientPropagationModule::PulseLibraryEntry
+TransientPropagationModule::create_library_entry(const ElectricField& electric_field,
+                                                 CarrierType type,
+                                                 const ROOT::Math::XYZPoint& start,
+                                                 const Pixel::Index& reference) const {
+    PulseLibraryEntry entry;
+    entry.induced.resize(library_offsets_.size());
+
+    std::vector<Pixel::Index> neighbors;
+    for(const auto& offset : library_offsets_) {
+        neighbors.emplace_back(reference.x() + offset.x(), reference.y() + offset.y());
+    }
+    std::vector<std::pair<double, double>> potentials;
+
+    auto carrier_velocity = [&](double, const Eigen::Vector3d& cur_pos) -> Eigen::Vector3d {
+        auto raw_field = electric_field(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+        Eigen::Vector3d efield(raw_field.x(), raw_field.y(), raw_field.z());
+        auto doping = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+        return static_cast<int>(type) * mobility_(type, efield.norm(), doping) * efield;
+    };
+
+    Eigen::Vector3d position(start.x(), start.y(), start.z());
+    auto runge_kutta = make_static_runge_kutta<tableau::StaticRK4>(carrier_velocity, timestep_, position);
+    double diffusion_integral = 0;
+    while(entry.state == CarrierState::MOTION && runge_kutta.getTime() < integration_time_) {
+        Eigen::Vector3d last_position = position;
+        auto efield_mag = std::sqrt(electric_field(static_cast<ROOT::Math::XYZPoint>(position)).Mag2());
+        auto doping = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(position));
+        diffusion_integral += boltzmann_kT_ * mobility_(type, efield_mag, doping) * timestep_;
+
+        runge_kutta.step();
+        position = runge_kutta.getValue();
+
+        // Stop at implants and sensor surfaces
+        if(auto implant = model_->findImplant(static_cast<ROOT::Math::XYZPoint>(position))) {
+            auto intercept = model_->getImplantIntercept(model_->getImplants()[implant.value()],
+                                                         static_cast<ROOT::Math::XYZPoint>(last_position),
+                                                         static_cast<ROOT::Math::XYZPoint>(position));
+            position = Eigen::Vector3d(intercept.x(), intercept.y(), intercept.z());
+            entry.state = CarrierState::HALTED;
+        }
+        if(!model_->isWithinSensor(static_cast<ROOT::Math::XYZPoint>(position))) {
+            auto intercept = model_->getSensorIntercept(static_cast<ROOT::Math::XYZPoint>(last_position),
+                                                        static_cast<ROOT::Math::XYZPoint>(position));
+            position = Eigen::Vector3d(intercept.x(), intercept.y(), intercept.z());
+            entry.state = CarrierState::HALTED;
+        }
+
+        detector_->getWeightingPotentials(static_cast<ROOT::Math::XYZPoint>(position),
+                                          static_cast<ROOT::Math::XYZPoint>(last_position),
+                                          neighbors,
+                                          potentials);
+        for(size_t n = 0; n < neighbors.size(); ++n) {
+            auto [ramo, last_ramo] = potentials[n];
+            entry.induced[n].push_back((ramo - last_ramo) * static_cast<std::underlying_type<CarrierType>::type>(type));
+        }
+    }
+
+    entry.drift_time = runge_kutta.getTime();
+    entry.diffusion_constant = diffusion_integral / std::max(entry.drift_time, timestep_);
+    entry.displacement = ROOT::Math::XYZVector(position.x() - start.x(), position.y() - start.y(), position.z() - start.z());
+    return entry;
+}
+
+/**
+ * The library entry is chosen between the closest grid points along every axis with probabilities given by the weights of a
+ * linear interpolation. Diffusion is added statistically by smearing the start position with the diffusion accumulated
+ * along the drift path of the unsmeared position, and the pulses are shifted to the time of the deposit.
+ */
+void TransientPropagationModule::synthesize(Event* event,
+                                            const DepositedCharge& deposit,
+                                            CarrierType type,
+                                            unsigned int charge,
+                                            std::vector<PropagatedCharge>& propagated_charges) const {
+    const auto& library = (type == CarrierType::ELECTRON ? electron_library_ : hole_library_);
+    auto pitch = model_->getPixelSize();
+    auto thickness = model_->getSensorSize().z();
+    auto sensor_min_z = model_->getSensorCenter().z() - thickness / 2;
+
+    allpix::uniform_real_distribution<double> uniform_distribution(0, 1);
+    auto select_bin = [&](double fraction, size_t bins) {
+        auto coordinate = std::clamp(fraction * static_cast<double>(bins) - 0.5, 0., static_cast<double>(bins - 1));
+        auto lower = static_cast<size_t>(coordinate);
+        auto upper = std::min(lower + 1, bins - 1);
+        return (uniform_distribution(event->getRandomEngine()) < coordinate - static_cast<double>(lower) ? upper : lower);
+    };
+    auto find_entry = [&](const ROOT::Math::XYZPoint& position, Pixel::Index& pixel) -> const PulseLibraryEntry& {
+        auto [xpixel, ypixel] = model_->getPixelIndex(position);
+        pixel = Pixel::Index(xpixel, ypixel);
+        auto center = model_->getPixelCenter(xpixel, ypixel);
+        auto x = select_bin((position.x() - center.x()) / pitch.x() + 0.5, library_bins_[0]);
+        auto y = select_bin((position.y() - center.y()) / pitch.y() + 0.5, library_bins_[1]);
+        auto z = select_bin((position.z() - sensor_min_z) / thickness, library_bins_[2]);
+        return library[(x * library_bins_[1] + y) * library_bins_[2] + z];
+    };
+
+    // Smear the start position with the diffusion along the drift path of the unsmeared position
+    Pixel::Index pixel;
+    auto start = deposit.getLocalPosition();
+    const auto& unsmeared = find_entry(start, pixel);
+    allpix::normal_distribution<double> gauss_distribution(
+        0, std::sqrt(2. * unsmeared.diffusion_constant * unsmeared.drift_time));
+    auto smeared_z = start.z() + gauss_distribution(event->getRandomEngine());
+    start.SetXYZ(start.x() + gauss_distribution(event->getRandomEngine()),
+                 start.y() + gauss_distribution(event->getRandomEngine()),
+                 std::clamp(smeared_z, sensor_min_z, sensor_min_z + thickness));
+    const auto& entry = find_entry(start, pixel);
+
+    // Only steps started within the integration time are taken into account, as in the full simulation
+    auto remaining_steps = std::ceil((integration_time_ - deposit.getLocalTime()) / timestep_);
+    auto steps = std::min(entry.induced.front().size(), static_cast<size_t>(std::max(remaining_steps, 0.)));
+    auto drift_time = std::min(entry.drift_time, static_cast<double>(steps) * timestep_);
+    auto state = (steps < entry.induced.front().size() ? CarrierState::MOTION : entry.state);
+
+    PropagatedCharge::PulseMap pulses;
+    pulses.reserve(library_offsets_.size());
+    for(size_t n = 0; n < library_offsets_.size(); ++n) {
+        auto pixel_index = Pixel::Index(pixel.x() + library_offsets_[n].x(), pixel.y() + library_offsets_[n].y());
+        if(!model_->isWithinMatrix(pixel_index)) {
+            continue;
+        }
+
+        // Induced charge of a step is added at the end time of the step as in the full simulation
+        Pulse pulse(timestep_);
+        pulse.addCharges(
+            pulse.getBin(deposit.getLocalTime() + timestep_), entry.induced[n].data(), steps, static_cast<double>(charge));
+        pulses.emplace_back(pixel_index, std::move(pulse));
+    }
+
+    auto local_position = start + entry.displacement;
+    PropagatedCharge propagated_charge(local_position,
+                                       detector_->getGlobalPosition(local_position),
+                                       type,
+                                       std::move(pulses),
+                                       deposit.getLocalTime() + drift_time,
+                                       deposit.getGlobalTime() + drift_time,
+                                       state,
+                                       &deposit);
+    LOG(DEBUG) << " Synthesized " << charge << " charges to " << Units::display(local_position, {"mm", "um"}) << " in "
+               << Units::display(drift_time, "ns") << " time, induced "
+               << Units::display(propagated_charge.getCharge(), {"e"});
+    propagated_charges.push_back(std::move(propagated_charge));
+}
+
 void TransientPropagationModule::finalize() {
     LOG(INFO) << deposits_exceeding_max_groups_ * 100.0 / total_deposits_ << "% of deposits have charge exceeding the "
               << max_charge_groups_ << " charge groups allowed, with a charge_per_step value of " << charge_per_step_ << ".";
+    if(termination_charge_ > 0) {
+        LOG(INFO) << "Terminated propagation of " << terminated_sets_
+                  << " charge carrier sets early, inducing less than " << Units::display(termination_charge_, "e");
+    }
     if(output_plots_) {
         group_size_histo_->Get()->GetXaxis()->SetRange(1, group_size_histo_->Get()->GetNbinsX() + 1);
 
@@ -938,4 +1559,9 @@ void TransientPropagationModule::finalize() {
             gain_h_vs_z_->Write();
         }
     }
+
+    if(output_trajectories_) {
+        auto events = trajectory_writer_->write();
+        LOG(INFO) << "Wrote charge carrier trajectories of " << events << " events";
+    }
 }
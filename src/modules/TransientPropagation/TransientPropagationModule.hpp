@@ -9,7 +9,10 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <array>
 #include <string>
+#include <tuple>
+#include <vector>
 
 #include <Math/DisplacementVector2D.h>
 #include <Math/Point3D.h>
@@ -35,6 +38,8 @@
 #include "tools/ROOT.h"
 #include "tools/line_graphs.h"
 
+#include "DeviceTransientPropagation.hpp"
+
 namespace allpix {
     /**
      * @ingroup Modules
@@ -89,9 +94,11 @@ namespace allpix {
          * @param level               Current level depth of the generated shower
          * @param propagated_charges  Reference to vector with all produced final PropagatedCharge objects
          * @param output_plot_points Reference to vector to hold points for line graph output plots
+         * @param electric_field      Accessor to the electric field of the detector
          *
          * @return Total recombined, trapped and propagated charge for statistics purposes
          */
+        template <typename ElectricField>
         std::tuple<unsigned int, unsigned int, unsigned int>
         propagate(Event* event,
                   const DepositedCharge& deposit,
@@ -102,15 +109,84 @@ namespace allpix {
                   const double initial_time_global,
                   const unsigned int level,
                   std::vector<PropagatedCharge>& propagated_charges,
-                  LineGraph::OutputPlotPoints& output_plot_points) const;
+                  LineGraph::OutputPlotPoints& output_plot_points,
+                  const ElectricField& electric_field) const;
+
+        /**
+         * @brief Induced charge of a single charge carrier started at one point of the pulse library grid
+         */
+        struct PulseLibraryEntry {
+            std::vector<std::vector<double>> induced; ///< Induced charge per time step for every pixel of the library
+            ROOT::Math::XYZVector displacement;       ///< Displacement from the start to the end position of the drift
+            double drift_time{};                      ///< Time until the end of the drift
+            double diffusion_constant{};              ///< Time-averaged diffusion constant along the drift path
+            CarrierState state{CarrierState::MOTION}; ///< Final state of the drift
+        };
+
+        /**
+         * @brief Propagate a single charge carrier without diffusion to obtain its induced charge for the pulse library
+         * @param electric_field Accessor to the electric field of the detector
+         * @param type           Type of the carrier to propagate
+         * @param start          Start position of the carrier
+         * @param reference      Index of the pixel the start position is located in
+         * @return Library entry for this start position
+         */
+        template <typename ElectricField>
+        PulseLibraryEntry create_library_entry(const ElectricField& electric_field,
+                                               CarrierType type,
+                                               const ROOT::Math::XYZPoint& start,
+                                               const Pixel::Index& reference) const;
+
+        /**
+         * @brief Synthesize the pulses of a set of charges from the pulse library
+         * @param event              Pointer to current event
+         * @param deposit            Reference to the original deposited charge object
+         * @param type               Type of the charge carriers
+         * @param charge             Total charge of the observed charge carrier set
+         * @param propagated_charges Reference to vector with all produced final PropagatedCharge objects
+         */
+        void synthesize(Event* event,
+                        const DepositedCharge& deposit,
+                        CarrierType type,
+                        unsigned int charge,
+                        std::vector<PropagatedCharge>& propagated_charges) const;
+
+        /**
+         * @brief Check if the propagation can be offloaded and transfer the tabulated carrier velocities and weighting
+         * potential to the device
+         */
+        void initialize_offload();
+
+        /**
+         * @brief Propagate all charge carrier groups of an event on the offload device
+         * @param seed               Seed of the random number streams of the groups
+         * @param groups             Deposit, carrier type and charge of each of the carrier groups
+         * @param propagated_charges Reference to vector with all produced final PropagatedCharge objects
+         */
+        void propagate_offload(uint64_t seed,
+                               const std::vector<std::tuple<const DepositedCharge*, CarrierType, unsigned int>>& groups,
+                               std::vector<PropagatedCharge>& propagated_charges) const;
+
+        // Pulse library with its grid in the pixel cell and the pixels of the induction matrix relative to the start pixel
+        bool pulse_library_{};
+        std::array<size_t, 3> library_bins_{};
+        std::vector<Pixel::Index> library_offsets_;
+        std::vector<PulseLibraryEntry> electron_library_, hole_library_;
 
         // Local copies of configuration parameters to avoid costly lookup:
         double temperature_{}, timestep_{}, integration_time_{}, output_plots_step_{};
+        double timestep_max_{}, coarsening_potential_{}, termination_charge_{};
+        size_t pulse_fine_bins_{};
+        double pulse_bin_growth_{};
         bool output_plots_{}, output_linegraphs_{}, output_linegraphs_collected_{}, output_linegraphs_recombined_{},
-            output_linegraphs_trapped_{};
+            output_linegraphs_trapped_{}, output_animations_{}, output_trajectories_{}, record_trajectories_{};
+        LineGraph::PlotSettings plot_settings_;
         unsigned int distance_{};
         unsigned int charge_per_step_{};
         unsigned int max_charge_groups_{};
+        bool sample_carrier_lifetimes_{};
+        bool prefetch_fields_{};
+        bool offload_propagation_{};
 
         unsigned int max_multiplication_level_{};
 
@@ -131,8 +207,18 @@ namespace allpix {
         // Magnetic field
         bool has_magnetic_field_{};
 
+        // Propagation on the offload device if requested and supported
+        std::unique_ptr<DeviceTransientPropagation> device_propagation_;
+
+        // Writer of the recorded trajectories if requested
+        std::unique_ptr<LineGraph::TrajectoryWriter> trajectory_writer_;
+
         // Deposit statistics
         std::atomic<unsigned int> total_deposits_{}, deposits_exceeding_max_groups_{};
+        mutable std::atomic<unsigned int> terminated_sets_{};
+
+        // Indices of the profiler counters and timers
+        size_t groups_counter_{}, recombined_counter_{}, trapped_counter_{}, propagation_timer_{};
 
         // Output plots
         Histogram<TH1D> potential_difference_, induced_charge_histo_, induced_charge_e_histo_, induced_charge_h_histo_;
@@ -15,6 +15,7 @@
 #include <csignal>
 #include <cstdlib>
 #include <cstring>
+#include <map>
 #include <memory>
 #include <string>
 #include <thread>
@@ -431,6 +432,9 @@ static void interrupt_handler(int signal) {
 void VisualizationGeant4Module::add_visualization_volumes() {
     // Only place the pixel matrix for the visualization if we have no simple view
     if(!config_.get<bool>("simple_view")) {
+        // Pixel matrices already placed, sensor volumes can be shared by detectors of the same model
+        std::map<const G4LogicalVolume*, std::shared_ptr<G4PVParameterised>> placed_matrices;
+
         // Loop through detectors
         for(auto& detector : geo_manager_->getDetectors()) {
             auto sensor_log = geo_manager_->getExternalObject<G4LogicalVolume>(detector->getName(), "sensor_log");
@@ -442,6 +446,13 @@ void VisualizationGeant4Module::add_visualization_volumes() {
                 continue;
             }
 
+            // Reuse the pixel matrix if the sensor volume is shared with another detector
+            auto placed_matrix = placed_matrices.find(sensor_log.get());
+            if(placed_matrix != placed_matrices.end()) {
+                geo_manager_->setExternalObject(detector->getName(), "pixel_param_phys", placed_matrix->second);
+                continue;
+            }
+
             // Place the pixels if all objects are available
             std::shared_ptr<G4PVParameterised> pixel_param_phys = std::make_shared<G4PVParameterised>(
                 "pixel_" + detector->getName() + "_param",
@@ -452,6 +463,7 @@ void VisualizationGeant4Module::add_visualization_volumes() {
                 pixel_param.get(),
                 false);
             geo_manager_->setExternalObject(detector->getName(), "pixel_param_phys", pixel_param_phys);
+            placed_matrices.emplace(sensor_log.get(), std::move(pixel_param_phys));
         }
     }
 }
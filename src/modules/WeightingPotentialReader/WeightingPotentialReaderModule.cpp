@@ -11,6 +11,8 @@
 
 #include "WeightingPotentialReaderModule.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include <fstream>
 #include <limits>
@@ -19,7 +21,9 @@
 #include <stdexcept>
 #include <string>
 #include <utility>
+#include <vector>
 
+#include <Math/Point3D.h>
 #include <TH2F.h>
 
 #include "core/config/exceptions.h"
@@ -35,6 +39,11 @@ WeightingPotentialReaderModule::WeightingPotentialReaderModule(Configuration& co
     : Module(config, detector), detector_(std::move(detector)) {
     // Enable multithreading of this module if multithreading is enabled
     allow_multithreading();
+
+    // Initialization only modifies this detector and can run in parallel to other detectors unless plots are booked
+    if(!config_.get<bool>("output_plots", false)) {
+        allow_parallel_initialization();
+    }
 }
 
 void WeightingPotentialReaderModule::initialize() {
@@ -74,14 +83,32 @@ void WeightingPotentialReaderModule::initialize() {
             field_scale = {{scales.x(), scales.y()}};
         }
 
+        // Storage precision of the field grid, reduced precision lowers the memory footprint of the field lookup
+        auto precision = config_.get<FieldPrecision>("field_precision", FieldPrecision::DOUBLE);
+        // Interpolation between the grid points, allows using coarser field grids
+        auto interpolation = config_.get<FieldInterpolation>("interpolation", FieldInterpolation::NEAREST);
+        LOG(DEBUG) << "Field values are interpolated with " << magic_enum::enum_name(interpolation) << " interpolation";
+        // Memory layout of the field grid, bricks keep cells neighboring along all axes close in memory
+        auto layout = config_.get<FieldLayout>("field_layout", FieldLayout::ROW_MAJOR);
+        LOG(DEBUG) << "Field values are stored in " << magic_enum::enum_name(layout) << " layout";
+
         // Set the field grid, provide scale factors as fraction of the pixel pitch for correct scaling:
-        detector_->setWeightingPotentialGrid(field_data.getData(),
-                                             field_data.getDimensions(),
-                                             field_data.getSize(),
-                                             field_mapping,
-                                             field_scale,
-                                             {0.0, 0.0},
-                                             thickness_domain);
+        auto summary = detector_->setWeightingPotentialGrid(field_data.getValues(),
+                                                            field_data.getDimensions(),
+                                                            field_data.getSize(),
+                                                            field_mapping,
+                                                            field_scale,
+                                                            {0.0, 0.0},
+                                                            thickness_domain,
+                                                            precision,
+                                                            interpolation,
+                                                            field_data.getRefinement(),
+                                                            layout);
+        if(precision != FieldPrecision::DOUBLE) {
+            LOG(INFO) << "Weighting potential stored with " << magic_enum::enum_name(precision) << " precision, saving "
+                      << static_cast<double>(summary.memory_saved) / (1024. * 1024.) << " MiB with a maximum deviation of "
+                      << summary.max_deviation;
+        }
     } else if(field_model == WeightingPotential::PAD) {
         LOG(TRACE) << "Adding weighting potential from pad in plane condenser";
 
@@ -100,7 +127,11 @@ void WeightingPotentialReaderModule::initialize() {
         }
 
         auto function = get_pad_potential_function({implant.x(), implant.y()}, thickness_domain);
-        detector_->setWeightingPotentialFunction(function, thickness_domain, FieldType::CUSTOM);
+        if(config_.get<bool>("tabulate", false)) {
+            tabulate_potential(function, thickness_domain);
+        } else {
+            detector_->setWeightingPotentialFunction(function, thickness_domain, FieldType::CUSTOM);
+        }
     }
 
     // Produce histograms if needed
@@ -150,6 +181,123 @@ WeightingPotentialReaderModule::get_pad_potential_function(const ROOT::Math::XYV
     };
 }
 
+/**
+ * The potential of the pad is symmetric in x and y and is therefore tabulated for a single quadrant with trilinear
+ * interpolation. The lateral extent of the table is extended in steps of half a pixel pitch until the potential drops below
+ * the requested precision. The number of bins is doubled separately for each axis until the interpolation error, estimated
+ * between neighboring grid points along a set of sample lines, is below the requested precision. The estimate excludes a
+ * thin layer below the electrode, where the potential changes abruptly at the implant edges.
+ */
+void WeightingPotentialReaderModule::tabulate_potential(const FieldFunction<double>& function,
+                                                        std::pair<double, double> thickness_domain) {
+    auto precision = config_.get<double>("tabulation_precision", 1e-3);
+    if(precision <= 0) {
+        throw InvalidValueError(config_, "tabulation_precision", "precision has to be positive");
+    }
+
+    const size_t max_bins = 256;
+    const size_t max_extent = 20;
+    const size_t samples = 8;
+
+    auto model = detector_->getModel();
+    auto depth = thickness_domain.second - thickness_domain.first;
+
+    // Evaluate the potential at a position in the quadrant, with the z coordinate relative to the thickness domain start:
+    auto potential = [&](const std::array<double, 3>& pos) {
+        return function(ROOT::Math::XYZPoint(pos[0], pos[1], thickness_domain.first + pos[2]));
+    };
+
+    // Determine the lateral extent of the table in multiples of half the pixel pitch
+    std::array<double, 3> size{{0., 0., depth}};
+    for(size_t axis = 0; axis < 2; ++axis) {
+        auto half_pitch = (axis == 0 ? model->getPixelSize().x() : model->getPixelSize().y()) / 2;
+        size_t extent = 1;
+        for(; extent < max_extent; ++extent) {
+            double maximum = 0;
+            for(size_t s = 0; s < 2 * samples; ++s) {
+                std::array<double, 3> pos{{0., 0., (static_cast<double>(s) + 0.5) / (2 * samples) * depth}};
+                pos[axis] = static_cast<double>(extent) * half_pitch;
+                maximum = std::max(maximum, std::fabs(potential(pos)));
+            }
+            if(maximum < precision) {
+                break;
+            }
+        }
+        size[axis] = static_cast<double>(extent) * half_pitch;
+    }
+
+    // Refine the binning along each axis until the estimated interpolation error is below the precision
+    std::array<size_t, 3> bins{{4, 4, 4}};
+    double max_error = 0;
+    for(size_t axis = 0; axis < 3; ++axis) {
+        auto other1 = (axis + 1) % 3;
+        auto other2 = (axis + 2) % 3;
+        while(true) {
+            auto width = size[axis] / static_cast<double>(bins[axis]);
+            double error = 0;
+            for(size_t s1 = 0; s1 < samples; ++s1) {
+                for(size_t s2 = 0; s2 < samples; ++s2) {
+                    std::array<double, 3> pos{};
+                    pos[other1] = (static_cast<double>(s1) + 0.5) / samples * size[other1];
+                    pos[other2] = (static_cast<double>(s2) + 0.5) / samples * size[other2];
+
+                    // Compare the potential between two grid points to the linear interpolation of their values
+                    pos[axis] = 0.5 * width;
+                    auto previous = potential(pos);
+                    for(size_t i = 1; i < bins[axis]; ++i) {
+                        if(axis == 2 && static_cast<double>(i) * width > (1. - 0.5 / samples) * depth) {
+                            break;
+                        }
+                        pos[axis] = (static_cast<double>(i) + 0.5) * width;
+                        auto current = potential(pos);
+                        pos[axis] = static_cast<double>(i) * width;
+                        error = std::max(error, std::fabs(potential(pos) - 0.5 * (previous + current)));
+                        previous = current;
+                    }
+                }
+            }
+            LOG(TRACE) << "Estimated interpolation error with " << bins[axis] << " bins along axis " << axis << ": "
+                       << error;
+            if(error < precision / 3 || bins[axis] >= max_bins) {
+                max_error += error;
+                break;
+            }
+            bins[axis] *= 2;
+        }
+    }
+    if(max_error > precision) {
+        LOG(WARNING) << "Tabulated pad weighting potential does not reach requested precision of " << precision
+                     << ", estimated interpolation error is " << max_error;
+    }
+
+    // Sample the potential at the grid cell centers
+    auto table = std::make_shared<std::vector<double>>(bins[0] * bins[1] * bins[2]);
+    for(size_t x = 0; x < bins[0]; ++x) {
+        for(size_t y = 0; y < bins[1]; ++y) {
+            for(size_t z = 0; z < bins[2]; ++z) {
+                std::array<double, 3> pos{{(static_cast<double>(x) + 0.5) / static_cast<double>(bins[0]) * size[0],
+                                           (static_cast<double>(y) + 0.5) / static_cast<double>(bins[1]) * size[1],
+                                           (static_cast<double>(z) + 0.5) / static_cast<double>(bins[2]) * size[2]}};
+                (*table)[x * bins[1] * bins[2] + y * bins[2] + z] = potential(pos);
+            }
+        }
+    }
+
+    LOG(INFO) << "Tabulated pad weighting potential with " << bins[0] << "x" << bins[1] << "x" << bins[2]
+              << " bins covering " << Units::display(ROOT::Math::XYVector(size[0], size[1]), {"um", "mm"})
+              << " around the electrode, estimated interpolation error " << max_error;
+    auto* values = table->data();
+    detector_->setWeightingPotentialGrid(std::shared_ptr<const double>(std::move(table), values),
+                                         bins,
+                                         size,
+                                         FieldMapping::PIXEL_QUADRANT_I,
+                                         {{1.0, 1.0}},
+                                         {{0.0, 0.0}},
+                                         thickness_domain,
+                                         FieldPrecision::DOUBLE,
+                                         FieldInterpolation::TRILINEAR);
+}
+
 void WeightingPotentialReaderModule::create_output_plots() {
     LOG(TRACE) << "Creating output plots";
 
@@ -273,11 +421,32 @@ FieldData<double> WeightingPotentialReaderModule::read_field() {
     try {
         LOG(TRACE) << "Fetching weighting potential from init file";
 
+        // Sub-volume of the field file to read, in the coordinates of the file, and averaging of blocks of cells
+        FieldSubset subset;
+        auto crop_min = config_.get<ROOT::Math::XYZPoint>("field_crop_min", ROOT::Math::XYZPoint());
+        subset.region_min = {{crop_min.x(), crop_min.y(), crop_min.z()}};
+        if(config_.has("field_crop_max")) {
+            auto crop_max = config_.get<ROOT::Math::XYZPoint>("field_crop_max");
+            subset.region_max = {{crop_max.x(), crop_max.y(), crop_max.z()}};
+        }
+        for(size_t i = 0; i < 3; ++i) {
+            if(subset.region_min.at(i) < 0 || subset.region_min.at(i) >= subset.region_max.at(i)) {
+                throw InvalidValueError(config_, "field_crop_max", "field region has to be positive and non-empty");
+            }
+        }
+        auto downsampling = config_.getArray<size_t>("field_downsampling", {1, 1, 1});
+        if(downsampling.size() != 3 || std::find(downsampling.begin(), downsampling.end(), 0) != downsampling.end()) {
+            throw InvalidValueError(config_, "field_downsampling", "expecting three positive downsampling factors");
+        }
+        std::copy(downsampling.begin(), downsampling.end(), subset.downsampling.begin());
+
         // Get field from file
-        auto field_data = field_parser_.getByFileName(config_.getPath("file_name", true));
+        auto field_data = field_parser_.getByFileName(
+            config_.getPath("file_name", true), std::string(), config_.get<bool>("cache_init_file", false), subset);
 
         // Check maximum/minimum values of the potential:
-        auto elements = std::minmax_element(field_data.getData()->begin(), field_data.getData()->end());
+        const auto* values = field_data.getValues().get();
+        auto elements = std::minmax_element(values, values + field_data.getNumberOfValues());
         if(*elements.first < 0 || *elements.second > 1) {
             throw InvalidValueError(config_,
                                     "file_name",
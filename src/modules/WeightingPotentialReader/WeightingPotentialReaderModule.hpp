@@ -60,6 +60,13 @@ namespace allpix {
         FieldFunction<double> get_pad_potential_function(const ROOT::Math::XYVector& implant,
                                                          std::pair<double, double> thickness_domain);
 
+        /**
+         * @brief Tabulate a weighting potential function on a grid and apply it to the detector
+         * @param function Function of the weighting potential, symmetric in x and y around the electrode
+         * @param thickness_domain Domain of the thickness where the field is defined
+         */
+        void tabulate_potential(const FieldFunction<double>& function, std::pair<double, double> thickness_domain);
+
         /**
          * @brief Read field from a file in init or apf format
          * @return Data of the field read from file
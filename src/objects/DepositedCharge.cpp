@@ -21,11 +21,22 @@ DepositedCharge::DepositedCharge(ROOT::Math::XYZPoint local_position,
                                  unsigned int charge,
                                  double local_time,
                                  double global_time,
-                                 const MCParticle* mc_particle)
-    : SensorCharge(std::move(local_position), std::move(global_position), type, charge, local_time, global_time) {
+                                 const MCParticle* mc_particle,
+                                 bool paired)
+    : SensorCharge(std::move(local_position),
+                   std::move(global_position),
+                   (paired ? CarrierType::ELECTRON : type),
+                   charge,
+                   local_time,
+                   global_time),
+      paired_(paired) {
     setMCParticle(mc_particle);
 }
 
+bool DepositedCharge::isPaired() const { return paired_; }
+
+bool DepositedCharge::hasCarrier(CarrierType type) const { return paired_ || getType() == type; }
+
 /**
  * @throws MissingReferenceException If the pointed object is not in scope
  *
@@ -46,7 +57,23 @@ void DepositedCharge::setMCParticle(const MCParticle* mc_particle) {
 void DepositedCharge::print(std::ostream& out) const {
     out << "--- Deposited charge information\n";
     SensorCharge::print(out);
+    if(paired_) {
+        out << "Deposit of electron-hole pairs\n";
+    }
 }
 
 void DepositedCharge::loadHistory() { mc_particle_.get(); }
 void DepositedCharge::petrifyHistory() { mc_particle_.store(); }
+
+std::vector<std::pair<const DepositedCharge*, CarrierType>>
+allpix::expandCarriers(const std::vector<DepositedCharge>& deposits) {
+    std::vector<std::pair<const DepositedCharge*, CarrierType>> carriers;
+    carriers.reserve(deposits.size());
+    for(const auto& deposit : deposits) {
+        carriers.emplace_back(&deposit, deposit.getType());
+        if(deposit.isPaired()) {
+            carriers.emplace_back(&deposit, CarrierType::HOLE);
+        }
+    }
+    return carriers;
+}
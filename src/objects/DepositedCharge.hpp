@@ -12,6 +12,9 @@
 #ifndef ALLPIX_DEPOSITED_CHARGE_H
 #define ALLPIX_DEPOSITED_CHARGE_H
 
+#include <utility>
+#include <vector>
+
 #include <TRef.h>
 
 #include "MCParticle.hpp"
@@ -21,6 +24,10 @@ namespace allpix {
     /**
      * @ingroup Objects
      * @brief Charge deposit in sensor of detector
+     *
+     * A deposit either holds charge carriers of a single type, or electron-hole pairs, i.e. the given charge of both
+     * electrons and holes at the same position and time. The latter halves the number of deposits created by ionization,
+     * their type is reported as electrons and modules processing the carriers expand them with \ref expandCarriers.
      */
     class DepositedCharge : public SensorCharge {
         friend class PropagatedCharge;
@@ -35,6 +42,7 @@ namespace allpix {
          * @param local_time Time of propagation arrival after energy deposition, local reference frame
          * @param global_time Total time of propagation arrival after event start, global reference frame
          * @param mc_particle Optional pointer to related MC particle
+         * @param paired If the deposit holds electron-hole pairs, the given type is ignored then
          */
         DepositedCharge(ROOT::Math::XYZPoint local_position,
                         ROOT::Math::XYZPoint global_position,
@@ -42,7 +50,21 @@ namespace allpix {
                         unsigned int charge,
                         double local_time,
                         double global_time,
-                        const MCParticle* mc_particle = nullptr);
+                        const MCParticle* mc_particle = nullptr,
+                        bool paired = false);
+
+        /**
+         * @brief Check if the deposit holds electron-hole pairs
+         * @return True if the deposit holds its charge for both carrier types, false for a single carrier type
+         */
+        bool isPaired() const;
+
+        /**
+         * @brief Check if the deposit holds charge carriers of a given type
+         * @param type Type of the carrier
+         * @return True if the deposit holds electron-hole pairs or carriers of the given type
+         */
+        bool hasCarrier(CarrierType type) const;
 
         /**
          * @brief Get related Monte-Carlo particle
@@ -66,7 +88,7 @@ namespace allpix {
         /**
          * @brief ROOT class definition
          */
-        ClassDefOverride(DepositedCharge, 4); // NOLINT
+        ClassDefOverride(DepositedCharge, 5); // NOLINT
         /**
          * @brief Default constructor for ROOT I/O
          */
@@ -77,8 +99,18 @@ namespace allpix {
 
     private:
         PointerWrapper<MCParticle> mc_particle_;
+        bool paired_{};
     };
 
+    /**
+     * @brief Expand deposits into the sets of charge carriers of every type they hold
+     * @param deposits Deposited charges
+     * @return Every deposit with the type of its carriers, deposits of electron-hole pairs are listed once for their
+     *         electrons followed by once for their holes
+     */
+    std::vector<std::pair<const DepositedCharge*, CarrierType>>
+    expandCarriers(const std::vector<DepositedCharge>& deposits);
+
     /**
      * @brief Typedef for message carrying deposits
      */
@@ -45,6 +45,8 @@
 
 #pragma link C++ class allpix::Pulse + ;
 #pragma link C++ class allpix::Pixel + ;
+#pragma link C++ class std::pair < allpix::Pixel::Index, allpix::Pulse> + ;
+#pragma link C++ class std::vector < std::pair < allpix::Pixel::Index, allpix::Pulse>> + ;
 
 #pragma link C++ class allpix::PropagatedCharge + ;
 #pragma link C++ class allpix::Object::PointerWrapper < allpix::PropagatedCharge> + ;
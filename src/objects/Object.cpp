@@ -13,6 +13,17 @@
 
 using namespace allpix;
 
+namespace {
+    std::atomic<Object::HistoryDepth>& history_depth() {
+        static std::atomic<Object::HistoryDepth> depth{Object::HistoryDepth::FULL};
+        return depth;
+    }
+} // namespace
+
+void Object::setHistoryDepth(HistoryDepth depth) { history_depth().store(depth, std::memory_order_relaxed); }
+
+Object::HistoryDepth Object::getHistoryDepth() { return history_depth().load(std::memory_order_relaxed); }
+
 std::ostream& allpix::operator<<(std::ostream& out, const Object& obj) {
     obj.print(out);
     return out;
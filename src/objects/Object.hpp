@@ -35,6 +35,28 @@ namespace allpix {
     public:
         friend std::ostream& operator<<(std::ostream& out, const allpix::Object& obj);
 
+        /**
+         * @brief Depth of the history recorded when objects are created
+         */
+        enum class HistoryDepth {
+            FULL,        ///< References to all objects an object was created from
+            MCPARTICLES, ///< References to Monte Carlo particles, but not to the propagated charges of pixel charges
+            NONE,        ///< No references of pixel objects to Monte Carlo particles or propagated charges
+        };
+
+        /**
+         * @brief Set the depth of the history recorded by all objects created afterwards
+         * @param depth Depth of the history
+         * @warning Should only be changed before the event loop starts
+         */
+        static void setHistoryDepth(HistoryDepth depth);
+
+        /**
+         * @brief Get the depth of the history recorded when creating objects
+         * @return Depth of the history
+         */
+        static HistoryDepth getHistoryDepth();
+
         /**
          * @brief Required default constructor
          */
@@ -174,7 +196,7 @@ namespace allpix {
              * @brief Constructor with object pointer to be wrapped
              * @param obj Pointer to object
              */
-            explicit PointerWrapper(const T* obj) : BaseWrapper<T>(obj), loaded_(true) {} // NOLINT
+            explicit PointerWrapper(const T* obj) : BaseWrapper<T>(obj), direct_(true), loaded_(true) {} // NOLINT
 
             /**
              * @brief Required virtual destructor
@@ -184,13 +206,15 @@ namespace allpix {
             /**
              * @brief Explicit copy constructor to avoid copying std::once_flag
              */
-            PointerWrapper(const PointerWrapper& rhs) : BaseWrapper<T>(rhs), loaded_(rhs.loaded_.load()){};
+            PointerWrapper(const PointerWrapper& rhs)
+                : BaseWrapper<T>(rhs), direct_(rhs.direct_), loaded_(rhs.loaded_.load()){};
 
             /**
              * @brief Explicit copy assignment operator to avoid copying std::once_flag
              */
             PointerWrapper& operator=(const PointerWrapper& rhs) {
                 BaseWrapper<T>::operator=(rhs);
+                direct_ = rhs.direct_;
                 loaded_ = rhs.loaded_.load();
                 return *this;
             };
@@ -198,13 +222,15 @@ namespace allpix {
             /**
              * @brief Explicit move constructor to avoid copying std::once_flag
              */
-            PointerWrapper(PointerWrapper&& rhs) noexcept : BaseWrapper<T>(std::move(rhs)), loaded_(rhs.loaded_.load()){};
+            PointerWrapper(PointerWrapper&& rhs) noexcept
+                : BaseWrapper<T>(std::move(rhs)), direct_(rhs.direct_), loaded_(rhs.loaded_.load()){};
 
             /**
              * @brief Explicit move assignment to avoid copying std::once_flag
              */
             PointerWrapper& operator=(PointerWrapper&& rhs) noexcept {
                 BaseWrapper<T>::operator=(std::move(rhs));
+                direct_ = rhs.direct_;
                 loaded_ = rhs.loaded_.load();
                 return *this;
             };
@@ -212,13 +238,20 @@ namespace allpix {
             /**
              * @brief Implementation of base class lazy loading mechanism with thread-safe call_once
              * @return Pointer to object
+             *
+             * Wrappers constructed from a pointer, as done for all objects created in the framework, never load from the
+             * TRef and return the pointer without any synchronization.
              */
             T* get() const override {
+                if(direct_) {
+                    return this->ptr_;
+                }
+
                 // Lazy loading of pointer from TRef
-                if(!this->loaded_) {
+                if(!this->loaded_.load(std::memory_order_acquire)) {
                     std::call_once(load_flag_, [&]() {
                         this->ptr_ = static_cast<T*>(this->ref_.GetObject());
-                        this->loaded_ = true;
+                        this->loaded_.store(true, std::memory_order_release);
                     });
                 }
                 return this->ptr_;
@@ -227,6 +260,7 @@ namespace allpix {
             ClassDefOverride(PointerWrapper, 1); // NOLINT
 
         private:
+            bool direct_{false};                     //! transient value
             mutable std::once_flag load_flag_;       //! transient value
             mutable std::atomic_bool loaded_{false}; //! transient value
         };
@@ -29,10 +29,24 @@ Pixel::Pixel(Pixel::Index index,
     : index_(std::move(index)), type_(type), local_center_(std::move(local_center)),
       global_center_(std::move(global_center)), size_(std::move(size)) {}
 
+Pixel::Pixel(Pixel::Index index, Pixel::Type type, ROOT::Math::XYVector size, const Pixel::Geometry* geometry)
+    : index_(std::move(index)), type_(type), size_(std::move(size)), geometry_(geometry) {}
+
 Pixel::Index Pixel::getIndex() const { return index_; }
 
 Pixel::Type Pixel::getType() const { return type_; }
 
-ROOT::Math::XYZPoint Pixel::getLocalCenter() const { return local_center_; }
-ROOT::Math::XYZPoint Pixel::getGlobalCenter() const { return global_center_; }
+ROOT::Math::XYZPoint Pixel::getLocalCenter() const {
+    return (geometry_ != nullptr ? geometry_->getLocalPixelCenter(index_) : local_center_);
+}
+ROOT::Math::XYZPoint Pixel::getGlobalCenter() const {
+    return (geometry_ != nullptr ? geometry_->getGlobalPixelCenter(index_) : global_center_);
+}
 ROOT::Math::XYVector Pixel::getSize() const { return size_; }
+
+void Pixel::materialize() {
+    if(geometry_ != nullptr) {
+        local_center_ = geometry_->getLocalPixelCenter(index_);
+        global_center_ = geometry_->getGlobalPixelCenter(index_);
+    }
+}
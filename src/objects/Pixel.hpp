@@ -27,6 +27,10 @@ namespace allpix {
      * @ingroup Objects
      * @brief Pixel in the model with indices, location and size
      * @warning This object is special and is not meant to be written directly to a tree (not inheriting from \ref Object)
+     *
+     * Pixels created by a detector only hold their index and a reference to the geometry of the detector, the centers of
+     * the pixel are computed from the index on access. They are only stored in the object when the object holding the
+     * pixel is prepared for persistent storage, such that the stored form is unchanged.
      */
     class Pixel {
     public:
@@ -41,6 +45,31 @@ namespace allpix {
             HEXAGON_POINTY, ///< Hexagonal pixel shape, corner up
         };
 
+        /**
+         * @brief Interface to resolve the location of pixels from their index, implemented by the detectors
+         */
+        class Geometry {
+        public:
+            /**
+             * @brief Required virtual destructor
+             */
+            virtual ~Geometry() = default;
+
+            /**
+             * @brief Get the center of a pixel in local coordinates
+             * @param index Index of the pixel
+             * @return Local center position
+             */
+            virtual ROOT::Math::XYZPoint getLocalPixelCenter(const Pixel::Index& index) const = 0;
+
+            /**
+             * @brief Get the center of a pixel in global coordinates
+             * @param index Index of the pixel
+             * @return Global center position
+             */
+            virtual ROOT::Math::XYZPoint getGlobalPixelCenter(const Pixel::Index& index) const = 0;
+        };
+
         /**
          * @brief Construct a new pixel
          */
@@ -50,6 +79,15 @@ namespace allpix {
               ROOT::Math::XYZPoint global_center,
               ROOT::Math::XYVector size);
 
+        /**
+         * @brief Construct a new pixel resolving its location through the geometry of a detector
+         * @param index Index of the pixel
+         * @param type Type of the pixel
+         * @param size Size of the pixel
+         * @param geometry Geometry to resolve the location from, needs to outlive the pixel
+         */
+        Pixel(Pixel::Index index, Pixel::Type type, ROOT::Math::XYVector size, const Pixel::Geometry* geometry);
+
         /**
          * @brief Return index pair of pixel
          * @return Index in x,y-plane
@@ -78,6 +116,11 @@ namespace allpix {
          */
         ROOT::Math::XYVector getSize() const;
 
+        /**
+         * @brief Store the location of the pixel resolved through the geometry in the object for persistent storage
+         */
+        void materialize();
+
         /**
          * @brief ROOT class definition
          */
@@ -85,7 +128,7 @@ namespace allpix {
         /**
          * @brief Default constructor for ROOT I/O
          */
-        ClassDef(Pixel, 2); // NOLINT
+        ClassDef(Pixel, 3); // NOLINT
 
     private:
         Pixel::Index index_;
@@ -94,6 +137,8 @@ namespace allpix {
         ROOT::Math::XYZPoint local_center_;
         ROOT::Math::XYZPoint global_center_;
         ROOT::Math::XYVector size_;
+
+        const Pixel::Geometry* geometry_{}; //! transient value
     };
 
 } // namespace allpix
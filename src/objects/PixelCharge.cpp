@@ -16,13 +16,24 @@
 
 using namespace allpix;
 
+/**
+ * The references to the propagated charges and Monte Carlo particles are only stored as far as requested by the configured
+ * history depth, the reference times are always calculated from the Monte Carlo particles.
+ */
 PixelCharge::PixelCharge(Pixel pixel, long charge, const std::vector<const PropagatedCharge*>& propagated_charges)
     : pixel_(std::move(pixel)), charge_(charge) {
+    const auto history_depth = getHistoryDepth();
+
     // Unique set of MC particles
     std::set<const MCParticle*> unique_particles;
     // Store all propagated charges and their MC particles
+    if(history_depth == HistoryDepth::FULL) {
+        propagated_charges_.reserve(propagated_charges.size());
+    }
     for(const auto& propagated_charge : propagated_charges) {
-        propagated_charges_.emplace_back(propagated_charge);
+        if(history_depth == HistoryDepth::FULL) {
+            propagated_charges_.emplace_back(propagated_charge);
+        }
         unique_particles.insert(propagated_charge->mc_particle_.get());
     }
     // Store the MC particle references
@@ -33,7 +44,9 @@ PixelCharge::PixelCharge(Pixel pixel, long charge, const std::vector<const Propa
             local_time_ = std::min(local_time_, primary->getLocalTime());
             global_time_ = std::min(global_time_, primary->getGlobalTime());
         }
-        mc_particles_.emplace_back(mc_particle);
+        if(history_depth != HistoryDepth::NONE) {
+            mc_particles_.emplace_back(mc_particle);
+        }
     }
 
     // If no appropriate reference time has been found, set them to zero:
@@ -64,6 +77,10 @@ unsigned long PixelCharge::getAbsoluteCharge() const { return static_cast<unsign
 
 const Pulse& PixelCharge::getPulse() const { return pulse_; }
 
+size_t PixelCharge::compressPulses() { return pulse_.compress(); }
+
+void PixelCharge::expandPulses() { pulse_.expand(); }
+
 double PixelCharge::getGlobalTime() const { return global_time_; }
 
 double PixelCharge::getLocalTime() const { return local_time_; }
@@ -149,6 +166,7 @@ void PixelCharge::loadHistory() {
     std::for_each(mc_particles_.begin(), mc_particles_.end(), [](auto& n) { n.get(); });
 }
 void PixelCharge::petrifyHistory() {
+    pixel_.materialize();
     std::for_each(propagated_charges_.begin(), propagated_charges_.end(), [](auto& n) { n.store(); });
     std::for_each(mc_particles_.begin(), mc_particles_.end(), [](auto& n) { n.store(); });
 }
@@ -101,6 +101,17 @@ namespace allpix {
          */
         const Pulse& getPulse() const;
 
+        /**
+         * @brief Compress the bins of the pulse to release their memory while the event waits in a buffer
+         * @return Number of bytes saved
+         */
+        size_t compressPulses();
+
+        /**
+         * @brief Restore the bins of the pulse compressed with \ref compressPulses
+         */
+        void expandPulses();
+
         /**
          * @brief Get time after start of event in global reference frame
          * @return Time from start event
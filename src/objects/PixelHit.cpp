@@ -126,6 +126,7 @@ void PixelHit::loadHistory() {
     std::for_each(mc_particles_.begin(), mc_particles_.end(), [](auto& n) { n.get(); });
 }
 void PixelHit::petrifyHistory() {
+    pixel_.materialize();
     pixel_charge_.store();
     std::for_each(mc_particles_.begin(), mc_particles_.end(), [](auto& n) { n.store(); });
 }
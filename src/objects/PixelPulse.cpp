@@ -48,6 +48,10 @@ double PixelPulse::getGlobalTime() const { return global_time_; }
 
 double PixelPulse::getLocalTime() const { return local_time_; }
 
+size_t PixelPulse::compressPulses() { return compress(); }
+
+void PixelPulse::expandPulses() { expand(); }
+
 /**
  * @throws MissingReferenceException If the pointed object is not in scope
  *
@@ -114,6 +118,7 @@ void PixelPulse::loadHistory() {
     std::for_each(mc_particles_.begin(), mc_particles_.end(), [](auto& n) { n.get(); });
 }
 void PixelPulse::petrifyHistory() {
+    pixel_.materialize();
     pixel_charge_.store();
     std::for_each(mc_particles_.begin(), mc_particles_.end(), [](auto& n) { n.store(); });
 }
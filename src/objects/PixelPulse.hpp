@@ -81,6 +81,17 @@ namespace allpix {
          */
         double getLocalTime() const;
 
+        /**
+         * @brief Compress the bins of the pulse to release their memory while the event waits in a buffer
+         * @return Number of bytes saved
+         */
+        size_t compressPulses();
+
+        /**
+         * @brief Restore the bins of the pulse compressed with \ref compressPulses
+         */
+        void expandPulses();
+
         /**
          * @brief Print an ASCII representation of PixelHit to the given stream
          * @param out Stream to print to
@@ -9,6 +9,7 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <algorithm>
 #include <magic_enum/magic_enum.hpp>
 #include <numeric>
 
@@ -18,6 +19,13 @@
 
 using namespace allpix;
 
+namespace {
+    // Order pulses by the index of their electrode, first by x and then by y as for the pixel index
+    bool pulse_index_less(const std::pair<Pixel::Index, Pulse>& lhs, const std::pair<Pixel::Index, Pulse>& rhs) {
+        return lhs.first < rhs.first;
+    }
+} // namespace
+
 PropagatedCharge::PropagatedCharge(ROOT::Math::XYZPoint local_position,
                                    ROOT::Math::XYZPoint global_position,
                                    CarrierType type,
@@ -37,7 +45,7 @@ PropagatedCharge::PropagatedCharge(ROOT::Math::XYZPoint local_position,
 PropagatedCharge::PropagatedCharge(ROOT::Math::XYZPoint local_position,
                                    ROOT::Math::XYZPoint global_position,
                                    CarrierType type,
-                                   std::map<Pixel::Index, Pulse> pulses,
+                                   PulseMap pulses,
                                    double local_time,
                                    double global_time,
                                    CarrierState state,
@@ -56,6 +64,9 @@ PropagatedCharge::PropagatedCharge(ROOT::Math::XYZPoint local_position,
                        state,
                        deposited_charge) {
     pulses_ = std::move(pulses); // NOLINT
+    if(!std::is_sorted(pulses_.begin(), pulses_.end(), pulse_index_less)) {
+        std::sort(pulses_.begin(), pulses_.end(), pulse_index_less);
+    }
 }
 
 /**
@@ -84,7 +95,28 @@ const MCParticle* PropagatedCharge::getMCParticle() const {
     return mc_particle;
 }
 
-std::map<Pixel::Index, Pulse> PropagatedCharge::getPulses() const { return pulses_; }
+const PropagatedCharge::PulseMap& PropagatedCharge::getPulses() const { return pulses_; }
+
+const Pulse* PropagatedCharge::getPulse(const Pixel::Index& index) const {
+    auto pulse = std::lower_bound(pulses_.begin(), pulses_.end(), index, [](const auto& entry, const Pixel::Index& value) {
+        return entry.first < value;
+    });
+    return (pulse != pulses_.end() && pulse->first == index ? &pulse->second : nullptr);
+}
+
+size_t PropagatedCharge::compressPulses() {
+    size_t saved = 0;
+    for(auto& [index, pulse] : pulses_) {
+        saved += pulse.compress();
+    }
+    return saved;
+}
+
+void PropagatedCharge::expandPulses() {
+    for(auto& [index, pulse] : pulses_) {
+        pulse.expand();
+    }
+}
 
 CarrierState PropagatedCharge::getState() const { return state_; }
 
@@ -12,7 +12,8 @@
 #ifndef ALLPIX_PROPAGATED_CHARGE_H
 #define ALLPIX_PROPAGATED_CHARGE_H
 
-#include <map>
+#include <utility>
+#include <vector>
 
 #include "DepositedCharge.hpp"
 #include "MCParticle.hpp"
@@ -41,6 +42,11 @@ namespace allpix {
         friend class PixelCharge;
 
     public:
+        /**
+         * @brief Pulses induced at electrodes, stored as flat range of pairs ordered by the index of the electrode
+         */
+        using PulseMap = std::vector<std::pair<Pixel::Index, Pulse>>;
+
         /**
          * @brief Construct a set of propagated charges
          * @param local_position Local position of the propagated set of charges in the sensor
@@ -66,7 +72,7 @@ namespace allpix {
          * @param local_position Local position of the propagated set of charges in the sensor
          * @param global_position Global position of the propagated set of charges in the sensor
          * @param type Type of the carrier to propagate
-         * @param pulses Map of pulses induced at electrodes identified by their index
+         * @param pulses Pulses induced at electrodes identified by their index, sorted by index if not ordered already
          * @param local_time Time of propagation arrival after energy deposition, local reference frame
          * @param global_time Total time of propagation arrival after event start, global reference frame
          * @param state State of the charge carrier when reaching its position
@@ -75,7 +81,7 @@ namespace allpix {
         PropagatedCharge(ROOT::Math::XYZPoint local_position,
                          ROOT::Math::XYZPoint global_position,
                          CarrierType type,
-                         std::map<Pixel::Index, Pulse> pulses,
+                         PulseMap pulses,
                          double local_time,
                          double global_time,
                          CarrierState state = CarrierState::UNKNOWN,
@@ -95,9 +101,27 @@ namespace allpix {
 
         /**
          * @brief Get related induced pulses
-         * @return Map with induced pulses if available
+         * @return Pulses ordered by electrode index if available
+         */
+        const PulseMap& getPulses() const;
+
+        /**
+         * @brief Get the pulse induced at a given electrode
+         * @param index Index of the electrode
+         * @return Pointer to the pulse or a nullptr if no pulse has been induced at this electrode
+         */
+        const Pulse* getPulse(const Pixel::Index& index) const;
+
+        /**
+         * @brief Compress the bins of the induced pulses to release their memory while the event waits in a buffer
+         * @return Number of bytes saved
+         */
+        size_t compressPulses();
+
+        /**
+         * @brief Restore the bins of the induced pulses compressed with \ref compressPulses
          */
-        std::map<Pixel::Index, Pulse> getPulses() const;
+        void expandPulses();
 
         /**
          * @brief Get state of the charge carrier
@@ -114,7 +138,7 @@ namespace allpix {
         /**
          * @brief ROOT class definition
          */
-        ClassDefOverride(PropagatedCharge, 7); // NOLINT
+        ClassDefOverride(PropagatedCharge, 8); // NOLINT
         /**
          * @brief Default constructor for ROOT I/O
          */
@@ -127,7 +151,7 @@ namespace allpix {
         PointerWrapper<DepositedCharge> deposited_charge_;
         PointerWrapper<MCParticle> mc_particle_;
 
-        std::map<Pixel::Index, Pulse> pulses_;
+        PulseMap pulses_;
 
         CarrierState state_{CarrierState::UNKNOWN};
     };
@@ -13,9 +13,14 @@
 
 #include "objects/exceptions.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <numeric>
 
+#include <Compression.h>
+#include <RZip.h>
+
 using namespace allpix;
 
 Pulse::Pulse(double time_bin) noexcept : bin_(time_bin), initialized_(true) {}
@@ -25,23 +30,96 @@ Pulse::Pulse(double time_bin, double total_time) : bin_(time_bin), initialized_(
     try {
         this->reserve(bins);
     } catch(const std::bad_alloc& e) {
-        PulseBadAllocException(bins, total_time, e.what());
+        throw PulseBadAllocException(bins, total_time, e.what());
     }
 }
 
-void Pulse::addCharge(double charge, double time) {
-    // For uninitialized pulses, store all charge in the first bin:
-    auto bin = (initialized_ ? static_cast<size_t>(std::lround(time / bin_)) : 0);
+Pulse::Pulse(double time_bin, size_t fine_bins, double growth) noexcept
+    : bin_(time_bin), initialized_(true), fine_bins_(fine_bins), growth_(growth) {}
+
+void Pulse::addCharge(double charge, double time) { addChargeToBin(charge, getBin(time)); }
+
+void Pulse::addChargeToBin(double charge, size_t bin) {
+    // Start the pulse at the first bin charge is added to:
+    if(this->empty()) {
+        offset_ = bin;
+    }
+    extend(bin, bin + 1);
+    (*this)[bin - offset_] += charge;
+}
+
+void Pulse::addCharges(size_t first_bin, const double* charges, size_t count, double scale) {
+    if(count == 0) {
+        return;
+    }
+    if(this->empty()) {
+        offset_ = first_bin;
+    }
+    extend(first_bin, first_bin + count);
 
+    auto* bins = this->data() + (first_bin - offset_);
+    for(size_t i = 0; i < count; ++i) {
+        bins[i] += scale * charges[i];
+    }
+}
+
+void Pulse::extend(size_t first_bin, size_t end_bin) {
     try {
+        // Extend the pulse to earlier bins if required:
+        if(first_bin < offset_) {
+            this->insert(this->begin(), offset_ - first_bin, 0.);
+            offset_ = first_bin;
+        }
+
         // Adapt pulse storage vector:
-        if(bin >= this->size()) {
-            this->resize(bin + 1);
+        if(end_bin > offset_ + this->size()) {
+            this->resize(end_bin - offset_);
         }
-        this->at(bin) += charge;
     } catch(const std::bad_alloc& e) {
-        PulseBadAllocException(bin + 1, time, e.what());
+        throw PulseBadAllocException(end_bin, getBinTime(end_bin), e.what());
+    }
+}
+
+size_t Pulse::getBin(double time) const {
+    // For uninitialized pulses, store all charge in the first bin:
+    if(!initialized_) {
+        return 0;
     }
+    if(isUniform() || time < get_bin_start(fine_bins_)) {
+        return static_cast<size_t>(std::lround(time / bin_));
+    }
+
+    // Invert the geometric series of the bin lengths after the fine bins, correcting for floating-point rounding
+    const auto growing = std::log1p((time - get_bin_start(fine_bins_)) * (growth_ - 1.) / bin_) / std::log(growth_);
+    auto bin = fine_bins_ + static_cast<size_t>(growing);
+    if(bin > fine_bins_ && get_bin_start(bin) > time) {
+        --bin;
+    } else if(get_bin_start(bin + 1) <= time) {
+        ++bin;
+    }
+    return bin;
+}
+
+double Pulse::get_bin_start(size_t bin) const {
+    if(isUniform() || bin <= fine_bins_) {
+        return (static_cast<double>(bin) - 0.5) * bin_;
+    }
+    const auto growing = static_cast<double>(bin - fine_bins_);
+    return get_bin_start(fine_bins_) + bin_ * std::expm1(growing * std::log(growth_)) / (growth_ - 1.);
+}
+
+double Pulse::getBinTime(size_t bin) const {
+    if(isUniform() || bin < fine_bins_) {
+        return static_cast<double>(bin) * bin_;
+    }
+    return get_bin_start(bin) + 0.5 * getBinWidth(bin);
+}
+
+double Pulse::getBinWidth(size_t bin) const {
+    if(isUniform() || bin < fine_bins_) {
+        return bin_;
+    }
+    return bin_ * std::pow(growth_, static_cast<double>(bin - fine_bins_));
 }
 
 int Pulse::getCharge() const {
@@ -49,31 +127,173 @@ int Pulse::getCharge() const {
     return static_cast<int>(std::lround(charge));
 }
 
+size_t Pulse::getOffset() const { return offset_; }
+
 double Pulse::getBinning() const { return bin_; }
 
+size_t Pulse::getFineBins() const { return fine_bins_; }
+
+double Pulse::getGrowth() const { return growth_; }
+
+bool Pulse::isUniform() const { return growth_ == 1.; }
+
+/**
+ * The charge of every bin after the fine bins is distributed evenly over the uniform bins whose centers it covers, or added
+ * to the uniform bin containing its center if it covers none. The total charge of the pulse is preserved.
+ */
+Pulse Pulse::getUniform() const {
+    if(isUniform()) {
+        return *this;
+    }
+
+    Pulse uniform(bin_);
+    for(size_t idx = 0; idx < this->size(); ++idx) {
+        const auto bin = offset_ + idx;
+        if(bin < fine_bins_) {
+            uniform.addChargeToBin((*this)[idx], bin);
+            continue;
+        }
+
+        auto first = uniform.getBin(get_bin_start(bin));
+        auto end = std::max(uniform.getBin(get_bin_start(bin + 1)), first + 1);
+        const auto charge = (*this)[idx] / static_cast<double>(end - first);
+        if(uniform.empty()) {
+            uniform.offset_ = first;
+        }
+        uniform.extend(first, end);
+        for(auto fine = first; fine < end; ++fine) {
+            uniform[fine - uniform.offset_] += charge;
+        }
+    }
+    return uniform;
+}
+
 bool Pulse::isInitialized() const { return initialized_; }
 
 Pulse& Pulse::operator+=(const Pulse& rhs) {
     // Allow to initialize uninitialized pulse
     if(!this->initialized_) {
         this->bin_ = rhs.getBinning();
+        this->fine_bins_ = rhs.fine_bins_;
+        this->growth_ = rhs.growth_;
         this->initialized_ = true;
     }
 
     // Check that the pulses are compatible by having the same binning:
-    if(this->getBinning() != rhs.getBinning()) {
+    if(this->getBinning() != rhs.getBinning() || this->growth_ != rhs.growth_ ||
+       (!this->isUniform() && this->fine_bins_ != rhs.fine_bins_)) {
         throw IncompatibleDatatypesException(typeid(*this), typeid(rhs), "different time binning");
     }
 
-    // If new pulse is longer, extend:
-    if(this->size() < rhs.size()) {
-        this->resize(rhs.size());
+    if(rhs.empty()) {
+        return *this;
     }
 
-    // Add up the individual bins:
-    for(size_t bin = 0; bin < rhs.size(); bin++) {
-        this->at(bin) += rhs.at(bin);
+    // Extend to the bins of the new pulse and add them up. Empty pulses keep their offset to not lose leading bins:
+    extend(rhs.offset_, rhs.offset_ + rhs.size());
+    auto* bins = this->data() + (rhs.offset_ - offset_);
+    for(size_t bin = 0; bin < rhs.size(); ++bin) {
+        bins[bin] += rhs[bin];
     }
 
     return *this;
 }
+
+/**
+ * The bins are byte-shuffled before compression, such that the sign and exponent bytes of all bins, which vary little
+ * along the pulse, are stored next to each other. The shuffled bytes are compressed with LZ4 in blocks of the maximum size
+ * supported by the compression routines of ROOT. Pulses which do not shrink are left untouched.
+ */
+size_t Pulse::compress() {
+    // Maximum number of bytes compressed into a single block
+    constexpr size_t max_block_size = 0xffffff;
+    if(this->empty() || isCompressed()) {
+        return 0;
+    }
+
+    const auto bins = this->size();
+    const auto bytes = bins * sizeof(double);
+    std::vector<char> shuffled(bytes);
+    const auto* raw = reinterpret_cast<const char*>(this->data());
+    for(size_t bin = 0; bin < bins; ++bin) {
+        for(size_t byte = 0; byte < sizeof(double); ++byte) {
+            shuffled[byte * bins + bin] = raw[bin * sizeof(double) + byte];
+        }
+    }
+
+    // Every block needs to shrink, otherwise the compressed pulse would not be smaller than the bins
+    std::vector<char> compressed(bytes);
+    size_t position = 0;
+    size_t compressed_size = 0;
+    while(position < bytes) {
+        auto source_size = static_cast<int>(std::min<size_t>(bytes - position, max_block_size));
+        auto target_size = static_cast<int>(bytes - compressed_size);
+        int written = 0;
+        R__zipMultipleAlgorithm(1,
+                                &source_size,
+                                shuffled.data() + position,
+                                &target_size,
+                                compressed.data() + compressed_size,
+                                &written,
+                                ROOT::RCompressionSetting::EAlgorithm::kLZ4);
+        if(written <= 0 || written >= source_size) {
+            return 0;
+        }
+        position += static_cast<size_t>(source_size);
+        compressed_size += static_cast<size_t>(written);
+    }
+    if(compressed_size >= bytes) {
+        return 0;
+    }
+
+    compressed.resize(compressed_size);
+    compressed.shrink_to_fit();
+    compressed_ = std::move(compressed);
+    compressed_bins_ = bins;
+
+    // Release the memory of the bins
+    this->clear();
+    this->shrink_to_fit();
+    return bytes - compressed_size;
+}
+
+void Pulse::expand() {
+    if(!isCompressed()) {
+        return;
+    }
+
+    const auto bins = compressed_bins_;
+    const auto bytes = bins * sizeof(double);
+    std::vector<char> shuffled(bytes);
+    size_t position = 0;
+    size_t compressed_position = 0;
+    while(position < bytes) {
+        auto* source = reinterpret_cast<unsigned char*>(compressed_.data() + compressed_position);
+        int source_size = 0;
+        int target_size = 0;
+        if(R__unzip_header(&source_size, source, &target_size) != 0) {
+            throw RuntimeError("Compressed pulse with " + std::to_string(bins) + " bins is corrupted");
+        }
+        int written = 0;
+        R__unzip(&source_size, source, &target_size, reinterpret_cast<unsigned char*>(shuffled.data() + position), &written);
+        if(written != target_size) {
+            throw RuntimeError("Compressed pulse with " + std::to_string(bins) + " bins is corrupted");
+        }
+        position += static_cast<size_t>(target_size);
+        compressed_position += static_cast<size_t>(source_size);
+    }
+
+    this->resize(bins);
+    auto* raw = reinterpret_cast<char*>(this->data());
+    for(size_t bin = 0; bin < bins; ++bin) {
+        for(size_t byte = 0; byte < sizeof(double); ++byte) {
+            raw[bin * sizeof(double) + byte] = shuffled[byte * bins + bin];
+        }
+    }
+
+    compressed_.clear();
+    compressed_.shrink_to_fit();
+    compressed_bins_ = 0;
+}
+
+bool Pulse::isCompressed() const { return !compressed_.empty(); }
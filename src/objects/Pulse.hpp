@@ -12,6 +12,7 @@
 #ifndef ALLPIX_PULSE_H
 #define ALLPIX_PULSE_H
 
+#include <cstddef>
 #include <vector>
 
 #include <TObject.h>
@@ -21,6 +22,15 @@ namespace allpix {
      * @ingroup Objects
      * @brief Pulse holding induced charges as a function of time
      * @warning This object is special and is not meant to be written directly to a tree (not inheriting from \ref Object)
+     *
+     * The pulse only stores the bins starting from the first bin charge has been added to, the leading empty bins are
+     * described by an offset. The memory of a pulse therefore scales with the duration of the signal instead of its end
+     * time. Pulses accumulated from other pulses via the compound assignment operator into a new pulse keep all bins from the
+     * start of the time axis.
+     *
+     * By default, all bins of the pulse have the same length. Pulses with piecewise binning keep this length for a number of
+     * fine bins at the start of the time axis, while every following bin is longer than the previous one by a constant
+     * factor. This resolves the fast initial signal while the slow tail of long integration windows is stored in few bins.
      */
     class Pulse : public std::vector<double> {
     public:
@@ -38,6 +48,14 @@ namespace allpix {
          */
         Pulse(double time_bin, double total_time);
 
+        /**
+         * @brief Construct a new pulse with piecewise binning
+         * @param time_bin Length in time of the fine bins at the start of the pulse
+         * @param fine_bins Number of fine bins before the bins start to grow
+         * @param growth Factor by which every bin after the fine bins is longer than the previous one, one for uniform bins
+         */
+        Pulse(double time_bin, size_t fine_bins, double growth) noexcept;
+
         /**
          * @brief Construct default pulse, uninitialized
          */
@@ -47,21 +65,103 @@ namespace allpix {
          * @brief adding induced charge to the pulse
          * @param charge induced charge
          * @param time   time when it has been induced
+         * @throws PulseBadAllocException if memory allocation failed
          */
         void addCharge(double charge, double time);
 
+        /**
+         * @brief Add induced charge to a precomputed time bin of the pulse
+         * @param charge induced charge
+         * @param bin    index of the time bin as returned by \ref getBin
+         * @throws PulseBadAllocException if memory allocation failed
+         */
+        void addChargeToBin(double charge, size_t bin);
+
+        /**
+         * @brief Add induced charges to consecutive time bins of the pulse
+         * @param first_bin index of the time bin the first charge is added to
+         * @param charges   pointer to the first of the induced charges
+         * @param count     number of induced charges
+         * @param scale     factor applied to all induced charges
+         *
+         * The pulse is extended once to cover all bins, such that the charges are summed in a single loop without checks.
+         * @throws PulseBadAllocException if memory allocation failed
+         */
+        void addCharges(size_t first_bin, const double* charges, size_t count, double scale = 1.);
+
+        /**
+         * @brief Extend the pulse to store all time bins of a range, e.g. the known integration window, with zero charge
+         * @param first_bin index of the first time bin of the range
+         * @param end_bin   index of the time bin after the range
+         * @throws PulseBadAllocException if memory allocation failed
+         */
+        void extend(size_t first_bin, size_t end_bin);
+
+        /**
+         * @brief Function to retrieve the index of the time bin charge induced at a given time is added to
+         * @param time time of the induced charge
+         * @return Index of the time bin, zero for uninitialized pulses
+         */
+        size_t getBin(double time) const;
+
+        /**
+         * @brief Function to retrieve the time at the center of a time bin
+         * @param bin index of the time bin
+         * @return Time the bin is centered at
+         */
+        double getBinTime(size_t bin) const;
+
+        /**
+         * @brief Function to retrieve the length in time of a time bin
+         * @param bin index of the time bin
+         * @return Length of the bin
+         */
+        double getBinWidth(size_t bin) const;
+
         /**
          * @brief Function to retrieve the integral (net) charge from the full pulse
          * @return Integrated charge
          */
         int getCharge() const;
 
+        /**
+         * @brief Function to retrieve the number of leading empty bins which are not stored in the pulse
+         * @return Index of the time bin corresponding to the first element of the pulse
+         */
+        size_t getOffset() const;
+
         /**
          * @brief Function to retrieve time binning of pulse
          * @return Width of one pulse bin in nanoseconds
          */
         double getBinning() const;
 
+        /**
+         * @brief Function to retrieve the number of fine bins at the start of a pulse with piecewise binning
+         * @return Number of bins with the length returned by \ref getBinning
+         */
+        size_t getFineBins() const;
+
+        /**
+         * @brief Function to retrieve the growth of the bins after the fine bins of a pulse with piecewise binning
+         * @return Ratio of the lengths of consecutive bins, one for uniform bins
+         */
+        double getGrowth() const;
+
+        /**
+         * @brief Method to check if all bins of the pulse have the same length
+         * @return True for uniform binning, false for piecewise binning
+         */
+        bool isUniform() const;
+
+        /**
+         * @brief Resample the pulse onto uniform bins with the length of its fine bins
+         * @return Copy of this pulse for uniform binning, otherwise a pulse with the charge of every longer bin distributed
+         * evenly over the uniform bins it covers
+         * @throws PulseBadAllocException if memory allocation failed
+         */
+        Pulse getUniform() const;
+
         /**
          * @brief Method to check if this is an initialized or empty pulse
          * @return Initialization status of the pulse object
@@ -70,18 +170,52 @@ namespace allpix {
 
         /**
          * @brief compound assignment operator to sum different pulses
-         * @throws IncompatibleDatatypesException If the binning of the pulses does not match
+         * @throws IncompatibleDatatypesException If the binning of the pulses, including piecewise binning, does not match
          */
         Pulse& operator+=(const Pulse& rhs);
 
+        /**
+         * @brief Compress the bins of the pulse and release their memory, e.g. while the event waits in a buffer
+         * @return Number of bytes saved, zero if the pulse is empty, already compressed or the bins do not compress
+         * @warning The bins are not accessible until the pulse has been expanded again with \ref expand
+         */
+        size_t compress();
+
+        /**
+         * @brief Restore the bins of a compressed pulse, does nothing if the pulse is not compressed
+         */
+        void expand();
+
+        /**
+         * @brief Method to check if the bins of the pulse are currently compressed
+         * @return True if compressed, false otherwise
+         */
+        bool isCompressed() const;
+
         /**
          * @brief Default constructor for ROOT I/O
          */
-        ClassDef(Pulse, 3); // NOLINT
+        ClassDef(Pulse, 5); // NOLINT
 
     private:
+        /**
+         * @brief Function to retrieve the time at the start of a time bin
+         * @param bin index of the time bin
+         * @return Lower edge of the time bin
+         */
+        double get_bin_start(size_t bin) const;
+
         double bin_{};
         bool initialized_{};
+        size_t offset_{};
+
+        // Piecewise binning: number of fine bins and growth of the subsequent bins
+        size_t fine_bins_{};
+        double growth_{1.};
+
+        // Byte-shuffled and compressed bins together with their number while the pulse is compressed
+        std::vector<char> compressed_; //! transient value
+        size_t compressed_bins_{};     //! transient value
     };
 
 } // namespace allpix
@@ -12,6 +12,11 @@
 #ifndef ALLPIX_DETRAPPING_MODELS_H
 #define ALLPIX_DETRAPPING_MODELS_H
 
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
 #include <TFormula.h>
 
 #include "exceptions.h"
@@ -99,11 +104,11 @@ namespace allpix {
                 auto model = config.get<std::string>("detrapping_model", "none");
 
                 if(model == "constant") {
-                    model_ = std::make_unique<ConstantDetrapping>(config.get<double>("detrapping_time_electron"),
-                                                                  config.get<double>("detrapping_time_hole"));
+                    model_.emplace<ConstantDetrapping>(config.get<double>("detrapping_time_electron"),
+                                                       config.get<double>("detrapping_time_hole"));
                 } else if(model == "none") {
                     LOG(INFO) << "No charge carrier detrapping model chosen, no detrapping simulated";
-                    model_ = std::make_unique<NoDetrapping>();
+                    model_.emplace<NoDetrapping>();
                 } else {
                     throw InvalidModelError(model);
                 }
@@ -114,14 +119,26 @@ namespace allpix {
 
         /**
          * Function call operator forwarded to the detrapping model
-         * @return Detrapping time
+         * @param type Type of charge carrier (electron or hole)
+         * @param probability Random number to draw the detrapping time from
+         * @param efield_mag Magnitude of the electric field
+         * @return Time after which the charge carrier is detrapped
          */
-        template <class... ARGS> double operator()(ARGS&&... args) const {
-            return model_->operator()(std::forward<ARGS>(args)...);
+        double operator()(const CarrierType& type, double probability, double efield_mag) const {
+            return std::visit(
+                [&](const auto& model) -> double {
+                    using T = std::decay_t<decltype(model)>;
+                    if constexpr(std::is_same_v<T, std::monostate>) {
+                        return std::numeric_limits<double>::max();
+                    } else {
+                        return model.T::operator()(type, probability, efield_mag);
+                    }
+                },
+                model_);
         }
 
     private:
-        std::unique_ptr<DetrappingModel> model_{};
+        std::variant<std::monostate, NoDetrapping, ConstantDetrapping> model_{};
     };
 
 } // namespace allpix
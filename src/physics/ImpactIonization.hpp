@@ -15,6 +15,10 @@
 #include <limits>
 #include <typeindex>
 
+#include <type_traits>
+#include <utility>
+#include <variant>
+
 #include <TFormula.h>
 
 #include "exceptions.h"
@@ -58,6 +62,9 @@ namespace allpix {
         };
 
     protected:
+        // The wrapper provides access to the gain factor for tabulating it
+        friend class ImpactIonization;
+
         virtual double gain_factor(const CarrierType& type, double efield_mag) const = 0;
         double threshold_{std::numeric_limits<double>::max()};
     };
@@ -370,24 +377,24 @@ namespace allpix {
                 auto threshold = config.get<double>("multiplication_threshold");
 
                 if(model == "massey") {
-                    model_ = std::make_unique<Massey>(temperature, threshold);
+                    model_.emplace<Massey>(temperature, threshold);
                 } else if(model == "massey_optimized") {
-                    model_ = std::make_unique<MasseyOptimized>(temperature, threshold);
+                    model_.emplace<MasseyOptimized>(temperature, threshold);
                 } else if(model == "overstraeten") {
-                    model_ = std::make_unique<VanOverstraetenDeMan>(temperature, threshold);
+                    model_.emplace<VanOverstraetenDeMan>(temperature, threshold);
                 } else if(model == "overstraeten_optimized") {
-                    model_ = std::make_unique<VanOverstraetenDeManOptimized>(temperature, threshold);
+                    model_.emplace<VanOverstraetenDeManOptimized>(temperature, threshold);
                 } else if(model == "okuto") {
-                    model_ = std::make_unique<OkutoCrowell>(temperature, threshold);
+                    model_.emplace<OkutoCrowell>(temperature, threshold);
                 } else if(model == "okuto_optimized") {
-                    model_ = std::make_unique<OkutoCrowellOptimized>(temperature, threshold);
+                    model_.emplace<OkutoCrowellOptimized>(temperature, threshold);
                 } else if(model == "bologna") {
-                    model_ = std::make_unique<Bologna>(temperature, threshold);
+                    model_.emplace<Bologna>(temperature, threshold);
                 } else if(model == "none") {
                     LOG(INFO) << "No impact ionization model chosen, charge multiplication not simulated";
-                    model_ = std::make_unique<NoImpactIonization>();
+                    model_.emplace<NoImpactIonization>();
                 } else if(model == "custom") {
-                    model_ = std::make_unique<CustomGain>(config, threshold);
+                    model_.emplace<CustomGain>(config, threshold);
                 } else {
                     throw InvalidModelError(model);
                 }
@@ -399,10 +406,56 @@ namespace allpix {
 
         /**
          * Function call operator forwarded to the impact ionization model
-         * @return Gain
+         * @param type Type of charge carrier (electron or hole)
+         * @param efield_mag Magnitude of the electric field
+         * @param step Length of the step in the direction of the field
+         * @return Gain factor for the step
+         */
+        double operator()(const CarrierType& type, double efield_mag, double step) const {
+            return std::visit(
+                [&](const auto& model) -> double {
+                    using T = std::decay_t<decltype(model)>;
+                    if constexpr(std::is_same_v<T, std::monostate>) {
+                        return 1.;
+                    } else {
+                        return model.T::operator()(type, efield_mag, step);
+                    }
+                },
+                model_);
+        }
+
+        /**
+         * @brief Get the threshold electric field of the model, below which no impact ionization occurs
+         * @return Threshold electric field magnitude
          */
-        template <class... ARGS> double operator()(ARGS&&... args) const {
-            return model_->operator()(std::forward<ARGS>(args)...);
+        double getThreshold() const {
+            return std::visit(
+                [](const auto& model) -> double {
+                    if constexpr(std::is_same_v<std::decay_t<decltype(model)>, std::monostate>) {
+                        return std::numeric_limits<double>::max();
+                    } else {
+                        return static_cast<const ImpactIonizationModel&>(model).threshold_;
+                    }
+                },
+                model_);
+        }
+
+        /**
+         * @brief Get the gain factor of the model, the impact ionization coefficient, irrespective of the threshold
+         * @param type Type of charge carrier (electron or hole)
+         * @param efield_mag Magnitude of the electric field
+         * @return Gain factor per unit length
+         */
+        double getGainFactor(const CarrierType& type, double efield_mag) const {
+            return std::visit(
+                [&](const auto& model) -> double {
+                    if constexpr(std::is_same_v<std::decay_t<decltype(model)>, std::monostate>) {
+                        return 0.;
+                    } else {
+                        return static_cast<const ImpactIonizationModel&>(model).gain_factor(type, efield_mag);
+                    }
+                },
+                model_);
         }
 
         /**
@@ -411,10 +464,22 @@ namespace allpix {
          *     if(model->is<MyModel>()) { }
          * @return Boolean indication whether this model is of the given type or not
          */
-        template <class T> bool is() const { return dynamic_cast<T*>(model_.get()) != nullptr; }
+        template <class T> bool is() const {
+            return std::visit([](const auto& model) { return std::is_base_of_v<T, std::decay_t<decltype(model)>>; }, model_);
+        }
 
     private:
-        std::unique_ptr<ImpactIonizationModel> model_{};
+        std::variant<std::monostate,
+                     NoImpactIonization,
+                     Massey,
+                     MasseyOptimized,
+                     VanOverstraetenDeMan,
+                     VanOverstraetenDeManOptimized,
+                     OkutoCrowell,
+                     OkutoCrowellOptimized,
+                     Bologna,
+                     CustomGain>
+            model_{};
     };
 
 } // namespace allpix
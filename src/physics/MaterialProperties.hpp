@@ -46,6 +46,32 @@ namespace allpix {
         {SensorMaterial::DIAMOND, 0.382},               // https://doi.org/10.1002/pssa.201600195
         {SensorMaterial::SILICON_CARBIDE, 0.1}};        // https://doi.org/10.1016/j.nima.2010.08.046
 
+    /**
+     * @brief Properties of the sensor materials entering the energy loss and multiple scattering of charged particles
+     *
+     * Values for elements and silicon carbide, gallium nitride and cadmium zinc telluride (Cd0.9Zn0.1Te) compounds from
+     * https://pdg.lbl.gov/2023/AtomicNuclearProperties, mean excitation energies and radiation lengths of the latter are
+     * obtained from their constituents with the Bragg additivity rule.
+     *
+     * @warning The mean excitation energy is given in framework-internal units (MeV), the radiation length in mm and the
+     * density in g/cm^3
+     */
+    struct MaterialStoppingProperties {
+        double z_over_a;               ///< Ratio of atomic number and atomic mass in mol/g
+        double density;                ///< Density in g/cm^3
+        double mean_excitation_energy; ///< Mean excitation energy
+        double radiation_length;       ///< Radiation length
+    };
+    static std::map<SensorMaterial, MaterialStoppingProperties> stopping_properties = {
+        {SensorMaterial::SILICON, {0.49848, 2.329, 173.0e-6, 93.70}},
+        {SensorMaterial::GALLIUM_ARSENIDE, {0.44247, 5.32, 384.9e-6, 22.91}},
+        {SensorMaterial::GALLIUM_NITRIDE, {0.45384, 6.15, 258.0e-6, 23.1}},
+        {SensorMaterial::GERMANIUM, {0.44053, 5.323, 350.0e-6, 23.01}},
+        {SensorMaterial::CADMIUM_TELLURIDE, {0.41665, 5.85, 539.3e-6, 15.21}},
+        {SensorMaterial::CADMIUM_ZINC_TELLURIDE, {0.41830, 5.78, 530.0e-6, 15.4}},
+        {SensorMaterial::DIAMOND, {0.49955, 3.52, 81.0e-6, 121.3}},
+        {SensorMaterial::SILICON_CARBIDE, {0.49880, 3.21, 138.0e-6, 79.6}}};
+
 } // namespace allpix
 
 #endif /* ALLPIX_PROPERTIES_H */
@@ -12,6 +12,13 @@
 #ifndef ALLPIX_MOBILITY_MODELS_H
 #define ALLPIX_MOBILITY_MODELS_H
 
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
 #include <TFormula.h>
 
 #include "exceptions.h"
@@ -586,6 +593,115 @@ namespace allpix {
         };
     };
 
+    /**
+     * @ingroup Models
+     * @brief Tabulated version of an arbitrary mobility model
+     *
+     * The mobility model provided at construction is sampled for both charge carrier types on a regular grid in the
+     * electric field magnitude and the logarithm of the absolute doping concentration. Values are obtained by bilinear
+     * interpolation between the grid points. For electric fields above the tabulated range, the value is extrapolated
+     * linearly from the last bin, doping concentrations outside the range are clamped to the range boundaries. If no doping
+     * profile is available, only the field dependence is tabulated.
+     */
+    class TabulatedMobility : public MobilityModel {
+    public:
+        /**
+         * Construct the lookup tables from an analytic model
+         * @param model Mobility model to tabulate
+         * @param max_field Upper boundary of the electric field magnitude range
+         * @param doping_range Lower and upper boundaries of the absolute doping concentration range
+         * @param bins Number of bins in electric field and doping concentration
+         * @param doping Boolean to indicate presence of doping profile information
+         */
+        TabulatedMobility(const MobilityModel& model,
+                          double max_field,
+                          std::pair<double, double> doping_range,
+                          std::array<size_t, 2> bins,
+                          bool doping)
+            : bins_field_(bins[0]), bins_doping_(doping ? bins[1] : 1),
+              dfield_(max_field / static_cast<double>(bins_field_ - 1)), log_doping_min_(std::log10(doping_range.first)),
+              dlog_doping_(bins_doping_ > 1 ? (std::log10(doping_range.second) - log_doping_min_) /
+                                                  static_cast<double>(bins_doping_ - 1)
+                                            : 1.) {
+            if(bins_field_ < 2 || bins_doping_ < 1) {
+                throw ModelUnsuitable("Lookup table needs at least two bins in electric field and one in doping concentration");
+            }
+
+            electron_table_.resize(bins_field_ * bins_doping_);
+            hole_table_.resize(bins_field_ * bins_doping_);
+            for(size_t f = 0; f < bins_field_; ++f) {
+                for(size_t d = 0; d < bins_doping_; ++d) {
+                    auto efield = field_at(static_cast<double>(f));
+                    auto conc = doping_at(static_cast<double>(d));
+                    electron_table_[f * bins_doping_ + d] = model(CarrierType::ELECTRON, efield, conc);
+                    hole_table_[f * bins_doping_ + d] = model(CarrierType::HOLE, efield, conc);
+                }
+            }
+        }
+
+        double operator()(const CarrierType& type, double efield_mag, double doping) const override {
+            const auto& table = (type == CarrierType::ELECTRON ? electron_table_ : hole_table_);
+
+            // Field bin, clamping only the bin index to allow for linear extrapolation beyond the tabulated range
+            auto pos_field = efield_mag / dfield_;
+            auto idx_field = std::min(static_cast<size_t>(pos_field), bins_field_ - 2);
+            auto t_field = pos_field - static_cast<double>(idx_field);
+
+            if(bins_doping_ == 1) {
+                return table[idx_field] * (1 - t_field) + t_field * table[idx_field + 1];
+            }
+
+            // Doping bin, clamped to the tabulated range
+            auto pos_doping = std::clamp(
+                (std::log10(std::fabs(doping)) - log_doping_min_) / dlog_doping_, 0., static_cast<double>(bins_doping_ - 1));
+            auto idx_doping = std::min(static_cast<size_t>(pos_doping), bins_doping_ - 2);
+            auto t_doping = pos_doping - static_cast<double>(idx_doping);
+
+            auto idx = idx_field * bins_doping_ + idx_doping;
+            auto low = table[idx] * (1 - t_doping) + t_doping * table[idx + 1];
+            auto high = table[idx + bins_doping_] * (1 - t_doping) + t_doping * table[idx + bins_doping_ + 1];
+            return low * (1 - t_field) + t_field * high;
+        };
+
+        /**
+         * Compare the tabulated values with the analytic model at the center of every table cell, where the interpolation
+         * deviates most from the tabulated function
+         * @param model Analytic mobility model this table has been generated from
+         * @return Maximum relative deviation between tabulated and analytic model
+         */
+        double max_deviation(const MobilityModel& model) const {
+            double deviation = 0;
+            for(size_t f = 0; f < bins_field_ - 1; ++f) {
+                for(size_t d = 0; d < bins_doping_; ++d) {
+                    auto efield = field_at(static_cast<double>(f) + 0.5);
+                    auto conc = doping_at(static_cast<double>(d) + (bins_doping_ > 1 && d < bins_doping_ - 1 ? 0.5 : 0.));
+                    for(const auto& type : {CarrierType::ELECTRON, CarrierType::HOLE}) {
+                        auto reference = model(type, efield, conc);
+                        if(reference != 0.) {
+                            deviation = std::max(deviation, std::fabs(operator()(type, efield, conc) / reference - 1.));
+                        }
+                    }
+                }
+            }
+            return deviation;
+        }
+
+    private:
+        double field_at(double bin) const { return bin * dfield_; }
+        double doping_at(double bin) const {
+            return (bins_doping_ > 1 ? std::pow(10., log_doping_min_ + bin * dlog_doping_) : 0.);
+        }
+
+        size_t bins_field_;
+        size_t bins_doping_;
+        double dfield_;
+        double log_doping_min_;
+        double dlog_doping_;
+
+        std::vector<double> electron_table_;
+        std::vector<double> hole_table_;
+    };
+
     /**
      * @brief Wrapper class and factory for mobility models.
      *
@@ -611,34 +727,34 @@ namespace allpix {
                 auto model = config.get<std::string>("mobility_model");
                 auto temperature = config.get<double>("temperature");
                 if(model == "jacoboni") {
-                    model_ = std::make_unique<JacoboniCanali>(material, temperature);
+                    model_.emplace<JacoboniCanali>(material, temperature);
                 } else if(model == "canali") {
-                    model_ = std::make_unique<Canali>(material, temperature);
+                    model_.emplace<Canali>(material, temperature);
                 } else if(model == "canali_fast") {
-                    model_ = std::make_unique<CanaliFast>(material, temperature);
+                    model_.emplace<CanaliFast>(material, temperature);
                 } else if(model == "hamburg") {
-                    model_ = std::make_unique<Hamburg>(material, temperature);
+                    model_.emplace<Hamburg>(material, temperature);
                 } else if(model == "hamburg_highfield") {
-                    model_ = std::make_unique<HamburgHighField>(material, temperature);
+                    model_.emplace<HamburgHighField>(material, temperature);
                 } else if(model == "masetti") {
-                    model_ = std::make_unique<Masetti>(
+                    model_.emplace<Masetti>(
                         material, temperature, doping, config.get<Dopant>("dopant_n", Dopant::PHOSPHORUS));
                 } else if(model == "masetti_canali") {
-                    model_ = std::make_unique<MasettiCanali>(
+                    model_.emplace<MasettiCanali>(
                         material, temperature, doping, config.get<Dopant>("dopant_n", Dopant::PHOSPHORUS));
                 } else if(model == "arora") {
-                    model_ = std::make_unique<Arora>(material, temperature, doping);
+                    model_.emplace<Arora>(material, temperature, doping);
                 } else if(model == "ruch_kino") {
-                    model_ = std::make_unique<RuchKino>(material);
+                    model_.emplace<RuchKino>(material);
                 } else if(model == "quay") {
-                    model_ = std::make_unique<Quay>(material, temperature);
+                    model_.emplace<Quay>(material, temperature);
                 } else if(model == "levinshtein") {
-                    model_ = std::make_unique<Levinshtein>(material, temperature, doping);
+                    model_.emplace<Levinshtein>(material, temperature, doping);
                 } else if(model == "constant") {
-                    model_ = std::make_unique<ConstantMobility>(config.get<double>("mobility_electron"),
-                                                                config.get<double>("mobility_hole"));
+                    model_.emplace<ConstantMobility>(config.get<double>("mobility_electron"),
+                                                     config.get<double>("mobility_hole"));
                 } else if(model == "custom") {
-                    model_ = std::make_unique<Custom>(config, doping);
+                    model_.emplace<Custom>(config, doping);
                 } else {
                     throw InvalidModelError(model);
                 }
@@ -646,18 +762,103 @@ namespace allpix {
             } catch(const ModelError& e) {
                 throw InvalidValueError(config, "mobility_model", e.what());
             }
+
+            if(config.get<bool>("mobility_tabulated", false)) {
+                tabulate(config, doping);
+            }
         }
 
         /**
          * Function call operator forwarded to the mobility model
+         *
+         * The model is resolved from the variant and called using a qualified name, such that the virtual function table is
+         * bypassed and the model evaluation can be inlined.
+         * @param type Type of charge carrier (electron or hole)
+         * @param efield_mag Magnitude of the electric field
+         * @param doping (Effective) doping concentration
          * @return Mobility value
          */
-        template <class... ARGS> double operator()(ARGS&&... args) const {
-            return model_->operator()(std::forward<ARGS>(args)...);
+        double operator()(const CarrierType& type, double efield_mag, double doping) const {
+            return std::visit(
+                [&](const auto& model) -> double {
+                    using T = std::decay_t<decltype(model)>;
+                    if constexpr(std::is_same_v<T, std::monostate>) {
+                        return 0.;
+                    } else {
+                        return model.T::operator()(type, efield_mag, doping);
+                    }
+                },
+                model_);
         }
 
     private:
-        std::unique_ptr<MobilityModel> model_{};
+        /**
+         * Replace the configured model by a lookup table sampled from it and check the accuracy of the table
+         * @param config    Configuration of the calling module
+         * @param doping    Boolean to indicate presence of doping profile information
+         */
+        void tabulate(const Configuration& config, bool doping) {
+            const auto& analytic = std::visit(
+                [](const auto& model) -> const MobilityModel& {
+                    if constexpr(std::is_same_v<std::decay_t<decltype(model)>, std::monostate>) {
+                        throw InvalidModelError("none");
+                    } else {
+                        return model;
+                    }
+                },
+                model_);
+
+            auto bins = config.getArray<size_t>("mobility_table_bins", {1000, 100});
+            if(bins.size() != 2) {
+                throw InvalidValueError(
+                    config, "mobility_table_bins", "number of bins in electric field and doping concentration required");
+            }
+            auto doping_range = config.getArray<double>(
+                "mobility_table_doping_range", {Units::get(1e10, "/cm/cm/cm"), Units::get(1e21, "/cm/cm/cm")});
+            if(doping_range.size() != 2 || doping_range[0] <= 0 || doping_range[0] >= doping_range[1]) {
+                throw InvalidValueError(config, "mobility_table_doping_range", "invalid doping concentration range");
+            }
+
+            try {
+                TabulatedMobility table(analytic,
+                                        config.get<double>("mobility_table_max_field", Units::get(1000., "kV/cm")),
+                                        {doping_range[0], doping_range[1]},
+                                        {bins[0], bins[1]},
+                                        doping);
+
+                // Check the accuracy of the table against the analytic model before replacing it
+                auto deviation = table.max_deviation(analytic);
+                auto tolerance = config.get<double>("mobility_table_tolerance", 0.01);
+                if(deviation > tolerance) {
+                    LOG(WARNING) << "Tabulated mobility deviates by up to " << deviation * 100
+                                 << "% from the analytic model, consider increasing the number of table bins";
+                } else {
+                    LOG(INFO) << "Tabulated mobility deviates by up to " << deviation * 100
+                              << "% from the analytic model";
+                }
+
+                model_.emplace<TabulatedMobility>(std::move(table));
+            } catch(const ModelError& e) {
+                throw InvalidValueError(config, "mobility_table_bins", e.what());
+            }
+        }
+
+        std::variant<std::monostate,
+                     JacoboniCanali,
+                     Canali,
+                     CanaliFast,
+                     Hamburg,
+                     HamburgHighField,
+                     Masetti,
+                     MasettiCanali,
+                     Arora,
+                     RuchKino,
+                     Quay,
+                     Levinshtein,
+                     ConstantMobility,
+                     Custom,
+                     TabulatedMobility>
+            model_{};
     };
 
 } // namespace allpix
@@ -12,6 +12,10 @@
 #ifndef ALLPIX_RECOMBINATION_MODELS_H
 #define ALLPIX_RECOMBINATION_MODELS_H
 
+#include <type_traits>
+#include <utility>
+#include <variant>
+
 #include <TFormula.h>
 
 #include "exceptions.h"
@@ -49,6 +53,14 @@ namespace allpix {
          * @return Recombination status, true if charge carrier has recombined, false if it still is alive
          */
         virtual bool operator()(const CarrierType& type, double doping, double survival_prob, double timestep) const = 0;
+
+        /**
+         * Recombination rate, i.e. the inverse lifetime, for the given carrier and doping concentration
+         * @param type Type of charge carrier (electron or hole)
+         * @param doping (Effective) doping concentration
+         * @return Recombination rate of the charge carrier
+         */
+        virtual double rate(const CarrierType& type, double doping) const = 0;
     };
 
     /**
@@ -59,6 +71,7 @@ namespace allpix {
     class None : virtual public RecombinationModel {
     public:
         bool operator()(const CarrierType&, double, double, double) const override { return false; };
+        double rate(const CarrierType&, double) const override { return 0; };
     };
 
     /**
@@ -86,6 +99,8 @@ namespace allpix {
             return survival_prob < (1 - std::exp(-1. * timestep / lifetime(type, doping)));
         };
 
+        double rate(const CarrierType& type, double doping) const override { return 1. / lifetime(type, doping); };
+
     protected:
         double lifetime(const CarrierType& type, double doping) const {
             return (type == CarrierType::ELECTRON ? electron_lifetime_reference_ : hole_lifetime_reference_) /
@@ -124,6 +139,11 @@ namespace allpix {
                                          : (survival_prob < (1 - std::exp(-1. * timestep / lifetime(type, doping)))));
         };
 
+        double rate(const CarrierType& type, double doping) const override {
+            auto minorityType = (doping > 0 ? CarrierType::HOLE : CarrierType::ELECTRON);
+            return (minorityType != type ? 0. : 1. / lifetime(type, doping));
+        };
+
     protected:
         double lifetime(const CarrierType&, double doping) const { return 1. / (auger_coefficient_ * doping * doping); }
 
@@ -152,6 +172,11 @@ namespace allpix {
                 return survival_prob < (1 - std::exp(-1. * timestep / combined_lifetime));
             }
         };
+
+        double rate(const CarrierType& type, double doping) const override {
+            // Rates of both processes add up, Auger only contributes for minority charge carriers
+            return ShockleyReadHall::rate(type, doping) + Auger::rate(type, doping); // NOLINT
+        };
     };
 
     /**
@@ -168,6 +193,10 @@ namespace allpix {
                    (1 - std::exp(-1. * timestep / (type == CarrierType::ELECTRON ? electron_lifetime_ : hole_lifetime_)));
         };
 
+        double rate(const CarrierType& type, double) const override {
+            return 1. / (type == CarrierType::ELECTRON ? electron_lifetime_ : hole_lifetime_);
+        };
+
     private:
         double electron_lifetime_;
         double hole_lifetime_;
@@ -190,6 +219,10 @@ namespace allpix {
                                                                                 : hole_lifetime_->Eval(doping))));
         };
 
+        double rate(const CarrierType& type, double doping) const override {
+            return 1. / (type == CarrierType::ELECTRON ? electron_lifetime_->Eval(doping) : hole_lifetime_->Eval(doping));
+        };
+
     private:
         std::unique_ptr<TFormula> electron_lifetime_;
         std::unique_ptr<TFormula> hole_lifetime_;
@@ -251,19 +284,19 @@ namespace allpix {
                 auto model = config.get<std::string>("recombination_model");
                 auto temperature = config.get<double>("temperature");
                 if(model == "srh") {
-                    model_ = std::make_unique<ShockleyReadHall>(temperature, doping);
+                    model_.emplace<ShockleyReadHall>(temperature, doping);
                 } else if(model == "auger") {
-                    model_ = std::make_unique<Auger>(doping);
+                    model_.emplace<Auger>(doping);
                 } else if(model == "combined" || model == "srh_auger") {
-                    model_ = std::make_unique<ShockleyReadHallAuger>(temperature, doping);
+                    model_.emplace<ShockleyReadHallAuger>(temperature, doping);
                 } else if(model == "constant") {
-                    model_ = std::make_unique<ConstantLifetime>(config.get<double>("lifetime_electron"),
-                                                                config.get<double>("lifetime_hole"));
+                    model_.emplace<ConstantLifetime>(config.get<double>("lifetime_electron"),
+                                                     config.get<double>("lifetime_hole"));
                 } else if(model == "none") {
                     LOG(INFO) << "No charge carrier recombination model chosen, finite lifetime not simulated";
-                    model_ = std::make_unique<None>();
+                    model_.emplace<None>();
                 } else if(model == "custom") {
-                    model_ = std::make_unique<CustomRecombination>(config, doping);
+                    model_.emplace<CustomRecombination>(config, doping);
                 } else {
                     throw InvalidModelError(model);
                 }
@@ -274,15 +307,57 @@ namespace allpix {
         }
 
         /**
-         * Function call operator forwarded to the mobility model
-         * @return Recombination value
+         * Function call operator forwarded to the recombination model
+         * @param type Type of charge carrier (electron or hole)
+         * @param doping (Effective) doping concentration
+         * @param survival_prob Current survival probability for this charge carrier
+         * @param timestep Current time step performed for the charge carrier
+         * @return Recombination status, true if the charge carrier has recombined
+         */
+        bool operator()(const CarrierType& type, double doping, double survival_prob, double timestep) const {
+            return std::visit(
+                [&](const auto& model) -> bool {
+                    using T = std::decay_t<decltype(model)>;
+                    if constexpr(std::is_same_v<T, std::monostate>) {
+                        return false;
+                    } else {
+                        return model.T::operator()(type, doping, survival_prob, timestep);
+                    }
+                },
+                model_);
+        }
+
+        /**
+         * Recombination rate forwarded to the recombination model
+         *
+         * Integrating the rate along the path of a charge carrier and comparing it to an exponentially distributed random
+         * number drawn once per charge carrier is equivalent to evaluating the survival probability at every step.
+         * @param type Type of charge carrier (electron or hole)
+         * @param doping (Effective) doping concentration
+         * @return Recombination rate, i.e. the inverse lifetime of the charge carrier
          */
-        template <class... ARGS> bool operator()(ARGS&&... args) const {
-            return model_->operator()(std::forward<ARGS>(args)...);
+        double rate(const CarrierType& type, double doping) const {
+            return std::visit(
+                [&](const auto& model) -> double {
+                    using T = std::decay_t<decltype(model)>;
+                    if constexpr(std::is_same_v<T, std::monostate>) {
+                        return 0;
+                    } else {
+                        return model.T::rate(type, doping);
+                    }
+                },
+                model_);
         }
 
     private:
-        std::unique_ptr<RecombinationModel> model_{};
+        std::variant<std::monostate,
+                     None,
+                     ShockleyReadHall,
+                     Auger,
+                     ShockleyReadHallAuger,
+                     ConstantLifetime,
+                     CustomRecombination>
+            model_{};
     };
 
 } // namespace allpix
@@ -12,6 +12,10 @@
 #ifndef ALLPIX_TRAPPING_MODELS_H
 #define ALLPIX_TRAPPING_MODELS_H
 
+#include <type_traits>
+#include <utility>
+#include <variant>
+
 #include <TFormula.h>
 
 #include "exceptions.h"
@@ -52,6 +56,16 @@ namespace allpix {
                    (1 - std::exp(-1. * timestep / (type == CarrierType::ELECTRON ? tau_eff_electron_ : tau_eff_hole_)));
         };
 
+        /**
+         * Trapping rate, i.e. the inverse effective trapping time, for the given carrier
+         * @param type Type of charge carrier (electron or hole)
+         * additional possible parameter: efield_mag Magnitude of the electric field
+         * @return Trapping rate of the charge carrier
+         */
+        virtual double rate(const CarrierType& type, double) const {
+            return 1. / (type == CarrierType::ELECTRON ? tau_eff_electron_ : tau_eff_hole_);
+        };
+
     protected:
         double tau_eff_electron_{std::numeric_limits<double>::max()};
         double tau_eff_hole_{std::numeric_limits<double>::max()};
@@ -64,6 +78,7 @@ namespace allpix {
     class NoTrapping : virtual public TrappingModel {
     public:
         bool operator()(const CarrierType&, double, double, double) const override { return false; };
+        double rate(const CarrierType&, double) const override { return 0; };
     };
 
     /**
@@ -158,6 +173,11 @@ namespace allpix {
                                                                               : tf_tau_eff_hole_->Eval(efield_mag))));
         };
 
+        double rate(const CarrierType& type, double efield_mag) const override {
+            return 1. / (type == CarrierType::ELECTRON ? tf_tau_eff_electron_->Eval(efield_mag)
+                                                       : tf_tau_eff_hole_->Eval(efield_mag));
+        };
+
     private:
         std::unique_ptr<TFormula> tf_tau_eff_electron_;
         std::unique_ptr<TFormula> tf_tau_eff_hole_;
@@ -222,21 +242,21 @@ namespace allpix {
                 }
 
                 if(model == "ljubljana" || model == "kramberger") {
-                    model_ = std::make_unique<Ljubljana>(temperature, fluence);
+                    model_.emplace<Ljubljana>(temperature, fluence);
                 } else if(model == "dortmund" || model == "krasel") {
-                    model_ = std::make_unique<Dortmund>(fluence);
+                    model_.emplace<Dortmund>(fluence);
                 } else if(model == "cmstracker") {
-                    model_ = std::make_unique<CMSTracker>(fluence);
+                    model_.emplace<CMSTracker>(fluence);
                 } else if(model == "mandic") {
-                    model_ = std::make_unique<Mandic>(fluence);
+                    model_.emplace<Mandic>(fluence);
                 } else if(model == "constant") {
-                    model_ = std::make_unique<ConstantTrapping>(config.get<double>("trapping_time_electron"),
-                                                                config.get<double>("trapping_time_hole"));
+                    model_.emplace<ConstantTrapping>(config.get<double>("trapping_time_electron"),
+                                                     config.get<double>("trapping_time_hole"));
                 } else if(model == "none") {
                     LOG(INFO) << "No charge carrier trapping model chosen, no trapping simulated";
-                    model_ = std::make_unique<NoTrapping>();
+                    model_.emplace<NoTrapping>();
                 } else if(model == "custom") {
-                    model_ = std::make_unique<CustomTrapping>(config);
+                    model_.emplace<CustomTrapping>(config);
                 } else {
                     throw InvalidModelError(model);
                 }
@@ -248,14 +268,57 @@ namespace allpix {
 
         /**
          * Function call operator forwarded to the trapping model
-         * @return Trapping state
+         * @param type Type of charge carrier (electron or hole)
+         * @param probability Current survival probability for this charge carrier
+         * @param timestep Current time step performed for the charge carrier
+         * @param efield_mag Magnitude of the electric field
+         * @return Trapping state, true if the charge carrier has been trapped
+         */
+        bool operator()(const CarrierType& type, double probability, double timestep, double efield_mag) const {
+            return std::visit(
+                [&](const auto& model) -> bool {
+                    using T = std::decay_t<decltype(model)>;
+                    if constexpr(std::is_same_v<T, std::monostate>) {
+                        return false;
+                    } else {
+                        return model.T::operator()(type, probability, timestep, efield_mag);
+                    }
+                },
+                model_);
+        }
+
+        /**
+         * Trapping rate forwarded to the trapping model
+         *
+         * Integrating the rate along the path of a charge carrier and comparing it to an exponentially distributed random
+         * number drawn once per charge carrier is equivalent to evaluating the trapping probability at every step.
+         * @param type Type of charge carrier (electron or hole)
+         * @param efield_mag Magnitude of the electric field
+         * @return Trapping rate, i.e. the inverse effective trapping time of the charge carrier
          */
-        template <class... ARGS> bool operator()(ARGS&&... args) const {
-            return model_->operator()(std::forward<ARGS>(args)...);
+        double rate(const CarrierType& type, double efield_mag) const {
+            return std::visit(
+                [&](const auto& model) -> double {
+                    using T = std::decay_t<decltype(model)>;
+                    if constexpr(std::is_same_v<T, std::monostate>) {
+                        return 0;
+                    } else {
+                        return model.T::rate(type, efield_mag);
+                    }
+                },
+                model_);
         }
 
     private:
-        std::unique_ptr<TrappingModel> model_{};
+        std::variant<std::monostate,
+                     NoTrapping,
+                     ConstantTrapping,
+                     Ljubljana,
+                     Dortmund,
+                     CMSTracker,
+                     Mandic,
+                     CustomTrapping>
+            model_{};
     };
 
 } // namespace allpix
@@ -12,10 +12,18 @@
 #ifndef ALLPIX_ROOT_H
 #define ALLPIX_ROOT_H
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <ostream>
+#include <set>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <utility>
+#include <vector>
 
 #include <Math/DisplacementVector2D.h>
 #include <Math/DisplacementVector3D.h>
@@ -28,6 +36,7 @@
 
 #include <ROOT/TThreadedObject.hxx>
 #include <TH1.h>
+#include <TList.h>
 
 #include "core/module/ThreadPool.hpp"
 #include "core/utils/text.h"
@@ -157,6 +166,145 @@ namespace allpix {
         return os << "(" << vec.x() << "," << vec.y() << ")";
     }
 
+    /**
+     * @brief Maximum number of copies held by every threaded histogram
+     *
+     * A value of zero creates one copy per thread. Smaller values bound the memory of the histograms and the time to merge
+     * them independently of the number of threads, at the price of threads sharing copies guarded by a mutex.
+     */
+    inline std::atomic<unsigned int>& histogram_copies() {
+        static std::atomic<unsigned int> copies{0};
+        return copies;
+    }
+
+    /**
+     * @brief Common interface of all threaded histograms, allowing to merge their copies together
+     *
+     * Every threaded histogram registers itself on construction. The copies of all registered histograms can then be merged
+     * at once, distributing the work over several threads.
+     */
+    class ThreadedHistogramBase {
+    public:
+        ThreadedHistogramBase() {
+            std::lock_guard<std::mutex> lock(registry_mutex());
+            registry().insert(this);
+        }
+        virtual ~ThreadedHistogramBase() {
+            std::lock_guard<std::mutex> lock(registry_mutex());
+            registry().erase(this);
+        }
+
+        ThreadedHistogramBase(const ThreadedHistogramBase&) = delete;
+        ThreadedHistogramBase& operator=(const ThreadedHistogramBase&) = delete;
+        ThreadedHistogramBase(ThreadedHistogramBase&&) = delete;
+        ThreadedHistogramBase& operator=(ThreadedHistogramBase&&) = delete;
+
+        /**
+         * @brief Merge the copies of all threaded histograms which have not been merged yet
+         * @param threads Number of threads to merge the copies with
+         * @return Number of histograms merged
+         * @warning No histogram may be filled while merging
+         *
+         * The copies of every histogram are merged pairwise in rounds, halving the number of remaining copies with each
+         * round. All merges of a round are independent, both within a histogram and across histograms, and are distributed
+         * over the threads. Merging a histogram afterwards returns the merged copy without merging it again.
+         */
+        static size_t mergeAll(unsigned int threads) {
+            std::vector<ThreadedHistogramBase*> histograms;
+            size_t max_copies = 0;
+            {
+                std::lock_guard<std::mutex> lock(registry_mutex());
+                for(auto* histogram : registry()) {
+                    if(!histogram->merged() && histogram->copies() > 1 && histogram->filled()) {
+                        histograms.push_back(histogram);
+                        max_copies = std::max(max_copies, histogram->copies());
+                    }
+                }
+            }
+
+            std::vector<std::tuple<ThreadedHistogramBase*, size_t, size_t>> merges;
+            for(size_t stride = 1; stride < max_copies; stride *= 2) {
+                merges.clear();
+                for(auto* histogram : histograms) {
+                    for(size_t target = 0; target + stride < histogram->copies(); target += 2 * stride) {
+                        merges.emplace_back(histogram, target, target + stride);
+                    }
+                }
+
+                std::atomic<size_t> next{0};
+                auto merge = [&]() {
+                    for(auto index = next++; index < merges.size(); index = next++) {
+                        auto [histogram, target, source] = merges[index];
+                        histogram->merge_copy(target, source);
+                    }
+                };
+                std::vector<std::thread> workers;
+                for(size_t worker = 1; worker < std::min<size_t>(threads, merges.size()); ++worker) {
+                    workers.emplace_back(merge);
+                }
+                merge();
+                for(auto& worker : workers) {
+                    worker.join();
+                }
+            }
+
+            for(auto* histogram : histograms) {
+                histogram->set_merged();
+            }
+            return histograms.size();
+        }
+
+        /**
+         * @brief Check whether the histogram has been used by any thread
+         * @return True if a copy of the histogram has been created by filling it or accessing it, false otherwise
+         */
+        virtual bool filled() const = 0;
+
+    protected:
+        /**
+         * @brief Get the number of copies of the histogram
+         * @return Number of copies, including copies not created yet
+         */
+        virtual size_t copies() const = 0;
+
+        /**
+         * @brief Merge one copy of the histogram into another one
+         * @param target Index of the copy to merge into
+         * @param source Index of the copy to merge, released afterwards
+         */
+        virtual void merge_copy(size_t target, size_t source) = 0;
+
+        /**
+         * @brief Check whether the copies of the histogram have been merged
+         * @return True if merged, false otherwise
+         */
+        virtual bool merged() const = 0;
+
+        /**
+         * @brief Mark the copies of the histogram as merged into the first copy
+         */
+        virtual void set_merged() = 0;
+
+        /**
+         * @brief Get the mutex serializing the creation of copies, which registers directories with the global ROOT state
+         * @return Reference to the mutex
+         */
+        static std::mutex& copy_mutex() {
+            static std::mutex mutex;
+            return mutex;
+        }
+
+    private:
+        static std::set<ThreadedHistogramBase*>& registry() {
+            static std::set<ThreadedHistogramBase*> histograms;
+            return histograms;
+        }
+        static std::mutex& registry_mutex() {
+            static std::mutex mutex;
+            return mutex;
+        }
+    };
+
     /**
      * @brief A re-implementation of ROOT::TThreadedObject
      *
@@ -165,9 +313,13 @@ namespace allpix {
      * does not depend on ROOT implementation changes that have happened to the original class between minor ROOT versions.
      * This class scales to an arbitrary number of thread, irrespective of the underlying ROOT version.
      *
-     * Enables filling histograms in parallel and makes sure an empty instance will exist if not filled.
+     * Enables filling histograms in parallel. The copies of the histogram are only created by the threads using them, such
+     * that histograms which are never filled, e.g. those of detectors without any hits, only hold their model and are
+     * neither merged nor written. Merging such a histogram still yields an empty instance. The number of copies of the
+     * histogram is limited by \ref histogram_copies, threads sharing a copy are serialized when filling it.
      */
-    template <typename T, typename std::enable_if<std::is_base_of<TH1, T>::value>::type* = nullptr> class ThreadedHistogram {
+    template <typename T, typename std::enable_if<std::is_base_of<TH1, T>::value>::type* = nullptr>
+    class ThreadedHistogram : public ThreadedHistogramBase {
     public:
         template <class... ARGS> explicit ThreadedHistogram(ARGS&&... args) { this->init(std::forward<ARGS>(args)...); }
 
@@ -175,33 +327,47 @@ namespace allpix {
          * @brief An easy way to fill a histogram
          */
         template <class... ARGS> Int_t Fill(ARGS&&... args) { // NOLINT
-            return this->Get()->Fill(std::forward<ARGS>(args)...);
+            auto idx = slot();
+            if(!shared_) {
+                return this->get_copy(idx)->Fill(std::forward<ARGS>(args)...);
+            }
+            std::lock_guard<std::mutex> lock(mutexes_[idx]);
+            return this->get_copy(idx)->Fill(std::forward<ARGS>(args)...);
         }
 
         /**
          * @brief An easy way to set bin contents
          */
         template <class... ARGS> void SetBinContent(ARGS&&... args) { // NOLINT
-            this->Get()->SetBinContent(std::forward<ARGS>(args)...);
+            auto idx = slot();
+            if(!shared_) {
+                this->get_copy(idx)->SetBinContent(std::forward<ARGS>(args)...);
+                return;
+            }
+            std::lock_guard<std::mutex> lock(mutexes_[idx]);
+            this->get_copy(idx)->SetBinContent(std::forward<ARGS>(args)...);
         }
 
         /**
-         * @brief An easy way to write a histogram
+         * @brief An easy way to write a histogram, skipping histograms which have never been filled
          */
-        void Write() { this->Merge()->Write(); } // NOLINT
+        void Write() { // NOLINT
+            if(filled()) {
+                this->Merge()->Write();
+            }
+        }
 
         /**
          * @brief Get the thread local instance of the histogram
+         * @warning The instance may be shared with other threads if the number of copies is limited, only use it outside
+         *          of the event processing in this case
          *
          * Based on get in https://root.cern/doc/master/classROOT_1_1TThreadedObject.html, optimized for faster retrieval.
          */
         std::shared_ptr<T> Get() { // NOLINT
-            auto idx = ThreadPool::threadNum();
-            auto& object = objects_[idx];
-            if(!object) {
-                object.reset(ROOT::Internal::TThreadedObjectUtils::Cloner<T>::Clone(model_.get(), directories_[idx]));
-            }
-            return object;
+            auto idx = slot();
+            get_copy(idx);
+            return objects_[idx];
         }
 
         /**
@@ -211,46 +377,109 @@ namespace allpix {
          */
         std::shared_ptr<T> Merge() { // NOLINT
             ROOT::TThreadedObjectUtils::MergeFunctionType<T> mergeFunction = ROOT::TThreadedObjectUtils::MergeTObjects<T>;
-            if(is_merged_) {
-                return objects_[0];
+            if(!is_merged_) {
+                // Merge into the first copy, which does not exist if the thread of the first slot never used the histogram
+                auto first = std::find_if(objects_.begin(), objects_.end(), [](const auto& object) { return !!object; });
+                if(first != objects_.end()) {
+                    std::swap(objects_[0], *first);
+                    mergeFunction(objects_[0], objects_);
+                }
+                is_merged_ = true;
             }
-            mergeFunction(objects_[0], objects_);
-            is_merged_ = true;
+
+            // Provide an empty histogram if it has never been filled
+            get_copy(0);
             return objects_[0];
         }
 
+        bool filled() const override {
+            return std::any_of(objects_.begin(), objects_.end(), [](const auto& object) { return !!object; });
+        }
+
+    protected:
+        size_t copies() const override { return objects_.size(); }
+
+        void merge_copy(size_t target, size_t source) override {
+            auto& source_object = objects_[source];
+            if(!source_object) {
+                return;
+            }
+            auto& target_object = objects_[target];
+            if(!target_object) {
+                target_object = std::move(source_object);
+                return;
+            }
+            TList list;
+            list.Add(source_object.get());
+            target_object->Merge(&list);
+            source_object.reset();
+        }
+
+        bool merged() const override { return is_merged_; }
+
+        void set_merged() override { is_merged_ = true; }
+
     private:
         /**
          * @brief Initialize the threaded histogram
          *
          * Based on initialization in https://root.cern/doc/master/classROOT_1_1TThreadedObject.html, modified to
-         * initialize based on number of preregistered threads.
+         * initialize based on number of preregistered threads and the maximum number of copies.
          */
         template <class... ARGS> void init(ARGS&&... args) {
-            const auto num_slots = ThreadPool::threadCount();
+            const auto num_threads = std::max(ThreadPool::threadCount(), 1u);
+            const auto max_copies = histogram_copies().load();
+            const auto num_slots = (max_copies == 0 ? num_threads : std::min(num_threads, max_copies));
             objects_.resize(num_slots);
+            shared_ = (num_slots < num_threads);
+            if(shared_) {
+                mutexes_ = std::make_unique<std::mutex[]>(num_slots);
+            }
 
+            std::lock_guard<std::mutex> lock(copy_mutex());
 #if ROOT_VERSION_CODE < ROOT_VERSION(6, 22, 0)
             directories_ = ROOT::Internal::TThreadedObjectUtils::DirCreator<T>::Create(num_slots);
 #else
-            // create at least one directory (we need it for the model), plus others as needed by the size of objects
-            directories_.emplace_back(ROOT::Internal::TThreadedObjectUtils::DirCreator<T>::Create());
-            for(auto i = 1u; i < num_slots; ++i) {
-                directories_.emplace_back(ROOT::Internal::TThreadedObjectUtils::DirCreator<T>::Create());
-            }
+            // Create the directory needed for the model, the others are created together with the copies using them
+            directories_.resize(num_slots, nullptr);
+            directories_[0] = ROOT::Internal::TThreadedObjectUtils::DirCreator<T>::Create();
 #endif
 
             TDirectory::TContext ctxt(directories_[0]);
             model_.reset(ROOT::Internal::TThreadedObjectUtils::Detacher<T>::Detach(new T(std::forward<ARGS>(args)...)));
+        }
 
-            // initialize at least the base object
-            objects_[0].reset(ROOT::Internal::TThreadedObjectUtils::Cloner<T>::Clone(model_.get(), directories_[0]));
+        /**
+         * @brief Get the copy of the histogram used by the current thread
+         * @return Index of the copy
+         */
+        size_t slot() const { return ThreadPool::threadNum() % objects_.size(); }
+
+        /**
+         * @brief Get a copy of the histogram, creating it on first access
+         * @param idx Index of the copy
+         * @return Pointer to the copy, avoiding the reference counting of the shared pointer when filling
+         */
+        T* get_copy(size_t idx) {
+            auto& object = objects_[idx];
+            if(!object) {
+                std::lock_guard<std::mutex> lock(copy_mutex());
+                if(directories_[idx] == nullptr) {
+                    directories_[idx] = ROOT::Internal::TThreadedObjectUtils::DirCreator<T>::Create();
+                }
+                object.reset(ROOT::Internal::TThreadedObjectUtils::Cloner<T>::Clone(model_.get(), directories_[idx]));
+            }
+            return object.get();
         }
 
         std::unique_ptr<T> model_;
         std::vector<std::shared_ptr<T>> objects_;
         std::vector<TDirectory*> directories_;
         bool is_merged_{false};
+
+        // Mutexes guarding the copies if they are shared between threads
+        bool shared_{false};
+        std::unique_ptr<std::mutex[]> mutexes_;
     };
 
     /**
@@ -0,0 +1,234 @@
+/**
+ * @file
+ * @brief Writer thread passing queued items to an output in the order they have been queued
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_ASYNC_WRITER_H
+#define ALLPIX_ASYNC_WRITER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace allpix {
+
+    /**
+     * @brief Dedicated thread writing items from a bounded queue, used by writer modules to write events asynchronously
+     *
+     * The worker threads queue the converted events and only wait if the queue is full. The writer thread takes all queued
+     * items at once, such that the workers only wait for the lock once per batch, and passes them to the write function.
+     * If the write function throws, all further items are dropped and the exception is rethrown in the worker threads when
+     * queuing the next item and when finishing the writer. Written items can be kept to reuse their memory for new items.
+     *
+     * Modules finish the writer when finalizing, which waits for all queued items and reports a failure of writing. If the
+     * run is aborted before, destroying the writer still writes the queued items. The writer therefore has to be declared
+     * after all members used by the write function, or has to be stopped explicitly in the destructor of the module.
+     */
+    template <typename T> class AsyncWriter {
+    public:
+        /**
+         * @brief Function writing a batch of items, only called from the writer thread
+         */
+        using WriteFunction = std::function<void(std::deque<T>&)>;
+
+        AsyncWriter() = default;
+
+        /**
+         * @brief Stop the writer thread after it has written all queued items
+         */
+        ~AsyncWriter() { stop(); }
+
+        /// @{
+        /**
+         * @brief Copying or moving the writer is not allowed, the writer thread holds a reference to it
+         */
+        AsyncWriter(const AsyncWriter&) = delete;
+        AsyncWriter& operator=(const AsyncWriter&) = delete;
+        AsyncWriter(AsyncWriter&&) = delete;
+        AsyncWriter& operator=(AsyncWriter&&) = delete;
+        /// @}
+
+        /**
+         * @brief Start the writer thread
+         * @param max_size Maximum number of queued items
+         * @param write Function writing a batch of items in the order they have been queued
+         * @param reuse Keep the written items to hand them out again by \ref acquire
+         * @param wake_interval Interval in which the write function is called with an empty batch while no items are
+         *                      queued, e.g. to serve an output in the meantime, or zero to only wake up for new items
+         */
+        void start(size_t max_size,
+                   WriteFunction write,
+                   bool reuse = false,
+                   std::chrono::milliseconds wake_interval = std::chrono::milliseconds::zero()) {
+            max_size_ = max_size;
+            write_ = std::move(write);
+            reuse_ = reuse;
+            wake_interval_ = wake_interval;
+            done_ = false;
+            thread_ = std::thread(&AsyncWriter::write_queued, this);
+        }
+
+        /**
+         * @brief Check if the writer thread has been started
+         * @return True if items are written asynchronously, false otherwise
+         */
+        bool running() const { return thread_.joinable(); }
+
+        /**
+         * @brief Queue an item for writing, waiting for space in the queue
+         * @param item Item to write
+         * @throws The exception thrown by the write function if writing failed
+         */
+        void push(T item) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                condition_.wait(lock, [this]() { return exception_ || queue_.size() < max_size_; });
+                if(exception_) {
+                    std::rethrow_exception(exception_);
+                }
+                queue_.push_back(std::move(item));
+            }
+            condition_.notify_all();
+        }
+
+        /**
+         * @brief Queue an item for writing without waiting
+         * @param item Item to write
+         * @return True if the item has been queued, false if the queue is full and the item has been dropped
+         * @throws The exception thrown by the write function if writing failed
+         */
+        bool try_push(T item) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if(exception_) {
+                    std::rethrow_exception(exception_);
+                }
+                if(queue_.size() >= max_size_) {
+                    return false;
+                }
+                queue_.push_back(std::move(item));
+            }
+            condition_.notify_all();
+            return true;
+        }
+
+        /**
+         * @brief Get an item already written to reuse its memory
+         * @return Written item if available, a default-constructed item otherwise
+         */
+        T acquire() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if(spares_.empty()) {
+                return T();
+            }
+            T item = std::move(spares_.back());
+            spares_.pop_back();
+            return item;
+        }
+
+        /**
+         * @brief Keep an item written without the writer thread to hand it out again by \ref acquire
+         * @param item Written item
+         */
+        void release(T item) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            spares_.push_back(std::move(item));
+        }
+
+        /**
+         * @brief Stop the writer thread after it has written all queued items
+         */
+        void stop() {
+            if(thread_.joinable()) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    done_ = true;
+                }
+                condition_.notify_all();
+                thread_.join();
+            }
+        }
+
+        /**
+         * @brief Stop the writer thread after it has written all queued items and report a failure of writing
+         * @throws The exception thrown by the write function if writing failed
+         */
+        void finish() {
+            stop();
+            if(exception_) {
+                std::rethrow_exception(exception_);
+            }
+        }
+
+    private:
+        /**
+         * @brief Writer thread passing the queued items to the write function until it is stopped
+         */
+        void write_queued() {
+            std::deque<T> batch;
+            while(true) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    auto ready = [this]() { return done_ || !queue_.empty(); };
+                    if(wake_interval_ > std::chrono::milliseconds::zero()) {
+                        condition_.wait_for(lock, wake_interval_, ready);
+                    } else {
+                        condition_.wait(lock, ready);
+                    }
+                    if(done_ && queue_.empty()) {
+                        break;
+                    }
+                    batch.swap(queue_);
+                }
+                condition_.notify_all();
+
+                try {
+                    write_(batch);
+                } catch(...) {
+                    // Report the failure to the workers and drop all further items
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    exception_ = std::current_exception();
+                    queue_.clear();
+                    done_ = true;
+                    condition_.notify_all();
+                    break;
+                }
+
+                if(reuse_) {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    for(auto& item : batch) {
+                        spares_.push_back(std::move(item));
+                    }
+                }
+                batch.clear();
+            }
+        }
+
+        size_t max_size_{};
+        WriteFunction write_;
+        bool reuse_{};
+        std::chrono::milliseconds wake_interval_{};
+
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        std::deque<T> queue_;
+        std::vector<T> spares_;
+        bool done_{};
+        std::exception_ptr exception_;
+        std::thread thread_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_ASYNC_WRITER_H */
@@ -0,0 +1,134 @@
+/**
+ * @file
+ * @brief Grouping of pixel objects into clusters of neighboring pixels
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_CLUSTERING_H
+#define ALLPIX_CLUSTERING_H
+
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "core/geometry/DetectorModel.hpp"
+#include "objects/Pixel.hpp"
+#include "tools/pixel_map.h"
+
+namespace allpix {
+
+    /**
+     * @brief Disjoint-set forest to merge elements into connected components
+     *
+     * Sets are merged by size and paths are halved while searching for the representative of a set, such that any sequence
+     * of operations runs in nearly linear time.
+     */
+    class DisjointSets {
+    public:
+        /**
+         * @brief Create a forest with every element in a separate set
+         * @param size Number of elements
+         */
+        explicit DisjointSets(size_t size) : parents_(size), sizes_(size, 1) {
+            std::iota(parents_.begin(), parents_.end(), size_t(0));
+        }
+
+        /**
+         * @brief Find the representative of the set containing an element
+         * @param element Element to search the set for
+         * @return Representative element of the set
+         */
+        size_t find(size_t element) {
+            while(parents_[element] != element) {
+                parents_[element] = parents_[parents_[element]];
+                element = parents_[element];
+            }
+            return element;
+        }
+
+        /**
+         * @brief Merge the sets containing two elements
+         * @param first First element
+         * @param second Second element
+         */
+        void merge(size_t first, size_t second) {
+            first = find(first);
+            second = find(second);
+            if(first == second) {
+                return;
+            }
+            if(sizes_[first] < sizes_[second]) {
+                std::swap(first, second);
+            }
+            parents_[second] = first;
+            sizes_[first] += sizes_[second];
+        }
+
+    private:
+        std::vector<size_t> parents_;
+        std::vector<size_t> sizes_;
+    };
+
+    /**
+     * @brief Group pixel objects into clusters of directly neighboring pixels
+     * @param model Detector model defining which pixels are neighbors
+     * @param objects Pixel objects to cluster, e.g. pixel hits or pixel charges, providing the index of their pixel
+     * @return Clusters of pointers to the objects
+     *
+     * Only the neighbors of every pixel, as found by \ref DetectorModel::getNeighbors and confirmed by
+     * \ref DetectorModel::areNeighbors, are looked up in a hash map of the occupied pixels, such that the run time scales
+     * linearly with the number of objects for any geometry. Objects of the same pixel always end up in the same cluster.
+     * The clusters are ordered by their first object, and the objects within a cluster keep their order in the input.
+     */
+    template <typename T>
+    std::vector<std::vector<const T*>> find_clusters(const DetectorModel& model, const std::vector<T>& objects) {
+        // Map the occupied pixels to the first object in each of them
+        PixelMap<size_t> occupied;
+        DisjointSets components(objects.size());
+        for(size_t i = 0; i < objects.size(); ++i) {
+            // Entries are offset by one to mark pixels not seen before
+            auto& entry = occupied[objects[i].getIndex()];
+            if(entry == 0) {
+                entry = i + 1;
+            } else {
+                components.merge(entry - 1, i);
+            }
+        }
+
+        std::vector<Pixel::Index> neighbors;
+        for(size_t i = 0; i < objects.size(); ++i) {
+            auto index = objects[i].getIndex();
+            neighbors.clear();
+            model.getNeighbors(index, 1, neighbors);
+            for(const auto& neighbor : neighbors) {
+                if(neighbor == index || !model.areNeighbors(index, neighbor, 1)) {
+                    continue;
+                }
+                const auto* entry = occupied.find(neighbor);
+                if(entry != nullptr) {
+                    components.merge(*entry - 1, i);
+                }
+            }
+        }
+
+        // Number the clusters in the order of their first object
+        std::vector<std::vector<const T*>> clusters;
+        std::vector<size_t> labels(objects.size(), objects.size());
+        for(size_t i = 0; i < objects.size(); ++i) {
+            auto& label = labels[components.find(i)];
+            if(label == objects.size()) {
+                label = clusters.size();
+                clusters.emplace_back();
+            }
+            clusters[label].push_back(&objects[i]);
+        }
+        return clusters;
+    }
+} // namespace allpix
+
+#endif /* ALLPIX_CLUSTERING_H */
@@ -0,0 +1,118 @@
+/**
+ * @file
+ * @brief Utilities for the propagation of charge carriers on offload devices using tabulated quantities
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_DEVICE_TABLES_H
+#define ALLPIX_DEVICE_TABLES_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "core/utils/prng.h"
+
+namespace allpix::device {
+
+#ifdef _OPENMP
+#pragma omp declare target
+#endif
+    /**
+     * @brief Get the bin of a fraction of a tabulated range, clamped to the range of the table
+     * @param fraction Position within the range, in units of the range
+     * @param bins Number of bins of the range
+     * @return Index of the bin
+     */
+    inline size_t to_bin(double fraction, size_t bins) {
+        auto bin = std::floor(fraction * static_cast<double>(bins));
+        if(bin < 0) {
+            return 0;
+        }
+        return std::min(static_cast<size_t>(bin), bins - 1);
+    }
+
+    /**
+     * @brief Get the bin of a coordinate in a table spanning the unit cell of one pixel
+     * @param position Coordinate in local coordinates
+     * @param center Center of the pixel the table has been computed for
+     * @param pitch Pitch of the pixels
+     * @param bins Number of bins of the table along the pitch
+     * @return Index of the bin, with the coordinate folded into the unit cell of the pixel
+     */
+    inline size_t to_cell_bin(double position, double center, double pitch, size_t bins) {
+        auto offset = position - center;
+        offset -= pitch * std::round(offset / pitch);
+        return to_bin(offset / pitch + 0.5, bins);
+    }
+
+    /**
+     * @brief Interpolate trilinearly between the nodes of a table
+     * @param table Values at the nodes with the z index running fastest
+     * @param nodes Number of nodes along the three axes
+     * @param fraction Position within the tabulated range along the three axes, in units of the range
+     * @return Interpolated value, clamped to the values at the boundary of the table
+     */
+    inline double interpolate(const float* table, const std::array<size_t, 3>& nodes, const std::array<double, 3>& fraction) {
+        std::array<size_t, 3> lower{};
+        std::array<double, 3> weight{};
+        for(size_t axis = 0; axis < 3; ++axis) {
+            auto cells = static_cast<double>(nodes[axis] - 1);
+            auto position = std::min(std::max(fraction[axis] * cells, 0.), cells);
+            lower[axis] = std::min(static_cast<size_t>(position), nodes[axis] - 2);
+            weight[axis] = position - static_cast<double>(lower[axis]);
+        }
+
+        double value = 0;
+        for(size_t corner = 0; corner < 8; ++corner) {
+            double corner_weight = 1;
+            size_t index = 0;
+            for(size_t axis = 0; axis < 3; ++axis) {
+                auto upper = (corner >> axis) & 1U;
+                corner_weight *= (upper != 0 ? weight[axis] : 1 - weight[axis]);
+                index = index * nodes[axis] + lower[axis] + upper;
+            }
+            value += corner_weight * static_cast<double>(table[index]);
+        }
+        return value;
+    }
+
+    /**
+     * @brief Draw four independent normal random numbers from a stream of the counter-based generator
+     * @param seed Seed of the generator
+     * @param stream Identifier of the stream, e.g. the index of a charge carrier group
+     * @param counter Position within the stream, e.g. the step of the charge carrier group
+     * @return Four numbers following a standard normal distribution
+     *
+     * One block of the generator is transformed with the Box-Muller method, such that the numbers only depend on the seed,
+     * the stream and the counter and can be drawn in any order by concurrent threads.
+     */
+    inline std::array<double, 4> normal_numbers(uint64_t seed, uint64_t stream, uint64_t counter) {
+        auto block = Philox4x64::generate({counter, 0, 0, 0}, {seed, stream});
+
+        // Uniform numbers in the open interval (0, 1)
+        std::array<double, 4> uniform{};
+        for(size_t i = 0; i < 4; ++i) {
+            uniform[i] = (static_cast<double>(block[i] >> 11) + 0.5) * 0x1.0p-53;
+        }
+
+        auto radius_first = std::sqrt(-2. * std::log(uniform[0]));
+        auto radius_second = std::sqrt(-2. * std::log(uniform[2]));
+        return {radius_first * std::cos(2. * M_PI * uniform[1]),
+                radius_first * std::sin(2. * M_PI * uniform[1]),
+                radius_second * std::cos(2. * M_PI * uniform[3]),
+                radius_second * std::sin(2. * M_PI * uniform[3])};
+    }
+#ifdef _OPENMP
+#pragma omp end declare target
+#endif
+} // namespace allpix::device
+
+#endif /* ALLPIX_DEVICE_TABLES_H */
@@ -0,0 +1,90 @@
+/**
+ * @file
+ * @brief Utility to perform fast Fourier transforms of complex sequences
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_FFT_H
+#define ALLPIX_FFT_H
+
+#include <cassert>
+#include <cmath>
+#include <complex>
+#include <utility>
+#include <vector>
+
+namespace allpix {
+
+    /**
+     * @brief Get the smallest power of two not smaller than the given size
+     * @param size Minimum size
+     * @return Power of two
+     */
+    inline size_t fft_size(size_t size) {
+        size_t length = 1;
+        while(length < size) {
+            length <<= 1;
+        }
+        return length;
+    }
+
+    /**
+     * @brief In-place iterative radix-2 fast Fourier transform
+     * @param data Sequence to transform, the length needs to be a power of two
+     * @param inverse Perform the inverse transform, including the normalization by the length of the sequence
+     *
+     * The twiddle factors are evaluated once for the largest butterfly stage and shared by all smaller stages, such that the
+     * precision of the transform does not degrade with the length of the sequence.
+     */
+    inline void fft(std::vector<std::complex<double>>& data, bool inverse = false) {
+        const auto length = data.size();
+        assert((length & (length - 1)) == 0);
+        if(length < 2) {
+            return;
+        }
+
+        // Reorder the sequence by bit-reversed indices
+        for(size_t i = 1, j = 0; i < length; ++i) {
+            auto bit = length >> 1;
+            for(; (j & bit) != 0; bit >>= 1) {
+                j ^= bit;
+            }
+            j ^= bit;
+            if(i < j) {
+                std::swap(data[i], data[j]);
+            }
+        }
+
+        // Twiddle factors of the last stage, the stage of half the length uses every second one
+        std::vector<std::complex<double>> twiddles(length / 2);
+        const auto angle = (inverse ? 2.0 : -2.0) * M_PI / static_cast<double>(length);
+        for(size_t k = 0; k < twiddles.size(); ++k) {
+            twiddles[k] = std::polar(1.0, angle * static_cast<double>(k));
+        }
+
+        for(size_t half = 1; half < length; half <<= 1) {
+            const auto stride = length / (2 * half);
+            for(size_t start = 0; start < length; start += 2 * half) {
+                for(size_t k = 0; k < half; ++k) {
+                    auto odd = data[start + half + k] * twiddles[k * stride];
+                    data[start + half + k] = data[start + k] - odd;
+                    data[start + k] += odd;
+                }
+            }
+        }
+
+        if(inverse) {
+            const auto norm = 1.0 / static_cast<double>(length);
+            for(auto& value : data) {
+                value *= norm;
+            }
+        }
+    }
+} // namespace allpix
+
+#endif /* ALLPIX_FFT_H */
@@ -0,0 +1,475 @@
+/**
+ * @file
+ * @brief Definition of fields on unstructured tetrahedral meshes
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_FIELD_MESH_H
+#define ALLPIX_FIELD_MESH_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cereal/archives/portable_binary.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+
+namespace allpix {
+
+    /**
+     * @brief Field defined on the vertices of an unstructured tetrahedral mesh
+     *
+     * The field values are stored for the vertices of the mesh as provided by TCAD simulations and are interpolated
+     * linearly within the tetrahedra using barycentric coordinates. The memory footprint thus follows the size of the
+     * original mesh instead of the resolution of a regular grid. Positions are located by walking from the tetrahedron found
+     * in the previous lookup of the calling thread towards the position through the faces shared with neighboring
+     * tetrahedra. Only if the walk leaves the mesh or does not converge within a few steps, the position is searched in a
+     * bounding volume hierarchy of all tetrahedra.
+     *
+     * Meshes are written and read in a binary format serialized with the cereal library, which contains the vertices, the
+     * vertex indices of all tetrahedra and the field values. The neighbors and the bounding volume hierarchy are built when
+     * constructing or reading the mesh.
+     */
+    class FieldMesh {
+    public:
+        /**
+         * @brief Index of a missing tetrahedron, e.g. the neighbor across a face on the boundary of the mesh
+         */
+        static constexpr std::uint32_t none = std::numeric_limits<std::uint32_t>::max();
+
+        /**
+         * @brief Default constructor for reading a mesh
+         */
+        FieldMesh() = default;
+
+        /**
+         * @brief Construct a mesh from its vertices, tetrahedra and field values
+         * @param vertices Coordinates x, y and z of all vertices
+         * @param elements Indices of the four vertices of all tetrahedra
+         * @param values Field values of all vertices with the given number of components each
+         * @param components Number of components of each field value
+         * @throws std::invalid_argument If the sizes of the arrays do not match or a tetrahedron refers to a missing vertex
+         */
+        FieldMesh(std::vector<double> vertices,
+                  std::vector<std::uint32_t> elements,
+                  std::vector<double> values,
+                  size_t components)
+            : components_(components), vertices_(std::move(vertices)), elements_(std::move(elements)),
+              values_(std::move(values)) {
+            build();
+        }
+
+        /**
+         * @brief Get the number of components of each field value
+         * @return Number of components
+         */
+        size_t getComponents() const { return components_; }
+
+        /**
+         * @brief Get the number of tetrahedra of the mesh
+         * @return Number of tetrahedra
+         */
+        size_t getElementCount() const { return elements_.size() / 4; }
+
+        /**
+         * @brief Get the number of vertices of the mesh
+         * @return Number of vertices
+         */
+        size_t getVertexCount() const { return vertices_.size() / 3; }
+
+        /**
+         * @brief Get the lower corner of the bounding box of the mesh
+         * @return Minimum coordinates along x, y and z
+         */
+        const std::array<double, 3>& getMin() const { return min_; }
+
+        /**
+         * @brief Get the upper corner of the bounding box of the mesh
+         * @return Maximum coordinates along x, y and z
+         */
+        const std::array<double, 3>& getMax() const { return max_; }
+
+        /**
+         * @brief Get the memory used by the mesh including the neighbors and the bounding volume hierarchy
+         * @return Size of all arrays in bytes
+         */
+        size_t getMemory() const {
+            return vertices_.size() * sizeof(double) + elements_.size() * sizeof(std::uint32_t) +
+                   values_.size() * sizeof(double) + neighbors_.size() * sizeof(std::uint32_t) +
+                   nodes_.size() * sizeof(Node) + order_.size() * sizeof(std::uint32_t);
+        }
+
+        /**
+         * @brief Interpolate the field at a position, starting the search from the tetrahedron of the previous lookup of
+         * the calling thread
+         * @param point Position in the coordinates of the mesh
+         * @param values Array receiving the interpolated field with \ref getComponents entries
+         * @return True if the position is located within the mesh, false otherwise with the values left unchanged
+         */
+        bool interpolate(const std::array<double, 3>& point, double* values) const {
+            thread_local std::vector<std::uint32_t> hints;
+            if(hints.size() <= id_) {
+                hints.resize(id_ + 1, none);
+            }
+            return interpolate(point, hints[id_], values);
+        }
+
+        /**
+         * @brief Interpolate the field at a position
+         * @param point Position in the coordinates of the mesh
+         * @param hint Tetrahedron to start the search from or \ref none, updated to the tetrahedron containing the position
+         * @param values Array receiving the interpolated field with \ref getComponents entries
+         * @return True if the position is located within the mesh, false otherwise with the values left unchanged
+         */
+        bool interpolate(const std::array<double, 3>& point, std::uint32_t& hint, double* values) const {
+            std::array<double, 4> weights{};
+            auto element = locate(point, hint, weights);
+            if(element == none) {
+                return false;
+            }
+            hint = element;
+
+            const auto* vertices = &elements_[4 * static_cast<size_t>(element)];
+            for(size_t c = 0; c < components_; ++c) {
+                double value = 0;
+                for(size_t v = 0; v < 4; ++v) {
+                    value += weights[v] * values_[vertices[v] * components_ + c];
+                }
+                values[c] = value;
+            }
+            return true;
+        }
+
+        /**
+         * @brief Write the mesh to a file
+         * @param file_name Path of the output file
+         * @throws std::runtime_error If the file cannot be written
+         */
+        void write(const std::filesystem::path& file_name) const {
+            std::ofstream file(file_name, std::ios::binary);
+            if(!file.good()) {
+                throw std::runtime_error("file '" + file_name.string() + "' is not writable");
+            }
+            cereal::PortableBinaryOutputArchive archive(file);
+            archive(std::string(magic), format_version, components_, vertices_, elements_, values_);
+        }
+
+        /**
+         * @brief Read a mesh from a file
+         * @param file_name Path of the input file
+         * @return Mesh with its neighbors and bounding volume hierarchy built
+         * @throws std::runtime_error If the file cannot be read or does not contain a tetrahedral mesh
+         */
+        static std::shared_ptr<FieldMesh> read(const std::filesystem::path& file_name) {
+            std::ifstream file(file_name, std::ios::binary);
+            if(!file.good()) {
+                throw std::runtime_error("file '" + file_name.string() + "' is not readable");
+            }
+
+            auto mesh = std::make_shared<FieldMesh>();
+            std::string file_magic;
+            std::uint32_t version{};
+            try {
+                cereal::PortableBinaryInputArchive archive(file);
+                archive(file_magic);
+                if(file_magic == magic) {
+                    archive(version);
+                    if(version == format_version) {
+                        archive(mesh->components_, mesh->vertices_, mesh->elements_, mesh->values_);
+                    }
+                }
+            } catch(const std::exception&) {
+                file_magic.clear();
+            }
+            if(file_magic != magic) {
+                throw std::runtime_error("file '" + file_name.string() + "' does not contain a tetrahedral mesh");
+            }
+            if(version != format_version) {
+                throw std::runtime_error("file '" + file_name.string() + "' has unsupported mesh format version " +
+                                         std::to_string(version));
+            }
+            mesh->build();
+            return mesh;
+        }
+
+    private:
+        /**
+         * @brief Node of the bounding volume hierarchy, either with two children or with a range of tetrahedra
+         *
+         * The first child of an inner node directly follows the node, the second child is found at the stored index.
+         */
+        struct Node {
+            std::array<double, 3> min;
+            std::array<double, 3> max;
+            std::uint32_t index; ///< Second child of inner nodes or first entry in the ordered tetrahedra of leaves
+            std::uint32_t count; ///< Number of tetrahedra of leaves, zero for inner nodes
+        };
+
+        /**
+         * @brief Compute the barycentric coordinates of a position in a tetrahedron
+         * @param element Index of the tetrahedron
+         * @param point Position
+         * @param weights Barycentric coordinates of the position with respect to the four vertices
+         * @return False for degenerate tetrahedra, true otherwise
+         */
+        bool barycentric(std::uint32_t element, const std::array<double, 3>& point, std::array<double, 4>& weights) const {
+            const auto* indices = &elements_[4 * static_cast<size_t>(element)];
+            const auto* a = &vertices_[3 * static_cast<size_t>(indices[0])];
+            std::array<std::array<double, 3>, 4> d{};
+            for(size_t v = 1; v < 4; ++v) {
+                const auto* vertex = &vertices_[3 * static_cast<size_t>(indices[v])];
+                for(size_t i = 0; i < 3; ++i) {
+                    d[v - 1][i] = vertex[i] - a[i];
+                }
+            }
+            for(size_t i = 0; i < 3; ++i) {
+                d[3][i] = point[i] - a[i];
+            }
+
+            // Triple product of three edge vectors
+            using Vector = std::array<double, 3>;
+            auto triple = [](const Vector& u, const Vector& v, const Vector& w) {
+                return u[0] * (v[1] * w[2] - v[2] * w[1]) + u[1] * (v[2] * w[0] - v[0] * w[2]) +
+                       u[2] * (v[0] * w[1] - v[1] * w[0]);
+            };
+            auto volume = triple(d[0], d[1], d[2]);
+            if(volume == 0 || !std::isfinite(volume)) {
+                return false;
+            }
+
+            weights[1] = triple(d[3], d[1], d[2]) / volume;
+            weights[2] = triple(d[0], d[3], d[2]) / volume;
+            weights[3] = triple(d[0], d[1], d[3]) / volume;
+            weights[0] = 1. - weights[1] - weights[2] - weights[3];
+            return true;
+        }
+
+        /**
+         * @brief Locate the tetrahedron containing a position
+         * @param point Position
+         * @param hint Tetrahedron to start the walk from or \ref none
+         * @param weights Barycentric coordinates of the position in the tetrahedron found
+         * @return Index of the tetrahedron or \ref none if the position is outside the mesh
+         */
+        std::uint32_t locate(const std::array<double, 3>& point, std::uint32_t hint, std::array<double, 4>& weights) const {
+            for(size_t i = 0; i < 3; ++i) {
+                if(!(point[i] >= min_[i] && point[i] <= max_[i])) {
+                    return none;
+                }
+            }
+
+            // Walk across the face with the most negative barycentric coordinate towards the position
+            constexpr size_t max_steps = 64;
+            auto element = (hint < getElementCount() ? hint : none);
+            for(size_t step = 0; step < max_steps && element != none; ++step) {
+                if(!barycentric(element, point, weights)) {
+                    break;
+                }
+                auto face = static_cast<size_t>(std::min_element(weights.begin(), weights.end()) - weights.begin());
+                if(weights[face] >= -tolerance) {
+                    return element;
+                }
+                element = neighbors_[4 * static_cast<size_t>(element) + face];
+            }
+
+            return search(point, weights);
+        }
+
+        /**
+         * @brief Search the tetrahedron containing a position in the bounding volume hierarchy
+         * @param point Position
+         * @param weights Barycentric coordinates of the position in the tetrahedron found
+         * @return Index of the tetrahedron or \ref none if the position is outside the mesh
+         */
+        std::uint32_t search(const std::array<double, 3>& point, std::array<double, 4>& weights) const {
+            if(nodes_.empty()) {
+                return none;
+            }
+
+            std::array<std::uint32_t, 64> stack{};
+            size_t size = 0;
+            stack[size++] = 0;
+            while(size > 0) {
+                const auto& node = nodes_[stack[--size]];
+                if(point[0] < node.min[0] || point[0] > node.max[0] || point[1] < node.min[1] || point[1] > node.max[1] ||
+                   point[2] < node.min[2] || point[2] > node.max[2]) {
+                    continue;
+                }
+                if(node.count == 0) {
+                    stack[size++] = node.index;
+                    stack[size++] = static_cast<std::uint32_t>(&node - nodes_.data()) + 1;
+                    continue;
+                }
+                for(auto entry = node.index; entry < node.index + node.count; ++entry) {
+                    auto element = order_[entry];
+                    if(barycentric(element, point, weights) &&
+                       *std::min_element(weights.begin(), weights.end()) >= -tolerance) {
+                        return element;
+                    }
+                }
+            }
+            return none;
+        }
+
+        /**
+         * @brief Validate the mesh and build the neighbors and the bounding volume hierarchy of the tetrahedra
+         */
+        void build() {
+            if(components_ == 0 || vertices_.size() % 3 != 0 || elements_.size() % 4 != 0 ||
+               values_.size() != getVertexCount() * components_) {
+                throw std::invalid_argument("mesh vertices, tetrahedra and field values do not match");
+            }
+            if(elements_.empty() || getElementCount() >= none) {
+                throw std::invalid_argument("mesh does not contain a supported number of tetrahedra");
+            }
+            if(*std::max_element(elements_.begin(), elements_.end()) >= getVertexCount()) {
+                throw std::invalid_argument("mesh tetrahedra refer to missing vertices");
+            }
+            id_ = next_id().fetch_add(1);
+            const auto elements = static_cast<std::uint32_t>(getElementCount());
+
+            // Match the faces of all tetrahedra, a face is shared by at most two tetrahedra
+            std::vector<std::pair<std::array<std::uint32_t, 3>, std::uint32_t>> faces;
+            faces.reserve(elements_.size());
+            for(std::uint32_t element = 0; element < elements; ++element) {
+                for(std::uint32_t face = 0; face < 4; ++face) {
+                    std::array<std::uint32_t, 3> key{};
+                    size_t k = 0;
+                    for(std::uint32_t v = 0; v < 4; ++v) {
+                        if(v != face) {
+                            key[k++] = elements_[4 * static_cast<size_t>(element) + v];
+                        }
+                    }
+                    std::sort(key.begin(), key.end());
+                    faces.emplace_back(key, 4 * element + face);
+                }
+            }
+            std::sort(faces.begin(), faces.end());
+            neighbors_.assign(elements_.size(), none);
+            for(size_t i = 0; i + 1 < faces.size(); ++i) {
+                if(faces[i].first == faces[i + 1].first) {
+                    neighbors_[faces[i].second] = faces[i + 1].second / 4;
+                    neighbors_[faces[i + 1].second] = faces[i].second / 4;
+                    ++i;
+                }
+            }
+
+            // Bounding boxes and centers of all tetrahedra
+            std::vector<std::array<double, 3>> box_min(elements), box_max(elements), centers(elements);
+            min_.fill(std::numeric_limits<double>::max());
+            max_.fill(std::numeric_limits<double>::lowest());
+            for(std::uint32_t element = 0; element < elements; ++element) {
+                box_min[element].fill(std::numeric_limits<double>::max());
+                box_max[element].fill(std::numeric_limits<double>::lowest());
+                for(size_t v = 0; v < 4; ++v) {
+                    const auto vertex_index = elements_[4 * static_cast<size_t>(element) + v];
+                    const auto* vertex = &vertices_[3 * static_cast<size_t>(vertex_index)];
+                    for(size_t i = 0; i < 3; ++i) {
+                        box_min[element][i] = std::min(box_min[element][i], vertex[i]);
+                        box_max[element][i] = std::max(box_max[element][i], vertex[i]);
+                    }
+                }
+                for(size_t i = 0; i < 3; ++i) {
+                    centers[element][i] = (box_min[element][i] + box_max[element][i]) / 2;
+                    min_[i] = std::min(min_[i], box_min[element][i]);
+                    max_[i] = std::max(max_[i], box_max[element][i]);
+                }
+            }
+
+            // Split the tetrahedra at the median of their centers along the longest axis of the node until few remain
+            constexpr std::uint32_t leaf_size = 4;
+            order_.resize(elements);
+            for(std::uint32_t element = 0; element < elements; ++element) {
+                order_[element] = element;
+            }
+            nodes_.clear();
+            nodes_.reserve(2 * (elements / leaf_size + 1));
+            auto build_node = [&](auto& self, std::uint32_t first, std::uint32_t last) -> void {
+                auto index = static_cast<std::uint32_t>(nodes_.size());
+                nodes_.push_back({});
+                auto& node = nodes_.back();
+                node.min.fill(std::numeric_limits<double>::max());
+                node.max.fill(std::numeric_limits<double>::lowest());
+                std::array<double, 3> center_min{}, center_max{};
+                center_min.fill(std::numeric_limits<double>::max());
+                center_max.fill(std::numeric_limits<double>::lowest());
+                for(auto entry = first; entry < last; ++entry) {
+                    auto element = order_[entry];
+                    for(size_t i = 0; i < 3; ++i) {
+                        node.min[i] = std::min(node.min[i], box_min[element][i]);
+                        node.max[i] = std::max(node.max[i], box_max[element][i]);
+                        center_min[i] = std::min(center_min[i], centers[element][i]);
+                        center_max[i] = std::max(center_max[i], centers[element][i]);
+                    }
+                }
+                if(last - first <= leaf_size) {
+                    node.index = first;
+                    node.count = last - first;
+                    return;
+                }
+
+                size_t axis = 0;
+                for(size_t i = 1; i < 3; ++i) {
+                    if(center_max[i] - center_min[i] > center_max[axis] - center_min[axis]) {
+                        axis = i;
+                    }
+                }
+                auto middle = first + (last - first) / 2;
+                std::nth_element(order_.begin() + first,
+                                 order_.begin() + middle,
+                                 order_.begin() + last,
+                                 [&](auto lhs, auto rhs) { return centers[lhs][axis] < centers[rhs][axis]; });
+                nodes_[index].count = 0;
+                self(self, first, middle);
+                nodes_[index].index = static_cast<std::uint32_t>(nodes_.size());
+                self(self, middle, last);
+            };
+            build_node(build_node, 0, elements);
+        }
+
+        /**
+         * @brief Counter of the meshes created, used to keep separate lookup hints per mesh and thread
+         */
+        static std::atomic<size_t>& next_id() {
+            static std::atomic<size_t> id{0};
+            return id;
+        }
+
+        static constexpr const char* magic = "Allpix Squared tetrahedral mesh";
+        static constexpr std::uint32_t format_version = 1;
+        // Tolerance on the barycentric coordinates for positions on the faces of tetrahedra
+        static constexpr double tolerance = 1e-9;
+
+        size_t id_{};
+        size_t components_{};
+        std::vector<double> vertices_;
+        std::vector<std::uint32_t> elements_;
+        std::vector<double> values_;
+
+        // Neighbor across the face opposite to each vertex of the tetrahedra
+        std::vector<std::uint32_t> neighbors_;
+        std::vector<Node> nodes_;
+        std::vector<std::uint32_t> order_;
+        std::array<double, 3> min_{};
+        std::array<double, 3> max_{};
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_FIELD_MESH_H */
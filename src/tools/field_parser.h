@@ -1,6 +1,6 @@
 /**
  * @file
- * @brief Utility to parse INIT-format field files
+ * @brief Utility to parse INIT-format, APF and memory-mappable APF field files
  *
  * @copyright Copyright (c) 2018-2024 CERN and the Allpix Squared authors.
  * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
@@ -13,14 +13,37 @@
 #define ALLPIX_FIELD_PARSER_H
 
 #include <algorithm>
+#include <array>
+#include <charconv>
 #include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <limits>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "core/utils/log.h"
 #include "core/utils/unit.h"
+#include "tools/field_refinement.h"
 
 #include <cereal/archives/portable_binary.hpp>
 
@@ -31,7 +54,10 @@
 #include <utility>
 
 // Mime type version for APF files
-#define APF_MIME_TYPE_VERSION 1
+#define APF_MIME_TYPE_VERSION 2
+
+// Format version for memory-mappable APF files
+#define APF_MAPPED_FORMAT_VERSION 1
 
 namespace allpix {
 
@@ -51,6 +77,66 @@ namespace allpix {
         UNKNOWN = 0, ///< Unknown file format
         INIT,        ///< Legacy file format, values stored in plain-text ASCII
         APF,         ///< Binary Allpix Squared format serialized using the cereal library
+        MAPPED,      ///< Binary Allpix Squared format with aligned raw field data, read via memory mapping
+    };
+
+    /**
+     * @brief Fixed-size header of memory-mappable field files
+     *
+     * The header is followed by the human-readable header string and, aligned to the page size, the flat field data in the
+     * native floating point representation. The endianness marker allows to detect files written on incompatible machines.
+     */
+    struct MappedFieldHeader {
+        std::array<char, 8> magic{{'A', 'P', 'F', 'M', 'A', 'P', '\0', '\0'}};
+        std::uint32_t version{APF_MAPPED_FORMAT_VERSION};
+        std::uint32_t endianness{0x01020304};
+        std::uint32_t value_size{};
+        std::uint32_t components{};
+        std::array<std::uint64_t, 3> dimensions{};
+        std::array<double, 3> size{};
+        std::uint64_t header_length{};
+        std::uint64_t data_offset{};
+        std::uint64_t values{};
+    };
+
+    // Alignment of the field data in memory-mappable field files
+    constexpr std::uint64_t mapped_field_alignment = 4096;
+
+    /**
+     * @brief Sub-volume and downsampling of field data applied while reading a field file
+     *
+     * The region is given in the coordinates of the field file, ranging from zero to the size of the field in every
+     * dimension, and is extended to full cells. Blocks of cells of the given downsampling factors are averaged into a single
+     * cell, cells at the upper end of the region which do not fill a complete block are dropped.
+     */
+    struct FieldSubset {
+        std::array<double, 3> region_min{{0., 0., 0.}};
+        std::array<double, 3> region_max{{std::numeric_limits<double>::infinity(),
+                                          std::numeric_limits<double>::infinity(),
+                                          std::numeric_limits<double>::infinity()}};
+        std::array<size_t, 3> downsampling{{1, 1, 1}};
+
+        /**
+         * @brief Check whether the subset comprises the full field without downsampling
+         * @return True if the field is read as stored in the file
+         */
+        bool isFull() const {
+            return region_min == FieldSubset().region_min && region_max == FieldSubset().region_max &&
+                   downsampling == FieldSubset().downsampling;
+        }
+
+        /**
+         * @brief Unique description of the subset, used to cache the field data read with different subsets separately
+         * @return Description of the region and the downsampling factors
+         */
+        std::string getDescription() const {
+            std::string description;
+            for(size_t i = 0; i < 3; ++i) {
+                description += std::to_string(region_min[i]) + ":" + std::to_string(region_max[i]) + "/" +
+                               std::to_string(downsampling[i]) + " ";
+            }
+            return description;
+        }
     };
 
     /**
@@ -77,7 +163,25 @@ namespace allpix {
                   std::array<size_t, 3> dimensions,
                   std::array<T, 3> size,
                   std::shared_ptr<std::vector<T>> data)
-            : header_(std::move(header)), dimensions_(dimensions), size_(size), data_(std::move(data)){};
+            : header_(std::move(header)), dimensions_(dimensions), size_(size), data_(std::move(data)),
+              values_(data_, data_ != nullptr ? data_->data() : nullptr),
+              number_of_values_(data_ != nullptr ? data_->size() : 0){};
+
+        /**
+         * @brief Constructor for field data which is not owned by a vector, such as memory-mapped field files
+         * @param header           Human readable header string to identify file content
+         * @param dimensions       Number of bins of the field in each coordinate
+         * @param size             Physical extent of the field in each dimension, given in internal units
+         * @param values           Shared pointer to the first value of the flat field data, keeping its storage alive
+         * @param number_of_values Total number of values of the flat field data
+         */
+        FieldData(std::string header,
+                  std::array<size_t, 3> dimensions,
+                  std::array<T, 3> size,
+                  std::shared_ptr<const T> values,
+                  size_t number_of_values)
+            : header_(std::move(header)), dimensions_(dimensions), size_(size), values_(std::move(values)),
+              number_of_values_(number_of_values){};
 
         /**
          * @brief Function to obtain the header (human readbale content description) of the field data
@@ -100,8 +204,44 @@ namespace allpix {
         /**
          * @brief Member to access the actual field data
          * @return shared pointer to the flat vector of field data
+         * @note For field data not owned by a vector, such as memory-mapped files, this creates a copy of the data
+         */
+        std::shared_ptr<std::vector<T>> getData() const {
+            if(data_ == nullptr && values_ != nullptr) {
+                return std::make_shared<std::vector<T>>(values_.get(), values_.get() + number_of_values_);
+            }
+            return data_;
+        }
+
+        /**
+         * @brief Member to access the actual field data without copying
+         * @return shared pointer to the first value of the flat field data, keeping its storage alive
+         */
+        std::shared_ptr<const T> getValues() const { return values_; }
+
+        /**
+         * @brief Member to get the total number of values of the flat field data
+         * @return Number of values
+         */
+        size_t getNumberOfValues() const { return number_of_values_; }
+
+        /**
+         * @brief Check whether the field data is memory-mapped from a file instead of being owned by a vector
+         * @return True if the data is memory-mapped, false otherwise
+         */
+        bool isMapped() const { return data_ == nullptr && values_ != nullptr; }
+
+        /**
+         * @brief Member to access the locally refined cells of the field
+         * @return Shared pointer to the refinement, or nullptr if the field is stored with uniform binning only
+         */
+        std::shared_ptr<const FieldRefinement> getRefinement() const { return refinement_; }
+
+        /**
+         * @brief Attach locally refined cells to the field
+         * @param refinement Refinement of cells of the field grid
          */
-        std::shared_ptr<std::vector<T>> getData() const { return data_; }
+        void setRefinement(std::shared_ptr<const FieldRefinement> refinement) { refinement_ = std::move(refinement); }
 
         /**
          * @brief get the dimensionality of the configured field in the x-y plane, e.g whether it is defined in 1D, 2D or 3D.
@@ -119,13 +259,16 @@ namespace allpix {
         std::array<size_t, 3> dimensions_{};
         std::array<T, 3> size_{};
         std::shared_ptr<std::vector<T>> data_;
+        std::shared_ptr<const T> values_;
+        size_t number_of_values_{};
+        std::shared_ptr<const FieldRefinement> refinement_;
 
         friend class cereal::access;
 
         // Versioned serialization function:
         template <class Archive> void serialize(Archive& archive, std::uint32_t const version) {
-            // For now, we only know one version of this file type:
-            if(version != 1) {
+            // Version 2 added the optional refinement of cells:
+            if(version != 1 && version != 2) {
                 throw std::runtime_error("unknown format version " + std::to_string(version));
             }
 
@@ -134,6 +277,25 @@ namespace allpix {
             archive(dimensions_);
             archive(size_);
             archive(data_);
+
+            if(version >= 2) {
+                bool refined = (refinement_ != nullptr);
+                archive(refined);
+                if constexpr(Archive::is_loading::value) {
+                    refinement_.reset();
+                    if(refined) {
+                        auto refinement = std::make_shared<FieldRefinement>();
+                        archive(*refinement);
+                        refinement_ = std::move(refinement);
+                    }
+                } else if(refined) {
+                    archive(*refinement_);
+                }
+            }
+
+            // Point to the deserialized data
+            values_ = std::shared_ptr<const T>(data_, data_ != nullptr ? data_->data() : nullptr);
+            number_of_values_ = (data_ != nullptr ? data_->size() : 0);
         }
     };
 } // namespace allpix
@@ -155,6 +317,8 @@ namespace cereal::detail {
 
 namespace allpix {
 
+    template <typename T> class FieldWriter;
+
     /**
      * @brief Class to parse Allpix Squared field data from files
      *
@@ -177,27 +341,149 @@ namespace allpix {
          * @brief Parse a file and retrieve the field data.
          * @param file_name  File name (as canonical path) of the input file to be parsed
          * @param units      Optional units to convert the field from after reading from file. Only used by some formats.
+         * @param cache_init Store fields parsed from INIT files in a memory-mappable file next to the input, which is read
+         *                   instead of the INIT file as long as it is newer than the input
+         * @param subset     Sub-volume and downsampling to apply while reading, APF and mapped files are only read partially
          * @return           Field data object read from file or internal cache
          *
          * @throws std::runtime_error if the file format is unknown or invalid field dimensions are detected
          * @throws std::filesystem::filesystem_error if the provided path does not exist
          *
-         * The type of the field data file to be read is deducted automatically from the file content
+         * The type of the field data file to be read is deducted automatically from the file content. The method can be
+         * called concurrently, every file is only parsed once while other callers requesting the same file wait for it.
          */
-        FieldData<T> getByFileName(const std::filesystem::path& file_name, const std::string& units = std::string()) {
+        FieldData<T> getByFileName(const std::filesystem::path& file_name,
+                                   const std::string& units = std::string(),
+                                   bool cache_init = false,
+                                   const FieldSubset& subset = FieldSubset()) {
 
             auto path = std::filesystem::canonical(file_name);
 
-            // Search in cache
-            auto iter = field_map_.find(path);
-            if(iter != field_map_.end()) {
+            // Search in cache, the entries are never removed and can be used after releasing the lock
+            CacheEntry* entry = nullptr;
+            bool cached = false;
+            {
+                std::lock_guard<std::mutex> lock(field_map_mutex_);
+                auto& cache_entry = field_map_[{path, subset.getDescription()}];
+                cached = (cache_entry != nullptr);
+                if(!cached) {
+                    cache_entry = std::make_unique<CacheEntry>();
+                }
+                entry = cache_entry.get();
+            }
+            if(cached) {
                 LOG(INFO) << "Using cached field data";
-                return iter->second;
             }
 
+            // Parse the file once, a failed attempt is repeated by the next caller
+            std::call_once(entry->parsed, [&]() { entry->field_data = parse_file(path, units, cache_init, subset); });
+            return entry->field_data;
+        }
+
+        /**
+         * @brief Read only the header of a field file, without reading the field data
+         * @param file_name File name (as canonical path) of the input file
+         * @return Field data object with header, dimensions and size, but without any values
+         *
+         * @throws std::runtime_error if the file format is unknown or the header is invalid
+         *
+         * The number of values of the returned object is taken from the file for APF and mapped files. For INIT files, it is
+         * derived from the dimensions, and the number of components is checked on the first line of the field values.
+         */
+        FieldData<T> getHeaderByFileName(const std::filesystem::path& file_name) {
+            auto path = std::filesystem::canonical(file_name);
+            switch(guess_file_type(path)) {
+            case FileType::INIT: {
+                auto header = read_init_header(path);
+
+                // Check the number of components on the first line of the body, holding three indices and the values
+                std::ifstream file(path);
+                file.seekg(static_cast<std::streamoff>(header.body_offset));
+                std::string line;
+                while(line.find_first_not_of(" \t\r") == std::string::npos && std::getline(file, line)) {
+                }
+                std::istringstream values(line);
+                if(std::distance(std::istream_iterator<std::string>(values), std::istream_iterator<std::string>()) !=
+                   static_cast<std::ptrdiff_t>(3 + N_)) {
+                    throw std::runtime_error("invalid data");
+                }
+                return FieldData<T>(
+                    header.header, header.dimensions, header.size, std::shared_ptr<const T>(), header.number_of_values);
+            }
+            case FileType::APF: {
+                std::ifstream file(path, std::ios::binary);
+                try {
+                    cereal::PortableBinaryInputArchive archive(file);
+                    auto header = read_apf_header(archive);
+                    return FieldData<T>(
+                        header.header, header.dimensions, header.size, std::shared_ptr<const T>(), header.number_of_values);
+                } catch(cereal::Exception& e) {
+                    throw std::runtime_error(e.what());
+                }
+            }
+            case FileType::MAPPED: {
+                std::ifstream file(path, std::ios::binary);
+                MappedFieldHeader header;
+                file.read(reinterpret_cast<char*>(&header), sizeof(header)); // NOLINT
+                std::string header_string(header.header_length, '\0');
+                file.read(header_string.data(), static_cast<std::streamsize>(header.header_length));
+                if(!file.good() || header.components != N_) {
+                    throw std::runtime_error("invalid data");
+                }
+                return FieldData<T>(header_string,
+                                    {{header.dimensions[0], header.dimensions[1], header.dimensions[2]}},
+                                    {{static_cast<T>(header.size[0]),
+                                      static_cast<T>(header.size[1]),
+                                      static_cast<T>(header.size[2])}},
+                                    std::shared_ptr<const T>(),
+                                    header.values);
+            }
+            default:
+                throw std::runtime_error("unknown file format");
+            }
+        }
+
+    private:
+        /**
+         * @brief Cached field data of a file together with the flag marking it as parsed
+         */
+        struct CacheEntry {
+            std::once_flag parsed;
+            FieldData<T> field_data;
+        };
+
+        /**
+         * @brief Header information of a field file, read without the field values
+         */
+        struct FileHeader {
+            std::string header;
+            std::array<size_t, 3> dimensions{};
+            std::array<T, 3> size{};
+            size_t number_of_values{};
+            // Units stated in INIT files
+            std::string units;
+            // Format version of APF files
+            std::uint32_t version{};
+            // Offset of the body of INIT files in bytes
+            size_t body_offset{};
+        };
+
+        /**
+         * @brief Parse a file, deducing its format from the content
+         * @param path    Canonical path of the input file to be parsed
+         * @param units   Optional units to convert the field from after reading from file
+         * @param cache_init Read and write the memory-mappable cache of INIT files
+         * @param subset  Sub-volume and downsampling to apply
+         * @return        Field data object read from file
+         */
+        FieldData<T> parse_file(const std::filesystem::path& path,
+                                const std::string& units,
+                                bool cache_init,
+                                const FieldSubset& subset) {
             // Deduce the file format
             auto file_type = guess_file_type(path);
-            LOG(DEBUG) << "Assuming file type \"" << (file_type == FileType::APF ? "APF" : "INIT") << "\"";
+            LOG(DEBUG) << "Assuming file type \""
+                       << (file_type == FileType::MAPPED ? "MAPPED" : file_type == FileType::APF ? "APF" : "INIT") << "\"";
 
             FieldData<T> field_data;
             switch(file_type) {
@@ -206,24 +492,34 @@ namespace allpix {
                     LOG(WARNING) << "No field units provided, interpreting field data in internal units, this might lead to "
                                     "unexpected results.";
                 }
-                field_data = parse_init_file(path, units);
+                field_data = (cache_init ? parse_cached_init_file(path, units) : parse_init_file(path, units));
+                if(!subset.isFull()) {
+                    field_data = subset_field_data(field_data, subset);
+                }
                 break;
             case FileType::APF:
                 if(!units.empty()) {
                     LOG(DEBUG) << "Units will be ignored, APF file content is interpreted in internal units.";
                 }
-                field_data = parse_apf_file(path);
+                field_data = (subset.isFull() ? parse_apf_file(path) : parse_apf_subset(path, subset));
+                break;
+            case FileType::MAPPED:
+                if(!units.empty()) {
+                    LOG(DEBUG) << "Units will be ignored, mapped APF file content is interpreted in internal units.";
+                }
+                field_data = parse_mapped_file(path);
+                if(!subset.isFull()) {
+                    // Only the pages of the mapped file holding the selected cells are read
+                    field_data = subset_field_data(field_data, subset);
+                }
                 break;
             default:
                 throw std::runtime_error("unknown file format");
             }
 
-            // Store the parsed field data for further reference:
-            field_map_[path] = field_data;
             return field_data;
         }
 
-    private:
         /**
          * @brief Check if the file is a binary file
          * @param path The path to the file to be checked check
@@ -242,17 +538,116 @@ namespace allpix {
             return false;
         }
 
+        /**
+         * @brief Check if the file is a memory-mappable field file
+         * @param path The path to the file to be checked
+         * @return True if the file starts with the magic bytes of the mapped format, false otherwise
+         */
+        bool file_is_mapped(const std::filesystem::path& path) const {
+            std::ifstream file(path, std::ios::binary);
+            MappedFieldHeader header;
+            decltype(header.magic) magic{};
+            file.read(magic.data(), static_cast<std::streamsize>(magic.size()));
+            return file.good() && magic == header.magic;
+        }
+
         /**
          * @brief Function to guess the type of a field data file
          * @param path Path to the file to be tested
          * @return Type of the file
          *
-         * This function checks if the file contains binary data to interpret it as APF formator INIT format otherwise.
+         * This function checks for the magic bytes of the mapped format first, then if the file contains binary data to
+         * interpret it as APF format or INIT format otherwise.
          */
         FileType guess_file_type(const std::filesystem::path& path) const {
+            if(file_is_mapped(path)) {
+                return FileType::MAPPED;
+            }
             return (file_is_binary(path) ? FileType::APF : FileType::INIT);
         }
 
+        /**
+         * @brief Map a file read-only into memory
+         * @param file_name  File name (as canonical path) of the file to be mapped
+         * @param min_length Minimum length of the file in bytes
+         * @return Pointer to the mapped file, which is unmapped once the last copy is gone, and the length of the file
+         */
+        static std::pair<std::shared_ptr<const char>, size_t> map_file(const std::filesystem::path& file_name,
+                                                                       size_t min_length) {
+            auto fd = ::open(file_name.c_str(), O_RDONLY);
+            if(fd < 0) {
+                throw std::runtime_error("could not open file for mapping");
+            }
+            struct stat file_stat {};
+            if(::fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < std::max<size_t>(min_length, 1)) {
+                ::close(fd);
+                throw std::runtime_error("unexpected end of file");
+            }
+            auto length = static_cast<size_t>(file_stat.st_size);
+            auto* address = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if(address == MAP_FAILED) { // NOLINT
+                throw std::runtime_error("could not map file into memory");
+            }
+
+            // Unmap the file once the last user of the field data is gone
+            auto mapping = std::shared_ptr<const char>(static_cast<const char*>(address), [length](const char* ptr) {
+                ::munmap(const_cast<char*>(ptr), length); // NOLINT
+            });
+            return {std::move(mapping), length};
+        }
+
+        /**
+         * @brief Function to map FieldData from a memory-mappable APF file into memory without copying. The file is mapped
+         * read-only such that its pages are shared between all processes using the same field file. As for APF files, all
+         * values are given in framework-internal base units.
+         * @param file_name  File name (as canonical path) of the input file to be mapped
+         */
+        FieldData<T> parse_mapped_file(const std::filesystem::path& file_name) {
+            auto [mapping, length] = map_file(file_name, sizeof(MappedFieldHeader));
+
+            // Check the header
+            MappedFieldHeader header;
+            std::memcpy(&header, mapping.get(), sizeof(header));
+            if(header.magic != MappedFieldHeader().magic) {
+                throw std::runtime_error("invalid file type");
+            }
+            if(header.version != APF_MAPPED_FORMAT_VERSION) {
+                throw std::runtime_error("unknown format version " + std::to_string(header.version));
+            }
+            if(header.endianness != MappedFieldHeader().endianness || header.value_size != sizeof(T)) {
+                throw std::runtime_error("incompatible data representation");
+            }
+            if(header.components != N_) {
+                throw std::runtime_error("invalid data");
+            }
+            // Bound all sizes by the length of the file before combining them, such that no sum or product overflows
+            if(header.header_length > length - sizeof(header) || header.data_offset > length ||
+               header.data_offset < sizeof(header) + header.header_length || header.data_offset % alignof(T) != 0 ||
+               header.values > (length - header.data_offset) / sizeof(T)) {
+                throw std::runtime_error("invalid data");
+            }
+            std::uint64_t expected_values = N_;
+            for(auto dimension : header.dimensions) {
+                if(dimension != 0 && expected_values > header.values / dimension) {
+                    throw std::runtime_error("invalid data");
+                }
+                expected_values *= dimension;
+            }
+            if(header.values != expected_values) {
+                throw std::runtime_error("invalid data");
+            }
+
+            std::string header_string(mapping.get() + sizeof(header), header.header_length);
+            auto values = std::shared_ptr<const T>(mapping, reinterpret_cast<const T*>(mapping.get() + header.data_offset));
+            LOG(DEBUG) << "Mapped " << header.values << " field values from file without copying";
+
+            std::array<size_t, 3> dimensions{{header.dimensions[0], header.dimensions[1], header.dimensions[2]}};
+            std::array<T, 3> size{
+                {static_cast<T>(header.size[0]), static_cast<T>(header.size[1]), static_cast<T>(header.size[2])}};
+            return FieldData<T>(header_string, dimensions, size, std::move(values), header.values);
+        }
+
         /**
          * @brief Function to deserialize FieldData from an APF file, using the cereal library. This does not convert any
          * units, i.e. all values stored in APF files are given framework-internal base units. This includes the field data
@@ -276,10 +671,174 @@ namespace allpix {
             if(field_data.getData()->size() != dimensions[0] * dimensions[1] * dimensions[2] * N_) {
                 throw std::runtime_error("invalid data");
             }
+            auto refinement = field_data.getRefinement();
+            if(refinement != nullptr) {
+                if(!refinement->isConsistent(dimensions, N_)) {
+                    throw std::runtime_error("invalid refinement data");
+                }
+                LOG(DEBUG) << "Field contains " << refinement->values.size() / N_ << " values in refined cells";
+            }
 
             return field_data;
         }
 
+        /**
+         * @brief Read the header of an APF file up to the first field value
+         * @param archive Archive reading from the beginning of the APF file
+         * @return Header information of the file, the archive is positioned at the first field value
+         *
+         * This reads the same sequence as the deserialization of FieldData, but stops after the size tag of the value
+         * vector.
+         */
+        FileHeader read_apf_header(cereal::PortableBinaryInputArchive& archive) const {
+            FileHeader header;
+            archive(header.version);
+            if(header.version != 1 && header.version != 2) {
+                throw std::runtime_error("unknown format version " + std::to_string(header.version));
+            }
+            archive(header.header);
+            archive(header.dimensions);
+            archive(header.size);
+
+            // The value vector is stored behind the identifier of its shared pointer
+            std::uint32_t pointer_id = 0;
+            archive(pointer_id);
+            cereal::size_type values = 0;
+            if((pointer_id & cereal::detail::msb_32bit) != 0) {
+                archive(cereal::make_size_tag(values));
+            }
+            header.number_of_values = static_cast<size_t>(values);
+            if(header.number_of_values != header.dimensions[0] * header.dimensions[1] * header.dimensions[2] * N_) {
+                throw std::runtime_error("invalid data");
+            }
+            return header;
+        }
+
+        /**
+         * @brief Read a sub-volume of the field from an APF file without reading the full field into memory
+         * @param file_name File name (as canonical path) of the input file to be parsed
+         * @param subset    Sub-volume and downsampling to apply
+         * @return Field data object holding the selected cells only
+         */
+        FieldData<T> parse_apf_subset(const std::filesystem::path& file_name, const FieldSubset& subset) {
+            std::ifstream file(file_name, std::ios::binary);
+            try {
+                // The archive reads directly from the file buffer, such that the file can be repositioned between reads
+                cereal::PortableBinaryInputArchive archive(file);
+                auto header = read_apf_header(archive);
+                auto data_offset = static_cast<std::streamoff>(file.tellg());
+
+                if(header.version >= 2) {
+                    file.seekg(data_offset + static_cast<std::streamoff>(header.number_of_values * sizeof(T)));
+                    bool refined = false;
+                    archive(refined);
+                    if(refined) {
+                        throw std::runtime_error("fields with refined cells cannot be cropped or downsampled");
+                    }
+                }
+
+                const auto dimensions = header.dimensions;
+                return subset_field(header, subset, [&](size_t x, size_t y, size_t z, size_t count, T* line) {
+                    auto offset = ((x * dimensions[1] + y) * dimensions[2] + z) * N_ * sizeof(T);
+                    file.seekg(data_offset + static_cast<std::streamoff>(offset));
+                    archive(cereal::binary_data(line, count * N_ * sizeof(T)));
+                });
+            } catch(cereal::Exception& e) {
+                throw std::runtime_error(e.what());
+            }
+        }
+
+        /**
+         * @brief Select a sub-volume of field data held in memory or mapped from a file
+         * @param field_data Field data to select the cells from
+         * @param subset     Sub-volume and downsampling to apply
+         * @return Field data object holding the selected cells only
+         */
+        FieldData<T> subset_field_data(const FieldData<T>& field_data, const FieldSubset& subset) const {
+            if(field_data.getRefinement() != nullptr) {
+                throw std::runtime_error("fields with refined cells cannot be cropped or downsampled");
+            }
+
+            FileHeader header;
+            header.header = field_data.getHeader();
+            header.dimensions = field_data.getDimensions();
+            header.size = field_data.getSize();
+            header.number_of_values = field_data.getNumberOfValues();
+
+            const auto values = field_data.getValues();
+            const auto dimensions = header.dimensions;
+            return subset_field(header, subset, [&](size_t x, size_t y, size_t z, size_t count, T* line) {
+                const T* first = values.get() + ((x * dimensions[1] + y) * dimensions[2] + z) * N_;
+                std::copy(first, first + count * N_, line);
+            });
+        }
+
+        /**
+         * @brief Select a sub-volume of a field and average blocks of cells
+         * @param header    Header information of the full field
+         * @param subset    Sub-volume and downsampling to apply
+         * @param read_line Function reading a number of cells along z, starting at the given cell, into a buffer
+         * @return Field data object holding the selected cells only
+         *
+         * The selected cells are read line by line along z, the innermost dimension of the field data, such that only the
+         * lines within the region are read from the source.
+         */
+        template <typename ReadLine>
+        FieldData<T> subset_field(const FileHeader& header, const FieldSubset& subset, ReadLine read_line) const {
+            const auto& factor = subset.downsampling;
+            std::array<size_t, 3> begin{}, dimensions{};
+            std::array<T, 3> size{};
+            for(size_t i = 0; i < 3; ++i) {
+                if(factor[i] == 0 || subset.region_min[i] < 0 || !(subset.region_min[i] < subset.region_max[i])) {
+                    throw std::runtime_error("invalid field region or downsampling factor");
+                }
+
+                // Extend the region to full cells
+                auto cell = static_cast<double>(header.size[i]) / static_cast<double>(header.dimensions[i]);
+                auto cells = static_cast<double>(header.dimensions[i]);
+                auto first = static_cast<size_t>(std::min(std::floor(subset.region_min[i] / cell), cells));
+                auto last = static_cast<size_t>(std::min(std::ceil(subset.region_max[i] / cell), cells));
+
+                dimensions[i] = (last - first) / factor[i];
+                if(dimensions[i] == 0) {
+                    throw std::runtime_error("no complete block of " + std::to_string(factor[i]) +
+                                             " cells within the field region in " + "xyz"[i]);
+                }
+                auto dropped = last - first - dimensions[i] * factor[i];
+                if(dropped > 0) {
+                    LOG(WARNING) << "Dropping " << dropped << " cells at the upper end of the field region in " << "xyz"[i]
+                                 << ", not filling a complete block of " << factor[i] << " cells";
+                }
+                begin[i] = first;
+                size[i] = static_cast<T>(static_cast<double>(dimensions[i] * factor[i]) * cell);
+            }
+
+            // Sum up the cells of every block, reading one line along z at a time
+            auto field = std::make_shared<std::vector<T>>(dimensions[0] * dimensions[1] * dimensions[2] * N_, T());
+            std::vector<T> line(dimensions[2] * factor[2] * N_);
+            for(size_t x = 0; x < dimensions[0] * factor[0]; ++x) {
+                for(size_t y = 0; y < dimensions[1] * factor[1]; ++y) {
+                    read_line(begin[0] + x, begin[1] + y, begin[2], dimensions[2] * factor[2], line.data());
+                    T* block = field->data() + ((x / factor[0]) * dimensions[1] + y / factor[1]) * dimensions[2] * N_;
+                    for(size_t z = 0; z < dimensions[2] * factor[2]; ++z) {
+                        for(size_t j = 0; j < N_; ++j) {
+                            block[(z / factor[2]) * N_ + j] += line[z * N_ + j];
+                        }
+                    }
+                }
+            }
+            const auto block_size = static_cast<T>(factor[0] * factor[1] * factor[2]);
+            for(auto& value : *field) {
+                value /= block_size;
+            }
+
+            LOG(INFO) << "Selected " << dimensions[0] << "x" << dimensions[1] << "x" << dimensions[2]
+                      << " cells of field with " << header.dimensions[0] << "x" << header.dimensions[1] << "x"
+                      << header.dimensions[2] << " cells, starting at cell (" << begin[0] << "," << begin[1] << ","
+                      << begin[2] << ")";
+            return FieldData<T>(header.header, dimensions, size, field);
+        }
+
         /**
          * @brief Helper function to compare potential units defined in the INIT file against the ones provided:
          * @param file_units Unit string read from the file
@@ -304,32 +863,111 @@ namespace allpix {
         }
 
         /**
-         * @brief Function to read FieldData from INIT-formatted ASCII files. Values are interpreted in the units provided by
-         * the argument and converted to the framework-internal base units. The size of the field given in the file is always
-         * interpreted as micrometers.
+         * @brief Read FieldData from INIT-formatted ASCII files via their memory-mappable cache
          * @param file_name  File name (as canonical path) of the input file to be parsed
          * @param units      Units to convert the values of the field data from
+         *
+         * The cache holds the values in framework-internal units and is therefore specific to the units. It is written
+         * under a temporary name and renamed once complete, such that concurrent jobs never read an incomplete cache. A
+         * cache which cannot be written, e.g. in a read-only directory, only leads to a warning.
          */
-        FieldData<T> parse_init_file(const std::filesystem::path& file_name, const std::string& units) {
-            // Load file
+        FieldData<T> parse_cached_init_file(const std::filesystem::path& file_name, const std::string& units) {
+            auto unit_tag = units;
+            std::replace(unit_tag.begin(), unit_tag.end(), '/', '_');
+            auto cache_name = file_name;
+            cache_name += (unit_tag.empty() ? "" : "." + unit_tag) + ".cache";
+
+            std::error_code error;
+            auto cache_time = std::filesystem::last_write_time(cache_name, error);
+            if(!error && cache_time >= std::filesystem::last_write_time(file_name)) {
+                try {
+                    auto field_data = parse_mapped_file(cache_name);
+                    LOG(INFO) << "Using memory-mappable cache " << cache_name << " of INIT file";
+                    return field_data;
+                } catch(std::runtime_error& e) {
+                    LOG(WARNING) << "Ignoring invalid cache " << cache_name << " of INIT file: " << e.what();
+                }
+            }
+
+            auto field_data = parse_init_file(file_name, units);
+            try {
+                auto temporary_name = cache_name;
+                temporary_name += "." + std::to_string(::getpid());
+                FieldWriter<T>(N_ == 1 ? FieldQuantity::SCALAR : FieldQuantity::VECTOR)
+                    .writeFile(field_data, temporary_name, FileType::MAPPED);
+                std::filesystem::rename(temporary_name, cache_name);
+                LOG(INFO) << "Stored memory-mappable cache " << cache_name << " of INIT file";
+            } catch(std::exception& e) {
+                LOG(WARNING) << "Cannot store cache " << cache_name << " of INIT file: " << e.what();
+            }
+            return field_data;
+        }
+
+        /**
+         * @brief Parse the next whitespace-separated number of the body of an INIT file
+         * @param position Position to start from, advanced behind the number
+         * @param end      End of the chunk of the body
+         * @param value    Value read
+         * @return False if the chunk ends before the next number
+         * @throws std::runtime_error if the next characters are not a valid number
+         */
+        template <typename V> static bool next_init_value(const char*& position, const char* end, V& value) {
+            while(position != end && (*position == ' ' || *position == '\t' || *position == '\n' || *position == '\r')) {
+                ++position;
+            }
+            if(position == end) {
+                return false;
+            }
+            // Leading plus signs are accepted by stream extraction but not by std::from_chars
+            if(*position == '+') {
+                ++position;
+            }
+
+            std::from_chars_result result{};
+            if constexpr(std::is_floating_point_v<V>) {
+#if defined(__cpp_lib_to_chars)
+                result = std::from_chars(position, end, value);
+#else
+                // Floating point conversion of std::from_chars is not available in all supported standard libraries
+                char buffer[64]; // NOLINT
+                auto length = std::min<size_t>(static_cast<size_t>(end - position), sizeof(buffer) - 1);
+                std::memcpy(buffer, position, length);
+                buffer[length] = '\0';
+                char* number_end = nullptr;
+                value = static_cast<V>(std::strtod(buffer, &number_end));
+                result.ptr = position + (number_end - buffer);
+                result.ec = (number_end == buffer ? std::errc::invalid_argument : std::errc());
+#endif
+            } else {
+                result = std::from_chars(position, end, value);
+            }
+            if(result.ec != std::errc()) {
+                throw std::runtime_error("invalid data");
+            }
+            position = result.ptr;
+            return true;
+        }
+
+        /**
+         * @brief Read the header of an INIT file
+         * @param file_name File name (as canonical path) of the input file
+         * @return Header information of the file, with the size converted from micrometers to internal units
+         */
+        FileHeader read_init_header(const std::filesystem::path& file_name) const {
             std::ifstream file(file_name);
-            std::string header;
-            std::getline(file, header);
-            LOG(TRACE) << "Header of file " << file_name << " is " << std::endl << header;
+            FileHeader header;
+            std::getline(file, header.header);
+            LOG(TRACE) << "Header of file " << file_name << " is " << std::endl << header.header;
 
             // Read the header
             std::string tmp;
             // WARNING the usage of this field as storage for the field units differs from the original INIT format!
-            file >> tmp;
-            check_unit_match(allpix::trim(tmp), units);
+            file >> header.units;
             file >> tmp;               // ignore cluster length
             file >> tmp >> tmp >> tmp; // ignore the incident pion direction
             file >> tmp >> tmp >> tmp; // ignore the magnetic field (specify separately)
             double thickness = NAN, xpixsz = NAN, ypixsz = NAN;
             file >> thickness >> xpixsz >> ypixsz;
-            thickness = Units::get(thickness, "um");
-            xpixsz = Units::get(xpixsz, "um");
-            ypixsz = Units::get(ypixsz, "um");
             file >> tmp >> tmp >> tmp >> tmp; // ignore temperature, flux, rhe (?) and new_drde (?)
             size_t xsize = 0, ysize = 0, zsize = 0;
             file >> xsize >> ysize >> zsize;
@@ -338,48 +976,110 @@ namespace allpix {
             if(file.fail()) {
                 throw std::runtime_error("invalid data or unexpected end of file");
             }
+            header.body_offset = static_cast<size_t>(file.tellg());
+            header.dimensions = {{xsize, ysize, zsize}};
+            header.size = {{static_cast<T>(Units::get(xpixsz, "um")),
+                            static_cast<T>(Units::get(ypixsz, "um")),
+                            static_cast<T>(Units::get(thickness, "um"))}};
+            header.number_of_values = xsize * ysize * zsize * N_;
+            return header;
+        }
+
+        /**
+         * @brief Function to read FieldData from INIT-formatted ASCII files. Values are interpreted in the units provided by
+         * the argument and converted to the framework-internal base units. The size of the field given in the file is always
+         * interpreted as micrometers.
+         * @param file_name  File name (as canonical path) of the input file to be parsed
+         * @param units      Units to convert the values of the field data from
+         *
+         * The body of the file is memory-mapped and split at line boundaries into chunks, which are parsed concurrently.
+         * Every vertex is stored on a separate line and carries its indices, such that the chunks write their values
+         * directly to the final position in the field.
+         */
+        FieldData<T> parse_init_file(const std::filesystem::path& file_name, const std::string& units) {
+            auto header = read_init_header(file_name);
+            check_unit_match(allpix::trim(header.units), units);
+            const auto xsize = header.dimensions[0], ysize = header.dimensions[1], zsize = header.dimensions[2];
+            const auto body_offset = header.body_offset;
+
             auto field = std::make_shared<std::vector<double>>();
             auto vertices = xsize * ysize * zsize;
             field->resize(vertices * N_);
-
-            // Loop through all the field data
-            for(size_t i = 0; i < vertices; ++i) {
-                if(vertices >= 100 && i % (vertices / 100) == 0) {
-                    LOG_PROGRESS(INFO, "read_init") << "Reading field data: " << (100 * i / vertices) << "%";
-                }
-
-                if(file.eof()) {
-                    throw std::runtime_error("unexpected end of file");
-                }
-
-                // Get index of field
-                size_t xind = 0, yind = 0, zind = 0;
-                file >> xind >> yind >> zind;
-
-                if(file.fail() || xind > xsize || yind > ysize || zind > zsize) {
-                    throw std::runtime_error("invalid data");
+            const auto unit_factor = Units::get(units);
+
+            // Split the body into chunks of at least one megabyte, ending at line boundaries
+            auto [mapping, length] = map_file(file_name, body_offset);
+            const char* body = mapping.get() + body_offset;
+            const char* body_end = mapping.get() + length;
+            auto body_length = static_cast<size_t>(body_end - body);
+            auto threads_available = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+            auto chunks = std::clamp<size_t>(body_length / (1024 * 1024), 1, threads_available);
+            std::vector<const char*> bounds{body};
+            for(size_t chunk = 1; chunk < chunks; ++chunk) {
+                const char* bound = body + body_length * chunk / chunks;
+                bound = std::max(bound, bounds.back());
+                const auto* line_end =
+                    static_cast<const char*>(std::memchr(bound, '\n', static_cast<size_t>(body_end - bound)));
+                bounds.push_back(line_end == nullptr ? body_end : line_end + 1);
+            }
+            bounds.push_back(body_end);
+            LOG(DEBUG) << "Parsing " << vertices << " vertices of INIT file in " << chunks << " chunks";
+
+            std::vector<size_t> parsed_vertices(chunks);
+            std::vector<std::exception_ptr> exceptions(chunks);
+            auto parse_chunk = [&](size_t chunk) {
+                try {
+                    const char* position = bounds[chunk];
+                    const char* end = bounds[chunk + 1];
+                    size_t xind = 0, yind = 0, zind = 0;
+                    while(next_init_value(position, end, xind)) {
+                        if(!next_init_value(position, end, yind) || !next_init_value(position, end, zind) || xind == 0 ||
+                           yind == 0 || zind == 0 || xind > xsize || yind > ysize || zind > zsize) {
+                            throw std::runtime_error("invalid data");
+                        }
+                        auto index = ((xind - 1) * ysize * zsize + (yind - 1) * zsize + (zind - 1)) * N_;
+
+                        // Loop through components of field
+                        for(size_t j = 0; j < N_; ++j) {
+                            double input = NAN;
+                            if(!next_init_value(position, end, input)) {
+                                throw std::runtime_error("invalid data");
+                            }
+                            (*field)[index + j] = static_cast<double>(input * unit_factor);
+                        }
+                        ++parsed_vertices[chunk];
+                    }
+                } catch(...) {
+                    exceptions[chunk] = std::current_exception();
                 }
-                xind--;
-                yind--;
-                zind--;
-
-                // Loop through components of field
-                for(size_t j = 0; j < N_; ++j) {
-                    double input = NAN;
-                    file >> input;
+            };
 
-                    // Set the field at a position
-                    (*field)[xind * ysize * zsize * N_ + yind * zsize * N_ + zind * N_ + j] = Units::get(input, units);
+            // Parse the first chunk on the calling thread
+            std::vector<std::thread> threads;
+            threads.reserve(chunks - 1);
+            for(size_t chunk = 1; chunk < chunks; ++chunk) {
+                threads.emplace_back(parse_chunk, chunk);
+            }
+            parse_chunk(0);
+            for(auto& thread : threads) {
+                thread.join();
+            }
+            for(const auto& exception : exceptions) {
+                if(exception) {
+                    std::rethrow_exception(exception);
                 }
             }
-            LOG_PROGRESS(INFO, "read_init") << "Reading field data: finished.";
+            if(std::accumulate(parsed_vertices.begin(), parsed_vertices.end(), size_t(0)) < vertices) {
+                throw std::runtime_error("unexpected end of file");
+            }
+            LOG(INFO) << "Reading field data: finished.";
 
-            return FieldData<T>(
-                header, std::array<size_t, 3>{{xsize, ysize, zsize}}, std::array<T, 3>{{xpixsz, ypixsz, thickness}}, field);
+            return FieldData<T>(header.header, header.dimensions, header.size, field);
         }
 
         size_t N_;
-        std::map<std::filesystem::path, FieldData<T>> field_map_;
+        std::map<std::pair<std::filesystem::path, std::string>, std::unique_ptr<CacheEntry>> field_map_;
+        std::mutex field_map_mutex_;
     };
 
     /**
@@ -405,7 +1105,8 @@ namespace allpix {
          * @param file_name  File name (as canonical path) of the output file to be created
          * @param file_type  Type of file (file format) to be produced
          * @param units      Optional units to convert the field into before writing. Only used by some formats.
-         * @throws std::runtime_error if the file format is unknown or invalid field dimensions are detected
+         * @throws std::runtime_error if the file format is unknown or cannot store the field, or invalid field dimensions
+         * are detected
          * @throws std::filesystem::filesystem_error if the provided path does not exist
          */
         void writeFile(const FieldData<T>& field_data,
@@ -416,10 +1117,14 @@ namespace allpix {
             auto path = std::filesystem::weakly_canonical(file_name);
 
             auto dimensions = field_data.getDimensions();
-            if(field_data.getData()->size() != N_ * dimensions[0] * dimensions[1] * dimensions[2]) {
+            if(field_data.getNumberOfValues() != N_ * dimensions[0] * dimensions[1] * dimensions[2]) {
                 throw std::runtime_error("invalid field dimensions");
             }
 
+            if(field_data.getRefinement() != nullptr && file_type != FileType::APF) {
+                throw std::runtime_error("refined field cells can only be stored in APF files");
+            }
+
             switch(file_type) {
             case FileType::INIT:
                 if(units.empty()) {
@@ -433,6 +1138,12 @@ namespace allpix {
                 }
                 write_apf_file(field_data, path);
                 break;
+            case FileType::MAPPED:
+                if(!units.empty()) {
+                    LOG(WARNING) << "Units will be ignored, mapped APF file content is written in internal units.";
+                }
+                write_mapped_file(field_data, path);
+                break;
             default:
                 throw std::runtime_error("unknown file format");
             }
@@ -449,15 +1160,57 @@ namespace allpix {
         void write_apf_file(const FieldData<T>& field_data, const std::filesystem::path& file_name) {
             std::ofstream file(file_name, std::ios::binary);
 
-            // Write the file with cereal:
+            // Write the file with cereal, memory-mapped field data needs to be owned for serialization:
             try {
                 cereal::PortableBinaryOutputArchive archive(file);
-                archive(field_data);
+                if(field_data.isMapped()) {
+                    archive(FieldData<T>(
+                        field_data.getHeader(), field_data.getDimensions(), field_data.getSize(), field_data.getData()));
+                } else {
+                    archive(field_data);
+                }
             } catch(cereal::Exception& e) {
                 throw std::runtime_error(e.what());
             }
         }
 
+        /**
+         * @brief Function to write FieldData into a memory-mappable APF file. The raw field data is written in the native
+         * floating point representation, aligned to the page size, such that it can be used directly after mapping the file.
+         * No units are converted, i.e. all values are stored in framework-internal base units.
+         * @param field_data Field data object to store
+         * @param file_name  File name (as canonical path) of the output file to be created
+         */
+        void write_mapped_file(const FieldData<T>& field_data, const std::filesystem::path& file_name) {
+            std::ofstream file(file_name, std::ios::binary);
+
+            auto header_string = field_data.getHeader();
+            auto dimensions = field_data.getDimensions();
+            auto size = field_data.getSize();
+
+            MappedFieldHeader header;
+            header.value_size = sizeof(T);
+            header.components = static_cast<std::uint32_t>(N_);
+            header.dimensions = {{dimensions[0], dimensions[1], dimensions[2]}};
+            header.size = {{static_cast<double>(size[0]), static_cast<double>(size[1]), static_cast<double>(size[2])}};
+            header.header_length = header_string.size();
+            header.data_offset = (sizeof(header) + header.header_length + mapped_field_alignment - 1) /
+                                 mapped_field_alignment * mapped_field_alignment;
+            header.values = field_data.getNumberOfValues();
+
+            // Write header, header string, padding and field data
+            std::vector<char> padding(header.data_offset - sizeof(header) - header.header_length, '\0');
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(header_string.data(), static_cast<std::streamsize>(header_string.size()));
+            file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+            file.write(reinterpret_cast<const char*>(field_data.getValues().get()),
+                       static_cast<std::streamsize>(header.values * sizeof(T)));
+
+            if(!file.good()) {
+                throw std::runtime_error("could not write field data to file");
+            }
+        }
+
         /**
          * @brief Function to write FieldData objects out to INIT-formatted ASCII files. Values are converted from the
          * framework-internal base units in which the data is stored in FieldData into the units provided by the units
@@ -487,9 +1240,10 @@ namespace allpix {
             file << dimensions[0] << " " << dimensions[1] << " " << dimensions[2] << " "; // Field grid dimensions (x, y, z)
             file << "0.0" << std::endl;                                                   // Unused
 
-            // Write the data block:
-            auto data = field_data.getData();
-            auto max_points = data->size() / N_;
+            // Write the data block directly from the field values, such that memory-mapped fields are not copied:
+            const auto* values = field_data.getValues().get();
+            const auto unit_factor = Units::convert(1, units);
+            auto max_points = field_data.getNumberOfValues() / N_;
 
             for(size_t xind = 0; xind < dimensions[0]; ++xind) {
                 for(size_t yind = 0; yind < dimensions[1]; ++yind) {
@@ -500,9 +1254,9 @@ namespace allpix {
                         // Vector or scalar field:
                         for(size_t j = 0; j < N_; j++) {
                             file << " "
-                                 << Units::convert(data->at(xind * dimensions[1] * dimensions[2] * N_ +
-                                                            yind * dimensions[2] * N_ + zind * N_ + j),
-                                                   units);
+                                 << static_cast<Units::UnitType>(values[xind * dimensions[1] * dimensions[2] * N_ +
+                                                                        yind * dimensions[2] * N_ + zind * N_ + j]) *
+                                        unit_factor;
                         }
                         // End this line
                         file << std::endl;
@@ -0,0 +1,83 @@
+/**
+ * @file
+ * @brief Definition of locally refined cells of field grids
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_FIELD_REFINEMENT_H
+#define ALLPIX_FIELD_REFINEMENT_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace allpix {
+
+    /**
+     * @brief Refined cells of a field grid
+     *
+     * A field grid is stored with a coarse binning for the full field, while selected cells of this grid can be subdivided
+     * into a brick of finer cells, e.g. close to implants where the field varies strongly. Every refined cell is split into
+     * the same number of sub-cells along each axis with more than one bin, axes with a single bin are never subdivided. The
+     * values of a brick are stored in the same order as the coarse grid, i.e. the i-th component of the sub-cell (x, y, z)
+     * is found at x * Y_SUB * Z_SUB * N + y * Z_SUB * N + z * N + i, and the bricks follow each other in one flat array.
+     */
+    struct FieldRefinement {
+        /**
+         * @brief Brick index of coarse cells which are not refined
+         */
+        static constexpr std::uint32_t unrefined = std::numeric_limits<std::uint32_t>::max();
+
+        /**
+         * @brief Get the number of sub-cells along each axis of a refined cell
+         * @param bins Number of bins of the coarse grid
+         * @return Number of sub-cells in x, y and z
+         */
+        std::array<size_t, 3> getFactors(const std::array<size_t, 3>& bins) const {
+            return {{bins[0] == 1 ? 1 : factor, bins[1] == 1 ? 1 : factor, bins[2] == 1 ? 1 : factor}};
+        }
+
+        /**
+         * @brief Check if the refinement can be applied to a coarse grid
+         * @param bins Number of bins of the coarse grid
+         * @param components Number of components of each field value
+         * @return True if there is one entry per coarse cell, all bricks are complete and referenced bricks exist
+         */
+        bool isConsistent(const std::array<size_t, 3>& bins, size_t components) const {
+            if(factor == 0 || bricks.size() != bins[0] * bins[1] * bins[2]) {
+                return false;
+            }
+            auto factors = getFactors(bins);
+            auto brick_size = factors[0] * factors[1] * factors[2] * components;
+            if(values.size() % brick_size != 0) {
+                return false;
+            }
+            auto number_of_bricks = values.size() / brick_size;
+            for(auto brick : bricks) {
+                if(brick != unrefined && brick >= number_of_bricks) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        size_t factor{1};                  ///< Number of sub-cells of a refined cell along each axis
+        std::vector<std::uint32_t> bricks; ///< Brick index for each cell of the coarse grid or unrefined
+        std::vector<double> values;        ///< Flat array of the values of all bricks
+
+        /**
+         * @brief Serialization of the refinement
+         * @param archive Archive to (de-)serialize from or to
+         */
+        template <class Archive> void serialize(Archive& archive) { archive(factor, bricks, values); }
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_FIELD_REFINEMENT_H */
@@ -40,7 +40,25 @@ void MTRunManager::Run(G4int n_event, uint64_t seed1, uint64_t seed2) { // NOLIN
     worker_run_manager_->seedsQueue.push(static_cast<long>(seed2 % LONG_MAX));
 
     // redirect the call to the correct manager responsible for this thread
-    worker_run_manager_->BeamOn(n_event);
+    if(persistent_run_) {
+        worker_run_manager_->ProcessEvents(n_event);
+    } else {
+        worker_run_manager_->BeamOn(n_event);
+    }
+}
+
+void MTRunManager::RunSubEvent(const std::function<void(G4Event*)>& generator, // NOLINT
+                               uint64_t seed1,
+                               uint64_t seed2) {
+    // Replace the primary generator of the worker for this event only, also if the event is aborted
+    worker_run_manager_->primary_generator_ = &generator;
+    try {
+        Run(1, seed1, seed2);
+    } catch(...) {
+        worker_run_manager_->primary_generator_ = nullptr;
+        throw;
+    }
+    worker_run_manager_->primary_generator_ = nullptr;
 }
 
 void MTRunManager::Initialize() {
@@ -66,7 +84,11 @@ void MTRunManager::InitializeForThread() { // NOLINT
 void MTRunManager::TerminateForThread() { // NOLINT
     // thread local instance
     if(worker_run_manager_ != nullptr) {
-        worker_run_manager_->RunTermination();
+        if(worker_run_manager_->persistent_run_open_) {
+            worker_run_manager_->EndPersistentRun();
+        } else {
+            worker_run_manager_->RunTermination();
+        }
         delete worker_run_manager_;
         worker_run_manager_ = nullptr;
     }
@@ -12,6 +12,7 @@
 #ifndef ALLPIX_MT_RUN_MANAGER_H
 #define ALLPIX_MT_RUN_MANAGER_H
 
+#include <functional>
 #include <unordered_map>
 
 #include <G4MTRunManager.hh>
@@ -52,6 +53,28 @@ namespace allpix {
          */
         void Run(G4int n_event, uint64_t seed1, uint64_t seed2); // NOLINT
 
+        /**
+         * @brief Simulate a single event with primaries provided by the caller instead of the user generator action
+         * @param generator Function adding the primary vertices to the event
+         * @param seed1 First event seed for the worker run manager of the calling thread
+         * @param seed2 Second event seed for the worker run manager of the calling thread
+         *
+         * Used to simulate part of the secondaries of an event on a different thread. The event is processed by the
+         * worker associated with the calling thread exactly as in \ref Run, only the generation of primaries is replaced.
+         */
+        void RunSubEvent(const std::function<void(G4Event*)>& generator, uint64_t seed1, uint64_t seed2); // NOLINT
+
+        /**
+         * @brief Select whether the workers keep a single Geant4 run open across events
+         * @param persistent_run True to process all events of a worker in one run, false to start a new run for every call
+         *
+         * Starting and terminating a Geant4 run for every event adds considerable overhead for light events. With a
+         * persistent run, each worker initializes its run once and only extends its event loop in every call to \ref Run.
+         * The random number generator is still seeded for every call, such that results per event can be reproduced. This
+         * has to be set before any thread calls \ref Run.
+         */
+        void SetPersistentRun(bool persistent_run) { persistent_run_ = persistent_run; } // NOLINT
+
         /**
          * @brief Initialize the run manager to be ready for run.
          *
@@ -187,6 +210,9 @@ namespace allpix {
         static G4ThreadLocal WorkerRunManager* worker_run_manager_;
 
         std::unique_ptr<SensitiveDetectorAndFieldConstruction> sd_field_construction_{nullptr};
+
+        // Flag whether workers keep their Geant4 run open across events
+        bool persistent_run_{false};
     };
 } // namespace allpix
 
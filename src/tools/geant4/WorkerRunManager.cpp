@@ -71,6 +71,68 @@ void WorkerRunManager::BeamOn(G4int n_event, const char* macroFile, G4int n_sele
     G4RunManager::BeamOn(n_event, macroFile, n_select);
 }
 
+void WorkerRunManager::ProcessEvents(G4int n_event) { // NOLINT
+    // An aborted run cannot be continued, terminate it and start a new one
+    if(persistent_run_open_ && runAborted) {
+        LOG(DEBUG) << "Terminating aborted persistent Geant4 run";
+        EndPersistentRun();
+    }
+
+    if(!persistent_run_open_) {
+        if(!ConfirmBeamOnCondition()) {
+            throw ModuleError("Geant4 is not in a state to start a run");
+        }
+
+        // Execute UI commands stored in the master UI manager
+        std::vector<G4String> cmds = G4MTRunManager::GetMasterRunManager()->GetCommandStack();
+        G4UImanager* uimgr = G4UImanager::GetUIpointer(); // TLS instance
+        for(const auto& cmd : cmds) {
+            uimgr->ApplyCommand(cmd);
+        }
+
+        // Start a run without any events, every call extends it by the requested number of events
+        LOG(DEBUG) << "Starting persistent Geant4 run";
+        fakeRun = false;
+        numberOfEventToBeProcessed = 0;
+        numberOfEventProcessed = 0;
+        ConstructScoringWorlds();
+        RunInitialization();
+        InitializeEventLoop(0, nullptr, -1);
+        persistent_run_open_ = true;
+    }
+
+    if(userPrimaryGeneratorAction == nullptr) {
+        throw ModuleError("G4VUserPrimaryGeneratorAction is not defined!");
+    }
+
+    // Every call should receive exactly one set of random number seeds
+    numberOfEventToBeProcessed += n_event;
+    runIsSeeded = false;
+
+    // Event loop, terminated by GenerateEvent once all requested events have been processed
+    eventLoopOnGoing = true;
+    while(eventLoopOnGoing) {
+        ProcessOneEvent(-1);
+        if(eventLoopOnGoing) {
+            TerminateOneEvent();
+            if(runAborted) {
+                eventLoopOnGoing = false;
+            }
+        }
+    }
+}
+
+void WorkerRunManager::EndPersistentRun() { // NOLINT
+    if(!persistent_run_open_) {
+        return;
+    }
+
+    LOG(DEBUG) << "Terminating persistent Geant4 run after " << numberOfEventProcessed << " events";
+    TerminateEventLoop();
+    RunTermination();
+    persistent_run_open_ = false;
+}
+
 void WorkerRunManager::InitializeGeometry() {
     if(userDetector == nullptr) {
         throw ModuleError("G4VUserDetectorConstruction is not defined!");
@@ -147,7 +209,11 @@ G4Event* WorkerRunManager::GenerateEvent(G4int) {
             runIsSeeded = true;
         }
 
-        userPrimaryGeneratorAction->GeneratePrimaries(anEvent);
+        if(primary_generator_ != nullptr) {
+            (*primary_generator_)(anEvent);
+        } else {
+            userPrimaryGeneratorAction->GeneratePrimaries(anEvent);
+        }
     } else {
         // This flag must be set so the event loop exits if no more events
         // to be processed
@@ -12,6 +12,8 @@
 #ifndef ALLPIX_WORKER_RUN_MANAGER_H
 #define ALLPIX_WORKER_RUN_MANAGER_H
 
+#include <functional>
+
 #include <G4WorkerRunManager.hh>
 
 namespace allpix {
@@ -41,6 +43,22 @@ namespace allpix {
          */
         void BeamOn(G4int n_event, const char* macroFile = nullptr, G4int n_select = -1) override; // NOLINT
 
+        /**
+         * @brief Executes specified number of events within a persistent run
+         * @param n_event number of events
+         *
+         * Starts a run on the first call and keeps it open afterwards, such that the run initialization and termination
+         * are only performed once per worker instead of once per call as for \ref BeamOn. Every call extends the event loop
+         * of the run by the requested number of events and reseeds the random number generator from the seeds queue. A
+         * run which has been aborted is terminated and a new one is started.
+         */
+        void ProcessEvents(G4int n_event); // NOLINT
+
+        /**
+         * @brief Terminates the persistent run if one has been started
+         */
+        void EndPersistentRun(); // NOLINT
+
         void InitializeGeometry() override;
 
         /**
@@ -91,6 +109,12 @@ namespace allpix {
          * Merge the run results with the master results. It will now do nothing.
          */
         void MergePartialResults() override {}
+
+    private:
+        // Flag whether a persistent run has been started and not yet terminated
+        bool persistent_run_open_{false};
+        // Generator replacing the user primary generator action for a single event, see \ref MTRunManager::RunSubEvent
+        const std::function<void(G4Event*)>* primary_generator_{nullptr};
     };
 } // namespace allpix
 
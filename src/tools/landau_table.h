@@ -0,0 +1,125 @@
+/**
+ * @file
+ * @brief Utility to sample energy loss fluctuations from a tabulated, truncated Landau distribution
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_LANDAU_TABLE_H
+#define ALLPIX_LANDAU_TABLE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <Math/PdfFuncMathCore.h>
+#include <Math/ProbFuncMathCore.h>
+
+namespace allpix {
+    /**
+     * @brief Tabulated Landau distribution, truncated at an upper value of the Landau parameter
+     *
+     * The energy loss of a charged particle in a thin layer fluctuates around its mean with a Landau distribution in the
+     * parameter lambda, scaled by the width xi of the layer. Since the mean of the Landau distribution diverges, it is
+     * truncated at the largest energy transfer considered, which yields a finite mean. The cumulative distribution and its
+     * first moment are integrated once, such that both sampling and the truncated mean only require a table lookup.
+     */
+    class LandauTable {
+    public:
+        /**
+         * @brief Get the table shared by all users
+         * @return Reference to the table
+         */
+        static const LandauTable& get() {
+            static const LandauTable table;
+            return table;
+        }
+
+        /**
+         * @brief Draw from the truncated Landau distribution
+         * @param lambda_max Upper limit of the Landau parameter
+         * @param uniform Uniformly distributed random number in [0,1)
+         * @return Landau parameter
+         */
+        double sample(double lambda_max, double uniform) const {
+            auto [index, fraction] = locate(lambda_max);
+            auto cdf = uniform * (cdf_[index] + fraction * (cdf_[index + 1] - cdf_[index]));
+            if(cdf <= cdf_.front()) {
+                return lambda_.front();
+            }
+
+            // Invert the cumulative distribution by interpolating between the entries enclosing the drawn value
+            auto upper = std::upper_bound(cdf_.begin(), cdf_.begin() + static_cast<std::ptrdiff_t>(index) + 2, cdf);
+            auto entry = static_cast<size_t>(std::min(upper, cdf_.end() - 1) - cdf_.begin());
+            return lambda_[entry - 1] +
+                   (cdf - cdf_[entry - 1]) / (cdf_[entry] - cdf_[entry - 1]) * (lambda_[entry] - lambda_[entry - 1]);
+        }
+
+        /**
+         * @brief Mean of the truncated Landau distribution
+         * @param lambda_max Upper limit of the Landau parameter
+         * @return Mean of the Landau parameter
+         */
+        double mean(double lambda_max) const {
+            auto [index, fraction] = locate(lambda_max);
+            auto cdf = cdf_[index] + fraction * (cdf_[index + 1] - cdf_[index]);
+            auto moment = moment_[index] + fraction * (moment_[index + 1] - moment_[index]);
+            return moment / cdf;
+        }
+
+    private:
+        /**
+         * @brief Integrate the cumulative distribution and the first moment of the Landau distribution
+         *
+         * The grid of the table is dense around the peak of the distribution and its spacing increases exponentially in
+         * the tail.
+         */
+        LandauTable() {
+            constexpr size_t points = 20000;
+            constexpr double lambda_min = -5.;
+            constexpr double lambda_max = 1e6;
+            const auto t_max = std::log(lambda_max - lambda_min + 1.);
+
+            lambda_.resize(points);
+            cdf_.resize(points);
+            moment_.resize(points);
+            for(size_t i = 0; i < points; ++i) {
+                lambda_[i] = lambda_min + std::expm1(t_max * static_cast<double>(i) / static_cast<double>(points - 1));
+            }
+
+            cdf_[0] = ROOT::Math::landau_cdf(lambda_min);
+            moment_[0] = lambda_min * cdf_[0];
+            for(size_t i = 1; i < points; ++i) {
+                auto width = lambda_[i] - lambda_[i - 1];
+                auto pdf_low = ROOT::Math::landau_pdf(lambda_[i - 1]);
+                auto pdf_high = ROOT::Math::landau_pdf(lambda_[i]);
+                cdf_[i] = cdf_[i - 1] + (pdf_low + pdf_high) / 2 * width;
+                moment_[i] = moment_[i - 1] + (lambda_[i - 1] * pdf_low + lambda_[i] * pdf_high) / 2 * width;
+            }
+        }
+
+        /**
+         * @brief Find the table position of a Landau parameter
+         * @param lambda Landau parameter
+         * @return Index of the lower table entry and fraction towards the next entry
+         */
+        std::pair<size_t, double> locate(double lambda) const {
+            lambda = std::clamp(lambda, lambda_.front(), lambda_.back());
+            auto index =
+                static_cast<size_t>(std::upper_bound(lambda_.begin(), lambda_.end() - 1, lambda) - lambda_.begin()) - 1;
+            return {index, (lambda - lambda_[index]) / (lambda_[index + 1] - lambda_[index])};
+        }
+
+        std::vector<double> lambda_;
+        std::vector<double> cdf_;
+        std::vector<double> moment_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_LANDAU_TABLE_H */
@@ -24,28 +24,304 @@
 #include <TPolyLine3D.h>
 #include <TPolyMarker3D.h>
 #include <TStyle.h>
+#include <TTree.h>
+
+#include <mutex>
+#include <vector>
 
 namespace allpix {
 
     class LineGraph {
 
     public:
-        using OutputPlotPoints = std::vector<
-            std::pair<std::tuple<double, unsigned int, CarrierType, CarrierState>, std::vector<ROOT::Math::XYZPoint>>>;
+        /**
+         * @brief Trajectories of charge carrier groups recorded during the propagation, stored in columns
+         *
+         * The properties of the trajectories and their points are kept in flat columns instead of a separate vector of
+         * points per trajectory, such that recording a trajectory requires no allocation once the buffer has grown to the
+         * size of an event. Points of different trajectories may be interleaved, e.g. when secondaries are propagated while
+         * the trajectory of their parent is still recorded, every point therefore stores the index of its trajectory.
+         */
+        class OutputPlotPoints {
+            friend class TrajectoryWriter;
+
+        public:
+            /**
+             * @brief Remove all trajectories while keeping the allocated memory
+             */
+            void clear() {
+                time_.clear();
+                charge_.clear();
+                type_.clear();
+                state_.clear();
+                point_count_.clear();
+                point_trajectory_.clear();
+                x_.clear();
+                y_.clear();
+                z_.clear();
+            }
+
+            /**
+             * @brief Reserve memory for the given number of trajectories and points
+             * @param trajectories Expected number of trajectories
+             * @param points Expected total number of points
+             */
+            void reserve(size_t trajectories, size_t points) {
+                time_.reserve(trajectories);
+                charge_.reserve(trajectories);
+                type_.reserve(trajectories);
+                state_.reserve(trajectories);
+                point_count_.reserve(trajectories);
+                point_trajectory_.reserve(points);
+                x_.reserve(points);
+                y_.reserve(points);
+                z_.reserve(points);
+            }
+
+            /**
+             * @brief Start a new trajectory
+             * @param time Global time of the deposit the charge carriers originate from
+             * @param charge Number of charge carriers in the group
+             * @param type Type of the charge carriers
+             * @param state Current state of the charge carriers
+             * @return Index of the new trajectory
+             */
+            size_t addTrajectory(double time, unsigned int charge, CarrierType type, CarrierState state) {
+                time_.push_back(time);
+                charge_.push_back(charge);
+                type_.push_back(type);
+                state_.push_back(state);
+                point_count_.push_back(0);
+                return time_.size() - 1;
+            }
+
+            /**
+             * @brief Add a point to a trajectory
+             * @param trajectory Index of the trajectory
+             * @param point Position of the charge carriers in local coordinates
+             */
+            void addPoint(size_t trajectory, const ROOT::Math::XYZPoint& point) {
+                point_trajectory_.push_back(static_cast<unsigned int>(trajectory));
+                x_.push_back(point.x());
+                y_.push_back(point.y());
+                z_.push_back(point.z());
+                ++point_count_[trajectory];
+            }
+
+            /**
+             * @brief Set the state of the charge carriers of a trajectory
+             * @param trajectory Index of the trajectory
+             * @param state Final state of the charge carriers
+             */
+            void setState(size_t trajectory, CarrierState state) { state_[trajectory] = state; }
+
+            /**
+             * @brief Get the number of trajectories
+             * @return Number of trajectories
+             */
+            size_t size() const { return time_.size(); }
+
+            /**
+             * @brief Get the total number of points of all trajectories
+             * @return Number of points
+             */
+            size_t getNumberOfPoints() const { return x_.size(); }
+
+            /**
+             * @brief Get the number of points of a trajectory
+             * @param trajectory Index of the trajectory
+             * @return Number of points
+             */
+            size_t getNumberOfPoints(size_t trajectory) const { return point_count_[trajectory]; }
+
+            /**
+             * @brief Get the global time of the deposit a trajectory originates from
+             * @param trajectory Index of the trajectory
+             * @return Global time of the deposit
+             */
+            double getTime(size_t trajectory) const { return time_[trajectory]; }
+
+            /**
+             * @brief Get the number of charge carriers of a trajectory
+             * @param trajectory Index of the trajectory
+             * @return Number of charge carriers
+             */
+            unsigned int getCharge(size_t trajectory) const { return charge_[trajectory]; }
+
+            /**
+             * @brief Get the type of the charge carriers of a trajectory
+             * @param trajectory Index of the trajectory
+             * @return Type of the charge carriers
+             */
+            CarrierType getType(size_t trajectory) const { return type_[trajectory]; }
+
+            /**
+             * @brief Get the state of the charge carriers of a trajectory
+             * @param trajectory Index of the trajectory
+             * @return State of the charge carriers
+             */
+            CarrierState getState(size_t trajectory) const { return state_[trajectory]; }
+
+            /**
+             * @brief Get a point from the columns
+             * @param index Index of the point in the order of recording
+             * @return Position of the point
+             */
+            ROOT::Math::XYZPoint getPoint(size_t index) const { return {x_[index], y_[index], z_[index]}; }
+
+            /**
+             * @brief Group the points by their trajectories
+             * @param offsets Filled with the offset of the first point of every trajectory, followed by the total number
+             * @return Indices of all points ordered by trajectory, keeping the order of recording within a trajectory
+             */
+            std::vector<size_t> groupPoints(std::vector<size_t>& offsets) const {
+                offsets.assign(size() + 1, 0);
+                for(size_t trajectory = 0; trajectory < size(); ++trajectory) {
+                    offsets[trajectory + 1] = offsets[trajectory] + point_count_[trajectory];
+                }
+                std::vector<size_t> order(getNumberOfPoints());
+                auto next = offsets;
+                for(size_t index = 0; index < order.size(); ++index) {
+                    order[next[point_trajectory_[index]]++] = index;
+                }
+                return order;
+            }
+
+        private:
+            // Properties of the trajectories
+            std::vector<double> time_;
+            std::vector<unsigned int> charge_;
+            std::vector<CarrierType> type_;
+            std::vector<CarrierState> state_;
+            std::vector<size_t> point_count_;
+
+            // Points of all trajectories with the index of their trajectory
+            std::vector<unsigned int> point_trajectory_;
+            std::vector<double> x_;
+            std::vector<double> y_;
+            std::vector<double> z_;
+        };
+
+        /**
+         * @brief Writer of recorded trajectories to a tree with one entry per event
+         *
+         * All columns of the trajectories are stored as vector branches, such that the trajectories can be analyzed without
+         * creating graphics objects during the simulation. The tree is created in the ROOT directory of the module, events
+         * can be filled from multiple threads.
+         */
+        class TrajectoryWriter {
+        public:
+            /**
+             * @brief Create the tree of trajectories
+             * @param module Module to create the tree for, used to obtain the ROOT directory
+             */
+            explicit TrajectoryWriter(Module* module) {
+                tree_ = new TTree("trajectories", ("Charge carrier trajectories of " + module->getUniqueName()).c_str());
+                tree_->SetDirectory(module->getROOTDirectory());
+                tree_->Branch("event", &event_);
+                tree_->Branch("trajectory_time", &time_);
+                tree_->Branch("trajectory_charge", &charge_);
+                tree_->Branch("trajectory_type", &type_);
+                tree_->Branch("trajectory_state", &state_);
+                tree_->Branch("point_trajectory", &point_trajectory_);
+                tree_->Branch("point_x", &x_);
+                tree_->Branch("point_y", &y_);
+                tree_->Branch("point_z", &z_);
+            }
+
+            /**
+             * @brief Write the trajectories of an event to the tree
+             * @param event_num Index of the event
+             * @param output_plot_points Trajectories recorded in this event
+             */
+            void fill(uint64_t event_num, const OutputPlotPoints& output_plot_points) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                event_ = event_num;
+                time_ = output_plot_points.time_;
+                charge_ = output_plot_points.charge_;
+                type_.resize(output_plot_points.size());
+                state_.resize(output_plot_points.size());
+                for(size_t trajectory = 0; trajectory < output_plot_points.size(); ++trajectory) {
+                    type_[trajectory] = static_cast<int>(output_plot_points.type_[trajectory]);
+                    state_[trajectory] = static_cast<int>(output_plot_points.state_[trajectory]);
+                }
+                point_trajectory_ = output_plot_points.point_trajectory_;
+                x_ = output_plot_points.x_;
+                y_ = output_plot_points.y_;
+                z_ = output_plot_points.z_;
+                tree_->Fill();
+            }
+
+            /**
+             * @brief Write the tree to the ROOT directory of the module
+             * @return Number of events written
+             */
+            Long64_t write() {
+                std::lock_guard<std::mutex> lock(mutex_);
+                tree_->Write();
+                return tree_->GetEntries();
+            }
+
+        private:
+            std::mutex mutex_;
+            TTree* tree_;
+
+            ULong64_t event_{};
+            std::vector<double> time_;
+            std::vector<unsigned int> charge_;
+            std::vector<int> type_;
+            std::vector<int> state_;
+            std::vector<unsigned int> point_trajectory_;
+            std::vector<double> x_;
+            std::vector<double> y_;
+            std::vector<double> z_;
+        };
+
+        /**
+         * @brief Plotting parameters of a module, parsed once from its configuration instead of for every event
+         */
+        struct PlotSettings {
+            PlotSettings() = default;
+
+            /**
+             * @brief Parse the plotting parameters from the configuration of a module
+             * @param config Configuration object of the module instance
+             */
+            explicit PlotSettings(const Configuration& config)
+                : use_pixel_units(config.get<bool>("output_plots_use_pixel_units")),
+                  use_equal_scaling(config.get<bool>("output_plots_use_equal_scaling", true)),
+                  align_pixels(config.get<bool>("output_plots_align_pixels")),
+                  theta(config.get<double>("output_plots_theta")), phi(config.get<double>("output_plots_phi")),
+                  step(config.get<long double>("output_plots_step", 0)),
+                  time_scaling(config.get<long double>("output_animations_time_scaling", 1e9)),
+                  marker_size(config.get<double>("output_animations_marker_size", 1)),
+                  color_markers(config.get<bool>("output_animations_color_markers")),
+                  contour_max_scaling(config.get<double>("output_animations_contour_max_scaling", 10)) {}
+
+            bool use_pixel_units{};         ///< Display the lateral coordinates in units of the pixel pitch
+            bool use_equal_scaling{true};   ///< Use the same scale for the lateral axes as for the sensor thickness
+            bool align_pixels{};            ///< Align the axis limits to the pixel boundaries
+            double theta{}, phi{};          ///< Viewing angles of the canvas
+            long double step{};             ///< Time between two animation frames
+            long double time_scaling{1e9};  ///< Scaling of the animation time to the real time
+            double marker_size{1};          ///< Scaling of the marker size with the charge
+            bool color_markers{};           ///< Color the markers according to their initial depth
+            double contour_max_scaling{10}; ///< Scaling of the contour maximum relative to the total charge
+        };
 
         /**
          * @brief Generate line graphs of charge carrier drift paths
          *
          * @param event_num Index for this event
          * @param module Module to generate plots for, used to create output files and to obtain ROOT directory
-         * @param config Configuration object used for this module instance
+         * @param settings Plotting parameters of this module instance
          * @param output_plot_points List of points cached for plotting
          * @param plotting_state State of charge carriers to be plotted. If state is set to CarrierState::UNKNOWN, all charge
          * carriers are plotted.
          */
         static void Create(uint64_t event_num, // NOLINT
                            Module* module,
-                           const Configuration& config,
+                           const PlotSettings& settings,
                            const OutputPlotPoints& output_plot_points,
                            CarrierState plotting_state) {
 
@@ -55,7 +331,7 @@ namespace allpix {
             LOG(TRACE) << "Writing line graph for " << title << " charge carriers";
 
             auto [minX, maxX, minY, maxY, scale_x, scale_y, max_charge, total_charge, tot_point_cnt, start_time] =
-                get_plot_settings(model, config, output_plot_points);
+                get_plot_settings(model, settings, output_plot_points);
 
             // Use a histogram to create the underlying frame
             auto* histogram_frame =
@@ -78,34 +354,41 @@ namespace allpix {
                                                     1280,
                                                     1024);
             canvas->cd();
-            canvas->SetTheta(config.get<float>("output_plots_theta") * 180.0f / ROOT::Math::Pi());
-            canvas->SetPhi(config.get<float>("output_plots_phi") * 180.0f / ROOT::Math::Pi());
+            canvas->SetTheta(static_cast<float>(settings.theta) * 180.0f / ROOT::Math::Pi());
+            canvas->SetPhi(static_cast<float>(settings.phi) * 180.0f / ROOT::Math::Pi());
 
             // Draw the frame on the canvas
             histogram_frame->GetXaxis()->SetTitle(
-                (std::string("x ") + (config.get<bool>("output_plots_use_pixel_units") ? "(pixels)" : "(mm)")).c_str());
+                (std::string("x ") + (settings.use_pixel_units ? "(pixels)" : "(mm)")).c_str());
             histogram_frame->GetYaxis()->SetTitle(
-                (std::string("y ") + (config.get<bool>("output_plots_use_pixel_units") ? "(pixels)" : "(mm)")).c_str());
+                (std::string("y ") + (settings.use_pixel_units ? "(pixels)" : "(mm)")).c_str());
             histogram_frame->GetZaxis()->SetTitle("z (mm)");
             histogram_frame->Draw();
 
-            // Loop over all point sets created during propagation
+            // Loop over all trajectories created during propagation
             // The vector of unique_pointers is required in order not to delete the objects before the canvas is drawn.
+            std::vector<size_t> offsets;
+            auto order = output_plot_points.groupPoints(offsets);
             std::vector<std::unique_ptr<TPolyLine3D>> lines;
+            lines.reserve(output_plot_points.size());
             short current_color = 1;
-            for(const auto& [deposit, points] : output_plot_points) {
+            for(size_t trajectory = 0; trajectory < output_plot_points.size(); ++trajectory) {
                 // Check if we should plot this point:
-                if(plotting_state != CarrierState::UNKNOWN && plotting_state != std::get<3>(deposit)) {
+                if(plotting_state != CarrierState::UNKNOWN && plotting_state != output_plot_points.getState(trajectory)) {
                     continue;
                 }
 
-                auto line = std::make_unique<TPolyLine3D>();
-                for(const auto& point : points) {
-                    line->SetNextPoint(point.x() / scale_x, point.y() / scale_y, point.z());
+                auto line = std::make_unique<TPolyLine3D>(
+                    static_cast<int>(output_plot_points.getNumberOfPoints(trajectory)));
+                for(auto idx = offsets[trajectory]; idx < offsets[trajectory + 1]; ++idx) {
+                    auto point = output_plot_points.getPoint(order[idx]);
+                    line->SetPoint(
+                        static_cast<int>(idx - offsets[trajectory]), point.x() / scale_x, point.y() / scale_y, point.z());
                 }
                 // Plot all lines with at least three points with different color
                 if(line->GetN() >= 2) {
-                    EColor plot_color = (std::get<2>(deposit) == CarrierType::ELECTRON ? EColor::kAzure : EColor::kOrange);
+                    EColor plot_color =
+                        (output_plot_points.getType(trajectory) == CarrierType::ELECTRON ? EColor::kAzure : EColor::kOrange);
                     current_color = static_cast<short int>(plot_color - 9 + (static_cast<int>(current_color) + 1) % 19);
                     line->SetLineColor(current_color);
                     line->Draw("same");
@@ -123,20 +406,23 @@ namespace allpix {
          *
          * @param event_num Index for this event
          * @param module Module to generate plots for, used to create output files and to obtain ROOT directory
-         * @param config Configuration object used for this module instance
+         * @param settings Plotting parameters of this module instance
          * @param output_plot_points List of points cached for plotting
          * carriers are plotted.
          */
         static void Animate(uint64_t event_num, // NOLINT
                             Module* module,
-                            const Configuration& config,
+                            const PlotSettings& settings,
                             const OutputPlotPoints& output_plot_points) {
 
             LOG(TRACE) << "Writing animation for all charge carriers";
             auto model = module->getDetector()->getModel();
 
             auto [minX, maxX, minY, maxY, scale_x, scale_y, max_charge, total_charge, tot_point_cnt, start_time] =
-                get_plot_settings(model, config, output_plot_points);
+                get_plot_settings(model, settings, output_plot_points);
+
+            std::vector<size_t> offsets;
+            auto order = output_plot_points.groupPoints(offsets);
 
             // Use a histogram to create the underlying frame
             auto* histogram_frame =
@@ -161,10 +447,10 @@ namespace allpix {
             canvas->cd();
 
             // Change axis labels if close to zero or PI as they behave different here
-            if(std::fabs(config.get<double>("output_plots_theta") / (ROOT::Math::Pi() / 2.0) -
-                         std::round(config.get<double>("output_plots_theta") / (ROOT::Math::Pi() / 2.0))) < 1e-6 ||
-               std::fabs(config.get<double>("output_plots_phi") / (ROOT::Math::Pi() / 2.0) -
-                         std::round(config.get<double>("output_plots_phi") / (ROOT::Math::Pi() / 2.0))) < 1e-6) {
+            if(std::fabs(settings.theta / (ROOT::Math::Pi() / 2.0) -
+                         std::round(settings.theta / (ROOT::Math::Pi() / 2.0))) < 1e-6 ||
+               std::fabs(settings.phi / (ROOT::Math::Pi() / 2.0) -
+                         std::round(settings.phi / (ROOT::Math::Pi() / 2.0))) < 1e-6) {
                 histogram_frame->GetXaxis()->SetLabelOffset(-0.1f);
                 histogram_frame->GetYaxis()->SetLabelOffset(-0.075f);
             } else {
@@ -239,8 +525,8 @@ namespace allpix {
 
             // Create animation of moving charges
             auto animation_time = static_cast<unsigned int>(
-                std::lround((Units::convert(config.get<long double>("output_plots_step"), "ms") / 10.0) *
-                            config.get<long double>("output_animations_time_scaling", 1e9)));
+                std::lround((Units::convert(settings.step, "ms") / 10.0) *
+                            settings.time_scaling));
             unsigned long plot_idx = 0;
             unsigned int point_cnt = 0;
             LOG_PROGRESS(INFO, module->getUniqueName() + "_OUTPUT_PLOTS")
@@ -251,21 +537,21 @@ namespace allpix {
 
                 // Reset the canvas
                 canvas->Clear();
-                canvas->SetTheta(config.get<float>("output_plots_theta") * 180.0f / ROOT::Math::Pi());
-                canvas->SetPhi(config.get<float>("output_plots_phi") * 180.0f / ROOT::Math::Pi());
+                canvas->SetTheta(static_cast<float>(settings.theta) * 180.0f / ROOT::Math::Pi());
+                canvas->SetPhi(static_cast<float>(settings.phi) * 180.0f / ROOT::Math::Pi());
                 canvas->Draw();
 
                 // Reset the histogram frame
                 histogram_frame->SetTitle("Charge propagation in sensor");
                 histogram_frame->GetXaxis()->SetTitle(
-                    (std::string("x ") + (config.get<bool>("output_plots_use_pixel_units") ? "(pixels)" : "(mm)")).c_str());
+                    (std::string("x ") + (settings.use_pixel_units ? "(pixels)" : "(mm)")).c_str());
                 histogram_frame->GetYaxis()->SetTitle(
-                    (std::string("y ") + (config.get<bool>("output_plots_use_pixel_units") ? "(pixels)" : "(mm)")).c_str());
+                    (std::string("y ") + (settings.use_pixel_units ? "(pixels)" : "(mm)")).c_str());
                 histogram_frame->GetZaxis()->SetTitle("z (mm)");
                 histogram_frame->Draw();
 
                 auto text = std::make_unique<TPaveText>(-0.75, -0.75, -0.60, -0.65);
-                auto time_ns = Units::convert(plot_idx * config.get<long double>("output_plots_step"), "ns");
+                auto time_ns = Units::convert(plot_idx * settings.step, "ns");
                 std::stringstream sstr;
                 sstr << std::fixed << std::setprecision(2) << time_ns << "ns";
                 auto time_str = std::string(8 - sstr.str().size(), ' ');
@@ -274,39 +560,43 @@ namespace allpix {
                 text->Draw();
 
                 // Plot all the required points
-                for(const auto& [deposit, points] : output_plot_points) {
-                    const auto& [time, charge, type, state] = deposit;
+                for(size_t trajectory = 0; trajectory < output_plot_points.size(); ++trajectory) {
+                    auto time = output_plot_points.getTime(trajectory);
+                    auto charge = output_plot_points.getCharge(trajectory);
 
                     auto diff = static_cast<unsigned long>(
-                        std::lround((time - start_time) / config.get<long double>("output_plots_step")));
+                        std::lround((time - start_time) / settings.step));
                     if(plot_idx < diff) {
                         min_idx_diff = std::min(min_idx_diff, diff - plot_idx);
                         continue;
                     }
                     auto idx = plot_idx - diff;
-                    if(idx >= points.size()) {
+                    if(idx >= output_plot_points.getNumberOfPoints(trajectory)) {
                         continue;
                     }
                     min_idx_diff = 0;
 
+                    auto initial_point = output_plot_points.getPoint(order[offsets[trajectory]]);
+                    auto point = output_plot_points.getPoint(order[offsets[trajectory] + idx]);
+
                     auto marker = std::make_unique<TPolyMarker3D>();
                     marker->SetMarkerStyle(kFullCircle);
                     marker->SetMarkerSize(
-                        static_cast<float>(charge * config.get<double>("output_animations_marker_size", 1)) /
+                        static_cast<float>(charge * settings.marker_size) /
                         static_cast<float>(max_charge));
                     auto initial_z_perc = static_cast<int>(
-                        ((points[0].z() + model->getSensorSize().z() / 2.0) / model->getSensorSize().z()) * 80);
+                        ((initial_point.z() + model->getSensorSize().z() / 2.0) / model->getSensorSize().z()) * 80);
                     initial_z_perc = std::max(std::min(79, initial_z_perc), 0);
-                    if(config.get<bool>("output_animations_color_markers")) {
+                    if(settings.color_markers) {
                         marker->SetMarkerColor(static_cast<Color_t>(colors[initial_z_perc]->GetNumber()));
                     }
-                    marker->SetNextPoint(points[idx].x() / scale_x, points[idx].y() / scale_y, points[idx].z());
+                    marker->SetNextPoint(point.x() / scale_x, point.y() / scale_y, point.z());
                     marker->Draw();
                     markers.push_back(std::move(marker));
 
-                    histogram_contour[0]->Fill(points[idx].y() / scale_y, points[idx].z(), charge);
-                    histogram_contour[1]->Fill(points[idx].x() / scale_x, points[idx].z(), charge);
-                    histogram_contour[2]->Fill(points[idx].x() / scale_x, points[idx].y() / scale_y, charge);
+                    histogram_contour[0]->Fill(point.y() / scale_y, point.z(), charge);
+                    histogram_contour[1]->Fill(point.x() / scale_x, point.z(), charge);
+                    histogram_contour[2]->Fill(point.x() / scale_x, point.y() / scale_y, charge);
                     ++point_cnt;
                 }
 
@@ -332,32 +622,32 @@ namespace allpix {
                         case 0 /* x */:
                             histogram_contour[i]->GetXaxis()->SetTitle(
                                 (std::string("y ") +
-                                 (config.get<bool>("output_plots_use_pixel_units") ? "(pixels)" : "(mm)"))
+                                 (settings.use_pixel_units ? "(pixels)" : "(mm)"))
                                     .c_str());
                             histogram_contour[i]->GetYaxis()->SetTitle("z (mm)");
                             break;
                         case 1 /* y */:
                             histogram_contour[i]->GetXaxis()->SetTitle(
                                 (std::string("x ") +
-                                 (config.get<bool>("output_plots_use_pixel_units") ? "(pixels)" : "(mm)"))
+                                 (settings.use_pixel_units ? "(pixels)" : "(mm)"))
                                     .c_str());
                             histogram_contour[i]->GetYaxis()->SetTitle("z (mm)");
                             break;
                         case 2 /* z */:
                             histogram_contour[i]->GetXaxis()->SetTitle(
                                 (std::string("x ") +
-                                 (config.get<bool>("output_plots_use_pixel_units") ? "(pixels)" : "(mm)"))
+                                 (settings.use_pixel_units ? "(pixels)" : "(mm)"))
                                     .c_str());
                             histogram_contour[i]->GetYaxis()->SetTitle(
                                 (std::string("y ") +
-                                 (config.get<bool>("output_plots_use_pixel_units") ? "(pixels)" : "(mm)"))
+                                 (settings.use_pixel_units ? "(pixels)" : "(mm)"))
                                     .c_str());
                             break;
                         default:;
                         }
                         histogram_contour[i]->SetMinimum(1);
                         histogram_contour[i]->SetMaximum(total_charge /
-                                                         config.get<double>("output_animations_contour_max_scaling", 10));
+                                                         settings.contour_max_scaling);
                         histogram_contour[i]->Draw("CONTZ 0");
                         if(point_cnt < tot_point_cnt - 1) {
                             canvas->Print((file_name_contour[i] + "+" + std::to_string(animation_time)).c_str());
@@ -378,12 +668,12 @@ namespace allpix {
     private:
         static std::tuple<double, double, double, double, double, double, double, double, unsigned long, double>
         get_plot_settings(const std::shared_ptr<DetectorModel>& model,
-                          const Configuration& config,
+                          const PlotSettings& settings,
                           const OutputPlotPoints& output_plot_points) {
 
             // Convert to pixel units if necessary
-            double scale_x = (config.get<bool>("output_plots_use_pixel_units") ? model->getPixelSize().x() : 1);
-            double scale_y = (config.get<bool>("output_plots_use_pixel_units") ? model->getPixelSize().y() : 1);
+            double scale_x = (settings.use_pixel_units ? model->getPixelSize().x() : 1);
+            double scale_y = (settings.use_pixel_units ? model->getPixelSize().y() : 1);
 
             // Calculate the axis limits
             double minX = FLT_MAX, maxX = FLT_MIN;
@@ -392,27 +682,27 @@ namespace allpix {
             double start_time = std::numeric_limits<double>::max();
             unsigned int total_charge = 0;
             unsigned int max_charge = 0;
-            for(const auto& [deposit, points] : output_plot_points) {
-                for(const auto& point : points) {
-                    minX = std::min(minX, point.x() / scale_x);
-                    maxX = std::max(maxX, point.x() / scale_x);
+            for(size_t index = 0; index < output_plot_points.getNumberOfPoints(); ++index) {
+                auto point = output_plot_points.getPoint(index);
+                minX = std::min(minX, point.x() / scale_x);
+                maxX = std::max(maxX, point.x() / scale_x);
 
-                    minY = std::min(minY, point.y() / scale_y);
-                    maxY = std::max(maxY, point.y() / scale_y);
-                }
-                const auto& [time, charge, type, state] = deposit;
-                start_time = std::min(start_time, time);
+                minY = std::min(minY, point.y() / scale_y);
+                maxY = std::max(maxY, point.y() / scale_y);
+            }
+            for(size_t trajectory = 0; trajectory < output_plot_points.size(); ++trajectory) {
+                auto charge = output_plot_points.getCharge(trajectory);
+                start_time = std::min(start_time, output_plot_points.getTime(trajectory));
                 total_charge += charge;
                 max_charge = std::max(max_charge, charge);
-
-                tot_point_cnt += points.size();
             }
+            tot_point_cnt = output_plot_points.getNumberOfPoints();
 
             // Compute frame axis sizes if equal scaling is requested
-            if(config.get<bool>("output_plots_use_equal_scaling", true)) {
+            if(settings.use_equal_scaling) {
                 double centerX = (minX + maxX) / 2.0;
                 double centerY = (minY + maxY) / 2.0;
-                if(config.get<bool>("output_plots_use_pixel_units")) {
+                if(settings.use_pixel_units) {
                     minX = centerX - model->getSensorSize().z() / model->getPixelSize().x() / 2.0;
                     maxX = centerX + model->getSensorSize().z() / model->getPixelSize().x() / 2.0;
 
@@ -428,8 +718,8 @@ namespace allpix {
             }
 
             // Align on pixels if requested
-            if(config.get<bool>("output_plots_align_pixels")) {
-                if(config.get<bool>("output_plots_use_pixel_units")) {
+            if(settings.align_pixels) {
+                if(settings.use_pixel_units) {
                     minX = std::floor(minX - 0.5) + 0.5;
                     minY = std::floor(minY + 0.5) - 0.5;
                     maxX = std::ceil(maxX - 0.5) + 0.5;
@@ -0,0 +1,97 @@
+/**
+ * @file
+ * @brief Cache of the per-type decisions of writer modules whether to store messages
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_MESSAGE_FILTER_H
+#define ALLPIX_MESSAGE_FILTER_H
+
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <typeindex>
+
+#include "core/messenger/Message.hpp"
+#include "core/messenger/exceptions.h"
+#include "core/utils/type.h"
+
+namespace allpix {
+
+    /**
+     * @brief Cache of the decisions of writer modules whether to store the objects of a message type
+     *
+     * Writer modules select the messages to store by the class name of their objects. Since every message type holds
+     * objects of a single class, the class name is only demangled and the selection only evaluated the first time a message
+     * type is seen. Afterwards, the decision is found in a small flat table shared by all threads.
+     */
+    class MessageFilterCache {
+    public:
+        /**
+         * @brief Decision for one message type
+         */
+        struct Entry {
+            std::type_index type;             ///< Type of the message
+            bool objects{};                   ///< True if the message holds objects, false otherwise
+            bool keep{};                      ///< True if the objects of the message should be stored
+            std::string class_name;           ///< Class name of the objects without namespace
+            std::string qualified_class_name; ///< Class name of the objects including the namespace
+        };
+
+        /**
+         * @brief Get the decision for the type of a message, evaluating the selection for new message types
+         * @param message Message to look up
+         * @param select Function deciding from the class name of the objects without namespace if they should be stored
+         * @return Pointer to the entry of the message type, or a null pointer if the type was not seen before and the
+         *         message is empty, such that the class name of its objects cannot be determined
+         *
+         * The returned entries remain valid for the lifetime of the cache.
+         */
+        template <typename F> const Entry* get(BaseMessage& message, F&& select) {
+            std::type_index type = typeid(message);
+            {
+                std::shared_lock<std::shared_mutex> lock(mutex_);
+                for(const auto& entry : entries_) {
+                    if(entry.type == type) {
+                        return &entry;
+                    }
+                }
+            }
+
+            Entry entry{type, false, false, {}, {}};
+            try {
+                auto object_array = message.getObjectArray();
+                if(object_array.empty()) {
+                    return nullptr;
+                }
+                const Object& first_object = object_array[0];
+                entry.objects = true;
+                entry.class_name = allpix::demangle(typeid(first_object).name());
+                entry.qualified_class_name = allpix::demangle(typeid(first_object).name(), true);
+                entry.keep = select(entry.class_name);
+            } catch(const MessageWithoutObjectException&) {
+                // Messages without objects are never stored
+            }
+
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+            for(const auto& existing : entries_) {
+                if(existing.type == type) {
+                    return &existing;
+                }
+            }
+            return &entries_.emplace_back(std::move(entry));
+        }
+
+    private:
+        std::shared_mutex mutex_;
+        std::deque<Entry> entries_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_MESSAGE_FILTER_H */
@@ -0,0 +1,225 @@
+/**
+ * @file
+ * @brief Columnar representation of the objects of one event for flat ROOT trees
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_OBJECT_COLUMNS_H
+#define ALLPIX_OBJECT_COLUMNS_H
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <TTree.h>
+
+namespace allpix {
+
+    /**
+     * @brief Type of the object a pulse stored in the pulse columns belongs to
+     */
+    enum class PulseOwner : int {
+        PROPAGATED_CHARGE = 0, ///< Pulse induced by a propagated charge at the electrode given by the pulse index
+        PIXEL_CHARGE,          ///< Pulse of a pixel charge
+        PIXEL_PULSE,           ///< Pulse of a pixel pulse
+    };
+
+    /**
+     * @brief Columns holding all objects of one type in an event
+     *
+     * Every member of the objects is stored as a separate vector with one element per object, such that the trees can be
+     * analyzed directly, e.g. with RDataFrame. References between objects are stored as indices into the columns of the
+     * referenced object type within the same event, with -1 denoting a missing reference. The branches are named after
+     * the object type and the column, separated by an underscore.
+     */
+    class ObjectColumns {
+    public:
+        /**
+         * @brief Define the columns of an object type
+         * @param type Name of the object type
+         * @param integers Names of the integer columns
+         * @param doubles Names of the floating point columns
+         * @param floats Names of the single precision floating point columns
+         */
+        ObjectColumns(std::string type,
+                      const std::vector<std::string>& integers,
+                      const std::vector<std::string>& doubles,
+                      const std::vector<std::string>& floats = {})
+            : type_(std::move(type)) {
+            for(const auto& name : integers) {
+                integers_[name];
+            }
+            for(const auto& name : doubles) {
+                doubles_[name];
+            }
+            for(const auto& name : floats) {
+                floats_[name];
+            }
+        }
+
+        /**
+         * @brief Create or attach the branches of all columns
+         * @param tree Tree to bind the columns to
+         * @param create Create the branches for writing if true, attach to existing branches for reading otherwise
+         * @return False if reading and any branch of the columns is missing in the tree
+         */
+        bool bind(TTree* tree, bool create) {
+            auto bind_column = [&](const std::string& name, auto& column, auto& pointers) {
+                auto branch_name = type_ + "_" + name;
+                if(create) {
+                    tree->Branch(branch_name.c_str(), &column);
+                    return true;
+                }
+                if(tree->GetBranch(branch_name.c_str()) == nullptr) {
+                    return false;
+                }
+                pointers.push_back(&column);
+                tree->SetBranchAddress(branch_name.c_str(), &pointers.back());
+                return true;
+            };
+
+            // Addresses of the column pointers need to be stable for reading
+            integer_pointers_.reserve(integers_.size());
+            double_pointers_.reserve(doubles_.size());
+            float_pointers_.reserve(floats_.size());
+            bool found = true;
+            for(auto& [name, column] : integers_) {
+                found &= bind_column(name, column, integer_pointers_);
+            }
+            for(auto& [name, column] : doubles_) {
+                found &= bind_column(name, column, double_pointers_);
+            }
+            for(auto& [name, column] : floats_) {
+                found &= bind_column(name, column, float_pointers_);
+            }
+            return found;
+        }
+
+        /**
+         * @brief Get an integer column
+         * @param name Name of the column
+         * @return Reference to the vector of values
+         */
+        std::vector<int>& integers(const std::string& name) { return integers_.at(name); }
+
+        /**
+         * @brief Get a floating point column
+         * @param name Name of the column
+         * @return Reference to the vector of values
+         */
+        std::vector<double>& doubles(const std::string& name) { return doubles_.at(name); }
+
+        /**
+         * @brief Get a single precision floating point column
+         * @param name Name of the column
+         * @return Reference to the vector of values
+         */
+        std::vector<float>& floats(const std::string& name) { return floats_.at(name); }
+
+        /**
+         * @brief Get the number of objects stored, i.e. the length of the detector column present for every type
+         * @return Number of objects
+         */
+        size_t size() const { return integers_.at("detector").size(); }
+
+        /**
+         * @brief Remove all values while keeping the allocated memory
+         */
+        void clear() {
+            for(auto& column : integers_) {
+                column.second.clear();
+            }
+            for(auto& column : doubles_) {
+                column.second.clear();
+            }
+            for(auto& column : floats_) {
+                column.second.clear();
+            }
+        }
+
+    private:
+        std::string type_;
+        std::map<std::string, std::vector<int>> integers_;
+        std::map<std::string, std::vector<double>> doubles_;
+        std::map<std::string, std::vector<float>> floats_;
+        // Pointers to the columns handed to ROOT for reading
+        std::vector<std::vector<int>*> integer_pointers_;
+        std::vector<std::vector<double>*> double_pointers_;
+        std::vector<std::vector<float>*> float_pointers_;
+    };
+
+    /**
+     * @brief Columns of all object types stored in the flat trees
+     * @return Columns of MCParticle, DepositedCharge, PropagatedCharge, PixelCharge and PixelHit objects
+     *
+     * The detector column holds the index of the detector in the list of detector names stored with the tree. Pixel
+     * charges reference their propagated charges via the range starting at the entry of the "propagated_charges_begin"
+     * column in the flattened "propagated_charges" column.
+     */
+    inline std::map<std::string, ObjectColumns> object_columns() {
+        const std::vector<std::string> sensor_charge = {
+            "local_x", "local_y", "local_z", "global_x", "global_y", "global_z", "local_time", "global_time"};
+
+        std::map<std::string, ObjectColumns> columns;
+        columns.emplace("MCParticle",
+                        ObjectColumns("MCParticle",
+                                      {"detector", "particle_id", "parent", "total_deposited_charge"},
+                                      {"local_start_x",
+                                       "local_start_y",
+                                       "local_start_z",
+                                       "local_end_x",
+                                       "local_end_y",
+                                       "local_end_z",
+                                       "global_start_x",
+                                       "global_start_y",
+                                       "global_start_z",
+                                       "global_end_x",
+                                       "global_end_y",
+                                       "global_end_z",
+                                       "local_time",
+                                       "global_time",
+                                       "total_energy_start",
+                                       "kinetic_energy_start"}));
+        columns.emplace("DepositedCharge",
+                        ObjectColumns("DepositedCharge", {"detector", "type", "charge", "mcparticle"}, sensor_charge));
+        columns.emplace(
+            "PropagatedCharge",
+            ObjectColumns("PropagatedCharge", {"detector", "type", "charge", "state", "deposited_charge"}, sensor_charge));
+        columns.emplace("PixelCharge",
+                        ObjectColumns("PixelCharge",
+                                      {"detector", "x", "y", "charge", "propagated_charges_begin", "propagated_charges"},
+                                      {}));
+        columns.emplace("PixelHit",
+                        ObjectColumns("PixelHit",
+                                      {"detector", "x", "y", "pixel_charge"},
+                                      {"signal", "local_time", "global_time"}));
+        return columns;
+    }
+
+    /**
+     * @brief Columns of the pulses and of the PixelPulse objects, which are only stored on request
+     * @return Columns of pulses and PixelPulse objects
+     *
+     * Every pulse refers to the object it belongs to by the owner type, see \ref PulseOwner, and the index of the owner in
+     * the columns of its type. The pulse is stored from its first stored bin given by the "offset" column, its values in
+     * single precision occupy the range starting at the entry of the "values_begin" column in the flattened "values"
+     * column. The "x" and "y" columns hold the index of the electrode or pixel of the pulse.
+     */
+    inline std::map<std::string, ObjectColumns> pulse_columns() {
+        std::map<std::string, ObjectColumns> columns;
+        columns.emplace(
+            "Pulse",
+            ObjectColumns(
+                "Pulse", {"detector", "owner_type", "owner", "x", "y", "offset", "values_begin"}, {"bin"}, {"values"}));
+        columns.emplace("PixelPulse", ObjectColumns("PixelPulse", {"detector", "x", "y", "pixel_charge"}, {}));
+        return columns;
+    }
+} // namespace allpix
+
+#endif /* ALLPIX_OBJECT_COLUMNS_H */
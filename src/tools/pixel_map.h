@@ -0,0 +1,145 @@
+/**
+ * @file
+ * @brief Flat hash map to accumulate values per pixel index
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_PIXEL_MAP_H
+#define ALLPIX_PIXEL_MAP_H
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "objects/Pixel.hpp"
+
+namespace allpix {
+
+    /**
+     * @brief Map from pixel indices to accumulated values, replacing std::map for the accumulation of charges per pixel
+     *
+     * The entries are stored contiguously in the order of their insertion, and are located via an open-addressing hash table
+     * with linear probing, keyed by the packed pixel index. Inserting or looking up an entry therefore does not allocate in
+     * the common case. Clearing the map keeps the allocated memory, such that a map reused across events, e.g. as a
+     * thread-local variable, stops allocating once it has grown to the typical event size. The entries can be sorted by
+     * pixel index to reproduce the iteration order of a std::map.
+     */
+    template <typename T> class PixelMap {
+    public:
+        using value_type = std::pair<Pixel::Index, T>;
+        using iterator = typename std::vector<value_type>::iterator;
+        using const_iterator = typename std::vector<value_type>::const_iterator;
+
+        /**
+         * @brief Access the value stored for a pixel, inserting a default-constructed value if not present
+         * @param index Index of the pixel
+         * @return Reference to the value of the pixel, valid until the next insertion
+         */
+        T& operator[](const Pixel::Index& index) {
+            // Keep the load factor of the hash table below one half
+            if(2 * (entries_.size() + 1) > slots_.size()) {
+                rehash(std::max<size_t>(initial_slots, 2 * slots_.size()));
+            }
+
+            auto slot = find_slot(index);
+            if(slots_[slot] == 0) {
+                entries_.emplace_back(index, T());
+                slots_[slot] = static_cast<std::uint32_t>(entries_.size());
+            }
+            return entries_[slots_[slot] - 1].second;
+        }
+
+        /**
+         * @brief Look up the value stored for a pixel without inserting it
+         * @param index Index of the pixel
+         * @return Pointer to the value of the pixel or a nullptr if not present, valid until the next insertion
+         */
+        const T* find(const Pixel::Index& index) const {
+            if(slots_.empty()) {
+                return nullptr;
+            }
+            auto slot = find_slot(index);
+            return slots_[slot] == 0 ? nullptr : &entries_[slots_[slot] - 1].second;
+        }
+
+        /**
+         * @brief Get the number of pixels in the map
+         * @return Number of pixels
+         */
+        size_t size() const { return entries_.size(); }
+
+        /**
+         * @brief Check if the map contains any pixel
+         * @return True if no pixel is stored
+         */
+        bool empty() const { return entries_.empty(); }
+
+        /**
+         * @brief Remove all pixels from the map while keeping the allocated memory
+         */
+        void clear() {
+            entries_.clear();
+            std::fill(slots_.begin(), slots_.end(), 0);
+        }
+
+        /**
+         * @brief Sort the entries by pixel index, the ordering used by std::map
+         */
+        void sort() {
+            std::sort(entries_.begin(), entries_.end(), [](const value_type& lhs, const value_type& rhs) {
+                return lhs.first < rhs.first;
+            });
+            std::fill(slots_.begin(), slots_.end(), 0);
+            for(size_t i = 0; i < entries_.size(); ++i) {
+                slots_[find_slot(entries_[i].first)] = static_cast<std::uint32_t>(i + 1);
+            }
+        }
+
+        iterator begin() { return entries_.begin(); }
+        iterator end() { return entries_.end(); }
+        const_iterator begin() const { return entries_.begin(); }
+        const_iterator end() const { return entries_.end(); }
+
+    private:
+        static constexpr size_t initial_slots = 64;
+
+        /**
+         * @brief Find the slot of the hash table holding the pixel index, or the empty slot where it is to be inserted
+         * @param index Index of the pixel
+         * @return Position of the slot in the hash table
+         */
+        size_t find_slot(const Pixel::Index& index) const {
+            auto key = (static_cast<std::uint64_t>(static_cast<std::uint32_t>(index.x())) << 32) |
+                       static_cast<std::uint64_t>(static_cast<std::uint32_t>(index.y()));
+            const auto mask = slots_.size() - 1;
+            auto slot = static_cast<size_t>((key * 0x9E3779B97F4A7C15) >> 32) & mask;
+            while(slots_[slot] != 0 && entries_[slots_[slot] - 1].first != index) {
+                slot = (slot + 1) & mask;
+            }
+            return slot;
+        }
+
+        /**
+         * @brief Resize the hash table and reinsert all entries
+         * @param size New number of slots, needs to be a power of two
+         */
+        void rehash(size_t size) {
+            slots_.assign(size, 0);
+            for(size_t i = 0; i < entries_.size(); ++i) {
+                slots_[find_slot(entries_[i].first)] = static_cast<std::uint32_t>(i + 1);
+            }
+        }
+
+        std::vector<value_type> entries_;
+        // Positions of the entries in the hash table, offset by one to mark empty slots with zero
+        std::vector<std::uint32_t> slots_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_PIXEL_MAP_H */
@@ -12,7 +12,11 @@
 #ifndef ALLPIX_RUNGE_KUTTA_H
 #define ALLPIX_RUNGE_KUTTA_H
 
+#include <array>
+#include <cstddef>
 #include <functional>
+#include <type_traits>
+#include <utility>
 
 #include <Eigen/Core>
 #include <Eigen/Geometry>
@@ -217,8 +221,231 @@ namespace allpix {
             37.0/378, 0, 250.0/621, 125.0/594, 0, 512.0/1771,
             2825.0/27648, 0, 18575.0/48384, 13525.0/55296, 277.0/14336, 1.0/4).finished());
     }
+
+    /**
+     * @brief Runge-Kutta tableaus available as compile-time constants
+     *
+     * The coefficients are laid out identically to the tableaus above, i.e. the first S rows hold the stage coefficients
+     * and the last two rows the weights of the solution and of the error estimate. These tableaus are used with the
+     * \ref StaticRungeKutta integrator.
+     */
+    namespace tableau {
+        /**
+         * @brief Classic original Runge-Kutta method
+         * @warning Without error function
+         */
+        struct StaticRK4 {
+            static constexpr std::size_t stages = 4;
+            static constexpr double values[stages + 2][stages] = {
+                {0, 0, 0, 0},
+                {1.0/2, 0, 0, 0},
+                {0, 1.0/2, 0, 0},
+                {0, 0, 1, 0},
+                {1.0/6, 1.0/3, 1.0/3, 1.0/6},
+                {0, 0, 0, 0}};
+        };
+        /**
+         * @brief Runge-Kutta-Fehlberg method
+         * Values from https://ntrs.nasa.gov/citations/19680027281, p.13, Table III
+         */
+        struct StaticRK5 {
+            static constexpr std::size_t stages = 6;
+            static constexpr double values[stages + 2][stages] = {
+                {0, 0, 0, 0, 0, 0},
+                {1.0/4, 0, 0, 0, 0, 0},
+                {3.0/32, 9.0/32, 0, 0, 0, 0},
+                {1932.0/2197, -7200.0/2197, 7296.0/2197, 0, 0, 0},
+                {439.0/216, -8, 3680.0/513, -845.0/4104, 0, 0},
+                {-8.0/27, 2, -3544.0/2565, 1859.0/4104, -11.0/40, 0},
+                {16.0/135, 0, 6656.0/12825, 28561.0/56430, -9.0/50, 2.0/55},
+                {25.0/216, 0, 1408.0/2565, 2197.0/4104, -1.0/5, 0}};
+        };
+        /**
+         * @brief Runge-Kutta-Cash-Karp method
+         */
+        struct StaticRKCK {
+            static constexpr std::size_t stages = 6;
+            static constexpr double values[stages + 2][stages] = {
+                {0, 0, 0, 0, 0, 0},
+                {1.0/5, 0, 0, 0, 0, 0},
+                {3.0/40, 9.0/40, 0, 0, 0, 0},
+                {3.0/10, -9.0/10, 6.0/5, 0, 0, 0},
+                {-11.0/54, 5.0/2, -70.0/27, 35.0/27, 0, 0},
+                {1631.0/55296, 175.0/512, 575.0/13824, 44275.0/110592, 253.0/4096, 0},
+                {37.0/378, 0, 250.0/621, 125.0/594, 0, 512.0/1771},
+                {2825.0/27648, 0, 18575.0/48384, 13525.0/55296, 277.0/14336, 1.0/4}};
+        };
+    } // namespace tableau
     // clang-format on
 
+    /**
+     * @brief Class to perform Runge-Kutta integration with a compile-time tableau and step function type
+     *
+     * In contrast to \ref RungeKutta, both the tableau and the type of the step function are template parameters. This
+     * allows the compiler to resolve the stage loops at compile time, to skip vanishing coefficients and to inline the
+     * step function, avoiding the type-erased call of a std::function for every stage of every step.
+     *
+     * The integrated values and the step size are stored in the scalar type T, while the time is always accumulated in
+     * double precision to avoid a drift of the time over many short steps when integrating in single precision.
+     */
+    template <typename T, typename Tableau, typename Function, int D = 3> class StaticRungeKutta {
+    public:
+        /**
+         * @brief Number of stages of the tableau
+         */
+        static constexpr std::size_t S = Tableau::stages;
+
+        /**
+         * @brief Utility type to return both the value and the error at every step
+         */
+        class Step {
+        public:
+            Eigen::Matrix<T, D, 1> value;
+            Eigen::Matrix<T, D, 1> error;
+        };
+
+        /**
+         * @brief Construct a Runge-Kutta integrator
+         * @param function Step function to perform integration, called with the time and a const reference to the value
+         * @param step_size Time step of the integration
+         * @param initial_y Start values of the vector to perform integration on
+         * @param initial_t Initial time at the start of the integration
+         */
+        StaticRungeKutta(Function function, T step_size, Eigen::Matrix<T, D, 1> initial_y, double initial_t = 0)
+            : function_(std::move(function)), h_(std::move(step_size)), y_(std::move(initial_y)), t_(initial_t) {
+            error_.setZero();
+        }
+
+        /**
+         * @brief Changes the time step
+         * @param step_size New time step of the integration
+         */
+        void setTimeStep(T step_size) { h_ = std::move(step_size); }
+        /**
+         * @brief Return the time step
+         * @return Current time step of the integration
+         */
+        T getTimeStep() const { return h_; }
+
+        /**
+         * @brief Changes the current value during integration
+         * @note Can be used to add additional processes during the integration
+         */
+        void setValue(const Eigen::Matrix<T, D, 1>& y) { y_ = y; }
+        /**
+         * @brief Get the value to integrate
+         * @return Current value
+         */
+        const Eigen::Matrix<T, D, 1>& getValue() const { return y_; }
+        /**
+         * @brief Get the total integration error
+         * @return Total integrated error
+         */
+        const Eigen::Matrix<T, D, 1>& getError() const { return error_; }
+        /**
+         * @brief Get the time during integration
+         * @return Current time
+         */
+        double getTime() const { return t_; }
+        /**
+         * @brief Advance the time of the integration
+         * @param t Time step to advance the integration by
+         */
+        void advanceTime(double t) { t_ += t; }
+
+        /**
+         * @brief Execute a single time step of the integration
+         * @return Combination of the current value and the error in this single step
+         */
+        Step step() {
+            Step step;
+            Eigen::Matrix<T, D, 1> ys = Eigen::Matrix<T, D, 1>::Zero();
+            Eigen::Matrix<T, D, 1> yse = Eigen::Matrix<T, D, 1>::Zero();
+
+            std::array<Eigen::Matrix<T, D, 1>, S> k;
+            for(std::size_t i = 0; i < S; ++i) {
+                Eigen::Matrix<T, D, 1> yt = y_;
+                double ct = 0;
+                for(std::size_t j = 0; j < i; ++j) {
+                    if(Tableau::values[i][j] != 0) {
+                        yt += coefficient(i, j) * k[j];
+                        ct += Tableau::values[i][j];
+                    }
+                }
+                k[i] = function_(t_ + ct * static_cast<double>(h_), static_cast<const Eigen::Matrix<T, D, 1>&>(yt));
+
+                ys += coefficient(S, i) * k[i];
+                yse += coefficient(S + 1, i) * k[i];
+            }
+
+            // Update values with new step
+            y_ += ys;
+            t_ += static_cast<double>(h_);
+            error_ += ys - yse;
+
+            step.value = ys;
+            step.error = ys - yse;
+            return step;
+        }
+
+        /**
+         * @brief Execute multiple time steps of the integration
+         * @param amount Number of steps to combine
+         * @return Combination of the current value and the total error in all the steps
+         */
+        Step step(int amount) {
+            Step result;
+            result.value.setZero();
+            result.error.setZero();
+            for(int i = 0; i < amount; ++i) {
+                Step single = step();
+                result.value += single.value;
+                result.error += single.error;
+            }
+            return result;
+        }
+
+    private:
+        /**
+         * @brief Get a coefficient of the tableau multiplied with the step size, in the scalar type of the integration
+         * @param row Row of the tableau
+         * @param column Column of the tableau
+         * @return Scaled coefficient
+         */
+        T coefficient(std::size_t row, std::size_t column) const {
+            return static_cast<T>(static_cast<double>(h_) * Tableau::values[row][column]);
+        }
+
+        Function function_;
+        // Step size
+        T h_;
+
+        // Vector to integrate
+        Eigen::Matrix<T, D, 1> y_;
+        // Total error vector
+        Eigen::Matrix<T, D, 1> error_;
+        // Current time, accumulated in double precision
+        double t_;
+    };
+
+    /**
+     * @brief Utility function to create StaticRungeKutta class using template deduction for the step function
+     * @param function Step function to perform integration
+     * @param step_size Time step of the integration
+     * @param initial_y Start values of the vector to perform integration on
+     * @param initial_t Initial time at the start of the integration
+     * @return Instantiation of \ref StaticRungeKutta class with the given tableau
+     */
+    template <typename Tableau, typename T, int D, typename Function>
+    StaticRungeKutta<T, Tableau, std::decay_t<Function>, D>
+    make_static_runge_kutta(Function&& function,
+                            T step_size,
+                            const Eigen::Matrix<T, D, 1>& initial_y,
+                            double initial_t = 0) {
+        return StaticRungeKutta<T, Tableau, std::decay_t<Function>, D>(
+            std::forward<Function>(function), step_size, initial_y, initial_t);
+    }
+
     /**
      * @brief Utility function to create RungeKutta class using template deduction
      * @param tableau One of the possible Runge-Kutta tableaus (see \ref allpix::tableau)
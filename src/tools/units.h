@@ -24,56 +24,56 @@ namespace allpix {
         LOG(TRACE) << "Adding physical units";
 
         // LENGTH
-        Units::add("nm", 1e-6);
-        Units::add("um", 1e-3);
-        Units::add("mm", 1);
-        Units::add("cm", 1e1);
-        Units::add("dm", 1e2);
-        Units::add("m", 1e3);
-        Units::add("km", 1e6);
+        Units::add("nm", units::nm);
+        Units::add("um", units::um);
+        Units::add("mm", units::mm);
+        Units::add("cm", units::cm);
+        Units::add("dm", units::dm);
+        Units::add("m", units::m);
+        Units::add("km", units::km);
 
         // TIME
-        Units::add("ps", 1e-3);
-        Units::add("ns", 1);
-        Units::add("us", 1e3);
-        Units::add("ms", 1e6);
-        Units::add("s", 1e9);
+        Units::add("ps", units::ps);
+        Units::add("ns", units::ns);
+        Units::add("us", units::us);
+        Units::add("ms", units::ms);
+        Units::add("s", units::s);
 
         // TEMPERATURE
-        Units::add("K", 1);
+        Units::add("K", units::K);
 
         // ENERGY
-        Units::add("eV", 1e-6);
-        Units::add("keV", 1e-3);
-        Units::add("MeV", 1);
-        Units::add("GeV", 1e3);
+        Units::add("eV", units::eV);
+        Units::add("keV", units::keV);
+        Units::add("MeV", units::MeV);
+        Units::add("GeV", units::GeV);
 
         // CHARGE
-        Units::add("e", 1);
-        Units::add("ke", 1e3);
-        Units::add("fC", 1 / 1.602176634e-4);
-        Units::add("C", 1 / 1.602176634e-19);
+        Units::add("e", units::e);
+        Units::add("ke", units::ke);
+        Units::add("fC", units::fC);
+        Units::add("C", units::C);
 
         // VOLTAGE
         // NOTE: fixed by above
-        Units::add("mV", 1e-9);
-        Units::add("V", 1e-6);
-        Units::add("kV", 1e-3);
+        Units::add("mV", units::mV);
+        Units::add("V", units::V);
+        Units::add("kV", units::kV);
 
         // MAGNETIC FIELD
-        Units::add("kT", 1);
-        Units::add("T", 1e-3);
-        Units::add("mT", 1e-6);
+        Units::add("kT", units::kT);
+        Units::add("T", units::T);
+        Units::add("mT", units::mT);
 
         // ANGLES
         // NOTE: these are fake units
-        Units::add("deg", 3.14159265358979323846 / 180.0);
-        Units::add("rad", 1);
-        Units::add("mrad", 1e-3);
+        Units::add("deg", units::deg);
+        Units::add("rad", units::rad);
+        Units::add("mrad", units::mrad);
 
         // FLUENCE
         // NOTE: pseudo unit "1-MeV neutron equivalent"
-        Units::add("neq", 1);
+        Units::add("neq", units::neq);
     }
 } // namespace allpix
 
@@ -26,7 +26,7 @@ template <typename T> static void print_info(allpix::FieldData<T> field_data, si
               << std::endl;
     std::cout << "Dimensions: " << field_data.getDimensions()[0] << " x " << field_data.getDimensions()[1] << " x "
               << field_data.getDimensions()[2] << " cells" << std::endl;
-    std::cout << "Field vector with " << field_data.getData()->size() << " entries" << std::endl;
+    std::cout << "Field vector with " << field_data.getNumberOfValues() << " entries" << std::endl;
 
     if(n > 0) {
         std::cout << "First " << n << " entries of field data:" << std::endl;
@@ -97,14 +97,15 @@ int main(int argc, const char* argv[]) {
 
         for(auto& file_input : file_names) {
             std::cout << "FILE:       " << file_input << std::endl;
+            // Only read the field values if they should be printed
+            auto read_field = [&](FieldQuantity quantity) {
+                FieldParser<double> field_parser(quantity);
+                return (n > 0 ? field_parser.getByFileName(file_input) : field_parser.getHeaderByFileName(file_input));
+            };
             try {
-                FieldParser<double> field_parser(FieldQuantity::VECTOR);
-                auto field_data = field_parser.getByFileName(file_input);
-                print_info(field_data, n, units);
+                print_info(read_field(FieldQuantity::VECTOR), n, units);
             } catch(std::runtime_error& e) {
-                FieldParser<double> field_parser(FieldQuantity::SCALAR);
-                auto field_data = field_parser.getByFileName(file_input);
-                print_info(field_data, n, units);
+                print_info(read_field(FieldQuantity::SCALAR), n, units);
             }
         }
 
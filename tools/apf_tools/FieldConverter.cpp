@@ -59,7 +59,10 @@ int main(int argc, const char* argv[]) {
             } else if(strcmp(argv[i], "--to") == 0 && (i + 1 < argc)) {
                 std::string format = std::string(argv[++i]);
                 std::transform(format.begin(), format.end(), format.begin(), ::tolower);
-                format_to = (format == "init" ? FileType::INIT : format == "apf" ? FileType::APF : FileType::UNKNOWN);
+                format_to = (format == "init"     ? FileType::INIT
+                             : format == "apf"    ? FileType::APF
+                             : format == "mapped" ? FileType::MAPPED
+                                                  : FileType::UNKNOWN);
             } else if(strcmp(argv[i], "--input") == 0 && (i + 1 < argc)) {
                 file_input = std::string(argv[++i]);
             } else if(strcmp(argv[i], "--output") == 0 && (i + 1 < argc)) {
@@ -82,7 +85,7 @@ int main(int argc, const char* argv[]) {
             std::cout << "Usage: field_converter <parameters>" << std::endl;
             std::cout << std::endl;
             std::cout << "Parameters (all mandatory):" << std::endl;
-            std::cout << "  --to <format>    file format of the output file" << std::endl;
+            std::cout << "  --to <format>    file format of the output file (init, apf or mapped)" << std::endl;
             std::cout << "  --input <file>   input field file" << std::endl;
             std::cout << "  --output <file>  output field file" << std::endl;
             std::cout << "  --units <units>  units the field is provided in" << std::endl << std::endl;
@@ -0,0 +1,67 @@
+/**
+ * @file
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "MeshCache.hpp"
+
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+using namespace mesh_converter;
+
+namespace {
+    // 64-bit FNV-1a hash, continued from the given state
+    std::uint64_t fnv1a(const char* data, size_t size, std::uint64_t hash = 0xcbf29ce484222325ULL) {
+        for(size_t i = 0; i < size; ++i) {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
+    std::string to_hex(std::uint64_t hash) {
+        std::stringstream stream;
+        stream << std::hex << std::setw(16) << std::setfill('0') << hash;
+        return stream.str();
+    }
+} // namespace
+
+MeshCache::MeshCache(std::filesystem::path directory) : directory_(std::move(directory)) {
+    if(enabled()) {
+        std::filesystem::create_directories(directory_);
+        LOG(STATUS) << "Caching intermediate results in directory " << directory_;
+    }
+}
+
+std::string MeshCache::getFileHash(const std::string& file_name) {
+    auto hash = file_hashes_.find(file_name);
+    if(hash != file_hashes_.end()) {
+        return hash->second;
+    }
+
+    std::ifstream file(file_name, std::ios::binary);
+    if(!file) {
+        throw std::runtime_error("file cannot be accessed");
+    }
+
+    LOG(INFO) << "Computing content hash of file \"" << file_name << "\"";
+    std::uint64_t state = fnv1a(nullptr, 0);
+    std::vector<char> buffer(1 << 20);
+    while(file) {
+        file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        state = fnv1a(buffer.data(), static_cast<size_t>(file.gcount()), state);
+    }
+
+    return file_hashes_[file_name] = to_hex(state);
+}
+
+std::string MeshCache::getHash(const std::string& str) { return to_hex(fnv1a(str.data(), str.size())); }
@@ -0,0 +1,161 @@
+/**
+ * @file
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_MESHCACHE_H
+#define ALLPIX_MESHCACHE_H
+
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <utility>
+
+#include <cereal/archives/portable_binary.hpp>
+#include <cereal/types/array.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+
+#include "core/utils/log.h"
+
+// The bundled subset of cereal does not provide serialization of maps, store them as list of key-value pairs
+namespace cereal {
+    template <class Archive, class K, class V, class C, class A>
+    void save(Archive& archive, const std::map<K, V, C, A>& map) {
+        archive(make_size_tag(static_cast<size_type>(map.size())));
+        for(const auto& entry : map) {
+            archive(entry.first, entry.second);
+        }
+    }
+
+    template <class Archive, class K, class V, class C, class A> void load(Archive& archive, std::map<K, V, C, A>& map) {
+        size_type size = 0;
+        archive(make_size_tag(size));
+        map.clear();
+        for(size_type i = 0; i < size; ++i) {
+            K key;
+            V value;
+            archive(key, value);
+            map.emplace_hint(map.end(), std::move(key), std::move(value));
+        }
+    }
+} // namespace cereal
+
+namespace mesh_converter {
+
+    /**
+     * @brief Persistent cache of intermediate results of the mesh conversion
+     *
+     * Entries are stored as binary files in the cache directory, named after a key which is derived from the content of the
+     * input files and the parameters the result depends on. Changing any of them results in a new key, such that stale
+     * entries are never used. An empty cache directory disables the cache.
+     */
+    class MeshCache {
+    public:
+        /**
+         * @brief Constructor for a disabled cache
+         */
+        MeshCache() = default;
+
+        /**
+         * @brief Constructor creating the cache directory if necessary
+         * @param directory Directory to store the cache entries in
+         */
+        explicit MeshCache(std::filesystem::path directory);
+
+        /**
+         * @brief Check if the cache is enabled
+         * @return True if a cache directory has been set
+         */
+        bool enabled() const { return !directory_.empty(); }
+
+        /**
+         * @brief Get the hash of the content of a file, computed once per file
+         * @param file_name Path of the file
+         * @return Hexadecimal representation of the hash
+         */
+        std::string getFileHash(const std::string& file_name);
+
+        /**
+         * @brief Get the hash of a string
+         * @param str String to hash
+         * @return Hexadecimal representation of the hash
+         */
+        static std::string getHash(const std::string& str);
+
+        /**
+         * @brief Load an entry from the cache
+         * @param key Key of the entry
+         * @param data Objects to load the entry into
+         * @return True if the entry has been found and read, false otherwise
+         */
+        template <typename... T> bool load(const std::string& key, T&... data) const {
+            if(!enabled()) {
+                return false;
+            }
+            auto path = get_path(key);
+            std::ifstream file(path, std::ios::binary);
+            if(!file) {
+                LOG(DEBUG) << "No cache entry " << path;
+                return false;
+            }
+
+            try {
+                cereal::PortableBinaryInputArchive archive(file);
+                std::string stored_key;
+                archive(stored_key);
+                if(stored_key != key) {
+                    LOG(WARNING) << "Cache entry " << path << " does not match its key, ignoring";
+                    return false;
+                }
+                archive(data...);
+            } catch(cereal::Exception& e) {
+                LOG(WARNING) << "Could not read cache entry " << path << ", ignoring: " << e.what();
+                return false;
+            }
+            LOG(STATUS) << "Using cache entry " << path;
+            return true;
+        }
+
+        /**
+         * @brief Store an entry in the cache, overwriting any existing entry with the same key
+         * @param key Key of the entry
+         * @param data Objects to store
+         */
+        template <typename... T> void store(const std::string& key, const T&... data) const {
+            if(!enabled()) {
+                return;
+            }
+
+            // Write to a temporary file first, such that interrupted writes never leave a truncated entry behind
+            auto path = get_path(key);
+            auto temporary_path = path;
+            temporary_path += ".tmp";
+            {
+                std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+                cereal::PortableBinaryOutputArchive archive(file);
+                archive(key, data...);
+                if(!file.good()) {
+                    LOG(WARNING) << "Could not write cache entry " << path;
+                    return;
+                }
+            }
+            std::filesystem::rename(temporary_path, path);
+            LOG(INFO) << "Stored cache entry " << path;
+        }
+
+    private:
+        std::filesystem::path get_path(const std::string& key) const { return directory_ / (key + ".cache"); }
+
+        std::filesystem::path directory_;
+        std::map<std::string, std::string> file_hashes_;
+    };
+} // namespace mesh_converter
+
+#endif // ALLPIX_MESHCACHE_H
@@ -9,13 +9,19 @@
  */
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cfloat>
 #include <chrono>
 #include <climits>
+#include <cmath>
 #include <csignal>
+#include <cstdint>
 #include <cstdlib>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -32,10 +38,13 @@
 #include "core/utils/log.h"
 #include "core/utils/unit.h"
 #include "tools/ROOT.h"
+#include "tools/field_mesh.h"
 #include "tools/field_parser.h"
 #include "tools/units.h"
 
+#include "MeshCache.hpp"
 #include "MeshElement.hpp"
+#include "MeshLocator.hpp"
 #include "MeshParser.hpp"
 #include "combinations/combinations.h"
 #include "octree/Octree.hpp"
@@ -187,14 +196,27 @@ int main(int argc, char** argv) {
         // Output file format:
         auto format = config.get<std::string>("model", "apf");
         std::transform(format.begin(), format.end(), format.begin(), ::tolower);
-        FileType file_type = (format == "init" ? FileType::INIT : format == "apf" ? FileType::APF : FileType::UNKNOWN);
-        if(file_type == FileType::UNKNOWN) {
-            throw allpix::InvalidValueError(config, "model", "only models 'apf' and 'init' are currently supported");
+        FileType file_type = (format == "init"     ? FileType::INIT
+                              : format == "apf"    ? FileType::APF
+                              : format == "mapped" ? FileType::MAPPED
+                                                   : FileType::UNKNOWN);
+        // The tetrahedral mesh is written directly without interpolating the field on a regular grid
+        const auto write_mesh = (format == "mesh");
+        if(file_type == FileType::UNKNOWN && !write_mesh) {
+            throw allpix::InvalidValueError(
+                config, "model", "only models 'apf', 'mapped', 'init' and 'mesh' are currently supported");
         }
 
         // Input file parser:
         auto parser = MeshParser::factory(config);
 
+        // Persistent cache of parsed input files and interpolated meshes:
+        std::shared_ptr<MeshCache> cache;
+        if(config.has("cache_directory")) {
+            cache = std::make_shared<MeshCache>(config.getPath("cache_directory"));
+            parser->setCache(cache);
+        }
+
         // Region, observable and binning of output field
         auto regions = config.getArray<std::string>("region");
         auto observable = config.get<std::string>("observable");
@@ -212,6 +234,17 @@ int main(int argc, char** argv) {
         const auto allow_decay = config.get<bool>("allow_coplanar_interpolation", false);
         const auto radius_step = config.get<double>("radius_step", 0.5);
         const auto volume_cut = config.get<double>("volume_cut", 10e-9);
+        const auto use_connectivity = config.get<bool>("use_connectivity", true);
+
+        // Refinement of cells with strongly varying field, disabled for a factor of one
+        const auto refinement_factor = config.get<unsigned int>("refinement_factor", 1);
+        const auto refinement_threshold = config.get<double>("refinement_threshold", 0.1);
+        if(refinement_factor == 0) {
+            throw allpix::InvalidValueError(config, "refinement_factor", "refinement factor needs to be at least one");
+        }
+        if(refinement_factor > 1 && file_type != FileType::APF) {
+            throw allpix::InvalidValueError(config, "refinement_factor", "refined cells can only be stored in APF files");
+        }
 
         // Swapping elements
         auto rot = config.getArray<std::string>("xyz", {"x", "y", "z"});
@@ -311,6 +344,25 @@ int main(int argc, char** argv) {
                   << max_radius;
         const auto allow_failed_interpolation = config.get<bool>("allow_failure", false);
 
+        // The interpolated mesh depends on the input files and all parameters of the interpolation:
+        std::string interpolation_key;
+        if(cache) {
+            std::stringstream parameters;
+            parameters << std::setprecision(17) << cache->getFileHash(grid_file) << cache->getFileHash(data_file) << " "
+                       << observable;
+            for(const auto& name : regions) {
+                parameters << " \"" << name << "\"";
+            }
+            for(const auto& axis : rot) {
+                parameters << " " << axis;
+            }
+            parameters << " " << divisions.x() << " " << divisions.y() << " " << divisions.z() << " " << interpolate << " "
+                       << use_connectivity << " " << allow_decay << " " << allow_failed_interpolation << " " << radius_step
+                       << " " << volume_cut << " " << initial_radius << " " << max_radius << " " << vector_field << " "
+                       << units << " " << refinement_factor << " " << refinement_threshold;
+            interpolation_key = "interpolation_" + MeshCache::getHash(parameters.str());
+        }
+
         if(rot.at(0) != "x" || rot.at(1) != "y" || rot.at(2) != "z") {
             LOG(STATUS) << "TCAD mesh (x,y,z) coords. transformation into: (" << rot.at(0) << "," << rot.at(1) << ","
                         << rot.at(2) << ")";
@@ -349,37 +401,114 @@ int main(int argc, char** argv) {
         auto elapsed_seconds = std::chrono::duration_cast<std::chrono::seconds>(end - start).count();
         LOG(INFO) << "Reading the files took " << elapsed_seconds << " seconds.";
 
-        // Initializing the Octree with points from mesh cloud.
-        unibn::Octree<Point> octree;
-        octree.initialize(points);
+        // Output field data in framework-internal units, written by the workers directly into disjoint slices
+        FieldQuantity quantity = (vector_field ? FieldQuantity::VECTOR : FieldQuantity::SCALAR);
+        const size_t components = (quantity == FieldQuantity::VECTOR ? 3 : 1);
+        const auto unit_factor = Units::get(units);
+
+        // For a scalar field, only one value is stored, but which one depends on the field rotation. We need the original
+        // x-position, as that is the only filled one in the parsed field
+        const auto scalar_index = (rot.at(1) == "-x" || rot.at(1) == "x"   ? 1
+                                   : rot.at(2) == "-x" || rot.at(2) == "x" ? 2
+                                                                           : 0);
+        auto store_point = [&](double* values, const Point& point) {
+            if(quantity == FieldQuantity::VECTOR) {
+                values[0] = point.x * unit_factor;
+                values[1] = point.y * unit_factor;
+                values[2] = point.z * unit_factor;
+            } else {
+                values[0] = (scalar_index == 1 ? point.y : scalar_index == 2 ? point.z : point.x) * unit_factor;
+            }
+        };
+
+        if(write_mesh) {
+            if(dimension != 3) {
+                throw allpix::InvalidValueError(config, "model", "only 3D meshes can be written as tetrahedral mesh");
+            }
+            auto simplices = parser->getElements(grid_file, regions);
+            if(simplices.empty()) {
+                throw allpix::InvalidValueError(
+                    config, "model", "the input files do not provide the connectivity of the mesh");
+            }
+
+            // Vertices and field values in framework-internal units
+            std::vector<double> vertices;
+            vertices.reserve(points.size() * 3);
+            std::vector<double> values(points.size() * components);
+            for(size_t i = 0; i < points.size(); ++i) {
+                vertices.push_back(Units::get(points[i].x, "um"));
+                vertices.push_back(Units::get(points[i].y, "um"));
+                vertices.push_back(Units::get(points[i].z, "um"));
+                store_point(values.data() + i * components, field[i]);
+            }
+            std::vector<std::uint32_t> elements;
+            elements.reserve(simplices.size() * 4);
+            for(const auto& simplex : simplices) {
+                for(auto vertex : simplex) {
+                    elements.push_back(static_cast<std::uint32_t>(vertex));
+                }
+            }
 
-        unsigned int mesh_points_done = 0;
-        auto mesh_section = [&](double x, double y) {
-            Log::setReportingLevel(log_level);
+            allpix::FieldMesh mesh(std::move(vertices), std::move(elements), std::move(values), components);
+            std::string mesh_file_name = init_file_prefix + "_" + observable + ".apm";
+            mesh.write(mesh_file_name);
+            LOG(STATUS) << "Tetrahedral mesh with " << mesh.getElementCount() << " tetrahedra and " << mesh.getVertexCount()
+                        << " vertices written to file \"" << mesh_file_name << "\"";
 
-            // New mesh slice
-            std::vector<Point> new_mesh;
+            end = std::chrono::system_clock::now();
+            elapsed_seconds = std::chrono::duration_cast<std::chrono::seconds>(end - start).count();
+            LOG(STATUS) << "Conversion completed in " << elapsed_seconds << " seconds.";
+            Log::finish();
+            return return_code;
+        }
 
-            double z = minz + zstep / 2.0;
-            for(unsigned int k = 0; k < divisions.z(); ++k) {
-                // New mesh vertex and field
-                auto q = (dimension == 2 ? Point(y, z) : Point(x, y, z));
-                Point e;
+        auto data = std::make_shared<std::vector<double>>();
+        auto refinement = std::make_shared<allpix::FieldRefinement>();
+        if(!cache || !cache->load(interpolation_key, *data, *refinement)) {
+            data->resize(static_cast<size_t>(mesh_points_total) * components);
+
+            // Initializing the Octree with points from mesh cloud.
+            unibn::Octree<Point> octree;
+            octree.initialize(points);
+
+            // Locate points directly in the elements of the mesh if the parser provides its connectivity:
+            std::unique_ptr<MeshLocator> locator;
+            if(interpolate && use_connectivity) {
+                auto simplices = parser->getElements(grid_file, regions);
+                if(!simplices.empty()) {
+                    LOG(INFO) << "Locating points in " << simplices.size()
+                              << " mesh elements, using neighbor search only for points outside of these";
+                    locator = std::make_unique<MeshLocator>(dimension, points, field, std::move(simplices));
+                } else {
+                    LOG(INFO) << "No mesh connectivity available, using neighbor search for all points";
+                }
+            }
 
+            // Interpolate the field at a new mesh vertex, using the mesh element found for the previous vertex as hint
+            auto interpolate_point = [&](Point& q, size_t& hint) {
                 // No interpolation requested, return nearest neighbor:
                 if(!interpolate) {
                     auto idx = static_cast<size_t>(octree.findNeighbor<unibn::L2Distance<Point>>(q));
-                    new_mesh.push_back(field.at(idx));
-                    z += zstep;
-                    continue;
+                    return field.at(idx);
                 }
 
+                Point e;
                 bool valid = false;
                 bool allow_zero_volume = false;
                 size_t prev_neighbours = 0;
                 double radius = initial_radius;
 
-                while(radius <= max_radius) {
+                if(locator && locator->locate(q, volume_cut, hint)) {
+                    auto element = locator->getElement(hint);
+                    LOG(DEBUG) << element.print(q);
+                    e = element.getObservable(q);
+                    valid = e.isFinite();
+                    if(!valid) {
+                        LOG(WARNING) << "Interpolated result not a finite number at " << q;
+                    }
+                }
+
+                while(!valid && radius <= max_radius) {
                     LOG(DEBUG) << "Search radius: " << radius;
                     // Calling octree neighbours search and sorting the results list with the closest neighbours first
                     std::vector<unsigned int> results;
@@ -389,8 +518,8 @@ int main(int argc, char** argv) {
                     if(radius == initial_radius && results.size() > 100) {
                         LOG(WARNING) << "Found " << results.size() << " mesh vertices within initial search radius of "
                                      << initial_radius << "um." << std::endl
-                                     << "This might indicate that the output mesh granularity is too low and field features "
-                                        "might be missed."
+                                     << "This might indicate that the output mesh granularity is too low and field "
+                                        "features might be missed."
                                      << std::endl
                                      << "Consider increasing output mesh granularity.";
                     }
@@ -419,15 +548,15 @@ int main(int argc, char** argv) {
                         allow_zero_volume = true;
                     }
 
-                    // Sort by lowest distance first, this drastically reduces the number of permutations required to find a
-                    // valid mesh element and also ensures that this is the one with the smallest volume.
+                    // Sort by lowest distance first, this drastically reduces the number of permutations required to
+                    // find a valid mesh element and also ensures that this is the one with the smallest volume.
                     std::sort(results.begin(), results.end(), [&](unsigned int a, unsigned int b) {
                         return unibn::L2Distance<Point>::compute(points[a], q) <
                                unibn::L2Distance<Point>::compute(points[b], q);
                     });
 
-                    // Finding tetrahedrons by checking all combinations of N elements, starting with closest to reference
-                    // point
+                    // Finding tetrahedrons by checking all combinations of N elements, starting with closest to
+                    // reference point
                     auto res = for_each_combination(results.begin(),
                                                     results.begin() + (dimension == 3 ? 4 : 3),
                                                     results.end(),
@@ -453,53 +582,161 @@ int main(int argc, char** argv) {
                     LOG(DEBUG) << "Failed to interpolate, setting element to zero";
                     e = {};
                 }
+                return e;
+            };
+
+            std::atomic<unsigned int> mesh_points_done{0};
+            auto mesh_section = [&](unsigned int i, unsigned int j, double x, double y) {
+                Log::setReportingLevel(log_level);
+
+                // Index of the first point of this slice in the new mesh
+                const auto offset = (static_cast<size_t>(i) * divisions.y() + j) * divisions.z();
 
-                new_mesh.push_back(e);
-                z += zstep;
+                // Mesh element found for the previous point of the slice
+                size_t hint = MeshLocator::none;
+
+                double z = minz + zstep / 2.0;
+                for(unsigned int k = 0; k < divisions.z(); ++k) {
+                    // New mesh vertex and field
+                    auto q = (dimension == 2 ? Point(y, z) : Point(x, y, z));
+                    store_point(data->data() + (offset + k) * components, interpolate_point(q, hint));
+                    z += zstep;
+                }
+
+                auto points_done = (mesh_points_done += divisions.z());
+                LOG_PROGRESS(STATUS, "m") << (interpolate ? "Interpolating" : "Generating")
+                                          << " new mesh: " << points_done << " of " << mesh_points_total << ", "
+                                          << (points_done / (mesh_points_total / 100)) << "%";
+            };
+
+            // Start the interpolation on many threads:
+            auto num_threads = config.get<unsigned int>("workers", std::max(std::thread::hardware_concurrency(), 1u));
+            ThreadPool::registerThreadCount(num_threads);
+            LOG(STATUS) << "Starting regular grid interpolation with " << num_threads << " threads.";
+
+            // clang-format off
+            auto init_function = [log_level = Log::getReportingLevel(), log_format = Log::getFormat()]() {
+                // clang-format on
+                // Initialize the threads to the same log level and format as the master setting
+                Log::setReportingLevel(log_level);
+                Log::setFormat(log_format);
+            };
+
+            ThreadPool pool(num_threads, num_threads * 1024, init_function);
+            std::vector<std::shared_future<void>> mesh_futures;
+            // Set starting point
+            double x = minx + xstep / 2.0;
+            // Loop over x coordinate, add tasks for each coordinate to the queue
+            for(unsigned int i = 0; i < divisions.x(); ++i) {
+                double y = miny + ystep / 2.0;
+                for(unsigned int j = 0; j < divisions.y(); ++j) {
+                    mesh_futures.push_back(pool.submit(mesh_section, i, j, x, y));
+                    y += ystep;
+                }
+                x += xstep;
             }
 
-            mesh_points_done += divisions.z();
-            LOG_PROGRESS(STATUS, "m") << (interpolate ? "Interpolating" : "Generating") << " new mesh: " << mesh_points_done
-                                      << " of " << mesh_points_total << ", "
-                                      << (mesh_points_done / (mesh_points_total / 100)) << "%";
+            // Wait for all slices to be filled:
+            for(auto& mesh_future : mesh_futures) {
+                mesh_future.get();
+            }
 
-            return new_mesh;
-        };
+            // Select cells whose value differs from any of their neighbors by more than the threshold, relative to the
+            // larger of both values
+            if(refinement_factor > 1) {
+                auto variation = [&](size_t a, size_t b) {
+                    double difference = 0, value_a = 0, value_b = 0;
+                    for(size_t c = 0; c < components; ++c) {
+                        const auto first = (*data)[a * components + c];
+                        const auto second = (*data)[b * components + c];
+                        difference += (first - second) * (first - second);
+                        value_a += first * first;
+                        value_b += second * second;
+                    }
+                    const auto scale = std::max(value_a, value_b);
+                    return (scale > 0 ? std::sqrt(difference / scale) : 0.);
+                };
+
+                const std::array<size_t, 3> bins{{divisions.x(), divisions.y(), divisions.z()}};
+                const std::array<size_t, 3> strides{{bins[1] * bins[2], bins[2], 1}};
+                auto needs_refinement = [&](const std::array<size_t, 3>& index, size_t cell) {
+                    for(size_t axis = 0; axis < 3; ++axis) {
+                        if((index[axis] > 0 && variation(cell, cell - strides[axis]) > refinement_threshold) ||
+                           (index[axis] + 1 < bins[axis] && variation(cell, cell + strides[axis]) > refinement_threshold)) {
+                            return true;
+                        }
+                    }
+                    return false;
+                };
+
+                refinement->factor = refinement_factor;
+                refinement->bricks.assign(mesh_points_total, allpix::FieldRefinement::unrefined);
+                std::vector<size_t> refined_cells;
+                for(size_t i = 0; i < bins[0]; ++i) {
+                    for(size_t j = 0; j < bins[1]; ++j) {
+                        for(size_t k = 0; k < bins[2]; ++k) {
+                            const auto cell = i * strides[0] + j * strides[1] + k;
+                            if(needs_refinement({{i, j, k}}, cell)) {
+                                refinement->bricks[cell] = static_cast<std::uint32_t>(refined_cells.size());
+                                refined_cells.push_back(cell);
+                            }
+                        }
+                    }
+                }
 
-        // Start the interpolation on many threads:
-        auto num_threads = config.get<unsigned int>("workers", std::max(std::thread::hardware_concurrency(), 1u));
-        ThreadPool::registerThreadCount(num_threads);
-        LOG(STATUS) << "Starting regular grid interpolation with " << num_threads << " threads.";
-        std::vector<Point> e_field_new_mesh;
-
-        // clang-format off
-        auto init_function = [log_level = Log::getReportingLevel(), log_format = Log::getFormat()]() {
-            // clang-format on
-            // Initialize the threads to the same log level and format as the master setting
-            Log::setReportingLevel(log_level);
-            Log::setFormat(log_format);
-        };
+                const auto factors = refinement->getFactors(bins);
+                const auto brick_size = factors[0] * factors[1] * factors[2] * components;
+                const std::array<double, 3> sub_steps{{xstep / static_cast<double>(factors[0]),
+                                                       ystep / static_cast<double>(factors[1]),
+                                                       zstep / static_cast<double>(factors[2])}};
+                refinement->values.resize(refined_cells.size() * brick_size);
+                LOG(STATUS) << "Refining " << refined_cells.size() << " of " << mesh_points_total << " cells into "
+                            << factors[0] * factors[1] * factors[2] << " sub-cells each";
+
+                // Interpolate the sub-cells of a range of refined cells, starting from the lower corner of each cell
+                std::atomic<size_t> cells_done{0};
+                auto refine_cells = [&](size_t first, size_t last) {
+                    size_t hint = MeshLocator::none;
+                    for(size_t brick = first; brick < last; ++brick) {
+                        const auto cell = refined_cells[brick];
+                        const auto x_corner = minx + static_cast<double>(cell / strides[0]) * xstep;
+                        const auto y_corner = miny + static_cast<double>((cell / strides[1]) % bins[1]) * ystep;
+                        const auto z_corner = minz + static_cast<double>(cell % bins[2]) * zstep;
+                        auto* values = refinement->values.data() + brick * brick_size;
+                        for(size_t a = 0; a < factors[0]; ++a) {
+                            const auto x = x_corner + (static_cast<double>(a) + 0.5) * sub_steps[0];
+                            for(size_t b = 0; b < factors[1]; ++b) {
+                                const auto y = y_corner + (static_cast<double>(b) + 0.5) * sub_steps[1];
+                                for(size_t c = 0; c < factors[2]; ++c) {
+                                    const auto z = z_corner + (static_cast<double>(c) + 0.5) * sub_steps[2];
+                                    auto q = (dimension == 2 ? Point(y, z) : Point(x, y, z));
+                                    store_point(values, interpolate_point(q, hint));
+                                    values += components;
+                                }
+                            }
+                        }
+                    }
+
+                    auto done = (cells_done += last - first);
+                    LOG_PROGRESS(STATUS, "r") << "Refining cells: " << done << " of " << refined_cells.size();
+                };
 
-        ThreadPool pool(num_threads, num_threads * 1024, init_function);
-        std::vector<std::shared_future<std::vector<Point>>> mesh_futures;
-        // Set starting point
-        double x = minx + xstep / 2.0;
-        // Loop over x coordinate, add tasks for each coordinate to the queue
-        for(unsigned int i = 0; i < divisions.x(); ++i) {
-            double y = miny + ystep / 2.0;
-            for(unsigned int j = 0; j < divisions.y(); ++j) {
-                mesh_futures.push_back(pool.submit(mesh_section, x, y));
-                y += ystep;
+                std::vector<std::shared_future<void>> refine_futures;
+                constexpr size_t cells_per_task = 64;
+                for(size_t first = 0; first < refined_cells.size(); first += cells_per_task) {
+                    refine_futures.push_back(
+                        pool.submit(refine_cells, first, std::min(first + cells_per_task, refined_cells.size())));
+                }
+                for(auto& refine_future : refine_futures) {
+                    refine_future.get();
+                }
             }
-            x += xstep;
-        }
+            pool.destroy();
 
-        // Merge the result vectors:
-        for(auto& mesh_future : mesh_futures) {
-            auto mesh_slice = mesh_future.get();
-            e_field_new_mesh.insert(e_field_new_mesh.end(), mesh_slice.begin(), mesh_slice.end());
+            if(cache) {
+                cache->store(interpolation_key, *data, *refinement);
+            }
         }
-        pool.destroy();
 
         end = std::chrono::system_clock::now();
         elapsed_seconds = std::chrono::duration_cast<std::chrono::seconds>(end - start).count();
@@ -513,38 +750,13 @@ int main(int argc, char** argv) {
         std::array<size_t, 3> gridsize{
             {static_cast<size_t>(divisions.x()), static_cast<size_t>(divisions.y()), static_cast<size_t>(divisions.z())}};
 
-        FieldQuantity quantity = (vector_field ? FieldQuantity::VECTOR : FieldQuantity::SCALAR);
-        // Prepare data:
-        LOG(INFO) << "Preparing data for storage...";
-        auto data = std::make_shared<std::vector<double>>();
-        for(unsigned int i = 0; i < divisions.x(); ++i) {
-            for(unsigned int j = 0; j < divisions.y(); ++j) {
-                for(unsigned int k = 0; k < divisions.z(); ++k) {
-                    auto& point = e_field_new_mesh[i * divisions.y() * divisions.z() + j * divisions.z() + k];
-                    LOG(DEBUG) << "Values of data point (" << i << ", " << j << ", " << k << "): " << point;
-                    // For a vector field, we push three values:
-                    if(quantity == FieldQuantity::VECTOR) {
-                        // We need to convert to framework-internal units:
-                        data->push_back(Units::get(point.x, units));
-                        data->push_back(Units::get(point.y, units));
-                        data->push_back(Units::get(point.z, units));
-                    } else {
-                        // For a scalar field, we need to push only one value, but which one depends on the field rotation.
-                        // We need the original x-position, as that is the only filled one in the parsed field
-                        if(rot.at(1) == "-x" || rot.at(1) == "x") {
-                            data->push_back(Units::get(point.y, units));
-                        } else if(rot.at(2) == "-x" || rot.at(2) == "x") {
-                            data->push_back(Units::get(point.z, units));
-                        } else {
-                            data->push_back(Units::get(point.x, units));
-                        }
-                    }
-                }
-            }
-        }
-
         allpix::FieldData<double> field_data(header, gridsize, size, data);
-        std::string init_file_name = init_file_prefix + "_" + observable + (file_type == FileType::INIT ? ".init" : ".apf");
+        if(!refinement->values.empty()) {
+            field_data.setRefinement(refinement);
+        }
+        std::string init_file_name =
+            init_file_prefix + "_" + observable +
+            (file_type == FileType::INIT ? ".init" : file_type == FileType::MAPPED ? ".apfm" : ".apf");
 
         allpix::FieldWriter<double> field_writer(quantity);
         field_writer.writeFile(field_data, init_file_name, file_type, (file_type == FileType::INIT ? units : ""));
@@ -32,6 +32,8 @@ namespace mesh_converter {
         double x{0}, y{0}, z{0};
         unsigned int dim{0};
 
+        template <class Archive> void serialize(Archive& archive) { archive(x, y, z, dim); }
+
         friend std::ostream& operator<<(std::ostream& out, const Point& pt) {
             out << "(" << pt.x << "," << pt.y << "," << pt.z << ")";
             return out;
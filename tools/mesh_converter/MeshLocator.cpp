@@ -0,0 +1,127 @@
+/**
+ * @file
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "MeshLocator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "core/utils/log.h"
+
+using namespace mesh_converter;
+
+namespace {
+    double coordinate(const Point& point, size_t axis) { return (axis == 0 ? point.x : axis == 1 ? point.y : point.z); }
+} // namespace
+
+MeshLocator::MeshLocator(size_t dimension,
+                         const std::vector<Point>& points,
+                         const std::vector<Point>& field,
+                         std::vector<Simplex> simplices)
+    : dimension_(dimension), points_(&points), field_(&field), simplices_(std::move(simplices)) {
+    // 2D meshes only span the y-z plane:
+    const size_t first_axis = (dimension_ == 2 ? 1 : 0);
+
+    // Bounding box of the mesh and number of bins, aiming at about one simplex per bin
+    std::array<double, 3> max{};
+    for(size_t axis = first_axis; axis < 3; ++axis) {
+        auto range = std::minmax_element(points.begin(), points.end(), [axis](auto& a, auto& b) {
+            return coordinate(a, axis) < coordinate(b, axis);
+        });
+        min_[axis] = coordinate(*range.first, axis);
+        max[axis] = coordinate(*range.second, axis);
+    }
+    const auto simplices_count = static_cast<double>(std::max<size_t>(simplices_.size(), 1));
+    const auto bins_per_axis =
+        static_cast<size_t>(std::ceil(std::pow(simplices_count, 1. / static_cast<double>(dimension_))));
+    for(size_t axis = 0; axis < 3; ++axis) {
+        bins_[axis] = (axis < first_axis ? 1 : bins_per_axis);
+        bin_size_[axis] = (max[axis] - min_[axis]) / static_cast<double>(bins_[axis]);
+    }
+
+    // Bin range covered by the bounding box of a simplex
+    auto bin_range = [&](const Simplex& simplex) {
+        std::array<std::pair<size_t, size_t>, 3> range{};
+        for(size_t axis = 0; axis < 3; ++axis) {
+            double low = coordinate(points[simplex[0]], axis);
+            double high = low;
+            for(size_t i = 1; i < dimension_ + 1; ++i) {
+                low = std::min(low, coordinate(points[simplex[i]], axis));
+                high = std::max(high, coordinate(points[simplex[i]], axis));
+            }
+            range[axis] = {get_bin(axis, low), get_bin(axis, high)};
+        }
+        return range;
+    };
+    auto for_each_bin = [&](const Simplex& simplex, auto&& function) {
+        auto range = bin_range(simplex);
+        for(size_t i = range[0].first; i <= range[0].second; ++i) {
+            for(size_t j = range[1].first; j <= range[1].second; ++j) {
+                for(size_t k = range[2].first; k <= range[2].second; ++k) {
+                    function((i * bins_[1] + j) * bins_[2] + k);
+                }
+            }
+        }
+    };
+
+    // Count the simplices per bin, then fill them in starting at the offset of every bin
+    bin_offsets_.assign(bins_[0] * bins_[1] * bins_[2] + 1, 0);
+    for(const auto& simplex : simplices_) {
+        for_each_bin(simplex, [&](size_t bin) { bin_offsets_[bin + 1]++; });
+    }
+    for(size_t bin = 1; bin < bin_offsets_.size(); ++bin) {
+        bin_offsets_[bin] += bin_offsets_[bin - 1];
+    }
+    bin_simplices_.resize(bin_offsets_.back());
+    auto fill = bin_offsets_;
+    for(size_t index = 0; index < simplices_.size(); ++index) {
+        for_each_bin(simplices_[index], [&](size_t bin) { bin_simplices_[fill[bin]++] = index; });
+    }
+
+    LOG(DEBUG) << "Sorted " << simplices_.size() << " simplices into " << bin_offsets_.size() - 1 << " bins with "
+               << bin_simplices_.size() << " entries";
+}
+
+size_t MeshLocator::get_bin(size_t axis, double value) const {
+    if(bins_[axis] == 1 || bin_size_[axis] <= 0) {
+        return 0;
+    }
+    auto bin = std::floor((value - min_[axis]) / bin_size_[axis]);
+    return static_cast<size_t>(std::clamp(bin, 0., static_cast<double>(bins_[axis] - 1)));
+}
+
+bool MeshLocator::locate(Point& qp, double volume_cut, size_t& hint) const {
+    // Neighboring grid points frequently fall into the same simplex:
+    if(hint != none && getElement(hint).isValid(volume_cut, qp)) {
+        return true;
+    }
+
+    const auto bin = (get_bin(0, qp.x) * bins_[1] + get_bin(1, qp.y)) * bins_[2] + get_bin(2, qp.z);
+    for(auto entry = bin_offsets_[bin]; entry < bin_offsets_[bin + 1]; ++entry) {
+        const auto index = bin_simplices_[entry];
+        if(index != hint && getElement(index).isValid(volume_cut, qp)) {
+            hint = index;
+            return true;
+        }
+    }
+    return false;
+}
+
+MeshElement MeshLocator::getElement(size_t index) const {
+    std::array<Point, 4> vertices{};
+    std::array<Point, 4> observables{};
+    const auto& simplex = simplices_[index];
+    for(size_t i = 0; i < dimension_ + 1; ++i) {
+        vertices[i] = (*points_)[simplex[i]];
+        observables[i] = (*field_)[simplex[i]];
+    }
+    return {dimension_, vertices, observables};
+}
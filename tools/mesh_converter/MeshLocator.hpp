@@ -0,0 +1,86 @@
+/**
+ * @file
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_MESHLOCATOR_H
+#define ALLPIX_MESHLOCATOR_H
+
+#include <array>
+#include <limits>
+#include <vector>
+
+#include "MeshElement.hpp"
+#include "MeshParser.hpp"
+
+namespace mesh_converter {
+
+    /**
+     * @brief Point location in the tetrahedra or triangles of a mesh with known connectivity
+     *
+     * The bounding boxes of the simplices are sorted into a regular grid of bins covering the mesh, such that locating a
+     * point only requires testing the few simplices overlapping its bin. The simplex found for the previous point is tested
+     * first, since consecutive points of the regular output grid are close to each other and often lie in the same simplex.
+     */
+    class MeshLocator {
+    public:
+        /// Index indicating that no simplex has been found yet
+        static constexpr size_t none = std::numeric_limits<size_t>::max();
+
+        /**
+         * @brief Constructor sorting the simplices into the bins
+         * @param dimension Dimension of the mesh, 2 or 3
+         * @param points Vertices of the mesh
+         * @param field Observable at the vertices of the mesh
+         * @param simplices Simplices with indices into the vertices
+         */
+        MeshLocator(size_t dimension,
+                    const std::vector<Point>& points,
+                    const std::vector<Point>& field,
+                    std::vector<Simplex> simplices);
+
+        /**
+         * @brief Find the simplex containing a point
+         * @param qp Point to locate
+         * @param volume_cut Minimum volume of the simplex, see \ref MeshElement::isValid
+         * @param hint Index of the simplex to test first or \ref none, updated to the simplex found
+         * @return True if a simplex containing the point has been found
+         */
+        bool locate(Point& qp, double volume_cut, size_t& hint) const;
+
+        /**
+         * @brief Get the mesh element for the barycentric interpolation in a simplex
+         * @param index Index of the simplex
+         * @return Mesh element with the vertices and observables of the simplex
+         */
+        MeshElement getElement(size_t index) const;
+
+    private:
+        /**
+         * @brief Get the bin index of a coordinate along one axis
+         * @param axis Axis of the coordinate
+         * @param value Coordinate
+         * @return Index of the bin, clamped to the grid
+         */
+        size_t get_bin(size_t axis, double value) const;
+
+        size_t dimension_;
+        const std::vector<Point>* points_;
+        const std::vector<Point>* field_;
+        std::vector<Simplex> simplices_;
+
+        // Regular grid of bins, storing the simplices of every bin consecutively starting at its offset
+        std::array<double, 3> min_{}, bin_size_{};
+        std::array<size_t, 3> bins_{};
+        std::vector<size_t> bin_offsets_;
+        std::vector<size_t> bin_simplices_;
+    };
+
+} // namespace mesh_converter
+
+#endif // ALLPIX_MESHLOCATOR_H
@@ -29,10 +29,17 @@ std::shared_ptr<MeshParser> MeshParser::factory(const allpix::Configuration& con
 
 std::vector<Point> MeshParser::getMesh(const std::string& file, const std::vector<std::string>& regions) {
 
-    // Populate mesh map once:
+    // Populate mesh map once, either from the persistent cache or from the file:
     if(mesh_map_[file].empty()) {
-        LOG(STATUS) << "Reading mesh grid from file \"" << file << "\"";
-        mesh_map_[file] = read_meshes(file);
+        auto key = (cache_ ? "mesh_" + cache_->getFileHash(file) : std::string());
+        if(!cache_ || !cache_->load(key, mesh_map_[file], element_map_[file])) {
+            LOG(STATUS) << "Reading mesh grid from file \"" << file << "\"";
+            mesh_map_[file] = read_meshes(file);
+            element_map_[file] = read_elements(file);
+            if(cache_) {
+                cache_->store(key, mesh_map_[file], element_map_[file]);
+            }
+        }
         LOG(INFO) << "Grid sizes for all regions:";
         for(auto& reg : mesh_map_[file]) {
             LOG(INFO) << "\t" << std::left << std::setw(25) << reg.first << " " << reg.second.size();
@@ -62,10 +69,16 @@ std::vector<Point> MeshParser::getMesh(const std::string& file, const std::vecto
 std::vector<Point>
 MeshParser::getField(const std::string& file, const std::string& observable, const std::vector<std::string>& regions) {
 
-    // Populate field map once:
+    // Populate field map once, either from the persistent cache or from the file:
     if(field_map_[file].empty()) {
-        LOG(STATUS) << "Reading field from file \"" << file << "\"";
-        field_map_[file] = read_fields(file, observable);
+        auto key = (cache_ ? "field_" + MeshCache::getHash(cache_->getFileHash(file) + observable) : std::string());
+        if(!cache_ || !cache_->load(key, field_map_[file])) {
+            LOG(STATUS) << "Reading field from file \"" << file << "\"";
+            field_map_[file] = read_fields(file, observable);
+            if(cache_) {
+                cache_->store(key, field_map_[file]);
+            }
+        }
         LOG(INFO) << "Field sizes for all regions and observables:";
         for(auto& reg : field_map_[file]) {
             LOG(INFO) << " " << reg.first << ":";
@@ -97,3 +110,28 @@ MeshParser::getField(const std::string& file, const std::string& observable, con
 
     return field;
 }
+
+std::vector<Simplex> MeshParser::getElements(const std::string& file, const std::vector<std::string>& regions) {
+    auto& elements = element_map_[file];
+
+    // Append the simplices of all regions, shifting the vertex indices by the points of the preceding regions:
+    std::vector<Simplex> simplices;
+    size_t offset = 0;
+    for(const auto& region : regions) {
+        auto region_elements = elements.find(region);
+        if(region_elements == elements.end()) {
+            LOG(DEBUG) << "No mesh elements known for region \"" << region << "\"";
+            return {};
+        }
+        for(auto simplex : region_elements->second) {
+            for(auto& index : simplex) {
+                index += offset;
+            }
+            simplices.push_back(simplex);
+        }
+        offset += mesh_map_[file][region].size();
+    }
+    LOG(DEBUG) << "Grid with " << simplices.size() << " simplices";
+
+    return simplices;
+}
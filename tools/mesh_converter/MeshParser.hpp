@@ -11,18 +11,24 @@
 #ifndef ALLPIX_MESHPARSER_H
 #define ALLPIX_MESHPARSER_H
 
+#include "MeshCache.hpp"
 #include "MeshElement.hpp"
 #include "core/config/Configuration.hpp"
 
+#include <array>
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace mesh_converter {
 
     using MeshMap = std::map<std::string, std::vector<Point>>;
     using FieldMap = std::map<std::string, std::map<std::string, std::vector<Point>>>;
+    // Indices of the vertices of a tetrahedron, or of a triangle in the first three entries
+    using Simplex = std::array<size_t, 4>;
+    using ElementMap = std::map<std::string, std::vector<Simplex>>;
 
     /**
      * @brief Parser class to read different data formats
@@ -39,6 +45,21 @@ namespace mesh_converter {
         std::vector<Point>
         getField(const std::string& file, const std::string& observable, const std::vector<std::string>& regions);
 
+        /**
+         * @brief Get the simplices of the mesh read from the given file
+         * @param  file    Canonical path of the grid file, already read via \ref getMesh
+         * @param  regions Regions to include, in the same order as for \ref getMesh
+         * @return         Simplices with vertex indices into the points returned by \ref getMesh, or an empty list if the
+         *                 connectivity of any of the regions is not known
+         */
+        std::vector<Simplex> getElements(const std::string& file, const std::vector<std::string>& regions);
+
+        /**
+         * @brief Set the cache to store parsed meshes and fields in and to retrieve them from
+         * @param cache Persistent cache of intermediate results
+         */
+        void setCache(std::shared_ptr<MeshCache> cache) { cache_ = std::move(cache); }
+
     protected:
         /**
          * @brief Default constructor
@@ -60,11 +81,23 @@ namespace mesh_converter {
          */
         virtual FieldMap read_fields(const std::string& file_name, const std::string& observable) = 0;
 
+        /**
+         * @brief Method to retrieve the connectivity of the mesh read from the given file
+         * @param  file_name Canonical path of the input file, already read via \ref read_meshes
+         * @return           Map with the simplices of all regions with vertex indices into the points of the region, empty
+         *                   if the format or the parser does not provide the connectivity
+         */
+        virtual ElementMap read_elements(const std::string&) { return {}; }
+
     private:
-        // Cache of parsed meshes for all regions
+        // Cache of parsed meshes and their connectivity for all regions
         std::map<std::string, MeshMap> mesh_map_;
+        std::map<std::string, ElementMap> element_map_;
         // Cache of parsed fields for all regions
         std::map<std::string, FieldMap> field_map_;
+
+        // Persistent cache shared with the converter
+        std::shared_ptr<MeshCache> cache_;
     };
 
 } // namespace mesh_converter
@@ -10,71 +10,101 @@
 
 #include "DFISEParser.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <cctype>
+#include <cmath>
 #include <cstdlib>
 #include <exception>
-#include <fstream>
 #include <iostream>
-#include <regex>
 #include <set>
 #include <string>
+#include <string_view>
 #include "TFile.h"
 #include "TTree.h"
 
+#include "MappedTextFile.hpp"
 #include "core/utils/log.h"
-#include "core/utils/text.h"
 
 using namespace mesh_converter;
 
-MeshMap DFISEParser::read_meshes(const std::string& file_name) {
-    std::ifstream file(file_name);
-    if(!file) {
-        throw std::runtime_error("file cannot be accessed");
+namespace {
+    // Parse a count or index given as header data or value, throwing if it is no number
+    long unsigned int parse_count(std::string_view str) {
+        long unsigned int count = 0;
+        if(!next_number(str, count)) {
+            throw std::runtime_error("invalid number \"" + std::string(str) + "\"");
+        }
+        return count;
     }
 
-    // Get the total number of lines to parse and reset file to the start:
-    auto num_lines = std::count(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>(), '\n');
-    file.clear();
-    file.seekg(0, std::ios::beg);
-    LOG(DEBUG) << "Grid file contains " << num_lines << " lines to parse";
+    // Parse the validity of a dataset given as `[ "region" ]`, failing for datasets valid in several regions
+    bool parse_validity(std::string_view value, std::string& region) {
+        if(value.size() < 2 || value.front() != '[' || value.back() != ']') {
+            return false;
+        }
+        value = trim_view(value.substr(1, value.size() - 2));
+        if(value.size() < 2 || value.front() != '"' || value.back() != '"') {
+            return false;
+        }
+        value = value.substr(1, value.size() - 2);
+        if(value.empty() || !std::all_of(value.begin(), value.end(), [](char c) {
+               return std::isalnum(static_cast<unsigned char>(c)) != 0 || c == '_' || c == '-' || c == '.';
+           })) {
+            return false;
+        }
+        region = std::string(value);
+        return true;
+    }
+} // namespace
+
+MeshMap DFISEParser::read_meshes(const std::string& file_name) {
+    // Map the file into memory, all lines are parsed in place:
+    MappedTextFile file(file_name);
 
     DFSection main_section = DFSection::HEADER;
     DFSection sub_section = DFSection::NONE;
 
     std::vector<Point> vertices;
     std::vector<std::pair<long unsigned int, long unsigned int>> edges;
-    std::vector<std::vector<long unsigned int>> faces;
-    std::vector<std::vector<long unsigned int>> elements;
+    // Vertex indices of all faces and elements, stored contiguously starting at the offset of every face or element
+    std::vector<long unsigned int> faces;
+    std::vector<size_t> face_offsets{0};
+    std::vector<long unsigned int> elements;
+    std::vector<size_t> element_offsets{0};
+    // Vertex indices of the face or element currently read
+    std::vector<long unsigned int> buffer;
 
     std::map<std::string, std::vector<long unsigned int>> regions_vertices;
+    std::map<std::string, std::vector<long unsigned int>> regions_elements;
 
     std::string region;
     long unsigned int dimension = 1;
     long unsigned int data_count = 0;
     bool in_data_block = false;
     long long num_lines_parsed = 0;
-    while(!file.eof()) {
-        std::string line;
-        std::getline(file, line);
-
+    std::string_view line;
+    while(file.getLine(line)) {
         // Log the parsing progress:
-        if(num_lines > 0 && num_lines_parsed % 1000 == 0) {
-            LOG_PROGRESS(STATUS, "gridlines") << "Parsing grid file: " << (100 * num_lines_parsed / num_lines) << "%";
+        if(num_lines_parsed % 1000 == 0) {
+            LOG_PROGRESS(STATUS, "gridlines") << "Parsing grid file: " << file.getProgress() << "%";
         }
         num_lines_parsed++;
 
-        line = allpix::trim(line);
         if(line.empty()) {
             continue;
         }
 
         // Check if line with begin of section
         if(line.find('{') != std::string::npos) {
+            std::string_view header_string;
+            std::string_view header_data;
+            if(!split_header(line, header_string, header_data)) {
+                continue;
+            }
+
             // Search for new simple headers
-            auto base_regex = std::regex("([a-zA-Z]+) \\{");
-            std::smatch base_match;
-            if(std::regex_match(line, base_match, base_regex) && base_match.ready()) {
-                auto header_string = base_match[1].str();
+            if(header_data.empty()) {
 
                 if(header_string == "Info") {
                     main_section = DFSection::INFO;
@@ -90,30 +120,26 @@ MeshMap DFISEParser::read_meshes(const std::string& file_name) {
             }
 
             // Search for headers with data
-            base_regex = std::regex("([a-zA-Z]+) \\((\\S+)\\) \\{");
-            if(std::regex_match(line, base_match, base_regex) && base_match.ready()) {
-                auto header_string = base_match[1].str();
-                auto header_data = base_match[2].str();
-
+            if(!header_data.empty()) {
                 if(header_string == "Region") {
                     main_section = DFSection::REGION;
-                    region = header_data.substr(1, header_data.size() - 2);
+                    region = std::string(header_data.substr(1, header_data.size() - 2));
                 } else if(header_string == "Vertices") {
                     main_section = DFSection::VERTICES;
-                    data_count = std::stoul(header_data);
+                    data_count = parse_count(header_data);
                 } else if(header_string == "Edges") {
                     main_section = DFSection::EDGES;
-                    data_count = std::stoul(header_data);
+                    data_count = parse_count(header_data);
                 } else if(header_string == "Faces") {
                     main_section = DFSection::FACES;
-                    data_count = std::stoul(header_data);
+                    data_count = parse_count(header_data);
                 } else if(header_string == "Elements") {
                     if(main_section == DFSection::REGION) {
                         sub_section = DFSection::ELEMENTS;
                     } else {
                         main_section = DFSection::ELEMENTS;
                     }
-                    data_count = std::stoul(header_data);
+                    data_count = parse_count(header_data);
                 } else {
                     if(main_section != DFSection::NONE) {
                         sub_section = DFSection::IGNORED;
@@ -140,12 +166,12 @@ MeshMap DFISEParser::read_meshes(const std::string& file_name) {
                 }
                 break;
             case DFSection::FACES:
-                if(faces.size() != data_count) {
+                if(face_offsets.size() - 1 != data_count) {
                     throw std::runtime_error("incorrect number of faces");
                 }
                 break;
             case DFSection::ELEMENTS:
-                if(elements.size() != data_count) {
+                if(element_offsets.size() - 1 != data_count) {
                     throw std::runtime_error("incorrect number of elements");
                 }
                 break;
@@ -169,19 +195,16 @@ MeshMap DFISEParser::read_meshes(const std::string& file_name) {
 
         // Look for key data pairs
         if(line.find('=') != std::string::npos) {
-            auto base_regex = std::regex("([a-zA-Z]+)\\s+=\\s+([\\S ]+)");
-            std::smatch base_match;
-            if(std::regex_match(line, base_match, base_regex) && base_match.ready()) {
-                auto key = base_match[1].str();
-                auto value = allpix::trim(base_match[2].str());
-
+            std::string_view key;
+            std::string_view value;
+            if(split_key_value(line, key, value)) {
                 // Filter correct electric field type
                 if(main_section == DFSection::INFO) {
-                    if(key == "dimension" && (std::stoul(value) != 3 && std::stoul(value) != 2)) {
+                    if(key == "dimension" && (parse_count(value) != 3 && parse_count(value) != 2)) {
                         main_section = DFSection::IGNORED;
                     }
-                    if(key == "dimension" && (std::stoul(value) == 3 || std::stoul(value) == 2)) {
-                        dimension = std::stoul(value);
+                    if(key == "dimension" && (parse_count(value) == 3 || parse_count(value) == 2)) {
+                        dimension = parse_count(value);
                     }
                 }
             }
@@ -189,7 +212,6 @@ MeshMap DFISEParser::read_meshes(const std::string& file_name) {
         }
 
         // Handle data
-        std::stringstream sstr(line);
         switch(main_section) {
         case DFSection::HEADER:
             if(line != "DF-ISE text") {
@@ -201,13 +223,13 @@ MeshMap DFISEParser::read_meshes(const std::string& file_name) {
             // Read vertex points
             if(dimension == 3) {
                 double x = 0, y = 0, z = 0;
-                while(sstr >> x >> y >> z) {
+                while(next_number(line, x) && next_number(line, y) && next_number(line, z)) {
                     vertices.emplace_back(x, y, z);
                 }
             }
             if(dimension == 2) {
                 double y = 0, z = 0;
-                while(sstr >> y >> z) {
+                while(next_number(line, y) && next_number(line, z)) {
                     vertices.emplace_back(y, z);
                 }
             }
@@ -215,7 +237,7 @@ MeshMap DFISEParser::read_meshes(const std::string& file_name) {
         case DFSection::EDGES: {
             // Read edges
             std::pair<long unsigned int, long unsigned int> edge;
-            while(sstr >> edge.first >> edge.second) {
+            while(next_number(line, edge.first) && next_number(line, edge.second)) {
                 if(edge.first >= vertices.size() || edge.second >= vertices.size()) {
                     throw std::runtime_error("vertex index is higher than number of vertices");
                 }
@@ -225,11 +247,12 @@ MeshMap DFISEParser::read_meshes(const std::string& file_name) {
         case DFSection::FACES: {
             // Get vertex indices for every face
             size_t n = 0;
-            sstr >> n;
-            std::vector<long unsigned int> face;
+            next_number(line, n);
+            auto& face = buffer;
+            face.clear();
             for(size_t i = 0; i < n; ++i) {
                 long edge_idx = 0;
-                sstr >> edge_idx;
+                next_number(line, edge_idx);
 
                 bool swap = false;
                 if(edge_idx < 0) {
@@ -264,12 +287,14 @@ MeshMap DFISEParser::read_meshes(const std::string& file_name) {
             face.erase(iter, face.end());
             face.pop_back();
 
-            faces.push_back(face);
+            faces.insert(faces.end(), face.begin(), face.end());
+            face_offsets.push_back(faces.size());
         } break;
         case DFSection::ELEMENTS: {
             int k = 0;
-            sstr >> k;
-            std::vector<long unsigned int> element;
+            next_number(line, k);
+            auto& element = buffer;
+            element.clear();
 
             size_t size = 0;
             switch(k) {
@@ -303,7 +328,7 @@ MeshMap DFISEParser::read_meshes(const std::string& file_name) {
 
             for(size_t i = 0; i < size; ++i) {
                 long element_idx = 0;
-                sstr >> element_idx;
+                next_number(line, element_idx);
 
                 bool reverse = false;
                 if(element_idx < 0) {
@@ -323,18 +348,23 @@ MeshMap DFISEParser::read_meshes(const std::string& file_name) {
                     element.push_back(edge.second);
                 }
                 if(size == 4) {
-                    if(element_idx >= static_cast<long>(faces.size())) {
+                    if(element_idx >= static_cast<long>(face_offsets.size() - 1)) {
                         throw std::runtime_error("face index is higher than number of faces");
                     }
-                    auto face = faces[static_cast<size_t>(element_idx)];
-                    if(reverse) {
-                        std::reverse(face.begin() + 1, face.end());
+                    auto face_begin = faces.begin() + static_cast<long>(face_offsets[static_cast<size_t>(element_idx)]);
+                    auto face_end = faces.begin() + static_cast<long>(face_offsets[static_cast<size_t>(element_idx) + 1]);
+                    if(reverse && face_begin != face_end) {
+                        element.push_back(*face_begin);
+                        element.insert(
+                            element.end(), std::make_reverse_iterator(face_end), std::make_reverse_iterator(face_begin + 1));
+                    } else {
+                        element.insert(element.end(), face_begin, face_end);
                     }
-                    element.insert(element.end(), face.begin(), face.end());
                 }
             }
 
-            elements.push_back(element);
+            elements.insert(elements.end(), element.begin(), element.end());
+            element_offsets.push_back(elements.size());
             break;
         }
         case DFSection::REGION: {
@@ -342,13 +372,16 @@ MeshMap DFISEParser::read_meshes(const std::string& file_name) {
                 continue;
             }
             long unsigned int elem_idx = 0;
-            while(sstr >> elem_idx) {
-                if(elem_idx >= elements.size()) {
+            auto& region_vertices = regions_vertices[region];
+            while(next_number(line, elem_idx)) {
+                if(elem_idx >= element_offsets.size() - 1) {
                     throw std::runtime_error("element index is higher than number of elements");
                 }
 
-                regions_vertices[region].insert(
-                    regions_vertices[region].end(), elements[elem_idx].begin(), elements[elem_idx].end());
+                region_vertices.insert(region_vertices.end(),
+                                       elements.begin() + static_cast<long>(element_offsets[elem_idx]),
+                                       elements.begin() + static_cast<long>(element_offsets[elem_idx + 1]));
+                regions_elements[region].push_back(elem_idx);
             }
 
         } break;
@@ -359,6 +392,7 @@ MeshMap DFISEParser::read_meshes(const std::string& file_name) {
     LOG_PROGRESS(STATUS, "gridlines") << "Parsing grid file: done.";
 
     std::map<std::string, std::vector<Point>> ret_map;
+    auto& ret_elements = elements_[file_name];
     for(auto& name_region_vertices : regions_vertices) {
         auto region_vertices = name_region_vertices.second;
 
@@ -373,22 +407,47 @@ MeshMap DFISEParser::read_meshes(const std::string& file_name) {
         }
 
         ret_map[name_region_vertices.first] = ret_vector;
+
+        // Store the tetrahedra or triangles of the region with the indices of their vertices within the region. Other
+        // element types are skipped, points within them are located via the neighbor search of the converter.
+        auto& region_simplices = ret_elements[name_region_vertices.first];
+        size_t skipped = 0;
+        for(auto& elem_idx : regions_elements[name_region_vertices.first]) {
+            auto& element = buffer;
+            element.assign(elements.begin() + static_cast<long>(element_offsets[elem_idx]),
+                           elements.begin() + static_cast<long>(element_offsets[elem_idx + 1]));
+            std::sort(element.begin(), element.end());
+            element.erase(std::unique(element.begin(), element.end()), element.end());
+            if(element.size() != dimension + 1) {
+                skipped++;
+                continue;
+            }
+
+            Simplex simplex{};
+            for(size_t i = 0; i < element.size(); ++i) {
+                simplex[i] = static_cast<size_t>(
+                    std::lower_bound(region_vertices.begin(), region_vertices.end(), element[i]) - region_vertices.begin());
+            }
+            region_simplices.push_back(simplex);
+        }
+        if(skipped > 0) {
+            LOG(DEBUG) << "Skipped " << skipped << " elements of region \"" << name_region_vertices.first
+                       << "\" which are no " << (dimension == 3 ? "tetrahedra" : "triangles");
+        }
     }
 
     return ret_map;
 }
 
-FieldMap DFISEParser::read_fields(const std::string& file_name, const std::string&) {
-    std::ifstream file(file_name);
-    if(!file) {
-        throw std::runtime_error("file cannot be accessed");
-    }
+ElementMap DFISEParser::read_elements(const std::string& file_name) {
+    auto elements = std::move(elements_[file_name]);
+    elements_.erase(file_name);
+    return elements;
+}
 
-    // Get the total number of lines to parse and reset file to the start:
-    auto num_lines = std::count(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>(), '\n');
-    file.clear();
-    file.seekg(0, std::ios::beg);
-    LOG(DEBUG) << "Field data file contains " << num_lines << " lines to parse";
+FieldMap DFISEParser::read_fields(const std::string& file_name, const std::string&) {
+    // Map the file into memory, all lines are parsed in place:
+    MappedTextFile file(file_name);
 
     DFSection main_section = DFSection::HEADER;
     DFSection sub_section = DFSection::NONE;
@@ -403,14 +462,11 @@ FieldMap DFISEParser::read_fields(const std::string& file_name, const std::strin
     long unsigned int data_count = 0;
     bool in_data_block = false;
     long long num_lines_parsed = 0;
-    while(!file.eof()) {
-        std::string line;
-        std::getline(file, line);
-        line = allpix::trim(line);
-
+    std::string_view line;
+    while(file.getLine(line)) {
         // Log the parsing progress:
-        if(num_lines > 0 && num_lines_parsed % 1000 == 0) {
-            LOG_PROGRESS(STATUS, "fieldlines") << "Parsing field data file: " << (100 * num_lines_parsed / num_lines) << "%";
+        if(num_lines_parsed % 1000 == 0) {
+            LOG_PROGRESS(STATUS, "fieldlines") << "Parsing field data file: " << file.getProgress() << "%";
         }
         num_lines_parsed++;
 
@@ -420,11 +476,14 @@ FieldMap DFISEParser::read_fields(const std::string& file_name, const std::strin
 
         // Check if line with begin of section
         if(line.find('{') != std::string::npos) {
+            std::string_view header_string;
+            std::string_view header_data;
+            if(!split_header(line, header_string, header_data)) {
+                continue;
+            }
+
             // Search for new simple headers
-            auto base_regex = std::regex("([a-zA-Z]+) \\{");
-            std::smatch base_match;
-            if(std::regex_match(line, base_match, base_regex) && base_match.ready()) {
-                auto header_string = base_match[1].str();
+            if(header_data.empty()) {
                 LOG(TRACE) << "Opening section " << header_string;
 
                 if(header_string == "Info") {
@@ -441,13 +500,9 @@ FieldMap DFISEParser::read_fields(const std::string& file_name, const std::strin
             }
 
             // Search for headers with data
-            base_regex = std::regex("([a-zA-Z]+) \\((\\S+)\\) \\{");
-            if(std::regex_match(line, base_match, base_regex) && base_match.ready()) {
-                auto header_string = base_match[1].str();
-                auto header_data = base_match[2].str();
-
+            if(!header_data.empty()) {
                 if(header_string == "Dataset") {
-                    std::string data_type = header_data.substr(1, header_data.size() - 2);
+                    auto data_type = header_data.substr(1, header_data.size() - 2);
                     LOG(DEBUG) << "Opening dataset of type " << data_type;
 
                     if(data_type == "ElectricField") {
@@ -466,7 +521,8 @@ FieldMap DFISEParser::read_fields(const std::string& file_name, const std::strin
                 } else if(header_string == "Values") {
                     LOG(DEBUG) << "Opening value section with " << header_data << " entries";
                     sub_section = DFSection::VALUES;
-                    data_count = std::stoul(header_data);
+                    data_count = parse_count(header_data);
+                    region_electric_field_num.reserve(data_count);
                 } else {
                     if(main_section != DFSection::NONE) {
                         sub_section = DFSection::IGNORED;
@@ -481,19 +537,12 @@ FieldMap DFISEParser::read_fields(const std::string& file_name, const std::strin
 
         // Look for key data pairs
         if(line.find('=') != std::string::npos) {
-            auto base_regex = std::regex("([a-zA-Z]+)\\s+=\\s+([\\S ]+)");
-            std::smatch base_match;
-            if(std::regex_match(line, base_match, base_regex) && base_match.ready()) {
-                auto key = base_match[1].str();
-                auto value = allpix::trim(base_match[2].str());
-
-                // Regular expression for matching validity region:
-                base_regex = std::regex("\\[\\s+\"([-\\w\\.]+)\"\\s+\\]");
+            std::string_view key;
+            std::string_view value;
+            if(split_key_value(line, key, value)) {
                 if(key == "validity") {
                     // Ignore any electric field valid for multiple regions
-                    if(std::regex_match(value, base_match, base_regex) && base_match.ready()) {
-                        region = base_match[1].str();
-                    } else {
+                    if(!parse_validity(value, region)) {
                         LOG(INFO) << "Could not determine validity region for string \"" << value << "\", ignoring.";
                         main_section = DFSection::IGNORED;
                     }
@@ -510,10 +559,10 @@ FieldMap DFISEParser::read_fields(const std::string& file_name, const std::strin
                     if(key == "type" && value != "vector") {
                         main_section = DFSection::IGNORED;
                     }
-                    if(key == "dimension" && (std::stoul(value) == 3 || std::stoul(value) == 2)) {
-                        dimension = std::stoul(value);
+                    if(key == "dimension" && (parse_count(value) == 3 || parse_count(value) == 2)) {
+                        dimension = parse_count(value);
                     }
-                    if(key == "dimension" && (std::stoul(value) != 3 && std::stoul(value) != 2)) {
+                    if(key == "dimension" && (parse_count(value) != 3 && parse_count(value) != 2)) {
                         main_section = DFSection::IGNORED;
                     }
                 }
@@ -524,10 +573,10 @@ FieldMap DFISEParser::read_fields(const std::string& file_name, const std::strin
                     if(key == "type" && value != "scalar") {
                         main_section = DFSection::IGNORED;
                     }
-                    if(key == "dimension" && std::stoul(value) == 1) {
-                        dimension = std::stoul(value);
+                    if(key == "dimension" && parse_count(value) == 1) {
+                        dimension = parse_count(value);
                     }
-                    if(key == "dimension" && std::stoul(value) != 1) {
+                    if(key == "dimension" && parse_count(value) != 1) {
                         main_section = DFSection::IGNORED;
                     }
                 }
@@ -537,10 +586,10 @@ FieldMap DFISEParser::read_fields(const std::string& file_name, const std::strin
                     if(key == "type" && value != "scalar") {
                         main_section = DFSection::IGNORED;
                     }
-                    if(key == "dimension" && std::stoul(value) == 1) {
-                        dimension = std::stoul(value);
+                    if(key == "dimension" && parse_count(value) == 1) {
+                        dimension = parse_count(value);
                     }
-                    if(key == "dimension" && std::stoul(value) != 1) {
+                    if(key == "dimension" && parse_count(value) != 1) {
                         main_section = DFSection::IGNORED;
                     }
                 }
@@ -551,10 +600,10 @@ FieldMap DFISEParser::read_fields(const std::string& file_name, const std::strin
                     if(key == "type" && value != "scalar") {
                         main_section = DFSection::IGNORED;
                     }
-                    if(key == "dimension" && std::stoul(value) == 1) {
-                        dimension = std::stoul(value);
+                    if(key == "dimension" && parse_count(value) == 1) {
+                        dimension = parse_count(value);
                     }
-                    if(key == "dimension" && std::stoul(value) != 1) {
+                    if(key == "dimension" && parse_count(value) != 1) {
                         main_section = DFSection::IGNORED;
                     }
                 }
@@ -565,10 +614,10 @@ FieldMap DFISEParser::read_fields(const std::string& file_name, const std::strin
                     if(key == "type" && value != "scalar") {
                         main_section = DFSection::IGNORED;
                     }
-                    if(key == "dimension" && std::stoul(value) == 1) {
-                        dimension = std::stoul(value);
+                    if(key == "dimension" && parse_count(value) == 1) {
+                        dimension = parse_count(value);
                     }
-                    if(key == "dimension" && std::stoul(value) != 1) {
+                    if(key == "dimension" && parse_count(value) != 1) {
                         main_section = DFSection::IGNORED;
                     }
                 }
@@ -583,10 +632,11 @@ FieldMap DFISEParser::read_fields(const std::string& file_name, const std::strin
                 if(data_count != region_electric_field_num.size()) {
                     throw std::runtime_error("incorrect number of electrostatic potential points");
                 }
+                auto& values = region_electric_field_map[region][observable];
 
                 for(size_t i = 0; i < region_electric_field_num.size(); i += 1) {
                     auto x = region_electric_field_num[i];
-                    region_electric_field_map[region][observable].emplace_back(x, 0, 0);
+                    values.emplace_back(x, 0, 0);
                 }
 
                 region_electric_field_num.clear();
@@ -596,13 +646,14 @@ FieldMap DFISEParser::read_fields(const std::string& file_name, const std::strin
                 if(data_count != region_electric_field_num.size()) {
                     throw std::runtime_error("incorrect number of electric field points");
                 }
+                auto& values = region_electric_field_map[region][observable];
 
                 if(dimension == 3) {
                     for(size_t i = 0; i < region_electric_field_num.size(); i += 3) {
                         auto x = region_electric_field_num[i];
                         auto y = region_electric_field_num[i + 1];
                         auto z = region_electric_field_num[i + 2];
-                        region_electric_field_map[region][observable].emplace_back(x, y, z);
+                        values.emplace_back(x, y, z);
                     }
                 }
 
@@ -610,7 +661,7 @@ FieldMap DFISEParser::read_fields(const std::string& file_name, const std::strin
                     for(size_t i = 0; i < region_electric_field_num.size(); i += 2) {
                         auto x = region_electric_field_num[i];
                         auto y = region_electric_field_num[i + 1];
-                        region_electric_field_map[region][observable].emplace_back(0, x, y);
+                        values.emplace_back(0, x, y);
                     }
                 }
 
@@ -621,10 +672,11 @@ FieldMap DFISEParser::read_fields(const std::string& file_name, const std::strin
                 if(data_count != region_electric_field_num.size()) {
                     throw std::runtime_error("incorrect number of points");
                 }
+                auto& values = region_electric_field_map[region][observable];
 
                 for(size_t i = 0; i < region_electric_field_num.size(); i += 1) {
                     auto x = region_electric_field_num[i];
-                    region_electric_field_map[region][observable].emplace_back(x, 0, 0);
+                    values.emplace_back(x, 0, 0);
                 }
 
                 region_electric_field_num.clear();
@@ -634,10 +686,11 @@ FieldMap DFISEParser::read_fields(const std::string& file_name, const std::strin
                 if(data_count != region_electric_field_num.size()) {
                     throw std::runtime_error("incorrect number of points");
                 }
+                auto& values = region_electric_field_map[region][observable];
 
                 for(size_t i = 0; i < region_electric_field_num.size(); i += 1) {
                     auto x = region_electric_field_num[i];
-                    region_electric_field_map[region][observable].emplace_back(x, 0, 0);
+                    values.emplace_back(x, 0, 0);
                 }
 
                 region_electric_field_num.clear();
@@ -647,10 +700,11 @@ FieldMap DFISEParser::read_fields(const std::string& file_name, const std::strin
                 if(data_count != region_electric_field_num.size()) {
                     throw std::runtime_error("incorrect number of points");
                 }
+                auto& values = region_electric_field_map[region][observable];
 
                 for(size_t i = 0; i < region_electric_field_num.size(); i += 1) {
                     auto x = region_electric_field_num[i];
-                    region_electric_field_map[region][observable].emplace_back(x, 0, 0);
+                    values.emplace_back(x, 0, 0);
                 }
 
                 region_electric_field_num.clear();
@@ -675,9 +729,8 @@ FieldMap DFISEParser::read_fields(const std::string& file_name, const std::strin
             main_section == DFSection::DOPING_CONCENTRATION || main_section == DFSection::DONOR_CONCENTRATION ||
             main_section == DFSection::ACCEPTOR_CONCENTRATION) &&
            sub_section == DFSection::VALUES) {
-            std::stringstream sstr(line);
             double num = NAN;
-            while(sstr >> num) {
+            while(next_number(line, num)) {
                 region_electric_field_num.push_back(num);
             }
         }
@@ -47,6 +47,12 @@ namespace mesh_converter {
 
         // Read the electric field
         FieldMap read_fields(const std::string& file_name, const std::string& observable) override;
+
+        // Retrieve the tetrahedra or triangles of the grid
+        ElementMap read_elements(const std::string& file_name) override;
+
+        // Simplices of all regions for every grid file read
+        std::map<std::string, ElementMap> elements_;
     };
 } // namespace mesh_converter
 
@@ -0,0 +1,126 @@
+/**
+ * @file
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "MappedTextFile.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace mesh_converter;
+
+namespace {
+    constexpr const char* whitespace = " \t\n\r\v";
+
+    // Check if a name consists of letters only
+    bool is_name(std::string_view str) {
+        return !str.empty() &&
+               std::all_of(str.begin(), str.end(), [](char c) { return std::isalpha(static_cast<unsigned char>(c)) != 0; });
+    }
+} // namespace
+
+MappedTextFile::MappedTextFile(const std::string& file_name) {
+    auto fd = ::open(file_name.c_str(), O_RDONLY);
+    if(fd < 0) {
+        throw std::runtime_error("file cannot be accessed");
+    }
+    struct stat file_stat {};
+    if(::fstat(fd, &file_stat) != 0) {
+        ::close(fd);
+        throw std::runtime_error("file cannot be accessed");
+    }
+
+    // Empty files cannot be mapped and are treated as having no lines
+    size_ = static_cast<size_t>(file_stat.st_size);
+    if(size_ > 0) {
+        auto* address = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(address == MAP_FAILED) { // NOLINT
+            ::close(fd);
+            throw std::runtime_error("file cannot be mapped into memory");
+        }
+        ::madvise(address, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(address);
+    }
+    ::close(fd);
+}
+
+MappedTextFile::~MappedTextFile() {
+    if(data_ != nullptr) {
+        ::munmap(const_cast<char*>(data_), size_); // NOLINT
+    }
+}
+
+bool MappedTextFile::getLine(std::string_view& line) {
+    if(position_ >= size_) {
+        return false;
+    }
+
+    const auto* begin = data_ + position_;
+    const auto* end = std::find(begin, data_ + size_, '\n');
+    position_ = static_cast<size_t>(end - data_) + 1;
+    line = trim_view(std::string_view(begin, static_cast<size_t>(end - begin)));
+    return true;
+}
+
+std::string_view mesh_converter::trim_view(std::string_view str) {
+    auto begin = str.find_first_not_of(whitespace);
+    if(begin == std::string_view::npos) {
+        return {};
+    }
+    return str.substr(begin, str.find_last_not_of(whitespace) - begin + 1);
+}
+
+bool mesh_converter::next_token(std::string_view& line, std::string_view& token) {
+    auto begin = line.find_first_not_of(whitespace);
+    if(begin == std::string_view::npos) {
+        line = {};
+        return false;
+    }
+    auto end = line.find_first_of(whitespace, begin);
+    token = line.substr(begin, end == std::string_view::npos ? std::string_view::npos : end - begin);
+    line = (end == std::string_view::npos ? std::string_view() : line.substr(end));
+    return true;
+}
+
+bool mesh_converter::split_header(std::string_view line, std::string_view& name, std::string_view& data) {
+    if(line.empty() || line.back() != '{') {
+        return false;
+    }
+    line = trim_view(line.substr(0, line.size() - 1));
+
+    // Optional data in parentheses following the name
+    data = {};
+    if(!line.empty() && line.back() == ')') {
+        auto open = line.find('(');
+        if(open == std::string_view::npos) {
+            return false;
+        }
+        data = trim_view(line.substr(open + 1, line.size() - open - 2));
+        line = trim_view(line.substr(0, open));
+    }
+
+    name = line;
+    return is_name(name);
+}
+
+bool mesh_converter::split_key_value(std::string_view line, std::string_view& key, std::string_view& value) {
+    auto separator = line.find('=');
+    if(separator == std::string_view::npos) {
+        return false;
+    }
+    key = trim_view(line.substr(0, separator));
+    value = trim_view(line.substr(separator + 1));
+    return is_name(key) && !value.empty();
+}
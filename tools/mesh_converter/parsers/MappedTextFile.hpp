@@ -0,0 +1,132 @@
+/**
+ * @file
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ALLPIX_MESHPARSER_MAPPED_TEXT_FILE_H
+#define ALLPIX_MESHPARSER_MAPPED_TEXT_FILE_H
+
+#include <charconv>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace mesh_converter {
+
+    /**
+     * @brief Read-only memory mapping of a text file, handing out its lines without copying
+     *
+     * The lines are returned as views into the mapped file, which remain valid for the lifetime of this object.
+     */
+    class MappedTextFile {
+    public:
+        /**
+         * @brief Constructor mapping the file into memory
+         * @param file_name Path of the file to map
+         * @throws std::runtime_error if the file cannot be accessed
+         */
+        explicit MappedTextFile(const std::string& file_name);
+
+        /**
+         * @brief Destructor unmapping the file
+         */
+        ~MappedTextFile();
+
+        /// @{
+        /**
+         * @brief Copying or moving the mapping is not allowed
+         */
+        MappedTextFile(const MappedTextFile&) = delete;
+        MappedTextFile& operator=(const MappedTextFile&) = delete;
+        MappedTextFile(MappedTextFile&&) = delete;
+        MappedTextFile& operator=(MappedTextFile&&) = delete;
+        /// @}
+
+        /**
+         * @brief Get the next line of the file with leading and trailing whitespace removed
+         * @param line View of the line
+         * @return False if the end of the file has been reached
+         */
+        bool getLine(std::string_view& line);
+
+        /**
+         * @brief Get the fraction of the file read so far
+         * @return Percentage of the bytes read
+         */
+        size_t getProgress() const { return (size_ > 0 ? 100 * position_ / size_ : 100); }
+
+    private:
+        const char* data_{nullptr};
+        size_t size_{0};
+        size_t position_{0};
+    };
+
+    /**
+     * @brief Remove leading and trailing whitespace from a view
+     * @param str View to trim
+     * @return Trimmed view
+     */
+    std::string_view trim_view(std::string_view str);
+
+    /**
+     * @brief Split off the next whitespace-separated token from a line
+     * @param line Remainder of the line, advanced past the token
+     * @param token View of the token
+     * @return False if no token is left
+     */
+    bool next_token(std::string_view& line, std::string_view& token);
+
+    /**
+     * @brief Split a section header of the form `Name {` or `Name (data) {`
+     * @param line Line to split
+     * @param name Name of the section
+     * @param data Data given in parentheses, empty if none
+     * @return False if the line is no section header
+     */
+    bool split_header(std::string_view line, std::string_view& name, std::string_view& data);
+
+    /**
+     * @brief Split a key-value pair of the form `key = value`
+     * @param line Line to split
+     * @param key Key of the pair
+     * @param value Value of the pair
+     * @return False if the line is no key-value pair
+     */
+    bool split_key_value(std::string_view line, std::string_view& key, std::string_view& value);
+
+    /**
+     * @brief Parse the next whitespace-separated number from a line
+     * @param line Remainder of the line, advanced past the number
+     * @param value Parsed number
+     * @return False if no number is left or the token cannot be fully parsed as number
+     */
+    template <typename T> bool next_number(std::string_view& line, T& value) {
+        std::string_view token;
+        if(!next_token(line, token)) {
+            return false;
+        }
+        if constexpr(std::is_floating_point_v<T>) {
+#if defined(__cpp_lib_to_chars)
+            auto result = std::from_chars(token.data(), token.data() + token.size(), value);
+            return result.ec == std::errc() && result.ptr == token.data() + token.size();
+#else
+            // Floating point conversion of std::from_chars is not available in all supported standard libraries
+            std::string copy(token);
+            char* end = nullptr;
+            value = static_cast<T>(std::strtod(copy.c_str(), &end));
+            return end == copy.c_str() + copy.size();
+#endif
+        } else {
+            auto result = std::from_chars(token.data(), token.data() + token.size(), value);
+            return result.ec == std::errc() && result.ptr == token.data() + token.size();
+        }
+    }
+} // namespace mesh_converter
+
+#endif // ALLPIX_MESHPARSER_MAPPED_TEXT_FILE_H
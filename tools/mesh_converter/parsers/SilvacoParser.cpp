@@ -11,79 +11,63 @@
 #include "SilvacoParser.hpp"
 
 #include <cassert>
+#include <cmath>
 #include <cstdlib>
 #include <exception>
-#include <fstream>
 #include <iostream>
-#include <regex>
 #include <set>
-#include <sstream>
 #include <string>
+#include <string_view>
 #include "TFile.h"
 #include "TTree.h"
 
+#include "MappedTextFile.hpp"
 #include "core/utils/log.h"
-#include "core/utils/text.h"
 
 using namespace mesh_converter;
 
 MeshMap SilvacoParser::read_meshes(const std::string& file_name) {
 
-    std::ifstream file(file_name);
-    if(!file) {
-        throw std::runtime_error("file cannot be accessed");
-    }
-
-    // Get the total number of lines to parse and reset file to the start:
-    auto num_lines = std::count(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>(), '\n');
-    file.clear();
-    file.seekg(0, std::ios::beg);
-    LOG(DEBUG) << "Grid file contains " << num_lines << " lines to parse";
+    // Map the file into memory, all lines are parsed in place:
+    MappedTextFile file(file_name);
 
     std::vector<Point> vertices;
 
     long unsigned int dimension = 1;
     long unsigned int columns_count = 0;
     long long num_lines_parsed = 0;
-    while(!file.eof()) {
-        std::string line;
-        std::getline(file, line);
-
+    std::string_view line;
+    while(file.getLine(line)) {
         // Log the parsing progress:
-        if(num_lines > 0 && num_lines_parsed % 1000 == 0) {
-            LOG_PROGRESS(STATUS, "gridlines") << "Parsing grid file: " << (100 * num_lines_parsed / num_lines) << "%";
+        if(num_lines_parsed % 1000 == 0) {
+            LOG_PROGRESS(STATUS, "gridlines") << "Parsing grid file: " << file.getProgress() << "%";
         }
         num_lines_parsed++;
 
-        line = allpix::trim(line);
         if(line.empty()) {
             continue;
         }
 
         // Determining number of columns by counting fields in first line
         if(num_lines_parsed == 1) {
-            std::istringstream iss;
-            iss.str(line);
+            auto columns = line;
             double val = NAN;
-            while(iss >> val) {
+            while(next_number(columns, val)) {
                 columns_count++;
             }
             dimension = columns_count;
-            iss.clear();
         }
 
-        // Handle data
-        std::stringstream sstr(line);
         // Read vertex points
         if(dimension == 3) {
             double x = 0, y = 0, z = 0;
-            while(sstr >> x >> y >> z) {
+            while(next_number(line, x) && next_number(line, y) && next_number(line, z)) {
                 vertices.emplace_back(x, y, z);
             }
         }
         if(dimension == 2) {
             double y = 0, z = 0;
-            while(sstr >> y >> z) {
+            while(next_number(line, y) && next_number(line, z)) {
                 vertices.emplace_back(y, z);
             }
         }
@@ -94,16 +78,8 @@ MeshMap SilvacoParser::read_meshes(const std::string& file_name) {
 }
 
 FieldMap SilvacoParser::read_fields(const std::string& file_name, const std::string& observable) {
-    std::ifstream file(file_name);
-    if(!file) {
-        throw std::runtime_error("file cannot be accessed");
-    }
-
-    // Get the total number of lines to parse and reset file to the start:
-    auto num_lines = std::count(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>(), '\n');
-    file.clear();
-    file.seekg(0, std::ios::beg);
-    LOG(DEBUG) << "Field data file contains " << num_lines << " lines to parse";
+    // Map the file into memory, all lines are parsed in place:
+    MappedTextFile file(file_name);
 
     // std::map<std::string, std::vector<Point>> region_electric_field_map;
     std::map<std::string, std::map<std::string, std::vector<Point>>> region_electric_field_map;
@@ -113,14 +89,12 @@ FieldMap SilvacoParser::read_fields(const std::string& file_name, const std::str
     long unsigned int dimension = 1;
     long long num_lines_parsed = 0;
     long unsigned int columns_count = 0;
-    while(!file.eof()) {
-        std::string line;
-        std::getline(file, line);
-        line = allpix::trim(line);
-
+    auto& values = region_electric_field_map[region][observable];
+    std::string_view line;
+    while(file.getLine(line)) {
         // Log the parsing progress:
-        if(num_lines > 0 && num_lines_parsed % 1000 == 0) {
-            LOG_PROGRESS(STATUS, "fieldlines") << "Parsing field data file: " << (100 * num_lines_parsed / num_lines) << "%";
+        if(num_lines_parsed % 1000 == 0) {
+            LOG_PROGRESS(STATUS, "fieldlines") << "Parsing field data file: " << file.getProgress() << "%";
         }
         num_lines_parsed++;
 
@@ -130,21 +104,17 @@ FieldMap SilvacoParser::read_fields(const std::string& file_name, const std::str
 
         // Determining number of columns by counting fields in first line
         if(num_lines_parsed == 1) {
-            std::istringstream iss;
-            iss.str(line);
+            auto columns = line;
             double val = NAN;
-            while(iss >> val) {
+            while(next_number(columns, val)) {
                 columns_count++;
             }
             dimension = columns_count;
-
-            iss.clear();
         }
 
         // Handle data
-        std::stringstream sstr(line);
         double num = NAN;
-        while(sstr >> num) {
+        while(next_number(line, num)) {
             region_electric_field_num.push_back(num);
         }
 
@@ -155,7 +125,7 @@ FieldMap SilvacoParser::read_fields(const std::string& file_name, const std::str
         if(dimension == 1) {
             for(size_t i = 0; i < region_electric_field_num.size(); i += 1) {
                 auto x = region_electric_field_num[i];
-                region_electric_field_map[region][observable].emplace_back(x, 0, 0);
+                values.emplace_back(x, 0, 0);
             }
 
             region_electric_field_num.clear();
@@ -164,13 +134,13 @@ FieldMap SilvacoParser::read_fields(const std::string& file_name, const std::str
                 auto x = region_electric_field_num[i];
                 auto y = region_electric_field_num[i + 1];
                 auto z = region_electric_field_num[i + 2];
-                region_electric_field_map[region][observable].emplace_back(x, y, z);
+                values.emplace_back(x, y, z);
             }
         } else if(dimension == 2) {
             for(size_t i = 0; i < region_electric_field_num.size(); i += 2) {
                 auto x = region_electric_field_num[i];
                 auto y = region_electric_field_num[i + 1];
-                region_electric_field_map[region][observable].emplace_back(0, x, y);
+                values.emplace_back(0, x, y);
             }
         } else {
             throw std::runtime_error("incorrect dimension of observable");
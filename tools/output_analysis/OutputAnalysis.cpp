@@ -0,0 +1,399 @@
+/**
+ * @file
+ * @brief Multi-threaded analysis of the cluster, residual and efficiency observables of ROOTObjectWriter output
+ *
+ * @copyright Copyright (c) 2024 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <ROOT/RDataFrame.hxx>
+#include <ROOT/RVec.hxx>
+#include <TChain.h>
+#include <TFile.h>
+#include <TH1D.h>
+#include <TObjArray.h>
+
+#include "core/utils/log.h"
+#include "core/utils/unit.h"
+#include "objects/MCParticle.hpp"
+#include "objects/PixelHit.hpp"
+#include "tools/units.h"
+
+using namespace allpix;
+
+namespace {
+    /**
+     * @brief Cluster of adjacent pixel hits
+     */
+    struct Cluster {
+        double x{};
+        double y{};
+        double charge{};
+        size_t size{};
+    };
+
+    /**
+     * @brief Group the pixel hits of a detector into clusters of pixels sharing an edge or a corner
+     * @param hits Pixel hits of the detector in one event
+     * @return Clusters with their charge-weighted position in local coordinates
+     */
+    std::vector<Cluster> find_clusters(const std::vector<PixelHit*>& hits) {
+        std::vector<Cluster> clusters;
+        std::vector<bool> used(hits.size(), false);
+        for(size_t seed = 0; seed < hits.size(); ++seed) {
+            if(used[seed]) {
+                continue;
+            }
+
+            // Grow the cluster from the seed until no further neighbor is found
+            std::vector<size_t> members{seed};
+            used[seed] = true;
+            for(size_t i = 0; i < members.size(); ++i) {
+                auto index = hits[members[i]]->getIndex();
+                for(size_t j = 0; j < hits.size(); ++j) {
+                    auto other = hits[j]->getIndex();
+                    if(!used[j] && std::abs(index.x() - other.x()) <= 1 && std::abs(index.y() - other.y()) <= 1) {
+                        used[j] = true;
+                        members.push_back(j);
+                    }
+                }
+            }
+
+            Cluster cluster;
+            double weight = 0;
+            for(auto member : members) {
+                auto center = hits[member]->getPixel().getLocalCenter();
+                auto signal = std::fabs(hits[member]->getSignal());
+                cluster.x += signal * center.x();
+                cluster.y += signal * center.y();
+                cluster.charge += hits[member]->getSignal();
+                weight += signal;
+            }
+            // Fall back to the arithmetic mean for clusters without signal
+            if(weight > 0) {
+                cluster.x /= weight;
+                cluster.y /= weight;
+            } else {
+                for(auto member : members) {
+                    auto center = hits[member]->getPixel().getLocalCenter();
+                    cluster.x += center.x() / static_cast<double>(members.size());
+                    cluster.y += center.y() / static_cast<double>(members.size());
+                }
+            }
+            cluster.size = members.size();
+            clusters.push_back(cluster);
+        }
+        return clusters;
+    }
+
+    /**
+     * @brief Select the reference particle of a detector, the particle with the longest path through the sensor
+     * @param particles Monte Carlo particles of the detector in one event
+     * @return Pointer to the reference particle or nullptr if no particle crossed the sensor
+     */
+    const MCParticle* reference_particle(const std::vector<MCParticle*>& particles) {
+        const MCParticle* reference = nullptr;
+        double max_length = -1;
+        for(const auto* particle : particles) {
+            auto length = (particle->getLocalEndPoint() - particle->getLocalStartPoint()).R();
+            if(length > max_length) {
+                max_length = length;
+                reference = particle;
+            }
+        }
+        return reference;
+    }
+
+    /**
+     * @brief Find the cluster closest to the reference particle within the matching distance
+     * @param clusters Clusters of the detector
+     * @param reference Reference particle of the detector
+     * @param max_distance Maximum distance between the cluster position and the reference point of the particle
+     * @return Pointer to the matched cluster or nullptr if no cluster is close enough
+     */
+    const Cluster* match_cluster(const std::vector<Cluster>& clusters, const MCParticle* reference, double max_distance) {
+        const Cluster* matched = nullptr;
+        auto point = reference->getLocalReferencePoint();
+        auto min_distance = max_distance;
+        for(const auto& cluster : clusters) {
+            auto distance = std::hypot(cluster.x - point.x(), cluster.y - point.y());
+            if(distance <= min_distance) {
+                min_distance = distance;
+                matched = &cluster;
+            }
+        }
+        return matched;
+    }
+
+    /**
+     * @brief Calculate the residual of the cluster matched to the reference particle
+     * @param clusters Clusters of the detector
+     * @param reference Reference particle of the detector
+     * @param max_distance Maximum distance between the cluster position and the reference point of the particle
+     * @return Residual in x and y in micrometer, or an empty vector if no cluster is matched
+     */
+    ROOT::RVecD cluster_residual(const std::vector<Cluster>& clusters, const MCParticle* reference, double max_distance) {
+        ROOT::RVecD residual;
+        const auto* cluster = match_cluster(clusters, reference, max_distance);
+        if(cluster != nullptr) {
+            auto point = reference->getLocalReferencePoint();
+            residual.push_back(static_cast<double>(Units::convert(cluster->x - point.x(), "um")));
+            residual.push_back(static_cast<double>(Units::convert(cluster->y - point.y(), "um")));
+        }
+        return residual;
+    }
+
+    /**
+     * @brief Booked results of all observables of a detector
+     */
+    struct DetectorResults {
+        ROOT::RDF::RResultPtr<TH1D> cluster_size;
+        ROOT::RDF::RResultPtr<TH1D> cluster_charge;
+        ROOT::RDF::RResultPtr<TH1D> residual_x;
+        ROOT::RDF::RResultPtr<TH1D> residual_y;
+        ROOT::RDF::RResultPtr<ULong64_t> references;
+        ROOT::RDF::RResultPtr<ULong64_t> matched;
+    };
+} // namespace
+
+/**
+ * @brief Main function running the application
+ */
+int main(int argc, const char* argv[]) {
+
+    int return_code = 0;
+    try {
+
+        // Register the default set of units with this executable:
+        register_units();
+
+        // Add cout as the default logging stream
+        Log::addStream(std::cout);
+
+        // If no arguments are provided, print the help:
+        bool print_help = false;
+        if(argc == 1) {
+            print_help = true;
+            return_code = 1;
+        }
+
+        // Parse arguments
+        std::vector<std::string> file_inputs;
+        std::string file_output = "analysis.root";
+        std::set<std::string> detectors;
+        unsigned int threads = 0;
+        double match_distance = Units::get(100.0, "um");
+        double max_charge = Units::get(50.0, "ke");
+        for(int i = 1; i < argc; i++) {
+            if(strcmp(argv[i], "-h") == 0) {
+                print_help = true;
+            } else if(strcmp(argv[i], "-v") == 0 && (i + 1 < argc)) {
+                try {
+                    LogLevel log_level = Log::getLevelFromString(std::string(argv[++i]));
+                    Log::setReportingLevel(log_level);
+                } catch(std::invalid_argument& e) {
+                    LOG(ERROR) << "Invalid verbosity level \"" << std::string(argv[i]) << "\", ignoring overwrite";
+                }
+            } else if(strcmp(argv[i], "-f") == 0 && (i + 1 < argc)) {
+                file_inputs.emplace_back(argv[++i]);
+            } else if(strcmp(argv[i], "-o") == 0 && (i + 1 < argc)) {
+                file_output = std::string(argv[++i]);
+            } else if(strcmp(argv[i], "-d") == 0 && (i + 1 < argc)) {
+                detectors.emplace(argv[++i]);
+            } else if(strcmp(argv[i], "-j") == 0 && (i + 1 < argc)) {
+                threads = static_cast<unsigned int>(std::stoul(argv[++i]));
+            } else if(strcmp(argv[i], "--match") == 0 && (i + 1 < argc)) {
+                match_distance = Units::get(std::stod(argv[++i]), "um");
+            } else if(strcmp(argv[i], "--max-charge") == 0 && (i + 1 < argc)) {
+                max_charge = Units::get(std::stod(argv[++i]), "ke");
+            } else {
+                LOG(ERROR) << "Unrecognized command line argument \"" << argv[i] << "\"";
+                print_help = true;
+                return_code = 1;
+            }
+        }
+        if(file_inputs.empty() && !print_help) {
+            LOG(ERROR) << "No input file given";
+            print_help = true;
+            return_code = 1;
+        }
+
+        // Print help if requested or no arguments given
+        if(print_help) {
+            std::cout << "Allpix Squared Output Analysis Tool" << std::endl;
+            std::cout << std::endl;
+            std::cout << "Usage: output_analysis -f <file> [<options>]" << std::endl;
+            std::cout << std::endl;
+            std::cout << "Options:" << std::endl;
+            std::cout << "  -f <file>            ROOTObjectWriter output file, can be given multiple times" << std::endl;
+            std::cout << "  -o <file>            file to write the histograms to, defaults to analysis.root" << std::endl;
+            std::cout << "  -d <detector>        detector to analyze, can be given multiple times, defaults to all"
+                      << std::endl;
+            std::cout << "  -j <threads>         number of threads, defaults to all available cores" << std::endl;
+            std::cout << "  --match <distance>   maximum distance between cluster and particle in um, defaults to 100"
+                      << std::endl;
+            std::cout << "  --max-charge <ke>    upper edge of the cluster charge histogram in ke, defaults to 50"
+                      << std::endl;
+            std::cout << "  -v <level>           verbosity level, overwriting the global level" << std::endl;
+            std::cout << std::endl;
+            std::cout << "For more help, please see <https://cern.ch/allpix-squared>" << std::endl;
+            return return_code;
+        }
+
+        // Chain the trees of all input files, with the Monte Carlo particles as friend of the pixel hits
+        auto hits = std::make_unique<TChain>("PixelHit");
+        auto particles = std::make_unique<TChain>("MCParticle");
+        for(const auto& file_input : file_inputs) {
+            hits->Add(file_input.c_str());
+            particles->Add(file_input.c_str());
+        }
+        if(hits->GetEntries() == 0) {
+            throw std::runtime_error("No PixelHit tree with entries found in the input files");
+        }
+        bool has_particles = (particles->GetNtrees() > 0 && particles->GetEntries() == hits->GetEntries());
+        if(has_particles) {
+            hits->AddFriend(particles.get());
+        } else {
+            LOG(WARNING) << "No MCParticle tree matching the PixelHit tree, only analyzing clusters";
+        }
+
+        // Every branch of the PixelHit tree holds the hits of one detector
+        std::vector<std::string> branches;
+        for(auto* branch : *hits->GetListOfBranches()) {
+            std::string name = branch->GetName();
+            if(detectors.empty() || detectors.count(name) > 0) {
+                branches.push_back(name);
+            }
+        }
+        for(const auto& detector : detectors) {
+            if(std::find(branches.begin(), branches.end(), detector) == branches.end()) {
+                throw std::invalid_argument("No pixel hits of detector " + detector + " in the input files");
+            }
+        }
+
+        ROOT::EnableImplicitMT(threads);
+        LOG(STATUS) << "Analyzing " << hits->GetEntries() << " events of " << branches.size() << " detectors on "
+                    << ROOT::GetThreadPoolSize() << " threads";
+
+        // Book all observables first such that the events are processed in a single pass, reading only the used branches
+        ROOT::RDataFrame data_frame(*hits);
+        std::map<std::string, DetectorResults> results;
+        for(const auto& detector : branches) {
+            auto clusters_column = detector + "_clusters";
+            auto node = data_frame.Define(clusters_column, find_clusters, {detector});
+            auto& result = results[detector];
+
+            result.cluster_size = node.Define(detector + "_cluster_size",
+                                              [](const std::vector<Cluster>& clusters) {
+                                                  ROOT::RVecD sizes;
+                                                  for(const auto& cluster : clusters) {
+                                                      sizes.push_back(static_cast<double>(cluster.size));
+                                                  }
+                                                  return sizes;
+                                              },
+                                              {clusters_column})
+                                      .Histo1D<ROOT::RVecD>({(detector + "_cluster_size").c_str(),
+                                                             ("Cluster size " + detector + ";cluster size;clusters").c_str(),
+                                                             20,
+                                                             0.5,
+                                                             20.5},
+                                                            detector + "_cluster_size");
+            result.cluster_charge =
+                node.Define(detector + "_cluster_charge",
+                            [](const std::vector<Cluster>& clusters) {
+                                ROOT::RVecD charges;
+                                for(const auto& cluster : clusters) {
+                                    charges.push_back(static_cast<double>(Units::convert(cluster.charge, "ke")));
+                                }
+                                return charges;
+                            },
+                            {clusters_column})
+                    .Histo1D<ROOT::RVecD>({(detector + "_cluster_charge").c_str(),
+                                           ("Cluster charge " + detector + ";cluster charge [ke];clusters").c_str(),
+                                           200,
+                                           0,
+                                           static_cast<double>(Units::convert(max_charge, "ke"))},
+                                          detector + "_cluster_charge");
+
+            if(!has_particles || particles->GetBranch(detector.c_str()) == nullptr) {
+                continue;
+            }
+
+            // Residuals and efficiency with respect to the reference particle of the detector
+            auto particles_column = "MCParticle." + detector;
+            auto matched = node.Define(detector + "_reference", reference_particle, {particles_column})
+                               .Filter([](const MCParticle* reference) { return reference != nullptr; },
+                                       {detector + "_reference"})
+                               .Define(detector + "_residual",
+                                       [match_distance](const std::vector<Cluster>& clusters, const MCParticle* reference) {
+                                           return cluster_residual(clusters, reference, match_distance);
+                                       },
+                                       {clusters_column, detector + "_reference"});
+            result.references = matched.Count();
+            auto with_cluster = matched.Filter([](const ROOT::RVecD& residual) { return !residual.empty(); },
+                                               {detector + "_residual"});
+            result.matched = with_cluster.Count();
+
+            auto residual_range = static_cast<double>(Units::convert(match_distance, "um"));
+            result.residual_x =
+                with_cluster.Define(detector + "_residual_x", [](const ROOT::RVecD& residual) { return residual[0]; },
+                                    {detector + "_residual"})
+                    .Histo1D<double>({(detector + "_residual_x").c_str(),
+                                      ("Residual x " + detector + ";x_{cluster} - x_{MC} [#mum];events").c_str(),
+                                      200,
+                                      -residual_range,
+                                      residual_range},
+                                     detector + "_residual_x");
+            result.residual_y =
+                with_cluster.Define(detector + "_residual_y", [](const ROOT::RVecD& residual) { return residual[1]; },
+                                    {detector + "_residual"})
+                    .Histo1D<double>({(detector + "_residual_y").c_str(),
+                                      ("Residual y " + detector + ";y_{cluster} - y_{MC} [#mum];events").c_str(),
+                                      200,
+                                      -residual_range,
+                                      residual_range},
+                                     detector + "_residual_y");
+        }
+
+        // Accessing the first result runs the event loop for all booked observables
+        auto output = std::make_unique<TFile>(file_output.c_str(), "RECREATE");
+        for(auto& [detector, result] : results) {
+            auto* directory = output->mkdir(detector.c_str());
+            directory->WriteTObject(result.cluster_size.GetPtr());
+            directory->WriteTObject(result.cluster_charge.GetPtr());
+            LOG(STATUS) << detector << ": mean cluster size " << result.cluster_size->GetMean() << ", mean cluster charge "
+                        << result.cluster_charge->GetMean() << "ke";
+
+            if(result.references) {
+                directory->WriteTObject(result.residual_x.GetPtr());
+                directory->WriteTObject(result.residual_y.GetPtr());
+                auto references = *result.references;
+                auto efficiency = (references > 0 ? static_cast<double>(*result.matched) / static_cast<double>(references)
+                                                  : 0.);
+                LOG(STATUS) << detector << ": efficiency " << efficiency << " (" << *result.matched << "/" << references
+                            << "), residual RMS " << result.residual_x->GetRMS() << "um in x and "
+                            << result.residual_y->GetRMS() << "um in y";
+            }
+        }
+        LOG(STATUS) << "Processed the events in " << data_frame.GetNRuns() << " pass, histograms written to "
+                    << file_output;
+    } catch(std::exception& e) {
+        LOG(FATAL) << "Fatal internal error" << std::endl << e.what() << std::endl << "Cannot continue.";
+        return_code = 127;
+    }
+
+    return return_code;
+}
@@ -8,9 +8,15 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
 #include <csignal>
 #include <filesystem>
 #include <fstream>
+#include <memory>
+#include <vector>
 
 #include "core/config/ConfigReader.hpp"
 #include "core/config/Configuration.hpp"
@@ -19,6 +25,7 @@
 #include "core/module/ThreadPool.hpp"
 #include "core/utils/log.h"
 #include "tools/ROOT.h"
+#include "tools/fft.h"
 #include "tools/field_parser.h"
 #include "tools/units.h"
 
@@ -48,6 +55,133 @@ void interrupt_handler(int) {
     std::exit(0);
 }
 
+namespace {
+    /**
+     * @brief Weighting potential of a rectangular pad from the series expansion of its mirror charges
+     * @param x Position in x relative to the pad center
+     * @param y Position in y relative to the pad center
+     * @param local_z Distance from the electrode plane
+     * @param d Thickness of the sensor
+     * @param implant Size of the pad
+     * @return Weighting potential
+     */
+    double series_potential(double x, double y, double local_z, double d, const ROOT::Math::XYZVector& implant) {
+        // Calculate values of the "f" function
+        auto f = [implant](double x_pos, double y_pos, double u) {
+            // Calculate arctan fractions
+            auto arctan = [](double a, double b, double c) {
+                return std::atan(a * b / c / std::sqrt(a * a + b * b + c * c));
+            };
+
+            // Shift the x and y coordinates by plus/minus half the implant size:
+            double x1 = x_pos - implant.x() / 2;
+            double x2 = x_pos + implant.x() / 2;
+            double y1 = y_pos - implant.y() / 2;
+            double y2 = y_pos + implant.y() / 2;
+
+            // Calculate arctan sum and return
+            return arctan(x1, y1, u) + arctan(x2, y2, u) - arctan(x1, y2, u) - arctan(x2, y1, u);
+        };
+
+        // Calculate the series expansion
+        double sum = 0;
+        for(int n = 1; n <= 100; n++) {
+            sum += f(x, y, 2 * n * d - local_z) - f(x, y, 2 * n * d + local_z);
+        }
+
+        return (1 / (2 * M_PI) * (f(x, y, local_z) - sum));
+    }
+
+    /**
+     * @brief Fourier coefficients of the pad along one axis of a periodic domain
+     *
+     * The coefficients of the rectangular pad profile are calculated analytically, such that the inverse transform yields
+     * its Fourier series at the grid points without aliasing. They include the phase of the first grid point and the
+     * normalization of the inverse transform.
+     */
+    struct PadSpectrum {
+        /**
+         * @brief Constructor calculating the coefficients
+         * @param bins Number of grid points within the field
+         * @param field_size Size of the field
+         * @param pad_size Size of the pad, centered in the field
+         */
+        PadSpectrum(size_t bins, double field_size, double pad_size) {
+            // Period of at least twice the field size, suppressing the potential of the neighboring images of the pad
+            const auto length = allpix::fft_size(2 * bins);
+            const auto step = field_size / static_cast<double>(bins);
+            const auto period = step * static_cast<double>(length);
+            const auto first_position = step - field_size / 2;
+
+            coefficients.resize(length);
+            wave_numbers.resize(length);
+            for(size_t m = 0; m < length; ++m) {
+                const auto mode = static_cast<double>(m) - (m < length / 2 ? 0. : static_cast<double>(length));
+                const auto k = 2 * M_PI * mode / period;
+                const auto argument = k * pad_size / 2;
+                const auto sinc = (m == 0 ? 1. : std::sin(argument) / argument);
+                wave_numbers[m] = k;
+                coefficients[m] = std::polar(pad_size / period * sinc * static_cast<double>(length), k * first_position);
+            }
+        }
+
+        std::vector<std::complex<double>> coefficients;
+        std::vector<double> wave_numbers;
+    };
+
+    /**
+     * @brief Weighting potential of a rectangular pad in a plane of constant depth, solving the Laplace equation with
+     * periodic lateral boundary conditions in Fourier space
+     * @param spectrum_x Fourier coefficients of the pad along x
+     * @param spectrum_y Fourier coefficients of the pad along y
+     * @param local_z Distance from the electrode plane
+     * @param d Thickness of the sensor
+     * @param bins_x Number of grid points within the field along x
+     * @param bins_y Number of grid points within the field along y
+     * @param plane Potential at the grid points, indexed as x * bins_y + y
+     *
+     * Each Fourier mode of the pad potential at the electrode decays towards the grounded backside as
+     * sinh(k (d - z)) / sinh(k d), which is evaluated in a numerically stable form for large wave numbers.
+     */
+    void fourier_potential(const PadSpectrum& spectrum_x,
+                           const PadSpectrum& spectrum_y,
+                           double local_z,
+                           double d,
+                           size_t bins_x,
+                           size_t bins_y,
+                           std::vector<double>& plane) {
+        const auto length_x = spectrum_x.coefficients.size();
+        const auto length_y = spectrum_y.coefficients.size();
+        std::vector<std::complex<double>> modes(length_x * length_y);
+        std::vector<std::complex<double>> row(length_y), column(length_x);
+
+        // Transform along y for every mode in x
+        for(size_t m = 0; m < length_x; ++m) {
+            for(size_t n = 0; n < length_y; ++n) {
+                const auto k = std::hypot(spectrum_x.wave_numbers[m], spectrum_y.wave_numbers[n]);
+                const auto decay = (k == 0. ? (d - local_z) / d
+                                            : std::exp(-k * local_z) * std::expm1(-2 * k * (d - local_z)) /
+                                                  std::expm1(-2 * k * d));
+                row[n] = spectrum_x.coefficients[m] * spectrum_y.coefficients[n] * decay;
+            }
+            allpix::fft(row, true);
+            std::copy(row.begin(), row.end(), modes.begin() + static_cast<std::ptrdiff_t>(m * length_y));
+        }
+
+        // Transform along x for the grid points within the field
+        plane.resize(bins_x * bins_y);
+        for(size_t j = 0; j < bins_y; ++j) {
+            for(size_t m = 0; m < length_x; ++m) {
+                column[m] = modes[m * length_y + j];
+            }
+            allpix::fft(column, true);
+            for(size_t i = 0; i < bins_x; ++i) {
+                plane[i * bins_y + j] = column[i].real();
+            }
+        }
+    }
+} // namespace
+
 int main(int argc, char** argv) {
     using XYZVectorInt = ROOT::Math::DisplacementVector3D<ROOT::Math::Cartesian3D<size_t>>;
     using XYVectorInt = ROOT::Math::DisplacementVector2D<ROOT::Math::Cartesian2D<size_t>>;
@@ -77,12 +211,26 @@ int main(int argc, char** argv) {
         XYVectorInt matrix(3, 3);
         XYZVectorInt binning;
         auto file_type = allpix::FileType::APF;
+        bool use_fft = false;
 
         for(int i = 1; i < argc; i++) {
             if(strcmp(argv[i], "-h") == 0) {
                 print_help = true;
             } else if(strcmp(argv[i], "--init") == 0) {
                 file_type = allpix::FileType::INIT;
+            } else if(strcmp(argv[i], "--mapped") == 0) {
+                file_type = allpix::FileType::MAPPED;
+            } else if(strcmp(argv[i], "--method") == 0 && (i + 1 < argc)) {
+                std::string method(argv[++i]);
+                if(method == "fft") {
+                    use_fft = true;
+                } else if(method == "series") {
+                    use_fft = false;
+                } else {
+                    LOG(ERROR) << "Invalid generation method \"" << method << "\"";
+                    print_help = true;
+                    return_code = 1;
+                }
             } else if(strcmp(argv[i], "--binning") == 0 && (i + 1 < argc)) {
                 binning = allpix::from_string<XYZVectorInt>(std::string(argv[++i]));
             } else if(strcmp(argv[i], "--matrix") == 0 && (i + 1 < argc)) {
@@ -125,6 +273,12 @@ int main(int argc, char** argv) {
             std::cout
                 << "\t --init                  Switch to enable writing the potential in the INIT format instead of APF"
                 << std::endl;
+            std::cout
+                << "\t --mapped                Switch to enable writing the potential in the memory-mappable APF format"
+                << std::endl;
+            std::cout << "\t --method  <method>      Generation method, \"series\" for the series expansion of the mirror "
+                         "charges (default) or \"fft\" for the Fourier space solution"
+                      << std::endl;
             std::cout << "\t -v <level>              verbosity level (default reporiting level is INFO)" << std::endl;
             std::cout << "\t -h                      print this help text" << std::endl;
 
@@ -172,64 +326,96 @@ int main(int argc, char** argv) {
 
         // Output file path:
         std::string output_file_name =
-            output_file_prefix + "_weightingpotential" + (file_type == allpix::FileType::INIT ? ".init" : ".apf");
+            output_file_prefix + "_weightingpotential" +
+            (file_type == allpix::FileType::INIT ? ".init" : file_type == allpix::FileType::MAPPED ? ".apfm" : ".apf");
 
         LOG(INFO) << "Field size: " << allpix::Units::display(fieldsize, {"um", "mm"});
         LOG(INFO) << "Binning: " << binning.x() << " " << binning.y() << " " << binning.z();
         LOG(INFO) << "Output file: " << output_file_name;
+        LOG(INFO) << "Generation method: " << (use_fft ? "Fourier space solution" : "series expansion");
         auto start = std::chrono::system_clock::now();
 
         // Start potential generation on many threads:
         auto num_threads = std::max(std::thread::hardware_concurrency(), 1u);
         ThreadPool::registerThreadCount(num_threads);
         LOG(STATUS) << "Starting weighting potential generation with " << num_threads << " threads.";
-        auto weighting_potential = std::make_shared<std::vector<double>>();
-
-        auto generate_section = [&](size_t index_x) {
-            allpix::Log::setReportingLevel(log_level);
 
-            auto potential = [implant, thickness_domain](const ROOT::Math::XYZPoint& pos) {
-                // Calculate values of the "f" function
-                auto f = [implant](double x, double y, double u) {
-                    // Calculate arctan fractions
-                    auto arctan = [](double a, double b, double c) {
-                        return std::atan(a * b / c / std::sqrt(a * a + b * b + c * c));
-                    };
-
-                    // Shift the x and y coordinates by plus/minus half the implant size:
-                    double x1 = x - implant.x() / 2;
-                    double x2 = x + implant.x() / 2;
-                    double y1 = y - implant.y() / 2;
-                    double y2 = y + implant.y() / 2;
-
-                    // Calculate arctan sum and return
-                    return arctan(x1, y1, u) + arctan(x2, y2, u) - arctan(x1, y2, u) - arctan(x2, y1, u);
-                };
+        // Potential stored with z as fastest index, written directly by the tasks
+        const size_t bins_x = binning.x();
+        const size_t bins_y = binning.y();
+        const size_t bins_z = binning.z();
+        auto weighting_potential = std::make_shared<std::vector<double>>(bins_x * bins_y * bins_z);
+        auto* values = weighting_potential->data();
+        auto value_index = [bins_y, bins_z](size_t x, size_t y, size_t z) { return (x * bins_y + y) * bins_z + z; };
+
+        // Transform into coordinate system with sensor between d/2 < z < -d/2:
+        const auto d = thickness_domain.second - thickness_domain.first;
+        auto local_z = [&](size_t index_z) {
+            auto pos_z = fieldsize.z() / static_cast<double>(bins_z) * static_cast<double>(index_z + 1) - fieldsize.z() / 2;
+            return -pos_z + thickness_domain.second;
+        };
 
-                // Transform into coordinate system with sensor between d/2 < z < -d/2:
-                auto d = thickness_domain.second - thickness_domain.first;
-                auto local_z = -pos.z() + thickness_domain.second;
+        // Grid points are placed symmetrically around the pad center except for the last one, such that the potential of
+        // index i equals the one of its mirror index bins - 2 - i
+        auto mirror_index = [](size_t index, size_t bins) { return (index + 2 <= bins ? bins - 2 - index : index); };
 
-                // Calculate the series expansion
-                double sum = 0;
-                for(int n = 1; n <= 100; n++) {
-                    sum += f(pos.x(), pos.y(), 2 * n * d - local_z) - f(pos.x(), pos.y(), 2 * n * d + local_z);
+        // Series expansion: calculate one slice in x, skipping points in y which are mirrored
+        auto generate_section = [&](size_t index_x) {
+            for(size_t index_y = 0; index_y < bins_y; index_y++) {
+                if(mirror_index(index_y, bins_y) < index_y) {
+                    continue;
+                }
+                auto pos_x =
+                    fieldsize.x() / static_cast<double>(bins_x) * static_cast<double>(index_x + 1) - fieldsize.x() / 2;
+                auto pos_y =
+                    fieldsize.y() / static_cast<double>(bins_y) * static_cast<double>(index_y + 1) - fieldsize.y() / 2;
+                for(size_t index_z = 0; index_z < bins_z; index_z++) {
+                    values[value_index(index_x, index_y, index_z)] =
+                        series_potential(pos_x, pos_y, local_z(index_z), d, implant);
                 }
+            }
 
-                return (1 / (2 * M_PI) * (f(pos.x(), pos.y(), local_z) - sum));
-            };
+            // Copy the mirrored points
+            for(size_t index_y = 0; index_y < bins_y; index_y++) {
+                auto mirror_y = mirror_index(index_y, bins_y);
+                if(mirror_y < index_y) {
+                    std::copy_n(
+                        values + value_index(index_x, mirror_y, 0), bins_z, values + value_index(index_x, index_y, 0));
+                }
+            }
+        };
 
-            std::vector<double> slice;
-            for(size_t index_y = 1; index_y <= binning.y(); index_y++) {
-                for(size_t index_z = 1; index_z <= binning.z(); index_z++) {
-                    auto pos = ROOT::Math::XYZPoint(
-                        fieldsize.x() / static_cast<double>(binning.x()) * static_cast<double>(index_x) - fieldsize.x() / 2,
-                        fieldsize.y() / static_cast<double>(binning.y()) * static_cast<double>(index_y) - fieldsize.y() / 2,
-                        fieldsize.z() / static_cast<double>(binning.z()) * static_cast<double>(index_z) - fieldsize.z() / 2);
-                    slice.push_back(potential(pos));
+        // Fourier space solution: calculate one plane in z
+        std::unique_ptr<PadSpectrum> spectrum_x, spectrum_y;
+        if(use_fft) {
+            spectrum_x = std::make_unique<PadSpectrum>(bins_x, fieldsize.x(), implant.x());
+            spectrum_y = std::make_unique<PadSpectrum>(bins_y, fieldsize.y(), implant.y());
+            LOG(DEBUG) << "Periodic domain of " << spectrum_x->coefficients.size() << "x" << spectrum_y->coefficients.size()
+                       << " grid points";
+        }
+        auto generate_plane = [&](size_t index_z) {
+            auto z = local_z(index_z);
+            std::vector<double> plane;
+            if(z > 0) {
+                fourier_potential(*spectrum_x, *spectrum_y, z, d, bins_x, bins_y, plane);
+            } else {
+                // The potential at the electrode is given by the pad itself, with the mean value at its edges
+                auto pad_profile = [](size_t index, size_t bins, double size, double pad_size) {
+                    auto distance = std::fabs(size / static_cast<double>(bins) * static_cast<double>(index + 1) - size / 2) -
+                                    pad_size / 2;
+                    return (distance < 0 ? 1. : distance > 0 ? 0. : 0.5);
+                };
+                plane.resize(bins_x * bins_y);
+                for(size_t index_x = 0; index_x < bins_x; index_x++) {
+                    for(size_t index_y = 0; index_y < bins_y; index_y++) {
+                        plane[index_x * bins_y + index_y] = pad_profile(index_x, bins_x, fieldsize.x(), implant.x()) *
+                                                            pad_profile(index_y, bins_y, fieldsize.y(), implant.y());
+                    }
                 }
             }
-            return slice;
+            for(size_t index_xy = 0; index_xy < bins_x * bins_y; index_xy++) {
+                values[index_xy * bins_z + index_z] = plane[index_xy];
+            }
         };
 
         // clang-format off
@@ -241,24 +427,42 @@ int main(int argc, char** argv) {
         };
 
         ThreadPool pool(num_threads, num_threads * 1024, init_function);
-        std::vector<std::shared_future<std::vector<double>>> wp_futures;
+        std::vector<std::shared_future<void>> wp_futures;
 
-        // Loop over x coordinate, add tasks for each coordinate to the queue
-        for(size_t x = 1; x <= binning.x(); x++) {
-            wp_futures.push_back(pool.submit(generate_section, x));
+        if(use_fft) {
+            // Loop over z coordinate, add tasks for each plane to the queue
+            for(size_t z = 0; z < bins_z; z++) {
+                wp_futures.push_back(pool.submit(generate_plane, z));
+            }
+        } else {
+            // Loop over x coordinate, add tasks for each slice which is not mirrored to the queue
+            for(size_t x = 0; x < bins_x; x++) {
+                if(mirror_index(x, bins_x) >= x) {
+                    wp_futures.push_back(pool.submit(generate_section, x));
+                }
+            }
         }
 
-        // Merge the result vectors:
+        // Wait for the tasks to finish:
         unsigned int slices_done = 0;
         for(auto& wp_future : wp_futures) {
-            auto slice = wp_future.get();
-            weighting_potential->insert(weighting_potential->end(), slice.begin(), slice.end());
+            wp_future.get();
             LOG_PROGRESS(INFO, "generation") << "Generating potential: " << (100 * slices_done / wp_futures.size()) << "%";
             slices_done++;
         }
         LOG_PROGRESS(INFO, "generation") << "Generating potential: 100%";
         pool.destroy();
 
+        // Copy the mirrored slices
+        if(!use_fft) {
+            for(size_t x = 0; x < bins_x; x++) {
+                auto mirror_x = mirror_index(x, bins_x);
+                if(mirror_x < x) {
+                    std::copy_n(values + value_index(mirror_x, 0, 0), bins_y * bins_z, values + value_index(x, 0, 0));
+                }
+            }
+        }
+
         auto end = std::chrono::system_clock::now();
         auto elapsed_seconds = std::chrono::duration_cast<std::chrono::seconds>(end - start).count();
         LOG(INFO) << "Weighting potential generated in " << elapsed_seconds << " seconds.";